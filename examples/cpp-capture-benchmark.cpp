@@ -0,0 +1,333 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+///////////////////////////
+// cpp-capture-benchmark //
+///////////////////////////
+
+// This tool qualifies a host, and the USB hubs between it and the camera, by streaming every supported mode of every stream of the first
+// device on its own, then every combination of its streams at their best quality preset. Each configuration is captured by waiting for
+// framesets, by polling for them and by frame callbacks in turn, measuring per stream the frames delivered per second, the share of the
+// frames received which never reached the application, the CPU spent unpacking and in callbacks, and the latency from the driver to the
+// application. The time to compute the point cloud, and depth aligned to color, is measured on the framesets waited or polled for.
+//
+// Usage: cpp-capture-benchmark [--seconds=N] [--quick] [--api=wait|poll|callback]... [--csv=path] [--json=path]
+//   --seconds  Time each configuration is captured for, 3 by default
+//   --quick    Only capture the best quality preset of each stream, instead of every mode
+//   --api      Only capture with the given API, may be repeated
+//
+// Frame callbacks cannot be removed from a device once set, so every configuration is captured by waiting and polling before any is by callbacks.
+
+#include <librealsense/rs.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+const rs::stream native_streams[] = { rs::stream::depth, rs::stream::color, rs::stream::infrared, rs::stream::infrared2, rs::stream::fisheye };
+
+struct stream_setting
+{
+    rs::stream stream;
+    bool preset;                // Enabled with rs::preset::best_quality, the mode below is then what it resolved to
+    int width, height, framerate;
+    rs::format format;
+};
+
+struct configuration
+{
+    std::string name;
+    std::vector<stream_setting> streams;
+};
+
+struct result
+{
+    std::string configuration, api, error;
+    rs::stream stream;
+    int width = 0, height = 0, framerate = 0;
+    rs::format format = rs::format::any;
+    double delivered_fps = 0, drop_rate = 0, cpu_percent = 0, latency_median_ms = 0, latency_p99_ms = 0;
+    double derived_ms = 0, process_cpu_percent = 0; // Of the whole configuration
+};
+
+// Upper bound of the bin holding the given share of the frames, the bins of the latency histograms doubling from one microsecond
+double histogram_percentile(const std::vector<unsigned long long> & counts, double share)
+{
+    unsigned long long total = 0, seen = 0;
+    for (auto c : counts) total += c;
+    if (!total) return 0;
+    for (size_t i = 0; i < counts.size(); ++i)
+    {
+        seen += counts[i];
+        if (seen >= share * total) return std::ldexp(1.0, static_cast<int>(i)) / 1000;
+    }
+    return std::ldexp(1.0, static_cast<int>(counts.size())) / 1000;
+}
+
+std::string stream_name(rs::stream s) { return rs_stream_to_string((rs_stream)s); }
+std::string format_name(rs::format f) { return rs_format_to_string((rs_format)f); }
+
+std::vector<configuration> list_configurations(rs::device & dev, bool quick)
+{
+    std::vector<configuration> configurations;
+    std::vector<rs::stream> supported;
+    for (auto s : native_streams) if (dev.get_stream_mode_count(s) > 0) supported.push_back(s);
+
+    // Every mode of every stream on its own
+    for (auto s : supported)
+    {
+        if (quick)
+        {
+            configurations.push_back({ stream_name(s) + " preset", { { s, true, 0, 0, 0, rs::format::any } } });
+            continue;
+        }
+        for (int i = 0; i < dev.get_stream_mode_count(s); ++i)
+        {
+            stream_setting setting = { s, false, 0, 0, 0, rs::format::any };
+            dev.get_stream_mode(s, i, setting.width, setting.height, setting.format, setting.framerate);
+            std::ostringstream name;
+            name << stream_name(s) << " " << setting.width << "x" << setting.height << " " << format_name(setting.format) << " " << setting.framerate << "fps";
+            configurations.push_back({ name.str(), { setting } });
+        }
+    }
+
+    // Every combination of two streams or more at their preset
+    for (int mask = 1; mask < (1 << supported.size()); ++mask)
+    {
+        if (!(mask & (mask - 1))) continue;
+        configuration c;
+        for (size_t i = 0; i < supported.size(); ++i)
+        {
+            if (!(mask & (1 << i))) continue;
+            c.name += (c.name.empty() ? "" : "+") + stream_name(supported[i]);
+            c.streams.push_back({ supported[i], true, 0, 0, 0, rs::format::any });
+        }
+        c.name += " preset";
+        configurations.push_back(c);
+    }
+    return configurations;
+}
+
+// Counts the frames of a stream the application saw, frame numbers telling apart new frames from those repeated in later framesets
+struct stream_counter
+{
+    std::mutex mutex;
+    std::set<unsigned long long> numbers;
+    void add(unsigned long long number) { std::lock_guard<std::mutex> lock(mutex); numbers.insert(number); }
+    size_t count() { std::lock_guard<std::mutex> lock(mutex); return numbers.size(); }
+};
+
+std::vector<result> capture(rs::device & dev, const configuration & c, const std::string & api, double seconds)
+{
+    std::vector<result> results;
+    for (auto s : native_streams) if (dev.is_stream_enabled(s)) dev.disable_stream(s);
+
+    std::map<rs::stream, stream_counter> counters;
+    double derived_ms = 0;
+    long long derived_runs = 0;
+    try
+    {
+        for (auto & s : c.streams)
+        {
+            if (s.preset) dev.enable_stream(s.stream, rs::preset::best_quality);
+            else dev.enable_stream(s.stream, s.width, s.height, s.format, s.framerate);
+            auto counter = &counters[s.stream];
+            if (api == "callback") dev.set_frame_callback(s.stream, [counter](rs::frame f) { counter->add(f.get_frame_number()); });
+        }
+
+        dev.start();
+        std::map<rs::stream, unsigned long long> received, busy;
+        for (auto & s : c.streams)
+        {
+            received[s.stream] = dev.get_stream_metric(s.stream, rs::stream_metric::frames_received);
+            busy[s.stream] = dev.get_stream_metric(s.stream, rs::stream_metric::unpack_nanoseconds) + dev.get_stream_metric(s.stream, rs::stream_metric::callback_nanoseconds);
+        }
+        dev.reset_latency_histograms();
+        const bool has_depth = dev.is_stream_enabled(rs::stream::depth), has_color = dev.is_stream_enabled(rs::stream::color);
+        const auto start = std::chrono::steady_clock::now();
+        const auto cpu_start = std::clock();
+
+        const auto deadline = start + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            if (api == "callback")
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            if (api == "wait") dev.wait_for_frames();
+            else if (!dev.poll_for_frames())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            for (auto & s : c.streams) counters[s.stream].add(dev.get_frame_number(s.stream));
+
+            if (has_depth)
+            {
+                const auto derived_start = std::chrono::steady_clock::now();
+                dev.get_frame_data(rs::stream::points);
+                if (has_color) dev.get_frame_data(rs::stream::depth_aligned_to_color);
+                derived_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - derived_start).count();
+                ++derived_runs;
+            }
+        }
+
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const double process_cpu = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+        for (auto & s : c.streams)
+        {
+            result r;
+            r.configuration = c.name;
+            r.api = api;
+            r.stream = s.stream;
+            r.width = dev.get_stream_width(s.stream);
+            r.height = dev.get_stream_height(s.stream);
+            r.format = dev.get_stream_format(s.stream);
+            r.framerate = dev.get_stream_framerate(s.stream);
+            const auto delivered = counters[s.stream].count();
+            const auto frames = dev.get_stream_metric(s.stream, rs::stream_metric::frames_received) - received[s.stream];
+            r.delivered_fps = delivered / elapsed;
+            r.drop_rate = frames ? 1.0 - (std::min)(1.0, static_cast<double>(delivered) / frames) : 0;
+            const auto nanoseconds = dev.get_stream_metric(s.stream, rs::stream_metric::unpack_nanoseconds) + dev.get_stream_metric(s.stream, rs::stream_metric::callback_nanoseconds) - busy[s.stream];
+            r.cpu_percent = nanoseconds / 1e7 / elapsed;
+            const auto latency = dev.get_stream_latency_histogram(s.stream, rs::frame_metadata::time_of_delivery);
+            r.latency_median_ms = histogram_percentile(latency, 0.5);
+            r.latency_p99_ms = histogram_percentile(latency, 0.99);
+            r.derived_ms = derived_runs ? derived_ms / derived_runs : 0;
+            r.process_cpu_percent = process_cpu * 100 / elapsed;
+            results.push_back(r);
+        }
+        dev.stop();
+    }
+    catch (const rs::error & e)
+    {
+        if (dev.is_streaming()) dev.stop();
+        result r;
+        r.configuration = c.name;
+        r.api = api;
+        r.stream = c.streams.front().stream;
+        r.error = e.what();
+        results.push_back(r);
+    }
+    return results;
+}
+
+void write_csv(const std::vector<result> & results, const std::string & path)
+{
+    std::ofstream out(path);
+    out << "configuration,api,stream,width,height,format,framerate,delivered_fps,drop_rate,cpu_percent,latency_median_ms,latency_p99_ms,derived_ms,process_cpu_percent,error\n";
+    for (auto & r : results)
+    {
+        out << '"' << r.configuration << "\"," << r.api << "," << stream_name(r.stream) << "," << r.width << "," << r.height << "," << format_name(r.format) << "," << r.framerate << ","
+            << r.delivered_fps << "," << r.drop_rate << "," << r.cpu_percent << "," << r.latency_median_ms << "," << r.latency_p99_ms << "," << r.derived_ms << "," << r.process_cpu_percent << ",\"" << r.error << "\"\n";
+    }
+}
+
+void write_json(const std::vector<result> & results, const std::string & path, const std::string & device)
+{
+    auto quoted = [](const std::string & s)
+    {
+        std::string q = "\"";
+        for (auto ch : s)
+        {
+            if (ch == '"' || ch == '\\') q += '\\';
+            q += ch;
+        }
+        return q + "\"";
+    };
+
+    std::ofstream out(path);
+    out << "{\"device\":" << quoted(device) << ",\"results\":[";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto & r = results[i];
+        out << (i ? ",\n" : "\n") << "{\"configuration\":" << quoted(r.configuration) << ",\"api\":" << quoted(r.api) << ",\"stream\":" << quoted(stream_name(r.stream));
+        if (!r.error.empty()) out << ",\"error\":" << quoted(r.error);
+        else
+        {
+            out << ",\"width\":" << r.width << ",\"height\":" << r.height << ",\"format\":" << quoted(format_name(r.format)) << ",\"framerate\":" << r.framerate
+                << ",\"delivered_fps\":" << r.delivered_fps << ",\"drop_rate\":" << r.drop_rate << ",\"cpu_percent\":" << r.cpu_percent
+                << ",\"latency_median_ms\":" << r.latency_median_ms << ",\"latency_p99_ms\":" << r.latency_p99_ms
+                << ",\"derived_ms\":" << r.derived_ms << ",\"process_cpu_percent\":" << r.process_cpu_percent;
+        }
+        out << "}";
+    }
+    out << "\n]}\n";
+}
+
+int main(int argc, char * argv[]) try
+{
+    double seconds = 3;
+    bool quick = false;
+    std::vector<std::string> apis;
+    std::string csv_path, json_path;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], "--seconds=", 10) == 0) seconds = atof(argv[i] + 10);
+        else if (strcmp(argv[i], "--quick") == 0) quick = true;
+        else if (strncmp(argv[i], "--api=", 6) == 0) apis.push_back(argv[i] + 6);
+        else if (strncmp(argv[i], "--csv=", 6) == 0) csv_path = argv[i] + 6;
+        else if (strncmp(argv[i], "--json=", 7) == 0) json_path = argv[i] + 7;
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--seconds=N] [--quick] [--api=wait|poll|callback]... [--csv=path] [--json=path]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (apis.empty()) apis = { "wait", "poll", "callback" };
+    std::stable_sort(apis.begin(), apis.end(), [](const std::string & a, const std::string & b) { return a != "callback" && b == "callback"; });
+
+    rs::log_to_console(rs::log_severity::warn);
+    rs::context ctx;
+    if (ctx.get_device_count() == 0)
+    {
+        std::cerr << "No device detected. Is it plugged in?" << std::endl;
+        return EXIT_FAILURE;
+    }
+    rs::device & dev = *ctx.get_device(0);
+    const std::string device = std::string(dev.get_name()) + " " + dev.get_serial();
+    std::cout << "Qualifying " << device << ", firmware " << dev.get_firmware_version() << std::endl;
+
+    const auto configurations = list_configurations(dev, quick);
+    std::vector<result> results;
+    std::cout << std::left << std::setw(44) << "configuration" << std::setw(9) << "api" << std::setw(11) << "stream" << std::right
+        << std::setw(9) << "fps" << std::setw(8) << "drops" << std::setw(8) << "cpu%" << std::setw(9) << "p50 ms" << std::setw(9) << "p99 ms" << std::setw(11) << "derived ms" << std::endl;
+    for (auto & api : apis)
+    {
+        for (auto & c : configurations)
+        {
+            for (auto & r : capture(dev, c, api, seconds))
+            {
+                std::cout << std::left << std::setw(44) << r.configuration << std::setw(9) << r.api << std::setw(11) << stream_name(r.stream) << std::right << std::fixed << std::setprecision(2);
+                if (!r.error.empty()) std::cout << "  error: " << r.error << std::endl;
+                else std::cout << std::setw(9) << r.delivered_fps << std::setw(8) << r.drop_rate << std::setw(8) << r.cpu_percent
+                    << std::setw(9) << r.latency_median_ms << std::setw(9) << r.latency_p99_ms << std::setw(11) << r.derived_ms << std::endl;
+                results.push_back(r);
+            }
+        }
+    }
+
+    if (!csv_path.empty()) write_csv(results, csv_path);
+    if (!json_path.empty()) write_json(results, json_path, device);
+    return EXIT_SUCCESS;
+}
+catch (const rs::error & e)
+{
+    std::cerr << "RealSense error calling " << e.get_failed_function() << "(" << e.get_failed_args() << "):\n    " << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
@@ -792,6 +792,7 @@ int main(int argc, char * argv[])
                     bool g_clicked = g.click;
                     static int frame_clicked[5] = {};
 
+                    // Start the uploads of every stream before drawing any, so that their transfers to the GPU overlap one another
                     for (auto i = 0; i < 5; i++)
                     {
                         if (!dev->is_stream_enabled((rs::stream)i))
@@ -805,6 +806,12 @@ int main(int argc, char * argv[])
                             frame_timestamp[i] = frame.get_timestamp();
                             fps[i] = frame.get_framerate();
                         }
+                    }
+
+                    for (auto i = 0; i < 5; i++)
+                    {
+                        if (!dev->is_stream_enabled((rs::stream)i))
+                            continue;
 
                         if (g_clicked && gui_click_flag &&
                             g.cursor.x >= center_position.rx && g.cursor.x <= (center_position.rw + center_position.rx) &&
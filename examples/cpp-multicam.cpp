@@ -6,6 +6,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cmath>
 
 std::vector<texture_buffer> buffers;
 
@@ -46,9 +47,10 @@ int main(int argc, char * argv[]) try
     int windowWidth, windowHeight;
     glfwGetWindowSize(win, &windowWidth, &windowHeight);
 
-    // Does not account for correct aspect ratios
-    auto perTextureWidth = int(windowWidth / devices.size());
-    auto perTextureHeight = 480;
+    // Cameras are laid out on a grid, every cell showing color above depth. Does not account for correct aspect ratios
+    const int columns = (int)std::ceil(std::sqrt((double)devices.size())), rows = ((int)devices.size() + columns - 1) / columns;
+    auto perTextureWidth = windowWidth / columns;
+    auto perTextureHeight = windowHeight / (rows * 2);
 
     while (!glfwWindowShouldClose(win))
     {
@@ -65,14 +67,21 @@ int main(int argc, char * argv[]) try
         glPushMatrix();
         glOrtho(0, w, h, 0, -1, +1);
         glPixelZoom(1, -1);
-        int i=0, x=0;
+        // Start the uploads of every camera before drawing any, so that their transfers to the GPU overlap one another
+        int i=0;
         for(auto dev : devices)
         {
             dev->poll_for_frames();
-            const auto c = dev->get_stream_intrinsics(rs::stream::color), d = dev->get_stream_intrinsics(rs::stream::depth);
-            buffers[i++].show(*dev, rs::stream::color, x, 0, perTextureWidth, perTextureHeight);
-            buffers[i++].show(*dev, rs::stream::depth, x, perTextureHeight, perTextureWidth, perTextureHeight);
-            x += perTextureWidth;
+            buffers[i++].upload(*dev, rs::stream::color);
+            buffers[i++].upload(*dev, rs::stream::depth);
+        }
+
+        i=0;
+        for(auto dev : devices)
+        {
+            const int x = (i / 2 % columns) * perTextureWidth, y = (i / 2 / columns) * perTextureHeight * 2;
+            buffers[i++].show(*dev, rs::stream::color, x, y, perTextureWidth, perTextureHeight);
+            buffers[i++].show(*dev, rs::stream::depth, x, y + perTextureHeight, perTextureWidth, perTextureHeight);
         }
 
         glPopMatrix();
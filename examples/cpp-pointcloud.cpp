@@ -79,7 +79,7 @@ int main(int argc, char * argv[]) try
     });
 
     glfwMakeContextCurrent(win);
-    texture_buffer tex;
+    texture_buffer tex(false); // Sampled by the points, so depth is colorized into the texture
 
     int frames = 0; float time = 0, fps = 0;
     auto t0 = std::chrono::high_resolution_clock::now();
@@ -56,8 +56,128 @@ inline void draw_text(int x, int y, const char * text)
 // Image display code //
 ////////////////////////
 
+// Entry points of OpenGL 1.5 and 2.0 for pixel buffer objects and shaders, which the OpenGL headers of Windows do not declare. They are looked up
+// through GLFW once a context is current, and the viewers fall back to synchronous uploads and colorizing depth on the CPU without them.
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#define GL_STREAM_DRAW 0x88E0
+#define GL_WRITE_ONLY 0x88B9
+#endif
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#endif
+#ifndef GL_TEXTURE0
+#define GL_TEXTURE0 0x84C0
+#define GL_TEXTURE1 0x84C1
+#endif
+
+struct gl_entry_points
+{
+    void (APIENTRY * GenBuffers)(GLsizei n, GLuint * buffers);
+    void (APIENTRY * BindBuffer)(GLenum target, GLuint buffer);
+    void (APIENTRY * BufferData)(GLenum target, ptrdiff_t size, const void * data, GLenum usage);
+    void * (APIENTRY * MapBuffer)(GLenum target, GLenum access);
+    GLboolean (APIENTRY * UnmapBuffer)(GLenum target);
+    void (APIENTRY * ActiveTexture)(GLenum texture);
+    GLuint (APIENTRY * CreateShader)(GLenum type);
+    void (APIENTRY * ShaderSource)(GLuint shader, GLsizei count, const char * const * source, const GLint * length);
+    void (APIENTRY * CompileShader)(GLuint shader);
+    void (APIENTRY * GetShaderiv)(GLuint shader, GLenum name, GLint * param);
+    GLuint (APIENTRY * CreateProgram)();
+    void (APIENTRY * AttachShader)(GLuint program, GLuint shader);
+    void (APIENTRY * LinkProgram)(GLuint program);
+    void (APIENTRY * GetProgramiv)(GLuint program, GLenum name, GLint * param);
+    void (APIENTRY * UseProgram)(GLuint program);
+    GLint (APIENTRY * GetUniformLocation)(GLuint program, const char * name);
+    void (APIENTRY * Uniform1i)(GLint location, GLint value);
+
+    bool has_buffers, has_shaders;
+    GLuint depth_program;   // Colors depth through the lookup table of its histogram, 0 without shaders
+
+    // Resolved in the context current the first time they are asked for, which the viewers keep for their whole run
+    static const gl_entry_points & get()
+    {
+        static const gl_entry_points entry_points;
+        return entry_points;
+    }
+
+private:
+    template<class T> void resolve(T & function, const char * name, bool & available)
+    {
+        function = reinterpret_cast<T>(glfwGetProcAddress(name));
+        available = available && function;
+    }
+
+    gl_entry_points() : has_buffers(true), has_shaders(true), depth_program()
+    {
+        resolve(GenBuffers, "glGenBuffers", has_buffers);
+        resolve(BindBuffer, "glBindBuffer", has_buffers);
+        resolve(BufferData, "glBufferData", has_buffers);
+        resolve(MapBuffer, "glMapBuffer", has_buffers);
+        resolve(UnmapBuffer, "glUnmapBuffer", has_buffers);
+        resolve(ActiveTexture, "glActiveTexture", has_shaders);
+        resolve(CreateShader, "glCreateShader", has_shaders);
+        resolve(ShaderSource, "glShaderSource", has_shaders);
+        resolve(CompileShader, "glCompileShader", has_shaders);
+        resolve(GetShaderiv, "glGetShaderiv", has_shaders);
+        resolve(CreateProgram, "glCreateProgram", has_shaders);
+        resolve(AttachShader, "glAttachShader", has_shaders);
+        resolve(LinkProgram, "glLinkProgram", has_shaders);
+        resolve(GetProgramiv, "glGetProgramiv", has_shaders);
+        resolve(UseProgram, "glUseProgram", has_shaders);
+        resolve(GetUniformLocation, "glGetUniformLocation", has_shaders);
+        resolve(Uniform1i, "glUniform1i", has_shaders);
+        if(has_shaders) depth_program = compile_depth_program();
+    }
+
+    // Depth arrives as 16 bit luminance and the table as 256 x 256 luminance, holding for every depth its place in the histogram of the frame,
+    // so that every pixel gets the colors of make_depth_histogram(...) without the CPU writing any of them
+    GLuint compile_depth_program() const
+    {
+        static const char * source =
+            "uniform sampler2D depth, histogram;\n"
+            "void main()\n"
+            "{\n"
+            "    float d = floor(texture2D(depth, gl_TexCoord[0].st).r * 65535.0 + 0.5);\n"
+            "    float f = texture2D(histogram, (vec2(mod(d, 256.0), floor(d / 256.0)) + 0.5) / 256.0).r;\n"
+            "    gl_FragColor = d > 0.0 ? vec4(1.0 - f, 0.0, f, 1.0) : vec4(20.0 / 255.0, 5.0 / 255.0, 0.0, 1.0);\n"
+            "}\n";
+        GLint compiled = 0, linked = 0;
+        const GLuint shader = CreateShader(GL_FRAGMENT_SHADER);
+        ShaderSource(shader, 1, &source, nullptr);
+        CompileShader(shader);
+        GetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if(!compiled) return 0;
+        const GLuint program = CreateProgram();
+        AttachShader(program, shader);
+        LinkProgram(program);
+        GetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(!linked) return 0;
+        UseProgram(program);
+        Uniform1i(GetUniformLocation(program, "depth"), 0);
+        Uniform1i(GetUniformLocation(program, "histogram"), 1);
+        UseProgram(0);
+        return program;
+    }
+};
+
+// Place of every depth in the cumulative histogram of a frame, from 0 to 255, as make_depth_histogram(...) colors it
+inline void make_depth_histogram_table(uint8_t table[0x10000], const uint16_t depth_image[], int width, int height, int stride)
+{
+    static uint32_t histogram[0x10000];
+    memset(histogram, 0, sizeof(histogram));
+
+    for(int y = 0; y < height; ++y) for(int x = 0; x < width; ++x) ++histogram[depth_image[y * stride + x]];
+    for(int i = 2; i < 0x10000; ++i) histogram[i] += histogram[i-1];
+    for(int i = 0; i < 0x10000; ++i) table[i] = histogram[0xFFFF] ? static_cast<uint8_t>(histogram[i] * 255ull / histogram[0xFFFF]) : 0;
+}
+
 class texture_buffer
 {
+    enum { pixel_buffers = 3 }; // Frames being copied while earlier ones still transfer to the texture
+
     GLuint texture;
     double last_timestamp;
     std::vector<uint8_t> rgb;
@@ -65,8 +185,62 @@ class texture_buffer
     int fps, num_frames;
     double next_time;
 
+    // Storage of the texture, reallocated only when the images change shape
+    int texture_width, texture_height;
+    GLint texture_format;
+    GLuint pixel_buffer[pixel_buffers];
+    int next_buffer;
+    GLuint histogram_texture;   // Of the depth colorized on the GPU
+    std::vector<uint8_t> histogram;
+    bool gpu_depth_colors;      // Whether depth may be colorized by the shader of show(...)
+    bool colorize_depth;
+
+    // Writes the pixels into the next pixel buffer and starts their transfer to the texture, which the GPU carries out without the application
+    // waiting. Drivers only block the copy into a buffer until its previous transfer is done, so the ring keeps the render thread running.
+    void transfer(GLuint target, int width, int height, int row_length, GLenum format, GLenum type, const void * pixels, size_t size)
+    {
+        auto & gl = gl_entry_points::get();
+        glBindTexture(GL_TEXTURE_2D, target);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
+        if(!gl.has_buffers)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, pixels);
+        }
+        else
+        {
+            if(!pixel_buffer[0]) gl.GenBuffers(pixel_buffers, pixel_buffer);
+            gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer[next_buffer]);
+            gl.BufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<ptrdiff_t>(size), nullptr, GL_STREAM_DRAW); // Orphans the storage a transfer may still read
+            if(auto mapped = gl.MapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY))
+            {
+                memcpy(mapped, pixels, size);
+                gl.UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, nullptr);
+            }
+            gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            next_buffer = (next_buffer + 1) % pixel_buffers;
+        }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+
+    void allocate(int width, int height, GLint internal_format, GLenum format, GLenum type, GLint filter)
+    {
+        if(width == texture_width && height == texture_height && internal_format == texture_format) return;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+        texture_width = width;
+        texture_height = height;
+        texture_format = internal_format;
+    }
+
 public:
-    texture_buffer() : texture(), last_timestamp(-1), fps(), num_frames(), next_time(1000) {}
+    // Textures sampled by the application rather than through show(...) need depth colorized on the CPU, into the texture itself
+    explicit texture_buffer(bool gpu_depth_colors = true) : texture(), last_timestamp(-1), fps(), num_frames(), next_time(1000), texture_width(), texture_height(), texture_format(), pixel_buffer(), next_buffer(), histogram_texture(),
+        gpu_depth_colors(gpu_depth_colors), colorize_depth() {}
 
     GLuint get_gl_handle() const { return texture; }
 
@@ -74,40 +248,61 @@ public:
     {
         // If the frame timestamp has changed since the last time show(...) was called, re-upload the texture
         if(!texture) glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
         stride = stride == 0 ? width : stride;
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+        colorize_depth = false;
+
+        // The texture takes the image as it is, other than the formats converted on the CPU below
+        GLint internal_format = GL_RGB;
+        GLenum pixel_format = GL_RGB, type = GL_UNSIGNED_BYTE;
+        int pixel_size = 3, texture_w = width, texture_h = height, row_length = stride;
         switch(format)
         {
         case rs::format::any:
         throw std::runtime_error("not a valid format");
         case rs::format::z16:
         case rs::format::disparity16:
+            if(gpu_depth_colors && gl_entry_points::get().depth_program)
+            {
+                // Only the table of the histogram is computed on the CPU, the shader of show(...) colors the pixels
+                colorize_depth = true;
+                histogram.resize(0x10000);
+                make_depth_histogram_table(histogram.data(), reinterpret_cast<const uint16_t *>(data), width, height, stride);
+                if(!histogram_texture)
+                {
+                    glGenTextures(1, &histogram_texture);
+                    glBindTexture(GL_TEXTURE_2D, histogram_texture);
+                    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, 256, 256, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, nullptr);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                }
+                transfer(histogram_texture, 256, 256, 256, GL_LUMINANCE, GL_UNSIGNED_BYTE, histogram.data(), histogram.size());
+                internal_format = GL_LUMINANCE16; pixel_format = GL_LUMINANCE; type = GL_UNSIGNED_SHORT; pixel_size = 2;
+                break;
+            }
             rgb.resize(stride * height * 3);
             make_depth_histogram(rgb.data(), reinterpret_cast<const uint16_t *>(data), stride, height);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, stride, height, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
-            
+            data = rgb.data();
+            texture_w = stride;
             break;
         case rs::format::xyz32f:
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_FLOAT, data);
+            type = GL_FLOAT; pixel_size = 12;
             break;
         case rs::format::yuyv: // Display YUYV by showing the luminance channel and packing chrominance into ignored alpha channel
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, data);
+            pixel_format = GL_LUMINANCE_ALPHA; pixel_size = 2;
             break;
         case rs::format::rgb8: case rs::format::bgr8: // Display both RGB and BGR by interpreting them RGB, to show the flipped byte ordering. Obviously, GL_BGR could be used on OpenGL 1.2+
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
             break;
         case rs::format::rgba8: case rs::format::bgra8: // Display both RGBA and BGRA by interpreting them RGBA, to show the flipped byte ordering. Obviously, GL_BGRA could be used on OpenGL 1.2+
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            internal_format = GL_RGBA; pixel_format = GL_RGBA; pixel_size = 4;
             break;
         case rs::format::y8:
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB,  width, height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
+            pixel_format = GL_LUMINANCE; pixel_size = 1;
             break;
         case rs::format::y16:
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_SHORT, data);
+            pixel_format = GL_LUMINANCE; type = GL_UNSIGNED_SHORT; pixel_size = 2;
             break;
         case rs::format::raw8:
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
+            internal_format = GL_LUMINANCE; pixel_format = GL_LUMINANCE; pixel_size = 1;
             break;
         case rs::format::raw10:
             {
@@ -124,13 +319,14 @@ public:
                     }
                     in0 = in1; in1 += width*5/4;
                 }
-                glPixelStorei(GL_UNPACK_ROW_LENGTH, width / 2);        // Update row stride to reflect post-downsampling dimensions of the target texture
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width/2, height/2, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
+                data = rgb.data();
+                texture_w = row_length = width / 2;        // Update row stride to reflect post-downsampling dimensions of the target texture
+                texture_h = height / 2;
             }
             break;
         case rs::format::raw16:
             // All RAW formats will be treated and displayed as Greyscale images
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_SHORT, data);
+            pixel_format = GL_LUMINANCE; type = GL_UNSIGNED_SHORT; pixel_size = 2;
             break;
         default:
             {
@@ -139,11 +335,10 @@ public:
                 throw std::runtime_error(ss.str().c_str());
             }
         }
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+        // Depth is looked up pixel by pixel, so it is never blended with its neighbours or with pixels without depth
+        allocate(texture_w, texture_h, internal_format, pixel_format, type, colorize_depth ? GL_NEAREST : GL_LINEAR);
+        transfer(texture, texture_w, texture_h, row_length, pixel_format, type, data, static_cast<size_t>(row_length) * (texture_h - 1) * pixel_size + static_cast<size_t>(texture_w) * pixel_size);
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
@@ -188,6 +383,14 @@ public:
 
     void show(float rx, float ry, float rw, float rh) const
     {
+        auto & gl = gl_entry_points::get();
+        if(colorize_depth)
+        {
+            gl.ActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, histogram_texture);
+            gl.ActiveTexture(GL_TEXTURE0);
+            gl.UseProgram(gl.depth_program);
+        }
         glBindTexture(GL_TEXTURE_2D, texture);
         glEnable(GL_TEXTURE_2D);
         glBegin(GL_QUADS);
@@ -198,6 +401,13 @@ public:
         glEnd();
         glDisable(GL_TEXTURE_2D);
         glBindTexture(GL_TEXTURE_2D, 0);
+        if(colorize_depth)
+        {
+            gl.UseProgram(0);
+            gl.ActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            gl.ActiveTexture(GL_TEXTURE0);
+        }
     }
 
     void print(int x, int y, const char * text)
@@ -29,6 +29,9 @@ extern "C" {
 /* Return version in "X.Y.Z" format */
 #define RS_API_VERSION_STR (VAR_ARG_STRING(RS_API_MAJOR_VERSION.RS_API_MINOR_VERSION.RS_API_PATCH_VERSION))
 
+#define RS_LATENCY_HISTOGRAM_BIN_COUNT 24 /**< Bins of the histograms of rs_get_stream_latency_histogram() */
+#define RS_MAX_FRAME_BUFFERS 64 /**< Buffers rs_set_stream_frame_buffers() accepts for a stream */
+
 /** \brief Streams are different types of data provided by RealSense devices */
 typedef enum rs_stream
 {
@@ -39,11 +42,14 @@ typedef enum rs_stream
     RS_STREAM_FISHEYE                          , /**< Native stream of fish-eye (wide) data captured from the dedicate motion camera */
     RS_STREAM_POINTS                           , /**< Synthetic stream containing point cloud data generated by deprojecting the depth image */
     RS_STREAM_RECTIFIED_COLOR                  , /**< Synthetic stream containing undistorted color data with no extrinsic rotation from the depth stream */
-    RS_STREAM_COLOR_ALIGNED_TO_DEPTH           , /**< Synthetic stream containing color data but sharing intrinsic of depth stream */
+    RS_STREAM_COLOR_ALIGNED_TO_DEPTH           , /**< Synthetic stream containing color data but sharing intrinsic of depth stream. YUYV color is delivered as RGB8, converting only the pixels that land on depth. */
     RS_STREAM_INFRARED2_ALIGNED_TO_DEPTH       , /**< Synthetic stream containing second viewpoint infrared data but sharing intrinsic of depth stream */
     RS_STREAM_DEPTH_ALIGNED_TO_COLOR           , /**< Synthetic stream containing depth data but sharing intrinsic of color stream */
     RS_STREAM_DEPTH_ALIGNED_TO_RECTIFIED_COLOR , /**< Synthetic stream containing depth data but sharing intrinsic of rectified color stream */
     RS_STREAM_DEPTH_ALIGNED_TO_INFRARED2       , /**< Synthetic stream containing depth data but sharing intrinsic of second viewpoint infrared stream */
+    RS_STREAM_DEPTH_COLORIZED                  , /**< Synthetic stream containing the depth image colored for display as RGB8, see RS_OPTION_DEPTH_COLORIZER_* */
+    RS_STREAM_RECTIFIED_FISHEYE                , /**< Synthetic stream containing fish-eye data undistorted to a pinhole image of the same focal length and principal point, sampled bilinearly */
+    RS_STREAM_NORMALS                          , /**< Synthetic stream containing the unit surface normal behind every depth pixel as XYZ32F, facing the camera, and zero on the border of the image and next to pixels without depth */
     RS_STREAM_COUNT                              /**< Number of enumeration values. Not a valid input: intended to be used in for-loops. */
 } rs_stream;
 
@@ -66,6 +72,12 @@ typedef enum rs_format
     RS_FORMAT_RAW10       , /**< Four 10-bit luminance values encoded into a 5-byte macropixel */
     RS_FORMAT_RAW16       , /**< 16-bit raw image */
     RS_FORMAT_RAW8        , /**< 8-bit raw image */
+    RS_FORMAT_XYZ16F      , /**< 16-bit half precision floating point 3D coordinates, in meters. */
+    RS_FORMAT_XYZ16       , /**< 16-bit signed 3D coordinates, in millimeters. Coordinates beyond 32.767 meters are clamped. */
+    RS_FORMAT_XYZUV32F    , /**< 32-bit floating point 3D coordinates, in meters, each followed by the coordinates of the color pixel it projects to, normalized by the color image size. */
+    RS_FORMAT_NV12        , /**< 8-bit luminance plane followed by a plane of interleaved U and V samples, one pair per 2x2 pixels, as video encoders take. Rows are as wide as the image. */
+    RS_FORMAT_I420        , /**< 8-bit luminance plane followed by a U plane and a V plane of one sample per 2x2 pixels, as video encoders take. Chroma rows are half as wide as the image. */
+    RS_FORMAT_XYZ32F_PLANAR, /**< 32-bit floating point 3D coordinates, in meters, as a plane of X followed by a plane of Y and a plane of Z, each with rows of the stride of the frame, for consumers that process every coordinate in vectors. */
     RS_FORMAT_COUNT         /**< Number of enumeration values. Not a valid input: intended to be used in for-loops. */
 } rs_format;
 
@@ -192,9 +204,39 @@ typedef enum rs_option
     RS_OPTION_FISHEYE_AUTO_EXPOSURE_ANTIFLICKER_RATE          , /**< Fisheye auto-exposure anti-flicker rate. Can be 50 or 60 Hz. */
     RS_OPTION_FISHEYE_AUTO_EXPOSURE_PIXEL_SAMPLE_RATE         , /**< In Fisheye auto-exposure sample frame every given number of pixels */
     RS_OPTION_FISHEYE_AUTO_EXPOSURE_SKIP_FRAMES               , /**< In Fisheye auto-exposure sample every given number of frames */
-    RS_OPTION_FRAMES_QUEUE_SIZE                               , /**< Number of frames the user is allowed to keep per stream. Trying to hold on to more frames will cause frame-drops.*/
+    RS_OPTION_FRAMES_QUEUE_SIZE                               , /**< Number of frames the user is allowed to keep per stream, up to 1000. Trying to hold on to more frames will cause frame-drops. The frame pools are sized for it by rs_start_device(), growing on demand, and it can only be raised up to that size while streaming.*/
     RS_OPTION_HARDWARE_LOGGER_ENABLED                         , /**< Enable/disable fetching log data from the device */
     RS_OPTION_TOTAL_FRAME_DROPS                               , /**< Total number of detected frame drops from all streams */
+    RS_OPTION_FRAME_UNPACK_THREADS                            , /**< Number of library threads unpacking frames off the capture thread, 0 unpacks on the capture thread. Can only be changed while the device is stopped.*/
+    RS_OPTION_DEPTH_DECIMATION_FACTOR                         , /**< Shrink the depth stream by this factor in both dimensions as it is unpacked, 1 delivers it at full resolution. Depth intrinsics are scaled to match. Can only be changed while the device is stopped.*/
+    RS_OPTION_DEPTH_DECIMATION_MODE                           , /**< 0 - every decimated depth pixel is the median of the non-zero pixels it covers, 1 - their mean. Can only be changed while the device is stopped.*/
+    RS_OPTION_DEPTH_SPATIAL_FILTER_ALPHA                      , /**< Weight of every depth pixel against its already smoothed neighbours, 1 disables the edge-preserving spatial filter. Can only be changed while the device is stopped.*/
+    RS_OPTION_DEPTH_SPATIAL_FILTER_DELTA                      , /**< Neighbouring depth pixels which differ by this many depth units or more lie across an edge, and are not smoothed together. Can only be changed while the device is stopped.*/
+    RS_OPTION_DEPTH_TEMPORAL_FILTER_ALPHA                     , /**< Weight of every depth pixel against its smoothed value in the previous frames, 1 disables temporal smoothing. Can only be changed while the device is stopped.*/
+    RS_OPTION_DEPTH_TEMPORAL_FILTER_DELTA                     , /**< Depth pixels which changed by this many depth units or more since the previous frames are not smoothed, so motion is not blurred. Can only be changed while the device is stopped.*/
+    RS_OPTION_DEPTH_TEMPORAL_FILTER_PERSISTENCE               , /**< Number of frames a depth pixel without data keeps reporting its last valid depth, 0 reports holes as they are. Can only be changed while the device is stopped.*/
+    RS_OPTION_DEPTH_STATISTICS_ENABLED                        , /**< Gather the range, valid pixel count and coarse histogram of every depth frame while it is unpacked, as RS_FRAME_METADATA_DEPTH_* values. Can only be changed while the device is stopped.*/
+    RS_OPTION_PRECOMPUTED_STREAMS                             , /**< Bit mask of the derived streams computed on library threads, in parallel with one another, as soon as the frameset they follow arrives, bit 0 standing for RS_STREAM_POINTS and bit k for the stream k after it. rs_get_frame_data() then returns them ready-made after rs_wait_for_frames() or rs_poll_for_frames(). Not used while a frameset callback is set. Can only be changed while the device is stopped.*/
+    RS_OPTION_DEPTH_COLORIZER_EQUALIZATION_ENABLED            , /**< 1 - RS_STREAM_DEPTH_COLORIZED spreads its colors evenly over the depths in each frame, 0 - over the distances from zero to RS_OPTION_DEPTH_COLORIZER_MAX_DISTANCE */
+    RS_OPTION_DEPTH_COLORIZER_MAX_DISTANCE                    , /**< Distance in meters that RS_STREAM_DEPTH_COLORIZED draws in the color of the farthest depth, while equalization is disabled */
+    RS_OPTION_POINTS_VOXEL_SIZE                               , /**< Edge in meters of the cubes RS_STREAM_POINTS is reduced to, one mean point per cube in front of the frame and zeros after them. 0 keeps one point per pixel */
+    RS_OPTION_CAPTURE_THREAD_AFFINITY                         , /**< Bit mask of the CPUs the threads receiving frames from the camera may run on, 0 for every CPU. Not supported on Windows */
+    RS_OPTION_CAPTURE_THREAD_PRIORITY                         , /**< SCHED_FIFO priority from 1 to 99 of the threads receiving frames from the camera, 0 for the default scheduling. Requires CAP_SYS_NICE, not supported on Windows */
+    RS_OPTION_CAPTURE_MEMORY                                  , /**< Where the camera driver writes frames: 0 - its own buffers mapped into the process, 1 - blocks of the frame allocator (V4L2 USERPTR), 2 - the dma-bufs given to rs_set_stream_capture_dmabufs() (V4L2 DMABUF). Pass-through streams are delivered in that memory. Only supported by the V4L2 backend. Can only be changed while the device is stopped.*/
+    RS_OPTION_MOTION_DATA_TRANSFER_COUNT                      , /**< Number of USB interrupt transfers kept queued for motion and timestamp events, from 1 to 32. More of them ride out longer stalls of the library thread receiving the events. Not supported on Windows. Can only be changed while motion tracking is stopped.*/
+    RS_OPTION_CONTROL_RETRY_BUDGET                            , /**< Milliseconds the library may spend waiting between attempts at a failing camera control request, from 0 to 10000. Retries back off exponentially, and requests the camera refuses outright fail at once. 0 makes every request a single attempt.*/
+    RS_OPTION_GPU_PROCESSING_ENABLED                          , /**< 1 - RS_STREAM_POINTS, RS_STREAM_RECTIFIED_COLOR and the aligned streams of depth and of images aligned to Z16 depth are computed on the CUDA device, keeping their calibration tables resident there, 0 - on the CPU. Requires a library built with BUILD_WITH_CUDA. Can only be changed while the device is stopped.*/
+    RS_OPTION_DERIVED_ROW_ALIGNMENT                           , /**< Bytes the rows of RS_STREAM_POINTS, RS_STREAM_NORMALS, the rectified streams and the aligned streams start on a multiple of, padding each row as rs_get_frame_stride_x() then reports: 0 keeps rows packed, otherwise a power of two up to 64. Padded rows let SIMD code read derived images as it reads native ones in RS_OUTPUT_BUFFER_FORMAT_NATIVE. Points reduced to voxels stay a packed list. Can only be changed while the device is stopped.*/
+    RS_OPTION_FRAME_MEMORY_PAGES                              , /**< Pages backing the frame memory of the library when no frame allocator was set: 0 - the heap, 1 - transparent huge pages of 2 MB, 2 - explicit huge pages reserved by the system (MAP_HUGETLB, or MEM_LARGE_PAGES on Windows). Huge pages save TLB misses in the kernels walking large frames, at the cost of every frame buffer taking whole huge pages. While streaming, reads return the pages actually provided, after falling back from pages the system could not give. Can only be changed while the device is stopped.*/
+    RS_OPTION_NUMA_LOCALITY_ENABLED                           , /**< 1 - frame memory of the library, and the threads capturing, unpacking and precomputing frames, are placed on the NUMA node of the USB host controller of the device, as Linux reports it in sysfs, 0 - anywhere. A nonzero RS_OPTION_CAPTURE_THREAD_AFFINITY takes precedence for the capture threads. Devices on an unknown node are placed as usual. Can only be changed while the device is stopped.*/
+    RS_OPTION_FRAME_MAILBOX_ENABLED                           , /**< 1 - every stream without a frame callback keeps only its latest frame, in a slot rs_get_latest_frame() empties without ever blocking, and the frame it replaces is recycled at once, 0 - frames are queued and matched into framesets for rs_wait_for_frames(). Mailboxes skip timestamp matching, for consumers which always want the newest frame, such as control loops. Can only be changed while the device is stopped.*/
+    RS_OPTION_INTERLEAVED_VIEWS_ENABLED                       , /**< 1 - streams interleaved in the pixels of one native frame, such as the infrared pair of Y8I, are handed out as strided views of the driver buffer instead of being split into frames of their own, 0 - they are split while the frame is unpacked. Views are only made when the driver buffer can be held, see rs_get_frame_strided_data(), and rs_get_frame_data() packs their pixels the first time it is called. Can only be changed while the device is stopped.*/
+    RS_OPTION_DEPTH_PYRAMID_LEVELS                            , /**< Number of levels of a depth pyramid built behind every depth frame right after it is unpacked, filtered and decimated, 0 to disable. Every level halves the one before in both dimensions, each of its pixels being the mean of the non-zero pixels of the 2x2 block under it, see rs_get_detached_frame_pyramid_level() and rs_get_depth_pyramid_intrinsics(). Can only be changed while the device is stopped.*/
+    RS_OPTION_FRAME_UNPACK_BANDS                              , /**< Most bands of rows a single native frame is split into, each unpacked on a thread of its own, from 1 to 8. Every mode gets as many bands as keep each at 256 KiB of native data or more, so that large color frames split across many threads while small depth frames stay whole, and planar formats are never split. 1 unpacks every frame on a single thread. Can only be changed while the device is stopped.*/
+    RS_OPTION_COLOR_DEMOSAIC_MODE                             , /**< How RGB8 and Y16 color is demosaiced from RAW10 modes: 0 - bilinear interpolation, 1 - interpolation corrected by the gradients of the color known at each pixel, which keeps edges sharper at a little more work. Can only be changed while the device is stopped.*/
+    RS_OPTION_DEPTH_RUNS_ENABLED                              , /**< Enable / disable finding the runs of consecutive pixels with depth data of every row of every depth frame, right after its pyramid is built, see rs_get_detached_frame_depth_runs(). Point clouds and images aligned to depth then only visit the pixels with data, so their cost follows the number of valid pixels rather than the size of the frame. Can only be changed while the device is stopped.*/
+    RS_OPTION_INCREMENTAL_PROCESSING_ENABLED                  , /**< Enable / disable recomputing RS_STREAM_POINTS and RS_STREAM_RECTIFIED_COLOR only in the tiles of 64x4 pixels of their source that changed since the previous frame, keeping the rest of the image computed before, and keeping aligned images whole while neither of their sources changed. Suits cameras at rest in static scenes. Applies to images computed on the CPU when they are read, not to those computed ahead of the frameset. Can only be changed while the device is stopped.*/
+    RS_OPTION_ZERO_COPY_ENABLED                               , /**< Enable / disable handing out the frames of streams the device delivers in their native layout, and the planes of NV12, I420 and similar images, in the memory the driver captured them in, on backends which keep it valid until the frames are released. Every frame the application holds then keeps a driver buffer from capturing, out of 8 per subdevice unless rs_set_stream_capture_buffer_count() sets more, so that capture stalls once that many are held: lower RS_OPTION_FRAMES_QUEUE_SIZE to match. Disabled, the frames are copied out of the driver buffers. Can only be changed while the device is stopped.*/
     RS_OPTION_COUNT                                           , /**< Number of enumeration values. Not a valid input: intended to be used in for-loops. */
 
 } rs_option;
@@ -202,9 +244,28 @@ typedef enum rs_option
 /** \brief Types of value provided from the device with each frame */
 typedef enum rs_frame_metadata
 {
-    RS_FRAME_METADATA_ACTUAL_EXPOSURE, /**< Actual exposure at which the frame was captured */
-    RS_FRAME_METADATA_ACTUAL_FPS,      /**< Actual FPS at the time of capture */
-    RS_FRAME_METADATA_COUNT            /**< Number of enumeration values. Not a valid input: intended to be used in for-loops. */
+    RS_FRAME_METADATA_ACTUAL_EXPOSURE,     /**< Actual exposure at which the frame was captured */
+    RS_FRAME_METADATA_ACTUAL_FPS,          /**< Actual FPS at the time of capture */
+    RS_FRAME_METADATA_DEPTH_MIN,           /**< Smallest value of the depth pixels with data, 0 if there are none. Provided on depth frames while RS_OPTION_DEPTH_STATISTICS_ENABLED is set */
+    RS_FRAME_METADATA_DEPTH_MAX,           /**< Largest value of the depth pixels with data */
+    RS_FRAME_METADATA_DEPTH_VALID_PIXELS,  /**< Number of depth pixels with data */
+    RS_FRAME_METADATA_DEPTH_HISTOGRAM_0,   /**< Number of depth pixels from 1 to 255 depth units */
+    RS_FRAME_METADATA_DEPTH_HISTOGRAM_1,   /**< Number of depth pixels from 256 to 511 depth units */
+    RS_FRAME_METADATA_DEPTH_HISTOGRAM_2,   /**< Number of depth pixels from 512 to 1023 depth units */
+    RS_FRAME_METADATA_DEPTH_HISTOGRAM_3,   /**< Number of depth pixels from 1024 to 2047 depth units */
+    RS_FRAME_METADATA_DEPTH_HISTOGRAM_4,   /**< Number of depth pixels from 2048 to 4095 depth units */
+    RS_FRAME_METADATA_DEPTH_HISTOGRAM_5,   /**< Number of depth pixels from 4096 to 8191 depth units */
+    RS_FRAME_METADATA_DEPTH_HISTOGRAM_6,   /**< Number of depth pixels from 8192 to 16383 depth units */
+    RS_FRAME_METADATA_DEPTH_HISTOGRAM_7,   /**< Number of depth pixels of 16384 depth units or more */
+    RS_FRAME_METADATA_TIME_OF_DEQUEUE,     /**< Time the driver handed over the native frame, in milliseconds of a monotonic clock of the host. Provided on every frame captured, as the later stages are */
+    RS_FRAME_METADATA_TIME_OF_VALIDATION,  /**< Time the native frame was validated and timestamped */
+    RS_FRAME_METADATA_TIME_OF_UNPACK_START, /**< Time unpacking of the native frame started, or the frame was handed on for formats needing none */
+    RS_FRAME_METADATA_TIME_OF_UNPACK_END,  /**< Time unpacking of the native frame ended */
+    RS_FRAME_METADATA_TIME_OF_COMMIT,      /**< Time the frame was committed to the archive, or published for its frame callback */
+    RS_FRAME_METADATA_TIME_OF_SYNC,        /**< Time the frame was matched into a frameset. Not provided on frames delivered to frame callbacks */
+    RS_FRAME_METADATA_TIME_OF_DELIVERY,    /**< Time the frame was first handed to the application, by a callback or by waiting or polling for frames */
+    RS_FRAME_METADATA_TIME_OF_EXPOSURE,    /**< Time of the device timestamp of the frame, mapped to the monotonic clock of the host by an estimate of the offset between the clocks which leaves out the quickest transfer of recent frames. Provided on every frame captured, the estimate settling over the first frames of a subdevice */
+    RS_FRAME_METADATA_COUNT                /**< Number of enumeration values. Not a valid input: intended to be used in for-loops. */
 } rs_frame_metadata;
 
 /** \brief Specifies various capabilities of a RealSense device.
@@ -296,6 +357,68 @@ typedef enum rs_timestamp_domain
     RS_TIMESTAMP_DOMAIN_COUNT            /**< Number of enumeration values. Not a valid input: intended to be used in for-loops. */
 }rs_timestamp_domain;
 
+/** \brief Specifies which frame is discarded once the library queue of a stream is full */
+typedef enum rs_frame_drop_policy
+{
+    RS_FRAME_DROP_POLICY_DROP_OLDEST, /**< Discard the oldest queued frame to make room for the one that just arrived. This is the default. */
+    RS_FRAME_DROP_POLICY_DROP_NEWEST, /**< Keep the queued frames and discard the one that just arrived */
+    RS_FRAME_DROP_POLICY_LATEST_ONLY, /**< Only ever keep the most recent frame, regardless of the queue depth */
+    RS_FRAME_DROP_POLICY_COUNT        /**< Number of enumeration values. Not a valid input: intended to be used in for-loops. */
+}rs_frame_drop_policy;
+
+/** \brief Specifies what becomes of the framesets of a multi-device synchronizer which found no match on some of the devices */
+typedef enum rs_straggler_policy
+{
+    RS_STRAGGLER_POLICY_DROP_SET       , /**< Release the framesets of an incomplete set without delivering them. This is the default. */
+    RS_STRAGGLER_POLICY_DELIVER_PARTIAL, /**< Deliver an incomplete set, with no frameset for the devices it is missing */
+    RS_STRAGGLER_POLICY_COUNT            /**< Number of enumeration values. Not a valid input: intended to be used in for-loops. */
+}rs_straggler_policy;
+
+/** \brief Specifies when a device replaying a recording delivers its next frame */
+typedef enum rs_playback_pacing
+{
+    RS_PLAYBACK_PACING_REAL_TIME          , /**< Frames are delivered as far apart as they were captured. This is the default. */
+    RS_PLAYBACK_PACING_AS_FAST_AS_POSSIBLE, /**< Frames are delivered as soon as the previous frame was handled */
+    RS_PLAYBACK_PACING_STEP               , /**< Frames are delivered one at a time, on every call to rs_step_playback() */
+    RS_PLAYBACK_PACING_COUNT                /**< Number of enumeration values. Not a valid input: intended to be used in for-loops. */
+}rs_playback_pacing;
+
+/** \brief Counters of what happened to the frames of a native stream, read with rs_get_stream_metric() */
+typedef enum rs_stream_metric
+{
+    RS_STREAM_METRIC_FRAMES_RECEIVED     , /**< Native frames the driver delivered, including those found invalid */
+    RS_STREAM_METRIC_FRAMES_INVALID      , /**< Native frames rejected as corrupted before being unpacked */
+    RS_STREAM_METRIC_FRAMES_CULLED       , /**< Frames the sync archive discarded, to form coherent framesets or to honor the queue policy of the stream */
+    RS_STREAM_METRIC_FRAMES_UNPUBLISHED  , /**< Frames dropped for lack of a free slot in the frame pools, or because the application held RS_OPTION_FRAMES_QUEUE_SIZE frames of the stream */
+    RS_STREAM_METRIC_QUEUED_FRAMES       , /**< Frames currently waiting in the sync archive. Unlike the other metrics, this one is not cumulative. */
+    RS_STREAM_METRIC_UNPACK_NANOSECONDS  , /**< Total time spent unpacking the native frames the stream is unpacked from */
+    RS_STREAM_METRIC_CALLBACK_NANOSECONDS, /**< Total time spent in the frame callback of the stream */
+    RS_STREAM_METRIC_DERIVED_FRAMES_SHED , /**< Framesets whose streams derived from this one were not precomputed, to shed load. Counted on the native stream the derived stream is computed from. */
+    RS_STREAM_METRIC_UNPACKS_SHED        , /**< Native frames released without being unpacked because every stream they provide had a full queue, to shed load */
+    RS_STREAM_METRIC_FRAMES_DECIMATED    , /**< Native frames released without being unpacked to lower the frame rate, to shed load */
+    RS_STREAM_METRIC_COUNT                 /**< Number of enumeration values. Not a valid input: intended to be used in for-loops. */
+}rs_stream_metric;
+
+/** \brief Counters of the transfers of the USB interface a native stream is captured from, read with rs_get_transfer_statistic() */
+typedef enum rs_transfer_statistic
+{
+    RS_TRANSFER_STATISTIC_BYTES           , /**< Bytes of the frames received */
+    RS_TRANSFER_STATISTIC_BYTES_PER_SECOND, /**< Bytes received over the last second measured, 0 once two seconds passed without any frame. Unlike the other statistics, this one is not cumulative. */
+    RS_TRANSFER_STATISTIC_FRAMES          , /**< Frames received, including short ones */
+    RS_TRANSFER_STATISTIC_SHORT_FRAMES    , /**< Frames which arrived with fewer bytes than their mode has */
+    RS_TRANSFER_STATISTIC_ERRORS          , /**< Transfers, packets and dequeues the USB stack or driver reported as failed */
+    RS_TRANSFER_STATISTIC_COUNT             /**< Number of enumeration values. Not a valid input: intended to be used in for-loops. */
+}rs_transfer_statistic;
+
+/** \brief Ways a device sheds load once its application falls behind, taken in the order given to rs_set_load_shedding() */
+typedef enum rs_load_shedding_action
+{
+    RS_LOAD_SHEDDING_ACTION_SKIP_DERIVED_STREAMS , /**< Derived streams are no longer precomputed, the application computing those it reads on request */
+    RS_LOAD_SHEDDING_ACTION_SKIP_CULLED_UNPACKING, /**< Native frames are released without being unpacked while every stream they provide has a full queue */
+    RS_LOAD_SHEDDING_ACTION_DECIMATE_FRAMERATE   , /**< Every other native frame is released without being unpacked, halving the frame rate */
+    RS_LOAD_SHEDDING_ACTION_COUNT                  /**< Number of enumeration values. Not a valid input: intended to be used in for-loops. */
+}rs_load_shedding_action;
+
 /** \brief Video stream intrinsics */
 typedef struct rs_intrinsics
 {
@@ -351,6 +474,36 @@ typedef struct rs_motion_data
     float               axes[3];    /**< Three [x,y,z] axes; 16-bit data for gyroscope [rad/sec], 12-bit for accelerometer; 2's complement [m/sec^2]*/
 } rs_motion_data;
 
+/** \brief A packet of the H.264 encoding of a frame, with the metadata of the frame */
+typedef struct rs_encoded_packet
+{
+    const void *        data;           /**< NAL units in Annex B byte stream format, only valid for the duration of the callback */
+    int                 size;           /**< Bytes of data */
+    int                 keyframe;       /**< 1 if the packet is an IDR picture, which decoding can start from */
+    double              timestamp;      /**< Timestamp of the frame, as rs_get_detached_frame_timestamp() returns it */
+    unsigned long long  frame_number;   /**< Number of the frame, as rs_get_detached_frame_number() returns it */
+    long long           system_time;    /**< Time of arrival of the frame, as rs_get_detached_frame_system_time() returns it */
+} rs_encoded_packet;
+
+/** \brief Everything the rs_get_detached_frame_*() calls return of the frame of one stream of a frameset, as filled in bulk by rs_get_frameset_frame_info() */
+typedef struct rs_frame_info
+{
+    rs_stream           stream;             /**< Stream of the frame */
+    const void *        data;               /**< Frame data, valid until the frameset is released */
+    int                 width;              /**< Width of the frame in pixels */
+    int                 height;             /**< Height of the frame in pixels */
+    int                 stride;             /**< Bytes from the start of a row to the start of the next */
+    int                 bpp;                /**< Bits per pixel */
+    rs_format           format;             /**< Format of the frame */
+    int                 framerate;          /**< Framerate of the stream */
+    double              timestamp;          /**< Timestamp in milliseconds */
+    rs_timestamp_domain timestamp_domain;   /**< Clock the timestamp was taken by */
+    unsigned long long  frame_number;       /**< Number of the frame */
+    long long           system_time;        /**< Time of arrival of the frame */
+    unsigned long long  supported_metadata; /**< Bit i is set if the frame carries the metadata of rs_frame_metadata i */
+    double              metadata[RS_FRAME_METADATA_COUNT]; /**< Value of every metadata the frame carries, 0 for the others */
+} rs_frame_info;
+
 
 typedef struct rs_context rs_context;
 typedef struct rs_device rs_device;
@@ -358,14 +511,34 @@ typedef struct rs_error rs_error;
 typedef struct rs_frameset rs_frameset;
 typedef struct rs_frame_ref rs_frame_ref;
 typedef struct rs_motion_callback rs_motion_callback;
+typedef struct rs_motion_batch_callback rs_motion_batch_callback;
 typedef struct rs_frame_callback rs_frame_callback;
+typedef struct rs_frameset_callback rs_frameset_callback;
+typedef struct rs_slice_callback rs_slice_callback;
+typedef struct rs_encoded_packet_callback rs_encoded_packet_callback;
 typedef struct rs_timestamp_callback rs_timestamp_callback;
 typedef struct rs_log_callback rs_log_callback;
+typedef struct rs_options_callback rs_options_callback;
+typedef struct rs_devices_changed_callback rs_devices_changed_callback;
+typedef struct rs_frame_allocator rs_frame_allocator;
+typedef struct rs_multi_sync rs_multi_sync;
+typedef struct rs_multi_frameset_callback rs_multi_frameset_callback;
+typedef struct rs_server rs_server;
 
 typedef void (*rs_frame_callback_ptr)(rs_device * dev, rs_frame_ref * frame, void * user);
+typedef void (*rs_frameset_callback_ptr)(rs_device * dev, rs_frameset * frames, void * user);
+typedef void (*rs_slice_callback_ptr)(rs_device * dev, const void * rows, int width, int first_row, int row_count, void * user);
+typedef void (*rs_encoded_packet_callback_ptr)(rs_device * dev, rs_stream stream, rs_encoded_packet packet, void * user);
+typedef void (*rs_multi_frameset_callback_ptr)(rs_device * const * devices, rs_frameset * const * framesets, int count, void * user);
 typedef void (*rs_motion_callback_ptr)(rs_device * , rs_motion_data, void * );
 typedef void (*rs_timestamp_callback_ptr)(rs_device * , rs_timestamp_data, void * );
+typedef void (*rs_motion_batch_callback_ptr)(rs_device * dev, const rs_motion_data * motion, int motion_count, const rs_timestamp_data * timestamps, int timestamp_count, void * user);
 typedef void (*rs_log_callback_ptr)(rs_log_severity min_severity, const char * message, void * user);
+typedef void (*rs_options_callback_ptr)(rs_device * dev, const rs_option * options, unsigned int count, const double * values, rs_error * error, void * user);
+typedef void (*rs_devices_changed_callback_ptr)(rs_context * context, rs_device * device, int connected, void * user);
+typedef void (*rs_blob_progress_callback_ptr)(rs_device * dev, int bytes_sent, int size, void * user);
+typedef void * (*rs_frame_allocate_ptr)(int size, void * user);
+typedef void (*rs_frame_deallocate_ptr)(void * ptr, int size, void * user);
 
 /**
 * \brief Creates RealSense context that is required for the rest of the API.
@@ -401,6 +574,62 @@ int rs_get_device_count(const rs_context * context, rs_error ** error);
  */
 rs_device * rs_get_device(rs_context * context, int index, rs_error ** error);
 
+/**
+ * \brief Keeps the devices of the context up to date as they are attached and detached, and reports every change
+ *
+ * Once a callback is set, the context watches for devices being attached and detached. After each burst of changes it updates its devices,
+ * then invokes the callback from a thread of its own, with \c connected set to 1 for every device added and to 0 for every device removed.
+ * Indices passed to \c rs_get_device() are reassigned by every change. A device removed stays valid until the context is deleted, but can
+ * no longer exchange any data with the camera. The context is shared by the whole process, so the callback replaces any callback set before
+ * through another context object. This function must not be called from within the callback.
+ * \param context        Object representing librealsense session
+ * \param[in] on_change  Callback invoked for every device added or removed, or null to stop watching for devices
+ * \param[in] user       User data point to be passed to the callback
+ * \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \see \c rs_set_devices_changed_callback_cpp()
+ */
+void rs_set_devices_changed_callback(rs_context * context, rs_devices_changed_callback_ptr on_change, void * user, rs_error ** error);
+
+/**
+ * \brief Keeps the devices of the context up to date as they are attached and detached, and reports every change
+ *
+ * This variant of \c rs_set_devices_changed_callback() is provided specifically to enable passing lambdas with capture lists safely into the library.
+ * \param context        Object representing librealsense session
+ * \param[in] callback   Callback invoked for every device added or removed, or null to stop watching for devices
+ * \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \see \c rs_set_devices_changed_callback()
+ */
+void rs_set_devices_changed_callback_cpp(rs_context * context, rs_devices_changed_callback * callback, rs_error ** error);
+
+/**
+ * \brief Sets the pool of threads running the periodic and background work of every device
+ *
+ * The asynchronous option requests, firmware logging, temperature compensation and fisheye auto exposure of all the devices are carried out by
+ * one pool of threads, two by default. The threads of a pool are replaced once the work they are doing is done, and the work waiting for them
+ * carries over to the new pool. Threads capturing frames are not part of the pool. This function must not be called from an options callback.
+ * \param context       Object representing librealsense session
+ * \param[in] count     Number of threads, from 1 to 64
+ * \param[in] cpu_mask  CPUs the threads may run on, bit n standing for CPU n, or 0 for every CPU. Ignored by backends without control over affinity
+ * \param[out] error    If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_executor_threads(rs_context * context, int count, unsigned long long cpu_mask, rs_error ** error);
+
+/**
+ * \brief Retrieves the number of threads running the periodic and background work of every device
+ * \param context     Object representing librealsense session
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Number of threads
+ */
+int rs_get_executor_thread_count(const rs_context * context, rs_error ** error);
+
+/**
+ * \brief Retrieves the CPUs the threads running the periodic and background work of every device may run on
+ * \param context     Object representing librealsense session
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Bit n standing for CPU n, or 0 for every CPU
+ */
+unsigned long long rs_get_executor_cpu_mask(const rs_context * context, rs_error ** error);
+
 /**
  * \brief Retrieves human-readable device model string
  * \param[in] device  Relevant RealSense device
@@ -515,6 +744,9 @@ void rs_enable_stream_ex(rs_device * device, rs_stream stream, int width, int he
 
 /**
 * \brief Enables a specific stream and requests specific properties
+*
+* Points follow the depth stream, but may be enabled with a width, height and framerate of 0 to select their format: XYZ32F, or the 6 byte XYZ16F and XYZ16 encodings,
+* XYZ32F_PLANAR, or XYZUV32F, which also requires the color stream to be enabled.
 * \param[in] device         Relevant RealSense device
 * \param[in] stream         Stream
 * \param[in] width          Desired width of a frame image in pixels, or 0 if any width is acceptable
@@ -535,13 +767,41 @@ void rs_enable_stream(rs_device * device, rs_stream stream, int width, int heigh
 void rs_enable_stream_preset(rs_device * device, rs_stream stream, rs_preset preset, rs_error ** error);
 
 /**
- * \brief Disables a specific stream
+ * \brief Disables a specific stream, or returns points to XYZ32F
  * \param[in] device  Relevant RealSense device
  * \param[in] stream  Stream
  * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
  */
 void rs_disable_stream(rs_device * device, rs_stream stream, rs_error ** error);
 
+/**
+ * \brief Restricts a derived stream, such as points or an aligned stream, to a window of its image
+ *
+ * Only the pixels inside the window are computed, and frames hold just the window. The intrinsics of the stream describe the window,
+ * with the principal point moved to its origin. The window is clipped to the image, and a width or height of 0 restores the whole image.
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Derived stream
+ * \param[in] x       Left column of the window
+ * \param[in] y       Top row of the window
+ * \param[in] width   Width of the window in pixels
+ * \param[in] height  Height of the window in pixels
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_stream_roi(rs_device * device, rs_stream stream, int x, int y, int width, int height, rs_error ** error);
+
+/**
+ * \brief Aligns an aligned stream to a fraction of the resolution of the stream it is aligned to
+ *
+ * Both dimensions of the aligned image are divided by the factor, and its intrinsics are those of a pixel covering a factor x factor block
+ * of the full image. The depth image is first reduced to the median of the valid pixels of every block, so that aligning takes a factor
+ * squared less work. A window set with \c rs_set_stream_roi() is taken in the decimated image.
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Aligned stream, such as RS_STREAM_DEPTH_ALIGNED_TO_COLOR
+ * \param[in] factor  Between 1, the full resolution, and 4
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_stream_decimation(rs_device * device, rs_stream stream, int factor, rs_error ** error);
+
 /**
  * \brief Determines if a specific stream is enabled
  * \param[in] device  Relevant RealSense device
@@ -551,6 +811,389 @@ void rs_disable_stream(rs_device * device, rs_stream stream, rs_error ** error);
  */
 int rs_is_stream_enabled(const rs_device * device, rs_stream stream, rs_error ** error);
 
+/**
+ * \brief Sets how many frames of a specific stream are queued for rs_wait_for_frames() and rs_poll_for_frames(), and which frame is discarded once the queue is full
+ *
+ * A shallow queue keeps latency low, a deeper one avoids dropping frames when the application falls behind.
+ * Queued frames may hold on to driver buffers. Frames delivered through frame callbacks are not queued.
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Stream
+ * \param[in] depth   Maximum number of queued frames, between 1 and 16. The default is 4.
+ * \param[in] policy  Frame to discard once the queue is full
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_stream_queue_policy(rs_device * device, rs_stream stream, int depth, rs_frame_drop_policy policy, rs_error ** error);
+
+/**
+ * \brief Retrieves the maximum number of queued frames of a specific stream
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Stream
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Queue depth set by rs_set_stream_queue_policy()
+ */
+int rs_get_stream_queue_depth(const rs_device * device, rs_stream stream, rs_error ** error);
+
+/**
+ * \brief Retrieves which frame of a specific stream is discarded once its queue is full
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Stream
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Drop policy set by rs_set_stream_queue_policy()
+ */
+rs_frame_drop_policy rs_get_stream_drop_policy(const rs_device * device, rs_stream stream, rs_error ** error);
+
+/**
+ * \brief Provides the dma-bufs a specific stream is captured into while RS_OPTION_CAPTURE_MEMORY is 2, one capture buffer per descriptor
+ *
+ * Every dma-buf must hold at least one native frame of the stream, and must allow being mapped for reading, which the library needs for frame headers and unpacking.
+ * The library duplicates the descriptors when streaming starts, so they only need to stay open until rs_start_device() returns.
+ * Streams served by the same camera interface, such as the infrared streams of the same sensor, share the dma-bufs of the first of them which has any.
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[in] fds     Array of count dma-buf file descriptors
+ * \param[in] count   Number of descriptors, at least two, or zero to forget the ones provided before
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_stream_capture_dmabufs(rs_device * device, rs_stream stream, const int * fds, int count, rs_error ** error);
+
+/**
+ * \brief Sets how many buffers the camera driver captures a specific stream into, kernel buffers on Linux and the buffers libuvc assembles frames in
+ *
+ * Few buffers keep the latency low, while more of them ride out a busy USB controller or application threads holding on to frames.
+ * Streams served by the same camera interface share its buffers, and use the largest count set for any of them.
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[in] count   Number of buffers, from 2 to 32, or 0 to let the library choose. Windows accepts only 0.
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_stream_capture_buffer_count(rs_device * device, rs_stream stream, int count, rs_error ** error);
+
+/**
+ * \brief Retrieves how many buffers the camera driver captures a specific stream into
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Count set by rs_set_stream_capture_buffer_count(), 0 if the library chooses
+ */
+int rs_get_stream_capture_buffer_count(const rs_device * device, rs_stream stream, rs_error ** error);
+
+/**
+ * \brief Crops a specific stream to a window of its image, from the next call to rs_start_device()
+ *
+ * Cameras whose driver can crop deliver the window alone, so that the rest of the image never crosses USB. The cameras embedding timestamps
+ * and counters in their pixels are always sent whole frames, of which the window alone is unpacked. Either way, the stream is then reported
+ * with the size of the window, and intrinsics whose principal point is moved into it. The streams captured by the same camera interface, such
+ * as both infrared streams, must be given the same crop. The window must lie within the pixels the camera delivers, rather than padding, and
+ * start on and span an even number of columns.
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[in] x       First column of the window, in pixels of the uncropped stream
+ * \param[in] y       First row of the window
+ * \param[in] width   Width of the window, or 0 to stream the whole image
+ * \param[in] height  Height of the window
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_stream_crop(rs_device * device, rs_stream stream, int x, int y, int width, int height, rs_error ** error);
+
+/**
+ * \brief Determines whether the driver crops a specific stream, rather than sending whole frames which are cropped as they are unpacked
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            1 if the stream is streaming and cropped by the driver, 0 otherwise
+ */
+int rs_is_stream_cropped_in_driver(const rs_device * device, rs_stream stream, rs_error ** error);
+
+/**
+ * \brief Unpacks the frames of a specific stream into fixed-size buffers of the application, such as pinned memory a GPU copies from
+ *
+ * Each frame of the stream takes one of the buffers until it is released, and rs_get_detached_frame_buffer_index() tells which, so that the
+ * application can hand the buffer to a device without copying the frame first. Frames larger than buffer_size, or arriving while the
+ * application holds every buffer, are unpacked into memory of the library instead. Frames are never handed out in driver memory, as they
+ * may otherwise be when the stream needs no processing. The buffers must stay valid until the device is stopped and every frame of the
+ * stream was released.
+ * \param[in] device       Relevant RealSense device
+ * \param[in] stream       Native stream
+ * \param[in] buffers      The buffers, each aligned to 64 bytes
+ * \param[in] count        Number of buffers, up to RS_MAX_FRAME_BUFFERS, or 0 to unpack into memory of the library, which is the default
+ * \param[in] buffer_size  Size in bytes of every buffer
+ * \param[out] error       If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_stream_frame_buffers(rs_device * device, rs_stream stream, void * const buffers[], int count, int buffer_size, rs_error ** error);
+
+/**
+ * \brief Moves the frame callback of a specific stream off the thread capturing its frames
+ *
+ * By default, frame callbacks are invoked on the thread capturing the frames, so a slow callback delays the frames of every stream captured
+ * by that thread, until the camera driver runs out of buffers and drops frames. Given a queue, the callback is invoked on a thread of its own,
+ * where frames wait in the queue meanwhile. Once the queue is full, its oldest frame is discarded to make room for the frame that just arrived.
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[in] depth   Maximum number of queued frames, between 1 and 16, or 0 to invoke the callback on the capturing thread, which is the default
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_stream_callback_queue(rs_device * device, rs_stream stream, int depth, rs_error ** error);
+
+/**
+ * \brief Retrieves the maximum number of frames queued for the frame callback of a specific stream
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Depth set by rs_set_stream_callback_queue(), 0 if the callback is invoked on the capturing thread
+ */
+int rs_get_stream_callback_queue_depth(const rs_device * device, rs_stream stream, rs_error ** error);
+
+/**
+ * \brief Retrieves how many frames of a specific stream were discarded from the queue of its frame callback
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Frames discarded since the device was last started
+ */
+unsigned long long rs_get_stream_callback_drops(const rs_device * device, rs_stream stream, rs_error ** error);
+
+/**
+ * \brief Adds a subscriber to the frames of a specific stream, alongside its frame callback and any other subscriber
+ *
+ * Every subscriber is handed a reference of its own to the same frame, which it releases with rs_release_frame(), so that no frame is ever
+ * copied however many components of the process consume the stream. Given a queue, the subscriber is invoked on a thread of its own, and
+ * drops frames from its queue by its own policy, so that a slow subscriber delays neither the capture nor any other subscriber. Like a
+ * frame callback, a subscriber takes the frames of the stream away from rs_wait_for_frames() and rs_poll_for_frames().
+ * \param[in] device    Relevant RealSense device
+ * \param[in] stream    Native stream
+ * \param[in] on_frame  Callback that will receive the frames
+ * \param[in] user      User data point to be passed to the callback
+ * \param[in] depth     Maximum number of frames queued for the subscriber, between 1 and 16, or 0 to invoke it on the capturing thread
+ * \param[in] policy    Frame discarded once its queue is full
+ * \param[out] error    If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return              Identifier of the subscriber, to remove it or query its drops
+ * \see \c rs_add_frame_subscriber_cpp()
+ */
+int rs_add_frame_subscriber(rs_device * device, rs_stream stream, rs_frame_callback_ptr on_frame, void * user, int depth, rs_frame_drop_policy policy, rs_error ** error);
+
+/**
+ * \brief Adds a subscriber to the frames of a specific stream, alongside its frame callback and any other subscriber
+ *
+ * This variant of \c rs_add_frame_subscriber() is provided specifically to enable passing lambdas with capture lists safely into the library.
+ * \param[in] device    Relevant RealSense device
+ * \param[in] stream    Native stream
+ * \param[in] callback  Callback that will receive the frames
+ * \param[in] depth     Maximum number of frames queued for the subscriber, between 1 and 16, or 0 to invoke it on the capturing thread
+ * \param[in] policy    Frame discarded once its queue is full
+ * \param[out] error    If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return              Identifier of the subscriber, to remove it or query its drops
+ * \see \c rs_add_frame_subscriber()
+ */
+int rs_add_frame_subscriber_cpp(rs_device * device, rs_stream stream, rs_frame_callback * callback, int depth, rs_frame_drop_policy policy, rs_error ** error);
+
+/**
+ * \brief Removes a subscriber added by rs_add_frame_subscriber() from the frames of a specific stream, while the device is stopped
+ * \param[in] device      Relevant RealSense device
+ * \param[in] stream      Native stream
+ * \param[in] subscriber  Identifier returned when the subscriber was added
+ * \param[out] error      If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_remove_frame_subscriber(rs_device * device, rs_stream stream, int subscriber, rs_error ** error);
+
+/**
+ * \brief Retrieves how many frames were discarded from the queue of a subscriber to a specific stream
+ * \param[in] device      Relevant RealSense device
+ * \param[in] stream      Native stream
+ * \param[in] subscriber  Identifier returned when the subscriber was added
+ * \param[out] error      If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return                Frames discarded since the device was last started, 0 for a subscriber without a queue
+ */
+unsigned long long rs_get_frame_subscriber_drops(const rs_device * device, rs_stream stream, int subscriber, rs_error ** error);
+
+/**
+ * \brief Starts a specific stream on demand, turning it off once it was not consumed for some time
+ *
+ * Streams enabled on a device run from rs_start_device() on, whether or not their frames are read, each costing USB bandwidth and unpacking.
+ * Given an idle timeout, a stream only runs while it is consumed: it stays off after rs_start_device() until its frames are first read, and
+ * is turned off again once they were not read for the timeout. A stream is consumed whenever the data of its current frame or of a stream
+ * derived from it is read, a frame of it is detached from a frameset, taken from its mailbox or processed into a derived frame. Reading it
+ * while it is off turns it on, frames arriving after the time the camera takes to restart, meanwhile its last frame stays current.
+ * Streams given a frame callback, or any stream once a frameset callback is set, are always on, as are the streams captured along with the
+ * stream framesets are formed on. Streams the camera captures together are only turned off once none of them is consumed.
+ * \param[in] device        Relevant RealSense device
+ * \param[in] stream        Native stream
+ * \param[in] milliseconds  Time the stream stays on without being consumed, up to an hour, or 0 to run it for as long as the device streams, which is the default
+ * \param[out] error        If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_stream_idle_timeout(rs_device * device, rs_stream stream, int milliseconds, rs_error ** error);
+
+/**
+ * \brief Retrieves the idle timeout of a specific stream
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Timeout set by rs_set_stream_idle_timeout(), 0 if the stream runs for as long as the device streams
+ */
+int rs_get_stream_idle_timeout(const rs_device * device, rs_stream stream, rs_error ** error);
+
+/**
+ * \brief Bounds the skew between a specific stream and the stream framesets are formed on
+ *
+ * By default every frameset takes the frame of each stream nearest to the frame of the stream it is formed on, however far apart they are,
+ * which pairs a 60 fps stream with a 30 fps one at up to a frame period of skew whenever frames are dropped or arrive late. Given a tolerance,
+ * a frameset only takes the frame of the stream closest to that frame within the tolerance: it waits until the stream provides a frame at or
+ * after it, or it can wait no longer without dropping frames, and otherwise leaves the stream out, its frame data then being NULL. Frames of
+ * the stream which can no longer be matched are discarded as they age out of the tolerance. Has no effect on the stream framesets are formed on.
+ * \param[in] device        Relevant RealSense device
+ * \param[in] stream        Native stream
+ * \param[in] milliseconds  Largest difference of timestamps matched, up to a second, or 0 to match the nearest frame, which is the default
+ * \param[out] error        If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_stream_sync_tolerance(rs_device * device, rs_stream stream, double milliseconds, rs_error ** error);
+
+/**
+ * \brief Retrieves the sync tolerance of a specific stream
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Tolerance set by rs_set_stream_sync_tolerance() in milliseconds, 0 if the nearest frame is matched
+ */
+double rs_get_stream_sync_tolerance(const rs_device * device, rs_stream stream, rs_error ** error);
+
+/**
+ * \brief Determines if a stream started on demand is currently turned off for lack of demand
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            1 if the stream is off until it is consumed again, 0 otherwise
+ */
+int rs_is_stream_idle(const rs_device * device, rs_stream stream, rs_error ** error);
+
+/**
+ * \brief Retrieves the histogram of the time the frames of a stream took from the driver to a stage of their processing
+ *
+ * Every frame delivered adds the time from RS_FRAME_METADATA_TIME_OF_DEQUEUE to each later stage it went through, so that comparing the
+ * histograms of successive stages tells where frames spend their time. Bin 0 counts the frames which reached the stage within a microsecond,
+ * bin i those which took from 2^(i-1) to 2^i microseconds, and the last bin those which took longer.
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[in] stage   Time of the stage, from RS_FRAME_METADATA_TIME_OF_VALIDATION to RS_FRAME_METADATA_TIME_OF_DELIVERY
+ * \param[out] counts Receives RS_LATENCY_HISTOGRAM_BIN_COUNT counts, of the frames delivered since the device was created or the histograms were last reset
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_get_stream_latency_histogram(const rs_device * device, rs_stream stream, rs_frame_metadata stage, unsigned long long counts[], rs_error ** error);
+
+/**
+ * \brief Retrieves the histogram of the time the frames of a stream took from their exposure to the application
+ *
+ * Every frame delivered with RS_FRAME_METADATA_TIME_OF_EXPOSURE adds the time from it to RS_FRAME_METADATA_TIME_OF_DELIVERY. As the clock of the
+ * device is mapped to that of the host from the times frames arrive, the durations leave out the quickest transfer from the device of recent frames,
+ * and compare the frames with each other rather than with absolute time. The bins are those of rs_get_stream_latency_histogram().
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[out] counts Receives RS_LATENCY_HISTOGRAM_BIN_COUNT counts, of the frames delivered since the device was created or the histograms were last reset
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_get_stream_exposure_latency_histogram(const rs_device * device, rs_stream stream, unsigned long long counts[], rs_error ** error);
+
+/**
+ * \brief Clears the latency histograms of every stream
+ * \param[in] device  Relevant RealSense device
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_reset_latency_histograms(rs_device * device, rs_error ** error);
+
+/**
+ * \brief Retrieves a counter of what happened to the frames of a stream since the device was created
+ *
+ * Counters are kept by the threads handling frames without any lock, and reading them never blocks those threads, so that they can be
+ * polled at any rate while streaming.
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream
+ * \param[in] metric  Counter to retrieve
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Value of the counter
+ */
+unsigned long long rs_get_stream_metric(const rs_device * device, rs_stream stream, rs_stream_metric metric, rs_error ** error);
+
+/**
+ * \brief Retrieves a counter of the transfers of the USB interface a stream is captured from, since the device last started streaming
+ *
+ * Streams captured from one interface report the same counters. A link degrading shows in bytes per second falling short of the bandwidth
+ * of the modes, and in errors and short frames, before frames are dropped. Counters are kept by the capture threads without any lock.
+ * Devices of the playback backend count what they read from their recording or ring.
+ * \param[in] device     Relevant RealSense device
+ * \param[in] stream     Native stream
+ * \param[in] statistic  Counter to retrieve
+ * \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return               Value of the counter
+ */
+unsigned long long rs_get_transfer_statistic(const rs_device * device, rs_stream stream, rs_transfer_statistic statistic, rs_error ** error);
+
+/**
+ * \brief Sets the actions a device takes, one more at a time, while its application falls behind
+ *
+ * While streaming, the device looks every 100 milliseconds for an overload: a stream whose queue is full, the frames waiting in the sync
+ * archive or in its callback queue having reached their depth, or a frame callback busy for more than 90% of the time. Every check finding
+ * one takes the next action of the list on top of those already taken, and every second without any overload drops the last action taken.
+ * Each frame an action sheds is counted by one of the RS_STREAM_METRIC_DERIVED_FRAMES_SHED, RS_STREAM_METRIC_UNPACKS_SHED and
+ * RS_STREAM_METRIC_FRAMES_DECIMATED metrics. Frames are recorded, published and kept in the frame history before any is shed.
+ * \param[in] device   Relevant RealSense device
+ * \param[in] actions  Actions in the order they are taken, each listed once at most
+ * \param[in] count    Number of actions, 0 to never shed load, which is the default
+ * \param[out] error   If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_load_shedding(rs_device * device, const rs_load_shedding_action actions[], int count, rs_error ** error);
+
+/**
+ * \brief Retrieves how many of the actions set by rs_set_load_shedding() a device is currently taking
+ * \param[in] device  Relevant RealSense device
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Number of actions taken, the first ones of the list, 0 while the application keeps up
+ */
+int rs_get_load_shedding_level(const rs_device * device, rs_error ** error);
+
+/**
+ * \brief Retrieves how many bytes of frame memory a device holds, and the most it has held since it was created
+ *
+ * Every block of frame memory the device allocates is counted until it is freed: the buffers of its frame pools, the frames being unpacked,
+ * queued for synchronization, presented and held by the application, those of derived streams and the capture buffers allocated when
+ * RS_OPTION_CAPTURE_MEMORY captures into the frame allocator. The images the derived streams keep for rs_get_frame_data() are added as they
+ * are when called. Buffers the application provided through rs_set_stream_frame_buffers() are its own and not counted.
+ * \param[in] device   Relevant RealSense device
+ * \param[out] current Bytes held now
+ * \param[out] peak    Most bytes held at once
+ * \param[out] error   If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_get_memory_usage(const rs_device * device, unsigned long long * current, unsigned long long * peak, rs_error ** error);
+
+/**
+ * \brief Caps the frame memory a device holds, also while streaming
+ *
+ * While the memory counted by rs_get_memory_usage() is above the budget, the frame pools free the buffers released instead of keeping them,
+ * and no stream keeps more than 2 frames queued for synchronization, nor has more than 2 frames published at once, the frames beyond being
+ * dropped as the queue policy of the stream and RS_STREAM_METRIC_FRAMES_UNPUBLISHED have it. A budget below what the streams need at least
+ * cannot be met, and keeps the device at those bounds.
+ * \param[in] device  Relevant RealSense device
+ * \param[in] bytes   Budget, 0 for none, which is the default
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_memory_budget(rs_device * device, unsigned long long bytes, rs_error ** error);
+
+/**
+ * \brief Retrieves the frame memory budget of a device set by rs_set_memory_budget()
+ * \param[in] device  Relevant RealSense device
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Budget in bytes, 0 for none
+ */
+unsigned long long rs_get_memory_budget(const rs_device * device, rs_error ** error);
+
+/**
+ * \brief Writes the firmware log data read from a device while RS_OPTION_HARDWARE_LOGGER_ENABLED was set to a file
+ *
+ * The device keeps the latest 256 KiB of log data, read in the background and less often while the log stays empty. The file holds one
+ * record for every read which returned data, oldest first: a little-endian 32 bit count of bytes followed by as many bytes of the log.
+ * \param[in] device     Relevant RealSense device
+ * \param[in] file_path  The file to write, replaced if it exists
+ * \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_export_fw_log(const rs_device * device, const char * file_path, rs_error ** error);
+
 /**
  * \brief Retrieves the width in pixels of a specific stream, equivalent to the width field from the stream's intrinsic
  * \param[in] device  Relevant RealSense device
@@ -596,6 +1239,15 @@ int rs_get_stream_framerate(const rs_device * device, rs_stream stream, rs_error
  */
 void rs_get_stream_intrinsics(const rs_device * device, rs_stream stream, rs_intrinsics * intrin, rs_error ** error);
 
+/**
+ * \brief Retrieves intrinsic camera parameters for a level of the depth pyramid, see RS_OPTION_DEPTH_PYRAMID_LEVELS
+ * \param[in] device   Relevant RealSense device
+ * \param[in] level    Level of the pyramid, 0 being the depth stream itself and every level halving the one before
+ * \param[out] intrin  Intrinsic parameters of the level
+ * \param[out] error   If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_get_depth_pyramid_intrinsics(const rs_device * device, int level, rs_intrinsics * intrin, rs_error ** error);
+
 /**
 * \brief Retrieves intrinsic camera parameters for a motion module
 * \param[in]  device     Relevant RealSense device
@@ -606,6 +1258,10 @@ void rs_get_motion_intrinsics(const rs_device * device, rs_motion_intrinsics * i
 
 /**
 * \brief Sets up a frame callback that is called immediately when an image is available, with no synchronization logic applied
+*
+* When every enabled stream has a frame callback, and neither a frameset callback nor motion tracking is set, the device keeps no
+* synchronization state at all: rs_wait_for_frames() and rs_poll_for_frames() then return at once, and the frame data of the streams is
+* only found in the frames handed to the callbacks.
 * \param[in] device    Relevant RealSense device
 * \param[in] stream    Stream
 * \param[in] on_frame  Callback that will receive the frame data and timestamp
@@ -656,6 +1312,31 @@ void rs_enable_motion_tracking_cpp(rs_device * device,
     rs_timestamp_callback * timestamp_callback,
     rs_error ** error);
 
+/**
+* \brief Enables motion-tracking, delivering the events of every USB transfer from the motion module in a single call
+*
+* Per-event handlers are called once per gyro and accelerometer sample, up to a few thousand times per second. The batch handler is called once per
+* transfer instead, with the motion and timestamp events it carried as contiguous arrays, which are only valid for the duration of the call.
+* Either count may be zero. Replaces the handlers given to \c rs_enable_motion_tracking(), and is replaced by them.
+* \param[in] device             Relevant RealSense device
+* \param[in] on_events          User-defined routine to be invoked with the events of every transfer
+* \param[in] user               User data point to be passed to the callback
+* \param[out] error             If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \see  \c rs_enable_motion_tracking_batched_cpp()
+*/
+void rs_enable_motion_tracking_batched(rs_device * device, rs_motion_batch_callback_ptr on_events, void * user, rs_error ** error);
+
+/**
+* \brief Enables motion-tracking, delivering the events of every USB transfer from the motion module in a single call
+*
+* This variant of \c rs_enable_motion_tracking_batched() is provided specifically to enable passing lambdas with capture lists safely into the library.
+* \param[in] device             Relevant RealSense device
+* \param[in] callback           Callback that will receive the events of every transfer
+* \param[out] error             If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \see  \c rs_enable_motion_tracking_batched()
+*/
+void rs_enable_motion_tracking_batched_cpp(rs_device * device, rs_motion_batch_callback * callback, rs_error ** error);
+
 /**
  * \brief Sets up a frame callback that is called immediately when an image is available, with no synchronization logic applied
  
@@ -668,6 +1349,238 @@ void rs_enable_motion_tracking_cpp(rs_device * device,
  */
 void rs_set_frame_callback_cpp(rs_device * device, rs_stream stream, rs_frame_callback * callback, rs_error ** error);
 
+/**
+ * \brief Hands the rows of every frame of a Z16 stream to a callback as the camera sends them, ahead of the frame itself
+ *
+ * The rows of the native image, as the camera sends it, are handed out every \c rows_per_slice rows, from top to bottom, with the rows left
+ * over making a shorter last slice. Where the backend assembles frames itself, as libuvc does, every slice is handed out as soon as its last
+ * row arrives, from the buffer the frame is assembled in, so that the top of the image can be acted upon before the bottom has been sent.
+ * Other backends only receive whole frames, which are then sliced as they arrive. Slices are handed out on a thread of the library which
+ * receives the transfers of the device, before the frame is validated, so the callback must return quickly, and the rows it is given are
+ * only valid for the duration of the call. Only streams the camera sends as 16-bit depth (RS_FORMAT_Z16) can be sliced, which
+ * rs_start_device() checks. Must be called before rs_start_device().
+ * \param[in] device          Relevant RealSense device
+ * \param[in] stream          Native stream
+ * \param[in] rows_per_slice  Rows of each slice, at least 1
+ * \param[in] on_slice        Callback receiving the 16-bit depth values of \c row_count rows of \c width pixels from row \c first_row, or NULL to stop slicing the stream
+ * \param[in] user            User data point to be passed to the callback
+ * \param[out] error          If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \see \c rs_set_stream_slice_callback_cpp()
+ */
+void rs_set_stream_slice_callback(rs_device * device, rs_stream stream, int rows_per_slice, rs_slice_callback_ptr on_slice, void * user, rs_error ** error);
+
+/**
+ * \brief Hands the rows of every frame of a Z16 stream to a callback as the camera sends them, ahead of the frame itself
+ *
+ * This variant of \c rs_set_stream_slice_callback() is provided specifically to enable passing lambdas with capture lists safely into the library.
+ * \param[in] device          Relevant RealSense device
+ * \param[in] stream          Native stream
+ * \param[in] rows_per_slice  Rows of each slice, at least 1
+ * \param[in] callback        Callback receiving the slices, or NULL to stop slicing the stream
+ * \param[out] error          If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \see \c rs_set_stream_slice_callback()
+ */
+void rs_set_stream_slice_callback_cpp(rs_device * device, rs_stream stream, int rows_per_slice, rs_slice_callback * callback, rs_error ** error);
+
+/**
+ * \brief Encodes every frame of a stream into H.264 on a hardware video encoder, and hands the packets to a callback
+ *
+ * Each frame is encoded straight from the buffer it was unpacked into, so the stream must be enabled in RS_FORMAT_NV12 or RS_FORMAT_I420,
+ * which rs_start_device() checks. The encoder is the first one of VA-API, NVENC, Quick Sync, Media Foundation and V4L2 memory-to-memory
+ * devices which rs_start_device() manages to open for the mode of the stream, at a constant \c bitrate, without B-frames and with a keyframe
+ * every second. Frames are encoded in order on the thread which unpacks them, ahead of their delivery, and their packets are handed out as
+ * the encoder produces them, along with the timestamp, number and time of arrival of the frame they encode. Requires a library built with
+ * BUILD_WITH_FFMPEG. Must be called before rs_start_device().
+ * \param[in] device     Relevant RealSense device
+ * \param[in] stream     Native stream
+ * \param[in] bitrate    Bits per second of the encoding
+ * \param[in] on_packet  Callback receiving the packets, or NULL to stop encoding the stream
+ * \param[in] user       User data point to be passed to the callback
+ * \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \see \c rs_set_stream_encoder_cpp()
+ */
+void rs_set_stream_encoder(rs_device * device, rs_stream stream, int bitrate, rs_encoded_packet_callback_ptr on_packet, void * user, rs_error ** error);
+
+/**
+ * \brief Encodes every frame of a stream into H.264 on a hardware video encoder, and hands the packets to a callback
+ *
+ * This variant of \c rs_set_stream_encoder() is provided specifically to enable passing lambdas with capture lists safely into the library.
+ * \param[in] device     Relevant RealSense device
+ * \param[in] stream     Native stream
+ * \param[in] bitrate    Bits per second of the encoding
+ * \param[in] callback   Callback receiving the packets, or NULL to stop encoding the stream
+ * \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \see \c rs_set_stream_encoder()
+ */
+void rs_set_stream_encoder_cpp(rs_device * device, rs_stream stream, int bitrate, rs_encoded_packet_callback * callback, rs_error ** error);
+
+/**
+ * \brief Sets up a callback that is called as soon as a synchronized set of frames is available, with the same matching as \c rs_wait_for_frames()
+ *
+ * A frameset is formed once a key stream frame has arrived together with a candidate frame of every other stream, or once the key stream queue is full.
+ * The callback owns the frameset: frames are shared with the library, not copied, and the frameset must be released with \c rs_release_frames().
+ * Streams with their own frame callback do not take part in synchronization. Must be called before \c rs_start_device().
+ * \param[in] device       Relevant RealSense device
+ * \param[in] on_frameset  User-defined routine to be invoked with every synchronized frameset, or null to go back to \c rs_wait_for_frames() / \c rs_poll_for_frames()
+ * \param[in] user         User data point to be passed to the callback
+ * \param[out] error       If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \see \c rs_set_frameset_callback_cpp()
+ */
+void rs_set_frameset_callback(rs_device * device, rs_frameset_callback_ptr on_frameset, void * user, rs_error ** error);
+
+/**
+ * \brief Sets up a callback that is called as soon as a synchronized set of frames is available
+ *
+ * This variant of \c rs_set_frameset_callback() is provided specifically to enable passing lambdas with capture lists safely into the library.
+ * \param[in] device    Relevant RealSense device
+ * \param[in] callback  Callback that will receive the framesets
+ * \param[out] error    If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \see \c rs_set_frameset_callback()
+ */
+void rs_set_frameset_callback_cpp(rs_device * device, rs_frameset_callback * callback, rs_error ** error);
+
+/**
+ * \brief Creates a synchronizer matching the framesets of several devices by timestamp, and calling back with every matched set
+ *
+ * Each device clock is mapped onto the host clock through the smallest gap between the arrival of its framesets and their timestamp,
+ * so devices are matched whatever their clocks. A set is complete once every device has a frameset within \c tolerance of the others.
+ * A frameset which can no longer be matched on every device, because another device moved past it or because a few newer framesets of its
+ * own are already waiting, is a straggler, handled according to \c policy. The synchronizer sets the frameset callback of every device,
+ * which must all be configured but not started yet. The callback owns the framesets, which must each be released with \c rs_release_frames()
+ * on their device, and is invoked on the library threads delivering frames, one set at a time.
+ * \param[in] devices       Devices to synchronize
+ * \param[in] count         Number of devices
+ * \param[in] tolerance     Largest difference between the timestamps of a matched set, between 0 and 1000 milliseconds, preferably below half a frame period
+ * \param[in] policy        What becomes of incomplete sets
+ * \param[in] on_framesets  User-defined routine to be invoked with every set: \c count framesets in the order of \c devices, null for the devices missing from a partial set
+ * \param[in] user          User data point to be passed to the callback
+ * \param[out] error        If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return                  Synchronizer, to be deleted with \c rs_delete_multi_sync() before the devices are started again or released
+ * \see \c rs_create_multi_sync_cpp()
+ */
+rs_multi_sync * rs_create_multi_sync(rs_device * const * devices, int count, double tolerance, rs_straggler_policy policy, rs_multi_frameset_callback_ptr on_framesets, void * user, rs_error ** error);
+
+/**
+ * \brief Creates a synchronizer matching the framesets of several devices by timestamp
+ *
+ * This variant of \c rs_create_multi_sync() is provided specifically to enable passing lambdas with capture lists safely into the library.
+ * \param[in] devices    Devices to synchronize
+ * \param[in] count      Number of devices
+ * \param[in] tolerance  Largest difference between the timestamps of a matched set, in milliseconds
+ * \param[in] policy     What becomes of incomplete sets
+ * \param[in] callback   Callback that will receive the sets
+ * \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return               Synchronizer
+ * \see \c rs_create_multi_sync()
+ */
+rs_multi_sync * rs_create_multi_sync_cpp(rs_device * const * devices, int count, double tolerance, rs_straggler_policy policy, rs_multi_frameset_callback * callback, rs_error ** error);
+
+/**
+ * \brief Releases a synchronizer along with the framesets it still holds
+ *
+ * The devices then release every frameset they form, until their frameset callback is set again.
+ * \param[in] sync    Synchronizer that is no longer needed
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_delete_multi_sync(rs_multi_sync * sync, rs_error ** error);
+
+/**
+ * \brief Estimates the USB bandwidth the streams of a device would take once started, from the modes \c rs_start_device() would select
+ * \param[in] device  Relevant RealSense device
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Bandwidth of the frames, in megabytes (10^6 bytes) per second, leaving the transfer overhead aside
+ */
+double rs_get_device_bandwidth(const rs_device * device, rs_error ** error);
+
+/**
+ * \brief Fits the streams of several devices within the bandwidth of the USB host controllers they share
+ *
+ * Devices on the same USB bus, as per \c rs_get_device_usb_port_id(), are taken to share one host controller. While the streams of the devices of
+ * a controller take more than \c controller_bandwidth, the device taking the most moves on to its next lower combination of resolutions, formats and
+ * framerates, among those left open by its \c rs_enable_stream() requests. The streams of the devices which had to move are enabled in full, the
+ * others keep their requests. Nothing is enabled if the devices of a controller cannot fit even at their lowest, the error then naming them.
+ * \param[in] devices               Devices to plan, which must all be configured but not started yet
+ * \param[in] count                 Number of devices
+ * \param[in] controller_bandwidth  Bandwidth available to the streams of each host controller, in megabytes (10^6 bytes) per second
+ * \param[out] error                If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_plan_device_modes(rs_device * const * devices, int count, double controller_bandwidth, rs_error ** error);
+
+/**
+ * \brief Deprojects depth frames of several devices into one point cloud in the frame of reference of the rig holding them
+ *
+ * Every pixel with depth is deprojected through the depth intrinsics of its device and moved into the rig frame in the same pass, so that the
+ * clouds of the devices are never written out on their own. The points are written as a list of XYZ32F points, the devices one after the other.
+ * With a \c voxel_size above zero, all points falling into the same cube of the rig frame are merged into their mean instead, which also merges
+ * the overlap of the views of the devices.
+ * \param[in] devices          Devices the frames come from, whose depth streams are enabled in the mode of the frames
+ * \param[in] depth_frames     Detached frames of the depth stream of every device, in format Z16
+ * \param[in] device_to_rig    Pose of every device in the rig frame, taking points of its depth stream into the rig frame
+ * \param[in] count            Number of devices
+ * \param[in] voxel_size       Width in meters of the cubes points are merged in, or 0 to keep every point
+ * \param[out] points          Points of the fused cloud, three floats each
+ * \param[in] capacity         Number of points \c points has room for, which must be at least the number of pixels of all the frames
+ * \param[out] error           If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return                     Number of points written
+ */
+int rs_fuse_point_clouds(rs_device * const * devices, rs_frame_ref * const * depth_frames, const rs_extrinsics * device_to_rig, int count, float voxel_size, float * points, int capacity, rs_error ** error);
+
+/**
+ * \brief Projects points in 3D space to the pixels of an image, as rs_project_point_to_pixel(...) of rsutil.h does for every point, with vector instructions where the CPU has them
+ * \param[out] pixels          Pixel coordinates of every point, two floats each
+ * \param[in] intrin           Intrinsics of the image, with no distortion or RS_DISTORTION_MODIFIED_BROWN_CONRADY
+ * \param[in] points           Points relative to the camera of the image, three floats each
+ * \param[in] count            Number of points
+ * \param[out] error           If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_project_points_to_pixels(float * pixels, const rs_intrinsics * intrin, const float * points, int count, rs_error ** error);
+
+/**
+ * \brief Deprojects pixels of an image to points in 3D space, as rs_deproject_pixel_to_point(...) of rsutil.h does for every pixel, with vector instructions where the CPU has them
+ * \param[out] points          Points relative to the camera of the image, three floats each
+ * \param[in] intrin           Intrinsics of the image, with no distortion or RS_DISTORTION_INVERSE_BROWN_CONRADY
+ * \param[in] pixels           Pixel coordinates, two floats each
+ * \param[in] depths           Depth of every pixel, in the unit the points are wanted in
+ * \param[in] count            Number of pixels
+ * \param[out] error           If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_deproject_pixels_to_points(float * points, const rs_intrinsics * intrin, const float * pixels, const float * depths, int count, rs_error ** error);
+
+/**
+ * \brief Transforms points from one frame of reference to another, as rs_transform_point_to_point(...) of rsutil.h does for every point, with vector instructions where the CPU has them
+ * \param[out] to_points       Points in the frame of reference extrin leads to, three floats each, which may be the array of from_points
+ * \param[in] extrin           Extrinsics from the frame of reference of the points to the other
+ * \param[in] from_points      Points, three floats each
+ * \param[in] count            Number of points
+ * \param[out] error           If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_transform_points_to_points(float * to_points, const rs_extrinsics * extrin, const float * from_points, int count, rs_error ** error);
+
+/**
+* \brief Provides the memory used for frame buffers, for example pinned, huge-page or GPU-mapped memory
+*
+* Buffers are obtained when streaming starts and are recycled between frames, so \c allocate is not called for every frame.
+* Buffers may be released from any library thread, but never after \c rs_stop_device() returns.
+* \param[in] device      Relevant RealSense device
+* \param[in] allocate    Routine returning a block of at least the requested size, or null on failure
+* \param[in] deallocate  Routine receiving back a block previously obtained from \c allocate, together with its size
+* \param[in] user        User data point to be passed to both routines
+* \param[out] error      If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \see \c rs_set_frame_allocator_cpp()
+*/
+void rs_set_frame_allocator(rs_device * device, rs_frame_allocate_ptr allocate, rs_frame_deallocate_ptr deallocate, void * user, rs_error ** error);
+
+/**
+* \brief Provides the memory used for frame buffers
+*
+* This variant of \c rs_set_frame_allocator() is provided specifically to enable passing lambdas with capture lists safely into the library.
+* \param[in] device      Relevant RealSense device
+* \param[in] allocator   Allocator object, released by the library once it is no longer needed
+* \param[out] error      If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \see \c rs_set_frame_allocator()
+*/
+void rs_set_frame_allocator_cpp(rs_device * device, rs_frame_allocator * allocator, rs_error ** error);
+
 /**
 * \brief Disables motion-tracking handlers
 * \param[in] device    Relevant RealSense device
@@ -683,6 +1596,171 @@ void rs_disable_motion_tracking(rs_device * device, rs_error ** error);
 */
 int rs_is_motion_tracking_active(rs_device * device, rs_error ** error);
 
+/**
+* \brief Retrieves the motion sample of a sensor at a given timestamp, linearly interpolated between the samples received around it
+*
+* While motion tracking is active, the latest samples of the accelerometer and of the gyroscope are kept by the library, a few seconds of each,
+* so that they can be looked up at the timestamps of frames in the microcontroller timestamp domain. The history restarts with motion tracking.
+* \param[in] device     Relevant RealSense device
+* \param[in] source     RS_EVENT_IMU_ACCEL or RS_EVENT_IMU_GYRO
+* \param[in] timestamp  Timestamp in milliseconds, in the microcontroller timestamp domain
+* \param[out] sample    Receives the interpolated sample, stamped with timestamp
+* \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return               1 if sample was filled, 0 if timestamp is older than the history or newer than its latest sample
+*/
+int rs_get_motion_sample_at(const rs_device * device, rs_event_source source, double timestamp, rs_motion_data * sample, rs_error ** error);
+
+/**
+* \brief Retrieves the motion samples of a sensor received within a time interval, oldest first
+* \param[in] device     Relevant RealSense device
+* \param[in] source     RS_EVENT_IMU_ACCEL or RS_EVENT_IMU_GYRO
+* \param[in] from       Start of the interval in milliseconds, in the microcontroller timestamp domain
+* \param[in] to         End of the interval, included as is from
+* \param[out] samples   Receives up to max_count samples, may be null if max_count is 0
+* \param[in] max_count  Number of samples that fit in samples
+* \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return               Number of samples the history holds in the interval, which may exceed max_count
+*/
+int rs_get_motion_samples(const rs_device * device, rs_event_source source, double from, double to, rs_motion_data * samples, int max_count, rs_error ** error);
+
+/**
+* \brief Starts recording the native frames of the device, before unpacking, along with their timestamps and the motion data, to a file
+*
+* Frames are copied into a bounded pool of memory and written from a thread of their own, so recording never holds up capture. When the disk falls
+* behind for long enough to fill the pool, frames are left out of the recording, which rs_get_recording_drops() reports. Recording may start before
+* or during streaming, and goes on across stops and starts of the device until rs_stop_recording() is called. Z16 depth frames are compressed on
+* the way, losslessly, as rs_encode_depth() does.
+* \param[in] device  Relevant RealSense device
+* \param[in] path    File to create, replacing any file of that name
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_start_recording(rs_device * device, const char * path, rs_error ** error);
+
+/**
+* \brief Stops recording, once the frames recorded so far are written to the file
+* \param[in] device  Relevant RealSense device
+* \param[out] error  If non-null, receives any error that occurs during this call, for instance when writing the file failed
+*/
+void rs_stop_recording(rs_device * device, rs_error ** error);
+
+/**
+* \brief Retrieves how many frames and motion data transfers were left out of the current recording, for lack of free memory to hold them
+* \param[in] device  Relevant RealSense device
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return            Number of frames and transfers dropped since recording started, 0 if the device is not recording
+*/
+unsigned long long rs_get_recording_drops(const rs_device * device, rs_error ** error);
+
+/**
+* \brief Starts publishing the native frames of the device and its motion data to other processes, through a ring in shared memory
+*
+* Every frame is copied once into a slot of the ring, whatever the number of subscribers, which read it in place. Subscribers are devices of
+* libraries built with the playback backend, listing the rings named by the RS_PLAYBACK_RINGS environment variable, which offer the streams
+* of the latest start of the publishing device and unpack the frames themselves. A slot is left alone as long as a subscriber holds a frame
+* of it, so that frames are dropped from the ring only once every slot is held. Publishing may start before or during streaming, and goes on
+* across stops and starts of the device until rs_stop_publishing() is called. Slots held by a subscriber which crashed stay held until then.
+* On POSIX systems, only processes of the same user may open the ring.
+* \param[in] device      Relevant RealSense device
+* \param[in] name        Name of the ring, replacing any ring of that name
+* \param[in] slot_count  Number of slots of the ring, each fitting the largest native frame of the device
+* \param[out] error      If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_start_publishing(rs_device * device, const char * name, int slot_count, rs_error ** error);
+
+/**
+* \brief Stops publishing, removing the ring, whose subscribers stop receiving frames
+* \param[in] device  Relevant RealSense device
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_stop_publishing(rs_device * device, rs_error ** error);
+
+/**
+* \brief Starts keeping the native frames of the last seconds of capture in memory, so that a window of them can be written out once an event occurs
+*
+* Capture threads only copy every frame into memory of the history. Z16 depth frames are then compressed losslessly from a thread of the history,
+* as rs_encode_depth() does, while other frames are kept in their native format, such as YUY2 color. Frames leave the history, oldest first, once
+* their timestamp is more than the given duration behind that of the latest frame, or once the history would otherwise hold more than max_bytes.
+* The history goes on across stops and starts of the device until rs_stop_frame_history() is called.
+* \param[in] device     Relevant RealSense device
+* \param[in] seconds    Duration of the history, compared to the timestamps of the frames
+* \param[in] max_bytes  Memory the frames of the history may take at most
+* \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_start_frame_history(rs_device * device, double seconds, unsigned long long max_bytes, rs_error ** error);
+
+/**
+* \brief Stops keeping a frame history, releasing its frames
+* \param[in] device  Relevant RealSense device
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_stop_frame_history(rs_device * device, rs_error ** error);
+
+/**
+* \brief Writes the frames of the frame history around a timestamp to a recording, which devices of the playback backend replay
+*
+* The frames written stay in the history, which goes on taking new frames meanwhile.
+* \param[in] device     Relevant RealSense device
+* \param[in] path       File to create, replacing any file of that name
+* \param[in] timestamp  Timestamp of interest, as returned by rs_get_frame_timestamp()
+* \param[in] before     Milliseconds of frames to write before timestamp
+* \param[in] after      Milliseconds of frames to write after timestamp
+* \param[out] error     If non-null, receives any error that occurs during this call, for instance when writing the file failed
+* \return               Number of frames written
+*/
+int rs_dump_frame_history(const rs_device * device, const char * path, double timestamp, double before, double after, rs_error ** error);
+
+/**
+* \brief Retrieves the memory taken by the frames of the frame history
+* \param[in] device  Relevant RealSense device
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return            Bytes of the frames held, 0 if the device keeps no frame history
+*/
+unsigned long long rs_get_frame_history_size(const rs_device * device, rs_error ** error);
+
+/**
+* \brief Sets when a device replaying a recording delivers its next frame
+*
+* Devices replay recordings when the library is built with the playback backend, which lists as devices the recordings named in the
+* RS_PLAYBACK_FILES environment variable, separated as the paths of PATH are. Their frames go through the same unpacking, synchronization and
+* processing as those of a camera. Pacing can be changed while the device streams.
+* \param[in] device  Device replaying a recording
+* \param[in] pacing  How frames are paced
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_set_playback_pacing(rs_device * device, rs_playback_pacing pacing, rs_error ** error);
+
+/**
+* \brief Delivers the next frame of a device replaying a recording with RS_PLAYBACK_PACING_STEP, along with the motion data recorded before it
+* \param[in] device  Device replaying a recording
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return            1 if a frame was delivered, 0 once the end of the recording is reached
+*/
+int rs_step_playback(rs_device * device, rs_error ** error);
+
+/**
+* \brief Moves a device replaying a recording to the first frame of a stream whose frame number is at least that given
+*
+* Frames are found through the index written at the end of recordings, or built by scanning recordings which were not stopped properly, so that
+* seeking takes no longer in an hour of recording than in a minute once the index is read, on the first seek. Playback goes on from the frame
+* sought, along with the frames of the other streams and the motion data recorded after it. A device which is not streaming starts from there.
+* \param[in] device        Device replaying a recording
+* \param[in] stream        Stream whose frame numbers are compared, which must be native
+* \param[in] frame_number  Frame number of the frame sought
+* \param[out] error        If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return                  1 if playback moved, 0 if no later frame of the stream was recorded, playback staying where it is
+*/
+int rs_seek_playback_to_frame(rs_device * device, rs_stream stream, unsigned long long frame_number, rs_error ** error);
+
+/**
+* \brief Moves a device replaying a recording to the first frame of a stream whose timestamp is at least that given, as rs_seek_playback_to_frame() does
+* \param[in] device     Device replaying a recording
+* \param[in] stream     Stream whose frame timestamps are compared, which must be native
+* \param[in] timestamp  Timestamp of the frame sought, in milliseconds, as returned by rs_get_frame_timestamp()
+* \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return               1 if playback moved, 0 if no later frame of the stream was recorded, playback staying where it is
+*/
+int rs_seek_playback_to_time(rs_device * device, rs_stream stream, double timestamp, rs_error ** error);
+
 
 /**
  * \brief Begins streaming on all enabled streams for this device
@@ -714,6 +1792,32 @@ void rs_start_source(rs_device * device, rs_source source, rs_error ** error);
  */
 void rs_stop_source(rs_device * device, rs_source source, rs_error ** error);
 
+/**
+ * \brief Turns the video streams of a streaming device off, keeping their modes, capture buffers and frame queues for \c rs_resume_device()
+ *
+ * Resuming takes no longer than the camera needs to start streaming again, unlike \c rs_stop_device() followed by \c rs_start_device().
+ * Frames already received can still be waited for, polled and released. The device stays streaming in the sense of \c rs_is_device_streaming(),
+ * so its configuration cannot change, and it can be stopped while paused. Pausing a paused device has no effect.
+ * \param[in] device  Relevant RealSense device
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored. The device is stopped if pausing fails.
+ */
+void rs_pause_device(rs_device * device, rs_error ** error);
+
+/**
+ * \brief Turns the video streams of a device paused by \c rs_pause_device() on again, in the modes they were started in
+ * \param[in] device  Relevant RealSense device
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored. The device is stopped if resuming fails.
+ */
+void rs_resume_device(rs_device * device, rs_error ** error);
+
+/**
+ * \brief Determines if the video streams of the device are paused
+ * \param[in] device  Relevant RealSense device
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            true if the device was paused by \c rs_pause_device() and not resumed or stopped since
+ */
+int rs_is_device_paused(const rs_device * device, rs_error ** error);
+
 /**
  * \brief Determines if the device is currently streaming
  * \param[in] device  Relevant RealSense device
@@ -765,6 +1869,78 @@ void rs_get_device_options(rs_device * device, const rs_option * options, unsign
  */
 void rs_set_device_options(rs_device * device, const rs_option * options, unsigned int count, const double * values, rs_error ** error);
 
+/**
+ * \brief Opens a transaction holding back the options written to the device until \c rs_commit_device_options()
+ *
+ * While the transaction is open, \c rs_set_device_option(), \c rs_set_device_options() and \c rs_reset_device_options_to_default() only record their writes,
+ * and reads still return the values of the device. Asynchronous writes are not held back.
+ * \param[in] device  Relevant RealSense device
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_begin_device_options(rs_device * device, rs_error ** error);
+
+/**
+ * \brief Closes the transaction opened by \c rs_begin_device_options(), writing the latest value recorded for every option at once
+ *
+ * Options sharing a hardware structure or control go out in a single USB transfer, and values the device is known to hold already are not written at all.
+ * The transaction is closed even if the writes fail, with the error of the failure.
+ * \param[in] device  Relevant RealSense device
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_commit_device_options(rs_device * device, rs_error ** error);
+
+/**
+ * \brief Sets the value of an arbitrary number of options without waiting for the hardware IO
+ *
+ * Asynchronous requests are carried out one at a time, in the order they were made, on a thread of the device.
+ * A write still waiting its turn absorbs the writes requested after it, so that frequent updates of the same options are never queued up behind one another:
+ * only the latest values are written, and all the merged requests complete together.
+ * \param[in] device       Relevant RealSense device
+ * \param[in] options      Array of options that should be set
+ * \param[in] count        Length of options and values arrays
+ * \param[in] values       Array of values to which the options should be set
+ * \param[in] on_complete  Called on the thread of the device once the options are written, with the values written and a null error, or with the reason they could not be. The error is only valid during the call. May be null.
+ * \param[in] user         Passed to on_complete
+ * \param[out] error       If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_device_options_async(rs_device * device, const rs_option * options, unsigned int count, const double * values, rs_options_callback_ptr on_complete, void * user, rs_error ** error);
+
+/**
+ * \brief Sets the value of an arbitrary number of options without waiting for the hardware IO
+ *
+ * This variant of \c rs_set_device_options_async() is provided specifically to enable passing lambdas with capture lists safely into the library.
+ * \param[in] device       Relevant RealSense device
+ * \param[in] options      Array of options that should be set
+ * \param[in] count        Length of options and values arrays
+ * \param[in] values       Array of values to which the options should be set
+ * \param[in] callback     Notified on the thread of the device once the options are written, then released. May be null.
+ * \param[out] error       If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_set_device_options_async_cpp(rs_device * device, const rs_option * options, unsigned int count, const double * values, rs_options_callback * callback, rs_error ** error);
+
+/**
+ * \brief Retrieves the value of an arbitrary number of options without waiting for the hardware IO, in order with the asynchronous writes
+ * \param[in] device       Relevant RealSense device
+ * \param[in] options      Array of options that should be queried
+ * \param[in] count        Length of the options array
+ * \param[in] on_complete  Called on the thread of the device with the values read and a null error, or with the reason they could not be. The error is only valid during the call.
+ * \param[in] user         Passed to on_complete
+ * \param[out] error       If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_get_device_options_async(rs_device * device, const rs_option * options, unsigned int count, rs_options_callback_ptr on_complete, void * user, rs_error ** error);
+
+/**
+ * \brief Retrieves the value of an arbitrary number of options without waiting for the hardware IO, in order with the asynchronous writes
+ *
+ * This variant of \c rs_get_device_options_async() is provided specifically to enable passing lambdas with capture lists safely into the library.
+ * \param[in] device       Relevant RealSense device
+ * \param[in] options      Array of options that should be queried
+ * \param[in] count        Length of the options array
+ * \param[in] callback     Notified on the thread of the device with the values read, then released
+ * \param[out] error       If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ */
+void rs_get_device_options_async_cpp(rs_device * device, const rs_option * options, unsigned int count, rs_options_callback * callback, rs_error ** error);
+
 /**
 * \brief Efficiently resets the value of an arbitrary number of options to default
 * \param[in] device   Relevant RealSense device
@@ -818,6 +1994,39 @@ void rs_wait_for_frames(rs_device * device, rs_error ** error);
  */
 int rs_poll_for_frames(rs_device * device, rs_error ** error);
 
+/**
+ * \brief Blocks until new frames are available or the timeout expires
+ * \param[in] device      Relevant RealSense device
+ * \param[in] timeout_ms  Maximum time to wait, in milliseconds
+ * \param[out] error      If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return                1 if new frames were obtained, 0 if the timeout expired or the device is not streaming
+ */
+int rs_wait_for_frames_timeout(rs_device * device, unsigned int timeout_ms, rs_error ** error);
+
+/**
+ * \brief Retrieves an OS object that is signaled while new frames are available, so that several devices can be waited on from a single thread
+ *
+ * On Windows the result is an event \c HANDLE, usable with \c WaitForMultipleObjects(). Elsewhere it is a file descriptor, stored in the pointer value,
+ * that becomes readable for \c select() / \c poll() / \c epoll(). The object stays signaled until \c rs_poll_for_frames() or \c rs_wait_for_frames()
+ * has taken all pending frames. It belongs to the device, stays the same across start / stop and must not be closed by the application.
+ * \param[in] device  Relevant RealSense device
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Waitable handle
+ */
+void * rs_get_frames_ready_handle(rs_device * device, rs_error ** error);
+
+/**
+ * \brief Takes the latest frame of a stream, with RS_OPTION_FRAME_MAILBOX_ENABLED set, without blocking
+ *
+ * Each stream keeps only the last frame it delivered, which a newer frame replaces if it was not taken. A frame is returned once, so
+ * calling again before the next frame arrives returns null.
+ * \param[in] device  Relevant RealSense device
+ * \param[in] stream  Native stream of interest
+ * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+ * \return            Frame handle, to be released with \c rs_release_frame(), or null if no frame arrived since the last call
+ */
+rs_frame_ref * rs_get_latest_frame(rs_device * device, rs_stream stream, rs_error ** error);
+
 /**
  * \brief Determines device capabilities
  * \param[in] device      Relevant RealSense device
@@ -890,6 +2099,63 @@ const void * rs_get_frame_data(const rs_device * device, rs_stream stream, rs_er
 */
 void rs_release_frame(rs_device * device, rs_frame_ref * frame, rs_error ** error);
 
+/**
+* \brief Obtains a handle to one frame of a frameset, without copying the frame
+* \param[in] device  Relevant RealSense device
+* \param[in] frames  Frameset received by a frameset callback
+* \param[in] stream  Stream of the requested frame
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return            Frame handle, to be released with \c rs_release_frame()
+*/
+rs_frame_ref * rs_detach_frame(rs_device * device, rs_frameset * frames, rs_stream stream, rs_error ** error);
+
+/**
+* \brief Releases a frameset handle, frames detached from it stay valid until released themselves
+* \param[in] device  Relevant RealSense device
+* \param[in] frames  Frameset received by a frameset callback
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_release_frames(rs_device * device, rs_frameset * frames, rs_error ** error);
+
+/**
+* \brief Computes a frame of a derived stream, such as points, rectified color or an aligned stream, from frames obtained through callbacks or framesets
+*
+* The result is a new frame from the device's frame pool, carrying the timestamp and metadata of the frame it is computed from, and must be released with \c rs_release_frame().
+* Safe to call from any thread, including several threads at once and from within frame callbacks.
+* \param[in] device  Relevant RealSense device
+* \param[in] stream  Derived stream to compute
+* \param[in] frames  Frames of the native streams the derived stream is built on, for instance depth and color for \c RS_STREAM_COLOR_ALIGNED_TO_DEPTH
+* \param[in] count   Number of frames
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return            Frame handle, to be released with \c rs_release_frame()
+*/
+rs_frame_ref * rs_process_frames(rs_device * device, rs_stream stream, rs_frame_ref * const * frames, int count, rs_error ** error);
+
+/**
+* \brief Computes a frame of a derived stream from the frames of a frameset, the frameset stays valid and owned by the caller
+* \param[in] device  Relevant RealSense device
+* \param[in] frames  Frameset received by a frameset callback
+* \param[in] stream  Derived stream to compute
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return            Frame handle, to be released with \c rs_release_frame()
+* \see \c rs_process_frames()
+*/
+rs_frame_ref * rs_process_frameset(rs_device * device, const rs_frameset * frames, rs_stream stream, rs_error ** error);
+
+/**
+* \brief Retrieves the data, dimensions, format, timestamps and metadata of every frame of a frameset in one call
+*
+* Fills one rs_frame_info per stream with a frame in the frameset, in the order of rs_stream, as the rs_get_detached_frame_*() calls would
+* for the frame detached of that stream, and counts these streams as consumed. The frameset stays valid and owned by the caller.
+* \param[in] device     Relevant RealSense device
+* \param[in] frames     Frameset received by a frameset callback
+* \param[out] infos     Receives up to max_count frames, may be null if max_count is 0
+* \param[in] max_count  Number of frames that fit in infos, one per native stream (those before RS_STREAM_POINTS) is always enough
+* \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return               Number of frames in the frameset, which may exceed max_count
+*/
+int rs_get_frameset_frame_info(rs_device * device, const rs_frameset * frames, rs_frame_info * infos, int max_count, rs_error ** error);
+
 /**
 * \brief Retrieves timestamp from frame reference
 * \param[in] frame   Current frame reference
@@ -924,6 +2190,36 @@ unsigned long long rs_get_detached_frame_number(const rs_frame_ref * frame, rs_e
 */
 const void * rs_get_detached_frame_data(const rs_frame_ref * frame, rs_error ** error);
 
+/**
+* \brief Retrieves the pixels of a frame where they lie, which for streams handed out as views of an interleaved native frame, see RS_OPTION_INTERLEAVED_VIEWS_ENABLED, are not packed
+* \param[in] frame          Current frame reference
+* \param[out] pixel_stride  Receives the number of bytes from one pixel to the next of a row
+* \param[out] row_stride    Receives the number of bytes from one row to the next
+* \param[out] error         If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return                   Pointer to the first pixel, valid as long as the frame is held
+*/
+const void * rs_get_detached_frame_strided_data(const rs_frame_ref * frame, int * pixel_stride, int * row_stride, rs_error ** error);
+
+/**
+* \brief Retrieves a level of the depth pyramid built behind a depth frame, see RS_OPTION_DEPTH_PYRAMID_LEVELS
+* \param[in] frame    Current frame reference
+* \param[in] level    Level of the pyramid, 0 being the frame itself
+* \param[out] width   Receives the width of the level in pixels, 0 if the frame has no such level
+* \param[out] height  Receives the height of the level in pixels, 0 if the frame has no such level
+* \param[out] error   If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return             Pointer to the packed pixels of the level, valid as long as the frame is held, or null if the frame has no such level
+*/
+const void * rs_get_detached_frame_pyramid_level(const rs_frame_ref * frame, int level, int * width, int * height, rs_error ** error);
+
+/**
+* \brief Retrieves the runs of consecutive pixels with data found in every row of a depth frame, see RS_OPTION_DEPTH_RUNS_ENABLED
+* \param[in] frame   Current frame reference
+* \param[out] runs   Receives the runs, pairs of the x of the first pixel of a run and its number of pixels, or null if the frame has none
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return            The height + 1 offsets of the runs of every row, those of row y being runs y to y + 1 exclusive, valid as long as the frame is held, or null if the frame has no runs
+*/
+const unsigned int * rs_get_detached_frame_depth_runs(const rs_frame_ref * frame, const unsigned short ** runs, rs_error ** error);
+
 /**
 * \brief Retrieves frame intrinsic width in pixels
 * \param[in] frame   Current frame reference
@@ -980,6 +2276,14 @@ rs_format rs_get_detached_frame_format(const rs_frame_ref * frame, rs_error ** e
 */
 rs_stream rs_get_detached_frame_stream_type(const rs_frame_ref * frame, rs_error ** error);
 
+/**
+* \brief Retrieves which of the buffers given to rs_set_stream_frame_buffers() holds a frame
+* \param[in] frame   Current frame reference
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return            Index of the buffer, -1 if the frame is held in memory of the library
+*/
+int rs_get_detached_frame_buffer_index(const rs_frame_ref * frame, rs_error ** error);
+
 /**
 * \brief Sends arbitrary binary data to the device 
 
@@ -991,6 +2295,19 @@ rs_stream rs_get_detached_frame_stream_type(const rs_frame_ref * frame, rs_error
 */
 void rs_send_blob_to_device(rs_device * device, rs_blob_type type, void * data, int size, rs_error ** error);
 
+/**
+* \brief Sends arbitrary binary data to the device, reporting progress while it is transferred. Motion module firmware is written in
+* IAP packets sent back to back, and on_progress is called after each of them, on the calling thread, before this call returns.
+* \param[in] device       Relevant RealSense device
+* \param[in] type         Type of raw data to send to the device
+* \param[in] data         Raw data pointer to send
+* \param[in] size         Size, in bytes of the raw data to send
+* \param[in] on_progress  Called with the bytes sent so far and the size of the data
+* \param[in] user         User argument handed to on_progress
+* \param[out] error       If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_send_blob_to_device_with_progress(rs_device * device, rs_blob_type type, void * data, int size, rs_blob_progress_callback_ptr on_progress, void * user, rs_error ** error);
+
 /**
 * \brief Retrieves API version from the source code. Evaluate that the value is conformant to the established policies
 * \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
@@ -1038,6 +2355,12 @@ const char * rs_camera_info_to_string(rs_camera_info info);
 const char * rs_camera_info_to_string(rs_camera_info info);
 const char * rs_timestamp_domain_to_string(rs_timestamp_domain info);
 const char * rs_frame_metadata_to_string(rs_frame_metadata md);
+const char * rs_frame_drop_policy_to_string(rs_frame_drop_policy policy);
+const char * rs_straggler_policy_to_string(rs_straggler_policy policy);
+const char * rs_playback_pacing_to_string(rs_playback_pacing pacing);
+const char * rs_stream_metric_to_string(rs_stream_metric metric);
+const char * rs_transfer_statistic_to_string(rs_transfer_statistic statistic);
+const char * rs_load_shedding_action_to_string(rs_load_shedding_action action);
 
 /**
 * \brief Starts logging to console
@@ -1046,6 +2369,81 @@ const char * rs_frame_metadata_to_string(rs_frame_metadata md);
 */
 void rs_log_to_console(rs_log_severity min_severity, rs_error ** error);
 
+/**
+* \brief Converts a disparity image to a Z16 depth image, through a lookup table which is only rebuilt when the scales change
+* \param[in] disparity_pixels  The RS_FORMAT_DISPARITY16 pixels to convert
+* \param[out] z_pixels         Receives count RS_FORMAT_Z16 pixels. Disparities of zero, and depths Z16 cannot represent, become zero.
+* \param[in] count             The number of pixels to convert
+* \param[in] disparity_scale   The depth scale reported by the device while streaming disparity, so that depth in meters is disparity_scale / disparity
+* \param[in] z_scale           The size of one Z16 unit, in meters
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_convert_disparity_to_z16(const unsigned short * disparity_pixels, unsigned short * z_pixels, int count, float disparity_scale, float z_scale, rs_error ** error);
+
+/**
+* \brief Retrieves the size of the buffer rs_encode_depth() requires for an image of pixel_count pixels
+* \param[in] pixel_count  The number of pixels of the image
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return               The most bytes the encoding of such an image may take
+*/
+int rs_get_encoded_depth_max_size(int pixel_count, rs_error ** error);
+
+/**
+* \brief Losslessly compresses a Z16 depth image, through run length and variable length coding of the differences between neighboring pixels
+*
+* Runs of pixels without depth take a few bits, and smooth surfaces about half a byte per pixel, so that typical depth images shrink three to
+* five times, at a speed which keeps up with capture on a single core. Recordings use the same encoding for their depth frames.
+* \param[in] depth_pixels  The RS_FORMAT_Z16 pixels to encode
+* \param[in] pixel_count   The number of pixels to encode
+* \param[out] buffer       Receives the encoded image
+* \param[in] buffer_size   The size of buffer, which must be at least rs_get_encoded_depth_max_size(pixel_count)
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return                  The number of bytes of the encoded image
+*/
+int rs_encode_depth(const unsigned short * depth_pixels, int pixel_count, void * buffer, int buffer_size, rs_error ** error);
+
+/**
+* \brief Restores a Z16 depth image encoded by rs_encode_depth()
+* \param[in] data          The encoded image
+* \param[in] size          The number of bytes of the encoded image
+* \param[out] depth_pixels Receives pixel_count RS_FORMAT_Z16 pixels
+* \param[in] pixel_count   The number of pixels of the image, an error being reported when the encoded image has another number of pixels
+* \param[out] error  If non-null, receives any error that occurs during this call, for instance when the encoded image is truncated
+*/
+void rs_decode_depth(const void * data, int size, unsigned short * depth_pixels, int pixel_count, rs_error ** error);
+
+/**
+* \brief Serves the cameras of this host over TCP to libraries built with the network backend, which list them as devices of their own
+*
+* The server relays the native frames and motion data as they are captured, and carries out the requests of its client, one client at a time,
+* so that the bandwidth of the link is that of the native streams, and unpacking happens on the client. Clients name the servers they connect
+* to, as host:port pairs separated by commas, in the RS_NETWORK_SERVERS environment variable. Devices of this host opened by the library
+* cannot be served at the same time.
+*
+* The protocol has no authentication nor encryption: any host reaching the address and port can stream the cameras, change their controls and
+* send them raw hw-monitor commands, firmware updates included. Listen on other addresses than loopback only on trusted networks.
+* \param[in] address The address of the local interface to listen on, such as "0.0.0.0" for every interface, or null for loopback only
+* \param[in] port    The TCP port to listen on, or 0 for any free port
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return            Server, to be deleted with \c rs_delete_server(), which disconnects its client
+*/
+rs_server * rs_create_server(const char * address, int port, rs_error ** error);
+
+/**
+* \brief Retrieves the TCP port a server listens on, which is the one picked by the system when created on port 0
+* \param[in] server  Relevant server
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return            The TCP port
+*/
+int rs_get_server_port(const rs_server * server, rs_error ** error);
+
+/**
+* \brief Stops a server, disconnecting its client, whose devices stop streaming
+* \param[in] server  Server that is no longer needed
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_delete_server(rs_server * server, rs_error ** error);
+
 /**
 * \brief Starts logging to file
 * \param[in] file_path Relative filename to log to. In case file exists, it will be appended to.
@@ -1071,6 +2469,43 @@ void rs_log_to_callback_cpp(rs_log_severity min_severity, rs_log_callback * call
 */
 void rs_log_to_callback(rs_log_severity min_severity, rs_log_callback_ptr on_log, void * user, rs_error ** error);
 
+/**
+* \brief Hands log messages to a background thread, which writes them to the console, file and callback, so that logging threads never wait
+*
+* Each thread queues up to queue_size messages, and the messages it logs while its queue is full are dropped and counted. Messages of one
+* thread are written in order, but may be interleaved with those of other threads out of order. Stopping writes every message queued.
+* \param[in] queue_size  The messages each thread may queue, or 0 to stop logging asynchronously, the default
+* \param[out] error      If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_log_asynchronously(int queue_size, rs_error ** error);
+
+/**
+* \brief Retrieves the number of log messages dropped so far because the queue of their thread was full
+* \param[out] error  If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+* \return            The messages dropped since the library was loaded
+*/
+unsigned long long rs_get_dropped_log_messages(rs_error ** error);
+
+/**
+* \brief Keeps the calibration read from devices in files of a directory, so that devices opened again skip reading it
+*
+* Entries are keyed by the serial number and firmware version of each device, and are checked against a small part of the calibration
+* read from the device every time it is opened, so that a device calibrated again is read again. Devices opened before the call are unaffected.
+* \param[in] directory  An existing directory, which may be shared between processes, or null to stop using the cache, the default
+* \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_set_calibration_cache_directory(const char * directory, rs_error ** error);
+
+/**
+* \brief Writes the spans recorded in the capture, processing and hardware monitor threads to a file, in the Chrome trace event format
+*
+* Each thread keeps its latest spans only, so the file covers the last moments of busy threads. Perfetto and chrome://tracing open it.
+* Spans are only recorded by libraries built with the ENABLE_TRACING CMake option, and the call fails otherwise.
+* \param[in] file_path  The file to write, replaced if it exists
+* \param[out] error     If non-null, receives any error that occurs during this call, otherwise, errors are ignored.
+*/
+void rs_export_trace(const char * file_path, rs_error ** error);
+
 #ifdef __cplusplus
 }
 #endif
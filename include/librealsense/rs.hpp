@@ -17,6 +17,15 @@
 #include <stdexcept>
 #include <functional>
 #include <vector>
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#include <cerrno>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <poll.h>
+#endif
+#endif
 
 namespace rs
 {
@@ -34,7 +43,10 @@ namespace rs
         infrared2_aligned_to_depth      ,  /**< Synthetic stream containing second viewpoint infrared data but sharing intrinsic of depth stream */
         depth_aligned_to_color          ,  /**< Synthetic stream containing depth data but sharing intrinsic of color stream */
         depth_aligned_to_rectified_color,  /**< Synthetic stream containing depth data but sharing intrinsic of rectified color stream */
-        depth_aligned_to_infrared2         /**< Synthetic stream containing depth data but sharing intrinsic of second viewpoint infrared stream */
+        depth_aligned_to_infrared2      ,  /**< Synthetic stream containing depth data but sharing intrinsic of second viewpoint infrared stream */
+        depth_colorized                 ,  /**< Synthetic stream containing the depth image colored for display as RGB8 */
+        rectified_fisheye               ,  /**< Synthetic stream containing fish-eye data undistorted to a pinhole image */
+        normals                            /**< Synthetic stream containing the unit surface normal behind every depth pixel */
     };
 
     ///  \brief Formats: defines how each stream can be encoded.
@@ -54,7 +66,13 @@ namespace rs
         y16         ,  /**< 16-bit per-pixel grayscale image */
         raw10       ,  /**< Four 10-bit luminance values encoded into a 5-byte macropixel */
         raw16       ,  /**< 16-bit raw image */
-        raw8           /**< 8-bit raw image */
+        raw8        ,  /**< 8-bit raw image */
+        xyz16f      ,  /**< 16-bit half precision floating point 3D coordinates, in meters. */
+        xyz16       ,  /**< 16-bit signed 3D coordinates, in millimeters. Coordinates beyond 32.767 meters are clamped. */
+        xyzuv32f    ,  /**< 32-bit floating point 3D coordinates, in meters, each followed by the coordinates of the color pixel it projects to, normalized by the color image size. */
+        nv12        ,  /**< 8-bit luminance plane followed by a plane of interleaved U and V samples, one pair per 2x2 pixels */
+        i420        ,  /**< 8-bit luminance plane followed by a U plane and a V plane of one sample per 2x2 pixels */
+        xyz32f_planar  /**< 32-bit floating point 3D coordinates, in meters, as a plane of X followed by a plane of Y and a plane of Z */
     };
 
     /// \brief Output buffer format: sets how librealsense works with frame memory.
@@ -159,8 +177,27 @@ namespace rs
     /// \brief Types of value provided from the device with each frame
     enum class frame_metadata
     {
-        actual_exposure, /**< Actual exposure at which the frame was captured */
-        actual_fps       /**< Actual FPS at the time of capture */
+        actual_exposure,        /**< Actual exposure at which the frame was captured */
+        actual_fps,             /**< Actual FPS at the time of capture */
+        depth_min,              /**< Smallest value of the depth pixels with data */
+        depth_max,              /**< Largest value of the depth pixels with data */
+        depth_valid_pixels,     /**< Number of depth pixels with data */
+        depth_histogram_0,      /**< Number of depth pixels from 1 to 255 depth units */
+        depth_histogram_1,      /**< Number of depth pixels from 256 to 511 depth units */
+        depth_histogram_2,      /**< Number of depth pixels from 512 to 1023 depth units */
+        depth_histogram_3,      /**< Number of depth pixels from 1024 to 2047 depth units */
+        depth_histogram_4,      /**< Number of depth pixels from 2048 to 4095 depth units */
+        depth_histogram_5,      /**< Number of depth pixels from 4096 to 8191 depth units */
+        depth_histogram_6,      /**< Number of depth pixels from 8192 to 16383 depth units */
+        depth_histogram_7,      /**< Number of depth pixels of 16384 depth units or more */
+        time_of_dequeue,        /**< Time the driver handed over the native frame, in milliseconds of a monotonic clock of the host */
+        time_of_validation,     /**< Time the native frame was validated and timestamped */
+        time_of_unpack_start,   /**< Time unpacking of the native frame started */
+        time_of_unpack_end,     /**< Time unpacking of the native frame ended */
+        time_of_commit,         /**< Time the frame was committed to the archive, or published for its frame callback */
+        time_of_sync,           /**< Time the frame was matched into a frameset */
+        time_of_delivery,       /**< Time the frame was first handed to the application */
+        time_of_exposure        /**< Time of the device timestamp of the frame, mapped to the monotonic clock of the host */
     };
 
     /// \brief Specifies various capabilities of a RealSense device.
@@ -245,6 +282,62 @@ namespace rs
         microcontroller /**< Frame timestamp was measured in relation to the microcontroller clock */
     };
 
+    /// \brief Specifies which frame is discarded once the library queue of a stream is full
+    enum class frame_drop_policy
+    {
+        drop_oldest, /**< Discard the oldest queued frame to make room for the one that just arrived. This is the default. */
+        drop_newest, /**< Keep the queued frames and discard the one that just arrived */
+        latest_only  /**< Only ever keep the most recent frame, regardless of the queue depth */
+    };
+
+    /// \brief Specifies what becomes of the framesets of a multi-device synchronizer which found no match on some of the devices
+    enum class straggler_policy
+    {
+        drop_set,       /**< Release the framesets of an incomplete set without delivering them. This is the default. */
+        deliver_partial /**< Deliver an incomplete set, with no frameset for the devices it is missing */
+    };
+
+    /// \brief Specifies when a device replaying a recording delivers its next frame
+    enum class playback_pacing
+    {
+        real_time,              /**< Frames are delivered as far apart as they were captured. This is the default. */
+        as_fast_as_possible,    /**< Frames are delivered as soon as the previous frame was handled */
+        step                    /**< Frames are delivered one at a time, on every call to device::step_playback() */
+    };
+
+    /// \brief Counters of what happened to the frames of a native stream, read with device::get_stream_metric()
+    enum class stream_metric
+    {
+        frames_received,        /**< Native frames the driver delivered, including those found invalid */
+        frames_invalid,         /**< Native frames rejected as corrupted before being unpacked */
+        frames_culled,          /**< Frames the sync archive discarded, to form coherent framesets or to honor the queue policy of the stream */
+        frames_unpublished,     /**< Frames dropped for lack of a free slot in the frame pools, or because the application held option::frames_queue_size frames of the stream */
+        queued_frames,          /**< Frames currently waiting in the sync archive. Unlike the other metrics, this one is not cumulative. */
+        unpack_nanoseconds,     /**< Total time spent unpacking the native frames the stream is unpacked from */
+        callback_nanoseconds,   /**< Total time spent in the frame callback of the stream */
+        derived_frames_shed,    /**< Framesets whose streams derived from this one were not precomputed, to shed load. Counted on the native stream the derived stream is computed from. */
+        unpacks_shed,           /**< Native frames released without being unpacked because every stream they provide had a full queue, to shed load */
+        frames_decimated        /**< Native frames released without being unpacked to lower the frame rate, to shed load */
+    };
+
+    /// \brief Counters of the transfers of the USB interface a native stream is captured from, read with device::get_transfer_statistic()
+    enum class transfer_statistic
+    {
+        bytes,                  /**< Bytes of the frames received */
+        bytes_per_second,       /**< Bytes received over the last second measured, 0 once two seconds passed without any frame. Unlike the other statistics, this one is not cumulative. */
+        frames,                 /**< Frames received, including short ones */
+        short_frames,           /**< Frames which arrived with fewer bytes than their mode has */
+        errors                  /**< Transfers, packets and dequeues the USB stack or driver reported as failed */
+    };
+
+    /// \brief Ways a device sheds load once its application falls behind, taken in the order given to device::set_load_shedding()
+    enum class load_shedding_action
+    {
+        skip_derived_streams,   /**< Derived streams are no longer precomputed, the application computing those it reads on request */
+        skip_culled_unpacking,  /**< Native frames are released without being unpacked while every stream they provide has a full queue */
+        decimate_framerate      /**< Every other native frame is released without being unpacked, halving the frame rate */
+    };
+
     struct float2 { float x,y; };
     struct float3 { float x,y,z; };
 
@@ -267,6 +360,10 @@ namespace rs
         float2      project(const float3 & point) const                                 { float2 pixel = {}; rs_project_point_to_pixel(&pixel.x, this, &point.x); return pixel; }
         float2      project_to_texcoord(const float3 & point) const                     { return pixel_to_texcoord(project(point)); }
 
+                    // Batches of the mappings above, vectorized within the library
+        std::vector<float3> deproject(const std::vector<float2> & pixels, const std::vector<float> & depths) const;
+        std::vector<float2> project(const std::vector<float3> & points) const;
+
         bool        operator == (const intrinsics & r) const                            { return memcmp(this, &r, sizeof(r)) == 0; }
 
     };
@@ -282,6 +379,7 @@ namespace rs
     {
         bool        is_identity() const                                                 { return (rotation[0] == 1) && (rotation[4] == 1) && (translation[0] == 0) && (translation[1] == 0) && (translation[2] == 0); }
         float3      transform(const float3 & point) const                               { float3 p = {}; rs_transform_point_to_point(&p.x, this, &point.x); return p; }
+        std::vector<float3> transform(const std::vector<float3> & points) const; // Vectorized within the library
     };
 
     /// \brief Timestamp data from the motion microcontroller
@@ -315,6 +413,51 @@ namespace rs
         const std::string & get_failed_args() const { return args; }
         static void handle(rs_error * e) { if(e) throw error(e); }
     };
+
+    inline std::vector<float3> intrinsics::deproject(const std::vector<float2> & pixels, const std::vector<float> & depths) const
+    {
+        if (depths.size() != pixels.size()) throw std::runtime_error("deproject needs the depth of every pixel");
+        if (pixels.empty()) return {};
+        std::vector<float3> points(pixels.size());
+        rs_error * e = nullptr;
+        rs_deproject_pixels_to_points(&points.data()->x, this, &pixels.data()->x, depths.data(), (int)pixels.size(), &e);
+        error::handle(e);
+        return points;
+    }
+
+    inline std::vector<float2> intrinsics::project(const std::vector<float3> & points) const
+    {
+        if (points.empty()) return {};
+        std::vector<float2> pixels(points.size());
+        rs_error * e = nullptr;
+        rs_project_points_to_pixels(&pixels.data()->x, this, &points.data()->x, (int)points.size(), &e);
+        error::handle(e);
+        return pixels;
+    }
+
+    inline std::vector<float3> extrinsics::transform(const std::vector<float3> & points) const
+    {
+        if (points.empty()) return {};
+        std::vector<float3> moved(points.size());
+        rs_error * e = nullptr;
+        rs_transform_points_to_points(&moved.data()->x, this, &points.data()->x, (int)points.size(), &e);
+        error::handle(e);
+        return moved;
+    }
+    class devices_changed_callback : public rs_devices_changed_callback
+    {
+        std::function<void(device *, bool)> on_change_function;
+    public:
+        explicit devices_changed_callback(std::function<void(device *, bool)> on_change) : on_change_function(on_change) {}
+
+        void on_devices_changed(rs_context *, rs_device * device, int connected) override
+        {
+            on_change_function((rs::device *)device, connected != 0);
+        }
+
+        void release() override { delete this; }
+    };
+
     /// \brief Context
     class context
     {
@@ -358,6 +501,44 @@ namespace rs
             error::handle(e);
             return (device *)r;
         }
+
+        /// Keeps the devices of the context up to date as they are attached and detached, calling back from a thread of the library
+        /// with every device added (true) or removed (false). Indices passed to get_device() are reassigned by every change.
+        /// \param[in] on_change  Callback invoked for every change, or an empty function to stop watching for devices
+        void set_devices_changed_callback(std::function<void(device * device, bool connected)> on_change)
+        {
+            rs_error * e = nullptr;
+            rs_set_devices_changed_callback_cpp(handle, on_change ? new devices_changed_callback(on_change) : nullptr, &e);
+            error::handle(e);
+        }
+
+        /// Sets the pool of threads running the background work of every device, waiting for the work in progress
+        /// \param[in] count     Number of threads, from 1 to 64
+        /// \param[in] cpu_mask  CPUs the threads may run on, bit n standing for CPU n, or 0 for every CPU
+        void set_executor_threads(int count, uint64_t cpu_mask = 0)
+        {
+            rs_error * e = nullptr;
+            rs_set_executor_threads(handle, count, cpu_mask, &e);
+            error::handle(e);
+        }
+
+        /// Retrieves the number of threads running the background work of every device
+        int get_executor_thread_count() const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_executor_thread_count(handle, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// Retrieves the CPUs the threads running the background work may run on, 0 standing for every CPU
+        uint64_t get_executor_cpu_mask() const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_executor_cpu_mask(handle, &e);
+            error::handle(e);
+            return r;
+        }
     };  
 
     class motion_callback : public rs_motion_callback
@@ -388,6 +569,20 @@ namespace rs
         void release() override { delete this; }
     };
 
+    class motion_batch_callback : public rs_motion_batch_callback
+    {
+        std::function<void(const motion_data * motion, int motion_count, const timestamp_data * timestamps, int timestamp_count)> on_events_function;
+    public:
+        explicit motion_batch_callback(std::function<void(const motion_data * motion, int motion_count, const timestamp_data * timestamps, int timestamp_count)> on_events) : on_events_function(on_events) {}
+
+        void on_events(const rs_motion_data * motion, int motion_count, const rs_timestamp_data * timestamps, int timestamp_count) override
+        {
+            on_events_function((const motion_data *)motion, motion_count, (const timestamp_data *)timestamps, timestamp_count);
+        }
+
+        void release() override { delete this; }
+    };
+
     /// \brief Frame
     class frame
     {
@@ -421,6 +616,9 @@ namespace rs
             }
         }
 
+        /// \brief Determines if the frame holds a frame of the device, rather than no frame, as returned by device::get_latest_frame() when none arrived
+        explicit operator bool() const { return frame_ref != nullptr; }
+
         /// Retrieves time at which frame was captured
         /// \return            Timestamp of the frame, in milliseconds since the device was started
         double get_timestamp() const
@@ -483,6 +681,42 @@ namespace rs
             return r;
         }
 
+        /// Retrieves frame content where it lies, which need not be packed for streams handed out as interleaved views
+        /// \param[out] pixel_stride  Bytes from one pixel to the next of a row
+        /// \param[out] row_stride    Bytes from one row to the next
+        /// \return   Frame content
+        const void * get_strided_data(int & pixel_stride, int & row_stride) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_detached_frame_strided_data(frame_ref, &pixel_stride, &row_stride, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// Retrieves a level of the depth pyramid built behind a depth frame
+        /// \param[in] level   Level of the pyramid, 0 being the frame itself
+        /// \param[out] width  Width of the level in pixels
+        /// \param[out] height Height of the level in pixels
+        /// \return   Packed pixels of the level, or null if the frame has no such level
+        const void * get_pyramid_level(int level, int & width, int & height) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_detached_frame_pyramid_level(frame_ref, level, &width, &height, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// Retrieves the runs of consecutive pixels with data found in every row of a depth frame
+        /// \param[out] runs  Pairs of the x of the first pixel of a run and its number of pixels
+        /// \return   Offsets of the runs of every row, from row_runs[y] to row_runs[y + 1], or null if the frame has no runs
+        const unsigned int * get_depth_runs(const unsigned short *& runs) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_detached_frame_depth_runs(frame_ref, &runs, &e);
+            error::handle(e);
+            return r;
+        }
+
         /// \brief Returns image width in pixels
         int get_width() const
         {
@@ -548,6 +782,67 @@ namespace rs
             error::handle(e);
             return static_cast<stream>(s);
         }
+
+        /// \brief Retrieves which of the buffers given to device::set_stream_frame_buffers() holds the frame
+        /// \return    Index of the buffer, -1 if the frame is held in memory of the library
+        int get_buffer_index() const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_detached_frame_buffer_index(frame_ref, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Computes a frame of a derived stream, such as points or rectified color, from this frame alone
+        /// \param[in] derived  Derived stream to compute
+        /// \return             New frame of the derived stream, safe to compute from any thread
+        frame process(stream derived) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_process_frames(device, (rs_stream)derived, &frame_ref, 1, &e);
+            error::handle(e);
+            return frame(device, r);
+        }
+
+        /// \brief Computes a frame of a derived stream built on two native streams, such as an aligned stream
+        /// \param[in] derived  Derived stream to compute
+        /// \param[in] other    Frame of the other stream the derived stream is built on
+        /// \return             New frame of the derived stream, safe to compute from any thread
+        frame process(stream derived, const frame & other) const
+        {
+            rs_error * e = nullptr;
+            rs_frame_ref * const frames[] = { frame_ref, other.frame_ref };
+            auto r = rs_process_frames(device, (rs_stream)derived, frames, 2, &e);
+            error::handle(e);
+            return frame(device, r);
+        }
+
+        /// \brief Deprojects depth frames of several devices into one point cloud in the frame of reference of the rig holding them
+        /// \param[in] depth_frames    Frames of the depth streams, one of every device, in format Z16
+        /// \param[in] device_to_rig   Pose of the device of every frame in the rig frame
+        /// \param[in] voxel_size      Width in meters of the cubes the points are merged in, or 0 to keep every point
+        /// \return                    Points of every pixel with depth, or of every cube reached, in the rig frame
+        friend std::vector<float3> fuse_point_clouds(const std::vector<const frame *> & depth_frames, const std::vector<extrinsics> & device_to_rig, float voxel_size)
+        {
+            std::vector<rs_device *> devices;
+            std::vector<rs_frame_ref *> frames;
+            int capacity = 0;
+            for (auto f : depth_frames)
+            {
+                devices.push_back(f->device);
+                frames.push_back(f->frame_ref);
+                capacity += f->get_width() * f->get_height();
+            }
+            const std::vector<rs_extrinsics> poses(device_to_rig.begin(), device_to_rig.end());
+            if (poses.size() != frames.size()) throw std::runtime_error("fuse_point_clouds needs the pose of the device of every frame");
+
+            std::vector<float3> points(capacity);
+            rs_error * e = nullptr;
+            auto r = rs_fuse_point_clouds(devices.data(), frames.data(), poses.data(), (int)frames.size(), voxel_size, &points.data()->x, capacity, &e);
+            error::handle(e);
+            points.resize(r);
+            return points;
+        }
     };
 
     class frame_callback : public rs_frame_callback
@@ -563,6 +858,143 @@ namespace rs
 
         void release() override { delete this; }
     };
+
+    class slice_callback : public rs_slice_callback
+    {
+        std::function<void(const uint16_t * rows, int width, int first_row, int row_count)> on_slice_function;
+    public:
+        explicit slice_callback(std::function<void(const uint16_t * rows, int width, int first_row, int row_count)> on_slice) : on_slice_function(on_slice) {}
+
+        void on_slice(rs_device *, const void * rows, int width, int first_row, int row_count) override
+        {
+            on_slice_function(static_cast<const uint16_t *>(rows), width, first_row, row_count);
+        }
+
+        void release() override { delete this; }
+    };
+
+    class encoded_packet_callback : public rs_encoded_packet_callback
+    {
+        std::function<void(const rs_encoded_packet & packet)> on_packet_function;
+    public:
+        explicit encoded_packet_callback(std::function<void(const rs_encoded_packet & packet)> on_packet) : on_packet_function(on_packet) {}
+
+        void on_packet(rs_device *, rs_stream, rs_encoded_packet packet) override
+        {
+            on_packet_function(packet);
+        }
+
+        void release() override { delete this; }
+    };
+
+    /// \brief Synchronized set of frames, one per enabled stream, shared with the library rather than copied
+    class frameset
+    {
+        rs_device * device;
+        rs_frameset * frames;
+
+        frameset(const frameset &) = delete;
+
+    public:
+        frameset() : device(nullptr), frames(nullptr) {}
+        frameset(rs_device * device, rs_frameset * frames) : device(device), frames(frames) {}
+        frameset(frameset&& other) : device(other.device), frames(other.frames) { other.frames = nullptr; }
+        bool empty() const { return frames == nullptr; } // A partial set of a multi-device synchronizer has empty framesets for its missing devices
+        frameset& operator=(frameset other)
+        {
+            swap(other);
+            return *this;
+        }
+        void swap(frameset& other)
+        {
+            std::swap(device, other.device);
+            std::swap(frames, other.frames);
+        }
+
+        ~frameset()
+        {
+            if (device && frames)
+            {
+                rs_error * e = nullptr;
+                rs_release_frames(device, frames, &e);
+                error::handle(e);
+            }
+        }
+
+        /// \brief Obtains the frame of a specific stream, which stays valid after the frameset is released
+        /// \param[in] stream  Stream
+        /// \return            Frame of the requested stream
+        frame detach(stream stream)
+        {
+            rs_error * e = nullptr;
+            auto r = rs_detach_frame(device, frames, (rs_stream)stream, &e);
+            error::handle(e);
+            return frame(device, r);
+        }
+
+        /// \brief Computes a frame of a derived stream, such as an aligned stream, from the frames of this frameset
+        /// \param[in] derived  Derived stream to compute
+        /// \return             New frame of the derived stream, which stays valid after the frameset is released
+        frame process(stream derived) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_process_frameset(device, frames, (rs_stream)derived, &e);
+            error::handle(e);
+            return frame(device, r);
+        }
+
+        /// \brief Retrieves the data, dimensions, format, timestamps and metadata of every frame of this frameset at once
+        /// \return  One entry per stream with a frame in this frameset, whose data stays valid until the frameset is released
+        std::vector<rs_frame_info> get_frame_info() const
+        {
+            rs_error * e = nullptr;
+            std::vector<rs_frame_info> infos(RS_STREAM_POINTS); // One per native stream
+            infos.resize(rs_get_frameset_frame_info(device, frames, infos.data(), (int)infos.size(), &e));
+            error::handle(e);
+            return infos;
+        }
+    };
+
+    class frameset_callback : public rs_frameset_callback
+    {
+        std::function<void(frameset)> on_frameset_function;
+    public:
+        explicit frameset_callback(std::function<void(frameset)> on_frameset) : on_frameset_function(on_frameset) {}
+
+        void on_frameset(rs_device * device, rs_frameset * frames) override
+        {
+            on_frameset_function(std::move(frameset(device, frames)));
+        }
+
+        void release() override { delete this; }
+    };
+
+    class options_callback : public rs_options_callback
+    {
+        std::function<void(const option *, size_t, const double *, const char *)> on_options_function;
+    public:
+        explicit options_callback(std::function<void(const option *, size_t, const double *, const char *)> on_options) : on_options_function(on_options) {}
+
+        void on_options(rs_device * device, const rs_option * options, unsigned int count, const double * values, const char * error_message) override
+        {
+            on_options_function((const option *)options, count, values, error_message);
+        }
+
+        void release() override { delete this; }
+    };
+
+    class frame_allocator : public rs_frame_allocator
+    {
+        std::function<void *(size_t)> allocate_function;
+        std::function<void(void *, size_t)> deallocate_function;
+    public:
+        frame_allocator(std::function<void *(size_t)> allocate, std::function<void(void *, size_t)> deallocate) : allocate_function(allocate), deallocate_function(deallocate) {}
+
+        void * allocate(size_t size) override { return allocate_function(size); }
+        void deallocate(void * ptr, size_t size) override { deallocate_function(ptr, size); }
+        void release() override { delete this; }
+    };
+
     /// \brief Provides convenience methods relating to devices
     class device
     {
@@ -603,6 +1035,16 @@ namespace rs
             return r;
         }
 
+        /// \brief Estimates the USB bandwidth the enabled streams would take once started
+        /// \return  Bandwidth of the frames, in megabytes per second
+        double get_bandwidth() const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_device_bandwidth((const rs_device *)this, &e);
+            error::handle(e);
+            return r;
+        }
+
         /// \brief Retrieves version of firmware currently installed on device
         /// \return  Firmware version string, in a format that is specific to device model
         const char * get_firmware_version() const
@@ -727,6 +1169,29 @@ namespace rs
             error::handle(e);
         }
 
+        /// \brief Restricts a derived stream to a window of its image, which is then the only part computed
+        /// \param[in] stream  Derived stream
+        /// \param[in] x       Left column of the window
+        /// \param[in] y       Top row of the window
+        /// \param[in] width   Width of the window, or 0 for the whole image
+        /// \param[in] height  Height of the window, or 0 for the whole image
+        void set_stream_roi(stream stream, int x, int y, int width, int height)
+        {
+            rs_error * e = nullptr;
+            rs_set_stream_roi((rs_device *)this, (rs_stream)stream, x, y, width, height, &e);
+            error::handle(e);
+        }
+
+        /// \brief Aligns an aligned stream to a fraction of the resolution of the stream it is aligned to
+        /// \param[in] stream  Aligned stream
+        /// \param[in] factor  Divides both dimensions, from 1 to 4
+        void set_stream_decimation(stream stream, int factor)
+        {
+            rs_error * e = nullptr;
+            rs_set_stream_decimation((rs_device *)this, (rs_stream)stream, factor, &e);
+            error::handle(e);
+        }
+
         /// \brief Determines if specific stream is enabled
         /// \param[in] stream  Stream to check
         /// \return            true if the stream is currently enabled
@@ -738,77 +1203,425 @@ namespace rs
             return r != 0;
         }
 
-        ///  \brief Retrieves width, in pixels, of a specific stream, equivalent to the width field from the stream's intrinsic
-        /// \param[in] stream  Stream 
-        /// \return            Width, in pixels of images from this stream
-        int get_stream_width(stream stream) const
+        /// \brief Sets how many frames of a specific stream are queued for wait_for_frames() and poll_for_frames(), and which frame is discarded once the queue is full
+        /// \param[in] stream  Stream
+        /// \param[in] depth   Maximum number of queued frames, between 1 and 16
+        /// \param[in] policy  Frame to discard once the queue is full
+        void set_stream_queue_policy(stream stream, int depth, frame_drop_policy policy)
         {
             rs_error * e = nullptr;
-            auto r = rs_get_stream_width((const rs_device *)this, (rs_stream)stream, &e);
+            rs_set_stream_queue_policy((rs_device *)this, (rs_stream)stream, depth, (rs_frame_drop_policy)policy, &e);
             error::handle(e);
-            return r;
         }
 
-        /// \brief Retrieves height, in pixels, of a specific stream, equivalent to the height field from the stream's intrinsic
+        /// \brief Retrieves the maximum number of queued frames of a specific stream
         /// \param[in] stream  Stream
-        /// \return            Height, in pixels of images from this stream
-        int get_stream_height(stream stream) const
+        /// \return            Queue depth
+        int get_stream_queue_depth(stream stream) const
         {
             rs_error * e = nullptr;
-            auto r = rs_get_stream_height((const rs_device *)this, (rs_stream)stream, &e);
+            auto r = rs_get_stream_queue_depth((const rs_device *)this, (rs_stream)stream, &e);
             error::handle(e);
             return r;
         }
 
-        /// \brief Retrieves pixel format for specific stream
+        /// \brief Retrieves which frame of a specific stream is discarded once its queue is full
         /// \param[in] stream  Stream
-        /// \return            Pixel format of the stream
-        format get_stream_format(stream stream) const
+        /// \return            Drop policy
+        frame_drop_policy get_stream_drop_policy(stream stream) const
         {
             rs_error * e = nullptr;
-            auto r = rs_get_stream_format((const rs_device *)this, (rs_stream)stream, &e);
+            auto r = rs_get_stream_drop_policy((const rs_device *)this, (rs_stream)stream, &e);
             error::handle(e);
-            return (format)r;
+            return (frame_drop_policy)r;
         }
 
-        /// \brief Retrieves frame rate for specific stream
-        /// \param[in] stream  Stream
-        /// \return            Frame rate of the stream, in frames per second
-        int get_stream_framerate(stream stream) const
+        /// \brief Provides the dma-bufs a specific stream is captured into while RS_OPTION_CAPTURE_MEMORY is 2
+        /// \param[in] stream  Native stream
+        /// \param[in] fds     Array of count dma-buf file descriptors, which only need to stay open until start() returns
+        /// \param[in] count   Number of descriptors, at least two, or zero to forget the ones provided before
+        void set_stream_capture_dmabufs(stream stream, const int * fds, int count)
         {
             rs_error * e = nullptr;
-            auto r = rs_get_stream_framerate((const rs_device *)this, (rs_stream)stream, &e);
+            rs_set_stream_capture_dmabufs((rs_device *)this, (rs_stream)stream, fds, count, &e);
             error::handle(e);
-            return r;
         }
 
-        /// \brief Retrieves intrinsic camera parameters for specific stream
-        /// \param[in] stream  Stream
-        /// \return            Intrinsic parameters of the stream
-        intrinsics get_stream_intrinsics(stream stream) const
+        /// \brief Sets how many buffers the camera driver captures a specific stream into
+        /// \param[in] stream  Native stream
+        /// \param[in] count   Number of buffers, or 0 to let the library choose
+        void set_stream_capture_buffer_count(stream stream, int count)
         {
             rs_error * e = nullptr;
-            intrinsics intrin;
-            rs_get_stream_intrinsics((const rs_device *)this, (rs_stream)stream, &intrin, &e);
+            rs_set_stream_capture_buffer_count((rs_device *)this, (rs_stream)stream, count, &e);
             error::handle(e);
-            return intrin;
         }
 
-        /// \brief Retrieves intrinsic camera parameters for motion module
-        /// \return            Intrinsic parameters
-        motion_intrinsics get_motion_intrinsics() const
+        /// \brief Retrieves how many buffers the camera driver captures a specific stream into
+        /// \param[in] stream  Native stream
+        /// \return            Number of buffers, 0 if the library chooses
+        int get_stream_capture_buffer_count(stream stream) const
         {
             rs_error * e = nullptr;
-            motion_intrinsics intrinsics;
-            rs_get_motion_intrinsics((const rs_device *)this, &intrinsics, &e);
+            auto r = rs_get_stream_capture_buffer_count((const rs_device *)this, (rs_stream)stream, &e);
             error::handle(e);
-            return intrinsics;
+            return r;
         }
 
-        /// \brief Sets callback for frame arrival event. 
-		/// 
-		/// The provided callback will be called the instant new frame of given stream becomes available
-        /// once callback is set on certain stream type, frames of this type will no longer be available throuhg wait/poll methods (those two approaches are mutually exclusive) 
+        /// \brief Crops a specific stream to a window of its image, by the driver when it can, from the next call to start()
+        /// \param[in] stream  Native stream
+        /// \param[in] x       First column of the window, in pixels of the uncropped stream
+        /// \param[in] y       First row of the window
+        /// \param[in] width   Width of the window, or 0 to stream the whole image
+        /// \param[in] height  Height of the window
+        void set_stream_crop(stream stream, int x, int y, int width, int height)
+        {
+            rs_error * e = nullptr;
+            rs_set_stream_crop((rs_device *)this, (rs_stream)stream, x, y, width, height, &e);
+            error::handle(e);
+        }
+
+        /// \brief Determines whether the driver crops a specific stream, rather than sending whole frames
+        /// \param[in] stream  Native stream
+        /// \return            true if the stream is streaming and cropped by the driver
+        bool is_stream_cropped_in_driver(stream stream) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_is_stream_cropped_in_driver((const rs_device *)this, (rs_stream)stream, &e);
+            error::handle(e);
+            return r != 0;
+        }
+
+        /// \brief Unpacks the frames of a specific stream into fixed-size buffers of the application, frame::get_buffer_index() telling which holds a frame
+        /// \param[in] stream       Native stream
+        /// \param[in] buffers      The buffers, each aligned to 64 bytes and valid until the device is stopped and every frame of the stream was released
+        /// \param[in] count        Number of buffers, up to RS_MAX_FRAME_BUFFERS, or 0 to unpack into memory of the library
+        /// \param[in] buffer_size  Size in bytes of every buffer
+        void set_stream_frame_buffers(stream stream, void * const buffers[], int count, int buffer_size)
+        {
+            rs_error * e = nullptr;
+            rs_set_stream_frame_buffers((rs_device *)this, (rs_stream)stream, buffers, count, buffer_size, &e);
+            error::handle(e);
+        }
+
+        /// \brief Moves the frame callback of a specific stream onto a thread of its own, frames waiting in a queue which discards its oldest frame once full
+        /// \param[in] stream  Native stream
+        /// \param[in] depth   Maximum number of queued frames, between 1 and 16, or 0 to invoke the callback on the capturing thread
+        void set_stream_callback_queue(stream stream, int depth)
+        {
+            rs_error * e = nullptr;
+            rs_set_stream_callback_queue((rs_device *)this, (rs_stream)stream, depth, &e);
+            error::handle(e);
+        }
+
+        /// \brief Retrieves the maximum number of frames queued for the frame callback of a specific stream
+        /// \param[in] stream  Native stream
+        /// \return            Queue depth, 0 if the callback is invoked on the capturing thread
+        int get_stream_callback_queue_depth(stream stream) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_stream_callback_queue_depth((const rs_device *)this, (rs_stream)stream, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Retrieves how many frames of a specific stream were discarded from the queue of its frame callback since the device was last started
+        /// \param[in] stream  Native stream
+        /// \return            Number of frames
+        unsigned long long get_stream_callback_drops(stream stream) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_stream_callback_drops((const rs_device *)this, (rs_stream)stream, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Adds a subscriber to the frames of a stream, handed a reference of its own to every frame alongside the frame callback and any other subscriber
+        /// \param[in] stream         Native stream
+        /// \param[in] frame_handler  Callback invoked on every new frame
+        /// \param[in] depth          Maximum number of frames queued for the subscriber on a thread of its own, between 1 and 16, or 0 to invoke it on the capturing thread
+        /// \param[in] policy         Frame discarded once its queue is full
+        /// \return                   Identifier of the subscriber
+        int add_frame_subscriber(stream stream, std::function<void(frame)> frame_handler, int depth = 0, frame_drop_policy policy = frame_drop_policy::drop_oldest)
+        {
+            rs_error * e = nullptr;
+            auto r = rs_add_frame_subscriber_cpp((rs_device *)this, (rs_stream)stream, new frame_callback(frame_handler), depth, (rs_frame_drop_policy)policy, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Removes a subscriber added by add_frame_subscriber(), while the device is stopped
+        /// \param[in] stream      Native stream
+        /// \param[in] subscriber  Identifier of the subscriber
+        void remove_frame_subscriber(stream stream, int subscriber)
+        {
+            rs_error * e = nullptr;
+            rs_remove_frame_subscriber((rs_device *)this, (rs_stream)stream, subscriber, &e);
+            error::handle(e);
+        }
+
+        /// \brief Retrieves how many frames were discarded from the queue of a subscriber since the device was last started
+        /// \param[in] stream      Native stream
+        /// \param[in] subscriber  Identifier of the subscriber
+        /// \return                Number of frames
+        unsigned long long get_frame_subscriber_drops(stream stream, int subscriber) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_frame_subscriber_drops((const rs_device *)this, (rs_stream)stream, subscriber, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Starts a specific stream on demand: it only runs while its frames are consumed, and is turned off once they were not for the timeout
+        /// \param[in] stream        Native stream
+        /// \param[in] milliseconds  Time the stream stays on without being consumed, or 0 to run it for as long as the device streams
+        void set_stream_idle_timeout(stream stream, int milliseconds)
+        {
+            rs_error * e = nullptr;
+            rs_set_stream_idle_timeout((rs_device *)this, (rs_stream)stream, milliseconds, &e);
+            error::handle(e);
+        }
+
+        /// \brief Retrieves the idle timeout of a specific stream
+        /// \param[in] stream  Native stream
+        /// \return            Timeout in milliseconds, 0 if the stream runs for as long as the device streams
+        int get_stream_idle_timeout(stream stream) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_stream_idle_timeout((const rs_device *)this, (rs_stream)stream, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Bounds the skew between a specific stream and the stream framesets are formed on, leaving it out of framesets it has no frame close enough for
+        /// \param[in] stream        Native stream
+        /// \param[in] milliseconds  Largest difference of timestamps matched, or 0 to match the nearest frame
+        void set_stream_sync_tolerance(stream stream, double milliseconds)
+        {
+            rs_error * e = nullptr;
+            rs_set_stream_sync_tolerance((rs_device *)this, (rs_stream)stream, milliseconds, &e);
+            error::handle(e);
+        }
+
+        /// \brief Retrieves the sync tolerance of a specific stream
+        /// \param[in] stream  Native stream
+        /// \return            Tolerance in milliseconds, 0 if the nearest frame is matched
+        double get_stream_sync_tolerance(stream stream) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_stream_sync_tolerance((const rs_device *)this, (rs_stream)stream, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Determines if a stream started on demand is currently turned off for lack of demand
+        /// \param[in] stream  Native stream
+        /// \return            true if the stream is off until it is consumed again
+        bool is_stream_idle(stream stream) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_is_stream_idle((const rs_device *)this, (rs_stream)stream, &e);
+            error::handle(e);
+            return r != 0;
+        }
+
+        /// \brief Retrieves the histogram of the time the frames of a stream took from the driver to a stage of their processing
+        /// \param[in] stream  Native stream
+        /// \param[in] stage   Time of the stage, from frame_metadata::time_of_validation to frame_metadata::time_of_delivery
+        /// \return            RS_LATENCY_HISTOGRAM_BIN_COUNT counts, bin i counting the frames which took from 2^(i-1) to 2^i microseconds
+        std::vector<unsigned long long> get_stream_latency_histogram(stream stream, frame_metadata stage) const
+        {
+            std::vector<unsigned long long> counts(RS_LATENCY_HISTOGRAM_BIN_COUNT);
+            rs_error * e = nullptr;
+            rs_get_stream_latency_histogram((const rs_device *)this, (rs_stream)stream, (rs_frame_metadata)stage, counts.data(), &e);
+            error::handle(e);
+            return counts;
+        }
+
+        /// \brief Retrieves the histogram of the time the frames of a stream took from their exposure to the application
+        /// \param[in] stream  Native stream
+        /// \return            RS_LATENCY_HISTOGRAM_BIN_COUNT counts, bin i counting the frames which took from 2^(i-1) to 2^i microseconds
+        std::vector<unsigned long long> get_stream_exposure_latency_histogram(stream stream) const
+        {
+            std::vector<unsigned long long> counts(RS_LATENCY_HISTOGRAM_BIN_COUNT);
+            rs_error * e = nullptr;
+            rs_get_stream_exposure_latency_histogram((const rs_device *)this, (rs_stream)stream, counts.data(), &e);
+            error::handle(e);
+            return counts;
+        }
+
+        /// \brief Clears the latency histograms of every stream
+        void reset_latency_histograms()
+        {
+            rs_error * e = nullptr;
+            rs_reset_latency_histograms((rs_device *)this, &e);
+            error::handle(e);
+        }
+
+        /// \brief Retrieves a counter of what happened to the frames of a stream since the device was created, without blocking streaming
+        /// \param[in] stream  Native stream
+        /// \param[in] metric  Counter to retrieve
+        /// \return            Value of the counter
+        unsigned long long get_stream_metric(stream stream, stream_metric metric) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_stream_metric((const rs_device *)this, (rs_stream)stream, (rs_stream_metric)metric, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Retrieves a counter of the transfers of the USB interface a stream is captured from, since the device last started streaming
+        /// \param[in] stream     Native stream
+        /// \param[in] statistic  Counter to retrieve
+        /// \return               Value of the counter
+        unsigned long long get_transfer_statistic(stream stream, transfer_statistic statistic) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_transfer_statistic((const rs_device *)this, (rs_stream)stream, (rs_transfer_statistic)statistic, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Sets the actions the device takes, one more at a time, while the application falls behind its streams
+        /// \param[in] actions  Actions in the order they are taken, each listed once at most, none to never shed load
+        void set_load_shedding(const std::vector<load_shedding_action> & actions)
+        {
+            rs_error * e = nullptr;
+            rs_set_load_shedding((rs_device *)this, (const rs_load_shedding_action *)actions.data(), (int)actions.size(), &e);
+            error::handle(e);
+        }
+
+        /// \brief Retrieves how many of the actions set by set_load_shedding() the device is currently taking
+        /// \return  Number of actions taken, the first ones of the list, 0 while the application keeps up
+        int get_load_shedding_level() const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_load_shedding_level((const rs_device *)this, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Retrieves how many bytes of frame memory the device holds, and the most it has held since it was created
+        /// \param[out] current  Bytes held now
+        /// \param[out] peak     Most bytes held at once
+        void get_memory_usage(unsigned long long & current, unsigned long long & peak) const
+        {
+            rs_error * e = nullptr;
+            rs_get_memory_usage((const rs_device *)this, &current, &peak, &e);
+            error::handle(e);
+        }
+
+        /// \brief Caps the frame memory the device holds by keeping fewer frames while above it, also while streaming
+        /// \param[in] bytes  Budget, 0 for none
+        void set_memory_budget(unsigned long long bytes)
+        {
+            rs_error * e = nullptr;
+            rs_set_memory_budget((rs_device *)this, bytes, &e);
+            error::handle(e);
+        }
+
+        /// \brief Retrieves the frame memory budget of the device
+        /// \return  Budget in bytes, 0 for none
+        unsigned long long get_memory_budget() const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_memory_budget((const rs_device *)this, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Writes the firmware log data read from the device while option::hardware_logger_enabled was set to a file
+        /// \param[in] file_path  The file to write, replaced if it exists, with records of a little-endian 32 bit count of bytes followed by the bytes
+        void export_fw_log(const char * file_path) const
+        {
+            rs_error * e = nullptr;
+            rs_export_fw_log((const rs_device *)this, file_path, &e);
+            error::handle(e);
+        }
+
+        ///  \brief Retrieves width, in pixels, of a specific stream, equivalent to the width field from the stream's intrinsic
+        /// \param[in] stream  Stream 
+        /// \return            Width, in pixels of images from this stream
+        int get_stream_width(stream stream) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_stream_width((const rs_device *)this, (rs_stream)stream, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Retrieves height, in pixels, of a specific stream, equivalent to the height field from the stream's intrinsic
+        /// \param[in] stream  Stream
+        /// \return            Height, in pixels of images from this stream
+        int get_stream_height(stream stream) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_stream_height((const rs_device *)this, (rs_stream)stream, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Retrieves pixel format for specific stream
+        /// \param[in] stream  Stream
+        /// \return            Pixel format of the stream
+        format get_stream_format(stream stream) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_stream_format((const rs_device *)this, (rs_stream)stream, &e);
+            error::handle(e);
+            return (format)r;
+        }
+
+        /// \brief Retrieves frame rate for specific stream
+        /// \param[in] stream  Stream
+        /// \return            Frame rate of the stream, in frames per second
+        int get_stream_framerate(stream stream) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_stream_framerate((const rs_device *)this, (rs_stream)stream, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Retrieves intrinsic camera parameters for specific stream
+        /// \param[in] stream  Stream
+        /// \return            Intrinsic parameters of the stream
+        intrinsics get_stream_intrinsics(stream stream) const
+        {
+            rs_error * e = nullptr;
+            intrinsics intrin;
+            rs_get_stream_intrinsics((const rs_device *)this, (rs_stream)stream, &intrin, &e);
+            error::handle(e);
+            return intrin;
+        }
+
+        /// \brief Retrieves intrinsic camera parameters for a level of the depth pyramid
+        /// \param[in] level  Level of the pyramid, 0 being the depth stream itself
+        /// \return           Intrinsic parameters of the level
+        intrinsics get_depth_pyramid_intrinsics(int level) const
+        {
+            rs_error * e = nullptr;
+            intrinsics intrin;
+            rs_get_depth_pyramid_intrinsics((const rs_device *)this, level, &intrin, &e);
+            error::handle(e);
+            return intrin;
+        }
+
+        /// \brief Retrieves intrinsic camera parameters for motion module
+        /// \return            Intrinsic parameters
+        motion_intrinsics get_motion_intrinsics() const
+        {
+            rs_error * e = nullptr;
+            motion_intrinsics intrinsics;
+            rs_get_motion_intrinsics((const rs_device *)this, &intrinsics, &e);
+            error::handle(e);
+            return intrinsics;
+        }
+
+        /// \brief Sets callback for frame arrival event. 
+		/// 
+		/// The provided callback will be called the instant new frame of given stream becomes available
+        /// once callback is set on certain stream type, frames of this type will no longer be available throuhg wait/poll methods (those two approaches are mutually exclusive) 
         /// while wait/poll methods provide consistent set of syncronized frames at the expense of extra latency,
         /// set frame callbacks provides low latency solution with no syncronization
         /// \param[in] stream         Stream 
@@ -821,6 +1634,58 @@ namespace rs
             error::handle(e);
         }
 
+        /// \brief Hands the rows of every frame of a Z16 stream to a callback as the camera sends them, ahead of the frame itself
+        ///
+        /// The callback is invoked from a thread of the library receiving the transfers of the device, with rows which are only valid for the
+        /// duration of the call. Must be called before start().
+        /// \param[in] stream          Native stream sent as Z16
+        /// \param[in] rows_per_slice  Rows of each slice, the last slice of a frame having the rows left over
+        /// \param[in] slice_handler   Callback receiving row_count rows of width depth values from row first_row, or an empty function to stop slicing
+        void set_slice_callback(rs::stream stream, int rows_per_slice, std::function<void(const uint16_t * rows, int width, int first_row, int row_count)> slice_handler)
+        {
+            rs_error * e = nullptr;
+            rs_set_stream_slice_callback_cpp((rs_device *)this, (rs_stream)stream, rows_per_slice, slice_handler ? new slice_callback(slice_handler) : nullptr, &e);
+            error::handle(e);
+        }
+
+        /// \brief Encodes every frame of a stream into H.264 on a hardware video encoder, and hands the packets to a callback
+        ///
+        /// The stream must be enabled as format::nv12 or format::i420, whose frames are encoded from the buffers they were unpacked into.
+        /// Requires a library built with BUILD_WITH_FFMPEG. Must be called before start().
+        /// \param[in] stream          Native stream
+        /// \param[in] bitrate         Bits per second of the encoding
+        /// \param[in] packet_handler  Callback receiving the packets with the metadata of their frames, or an empty function to stop encoding
+        void set_encoder(rs::stream stream, int bitrate, std::function<void(const rs_encoded_packet & packet)> packet_handler)
+        {
+            rs_error * e = nullptr;
+            rs_set_stream_encoder_cpp((rs_device *)this, (rs_stream)stream, bitrate, packet_handler ? new encoded_packet_callback(packet_handler) : nullptr, &e);
+            error::handle(e);
+        }
+
+        /// \brief Sets callback for synchronized frameset arrival
+        ///
+        /// The provided callback will be called from a library thread as soon as wait_for_frames() could have returned a new frameset.
+        /// Streams with their own frame callback do not take part. Must be called before start().
+        /// \param[in] frameset_handler  Frameset callback to be invoked on every synchronized frameset
+        void set_frameset_callback(std::function<void(frameset)> frameset_handler)
+        {
+            rs_error * e = nullptr;
+            rs_set_frameset_callback_cpp((rs_device *)this, new frameset_callback(frameset_handler), &e);
+            error::handle(e);
+        }
+
+        /// \brief Provides the memory used for frame buffers, for example pinned, huge-page or GPU-mapped memory
+        ///
+        /// Buffers are obtained when streaming starts and recycled between frames. Must be called before start().
+        /// \param[in] allocate    Returns a block of at least the requested size, or null on failure
+        /// \param[in] deallocate  Receives back a block previously returned by allocate, together with its size
+        void set_frame_allocator(std::function<void *(size_t)> allocate, std::function<void(void *, size_t)> deallocate)
+        {
+            rs_error * e = nullptr;
+            rs_set_frame_allocator_cpp((rs_device *)this, new frame_allocator(allocate, deallocate), &e);
+            error::handle(e);
+        }
+
         ///  \brief Sets callback for motion module event. 
 		/// 
 		///  The provided callback will be called the instant new motion or timestamp event is available. 
@@ -857,6 +1722,17 @@ namespace rs
             error::handle(e);
         }
 
+        /// \brief Sets the callback receiving the motion and timestamp events of every USB transfer from the motion module at once
+        ///
+        /// The arrays are only valid for the duration of the call. Replaces the handlers given to enable_motion_tracking(), and is replaced by them.
+        /// \param[in] events_handler     Callback to be invoked with the events of every transfer
+        void enable_motion_tracking_batched(std::function<void(const motion_data * motion, int motion_count, const timestamp_data * timestamps, int timestamp_count)> events_handler)
+        {
+            rs_error * e = nullptr;
+            rs_enable_motion_tracking_batched_cpp((rs_device *)this, new motion_batch_callback(events_handler), &e);
+            error::handle(e);
+        }
+
         /// \brief Disables events polling
         void disable_motion_tracking(void)
         {
@@ -874,6 +1750,171 @@ namespace rs
             return result;
         }
 
+        /// \brief Retrieves the motion sample of a sensor at a given timestamp, interpolated from the history kept while motion tracking is active
+        /// \param[in] source     event::event_imu_accel or event::event_imu_gyro
+        /// \param[in] timestamp  Timestamp in milliseconds, in the microcontroller timestamp domain
+        /// \param[out] sample    Receives the interpolated sample
+        /// \return               true if sample was filled, false if timestamp is outside the history
+        bool get_motion_sample_at(event source, double timestamp, motion_data & sample) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_motion_sample_at((const rs_device *)this, (rs_event_source)source, timestamp, &sample, &e);
+            error::handle(e);
+            return r != 0;
+        }
+
+        /// \brief Retrieves the motion samples of a sensor received within a time interval, oldest first
+        /// \param[in] source     event::event_imu_accel or event::event_imu_gyro
+        /// \param[in] from       Start of the interval in milliseconds, in the microcontroller timestamp domain
+        /// \param[in] to         End of the interval, included
+        /// \return               Samples of the interval
+        std::vector<motion_data> get_motion_samples(event source, double from, double to) const
+        {
+            rs_error * e = nullptr;
+            std::vector<motion_data> samples(64);
+            while (true)
+            {
+                auto count = rs_get_motion_samples((const rs_device *)this, (rs_event_source)source, from, to, samples.data(), (int)samples.size(), &e);
+                error::handle(e);
+                if (count <= (int)samples.size())
+                {
+                    samples.resize(count);
+                    return samples;
+                }
+                samples.resize(count);
+            }
+        }
+
+        /// \brief Starts recording the native frames of the device, along with their timestamps and the motion data, without holding up capture
+        /// \param[in] path  File to create
+        void start_recording(const char * path)
+        {
+            rs_error * e = nullptr;
+            rs_start_recording((rs_device *)this, path, &e);
+            error::handle(e);
+        }
+
+        /// \brief Stops recording, once the frames recorded so far are written to the file
+        void stop_recording()
+        {
+            rs_error * e = nullptr;
+            rs_stop_recording((rs_device *)this, &e);
+            error::handle(e);
+        }
+
+        /// \brief Retrieves how many frames and motion data transfers were left out of the current recording, for lack of free memory to hold them
+        /// \return  Number of frames and transfers
+        unsigned long long get_recording_drops() const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_recording_drops((const rs_device *)this, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Starts publishing the native frames of the device and its motion data to other processes, through a ring in shared memory
+        /// \param[in] name        Name of the ring, listed by subscribers in RS_PLAYBACK_RINGS
+        /// \param[in] slot_count  Number of slots of the ring, each fitting the largest native frame of the device
+        void start_publishing(const char * name, int slot_count = 16)
+        {
+            rs_error * e = nullptr;
+            rs_start_publishing((rs_device *)this, name, slot_count, &e);
+            error::handle(e);
+        }
+
+        /// \brief Stops publishing, removing the ring
+        void stop_publishing()
+        {
+            rs_error * e = nullptr;
+            rs_stop_publishing((rs_device *)this, &e);
+            error::handle(e);
+        }
+
+        /// \brief Starts keeping the native frames of the last seconds of capture in memory, compressing depth
+        /// \param[in] seconds    Duration of the history
+        /// \param[in] max_bytes  Memory the frames of the history may take at most
+        void start_frame_history(double seconds, unsigned long long max_bytes)
+        {
+            rs_error * e = nullptr;
+            rs_start_frame_history((rs_device *)this, seconds, max_bytes, &e);
+            error::handle(e);
+        }
+
+        /// \brief Stops keeping a frame history, releasing its frames
+        void stop_frame_history()
+        {
+            rs_error * e = nullptr;
+            rs_stop_frame_history((rs_device *)this, &e);
+            error::handle(e);
+        }
+
+        /// \brief Writes the frames of the frame history around a timestamp to a recording
+        /// \param[in] path       File to create
+        /// \param[in] timestamp  Timestamp of interest
+        /// \param[in] before     Milliseconds of frames to write before timestamp
+        /// \param[in] after      Milliseconds of frames to write after timestamp
+        /// \return               Number of frames written
+        int dump_frame_history(const char * path, double timestamp, double before, double after) const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_dump_frame_history((const rs_device *)this, path, timestamp, before, after, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Retrieves the memory taken by the frames of the frame history
+        /// \return  Bytes of the frames held
+        unsigned long long get_frame_history_size() const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_frame_history_size((const rs_device *)this, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Sets when a device replaying a recording delivers its next frame
+        /// \param[in] pacing  How frames are paced
+        void set_playback_pacing(playback_pacing pacing)
+        {
+            rs_error * e = nullptr;
+            rs_set_playback_pacing((rs_device *)this, (rs_playback_pacing)pacing, &e);
+            error::handle(e);
+        }
+
+        /// \brief Delivers the next frame of a device replaying a recording with playback_pacing::step
+        /// \return  false once the end of the recording is reached
+        bool step_playback()
+        {
+            rs_error * e = nullptr;
+            auto r = rs_step_playback((rs_device *)this, &e);
+            error::handle(e);
+            return r != 0;
+        }
+
+        /// \brief Moves a device replaying a recording to the first frame of a stream whose frame number is at least that given
+        /// \param[in] stream        Native stream whose frame numbers are compared
+        /// \param[in] frame_number  Frame number of the frame sought
+        /// \return                  false if no later frame of the stream was recorded, playback staying where it is
+        bool seek_playback_to_frame(stream stream, unsigned long long frame_number)
+        {
+            rs_error * e = nullptr;
+            auto r = rs_seek_playback_to_frame((rs_device *)this, (rs_stream)stream, frame_number, &e);
+            error::handle(e);
+            return r != 0;
+        }
+
+        /// \brief Moves a device replaying a recording to the first frame of a stream whose timestamp is at least that given
+        /// \param[in] stream     Native stream whose frame timestamps are compared
+        /// \param[in] timestamp  Timestamp of the frame sought, in milliseconds
+        /// \return               false if no later frame of the stream was recorded, playback staying where it is
+        bool seek_playback_to_time(stream stream, double timestamp)
+        {
+            rs_error * e = nullptr;
+            auto r = rs_seek_playback_to_time((rs_device *)this, (rs_stream)stream, timestamp, &e);
+            error::handle(e);
+            return r != 0;
+        }
+
 
         /// \brief Begins streaming on all enabled streams for this device
         void start(rs::source source = rs::source::video)
@@ -891,6 +1932,32 @@ namespace rs
             error::handle(e);
         }
 
+        /// \brief Turns the video streams off, keeping their modes and buffers so that resume() starts them again at once
+        void pause()
+        {
+            rs_error * e = nullptr;
+            rs_pause_device((rs_device *)this, &e);
+            error::handle(e);
+        }
+
+        /// \brief Turns the video streams of a paused device on again
+        void resume()
+        {
+            rs_error * e = nullptr;
+            rs_resume_device((rs_device *)this, &e);
+            error::handle(e);
+        }
+
+        /// \brief Determines if the video streams are paused
+        /// \return  true if device was paused and not resumed or stopped since
+        bool is_paused() const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_is_device_paused((const rs_device *)this, &e);
+            error::handle(e);
+            return r != 0;
+        }
+
         /// \brief Determines if device is currently streaming
         /// \return  true if device is currently streaming
         bool is_streaming() const
@@ -948,6 +2015,47 @@ namespace rs
             error::handle(e);
         }
 
+        /// \brief Holds back the options written to the device until commit_options(), which writes them at once
+        void begin_options()
+        {
+            rs_error * e = nullptr;
+            rs_begin_device_options((rs_device *)this, &e);
+            error::handle(e);
+        }
+
+        /// \brief Writes the latest value of every option set since begin_options(), using minimal hardware IO
+        void commit_options()
+        {
+            rs_error * e = nullptr;
+            rs_commit_device_options((rs_device *)this, &e);
+            error::handle(e);
+        }
+
+        /// \brief Sets value of arbitrary number of options without waiting for the hardware IO
+        ///
+        /// Writes still waiting their turn are merged with the ones that follow, so that only the latest values are written
+        /// \param[in] options      Array of options that should be set
+        /// \param[in] count        Length of options and values arrays
+        /// \param[in] values       Array of values to which the options should be set
+        /// \param[in] on_complete  Invoked from a library thread with the values written, and a null error message unless they could not be
+        void set_options_async(const option * options, size_t count, const double * values, std::function<void(const option *, size_t, const double *, const char *)> on_complete = nullptr)
+        {
+            rs_error * e = nullptr;
+            rs_set_device_options_async_cpp((rs_device *)this, (const rs_option *)options, (unsigned int)count, values, on_complete ? new options_callback(on_complete) : nullptr, &e);
+            error::handle(e);
+        }
+
+        /// \brief Retrieves value of arbitrary number of options without waiting for the hardware IO, in order with asynchronous writes
+        /// \param[in] options      Array of options that should be queried
+        /// \param[in] count        Length of the options array
+        /// \param[in] on_complete  Invoked from a library thread with the values read, and a null error message unless they could not be
+        void get_options_async(const option * options, size_t count, std::function<void(const option *, size_t, const double *, const char *)> on_complete)
+        {
+            rs_error * e = nullptr;
+            rs_get_device_options_async_cpp((rs_device *)this, (const rs_option *)options, (unsigned int)count, new options_callback(on_complete), &e);
+            error::handle(e);
+        }
+
         /// \brief Retrieves current value of single option
         /// \param[in] option  Option
         /// \return            Option value
@@ -999,6 +2107,38 @@ namespace rs
             return r != 0;
         }
 
+        /// \brief Blocks until new frames are available or the timeout expires
+        /// \param[in] timeout_ms  Maximum time to wait, in milliseconds
+        /// \return                true if new frames were obtained; false if the timeout expired.
+        bool wait_for_frames(unsigned int timeout_ms)
+        {
+            rs_error * e = nullptr;
+            auto r = rs_wait_for_frames_timeout((rs_device *)this, timeout_ms, &e);
+            error::handle(e);
+            return r != 0;
+        }
+
+        /// \brief Retrieves an OS object that is signaled while new frames are available
+        /// \return  Event HANDLE on Windows, a readable file descriptor stored in the pointer value elsewhere. Owned by the device.
+        void * get_frames_ready_handle()
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_frames_ready_handle((rs_device *)this, &e);
+            error::handle(e);
+            return r;
+        }
+
+        /// \brief Takes the latest frame of a stream, with RS_OPTION_FRAME_MAILBOX_ENABLED set, without blocking
+        /// \param[in] stream  Native stream of interest
+        /// \return            The frame, or an empty frame if none arrived since the last call
+        frame get_latest_frame(stream stream)
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_latest_frame((rs_device *)this, (rs_stream)stream, &e);
+            error::handle(e);
+            return frame((rs_device *)this, r);
+        }
+
         /// \brief Determines device capabilities
         /// \param[in] capability  Capability to check
         /// \return                true if device has this capability
@@ -1065,8 +2205,162 @@ namespace rs
             rs_send_blob_to_device((rs_device *)this, (rs_blob_type)type, data, size, &e);
             error::handle(e);
         }
+
+        /// \brief Sends device-specific data to device, reporting progress while it is transferred
+        /// \param[in] type         Type of raw data to send to the device
+        /// \param[in] data         Raw data pointer to send
+        /// \param[in] size         Size, in bytes of the raw data to send
+        /// \param[in] on_progress  Called with the bytes sent so far and the size of the data, before this call returns
+        void send_blob_to_device(rs::blob_type type, void * data, int size, std::function<void(int bytes_sent, int size)> on_progress)
+        {
+            rs_error * e = nullptr;
+            rs_send_blob_to_device_with_progress((rs_device *)this, (rs_blob_type)type, data, size, [](rs_device *, int bytes_sent, int total, void * user)
+            {
+                (*static_cast<std::function<void(int, int)> *>(user))(bytes_sent, total);
+            }, &on_progress, &e);
+            error::handle(e);
+        }
     };
 
+    class multi_frameset_callback : public rs_multi_frameset_callback
+    {
+        std::function<void(std::vector<frameset>)> on_framesets_function;
+    public:
+        explicit multi_frameset_callback(std::function<void(std::vector<frameset>)> on_framesets) : on_framesets_function(on_framesets) {}
+
+        void on_framesets(rs_device * const * devices, rs_frameset * const * framesets, int count) override
+        {
+            std::vector<frameset> sets;
+            for (int i = 0; i < count; ++i) sets.push_back(framesets[i] ? frameset(devices[i], framesets[i]) : frameset());
+            on_framesets_function(std::move(sets));
+        }
+
+        void release() override { delete this; }
+    };
+
+    /// \brief Matches the framesets of several devices by timestamp, and calls back with every matched set
+    class multi_sync
+    {
+        rs_multi_sync * handle;
+        multi_sync(const multi_sync &) = delete;
+        multi_sync & operator = (const multi_sync &) = delete;
+    public:
+        /// \brief Sets the frameset callback of every device, which must be configured but not started yet
+        /// \param[in] devices       Devices to synchronize
+        /// \param[in] tolerance     Largest difference between the timestamps of a matched set, in milliseconds
+        /// \param[in] policy        What becomes of incomplete sets
+        /// \param[in] on_framesets  Receives every set, one frameset per device in the order of devices, empty for the devices missing from a partial set
+        multi_sync(const std::vector<device *> & devices, double tolerance, straggler_policy policy, std::function<void(std::vector<frameset>)> on_framesets)
+        {
+            rs_error * e = nullptr;
+            handle = rs_create_multi_sync_cpp((rs_device * const *)devices.data(), (int)devices.size(), tolerance, (rs_straggler_policy)policy, new multi_frameset_callback(on_framesets), &e);
+            error::handle(e);
+        }
+
+        /// \brief Releases the framesets still waiting for a match, must happen before the devices are started again
+        ~multi_sync()
+        {
+            rs_delete_multi_sync(handle, nullptr);
+        }
+    };
+
+    /// \brief Fits the streams of devices sharing a USB host controller within its bandwidth, lowering those left open by their requests
+    /// \param[in] devices               Devices to plan, which must be configured but not started yet
+    /// \param[in] controller_bandwidth  Bandwidth available to the streams of each host controller, in megabytes per second
+    inline void plan_device_modes(const std::vector<device *> & devices, double controller_bandwidth)
+    {
+        rs_error * e = nullptr;
+        rs_plan_device_modes((rs_device * const *)devices.data(), (int)devices.size(), controller_bandwidth, &e);
+        error::handle(e);
+    }
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+    /// \brief Resumes coroutines awaiting the frames of any number of devices, all from the one thread running it
+    ///
+    /// Coroutines await next_frameset() where they would call wait_for_frames(), and read the frames of the device once resumed. The scheduler
+    /// waits on the frames ready handles of the devices, so that no thread blocks per device and no frame callback nests the code of the
+    /// application. Any coroutine type can await it. An event loop of its own, such as asio, can wait on get_frames_ready_handle() instead,
+    /// and call run_once(0) once a handle is signaled.
+    class frame_scheduler
+    {
+        struct waiter
+        {
+            device *                dev;
+            std::coroutine_handle<> coroutine;
+        };
+        std::vector<waiter> waiters;
+
+        int resume_ready()
+        {
+            // Resuming a coroutine may suspend it again, or others, so that the ready ones are taken out first
+            std::vector<std::coroutine_handle<>> ready;
+            for (auto it = waiters.begin(); it != waiters.end(); )
+            {
+                if (it->dev->poll_for_frames())
+                {
+                    ready.push_back(it->coroutine);
+                    it = waiters.erase(it);
+                }
+                else ++it;
+            }
+            for (auto & coroutine : ready) coroutine.resume();
+            return (int)ready.size();
+        }
+
+    public:
+        /// \brief Resumes the coroutine once the device has a new frameset
+        class frameset_awaiter
+        {
+            frame_scheduler & scheduler;
+            device & dev;
+        public:
+            frameset_awaiter(frame_scheduler & scheduler, device & dev) : scheduler(scheduler), dev(dev) {}
+            bool await_ready() { return dev.poll_for_frames(); }
+            void await_suspend(std::coroutine_handle<> coroutine) { scheduler.waiters.push_back({ &dev, coroutine }); }
+            void await_resume() const {}
+        };
+
+        frame_scheduler() = default;
+        frame_scheduler(const frame_scheduler &) = delete;
+        frame_scheduler & operator = (const frame_scheduler &) = delete;
+
+        /// \brief Awaits the next frameset of a streaming device, whose frames are then read from the device as after wait_for_frames()
+        /// \param[in] dev  Device to await
+        /// \return         Awaitable completing without suspending if a frameset is already pending
+        frameset_awaiter next_frameset(device & dev) { return frameset_awaiter(*this, dev); }
+
+        /// \brief Retrieves how many coroutines await frames
+        size_t pending() const { return waiters.size(); }
+
+        /// \brief Waits until frames arrive for some of the coroutines awaiting them, or the timeout expires, and resumes those in the order they suspended
+        /// \param[in] timeout_ms  Longest wait, in milliseconds, 0 to resume only those whose frames already arrived, or -1 to wait for frames
+        /// \return                Number of coroutines resumed
+        int run_once(int timeout_ms)
+        {
+            // Frames which arrived before the handles were first retrieved do not signal them, so that the devices are polled before waiting
+            auto resumed = resume_ready();
+            if (resumed || waiters.empty() || timeout_ms == 0) return resumed;
+
+            // Any of the handles being signaled ends the wait, after which every device is polled, since several may have frames by then
+#ifdef _WIN32
+            std::vector<HANDLE> handles;
+            for (auto & w : waiters) if (handles.size() < MAXIMUM_WAIT_OBJECTS) handles.push_back((HANDLE)w.dev->get_frames_ready_handle());
+            if (waiters.size() > handles.size() && (timeout_ms < 0 || timeout_ms > 1)) timeout_ms = 1; // The others are polled every millisecond
+            auto status = WaitForMultipleObjects((DWORD)handles.size(), handles.data(), FALSE, timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms);
+            if (status == WAIT_FAILED) throw std::runtime_error("WaitForMultipleObjects(...) failed while awaiting frames");
+#else
+            std::vector<pollfd> fds;
+            for (auto & w : waiters) fds.push_back({ (int)(intptr_t)w.dev->get_frames_ready_handle(), POLLIN, 0 });
+            if (poll(fds.data(), (nfds_t)fds.size(), timeout_ms) < 0 && errno != EINTR) throw std::runtime_error("poll(...) failed while awaiting frames");
+#endif
+            return resume_ready();
+        }
+
+        /// \brief Resumes coroutines as their frames arrive, until none awaits frames, so that devices which stopped streaming must not be awaited
+        void run() { while (!waiters.empty()) run_once(-1); }
+    };
+#endif
+
     inline std::ostream & operator << (std::ostream & o, stream stream) { return o << rs_stream_to_string((rs_stream)stream); }
     inline std::ostream & operator << (std::ostream & o, format format) { return o << rs_format_to_string((rs_format)format); }
     inline std::ostream & operator << (std::ostream & o, preset preset) { return o << rs_preset_to_string((rs_preset)preset); }
@@ -1122,6 +2416,123 @@ namespace rs
         error::handle(e);
     }
 
+    /// Hands log messages to a background thread, each thread queueing up to queue_size of them, or logs synchronously again if queue_size is 0
+    inline void log_asynchronously(int queue_size)
+    {
+        rs_error * e = nullptr;
+        rs_log_asynchronously(queue_size, &e);
+        error::handle(e);
+    }
+
+    /// Retrieves the number of log messages dropped so far because the queue of their thread was full
+    inline unsigned long long get_dropped_log_messages()
+    {
+        rs_error * e = nullptr;
+        auto r = rs_get_dropped_log_messages(&e);
+        error::handle(e);
+        return r;
+    }
+
+    /// Keeps the calibration read from devices in files of a directory, so that devices opened again skip reading it
+    /// \param[in] directory  An existing directory, or null to stop using the cache
+    inline void set_calibration_cache_directory(const char * directory)
+    {
+        rs_error * e = nullptr;
+        rs_set_calibration_cache_directory(directory, &e);
+        error::handle(e);
+    }
+
+    /// Writes the spans recorded by libraries built with ENABLE_TRACING to a file, in the Chrome trace event format
+    /// \param[in] file_path  The file to write
+    inline void export_trace(const char * file_path)
+    {
+        rs_error * e = nullptr;
+        rs_export_trace(file_path, &e);
+        error::handle(e);
+    }
+
+    /// \brief Converts a disparity image to a Z16 depth image
+    /// \param[in] disparity_pixels  The disparity pixels to convert
+    /// \param[out] z_pixels         Receives count Z16 pixels
+    /// \param[in] count             The number of pixels to convert
+    /// \param[in] disparity_scale   The depth scale reported by the device while streaming disparity
+    /// \param[in] z_scale           The size of one Z16 unit, in meters
+    inline void convert_disparity_to_z16(const unsigned short * disparity_pixels, unsigned short * z_pixels, int count, float disparity_scale, float z_scale)
+    {
+        rs_error * e = nullptr;
+        rs_convert_disparity_to_z16(disparity_pixels, z_pixels, count, disparity_scale, z_scale, &e);
+        error::handle(e);
+    }
+
+    /// \brief Retrieves the size of the buffer encode_depth() requires for an image of pixel_count pixels
+    inline int get_encoded_depth_max_size(int pixel_count)
+    {
+        rs_error * e = nullptr;
+        auto r = rs_get_encoded_depth_max_size(pixel_count, &e);
+        error::handle(e);
+        return r;
+    }
+
+    /// \brief Losslessly compresses a Z16 depth image, typically three to five times
+    /// \param[in] depth_pixels  The Z16 pixels to encode
+    /// \param[in] pixel_count   The number of pixels to encode
+    /// \param[out] buffer       Receives the encoded image
+    /// \param[in] buffer_size   The size of buffer, at least get_encoded_depth_max_size(pixel_count)
+    /// \return                  The number of bytes of the encoded image
+    inline int encode_depth(const unsigned short * depth_pixels, int pixel_count, void * buffer, int buffer_size)
+    {
+        rs_error * e = nullptr;
+        auto r = rs_encode_depth(depth_pixels, pixel_count, buffer, buffer_size, &e);
+        error::handle(e);
+        return r;
+    }
+
+    /// \brief Restores a Z16 depth image encoded by encode_depth()
+    /// \param[in] data          The encoded image
+    /// \param[in] size          The number of bytes of the encoded image
+    /// \param[out] depth_pixels Receives pixel_count Z16 pixels
+    /// \param[in] pixel_count   The number of pixels of the image
+    inline void decode_depth(const void * data, int size, unsigned short * depth_pixels, int pixel_count)
+    {
+        rs_error * e = nullptr;
+        rs_decode_depth(data, size, depth_pixels, pixel_count, &e);
+        error::handle(e);
+    }
+
+    /// \brief Serves the cameras of this host over TCP to libraries built with the network backend, one client at a time, without authenticating them
+    class server
+    {
+        rs_server * handle;
+        server(const server &) = delete;
+        server & operator = (const server &) = delete;
+    public:
+        /// \brief Starts listening
+        /// \param[in] port     The TCP port to listen on, or 0 for any free port
+        /// \param[in] address  The address of the local interface to listen on, or null for loopback only, see rs_create_server()
+        explicit server(int port = 0, const char * address = nullptr)
+        {
+            rs_error * e = nullptr;
+            handle = rs_create_server(address, port, &e);
+            error::handle(e);
+        }
+
+        /// \brief Disconnects the client, whose devices stop streaming
+        ~server()
+        {
+            rs_delete_server(handle, nullptr);
+        }
+
+        /// \brief Retrieves the TCP port the server listens on
+        /// \return  The TCP port
+        int get_port() const
+        {
+            rs_error * e = nullptr;
+            auto r = rs_get_server_port(handle, &e);
+            error::handle(e);
+            return r;
+        }
+    };
+
     // Additional utilities
     inline void apply_depth_control_preset(device * device, int preset) { rs_apply_depth_control_preset((rs_device *)device, preset); }
     inline void apply_ivcam_preset(device * device, rs_ivcam_preset preset) { rs_apply_ivcam_preset((rs_device *)device, preset); }
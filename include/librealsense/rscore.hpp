@@ -45,6 +45,9 @@ struct rs_frame_ref
 {
     virtual                                 ~rs_frame_ref() {}
     virtual const uint8_t*                  get_frame_data() const = 0;
+    virtual const uint8_t*                  get_frame_strided_data(int & pixel_stride, int & row_stride) const = 0;
+    virtual const uint8_t*                  get_frame_pyramid_level(int level, int & width, int & height) const = 0;
+    virtual const uint32_t*                 get_frame_depth_runs() const = 0;
     virtual double                          get_frame_timestamp() const = 0;
     virtual rs_timestamp_domain             get_frame_timestamp_domain() const = 0;
     virtual unsigned long long              get_frame_number() const = 0;
@@ -56,6 +59,7 @@ struct rs_frame_ref
     virtual int                             get_frame_bpp() const = 0;
     virtual rs_format                       get_frame_format() const = 0;
     virtual rs_stream                       get_stream_type() const = 0;
+    virtual int                             get_frame_buffer_index() const = 0;
     virtual double                          get_frame_metadata(rs_frame_metadata frame_metadata) const = 0;
     virtual bool                            supports_frame_metadata(rs_frame_metadata frame_metadata) const = 0;
 };
@@ -75,10 +79,48 @@ struct rs_device
     virtual void                            enable_stream(rs_stream stream, int width, int height, rs_format format, int fps, rs_output_buffer_format output) = 0;
     virtual void                            enable_stream_preset(rs_stream stream, rs_preset preset) = 0;
     virtual void                            disable_stream(rs_stream stream) = 0;
+    virtual void                            set_stream_roi(rs_stream stream, int x, int y, int width, int height) = 0;
+    virtual void                            set_stream_decimation(rs_stream stream, int factor) = 0;
+    virtual void                            set_stream_queue_policy(rs_stream stream, int depth, rs_frame_drop_policy policy) = 0;
+    virtual void                            get_stream_queue_policy(rs_stream stream, int & depth, rs_frame_drop_policy & policy) const = 0;
+    virtual void                            set_stream_capture_dmabufs(rs_stream stream, const int fds[], int count) = 0;
+    virtual void                            set_stream_capture_buffer_count(rs_stream stream, int count) = 0;
+    virtual int                             get_stream_capture_buffer_count(rs_stream stream) const = 0;
+    virtual void                            set_stream_crop(rs_stream stream, int x, int y, int width, int height) = 0;
+    virtual bool                            is_stream_cropped_in_driver(rs_stream stream) const = 0;
+    virtual void                            set_stream_frame_buffers(rs_stream stream, void * const buffers[], int count, int buffer_size) = 0;
+    virtual void                            set_stream_callback_queue(rs_stream stream, int depth) = 0;
+    virtual int                             get_stream_callback_queue_depth(rs_stream stream) const = 0;
+    virtual unsigned long long              get_stream_callback_drops(rs_stream stream) const = 0;
+    virtual int                             add_frame_subscriber(rs_stream stream, rs_frame_callback * callback, int depth, rs_frame_drop_policy policy) = 0;
+    virtual void                            remove_frame_subscriber(rs_stream stream, int subscriber) = 0;
+    virtual unsigned long long              get_frame_subscriber_drops(rs_stream stream, int subscriber) const = 0;
+    virtual void                            set_stream_idle_timeout(rs_stream stream, int milliseconds) = 0;
+    virtual int                             get_stream_idle_timeout(rs_stream stream) const = 0;
+    virtual void                            set_stream_sync_tolerance(rs_stream stream, double milliseconds) = 0;
+    virtual double                          get_stream_sync_tolerance(rs_stream stream) const = 0;
+    virtual bool                            is_stream_idle(rs_stream stream) const = 0;
+    virtual void                            get_stream_latency_histogram(rs_stream stream, rs_frame_metadata stage, unsigned long long counts[]) const = 0;
+    virtual void                            get_stream_exposure_latency_histogram(rs_stream stream, unsigned long long counts[]) const = 0;
+    virtual void                            reset_latency_histograms() = 0;
+    virtual unsigned long long              get_stream_metric(rs_stream stream, rs_stream_metric metric) const = 0;
+    virtual unsigned long long              get_transfer_statistic(rs_stream stream, rs_transfer_statistic statistic) const = 0;
+    virtual void                            set_load_shedding(const rs_load_shedding_action actions[], int count) = 0;
+    virtual int                             get_load_shedding_level() const = 0;
+    virtual void                            get_memory_usage(unsigned long long & current, unsigned long long & peak) const = 0;
+    virtual void                            set_memory_budget(unsigned long long bytes) = 0;
+    virtual unsigned long long              get_memory_budget() const = 0;
+    virtual void                            export_fw_log(const char * file_path) const = 0;
                                             
     virtual void                            enable_motion_tracking() = 0;
     virtual void                            set_stream_callback(rs_stream stream, void(*on_frame)(rs_device * device, rs_frame_ref * frame, void * user), void * user) = 0;
     virtual void                            set_stream_callback(rs_stream stream, rs_frame_callback * callback) = 0;
+    virtual void                            set_frameset_callback(void(*on_frameset)(rs_device * device, rs_frameset * frames, void * user), void * user) = 0;
+    virtual void                            set_frameset_callback(rs_frameset_callback * callback) = 0;
+    virtual void                            set_stream_slice_callback(rs_stream stream, int rows_per_slice, void(*on_slice)(rs_device * device, const void * rows, int width, int first_row, int row_count, void * user), void * user) = 0;
+    virtual void                            set_stream_slice_callback(rs_stream stream, int rows_per_slice, rs_slice_callback * callback) = 0;
+    virtual void                            set_stream_encoder(rs_stream stream, int bitrate, void(*on_packet)(rs_device * device, rs_stream stream, rs_encoded_packet packet, void * user), void * user) = 0;
+    virtual void                            set_stream_encoder(rs_stream stream, int bitrate, rs_encoded_packet_callback * callback) = 0;
     virtual void                            disable_motion_tracking() = 0;
 
     virtual rs_motion_intrinsics            get_motion_intrinsics() const = 0;
@@ -87,18 +129,41 @@ struct rs_device
     virtual void                            set_motion_callback(rs_motion_callback * callback) = 0;
     virtual void                            set_timestamp_callback(void(*on_event)(rs_device * device, rs_timestamp_data data, void * user), void * user) = 0;
     virtual void                            set_timestamp_callback(rs_timestamp_callback * callback) = 0;
+    virtual void                            set_motion_batch_callback(void(*on_events)(rs_device * device, const rs_motion_data * motion, int motion_count, const rs_timestamp_data * timestamps, int timestamp_count, void * user), void * user) = 0;
+    virtual void                            set_motion_batch_callback(rs_motion_batch_callback * callback) = 0;
+    virtual bool                            get_motion_sample_at(rs_event_source source, double timestamp, rs_motion_data & sample) const = 0;
+    virtual size_t                          get_motion_samples(rs_event_source source, double from, double to, rs_motion_data samples[], size_t max_count) const = 0;
+    virtual void                            start_recording(const char * path) = 0;
+    virtual void                            stop_recording() = 0;
+    virtual unsigned long long              get_recording_drops() const = 0;
+    virtual void                            start_publishing(const char * name, int slot_count) = 0;
+    virtual void                            stop_publishing() = 0;
+    virtual void                            start_frame_history(double seconds, size_t max_bytes) = 0;
+    virtual void                            stop_frame_history() = 0;
+    virtual size_t                          dump_frame_history(const char * path, double from, double to) const = 0;
+    virtual size_t                          get_frame_history_size() const = 0;
+    virtual void                            set_playback_pacing(rs_playback_pacing pacing) = 0;
+    virtual bool                            step_playback() = 0;
+    virtual bool                            seek_playback_to_frame(rs_stream stream, unsigned long long frame_number) = 0;
+    virtual bool                            seek_playback_to_time(rs_stream stream, double timestamp) = 0;
                                             
     virtual void                            start(rs_source source) = 0;
     virtual void                            stop(rs_source source) = 0;
+    virtual void                            pause() = 0;
+    virtual void                            resume() = 0;
 
     virtual void                            start_fw_logger(char fw_log_op_code, int grab_rate_in_ms, std::timed_mutex& mutex) = 0;
     virtual void                            stop_fw_logger() = 0;
 
     virtual bool                            is_capturing() const = 0;
+    virtual bool                            is_paused() const = 0;
     virtual int                             is_motion_tracking_active() const = 0;
                                             
     virtual void                            wait_all_streams() = 0;
     virtual bool                            poll_all_streams() = 0;
+    virtual bool                            wait_all_streams(unsigned int timeout_ms) = 0;
+    virtual void *                          get_frames_ready_handle() = 0;
+    virtual rs_frame_ref *                  get_latest_frame(rs_stream stream) = 0;
                                             
     virtual bool                            supports(rs_capabilities capability) const = 0;
     virtual bool                            supports(rs_camera_info info_param) const = 0;
@@ -107,10 +172,22 @@ struct rs_device
     virtual void                            get_option_range(rs_option option, double & min, double & max, double & step, double & def) = 0;
     virtual void                            set_options(const rs_option options[], size_t count, const double values[]) = 0;
     virtual void                            get_options(const rs_option options[], size_t count, double values[]) = 0;
+    virtual void                            set_options_async(const rs_option options[], size_t count, const double values[], rs_options_callback * callback) = 0;
+    virtual void                            get_options_async(const rs_option options[], size_t count, rs_options_callback * callback) = 0;
+    virtual void                            begin_options() = 0;
+    virtual bool                            hold_options(const rs_option options[], size_t count, const double values[]) = 0; // False unless a transaction is open to record the writes
+    virtual void                            commit_options() = 0;
     virtual const char *                    get_option_description(rs_option option) const = 0;
 
     virtual void                            release_frame(rs_frame_ref * ref) = 0;
     virtual rs_frame_ref *                  clone_frame(rs_frame_ref * frame) = 0;
+    virtual rs_frame_ref *                  detach_frame(rs_frameset * frames, rs_stream stream) = 0;
+    virtual void                            release_frames(rs_frameset * frames) = 0;
+    virtual rs_frame_ref *                  process_frames(rs_stream stream, rs_frame_ref * const frames[], int count) = 0;
+    virtual rs_frame_ref *                  process_frameset(const rs_frameset * frames, rs_stream stream) = 0;
+    virtual int                             get_frameset_frame_info(const rs_frameset * frames, rs_frame_info * infos, int max_count) = 0;
+    virtual void                            set_frame_allocator(void *(*allocate)(int size, void * user), void(*deallocate)(void * ptr, int size, void * user), void * user) = 0;
+    virtual void                            set_frame_allocator(rs_frame_allocator * allocator) = 0;
 
     virtual const char *                    get_usb_port_id() const = 0;
 };
@@ -119,9 +196,20 @@ struct rs_context
 {
     virtual size_t                          get_device_count() const = 0;
     virtual rs_device *                     get_device(int index) const = 0;
+    virtual void                            set_devices_changed_callback(rs_devices_changed_callback * callback) = 0;
+    virtual void                            set_executor_threads(int count, uint64_t cpu_mask) = 0;
+    virtual int                             get_executor_thread_count() const = 0;
+    virtual uint64_t                        get_executor_cpu_mask() const = 0;
     virtual                                 ~rs_context() {}
 };
 
+struct rs_devices_changed_callback
+{
+    virtual void                            on_devices_changed(rs_context * context, rs_device * device, int connected) = 0;
+    virtual void                            release() = 0;
+    virtual                                 ~rs_devices_changed_callback() {}
+};
+
 struct rs_motion_callback
 {
     virtual void                            on_event(rs_motion_data e) = 0;
@@ -129,6 +217,13 @@ struct rs_motion_callback
     virtual                                 ~rs_motion_callback() {}
 };
 
+struct rs_motion_batch_callback
+{
+    virtual void                            on_events(const rs_motion_data * motion, int motion_count, const rs_timestamp_data * timestamps, int timestamp_count) = 0;
+    virtual void                            release() = 0;
+    virtual                                 ~rs_motion_batch_callback() {}
+};
+
 struct rs_frame_callback
 {
     virtual void                            on_frame(rs_device * device, rs_frame_ref * f) = 0;
@@ -136,6 +231,42 @@ struct rs_frame_callback
     virtual                                 ~rs_frame_callback() {}
 };
 
+struct rs_frameset_callback
+{
+    virtual void                            on_frameset(rs_device * device, rs_frameset * frames) = 0;
+    virtual void                            release() = 0;
+    virtual                                 ~rs_frameset_callback() {}
+};
+
+struct rs_slice_callback
+{
+    virtual void                            on_slice(rs_device * device, const void * rows, int width, int first_row, int row_count) = 0;
+    virtual void                            release() = 0;
+    virtual                                 ~rs_slice_callback() {}
+};
+
+struct rs_encoded_packet_callback
+{
+    virtual void                            on_packet(rs_device * device, rs_stream stream, rs_encoded_packet packet) = 0;
+    virtual void                            release() = 0;
+    virtual                                 ~rs_encoded_packet_callback() {}
+};
+
+struct rs_multi_frameset_callback
+{
+    virtual void                            on_framesets(rs_device * const * devices, rs_frameset * const * framesets, int count) = 0;
+    virtual void                            release() = 0;
+    virtual                                 ~rs_multi_frameset_callback() {}
+};
+
+struct rs_frame_allocator
+{
+    virtual void *                          allocate(size_t size) = 0;
+    virtual void                            deallocate(void * ptr, size_t size) = 0;
+    virtual void                            release() = 0;
+    virtual                                 ~rs_frame_allocator() {}
+};
+
 struct rs_timestamp_callback
 {
     virtual void                            on_event(rs_timestamp_data data) = 0;
@@ -143,6 +274,13 @@ struct rs_timestamp_callback
     virtual                                 ~rs_timestamp_callback() {}
 };
 
+struct rs_options_callback
+{
+    virtual void                            on_options(rs_device * device, const rs_option * options, unsigned int count, const double * values, const char * error_message) = 0;
+    virtual void                            release() = 0;
+    virtual                                 ~rs_options_callback() {}
+};
+
 struct rs_log_callback
 {
     virtual void                            on_event(rs_log_severity severity, const char * message) = 0;
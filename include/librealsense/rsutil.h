@@ -7,6 +7,8 @@
 #include "rs.h"
 #include "assert.h"
 
+/* For arrays of points, rs_project_points_to_pixels(...), rs_deproject_pixels_to_points(...) and rs_transform_points_to_points(...) of rs.h give the same results with vector instructions */
+
 /* Given a point in 3D space, compute the corresponding pixel coordinates in an image with no distortion or forward distortion coefficients produced by the same camera */
 static void rs_project_point_to_pixel(float pixel[2], const struct rs_intrinsics * intrin, const float point[3])
 {
@@ -122,7 +124,10 @@ static void rs_apply_ivcam_preset(rs_device * device, rs_ivcam_preset preset)
 
     // The Default preset is handled differntly from all the rest,
     // When the user applies the Default preset the camera is expected to return to
-    // Default values of depth options:
+    // Default values of depth options.
+    // The options go out together, unless the preset is applied within a transaction of the application, which then writes them on commit.
+    rs_error * nested = 0;
+    rs_begin_device_options(device, &nested);
     if(preset == RS_IVCAM_PRESET_DEFAULT)
     {
         rs_reset_device_options_to_default(device, arr_options, 15, 0);
@@ -133,6 +138,8 @@ static void rs_apply_ivcam_preset(rs_device * device, rs_ivcam_preset preset)
         if(arr_values[preset][13] != -1) rs_set_device_options(device, arr_options, 14, arr_values[preset], 0);
         else rs_set_device_options(device, arr_options, 11, arr_values[preset], 0);
     }
+    if(nested) rs_free_error(nested);
+    else rs_commit_device_options(device, 0);
 }
 
 #endif
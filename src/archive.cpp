@@ -1,11 +1,306 @@
 
 #include "archive.h"
+#include "image.h" // For get_image_size and pack_strided_samples
+#include "numa.h"
 #include <algorithm>
+#ifdef _WIN32
+#define NOMINMAX // Keeps std::min and std::max usable
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
 
 using namespace rsimpl;
 
-frame_archive::frame_archive(const std::vector<subdevice_mode_selection>& selection, std::atomic<uint32_t>* in_max_frame_queue_size, std::chrono::high_resolution_clock::time_point capture_started)
-    : max_frame_queue_size(in_max_frame_queue_size), mutex(), capture_started(capture_started)
+namespace
+{
+    // Buffers preallocated per stream on start, enough for the backbuffer, the sync queue and the frontbuffer in steady state
+    const int preallocated_buffers_per_stream = 4;
+
+    // Frame memory starts on a cache line, so that unpackers may use aligned vector loads and stores
+    const size_t frame_buffer_alignment = 64;
+
+    class heap_frame_allocator : public rs_frame_allocator
+    {
+    public:
+        void * allocate(size_t size) override
+        {
+            auto block = new (std::nothrow) byte[size + frame_buffer_alignment];
+            if (!block) return nullptr;
+            auto aligned = block + frame_buffer_alignment - (reinterpret_cast<uintptr_t>(block) % frame_buffer_alignment);
+            aligned[-1] = static_cast<byte>(aligned - block); // Offset always lies in [1, alignment]
+            return aligned;
+        }
+        void deallocate(void * ptr, size_t) override
+        {
+            auto aligned = static_cast<byte *>(ptr);
+            delete[] (aligned - aligned[-1]);
+        }
+        void release() override {}
+    };
+}
+
+std::shared_ptr<rs_frame_allocator> rsimpl::get_default_frame_allocator()
+{
+    static auto allocator = std::make_shared<heap_frame_allocator>();
+    return allocator;
+}
+
+void mapped_frame_allocator::fall_back_to(frame_memory_pages pages, const char * reason)
+{
+    int current = provided.load();
+    while (current > static_cast<int>(pages))
+    {
+        if (provided.compare_exchange_weak(current, static_cast<int>(pages)))
+        {
+            LOG_WARNING("Frame memory falls back from " << (current == static_cast<int>(frame_memory_pages::explicit_huge) ? "explicit" : "transparent") << " huge pages: " << reason);
+            return;
+        }
+    }
+}
+
+#if defined(__linux__)
+namespace
+{
+    const size_t huge_page_size = 2 << 20;
+    size_t get_mapping_size(size_t size, frame_memory_pages requested)
+    {
+        const size_t page_size = requested == frame_memory_pages::heap ? 4096 : huge_page_size;
+        return (size + page_size - 1) / page_size * page_size;
+    }
+}
+
+void * mapped_frame_allocator::allocate(size_t size)
+{
+    // The node is preferred before the pages are first touched, which is when they are placed
+    const size_t length = get_mapping_size(size, requested);
+    if (requested == frame_memory_pages::heap)
+    {
+        auto block = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block == MAP_FAILED) return nullptr;
+        if (numa_node >= 0) numa::prefer_node(block, length, numa_node);
+        return block;
+    }
+#ifdef MAP_HUGETLB
+    if (requested == frame_memory_pages::explicit_huge)
+    {
+        auto block = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (block != MAP_FAILED)
+        {
+            if (numa_node >= 0) numa::prefer_node(block, length, numa_node);
+            return block;
+        }
+        fall_back_to(frame_memory_pages::transparent_huge, "the system has no reserved huge page free, see /proc/sys/vm/nr_hugepages");
+    }
+#else
+    if (requested == frame_memory_pages::explicit_huge) fall_back_to(frame_memory_pages::transparent_huge, "the library was built without MAP_HUGETLB");
+#endif
+
+    // Transparent huge pages only back whole aligned huge pages, so a huge page more is mapped and the block is trimmed to a boundary
+    auto block = static_cast<byte *>(mmap(nullptr, length + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (block == MAP_FAILED) return nullptr;
+    const size_t head = (huge_page_size - reinterpret_cast<uintptr_t>(block) % huge_page_size) % huge_page_size;
+    if (head) munmap(block, head);
+    munmap(block + head + length, huge_page_size - head);
+#ifdef MADV_HUGEPAGE
+    if (madvise(block + head, length, MADV_HUGEPAGE) != 0) fall_back_to(frame_memory_pages::heap, "transparent huge pages are disabled, see /sys/kernel/mm/transparent_hugepage/enabled");
+#else
+    fall_back_to(frame_memory_pages::heap, "the library was built without MADV_HUGEPAGE");
+#endif
+    if (numa_node >= 0) numa::prefer_node(block + head, length, numa_node);
+    return block + head;
+}
+
+void mapped_frame_allocator::deallocate(void * ptr, size_t size)
+{
+    munmap(ptr, get_mapping_size(size, requested));
+}
+#elif defined(_WIN32)
+void * mapped_frame_allocator::allocate(size_t size)
+{
+    // Large pages need the SeLockMemoryPrivilege, and Windows has no transparent huge pages to fall back to. NUMA nodes are not detected here.
+    if (requested == frame_memory_pages::explicit_huge)
+    {
+        if (const SIZE_T large_page_size = GetLargePageMinimum())
+        {
+            if (auto block = VirtualAlloc(nullptr, (size + large_page_size - 1) / large_page_size * large_page_size, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE)) return block;
+        }
+        fall_back_to(frame_memory_pages::heap, "large pages require the \"Lock pages in memory\" privilege");
+    }
+    else if (requested == frame_memory_pages::transparent_huge) fall_back_to(frame_memory_pages::heap, "Windows has no transparent huge pages");
+    return VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+}
+
+void mapped_frame_allocator::deallocate(void * ptr, size_t)
+{
+    VirtualFree(ptr, 0, MEM_RELEASE);
+}
+#else
+void * mapped_frame_allocator::allocate(size_t size)
+{
+    if (requested != frame_memory_pages::heap) fall_back_to(frame_memory_pages::heap, "huge pages are only supported on Linux and Windows");
+    return get_default_frame_allocator()->allocate(size);
+}
+
+void mapped_frame_allocator::deallocate(void * ptr, size_t size)
+{
+    get_default_frame_allocator()->deallocate(ptr, size);
+}
+#endif
+
+frame_buffer::frame_buffer(std::shared_ptr<rs_frame_allocator> allocator, size_t capacity)
+    : allocator(allocator), ptr(static_cast<byte *>(allocator->allocate(capacity))), length(0), capacity_(capacity)
+{
+    if (!ptr) throw std::runtime_error(to_string() << "frame allocator failed to provide " << capacity << " bytes");
+}
+
+frame_buffer & frame_buffer::operator=(frame_buffer && r)
+{
+    if (this != &r)
+    {
+        reset();
+        allocator = std::move(r.allocator);
+        ptr = r.ptr;
+        length = r.length;
+        capacity_ = r.capacity_;
+        r.ptr = nullptr;
+        r.length = r.capacity_ = 0;
+    }
+    return *this;
+}
+
+void frame_buffer::reset()
+{
+    if (ptr) allocator->deallocate(ptr, capacity_);
+    allocator.reset();
+    ptr = nullptr;
+    length = capacity_ = 0;
+}
+
+size_t frame_buffer_pool::get_size_class(size_t size)
+{
+    // Round up to the next value of the form 2^k * {4, 5, 6, 7} / 4, wasting at most 25% of the block
+    if (size <= 4096) return 4096;
+    size_t octave = 4096;
+    while (octave * 2 < size) octave *= 2;
+    for (size_t quarter = 5; quarter <= 8; ++quarter)
+    {
+        if (size <= octave / 4 * quarter) return octave / 4 * quarter;
+    }
+    return octave * 2;
+}
+
+frame_buffer_pool::bucket & frame_buffer_pool::get_bucket(size_t size)
+{
+    const auto capacity = get_size_class(size);
+    for (auto & b : buckets)
+    {
+        if (b.capacity == capacity) return b;
+    }
+    buckets.push_back({ capacity, {} });
+    return buckets.back();
+}
+
+void frame_buffer_pool::reserve(size_t size, int count)
+{
+    auto & b = get_bucket(size);
+    b.buffers.reserve(b.buffers.size() + count);
+    for (int i = 0; i < count; ++i) b.buffers.emplace_back(allocator, b.capacity);
+}
+
+frame_buffer frame_buffer_pool::acquire(size_t size)
+{
+    auto & b = get_bucket(size);
+    frame_buffer result;
+    if (!b.buffers.empty())
+    {
+        result = std::move(b.buffers.back());
+        b.buffers.pop_back();
+    }
+    else result = frame_buffer(allocator, b.capacity);
+    result.resize(size);
+    return result;
+}
+
+void frame_buffer_pool::recycle(frame_buffer && buffer)
+{
+    if (buffer.empty()) return;
+    if (buffer.get_allocator() != allocator)
+    {
+        buffer.reset();
+        return;
+    }
+    if (account && account->is_over_budget())
+    {
+        // Shrink the pool to the buffers in use, the next frames reusing what the frames released free
+        buffer.reset();
+        for (auto & b : buckets) b.buffers.clear();
+        return;
+    }
+    for (auto & b : buckets)
+    {
+        if (b.capacity == buffer.capacity())
+        {
+            b.buffers.push_back(std::move(buffer));
+            return;
+        }
+    }
+    buffer.reset();
+}
+
+size_t frame_buffer_pool::get_pooled_bytes() const
+{
+    size_t bytes = 0;
+    for (auto & b : buckets) bytes += b.capacity * b.buffers.size();
+    return bytes;
+}
+
+user_frame_buffers::user_frame_buffers(void * const buffers[], int count, size_t buffer_size) : buffers(buffers, buffers + count), buffer_size(buffer_size)
+{
+    for (int i = count - 1; i >= 0; --i) available.push_back(i);
+}
+
+void * user_frame_buffers::allocate(size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (size <= buffer_size && !available.empty())
+        {
+            auto index = available.back();
+            available.pop_back();
+            return buffers[index];
+        }
+    }
+    return get_default_frame_allocator()->allocate(size);
+}
+
+void user_frame_buffers::deallocate(void * ptr, size_t size)
+{
+    const int index = get_index(ptr);
+    if (index < 0)
+    {
+        get_default_frame_allocator()->deallocate(ptr, size);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    available.push_back(index);
+}
+
+int user_frame_buffers::get_index(const void * ptr) const
+{
+    for (size_t i = 0; i < buffers.size(); ++i) if (buffers[i] == ptr) return static_cast<int>(i);
+    return -1;
+}
+
+static int get_pool_capacity(uint32_t max_frame_queue_size) { return std::max(static_cast<int>(max_frame_queue_size), RS_USER_QUEUE_SIZE) * RS_STREAM_COUNT; }
+
+frame_archive::frame_archive(const std::vector<subdevice_mode_selection>& selection, std::atomic<uint32_t>* in_max_frame_queue_size,
+    std::shared_ptr<rs_frame_allocator> allocator, std::chrono::high_resolution_clock::time_point capture_started)
+    : max_frame_queue_size(in_max_frame_queue_size),
+    published_frames(RS_USER_QUEUE_SIZE * RS_STREAM_COUNT, get_pool_capacity(*in_max_frame_queue_size)),
+    published_sets(RS_USER_QUEUE_SIZE * RS_STREAM_COUNT, get_pool_capacity(*in_max_frame_queue_size)),
+    detached_refs(RS_USER_QUEUE_SIZE * RS_STREAM_COUNT, get_pool_capacity(*in_max_frame_queue_size)),
+    buffer_pool(allocator ? allocator : get_default_frame_allocator()), mutex(), capture_started(capture_started)
 {
     // Store the mode selection that pertains to each native stream
     for (auto & mode : selection)
@@ -16,22 +311,43 @@ frame_archive::frame_archive(const std::vector<subdevice_mode_selection>& select
         }
     }
 
+    for (auto & count : published_frames_per_stream) count = 0; // Derived streams publish frames too
     for(auto s : {RS_STREAM_DEPTH, RS_STREAM_INFRARED, RS_STREAM_INFRARED2, RS_STREAM_COLOR, RS_STREAM_FISHEYE})
     {
-        published_frames_per_stream[s] = 0;
+        mailboxes[s] = nullptr;
+
+        // Streams which are unpacked by the library need their own memory, warm up the pool so that the first frames do not allocate
+        if (is_stream_enabled(s) && modes[s].requires_processing())
+        {
+            buffer_pool.reserve(modes[s].get_image_size(s), preallocated_buffers_per_stream);
+        }
     }
 }
 
-frame_archive::frameset* frame_archive::clone_frameset(frameset* frameset)
+// Return the memory of a frame nobody observes anymore to the pool, and hand back any driver buffer it still holds
+void frame_archive::recycle_frame(frame && f)
+{
+    std::lock_guard<std::recursive_mutex> guard(mutex);
+    f.run_continuation();
+    buffer_pool.recycle(std::move(f.data));
+}
+
+frame_archive::shared_frameset* frame_archive::share_frameset(const frameset& frames)
 {
     auto new_set = published_sets.allocate();
     if (new_set)
     {
-        *new_set = *frameset;
+        new_set->frames = frames;
+        new_set->ref_count = 1;
     }
     return new_set;
 }
 
+void frame_archive::release_frameset(shared_frameset* frames)
+{
+    if (frames->ref_count.fetch_sub(1) == 1) published_sets.deallocate(frames); // Which releases its frames
+}
+
 void frame_archive::unpublish_frame(frame* frame)
 {
     if (frame)
@@ -42,7 +358,7 @@ void frame_archive::unpublish_frame(frame* frame)
         if (is_valid(frame->get_stream_type()))
             --published_frames_per_stream[frame->get_stream_type()];
 
-        freelist.push_back(std::move(*frame));
+        recycle_frame(std::move(*frame));
         published_frames.deallocate(frame);
        
     }
@@ -50,9 +366,12 @@ void frame_archive::unpublish_frame(frame* frame)
 
 frame_archive::frame* frame_archive::publish_frame(frame&& frame)
 {
+    // Over budget, the application holding on to frames gets no more of them before it releases some
+    const uint32_t max_published = is_over_budget() ? std::min(max_frame_queue_size->load(), static_cast<uint32_t>(RS_OVER_BUDGET_QUEUE_SIZE)) : max_frame_queue_size->load();
     if (is_valid(frame.get_stream_type()) &&
-        published_frames_per_stream[frame.get_stream_type()] >= *max_frame_queue_size)
+        published_frames_per_stream[frame.get_stream_type()] >= max_published)
     {
+        if (metrics) metrics->add(frame.get_stream_type(), RS_STREAM_METRIC_FRAMES_UNPUBLISHED);
         return nullptr;
     }
     auto new_frame = published_frames.allocate();
@@ -61,15 +380,16 @@ frame_archive::frame* frame_archive::publish_frame(frame&& frame)
         if (is_valid(frame.get_stream_type())) ++published_frames_per_stream[frame.get_stream_type()];
         *new_frame = std::move(frame);
     }
+    else if (metrics) metrics->add(frame.get_stream_type(), RS_STREAM_METRIC_FRAMES_UNPUBLISHED);
     return new_frame;
 }
 
-frame_archive::frame_ref* frame_archive::detach_frame_ref(frameset* frameset, rs_stream stream)
+frame_archive::frame_ref* frame_archive::detach_frame_ref(const shared_frameset* frames, rs_stream stream)
 {
     auto new_ref = detached_refs.allocate();
     if (new_ref)
     {
-        *new_ref = frameset->detach_ref(stream);
+        *new_ref = frames->frames.get_ref(stream);
     }
     return new_ref;
 }
@@ -84,49 +404,74 @@ frame_archive::frame_ref* frame_archive::clone_frame(frame_ref* frameset)
     return new_ref;
 }
 
-// Allocate a new frame in the backbuffer, potentially recycling a buffer from the freelist
+// Allocate a new frame in the backbuffer, recycling a buffer from the pool
 byte * frame_archive::alloc_frame(rs_stream stream, const frame_additional_data& additional_data, bool requires_memory)
 {
     const size_t size = modes[stream].get_image_size(stream);
     {
         std::lock_guard<std::recursive_mutex> guard(mutex);
 
-        if (requires_memory)
+        // A frame left in the backbuffer was never committed nor published, keep its memory
+        buffer_pool.recycle(std::move(backbuffer[stream].data));
+        if (requires_memory && stream_buffers[stream])
         {
-            // Attempt to obtain a buffer of the appropriate size from the freelist
-            for (auto it = begin(freelist); it != end(freelist); ++it)
-            {
-                if (it->data.size() == size)
-                {
-                    backbuffer[stream] = std::move(*it);
-                    freelist.erase(it);
-                    break;
-                }
-            }
+            backbuffer[stream].data = frame_buffer(stream_buffers[stream], size);
+            backbuffer[stream].data.resize(size);
         }
-
-        // Discard buffers that have been in the freelist for longer than 1s
-        for (auto it = begin(freelist); it != end(freelist);)
+        else if (requires_memory)
         {
-            if (additional_data.timestamp > it->additional_data.timestamp + 1000) it = freelist.erase(it);
-            else ++it;
+            backbuffer[stream].data = buffer_pool.acquire(size);
         }
     }
-    
-    if (requires_memory)
-    {
-        backbuffer[stream].data.resize(size); // TODO: Allow users to provide a custom allocator for frame buffers
-    }
+
     backbuffer[stream].update_owner(this);
     backbuffer[stream].additional_data = additional_data;
+    backbuffer[stream].discard_packed_pixels();
+    if (requires_memory && stream_buffers[stream]) backbuffer[stream].additional_data.buffer_index = stream_buffers[stream]->get_index(backbuffer[stream].data.data());
     return backbuffer[stream].data.data();
 }
 
+// Derived frames are not tied to a backbuffer, so concurrent callers each fill a frame of their own
+frame_archive::frame_ref* frame_archive::create_derived_frame(const frame_additional_data& additional_data, const std::function<void(byte * dest)> & fill)
+{
+    frame derived;
+    {
+        std::lock_guard<std::recursive_mutex> guard(mutex);
+        derived.data = buffer_pool.acquire(get_image_size(additional_data.stride_x, additional_data.height, additional_data.format));
+    }
+    derived.update_owner(this);
+    derived.additional_data = additional_data;
+
+    try
+    {
+        fill(derived.data.data());
+    }
+    catch (...)
+    {
+        recycle_frame(std::move(derived));
+        throw;
+    }
+
+    auto published_frame = derived.publish();
+    if (!published_frame)
+    {
+        recycle_frame(std::move(derived));
+        return nullptr;
+    }
+    frame_ref new_ref(published_frame);
+    return clone_frame(&new_ref);
+}
+
 void frame_archive::attach_continuation(rs_stream stream, frame_continuation&& continuation)
 {
     backbuffer[stream].attach_continuation(std::move(continuation));
 }
 
+void frame_archive::set_frame_metadata(rs_stream stream, rs_frame_metadata frame_metadata, double value)
+{
+    backbuffer[stream].additional_data.set_metadata(frame_metadata, value);
+}
+
 frame_archive::frame_ref* frame_archive::track_frame(rs_stream stream)
 {
     std::unique_lock<std::recursive_mutex> lock(mutex);
@@ -141,8 +486,27 @@ frame_archive::frame_ref* frame_archive::track_frame(rs_stream stream)
     return nullptr;
 }
 
+void frame_archive::post_frame(rs_stream stream)
+{
+    auto latest = track_frame(stream);
+    if (!latest) return;
+    if (auto replaced = mailboxes[stream].exchange(latest))
+    {
+        if (metrics) metrics->add(stream, RS_STREAM_METRIC_FRAMES_CULLED);
+        release_frame_ref(replaced);
+    }
+}
+
+void frame_archive::drop_frame(rs_stream stream)
+{
+    if (metrics) metrics->add(stream, RS_STREAM_METRIC_FRAMES_CULLED);
+    recycle_frame(std::move(backbuffer[stream]));
+}
+
 void frame_archive::flush()
 {
+    for (auto & m : mailboxes) if (auto latest = m.exchange(nullptr)) release_frame_ref(latest);
+
     published_frames.stop_allocation();
     published_sets.stop_allocation();
     detached_refs.stop_allocation();
@@ -168,11 +532,6 @@ frame_archive::frame* frame_archive::frame::publish()
     return owner->publish_frame(std::move(*this));
 }
 
-frame_archive::frame_ref frame_archive::frameset::detach_ref(rs_stream stream)
-{
-    return std::move(buffer[stream]);
-}
-
 void frame_archive::frameset::place_frame(rs_stream stream, frame&& new_frame)
 {
     auto published_frame = new_frame.publish();
@@ -208,6 +567,23 @@ const byte* frame_archive::frame_ref::get_frame_data() const
     return frame_ptr ? frame_ptr->get_frame_data() : nullptr;
 }
 
+const byte* frame_archive::frame_ref::get_frame_strided_data(int & pixel_stride, int & row_stride) const
+{
+    pixel_stride = row_stride = 0;
+    return frame_ptr ? frame_ptr->get_strided_data(pixel_stride, row_stride) : nullptr;
+}
+
+const byte* frame_archive::frame_ref::get_frame_pyramid_level(int level, int & width, int & height) const
+{
+    width = height = 0;
+    return frame_ptr ? frame_ptr->get_pyramid_level(level, width, height) : nullptr;
+}
+
+const uint32_t* frame_archive::frame_ref::get_frame_depth_runs() const
+{
+    return frame_ptr ? frame_ptr->get_depth_runs() : nullptr;
+}
+
 double frame_archive::frame_ref::get_frame_timestamp() const
 {
     return frame_ptr ? frame_ptr->get_frame_timestamp(): 0;
@@ -278,28 +654,37 @@ double frame_archive::frame::get_frame_metadata(rs_frame_metadata frame_metadata
     if (!supports_frame_metadata(frame_metadata))
         throw std::logic_error("unsupported metadata type");
 
-    switch (frame_metadata)
-    {
-        case RS_FRAME_METADATA_ACTUAL_EXPOSURE:
-            return additional_data.exposure_value;
-            break;
-        case RS_FRAME_METADATA_ACTUAL_FPS:
-            return additional_data.actual_fps;
-            break;
-        default:
-            throw std::logic_error("unsupported metadata type");
-            break;
-    }
+    return additional_data.metadata[frame_metadata];
 }
 
 bool frame_archive::frame::supports_frame_metadata(rs_frame_metadata frame_metadata) const
 {
-    for (auto & md : *additional_data.supported_metadata_vector) if (md == frame_metadata) return true;
-    return false;
+    return frame_metadata >= 0 && frame_metadata < RS_FRAME_METADATA_COUNT && (additional_data.supported_metadata_mask & (1u << frame_metadata)) != 0;
 }
 
 const byte* frame_archive::frame::get_frame_data() const
 {
+    // A strided view is packed into the memory set aside for it when it was allocated, once, whichever thread asks first
+    if (additional_data.pixel_stride && on_release.get_data())
+    {
+        if (!packed.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(pack_mutex);
+            if (!packed.load(std::memory_order_relaxed))
+            {
+                auto samples = static_cast<const byte*>(on_release.get_data());
+                auto pixels = const_cast<byte*>(data.data()); // The memory of the frame, not its contents, is what makes it const
+                const int row_stride = additional_data.stride_x * additional_data.pixel_stride;
+                for (int y = 0; y < additional_data.height; ++y)
+                {
+                    pack_strided_samples(pixels + y * get_stride(), samples + y * row_stride, additional_data.width, additional_data.pixel_stride);
+                }
+                packed.store(true, std::memory_order_release);
+            }
+        }
+        return data.data();
+    }
+
 	const byte* frame_data = data.data();;
 
     if (on_release.get_data())
@@ -314,6 +699,44 @@ const byte* frame_archive::frame::get_frame_data() const
     return frame_data;
 }
 
+const byte* frame_archive::frame::get_strided_data(int & pixel_stride, int & row_stride) const
+{
+    if (additional_data.pixel_stride && on_release.get_data())
+    {
+        pixel_stride = additional_data.pixel_stride;
+        row_stride = additional_data.stride_x * additional_data.pixel_stride;
+        return static_cast<const byte*>(on_release.get_data());
+    }
+    pixel_stride = additional_data.bpp / 8;
+    row_stride = get_stride();
+    return get_frame_data();
+}
+
+const byte* frame_archive::frame::get_pyramid_level(int level, int & width, int & height) const
+{
+    width = height = 0;
+    if (level < 0 || level > additional_data.pyramid_levels) return nullptr;
+    if (level == 0)
+    {
+        width = additional_data.width;
+        height = additional_data.height;
+        return get_frame_data();
+    }
+
+    // The levels follow the packed pixels of the frame, each one half the size of the one before in both dimensions
+    auto pixels = data.data() + additional_data.width * additional_data.height * (additional_data.bpp / 8);
+    for (int k = 1; k < level; ++k) pixels += (additional_data.width >> k) * (additional_data.height >> k) * (additional_data.bpp / 8);
+    width = additional_data.width >> level;
+    height = additional_data.height >> level;
+    return pixels;
+}
+
+const uint32_t* frame_archive::frame::get_depth_runs() const
+{
+    if (!additional_data.depth_runs) return nullptr;
+    return reinterpret_cast<const uint32_t *>(data.data() + get_depth_runs_offset(additional_data.width, additional_data.height, additional_data.pyramid_levels));
+}
+
 rs_timestamp_domain frame_archive::frame::get_frame_timestamp_domain() const
 {
     return additional_data.timestamp_domain;
@@ -366,6 +789,13 @@ void frame_archive::frame::update_frame_callback_start_ts(std::chrono::high_reso
 }
 
 
+void frame_archive::frame::log_delivery(stage_latency_histograms * histograms)
+{
+    if (supports_frame_metadata(RS_FRAME_METADATA_TIME_OF_DELIVERY)) return; // Handed out again, along with a later frameset
+    additional_data.set_metadata(RS_FRAME_METADATA_TIME_OF_DELIVERY, get_monotonic_time());
+    if (histograms) histograms->add(additional_data.stream_type, additional_data.metadata, additional_data.supported_metadata_mask);
+}
+
 rs_format frame_archive::frame::get_format() const
 {
     return additional_data.format;
@@ -382,6 +812,7 @@ std::chrono::high_resolution_clock::time_point frame_archive::frame::get_frame_c
 
 void frame_archive::log_frame_callback_end(frame* frame)
 {
+    if (!is_logged(RS_LOG_SEVERITY_INFO)) return;
     auto callback_ended = std::chrono::high_resolution_clock::now();
     auto ts = std::chrono::duration_cast<std::chrono::milliseconds>(callback_ended - capture_started).count();
     auto callback_warning_duration = 1000 / (frame->additional_data.fps+1);
@@ -397,6 +828,7 @@ void frame_archive::log_frame_callback_end(frame* frame)
 
 void frame_archive::frame_ref::log_callback_start(std::chrono::high_resolution_clock::time_point capture_start_time)
 {
+    if (!is_logged(RS_LOG_SEVERITY_DEBUG)) return;
     auto callback_start_time = std::chrono::high_resolution_clock::now();
     auto ts = std::chrono::duration_cast<std::chrono::milliseconds>(callback_start_time - capture_start_time).count();
     LOG_DEBUG("CallbackStarted," << rsimpl::get_string(get_stream_type()) << "," << get_frame_number() << ",DispatchedAt," << ts);
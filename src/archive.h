@@ -8,54 +8,192 @@
 #include "types.h"
 #include <atomic>
 #include "timestamps.h"
+#include "latency.h"
+#include "metrics.h"
 
 namespace rsimpl
 {
-    // Defines general frames storage model
+    // Returns the allocator used when the application did not provide one, backed by the heap
+    std::shared_ptr<rs_frame_allocator> get_default_frame_allocator();
+
+    // Kinds of pages frame memory is backed by, as RS_OPTION_FRAME_MEMORY_PAGES selects them
+    enum class frame_memory_pages { heap, transparent_huge, explicit_huge };
+
+    // Frame memory mapped straight from the system, in the pages requested and on the NUMA node requested, if any. Huge pages of 2 MB let a
+    // few TLB entries cover a frame the kernels stream through. Explicit huge pages the system has not reserved fall back to transparent huge
+    // pages, and those to ordinary pages, and the allocator keeps the furthest fallback it had to make. Every block takes whole pages, which
+    // the frame pool allocating a few large blocks per stream amortizes.
+    class mapped_frame_allocator : public rs_frame_allocator
+    {
+        const frame_memory_pages requested;
+        const int numa_node;
+        std::atomic<int> provided;
+        void fall_back_to(frame_memory_pages pages, const char * reason);
+    public:
+        explicit mapped_frame_allocator(frame_memory_pages requested, int numa_node = -1) : requested(requested), numa_node(numa_node), provided(static_cast<int>(requested)) {}
+
+        void * allocate(size_t size) override;
+        void deallocate(void * ptr, size_t size) override;
+        void release() override {}
+
+        frame_memory_pages get_provided_pages() const { return static_cast<frame_memory_pages>(provided.load()); } // Of the block served with the smallest pages so far
+    };
+
+    // Counts the blocks of another allocator in the memory_account of a device, which every archive and capture of the device allocates through
+    class accounted_frame_allocator : public rs_frame_allocator
+    {
+        const std::shared_ptr<rs_frame_allocator> allocator;
+        const std::shared_ptr<memory_account> account;  // Shared, as frames the application holds may outlive their device
+    public:
+        accounted_frame_allocator(std::shared_ptr<rs_frame_allocator> allocator, std::shared_ptr<memory_account> account) : allocator(allocator), account(account) {}
+
+        void * allocate(size_t size) override { auto ptr = allocator->allocate(size); if (ptr) account->allocated(size); return ptr; }
+        void deallocate(void * ptr, size_t size) override { allocator->deallocate(ptr, size); account->deallocated(size); }
+        void release() override {}
+    };
+
+    // Movable, noncopyable block of frame memory which hands itself back to its allocator on destruction
+    class frame_buffer
+    {
+        std::shared_ptr<rs_frame_allocator> allocator;
+        byte * ptr;
+        size_t length, capacity_;
+    public:
+        frame_buffer() : ptr(nullptr), length(0), capacity_(0) {}
+        frame_buffer(std::shared_ptr<rs_frame_allocator> allocator, size_t capacity);
+        frame_buffer(const frame_buffer & r) = delete;
+        frame_buffer(frame_buffer && r) : frame_buffer() { *this = std::move(r); }
+        frame_buffer & operator=(const frame_buffer & r) = delete;
+        frame_buffer & operator=(frame_buffer && r);
+        ~frame_buffer() { reset(); }
+
+        byte * data() { return ptr; }
+        const byte * data() const { return ptr; }
+        size_t size() const { return length; }
+        size_t capacity() const { return capacity_; }
+        bool empty() const { return ptr == nullptr; }
+        const std::shared_ptr<rs_frame_allocator> & get_allocator() const { return allocator; }
+
+        void resize(size_t size) { assert(size <= capacity_); length = size; } // Never reallocates
+        void reset();
+    };
+
+    // Recycles frame buffers in size classes, so that steady state streaming never touches the allocator
+    // Size classes are spaced a quarter octave apart, which lets streams of nearby sizes share buffers
+    // A pool lives as long as one capture session, so changing resolutions releases the old size classes wholesale
+    class frame_buffer_pool
+    {
+        struct bucket
+        {
+            size_t capacity;
+            std::vector<frame_buffer> buffers;
+        };
+
+        std::shared_ptr<rs_frame_allocator> allocator;
+        std::vector<bucket> buckets;
+        std::shared_ptr<const memory_account> account; // Whose budget, once exceeded, has the pool give its buffers back to the allocator
+
+        bucket & get_bucket(size_t size);
+    public:
+        explicit frame_buffer_pool(std::shared_ptr<rs_frame_allocator> allocator) : allocator(allocator) {}
+
+        static size_t get_size_class(size_t size);
+
+        void set_memory_account(std::shared_ptr<const memory_account> a) { account = a; }
+        void reserve(size_t size, int count);       // Preallocate count buffers able to hold size bytes
+        frame_buffer acquire(size_t size);          // Obtain a buffer of exactly size bytes, allocating only if its size class is exhausted
+        void recycle(frame_buffer && buffer);       // Buffers of another allocator are handed back to it instead, as are all of them while over budget
+        size_t get_pooled_bytes() const;            // Of the buffers waiting to be acquired
+    };
+
+    // Fixed-size buffers of the application, such as pinned memory a GPU copies from, which the frames of one stream are unpacked into.
+    // A buffer returns to the set as soon as the frame in it is released. Frames larger than the buffers, or arriving while every buffer
+    // is taken, are given memory of the heap instead.
+    class user_frame_buffers : public rs_frame_allocator
+    {
+        std::mutex mutex;                           // Frames are allocated by the capture threads and released by any thread
+        const std::vector<void *> buffers;
+        std::vector<int> available;                 // Indices of the buffers not holding a frame, the most recently released last
+        const size_t buffer_size;
+    public:
+        user_frame_buffers(void * const buffers[], int count, size_t buffer_size);
+
+        void * allocate(size_t size) override;
+        void deallocate(void * ptr, size_t size) override;
+        void release() override {}
+
+        int get_index(const void * ptr) const;      // Of the buffer at ptr, -1 for memory of the heap
+    };
+
+    // Defines general frames storage model: pooled frame memory and reference counted frames. Used as is when every frame goes to a frame callback,
+    // and extended by syncronizing_archive otherwise
     class frame_archive
     {
     public:
+        // Plain values only, so that moving, cloning and publishing a frame never touches the heap or an atomic
+        // Fields read on every frame come first, and are grouped by size to avoid padding
         struct frame_additional_data
         {
-            double actual_fps = 0;
+            static_assert(RS_FRAME_METADATA_COUNT <= 32, "frame metadata no longer fits the supported metadata mask");
+
             double timestamp = 0;
-            double exposure_value = 0;
             unsigned long long frame_number = 0;
             long long system_time = 0;
             int width = 0;
             int height = 0;
-            int fps = 0;
             int stride_x = 0;
             int stride_y = 0;
             int bpp = 1;
+            int pad = 0;
+            int fps = 0;
+            int buffer_index = -1;                          // Of the user_frame_buffers the frame was unpacked into, -1 for library memory
+            int pixel_stride = 0;                           // Bytes between the pixels of a strided view of an interleaved native frame, 0 for packed pixels
+            int pyramid_levels = 0;                         // Reduced levels of a depth pyramid stored behind the pixels of the frame
+            bool depth_runs = false;                        // The runs of valid depth pixels are stored behind the pyramid of the frame
             rs_format format = RS_FORMAT_ANY;
             rs_stream stream_type = RS_STREAM_COUNT;
             rs_timestamp_domain timestamp_domain = RS_TIMESTAMP_DOMAIN_CAMERA;
-            int pad = 0;
-            std::shared_ptr<std::vector<rs_frame_metadata>> supported_metadata_vector;
+            uint32_t supported_metadata_mask = 0;           // Bit i is set if metadata value i is provided for this frame
+            bool timestamp_pending = false;                 // Published before the motion module event of its frame number arrived, corrected by the application side
+            double metadata[RS_FRAME_METADATA_COUNT];       // Indexed by rs_frame_metadata
             std::chrono::high_resolution_clock::time_point frame_callback_started {};
 
-            frame_additional_data(){};
+            frame_additional_data() { for (auto & m : metadata) m = 0; }
 
             frame_additional_data(double in_timestamp, unsigned long long in_frame_number, long long in_system_time, 
                 int in_width, int in_height, int in_fps, 
                 int in_stride_x, int in_stride_y, int in_bpp, 
-                const rs_format in_format, rs_stream in_stream_type, int in_pad, std::shared_ptr<std::vector<rs_frame_metadata>> in_supported_metadata_vector, double in_exposure_value, double in_actual_fps)
+                const rs_format in_format, rs_stream in_stream_type, int in_pad, uint32_t in_supported_metadata_mask, double in_exposure_value, double in_actual_fps)
                 : timestamp(in_timestamp),
                   frame_number(in_frame_number),
                   system_time(in_system_time),
                   width(in_width),
                   height(in_height),
-                  fps(in_fps),
                   stride_x(in_stride_x),
                   stride_y(in_stride_y),
                   bpp(in_bpp),
+                  pad(in_pad),
+                  fps(in_fps),
                   format(in_format),
                   stream_type(in_stream_type),
-                  pad(in_pad),
-                  supported_metadata_vector(in_supported_metadata_vector),
-                  exposure_value(in_exposure_value),
-                  actual_fps(in_actual_fps){}
+                  supported_metadata_mask(in_supported_metadata_mask)
+            {
+                metadata[RS_FRAME_METADATA_ACTUAL_EXPOSURE] = in_exposure_value;
+                metadata[RS_FRAME_METADATA_ACTUAL_FPS] = in_actual_fps;
+            }
+
+            void set_metadata(rs_frame_metadata frame_metadata, double value)
+            {
+                metadata[frame_metadata] = value;
+                supported_metadata_mask |= 1u << frame_metadata;
+            }
+
+            static uint32_t get_metadata_mask(const std::vector<rs_frame_metadata> & supported)
+            {
+                uint32_t mask = 0;
+                for (auto md : supported) mask |= 1u << md;
+                return mask;
+            }
         };
 
         // Define a movable but explicitly noncopyable buffer type to hold our frame data
@@ -66,16 +204,18 @@ namespace rsimpl
             std::atomic<int> ref_count; // the reference count is on how many times this placeholder has been observed (not lifetime, not content)
             frame_archive * owner; // pointer to the owner to be returned to by last observe
             frame_continuation on_release;
+            mutable std::mutex pack_mutex;      // The pixels of a strided view are packed into data by the first thread asking for them
+            mutable std::atomic<bool> packed;
 
         public:
-            std::vector<byte> data;
+            frame_buffer data;
             frame_additional_data additional_data;
 
-            explicit frame() : ref_count(0), owner(nullptr), on_release(){}
+            explicit frame() : ref_count(0), owner(nullptr), on_release(), packed(false){}
             frame(const frame & r) = delete;
             frame(frame && r) 
                 : ref_count(r.ref_count.exchange(0)), 
-                  owner(r.owner), on_release() 
+                  owner(r.owner), on_release(), packed(false)
             {
                 *this = std::move(r); // TODO: This is not very safe, refactor later
             }
@@ -83,11 +223,12 @@ namespace rsimpl
             frame & operator=(const frame & r) = delete;
             frame& operator=(frame&& r)
             {
-                data = move(r.data);
+                data = std::move(r.data);
                 owner = r.owner;
                 ref_count = r.ref_count.exchange(0);
                 on_release = std::move(r.on_release);
                 additional_data = std::move(r.additional_data);
+                packed = r.packed.load();
                 return *this;
             }
 
@@ -95,7 +236,10 @@ namespace rsimpl
 
             double get_frame_metadata(rs_frame_metadata frame_metadata) const override;
             bool supports_frame_metadata(rs_frame_metadata frame_metadata) const override;
-            const byte* get_frame_data() const;
+            const byte* get_frame_data() const; // Packs the pixels of a strided view the first time
+            const byte* get_strided_data(int & pixel_stride, int & row_stride) const;
+            const byte* get_pyramid_level(int level, int & width, int & height) const; // Level 0 is the frame itself, nullptr past its levels
+            const uint32_t* get_depth_runs() const; // Row offsets followed by the runs found by find_depth_runs(...), nullptr if none were
             double get_frame_timestamp() const;
             rs_timestamp_domain get_frame_timestamp_domain() const;
             void set_timestamp(double new_ts) override { additional_data.timestamp = new_ts; }
@@ -109,16 +253,20 @@ namespace rsimpl
             int get_bpp() const;
             rs_format get_format() const;
             rs_stream get_stream_type() const override;
+            int get_buffer_index() const { return additional_data.buffer_index; }
 
             std::chrono::high_resolution_clock::time_point get_frame_callback_start_time_point() const;
             void update_frame_callback_start_ts(std::chrono::high_resolution_clock::time_point ts);
+            void log_delivery(stage_latency_histograms * histograms); // Times the first delivery of the frame, adding its stages to the histograms if not null
 
             void acquire() { ref_count.fetch_add(1); }
             void release();
             frame* publish();
             void update_owner(frame_archive * new_owner) { owner = new_owner; }
+            void discard_packed_pixels() { packed = false; }
             void attach_continuation(frame_continuation&& continuation) { on_release = std::move(continuation); }
             void disable_continuation() { on_release.reset(); }
+            void run_continuation() { on_release(); }
         };
 
         class frame_ref : public rs_frame_ref // esentially an intrusive shared_ptr<frame>
@@ -163,9 +311,14 @@ namespace rsimpl
                 if (frame_ptr) frame_ptr->disable_continuation();
             }
 
+            const frame_additional_data * get_additional_data() const { return frame_ptr ? &frame_ptr->additional_data : nullptr; }
+
             double get_frame_metadata(rs_frame_metadata frame_metadata) const override;
             bool supports_frame_metadata(rs_frame_metadata frame_metadata) const override;
             const byte* get_frame_data() const override;
+            const byte* get_frame_strided_data(int & pixel_stride, int & row_stride) const override;
+            const byte* get_frame_pyramid_level(int level, int & width, int & height) const override;
+            const uint32_t* get_frame_depth_runs() const override;
             double get_frame_timestamp() const override;
             unsigned long long get_frame_number() const override;
             long long get_frame_system_time() const override;
@@ -177,9 +330,11 @@ namespace rsimpl
             int get_frame_bpp() const override;
             rs_format get_frame_format() const override;
             rs_stream get_stream_type() const override;
+            int get_frame_buffer_index() const override { return frame_ptr ? frame_ptr->get_buffer_index() : -1; }
             std::chrono::high_resolution_clock::time_point get_frame_callback_start_time_point() const;
             void update_frame_callback_start_ts(std::chrono::high_resolution_clock::time_point ts);
             void log_callback_start(std::chrono::high_resolution_clock::time_point capture_start_time);
+            void log_delivery(stage_latency_histograms * histograms) { if (frame_ptr) frame_ptr->log_delivery(histograms); }
         };
 
         class frameset
@@ -187,8 +342,9 @@ namespace rsimpl
             frame_ref buffer[RS_STREAM_NATIVE_COUNT];
         public:
 
-            frame_ref detach_ref(rs_stream stream);
+            frame_ref get_ref(rs_stream stream) const { return buffer[stream]; }
             void place_frame(rs_stream stream, frame&& new_frame);
+            void clear_frame(rs_stream stream) { buffer[stream] = frame_ref(); } // Leaves the stream out, its frame data is then null
 
             const rs_frame_ref * get_frame(rs_stream stream) const
             {
@@ -201,11 +357,32 @@ namespace rsimpl
             double get_frame_timestamp(rs_stream stream) const { return buffer[stream].get_frame_timestamp(); }
             unsigned long long get_frame_number(rs_stream stream) const { return buffer[stream].get_frame_number(); }
             long long get_frame_system_time(rs_stream stream) const { return buffer[stream].get_frame_system_time(); }
+            const frame_additional_data * get_additional_data(rs_stream stream) const { return buffer[stream].get_additional_data(); } // Null once cleared, never packs a view
             int get_frame_stride(rs_stream stream) const { return buffer[stream].get_frame_stride(); }
+            const uint32_t * get_frame_depth_runs(rs_stream stream) const { return buffer[stream].get_frame_depth_runs(); }
             int get_frame_bpp(rs_stream stream) const { return buffer[stream].get_frame_bpp(); }
 
             void cleanup();
-            
+            void log_delivery(stage_latency_histograms * histograms) { for (auto & f : buffer) f.log_delivery(histograms); }
+        };
+
+        // A frameset once formed, as handed out through rs_frameset. It is never modified and shared by every handle to it, so that cloning
+        // one is a single atomic increment, and the last release drops all of its frames together.
+        class shared_frameset
+        {
+            std::atomic<int> ref_count;
+            frameset frames;
+            friend class frame_archive;
+        public:
+            shared_frameset() : ref_count(0) {}
+            shared_frameset & operator=(shared_frameset && r)
+            {
+                ref_count = r.ref_count.exchange(0);
+                frames = std::move(r.frames);
+                return *this;
+            }
+
+            const frameset & get_frames() const { return frames; }
         };
 
     private:
@@ -214,46 +391,68 @@ namespace rsimpl
         
         std::atomic<uint32_t>* max_frame_queue_size;
         std::atomic<uint32_t> published_frames_per_stream[RS_STREAM_COUNT];
-        small_heap<frame, RS_USER_QUEUE_SIZE*RS_STREAM_COUNT> published_frames;
-        small_heap<frameset, RS_USER_QUEUE_SIZE*RS_STREAM_COUNT> published_sets;
-        small_heap<frame_ref, RS_USER_QUEUE_SIZE*RS_STREAM_COUNT> detached_refs;
+        small_heap<frame> published_frames;         // The pools hold as many objects per stream as max_frame_queue_size at creation, at least
+        small_heap<shared_frameset> published_sets; // RS_USER_QUEUE_SIZE, and start with the latter
+        small_heap<frame_ref> detached_refs;
+        std::atomic<frame_ref *> mailboxes[RS_STREAM_NATIVE_COUNT]; // Latest frame of each stream posted and not taken yet, swapped without a lock
         
 
     protected:
         frame backbuffer[RS_STREAM_NATIVE_COUNT]; // receive frame here
-        std::vector<frame> freelist; // return frames here
+        frame_buffer_pool buffer_pool; // return frame memory here
+        std::shared_ptr<user_frame_buffers> stream_buffers[RS_STREAM_NATIVE_COUNT]; // Of the streams unpacked into buffers of the application
         std::recursive_mutex mutex;
         std::chrono::high_resolution_clock::time_point capture_started;
+        stage_latency_histograms * latency_histograms = nullptr; // Outlives the archive, as the device owning it does
+        stream_metrics * metrics = nullptr;                     // Likewise
+        std::shared_ptr<const memory_account> memory;           // Of the device, set before streaming starts like metrics
+
+        void recycle_frame(frame && f);
+        bool is_over_budget() const { return memory && memory->is_over_budget(); }
 
     public:
-        frame_archive(const std::vector<subdevice_mode_selection> & selection, std::atomic<uint32_t>* max_frame_queue_size, std::chrono::high_resolution_clock::time_point capture_started = std::chrono::high_resolution_clock::now());
+        frame_archive(const std::vector<subdevice_mode_selection> & selection, std::atomic<uint32_t>* max_frame_queue_size,
+            std::shared_ptr<rs_frame_allocator> allocator = nullptr,
+            std::chrono::high_resolution_clock::time_point capture_started = std::chrono::high_resolution_clock::now());
 
         // Safe to call from any thread
         bool is_stream_enabled(rs_stream stream) const { return modes[stream].mode.pf.fourcc != 0; }
+        int get_frame_pool_size() const { return detached_refs.get_capacity() / RS_STREAM_COUNT; } // Frames of every stream the pools can hand out at once
         const subdevice_mode_selection & get_mode(rs_stream stream) const { return modes[stream]; }
         
-        void release_frameset(frameset * frameset)
-        {
-            published_sets.deallocate(frameset);
-        }
-        frameset * clone_frameset(frameset * frameset);
+        shared_frameset * share_frameset(const frameset & frames); // The first handle to a copy of frames, or nullptr if too many framesets are held
+        shared_frameset * clone_frameset(shared_frameset * frames) { frames->ref_count.fetch_add(1); return frames; }
+        void release_frameset(shared_frameset * frames);
 
         void unpublish_frame(frame * frame);
         frame * publish_frame(frame && frame);
 
-        frame_ref * detach_frame_ref(frameset * frameset, rs_stream stream);
+        frame_ref * detach_frame_ref(const shared_frameset * frames, rs_stream stream);
         frame_ref * clone_frame(frame_ref * frameset);
         void release_frame_ref(frame_ref * ref)
         {
             detached_refs.deallocate(ref);
         }
 
+        // Derived frames API, safe to call from any thread. Fills a frame from the pool and hands out the first reference to it, or nullptr if the queue of its stream is full
+        frame_ref * create_derived_frame(const frame_additional_data & additional_data, const std::function<void(byte * dest)> & fill);
+
         // Frame callback thread API
         byte * alloc_frame(rs_stream stream, const frame_additional_data& additional_data, bool requires_memory);
         frame_ref * track_frame(rs_stream stream);
         void attach_continuation(rs_stream stream, frame_continuation&& continuation);
+        void post_frame(rs_stream stream); // Makes the backbuffer the latest frame of its stream, recycling the one it replaces at once
+        void drop_frame(rs_stream stream); // Recycles the backbuffer of a stream nobody takes the frames of, counting it as culled
+
+        // Mailbox API, safe to call from any thread and never blocks. The frame posted since the last call, or nullptr, released with release_frame_ref
+        frame_ref * take_latest_frame(rs_stream stream) { return mailboxes[stream].exchange(nullptr); }
+        void set_frame_metadata(rs_stream stream, rs_frame_metadata frame_metadata, double value);
         void log_frame_callback_end(frame* frame);
         void log_callback_start(frame_ref* frame_ref, std::chrono::high_resolution_clock::time_point capture_start_time);
+        void set_latency_histograms(stage_latency_histograms * histograms) { latency_histograms = histograms; } // Set before streaming starts
+        void set_stream_metrics(stream_metrics * m) { metrics = m; }                                            // Likewise
+        void set_memory_account(std::shared_ptr<const memory_account> m) { memory = m; buffer_pool.set_memory_account(m); } // Likewise, fewer frames are then kept while over its budget
+        void set_stream_buffers(rs_stream stream, std::shared_ptr<user_frame_buffers> buffers) { stream_buffers[stream] = buffers; } // Likewise
 
         virtual void flush();
 
@@ -0,0 +1,77 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "bandwidth-planner.h"
+#include "device.h"
+
+using namespace rsimpl;
+
+std::vector<size_t> rsimpl::plan_bandwidth(const std::vector<bandwidth_demand> & demands, double capacity)
+{
+    std::vector<size_t> plan(demands.size(), 0);
+    for (size_t i = 0; i < demands.size(); ++i)
+    {
+        // Every controller is planned once, along with the first of its devices
+        const auto & controller = demands[i].controller;
+        if (!controller.empty() && std::any_of(demands.begin(), demands.begin() + i, [&controller](const bandwidth_demand & d) { return d.controller == controller; })) continue;
+        std::vector<size_t> group(1, i);
+        for (size_t j = i + 1; j < demands.size(); ++j) if (!controller.empty() && demands[j].controller == controller) group.push_back(j);
+
+        while (true)
+        {
+            double total = 0;
+            size_t largest = demands.size();
+            for (auto j : group)
+            {
+                total += demands[j].bandwidths[plan[j]];
+                if (plan[j] + 1 == demands[j].bandwidths.size()) continue;
+                if (largest == demands.size() || demands[j].bandwidths[plan[j]] > demands[largest].bandwidths[plan[largest]]) largest = j;
+            }
+            if (total <= capacity) break;
+
+            if (largest == demands.size())
+            {
+                std::ostringstream names;
+                for (auto j : group) names << (j == i ? "" : ", ") << demands[j].name;
+                throw std::runtime_error(to_string() << "the streams of " << names.str() << (controller.empty() ? "" : " on USB bus " + controller)
+                    << " take " << total / 1e6 << " MB/s at their lowest, more than the " << capacity / 1e6 << " MB/s available");
+            }
+            ++plan[largest];
+        }
+    }
+    return plan;
+}
+
+std::string rsimpl::get_usb_controller(const std::string & usb_port_id)
+{
+    return usb_port_id.substr(0, usb_port_id.find('-'));
+}
+
+void rsimpl::plan_device_modes(const std::vector<rs_device_base *> & devices, double capacity)
+{
+    std::vector<std::vector<request_candidate>> candidates;
+    std::vector<bandwidth_demand> demands;
+    for (auto it = devices.begin(); it != devices.end(); ++it)
+    {
+        auto dev = *it;
+        if (std::find(devices.begin(), it, dev) != it) throw std::runtime_error(to_string() << "device " << dev->get_name() << " is passed more than once");
+        if (dev->is_capturing()) throw std::runtime_error(to_string() << "device " << dev->get_name() << " must be stopped to plan its streams");
+
+        candidates.push_back(dev->get_bandwidth_candidates());
+        bandwidth_demand demand = { to_string() << dev->get_name() << " " << dev->get_serial(), get_usb_controller(dev->get_usb_port_id()) };
+        for (auto & c : candidates.back()) demand.bandwidths.push_back(c.bandwidth);
+        demands.push_back(demand);
+    }
+
+    auto plan = plan_bandwidth(demands, capacity);
+    for (size_t i = 0; i < devices.size(); ++i)
+    {
+        if (plan[i] == 0) continue;
+        auto & requests = candidates[i][plan[i]].requests;
+        for (int s = 0; s < RS_STREAM_NATIVE_COUNT; ++s)
+        {
+            auto & r = requests[s];
+            if (r.enabled) devices[i]->enable_stream((rs_stream)s, r.width, r.height, r.format, r.fps, r.output_format);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_BANDWIDTH_PLANNER_H
+#define LIBREALSENSE_BANDWIDTH_PLANNER_H
+
+#include "types.h"
+
+struct rs_device_base;
+
+namespace rsimpl
+{
+    // A device to plan, with the bandwidths of the stream configurations it may take: the one its requests select, then lower ones from the highest
+    struct bandwidth_demand
+    {
+        std::string name;                   // Names the device in errors
+        std::string controller;             // Devices sharing a host controller share its bandwidth, no controller shares it with no other device
+        std::vector<double> bandwidths;     // Bytes per second
+    };
+
+    // Chooses one configuration per device, returned as an index into its bandwidths. On each controller, the device taking the most bandwidth
+    // moves on to its next configuration until the devices fit within capacity, a controller they cannot fit on even at their lowest being reported.
+    std::vector<size_t> plan_bandwidth(const std::vector<bandwidth_demand> & demands, double capacity);
+
+    // Host controller of a device from its USB port id, its bus ahead of the port path. Devices of an unknown port have none.
+    std::string get_usb_controller(const std::string & usb_port_id);
+
+    // Plans the streams of stopped devices over the controllers they are connected to, and enables the streams of the devices which have to
+    // move off the configuration their requests select. Streams are only moved among the resolutions, formats and framerates left open by
+    // their requests, so the requests of a device stand whenever the configuration they select fits.
+    void plan_device_modes(const std::vector<rs_device_base *> & devices, double capacity);
+}
+
+#endif
@@ -0,0 +1,131 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "calibration-store.h"
+
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cctype>
+#include <sys/stat.h>
+
+using namespace rsimpl;
+
+namespace
+{
+    std::mutex directory_mutex;
+    std::string cache_directory;
+
+    const char file_magic[8] = { 'R', 'S', 'C', 'A', 'L', 'I', 'B', '1' };
+    const uint32_t max_entry_size = 1 << 20;
+
+    struct file_header
+    {
+        char magic[8];
+        uint32_t signature_size, data_size, checksum;
+    };
+
+    // FNV-1a over the signature and the data, which catches entries cut short or overwritten
+    uint32_t get_checksum(const std::vector<uint8_t> & signature, const std::vector<uint8_t> & data)
+    {
+        uint32_t hash = 2166136261u;
+        for (auto b : signature) hash = (hash ^ b) * 16777619u;
+        for (auto b : data) hash = (hash ^ b) * 16777619u;
+        return hash;
+    }
+
+    std::string get_path(const std::string & directory, const std::string & key)
+    {
+        std::string name = key;
+        for (auto & c : name) if (!isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_' && c != '.') c = '_';
+        return directory + "/" + name + ".calibration";
+    }
+
+    bool load(const std::string & path, const std::vector<uint8_t> & signature, std::vector<uint8_t> & data)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+
+        file_header header;
+        if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) return false;
+        if (memcmp(header.magic, file_magic, sizeof(file_magic)) || header.signature_size != signature.size() || header.data_size > max_entry_size) return false;
+
+        std::vector<uint8_t> stored_signature(header.signature_size);
+        data.resize(header.data_size);
+        if (!file.read(reinterpret_cast<char *>(stored_signature.data()), stored_signature.size())) return false;
+        if (!file.read(reinterpret_cast<char *>(data.data()), data.size())) return false;
+        return stored_signature == signature && get_checksum(stored_signature, data) == header.checksum;
+    }
+
+    // The entry is written next to its file and renamed over it, so that other processes never read it half written
+    void store(const std::string & path, const std::vector<uint8_t> & signature, const std::vector<uint8_t> & data)
+    {
+        std::ostringstream temporary;
+        temporary << path << '.' << std::hash<std::thread::id>()(std::this_thread::get_id()) << '.' << std::chrono::steady_clock::now().time_since_epoch().count();
+
+        file_header header = {};
+        memcpy(header.magic, file_magic, sizeof(file_magic));
+        header.signature_size = static_cast<uint32_t>(signature.size());
+        header.data_size = static_cast<uint32_t>(data.size());
+        header.checksum = get_checksum(signature, data);
+        {
+            std::ofstream file(temporary.str(), std::ios::binary);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(signature.data()), signature.size());
+            file.write(reinterpret_cast<const char *>(data.data()), data.size());
+            if (!file.flush())
+            {
+                LOG_WARNING("Calibration could not be written to " << temporary.str());
+                file.close();
+                std::remove(temporary.str().c_str());
+                return;
+            }
+        }
+
+        // Windows refuses to rename over an existing file
+        if (std::rename(temporary.str().c_str(), path.c_str()) != 0 && (std::remove(path.c_str()), std::rename(temporary.str().c_str(), path.c_str()) != 0))
+        {
+            LOG_WARNING("Calibration could not be stored in " << path);
+            std::remove(temporary.str().c_str());
+        }
+    }
+}
+
+void calibration_store::set_directory(const std::string & directory)
+{
+    struct stat status;
+    if (!directory.empty() && (stat(directory.c_str(), &status) != 0 || !(status.st_mode & S_IFDIR)))
+        throw std::runtime_error(to_string() << "calibration cache directory " << directory << " does not exist");
+
+    std::lock_guard<std::mutex> lock(directory_mutex);
+    cache_directory = directory;
+}
+
+bool calibration_store::is_enabled()
+{
+    std::lock_guard<std::mutex> lock(directory_mutex);
+    return !cache_directory.empty();
+}
+
+std::vector<uint8_t> calibration_store::get(const std::string & key, const std::vector<uint8_t> & signature, std::function<std::vector<uint8_t>()> read_data)
+{
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(directory_mutex);
+        directory = cache_directory;
+    }
+    if (directory.empty()) return read_data();
+
+    auto path = get_path(directory, key);
+    std::vector<uint8_t> data;
+    if (load(path, signature, data))
+    {
+        LOG_INFO("Calibration of " << key << " loaded from " << path);
+        return data;
+    }
+
+    data = read_data();
+    store(path, signature, data);
+    return data;
+}
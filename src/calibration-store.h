@@ -0,0 +1,26 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_CALIBRATION_STORE_H
+#define LIBREALSENSE_CALIBRATION_STORE_H
+
+#include "types.h"
+
+namespace rsimpl
+{
+    // Calibration read from devices, kept in files of a directory chosen by the application so that reopening a device skips the slow reads.
+    // Entries are keyed by the model, serial number and firmware version of a device, and hold the raw data as read along with a signature:
+    // device memory which is cheap to read and changes whenever the calibration is rewritten. An entry whose signature differs is read again.
+    namespace calibration_store
+    {
+        void set_directory(const std::string & directory); // Throws if it is not a directory. An empty directory disables the cache, the default.
+        bool is_enabled();
+
+        // Returns the data stored under key if its signature matches, otherwise the data read_data returns, which is stored in its place.
+        // Files which cannot be read or written only cost the read.
+        std::vector<uint8_t> get(const std::string & key, const std::vector<uint8_t> & signature, std::function<std::vector<uint8_t>()> read_data);
+    }
+}
+
+#endif
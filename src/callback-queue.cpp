@@ -0,0 +1,70 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "callback-queue.h"
+#include "uvc.h"
+
+using namespace rsimpl;
+
+frame_callback_queue::frame_callback_queue(size_t depth, frame_handler on_frame, frame_handler release, rs_frame_drop_policy policy)
+    : depth(policy == RS_FRAME_DROP_POLICY_LATEST_ONLY ? 1 : depth), drop_newest(policy == RS_FRAME_DROP_POLICY_DROP_NEWEST), on_frame(on_frame), release(release), dropped(0)
+{
+    thread = uvc::start_backend_thread([this]() { run(); }); // Callbacks may call back into the backend
+}
+
+void frame_callback_queue::push(rs_frame_ref * frame)
+{
+    rs_frame_ref * released = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) released = frame;
+        else if (drop_newest && frames.size() == depth)
+        {
+            released = frame;
+            ++dropped;
+        }
+        else
+        {
+            if (frames.size() == depth)
+            {
+                released = frames.front();
+                frames.pop_front();
+                ++dropped;
+            }
+            frames.push_back(frame);
+        }
+    }
+    cv.notify_one();
+    if (released) release(released);
+}
+
+void frame_callback_queue::run()
+{
+    while (true)
+    {
+        rs_frame_ref * frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]() { return stopping || !frames.empty(); });
+            if (stopping) return;
+            frame = frames.front();
+            frames.pop_front();
+        }
+
+        try { on_frame(frame); }
+        catch (...) { LOG_ERROR("Received an execption from frame callback!"); }
+    }
+}
+
+void frame_callback_queue::stop()
+{
+    std::deque<rs_frame_ref *> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        abandoned.swap(frames);
+    }
+    cv.notify_all();
+    if (thread.joinable()) thread.join();
+    for (auto frame : abandoned) release(frame);
+}
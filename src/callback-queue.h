@@ -0,0 +1,48 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_CALLBACK_QUEUE_H
+#define LIBREALSENSE_CALLBACK_QUEUE_H
+
+#include "types.h"
+
+#include <deque>
+#include <thread>
+
+namespace rsimpl
+{
+    // Hands the frames of one stream to its callback on a thread of its own, so that a slow callback holds up neither the capture thread
+    // nor the other streams. Frames wait in a bounded queue, and once it is full the oldest queued frame is released to make room, or else
+    // the frame just pushed with RS_FRAME_DROP_POLICY_DROP_NEWEST.
+    class frame_callback_queue
+    {
+    public:
+        typedef std::function<void(rs_frame_ref * frame)> frame_handler;
+    private:
+        const size_t depth;
+        const bool drop_newest;
+        const frame_handler on_frame, release;
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<rs_frame_ref *> frames;
+        bool stopping = false;
+        std::atomic<unsigned long long> dropped;
+        std::thread thread;
+
+        frame_callback_queue(const frame_callback_queue &) = delete;
+        frame_callback_queue & operator=(const frame_callback_queue &) = delete;
+
+        void run();
+    public:
+        frame_callback_queue(size_t depth, frame_handler on_frame, frame_handler release, rs_frame_drop_policy policy = RS_FRAME_DROP_POLICY_DROP_OLDEST); // on_frame takes ownership of the frames passed to it
+        ~frame_callback_queue() { stop(); }
+
+        void push(rs_frame_ref * frame);
+        void stop(); // Waits for the callback in progress, then releases the frames still queued
+        unsigned long long get_dropped_count() const { return dropped; }
+        size_t get_queued_count() const { std::lock_guard<std::mutex> lock(mutex); return frames.size(); }
+    };
+}
+
+#endif
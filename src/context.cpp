@@ -4,11 +4,14 @@
 #include <mutex>
 #include <array>
 #include <string>
+#include <algorithm>
+#include <atomic>
 
 #include "r200.h"
 #include "f200.h"
 #include "sr300.h"
 #include "zr300.h"
+#include "playback.h"
 #include "uvc.h"
 #include "context.h"
 
@@ -51,36 +54,84 @@ bool is_compatible(std::shared_ptr<rs_device> device)
     return device->supports(RS_CAPABILITIES_ENUMERATION);
 }
 
-rs_context_base::rs_context_base()
+// A device being attached raises a burst of notifications, one for each of its interfaces, and its nodes take a moment to become accessible,
+// so the devices are enumerated again only once the notifications have stopped for this long
+static const std::chrono::milliseconds hotplug_settle_time(500);
+
+static std::shared_ptr<rs_device> make_device(std::shared_ptr<rsimpl::uvc::device> device)
 {
-    context = rsimpl::uvc::create_context();
+#ifdef RS_USE_PLAYBACK_BACKEND
+    // Every device of the playback backend is a recording
+    return rsimpl::make_playback_device(device);
+#endif
+    LOG_INFO("UVC device detected with VID = 0x" << std::hex << get_vendor_id(*device) << " PID = 0x" << get_product_id(*device));
+
+    if (get_vendor_id(*device) != VID_INTEL_CAMERA)
+        return nullptr;
+
+    std::shared_ptr<rs_device> rs_dev;
 
-    for(auto device : query_devices(context))
+    switch(get_product_id(*device))
     {
-        LOG_INFO("UVC device detected with VID = 0x" << std::hex << get_vendor_id(*device) << " PID = 0x" << get_product_id(*device));
+        case R200_PRODUCT_ID:  rs_dev = rsimpl::make_r200_device(device); break;
+        case LR200_PRODUCT_ID: rs_dev = rsimpl::make_lr200_device(device); break;
+        case ZR300_PRODUCT_ID: rs_dev = rsimpl::make_zr300_device(device); break;
+        case F200_PRODUCT_ID:  rs_dev = rsimpl::make_f200_device(device); break;
+        case SR300_PRODUCT_ID: rs_dev = rsimpl::make_sr300_device(device); break;
+    }
 
-        if (get_vendor_id(*device) != VID_INTEL_CAMERA)
-            continue;
+    if (rs_dev && is_compatible(rs_dev))
+    {
+        return rs_dev;
+    }
+    LOG_ERROR("Device is not supported by librealsense!");
+    return nullptr;
+}
 
-        std::shared_ptr<rs_device> rs_dev;
+// Devices are opened on up to this many threads at once. Each device keeps its own protocol serialized behind its locks, so that devices
+// proceed in parallel, and the time taken by a rig of cameras approaches that of its slowest camera.
+static const size_t max_parallel_opens = 8;
 
-        switch(get_product_id(*device))
+// Returns the devices in the order of the backend devices they were made from, with null for those which are not supported, and
+// the exception of each device which could not be opened.
+static std::vector<std::shared_ptr<rs_device>> make_devices(const std::vector<std::shared_ptr<rsimpl::uvc::device>> & uvc_devices, std::vector<std::exception_ptr> & errors)
+{
+    std::vector<std::shared_ptr<rs_device>> made(uvc_devices.size());
+    errors.assign(uvc_devices.size(), nullptr);
+    std::atomic<size_t> next(0);
+    auto open_devices = [&]()
+    {
+        for (size_t i; (i = next++) < uvc_devices.size(); )
         {
-            case R200_PRODUCT_ID:  rs_dev = rsimpl::make_r200_device(device); break;
-            case LR200_PRODUCT_ID: rs_dev = rsimpl::make_lr200_device(device); break;
-            case ZR300_PRODUCT_ID: rs_dev = rsimpl::make_zr300_device(device); break;
-            case F200_PRODUCT_ID:  rs_dev = rsimpl::make_f200_device(device); break;
-            case SR300_PRODUCT_ID: rs_dev = rsimpl::make_sr300_device(device); break;
+            try { made[i] = make_device(uvc_devices[i]); }
+            catch (...) { errors[i] = std::current_exception(); }
         }
+    };
 
-        if (rs_dev && is_compatible(rs_dev))
-        {
-            devices.push_back(rs_dev);
-        }
-        else
-        {
-            LOG_ERROR("Device is not supported by librealsense!");
-        }
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(uvc_devices.size(), max_parallel_opens); ++i) threads.push_back(rsimpl::uvc::start_backend_thread(open_devices));
+    open_devices();
+    for (auto & thread : threads) thread.join();
+    return made;
+}
+
+static bool is_same_device(rsimpl::uvc::device & a, rsimpl::uvc::device & b)
+{
+    return get_vendor_id(a) == get_vendor_id(b) && get_product_id(a) == get_product_id(b) && get_device_instance_id(a) == get_device_instance_id(b);
+}
+
+rs_context_base::rs_context_base() : executor(rsimpl::executor::acquire_shared())
+{
+    context = rsimpl::uvc::create_context();
+
+    std::vector<std::exception_ptr> errors;
+    for (auto & rs_dev : make_devices(query_devices(context), errors))
+    {
+        if (rs_dev) devices.push_back(rs_dev);
+    }
+    for (auto & error : errors)
+    {
+        if (error) std::rethrow_exception(error);
     }
 }
 
@@ -112,14 +163,134 @@ void rs_context_base::release_instance()
 rs_context_base::~rs_context_base()
 {
     assert(ref_count == 0);
+    stop_hotplug();
+
+    // Option requests call the overrides of the devices, so they must end before any device starts being destroyed
+    for (auto & device : devices) static_cast<rs_device_base &>(*device).stop_option_requests();
+    for (auto & device : removed_devices) static_cast<rs_device_base &>(*device).stop_option_requests();
 }
 
 size_t rs_context_base::get_device_count() const
 {
+    std::lock_guard<std::mutex> lock(devices_mutex);
     return devices.size();
 }
 
 rs_device* rs_context_base::get_device(int index) const
 {
+    std::lock_guard<std::mutex> lock(devices_mutex);
+    if (index < 0 || index >= static_cast<int>(devices.size())) throw std::runtime_error("the device was removed"); // Between a count and the call
     return devices[index].get();
 }
+
+void rs_context_base::set_devices_changed_callback(rs_devices_changed_callback * callback)
+{
+    rsimpl::devices_changed_callback_ptr next(callback, [](rs_devices_changed_callback * c) { if (c) c->release(); });
+    if (std::this_thread::get_id() == hotplug_thread.get_id()) throw std::logic_error("the devices changed callback cannot be changed from within itself");
+
+    stop_hotplug();
+    if (!next) return;
+
+    on_devices_changed = next;
+    hotplug_pending = true; // Devices may have come and gone since they were enumerated
+    hotplug_thread = rsimpl::uvc::start_backend_thread([this]() { run_hotplug(); });
+    try
+    {
+        rsimpl::uvc::set_devices_changed_callback(*context, [this]()
+        {
+            {
+                std::lock_guard<std::mutex> lock(hotplug_mutex);
+                hotplug_pending = true;
+            }
+            hotplug_cv.notify_one();
+        });
+    }
+    catch (...)
+    {
+        stop_hotplug();
+        throw;
+    }
+}
+
+void rs_context_base::stop_hotplug()
+{
+    rsimpl::uvc::set_devices_changed_callback(*context, nullptr);
+    {
+        std::lock_guard<std::mutex> lock(hotplug_mutex);
+        hotplug_stopping = true;
+    }
+    hotplug_cv.notify_one();
+    if (hotplug_thread.joinable()) hotplug_thread.join();
+    hotplug_stopping = hotplug_pending = false;
+    on_devices_changed.reset();
+}
+
+void rs_context_base::run_hotplug()
+{
+    std::unique_lock<std::mutex> lock(hotplug_mutex);
+    while (true)
+    {
+        hotplug_cv.wait(lock, [this]() { return hotplug_stopping || hotplug_pending; });
+        while (hotplug_pending && !hotplug_stopping)
+        {
+            hotplug_pending = false;
+            hotplug_cv.wait_for(lock, hotplug_settle_time, [this]() { return hotplug_stopping || hotplug_pending; });
+        }
+        if (hotplug_stopping) return;
+
+        lock.unlock();
+        update_devices(*on_devices_changed);
+        lock.lock();
+    }
+}
+
+// Devices still attached are kept as they are, so that only the devices attached since are probed, and their applications are undisturbed
+void rs_context_base::update_devices(rs_devices_changed_callback & callback)
+{
+    std::vector<std::shared_ptr<rsimpl::uvc::device>> attached;
+    try { attached = query_devices(context); }
+    catch (const std::exception & e)
+    {
+        LOG_WARNING("Devices could not be enumerated after a hotplug notification: " << e.what());
+        return;
+    }
+
+    // Only this thread modifies the devices, so it reads them without locking
+    std::vector<std::shared_ptr<rs_device>> kept, added, removed;
+    for (auto & device : devices)
+    {
+        auto & uvc_device = static_cast<rs_device_base &>(*device).get_device();
+        auto it = std::find_if(attached.begin(), attached.end(), [&](const std::shared_ptr<rsimpl::uvc::device> & d) { return is_same_device(*d, uvc_device); });
+        if (it != attached.end())
+        {
+            kept.push_back(device);
+            attached.erase(it);
+        }
+        else removed.push_back(device);
+    }
+    std::vector<std::exception_ptr> errors;
+    auto made = make_devices(attached, errors);
+    for (size_t i = 0; i < made.size(); ++i)
+    {
+        if (made[i]) added.push_back(made[i]);
+        if (!errors[i]) continue;
+        try { std::rethrow_exception(errors[i]); }
+        catch (const std::exception & e) { LOG_WARNING("A device attached could not be opened: " << e.what()); }
+        catch (...) { LOG_WARNING("A device attached could not be opened"); }
+    }
+    if (added.empty() && removed.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(devices_mutex);
+        devices = kept;
+        devices.insert(devices.end(), added.begin(), added.end());
+        removed_devices.insert(removed_devices.end(), removed.begin(), removed.end());
+    }
+
+    try
+    {
+        for (auto & device : removed) callback.on_devices_changed(this, device.get(), 0);
+        for (auto & device : added) callback.on_devices_changed(this, device.get(), 1);
+    }
+    catch (...) { LOG_ERROR("Received an exception from devices changed callback!"); }
+}
@@ -7,10 +7,14 @@
 
 #include "types.h"
 #include "uvc.h"
+#include "executor.h"
+
+#include <thread>
 
 struct rs_context_base : rs_context
 {
     std::shared_ptr<rsimpl::uvc::context>           context;
+    std::shared_ptr<rsimpl::executor>               executor;               // Shared with the devices, which hold on to it
     std::vector<std::shared_ptr<rs_device>>         devices;
 
                                                     rs_context_base();
@@ -21,7 +25,24 @@ struct rs_context_base : rs_context
 
     size_t                                          get_device_count() const override;
     rs_device *                                     get_device(int index) const override;
+    void                                            set_devices_changed_callback(rs_devices_changed_callback * callback) override;
+    void                                            set_executor_threads(int count, uint64_t cpu_mask) override { executor->set_threads(count, cpu_mask); }
+    int                                             get_executor_thread_count() const override { return executor->get_thread_count(); }
+    uint64_t                                        get_executor_cpu_mask() const override { return executor->get_cpu_mask(); }
 private:
+    mutable std::mutex                              devices_mutex;          // Guards devices while the hotplug thread updates them
+    std::vector<std::shared_ptr<rs_device>>         removed_devices;        // Kept alive, as the application may still hold pointers to them
+
+    std::mutex                                      hotplug_mutex;
+    std::condition_variable                         hotplug_cv;
+    bool                                            hotplug_pending = false;    // Set by the backend on every notification
+    bool                                            hotplug_stopping = false;
+    rsimpl::devices_changed_callback_ptr            on_devices_changed;
+    std::thread                                     hotplug_thread;
+
+    void                                            stop_hotplug();
+    void                                            run_hotplug();
+    void                                            update_devices(rs_devices_changed_callback & callback);
     static int                                      ref_count;
     static std::mutex                               instance_lock;
     static rs_context*                              instance;
@@ -0,0 +1,303 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "depth-codec.h"
+
+#include <cstring>
+#include <climits>
+
+// SSE2 is part of every x86-64 target, so unlike the unpackers of image.cpp, the codec needs neither runtime dispatch nor files of its own
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RS_CODEC_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RS_CODEC_NEON
+#include <arm_neon.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace rsimpl;
+
+namespace
+{
+    int count_trailing_zeros(uint64_t x) // x must not be zero
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+#ifdef _M_X64
+        _BitScanForward64(&index, x);
+#else
+        if (!_BitScanForward(&index, static_cast<unsigned long>(x))) { _BitScanForward(&index, static_cast<unsigned long>(x >> 32)); index += 32; }
+#endif
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(x);
+#endif
+    }
+
+    // Length of the run of pixels at the start of [p, end) which are zero if zeros is true, valid otherwise, scanning eight pixels at a time
+    int scan_run(const uint16_t * p, const uint16_t * end, bool zeros)
+    {
+        auto q = p;
+#if defined(RS_CODEC_SSE2)
+        const int stop = zeros ? 0xffff : 0;
+        for (; end - q >= 8; q += 8)
+        {
+            const int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(q)), _mm_setzero_si128()));
+            if (mask != stop) return static_cast<int>(q - p) + count_trailing_zeros(mask ^ stop) / 2;
+        }
+#elif defined(RS_CODEC_NEON)
+        const uint64_t stop = zeros ? ~0ull : 0;
+        for (; end - q >= 8; q += 8)
+        {
+            const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(vceqq_u16(vld1q_u16(q), vdupq_n_u16(0)))), 0); // One byte per pixel
+            if (mask != stop) return static_cast<int>(q - p) + count_trailing_zeros(mask ^ stop) / 8;
+        }
+#endif
+        while (q != end && (*q == 0) == zeros) ++q;
+        return static_cast<int>(q - p);
+    }
+
+    // Zigzag codes of the differences, modulo 2^16, of eight valid pixels to the pixel before each of them. Returns true if all of them fit a nibble.
+    bool zigzag_deltas(uint16_t codes[8], const uint16_t * pixels, uint16_t previous)
+    {
+#if defined(RS_CODEC_SSE2)
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels));
+        const __m128i d = _mm_sub_epi16(v, _mm_insert_epi16(_mm_slli_si128(v, 2), previous, 0));
+        const __m128i z = _mm_xor_si128(_mm_slli_epi16(d, 1), _mm_srai_epi16(d, 15));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(codes), z);
+        return _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(z, _mm_set1_epi16(static_cast<short>(0xfff8))), _mm_setzero_si128())) == 0xffff;
+#elif defined(RS_CODEC_NEON)
+        const uint16x8_t v = vld1q_u16(pixels);
+        const uint16x8_t d = vsubq_u16(v, vextq_u16(vdupq_n_u16(previous), v, 7));
+        const uint16x8_t z = veorq_u16(vshlq_n_u16(d, 1), vreinterpretq_u16_s16(vshrq_n_s16(vreinterpretq_s16_u16(d), 15)));
+        vst1q_u16(codes, z);
+        return vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(vtstq_u16(z, vdupq_n_u16(0xfff8)))), 0) == 0;
+#else
+        uint16_t large = 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            const int16_t d = static_cast<int16_t>(pixels[i] - previous);
+            codes[i] = static_cast<uint16_t>((d << 1) ^ (d >> 15));
+            large |= codes[i] & 0xfff8;
+            previous = pixels[i];
+        }
+        return !large;
+#endif
+    }
+
+    // Inverse of zigzag_deltas, for eight codes which all fit a nibble, packed first code in the most significant bits
+    uint16_t undo_nibble_deltas(uint16_t * pixels, uint32_t nibbles, uint16_t previous)
+    {
+#if defined(RS_CODEC_SSE2) || defined(RS_CODEC_NEON)
+        alignas(16) uint16_t z[8];
+        for (int i = 0; i < 8; ++i) z[i] = (nibbles >> (28 - 4 * i)) & 0xf;
+#endif
+#if defined(RS_CODEC_SSE2)
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(z));
+        v = _mm_xor_si128(_mm_srli_epi16(v, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(v, _mm_set1_epi16(1))));
+        v = _mm_add_epi16(v, _mm_slli_si128(v, 2)); // Prefix sum of the differences
+        v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi16(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi16(v, _mm_set1_epi16(static_cast<short>(previous)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pixels), v);
+#elif defined(RS_CODEC_NEON)
+        const uint16x8_t zero = vdupq_n_u16(0);
+        uint16x8_t v = vld1q_u16(z);
+        v = veorq_u16(vshrq_n_u16(v, 1), vsubq_u16(zero, vandq_u16(v, vdupq_n_u16(1))));
+        v = vaddq_u16(v, vextq_u16(zero, v, 7));
+        v = vaddq_u16(v, vextq_u16(zero, v, 6));
+        v = vaddq_u16(v, vextq_u16(zero, v, 4));
+        v = vaddq_u16(v, vdupq_n_u16(previous));
+        vst1q_u16(pixels, v);
+#else
+        for (int i = 0; i < 8; ++i)
+        {
+            const uint16_t code = (nibbles >> (28 - 4 * i)) & 0xf;
+            previous = pixels[i] = static_cast<uint16_t>(previous + ((code >> 1) ^ (0u - (code & 1))));
+        }
+#endif
+        return pixels[7];
+    }
+
+    class nibble_writer
+    {
+        byte * out;
+        uint64_t pending;           // The last count nibbles written, most recent in the least significant bits
+        int count;                  // Below 8 between calls
+
+        void flush_word()
+        {
+            const uint32_t word = static_cast<uint32_t>(pending >> (4 * (count - 8)));
+            memcpy(out, &word, sizeof(word));
+            out += sizeof(word);
+            count -= 8;
+        }
+    public:
+        explicit nibble_writer(byte * out) : out(out), pending(0), count(0) {}
+
+        void write_value(uint32_t value)
+        {
+            do
+            {
+                uint32_t nibble = value & 0x7;
+                if (value >>= 3) nibble |= 0x8;
+                pending = (pending << 4) | nibble;
+                if (++count == 8) flush_word();
+            } while (value);
+        }
+
+        void write_nibbles(uint32_t nibbles) // Eight values below 8 at once, first value in the most significant bits
+        {
+            pending = (pending << 32) | nibbles;
+            count += 8;
+            flush_word();
+        }
+
+        byte * finish()
+        {
+            if (count)
+            {
+                pending <<= 4 * (8 - count);
+                count = 8;
+                flush_word();
+            }
+            return out;
+        }
+    };
+
+    class nibble_reader
+    {
+        const byte * in, * end;
+        uint64_t pending;           // The next count nibbles, next one in the most significant bits
+        int count;
+
+        void refill()
+        {
+            if (count <= 8 && end - in >= 4)
+            {
+                uint32_t word;
+                memcpy(&word, in, sizeof(word));
+                in += sizeof(word);
+                pending |= static_cast<uint64_t>(word) << (32 - 4 * count);
+                count += 8;
+            }
+        }
+    public:
+        nibble_reader(const byte * in, const byte * end) : in(in), end(end), pending(0), count(0) {}
+
+        uint32_t read_value()
+        {
+            uint32_t value = 0;
+            for (int shift = 0; ; shift += 3)
+            {
+                if (!count) refill();
+                if (!count) throw std::runtime_error("encoded depth image is truncated");
+                if (shift > 30) throw std::runtime_error("encoded depth image is corrupted");
+                const uint32_t nibble = static_cast<uint32_t>(pending >> 60);
+                pending <<= 4;
+                --count;
+                value |= (nibble & 0x7) << shift;
+                if (!(nibble & 0x8)) return value;
+            }
+        }
+
+        bool read_nibbles(uint32_t & nibbles) // Reads the next eight nibbles only if none of them continues a value
+        {
+            refill();
+            if (count < 8) return false;
+            const uint32_t next = static_cast<uint32_t>(pending >> 32);
+            if (next & 0x88888888) return false;
+            nibbles = next;
+            pending <<= 32;
+            count -= 8;
+            return true;
+        }
+    };
+}
+
+size_t rsimpl::rvl_max_encoded_size(int pixel_count)
+{
+    // Runs of z zeros and n valid pixels take at most 1 + z + 7n nibbles, and at most one run of zeros ends the image with another nibble
+    return sizeof(uint32_t) + sizeof(uint32_t) * (static_cast<size_t>(pixel_count) + 1);
+}
+
+size_t rsimpl::rvl_encode(byte * out, const uint16_t * pixels, int pixel_count)
+{
+    const uint32_t count = pixel_count;
+    memcpy(out, &count, sizeof(count));
+    nibble_writer writer(out + sizeof(count));
+
+    const uint16_t * p = pixels, * end = pixels + pixel_count;
+    uint16_t previous = 0;
+    while (p != end)
+    {
+        const int zeros = scan_run(p, end, true);
+        p += zeros;
+        const int valid = scan_run(p, end, false);
+        writer.write_value(zeros);
+        writer.write_value(valid);
+
+        auto run_end = p + valid;
+        uint16_t codes[8];
+        for (; run_end - p >= 8; p += 8)
+        {
+            if (zigzag_deltas(codes, p, previous))
+            {
+                uint32_t nibbles = 0;
+                for (int i = 0; i < 8; ++i) nibbles = (nibbles << 4) | codes[i];
+                writer.write_nibbles(nibbles);
+            }
+            else for (int i = 0; i < 8; ++i) writer.write_value(codes[i]);
+            previous = p[7];
+        }
+        for (; p != run_end; ++p)
+        {
+            const int16_t d = static_cast<int16_t>(*p - previous);
+            writer.write_value(static_cast<uint16_t>((d << 1) ^ (d >> 15)));
+            previous = *p;
+        }
+    }
+    return writer.finish() - out;
+}
+
+int rsimpl::rvl_get_pixel_count(const byte * in, size_t size)
+{
+    uint32_t count;
+    if (size < sizeof(count)) return -1;
+    memcpy(&count, in, sizeof(count));
+    return count > static_cast<uint32_t>(INT_MAX) ? -1 : static_cast<int>(count);
+}
+
+void rsimpl::rvl_decode(uint16_t * pixels, int pixel_count, const byte * in, size_t size)
+{
+    if (rvl_get_pixel_count(in, size) != pixel_count) throw std::runtime_error("encoded depth image does not have the expected number of pixels");
+    nibble_reader reader(in + sizeof(uint32_t), in + size);
+
+    uint16_t * p = pixels, * end = pixels + pixel_count;
+    uint16_t previous = 0;
+    while (p != end)
+    {
+        const uint32_t zeros = reader.read_value();
+        const uint32_t valid = reader.read_value();
+        if (zeros > static_cast<size_t>(end - p) || valid > static_cast<size_t>(end - p) - zeros) throw std::runtime_error("encoded depth image is corrupted");
+        memset(p, 0, zeros * sizeof(uint16_t));
+        p += zeros;
+
+        auto run_end = p + valid;
+        uint32_t nibbles;
+        while (p != run_end)
+        {
+            if (run_end - p >= 8 && reader.read_nibbles(nibbles))
+            {
+                previous = undo_nibble_deltas(p, nibbles, previous);
+                p += 8;
+                continue;
+            }
+            const uint32_t code = reader.read_value();
+            previous = *p++ = static_cast<uint16_t>(previous + ((code >> 1) ^ (0u - (code & 1))));
+        }
+    }
+}
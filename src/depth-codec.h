@@ -0,0 +1,23 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_DEPTH_CODEC_H
+#define LIBREALSENSE_DEPTH_CODEC_H
+
+#include "types.h"
+
+namespace rsimpl
+{
+    // Lossless run length and variable length coding of Z16 images (RVL). An image alternates runs of zero pixels, where the camera has no depth,
+    // and runs of valid pixels. Each pair of runs is coded as the length of both runs, followed by the difference of every valid pixel to the valid
+    // pixel before it, zigzag encoded so that small steps of either sign stay small. Every number is coded in 3 bit groups with a continuation bit,
+    // least significant group first, eight such nibbles to a 32 bit word, first nibble in the most significant bits. The words follow a 32 bit count
+    // of the pixels of the image, all in the byte order of the host.
+    size_t rvl_max_encoded_size(int pixel_count); // Bytes rvl_encode may write for an image of pixel_count pixels
+    size_t rvl_encode(byte * out, const uint16_t * pixels, int pixel_count); // Returns the bytes written to out
+    void rvl_decode(uint16_t * pixels, int pixel_count, const byte * in, size_t size); // Throws when in is not an image of pixel_count pixels
+    int rvl_get_pixel_count(const byte * in, size_t size); // Returns -1 when in is too short to be an encoded image
+}
+
+#endif
@@ -6,23 +6,45 @@
 #include "motion-module.h"
 #include "hw-monitor.h"
 #include "image.h"
+#include "pipeline.h"
+#include "task-graph.h"
+#include "option-queue.h"
+#include "hw-command-queue.h"
+#include "callback-queue.h"
+#include "motion-history.h"
+#include "recording.h"
+#include "shared-ring.h"
+#include "frame-history.h"
+#include "numa.h"
+#include "trace.h"
+#include "video-encoder.h"
 
 #include <array>
 #include <algorithm>
 #include <sstream>
 #include <iostream>
+#include <cmath>
 #include <functional>
 
 using namespace rsimpl;
 using namespace rsimpl::motion_module;
 
 const int NUMBER_OF_FRAMES_TO_SAMPLE = 5;
+const int COPIED_STREAM_BUFFER_COUNT = 4;       // Frames are unpacked inside the callback, so a driver buffer is requeued right away
+const int ZERO_COPY_STREAM_BUFFER_COUNT = 8;    // Covers the sync queues and the frontbuffer, with room left for the driver to keep capturing
+const size_t FRAME_BUFFER_ALIGNMENT = 64;       // Lets unpackers use aligned vector loads and stores on frames in buffers of the application
+const int FW_LOG_MAX_INTERVAL = 16;             // Grab periods between reads of a firmware log found empty again and again
+const size_t FW_LOG_RING_SIZE = 256 * 1024;
 
-rs_device_base::rs_device_base(std::shared_ptr<rsimpl::uvc::device> device, const rsimpl::static_device_info & info, calibration_validator validator) : device(device), config(info),
+rs_device_base::rs_device_base(std::shared_ptr<rsimpl::uvc::device> device, const rsimpl::static_device_info & info, calibration_validator validator) : device(device), config(info), shared_executor(executor::acquire_shared()),
     depth(config, RS_STREAM_DEPTH, validator), color(config, RS_STREAM_COLOR, validator), infrared(config, RS_STREAM_INFRARED, validator), infrared2(config, RS_STREAM_INFRARED2, validator), fisheye(config, RS_STREAM_FISHEYE, validator),
-    points(depth), rect_color(color), color_to_depth(color, depth), depth_to_color(depth, color), depth_to_rect_color(depth, rect_color), infrared2_to_depth(infrared2,depth), depth_to_infrared2(depth,infrared2),
-    capturing(false), data_acquisition_active(false), max_publish_list_size(RS_USER_QUEUE_SIZE), event_queue_size(RS_MAX_EVENT_QUEUE_SIZE), events_timeout(RS_MAX_EVENT_TIME_OUT),
-    usb_port_id(""), motion_module_ready(false), keep_fw_logger_alive(false), frames_drops_counter(0)
+    points(depth, color), rect_color(color), rect_fisheye(fisheye, RS_STREAM_RECTIFIED_FISHEYE), color_to_depth(color, depth, RS_STREAM_COLOR_ALIGNED_TO_DEPTH), depth_to_color(depth, color, RS_STREAM_DEPTH_ALIGNED_TO_COLOR), depth_to_rect_color(depth, rect_color, RS_STREAM_DEPTH_ALIGNED_TO_RECTIFIED_COLOR),
+    infrared2_to_depth(infrared2, depth, RS_STREAM_INFRARED2_ALIGNED_TO_DEPTH), depth_to_infrared2(depth, infrared2, RS_STREAM_DEPTH_ALIGNED_TO_INFRARED2), depth_colorized(depth), normals(depth),
+    capturing(false), paused(false), data_acquisition_active(false), max_publish_list_size(RS_USER_QUEUE_SIZE), event_queue_size(RS_MAX_EVENT_QUEUE_SIZE), events_timeout(RS_MAX_EVENT_TIME_OUT), unpack_threads(0), capture_cpu_mask(0), capture_priority(0), capture_memory_type(uvc::capture_memory::mapped), frame_pages(frame_memory_pages::heap), numa_local(false), zero_copy(false), mailbox(false), motion_data_transfers(RS_DEFAULT_MOTION_DATA_TRANSFERS), precomputed_streams(0), frames_ready(new frames_ready_signal()),
+    option_requests(new option_request_queue(*shared_executor, [this](const rs_option options[], size_t count, const double values[]) { set_options(options, count, values); },
+                                             [this](const rs_option options[], size_t count, double values[]) { get_options(options, count, values); })),
+    option_transaction_open(false),
+    on_demand_subdevices(0), idle_subdevices(0), last_load_check(0), memory(std::make_shared<memory_account>()), usb_port_id(""), fw_log_interval(1), fw_log_periods(0), fw_log(FW_LOG_RING_SIZE), motion_module_ready(false), keep_fw_logger_alive(false), frames_drops_counter(0)
 {
     streams[RS_STREAM_DEPTH    ] = native_streams[RS_STREAM_DEPTH]     = &depth;
     streams[RS_STREAM_COLOR    ] = native_streams[RS_STREAM_COLOR]     = &color;
@@ -36,12 +58,19 @@ rs_device_base::rs_device_base(std::shared_ptr<rsimpl::uvc::device> device, cons
     streams[RS_STREAM_DEPTH_ALIGNED_TO_RECTIFIED_COLOR]                = &depth_to_rect_color;
     streams[RS_STREAM_INFRARED2_ALIGNED_TO_DEPTH]                      = &infrared2_to_depth;
     streams[RS_STREAM_DEPTH_ALIGNED_TO_INFRARED2]                      = &depth_to_infrared2;
+    streams[RS_STREAM_DEPTH_COLORIZED]                                 = &depth_colorized;
+    streams[RS_STREAM_RECTIFIED_FISHEYE]                               = &rect_fisheye;
+    streams[RS_STREAM_NORMALS]                                         = &normals;
+
+    for (auto s : native_streams) s->demand = &demand;
+    demand.set_wake_handler([this]() { if (auto monitor = std::atomic_load(&demand_monitor)) monitor->trigger(); });
 }
 
 rs_device_base::~rs_device_base()
 {
     try
     {
+        stop_option_requests();
         if (capturing) 
             stop(RS_SOURCE_VIDEO);
         if (data_acquisition_active)
@@ -70,6 +99,14 @@ const char* rs_device_base::get_camera_info(rs_camera_info info) const
 void rs_device_base::enable_stream(rs_stream stream, int width, int height, rs_format format, int fps, rs_output_buffer_format output)
 {
     if(capturing) throw std::runtime_error("streams cannot be reconfigured after having called rs_start_device()");
+    if(stream == RS_STREAM_POINTS)
+    {
+        // The point cloud follows the depth stream, only the encoding of its points can be chosen
+        if(width || height || fps) throw std::runtime_error("points take their resolution and framerate from the depth stream");
+        if(format != RS_FORMAT_ANY && format != RS_FORMAT_XYZ32F && format != RS_FORMAT_XYZ16F && format != RS_FORMAT_XYZ16 && format != RS_FORMAT_XYZUV32F && format != RS_FORMAT_XYZ32F_PLANAR) throw std::runtime_error(to_string() << "unsupported points format: " << format);
+        points.set_format(format == RS_FORMAT_ANY ? RS_FORMAT_XYZ32F : format);
+        return;
+    }
     if(config.info.stream_subdevices[stream] == -1) throw std::runtime_error("unsupported stream");
 
     config.requests[stream] = { true, width, height, format, fps, output };
@@ -98,6 +135,11 @@ rs_extrinsics rs_device_base::get_motion_extrinsics_from(rs_stream /*from*/) con
 void rs_device_base::disable_stream(rs_stream stream)
 {
     if(capturing) throw std::runtime_error("streams cannot be reconfigured after having called rs_start_device()");
+    if(stream == RS_STREAM_POINTS)
+    {
+        points.set_format(RS_FORMAT_XYZ32F);
+        return;
+    }
     if(config.info.stream_subdevices[stream] == -1) throw std::runtime_error("unsupported stream");
 
     config.callbacks[stream] = {};
@@ -105,6 +147,201 @@ void rs_device_base::disable_stream(rs_stream stream)
     for(auto & s : native_streams) s->archive.reset(); // Changing stream configuration invalidates the current stream info
 }
 
+void rs_device_base::set_stream_roi(rs_stream stream, int x, int y, int width, int height)
+{
+    if(capturing) throw std::runtime_error("streams cannot be reconfigured after having called rs_start_device()");
+    streams[stream]->set_roi({ x, y, width, height });
+}
+
+void rs_device_base::set_stream_decimation(rs_stream stream, int factor)
+{
+    if(capturing) throw std::runtime_error("streams cannot be reconfigured after having called rs_start_device()");
+    for(auto aligned : { &color_to_depth, &depth_to_color, &depth_to_rect_color, &infrared2_to_depth, &depth_to_infrared2 })
+    {
+        if(aligned->get_stream_type() != stream) continue;
+        aligned->set_decimation(factor);
+        return;
+    }
+    throw std::runtime_error(to_string() << "only aligned streams can be decimated, not " << get_string(stream));
+}
+
+void rs_device_base::set_stream_queue_policy(rs_stream stream, int depth, rs_frame_drop_policy policy)
+{
+    if(capturing) throw std::runtime_error("stream queues cannot be reconfigured after having called rs_start_device()");
+    if(depth < 1 || depth > RS_MAX_STREAM_QUEUE_DEPTH) throw std::runtime_error(to_string() << "stream queue depth must be between 1 and " << RS_MAX_STREAM_QUEUE_DEPTH);
+
+    config.queue_policies[stream] = { depth, policy };
+}
+
+void rs_device_base::get_stream_queue_policy(rs_stream stream, int & depth, rs_frame_drop_policy & policy) const
+{
+    depth = config.queue_policies[stream].depth;
+    policy = config.queue_policies[stream].policy;
+}
+
+void rs_device_base::set_stream_capture_dmabufs(rs_stream stream, const int fds[], int count)
+{
+    if(capturing) throw std::runtime_error("capture dma-bufs cannot be changed after having called rs_start_device()");
+    config.capture_dmabufs[stream].assign(fds, fds + count);
+}
+
+void rs_device_base::set_stream_capture_buffer_count(rs_stream stream, int count)
+{
+    if(capturing) throw std::runtime_error("capture buffer counts cannot be changed after having called rs_start_device()");
+    if(count != 0)
+    {
+        int min, max;
+        get_subdevice_buffer_count_range(*device, min, max);
+        if(!max) throw std::runtime_error("the capture buffer count cannot be changed on this platform");
+        if(count < min || count > max) throw std::runtime_error(to_string() << "capture buffer count must be between " << min << " and " << max << " on this platform, or 0");
+    }
+    config.capture_buffer_counts[stream] = count;
+}
+
+void rs_device_base::set_stream_crop(rs_stream stream, int x, int y, int width, int height)
+{
+    if(capturing) throw std::runtime_error("stream crops cannot be changed after having called rs_start_device()");
+    if(!width) config.crops[stream] = {};
+    else if(x < 0 || y < 0 || width < 0 || height <= 0) throw std::runtime_error("crops must have a positive size at non-negative coordinates");
+    else config.crops[stream] = { x, y, width, height };
+}
+
+bool rs_device_base::is_stream_cropped_in_driver(rs_stream stream) const
+{
+    return capturing && native_streams[stream]->is_enabled() && native_streams[stream]->get_mode().cropped_in_driver;
+}
+
+void rs_device_base::set_stream_frame_buffers(rs_stream stream, void * const buffers[], int count, int buffer_size)
+{
+    if(capturing) throw std::runtime_error("frame buffers cannot be changed after having called rs_start_device()");
+    if(!count)
+    {
+        config.frame_buffers[stream].reset();
+        return;
+    }
+    for(int i = 0; i < count; ++i)
+    {
+        if(reinterpret_cast<uintptr_t>(buffers[i]) % FRAME_BUFFER_ALIGNMENT) throw std::runtime_error(to_string() << "frame buffers must be aligned to " << FRAME_BUFFER_ALIGNMENT << " bytes");
+    }
+    config.frame_buffers[stream] = std::make_shared<user_frame_buffers>(buffers, count, buffer_size);
+}
+
+void rs_device_base::set_stream_callback_queue(rs_stream stream, int depth)
+{
+    if(capturing) throw std::runtime_error("callback queues cannot be changed after having called rs_start_device()");
+    config.callback_queue_depths[stream] = depth;
+}
+
+unsigned long long rs_device_base::get_stream_callback_drops(rs_stream stream) const
+{
+    return callback_queues[stream] ? callback_queues[stream]->get_dropped_count() : 0;
+}
+
+int rs_device_base::add_frame_subscriber(rs_stream stream, rs_frame_callback * callback, int depth, rs_frame_drop_policy policy)
+{
+    std::shared_ptr<rs_frame_callback> on_frame(callback, [](rs_frame_callback * c) { c->release(); });
+    if(capturing) throw std::runtime_error("frame subscribers cannot be changed after having called rs_start_device()");
+    config.subscribers[stream].push_back({ ++config.last_subscriber_id, on_frame, { depth, policy } });
+    return config.last_subscriber_id;
+}
+
+void rs_device_base::remove_frame_subscriber(rs_stream stream, int subscriber)
+{
+    if(capturing) throw std::runtime_error("frame subscribers cannot be changed after having called rs_start_device()");
+    auto & subscribers = config.subscribers[stream];
+    auto it = std::find_if(subscribers.begin(), subscribers.end(), [subscriber](const frame_subscriber & s) { return s.id == subscriber; });
+    if(it == subscribers.end()) throw std::runtime_error(to_string() << "no subscriber " << subscriber << " to " << get_string(stream));
+    subscribers.erase(it);
+}
+
+unsigned long long rs_device_base::get_frame_subscriber_drops(rs_stream stream, int subscriber) const
+{
+    for(auto & queue : subscriber_queues[stream]) if(queue.first == subscriber) return queue.second ? queue.second->get_dropped_count() : 0;
+    return 0;
+}
+
+// Hands a frame to a frame callback, which takes ownership of it, accounting for the time spent in the callback
+void rs_device_base::invoke_frame_callback(rs_stream stream, rs_frame_callback * callback, rs_frame_ref * frame, std::chrono::high_resolution_clock::time_point capture_start_time)
+{
+    auto ref = (frame_archive::frame_ref *)frame;
+    ref->update_frame_callback_start_ts(std::chrono::high_resolution_clock::now());
+    ref->log_callback_start(capture_start_time);
+    ref->log_delivery(&latency_histograms);
+    const double callback_start = get_monotonic_time();
+    callback->on_frame(this, frame);
+    metrics.add(stream, RS_STREAM_METRIC_CALLBACK_NANOSECONDS, stream_metrics::to_nanoseconds(get_monotonic_time() - callback_start));
+}
+
+void rs_device_base::set_stream_idle_timeout(rs_stream stream, int milliseconds)
+{
+    if(capturing) throw std::runtime_error("idle timeouts cannot be changed after having called rs_start_device()");
+    config.idle_timeouts[stream] = milliseconds;
+}
+
+void rs_device_base::set_stream_sync_tolerance(rs_stream stream, double milliseconds)
+{
+    if(capturing) throw std::runtime_error("sync tolerances cannot be changed after having called rs_start_device()");
+    config.sync_tolerances[stream] = milliseconds;
+}
+
+void rs_device_base::set_load_shedding(const rs_load_shedding_action actions[], int count)
+{
+    if(capturing) throw std::runtime_error("load shedding cannot be changed after having called rs_start_device()");
+    std::vector<rs_load_shedding_action> order(actions, actions + count);
+    for(auto it = order.begin(); it != order.end(); ++it)
+    {
+        if(std::find(order.begin(), it, *it) != it) throw std::runtime_error(to_string() << "load shedding action " << get_string(*it) << " is listed more than once");
+    }
+    shedding.set_order(order);
+}
+
+void rs_device_base::get_memory_usage(unsigned long long & current, unsigned long long & peak) const
+{
+    // The images of the derived streams are allocated by their vectors, and only grow, so they are added whenever usage is asked for
+    size_t images = 0;
+    for(int s = RS_STREAM_NATIVE_COUNT; s < RS_STREAM_COUNT; ++s) images += streams[s]->get_image_memory();
+    current = memory->get_current() + images;
+    memory->raise_peak(current);
+    peak = memory->get_peak();
+}
+
+void rs_device_base::get_stream_latency_histogram(rs_stream stream, rs_frame_metadata stage, unsigned long long counts[]) const
+{
+    latency_histograms.stages[stream][stage - RS_FRAME_METADATA_TIME_OF_VALIDATION].read(counts);
+}
+
+void rs_device_base::get_stream_exposure_latency_histogram(rs_stream stream, unsigned long long counts[]) const
+{
+    latency_histograms.exposure_to_delivery[stream].read(counts);
+}
+
+void rs_device_base::reset_latency_histograms()
+{
+    for (auto & stream : latency_histograms.stages) for (auto & stage : stream) stage.reset();
+    for (auto & stream : latency_histograms.exposure_to_delivery) stream.reset();
+}
+
+unsigned long long rs_device_base::get_stream_metric(rs_stream stream, rs_stream_metric metric) const
+{
+    return metrics.get(stream, metric);
+}
+
+unsigned long long rs_device_base::get_transfer_statistic(rs_stream stream, rs_transfer_statistic statistic) const
+{
+    const int subdevice = config.info.stream_subdevices[stream];
+    if (subdevice < 0) throw std::runtime_error(to_string() << "device does not support " << stream);
+    const auto statistics = get_subdevice_transfer_statistics(*device, subdevice);
+    switch (statistic)
+    {
+    case RS_TRANSFER_STATISTIC_BYTES: return statistics.bytes;
+    case RS_TRANSFER_STATISTIC_BYTES_PER_SECOND: return statistics.bytes_per_second;
+    case RS_TRANSFER_STATISTIC_FRAMES: return statistics.frames;
+    case RS_TRANSFER_STATISTIC_SHORT_FRAMES: return statistics.short_frames;
+    case RS_TRANSFER_STATISTIC_ERRORS: return statistics.errors;
+    default: throw std::logic_error("not a valid transfer statistic");
+    }
+}
+
 void rs_device_base::set_stream_callback(rs_stream stream, void (*on_frame)(rs_device * device, rs_frame_ref * frame, void * user), void * user)
 {
     config.callbacks[stream] = frame_callback_ptr(new frame_callback{ this, on_frame, user });
@@ -115,6 +352,130 @@ void rs_device_base::set_stream_callback(rs_stream stream, rs_frame_callback* ca
     config.callbacks[stream] = frame_callback_ptr(callback);
 }
 
+void rs_device_base::set_frameset_callback(void(*on_frameset)(rs_device * device, rs_frameset * frames, void * user), void * user)
+{
+    if (!on_frameset)
+    {
+        if (capturing) throw std::runtime_error("frameset callback cannot be changed after having called rs_start_device()");
+        config.frameset_callback.reset();
+        return;
+    }
+    set_frameset_callback(new frameset_callback(this, on_frameset, user));
+}
+
+void rs_device_base::set_frameset_callback(rs_frameset_callback * callback)
+{
+    if (capturing)
+    {
+        callback->release();
+        throw std::runtime_error("frameset callback cannot be changed after having called rs_start_device()");
+    }
+    config.frameset_callback = frameset_callback_ptr(callback, [](rs_frameset_callback * c) { c->release(); });
+}
+
+void rs_device_base::set_stream_slice_callback(rs_stream stream, int rows_per_slice, void(*on_slice)(rs_device * device, const void * rows, int width, int first_row, int row_count, void * user), void * user)
+{
+    set_stream_slice_callback(stream, rows_per_slice, on_slice ? new slice_callback(on_slice, user) : nullptr);
+}
+
+void rs_device_base::set_stream_slice_callback(rs_stream stream, int rows_per_slice, rs_slice_callback * callback)
+{
+    slice_callback_ptr on_slice(callback, [](rs_slice_callback * c) { if (c) c->release(); });
+    if (capturing) throw std::runtime_error("slice callbacks cannot be changed after having called rs_start_device()");
+    config.slice_callbacks[stream] = callback ? on_slice : nullptr;
+    config.slice_rows[stream] = callback ? rows_per_slice : 0;
+}
+
+void rs_device_base::set_stream_encoder(rs_stream stream, int bitrate, void(*on_packet)(rs_device * device, rs_stream stream, rs_encoded_packet packet, void * user), void * user)
+{
+    set_stream_encoder(stream, bitrate, on_packet ? new encoded_packet_callback(on_packet, user) : nullptr);
+}
+
+void rs_device_base::set_stream_encoder(rs_stream stream, int bitrate, rs_encoded_packet_callback * callback)
+{
+    encoded_packet_callback_ptr on_packet(callback, [](rs_encoded_packet_callback * c) { if (c) c->release(); });
+    if (capturing) throw std::runtime_error("encoders cannot be changed after having called rs_start_device()");
+    if (callback && !video::is_available()) throw std::runtime_error("encoding requires a library built with BUILD_WITH_FFMPEG");
+    config.encoded_packet_callbacks[stream] = callback ? on_packet : nullptr;
+    config.encoder_bitrates[stream] = callback ? bitrate : 0;
+}
+
+void rs_device_base::set_options_async(const rs_option options[], size_t count, const double values[], rs_options_callback * callback)
+{
+    options_callback_ptr on_options(callback, [](rs_options_callback * c) { if (c) c->release(); });
+    option_requests->set(options, count, values, [this, on_options](const rs_option options[], size_t count, const double values[], const char * error_message)
+    {
+        if (on_options) on_options->on_options(this, options, (unsigned int)count, values, error_message);
+    });
+}
+
+void rs_device_base::get_options_async(const rs_option options[], size_t count, rs_options_callback * callback)
+{
+    options_callback_ptr on_options(callback, [](rs_options_callback * c) { c->release(); });
+    option_requests->get(options, count, [this, on_options](const rs_option options[], size_t count, const double values[], const char * error_message)
+    {
+        on_options->on_options(this, options, (unsigned int)count, values, error_message);
+    });
+}
+
+void rs_device_base::stop_option_requests()
+{
+    option_requests->stop();
+}
+
+void rs_device_base::begin_options()
+{
+    std::lock_guard<std::mutex> lock(option_transaction_mutex);
+    if (option_transaction_open) throw std::runtime_error("an option transaction is already open");
+    option_transaction_open = true;
+}
+
+bool rs_device_base::hold_options(const rs_option options[], size_t count, const double values[])
+{
+    std::lock_guard<std::mutex> lock(option_transaction_mutex);
+    if (!option_transaction_open) return false;
+    for (size_t i = 0; i < count; ++i) held_options.push_back({ options[i], values[i] });
+    return true;
+}
+
+void rs_device_base::commit_options()
+{
+    std::vector<std::pair<rs_option, double>> held;
+    {
+        std::lock_guard<std::mutex> lock(option_transaction_mutex);
+        if (!option_transaction_open) throw std::runtime_error("no option transaction is open");
+        option_transaction_open = false;
+        held.swap(held_options);
+    }
+
+    // Only the last write of every option is carried out, in the order of those writes, so that a single call to the most derived
+    // set_options() sees every option sharing a hardware structure or control at once
+    std::vector<rs_option> options;
+    std::vector<double> values;
+    for (size_t i = 0; i < held.size(); ++i)
+    {
+        if (std::any_of(held.begin() + i + 1, held.end(), [&](const std::pair<rs_option, double> & later) { return later.first == held[i].first; })) continue;
+        options.push_back(held[i].first);
+        values.push_back(held[i].second);
+    }
+    if (!options.empty()) set_options(options.data(), options.size(), values.data());
+}
+
+void rs_device_base::set_frame_allocator(void *(*allocate)(int size, void * user), void(*deallocate)(void * ptr, int size, void * user), void * user)
+{
+    set_frame_allocator(new frame_allocator(allocate, deallocate, user));
+}
+
+void rs_device_base::set_frame_allocator(rs_frame_allocator * allocator)
+{
+    if (capturing)
+    {
+        allocator->release();
+        throw std::runtime_error("frame allocator cannot be changed after having called rs_start_device()");
+    }
+    config.frame_allocator = std::shared_ptr<rs_frame_allocator>(allocator, [](rs_frame_allocator * a) { a->release(); });
+}
+
 void rs_device_base::enable_motion_tracking()
 {
     if (data_acquisition_active) throw std::runtime_error("motion-tracking cannot be reconfigured after having called rs_start_device()");
@@ -142,18 +503,50 @@ void rs_device_base::start_motion_tracking()
     if (data_acquisition_active) throw std::runtime_error("cannot restart data acquisition without stopping first");
 
     auto parser = std::make_shared<motion_module_parser>();
+    auto motion_batch = std::make_shared<std::vector<rs_motion_data>>();
+    auto timestamp_batch = std::make_shared<std::vector<rs_timestamp_data>>();
+    auto history = std::make_shared<motion_history>();
+    std::atomic_store(&motion_samples, history);
 
     // Activate data polling handler
     if (config.data_request.enabled)
     {
         // TODO -replace hard-coded value 3 which stands for fisheye subdevice   
         set_subdevice_data_channel_handler(*device, 3,
-            [this, parser](const unsigned char * data, const int size) mutable
+            [this, parser, motion_batch, timestamp_batch, history](const unsigned char * data, const int size) mutable
         {
             if (motion_module_ready)    //  Flush all received data before MM is fully operational 
             {
+                auto writer = std::atomic_load(&recorder);
+                auto ring = std::atomic_load(&publisher);
+                if (writer || ring)
+                {
+                    recording::motion_record record = { 3, 0, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() };
+                    if (writer) writer->write_motion(record, data, size);
+                    if (ring) ring->publish_motion(record, data, size);
+                }
+
                 // Parse motion data
-                auto events = (*parser)(data, size);
+                auto & events = (*parser)(data, size);
+                for (auto & entry : events)
+                    for (int i = 0; i < entry.imu_entries_num; i++)
+                        history->push(entry.imu_packets[i]);
+
+                // Gather the events of the whole transfer for a single call of the batch callback, the buffers keeping their capacity between transfers
+                if (config.motion_batch_callback)
+                {
+                    motion_batch->clear();
+                    timestamp_batch->clear();
+                    for (auto & entry : events)
+                    {
+                        motion_batch->insert(motion_batch->end(), entry.imu_packets, entry.imu_packets + entry.imu_entries_num);
+                        timestamp_batch->insert(timestamp_batch->end(), entry.non_imu_packets, entry.non_imu_packets + entry.non_imu_entries_num);
+                    }
+                    if (sync_archive) for (auto & tse : *timestamp_batch) sync_archive->on_timestamp(tse);
+                    if (!motion_batch->empty() || !timestamp_batch->empty())
+                        config.motion_batch_callback->on_events(motion_batch->data(), (int)motion_batch->size(), timestamp_batch->data(), (int)timestamp_batch->size());
+                    return;
+                }
 
                 // Handle events by user-provided handlers
                 for (auto & entry : events)
@@ -169,8 +562,8 @@ void rs_device_base::start_motion_tracking()
                         for (int i = 0; i < entry.non_imu_entries_num; i++)
                         {
                             auto tse = entry.non_imu_packets[i];
-                            if (archive)
-                                archive->on_timestamp(tse);
+                            if (sync_archive)
+                                sync_archive->on_timestamp(tse);
 
                             config.timestamp_callback->on_event(entry.non_imu_packets[i]);
                         }
@@ -180,7 +573,7 @@ void rs_device_base::start_motion_tracking()
         });
     }
 
-    start_data_acquisition(*device);     // activate polling thread in the backend
+    start_data_acquisition(*device, motion_data_transfers);     // activate polling thread in the backend
     data_acquisition_active = true;
 }
 
@@ -212,6 +605,142 @@ void rs_device_base::set_timestamp_callback(rs_timestamp_callback* callback)
     config.timestamp_callback = timestamp_callback_ptr(callback, [](rs_timestamp_callback* c) { c->release(); });
 }
 
+void rs_device_base::set_motion_batch_callback(void(*on_events)(rs_device * device, const rs_motion_data * motion, int motion_count, const rs_timestamp_data * timestamps, int timestamp_count, void * user), void * user)
+{
+    if (data_acquisition_active) throw std::runtime_error("cannot set motion batch callback when motion data is active");
+
+    config.motion_batch_callback = on_events ? motion_batch_callback_ptr(new motion_batch_events_callback(this, on_events, user), [](rs_motion_batch_callback* c) { c->release(); })
+                                             : motion_batch_callback_ptr(nullptr, [](rs_motion_batch_callback*) {});
+}
+
+void rs_device_base::set_motion_batch_callback(rs_motion_batch_callback* callback)
+{
+    if (data_acquisition_active) throw std::runtime_error("cannot set motion batch callback when motion data is active");
+
+    config.motion_batch_callback = motion_batch_callback_ptr(callback, [](rs_motion_batch_callback* c) { c->release(); });
+}
+
+bool rs_device_base::get_motion_sample_at(rs_event_source source, double timestamp, rs_motion_data & sample) const
+{
+    auto history = std::atomic_load(&motion_samples);
+    return history && history->get_sample_at(source, timestamp, sample);
+}
+
+void rs_device_base::start_recording(const char * path)
+{
+    if (std::atomic_load(&recorder)) throw std::runtime_error("device is already recording");
+
+    auto writer = std::make_shared<recording::writer>(path, RS_RECORDING_CHUNK_SIZE, RS_RECORDING_CHUNK_COUNT);
+    writer->write_device(describe_device());
+    if (capturing) record_modes(*writer, streaming_modes);
+    std::atomic_store(&recorder, writer);
+}
+
+void rs_device_base::stop_recording()
+{
+    auto writer = std::atomic_exchange(&recorder, std::shared_ptr<recording::writer>());
+    if (!writer) throw std::runtime_error("device is not recording");
+    writer->close(); // Capture threads still holding the writer find it closed
+}
+
+unsigned long long rs_device_base::get_recording_drops() const
+{
+    auto writer = std::atomic_load(&recorder);
+    return writer ? writer->get_dropped_count() : 0;
+}
+
+void rs_device_base::start_publishing(const char * name, int slot_count)
+{
+    if (std::atomic_load(&publisher)) throw std::runtime_error("device is already publishing");
+
+    // Slots fit the largest native frame of the device, so that starting again in another mode keeps the ring
+    size_t max_frame_size = 0;
+    for (auto & mode : config.info.subdevice_modes) max_frame_size = std::max(max_frame_size, mode.pf.get_image_size(mode.native_dims.x, mode.native_dims.y));
+
+    auto ring = std::make_shared<shared_ring::publisher>(name, slot_count, max_frame_size, describe_device());
+    if (capturing) ring->describe(describe_modes(streaming_modes));
+    std::atomic_store(&publisher, ring);
+}
+
+void rs_device_base::stop_publishing()
+{
+    if (!std::atomic_exchange(&publisher, std::shared_ptr<shared_ring::publisher>())) throw std::runtime_error("device is not publishing");
+    // The ring closes once the capture threads still holding it are done with their frames
+}
+
+void rs_device_base::start_frame_history(double seconds, size_t max_bytes)
+{
+    if (std::atomic_load(&history)) throw std::runtime_error("device already keeps a frame history");
+
+    auto frames = std::make_shared<frame_history>(describe_device(), seconds, max_bytes);
+    if (capturing) frames->describe(describe_modes(streaming_modes));
+    std::atomic_store(&history, frames);
+}
+
+void rs_device_base::stop_frame_history()
+{
+    if (!std::atomic_exchange(&history, std::shared_ptr<frame_history>())) throw std::runtime_error("device keeps no frame history");
+}
+
+size_t rs_device_base::dump_frame_history(const char * path, double from, double to) const
+{
+    auto frames = std::atomic_load(&history);
+    if (!frames) throw std::runtime_error("device keeps no frame history");
+    return frames->dump(path, from, to);
+}
+
+size_t rs_device_base::get_frame_history_size() const
+{
+    auto frames = std::atomic_load(&history);
+    return frames ? frames->get_size() : 0;
+}
+
+recording::device_record rs_device_base::describe_device() const
+{
+    recording::device_record device = {};
+    strncpy(device.name, get_name(), sizeof(device.name) - 1);
+    strncpy(device.serial, get_serial(), sizeof(device.serial) - 1);
+    strncpy(device.firmware_version, get_firmware_version(), sizeof(device.firmware_version) - 1);
+    if (supports(RS_CAMERA_INFO_ADAPTER_BOARD_FIRMWARE_VERSION)) strncpy(device.adapter_board_firmware_version, get_camera_info(RS_CAMERA_INFO_ADAPTER_BOARD_FIRMWARE_VERSION), sizeof(device.adapter_board_firmware_version) - 1);
+    return device;
+}
+
+std::vector<recording::mode_description> rs_device_base::describe_modes(const std::vector<subdevice_mode_selection> & modes) const
+{
+    std::vector<recording::mode_description> descriptions;
+    for (auto & selection : modes)
+    {
+        recording::mode_description d;
+        d.mode = { selection.mode.subdevice, selection.mode.native_dims.x, selection.mode.native_dims.y, selection.mode.pf.fourcc,
+            selection.mode.fps, selection.pad_crop, selection.mode.native_intrinsics };
+
+        for (auto & output : selection.get_outputs())
+        {
+            if (!config.requests[output.first].enabled) continue;
+            recording::stream_record stream = { output.first, output.second, selection.mode.fps, pad_crop_intrinsics(selection.mode.native_intrinsics, selection.pad_crop),
+                get_stream_interface(output.first).get_extrinsics_to(get_stream_interface(RS_STREAM_DEPTH)), get_depth_scale() };
+            d.streams.push_back(stream);
+        }
+        descriptions.push_back(d);
+    }
+    return descriptions;
+}
+
+void rs_device_base::record_modes(recording::writer & writer, const std::vector<subdevice_mode_selection> & modes) const
+{
+    for (auto & d : describe_modes(modes))
+    {
+        writer.write_mode(d.mode);
+        for (auto & stream : d.streams) writer.write_stream(stream);
+    }
+}
+
+size_t rs_device_base::get_motion_samples(rs_event_source source, double from, double to, rs_motion_data samples[], size_t max_count) const
+{
+    auto history = std::atomic_load(&motion_samples);
+    return history ? history->get_samples(source, from, to, samples, max_count) : 0;
+}
+
 void rs_device_base::start(rs_source source)
 {
     if (source == RS_SOURCE_MOTION_TRACKING)
@@ -286,26 +815,44 @@ void rs_device_base::start_fw_logger(char fw_log_op_code, int grab_rate_in_ms, s
         throw std::logic_error("FW logger already started");
 
     keep_fw_logger_alive = true;
-    fw_logger = std::make_shared<std::thread>([this, fw_log_op_code, grab_rate_in_ms, &mutex]() {
+    fw_log.clear();
+    fw_log_interval = 1;
+    fw_log_periods = 0;
+    hw_commands.reset(new hw_command_queue(*shared_executor, get_device(), mutex));
+    fw_logger = shared_executor->create_job([this, fw_log_op_code]() {
+        // Reads back off while the log is empty, so that an idle device costs option calls next to nothing
+        if (++fw_log_periods < fw_log_interval) return;
+        fw_log_periods = 0;
+
         const int data_size = 500;
         hw_monitor::hwmon_cmd cmd((int)fw_log_op_code);
         cmd.Param1 = data_size;
-        while (keep_fw_logger_alive)
+        hw_commands->submit(cmd, hw_command_priority::background, [this](const hw_monitor::hwmon_cmd & cmd, const char * error_message)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(grab_rate_in_ms));
-            hw_monitor::perform_and_send_monitor_command(this->get_device(), mutex, cmd);
-            char data[data_size];
-            memcpy(data, cmd.receivedCommandData, cmd.receivedCommandDataLength);
-
-            std::stringstream sstr;
-            sstr << "FW_Log_Data:";
-            for (size_t i = 0; i < cmd.receivedCommandDataLength; ++i)
-                sstr << hexify(data[i]) << " ";
-
-            if (cmd.receivedCommandDataLength)
-               LOG_INFO(sstr.str());
-        }
-    });
+            if (error_message || !cmd.receivedCommandDataLength)
+            {
+                if (error_message) LOG_WARNING("FW log could not be read: " << error_message);
+                fw_log_interval = std::min(fw_log_interval * 2, FW_LOG_MAX_INTERVAL);
+                return;
+            }
+            fw_log_interval = 1;
+            fw_log.push(cmd.receivedCommandData, cmd.receivedCommandDataLength);
+
+            if (is_logged(RS_LOG_SEVERITY_INFO))
+            {
+                std::stringstream sstr;
+                sstr << "FW_Log_Data:";
+                for (size_t i = 0; i < cmd.receivedCommandDataLength; ++i)
+                    sstr << hexify(cmd.receivedCommandData[i]) << " ";
+                LOG_INFO(sstr.str());
+            }
+        });
+    }, std::chrono::milliseconds(grab_rate_in_ms));
+}
+
+void rs_device_base::export_fw_log(const char * file_path) const
+{
+    fw_log.export_records(file_path);
 }
 
 void rs_device_base::stop_fw_logger()
@@ -314,7 +861,10 @@ void rs_device_base::stop_fw_logger()
         throw std::logic_error("FW logger not started");
 
     keep_fw_logger_alive = false;
-    fw_logger->join();
+    fw_logger->cancel();
+    fw_logger.reset();
+    hw_commands->stop();
+    hw_commands.reset();
 }
 
 struct drops_status
@@ -323,17 +873,237 @@ struct drops_status
     unsigned long long prev_frame_counter = 0;
 };
 
-void rs_device_base::start_video_streaming()
+// Everything the frame callback needs to know about a subdevice mode, worked out once when streaming starts
+struct frame_dispatch_plan
 {
-    if(capturing) throw std::runtime_error("cannot restart device without first stopping device");
+    struct output
+    {
+        rs_stream stream;
+        rs_format format;
+        int bpp;
+        int view_offset;    // Byte offset of the native plane or sample this output is a view of, or -1 if it is unpacked
+        int pixel_stride;   // Bytes between the pixels of an interleaved view, 0 for outputs with packed pixels
+        int width, height, stride_x, stride_y; // Decimated outputs are smaller than the mode they are unpacked from
+    };
+
+    subdevice_mode_selection mode_selection;
+    output outputs[RS_STREAM_NATIVE_COUNT];
+    size_t output_count;
+    size_t native_frame_size;
+    int fps;
+    bool requires_processing;
+    bool has_plane_views;   // Of planes or of interleaved samples, either way the driver buffer is shared by the outputs
+    bool unpacks_outputs;   // Some output is not a view of the native frame
+    bool embedded_fisheye_exposure;
+    uint32_t supported_metadata;
+
+    frame_dispatch_plan(const subdevice_mode_selection & selection, uint32_t supported_metadata, bool embedded_fisheye_exposure)
+        : mode_selection(selection), output_count(0), native_frame_size(selection.mode.pf.get_image_size(selection.mode.native_dims.x, selection.mode.native_dims.y)), fps(selection.get_framerate()), requires_processing(selection.requires_processing()), has_plane_views(false), unpacks_outputs(false),
+        embedded_fisheye_exposure(embedded_fisheye_exposure), supported_metadata(supported_metadata)
+    {
+        const auto & mode = selection.mode;
+        const int plane_size = static_cast<int>(native_frame_size / mode.pf.plane_count);
+        for (auto & o : selection.get_outputs())
+        {
+            if (output_count == RS_STREAM_NATIVE_COUNT) throw std::logic_error("subdevice mode provides too many streams");
+            const int plane = requires_processing ? selection.get_plane_view(output_count) : -1;
+            const int sample = requires_processing && plane < 0 ? selection.get_interleaved_view(output_count) : -1;
+            has_plane_views |= plane >= 0 || sample >= 0;
+            unpacks_outputs |= requires_processing && plane < 0 && sample < 0;
+            const int width = selection.get_output_width(o.first), height = selection.get_output_height(o.first);
+            const bool decimated = selection.is_decimated(o.first);
+            outputs[output_count++] = { o.first, o.second, get_image_bpp(o.second), plane >= 0 ? plane * plane_size : sample,
+                sample >= 0 ? static_cast<int>(mode.pf.bytes_per_pixel) : 0,
+                width, height, decimated ? width : selection.get_stride_x(), decimated ? height : selection.get_stride_y() };
+        }
+    }
+};
 
-    auto capture_start_time = std::chrono::high_resolution_clock::now();
-    auto selected_modes = config.select_modes();
-    auto archive = std::make_shared<syncronizing_archive>(selected_modes, select_key_stream(selected_modes), &max_publish_list_size, &event_queue_size, &events_timeout, capture_start_time);
+struct frame_capture_info
+{
+    double dequeue_time, validation_time;   // Of the monotonic clock of frame stages
+    double exposure_time;                   // The timestamp mapped to that clock
+    double timestamp;
+    unsigned long long frame_counter;
+    long long sys_time;
+    double exposure_value;
+    double actual_fps;
+};
 
-    for(auto & s : native_streams) s->archive.reset(); // Starting capture invalidates the current stream info, if any exists from previous capture
+std::shared_ptr<rs_frame_allocator> rs_device_base::get_frame_allocator() const
+{
+    if (config.frame_allocator) return config.frame_allocator;
+    return page_allocator;
+}
 
-    auto timestamp_readers = create_frame_timestamp_readers();
+// The frames of a frameset which hold data, returning how many
+static int get_frameset_frames(const rs_frameset * frames, rs_frame_ref * (&refs)[RS_STREAM_NATIVE_COUNT])
+{
+    auto & set = ((const frame_archive::shared_frameset *)frames)->get_frames();
+    int count = 0;
+    for (int i = 0; i < RS_STREAM_NATIVE_COUNT; ++i)
+    {
+        auto ref = const_cast<rs_frame_ref *>(set.get_frame((rs_stream)i));
+        if (ref->get_frame_data()) refs[count++] = ref;
+    }
+    return count;
+}
+
+// Hands the rows of the native frames of a stream to its slice callback, rows_per_slice at a time
+struct frame_slicer
+{
+    rs_device * device;
+    slice_callback_ptr callback;
+    int rows_per_slice, width, height;
+    size_t row_bytes;
+
+    void operator()(const void * rows, int first_row, int row_count) const
+    {
+        try { callback->on_slice(device, rows, width, first_row, row_count); }
+        catch (const std::exception & e) { LOG_ERROR("Received an exception from a slice callback: " << e.what()); }
+        catch (...) { LOG_ERROR("Received an exception from a slice callback!"); }
+    }
+
+    // Slices a whole frame, for backends which only deliver frames whole
+    void slice(const void * frame) const
+    {
+        for (int y = 0; y < height; y += rows_per_slice) (*this)(static_cast<const byte *>(frame) + row_bytes * y, y, std::min(rows_per_slice, height - y));
+    }
+};
+
+// Encodes the frames of a stream from the archive buffers they were unpacked into, and hands the packets to its encoded packet callback
+struct frame_encoder
+{
+    rs_device * device;
+    rs_stream stream;
+    size_t output;  // Of the frame dispatch plan
+    encoded_packet_callback_ptr callback;
+    std::shared_ptr<video::h264_encoder> encoder;
+
+    void encode(const byte * image, const frame_capture_info & info) const
+    {
+        try
+        {
+            encoder->encode(image, info.timestamp, info.frame_counter, info.sys_time, [this](const rs_encoded_packet & packet)
+            {
+                try { callback->on_packet(device, stream, packet); }
+                catch (const std::exception & e) { LOG_ERROR("Received an exception from an encoded packet callback: " << e.what()); }
+                catch (...) { LOG_ERROR("Received an exception from an encoded packet callback!"); }
+            });
+        }
+        catch (const std::exception & e) { LOG_ERROR("Failed to encode a frame of " << get_string(stream) << ": " << e.what()); }
+    }
+};
+
+void rs_device_base::start_video_streaming()
+{
+    if(capturing) throw std::runtime_error("cannot restart device without first stopping device");
+
+    auto capture_start_time = std::chrono::high_resolution_clock::now();
+    auto selected_modes = config.select_modes();
+
+    // Pass-through streams are delivered straight from driver memory when the application asked for it and the backend allows it. Either way,
+    // a backend keeping driver buffers valid lets unpacking be deferred to the pipeline.
+    const bool backend_keeps_buffers = supports_zero_copy(*device);
+    for(auto & mode_selection : selected_modes) mode_selection.zero_copy = zero_copy && backend_keeps_buffers;
+
+    // Streams given buffers of the application are always unpacked into them, rather than handed out in driver memory
+    for(auto & mode_selection : selected_modes)
+    {
+        for(auto & output : mode_selection.get_outputs()) if(config.frame_buffers[output.first]) mode_selection.zero_copy = false;
+    }
+
+    // Crops are moved to the driver where the frames carry nothing but pixels, so that only the window crosses the bus. Elsewhere, the window
+    // is unpacked from whole frames, which keep the timestamps and counters some cameras embed in their pixels.
+    for(auto & mode_selection : selected_modes)
+    {
+        const auto window = mode_selection.software_crop;
+        const int subdevice = mode_selection.mode.subdevice;
+        if(window.width && config.info.croppable_subdevices[subdevice] && set_subdevice_crop(*device, subdevice, window.x - mode_selection.pad_crop, window.y - mode_selection.pad_crop, window.width, window.height)) mode_selection.move_crop_to_driver();
+        else set_subdevice_crop(*device, subdevice, 0, 0, 0, 0);
+    }
+
+    // With NUMA locality, frames are allocated, captured and unpacked on the node of the host controller of the device
+    const int numa_node = numa_local ? numa::get_usb_node(get_usb_port_id()) : -1;
+    const uint64_t numa_cpus = numa::get_node_cpu_mask(numa_node);
+    if (numa_local && numa_node < 0) LOG_WARNING("The NUMA node of " << get_name() << " is unknown, its frame memory and threads are placed as usual");
+    else if (numa_local) LOG_INFO(get_name() << " streams on NUMA node " << numa_node);
+
+    // Every capture gets its own allocator, so that the pages reported are those of this capture
+    page_allocator = !config.frame_allocator && (frame_pages != frame_memory_pages::heap || numa_node >= 0) ? std::make_shared<mapped_frame_allocator>(frame_pages, numa_node) : nullptr;
+    // A subdevice streams on demand when every stream it provides does, and nothing consumes their every frame through a callback. Framesets are
+    // keyed on a stream which is always on, or else the subdevice of the key stream is, so that waiting for frames never waits for a stream off.
+    int on_demand = 0;
+    std::vector<subdevice_mode_selection> always_on_modes;
+    for(auto & mode_selection : selected_modes)
+    {
+        bool streams_on_demand = !config.frameset_callback;
+        for(auto & output : mode_selection.get_outputs())
+        {
+            if(config.requests[output.first].enabled) streams_on_demand &= config.idle_timeouts[output.first] > 0 && !config.has_frame_callbacks(output.first);
+        }
+        if(streams_on_demand) on_demand |= 1 << mode_selection.mode.subdevice;
+        else always_on_modes.push_back(mode_selection);
+    }
+    const auto key_stream = select_key_stream(always_on_modes.empty() ? selected_modes : always_on_modes);
+    for(auto & mode_selection : selected_modes) if(mode_selection.provides_stream(key_stream)) on_demand &= ~(1 << mode_selection.mode.subdevice);
+
+    // Frame memory is counted towards the memory budget, whichever allocator provides it
+    auto accounted_allocator = std::make_shared<accounted_frame_allocator>(get_frame_allocator() ? get_frame_allocator() : get_default_frame_allocator(), memory);
+
+    // When the frames of every enabled stream go to a frame callback, nothing forms framesets nor corrects timestamps from motion events, so the
+    // frames only need the pooled buffers and references of a plain archive, without the queues and frontbuffer of the sync archive
+    bool callbacks_only = !config.frameset_callback && !config.data_request.enabled;
+    for (int s = 0; s < RS_STREAM_NATIVE_COUNT; ++s) if (config.requests[s].enabled && !config.has_frame_callbacks((rs_stream)s)) callbacks_only = false;
+    auto sync_archive = callbacks_only ? nullptr : std::make_shared<syncronizing_archive>(selected_modes, key_stream, &max_publish_list_size, &event_queue_size, &events_timeout, config.queue_policies, accounted_allocator, capture_start_time);
+    auto archive = sync_archive ? std::static_pointer_cast<frame_archive>(sync_archive) : std::make_shared<frame_archive>(selected_modes, &max_publish_list_size, accounted_allocator, capture_start_time);
+    if (sync_archive) for (int s = 0; s < RS_STREAM_NATIVE_COUNT; ++s) sync_archive->set_sync_tolerance((rs_stream)s, config.sync_tolerances[s]);
+
+    // Outputs unpacked together from one native frame into the sync archive, such as depth and infrared or both infrared images, are committed
+    // and matched as a unit led by the key stream, or else by the first of them, so timestamps are only compared between subdevices
+    if (sync_archive && !mailbox) for (auto & mode_selection : selected_modes)
+    {
+        std::vector<rs_stream> unit;
+        for (auto & output : mode_selection.get_outputs()) if (!config.has_frame_callbacks(output.first)) unit.push_back(output.first);
+        if (unit.size() < 2) continue;
+        const auto leader = std::find(unit.begin(), unit.end(), key_stream) != unit.end() ? key_stream : unit.front();
+        for (auto s : unit) if (s != leader) sync_archive->set_companion(s, leader);
+    }
+
+    for(auto & s : native_streams) s->archive.reset(); // Starting capture invalidates the current stream info, if any exists from previous capture
+
+    if (auto writer = std::atomic_load(&recorder)) record_modes(*writer, selected_modes);
+    if (auto ring = std::atomic_load(&publisher)) ring->describe(describe_modes(selected_modes));
+    if (auto frames = std::atomic_load(&history)) frames->describe(describe_modes(selected_modes));
+
+    auto timestamp_readers = create_frame_timestamp_readers();
+
+    if (unpack_threads > 0 && backend_keeps_buffers) pipeline = std::make_shared<unpack_pipeline>(unpack_threads, numa_cpus);
+
+    // Streams given a callback queue have their callbacks invoked on a thread of their own, which releases the frames it drops to the archive
+    for (int s = 0; s < RS_STREAM_NATIVE_COUNT; ++s)
+    {
+        callback_queues[s].reset();
+        if (!config.callbacks[s] || !config.callback_queue_depths[s]) continue;
+        callback_queues[s] = std::make_shared<frame_callback_queue>(config.callback_queue_depths[s],
+            [this, s, capture_start_time](rs_frame_ref * frame) { invoke_frame_callback((rs_stream)s, *config.callbacks[s], frame, capture_start_time); },
+            [archive](rs_frame_ref * frame) { archive->release_frame_ref((frame_archive::frame_ref *)frame); });
+    }
+
+    // Likewise every subscriber given a queue, each on a thread and with a drop policy of its own, so that a slow subscriber never holds up another
+    for (int s = 0; s < RS_STREAM_NATIVE_COUNT; ++s)
+    {
+        subscriber_queues[s].clear();
+        for (auto & subscriber : config.subscribers[s])
+        {
+            std::shared_ptr<frame_callback_queue> queue;
+            auto callback = subscriber.callback;
+            if (subscriber.queue.depth) queue = std::make_shared<frame_callback_queue>(subscriber.queue.depth,
+                [this, s, callback, capture_start_time](rs_frame_ref * frame) { invoke_frame_callback((rs_stream)s, callback.get(), frame, capture_start_time); },
+                [archive](rs_frame_ref * frame) { archive->release_frame_ref((frame_archive::frame_ref *)frame); }, subscriber.queue.policy);
+            subscriber_queues[s].push_back({ subscriber.id, queue });
+        }
+    }
 
     // Satisfy stream_requests as necessary for each subdevice, calling set_mode and
     // dispatching the uvc configuration for a requested stream to the hardware
@@ -346,168 +1116,598 @@ void rs_device_base::start_video_streaming()
         for(auto & stream_mode : mode_selection.get_outputs())
         {                    
             // If this is one of the streams requested by the user, store the buffer so they can access it
-            if(config.requests[stream_mode.first].enabled) native_streams[stream_mode.first]->archive = archive;
+            if(config.requests[stream_mode.first].enabled) native_streams[stream_mode.first]->archive = sync_archive;
         }
 
-        // Copy the callbacks that apply to this stream, so that they can be captured by value
-        std::vector<rs_stream> streams;
-        for (auto & output : mode_selection.get_outputs())
+        auto plan = std::make_shared<const frame_dispatch_plan>(mode_selection, frame_archive::frame_additional_data::get_metadata_mask(config.info.supported_metadata_vector),
+            // fisheye exposure value is embedded in the frame data from version 1.27.2.90
+            mode_selection.get_outputs().front().first == RS_STREAM_FISHEYE && firmware_version(get_camera_info(RS_CAMERA_INFO_ADAPTER_BOARD_FIRMWARE_VERSION)) >= firmware_version("1.27.2.90"));
+
+        auto actual_fps_calc = std::make_shared<fps_calc>(NUMBER_OF_FRAMES_TO_SAMPLE, plan->fps);
+        auto device_clock = std::make_shared<device_clock_estimator>();
+        std::shared_ptr<drops_status> frame_drops_status(new drops_status{});
+
+        // Frames of one subdevice are delivered in order, never concurrently, so they can share the history of the temporal depth filter
+        auto depth_history = std::make_shared<temporal_depth_history>();
+
+        // Frames split into bands are unpacked by the thread delivering them along with the threads of a pool of the subdevice
+        auto bands_pool = mode_selection.unpack_bands > 1 ? std::make_shared<parallel_pool>(mode_selection.unpack_bands) : nullptr;
+
+        // Unpacking is handed to the pipeline only when the driver buffer stays valid until its continuation runs
+        auto defer_unpacking = pipeline && plan->unpacks_outputs;
+
+        // Encoded streams are encoded in order, from the archive buffers they are unpacked into, ahead of their delivery
+        std::shared_ptr<const frame_encoder> encoder;
+        for (size_t i = 0; i < plan->output_count; ++i)
+        {
+            auto & output = plan->outputs[i];
+            if (!config.encoded_packet_callbacks[output.stream] || !config.requests[output.stream].enabled) continue;
+            if (!is_yuv420(output.format)) throw std::runtime_error(to_string() << "only streams in NV12 or I420 can be encoded, " << get_string(output.stream) << " is " << get_string(output.format));
+            encoder = std::make_shared<const frame_encoder>(frame_encoder{ this, output.stream, i, config.encoded_packet_callbacks[output.stream],
+                std::make_shared<video::h264_encoder>(output.width, output.height, output.format, plan->fps, config.encoder_bitrates[output.stream]) });
+        }
+
+        // Allocates the archive frames, unpacks the native frame into them and hands them to the application
+        auto deliver = std::make_shared<std::function<void(const void *, frame_continuation &, const frame_capture_info &)>>(
+            [this, plan, archive, sync_archive, capture_start_time, depth_history, bands_pool, encoder](const void * frame, frame_continuation & release_and_enqueue, const frame_capture_info & info)
         {
-            streams.push_back(output.first);
-        }     
+            byte * dest[RS_STREAM_NATIVE_COUNT] = {}; // Fixed storage, we do not want to touch the heap on every frame
+            rs_stream committed[RS_STREAM_NATIVE_COUNT];
+            size_t committed_count = 0;
+
+            for (size_t i = 0; i < plan->output_count; ++i)
+            {
+                auto & output = plan->outputs[i];
+                frame_archive::frame_additional_data additional_data( info.timestamp,
+                    info.frame_counter,
+                    info.sys_time,
+                    output.width,
+                    output.height,
+                    plan->fps,
+                    output.stride_x,
+                    output.stride_y,
+                    output.bpp,
+                    output.format,
+                    output.stream,
+                    plan->mode_selection.pad_crop,
+                    plan->supported_metadata,
+                    info.exposure_value,
+                    info.actual_fps);
+                additional_data.pixel_stride = output.pixel_stride;
+                if (plan->mode_selection.builds_pyramid(output.stream)) additional_data.pyramid_levels = plan->mode_selection.depth_pyramid_levels;
+                additional_data.depth_runs = plan->mode_selection.finds_depth_runs(output.stream);
+
+                // Obtain buffers for unpacking the frame, outputs which are views of a native plane need none, and interleaved views
+                // get one they are packed into only if the application asks for their packed pixels
+                dest[i] = archive->alloc_frame(output.stream, additional_data, plan->requires_processing && (output.view_offset < 0 || output.pixel_stride));
+
+
+                if (motion_module_ready && sync_archive) // try to correct timestamp only if motion module is enabled
+                {
+                    sync_archive->correct_timestamp(output.stream);
+                }
+            }
+            // Unpack the frame
+            const double unpack_start_time = get_monotonic_time();
+            if (plan->unpacks_outputs)
+            {
+                RS_TRACE_SPAN("unpack");
+                depth_statistics statistics;
+                const bool gather_statistics = plan->mode_selection.computes_statistics(RS_STREAM_DEPTH);
+                plan->mode_selection.unpack(dest, reinterpret_cast<const byte *>(frame), depth_history.get(), gather_statistics ? &statistics : nullptr, bands_pool.get());
+                if (gather_statistics)
+                {
+                    archive->set_frame_metadata(RS_STREAM_DEPTH, RS_FRAME_METADATA_DEPTH_MIN, statistics.valid ? statistics.min : 0);
+                    archive->set_frame_metadata(RS_STREAM_DEPTH, RS_FRAME_METADATA_DEPTH_MAX, statistics.max);
+                    archive->set_frame_metadata(RS_STREAM_DEPTH, RS_FRAME_METADATA_DEPTH_VALID_PIXELS, statistics.valid);
+                    for (int k = 0; k < depth_statistics::histogram_bins; ++k)
+                    {
+                        archive->set_frame_metadata(RS_STREAM_DEPTH, static_cast<rs_frame_metadata>(RS_FRAME_METADATA_DEPTH_HISTOGRAM_0 + k), statistics.histogram[k]);
+                    }
+                }
+            }
 
-        auto supported_metadata_vector = std::make_shared<std::vector<rs_frame_metadata>>(config.info.supported_metadata_vector);
+            const double unpack_end_time = plan->unpacks_outputs ? get_monotonic_time() : unpack_start_time;
+
+            if (encoder && dest[encoder->output])
+            {
+                RS_TRACE_SPAN("encode");
+                encoder->encode(dest[encoder->output], info);
+            }
+
+            // Plane views share the driver buffer, which is requeued once the last of them is released
+            if (plan->has_plane_views)
+            {
+                auto shared_buffer = std::make_shared<frame_continuation>(std::move(release_and_enqueue));
+                for (size_t i = 0; i < plan->output_count; ++i)
+                {
+                    if (plan->outputs[i].view_offset < 0) continue;
+                    archive->attach_continuation(plan->outputs[i].stream, frame_continuation([shared_buffer]() {}, static_cast<const byte *>(frame) + plan->outputs[i].view_offset));
+                }
+            }
+
+            // If any frame callbacks were specified, dispatch them now
+            for (size_t i = 0; i < plan->output_count; ++i)
+            {
+                RS_TRACE_SPAN("commit");
+                auto stream = plan->outputs[i].stream;
+                if (!plan->requires_processing)
+                {
+                    archive->attach_continuation(stream, std::move(release_and_enqueue));
+                }
+                archive->set_frame_metadata(stream, RS_FRAME_METADATA_TIME_OF_DEQUEUE, info.dequeue_time);
+                archive->set_frame_metadata(stream, RS_FRAME_METADATA_TIME_OF_VALIDATION, info.validation_time);
+                archive->set_frame_metadata(stream, RS_FRAME_METADATA_TIME_OF_EXPOSURE, info.exposure_time);
+                archive->set_frame_metadata(stream, RS_FRAME_METADATA_TIME_OF_UNPACK_START, unpack_start_time);
+                archive->set_frame_metadata(stream, RS_FRAME_METADATA_TIME_OF_UNPACK_END, unpack_end_time);
+                archive->set_frame_metadata(stream, RS_FRAME_METADATA_TIME_OF_COMMIT, get_monotonic_time());
+                metrics.add(stream, RS_STREAM_METRIC_UNPACK_NANOSECONDS, stream_metrics::to_nanoseconds(unpack_end_time - unpack_start_time));
+
+                if (config.has_frame_callbacks(stream))
+                {
+                    auto frame_ref = archive->track_frame(stream);
+                    if (frame_ref) on_before_callback(stream, frame_ref, archive);
+
+                    // Every subscriber is handed a reference of its own to the same frame, those with a queue first so that none waits for a callback run here
+                    auto & subscribers = subscriber_queues[stream];
+                    for (size_t k = 0; frame_ref && k < subscribers.size(); ++k)
+                    {
+                        if (!subscribers[k].second) continue;
+                        if (auto clone = archive->clone_frame(frame_ref)) subscribers[k].second->push(clone);
+                    }
+                    for (size_t k = 0; frame_ref && k < subscribers.size(); ++k)
+                    {
+                        if (subscribers[k].second) continue;
+                        if (auto clone = archive->clone_frame(frame_ref)) invoke_frame_callback(stream, config.subscribers[stream][k].callback.get(), clone, capture_start_time);
+                    }
+
+                    if (frame_ref && !config.callbacks[stream]) archive->release_frame_ref(frame_ref);
+                    else if (frame_ref && callback_queues[stream]) callback_queues[stream]->push(frame_ref);
+                    else if (frame_ref) invoke_frame_callback(stream, *config.callbacks[stream], frame_ref, capture_start_time);
+                }
+                else if (mailbox)
+                {
+                    archive->post_frame(stream);
+                }
+                else if (sync_archive)
+                {
+                    // Committed to the archive along with the other outputs of the native frame
+                    committed[committed_count++] = stream;
+                }
+                else
+                {
+                    // An output of the subdevice which was not requested
+                    archive->drop_frame(stream);
+                }
+            }
+            if (committed_count) sync_archive->commit_frames(committed, committed_count);
+        });
+
+        // The dma-bufs of a subdevice are those of the first of its streams which has any
+        std::vector<int> dmabuf_fds;
+        if (capture_memory_type == uvc::capture_memory::dma_buffer)
+        {
+            for (auto & output : mode_selection.get_outputs()) if (dmabuf_fds.empty()) dmabuf_fds = config.capture_dmabufs[output.first];
+            if (dmabuf_fds.empty()) throw std::runtime_error(to_string() << "no capture dma-bufs were provided for " << mode_selection.get_outputs().front().first);
+        }
+        set_subdevice_capture_memory(*device, mode_selection.mode.subdevice, capture_memory_type, accounted_allocator, dmabuf_fds);
+
+        // Streams of one subdevice share its buffers, so the largest count any of them asked for is used. Otherwise, frames delivered
+        // without copying or waiting for a worker hold on to their driver buffer for longer, and get more of them
+        int buffer_count = 0, min_buffer_count, max_buffer_count;
+        for (auto & output : mode_selection.get_outputs()) buffer_count = std::max(buffer_count, config.capture_buffer_counts[output.first]);
+        get_subdevice_buffer_count_range(*device, min_buffer_count, max_buffer_count);
+        if (!buffer_count && backend_keeps_buffers && max_buffer_count) buffer_count = plan->requires_processing && !defer_unpacking && !plan->has_plane_views ? COPIED_STREAM_BUFFER_COUNT : ZERO_COPY_STREAM_BUFFER_COUNT;
+        set_subdevice_buffer_count(*device, mode_selection.mode.subdevice, buffer_count);
+
+        // Slice callbacks get the rows of the native frames as the driver assembles them, or else as each frame arrives, ahead of unpacking it
+        std::shared_ptr<const frame_slicer> slicer;
+        for (auto & output : mode_selection.get_outputs())
+        {
+            if (!config.slice_callbacks[output.first] || !config.requests[output.first].enabled) continue;
+            if (mode_selection.mode.pf.fourcc != pf_z16.fourcc) throw std::runtime_error(to_string() << "only streams sent as Z16 can be sliced, " << get_string(output.first) << " is not");
+            const auto & dims = mode_selection.mode.native_dims;
+            slicer = std::make_shared<const frame_slicer>(frame_slicer{ this, config.slice_callbacks[output.first], config.slice_rows[output.first], dims.x, dims.y, mode_selection.mode.pf.get_image_size(dims.x, 1) });
+        }
+        const bool driver_slices = set_subdevice_slice_callback(*device, mode_selection.mode.subdevice, slicer ? slicer->rows_per_slice : 0, slicer ? slicer->row_bytes : 0,
+            slicer ? uvc::video_slice_callback([slicer](const void * rows, int first_row, int row_count) { (*slicer)(rows, first_row, row_count); }) : nullptr);
+        auto frame_slices = driver_slices ? nullptr : slicer;
 
-        auto actual_fps_calc = std::make_shared<fps_calc>(NUMBER_OF_FRAMES_TO_SAMPLE, mode_selection.get_framerate());
-        std::shared_ptr<drops_status> frame_drops_status(new drops_status{});
         // Initialize the subdevice and set it to the selected mode
-        set_subdevice_mode(*device, mode_selection.mode.subdevice, mode_selection.mode.native_dims.x, mode_selection.mode.native_dims.y, mode_selection.mode.pf.fourcc, mode_selection.mode.fps, 
-            [this, mode_selection, archive, timestamp_reader, streams, capture_start_time, frame_drops_status, actual_fps_calc, supported_metadata_vector](const void * frame, std::function<void()> continuation) mutable
+        const auto driver_dims = mode_selection.cropped_in_driver ? mode_selection.uncropped_dims : mode_selection.mode.native_dims;
+        set_subdevice_mode(*device, mode_selection.mode.subdevice, driver_dims.x, driver_dims.y, mode_selection.mode.pf.fourcc, mode_selection.mode.fps, plan->native_frame_size,
+            [this, plan, timestamp_reader, capture_start_time, frame_drops_status, actual_fps_calc, device_clock, deliver, defer_unpacking, frame_slices](const void * frame, size_t, inline_function continuation)
         {
+            RS_TRACE_SPAN("capture");
+            if (frame_slices) frame_slices->slice(frame);
+            frame_capture_info info = {};
+            info.dequeue_time = get_monotonic_time();
             auto now = std::chrono::system_clock::now();
-            auto sys_time = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+            info.sys_time = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+
+            frame_continuation release_and_enqueue(std::move(continuation), frame);
 
-            frame_continuation release_and_enqueue(continuation, frame);
+            auto & mode = plan->mode_selection.mode;
 
             // Ignore any frames which appear corrupted or invalid
-            if (!timestamp_reader->validate_frame(mode_selection.mode, frame)) return;
+            for (size_t i = 0; i < plan->output_count; ++i) metrics.add(plan->outputs[i].stream, RS_STREAM_METRIC_FRAMES_RECEIVED);
+            if (!timestamp_reader->validate_frame(mode, frame))
+            {
+                for (size_t i = 0; i < plan->output_count; ++i) metrics.add(plan->outputs[i].stream, RS_STREAM_METRIC_FRAMES_INVALID);
+                return;
+            }
             
-            auto actual_fps = actual_fps_calc->calc_fps(now);
+            info.actual_fps = actual_fps_calc->calc_fps(now);
 
             // Determine the timestamp for this frame
-            auto timestamp = timestamp_reader->get_frame_timestamp(mode_selection.mode, frame, actual_fps);
-            auto frame_counter = timestamp_reader->get_frame_counter(mode_selection.mode, frame);
-            auto recieved_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - capture_start_time).count();
-
-            auto requires_processing = mode_selection.requires_processing();
+            info.timestamp = timestamp_reader->get_frame_timestamp(mode, frame, info.actual_fps);
+            info.frame_counter = timestamp_reader->get_frame_counter(mode, frame);
+            device_clock->add(info.timestamp, info.frame_counter, info.dequeue_time);
+            info.exposure_time = device_clock->to_host_time(info.timestamp);
 
-            double exposure_value[1] = {};
-            if (streams[0] == rs_stream::RS_STREAM_FISHEYE)
+            if (plan->embedded_fisheye_exposure)
             {
-                // fisheye exposure value is embedded in the frame data from version 1.27.2.90
-                firmware_version firmware(get_camera_info(RS_CAMERA_INFO_ADAPTER_BOARD_FIRMWARE_VERSION));
-                if (firmware >= firmware_version("1.27.2.90"))
-                {
-                    auto data = static_cast<const char*>(frame);
-                    int exposure = 0; // Embedded Fisheye exposure value is in units of 0.2 mSec
-                    for (int i = 4, j = 0; i < 12; ++i, ++j)
-                        exposure |= ((data[i] & 0x01) << j);
+                auto data = static_cast<const char*>(frame);
+                int exposure = 0; // Embedded Fisheye exposure value is in units of 0.2 mSec
+                for (int i = 4, j = 0; i < 12; ++i, ++j)
+                    exposure |= ((data[i] & 0x01) << j);
 
-                    exposure_value[0] = exposure * 0.2 * 10.;
-                }
+                info.exposure_value = exposure * 0.2 * 10.;
             }
+            info.validation_time = get_monotonic_time();
 
-            auto width = mode_selection.get_width();
-            auto height = mode_selection.get_height();
-            auto fps = mode_selection.get_framerate();
-            std::vector<byte *> dest;
-
-            auto stride_x = mode_selection.get_stride_x();
-            auto stride_y = mode_selection.get_stride_y();
-            for (auto & output : mode_selection.get_outputs())
+            if (is_logged(RS_LOG_SEVERITY_DEBUG))
             {
-                LOG_DEBUG("FrameAccepted, RecievedAt," << recieved_time << ", FWTS," << timestamp << ", DLLTS," << recieved_time << ", Type," << rsimpl::get_string(output.first) << ",HasPair,0,F#," << frame_counter);
+                auto recieved_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - capture_start_time).count();
+                for (size_t i = 0; i < plan->output_count; ++i)
+                {
+                    LOG_DEBUG("FrameAccepted, RecievedAt," << recieved_time << ", FWTS," << info.timestamp << ", DLLTS," << recieved_time << ", Type," << rsimpl::get_string(plan->outputs[i].stream) << ",HasPair,0,F#," << info.frame_counter);
+                }
             }
             
+            if (auto writer = std::atomic_load(&recorder))
+            {
+                const auto encoding = mode.pf.fourcc == pf_z16.fourcc ? recording::frame_encoding::rvl : recording::frame_encoding::raw;
+                recording::frame_record record = { mode.subdevice, encoding, info.timestamp, info.frame_counter, info.sys_time, info.exposure_value, info.actual_fps };
+                writer->write_frame(record, frame, plan->native_frame_size);
+            }
+            if (auto ring = std::atomic_load(&publisher))
+            {
+                const recording::mode_record mode_record = { mode.subdevice, mode.native_dims.x, mode.native_dims.y, mode.pf.fourcc, mode.fps, plan->mode_selection.pad_crop, mode.native_intrinsics };
+                recording::frame_record record = { mode.subdevice, recording::frame_encoding::raw, info.timestamp, info.frame_counter, info.sys_time, info.exposure_value, info.actual_fps };
+                ring->publish_frame(mode_record, record, frame, plan->native_frame_size);
+            }
+            if (auto frames = std::atomic_load(&history))
+            {
+                const recording::frame_record record = { mode.subdevice, recording::frame_encoding::raw, info.timestamp, info.frame_counter, info.sys_time, info.exposure_value, info.actual_fps };
+                frames->push(record, mode.pf.fourcc == pf_z16.fourcc, frame, plan->native_frame_size);
+            }
+
             frame_drops_status->was_initialized = true;
 
             // Not updating prev_frame_counter when first frame arrival
             if (frame_drops_status->was_initialized)
             {
-                frames_drops_counter.fetch_add(frame_counter - frame_drops_status->prev_frame_counter - 1);
-                frame_drops_status->prev_frame_counter = frame_counter;
+                frames_drops_counter.fetch_add(info.frame_counter - frame_drops_status->prev_frame_counter - 1);
+                frame_drops_status->prev_frame_counter = info.frame_counter;
             }
 
-            for (auto & output : mode_selection.get_outputs())
+            // Load is shed once the frame has been recorded, published and kept in the history. Decimating on the frame counter keeps
+            // the same captures of every subdevice, so that the frames left still form framesets.
+            if (shedding.is_taking(RS_LOAD_SHEDDING_ACTION_DECIMATE_FRAMERATE) && (info.frame_counter & 1))
             {
-                auto bpp = get_image_bpp(output.second);
-                frame_archive::frame_additional_data additional_data( timestamp,
-                    frame_counter,
-                    sys_time,
-                    width,
-                    height,
-                    fps,
-                    stride_x,
-                    stride_y,
-                    bpp,
-                    output.second,
-                    output.first,
-                    mode_selection.pad_crop,
-                    supported_metadata_vector,
-                    exposure_value[0],
-                    actual_fps);
-
-                // Obtain buffers for unpacking the frame
-                dest.push_back(archive->alloc_frame(output.first, additional_data, requires_processing));
-
-
-                if (motion_module_ready) // try to correct timestamp only if motion module is enabled
+                for (size_t i = 0; i < plan->output_count; ++i) metrics.add(plan->outputs[i].stream, RS_STREAM_METRIC_FRAMES_DECIMATED);
+                return;
+            }
+            if (shedding.is_taking(RS_LOAD_SHEDDING_ACTION_SKIP_CULLED_UNPACKING))
+            {
+                bool backlogged = true;
+                for (size_t i = 0; i < plan->output_count; ++i) backlogged &= is_stream_backlogged(plan->outputs[i].stream);
+                if (backlogged)
                 {
-                    archive->correct_timestamp(output.first);
+                    for (size_t i = 0; i < plan->output_count; ++i) metrics.add(plan->outputs[i].stream, RS_STREAM_METRIC_UNPACKS_SHED);
+                    return;
                 }
             }
-            // Unpack the frame
-            if (requires_processing)
+
+            if (defer_unpacking)
+            {
+                // The driver buffer is requeued once the worker is done with it
+                auto held = std::make_shared<frame_continuation>(std::move(release_and_enqueue));
+                pipeline->submit(mode.subdevice, [deliver, held, info]() { (*deliver)(held->get_data(), *held, info); });
+            }
+            else
             {
-                mode_selection.unpack(dest.data(), reinterpret_cast<const byte *>(frame));
+                (*deliver)(frame, release_and_enqueue, info);
             }
+        });
+    }
+    
+    if (sync_archive) sync_archive->set_frames_ready_signal(frames_ready.get());
+    archive->set_latency_histograms(&latency_histograms);
+    archive->set_stream_metrics(&metrics);
+    archive->set_memory_account(memory);
+    for (int s = 0; s < RS_STREAM_NATIVE_COUNT; ++s) archive->set_stream_buffers((rs_stream)s, config.frame_buffers[s]);
+    for (int s = 0; s < RS_STREAM_NATIVE_COUNT; ++s) metrics.clear((rs_stream)s, RS_STREAM_METRIC_QUEUED_FRAMES); // Frames left queued by the previous archive went with it
+    if (config.frameset_callback)
+    {
+        auto callback = config.frameset_callback;
+        sync_archive->set_frameset_callback([this, callback](frame_archive::shared_frameset * frames) { callback->on_frameset(this, (rs_frameset *)frames); });
+    }
+    else if (precomputed_streams && sync_archive)
+    {
+        // Every enabled derived stream is a task of the graph, computed as soon as a frameset is formed. The derived streams of this tree all read
+        // native frames only, such as depth aligned to rectified color, which only takes the intrinsics of rectified color, so they are all roots of
+        // the graph and run in parallel. Neither the capture threads nor the application wait for them.
+        struct prepared_frames
+        {
+            frame_archive::shared_frameset * frames;
+            frame_archive::frame_ref * derived[RS_STREAM_COUNT - RS_STREAM_NATIVE_COUNT];
+        };
+        std::vector<rs_stream> derived_streams;
+        for (int i = 0; i < RS_STREAM_COUNT - RS_STREAM_NATIVE_COUNT; ++i)
+        {
+            const auto stream = static_cast<rs_stream>(RS_STREAM_NATIVE_COUNT + i);
+            if ((precomputed_streams & (1 << i)) && streams[stream]->is_enabled()) derived_streams.push_back(stream);
+        }
 
-            // If any frame callbacks were specified, dispatch them now
-            for (size_t i = 0; i < dest.size(); ++i)
+        auto prepared_archive = sync_archive.get(); // The archive owns the preparation callback, and the graph is stopped before the archive is flushed
+        const int threads = std::max(1, std::min((int)derived_streams.size(), (int)std::thread::hardware_concurrency()));
+        auto graph = precompute_graph = std::make_shared<task_graph>(threads, numa_cpus, [prepared_archive](void * input)
+        {
+            std::unique_ptr<prepared_frames> prepared((prepared_frames *)input);
+            prepared_archive->publish_prepared_frameset(prepared->frames, prepared->derived);
+        });
+        for (auto stream : derived_streams)
+        {
+            graph->add_task([this, stream](void * input)
             {
-                if (!requires_processing)
+                auto prepared = (prepared_frames *)input;
+                if (shedding.is_taking(RS_LOAD_SHEDDING_ACTION_SKIP_DERIVED_STREAMS))
                 {
-                    archive->attach_continuation(streams[i], std::move(release_and_enqueue));
+                    metrics.add(streams[stream]->get_frame_source(), RS_STREAM_METRIC_DERIVED_FRAMES_SHED);
+                    return;
                 }
-
-                if (config.callbacks[streams[i]])
+                try
                 {
-                    auto frame_ref = archive->track_frame(streams[i]);
-                    if (frame_ref)
-                    {
-                        frame_ref->update_frame_callback_start_ts(std::chrono::high_resolution_clock::now());
-                        frame_ref->log_callback_start(capture_start_time);
-                        on_before_callback(streams[i], frame_ref, archive);
-                        (*config.callbacks[streams[i]])->on_frame(this, frame_ref);
-                    }
+                    // Computing ahead of the application does not count as a use of the frames
+                    rs_frame_ref * refs[RS_STREAM_NATIVE_COUNT];
+                    const int count = get_frameset_frames((rs_frameset *)prepared->frames, refs);
+                    prepared->derived[stream - RS_STREAM_NATIVE_COUNT] = (frame_archive::frame_ref *)derive_frame(stream, refs, count);
                 }
-                else
+                catch (const std::exception & e)
                 {
-                    // Commit the frame to the archive
-                    archive->commit_frame(streams[i]);
+                    LOG_WARNING("Could not precompute " << stream << ", it is computed once its frame data is requested: " << e.what());
                 }
-            }
+            });
+        }
+        sync_archive->set_frameset_preparation([graph](frame_archive::shared_frameset * frames)
+        {
+            auto prepared = new prepared_frames();
+            prepared->frames = frames;
+            graph->submit(prepared);
         });
     }
-    
+
     this->archive = archive;
+    this->sync_archive = sync_archive;
+    streaming_modes = selected_modes;
     on_before_start(selected_modes);
+    set_capture_thread_scheduling(*device, capture_cpu_mask ? capture_cpu_mask : numa_cpus, capture_priority);
     start_streaming(*device, config.info.num_libuvc_transfer_buffers);
     capture_started = std::chrono::high_resolution_clock::now();
     capturing = true;
+
+    // Streams on demand are turned off until they are first consumed
+    demand.reset();
+    on_demand_subdevices = on_demand;
+    idle_subdevices = 0;
+    if(on_demand_subdevices)
+    {
+        int shortest_timeout = RS_MAX_STREAM_IDLE_TIMEOUT;
+        try
+        {
+            std::lock_guard<std::mutex> lock(demand_mutex);
+            for(auto & mode_selection : selected_modes)
+            {
+                if(!(on_demand_subdevices & (1 << mode_selection.mode.subdevice))) continue;
+                for(auto & output : mode_selection.get_outputs()) if(config.requests[output.first].enabled) shortest_timeout = std::min(shortest_timeout, config.idle_timeouts[output.first]);
+                set_subdevice_idle(mode_selection, true);
+            }
+        }
+        catch(...)
+        {
+            stop_video_streaming();
+            throw;
+        }
+        std::atomic_store(&demand_monitor, shared_executor->create_job([this]() { update_stream_demand(); }, std::chrono::milliseconds(std::max(10, shortest_timeout / 4))));
+    }
+
+    shedding.reset();
+    if(!shedding.get_order().empty())
+    {
+        last_load_check = get_monotonic_time();
+        for(int s = 0; s < RS_STREAM_NATIVE_COUNT; ++s) checked_callback_nanoseconds[s] = metrics.get((rs_stream)s, RS_STREAM_METRIC_CALLBACK_NANOSECONDS);
+        std::atomic_store(&load_monitor, shared_executor->create_job([this]() { update_load_shedding(); }, std::chrono::milliseconds(RS_LOAD_CHECK_PERIOD)));
+    }
+}
+
+void rs_device_base::set_subdevice_idle(const subdevice_mode_selection & mode_selection, bool idle)
+{
+    const int subdevice = mode_selection.mode.subdevice;
+    if(idle) pause_streaming(*device, subdevice);
+    else resume_streaming(*device, subdevice);
+    if(idle) idle_subdevices |= 1 << subdevice;
+    else idle_subdevices &= ~(1 << subdevice);
+    for(auto & output : mode_selection.get_outputs())
+    {
+        if(!config.requests[output.first].enabled) continue;
+        demand.set_idle(output.first, idle);
+        if (sync_archive) sync_archive->set_stream_idle(output.first, idle);
+    }
+}
+
+// Turns the subdevices on demand whose streams were all left unconsumed for their idle timeouts off, and those with a stream consumed since on
+void rs_device_base::update_stream_demand()
+{
+    std::lock_guard<std::mutex> lock(demand_mutex);
+    if(paused) return; // Looked at again once the device resumes
+    const auto now = stream_demand::now();
+    for(auto & mode_selection : streaming_modes)
+    {
+        const int subdevice = mode_selection.mode.subdevice;
+        if(!(on_demand_subdevices & (1 << subdevice))) continue;
+        bool wanted = false;
+        for(auto & output : mode_selection.get_outputs())
+        {
+            if(!config.requests[output.first].enabled) continue;
+            const auto last_use = demand.get_last_use(output.first);
+            wanted |= last_use && now - last_use < config.idle_timeouts[output.first];
+        }
+        const bool idle = (idle_subdevices & (1 << subdevice)) != 0;
+        if(wanted != idle) continue;
+        try { set_subdevice_idle(mode_selection, !wanted); }
+        catch(const std::exception & e) { LOG_WARNING("Subdevice " << subdevice << " of " << get_name() << " could not be turned " << (wanted ? "on" : "off") << ": " << e.what()); }
+    }
+}
+
+// A new frame of the stream would be culled, or push the oldest one queued out: the frames waiting for the application in the sync archive,
+// or for the frame callback in its queue, reached the depth of the queue
+bool rs_device_base::is_stream_backlogged(rs_stream stream) const
+{
+    if(callback_queues[stream]) return callback_queues[stream]->get_queued_count() >= static_cast<size_t>(config.callback_queue_depths[stream]);
+    return metrics.get(stream, RS_STREAM_METRIC_QUEUED_FRAMES) >= static_cast<unsigned long long>(config.queue_policies[stream].get_max_queued_frames());
+}
+
+// Finds the device overloaded once a stream is backlogged, or its frame callback was busy for most of the time since the last check
+void rs_device_base::update_load_shedding()
+{
+    if(paused) return; // The application takes its time while nothing streams
+    const double now = get_monotonic_time();
+    const double elapsed = now - last_load_check;
+    last_load_check = now;
+
+    bool overloaded = false;
+    for(int s = 0; s < RS_STREAM_NATIVE_COUNT; ++s)
+    {
+        const auto stream = static_cast<rs_stream>(s);
+        const auto callback_nanoseconds = metrics.get(stream, RS_STREAM_METRIC_CALLBACK_NANOSECONDS);
+        const auto busy = callback_nanoseconds - checked_callback_nanoseconds[s];
+        checked_callback_nanoseconds[s] = callback_nanoseconds;
+        if(!config.requests[s].enabled || demand.is_idle(stream)) continue;
+        overloaded |= is_stream_backlogged(stream) || (elapsed > 0 && busy > stream_metrics::to_nanoseconds(elapsed * RS_MAX_CALLBACK_BUSY_RATIO));
+    }
+    shedding.update(overloaded);
 }
 
 void rs_device_base::stop_video_streaming()
 {
     if(!capturing) throw std::runtime_error("cannot stop device without first starting device");
+    if(auto monitor = std::atomic_exchange(&load_monitor, std::shared_ptr<executor::job>()))
+    {
+        monitor->cancel();
+        shedding.reset();
+    }
+    if(auto monitor = std::atomic_exchange(&demand_monitor, std::shared_ptr<executor::job>()))
+    {
+        monitor->cancel();
+        on_demand_subdevices = idle_subdevices = 0;
+        demand.reset();
+    }
     stop_streaming(*device);
+    if (pipeline)
+    {
+        // Frames still queued for unpacking are delivered before the archive is flushed
+        pipeline->stop();
+        pipeline.reset();
+    }
+    if (precompute_graph)
+    {
+        // Framesets still being prepared are published before the archive is flushed
+        precompute_graph->stop();
+        precompute_graph.reset();
+    }
+    // Callbacks in progress complete before the archive is flushed, frames still queued for them are released
+    for (auto & queue : callback_queues) if (queue) queue->stop();
+    for (auto & queues : subscriber_queues) for (auto & queue : queues) if (queue.second) queue.second->stop();
     archive->flush();
+    frames_ready->reset();
     capturing = false;
+    paused = false;
+}
+
+void rs_device_base::pause()
+{
+    if(!capturing) throw std::runtime_error("cannot pause device without first starting device");
+    if(paused) return;
+    try
+    {
+        std::lock_guard<std::mutex> lock(demand_mutex);
+        pause_streaming(*device);
+        paused = true;
+    }
+    catch(...)
+    {
+        stop_video_streaming();
+        throw;
+    }
+}
+
+// The archive, the timestamp readers and the capture buffers of the last start are still in place, only the streams are turned on again, but
+// for those turned off for lack of demand
+void rs_device_base::resume()
+{
+    if(!paused) throw std::runtime_error("cannot resume device without first pausing device");
+    try
+    {
+        on_before_start(streaming_modes);
+        std::lock_guard<std::mutex> lock(demand_mutex);
+        if(!idle_subdevices) resume_streaming(*device);
+        else for(auto & mode_selection : streaming_modes) if(!(idle_subdevices & (1 << mode_selection.mode.subdevice))) resume_streaming(*device, mode_selection.mode.subdevice);
+        paused = false;
+    }
+    catch(...)
+    {
+        stop_video_streaming();
+        throw;
+    }
+    if(auto monitor = std::atomic_load(&demand_monitor)) monitor->trigger(); // For the streams consumed while paused
 }
 
 void rs_device_base::wait_all_streams()
 {
     if(!capturing) return;
-    if(!archive) return;
+    if(!sync_archive) return;
 
-    archive->wait_for_frames();
+    sync_archive->wait_for_frames();
 }
 
 bool rs_device_base::poll_all_streams()
 {
     if(!capturing) return false;
-    if(!archive) return false;
-    return archive->poll_for_frames();
+    if(!sync_archive) return false;
+    return sync_archive->poll_for_frames();
+}
+
+bool rs_device_base::wait_all_streams(unsigned int timeout_ms)
+{
+    if(!capturing) return false;
+    if(!sync_archive) return false;
+    return sync_archive->try_wait_for_frames(std::chrono::milliseconds(timeout_ms));
+}
+
+void * rs_device_base::get_frames_ready_handle()
+{
+    return frames_ready->get_handle();
+}
+
+rs_frame_ref* rs_device_base::get_latest_frame(rs_stream stream)
+{
+    if (!mailbox) throw std::runtime_error("latest frames are only kept with RS_OPTION_FRAME_MAILBOX_ENABLED");
+    if (!capturing || !archive) return nullptr;
+    if (!archive->is_stream_enabled(stream)) throw std::runtime_error(to_string() << "stream " << stream << " is not enabled");
+    demand.consume(stream);
+    return archive->take_latest_frame(stream);
 }
 
 void rs_device_base::release_frame(rs_frame_ref* ref)
@@ -522,9 +1722,150 @@ rs_frame_ref* ::rs_device_base::clone_frame(rs_frame_ref* frame)
     return result;
 }
 
+rs_frame_ref* rs_device_base::detach_frame(rs_frameset* frames, rs_stream stream)
+{
+    if (!archive->is_stream_enabled(stream)) throw std::runtime_error(to_string() << "stream " << stream << " is not part of the frameset");
+    demand.consume(stream);
+    auto result = archive->detach_frame_ref((frame_archive::shared_frameset *)frames, stream);
+    if (!result) throw std::runtime_error("Not enough resources to detach frame!");
+    return result;
+}
+
+void rs_device_base::release_frames(rs_frameset* frames)
+{
+    archive->release_frameset((frame_archive::shared_frameset *)frames);
+}
+
+rs_frame_ref* rs_device_base::process_frames(rs_stream stream, rs_frame_ref * const frames[], int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        auto source_stream = ((const frame_archive::frame_ref *)frames[i])->get_stream_type();
+        if (is_valid(source_stream) && source_stream < RS_STREAM_NATIVE_COUNT) demand.consume(source_stream);
+    }
+    return derive_frame(stream, frames, count);
+}
+
+rs_frame_ref* rs_device_base::derive_frame(rs_stream stream, rs_frame_ref * const frames[], int count)
+{
+    RS_TRACE_SPAN("derive");
+    auto archive = this->archive;
+    if (!archive) throw std::runtime_error("streaming not started!");
+    auto & derived = *streams[stream];
+    if (!derived.is_enabled()) throw std::runtime_error(to_string() << "stream not enabled: " << stream);
+
+    const frame_archive::frame_ref * sources[RS_STREAM_NATIVE_COUNT] = {};
+    for (int i = 0; i < count; ++i)
+    {
+        auto source = (const frame_archive::frame_ref *)frames[i];
+        auto source_stream = source->get_stream_type();
+        if (!is_valid(source_stream) || source_stream >= RS_STREAM_NATIVE_COUNT) throw std::runtime_error(to_string() << "frame of stream " << source_stream << " cannot be processed");
+        sources[source_stream] = source;
+    }
+
+    // Every frame a derived image reads must come from the mode its stream is currently started in, or the calibration would not describe it
+    auto lookup = [&sources](const stream_interface & source) -> source_image
+    {
+        auto source_stream = source.get_stream_type();
+        auto frame = source_stream < RS_STREAM_NATIVE_COUNT ? sources[source_stream] : nullptr;
+        if (!frame || !frame->get_frame_data()) throw std::runtime_error(to_string() << "no frame of stream " << source_stream << " was provided");
+        auto intrin = source.get_intrinsics();
+        if (frame->get_frame_format() != source.get_format() || frame->get_frame_width() < intrin.width || frame->get_frame_height() < intrin.height)
+            throw std::runtime_error(to_string() << "frame of stream " << source_stream << " does not match the mode of the stream");
+        return {frame->get_frame_data(), frame->get_frame_stride() * 8 / frame->get_frame_bpp(), frame->get_frame_depth_runs()}; // Frames kept in RS_OUTPUT_BUFFER_FORMAT_NATIVE are read through their padding
+    };
+
+    // The derived frame carries the timestamp and metadata of the frame it follows
+    auto timing_source = sources[derived.get_frame_source()];
+    if (!timing_source || !timing_source->get_additional_data()) throw std::runtime_error(to_string() << "no frame of stream " << derived.get_frame_source() << " was provided");
+    auto additional_data = *timing_source->get_additional_data();
+    auto intrin = derived.get_intrinsics();
+    additional_data.width = intrin.width;
+    additional_data.stride_x = derived.get_row_stride();
+    additional_data.height = additional_data.stride_y = intrin.height;
+    additional_data.format = derived.get_format();
+    additional_data.bpp = get_image_bpp(additional_data.format);
+    additional_data.stream_type = stream;
+    additional_data.pad = 0;
+
+    auto result = archive->create_derived_frame(additional_data, [&derived, &lookup](byte * dest) { derived.compute_frame(dest, lookup); });
+    if (!result) throw std::runtime_error("Not enough resources to process frame!");
+    return result;
+}
+
+rs_frame_ref* rs_device_base::process_frameset(const rs_frameset* frames, rs_stream stream)
+{
+    rs_frame_ref * refs[RS_STREAM_NATIVE_COUNT];
+    const int count = get_frameset_frames(frames, refs);
+    return process_frames(stream, refs, count);
+}
+
+int rs_device_base::get_frameset_frame_info(const rs_frameset * frames, rs_frame_info * infos, int max_count)
+{
+    static_assert(RS_FRAME_METADATA_COUNT <= 64, "rs_frame_info::supported_metadata has a bit per metadata");
+    rs_frame_ref * refs[RS_STREAM_NATIVE_COUNT];
+    const int count = get_frameset_frames(frames, refs);
+    for (int i = 0; i < std::min(count, max_count); ++i)
+    {
+        // Reading a frame here counts as reading it detached
+        const auto & frame = *refs[i];
+        auto & info = infos[i];
+        info.stream = frame.get_stream_type();
+        demand.consume(info.stream);
+        info.data = frame.get_frame_data();
+        info.width = frame.get_frame_width();
+        info.height = frame.get_frame_height();
+        info.stride = frame.get_frame_stride();
+        info.bpp = frame.get_frame_bpp();
+        info.format = frame.get_frame_format();
+        info.framerate = frame.get_frame_framerate();
+        info.timestamp = frame.get_frame_timestamp();
+        info.timestamp_domain = frame.get_frame_timestamp_domain();
+        info.frame_number = frame.get_frame_number();
+        info.system_time = frame.get_frame_system_time();
+        info.supported_metadata = 0;
+        for (int m = 0; m < RS_FRAME_METADATA_COUNT; ++m)
+        {
+            const bool supported = frame.supports_frame_metadata((rs_frame_metadata)m);
+            info.metadata[m] = supported ? frame.get_frame_metadata((rs_frame_metadata)m) : 0;
+            if (supported) info.supported_metadata |= 1ull << m;
+        }
+    }
+    return count;
+}
+
 void rs_device_base::update_device_info(rsimpl::static_device_info& info)
 {
-    info.options.push_back({ RS_OPTION_FRAMES_QUEUE_SIZE,     1, RS_USER_QUEUE_SIZE,      1, RS_USER_QUEUE_SIZE });
+    info.options.push_back({ RS_OPTION_FRAMES_QUEUE_SIZE,                   1,    RS_MAX_USER_QUEUE_SIZE,           1,    RS_USER_QUEUE_SIZE });
+    info.options.push_back({ RS_OPTION_FRAME_UNPACK_THREADS,                0,    RS_MAX_UNPACK_THREADS,            1,    0 });
+    info.options.push_back({ RS_OPTION_DEPTH_DECIMATION_FACTOR,             1,    RS_MAX_DEPTH_DECIMATION,          1,    1 });
+    info.options.push_back({ RS_OPTION_DEPTH_DECIMATION_MODE,               0,    1,                                1,    0 });
+    info.options.push_back({ RS_OPTION_DEPTH_SPATIAL_FILTER_ALPHA,          0.25, 1,                                0.05, 1 });
+    info.options.push_back({ RS_OPTION_DEPTH_SPATIAL_FILTER_DELTA,          1,    RS_MAX_DEPTH_FILTER_DELTA,        1,    20 });
+    info.options.push_back({ RS_OPTION_DEPTH_TEMPORAL_FILTER_ALPHA,         0.05, 1,                                0.05, 1 });
+    info.options.push_back({ RS_OPTION_DEPTH_TEMPORAL_FILTER_DELTA,         1,    RS_MAX_DEPTH_FILTER_DELTA,        1,    20 });
+    info.options.push_back({ RS_OPTION_DEPTH_TEMPORAL_FILTER_PERSISTENCE,   0,    RS_MAX_DEPTH_FILTER_PERSISTENCE,  1,    0 });
+    info.options.push_back({ RS_OPTION_DEPTH_STATISTICS_ENABLED,            0,    1,                                1,    0 });
+    info.options.push_back({ RS_OPTION_PRECOMPUTED_STREAMS,                 0,    RS_MAX_PRECOMPUTED_STREAMS,       1,    0 });
+    info.options.push_back({ RS_OPTION_DEPTH_COLORIZER_EQUALIZATION_ENABLED, 0,   1,                                1,    1 });
+    info.options.push_back({ RS_OPTION_DEPTH_COLORIZER_MAX_DISTANCE,        0.1,  20,                               0.1,  6 });
+    info.options.push_back({ RS_OPTION_POINTS_VOXEL_SIZE,                   0,    1,                                0.001, 0 });
+    info.options.push_back({ RS_OPTION_CAPTURE_THREAD_AFFINITY,             0,    RS_MAX_CAPTURE_THREAD_AFFINITY,   1,    0 });
+    info.options.push_back({ RS_OPTION_CAPTURE_THREAD_PRIORITY,             0,    RS_MAX_CAPTURE_THREAD_PRIORITY,   1,    0 });
+    info.options.push_back({ RS_OPTION_CAPTURE_MEMORY,                      0,    2,                                1,    0 });
+    info.options.push_back({ RS_OPTION_CONTROL_RETRY_BUDGET,                0,    RS_MAX_CONTROL_RETRY_BUDGET,      1,    RS_DEFAULT_CONTROL_RETRY_BUDGET });
+    info.options.push_back({ RS_OPTION_GPU_PROCESSING_ENABLED,              0,    1,                                1,    0 });
+    info.options.push_back({ RS_OPTION_DERIVED_ROW_ALIGNMENT,               0,    64,                               1,    0 });
+    info.options.push_back({ RS_OPTION_FRAME_MEMORY_PAGES,                  0,    2,                                1,    0 });
+    info.options.push_back({ RS_OPTION_NUMA_LOCALITY_ENABLED,               0,    1,                                1,    0 });
+    info.options.push_back({ RS_OPTION_FRAME_MAILBOX_ENABLED,               0,    1,                                1,    0 });
+    info.options.push_back({ RS_OPTION_INTERLEAVED_VIEWS_ENABLED,           0,    1,                                1,    0 });
+    info.options.push_back({ RS_OPTION_DEPTH_PYRAMID_LEVELS,                0,    RS_MAX_DEPTH_PYRAMID_LEVELS,      1,    0 });
+    info.options.push_back({ RS_OPTION_FRAME_UNPACK_BANDS,                  1,    RS_MAX_UNPACK_BANDS,              1,    1 });
+    info.options.push_back({ RS_OPTION_COLOR_DEMOSAIC_MODE,                 0,    1,                                1,    0 });
+    info.options.push_back({ RS_OPTION_DEPTH_RUNS_ENABLED,                  0,    1,                                1,    0 });
+    info.options.push_back({ RS_OPTION_INCREMENTAL_PROCESSING_ENABLED,      0,    1,                                1,    0 });
+    info.options.push_back({ RS_OPTION_ZERO_COPY_ENABLED,                   0,    1,                                1,    0 });
 }
 
 const char * rs_device_base::get_option_description(rs_option option) const
@@ -591,7 +1932,7 @@ const char * rs_device_base::get_option_description(rs_option option) const
     case RS_OPTION_FISHEYE_GAIN                                    : return "Fisheye image gain";
     case RS_OPTION_FISHEYE_STROBE                                  : return "Enables / disables fisheye strobe. When enabled this will align timestamps to common clock-domain with the motion events";
     case RS_OPTION_FISHEYE_EXTERNAL_TRIGGER                        : return "Enables / disables fisheye external trigger mode. When enabled fisheye image will be acquired in-sync with the depth image";
-    case RS_OPTION_FRAMES_QUEUE_SIZE                               : return "Number of frames the user is allowed to keep per stream. Trying to hold-on to more frames will cause frame-drops.";
+    case RS_OPTION_FRAMES_QUEUE_SIZE                               : return "Number of frames the user is allowed to keep per stream. Trying to hold-on to more frames will cause frame-drops. The frame pools are sized for it at start, growing on demand.";
     case RS_OPTION_FISHEYE_ENABLE_AUTO_EXPOSURE                    : return "Enable / disable fisheye auto-exposure";
     case RS_OPTION_FISHEYE_AUTO_EXPOSURE_MODE                      : return "0 - static auto-exposure, 1 - anti-flicker auto-exposure, 2 - hybrid";
     case RS_OPTION_FISHEYE_AUTO_EXPOSURE_ANTIFLICKER_RATE          : return "Fisheye auto-exposure anti-flicker rate, can be 50 or 60 Hz";
@@ -599,6 +1940,36 @@ const char * rs_device_base::get_option_description(rs_option option) const
     case RS_OPTION_FISHEYE_AUTO_EXPOSURE_SKIP_FRAMES               : return "In Fisheye auto-exposure sample every given number of frames";
     case RS_OPTION_HARDWARE_LOGGER_ENABLED                         : return "Enables / disables fetching diagnostic information from hardware (and writting the results to log)";
     case RS_OPTION_TOTAL_FRAME_DROPS                               : return "Total number of detected frame drops from all streams";
+    case RS_OPTION_FRAME_UNPACK_THREADS                            : return "Number of threads unpacking frames off the capture thread, 0 unpacks on the capture thread";
+    case RS_OPTION_DEPTH_DECIMATION_FACTOR                         : return "Shrink depth by this factor in both dimensions as it is unpacked, 1 delivers full resolution";
+    case RS_OPTION_DEPTH_DECIMATION_MODE                           : return "0 - decimate depth to the median of the valid pixels, 1 - to their mean";
+    case RS_OPTION_DEPTH_SPATIAL_FILTER_ALPHA                      : return "Weight of every depth pixel against its smoothed neighbours, 1 disables the spatial filter";
+    case RS_OPTION_DEPTH_SPATIAL_FILTER_DELTA                      : return "Neighbouring depth pixels this many depth units apart lie across an edge, and are not smoothed";
+    case RS_OPTION_DEPTH_TEMPORAL_FILTER_ALPHA                     : return "Weight of every depth pixel against its smoothed past, 1 disables temporal smoothing";
+    case RS_OPTION_DEPTH_TEMPORAL_FILTER_DELTA                     : return "Depth pixels which changed by this many depth units are not smoothed with their past";
+    case RS_OPTION_DEPTH_TEMPORAL_FILTER_PERSISTENCE               : return "Number of frames a depth pixel without data keeps its last valid depth";
+    case RS_OPTION_DEPTH_STATISTICS_ENABLED                        : return "Attach the depth range, valid pixel count and a coarse histogram to every depth frame as metadata";
+    case RS_OPTION_PRECOMPUTED_STREAMS                             : return "Bit mask of derived streams computed as soon as their frameset arrives, bit 0 is the point cloud";
+    case RS_OPTION_DEPTH_COLORIZER_EQUALIZATION_ENABLED            : return "1 - spread the colors of the colorized depth stream evenly over every frame, 0 - over a fixed range of distances";
+    case RS_OPTION_DEPTH_COLORIZER_MAX_DISTANCE                    : return "Distance in meters drawn in the farthest color of the colorized depth stream, while it is not equalized";
+    case RS_OPTION_POINTS_VOXEL_SIZE                               : return "Reduce the point cloud to the mean point of every cube this many meters wide, listed in front of the frame, 0 keeps every point";
+    case RS_OPTION_CAPTURE_THREAD_AFFINITY                         : return "Bit mask of the CPUs the capture threads may run on, 0 lets them run on every CPU";
+    case RS_OPTION_CAPTURE_THREAD_PRIORITY                         : return "SCHED_FIFO priority of the capture threads, 0 keeps the default scheduling";
+    case RS_OPTION_CAPTURE_MEMORY                                  : return "0 - capture into mapped driver buffers, 1 - into blocks of the frame allocator, 2 - into the dma-bufs provided for every stream";
+    case RS_OPTION_MOTION_DATA_TRANSFER_COUNT                      : return "Number of USB transfers kept queued for motion events, more of them tolerate longer delays in receiving them";
+    case RS_OPTION_CONTROL_RETRY_BUDGET                            : return "Milliseconds spent waiting between attempts at a failing control request before giving up";
+    case RS_OPTION_GPU_PROCESSING_ENABLED                          : return "Compute point clouds, rectified and aligned images on the CUDA device";
+    case RS_OPTION_DERIVED_ROW_ALIGNMENT                           : return "Bytes the rows of point clouds, rectified and aligned images are padded to a multiple of, 0 for packed rows";
+    case RS_OPTION_FRAME_MEMORY_PAGES                              : return "0 - frame memory of the heap, 1 - of transparent huge pages, 2 - of explicit huge pages. While streaming, the pages actually provided";
+    case RS_OPTION_NUMA_LOCALITY_ENABLED                           : return "Keep frame memory and the capture and unpack threads on the NUMA node of the USB host controller of the device";
+    case RS_OPTION_FRAME_MAILBOX_ENABLED                           : return "Keep only the latest frame of every stream, taken with rs_get_latest_frame() instead of waiting for framesets";
+    case RS_OPTION_INTERLEAVED_VIEWS_ENABLED                       : return "Hand out streams interleaved in one native frame, such as the Y8I infrared pair, as strided views of the driver buffer";
+    case RS_OPTION_DEPTH_PYRAMID_LEVELS                            : return "Levels of 2x2 reductions of depth, ignoring pixels with no data, built behind every depth frame";
+    case RS_OPTION_FRAME_UNPACK_BANDS                              : return "Most bands of rows one frame is split into to be unpacked on several threads, 1 unpacks it on one";
+    case RS_OPTION_COLOR_DEMOSAIC_MODE                             : return "0 - demosaic raw color bilinearly, 1 - correct the interpolation by the gradients of the known color";
+    case RS_OPTION_DEPTH_RUNS_ENABLED                              : return "Find the runs of pixels with data of every depth row, so point clouds and alignment skip the pixels without";
+    case RS_OPTION_INCREMENTAL_PROCESSING_ENABLED                  : return "Recompute point clouds, rectified and aligned images only where their source changed since the previous frame";
+    case RS_OPTION_ZERO_COPY_ENABLED                               : return "Hand out frames in driver memory instead of copying them, each frame held keeping a driver buffer from capturing";
     default: return rs_option_to_string(option);
     }
 }
@@ -665,11 +2036,155 @@ void rs_device_base::set_options(const rs_option options[], size_t count, const
         switch (options[i])
         {
         case  RS_OPTION_FRAMES_QUEUE_SIZE:
+            if (values[i] < 1 || values[i] > RS_MAX_USER_QUEUE_SIZE) throw std::runtime_error(to_string() << "frames queue size must be between 1 and " << RS_MAX_USER_QUEUE_SIZE);
+            if (capturing && archive && values[i] > archive->get_frame_pool_size())
+                throw std::runtime_error(to_string() << "frames queue size cannot be raised above " << archive->get_frame_pool_size() << ", the size of the frame pools, after having called rs_start_device()");
             max_publish_list_size = (uint32_t)values[i];
             break;
         case RS_OPTION_TOTAL_FRAME_DROPS:
             frames_drops_counter = (uint32_t)values[i];
             break;
+        case RS_OPTION_FRAME_UNPACK_THREADS:
+            if (capturing) throw std::runtime_error("unpack threads cannot be changed after having called rs_start_device()");
+            if (values[i] < 0 || values[i] > RS_MAX_UNPACK_THREADS) throw std::runtime_error(to_string() << "unpack threads must be between 0 and " << RS_MAX_UNPACK_THREADS);
+            unpack_threads = (int)values[i];
+            break;
+        case RS_OPTION_DEPTH_DECIMATION_FACTOR:
+            if (capturing) throw std::runtime_error("depth decimation cannot be changed after having called rs_start_device()");
+            if (values[i] < 1 || values[i] > RS_MAX_DEPTH_DECIMATION) throw std::runtime_error(to_string() << "depth decimation factor must be between 1 and " << RS_MAX_DEPTH_DECIMATION);
+            config.depth_decimation_factor = (int)values[i];
+            break;
+        case RS_OPTION_DEPTH_DECIMATION_MODE:
+            if (capturing) throw std::runtime_error("depth decimation cannot be changed after having called rs_start_device()");
+            if (values[i] != 0 && values[i] != 1) throw std::runtime_error("depth decimation mode must be 0 (median) or 1 (mean)");
+            config.depth_decimation_mean = values[i] == 1;
+            break;
+        case RS_OPTION_DEPTH_SPATIAL_FILTER_ALPHA:
+        case RS_OPTION_DEPTH_SPATIAL_FILTER_DELTA:
+        case RS_OPTION_DEPTH_TEMPORAL_FILTER_ALPHA:
+        case RS_OPTION_DEPTH_TEMPORAL_FILTER_DELTA:
+        case RS_OPTION_DEPTH_TEMPORAL_FILTER_PERSISTENCE:
+            set_depth_filter_option(options[i], values[i]);
+            break;
+        case RS_OPTION_DEPTH_STATISTICS_ENABLED:
+            if (capturing) throw std::runtime_error("depth statistics cannot be changed after having called rs_start_device()");
+            if (values[i] != 0 && values[i] != 1) throw std::runtime_error("depth statistics must be 0 (disabled) or 1 (enabled)");
+            config.gather_depth_statistics = values[i] == 1;
+            break;
+        case RS_OPTION_PRECOMPUTED_STREAMS:
+            if (capturing) throw std::runtime_error("precomputed streams cannot be changed after having called rs_start_device()");
+            if (values[i] < 0 || values[i] > RS_MAX_PRECOMPUTED_STREAMS) throw std::runtime_error(to_string() << "precomputed streams must be a bit mask between 0 and " << RS_MAX_PRECOMPUTED_STREAMS);
+            precomputed_streams = (int)values[i];
+            break;
+        case RS_OPTION_DEPTH_COLORIZER_EQUALIZATION_ENABLED:
+            if (values[i] != 0 && values[i] != 1) throw std::runtime_error("depth colorizer equalization must be 0 (disabled) or 1 (enabled)");
+            depth_colorized.set_colormap(values[i] == 1, depth_colorized.get_max_distance());
+            break;
+        case RS_OPTION_DEPTH_COLORIZER_MAX_DISTANCE:
+            if (values[i] < 0.1 || values[i] > 20) throw std::runtime_error("depth colorizer max distance must be between 0.1 and 20 meters");
+            depth_colorized.set_colormap(depth_colorized.is_equalized(), (float)values[i]);
+            break;
+        case RS_OPTION_POINTS_VOXEL_SIZE:
+            if (capturing) throw std::runtime_error("points voxel size cannot be changed after having called rs_start_device()");
+            if (values[i] < 0 || values[i] > 1) throw std::runtime_error("points voxel size must be between 0 and 1 meter");
+            points.set_voxel_size((float)values[i]);
+            break;
+        case RS_OPTION_CAPTURE_THREAD_AFFINITY:
+            if (capturing) throw std::runtime_error("capture thread affinity cannot be changed after having called rs_start_device()");
+            if (values[i] < 0 || values[i] > RS_MAX_CAPTURE_THREAD_AFFINITY || values[i] != std::floor(values[i])) throw std::runtime_error("capture thread affinity must be a bit mask of CPUs 0 to 52");
+            capture_cpu_mask = (uint64_t)values[i];
+            break;
+        case RS_OPTION_CAPTURE_THREAD_PRIORITY:
+            if (capturing) throw std::runtime_error("capture thread priority cannot be changed after having called rs_start_device()");
+            if (values[i] < 0 || values[i] > RS_MAX_CAPTURE_THREAD_PRIORITY) throw std::runtime_error(to_string() << "capture thread priority must be between 0 and " << RS_MAX_CAPTURE_THREAD_PRIORITY);
+            capture_priority = (int)values[i];
+            break;
+        case RS_OPTION_CAPTURE_MEMORY:
+            if (capturing) throw std::runtime_error("capture memory cannot be changed after having called rs_start_device()");
+            if (values[i] != 0 && values[i] != 1 && values[i] != 2) throw std::runtime_error("capture memory must be 0 for mapped driver buffers, 1 for the frame allocator or 2 for dma-bufs");
+            capture_memory_type = static_cast<uvc::capture_memory>((int)values[i]);
+            break;
+        case RS_OPTION_FRAME_MEMORY_PAGES:
+            if (capturing) throw std::runtime_error("frame memory pages cannot be changed after having called rs_start_device()");
+            if (values[i] != 0 && values[i] != 1 && values[i] != 2) throw std::runtime_error("frame memory pages must be 0 for the heap, 1 for transparent huge pages or 2 for explicit huge pages");
+            frame_pages = static_cast<frame_memory_pages>((int)values[i]);
+            break;
+        case RS_OPTION_NUMA_LOCALITY_ENABLED:
+            if (capturing) throw std::runtime_error("NUMA locality cannot be changed after having called rs_start_device()");
+            if (values[i] != 0 && values[i] != 1) throw std::runtime_error("NUMA locality must be 0 (disabled) or 1 (enabled)");
+            numa_local = values[i] == 1;
+            break;
+        case RS_OPTION_FRAME_MAILBOX_ENABLED:
+            if (capturing) throw std::runtime_error("frame mailboxes cannot be enabled or disabled after having called rs_start_device()");
+            if (values[i] != 0 && values[i] != 1) throw std::runtime_error("frame mailboxes must be 0 (disabled) or 1 (enabled)");
+            mailbox = values[i] == 1;
+            break;
+        case RS_OPTION_INTERLEAVED_VIEWS_ENABLED:
+            if (capturing) throw std::runtime_error("interleaved views cannot be enabled or disabled after having called rs_start_device()");
+            if (values[i] != 0 && values[i] != 1) throw std::runtime_error("interleaved views must be 0 (disabled) or 1 (enabled)");
+            config.interleaved_views = values[i] == 1;
+            break;
+        case RS_OPTION_DEPTH_PYRAMID_LEVELS:
+            if (capturing) throw std::runtime_error("depth pyramid levels cannot be changed after having called rs_start_device()");
+            if (values[i] < 0 || values[i] > RS_MAX_DEPTH_PYRAMID_LEVELS) throw std::runtime_error(to_string() << "depth pyramid levels must be between 0 and " << RS_MAX_DEPTH_PYRAMID_LEVELS);
+            config.depth_pyramid_levels = (int)values[i];
+            break;
+        case RS_OPTION_FRAME_UNPACK_BANDS:
+            if (capturing) throw std::runtime_error("frame unpack bands cannot be changed after having called rs_start_device()");
+            if (values[i] < 1 || values[i] > RS_MAX_UNPACK_BANDS) throw std::runtime_error(to_string() << "frame unpack bands must be between 1 and " << RS_MAX_UNPACK_BANDS);
+            config.unpack_bands = (int)values[i];
+            break;
+        case RS_OPTION_COLOR_DEMOSAIC_MODE:
+            if (capturing) throw std::runtime_error("color demosaicing cannot be changed after having called rs_start_device()");
+            if (values[i] != 0 && values[i] != 1) throw std::runtime_error("color demosaic mode must be 0 (bilinear) or 1 (gradient-corrected)");
+            config.color_demosaic_corrected = values[i] == 1;
+            break;
+        case RS_OPTION_DEPTH_RUNS_ENABLED:
+            if (capturing) throw std::runtime_error("depth runs cannot be enabled or disabled after having called rs_start_device()");
+            if (values[i] != 0 && values[i] != 1) throw std::runtime_error("depth runs must be 0 (disabled) or 1 (enabled)");
+            config.depth_runs = values[i] == 1;
+            break;
+        case RS_OPTION_INCREMENTAL_PROCESSING_ENABLED:
+            if (capturing) throw std::runtime_error("incremental processing cannot be changed after having called rs_start_device()");
+            if (values[i] != 0 && values[i] != 1) throw std::runtime_error("incremental processing must be 0 (disabled) or 1 (enabled)");
+            points.set_incremental_processing(values[i] == 1);
+            rect_color.set_incremental_processing(values[i] == 1);
+            for (auto aligned : { &color_to_depth, &depth_to_color, &depth_to_rect_color, &infrared2_to_depth, &depth_to_infrared2 }) aligned->set_incremental_processing(values[i] == 1);
+            break;
+        case RS_OPTION_ZERO_COPY_ENABLED:
+            if (capturing) throw std::runtime_error("zero-copy delivery cannot be enabled or disabled after having called rs_start_device()");
+            if (values[i] != 0 && values[i] != 1) throw std::runtime_error("zero-copy delivery must be 0 (disabled) or 1 (enabled)");
+            zero_copy = values[i] == 1;
+            break;
+        case RS_OPTION_MOTION_DATA_TRANSFER_COUNT:
+            if (data_acquisition_active) throw std::runtime_error("motion data transfer count cannot be changed while motion tracking is active");
+            if (values[i] < 1 || values[i] > RS_MAX_MOTION_DATA_TRANSFERS) throw std::runtime_error(to_string() << "motion data transfer count must be between 1 and " << RS_MAX_MOTION_DATA_TRANSFERS);
+            motion_data_transfers = (int)values[i];
+            break;
+        case RS_OPTION_CONTROL_RETRY_BUDGET:
+            if (values[i] < 0 || values[i] > RS_MAX_CONTROL_RETRY_BUDGET) throw std::runtime_error(to_string() << "control retry budget must be between 0 and " << RS_MAX_CONTROL_RETRY_BUDGET << " ms");
+            set_control_retry_budget(*device, (int)values[i]);
+            break;
+        case RS_OPTION_GPU_PROCESSING_ENABLED:
+            if (capturing) throw std::runtime_error("GPU processing cannot be changed after having called rs_start_device()");
+            if (values[i] != 0 && values[i] != 1) throw std::runtime_error("GPU processing must be 0 (disabled) or 1 (enabled)");
+            if (values[i] == 1 && !gpu::is_available()) throw std::runtime_error("GPU processing requires a library built with BUILD_WITH_CUDA and a CUDA device");
+            points.set_gpu_processing(values[i] == 1);
+            rect_color.set_gpu_processing(values[i] == 1);
+            for (auto aligned : { &color_to_depth, &depth_to_color, &depth_to_rect_color, &infrared2_to_depth, &depth_to_infrared2 }) aligned->set_gpu_processing(values[i] == 1);
+            break;
+        case RS_OPTION_DERIVED_ROW_ALIGNMENT:
+        {
+            if (capturing) throw std::runtime_error("the row alignment of derived streams cannot be changed after having called rs_start_device()");
+            const int alignment = (int)values[i];
+            if (alignment != values[i] || alignment < 0 || alignment > 64 || (alignment & (alignment - 1))) throw std::runtime_error("the row alignment of derived streams must be 0 or a power of two up to 64");
+            points.set_row_alignment(alignment);
+            rect_color.set_row_alignment(alignment);
+            rect_fisheye.set_row_alignment(alignment);
+            normals.set_row_alignment(alignment);
+            for (auto aligned : { &color_to_depth, &depth_to_color, &depth_to_rect_color, &infrared2_to_depth, &depth_to_infrared2 }) aligned->set_row_alignment(alignment);
+            break;
+        }
         default:
             LOG_WARNING("Cannot set " << options[i] << " to " << values[i] << " on " << get_name());
             throw std::logic_error("Option unsupported");
@@ -678,6 +2193,26 @@ void rs_device_base::set_options(const rs_option options[], size_t count, const
     }
 }
 
+void rs_device_base::set_depth_filter_option(rs_option option, double value)
+{
+    if (capturing) throw std::runtime_error("depth filters cannot be changed after having called rs_start_device()");
+    for (auto & o : config.info.options)
+    {
+        if (o.option == option && (value < o.min || value > o.max)) throw std::runtime_error(to_string() << rs_option_to_string(option) << " must be between " << o.min << " and " << o.max);
+    }
+
+    auto & filter = config.depth_filter;
+    switch (option)
+    {
+    case RS_OPTION_DEPTH_SPATIAL_FILTER_ALPHA:          filter.spatial_alpha = (float)value; break;
+    case RS_OPTION_DEPTH_SPATIAL_FILTER_DELTA:          filter.spatial_delta = (int)value; break;
+    case RS_OPTION_DEPTH_TEMPORAL_FILTER_ALPHA:         filter.temporal_alpha = (float)value; break;
+    case RS_OPTION_DEPTH_TEMPORAL_FILTER_DELTA:         filter.temporal_delta = (int)value; break;
+    case RS_OPTION_DEPTH_TEMPORAL_FILTER_PERSISTENCE:   filter.temporal_persistence = (int)value; break;
+    default: throw std::logic_error("not a depth filter option");
+    }
+}
+
 void rs_device_base::get_options(const rs_option options[], size_t count, double values[])
 {
     for (size_t i = 0; i < count; ++i)
@@ -690,6 +2225,96 @@ void rs_device_base::get_options(const rs_option options[], size_t count, double
         case  RS_OPTION_TOTAL_FRAME_DROPS:
             values[i] = frames_drops_counter;
             break;
+        case RS_OPTION_FRAME_UNPACK_THREADS:
+            values[i] = unpack_threads;
+            break;
+        case RS_OPTION_DEPTH_DECIMATION_FACTOR:
+            values[i] = config.depth_decimation_factor;
+            break;
+        case RS_OPTION_DEPTH_DECIMATION_MODE:
+            values[i] = config.depth_decimation_mean ? 1 : 0;
+            break;
+        case RS_OPTION_DEPTH_SPATIAL_FILTER_ALPHA:
+            values[i] = config.depth_filter.spatial_alpha;
+            break;
+        case RS_OPTION_DEPTH_SPATIAL_FILTER_DELTA:
+            values[i] = config.depth_filter.spatial_delta;
+            break;
+        case RS_OPTION_DEPTH_TEMPORAL_FILTER_ALPHA:
+            values[i] = config.depth_filter.temporal_alpha;
+            break;
+        case RS_OPTION_DEPTH_TEMPORAL_FILTER_DELTA:
+            values[i] = config.depth_filter.temporal_delta;
+            break;
+        case RS_OPTION_DEPTH_TEMPORAL_FILTER_PERSISTENCE:
+            values[i] = config.depth_filter.temporal_persistence;
+            break;
+        case RS_OPTION_DEPTH_STATISTICS_ENABLED:
+            values[i] = config.gather_depth_statistics ? 1 : 0;
+            break;
+        case RS_OPTION_PRECOMPUTED_STREAMS:
+            values[i] = precomputed_streams;
+            break;
+        case RS_OPTION_DEPTH_COLORIZER_EQUALIZATION_ENABLED:
+            values[i] = depth_colorized.is_equalized() ? 1 : 0;
+            break;
+        case RS_OPTION_DEPTH_COLORIZER_MAX_DISTANCE:
+            values[i] = depth_colorized.get_max_distance();
+            break;
+        case RS_OPTION_POINTS_VOXEL_SIZE:
+            values[i] = points.get_voxel_size();
+            break;
+        case RS_OPTION_CAPTURE_THREAD_AFFINITY:
+            values[i] = (double)capture_cpu_mask;
+            break;
+        case RS_OPTION_CAPTURE_THREAD_PRIORITY:
+            values[i] = capture_priority;
+            break;
+        case RS_OPTION_CAPTURE_MEMORY:
+            values[i] = static_cast<int>(capture_memory_type);
+            break;
+        case RS_OPTION_FRAME_MEMORY_PAGES:
+            values[i] = static_cast<int>(capturing && page_allocator ? page_allocator->get_provided_pages() : frame_pages);
+            break;
+        case RS_OPTION_NUMA_LOCALITY_ENABLED:
+            values[i] = numa_local ? 1 : 0;
+            break;
+        case RS_OPTION_FRAME_MAILBOX_ENABLED:
+            values[i] = mailbox ? 1 : 0;
+            break;
+        case RS_OPTION_INTERLEAVED_VIEWS_ENABLED:
+            values[i] = config.interleaved_views ? 1 : 0;
+            break;
+        case RS_OPTION_DEPTH_PYRAMID_LEVELS:
+            values[i] = config.depth_pyramid_levels;
+            break;
+        case RS_OPTION_FRAME_UNPACK_BANDS:
+            values[i] = config.unpack_bands;
+            break;
+        case RS_OPTION_COLOR_DEMOSAIC_MODE:
+            values[i] = config.color_demosaic_corrected ? 1 : 0;
+            break;
+        case RS_OPTION_DEPTH_RUNS_ENABLED:
+            values[i] = config.depth_runs ? 1 : 0;
+            break;
+        case RS_OPTION_INCREMENTAL_PROCESSING_ENABLED:
+            values[i] = points.is_incremental_processing() ? 1 : 0;
+            break;
+        case RS_OPTION_ZERO_COPY_ENABLED:
+            values[i] = zero_copy ? 1 : 0;
+            break;
+        case RS_OPTION_MOTION_DATA_TRANSFER_COUNT:
+            values[i] = motion_data_transfers;
+            break;
+        case RS_OPTION_CONTROL_RETRY_BUDGET:
+            values[i] = get_control_retry_budget(*device);
+            break;
+        case RS_OPTION_GPU_PROCESSING_ENABLED:
+            values[i] = points.is_gpu_processing() ? 1 : 0;
+            break;
+        case RS_OPTION_DERIVED_ROW_ALIGNMENT:
+            values[i] = points.get_row_alignment();
+            break;
         default:
             LOG_WARNING("Cannot get " << options[i] << " on " << get_name());
             throw std::logic_error("Option unsupported");
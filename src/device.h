@@ -7,12 +7,31 @@
 
 #include "uvc.h"
 #include "stream.h"
+#include "executor.h"
+#include "latency.h"
+#include "metrics.h"
+#include "fw-log.h"
 #include <chrono>
 #include <memory>
 #include <vector>
 
 namespace rsimpl
 {
+    class unpack_pipeline;
+    class task_graph;
+    class frames_ready_signal;
+    class option_request_queue;
+    class hw_command_queue;
+    class frame_callback_queue;
+    class motion_history;
+    class frame_history;
+    class mapped_frame_allocator;
+    enum class frame_memory_pages;
+    namespace recording { class writer; struct device_record; struct mode_description; }
+    namespace shared_ring { class publisher; }
+
+    typedef std::function<void(int bytes_sent, int size)> blob_progress; // Told of the bytes of a blob sent to the device so far
+
     // This class is used to buffer up several writes to a structure-valued XU control, and send the entire structure all at once
     // Additionally, it will ensure that any fields not set in a given struct will retain their original values
     template<class T, class R, class W> struct struct_interface
@@ -51,6 +70,20 @@ namespace rsimpl
             return number;
         }
 
+        // Fixes a run of numbers in arrival order in place, with the same result as fixing them one by one but without a branch per number
+        void fix(T * numbers, size_t count)
+        {
+            auto wraparounds = num_of_wraparounds;
+            auto last = last_number;
+            for (size_t i = 0; i < count; ++i)
+            {
+                wraparounds += (numbers[i] + wraparounds*max_number) < last;
+                last = numbers[i] += wraparounds*max_number;
+            }
+            num_of_wraparounds = wraparounds;
+            last_number = last;
+        }
+
     private:
         T max_number;
         T last_number;
@@ -77,26 +110,85 @@ private:
     const std::shared_ptr<rsimpl::uvc::device>  device;
 protected:
     rsimpl::device_config                       config;
+    const std::shared_ptr<rsimpl::executor>     shared_executor;        // Runs the periodic and background jobs of the device, which are all cancelled before it goes
 private:
     rsimpl::native_stream                       depth, color, infrared, infrared2, fisheye;
     rsimpl::point_stream                        points;
-    rsimpl::rectified_stream                    rect_color;
+    rsimpl::rectified_stream                    rect_color, rect_fisheye;
     rsimpl::aligned_stream                      color_to_depth, depth_to_color, depth_to_rect_color, infrared2_to_depth, depth_to_infrared2;
+    rsimpl::colorized_stream                    depth_colorized;
+    rsimpl::normal_stream                       normals;
     rsimpl::native_stream *                     native_streams[RS_STREAM_NATIVE_COUNT];
     rsimpl::stream_interface *                  streams[RS_STREAM_COUNT];
 
     bool                                        capturing;
+    bool                                        paused;                 // Capturing, with the video streams off but their buffers and archive kept
+    std::vector<rsimpl::subdevice_mode_selection> streaming_modes;      // Modes selected by the last start, for resuming
     bool                                        data_acquisition_active;
     std::chrono::high_resolution_clock::time_point capture_started;
     std::atomic<uint32_t>                       max_publish_list_size;
     std::atomic<uint32_t>                       event_queue_size;
     std::atomic<uint32_t>                       events_timeout;
-    std::shared_ptr<rsimpl::syncronizing_archive> archive;
+    std::shared_ptr<rsimpl::frame_archive>      archive;                // Of the current capture, a plain frame_archive when every enabled stream has a frame callback
+    std::shared_ptr<rsimpl::syncronizing_archive> sync_archive;         // archive, if it synchronizes the frames into framesets, null otherwise
+    int                                         unpack_threads;
+    uint64_t                                    capture_cpu_mask;       // Scheduling of the backend threads receiving frames, see uvc::set_capture_thread_scheduling
+    int                                         capture_priority;
+    rsimpl::uvc::capture_memory                 capture_memory_type;    // Applied to every subdevice streaming, with the dma-bufs of config.capture_dmabufs
+    rsimpl::frame_memory_pages                  frame_pages;            // Of the frame memory of the library, unless the application set a frame allocator
+    std::shared_ptr<rsimpl::mapped_frame_allocator> page_allocator;  // Of the current capture if frame_pages asks for huge pages or memory of a NUMA node, keeping the pages it could provide
+    bool                                        numa_local;             // Places frame memory and the capture and unpack threads on the NUMA node of the USB host controller
+    bool                                        zero_copy;              // Hands out pass-through frames in driver memory where the backend keeps it valid, instead of copying them
+    bool                                        mailbox;                // Frames without a callback go to the mailbox of their stream instead of the sync queues
+    int                                         motion_data_transfers;  // Interrupt transfers kept queued while motion tracking
+    std::shared_ptr<rsimpl::unpack_pipeline>    pipeline;
+    int                                         precomputed_streams;    // Bit mask of derived streams, bit k standing for stream RS_STREAM_NATIVE_COUNT + k
+    std::shared_ptr<rsimpl::task_graph>         precompute_graph;       // Computes the precomputed streams of every frameset, built at start from those enabled
+    std::unique_ptr<rsimpl::frames_ready_signal> frames_ready;
+    std::unique_ptr<rsimpl::option_request_queue> option_requests; // Serves set_options_async and get_options_async on a job of the executor
+    std::mutex                                  option_transaction_mutex;
+    bool                                        option_transaction_open;
+    std::vector<std::pair<rs_option, double>>   held_options;           // Writes of the open transaction, in the order they were made
+    std::shared_ptr<rsimpl::motion_history>     motion_samples;         // Replaced through atomic_store whenever motion tracking starts, queried through atomic_load
+    std::shared_ptr<rsimpl::recording::writer>  recorder;               // Set through atomic_store while recording, loaded by the capture threads for every frame
+    std::shared_ptr<rsimpl::shared_ring::publisher> publisher;          // Set through atomic_store while publishing, loaded like recorder
+    std::shared_ptr<rsimpl::frame_history>      history;                // Set through atomic_store while keeping a frame history, loaded like recorder
+    std::shared_ptr<rsimpl::frame_callback_queue> callback_queues[RS_STREAM_NATIVE_COUNT]; // Of the streams given a callback queue, kept after stopping for their drop counts
+    std::vector<std::pair<int, std::shared_ptr<rsimpl::frame_callback_queue>>> subscriber_queues[RS_STREAM_NATIVE_COUNT]; // By subscriber id, in the order of config.subscribers, null for those without a queue
+    rsimpl::stream_demand                       demand;                 // Of the streams started on demand
+    std::shared_ptr<rsimpl::executor::job>      demand_monitor;         // Set through atomic_store while streams are on demand, turns their subdevices off once idle and on again once consumed
+    std::mutex                                  demand_mutex;           // Serializes the pauses and resumes of demand_monitor with those of the application, guards idle_subdevices
+    int                                         on_demand_subdevices;   // Bit mask of the subdevices streaming on demand, set at start
+    int                                         idle_subdevices;        // Bit mask of those turned off for lack of demand
+    rsimpl::load_shedder                        shedding;               // Its order is set by set_load_shedding calls
+    std::shared_ptr<rsimpl::executor::job>      load_monitor;           // Set through atomic_store while shedding load, checks the streams for an overload every RS_LOAD_CHECK_PERIOD milliseconds
+    double                                      last_load_check;        // Touched by load_monitor only, once started
+    unsigned long long                          checked_callback_nanoseconds[RS_STREAM_NATIVE_COUNT]; // RS_STREAM_METRIC_CALLBACK_NANOSECONDS at the last check
+    std::shared_ptr<rsimpl::memory_account>     memory;                 // Of the frame memory of every capture, counted by the allocator the archive and capture buffers get
 
     mutable std::string                         usb_port_id;
     mutable std::mutex                          usb_port_mutex;
 
-    std::shared_ptr<std::thread>                fw_logger;
+    std::shared_ptr<rsimpl::executor::job>      fw_logger;              // Submits a log read to hw_commands every fw_log_interval grab periods
+    std::atomic<int>                            fw_log_interval;        // Doubles while the firmware log is found empty, back to 1 once it has data
+    int                                         fw_log_periods;         // Grab periods since the last read, touched by the fw_logger job only
+    rsimpl::fw_log_ring                         fw_log;
+    rsimpl::calibration_cache<rs_intrinsics, std::vector<float>> depth_rays; // Of the depth intrinsics, for fusing point clouds
+    std::unique_ptr<rsimpl::hw_command_queue>   hw_commands;            // Carries out the hardware monitor commands of the background jobs, after those of the application
+
+    void                                        set_depth_filter_option(rs_option option, double value);
+    std::shared_ptr<rs_frame_allocator>         get_frame_allocator() const; // Of the application, or page_allocator, null selecting the heap
+    rsimpl::recording::device_record            describe_device() const;
+    std::vector<rsimpl::recording::mode_description> describe_modes(const std::vector<rsimpl::subdevice_mode_selection> & modes) const;
+    void                                        record_modes(rsimpl::recording::writer & writer, const std::vector<rsimpl::subdevice_mode_selection> & modes) const;
+    void                                        set_subdevice_idle(const rsimpl::subdevice_mode_selection & mode, bool idle); // With demand_mutex held
+    void                                        update_stream_demand();
+    bool                                        is_stream_backlogged(rs_stream stream) const; // The queue a new frame of the stream goes into is full
+    void                                        update_load_shedding();
+    void                                        invoke_frame_callback(rs_stream stream, rs_frame_callback * callback, rs_frame_ref * frame, std::chrono::high_resolution_clock::time_point capture_start_time);
+    rs_frame_ref *                              derive_frame(rs_stream stream, rs_frame_ref * const frames[], int count); // process_frames, without counting as a use of the frames
+
+    friend struct rs_context_base;                                      // Matches the devices it enumerates again to the backend devices of its own
 
 protected:
     const rsimpl::uvc::device &                 get_device() const { return *device; }
@@ -114,6 +206,8 @@ protected:
     std::atomic<bool>                           keep_fw_logger_alive;
     
     std::atomic<int>                            frames_drops_counter;
+    rsimpl::stage_latency_histograms            latency_histograms;
+    rsimpl::stream_metrics                      metrics;
 
 public:
     rs_device_base(std::shared_ptr<rsimpl::uvc::device> device, const rsimpl::static_device_info & info, rsimpl::calibration_validator validator = rsimpl::calibration_validator());
@@ -131,30 +225,96 @@ public:
     void                                        enable_stream(rs_stream stream, int width, int height, rs_format format, int fps, rs_output_buffer_format output) override;
     void                                        enable_stream_preset(rs_stream stream, rs_preset preset) override;
     void                                        disable_stream(rs_stream stream) override;
+    void                                        set_stream_roi(rs_stream stream, int x, int y, int width, int height) override;
+    void                                        set_stream_decimation(rs_stream stream, int factor) override;
+    void                                        set_stream_queue_policy(rs_stream stream, int depth, rs_frame_drop_policy policy) override;
+    void                                        get_stream_queue_policy(rs_stream stream, int & depth, rs_frame_drop_policy & policy) const override;
+    void                                        set_stream_capture_dmabufs(rs_stream stream, const int fds[], int count) override;
+    void                                        set_stream_capture_buffer_count(rs_stream stream, int count) override;
+    int                                         get_stream_capture_buffer_count(rs_stream stream) const override { return config.capture_buffer_counts[stream]; }
+    void                                        set_stream_crop(rs_stream stream, int x, int y, int width, int height) override;
+    bool                                        is_stream_cropped_in_driver(rs_stream stream) const override;
+    void                                        set_stream_frame_buffers(rs_stream stream, void * const buffers[], int count, int buffer_size) override;
+    void                                        set_stream_callback_queue(rs_stream stream, int depth) override;
+    int                                         get_stream_callback_queue_depth(rs_stream stream) const override { return config.callback_queue_depths[stream]; }
+    unsigned long long                          get_stream_callback_drops(rs_stream stream) const override;
+    int                                         add_frame_subscriber(rs_stream stream, rs_frame_callback * callback, int depth, rs_frame_drop_policy policy) override;
+    void                                        remove_frame_subscriber(rs_stream stream, int subscriber) override;
+    unsigned long long                          get_frame_subscriber_drops(rs_stream stream, int subscriber) const override;
+    void                                        set_stream_idle_timeout(rs_stream stream, int milliseconds) override;
+    int                                         get_stream_idle_timeout(rs_stream stream) const override { return config.idle_timeouts[stream]; }
+    void                                        set_stream_sync_tolerance(rs_stream stream, double milliseconds) override;
+    double                                      get_stream_sync_tolerance(rs_stream stream) const override { return config.sync_tolerances[stream]; }
+    bool                                        is_stream_idle(rs_stream stream) const override { return demand.is_idle(stream); }
+    void                                        get_stream_latency_histogram(rs_stream stream, rs_frame_metadata stage, unsigned long long counts[]) const override;
+    void                                        get_stream_exposure_latency_histogram(rs_stream stream, unsigned long long counts[]) const override;
+    void                                        reset_latency_histograms() override;
+    unsigned long long                          get_stream_metric(rs_stream stream, rs_stream_metric metric) const override;
+    unsigned long long                          get_transfer_statistic(rs_stream stream, rs_transfer_statistic statistic) const override;
+    void                                        set_load_shedding(const rs_load_shedding_action actions[], int count) override;
+    int                                         get_load_shedding_level() const override { return shedding.get_level(); }
+    void                                        get_memory_usage(unsigned long long & current, unsigned long long & peak) const override;
+    void                                        set_memory_budget(unsigned long long bytes) override { memory->set_budget(bytes); }
+    unsigned long long                          get_memory_budget() const override { return memory->get_budget(); }
+    void                                        export_fw_log(const char * file_path) const override;
+    std::vector<rsimpl::request_candidate>      get_bandwidth_candidates() const { return config.get_bandwidth_candidates(); }
+    double                                      get_stream_bandwidth() const { return rsimpl::get_bandwidth(config.select_modes()); } // Of the modes rs_start_device would select, in bytes per second
+    std::shared_ptr<const std::vector<float>>   get_depth_rays(const rs_intrinsics & intrin) const { return depth_rays.get(intrin, [&intrin]() { return rsimpl::compute_deprojection_table(intrin); }); }
 
     rs_motion_intrinsics                        get_motion_intrinsics() const override;
     rs_extrinsics                               get_motion_extrinsics_from(rs_stream from) const override;
     void                                        enable_motion_tracking() override;
     void                                        set_stream_callback(rs_stream stream, void(*on_frame)(rs_device * device, rs_frame_ref * frame, void * user), void * user) override;
     void                                        set_stream_callback(rs_stream stream, rs_frame_callback * callback) override;
+    void                                        set_frameset_callback(void(*on_frameset)(rs_device * device, rs_frameset * frames, void * user), void * user) override;
+    void                                        set_frameset_callback(rs_frameset_callback * callback) override;
+    void                                        set_stream_slice_callback(rs_stream stream, int rows_per_slice, void(*on_slice)(rs_device * device, const void * rows, int width, int first_row, int row_count, void * user), void * user) override;
+    void                                        set_stream_slice_callback(rs_stream stream, int rows_per_slice, rs_slice_callback * callback) override;
+    void                                        set_stream_encoder(rs_stream stream, int bitrate, void(*on_packet)(rs_device * device, rs_stream stream, rs_encoded_packet packet, void * user), void * user) override;
+    void                                        set_stream_encoder(rs_stream stream, int bitrate, rs_encoded_packet_callback * callback) override;
+    void                                        set_frame_allocator(void *(*allocate)(int size, void * user), void(*deallocate)(void * ptr, int size, void * user), void * user) override;
+    void                                        set_frame_allocator(rs_frame_allocator * allocator) override;
     void                                        disable_motion_tracking() override;
 
     void                                        set_motion_callback(rs_motion_callback * callback) override;
     void                                        set_motion_callback(void(*on_event)(rs_device * device, rs_motion_data data, void * user), void * user) override;
     void                                        set_timestamp_callback(void(*on_event)(rs_device * device, rs_timestamp_data data, void * user), void * user) override;
     void                                        set_timestamp_callback(rs_timestamp_callback * callback) override;
+    void                                        set_motion_batch_callback(void(*on_events)(rs_device * device, const rs_motion_data * motion, int motion_count, const rs_timestamp_data * timestamps, int timestamp_count, void * user), void * user) override;
+    void                                        set_motion_batch_callback(rs_motion_batch_callback * callback) override;
+    bool                                        get_motion_sample_at(rs_event_source source, double timestamp, rs_motion_data & sample) const override;
+    size_t                                      get_motion_samples(rs_event_source source, double from, double to, rs_motion_data samples[], size_t max_count) const override;
+    void                                        start_recording(const char * path) override;
+    void                                        stop_recording() override;
+    unsigned long long                          get_recording_drops() const override;
+    void                                        start_publishing(const char * name, int slot_count) override;
+    void                                        stop_publishing() override;
+    void                                        start_frame_history(double seconds, size_t max_bytes) override;
+    void                                        stop_frame_history() override;
+    size_t                                      dump_frame_history(const char * path, double from, double to) const override;
+    size_t                                      get_frame_history_size() const override;
+    void                                        set_playback_pacing(rs_playback_pacing pacing) override { throw std::runtime_error("device does not replay a recording"); }
+    bool                                        step_playback() override { throw std::runtime_error("device does not replay a recording"); }
+    bool                                        seek_playback_to_frame(rs_stream stream, unsigned long long frame_number) override { throw std::runtime_error("device does not replay a recording"); }
+    bool                                        seek_playback_to_time(rs_stream stream, double timestamp) override { throw std::runtime_error("device does not replay a recording"); }
 
     virtual void                                start(rs_source source) override;
     virtual void                                stop(rs_source source) override;
+    virtual void                                pause() override;
+    virtual void                                resume() override;
 
     virtual void                                start_fw_logger(char fw_log_op_code, int grab_rate_in_ms, std::timed_mutex& mutex) override;
     virtual void                                stop_fw_logger() override;
 
     bool                                        is_capturing() const override { return capturing; }
+    bool                                        is_paused() const override { return paused; }
     int                                         is_motion_tracking_active() const override { return data_acquisition_active; }
 
     void                                        wait_all_streams() override;
     bool                                        poll_all_streams() override;
+    bool                                        wait_all_streams(unsigned int timeout_ms) override;
+    void *                                      get_frames_ready_handle() override;
+    rs_frame_ref *                              get_latest_frame(rs_stream stream) override;
 
     virtual bool                                supports(rs_capabilities capability) const override;
     virtual bool                                supports(rs_camera_info info_param) const override;
@@ -163,6 +323,12 @@ public:
     virtual void                                get_option_range(rs_option option, double & min, double & max, double & step, double & def) override;
     virtual void                                set_options(const rs_option options[], size_t count, const double values[]) override;
     virtual void                                get_options(const rs_option options[], size_t count, double values[])override;
+    void                                        set_options_async(const rs_option options[], size_t count, const double values[], rs_options_callback * callback) override;
+    void                                        get_options_async(const rs_option options[], size_t count, rs_options_callback * callback) override;
+    void                                        stop_option_requests(); // Must run before the destruction of the most derived device begins, as requests call its overrides
+    void                                        begin_options() override;
+    bool                                        hold_options(const rs_option options[], size_t count, const double values[]) override;
+    void                                        commit_options() override;
     virtual void                                on_before_start(const std::vector<rsimpl::subdevice_mode_selection> & selected_modes) = 0;
     virtual rs_stream                           select_key_stream(const std::vector<rsimpl::subdevice_mode_selection> & selected_modes) = 0;
     virtual std::vector<std::shared_ptr<rsimpl::frame_timestamp_reader>> 
@@ -170,8 +336,13 @@ public:
     void                                        release_frame(rs_frame_ref * ref) override;
     const char *                                get_usb_port_id() const override;
     rs_frame_ref *                              clone_frame(rs_frame_ref * frame) override;
+    rs_frame_ref *                              detach_frame(rs_frameset * frames, rs_stream stream) override;
+    void                                        release_frames(rs_frameset * frames) override;
+    rs_frame_ref *                              process_frames(rs_stream stream, rs_frame_ref * const frames[], int count) override;
+    rs_frame_ref *                              process_frameset(const rs_frameset * frames, rs_stream stream) override;
+    int                                         get_frameset_frame_info(const rs_frameset * frames, rs_frame_info * infos, int max_count) override;
 
-    virtual void                                send_blob_to_device(rs_blob_type /*type*/, void * /*data*/, int /*size*/) { throw std::runtime_error("not supported!"); }
+    virtual void                                send_blob_to_device(rs_blob_type /*type*/, void * /*data*/, int /*size*/, const rsimpl::blob_progress & /*on_progress*/) { throw std::runtime_error("not supported!"); }
     static void                                 update_device_info(rsimpl::static_device_info& info);
 
     const char *                                get_option_description(rs_option option) const override;
@@ -107,6 +107,24 @@ namespace rsimpl
         params.exposure_bottom_edge = bottom;
     }
 
+    // Options the firmware leaves alone. The LR exposure and gain are outputs of auto-exposure and the emitter follows streaming.
+    static bool is_cached_option(rs_option option)
+    {
+        switch (option)
+        {
+        case RS_OPTION_R200_LR_AUTO_EXPOSURE_ENABLED:
+        case RS_OPTION_R200_DEPTH_UNITS:
+        case RS_OPTION_R200_DEPTH_CLAMP_MIN:
+        case RS_OPTION_R200_DEPTH_CLAMP_MAX:
+        case RS_OPTION_R200_DISPARITY_MULTIPLIER:
+        case RS_OPTION_R200_DISPARITY_SHIFT:
+            return true;
+        default:
+            return (option >= RS_OPTION_R200_AUTO_EXPOSURE_MEAN_INTENSITY_SET_POINT && option <= RS_OPTION_R200_AUTO_EXPOSURE_RIGHT_EDGE) ||
+                   (option >= RS_OPTION_R200_DEPTH_CONTROL_ESTIMATE_MEDIAN_DECREMENT && option <= RS_OPTION_R200_DEPTH_CONTROL_LR_THRESHOLD);
+        }
+    }
+
     void ds_device::set_options(const rs_option options[], size_t count, const double values[])
     {
         std::vector<rs_option>  base_opt;
@@ -128,6 +146,12 @@ namespace rsimpl
         );
         auto dc_writer     = make_struct_interface<ds::dc_params>([&dev]() { return ds::get_depth_params(dev);            }, [&dev](ds::dc_params v) { ds::set_depth_params(dev,v);            });
 
+        // Values the device is known to hold already are not written again
+        std::vector<rs_option> written_opt(options, options + count);
+        std::vector<double>    written_val(values, values + count);
+        option_cache.drop_known_writes(written_opt, written_val);
+        options = written_opt.data(); values = written_val.data(); count = written_opt.size();
+
         for (size_t i = 0; i<count; ++i)
         {
             if (uvc::is_pu_control(options[i]))
@@ -192,6 +216,42 @@ namespace rsimpl
         ae_writer.commit();
         dc_writer.commit();
 
+        // Write through the values as the device now holds them, after the conversions and corrections above
+        for (size_t i = 0; i<count; ++i)
+        {
+            double value;
+            switch(options[i])
+            {
+            case RS_OPTION_R200_LR_AUTO_EXPOSURE_ENABLED:                   value = static_cast<uint8_t>(values[i]); break;
+            case RS_OPTION_R200_DEPTH_UNITS:                                value = static_cast<uint32_t>(values[i]); break;
+            case RS_OPTION_R200_DEPTH_CLAMP_MIN:                            value = minmax_writer.get(&ds::range::min); break;
+            case RS_OPTION_R200_DEPTH_CLAMP_MAX:                            value = minmax_writer.get(&ds::range::max); break;
+            case RS_OPTION_R200_DISPARITY_MULTIPLIER:                       value = disp_writer.get(&ds::disp_mode::disparity_multiplier); break;
+            case RS_OPTION_R200_DISPARITY_SHIFT:                            value = static_cast<uint32_t>(values[i]); break;
+            case RS_OPTION_R200_AUTO_EXPOSURE_MEAN_INTENSITY_SET_POINT:     value = ae_writer.get(&ds::ae_params::mean_intensity_set_point); break;
+            case RS_OPTION_R200_AUTO_EXPOSURE_BRIGHT_RATIO_SET_POINT:       value = ae_writer.get(&ds::ae_params::bright_ratio_set_point  ); break;
+            case RS_OPTION_R200_AUTO_EXPOSURE_KP_GAIN:                      value = ae_writer.get(&ds::ae_params::kp_gain                 ); break;
+            case RS_OPTION_R200_AUTO_EXPOSURE_KP_EXPOSURE:                  value = ae_writer.get(&ds::ae_params::kp_exposure             ); break;
+            case RS_OPTION_R200_AUTO_EXPOSURE_KP_DARK_THRESHOLD:            value = ae_writer.get(&ds::ae_params::kp_dark_threshold       ); break;
+            case RS_OPTION_R200_AUTO_EXPOSURE_TOP_EDGE:                     value = ae_writer.get(&ds::ae_params::exposure_top_edge       ); break;
+            case RS_OPTION_R200_AUTO_EXPOSURE_BOTTOM_EDGE:                  value = ae_writer.get(&ds::ae_params::exposure_bottom_edge    ); break;
+            case RS_OPTION_R200_AUTO_EXPOSURE_LEFT_EDGE:                    value = ae_writer.get(&ds::ae_params::exposure_left_edge      ); break;
+            case RS_OPTION_R200_AUTO_EXPOSURE_RIGHT_EDGE:                   value = ae_writer.get(&ds::ae_params::exposure_right_edge     ); break;
+            case RS_OPTION_R200_DEPTH_CONTROL_ESTIMATE_MEDIAN_DECREMENT:    value = dc_writer.get(&ds::dc_params::robbins_munroe_minus_inc); break;
+            case RS_OPTION_R200_DEPTH_CONTROL_ESTIMATE_MEDIAN_INCREMENT:    value = dc_writer.get(&ds::dc_params::robbins_munroe_plus_inc ); break;
+            case RS_OPTION_R200_DEPTH_CONTROL_MEDIAN_THRESHOLD:             value = dc_writer.get(&ds::dc_params::median_thresh           ); break;
+            case RS_OPTION_R200_DEPTH_CONTROL_SCORE_MINIMUM_THRESHOLD:      value = dc_writer.get(&ds::dc_params::score_min_thresh        ); break;
+            case RS_OPTION_R200_DEPTH_CONTROL_SCORE_MAXIMUM_THRESHOLD:      value = dc_writer.get(&ds::dc_params::score_max_thresh        ); break;
+            case RS_OPTION_R200_DEPTH_CONTROL_TEXTURE_COUNT_THRESHOLD:      value = dc_writer.get(&ds::dc_params::texture_count_thresh    ); break;
+            case RS_OPTION_R200_DEPTH_CONTROL_TEXTURE_DIFFERENCE_THRESHOLD: value = dc_writer.get(&ds::dc_params::texture_diff_thresh     ); break;
+            case RS_OPTION_R200_DEPTH_CONTROL_SECOND_PEAK_THRESHOLD:        value = dc_writer.get(&ds::dc_params::second_peak_thresh      ); break;
+            case RS_OPTION_R200_DEPTH_CONTROL_NEIGHBOR_THRESHOLD:           value = dc_writer.get(&ds::dc_params::neighbor_thresh         ); break;
+            case RS_OPTION_R200_DEPTH_CONTROL_LR_THRESHOLD:                 value = dc_writer.get(&ds::dc_params::lr_thresh               ); break;
+            default: continue;
+            }
+            option_cache.store(options[i], value);
+        }
+
         //Handle common options
         if (base_opt.size())
             rs_device_base::set_options(base_opt.data(), base_opt.size(), base_opt_val.data());
@@ -221,6 +281,8 @@ namespace rsimpl
 
         for (size_t i = 0; i<count; ++i)
         {
+            if (option_cache.lookup(options[i], values[i]))
+                continue;
 
             if(uvc::is_pu_control(options[i]))
             {
@@ -277,6 +339,7 @@ namespace rsimpl
             default:
                 base_opt.push_back(options[i]); base_opt_index.push_back(i); break;
             }
+            if (is_cached_option(options[i])) option_cache.store(options[i], values[i]);
         }
         if (base_opt.size())
         {
@@ -301,6 +364,18 @@ namespace rsimpl
         start_stop_pad.start();
     }
 
+    void ds_device::pause()
+    {
+        start_stop_pad.stop();
+        rs_device_base::pause();
+    }
+
+    void ds_device::resume()
+    {
+        rs_device_base::resume();
+        start_stop_pad.start();
+    }
+
     void ds_device::start_fw_logger(char fw_log_op_code, int grab_rate_in_ms, std::timed_mutex& mutex)
     {
         rs_device_base::start_fw_logger(fw_log_op_code, grab_rate_in_ms, mutex);
@@ -515,14 +590,14 @@ namespace rsimpl
         info.stream_poses[RS_STREAM_COLOR].position = info.stream_poses[RS_STREAM_COLOR].orientation * info.stream_poses[RS_STREAM_COLOR].position;
         info.nominal_depth_scale = 0.001f;
         info.serial = std::to_string(c.serial_number);
-        info.firmware_version = ds::read_firmware_version(*device);
+        info.firmware_version = cam_info.firmware_version;
 
         auto &h = cam_info.head_content;
         info.camera_info[RS_CAMERA_INFO_CAMERA_FIRMWARE_VERSION] = info.firmware_version;
         info.camera_info[RS_CAMERA_INFO_DEVICE_SERIAL_NUMBER] = info.serial;
         info.camera_info[RS_CAMERA_INFO_DEVICE_NAME] = info.name;
 
-        info.camera_info[RS_CAMERA_INFO_ISP_FW_VERSION]         = ds::read_isp_firmware_version(*device);
+        info.camera_info[RS_CAMERA_INFO_ISP_FW_VERSION]         = cam_info.isp_firmware_version;
         info.camera_info[RS_CAMERA_INFO_IMAGER_MODEL_NUMBER]    = to_string() << h.imager_model_number;
         info.camera_info[RS_CAMERA_INFO_CAMERA_TYPE]            = to_string() << h.prq_type;
         info.camera_info[RS_CAMERA_INFO_OEM_ID]                 = to_string() << h.oem_id;
@@ -7,6 +7,7 @@
 
 #include "device.h"
 #include "ds-private.h"
+#include "option-cache.h"
 
 #define R200_PRODUCT_ID  0x0a80
 #define LR200_PRODUCT_ID 0x0abf
@@ -38,6 +39,7 @@ namespace rsimpl
             uint32_t get_lr_framerate() const;
             std::vector<supported_option> get_ae_range_vec();
             time_pad start_stop_pad; // R200 line-up needs minimum 500ms delay between consecutive start-stop commands
+            option_value_cache option_cache; // Of the XU options only the application changes
 
         public:
             ds_device(std::shared_ptr<uvc::device> device, const static_device_info & info, calibration_validator validator);
@@ -57,6 +59,8 @@ namespace rsimpl
 
             virtual void stop(rs_source source) override;
             virtual void start(rs_source source) override;
+            virtual void pause() override;
+            virtual void resume() override;
 
             virtual void start_fw_logger(char fw_log_op_code, int grab_rate_in_ms, std::timed_mutex& mutex) override;
             virtual void stop_fw_logger() override;
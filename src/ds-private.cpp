@@ -4,6 +4,7 @@
 
 #include "hw-monitor.h"
 #include "ds-private.h"
+#include "calibration-store.h"
 
 #pragma pack(push, 1) // All structs in this file are byte-aligned
 
@@ -155,7 +156,7 @@ namespace rsimpl {
             }
         }
 
-        bool read_admin_sector(uvc::device & dev, unsigned char data[SPI_FLASH_SECTOR_SIZE_IN_BYTES], int whichAdminSector)
+        bool read_admin_sector_address(uvc::device & dev, uint32_t & address, int whichAdminSector)
         {
             uint32_t adminSectorAddresses[NV_ADMIN_DATA_N_ENTRIES];
 
@@ -163,13 +164,46 @@ namespace rsimpl {
 
             if (whichAdminSector >= 0 && whichAdminSector < NV_ADMIN_DATA_N_ENTRIES)
             {
-                uint32_t pageAddressInBytes = adminSectorAddresses[whichAdminSector];
-                return read_device_pages(dev, pageAddressInBytes, data, SPI_FLASH_PAGES_PER_SECTOR);
+                address = adminSectorAddresses[whichAdminSector];
+                return true;
             }
 
             return false;
         }
 
+        bool read_admin_sector(uvc::device & dev, unsigned char data[SPI_FLASH_SECTOR_SIZE_IN_BYTES], int whichAdminSector)
+        {
+            uint32_t pageAddressInBytes;
+            return read_admin_sector_address(dev, pageAddressInBytes, whichAdminSector) && read_device_pages(dev, pageAddressInBytes, data, SPI_FLASH_PAGES_PER_SECTOR);
+        }
+
+        // The camera head contents, a page in the middle of the calibration sector, hold the serial number and the date of calibration,
+        // so together with the firmware version they identify and sign the sector without reading the rest of it
+        void read_calibration_sector(uvc::device & dev, const std::string & firmware_version, uint8_t(&flash_data_buffer)[SPI_FLASH_SECTOR_SIZE_IN_BYTES])
+        {
+            if (!calibration_store::is_enabled())
+            {
+                if (!read_admin_sector(dev, flash_data_buffer, NV_CALIBRATION_DATA_ADDRESS_INDEX)) throw std::runtime_error("Could not read calibration sector");
+                return;
+            }
+
+            uint32_t address;
+            if (!read_admin_sector_address(dev, address, NV_CALIBRATION_DATA_ADDRESS_INDEX)) throw std::runtime_error("Could not read calibration sector");
+            std::vector<uint8_t> signature(sizeof(ds_head_content));
+            read_arbitrary_chunk(dev, address + CAM_INFO_BLOCK_LEN, signature.data(), static_cast<int>(signature.size()));
+            const auto & head_content = reinterpret_cast<const ds_head_content &>(signature[0]);
+
+            std::string key = to_string() << "ds-" << head_content.serial_number << "-" << firmware_version;
+            auto sector = calibration_store::get(key, signature, [&]()
+            {
+                std::vector<uint8_t> data(SPI_FLASH_SECTOR_SIZE_IN_BYTES);
+                if (!read_device_pages(dev, address, data.data(), SPI_FLASH_PAGES_PER_SECTOR)) throw std::runtime_error("Could not read calibration sector");
+                return data;
+            });
+            if (sector.size() != SPI_FLASH_SECTOR_SIZE_IN_BYTES) throw std::runtime_error("Cached calibration sector has the wrong size");
+            memcpy(flash_data_buffer, sector.data(), sector.size());
+        }
+
         ds_calibration read_calibration_and_rectification_parameters(const uint8_t(&flash_data_buffer)[SPI_FLASH_SECTOR_SIZE_IN_BYTES])
         {
             struct RectifiedIntrinsics
@@ -331,10 +365,13 @@ namespace rsimpl {
 
         ds_info read_camera_info(uvc::device & device)
         {
-            uint8_t flashDataBuffer[SPI_FLASH_SECTOR_SIZE_IN_BYTES];
-            if (!read_admin_sector(device, flashDataBuffer, NV_CALIBRATION_DATA_ADDRESS_INDEX)) throw std::runtime_error("Could not read calibration sector");
-
             ds_info cam_info = {};
+            auto revision = send_command_and_receive_response(device, CommandResponsePacket(command::get_fwrevision));
+            cam_info.firmware_version = reinterpret_cast<const char *>(revision.reserved);
+            cam_info.isp_firmware_version = to_string() << "0x" << std::hex << revision.reserved[4];
+
+            uint8_t flashDataBuffer[SPI_FLASH_SECTOR_SIZE_IN_BYTES];
+            read_calibration_sector(device, cam_info.firmware_version, flashDataBuffer);
 
             try
             {
@@ -347,18 +384,6 @@ namespace rsimpl {
             return cam_info;
         }
 
-        std::string read_firmware_version(uvc::device & device)
-        {
-            auto response = send_command_and_receive_response(device, CommandResponsePacket(command::get_fwrevision));
-            return reinterpret_cast<const char *>(response.reserved);
-        }
-
-        std::string read_isp_firmware_version(uvc::device & device)
-        {
-            auto response = send_command_and_receive_response(device, CommandResponsePacket(command::get_fwrevision));
-            return to_string() << "0x" << std::hex << response.reserved[4];
-        }
-
         void set_stream_intent(uvc::device & device, uint8_t & intent)
         {
             xu_write(device, lr_xu, control::stream_intent, intent);
@@ -245,12 +245,11 @@ namespace rsimpl
         {
             ds_head_content head_content;
             ds_calibration calibration;
+            std::string firmware_version, isp_firmware_version; // Both from the one firmware revision command the camera info reads
         };
 
 
         ds_info     read_camera_info(uvc::device & device);
-        std::string read_firmware_version(uvc::device & device);
-        std::string read_isp_firmware_version(uvc::device & device);
 
         ///////////////////////////////
         //// Extension unit controls //
@@ -0,0 +1,272 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "executor.h"
+#include "uvc.h"
+
+using namespace rsimpl;
+
+const int default_thread_count = 2; // Enough for the periodic work of a few devices, rigs of cameras can ask for more through rs_set_executor_threads
+
+static std::mutex shared_mutex;
+static std::weak_ptr<executor> shared_instance;
+
+std::shared_ptr<executor> executor::acquire_shared()
+{
+    std::lock_guard<std::mutex> lock(shared_mutex);
+    auto instance = shared_instance.lock();
+    if (!instance)
+    {
+        instance = std::make_shared<executor>(default_thread_count, 0);
+        shared_instance = instance;
+    }
+    return instance;
+}
+
+executor::executor(int thread_count, uint64_t cpu_mask) : next_worker(0), stopping(false), cpu_mask(cpu_mask), timers_watched(false)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    start_workers(thread_count, {});
+}
+
+executor::~executor()
+{
+    stop_workers();
+}
+
+executor::worker * executor::find_worker() const
+{
+    for (auto & w : workers) if (w->thread.get_id() == std::this_thread::get_id()) return w.get();
+    return nullptr;
+}
+
+// Called with the mutex held
+void executor::start_workers(int count, std::vector<std::shared_ptr<job>> jobs)
+{
+    for (int i = 0; i < count; ++i) workers.push_back(std::unique_ptr<worker>(new worker));
+    for (size_t i = 0; i < jobs.size(); ++i) workers[i % workers.size()]->jobs.push_back(jobs[i]);
+    for (auto & w : workers)
+    {
+        auto self = w.get();
+        w->thread = uvc::start_backend_thread([this, self]() { run_worker(*self); });
+        uvc::set_thread_cpu_mask(w->thread, cpu_mask);
+    }
+}
+
+// Jobs triggered meanwhile are still queued to the workers stopped
+void executor::stop_workers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto & w : workers) w->thread.join();
+}
+
+void executor::set_threads(int count, uint64_t cpu_mask)
+{
+    std::lock_guard<std::mutex> config_lock(config_mutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (find_worker()) throw std::logic_error("the executor threads cannot be changed from within a job");
+    }
+    stop_workers();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::shared_ptr<job>> jobs;
+    for (auto & w : workers) jobs.insert(jobs.end(), w->jobs.begin(), w->jobs.end());
+    workers.clear();
+    stopping = false;
+    this->cpu_mask = cpu_mask;
+    start_workers(count, jobs);
+}
+
+int executor::get_thread_count() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)workers.size();
+}
+
+uint64_t executor::get_cpu_mask() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return cpu_mask;
+}
+
+std::shared_ptr<executor::job> executor::create_job(std::function<void()> work, std::chrono::milliseconds period)
+{
+    auto j = std::make_shared<job>(*this, work, period);
+    if (period.count() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            timers.insert(std::make_pair(clock::now() + period, j));
+        }
+        cv.notify_all(); // The idle workers may be waiting for a later timer
+    }
+    return j;
+}
+
+void executor::remove_timer(const job * j)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = timers.begin(); it != timers.end(); ++it)
+    {
+        if (it->second.get() != j) continue;
+        timers.erase(it);
+        return;
+    }
+}
+
+// Called with the mutex held. The latest time every timer due by then may start, which is the earliest deadline plus slack of any timer.
+executor::clock::time_point executor::next_wakeup() const
+{
+    auto wakeup = clock::time_point::max();
+    for (auto it = timers.begin(); it != timers.end() && it->first < wakeup; ++it) wakeup = std::min(wakeup, it->first + it->second->slack);
+    return wakeup;
+}
+
+// A job triggered from the pool stays on the thread triggering it, the other jobs are spread over the pool
+void executor::enqueue(std::shared_ptr<job> j)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto w = find_worker();
+        if (!w) w = workers[next_worker++ % workers.size()].get();
+        std::lock_guard<std::mutex> worker_lock(w->mutex);
+        w->jobs.push_back(j);
+    }
+    cv.notify_one();
+}
+
+std::shared_ptr<executor::job> executor::take_job(worker & self)
+{
+    {
+        std::lock_guard<std::mutex> lock(self.mutex);
+        if (!self.jobs.empty())
+        {
+            auto j = self.jobs.back();
+            self.jobs.pop_back();
+            return j;
+        }
+    }
+    for (auto & w : workers)
+    {
+        if (w.get() == &self) continue;
+        std::lock_guard<std::mutex> lock(w->mutex);
+        if (w->jobs.empty()) continue;
+        auto j = w->jobs.front();
+        w->jobs.pop_front();
+        return j;
+    }
+    return nullptr;
+}
+
+// Called with the mutex held, which jobs are queued under
+bool executor::has_queued_jobs() const
+{
+    for (auto & w : workers)
+    {
+        std::lock_guard<std::mutex> lock(w->mutex);
+        if (!w->jobs.empty()) return true;
+    }
+    return false;
+}
+
+void executor::run_worker(worker & self)
+{
+    while (true)
+    {
+        if (auto j = take_job(self))
+        {
+            j->run();
+            continue;
+        }
+
+        std::vector<std::shared_ptr<job>> due;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (stopping) return;
+
+            // Periodic jobs which fell behind skip the runs they missed
+            const auto now = clock::now();
+            while (!timers.empty() && timers.begin()->first <= now)
+            {
+                auto next = timers.begin()->first + timers.begin()->second->period;
+                auto j = timers.begin()->second;
+                timers.erase(timers.begin());
+                timers.insert(std::make_pair(next > now ? next : now + j->period, j));
+                due.push_back(j);
+            }
+
+            if (due.empty())
+            {
+                if (has_queued_jobs()) continue;
+                if (timers.empty() || timers_watched) cv.wait(lock);
+                else
+                {
+                    timers_watched = true;
+                    cv.wait_until(lock, next_wakeup());
+                    timers_watched = false;
+                    if (has_queued_jobs()) cv.notify_one(); // Hands the timers over to another idle worker while this one runs jobs
+                }
+                continue;
+            }
+        }
+        for (auto & j : due) j->trigger();
+    }
+}
+
+void executor::job::trigger()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cancelled || queued) return;
+        if (running)
+        {
+            run_again = true;
+            return;
+        }
+        queued = true;
+    }
+    owner.enqueue(shared_from_this());
+}
+
+void executor::job::run()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued = false;
+        if (cancelled) return;
+        running = true;
+        runner = std::this_thread::get_id();
+    }
+
+    try { work(); }
+    catch (const std::exception & e) { LOG_ERROR("Received an exception from a background job: " << e.what()); }
+    catch (...) { LOG_ERROR("Received an exception from a background job!"); }
+
+    bool again;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        runner = std::thread::id();
+        again = run_again && !cancelled;
+        run_again = false;
+        queued = again;
+    }
+    cv.notify_all();
+    if (again) owner.enqueue(shared_from_this());
+}
+
+void executor::job::cancel()
+{
+    if (period.count() > 0) owner.remove_timer(this);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    cancelled = true;
+    if (runner == std::this_thread::get_id()) return;
+    cv.wait(lock, [this]() { return !running; });
+    work = nullptr; // Lets go of whatever the work holds, as it never runs again
+}
@@ -0,0 +1,97 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_EXECUTOR_H
+#define LIBREALSENSE_EXECUTOR_H
+
+#include "types.h"
+
+#include <deque>
+#include <thread>
+#include <chrono>
+
+namespace rsimpl
+{
+    // Pool of backend threads carrying out the periodic and background work of the context and its devices, so that a rig of cameras does not
+    // keep dozens of mostly idle threads of its own. Work is handed to the pool as jobs. Every thread runs the jobs queued to it newest first
+    // and, once it runs out, steals the oldest job queued to another thread. Jobs should not block for long, as they hold up a pool thread.
+    class executor
+    {
+    public:
+        class job;
+    private:
+        struct worker
+        {
+            std::mutex mutex;
+            std::deque<std::shared_ptr<job>> jobs;  // Guarded by mutex, the worker takes from the back and other workers steal from the front
+            std::thread thread;
+        };
+        typedef std::chrono::steady_clock clock;
+
+        std::mutex                                  config_mutex;   // Serializes set_threads
+        mutable std::mutex                          mutex;          // Guards the members below, taken before the mutex of any worker
+        std::condition_variable                     cv;             // Idle workers wait on it for jobs and for the next timer
+        std::vector<std::unique_ptr<worker>>        workers;        // Only replaced while no worker runs
+        std::multimap<clock::time_point, std::shared_ptr<job>> timers; // Next run of every periodic job
+        size_t                                      next_worker;
+        bool                                        stopping;
+        uint64_t                                    cpu_mask;
+        bool                                        timers_watched; // One idle worker waits for the timers, the others for jobs only
+
+        executor(const executor &) = delete;
+        executor & operator=(const executor &) = delete;
+
+        worker * find_worker() const; // Worker of the calling thread, null outside of the pool
+        void start_workers(int count, std::vector<std::shared_ptr<job>> jobs);
+        void stop_workers();
+        std::shared_ptr<job> take_job(worker & self);
+        bool has_queued_jobs() const;
+        void run_worker(worker & self);
+        void enqueue(std::shared_ptr<job> j);
+        void remove_timer(const job * j);
+        clock::time_point next_wakeup() const;
+    public:
+        executor(int thread_count, uint64_t cpu_mask); // A cpu_mask of 0 lets the threads run on every CPU
+        ~executor();
+
+        // A job runs its work on the pool once for every trigger and, given a period, once every period from its creation. Runs never overlap,
+        // and triggers made before a run starts add up to that one run. The job must be cancelled before whatever its work refers to goes away.
+        // Periodic runs may start up to an eighth of the period late, at most half a second, so that the pool wakes up once for the timers of
+        // many devices falling due around the same time.
+        std::shared_ptr<job> create_job(std::function<void()> work, std::chrono::milliseconds period = std::chrono::milliseconds(0));
+
+        void set_threads(int count, uint64_t cpu_mask); // Restarts the pool, waiting for the jobs running to return, the jobs queued carry over
+        int get_thread_count() const;
+        uint64_t get_cpu_mask() const;
+
+        static std::shared_ptr<executor> acquire_shared(); // The executor shared by the context and its devices, created again once they all let it go
+    };
+
+    class executor::job : public std::enable_shared_from_this<job>
+    {
+        friend class executor;
+
+        executor &                                  owner;
+        std::function<void()>                       work;
+        const std::chrono::milliseconds             period;
+        const std::chrono::milliseconds             slack;          // How late periodic runs may start
+        std::mutex                                  mutex;
+        std::condition_variable                     cv;
+        bool                                        queued;         // Waiting in the queue of a worker
+        bool                                        running;
+        bool                                        run_again;      // Triggered while running
+        bool                                        cancelled;
+        std::thread::id                             runner;
+
+        void run();
+    public:
+        job(executor & owner, std::function<void()> work, std::chrono::milliseconds period) : owner(owner), work(work), period(period),
+            slack(std::min(period / 8, std::chrono::milliseconds(500))), queued(false), running(false), run_again(false), cancelled(false) {}
+
+        void trigger(); // Runs the work once more as soon as a pool thread is free
+        void cancel();  // No run starts afterwards, and a run in progress is waited for, unless cancel is called from within it
+    };
+}
+
+#endif
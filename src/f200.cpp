@@ -114,84 +114,75 @@ namespace rsimpl
         thermal_loop_params(params), 
         last_temperature_delta(std::numeric_limits<float>::infinity())
     {
-        // If thermal control loop requested, start up thread to handle it
+        fcx_slope = base_calibration.Kc[0][0] * thermal_loop_params.FcxSlopeA + thermal_loop_params.FcxSlopeB;
+        ux_slope = base_calibration.Kc[0][2] * thermal_loop_params.UxSlopeA + base_calibration.Kc[0][0] * thermal_loop_params.UxSlopeB + thermal_loop_params.UxSlopeC;
+        const float tempFromHFOV = (tan(thermal_loop_params.HFOVsensitivity*(float)M_PI/360)*(1 + base_calibration.Kc[0][0]*base_calibration.Kc[0][0]))/(fcx_slope * (1 + base_calibration.Kc[0][0] * tan(thermal_loop_params.HFOVsensitivity * (float)M_PI/360)));
+        temperature_threshold = thermal_loop_params.TempThreshold; //celcius degrees, the temperatures delta that above should be fixed;
+        if (temperature_threshold <= 0) temperature_threshold = tempFromHFOV;
+        if (temperature_threshold > tempFromHFOV) temperature_threshold = tempFromHFOV;
+
+        // If thermal control loop requested, check the temperature every 10 seconds, on the executor shared with the other devices
         if(thermal_loop_params.IRThermalLoopEnable)
         {
-            runTemperatureThread = true;
-            temperatureThread = std::thread(&f200_camera::temperature_control_loop, this);
+            temperature_job = shared_executor->create_job([this]() { temperature_control_step(); }, std::chrono::seconds(10));
         }
     }
 
     f200_camera::~f200_camera()
     {
-        // Shut down thermal control loop thread
-        runTemperatureThread = false;
-        temperatureCv.notify_one();
-        if (temperatureThread.joinable())
-            temperatureThread.join();
+        // Shut down thermal control loop
+        if (temperature_job)
+            temperature_job->cancel();
     }
 
-    void f200_camera::temperature_control_loop()
+    void f200_camera::temperature_control_step()
     {
-        const float FcxSlope = base_calibration.Kc[0][0] * thermal_loop_params.FcxSlopeA + thermal_loop_params.FcxSlopeB;
-        const float UxSlope = base_calibration.Kc[0][2] * thermal_loop_params.UxSlopeA + base_calibration.Kc[0][0] * thermal_loop_params.UxSlopeB + thermal_loop_params.UxSlopeC;
-        const float tempFromHFOV = (tan(thermal_loop_params.HFOVsensitivity*(float)M_PI/360)*(1 + base_calibration.Kc[0][0]*base_calibration.Kc[0][0]))/(FcxSlope * (1 + base_calibration.Kc[0][0] * tan(thermal_loop_params.HFOVsensitivity * (float)M_PI/360)));
-        float TempThreshold = thermal_loop_params.TempThreshold; //celcius degrees, the temperatures delta that above should be fixed;
-        if (TempThreshold <= 0) TempThreshold = tempFromHFOV;
-        if (TempThreshold > tempFromHFOV) TempThreshold = tempFromHFOV;
-
-        std::unique_lock<std::mutex> lock(temperatureMutex);
-        while (runTemperatureThread) 
+        // todo - this will throw if bad, but might periodically fail anyway. try/catch
+        try
         {
-            temperatureCv.wait_for(lock, std::chrono::seconds(10));
+            float IRTemp = (float)f200::read_ir_temp(get_device(), usbMutex);
+            float LiguriaTemp = f200::read_mems_temp(get_device(), usbMutex);
 
-            // todo - this will throw if bad, but might periodically fail anyway. try/catch
-            try
-            {
-                float IRTemp = (float)f200::read_ir_temp(get_device(), usbMutex);
-                float LiguriaTemp = f200::read_mems_temp(get_device(), usbMutex);
-
-                double IrBaseTemperature = base_temperature_data.IRTemp; //should be taken from the parameters
-                double liguriaBaseTemperature = base_temperature_data.LiguriaTemp; //should be taken from the parameters
+            double IrBaseTemperature = base_temperature_data.IRTemp; //should be taken from the parameters
+            double liguriaBaseTemperature = base_temperature_data.LiguriaTemp; //should be taken from the parameters
 
-                // calculate deltas from the calibration and last fix
-                double IrTempDelta = IRTemp - IrBaseTemperature;
-                double liguriaTempDelta = LiguriaTemp - liguriaBaseTemperature;
-                double weightedTempDelta = liguriaTempDelta * thermal_loop_params.LiguriaTempWeight + IrTempDelta * thermal_loop_params.IrTempWeight;
-                double tempDeltaFromLastFix = fabs(weightedTempDelta - last_temperature_delta);
+            // calculate deltas from the calibration and last fix
+            double IrTempDelta = IRTemp - IrBaseTemperature;
+            double liguriaTempDelta = LiguriaTemp - liguriaBaseTemperature;
+            double weightedTempDelta = liguriaTempDelta * thermal_loop_params.LiguriaTempWeight + IrTempDelta * thermal_loop_params.IrTempWeight;
+            double tempDeltaFromLastFix = fabs(weightedTempDelta - last_temperature_delta);
 
-                // read intrinsic from the calibration working point
-                double Kc11 = base_calibration.Kc[0][0];
-                double Kc13 = base_calibration.Kc[0][2];
+            // read intrinsic from the calibration working point
+            double Kc11 = base_calibration.Kc[0][0];
+            double Kc13 = base_calibration.Kc[0][2];
 
-                // Apply model
-                if (tempDeltaFromLastFix >= TempThreshold)
+            // Apply model
+            if (tempDeltaFromLastFix >= temperature_threshold)
+            {
+                // if we are during a transition, fix for after the transition
+                double tempDeltaToUse = weightedTempDelta;
+                if (tempDeltaToUse > 0 && tempDeltaToUse < thermal_loop_params.TransitionTemp)
                 {
-                    // if we are during a transition, fix for after the transition
-                    double tempDeltaToUse = weightedTempDelta;
-                    if (tempDeltaToUse > 0 && tempDeltaToUse < thermal_loop_params.TransitionTemp)
-                    {
-                        tempDeltaToUse = thermal_loop_params.TransitionTemp;
-                    }
-
-                    // calculate fixed values
-                    double fixed_Kc11 = Kc11 + (FcxSlope * tempDeltaToUse) + thermal_loop_params.FcxOffset;
-                    double fixed_Kc13 = Kc13 + (UxSlope * tempDeltaToUse) + thermal_loop_params.UxOffset;
-
-                    // write back to intrinsic hfov and vfov
-                    auto compensated_calibration = base_calibration;
-                    compensated_calibration.Kc[0][0] = (float) fixed_Kc11;
-                    compensated_calibration.Kc[1][1] = base_calibration.Kc[1][1] * (float)(fixed_Kc11/Kc11);
-                    compensated_calibration.Kc[0][2] = (float) fixed_Kc13;
-
-                    // todo - Pass the current resolution into update_asic_coefficients
-                    LOG_INFO("updating asic with new temperature calibration coefficients");
-                    update_asic_coefficients(get_device(), usbMutex, compensated_calibration);
-                    last_temperature_delta = (float)weightedTempDelta;
+                    tempDeltaToUse = thermal_loop_params.TransitionTemp;
                 }
+
+                // calculate fixed values
+                double fixed_Kc11 = Kc11 + (fcx_slope * tempDeltaToUse) + thermal_loop_params.FcxOffset;
+                double fixed_Kc13 = Kc13 + (ux_slope * tempDeltaToUse) + thermal_loop_params.UxOffset;
+
+                // write back to intrinsic hfov and vfov
+                auto compensated_calibration = base_calibration;
+                compensated_calibration.Kc[0][0] = (float) fixed_Kc11;
+                compensated_calibration.Kc[1][1] = base_calibration.Kc[1][1] * (float)(fixed_Kc11/Kc11);
+                compensated_calibration.Kc[0][2] = (float) fixed_Kc13;
+
+                // todo - Pass the current resolution into update_asic_coefficients
+                LOG_INFO("updating asic with new temperature calibration coefficients");
+                update_asic_coefficients(get_device(), usbMutex, compensated_calibration);
+                last_temperature_delta = (float)weightedTempDelta;
             }
-            catch(const std::exception & e) { LOG_ERROR("TemperatureControlLoop: " << e.what()); }
         }
+        catch(const std::exception & e) { LOG_ERROR("TemperatureControlLoop: " << e.what()); }
     }
 
     void f200_camera::start_fw_logger(char /*fw_log_op_code*/, int /*grab_rate_in_ms*/, std::timed_mutex& /*mutex*/)
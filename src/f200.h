@@ -23,12 +23,12 @@ namespace rsimpl
 
         float last_temperature_delta;
 
-        std::thread temperatureThread;
-        std::atomic<bool> runTemperatureThread;
-        std::mutex temperatureMutex;
-        std::condition_variable temperatureCv;
+        // Terms of the thermal loop which depend on the calibration only, computed once rather than on every step
+        float fcx_slope, ux_slope, temperature_threshold;
 
-        void temperature_control_loop();
+        std::shared_ptr<executor::job> temperature_job;
+
+        void temperature_control_step();
 
     public:
         f200_camera(std::shared_ptr<uvc::device> device, const static_device_info & info, const ivcam::camera_calib_params & calib, const f200::cam_temperature_data & temp, const f200::thermal_loop_params & params);
@@ -0,0 +1,171 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "frame-history.h"
+#include "depth-codec.h"
+
+using namespace rsimpl;
+using namespace rsimpl::recording;
+
+frame_history::frame_history(const device_record & device, double seconds, size_t max_bytes)
+    : device(device), duration(seconds * 1000), max_bytes(max_bytes), pushed(0), bytes(0), compressing(false), stopping(false)
+{
+    thread = std::thread([this]() { run(); });
+}
+
+frame_history::~frame_history()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    thread.join();
+}
+
+void frame_history::describe(const std::vector<mode_description> & modes)
+{
+    auto described = std::make_shared<const std::vector<mode_description>>(modes);
+    std::lock_guard<std::mutex> lock(mutex);
+    this->modes = described;
+}
+
+void frame_history::push(const frame_record & frame, bool depth, const void * data, size_t size)
+{
+    auto f = std::make_shared<stored_frame>();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!spare_buffers.empty())
+        {
+            f->data = std::move(spare_buffers.back());
+            spare_buffers.pop_back();
+        }
+    }
+
+    // The copy is the only work of the capture thread, into a buffer which already has the capacity of a frame once the history is full
+    auto pixels = static_cast<const byte *>(data);
+    f->data.assign(pixels, pixels + size);
+    f->frame = frame;
+    f->frame.encoding = frame_encoding::raw;
+    f->depth = depth;
+    f->raw_size = size;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        f->sequence = pushed++;
+        f->modes = modes;
+        frames.push_back(f);
+        bytes += size;
+        if (depth) pending.push_back(f);
+        evict(frame.timestamp);
+    }
+    if (depth) cv.notify_all();
+}
+
+void frame_history::evict(double latest)
+{
+    while (!frames.empty() && (bytes > max_bytes || frames.front()->frame.timestamp < latest - duration))
+    {
+        bytes -= frames.front()->data.size();
+        recycle(std::move(frames.front()));
+        frames.pop_front();
+    }
+}
+
+void frame_history::recycle(std::shared_ptr<stored_frame> f)
+{
+    // A dump may still be writing the frame, in which case its buffer goes with the last copy of it
+    if (f.use_count() == 1 && f->data.capacity() && spare_buffers.size() < RS_FRAME_HISTORY_SPARE_BUFFERS) spare_buffers.push_back(std::move(f->data));
+}
+
+void frame_history::run()
+{
+    std::vector<byte> encoded;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        compressing = false;
+        cv.notify_all();
+        cv.wait(lock, [this]() { return stopping || !pending.empty(); });
+        if (stopping) return;
+        auto raw = std::move(pending.front());
+        pending.pop_front();
+        if (frames.empty() || raw->sequence < frames.front()->sequence) continue; // Left the history before its turn came
+        compressing = true;
+        lock.unlock();
+
+        const int pixel_count = static_cast<int>(raw->raw_size / sizeof(uint16_t));
+        encoded.resize(rvl_max_encoded_size(pixel_count));
+        const size_t size = rvl_encode(encoded.data(), reinterpret_cast<const uint16_t *>(raw->data.data()), pixel_count);
+        auto f = std::make_shared<stored_frame>();
+        f->sequence = raw->sequence;
+        f->modes = raw->modes;
+        f->frame = raw->frame;
+        f->frame.encoding = frame_encoding::rvl;
+        f->depth = true;
+        f->data.assign(encoded.begin(), encoded.begin() + size);
+        f->raw_size = raw->raw_size;
+
+        lock.lock();
+        if (frames.empty() || raw->sequence < frames.front()->sequence) continue; // Left the history while being compressed
+        auto & slot = frames[static_cast<size_t>(raw->sequence - frames.front()->sequence)];
+        bytes = bytes - slot->data.size() + f->data.size();
+        slot = std::move(f);
+        recycle(std::move(raw));
+    }
+}
+
+size_t frame_history::get_size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes;
+}
+
+size_t frame_history::get_frame_count() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return frames.size();
+}
+
+void frame_history::wait_for_compression() const
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]() { return pending.empty() && !compressing; });
+}
+
+size_t frame_history::dump(const std::string & path, double from, double to) const
+{
+    // The frames of the window are held by the dump, so that writing them leaves the mutex to capture and compression
+    std::vector<std::shared_ptr<const stored_frame>> window;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto & f : frames) if (f->frame.timestamp >= from && f->frame.timestamp <= to) window.push_back(f);
+    }
+
+    writer out(path, RS_RECORDING_CHUNK_SIZE, RS_RECORDING_CHUNK_COUNT, true);
+    out.write_device(device);
+    const std::vector<mode_description> * described = nullptr;
+    for (auto & f : window)
+    {
+        if (f->modes.get() != described && f->modes)
+        {
+            for (auto & d : *f->modes)
+            {
+                out.write_mode(d.mode);
+                for (auto & stream : d.streams) out.write_stream(stream);
+            }
+        }
+        described = f->modes.get();
+
+        if (f->frame.encoding == frame_encoding::raw && f->depth)
+        {
+            // Not compressed yet, the writer compresses it on the way
+            auto record = f->frame;
+            record.encoding = frame_encoding::rvl;
+            out.write_frame(record, f->data.data(), f->raw_size);
+        }
+        else out.write_encoded_frame(f->frame, f->data.data(), f->data.size());
+    }
+    out.close();
+    return window.size();
+}
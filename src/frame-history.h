@@ -0,0 +1,67 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_FRAME_HISTORY_H
+#define LIBREALSENSE_FRAME_HISTORY_H
+
+#include "recording.h"
+
+namespace rsimpl
+{
+    // Keeps the native frames of the last seconds of capture in memory, within a budget of bytes, so that a window of them can be written out as
+    // a recording once something of interest happened. Capture threads only copy a frame into a recycled buffer. Z16 depth frames are then
+    // compressed losslessly by a thread of the history, as recordings compress them, while other frames stay in their native format, YUY2 color
+    // taking half the memory of its unpacked form. Frames leave the history, oldest first, once they are older than its duration or once it
+    // holds more bytes than its budget, so that capture never waits for the compression to catch up.
+    class frame_history
+    {
+        struct stored_frame                     // Never changed once held by the history, the compressed frame replacing the raw one
+        {
+            uint64_t sequence;                  // Of the frame among every frame pushed
+            std::shared_ptr<const std::vector<recording::mode_description>> modes; // Streamed when the frame was captured
+            recording::frame_record frame;      // encoding is that of data
+            bool depth;                         // A Z16 frame, compressed by the history
+            std::vector<byte> data;
+            size_t raw_size;
+        };
+
+        const recording::device_record device;
+        const double duration;                  // Milliseconds of frame timestamps
+        const size_t max_bytes;
+
+        mutable std::mutex mutex;               // Guards the members below
+        mutable std::condition_variable cv;
+        std::deque<std::shared_ptr<stored_frame>> frames;   // In the order they were pushed, frames[i] being frame number frames.front()->sequence + i
+        std::deque<std::shared_ptr<stored_frame>> pending;  // Depth frames to compress, some of which may have left the history already
+        std::vector<std::vector<byte>> spare_buffers;
+        std::shared_ptr<const std::vector<recording::mode_description>> modes;
+        uint64_t pushed;
+        size_t bytes;                           // Of the data of the frames held
+        bool compressing;                       // A frame taken from pending is being compressed
+        bool stopping;
+        std::thread thread;
+
+        frame_history(const frame_history &) = delete;
+        frame_history & operator=(const frame_history &) = delete;
+
+        void evict(double latest);              // Requires mutex
+        void recycle(std::shared_ptr<stored_frame> f); // Requires mutex, keeps the buffer of a frame nobody else holds
+        void run();
+    public:
+        frame_history(const recording::device_record & device, double seconds, size_t max_bytes);
+        ~frame_history();
+
+        void describe(const std::vector<recording::mode_description> & modes); // Of the frames pushed from then on, when capture starts
+        void push(const recording::frame_record & frame, bool depth, const void * data, size_t size);
+
+        size_t get_size() const;                // Bytes of the frames held
+        size_t get_frame_count() const;
+        void wait_for_compression() const;      // Until every depth frame held is compressed
+
+        // Writes the frames held with timestamps in [from, to] as a recording, which playback replays, returning how many were written
+        size_t dump(const std::string & path, double from, double to) const;
+    };
+}
+
+#endif
@@ -0,0 +1,77 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_FW_LOG_H
+#define LIBREALSENSE_FW_LOG_H
+
+#include "types.h"
+
+#include <fstream>
+
+namespace rsimpl
+{
+    // Keeps the latest firmware log data read from a device, as the records of rs_export_fw_log(): a little-endian 32 bit count of bytes
+    // followed by the bytes of one read. Once full, the oldest records make room for new ones, whole.
+    class fw_log_ring
+    {
+        mutable std::mutex mutex;   // Reads of the log complete on executor threads, while the application exports
+        std::vector<uint8_t> bytes;
+        size_t begin, size;         // Of the records kept, begin wrapping around bytes
+
+        void copy_in(size_t offset, const uint8_t * data, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) bytes[(begin + offset + i) % bytes.size()] = data[i];
+        }
+        uint32_t record_size(size_t offset) const
+        {
+            uint32_t count = 0;
+            for (int i = 0; i < 4; ++i) count |= uint32_t(bytes[(begin + offset + i) % bytes.size()]) << (8 * i);
+            return count;
+        }
+    public:
+        explicit fw_log_ring(size_t capacity) : bytes(capacity), begin(0), size(0) {}
+
+        void push(const uint8_t * data, size_t count)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const size_t needed = 4 + count;
+            if (needed > bytes.size()) return;
+            while (bytes.size() - size < needed)
+            {
+                const size_t oldest = 4 + record_size(0);
+                begin = (begin + oldest) % bytes.size();
+                size -= oldest;
+            }
+            const uint8_t header[4] = { uint8_t(count), uint8_t(count >> 8), uint8_t(count >> 16), uint8_t(count >> 24) };
+            copy_in(size, header, 4);
+            copy_in(size + 4, data, count);
+            size += needed;
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            begin = size = 0;
+        }
+
+        std::vector<uint8_t> get_records() const // Oldest first
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<uint8_t> records(size);
+            for (size_t i = 0; i < size; ++i) records[i] = bytes[(begin + i) % bytes.size()];
+            return records;
+        }
+
+        void export_records(const char * file_path) const
+        {
+            auto records = get_records();
+            std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+            if (!file) throw std::runtime_error(to_string() << "could not open " << file_path << " for writing");
+            file.write(reinterpret_cast<const char *>(records.data()), records.size());
+            if (!file) throw std::runtime_error(to_string() << "could not write the firmware log to " << file_path);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,29 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+// Without BUILD_WITH_CUDA, derived streams are only computed on the CPU. The CUDA implementation lives in gpu.cu.
+#ifndef RS_USE_CUDA
+
+#include "gpu.h"
+
+namespace rsimpl
+{
+    namespace gpu
+    {
+        struct processor::impl {};
+
+        bool is_available() { return false; }
+
+        static void throw_unavailable() { throw std::runtime_error("librealsense was built without BUILD_WITH_CUDA"); }
+
+        processor::processor() { throw_unavailable(); }
+        processor::~processor() {}
+
+        void processor::deproject_z(float *, const std::shared_ptr<const std::vector<float>> &, const uint16_t *, int, float) { throw_unavailable(); }
+        void processor::align_z_to_other(uint16_t *, const uint16_t *, float, const rs_intrinsics &, const std::shared_ptr<const std::vector<float>> &, const rs_extrinsics &, const rs_intrinsics &) { throw_unavailable(); }
+        void processor::align_other_to_z(byte *, const uint16_t *, float, const rs_intrinsics &, const std::shared_ptr<const std::vector<float>> &, const rs_extrinsics &, const rs_intrinsics &, const byte *, int) { throw_unavailable(); }
+        void processor::rectify_image(byte *, const std::shared_ptr<const rectification_table> &, const byte *, int, int) { throw_unavailable(); }
+    }
+}
+
+#endif
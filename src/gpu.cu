@@ -0,0 +1,281 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+// Derived streams computed on a CUDA device, built with BUILD_WITH_CUDA. Every kernel runs one thread per pixel of the image the CPU
+// function it replaces loops over, through the same pixel arithmetic.
+#ifdef RS_USE_CUDA
+
+#include "gpu.h"
+
+#include <cuda_runtime.h>
+
+namespace rsimpl
+{
+    namespace gpu
+    {
+        static void check(cudaError_t result, const char * call)
+        {
+            if(result != cudaSuccess) throw std::runtime_error(to_string() << call << " failed: " << cudaGetErrorString(result));
+        }
+        #define CUDA_CHECK(call) check(call, #call)
+
+        const int threads_per_block = 256;
+        static int blocks_for(int count) { return (count + threads_per_block - 1) / threads_per_block; }
+
+        bool is_available()
+        {
+            static const bool available = []() { int count = 0; return cudaGetDeviceCount(&count) == cudaSuccess && count > 0; }();
+            return available;
+        }
+
+        // Device memory, grown as needed and kept for the next frame
+        class device_buffer
+        {
+            void * data;
+            size_t capacity;
+        public:
+            device_buffer() : data(), capacity() {}
+            device_buffer(const device_buffer &) = delete;
+            device_buffer & operator = (const device_buffer &) = delete;
+            ~device_buffer() { if(data) cudaFree(data); }
+
+            template<class T> T * get(size_t count)
+            {
+                if(count * sizeof(T) > capacity)
+                {
+                    if(data) cudaFree(data);
+                    data = nullptr;
+                    capacity = 0;
+                    CUDA_CHECK(cudaMalloc(&data, count * sizeof(T)));
+                    capacity = count * sizeof(T);
+                }
+                return static_cast<T *>(data);
+            }
+        };
+
+        // The device copy of a table of the calibration cache, uploaded again only when the cache hands out another. The table uploaded
+        // is kept alive so that no table built later can reuse its address.
+        template<class TABLE> class resident_table
+        {
+            std::shared_ptr<const TABLE> uploaded;
+            device_buffer buffer;
+        public:
+            template<class T, class UPLOAD> const T * get(const std::shared_ptr<const TABLE> & table, size_t count, UPLOAD upload)
+            {
+                auto data = buffer.get<T>(count);
+                if(table != uploaded)
+                {
+                    upload(data);
+                    uploaded = table;
+                }
+                return data;
+            }
+        };
+
+        ///////////////////////////////////////
+        // Device versions of rsutil.h calls //
+        ///////////////////////////////////////
+
+        __device__ void project_point_to_pixel(float pixel[2], const rs_intrinsics & intrin, const float point[3])
+        {
+            float x = point[0] / point[2], y = point[1] / point[2];
+            if(intrin.model == RS_DISTORTION_MODIFIED_BROWN_CONRADY)
+            {
+                float r2  = x*x + y*y;
+                float f = 1 + intrin.coeffs[0]*r2 + intrin.coeffs[1]*r2*r2 + intrin.coeffs[4]*r2*r2*r2;
+                x *= f;
+                y *= f;
+                float dx = x + 2*intrin.coeffs[2]*x*y + intrin.coeffs[3]*(r2 + 2*x*x);
+                float dy = y + 2*intrin.coeffs[3]*x*y + intrin.coeffs[2]*(r2 + 2*y*y);
+                x = dx;
+                y = dy;
+            }
+            pixel[0] = x * intrin.fx + intrin.ppx;
+            pixel[1] = y * intrin.fy + intrin.ppy;
+        }
+
+        // The rectangle of the other image covered by one depth pixel, as for_each_footprint(...) of image.cpp finds it. Returns false if
+        // the rectangle is not entirely inside the other image.
+        __device__ bool map_footprint(int & x0, int & y0, int & x1, int & y1, const float * rays, int depth_x, int depth_y, int depth_width, float depth,
+                                      const rs_extrinsics & depth_to_other, const rs_intrinsics & other_intrin)
+        {
+            const int ray_stride = (depth_width + 1) * 3;
+            const float * corners[] = { rays + depth_y * ray_stride + depth_x * 3, rays + (depth_y + 1) * ray_stride + (depth_x + 1) * 3 };
+            int * xs[] = { &x0, &x1 }, * ys[] = { &y0, &y1 };
+            for(int i = 0; i < 2; ++i)
+            {
+                const float * ray = corners[i];
+                const float other_point[] = { depth * ray[0] + depth_to_other.translation[0], depth * ray[1] + depth_to_other.translation[1], depth * ray[2] + depth_to_other.translation[2] };
+                float other_pixel[2];
+                project_point_to_pixel(other_pixel, other_intrin, other_point);
+                *xs[i] = static_cast<int>(other_pixel[0] + 0.5f);
+                *ys[i] = static_cast<int>(other_pixel[1] + 0.5f);
+            }
+            return x0 >= 0 && y0 >= 0 && x1 < other_intrin.width && y1 < other_intrin.height;
+        }
+
+        /////////////
+        // Kernels //
+        /////////////
+
+        __global__ void deproject_z_kernel(float * points, const float * table, const uint16_t * z_pixels, int count, float z_scale)
+        {
+            const int i = blockIdx.x * blockDim.x + threadIdx.x;
+            if(i >= count) return;
+            const float depth = z_scale * z_pixels[i];
+            points[i * 3 + 0] = table[i * 2 + 0] * depth;
+            points[i * 3 + 1] = table[i * 2 + 1] * depth;
+            points[i * 3 + 2] = depth;
+        }
+
+        // Every other pixel keeps the nearest depth of the footprints covering it, starting from 0xFFFFFFFF for none
+        __global__ void scatter_z_kernel(unsigned int * nearest, const uint16_t * z_pixels, float z_scale, int z_width, int z_height, const float * rays,
+                                         rs_extrinsics z_to_other, rs_intrinsics other_intrin)
+        {
+            const int i = blockIdx.x * blockDim.x + threadIdx.x;
+            if(i >= z_width * z_height || !z_pixels[i]) return;
+            int x0, y0, x1, y1;
+            if(!map_footprint(x0, y0, x1, y1, rays, i % z_width, i / z_width, z_width, z_scale * z_pixels[i], z_to_other, other_intrin)) return;
+            for(int y = y0; y <= y1; ++y) for(int x = x0; x <= x1; ++x) atomicMin(&nearest[y * other_intrin.width + x], static_cast<unsigned int>(z_pixels[i]));
+        }
+
+        __global__ void narrow_z_kernel(uint16_t * z_aligned_to_other, const unsigned int * nearest, int count)
+        {
+            const int i = blockIdx.x * blockDim.x + threadIdx.x;
+            if(i < count) z_aligned_to_other[i] = nearest[i] == 0xFFFFFFFF ? 0 : static_cast<uint16_t>(nearest[i]);
+        }
+
+        // Of every footprint the CPU visits every pixel and keeps the last, its bottom-right corner, which is all this copies
+        __global__ void gather_other_kernel(byte * other_aligned_to_z, const uint16_t * z_pixels, float z_scale, int z_width, int z_height, const float * rays,
+                                            rs_extrinsics z_to_other, rs_intrinsics other_intrin, const byte * other_pixels, int pixel_size)
+        {
+            const int i = blockIdx.x * blockDim.x + threadIdx.x;
+            if(i >= z_width * z_height || !z_pixels[i]) return;
+            int x0, y0, x1, y1;
+            if(!map_footprint(x0, y0, x1, y1, rays, i % z_width, i / z_width, z_width, z_scale * z_pixels[i], z_to_other, other_intrin)) return;
+            if(x0 > x1 || y0 > y1) return;
+            const byte * in = other_pixels + (y1 * other_intrin.width + x1) * pixel_size;
+            for(int b = 0; b < pixel_size; ++b) other_aligned_to_z[i * pixel_size + b] = in[b];
+        }
+
+        __global__ void rectify_kernel(byte * rect_pixels, const int32_t * indices, int count, const byte * unrect_pixels, int pixel_size)
+        {
+            const int i = blockIdx.x * blockDim.x + threadIdx.x;
+            if(i >= count) return;
+            const byte * in = unrect_pixels + indices[i] * pixel_size;
+            for(int b = 0; b < pixel_size; ++b) rect_pixels[i * pixel_size + b] = in[b];
+        }
+
+        ///////////////
+        // Processor //
+        ///////////////
+
+        struct processor::impl
+        {
+            std::mutex mutex; // compute_frame(...) of one stream may be called from the thread precomputing it and from get_frame_data()
+            cudaStream_t stream;
+            resident_table<std::vector<float>> deprojection_table, alignment_rays;
+            resident_table<rectification_table> rectification_indices;
+            device_buffer input, other_input, scratch, output;
+
+            impl() { CUDA_CHECK(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking)); }
+            ~impl() { cudaStreamDestroy(stream); }
+
+            template<class T> T * upload(device_buffer & buffer, const T * data, size_t count)
+            {
+                auto d = buffer.get<T>(count);
+                CUDA_CHECK(cudaMemcpyAsync(d, data, count * sizeof(T), cudaMemcpyHostToDevice, stream));
+                return d;
+            }
+
+            const float * upload_rays(const std::shared_ptr<const std::vector<float>> & rays)
+            {
+                return alignment_rays.get<float>(rays, rays->size(), [&](float * d) { CUDA_CHECK(cudaMemcpyAsync(d, rays->data(), rays->size() * sizeof(float), cudaMemcpyHostToDevice, stream)); });
+            }
+
+            template<class T> void download(T * dest, const T * d, size_t count)
+            {
+                CUDA_CHECK(cudaGetLastError());
+                CUDA_CHECK(cudaMemcpyAsync(dest, d, count * sizeof(T), cudaMemcpyDeviceToHost, stream));
+                CUDA_CHECK(cudaStreamSynchronize(stream));
+            }
+        };
+
+        processor::processor()
+        {
+            if(!is_available()) throw std::runtime_error("no CUDA device is present");
+            p.reset(new impl());
+        }
+        processor::~processor() {}
+
+        void processor::deproject_z(float * points, const std::shared_ptr<const std::vector<float>> & deprojection_table, const uint16_t * z_pixels, int count, float z_scale)
+        {
+            std::lock_guard<std::mutex> lock(p->mutex);
+            auto table = p->deprojection_table.get<float>(deprojection_table, count * 2, [&](float * d) { CUDA_CHECK(cudaMemcpyAsync(d, deprojection_table->data(), count * 2 * sizeof(float), cudaMemcpyHostToDevice, p->stream)); });
+            auto z = p->upload(p->input, z_pixels, count);
+            auto out = p->output.get<float>(count * 3);
+            deproject_z_kernel<<<blocks_for(count), threads_per_block, 0, p->stream>>>(out, table, z, count, z_scale);
+            p->download(points, out, count * 3);
+        }
+
+        void processor::align_z_to_other(uint16_t * z_aligned_to_other, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, const std::shared_ptr<const std::vector<float>> & z_rays,
+                                         const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin)
+        {
+            std::lock_guard<std::mutex> lock(p->mutex);
+            const int z_count = z_intrin.width * z_intrin.height, other_count = other_intrin.width * other_intrin.height;
+            auto rays = p->upload_rays(z_rays);
+            auto z = p->upload(p->input, z_pixels, z_count);
+            auto nearest = p->scratch.get<unsigned int>(other_count);
+            auto out = p->output.get<uint16_t>(other_count);
+            CUDA_CHECK(cudaMemsetAsync(nearest, 0xFF, other_count * sizeof(unsigned int), p->stream));
+            scatter_z_kernel<<<blocks_for(z_count), threads_per_block, 0, p->stream>>>(nearest, z, z_scale, z_intrin.width, z_intrin.height, rays, z_to_other, other_intrin);
+            narrow_z_kernel<<<blocks_for(other_count), threads_per_block, 0, p->stream>>>(out, nearest, other_count);
+            p->download(z_aligned_to_other, out, other_count);
+        }
+
+        void processor::align_other_to_z(byte * other_aligned_to_z, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, const std::shared_ptr<const std::vector<float>> & z_rays,
+                                         const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels, int other_pixel_size)
+        {
+            std::lock_guard<std::mutex> lock(p->mutex);
+            const int z_count = z_intrin.width * z_intrin.height;
+            auto rays = p->upload_rays(z_rays);
+            auto z = p->upload(p->input, z_pixels, z_count);
+            auto other = p->upload(p->other_input, other_pixels, other_intrin.width * other_intrin.height * other_pixel_size);
+            auto out = p->output.get<byte>(z_count * other_pixel_size);
+            CUDA_CHECK(cudaMemsetAsync(out, 0, z_count * other_pixel_size, p->stream));
+            gather_other_kernel<<<blocks_for(z_count), threads_per_block, 0, p->stream>>>(out, z, z_scale, z_intrin.width, z_intrin.height, rays, z_to_other, other_intrin, other, other_pixel_size);
+            p->download(other_aligned_to_z, out, z_count * other_pixel_size);
+        }
+
+        void processor::rectify_image(byte * rect_pixels, const std::shared_ptr<const rectification_table> & table, const byte * unrect_pixels, int unrect_pixel_count, int pixel_size)
+        {
+            std::lock_guard<std::mutex> lock(p->mutex);
+            typedef rectification_table table_type;
+            const int count = table->width * table->height;
+
+            // The tiles only save memory bandwidth on the CPU, so the device keeps one 32 bit index per rectified pixel
+            auto indices = p->rectification_indices.get<int32_t>(table, count, [&](int32_t * d)
+            {
+                std::vector<int32_t> flat(count);
+                const int tiles_per_row = (table->width + table_type::tile_width - 1) / table_type::tile_width;
+                for(int y = 0; y < table->height; ++y)
+                {
+                    for(int x = 0; x < table->width; ++x)
+                    {
+                        const auto & tile = table->tiles[(y / table_type::tile_height) * tiles_per_row + x / table_type::tile_width];
+                        const int offset = tile.first + (y % table_type::tile_height) * table_type::tile_width + x % table_type::tile_width;
+                        flat[y * table->width + x] = tile.base + (tile.wide ? table->wide_offsets[offset] : table->narrow_offsets[offset]);
+                    }
+                }
+                CUDA_CHECK(cudaMemcpyAsync(d, flat.data(), count * sizeof(int32_t), cudaMemcpyHostToDevice, p->stream));
+                CUDA_CHECK(cudaStreamSynchronize(p->stream)); // Before flat goes away
+            });
+            auto unrect = p->upload(p->input, unrect_pixels, unrect_pixel_count * pixel_size);
+            auto out = p->output.get<byte>(count * pixel_size);
+            rectify_kernel<<<blocks_for(count), threads_per_block, 0, p->stream>>>(out, indices, count, unrect, pixel_size);
+            p->download(rect_pixels, out, count * pixel_size);
+        }
+    }
+}
+
+#endif
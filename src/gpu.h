@@ -0,0 +1,49 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_GPU_H
+#define LIBREALSENSE_GPU_H
+
+#include "image.h" // For rectification_table
+
+#include <memory>
+
+namespace rsimpl
+{
+    namespace gpu
+    {
+        // True if the library was built with BUILD_WITH_CUDA and a CUDA device is present
+        bool is_available();
+
+        // Computes the images of one derived stream on the CUDA device. The tables of the stream are uploaded the first time they are used
+        // and stay resident until the calibration cache hands out another table, so a frame only moves its source pixels in and the result
+        // out. Inputs and outputs are host memory, which the driver copies by DMA when it is pinned, such as blocks of a frame allocator
+        // obtained from cudaHostAlloc(). Results match those of the CPU functions of image.h they stand in for, up to the rounding of
+        // floating point arithmetic on the device.
+        class processor
+        {
+            struct impl;
+            std::unique_ptr<impl> p;
+        public:
+            processor();
+            ~processor();
+
+            // Into XYZ32F, as deproject_z(...)
+            void deproject_z(float * points, const std::shared_ptr<const std::vector<float>> & deprojection_table, const uint16_t * z_pixels, int count, float z_scale);
+
+            // As align_z_to_other(...), into an image that needs no clearing beforehand
+            void align_z_to_other(uint16_t * z_aligned_to_other, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, const std::shared_ptr<const std::vector<float>> & z_rays,
+                                  const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin);
+
+            // As align_other_to_z(...) for other formats of 1 to 4 bytes per pixel, into an image that needs no clearing beforehand
+            void align_other_to_z(byte * other_aligned_to_z, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, const std::shared_ptr<const std::vector<float>> & z_rays,
+                                  const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels, int other_pixel_size);
+
+            // As rectify_image(...) for formats of 1 to 4 bytes per pixel
+            void rectify_image(byte * rect_pixels, const std::shared_ptr<const rectification_table> & table, const byte * unrect_pixels, int unrect_pixel_count, int pixel_size);
+        };
+    }
+}
+
+#endif
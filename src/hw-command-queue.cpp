@@ -0,0 +1,107 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "hw-command-queue.h"
+
+using namespace rsimpl;
+
+// How long a background command waits for the monitor before giving way to the commands of other threads
+const std::chrono::milliseconds background_lock_timeout(2);
+
+hw_command_queue::hw_command_queue(executor & pool, uvc::device & device, std::timed_mutex & mutex)
+    : hw_command_queue(pool, [&device, &mutex](hw_monitor::hwmon_cmd & cmd, std::chrono::milliseconds lock_timeout) { hw_monitor::perform_and_send_monitor_command(device, mutex, cmd, lock_timeout); })
+{
+}
+
+// Reads are commands expecting a reply and sending no data, two of them with the same opcode and parameters get the same reply
+bool hw_command_queue::is_same_read(const hw_monitor::hwmon_cmd & a, const hw_monitor::hwmon_cmd & b)
+{
+    return !a.oneDirection && !b.oneDirection && !a.sizeOfSendCommandData && !b.sizeOfSendCommandData && a.cmd == b.cmd
+        && a.Param1 == b.Param1 && a.Param2 == b.Param2 && a.Param3 == b.Param3 && a.Param4 == b.Param4;
+}
+
+void hw_command_queue::submit(const hw_monitor::hwmon_cmd & cmd, hw_command_priority priority, completion on_complete)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) throw std::runtime_error("commands can no longer be submitted to a device being released");
+
+        auto & queue = requests[(int)priority];
+        auto it = std::find_if(queue.begin(), queue.end(), [&cmd](const request & r) { return is_same_read(*r.cmd, cmd); });
+        if (it != queue.end()) it->completions.push_back(on_complete);
+        else queue.push_back({ std::make_shared<hw_monitor::hwmon_cmd>(cmd), { on_complete } });
+    }
+    job->trigger();
+}
+
+size_t hw_command_queue::get_queued_count(hw_command_priority priority)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return requests[(int)priority].size();
+}
+
+// Every run carries out the commands until none is left, or until a background command finds the monitor busy, in which case it is put back and
+// another run is triggered. Commands made meanwhile trigger one more run which may find none.
+void hw_command_queue::run()
+{
+    while (true)
+    {
+        request r;
+        hw_command_priority priority;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) return;
+            priority = !requests[(int)hw_command_priority::control].empty() ? hw_command_priority::control : hw_command_priority::background;
+            auto & queue = requests[(int)priority];
+            if (queue.empty()) return;
+            r = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        std::string error_message;
+        try
+        {
+            perform(*r.cmd, priority == hw_command_priority::control ? std::chrono::milliseconds(IVCAM_MONITOR_MUTEX_TIMEOUT) : background_lock_timeout);
+        }
+        catch (const hw_monitor::monitor_busy_error & e)
+        {
+            if (priority == hw_command_priority::control) error_message = e.what();
+            else
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    auto & queue = requests[(int)priority];
+                    queue.push_front(std::move(r));
+                }
+                job->trigger();
+                return;
+            }
+        }
+        catch (const std::exception & e) { error_message = e.what(); }
+        catch (...) { error_message = "unknown error"; }
+        complete(r, error_message.empty() ? nullptr : error_message.c_str());
+    }
+}
+
+void hw_command_queue::complete(const request & r, const char * error_message)
+{
+    for (auto & c : r.completions)
+    {
+        if (!c) continue;
+        try { c(*r.cmd, error_message); }
+        catch (...) { LOG_ERROR("Received an exception from hardware command callback!"); }
+    }
+}
+
+void hw_command_queue::stop()
+{
+    std::deque<request> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        for (auto & queue : requests) for (auto & r : queue) abandoned.push_back(std::move(r));
+        for (auto & queue : requests) queue.clear();
+    }
+    job->cancel();
+    for (auto & r : abandoned) complete(r, "the device was released before the command was carried out");
+}
@@ -0,0 +1,53 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_HW_COMMAND_QUEUE_H
+#define LIBREALSENSE_HW_COMMAND_QUEUE_H
+
+#include "executor.h"
+#include "hw-monitor.h"
+
+namespace rsimpl
+{
+    enum class hw_command_priority { control, background };
+
+    // Carries out hardware monitor commands on a job of the executor, and hands their replies to completion callbacks. Control commands are
+    // served before any background command, and background commands give way as soon as the monitor is busy with the commands of other
+    // threads, instead of waiting for it. A read still waiting its turn absorbs the identical reads queued after it, which share its reply.
+    class hw_command_queue
+    {
+    public:
+        typedef std::function<void(hw_monitor::hwmon_cmd & cmd, std::chrono::milliseconds lock_timeout)> performer; // Throws hw_monitor::monitor_busy_error past lock_timeout
+        typedef std::function<void(const hw_monitor::hwmon_cmd & cmd, const char * error_message)> completion;     // error_message is null on success
+    private:
+        struct request
+        {
+            std::shared_ptr<hw_monitor::hwmon_cmd> cmd;
+            std::vector<completion> completions;
+        };
+
+        const performer perform;
+        std::mutex mutex;
+        std::deque<request> requests[2]; // Indexed by hw_command_priority
+        bool stopping = false;
+        std::shared_ptr<executor::job> job;
+
+        hw_command_queue(const hw_command_queue &) = delete;
+        hw_command_queue & operator=(const hw_command_queue &) = delete;
+
+        void run();
+        static bool is_same_read(const hw_monitor::hwmon_cmd & a, const hw_monitor::hwmon_cmd & b);
+        static void complete(const request & r, const char * error_message);
+    public:
+        hw_command_queue(executor & pool, performer perform) : perform(perform), job(pool.create_job([this]() { run(); })) {}
+        hw_command_queue(executor & pool, uvc::device & device, std::timed_mutex & mutex);
+        ~hw_command_queue() { stop(); }
+
+        void submit(const hw_monitor::hwmon_cmd & cmd, hw_command_priority priority, completion on_complete); // on_complete may be empty
+        size_t get_queued_count(hw_command_priority priority);
+        void stop(); // Waits for the command being carried out and fails those still queued
+    };
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 
 #include "hw-monitor.h"
+#include "trace.h"
 
 namespace rsimpl
 {
@@ -41,19 +42,17 @@ namespace rsimpl
         }
 
 
-        void execute_usb_command(uvc::device & device, std::timed_mutex & mutex, uint8_t *out, size_t outSize, uint32_t & op, uint8_t * in, size_t & inSize)
+        // The transfers of a single command, with the monitor mutex held. The reply is read settle_time after the command was sent.
+        static void transfer_usb_command(uvc::device & device, uint8_t *out, size_t outSize, uint32_t & op, uint8_t * in, size_t & inSize, std::chrono::milliseconds settle_time)
         {
             // write
             errno = 0;
 
             int outXfer;
 
-            if (!mutex.try_lock_for(std::chrono::milliseconds(IVCAM_MONITOR_MUTEX_TIMEOUT))) throw std::runtime_error("timed_mutex::try_lock_for(...) timed out");
-            std::lock_guard<std::timed_mutex> guard(mutex, std::adopt_lock);
-
             bulk_transfer(device, IVCAM_MONITOR_ENDPOINT_OUT, out, (int)outSize, &outXfer, 1000); // timeout in ms
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            if (settle_time.count()) std::this_thread::sleep_for(settle_time);
             // read
             if (in && inSize)
             {
@@ -71,14 +70,55 @@ namespace rsimpl
             }
         }
 
-        void send_hw_monitor_command(uvc::device & device, std::timed_mutex & mutex, hwmon_cmd_details & details)
+        void execute_usb_command(uvc::device & device, std::timed_mutex & mutex, uint8_t *out, size_t outSize, uint32_t & op, uint8_t * in, size_t & inSize, std::chrono::milliseconds lock_timeout)
+        {
+            RS_TRACE_SPAN("hw_monitor");
+
+            if (!mutex.try_lock_for(lock_timeout)) throw monitor_busy_error();
+            std::lock_guard<std::timed_mutex> guard(mutex, std::adopt_lock);
+
+            transfer_usb_command(device, out, outSize, op, in, inSize, std::chrono::milliseconds(20));
+        }
+
+        void perform_monitor_commands(uvc::device & device, std::timed_mutex & mutex, hwmon_cmd * commands, size_t count, const std::function<void(size_t performed)> & on_performed)
+        {
+            RS_TRACE_SPAN("hw_monitor_batch");
+
+            if (!mutex.try_lock_for(std::chrono::milliseconds(IVCAM_MONITOR_MUTEX_TIMEOUT))) throw monitor_busy_error();
+            std::lock_guard<std::timed_mutex> guard(mutex, std::adopt_lock);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto & cmd = commands[i];
+                uint8_t out[HW_MONITOR_COMMAND_SIZE];
+                int out_size = 0;
+                fill_usb_buffer(cmd.cmd, cmd.Param1, cmd.Param2, cmd.Param3, cmd.Param4, cmd.data, cmd.sizeOfSendCommandData, out, out_size);
+
+                // The read of the reply waits for the device to answer, so commands following each other need no settle time
+                uint8_t reply[HW_MONITOR_BUFFER_SIZE];
+                size_t reply_size = sizeof(reply);
+                uint32_t op = 0;
+                transfer_usb_command(device, out, out_size, op, reply, reply_size, std::chrono::milliseconds(0));
+                if (!cmd.oneDirection)
+                {
+                    if (reply_size < 4) throw std::runtime_error("received incomplete response to usb command");
+                    memcpy(cmd.receivedOpcode, reply, 4);
+                    cmd.receivedCommandDataLength = reply_size - 4;
+                    memcpy(cmd.receivedCommandData, reply + 4, cmd.receivedCommandDataLength);
+                    if (pack(reply[3], reply[2], reply[1], reply[0]) != cmd.cmd) throw std::runtime_error("opcodes do not match");
+                }
+                if (on_performed) on_performed(i + 1);
+            }
+        }
+
+        void send_hw_monitor_command(uvc::device & device, std::timed_mutex & mutex, hwmon_cmd_details & details, std::chrono::milliseconds lock_timeout)
         {
             unsigned char outputBuffer[HW_MONITOR_BUFFER_SIZE];
 
             uint32_t op;
             size_t receivedCmdLen = HW_MONITOR_BUFFER_SIZE;
 
-            execute_usb_command(device, mutex, (uint8_t*)details.sendCommandData, (size_t)details.sizeOfSendCommandData, op, outputBuffer, receivedCmdLen);
+            execute_usb_command(device, mutex, (uint8_t*)details.sendCommandData, (size_t)details.sizeOfSendCommandData, op, outputBuffer, receivedCmdLen, lock_timeout);
             details.receivedCommandDataLength = receivedCmdLen;
 
             if (details.oneDirection) return;
@@ -92,7 +132,7 @@ namespace rsimpl
                 memcpy(details.receivedCommandData, outputBuffer + 4, details.receivedCommandDataLength);
         }
 
-        void perform_and_send_monitor_command(uvc::device & device, std::timed_mutex & mutex, hwmon_cmd & newCommand)
+        void perform_and_send_monitor_command(uvc::device & device, std::timed_mutex & mutex, hwmon_cmd & newCommand, std::chrono::milliseconds lock_timeout)
         {
             uint32_t opCodeXmit = (uint32_t)newCommand.cmd;
 
@@ -110,7 +150,7 @@ namespace rsimpl
                 details.sendCommandData,
                 details.sizeOfSendCommandData);
 
-            send_hw_monitor_command(device, mutex, details);
+            send_hw_monitor_command(device, mutex, details, lock_timeout);
 
             // Error/exit conditions
             if (newCommand.oneDirection)
@@ -76,7 +76,7 @@ namespace rsimpl
             size_t      receivedCommandDataLength;
             uint8_t     receivedOpcode[4];
 
-            hwmon_cmd(uint8_t cmd_id) : cmd(cmd_id), Param1(0), Param2(0), Param3(0), Param4(0), sizeOfSendCommandData(0), TimeOut(5000), oneDirection(false){}
+            hwmon_cmd(uint8_t cmd_id) : cmd(cmd_id), Param1(0), Param2(0), Param3(0), Param4(0), sizeOfSendCommandData(0), TimeOut(5000), oneDirection(false), receivedCommandDataLength(0){}
         };
 
         struct hwmon_cmd_details
@@ -92,12 +92,24 @@ namespace rsimpl
         
         void fill_usb_buffer(int opCodeNumber, int p1, int p2, int p3, int p4, uint8_t * data, int dataLength, uint8_t * bufferToSend, int & length);
 
-        void execute_usb_command(uvc::device & device, std::timed_mutex & mutex, uint8_t *out, size_t outSize, uint32_t & op, uint8_t * in, size_t & inSize);        
+        // Thrown when the monitor of the device stays busy with the commands of other threads for longer than the lock timeout of a command
+        struct monitor_busy_error : std::runtime_error
+        {
+            monitor_busy_error() : std::runtime_error("timed_mutex::try_lock_for(...) timed out") {}
+        };
+
+        void execute_usb_command(uvc::device & device, std::timed_mutex & mutex, uint8_t *out, size_t outSize, uint32_t & op, uint8_t * in, size_t & inSize,
+            std::chrono::milliseconds lock_timeout = std::chrono::milliseconds(IVCAM_MONITOR_MUTEX_TIMEOUT));
+
+        void send_hw_monitor_command(uvc::device & device, std::timed_mutex & mutex, hwmon_cmd_details & details,
+            std::chrono::milliseconds lock_timeout = std::chrono::milliseconds(IVCAM_MONITOR_MUTEX_TIMEOUT));
 
-        void send_hw_monitor_command(uvc::device & device, std::timed_mutex & mutex, hwmon_cmd_details & details);
+        void perform_and_send_monitor_command(uvc::device & device, std::timed_mutex & mutex, hwmon_cmd & newCommand,
+            std::chrono::milliseconds lock_timeout = std::chrono::milliseconds(IVCAM_MONITOR_MUTEX_TIMEOUT));
 
-        void perform_and_send_monitor_command(uvc::device & device, std::timed_mutex & mutex, hwmon_cmd & newCommand);
-        void perform_and_send_monitor_command(uvc::device & device, std::timed_mutex & mutex, hwmon_cmd & newCommand);
+        // Performs commands back to back under a single hold of the monitor mutex, so no command of another thread lands in between, reading
+        // every reply as soon as the device sends it. on_performed, if set, is told how many commands went through after each one.
+        void perform_monitor_commands(uvc::device & device, std::timed_mutex & mutex, hwmon_cmd * commands, size_t count, const std::function<void(size_t performed)> & on_performed);
 
         void i2c_write_reg(int command, uvc::device & device, uint16_t slave_address, uint16_t reg, uint32_t value);
         void i2c_read_reg(int command, uvc::device & device, uint16_t slave_address, uint16_t reg, uint32_t size, byte* data);
@@ -0,0 +1,73 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "image-simd.h"
+
+namespace rsimpl
+{
+#ifdef RS_SIMD_HAVE_AVX2
+    // Unpacks 32 pixels per step, and finishes the last 16 pixels of an odd number of steps with 128 bit registers
+    template<rs_format FORMAT> void unpack_yuy2_avx2(byte * const d [], const byte * s, int n)
+    {
+        assert(n % 16 == 0);
+        byte * dst = d[0];
+        n = unpack_yuy2_simd<avx2_ops, FORMAT>(dst, s, n);
+        unpack_yuy2_simd<sse_ops, FORMAT>(dst, s, n);
+    }
+
+    static int unpack_yuy2_420_avx2(byte * y0, byte * y1, byte * u, byte * v, const byte * s0, const byte * s1, int count)
+    {
+        int n = unpack_yuy2_420_simd<avx2_ops>(y0, y1, u, v, s0, s1, count);
+        return count - unpack_yuy2_420_simd<sse_ops>(y0, y1, u, v, s0, s1, n);
+    }
+
+    static const yuy2_unpackers yuy2_avx2 = { "avx2", &unpack_yuy2_avx2<RS_FORMAT_Y8>, &unpack_yuy2_avx2<RS_FORMAT_Y16>,
+        &unpack_yuy2_avx2<RS_FORMAT_RGB8>, &unpack_yuy2_avx2<RS_FORMAT_RGBA8>, &unpack_yuy2_avx2<RS_FORMAT_BGR8>, &unpack_yuy2_avx2<RS_FORMAT_BGRA8>, &unpack_yuy2_420_avx2 };
+
+    const yuy2_unpackers * get_yuy2_unpackers_avx2() { return &yuy2_avx2; }
+
+    // Demosaics 32 pixels per step, and the last 16 pixels of an odd number of steps with 128 bit registers
+    template<rs_format FORMAT, bool CORRECTED> int demosaic_steps_avx2(byte * out, const uint16_t * const rows[5], int count, bool red_row, bool sites_even)
+    {
+        const int x = demosaic_row_simd<avx2_ops, FORMAT, CORRECTED>(out, rows, 0, count, red_row, sites_even);
+        return demosaic_row_simd<sse_ops, FORMAT, CORRECTED>(out, rows, x, count, red_row, sites_even);
+    }
+
+    template<rs_format FORMAT> int demosaic_row_avx2(byte * out, const uint16_t * const rows[5], int count, bool red_row, bool sites_even, bool corrected)
+    {
+        return corrected ? demosaic_steps_avx2<FORMAT, true>(out, rows, count, red_row, sites_even) : demosaic_steps_avx2<FORMAT, false>(out, rows, count, red_row, sites_even);
+    }
+
+    static const bayer_demosaicers bayer_avx2 = { "avx2", &demosaic_row_avx2<RS_FORMAT_RGB8>, &demosaic_row_avx2<RS_FORMAT_Y16> };
+
+    const bayer_demosaicers * get_bayer_demosaicers_avx2() { return &bayer_avx2; }
+
+    // Gathers the colors of eight pixels at once. Their 24 bytes are written as two overlapping 16 byte stores, the second of which reaches
+    // 4 bytes into the next two pixels, so the last pixels are left to the caller.
+    static int colorize_depth_avx2(byte * rgb, const uint16_t * pixels, int count, const uint32_t * lut)
+    {
+        const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        int i = 0;
+        for(; i + 10 <= count; i += 8)
+        {
+            const __m256i index = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + i)));
+            const __m256i colors = _mm256_shuffle_epi8(_mm256_i32gather_epi32(reinterpret_cast<const int *>(lut), index, 4), pack);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(rgb + i * 3), _mm256_castsi256_si128(colors));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(rgb + i * 3 + 12), _mm256_extracti128_si256(colors, 1));
+        }
+        return i;
+    }
+
+    depth_colorizer get_depth_colorizer_avx2() { return &colorize_depth_avx2; }
+
+    static const projection_kernels projection_avx2 = { &project_points_simd<avx_float_ops, false>, &project_points_simd<avx_float_ops, true>,
+        &deproject_pixels_simd<avx_float_ops, false>, &deproject_pixels_simd<avx_float_ops, true>, &transform_points_simd<avx_float_ops> };
+
+    const projection_kernels * get_projection_kernels_avx2() { return &projection_avx2; }
+#else
+    const yuy2_unpackers * get_yuy2_unpackers_avx2() { return nullptr; }
+    const bayer_demosaicers * get_bayer_demosaicers_avx2() { return nullptr; }
+    depth_colorizer get_depth_colorizer_avx2() { return nullptr; }
+    const projection_kernels * get_projection_kernels_avx2() { return nullptr; }
+#endif
+}
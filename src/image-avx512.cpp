@@ -0,0 +1,51 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "image-simd.h"
+
+namespace rsimpl
+{
+#if defined(RS_SIMD_HAVE_AVX512BW) && defined(RS_SIMD_HAVE_AVX2)
+    // Unpacks 64 pixels per step, and finishes the remaining 16 to 48 pixels with narrower registers
+    template<rs_format FORMAT> void unpack_yuy2_avx512bw(byte * const d [], const byte * s, int n)
+    {
+        assert(n % 16 == 0);
+        byte * dst = d[0];
+        n = unpack_yuy2_simd<avx512bw_ops, FORMAT>(dst, s, n);
+        n = unpack_yuy2_simd<avx2_ops, FORMAT>(dst, s, n);
+        unpack_yuy2_simd<sse_ops, FORMAT>(dst, s, n);
+    }
+
+    static int unpack_yuy2_420_avx512bw(byte * y0, byte * y1, byte * u, byte * v, const byte * s0, const byte * s1, int count)
+    {
+        int n = unpack_yuy2_420_simd<avx512bw_ops>(y0, y1, u, v, s0, s1, count);
+        n = unpack_yuy2_420_simd<avx2_ops>(y0, y1, u, v, s0, s1, n);
+        return count - unpack_yuy2_420_simd<sse_ops>(y0, y1, u, v, s0, s1, n);
+    }
+
+    static const yuy2_unpackers yuy2_avx512bw = { "avx512bw", &unpack_yuy2_avx512bw<RS_FORMAT_Y8>, &unpack_yuy2_avx512bw<RS_FORMAT_Y16>,
+        &unpack_yuy2_avx512bw<RS_FORMAT_RGB8>, &unpack_yuy2_avx512bw<RS_FORMAT_RGBA8>, &unpack_yuy2_avx512bw<RS_FORMAT_BGR8>, &unpack_yuy2_avx512bw<RS_FORMAT_BGRA8>, &unpack_yuy2_420_avx512bw };
+
+    const yuy2_unpackers * get_yuy2_unpackers_avx512bw() { return &yuy2_avx512bw; }
+
+    // Demosaics 64 pixels per step, and finishes the remaining 16 to 48 pixels with narrower registers
+    template<rs_format FORMAT, bool CORRECTED> int demosaic_steps_avx512bw(byte * out, const uint16_t * const rows[5], int count, bool red_row, bool sites_even)
+    {
+        int x = demosaic_row_simd<avx512bw_ops, FORMAT, CORRECTED>(out, rows, 0, count, red_row, sites_even);
+        x = demosaic_row_simd<avx2_ops, FORMAT, CORRECTED>(out, rows, x, count, red_row, sites_even);
+        return demosaic_row_simd<sse_ops, FORMAT, CORRECTED>(out, rows, x, count, red_row, sites_even);
+    }
+
+    template<rs_format FORMAT> int demosaic_row_avx512bw(byte * out, const uint16_t * const rows[5], int count, bool red_row, bool sites_even, bool corrected)
+    {
+        return corrected ? demosaic_steps_avx512bw<FORMAT, true>(out, rows, count, red_row, sites_even) : demosaic_steps_avx512bw<FORMAT, false>(out, rows, count, red_row, sites_even);
+    }
+
+    static const bayer_demosaicers bayer_avx512bw = { "avx512bw", &demosaic_row_avx512bw<RS_FORMAT_RGB8>, &demosaic_row_avx512bw<RS_FORMAT_Y16> };
+
+    const bayer_demosaicers * get_bayer_demosaicers_avx512bw() { return &bayer_avx512bw; }
+#else
+    const yuy2_unpackers * get_yuy2_unpackers_avx512bw() { return nullptr; }
+    const bayer_demosaicers * get_bayer_demosaicers_avx512bw() { return nullptr; }
+#endif
+}
@@ -0,0 +1,168 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "image-simd.h"
+
+namespace rsimpl
+{
+#ifdef RS_SIMD_HAVE_NEON
+    // Computes 8 clamped R, G and B values using the same fixed-point arithmetic as the SSSE3 kernel. vqdmulhq_s16(a, b) returns
+    // (2 * a * b) >> 16, so (c << 4, 298 << 3) yields exactly what _mm_mulhi_epi16(c << 4, 298 << 4) does on x86.
+    static void yuy2_to_rgb8(int16x8_t c16, int16x8_t d16, int16x8_t e16, uint8x8_t & r, uint8x8_t & g, uint8x8_t & b)
+    {
+        const int16x8_t c298 = vqdmulhq_s16(c16, vdupq_n_s16(298 << 3));
+        r = vqmovun_s16(vaddq_s16(c298, vqdmulhq_s16(e16, vdupq_n_s16(409 << 3))));
+        g = vqmovun_s16(vsubq_s16(vsubq_s16(c298, vqdmulhq_s16(d16, vdupq_n_s16(100 << 3))), vqdmulhq_s16(e16, vdupq_n_s16(208 << 3))));
+        b = vqmovun_s16(vaddq_s16(c298, vqdmulhq_s16(d16, vdupq_n_s16(516 << 3))));
+    }
+
+    static int16x8_t centered_x16(uint8x8_t x, int16_t center) { return vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(x)), vdupq_n_s16(center)), 4); }
+
+    static uint8x16_t interleave(uint8x8_t evens, uint8x8_t odds) { const uint8x8x2_t z = vzip_u8(evens, odds); return vcombine_u8(z.val[0], z.val[1]); }
+
+    template<rs_format FORMAT> void unpack_yuy2_neon(byte * const d [], const byte * s, int n)
+    {
+        assert(n % 16 == 0);
+        uint8_t * dst = d[0];
+        for(; n; n -= 16, s += 32)
+        {
+            if(FORMAT == RS_FORMAT_Y8 || FORMAT == RS_FORMAT_Y16)
+            {
+                const uint8x16x2_t yuv = vld2q_u8(s); // Y in the even bytes, U/V in the odd bytes
+                if(FORMAT == RS_FORMAT_Y8)
+                {
+                    vst1q_u8(dst, yuv.val[0]);
+                    dst += 16;
+                }
+                else
+                {
+                    const uint8x16x2_t y16 = {{ vdupq_n_u8(0), yuv.val[0] }}; // Y << 8
+                    vst2q_u8(dst, y16);
+                    dst += 32;
+                }
+                continue;
+            }
+
+            // Deinterleave 8 macropixels into Y of even pixels, U, Y of odd pixels, and V. Both pixels of a macropixel share its U and V.
+            const uint8x8x4_t yuyv = vld4_u8(s);
+            const int16x8_t d16 = centered_x16(yuyv.val[1], 128), e16 = centered_x16(yuyv.val[3], 128);
+            uint8x8_t r0, g0, b0, r1, g1, b1;
+            yuy2_to_rgb8(centered_x16(yuyv.val[0], 16), d16, e16, r0, g0, b0);
+            yuy2_to_rgb8(centered_x16(yuyv.val[2], 16), d16, e16, r1, g1, b1);
+            const uint8x16_t r = interleave(r0, r1), g = interleave(g0, g1), b = interleave(b0, b1);
+
+            if(FORMAT == RS_FORMAT_RGB8)  { const uint8x16x3_t rgb  = {{ r, g, b }};                  vst3q_u8(dst, rgb);  dst += 48; }
+            if(FORMAT == RS_FORMAT_BGR8)  { const uint8x16x3_t bgr  = {{ b, g, r }};                  vst3q_u8(dst, bgr);  dst += 48; }
+            if(FORMAT == RS_FORMAT_RGBA8) { const uint8x16x4_t rgba = {{ r, g, b, vdupq_n_u8(255) }}; vst4q_u8(dst, rgba); dst += 64; }
+            if(FORMAT == RS_FORMAT_BGRA8) { const uint8x16x4_t bgra = {{ b, g, r, vdupq_n_u8(255) }}; vst4q_u8(dst, bgra); dst += 64; }
+        }
+    }
+
+    static int unpack_yuy2_420_neon(byte * y0, byte * y1, byte * u, byte * v, const byte * s0, const byte * s1, int count)
+    {
+        int n = count;
+        for(; n >= 32; n -= 32, s0 += 64, s1 += 64)
+        {
+            // Deinterleave 16 macropixels of each row, whose Y components are stored back in order, and whose U and V are averaged over both rows
+            const uint8x16x4_t a = vld4q_u8(s0), b = vld4q_u8(s1);
+            const uint8x16x2_t ya = {{ a.val[0], a.val[2] }}, yb = {{ b.val[0], b.val[2] }};
+            vst2q_u8(y0, ya);
+            vst2q_u8(y1, yb);
+            y0 += 32;
+            y1 += 32;
+
+            const uint8x16_t cu = vrhaddq_u8(a.val[1], b.val[1]), cv = vrhaddq_u8(a.val[3], b.val[3]);
+            if(!v)
+            {
+                const uint8x16x2_t uv = {{ cu, cv }};
+                vst2q_u8(u, uv);
+                u += 32;
+            }
+            else
+            {
+                vst1q_u8(u, cu);
+                vst1q_u8(v, cv);
+                u += 16;
+                v += 16;
+            }
+        }
+        return count - n;
+    }
+
+    static const yuy2_unpackers yuy2_neon = { "neon", &unpack_yuy2_neon<RS_FORMAT_Y8>, &unpack_yuy2_neon<RS_FORMAT_Y16>,
+        &unpack_yuy2_neon<RS_FORMAT_RGB8>, &unpack_yuy2_neon<RS_FORMAT_RGBA8>, &unpack_yuy2_neon<RS_FORMAT_BGR8>, &unpack_yuy2_neon<RS_FORMAT_BGRA8>, &unpack_yuy2_420_neon };
+
+    const yuy2_unpackers * get_yuy2_unpackers_neon() { return &yuy2_neon; }
+
+    // Demosaics 16 pixels per step with the arithmetic of demosaic_row_simd. vqrdmulhq_s16(a, b) returns (2 * a * b + (1 << 15)) >> 16,
+    // which is what _mm_mulhrs_epi16(a, b) returns on x86, and vrshrq_n_s16(a, 4) rounds as (a + 8) >> 4 does.
+    template<rs_format FORMAT, bool CORRECTED> int demosaic_steps_neon(byte * out, const uint16_t * const rows[5], int count, bool red_row, bool sites_even)
+    {
+        static const uint16_t even_sites[8] = { 0xffff, 0, 0xffff, 0, 0xffff, 0, 0xffff, 0 }, odd_sites[8] = { 0, 0xffff, 0, 0xffff, 0, 0xffff, 0, 0xffff };
+        const uint16x8_t sites = vld1q_u16(sites_even ? even_sites : odd_sites);
+        const int16x8_t zero = vdupq_n_s16(0), max10 = vdupq_n_s16(1023);
+        int x = 0;
+        for(; x + 16 <= count; x += 16)
+        {
+            int16x8_t r[2], g[2], b[2];
+            for(int k = 0; k < 2; ++k)
+            {
+                auto at = [&](int row, int dx) { return vreinterpretq_s16_u16(vld1q_u16(rows[row] + x + k * 8 + dx)); };
+                const int16x8_t c = at(2, 0), h1 = vaddq_s16(at(2, -1), at(2, 1)), v1 = vaddq_s16(at(1, 0), at(3, 0));
+                const int16x8_t diag = vaddq_s16(vaddq_s16(at(1, -1), at(1, 1)), vaddq_s16(at(3, -1), at(3, 1)));
+                int16x8_t cross = vshlq_n_s16(vaddq_s16(h1, v1), 2), across = vshlq_n_s16(h1, 3), down = vshlq_n_s16(v1, 3), diagonal = vshlq_n_s16(diag, 2);
+                if(CORRECTED)
+                {
+                    const int16x8_t h2 = vaddq_s16(at(2, -2), at(2, 2)), v2 = vaddq_s16(at(0, 0), at(4, 0)), axial = vaddq_s16(h2, v2);
+                    const int16x8_t c10 = vmulq_n_s16(c, 10), diag2 = vshlq_n_s16(diag, 1);
+                    cross = vsubq_s16(vaddq_s16(cross, vshlq_n_s16(c, 3)), vshlq_n_s16(axial, 1));
+                    across = vaddq_s16(vsubq_s16(vsubq_s16(vaddq_s16(across, c10), diag2), vshlq_n_s16(h2, 1)), v2);
+                    down = vaddq_s16(vsubq_s16(vsubq_s16(vaddq_s16(down, c10), diag2), vshlq_n_s16(v2, 1)), h2);
+                    diagonal = vsubq_s16(vaddq_s16(diagonal, vmulq_n_s16(c, 12)), vmulq_n_s16(axial, 3));
+                }
+                auto finish = [&](int16x8_t v) { return vminq_s16(max10, vmaxq_s16(zero, vrshrq_n_s16(v, 4))); };
+                cross = finish(cross);
+                across = finish(across);
+                down = finish(down);
+                diagonal = finish(diagonal);
+
+                g[k] = vbslq_s16(sites, cross, c);
+                r[k] = red_row ? vbslq_s16(sites, c, across) : vbslq_s16(sites, diagonal, down);
+                b[k] = red_row ? vbslq_s16(sites, diagonal, down) : vbslq_s16(sites, c, across);
+            }
+
+            if(FORMAT == RS_FORMAT_Y16)
+            {
+                for(int k = 0; k < 2; ++k)
+                {
+                    const int16x8_t luma = vaddq_s16(vaddq_s16(vqrdmulhq_s16(vshlq_n_s16(r[k], 3), vdupq_n_s16(77 << 4)), vqrdmulhq_s16(vshlq_n_s16(g[k], 3), vdupq_n_s16(150 << 4))),
+                                                     vqrdmulhq_s16(vshlq_n_s16(b[k], 3), vdupq_n_s16(29 << 4)));
+                    vst1q_u16(reinterpret_cast<uint16_t *>(out) + k * 8, vshlq_n_u16(vreinterpretq_u16_s16(luma), 6));
+                }
+                out += 32;
+            }
+            else
+            {
+                const uint8x16x3_t rgb = {{ vcombine_u8(vqmovun_s16(vshrq_n_s16(r[0], 2)), vqmovun_s16(vshrq_n_s16(r[1], 2))),
+                                            vcombine_u8(vqmovun_s16(vshrq_n_s16(g[0], 2)), vqmovun_s16(vshrq_n_s16(g[1], 2))),
+                                            vcombine_u8(vqmovun_s16(vshrq_n_s16(b[0], 2)), vqmovun_s16(vshrq_n_s16(b[1], 2))) }};
+                vst3q_u8(out, rgb);
+                out += 48;
+            }
+        }
+        return x;
+    }
+
+    template<rs_format FORMAT> int demosaic_row_neon(byte * out, const uint16_t * const rows[5], int count, bool red_row, bool sites_even, bool corrected)
+    {
+        return corrected ? demosaic_steps_neon<FORMAT, true>(out, rows, count, red_row, sites_even) : demosaic_steps_neon<FORMAT, false>(out, rows, count, red_row, sites_even);
+    }
+
+    static const bayer_demosaicers bayer_neon = { "neon", &demosaic_row_neon<RS_FORMAT_RGB8>, &demosaic_row_neon<RS_FORMAT_Y16> };
+
+    const bayer_demosaicers * get_bayer_demosaicers_neon() { return &bayer_neon; }
+#else
+    const yuy2_unpackers * get_yuy2_unpackers_neon() { return nullptr; }
+    const bayer_demosaicers * get_bayer_demosaicers_neon() { return nullptr; }
+#endif
+}
@@ -0,0 +1,819 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+// Shared body of the vectorized unpackers. On x86, every instruction set gets its own translation unit, built with the
+// matching code generation flags, which instantiates the YUY2 kernel below with its own register width. All shuffles and
+// unpacks operate within 128 bit lanes, so a wider register simply runs one copy of the SSSE3 algorithm per lane.
+// Everything here has internal linkage, so that instantiations built with different flags are never merged by the linker.
+// On ARM, NEON is a property of the whole build, so its kernels are plain inline functions used directly by image.cpp.
+#pragma once
+#ifndef LIBREALSENSE_IMAGE_SIMD_H
+#define LIBREALSENSE_IMAGE_SIMD_H
+
+#include "image.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define RS_SIMD_MSVC_X86 // MSVC exposes every intrinsic regardless of /arch
+#endif
+
+#if defined(__SSSE3__) || defined(RS_SIMD_MSVC_X86)
+#define RS_SIMD_HAVE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#if defined(__AVX2__) || defined(RS_SIMD_MSVC_X86)
+#define RS_SIMD_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX512BW__) || (defined(RS_SIMD_MSVC_X86) && _MSC_VER >= 1910)
+#define RS_SIMD_HAVE_AVX512BW
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RS_SIMD_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef RS_SIMD_HAVE_NEON
+namespace rsimpl
+{
+    namespace neon
+    {
+        // Each kernel converts one block of 16 pixels, and produces exactly the same output as the portable code in image.cpp
+        inline void unpack_y16_from_y8(uint16_t * out, const byte * in)
+        {
+            const uint8x16_t y = vld1q_u8(in);
+            const uint8x16x2_t yy = {{ y, y }}; // pixel | pixel << 8
+            vst2q_u8(reinterpret_cast<uint8_t *>(out), yy);
+        }
+
+        inline void unpack_y16_from_y16_10(uint16_t * out, const byte * in)
+        {
+            auto src = reinterpret_cast<const uint16_t *>(in);
+            vst1q_u16(out, vshlq_n_u16(vld1q_u16(src), 6));
+            vst1q_u16(out + 8, vshlq_n_u16(vld1q_u16(src + 8), 6));
+        }
+
+        inline void unpack_y8_from_y16_10(uint8_t * out, const byte * in)
+        {
+            auto src = reinterpret_cast<const uint16_t *>(in);
+            vst1q_u8(out, vcombine_u8(vshrn_n_u16(vld1q_u16(src), 2), vshrn_n_u16(vld1q_u16(src + 8), 2)));
+        }
+
+        inline void unpack_y8_y8_from_y8i(uint8_t * left, uint8_t * right, const byte * in)
+        {
+            const uint8x16x2_t lr = vld2q_u8(in);
+            vst1q_u8(left, lr.val[0]);
+            vst1q_u8(right, lr.val[1]);
+        }
+
+        inline void pack_y8_from_stride_2(uint8_t * out, const byte * in)
+        {
+            vst1q_u8(out, vld2q_u8(in).val[0]);
+        }
+
+        // Blends 8 pairs of horizontal blends with weights out of 64, rounding off 12 bits
+        inline uint16x8_t blend_rows(uint16x8_t top, uint16x8_t bottom, uint8x8_t w, uint8x8_t ow)
+        {
+            const uint16x8_t w16 = vmovl_u8(w), ow16 = vmovl_u8(ow);
+            const uint32x4_t lo = vmlal_u16(vmull_u16(vget_low_u16(top), vget_low_u16(ow16)), vget_low_u16(bottom), vget_low_u16(w16));
+            const uint32x4_t hi = vmlal_u16(vmull_u16(vget_high_u16(top), vget_high_u16(ow16)), vget_high_u16(bottom), vget_high_u16(w16));
+            return vcombine_u16(vrshrn_n_u32(lo, 12), vrshrn_n_u32(hi, 12));
+        }
+
+        // Bilinear samples of 16 pixels from their gathered 2x2 neighbours, see remap_fisheye_image
+        inline void blend_bilinear(uint8_t * out, const uint8_t * p00, const uint8_t * p01, const uint8_t * p10, const uint8_t * p11, const uint8_t * wx, const uint8_t * wy)
+        {
+            const uint8x16_t one = vdupq_n_u8(64), x = vld1q_u8(wx), y = vld1q_u8(wy), ox = vsubq_u8(one, x), oy = vsubq_u8(one, y);
+            const uint8x16_t a = vld1q_u8(p00), b = vld1q_u8(p01), c = vld1q_u8(p10), d = vld1q_u8(p11);
+            const uint16x8_t top_lo = vmlal_u8(vmull_u8(vget_low_u8(a), vget_low_u8(ox)), vget_low_u8(b), vget_low_u8(x));
+            const uint16x8_t top_hi = vmlal_u8(vmull_u8(vget_high_u8(a), vget_high_u8(ox)), vget_high_u8(b), vget_high_u8(x));
+            const uint16x8_t bottom_lo = vmlal_u8(vmull_u8(vget_low_u8(c), vget_low_u8(ox)), vget_low_u8(d), vget_low_u8(x));
+            const uint16x8_t bottom_hi = vmlal_u8(vmull_u8(vget_high_u8(c), vget_high_u8(ox)), vget_high_u8(d), vget_high_u8(x));
+            vst1q_u8(out, vcombine_u8(vqmovn_u16(blend_rows(top_lo, bottom_lo, vget_low_u8(y), vget_low_u8(oy))),
+                                      vqmovn_u16(blend_rows(top_hi, bottom_hi, vget_high_u8(y), vget_high_u8(oy)))));
+        }
+
+        // Widens 10 bit values to 16 bits as v << 6 | v >> 4, discarding any bits shifted out of the top
+        inline uint16x8_t widen_10_to_16(uint16x8_t v) { return vorrq_u16(vshlq_n_u16(v, 6), vshrq_n_u16(v, 4)); }
+
+        inline void unpack_y16_y16_from_y12i_10(uint16_t * left, uint16_t * right, const byte * in)
+        {
+            const uint8x16x3_t p = vld3q_u8(in); // Bytes of each pixel are rl, ll << 4 | rh, lh
+            const uint8x16_t rh = vandq_u8(p.val[1], vdupq_n_u8(0x0f)), ll = vshrq_n_u8(p.val[1], 4);
+            vst1q_u16(left,      widen_10_to_16(vorrq_u16(vshll_n_u8(vget_low_u8 (p.val[2]), 4), vmovl_u8(vget_low_u8 (ll)))));
+            vst1q_u16(left + 8,  widen_10_to_16(vorrq_u16(vshll_n_u8(vget_high_u8(p.val[2]), 4), vmovl_u8(vget_high_u8(ll)))));
+            vst1q_u16(right,     widen_10_to_16(vorrq_u16(vshll_n_u8(vget_low_u8 (rh), 8), vmovl_u8(vget_low_u8 (p.val[0])))));
+            vst1q_u16(right + 8, widen_10_to_16(vorrq_u16(vshll_n_u8(vget_high_u8(rh), 8), vmovl_u8(vget_high_u8(p.val[0])))));
+        }
+
+        inline void unpack_y8_y8_from_y12i_10(uint8_t * left, uint8_t * right, const byte * in)
+        {
+            const uint8x16x3_t p = vld3q_u8(in);
+            const uint8x16_t rh = vandq_u8(p.val[1], vdupq_n_u8(0x0f)), ll = vshrq_n_u8(p.val[1], 4);
+            vst1q_u8(left,  vcombine_u8(vshrn_n_u16(vorrq_u16(vshll_n_u8(vget_low_u8 (p.val[2]), 4), vmovl_u8(vget_low_u8 (ll))), 2),
+                                        vshrn_n_u16(vorrq_u16(vshll_n_u8(vget_high_u8(p.val[2]), 4), vmovl_u8(vget_high_u8(ll))), 2)));
+            vst1q_u8(right, vcombine_u8(vshrn_n_u16(vorrq_u16(vshll_n_u8(vget_low_u8 (rh), 8), vmovl_u8(vget_low_u8 (p.val[0]))), 2),
+                                        vshrn_n_u16(vorrq_u16(vshll_n_u8(vget_high_u8(rh), 8), vmovl_u8(vget_high_u8(p.val[0]))), 2)));
+        }
+
+        inline void unpack_z16_y8_from_f200_inzi(uint16_t * z, uint8_t * y, const byte * in)
+        {
+            const uint8x16x3_t p = vld3q_u8(in); // Bytes of each pixel are z16 low, z16 high, y8
+            const uint8x16x2_t zz = {{ p.val[0], p.val[1] }};
+            vst2q_u8(reinterpret_cast<uint8_t *>(z), zz);
+            vst1q_u8(y, p.val[2]);
+        }
+
+        inline void unpack_z16_y16_from_f200_inzi(uint16_t * z, uint16_t * y, const byte * in)
+        {
+            const uint8x16x3_t p = vld3q_u8(in);
+            const uint8x16x2_t zz = {{ p.val[0], p.val[1] }}, yy = {{ p.val[2], p.val[2] }};
+            vst2q_u8(reinterpret_cast<uint8_t *>(z), zz);
+            vst2q_u8(reinterpret_cast<uint8_t *>(y), yy);
+        }
+    }
+}
+#endif
+
+#ifdef RS_SIMD_HAVE_SSSE3
+namespace rsimpl
+{
+    namespace
+    {
+        // Block kernels for image.cpp with the same contract as the NEON ones. They live in an unnamed namespace because the
+        // AVX2/AVX-512 translation units include this header too, and must not lend their instantiations to the SSSE3 build.
+        namespace ssse3
+        {
+            // Splits 8 Y12I pixels into their left and right 12 bit values. The left value is the upper 12 bits of the
+            // little-endian word at byte 1 of a pixel, the right value the lower 12 bits of the word at byte 0.
+            inline void split_y12i(__m128i & left, __m128i & right, const byte * in)
+            {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));      // Pixels 0-4
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 8));  // Pixels 3-7, from byte 1
+                const __m128i r = _mm_unpacklo_epi64(_mm_shuffle_epi8(a, _mm_setr_epi8(0,1, 3,4, 6,7, 9,10, -1,-1,-1,-1,-1,-1,-1,-1)),
+                                                     _mm_shuffle_epi8(b, _mm_setr_epi8(4,5, 7,8, 10,11, 13,14, -1,-1,-1,-1,-1,-1,-1,-1)));
+                const __m128i l = _mm_unpacklo_epi64(_mm_shuffle_epi8(a, _mm_setr_epi8(1,2, 4,5, 7,8, 10,11, -1,-1,-1,-1,-1,-1,-1,-1)),
+                                                     _mm_shuffle_epi8(b, _mm_setr_epi8(5,6, 8,9, 11,12, 14,15, -1,-1,-1,-1,-1,-1,-1,-1)));
+                left = _mm_srli_epi16(l, 4);
+                right = _mm_and_si128(r, _mm_set1_epi16(0x0fff));
+            }
+
+            // Widens 10 bit values to 16 bits as v << 6 | v >> 4, discarding any bits shifted out of the top
+            inline __m128i widen_10_to_16(__m128i v) { return _mm_or_si128(_mm_slli_epi16(v, 6), _mm_srli_epi16(v, 4)); }
+
+            // Narrows 10 bit values to 8 bits as v >> 2, truncating rather than saturating like the portable code
+            inline __m128i narrow_10_to_8(__m128i lo, __m128i hi)
+            {
+                const __m128i mask = _mm_set1_epi16(0xff);
+                return _mm_packus_epi16(_mm_and_si128(_mm_srli_epi16(lo, 2), mask), _mm_and_si128(_mm_srli_epi16(hi, 2), mask));
+            }
+
+            inline void unpack_y16_from_y16_10(uint16_t * out, const byte * in)
+            {
+                auto src = reinterpret_cast<const __m128i *>(in);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_slli_epi16(_mm_loadu_si128(src), 6));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8), _mm_slli_epi16(_mm_loadu_si128(src + 1), 6));
+            }
+
+            inline void unpack_y8_from_y16_10(uint8_t * out, const byte * in)
+            {
+                auto src = reinterpret_cast<const __m128i *>(in);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out), narrow_10_to_8(_mm_loadu_si128(src), _mm_loadu_si128(src + 1)));
+            }
+
+            inline void unpack_y8_y8_from_y8i(uint8_t * left, uint8_t * right, const byte * in)
+            {
+                auto src = reinterpret_cast<const __m128i *>(in);
+                const __m128i a = _mm_loadu_si128(src), b = _mm_loadu_si128(src + 1), mask = _mm_set1_epi16(0xff);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(left), _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(right), _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+            }
+
+            inline void pack_y8_from_stride_2(uint8_t * out, const byte * in)
+            {
+                auto src = reinterpret_cast<const __m128i *>(in);
+                const __m128i mask = _mm_set1_epi16(0xff);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(_mm_and_si128(_mm_loadu_si128(src), mask), _mm_and_si128(_mm_loadu_si128(src + 1), mask)));
+            }
+
+            // Blends 8 pairs of horizontal blends with 16 bit weights out of 64, rounding off 12 bits
+            inline __m128i blend_rows(__m128i top, __m128i bottom, __m128i w)
+            {
+                const __m128i ow = _mm_sub_epi16(_mm_set1_epi16(64), w), round = _mm_set1_epi32(1 << 11);
+                const __m128i lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(top, bottom), _mm_unpacklo_epi16(ow, w)), round), 12);
+                const __m128i hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(top, bottom), _mm_unpackhi_epi16(ow, w)), round), 12);
+                return _mm_packs_epi32(lo, hi);
+            }
+
+            // Bilinear samples of 16 pixels from their gathered 2x2 neighbours. Pixels are unsigned and weights at most 64, so maddubs never saturates.
+            inline void blend_bilinear(uint8_t * out, const uint8_t * p00, const uint8_t * p01, const uint8_t * p10, const uint8_t * p11, const uint8_t * wx, const uint8_t * wy)
+            {
+                auto load = [](const uint8_t * p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); };
+                const __m128i x = load(wx), y = load(wy), ox = _mm_sub_epi8(_mm_set1_epi8(64), x), zero = _mm_setzero_si128();
+                const __m128i a = load(p00), b = load(p01), c = load(p10), d = load(p11);
+                const __m128i wlo = _mm_unpacklo_epi8(ox, x), whi = _mm_unpackhi_epi8(ox, x);
+                const __m128i top_lo = _mm_maddubs_epi16(_mm_unpacklo_epi8(a, b), wlo), top_hi = _mm_maddubs_epi16(_mm_unpackhi_epi8(a, b), whi);
+                const __m128i bottom_lo = _mm_maddubs_epi16(_mm_unpacklo_epi8(c, d), wlo), bottom_hi = _mm_maddubs_epi16(_mm_unpackhi_epi8(c, d), whi);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(blend_rows(top_lo, bottom_lo, _mm_unpacklo_epi8(y, zero)),
+                                                                                    blend_rows(top_hi, bottom_hi, _mm_unpackhi_epi8(y, zero))));
+            }
+
+            inline void unpack_y16_y16_from_y12i_10(uint16_t * left, uint16_t * right, const byte * in)
+            {
+                __m128i l0, r0, l1, r1;
+                split_y12i(l0, r0, in);
+                split_y12i(l1, r1, in + 24);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(left), widen_10_to_16(l0));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(left + 8), widen_10_to_16(l1));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(right), widen_10_to_16(r0));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(right + 8), widen_10_to_16(r1));
+            }
+
+            inline void unpack_y8_y8_from_y12i_10(uint8_t * left, uint8_t * right, const byte * in)
+            {
+                __m128i l0, r0, l1, r1;
+                split_y12i(l0, r0, in);
+                split_y12i(l1, r1, in + 24);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(left), narrow_10_to_8(l0, l1));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(right), narrow_10_to_8(r0, r1));
+            }
+        }
+
+        // Each register holds 16 * lanes bytes. Lane l of the two source registers of a step holds pixels [16l, 16l+16), and
+        // lane l of every output register belongs to the same block of 16 pixels, in the same order the SSSE3 kernel produces them.
+        struct sse_ops
+        {
+            typedef __m128i reg;
+            enum { lanes = 1 };
+
+            static reg load(const byte * src, int i) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(src) + i); }
+            static void store(byte * dst, const reg * r, int count) { for (int k = 0; k < count; ++k) _mm_storeu_si128(reinterpret_cast<__m128i *>(dst) + k, r[k]); }
+            static reg broadcast(__m128i pattern) { return pattern; }
+            static reg set1_epi8(char x) { return _mm_set1_epi8(x); }
+            static reg set1_epi16(short x) { return _mm_set1_epi16(x); }
+            static reg shuffle_epi8(reg a, reg b) { return _mm_shuffle_epi8(a, b); }
+            static reg unpacklo_epi8(reg a, reg b) { return _mm_unpacklo_epi8(a, b); }
+            static reg unpackhi_epi8(reg a, reg b) { return _mm_unpackhi_epi8(a, b); }
+            static reg unpacklo_epi16(reg a, reg b) { return _mm_unpacklo_epi16(a, b); }
+            static reg unpackhi_epi16(reg a, reg b) { return _mm_unpackhi_epi16(a, b); }
+            static reg unpackhi_epi32(reg a, reg b) { return _mm_unpackhi_epi32(a, b); }
+            template<int N> static reg alignr_epi8(reg a, reg b) { return _mm_alignr_epi8(a, b, N); }
+            template<int N> static reg slli_epi16(reg a) { return _mm_slli_epi16(a, N); }
+            static reg add_epi16(reg a, reg b) { return _mm_add_epi16(a, b); }
+            static reg sub_epi16(reg a, reg b) { return _mm_sub_epi16(a, b); }
+            static reg subs_epi16(reg a, reg b) { return _mm_subs_epi16(a, b); }
+            static reg mulhi_epi16(reg a, reg b) { return _mm_mulhi_epi16(a, b); }
+            static reg min_epi16(reg a, reg b) { return _mm_min_epi16(a, b); }
+            static reg max_epi16(reg a, reg b) { return _mm_max_epi16(a, b); }
+            static reg avg_epu8(reg a, reg b) { return _mm_avg_epu8(a, b); }
+            template<int N> static reg srai_epi16(reg a) { return _mm_srai_epi16(a, N); }
+            static reg mullo_epi16(reg a, reg b) { return _mm_mullo_epi16(a, b); }
+            static reg mulhrs_epi16(reg a, reg b) { return _mm_mulhrs_epi16(a, b); }
+            static reg select(reg mask, reg a, reg b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); } // a where mask is set, b elsewhere
+            static void store_halves(byte * lo, byte * hi, reg r) // The low 8 bytes of lane l to lo + 8l, its high 8 bytes to hi + 8l
+            {
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(lo), r);
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(hi), _mm_unpackhi_epi64(r, r));
+            }
+        };
+
+#ifdef RS_SIMD_HAVE_AVX2
+        struct avx2_ops
+        {
+            typedef __m256i reg;
+            enum { lanes = 2 };
+
+            static reg load(const byte * src, int i)
+            {
+                auto s = reinterpret_cast<const __m128i *>(src);
+                return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(s + i)), _mm_loadu_si128(s + 2 + i), 1);
+            }
+            static void store(byte * dst, const reg * r, int count)
+            {
+                auto d = reinterpret_cast<__m128i *>(dst);
+                for (int k = 0; k < count; ++k)
+                {
+                    _mm_storeu_si128(d + k, _mm256_castsi256_si128(r[k]));
+                    _mm_storeu_si128(d + count + k, _mm256_extracti128_si256(r[k], 1));
+                }
+            }
+            static reg broadcast(__m128i pattern) { return _mm256_inserti128_si256(_mm256_castsi128_si256(pattern), pattern, 1); }
+            static reg set1_epi8(char x) { return _mm256_set1_epi8(x); }
+            static reg set1_epi16(short x) { return _mm256_set1_epi16(x); }
+            static reg shuffle_epi8(reg a, reg b) { return _mm256_shuffle_epi8(a, b); }
+            static reg unpacklo_epi8(reg a, reg b) { return _mm256_unpacklo_epi8(a, b); }
+            static reg unpackhi_epi8(reg a, reg b) { return _mm256_unpackhi_epi8(a, b); }
+            static reg unpacklo_epi16(reg a, reg b) { return _mm256_unpacklo_epi16(a, b); }
+            static reg unpackhi_epi16(reg a, reg b) { return _mm256_unpackhi_epi16(a, b); }
+            static reg unpackhi_epi32(reg a, reg b) { return _mm256_unpackhi_epi32(a, b); }
+            template<int N> static reg alignr_epi8(reg a, reg b) { return _mm256_alignr_epi8(a, b, N); }
+            template<int N> static reg slli_epi16(reg a) { return _mm256_slli_epi16(a, N); }
+            static reg add_epi16(reg a, reg b) { return _mm256_add_epi16(a, b); }
+            static reg sub_epi16(reg a, reg b) { return _mm256_sub_epi16(a, b); }
+            static reg subs_epi16(reg a, reg b) { return _mm256_subs_epi16(a, b); }
+            static reg mulhi_epi16(reg a, reg b) { return _mm256_mulhi_epi16(a, b); }
+            static reg min_epi16(reg a, reg b) { return _mm256_min_epi16(a, b); }
+            static reg max_epi16(reg a, reg b) { return _mm256_max_epi16(a, b); }
+            static reg avg_epu8(reg a, reg b) { return _mm256_avg_epu8(a, b); }
+            template<int N> static reg srai_epi16(reg a) { return _mm256_srai_epi16(a, N); }
+            static reg mullo_epi16(reg a, reg b) { return _mm256_mullo_epi16(a, b); }
+            static reg mulhrs_epi16(reg a, reg b) { return _mm256_mulhrs_epi16(a, b); }
+            static reg select(reg mask, reg a, reg b) { return _mm256_blendv_epi8(b, a, mask); }
+            static void store_halves(byte * lo, byte * hi, reg r)
+            {
+                sse_ops::store_halves(lo, hi, _mm256_castsi256_si128(r));
+                sse_ops::store_halves(lo + 8, hi + 8, _mm256_extracti128_si256(r, 1));
+            }
+        };
+#endif
+
+#ifdef RS_SIMD_HAVE_AVX512BW
+        struct avx512bw_ops
+        {
+            typedef __m512i reg;
+            enum { lanes = 4 };
+
+            static reg load(const byte * src, int i)
+            {
+                auto s = reinterpret_cast<const __m128i *>(src);
+                reg r = _mm512_castsi128_si512(_mm_loadu_si128(s + i));
+                r = _mm512_inserti32x4(r, _mm_loadu_si128(s + 2 + i), 1);
+                r = _mm512_inserti32x4(r, _mm_loadu_si128(s + 4 + i), 2);
+                return _mm512_inserti32x4(r, _mm_loadu_si128(s + 6 + i), 3);
+            }
+            static void store(byte * dst, const reg * r, int count)
+            {
+                auto d = reinterpret_cast<__m128i *>(dst);
+                for (int k = 0; k < count; ++k)
+                {
+                    _mm_storeu_si128(d + k, _mm512_castsi512_si128(r[k]));
+                    _mm_storeu_si128(d + count + k, _mm512_extracti32x4_epi32(r[k], 1));
+                    _mm_storeu_si128(d + count * 2 + k, _mm512_extracti32x4_epi32(r[k], 2));
+                    _mm_storeu_si128(d + count * 3 + k, _mm512_extracti32x4_epi32(r[k], 3));
+                }
+            }
+            static reg broadcast(__m128i pattern) { return _mm512_broadcast_i32x4(pattern); }
+            static reg set1_epi8(char x) { return _mm512_set1_epi8(x); }
+            static reg set1_epi16(short x) { return _mm512_set1_epi16(x); }
+            static reg shuffle_epi8(reg a, reg b) { return _mm512_shuffle_epi8(a, b); }
+            static reg unpacklo_epi8(reg a, reg b) { return _mm512_unpacklo_epi8(a, b); }
+            static reg unpackhi_epi8(reg a, reg b) { return _mm512_unpackhi_epi8(a, b); }
+            static reg unpacklo_epi16(reg a, reg b) { return _mm512_unpacklo_epi16(a, b); }
+            static reg unpackhi_epi16(reg a, reg b) { return _mm512_unpackhi_epi16(a, b); }
+            static reg unpackhi_epi32(reg a, reg b) { return _mm512_unpackhi_epi32(a, b); }
+            template<int N> static reg alignr_epi8(reg a, reg b) { return _mm512_alignr_epi8(a, b, N); }
+            template<int N> static reg slli_epi16(reg a) { return _mm512_slli_epi16(a, N); }
+            static reg add_epi16(reg a, reg b) { return _mm512_add_epi16(a, b); }
+            static reg sub_epi16(reg a, reg b) { return _mm512_sub_epi16(a, b); }
+            static reg subs_epi16(reg a, reg b) { return _mm512_subs_epi16(a, b); }
+            static reg mulhi_epi16(reg a, reg b) { return _mm512_mulhi_epi16(a, b); }
+            static reg min_epi16(reg a, reg b) { return _mm512_min_epi16(a, b); }
+            static reg max_epi16(reg a, reg b) { return _mm512_max_epi16(a, b); }
+            static reg avg_epu8(reg a, reg b) { return _mm512_avg_epu8(a, b); }
+            template<int N> static reg srai_epi16(reg a) { return _mm512_srai_epi16(a, N); }
+            static reg mullo_epi16(reg a, reg b) { return _mm512_mullo_epi16(a, b); }
+            static reg mulhrs_epi16(reg a, reg b) { return _mm512_mulhrs_epi16(a, b); }
+            static reg select(reg mask, reg a, reg b) { return _mm512_ternarylogic_epi32(mask, a, b, 0xCA); } // mask ? a : b, bitwise
+            static void store_halves(byte * lo, byte * hi, reg r)
+            {
+                sse_ops::store_halves(lo, hi, _mm512_castsi512_si128(r));
+                sse_ops::store_halves(lo + 8, hi + 8, _mm512_extracti32x4_epi32(r, 1));
+                sse_ops::store_halves(lo + 16, hi + 16, _mm512_extracti32x4_epi32(r, 2));
+                sse_ops::store_halves(lo + 24, hi + 24, _mm512_extracti32x4_epi32(r, 3));
+            }
+        };
+#endif
+
+        // Computes 8 clamped R, G and B values (as 16 bit integers, per lane) from 8 Y and 8 upsampled U and V values
+        template<class V> void yuy2_to_rgb16(typename V::reg y16, typename V::reg u16, typename V::reg v16, typename V::reg & r16, typename V::reg & g16, typename V::reg & b16)
+        {
+            typedef typename V::reg reg;
+            const reg zero = V::set1_epi8(0), n255 = V::set1_epi16(255);
+            const reg n100 = V::set1_epi16(100 << 4), n208 = V::set1_epi16(208 << 4), n298 = V::set1_epi16(298 << 4), n409 = V::set1_epi16(409 << 4), n516 = V::set1_epi16(516 << 4);
+
+            reg c16 = V::template slli_epi16<4>(V::subs_epi16(y16, V::set1_epi16(16)));
+            reg d16 = V::template slli_epi16<4>(V::subs_epi16(u16, V::set1_epi16(128)));
+            reg e16 = V::template slli_epi16<4>(V::subs_epi16(v16, V::set1_epi16(128)));
+            reg c298 = V::mulhi_epi16(c16, n298);
+            r16 = V::min_epi16(n255, V::max_epi16(zero, V::add_epi16(c298, V::mulhi_epi16(e16, n409))));                                   // (298 * c + 409 * e + 128) >> 8
+            g16 = V::min_epi16(n255, V::max_epi16(zero, V::sub_epi16(V::sub_epi16(c298, V::mulhi_epi16(d16, n100)), V::mulhi_epi16(e16, n208)))); // (298 * c - 100 * d - 208 * e + 128) >> 8
+            b16 = V::min_epi16(n255, V::max_epi16(zero, V::add_epi16(c298, V::mulhi_epi16(d16, n516))));                                   // (298 * c + 516 * d + 128) >> 8
+        }
+
+        // Interleaves three channels of 16 pixels (16 bit values, of which only the low byte is kept) and an opaque alpha channel into four registers of four pixels each
+        template<class V> void interleave_abc1(typename V::reg a16__0_7, typename V::reg b16__0_7, typename V::reg c16__0_7,
+                                               typename V::reg a16__8_F, typename V::reg b16__8_F, typename V::reg c16__8_F, typename V::reg out[4])
+        {
+            typedef typename V::reg reg;
+            const reg evens_odds = V::broadcast(_mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15));
+            reg ab8__0_7 = V::unpacklo_epi8(V::shuffle_epi8(a16__0_7, evens_odds), V::shuffle_epi8(b16__0_7, evens_odds));
+            reg c18__0_7 = V::unpacklo_epi8(V::shuffle_epi8(c16__0_7, evens_odds), V::set1_epi8(-1));
+            reg ab8__8_F = V::unpacklo_epi8(V::shuffle_epi8(a16__8_F, evens_odds), V::shuffle_epi8(b16__8_F, evens_odds));
+            reg c18__8_F = V::unpacklo_epi8(V::shuffle_epi8(c16__8_F, evens_odds), V::set1_epi8(-1));
+            out[0] = V::unpacklo_epi16(ab8__0_7, c18__0_7);
+            out[1] = V::unpackhi_epi16(ab8__0_7, c18__0_7);
+            out[2] = V::unpacklo_epi16(ab8__8_F, c18__8_F);
+            out[3] = V::unpackhi_epi16(ab8__8_F, c18__8_F);
+        }
+
+        // Packs the 16 pixels of each lane of four registers of four RGBA or BGRA pixels into their first three registers, without alpha
+        template<class V> void drop_alpha(typename V::reg out[4])
+        {
+            typedef typename V::reg reg;
+
+            // Shuffle rgb triples to the start and end of each register
+            reg rgb0 = V::shuffle_epi8(out[0], V::broadcast(_mm_setr_epi8(  3, 7, 11, 15,   0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14)));
+            reg rgb1 = V::shuffle_epi8(out[1], V::broadcast(_mm_setr_epi8(0, 1, 2, 4,   3, 7, 11, 15,   5, 6, 8, 9, 10, 12, 13, 14)));
+            reg rgb2 = V::shuffle_epi8(out[2], V::broadcast(_mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9,   3, 7, 11, 15,   10, 12, 13, 14)));
+            reg rgb3 = V::shuffle_epi8(out[3], V::broadcast(_mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,   3, 7, 11, 15  )));
+
+            // Align registers
+            out[0] = V::template alignr_epi8<4>(rgb1, rgb0);
+            out[1] = V::template alignr_epi8<8>(rgb2, rgb1);
+            out[2] = V::template alignr_epi8<12>(rgb3, rgb2);
+        }
+
+        // Unpacks as many whole steps of 16 * V::lanes pixels as possible, advancing both pointers, and returns the number of pixels left over
+        template<class V, rs_format FORMAT> int unpack_yuy2_simd(byte * & dst, const byte * & src, int n)
+        {
+            typedef typename V::reg reg;
+            for(; n >= 16 * V::lanes; n -= 16 * V::lanes, src += 32 * V::lanes)
+            {
+                // Load 8 YUY2 pixels each into two 16-byte lanes
+                reg s0 = V::load(src, 0), s1 = V::load(src, 1);
+                reg out[4];
+
+                if(FORMAT == RS_FORMAT_Y8)
+                {
+                    // Align all Y components and output 16 pixels (16 bytes) per lane
+                    reg y0 = V::shuffle_epi8(s0, V::broadcast(_mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15,   0, 2, 4, 6, 8, 10, 12, 14)));
+                    reg y1 = V::shuffle_epi8(s1, V::broadcast(_mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,   1, 3, 5, 7, 9, 11, 13, 15)));
+                    out[0] = V::template alignr_epi8<8>(y1, y0);
+                    V::store(dst, out, 1);
+                    dst += 16 * V::lanes;
+                    continue;
+                }
+
+                // Shuffle all Y components to the low order bytes of the register, and all U/V components to the high order bytes
+                const reg evens_odd1s_odd3s = V::broadcast(_mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 5, 9, 13, 3, 7, 11, 15)); // to get yyyyyyyyuuuuvvvv
+                reg yyyyyyyyuuuuvvvv0 = V::shuffle_epi8(s0, evens_odd1s_odd3s);
+                reg yyyyyyyyuuuuvvvv8 = V::shuffle_epi8(s1, evens_odd1s_odd3s);
+
+                // Retrieve all 16 Y components as 16-bit values (8 components per register)
+                const reg zero = V::set1_epi8(0);
+                reg y16__0_7 = V::unpacklo_epi8(yyyyyyyyuuuuvvvv0, zero);
+                reg y16__8_F = V::unpacklo_epi8(yyyyyyyyuuuuvvvv8, zero);
+
+                if(FORMAT == RS_FORMAT_Y16)
+                {
+                    // Output 16 pixels (32 bytes) per lane
+                    out[0] = V::template slli_epi16<8>(y16__0_7);
+                    out[1] = V::template slli_epi16<8>(y16__8_F);
+                    V::store(dst, out, 2);
+                    dst += 32 * V::lanes;
+                    continue;
+                }
+
+                // Retrieve all 16 U and V components as 16-bit values (8 components per register)
+                reg uv = V::unpackhi_epi32(yyyyyyyyuuuuvvvv0, yyyyyyyyuuuuvvvv8); // uuuuuuuuvvvvvvvv
+                reg u = V::unpacklo_epi8(uv, uv);                                 // uu uu uu uu uu uu uu uu  u's duplicated
+                reg v = V::unpackhi_epi8(uv, uv);                                 // vv vv vv vv vv vv vv vv
+
+                reg r16__0_7, g16__0_7, b16__0_7, r16__8_F, g16__8_F, b16__8_F;
+                yuy2_to_rgb16<V>(y16__0_7, V::unpacklo_epi8(u, zero), V::unpacklo_epi8(v, zero), r16__0_7, g16__0_7, b16__0_7);
+                yuy2_to_rgb16<V>(y16__8_F, V::unpackhi_epi8(u, zero), V::unpackhi_epi8(v, zero), r16__8_F, g16__8_F, b16__8_F);
+
+                // Shuffle separate R, G, B values into four registers storing four pixels each in (R, G, B, A) or (B, G, R, A) order
+                if (FORMAT == RS_FORMAT_RGB8 || FORMAT == RS_FORMAT_RGBA8) interleave_abc1<V>(r16__0_7, g16__0_7, b16__0_7, r16__8_F, g16__8_F, b16__8_F, out);
+                else interleave_abc1<V>(b16__0_7, g16__0_7, r16__0_7, b16__8_F, g16__8_F, r16__8_F, out);
+
+                if(FORMAT == RS_FORMAT_RGBA8 || FORMAT == RS_FORMAT_BGRA8)
+                {
+                    // Store 16 pixels (64 bytes) per lane
+                    V::store(dst, out, 4);
+                    dst += 64 * V::lanes;
+                }
+
+                if(FORMAT == RS_FORMAT_RGB8 || FORMAT == RS_FORMAT_BGR8)
+                {
+                    // Store 16 pixels (48 bytes) per lane
+                    drop_alpha<V>(out);
+                    V::store(dst, out, 3);
+                    dst += 48 * V::lanes;
+                }
+            }
+            return n;
+        }
+
+        // Unpacks as many whole steps of 16 * V::lanes pixels of a pair of rows as possible into their luminance and 4:2:0 chroma, see
+        // yuy2_unpackers::yuv420, advancing every pointer, and returns the number of pixels left over
+        template<class V> int unpack_yuy2_420_simd(byte * & y0, byte * & y1, byte * & u, byte * & v, const byte * & s0, const byte * & s1, int n)
+        {
+            typedef typename V::reg reg;
+            const reg evens_odds = V::broadcast(_mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,   1, 3, 5, 7, 9, 11, 13, 15));     // Y then U/V
+            const reg odds_evens = V::broadcast(_mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15,   0, 2, 4, 6, 8, 10, 12, 14));     // U/V then Y
+            const reg evens_odd1s_odd3s = V::broadcast(_mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,   1, 5, 9, 13, 3, 7, 11, 15)); // Y then U then V
+            for(; n >= 16 * V::lanes; n -= 16 * V::lanes, s0 += 32 * V::lanes, s1 += 32 * V::lanes)
+            {
+                // Load 8 YUY2 pixels of each row into two 16-byte lanes
+                const reg a0 = V::load(s0, 0), a1 = V::load(s0, 1), b0 = V::load(s1, 0), b1 = V::load(s1, 1);
+
+                // Align the Y components of each row as the Y8 kernel does, and output 16 pixels (16 bytes) of both rows per lane
+                reg out = V::template alignr_epi8<8>(V::shuffle_epi8(a1, evens_odds), V::shuffle_epi8(a0, odds_evens));
+                V::store(y0, &out, 1);
+                out = V::template alignr_epi8<8>(V::shuffle_epi8(b1, evens_odds), V::shuffle_epi8(b0, odds_evens));
+                V::store(y1, &out, 1);
+                y0 += 16 * V::lanes;
+                y1 += 16 * V::lanes;
+
+                // Average the rows, whose U and V components of the same pixels are then those of the 4:2:0 image
+                const reg c0 = V::avg_epu8(a0, b0), c1 = V::avg_epu8(a1, b1);
+                if(!v)
+                {
+                    // Align the U/V components the way Y components are, and output 8 UV pairs (16 bytes) per lane
+                    out = V::template alignr_epi8<8>(V::shuffle_epi8(c1, odds_evens), V::shuffle_epi8(c0, evens_odds));
+                    V::store(u, &out, 1);
+                    u += 16 * V::lanes;
+                }
+                else
+                {
+                    // Gather 8 U components in the low half of each lane and 8 V components in its high half, and output them (8 bytes each) per lane
+                    out = V::unpackhi_epi32(V::shuffle_epi8(c0, evens_odd1s_odd3s), V::shuffle_epi8(c1, evens_odd1s_odd3s));
+                    V::store_halves(u, v, out);
+                    u += 8 * V::lanes;
+                    v += 8 * V::lanes;
+                }
+            }
+            return n;
+        }
+
+        // Demosaics as many whole steps of 16 * V::lanes pixels of a row of an RGGB image as possible from pixel x on, which must be even, see
+        // bayer_demosaicers, and returns the first pixel left. Loads are unaligned, so each lane reads its pixels and their neighbours straight out of the padded rows.
+        template<class V, rs_format FORMAT, bool CORRECTED> int demosaic_row_simd(byte * row, const uint16_t * const rows[5], int x, int count, bool red_row, bool sites_even)
+        {
+            typedef typename V::reg reg;
+            const reg sites = V::broadcast(sites_even ? _mm_setr_epi16(-1, 0, -1, 0, -1, 0, -1, 0) : _mm_setr_epi16(0, -1, 0, -1, 0, -1, 0, -1)); // Lanes start on even pixels
+            const reg zero = V::set1_epi8(0), max10 = V::set1_epi16(1023), half = V::set1_epi16(8);
+            byte * out = row + x * (FORMAT == RS_FORMAT_Y16 ? 2 : 3);
+            for(; x + 16 * V::lanes <= count; x += 16 * V::lanes)
+            {
+                reg r[2], g[2], b[2];
+                for(int k = 0; k < 2; ++k)
+                {
+                    auto at = [&](int row, int dx) { return V::load(reinterpret_cast<const byte *>(rows[row] + x + dx), k); };
+                    const reg c = at(2, 0), h1 = V::add_epi16(at(2, -1), at(2, 1)), v1 = V::add_epi16(at(1, 0), at(3, 0));
+                    const reg diag = V::add_epi16(V::add_epi16(at(1, -1), at(1, 1)), V::add_epi16(at(3, -1), at(3, 1)));
+
+                    // Every filter scaled by 16: the missing color at a site (cross), and at a green pixel from its row (across) and column (down)
+                    reg cross = V::template slli_epi16<2>(V::add_epi16(h1, v1)), across = V::template slli_epi16<3>(h1), down = V::template slli_epi16<3>(v1), diagonal = V::template slli_epi16<2>(diag);
+                    if(CORRECTED)
+                    {
+                        // Malvar-He-Cutler: each estimate is corrected by the Laplacian of the color known at the pixel
+                        const reg h2 = V::add_epi16(at(2, -2), at(2, 2)), v2 = V::add_epi16(at(0, 0), at(4, 0)), axial = V::add_epi16(h2, v2);
+                        const reg c10 = V::mullo_epi16(c, V::set1_epi16(10)), diag2 = V::template slli_epi16<1>(diag);
+                        cross = V::sub_epi16(V::add_epi16(cross, V::template slli_epi16<3>(c)), V::template slli_epi16<1>(axial));
+                        across = V::add_epi16(V::sub_epi16(V::sub_epi16(V::add_epi16(across, c10), diag2), V::template slli_epi16<1>(h2)), v2);
+                        down = V::add_epi16(V::sub_epi16(V::sub_epi16(V::add_epi16(down, c10), diag2), V::template slli_epi16<1>(v2)), h2);
+                        diagonal = V::sub_epi16(V::add_epi16(diagonal, V::mullo_epi16(c, V::set1_epi16(12))), V::mullo_epi16(axial, V::set1_epi16(3)));
+                    }
+                    auto finish = [&](reg v) { return V::min_epi16(max10, V::max_epi16(zero, V::template srai_epi16<4>(V::add_epi16(v, half)))); };
+                    cross = finish(cross);
+                    across = finish(across);
+                    down = finish(down);
+                    diagonal = finish(diagonal);
+
+                    g[k] = V::select(sites, cross, c);
+                    r[k] = red_row ? V::select(sites, c, across) : V::select(sites, diagonal, down);
+                    b[k] = red_row ? V::select(sites, diagonal, down) : V::select(sites, c, across);
+                }
+
+                if(FORMAT == RS_FORMAT_Y16)
+                {
+                    // BT.601 luma of the 10 bit colors, rounded as the scalar code rounds it, and output 16 pixels (32 bytes) per lane
+                    reg y[2];
+                    for(int k = 0; k < 2; ++k)
+                    {
+                        const reg luma = V::add_epi16(V::add_epi16(V::mulhrs_epi16(V::template slli_epi16<3>(r[k]), V::set1_epi16(77 << 4)),
+                                                                   V::mulhrs_epi16(V::template slli_epi16<3>(g[k]), V::set1_epi16(150 << 4))),
+                                                      V::mulhrs_epi16(V::template slli_epi16<3>(b[k]), V::set1_epi16(29 << 4)));
+                        y[k] = V::template slli_epi16<6>(luma);
+                    }
+                    V::store(out, y, 2);
+                    out += 32 * V::lanes;
+                }
+                else
+                {
+                    // Keep the upper 8 bits of every color, and output 16 pixels (48 bytes) per lane
+                    reg rgb[4];
+                    interleave_abc1<V>(V::template srai_epi16<2>(r[0]), V::template srai_epi16<2>(g[0]), V::template srai_epi16<2>(b[0]),
+                                       V::template srai_epi16<2>(r[1]), V::template srai_epi16<2>(g[1]), V::template srai_epi16<2>(b[1]), rgb);
+                    drop_alpha<V>(rgb);
+                    V::store(out, rgb, 3);
+                    out += 48 * V::lanes;
+                }
+            }
+            return x;
+        }
+    }
+}
+#endif
+
+
+#if defined(RS_SIMD_HAVE_SSSE3) || (defined(RS_SIMD_HAVE_NEON) && defined(__aarch64__))
+namespace rsimpl
+{
+    namespace
+    {
+        // Float registers of V::width points, loaded from and stored to arrays of interleaved pixels (x, y) or points (x, y, z)
+#ifdef RS_SIMD_HAVE_SSSE3
+        struct sse_float_ops
+        {
+            typedef __m128 reg;
+            enum { width = 4 };
+
+            static reg set1(float f) { return _mm_set1_ps(f); }
+            static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+            static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+            static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+            static reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+            static reg load(const float * p) { return _mm_loadu_ps(p); }
+            static void load_xy(const float * p, reg & x, reg & y)
+            {
+                const reg a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 4);
+                x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+                y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            }
+            static void store_xy(float * p, reg x, reg y)
+            {
+                _mm_storeu_ps(p, _mm_unpacklo_ps(x, y));
+                _mm_storeu_ps(p + 4, _mm_unpackhi_ps(x, y));
+            }
+            // The last point is read and written from one float before it, so that nothing past the points is touched
+            static void load_xyz(const float * p, reg & x, reg & y, reg & z)
+            {
+                reg a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 3), c = _mm_loadu_ps(p + 6), d = _mm_loadu_ps(p + 8);
+                d = _mm_shuffle_ps(d, d, _MM_SHUFFLE(3, 3, 2, 1));
+                _MM_TRANSPOSE4_PS(a, b, c, d);
+                x = a; y = b; z = c;
+            }
+            static void store_xyz(float * p, reg x, reg y, reg z)
+            {
+                reg a = x, b = y, c = z, d = _mm_setzero_ps();
+                _MM_TRANSPOSE4_PS(a, b, c, d);
+                _mm_storeu_ps(p, a);
+                _mm_storeu_ps(p + 3, b);
+                _mm_storeu_ps(p + 6, c);
+                _mm_storeu_ps(p + 8, _mm_move_ss(_mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 1, 0, 0)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(2, 2, 2, 2))));
+            }
+        };
+#endif
+
+#ifdef RS_SIMD_HAVE_AVX2
+        // Every half goes through the SSE loads and stores, which keeps the points of a register in order without crossing lanes
+        struct avx_float_ops
+        {
+            typedef __m256 reg;
+            enum { width = 8 };
+
+            static reg join(__m128 lo, __m128 hi) { return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1); }
+            static reg set1(float f) { return _mm256_set1_ps(f); }
+            static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+            static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+            static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+            static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+            static reg load(const float * p) { return _mm256_loadu_ps(p); }
+            static void load_xy(const float * p, reg & x, reg & y)
+            {
+                __m128 x0, y0, x1, y1;
+                sse_float_ops::load_xy(p, x0, y0);
+                sse_float_ops::load_xy(p + 8, x1, y1);
+                x = join(x0, x1); y = join(y0, y1);
+            }
+            static void store_xy(float * p, reg x, reg y)
+            {
+                sse_float_ops::store_xy(p, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y));
+                sse_float_ops::store_xy(p + 8, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1));
+            }
+            static void load_xyz(const float * p, reg & x, reg & y, reg & z)
+            {
+                __m128 x0, y0, z0, x1, y1, z1;
+                sse_float_ops::load_xyz(p, x0, y0, z0);
+                sse_float_ops::load_xyz(p + 12, x1, y1, z1);
+                x = join(x0, x1); y = join(y0, y1); z = join(z0, z1);
+            }
+            static void store_xyz(float * p, reg x, reg y, reg z)
+            {
+                sse_float_ops::store_xyz(p, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+                sse_float_ops::store_xyz(p + 12, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+            }
+        };
+#endif
+
+#if defined(RS_SIMD_HAVE_NEON) && defined(__aarch64__)
+        // Vector division is only part of NEON on AArch64
+        struct neon_float_ops
+        {
+            typedef float32x4_t reg;
+            enum { width = 4 };
+
+            static reg set1(float f) { return vdupq_n_f32(f); }
+            static reg add(reg a, reg b) { return vaddq_f32(a, b); }
+            static reg sub(reg a, reg b) { return vsubq_f32(a, b); }
+            static reg mul(reg a, reg b) { return vmulq_f32(a, b); }
+            static reg div(reg a, reg b) { return vdivq_f32(a, b); }
+            static reg load(const float * p) { return vld1q_f32(p); }
+            static void load_xy(const float * p, reg & x, reg & y) { const float32x4x2_t xy = vld2q_f32(p); x = xy.val[0]; y = xy.val[1]; }
+            static void store_xy(float * p, reg x, reg y) { const float32x4x2_t xy = {{ x, y }}; vst2q_f32(p, xy); }
+            static void load_xyz(const float * p, reg & x, reg & y, reg & z) { const float32x4x3_t xyz = vld3q_f32(p); x = xyz.val[0]; y = xyz.val[1]; z = xyz.val[2]; }
+            static void store_xyz(float * p, reg x, reg y, reg z) { const float32x4x3_t xyz = {{ x, y, z }}; vst3q_f32(p, xyz); }
+        };
+#endif
+
+        // The kernels below handle as many whole steps of V::width points as there are, and return the number of points they handled. Every
+        // multiply and add is a separate instruction, in the order of the functions of rsutil.h, so that the results match theirs exactly.
+
+        // Radial and tangential distortion, as rs_project_point_to_pixel applies it and rs_deproject_pixel_to_point takes it away
+        template<class V> void brown_conrady(typename V::reg & x, typename V::reg & y, const float coeffs[5], bool tangential_after_radial)
+        {
+            typedef typename V::reg reg;
+            const reg k0 = V::set1(coeffs[0]), k1 = V::set1(coeffs[1]), k2 = V::set1(coeffs[2]), k3 = V::set1(coeffs[3]), k4 = V::set1(coeffs[4]);
+            const reg k2x2 = V::set1(2 * coeffs[2]), k3x2 = V::set1(2 * coeffs[3]), one = V::set1(1), two = V::set1(2);
+            const reg r2 = V::add(V::mul(x, x), V::mul(y, y));
+            const reg f = V::add(V::add(V::add(one, V::mul(k0, r2)), V::mul(V::mul(k1, r2), r2)), V::mul(V::mul(V::mul(k4, r2), r2), r2));
+            if(tangential_after_radial)
+            {
+                x = V::mul(x, f);
+                y = V::mul(y, f);
+                const reg dx = V::add(V::add(x, V::mul(V::mul(k2x2, x), y)), V::mul(k3, V::add(r2, V::mul(V::mul(two, x), x))));
+                const reg dy = V::add(V::add(y, V::mul(V::mul(k3x2, x), y)), V::mul(k2, V::add(r2, V::mul(V::mul(two, y), y))));
+                x = dx;
+                y = dy;
+            }
+            else
+            {
+                const reg ux = V::add(V::add(V::mul(x, f), V::mul(V::mul(k2x2, x), y)), V::mul(k3, V::add(r2, V::mul(V::mul(two, x), x))));
+                const reg uy = V::add(V::add(V::mul(y, f), V::mul(V::mul(k3x2, x), y)), V::mul(k2, V::add(r2, V::mul(V::mul(two, y), y))));
+                x = ux;
+                y = uy;
+            }
+        }
+
+        template<class V, bool DISTORTED> int project_points_simd(float * pixels, const rs_intrinsics & intrin, const float * points, int count)
+        {
+            typedef typename V::reg reg;
+            const reg fx = V::set1(intrin.fx), fy = V::set1(intrin.fy), ppx = V::set1(intrin.ppx), ppy = V::set1(intrin.ppy);
+            int i = 0;
+            for(; i + V::width <= count; i += V::width)
+            {
+                reg px, py, pz;
+                V::load_xyz(points + i * 3, px, py, pz);
+                reg x = V::div(px, pz), y = V::div(py, pz);
+                if(DISTORTED) brown_conrady<V>(x, y, intrin.coeffs, true);
+                V::store_xy(pixels + i * 2, V::add(V::mul(x, fx), ppx), V::add(V::mul(y, fy), ppy));
+            }
+            return i;
+        }
+
+        template<class V, bool DISTORTED> int deproject_pixels_simd(float * points, const rs_intrinsics & intrin, const float * pixels, const float * depths, int count)
+        {
+            typedef typename V::reg reg;
+            const reg fx = V::set1(intrin.fx), fy = V::set1(intrin.fy), ppx = V::set1(intrin.ppx), ppy = V::set1(intrin.ppy);
+            int i = 0;
+            for(; i + V::width <= count; i += V::width)
+            {
+                reg u, v;
+                V::load_xy(pixels + i * 2, u, v);
+                reg x = V::div(V::sub(u, ppx), fx), y = V::div(V::sub(v, ppy), fy);
+                if(DISTORTED) brown_conrady<V>(x, y, intrin.coeffs, false);
+                const reg depth = V::load(depths + i);
+                V::store_xyz(points + i * 3, V::mul(depth, x), V::mul(depth, y), depth);
+            }
+            return i;
+        }
+
+        template<class V> int transform_points_simd(float * to_points, const rs_extrinsics & extrin, const float * from_points, int count)
+        {
+            typedef typename V::reg reg;
+            const float * r = extrin.rotation, * t = extrin.translation;
+            const reg r0 = V::set1(r[0]), r1 = V::set1(r[1]), r2 = V::set1(r[2]), r3 = V::set1(r[3]), r4 = V::set1(r[4]);
+            const reg r5 = V::set1(r[5]), r6 = V::set1(r[6]), r7 = V::set1(r[7]), r8 = V::set1(r[8]);
+            const reg t0 = V::set1(t[0]), t1 = V::set1(t[1]), t2 = V::set1(t[2]);
+            int i = 0;
+            for(; i + V::width <= count; i += V::width)
+            {
+                reg x, y, z;
+                V::load_xyz(from_points + i * 3, x, y, z);
+                V::store_xyz(to_points + i * 3, V::add(V::add(V::add(V::mul(r0, x), V::mul(r3, y)), V::mul(r6, z)), t0),
+                                                V::add(V::add(V::add(V::mul(r1, x), V::mul(r4, y)), V::mul(r7, z)), t1),
+                                                V::add(V::add(V::add(V::mul(r2, x), V::mul(r5, y)), V::mul(r8, z)), t2));
+            }
+            return i;
+        }
+    }
+}
+#endif
+
+#endif
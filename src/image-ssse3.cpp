@@ -0,0 +1,38 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "image-simd.h"
+
+namespace rsimpl
+{
+#ifdef RS_SIMD_HAVE_SSSE3
+    template<rs_format FORMAT> void unpack_yuy2_ssse3(byte * const d [], const byte * s, int n)
+    {
+        assert(n % 16 == 0);
+        byte * dst = d[0];
+        unpack_yuy2_simd<sse_ops, FORMAT>(dst, s, n);
+    }
+
+    static int unpack_yuy2_420_ssse3(byte * y0, byte * y1, byte * u, byte * v, const byte * s0, const byte * s1, int count)
+    {
+        return count - unpack_yuy2_420_simd<sse_ops>(y0, y1, u, v, s0, s1, count);
+    }
+
+    static const yuy2_unpackers yuy2_ssse3 = { "ssse3", &unpack_yuy2_ssse3<RS_FORMAT_Y8>, &unpack_yuy2_ssse3<RS_FORMAT_Y16>,
+        &unpack_yuy2_ssse3<RS_FORMAT_RGB8>, &unpack_yuy2_ssse3<RS_FORMAT_RGBA8>, &unpack_yuy2_ssse3<RS_FORMAT_BGR8>, &unpack_yuy2_ssse3<RS_FORMAT_BGRA8>, &unpack_yuy2_420_ssse3 };
+
+    const yuy2_unpackers * get_yuy2_unpackers_ssse3() { return &yuy2_ssse3; }
+
+    template<rs_format FORMAT> int demosaic_row_ssse3(byte * out, const uint16_t * const rows[5], int count, bool red_row, bool sites_even, bool corrected)
+    {
+        return corrected ? demosaic_row_simd<sse_ops, FORMAT, true>(out, rows, 0, count, red_row, sites_even) : demosaic_row_simd<sse_ops, FORMAT, false>(out, rows, 0, count, red_row, sites_even);
+    }
+
+    static const bayer_demosaicers bayer_ssse3 = { "ssse3", &demosaic_row_ssse3<RS_FORMAT_RGB8>, &demosaic_row_ssse3<RS_FORMAT_Y16> };
+
+    const bayer_demosaicers * get_bayer_demosaicers_ssse3() { return &bayer_ssse3; }
+#else
+    const yuy2_unpackers * get_yuy2_unpackers_ssse3() { return nullptr; }
+    const bayer_demosaicers * get_bayer_demosaicers_ssse3() { return nullptr; }
+#endif
+}
@@ -1,14 +1,24 @@
 // License: Apache 2.0. See LICENSE file in root directory.
 // Copyright(c) 2015 Intel Corporation. All Rights Reserved.
 
-#include "image.h"
+#include "image-simd.h"
+#include "pipeline.h" // For get_shared_parallel_pool
 #include "../include/librealsense/rsutil.h" // For projection/deprojection logic
 
 #include <cstring> // For memcpy
 #include <cmath>
 #include <algorithm>
+#include <limits>
+#include <utility> // For std::declval
+#include <mutex>
 #ifdef __SSSE3__
-#include <tmmintrin.h> // For SSE3 intrinsic used in unpack_yuy2_sse
+#include <tmmintrin.h> // For SSE3 intrinsic used in unpack_rw10_from_rw8
+#endif
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h> // For __cpuid and _xgetbv
+#include <immintrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
 #endif
 
 #pragma pack(push, 1) // All structs in this file are assumed to be byte-packed
@@ -23,6 +33,8 @@ namespace rsimpl
     {
         if (format == RS_FORMAT_YUYV) assert(width % 2 == 0);
         if (format == RS_FORMAT_RAW10) assert(width % 4 == 0);
+        if (is_yuv420(format)) return width * height + 2 * ((width + 1) / 2) * ((height + 1) / 2); // The luminance plane, then the chroma of every 2x2 pixels
+        if (format == RS_FORMAT_XYZ32F_PLANAR) return width * height * 3 * sizeof(float);
         return width * height * get_image_bpp(format) / 8;
     }
 
@@ -43,6 +55,12 @@ namespace rsimpl
         case RS_FORMAT_RAW10: return 10;
         case RS_FORMAT_RAW16: return 16;
         case RS_FORMAT_RAW8: return 8;
+        case RS_FORMAT_XYZ16F: return 6 * 8;
+        case RS_FORMAT_XYZ16: return 6 * 8;
+        case RS_FORMAT_XYZUV32F: return 20 * 8;
+        case RS_FORMAT_NV12: return 8; // Of the luminance plane, which the rows of the image stride over
+        case RS_FORMAT_I420: return 8;
+        case RS_FORMAT_XYZ32F_PLANAR: return 32; // Of each plane
         default: assert(false); return 0;
         }
     }
@@ -60,15 +78,33 @@ namespace rsimpl
         memcpy(dest[0], source, (5 * (count/4)));
     }
 
-    template<class SOURCE, class UNPACK> void unpack_pixels(byte * const dest[], int count, const SOURCE * source, UNPACK unpack)
+#ifdef RS_SIMD_HAVE_NEON
+#define NEON_BLOCK(KERNEL) &neon::KERNEL
+#else
+#define NEON_BLOCK(KERNEL) nullptr
+#endif
+
+// For kernels which also have an SSSE3 version in image-simd.h
+#if defined(RS_SIMD_HAVE_NEON)
+#define SIMD_BLOCK(KERNEL) &neon::KERNEL
+#elif defined(RS_SIMD_HAVE_SSSE3)
+#define SIMD_BLOCK(KERNEL) &ssse3::KERNEL
+#else
+#define SIMD_BLOCK(KERNEL) nullptr
+#endif
+
+    // If a block kernel is available, it converts all whole blocks of 16 pixels, and the per-pixel function only handles the remainder
+    template<class SOURCE, class UNPACK> void unpack_pixels(byte * const dest[], int count, const SOURCE * source, UNPACK unpack,
+                                                           void(*block)(decltype(std::declval<UNPACK>()(SOURCE())) * out, const byte * in))
     {
         auto out = reinterpret_cast<decltype(unpack(SOURCE())) *>(dest[0]);
+        if(block) for(; count >= 16; count -= 16, source += 16, out += 16) block(out, reinterpret_cast<const byte *>(source));
         for(int i=0; i<count; ++i) *out++ = unpack(*source++);
     }
 
-    void unpack_y16_from_y8    (byte * const d[], const byte * s, int n) { unpack_pixels(d, n, reinterpret_cast<const uint8_t  *>(s), [](uint8_t  pixel) -> uint16_t { return pixel | pixel << 8; }); }
-    void unpack_y16_from_y16_10(byte * const d[], const byte * s, int n) { unpack_pixels(d, n, reinterpret_cast<const uint16_t *>(s), [](uint16_t pixel) -> uint16_t { return pixel << 6; }); }
-    void unpack_y8_from_y16_10 (byte * const d[], const byte * s, int n) { unpack_pixels(d, n, reinterpret_cast<const uint16_t *>(s), [](uint16_t pixel) -> uint8_t  { return pixel >> 2; }); }
+    void unpack_y16_from_y8    (byte * const d[], const byte * s, int n) { unpack_pixels(d, n, reinterpret_cast<const uint8_t  *>(s), [](uint8_t  pixel) -> uint16_t { return pixel | pixel << 8; }, NEON_BLOCK(unpack_y16_from_y8)); }
+    void unpack_y16_from_y16_10(byte * const d[], const byte * s, int n) { unpack_pixels(d, n, reinterpret_cast<const uint16_t *>(s), [](uint16_t pixel) -> uint16_t { return pixel << 6; }, SIMD_BLOCK(unpack_y16_from_y16_10)); }
+    void unpack_y8_from_y16_10 (byte * const d[], const byte * s, int n) { unpack_pixels(d, n, reinterpret_cast<const uint16_t *>(s), [](uint16_t pixel) -> uint8_t  { return pixel >> 2; }, SIMD_BLOCK(unpack_y8_from_y16_10)); }
     void unpack_rw10_from_rw8 (byte *  const d[], const byte * s, int n)
     {
 #ifdef __SSSE3__
@@ -90,7 +126,11 @@ namespace rsimpl
         unsigned short* from = (unsigned short*)s;
         byte* to = d[0];
 
-        for(int i = 0; i < n; ++i)
+        int i = 0;
+#ifdef RS_SIMD_HAVE_NEON
+        for(; i + 16 <= n; i += 16, from += 16, to += 16) neon::unpack_y8_from_y16_10(to, reinterpret_cast<const byte *>(from));
+#endif
+        for(; i < n; ++i)
         {
           byte temp = (byte)(*from >> 2);
           *to = temp;
@@ -104,154 +144,26 @@ namespace rsimpl
     // YUY2 unpacking routines //
     /////////////////////////////
     
+    // Each product is truncated separately, exactly like the 16 bit multiply-high of the vectorized kernels, so every variant agrees bit for bit
+    static void yuy2_to_rgb(int y, int u, int v, uint8_t & r, uint8_t & g, uint8_t & b)
+    {
+        int32_t c = y - 16;
+        int32_t d = u - 128;
+        int32_t e = v - 128;
+
+        int32_t t;
+        #define clamp(x)  ((t=(x)) > 255 ? 255 : t < 0 ? 0 : t)
+        r = clamp(((298 * c) >> 8)                    + ((409 * e) >> 8));
+        g = clamp(((298 * c) >> 8) - ((100 * d) >> 8) - ((208 * e) >> 8));
+        b = clamp(((298 * c) >> 8) + ((516 * d) >> 8));
+        #undef clamp
+    }
+
     // This templated function unpacks YUY2 into Y8/Y16/RGB8/RGBA8/BGR8/BGRA8, depending on the compile-time parameter FORMAT.
-    // It is expected that all branching outside of the loop control variable will be removed due to constant-folding.
-    template<rs_format FORMAT> void unpack_yuy2(byte * const d [], const byte * s, int n)
+    // It is the portable fallback for the vectorized variants in image-ssse3.cpp, image-avx2.cpp, image-avx512.cpp and image-neon.cpp.
+    template<rs_format FORMAT> void unpack_yuy2_scalar(byte * const d [], const byte * s, int n)
     {
         assert(n % 16 == 0); // All currently supported color resolutions are multiples of 16 pixels. Could easily extend support to other resolutions by copying final n<16 pixels into a zero-padded buffer and recursively calling self for final iteration.
-#ifdef __SSSE3__
-        auto src = reinterpret_cast<const __m128i *>(s);
-        auto dst = reinterpret_cast<__m128i *>(d[0]);
-        for(; n; n -= 16)
-        {
-            const __m128i zero = _mm_set1_epi8(0);
-            const __m128i n100 = _mm_set1_epi16(100 << 4);
-            const __m128i n208 = _mm_set1_epi16(208 << 4);
-            const __m128i n298 = _mm_set1_epi16(298 << 4);
-            const __m128i n409 = _mm_set1_epi16(409 << 4);
-            const __m128i n516 = _mm_set1_epi16(516 << 4);
-            const __m128i evens_odds = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);            
-
-            // Load 8 YUY2 pixels each into two 16-byte registers
-            __m128i s0 = _mm_loadu_si128(src++);
-            __m128i s1 = _mm_loadu_si128(src++);
-
-            if(FORMAT == RS_FORMAT_Y8)
-            {   
-                // Align all Y components and output 16 pixels (16 bytes) at once
-                __m128i y0 = _mm_shuffle_epi8(s0, _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15,   0, 2, 4, 6, 8, 10, 12, 14));
-                __m128i y1 = _mm_shuffle_epi8(s1, _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,   1, 3, 5, 7, 9, 11, 13, 15));
-                _mm_storeu_si128(dst++, _mm_alignr_epi8(y0, y1, 8));
-                continue;
-            }
-
-            // Shuffle all Y components to the low order bytes of the register, and all U/V components to the high order bytes
-            const __m128i evens_odd1s_odd3s = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 5, 9, 13, 3, 7, 11, 15); // to get yyyyyyyyuuuuvvvv
-            __m128i yyyyyyyyuuuuvvvv0 = _mm_shuffle_epi8(s0, evens_odd1s_odd3s);
-            __m128i yyyyyyyyuuuuvvvv8 = _mm_shuffle_epi8(s1, evens_odd1s_odd3s);
-
-            // Retrieve all 16 Y components as 16-bit values (8 components per register))
-            __m128i y16__0_7 = _mm_unpacklo_epi8(yyyyyyyyuuuuvvvv0, zero);         // convert to 16 bit
-            __m128i y16__8_F = _mm_unpacklo_epi8(yyyyyyyyuuuuvvvv8, zero);         // convert to 16 bit
-
-            if(FORMAT == RS_FORMAT_Y16)
-            {      
-                // Output 16 pixels (32 bytes) at once
-                _mm_storeu_si128(dst++, _mm_slli_epi16(y16__0_7, 8));
-                _mm_storeu_si128(dst++, _mm_slli_epi16(y16__8_F, 8));
-                continue;
-            }
-
-            // Retrieve all 16 U and V components as 16-bit values (8 components per register)
-            __m128i uv = _mm_unpackhi_epi32(yyyyyyyyuuuuvvvv0, yyyyyyyyuuuuvvvv8); // uuuuuuuuvvvvvvvv
-            __m128i u = _mm_unpacklo_epi8(uv, uv);                                 //  uu uu uu uu uu uu uu uu  u's duplicated
-            __m128i v = _mm_unpackhi_epi8(uv, uv);                                 //  vv vv vv vv vv vv vv vv            
-            __m128i u16__0_7 = _mm_unpacklo_epi8(u, zero);                         // convert to 16 bit
-            __m128i u16__8_F = _mm_unpackhi_epi8(u, zero);                         // convert to 16 bit
-            __m128i v16__0_7 = _mm_unpacklo_epi8(v, zero);                         // convert to 16 bit
-            __m128i v16__8_F = _mm_unpackhi_epi8(v, zero);                         // convert to 16 bit
-
-            // Compute R, G, B values for first 8 pixels
-            __m128i c16__0_7 = _mm_slli_epi16(_mm_subs_epi16(y16__0_7, _mm_set1_epi16(16)), 4);
-            __m128i d16__0_7 = _mm_slli_epi16(_mm_subs_epi16(u16__0_7, _mm_set1_epi16(128)), 4); // perhaps could have done these u,v to d,e before the duplication
-            __m128i e16__0_7 = _mm_slli_epi16(_mm_subs_epi16(v16__0_7, _mm_set1_epi16(128)), 4);
-            __m128i r16__0_7 = _mm_min_epi16(_mm_set1_epi16(255), _mm_max_epi16(zero, ((_mm_add_epi16(_mm_mulhi_epi16(c16__0_7, n298), _mm_mulhi_epi16(e16__0_7, n409))))));                                                 // (298 * c + 409 * e + 128) ; //
-            __m128i g16__0_7 = _mm_min_epi16(_mm_set1_epi16(255), _mm_max_epi16(zero, ((_mm_sub_epi16(_mm_sub_epi16(_mm_mulhi_epi16(c16__0_7, n298), _mm_mulhi_epi16(d16__0_7, n100)), _mm_mulhi_epi16(e16__0_7, n208)))))); // (298 * c - 100 * d - 208 * e + 128)
-            __m128i b16__0_7 = _mm_min_epi16(_mm_set1_epi16(255), _mm_max_epi16(zero, ((_mm_add_epi16(_mm_mulhi_epi16(c16__0_7, n298), _mm_mulhi_epi16(d16__0_7, n516))))));                                                 // clampbyte((298 * c + 516 * d + 128) >> 8);
-
-            // Compute R, G, B values for second 8 pixels
-            __m128i c16__8_F = _mm_slli_epi16(_mm_subs_epi16(y16__8_F, _mm_set1_epi16(16)), 4);
-            __m128i d16__8_F = _mm_slli_epi16(_mm_subs_epi16(u16__8_F, _mm_set1_epi16(128)), 4); // perhaps could have done these u,v to d,e before the duplication
-            __m128i e16__8_F = _mm_slli_epi16(_mm_subs_epi16(v16__8_F, _mm_set1_epi16(128)), 4);           
-            __m128i r16__8_F = _mm_min_epi16(_mm_set1_epi16(255), _mm_max_epi16(zero, ((_mm_add_epi16(_mm_mulhi_epi16(c16__8_F, n298), _mm_mulhi_epi16(e16__8_F, n409))))));                                                 // (298 * c + 409 * e + 128) ; //
-            __m128i g16__8_F = _mm_min_epi16(_mm_set1_epi16(255), _mm_max_epi16(zero, ((_mm_sub_epi16(_mm_sub_epi16(_mm_mulhi_epi16(c16__8_F, n298), _mm_mulhi_epi16(d16__8_F, n100)), _mm_mulhi_epi16(e16__8_F, n208)))))); // (298 * c - 100 * d - 208 * e + 128)
-            __m128i b16__8_F = _mm_min_epi16(_mm_set1_epi16(255), _mm_max_epi16(zero, ((_mm_add_epi16(_mm_mulhi_epi16(c16__8_F, n298), _mm_mulhi_epi16(d16__8_F, n516))))));                                                 // clampbyte((298 * c + 516 * d + 128) >> 8);
-
-            if (FORMAT == RS_FORMAT_RGB8 || FORMAT == RS_FORMAT_RGBA8)
-            {
-                // Shuffle separate R, G, B values into four registers storing four pixels each in (R, G, B, A) order
-                __m128i rg8__0_7 = _mm_unpacklo_epi8(_mm_shuffle_epi8(r16__0_7, evens_odds), _mm_shuffle_epi8(g16__0_7, evens_odds)); // hi to take the odds which are the upper bytes we care about
-                __m128i ba8__0_7 = _mm_unpacklo_epi8(_mm_shuffle_epi8(b16__0_7, evens_odds), _mm_set1_epi8(-1));
-                __m128i rgba_0_3 = _mm_unpacklo_epi16(rg8__0_7, ba8__0_7);
-                __m128i rgba_4_7 = _mm_unpackhi_epi16(rg8__0_7, ba8__0_7);
-
-                __m128i rg8__8_F = _mm_unpacklo_epi8(_mm_shuffle_epi8(r16__8_F, evens_odds), _mm_shuffle_epi8(g16__8_F, evens_odds)); // hi to take the odds which are the upper bytes we care about
-                __m128i ba8__8_F = _mm_unpacklo_epi8(_mm_shuffle_epi8(b16__8_F, evens_odds), _mm_set1_epi8(-1));
-                __m128i rgba_8_B = _mm_unpacklo_epi16(rg8__8_F, ba8__8_F);
-                __m128i rgba_C_F = _mm_unpackhi_epi16(rg8__8_F, ba8__8_F);
-
-                if(FORMAT == RS_FORMAT_RGBA8)
-                {
-                    // Store 16 pixels (64 bytes) at once
-                    _mm_storeu_si128(dst++, rgba_0_3);
-                    _mm_storeu_si128(dst++, rgba_4_7);
-                    _mm_storeu_si128(dst++, rgba_8_B);
-                    _mm_storeu_si128(dst++, rgba_C_F);
-                }
-
-                if(FORMAT == RS_FORMAT_RGB8)
-                {
-                    // Shuffle rgb triples to the start and end of each register
-                    __m128i rgb0 = _mm_shuffle_epi8(rgba_0_3, _mm_setr_epi8(  3, 7, 11, 15,   0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14));
-                    __m128i rgb1 = _mm_shuffle_epi8(rgba_4_7, _mm_setr_epi8(0, 1, 2, 4,   3, 7, 11, 15,   5, 6, 8, 9, 10, 12, 13, 14));
-                    __m128i rgb2 = _mm_shuffle_epi8(rgba_8_B, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9,   3, 7, 11, 15,   10, 12, 13, 14));
-                    __m128i rgb3 = _mm_shuffle_epi8(rgba_C_F, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,   3, 7, 11, 15  ));
-
-                    // Align registers and store 16 pixels (48 bytes) at once
-                    _mm_storeu_si128(dst++, _mm_alignr_epi8(rgb1, rgb0, 4));
-                    _mm_storeu_si128(dst++, _mm_alignr_epi8(rgb2, rgb1, 8));
-                    _mm_storeu_si128(dst++, _mm_alignr_epi8(rgb3, rgb2, 12));                
-                }
-            }
-
-            if (FORMAT == RS_FORMAT_BGR8 || FORMAT == RS_FORMAT_BGRA8)
-            {
-                // Shuffle separate R, G, B values into four registers storing four pixels each in (B, G, R, A) order
-                __m128i bg8__0_7 = _mm_unpacklo_epi8(_mm_shuffle_epi8(b16__0_7, evens_odds), _mm_shuffle_epi8(g16__0_7, evens_odds)); // hi to take the odds which are the upper bytes we care about
-                __m128i ra8__0_7 = _mm_unpacklo_epi8(_mm_shuffle_epi8(r16__0_7, evens_odds), _mm_set1_epi8(-1));
-                __m128i bgra_0_3 = _mm_unpacklo_epi16(bg8__0_7, ra8__0_7);
-                __m128i bgra_4_7 = _mm_unpackhi_epi16(bg8__0_7, ra8__0_7);
-
-                __m128i bg8__8_F = _mm_unpacklo_epi8(_mm_shuffle_epi8(b16__8_F, evens_odds), _mm_shuffle_epi8(g16__8_F, evens_odds)); // hi to take the odds which are the upper bytes we care about
-                __m128i ra8__8_F = _mm_unpacklo_epi8(_mm_shuffle_epi8(r16__8_F, evens_odds), _mm_set1_epi8(-1));
-                __m128i bgra_8_B = _mm_unpacklo_epi16(bg8__8_F, ra8__8_F);
-                __m128i bgra_C_F = _mm_unpackhi_epi16(bg8__8_F, ra8__8_F);
-
-                if(FORMAT == RS_FORMAT_BGRA8)
-                {
-                    // Store 16 pixels (64 bytes) at once
-                    _mm_storeu_si128(dst++, bgra_0_3);
-                    _mm_storeu_si128(dst++, bgra_4_7);
-                    _mm_storeu_si128(dst++, bgra_8_B);
-                    _mm_storeu_si128(dst++, bgra_C_F);
-                }
-
-                if(FORMAT == RS_FORMAT_BGR8)
-                {
-                    // Shuffle rgb triples to the start and end of each register
-                    __m128i bgr0 = _mm_shuffle_epi8(bgra_0_3, _mm_setr_epi8(  3, 7, 11, 15,   0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14));
-                    __m128i bgr1 = _mm_shuffle_epi8(bgra_4_7, _mm_setr_epi8(0, 1, 2, 4,   3, 7, 11, 15,   5, 6, 8, 9, 10, 12, 13, 14));
-                    __m128i bgr2 = _mm_shuffle_epi8(bgra_8_B, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9,   3, 7, 11, 15,   10, 12, 13, 14));
-                    __m128i bgr3 = _mm_shuffle_epi8(bgra_C_F, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,   3, 7, 11, 15  ));
-
-                    // Align registers and store 16 pixels (48 bytes) at once
-                    _mm_storeu_si128(dst++, _mm_alignr_epi8(bgr1, bgr0, 4));
-                    _mm_storeu_si128(dst++, _mm_alignr_epi8(bgr2, bgr1, 8));
-                    _mm_storeu_si128(dst++, _mm_alignr_epi8(bgr3, bgr2, 12));                
-                }
-            }
-        }    
-#else  // Generic code for when SSSE3 is not available.
         auto src = reinterpret_cast<const uint8_t *>(s);
         auto dst = reinterpret_cast<uint8_t *>(d[0]);
         for(; n; n -= 16, src += 32)
@@ -301,19 +213,7 @@ namespace rsimpl
             };
 
             uint8_t r[16], g[16], b[16];
-            for(int i = 0; i < 16; i++)
-            {
-                int32_t c = y[i] - 16;
-                int32_t d = u[i] - 128;
-                int32_t e = v[i] - 128;
-
-                int32_t t;
-                #define clamp(x)  ((t=(x)) > 255 ? 255 : t < 0 ? 0 : t)
-                r[i] = clamp((298 * c           + 409 * e + 128) >> 8);
-                g[i] = clamp((298 * c - 100 * d - 409 * e + 128) >> 8);
-                b[i] = clamp((298 * c + 516 * d           + 128) >> 8);
-                #undef clamp
-            }
+            for(int i = 0; i < 16; i++) yuy2_to_rgb(y[i], u[i], v[i], r[i], g[i], b[i]);
 
             if(FORMAT == RS_FORMAT_RGB8)
             {
@@ -383,17 +283,220 @@ namespace rsimpl
                 continue;
             }
         }
+    }
+
+    // Chroma is rounded up, as the pavgb and vrhadd instructions of the vectorized variants round it
+    static int unpack_yuy2_420_scalar(byte * y0, byte * y1, byte * u, byte * v, const byte * s0, const byte * s1, int n)
+    {
+        assert(n % 2 == 0);
+        for(int i = 0; i < n; i += 2, s0 += 4, s1 += 4)
+        {
+            *y0++ = s0[0];
+            *y0++ = s0[2];
+            *y1++ = s1[0];
+            *y1++ = s1[2];
+            *u++ = static_cast<byte>((s0[1] + s1[1] + 1) >> 1);
+            *(v ? v++ : u++) = static_cast<byte>((s0[3] + s1[3] + 1) >> 1);
+        }
+        return n;
+    }
+
+    static const yuy2_unpackers yuy2_scalar = { "scalar", &unpack_yuy2_scalar<RS_FORMAT_Y8>, &unpack_yuy2_scalar<RS_FORMAT_Y16>,
+        &unpack_yuy2_scalar<RS_FORMAT_RGB8>, &unpack_yuy2_scalar<RS_FORMAT_RGBA8>, &unpack_yuy2_scalar<RS_FORMAT_BGR8>, &unpack_yuy2_scalar<RS_FORMAT_BGRA8>, &unpack_yuy2_420_scalar };
+
+    // Instruction set extensions usable by this process, which requires both CPU and OS support (XSAVE must preserve the wide registers)
+    struct cpu_features { bool ssse3, avx2, avx512bw; };
+    static cpu_features query_cpu_features()
+    {
+        cpu_features f = {};
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int regs[4];
+        __cpuid(regs, 0);
+        const int max_leaf = regs[0];
+        __cpuid(regs, 1);
+        const unsigned ecx1 = regs[2];
+        unsigned ebx7 = 0;
+        if (max_leaf >= 7) { __cpuidex(regs, 7, 0); ebx7 = regs[1]; }
+        const unsigned long long xcr0 = (ecx1 & (1 << 27)) ? _xgetbv(0) : 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        unsigned eax, ebx, ecx1, edx;
+        const unsigned max_leaf = __get_cpuid_max(0, nullptr);
+        if (!__get_cpuid(1, &eax, &ebx, &ecx1, &edx)) return f;
+        unsigned ebx7 = 0, ecx7;
+        if (max_leaf >= 7) __cpuid_count(7, 0, eax, ebx7, ecx7, edx);
+        unsigned long long xcr0 = 0;
+        if (ecx1 & (1 << 27))
+        {
+            unsigned lo, hi;
+            __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(lo), "=d"(hi) : "c"(0)); // xgetbv
+            xcr0 = (static_cast<unsigned long long>(hi) << 32) | lo;
+        }
+#else
+        const unsigned ecx1 = 0, ebx7 = 0;
+        const unsigned long long xcr0 = 0;
 #endif
+        const bool os_ymm = (xcr0 & 0x06) == 0x06, os_zmm = (xcr0 & 0xe6) == 0xe6;
+        f.ssse3 = (ecx1 & (1 << 9)) != 0;
+        f.avx2 = os_ymm && (ecx1 & (1 << 28)) && (ebx7 & (1 << 5));
+        f.avx512bw = f.avx2 && os_zmm && (ebx7 & (1 << 16)) && (ebx7 & (1u << 30));
+        return f;
     }
-    
+
+    std::vector<const yuy2_unpackers *> get_available_yuy2_unpackers()
+    {
+        const auto cpu = query_cpu_features();
+        std::vector<const yuy2_unpackers *> list = { &yuy2_scalar };
+        if (cpu.ssse3 && get_yuy2_unpackers_ssse3()) list.push_back(get_yuy2_unpackers_ssse3());
+        if (cpu.avx2 && get_yuy2_unpackers_avx2()) list.push_back(get_yuy2_unpackers_avx2());
+        if (cpu.avx512bw && get_yuy2_unpackers_avx512bw()) list.push_back(get_yuy2_unpackers_avx512bw());
+        if (get_yuy2_unpackers_neon()) list.push_back(get_yuy2_unpackers_neon()); // NEON is required by the whole build whenever it is compiled in
+        return list;
+    }
+
+    // The widest supported variant is selected once, while the library is loaded, and every YUY2 stream dispatches through it
+    static const yuy2_unpackers & yuy2 = *get_available_yuy2_unpackers().back();
+
+    template<rs_format FORMAT> void unpack_yuy2(byte * const d [], const byte * s, int n)
+    {
+        switch(FORMAT)
+        {
+        case RS_FORMAT_Y8: return yuy2.y8(d, s, n);
+        case RS_FORMAT_Y16: return yuy2.y16(d, s, n);
+        case RS_FORMAT_RGB8: return yuy2.rgb8(d, s, n);
+        case RS_FORMAT_RGBA8: return yuy2.rgba8(d, s, n);
+        case RS_FORMAT_BGR8: return yuy2.bgr8(d, s, n);
+        case RS_FORMAT_BGRA8: return yuy2.bgra8(d, s, n);
+        }
+    }
+
+    void unpack_yuy2_to_yuv420(byte * image, rs_format format, int width, int height, const byte * source, size_t source_stride, int first_row, int row_count)
+    {
+        assert(is_yuv420(format) && width % 2 == 0 && first_row % 2 == 0);
+        const int chroma_stride = format == RS_FORMAT_I420 ? width / 2 : width;
+        byte * u_plane = image + width * height, * v_plane = format == RS_FORMAT_I420 ? u_plane + chroma_stride * ((height + 1) / 2) : nullptr;
+        for(int y = first_row; y < first_row + row_count; y += 2)
+        {
+            // A last odd row is paired with itself
+            const byte * s0 = source + source_stride * y, * s1 = y + 1 < height ? s0 + source_stride : s0;
+            byte * y0 = image + width * y, * y1 = y + 1 < height ? y0 + width : y0;
+            byte * u = u_plane + chroma_stride * (y / 2), * v = v_plane ? v_plane + chroma_stride * (y / 2) : nullptr;
+
+            const int n = yuy2.yuv420(y0, y1, u, v, s0, s1, width);
+            if(n < width) unpack_yuy2_420_scalar(y0 + n, y1 + n, u + (v ? n / 2 : n), v ? v + n / 2 : nullptr, s0 + n * 2, s1 + n * 2, width - n);
+        }
+    }
+
+    ///////////////////////
+    // Bayer demosaicing //
+    ///////////////////////
+
+    // The same integer arithmetic as demosaic_row_simd, one pixel at a time
+    template<rs_format FORMAT> static int demosaic_row_scalar(byte * out, const uint16_t * const rows[5], int count, bool red_row, bool sites_even, bool corrected)
+    {
+        for(int x = 0; x < count; ++x)
+        {
+            auto at = [&](int row, int dx) -> int { return rows[row][x + dx]; };
+            const int c = at(2, 0), h1 = at(2, -1) + at(2, 1), v1 = at(1, 0) + at(3, 0), diag = at(1, -1) + at(1, 1) + at(3, -1) + at(3, 1);
+            int cross = 4 * (h1 + v1), across = 8 * h1, down = 8 * v1, diagonal = 4 * diag;
+            if(corrected)
+            {
+                const int h2 = at(2, -2) + at(2, 2), v2 = at(0, 0) + at(4, 0);
+                cross += 8 * c - 2 * (h2 + v2);
+                across += 10 * c - 2 * diag - 2 * h2 + v2;
+                down += 10 * c - 2 * diag - 2 * v2 + h2;
+                diagonal += 12 * c - 3 * (h2 + v2);
+            }
+            auto finish = [](int v) { return std::min(1023, std::max(0, (v + 8) >> 4)); };
+            const bool site = (x % 2 == 0) == sites_even;
+            const int g = site ? finish(cross) : c;
+            const int r = red_row ? (site ? c : finish(across)) : (site ? finish(diagonal) : finish(down));
+            const int b = red_row ? (site ? finish(diagonal) : finish(down)) : (site ? c : finish(across));
+            if(FORMAT == RS_FORMAT_Y16)
+            {
+                const int luma = ((r * 8 * (77 << 4) + 0x4000) >> 15) + ((g * 8 * (150 << 4) + 0x4000) >> 15) + ((b * 8 * (29 << 4) + 0x4000) >> 15);
+                reinterpret_cast<uint16_t *>(out)[x] = static_cast<uint16_t>(luma << 6);
+            }
+            else
+            {
+                out[x * 3] = static_cast<byte>(r >> 2);
+                out[x * 3 + 1] = static_cast<byte>(g >> 2);
+                out[x * 3 + 2] = static_cast<byte>(b >> 2);
+            }
+        }
+        return count;
+    }
+
+    static const bayer_demosaicers bayer_scalar = { "scalar", &demosaic_row_scalar<RS_FORMAT_RGB8>, &demosaic_row_scalar<RS_FORMAT_Y16> };
+
+    std::vector<const bayer_demosaicers *> get_available_bayer_demosaicers()
+    {
+        const auto cpu = query_cpu_features();
+        std::vector<const bayer_demosaicers *> list = { &bayer_scalar };
+        if (cpu.ssse3 && get_bayer_demosaicers_ssse3()) list.push_back(get_bayer_demosaicers_ssse3());
+        if (cpu.avx2 && get_bayer_demosaicers_avx2()) list.push_back(get_bayer_demosaicers_avx2());
+        if (cpu.avx512bw && get_bayer_demosaicers_avx512bw()) list.push_back(get_bayer_demosaicers_avx512bw());
+        if (get_bayer_demosaicers_neon()) list.push_back(get_bayer_demosaicers_neon());
+        return list;
+    }
+
+    static const bayer_demosaicers & bayer = *get_available_bayer_demosaicers().back();
+
+    // Reflects coordinates past either edge back into [0, size), onto pixels of the same color
+    static int mirror(int i, int size) { return i < 0 ? -i : i >= size ? 2 * (size - 1) - i : i; }
+
+    void demosaic_raw10(byte * image, rs_format format, int width, int height, const byte * raw, size_t raw_stride, int raw_width, int raw_height,
+                        int x, int y, int first_row, int row_count, bool corrected)
+    {
+        assert(format == RS_FORMAT_RGB8 || format == RS_FORMAT_Y16);
+        assert(raw_width >= 3 && raw_height >= 3 && x + width <= raw_width && y + height <= raw_height);
+        const int padded = width + 4;
+        const size_t out_stride = get_image_size(width, 1, format);
+        auto kernel = format == RS_FORMAT_Y16 ? bayer.y16 : bayer.rgb8;
+        auto tail = format == RS_FORMAT_Y16 ? &demosaic_row_scalar<RS_FORMAT_Y16> : &demosaic_row_scalar<RS_FORMAT_RGB8>;
+
+        // Five rows around the one being demosaiced are kept unpacked, each replaced by the row five further down once it is passed
+        std::vector<uint16_t> ring(padded * 5);
+        auto unpack_row = [&](int row)
+        {
+            const byte * src = raw + raw_stride * mirror(y + row, raw_height);
+            uint16_t * dst = ring.data() + padded * ((row + 10) % 5) + 2;
+            for(int i = -2; i < width + 2; ++i)
+            {
+                // Four pixels keep their upper 8 bits in four bytes, then their lower 2 bits in a fifth
+                const int p = mirror(x + i, raw_width);
+                const byte * macropixel = src + p / 4 * 5;
+                dst[i] = static_cast<uint16_t>(macropixel[p % 4] << 2 | (macropixel[4] >> (p % 4 * 2) & 3));
+            }
+        };
+        for(int row = first_row - 2; row < first_row + 2; ++row) unpack_row(row);
+        for(int row = first_row; row < first_row + row_count; ++row)
+        {
+            unpack_row(row + 2);
+            const uint16_t * rows[5];
+            for(int k = 0; k < 5; ++k) rows[k] = ring.data() + padded * ((row - 2 + k + 10) % 5) + 2;
+            const bool red_row = (y + row) % 2 == 0, sites_even = x % 2 == (red_row ? 0 : 1);
+            byte * out = image + out_stride * row;
+            const int n = kernel(out, rows, width, red_row, sites_even, corrected);
+            if(n < width)
+            {
+                const uint16_t * rest[5];
+                for(int k = 0; k < 5; ++k) rest[k] = rows[k] + n;
+                tail(out + get_image_size(n, 1, format), rest, width - n, red_row, sites_even == (n % 2 == 0), corrected);
+            }
+        }
+    }
+
     //////////////////////////////////////
     // 2-in-1 format splitting routines //
     //////////////////////////////////////
 
-    template<class SOURCE, class SPLIT_A, class SPLIT_B> void split_frame(byte * const dest[], int count, const SOURCE * source, SPLIT_A split_a, SPLIT_B split_b)
+    // As with unpack_pixels, an optional block kernel converts all whole blocks of 16 pixels
+    template<class SOURCE, class SPLIT_A, class SPLIT_B> void split_frame(byte * const dest[], int count, const SOURCE * source, SPLIT_A split_a, SPLIT_B split_b,
+        void(*block)(decltype(std::declval<SPLIT_A>()(SOURCE())) * a, decltype(std::declval<SPLIT_B>()(SOURCE())) * b, const byte * in))
     {
         auto a = reinterpret_cast<decltype(split_a(SOURCE())) *>(dest[0]);
         auto b = reinterpret_cast<decltype(split_b(SOURCE())) *>(dest[1]);
+        if(block) for(; count >= 16; count -= 16, source += 16, a += 16, b += 16) block(a, b, reinterpret_cast<const byte *>(source));
         for(int i=0; i<count; ++i)
         {
             *a++ = split_a(*source);
@@ -406,7 +509,16 @@ namespace rsimpl
     {
         split_frame(dest, count, reinterpret_cast<const y8i_pixel *>(source),
             [](const y8i_pixel & p) -> uint8_t { return p.l; },
-            [](const y8i_pixel & p) -> uint8_t { return p.r; });
+            [](const y8i_pixel & p) -> uint8_t { return p.r; }, SIMD_BLOCK(unpack_y8_y8_from_y8i));
+    }
+
+    // Strided views of Y8I frames are packed from one byte of every pixel, which the block kernel picks from the low bytes of 16 bit words.
+    // Its blocks end one byte past their last sample, so the last sample is always left to the portable loop.
+    void pack_strided_samples(byte * dest, const byte * source, int count, int pixel_stride)
+    {
+        auto block = pixel_stride == 2 ? SIMD_BLOCK(pack_y8_from_stride_2) : nullptr;
+        if(block) for(; count > 16; count -= 16, source += 32, dest += 16) block(dest, source);
+        for(int i=0; i<count; ++i) dest[i] = source[i * pixel_stride];
     }
 
     struct y12i_pixel { uint8_t rl : 8, rh : 4, ll : 4, lh : 8; int l() const { return lh << 4 | ll; } int r() const { return rh << 8 | rl; } };
@@ -414,7 +526,16 @@ namespace rsimpl
     {
         split_frame(dest, count, reinterpret_cast<const y12i_pixel *>(source),
             [](const y12i_pixel & p) -> uint16_t { return p.l() << 6 | p.l() >> 4; },  // We want to convert 10-bit data to 16-bit data
-            [](const y12i_pixel & p) -> uint16_t { return p.r() << 6 | p.r() >> 4; }); // Multiply by 64 1/16 to efficiently approximate 65535/1023
+            [](const y12i_pixel & p) -> uint16_t { return p.r() << 6 | p.r() >> 4; },  // Multiply by 64 1/16 to efficiently approximate 65535/1023
+            SIMD_BLOCK(unpack_y16_y16_from_y12i_10));
+    }
+
+    void unpack_y8_y8_from_y12i_10(byte * const dest[], const byte * source, int count)
+    {
+        split_frame(dest, count, reinterpret_cast<const y12i_pixel *>(source),
+            [](const y12i_pixel & p) -> uint8_t { return p.l() >> 2; },  // Keep the top 8 of the 10 bits, skipping the 16 bit intermediate
+            [](const y12i_pixel & p) -> uint8_t { return p.r() >> 2; },
+            SIMD_BLOCK(unpack_y8_y8_from_y12i_10));
     }
 
     struct f200_inzi_pixel { uint16_t z16; uint8_t y8; };
@@ -422,30 +543,29 @@ namespace rsimpl
     {
         split_frame(dest, count, reinterpret_cast<const f200_inzi_pixel *>(source),
             [](const f200_inzi_pixel & p) -> uint16_t { return p.z16; },
-            [](const f200_inzi_pixel & p) -> uint8_t { return p.y8; });
+            [](const f200_inzi_pixel & p) -> uint8_t { return p.y8; }, NEON_BLOCK(unpack_z16_y8_from_f200_inzi));
     }
 
     void unpack_z16_y16_from_f200_inzi(byte * const dest[], const byte * source, int count)
     {
         split_frame(dest, count, reinterpret_cast<const f200_inzi_pixel *>(source),
             [](const f200_inzi_pixel & p) -> uint16_t { return p.z16; },
-            [](const f200_inzi_pixel & p) -> uint16_t { return p.y8 | p.y8 << 8; });
+            [](const f200_inzi_pixel & p) -> uint16_t { return p.y8 | p.y8 << 8; }, NEON_BLOCK(unpack_z16_y16_from_f200_inzi));
     }
 
+    // A null Z destination means the Z plane is handed out as a view of the native frame, see pixel_format_unpacker::plane_views
     void unpack_z16_y8_from_sr300_inzi(byte * const dest[], const byte * source, int count)
     {
         auto in = reinterpret_cast<const uint16_t *>(source);
-        auto out_ir = reinterpret_cast<uint8_t *>(dest[1]);            
-        for(int i=0; i<count; ++i) *out_ir++ = *in++ >> 2;
-        memcpy(dest[0], in, count*2);
+        unpack_pixels(dest + 1, count, in, [](uint16_t pixel) -> uint8_t { return pixel >> 2; }, SIMD_BLOCK(unpack_y8_from_y16_10));
+        if(dest[0]) memcpy(dest[0], in + count, count*2);
     }
 
     void unpack_z16_y16_from_sr300_inzi (byte * const dest[], const byte * source, int count)
     {
         auto in = reinterpret_cast<const uint16_t *>(source);
-        auto out_ir = reinterpret_cast<uint16_t *>(dest[1]);
-        for(int i=0; i<count; ++i) *out_ir++ = *in++ << 6;
-        memcpy(dest[0], in, count*2);
+        unpack_pixels(dest + 1, count, in, [](uint16_t pixel) -> uint16_t { return pixel << 6; }, SIMD_BLOCK(unpack_y16_from_y16_10));
+        if(dest[0]) memcpy(dest[0], in + count, count*2);
     }
 
 #pragma GCC diagnostic push
@@ -458,16 +578,23 @@ namespace rsimpl
     //////////////////////////
     const native_pixel_format pf_raw8       = { 'RAW8', 1, 1,{  { false, &copy_pixels<1>,                   { { RS_STREAM_FISHEYE,  RS_FORMAT_RAW8 } } } } };
     const native_pixel_format pf_rw16       = { 'RW16', 1, 2,{  { false, &copy_pixels<2>,                   { { RS_STREAM_COLOR,    RS_FORMAT_RAW16 } } } } };
-    const native_pixel_format pf_rw10       = { 'pRAA', 1, 1,{  { false, &copy_raw10,                       { { RS_STREAM_COLOR,    RS_FORMAT_RAW10 } } } } };
+    const native_pixel_format pf_rw10       = { 'pRAA', 1, 1,{  { false, &copy_raw10,                       { { RS_STREAM_COLOR,    RS_FORMAT_RAW10 } } },
+                                                                // Demosaiced outputs are interpolated from the rows around each row by demosaic_raw10, the unpacker only standing for them
+                                                                { true,  &copy_raw10,                       { { RS_STREAM_COLOR,    RS_FORMAT_RGB8 } } },
+                                                                { true,  &copy_raw10,                       { { RS_STREAM_COLOR,    RS_FORMAT_Y16 } } } } };
     const native_pixel_format pf_yuy2       = { 'YUY2', 1, 2,{  { true,  &unpack_yuy2<RS_FORMAT_RGB8 >,     { { RS_STREAM_COLOR,    RS_FORMAT_RGB8 } } },
                                                                 { false, &copy_pixels<2>,                   { { RS_STREAM_COLOR,    RS_FORMAT_YUYV } } },
                                                                 { true,  &unpack_yuy2<RS_FORMAT_RGBA8>,     { { RS_STREAM_COLOR,    RS_FORMAT_RGBA8 } } },
                                                                 { true,  &unpack_yuy2<RS_FORMAT_BGR8 >,     { { RS_STREAM_COLOR,    RS_FORMAT_BGR8 } } },
-                                                                { true,  &unpack_yuy2<RS_FORMAT_BGRA8>,     { { RS_STREAM_COLOR,    RS_FORMAT_BGRA8 } } } } };
+                                                                { true,  &unpack_yuy2<RS_FORMAT_BGRA8>,     { { RS_STREAM_COLOR,    RS_FORMAT_BGRA8 } } },
+                                                                // 4:2:0 outputs are unpacked into their planes by unpack_yuy2_to_yuv420, the unpacker standing for their luminance alone
+                                                                { true,  &unpack_yuy2<RS_FORMAT_Y8>,        { { RS_STREAM_COLOR,    RS_FORMAT_NV12 } } },
+                                                                { true,  &unpack_yuy2<RS_FORMAT_Y8>,        { { RS_STREAM_COLOR,    RS_FORMAT_I420 } } } } };
     const native_pixel_format pf_y8         = { 'GREY', 1, 1,{  { false, &copy_pixels<1>,                   { { RS_STREAM_INFRARED, RS_FORMAT_Y8 } } } } };
     const native_pixel_format pf_y16        = { 'Y16 ', 1, 2,{  { true,  &unpack_y16_from_y16_10,           { { RS_STREAM_INFRARED, RS_FORMAT_Y16 } } } } };
-    const native_pixel_format pf_y8i        = { 'Y8I ', 1, 2,{  { true,  &unpack_y8_y8_from_y8i,            { { RS_STREAM_INFRARED, RS_FORMAT_Y8 },{ RS_STREAM_INFRARED2, RS_FORMAT_Y8 } } } } };
-    const native_pixel_format pf_y12i       = { 'Y12I', 1, 3,{  { true,  &unpack_y16_y16_from_y12i_10,      { { RS_STREAM_INFRARED, RS_FORMAT_Y16 },{ RS_STREAM_INFRARED2, RS_FORMAT_Y16 } } } } };
+    const native_pixel_format pf_y8i        = { 'Y8I ', 1, 2,{  { true,  &unpack_y8_y8_from_y8i,            { { RS_STREAM_INFRARED, RS_FORMAT_Y8 },{ RS_STREAM_INFRARED2, RS_FORMAT_Y8 } }, {}, { 0, 1 } } } };
+    const native_pixel_format pf_y12i       = { 'Y12I', 1, 3,{  { true,  &unpack_y16_y16_from_y12i_10,      { { RS_STREAM_INFRARED, RS_FORMAT_Y16 },{ RS_STREAM_INFRARED2, RS_FORMAT_Y16 } } },
+                                                                { true,  &unpack_y8_y8_from_y12i_10,        { { RS_STREAM_INFRARED, RS_FORMAT_Y8 },{ RS_STREAM_INFRARED2, RS_FORMAT_Y8 } } } } };
     const native_pixel_format pf_z16        = { 'Z16 ', 1, 2,{  { false, &copy_pixels<2>,                   { { RS_STREAM_DEPTH,    RS_FORMAT_Z16 } } },
                                                                 { false, &copy_pixels<2>,                   { { RS_STREAM_DEPTH,    RS_FORMAT_DISPARITY16 } } } } };
     const native_pixel_format pf_invz       = { 'Z16 ', 1, 2, { { false, &copy_pixels<2>,                   { { RS_STREAM_DEPTH,    RS_FORMAT_Z16 } } } } };
@@ -477,163 +604,1896 @@ namespace rsimpl
                                                                 { true,  &unpack_z16_y16_from_f200_inzi,    { { RS_STREAM_DEPTH,    RS_FORMAT_Z16 },{ RS_STREAM_INFRARED, RS_FORMAT_Y16 } } } } };
     const native_pixel_format pf_sr300_invi = { 'Y10 ', 1, 2,{  { true,  &unpack_y8_from_y16_10,            { { RS_STREAM_INFRARED, RS_FORMAT_Y8 } } },
                                                                 { true,  &unpack_y16_from_y16_10,           { { RS_STREAM_INFRARED, RS_FORMAT_Y16 } } } } };
-    const native_pixel_format pf_sr300_inzi = { 'INZI', 2, 2,{  { true,  &unpack_z16_y8_from_sr300_inzi,    { { RS_STREAM_DEPTH,    RS_FORMAT_Z16 },{ RS_STREAM_INFRARED, RS_FORMAT_Y8 } } },
-                                                                { true,  &unpack_z16_y16_from_sr300_inzi,   { { RS_STREAM_DEPTH,    RS_FORMAT_Z16 },{ RS_STREAM_INFRARED, RS_FORMAT_Y16 } } } } };
+    const native_pixel_format pf_sr300_inzi = { 'INZI', 2, 2,{  { true,  &unpack_z16_y8_from_sr300_inzi,    { { RS_STREAM_DEPTH,    RS_FORMAT_Z16 },{ RS_STREAM_INFRARED, RS_FORMAT_Y8 } }, { 1, -1 } },
+                                                                { true,  &unpack_z16_y16_from_sr300_inzi,   { { RS_STREAM_DEPTH,    RS_FORMAT_Z16 },{ RS_STREAM_INFRARED, RS_FORMAT_Y16 } }, { 1, -1 } } } };
 #pragma GCC diagnostic pop
 
+    /////////////////////////////////
+    // Width-specialized unpacking //
+    /////////////////////////////////
+
+    template<void(*UNPACK)(byte * const[], const byte *, int), int OUTPUTS, int WIDTH> void unpack_rows(byte * const dest[], const size_t dest_stride[], const byte * source, size_t source_stride, int height)
+    {
+        byte * out[OUTPUTS];
+        for(int i=0; i<OUTPUTS; ++i) out[i] = dest[i];
+        for(int y=0; y<height; ++y, source += source_stride)
+        {
+            UNPACK(out, source, WIDTH);
+            for(int i=0; i<OUTPUTS; ++i) out[i] += dest_stride[i];
+        }
+    }
+
+    struct row_unpacker_instance
+    {
+        void(*unpack)(byte * const dest[], const byte * source, int count);
+        int width;
+        row_unpack_function rows;
+    };
+
+    // The widths of the modes of every supported camera, R200 depth being cropped to 628 and 480 pixels
+#define ROW_UNPACKERS(UNPACK, OUTPUTS) \
+    { &UNPACK, 320, &unpack_rows<&UNPACK, OUTPUTS, 320> }, { &UNPACK, 480, &unpack_rows<&UNPACK, OUTPUTS, 480> }, { &UNPACK, 628, &unpack_rows<&UNPACK, OUTPUTS, 628> }, \
+    { &UNPACK, 640, &unpack_rows<&UNPACK, OUTPUTS, 640> }, { &UNPACK, 1280, &unpack_rows<&UNPACK, OUTPUTS, 1280> }, { &UNPACK, 1920, &unpack_rows<&UNPACK, OUTPUTS, 1920> }
+
+    static const row_unpacker_instance row_unpackers[] = {
+        ROW_UNPACKERS(copy_pixels<1>, 1),
+        ROW_UNPACKERS(copy_pixels<2>, 1),
+        ROW_UNPACKERS(unpack_y16_from_y8, 1),
+        ROW_UNPACKERS(unpack_y16_from_y16_10, 1),
+        ROW_UNPACKERS(unpack_y8_from_y16_10, 1),
+        ROW_UNPACKERS(unpack_y8_y8_from_y8i, 2),
+        ROW_UNPACKERS(unpack_y16_y16_from_y12i_10, 2),
+        ROW_UNPACKERS(unpack_y8_y8_from_y12i_10, 2),
+        ROW_UNPACKERS(unpack_z16_y8_from_f200_inzi, 2),
+        ROW_UNPACKERS(unpack_z16_y16_from_f200_inzi, 2),
+    };
+#undef ROW_UNPACKERS
+
+    row_unpack_function find_row_unpacker(void(*unpack)(byte * const dest[], const byte * source, int count), int width)
+    {
+        for(auto & instance : row_unpackers) if(instance.unpack == unpack && instance.width == width) return instance.rows;
+        return nullptr;
+    }
+
     //////////////////
     // Deprojection //
     //////////////////
 
-    template<class MAP_DEPTH> void deproject_depth(float * points, const rs_intrinsics & intrin, const uint16_t * depth, MAP_DEPTH map_depth)
+    std::vector<float> compute_deprojection_table(const rs_intrinsics & intrin)
     {
+        std::vector<float> table(intrin.width * intrin.height * 2);
+        auto ray = table.data();
         for(int y=0; y<intrin.height; ++y)
         {
-            for(int x=0; x<intrin.width; ++x)
+            for(int x=0; x<intrin.width; ++x, ray += 2)
             {
                 const float pixel[] = { (float) x, (float) y};
-                rs_deproject_pixel_to_point(points, &intrin, pixel, map_depth(*depth++));
-                points += 3;                
+                float point[3];
+                rs_deproject_pixel_to_point(point, &intrin, pixel, 1.0f);
+                ray[0] = point[0];
+                ray[1] = point[1];
             }
-        }    
+        }
+        return table;
     }
 
-    void deproject_z(float * points, const rs_intrinsics & z_intrin, const uint16_t * z_pixels, float z_scale)
+    // Rounds to the nearest half, ties to even, the way F16C and ARMv8 convert. Written as integer operations on the bits of the float
+    // so that the SSSE3 path below, which has no conversion instruction, computes exactly the same encoding.
+    static uint16_t float_to_half(float f)
     {
-        deproject_depth(points, z_intrin, z_pixels, [z_scale](uint16_t z) { return z_scale * z; });
+        uint32_t x;
+        memcpy(&x, &f, sizeof(x));
+        const uint32_t sign = x & 0x80000000u;
+        x ^= sign;
+
+        uint32_t h;
+        if(x >= (127 + 16) << 23) h = x > 0x7f800000u ? 0x7e00 : 0x7c00;   // Beyond the half range, or NaN
+        else if(x < (127 - 14) << 23)                                       // Subnormal half, rounded by the float adder
+        {
+            const uint32_t magic_bits = ((127 - 15) + (23 - 10) + 1) << 23;
+            float magnitude, magic;
+            memcpy(&magnitude, &x, sizeof(magnitude));
+            memcpy(&magic, &magic_bits, sizeof(magic));
+            const float sum = magnitude + magic;
+            memcpy(&h, &sum, sizeof(h));
+            h -= magic_bits;
+        }
+        else h = (x + 0xfff - ((127 - 15) << 23) + ((x >> 13) & 1)) >> 13;
+        return static_cast<uint16_t>(h | sign >> 16);
     }
 
-    void deproject_disparity(float * points, const rs_intrinsics & disparity_intrin, const uint16_t * disparity_pixels, float disparity_scale)
+    static int16_t meters_to_millimeters(float m)
     {
-        deproject_depth(points, disparity_intrin, disparity_pixels, [disparity_scale](uint16_t disparity) { return disparity_scale / disparity; });
+        return static_cast<int16_t>(std::nearbyint(std::min(std::max(m * 1000.0f, -32768.0f), 32767.0f)));
     }
 
-    /////////////////////
-    // Image alignment //
-    /////////////////////
+#if defined(RS_SIMD_HAVE_SSSE3)
+    // Four halves in the low 16 bits of every 32 bit lane, through the same steps as float_to_half(...)
+    static __m128i float_to_half(__m128 f)
+    {
+        const __m128i sign = _mm_and_si128(_mm_castps_si128(f), _mm_set1_epi32(0x80000000));
+        const __m128i x = _mm_xor_si128(_mm_castps_si128(f), sign);
+        const __m128i magic_bits = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+
+        const __m128i is_regular = _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), x);
+        const __m128i is_nan = _mm_cmpgt_epi32(x, _mm_set1_epi32(0x7f800000));
+        const __m128i special = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(is_nan, _mm_set1_epi32(0x200)));
+        const __m128i is_subnormal = _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), x);
+        const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(x), _mm_castsi128_ps(magic_bits))), magic_bits);
+        const __m128i odd = _mm_and_si128(_mm_srli_epi32(x, 13), _mm_set1_epi32(1));
+        const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(x, _mm_set1_epi32(0xfff - ((127 - 15) << 23))), odd), 13);
+
+        const __m128i finite = _mm_or_si128(_mm_and_si128(is_subnormal, subnormal), _mm_andnot_si128(is_subnormal, normal));
+        const __m128i h = _mm_or_si128(_mm_and_si128(is_regular, finite), _mm_andnot_si128(is_regular, special));
+        return _mm_or_si128(h, _mm_srli_epi32(sign, 16));
+    }
+
+    static __m128i meters_to_millimeters(__m128 m)
+    {
+        return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(m, _mm_set1_ps(1000.0f)), _mm_set1_ps(-32768.0f)), _mm_set1_ps(32767.0f)));
+    }
+#elif defined(RS_SIMD_HAVE_NEON)
+    static int16x4_t meters_to_millimeters(float32x4_t m)
+    {
+        // Adding and removing 1.5 * 2^23 rounds to the nearest integer, ties to even, as the rounding of vcvtq_s32_f32 is toward zero
+        const float32x4_t clamped = vminq_f32(vmaxq_f32(vmulq_f32(m, vdupq_n_f32(1000.0f)), vdupq_n_f32(-32768.0f)), vdupq_n_f32(32767.0f));
+        const float32x4_t rounded = vsubq_f32(vaddq_f32(clamped, vdupq_n_f32(12582912.0f)), vdupq_n_f32(12582912.0f));
+        return vmovn_s32(vcvtq_s32_f32(rounded));
+    }
+#endif
+
+    // Point encodings. Every one stores a single point, and four points at once from the registers the deprojection produces:
+    // on SSSE3 the coordinates already interleaved as x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3, on NEON one register per axis.
+    struct xyz32f_points
+    {
+        enum { point_size = 12 };
+        static void store(byte * p, float x, float y, float z) { const float xyz[] = { x, y, z }; memcpy(p, xyz, sizeof(xyz)); }
+#if defined(RS_SIMD_HAVE_SSSE3)
+        static void store(byte * p, __m128 a, __m128 b, __m128 c)
+        {
+            _mm_storeu_ps(reinterpret_cast<float *>(p), a);
+            _mm_storeu_ps(reinterpret_cast<float *>(p + 16), b);
+            _mm_storeu_ps(reinterpret_cast<float *>(p + 32), c);
+        }
+#elif defined(RS_SIMD_HAVE_NEON)
+        static void store(byte * p, const float32x4x3_t & xyz) { vst3q_f32(reinterpret_cast<float *>(p), xyz); }
+#endif
+    };
+
+    struct xyz16f_points
+    {
+        enum { point_size = 6 };
+        static void store(byte * p, float x, float y, float z) { const uint16_t xyz[] = { float_to_half(x), float_to_half(y), float_to_half(z) }; memcpy(p, xyz, sizeof(xyz)); }
+#if defined(RS_SIMD_HAVE_SSSE3)
+        static void store(byte * p, __m128 a, __m128 b, __m128 c)
+        {
+            const __m128i low_halves = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_shuffle_epi8(float_to_half(a), low_halves));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(p + 8), _mm_shuffle_epi8(float_to_half(b), low_halves));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(p + 16), _mm_shuffle_epi8(float_to_half(c), low_halves));
+        }
+#elif defined(RS_SIMD_HAVE_NEON)
+        static void store(byte * p, const float32x4x3_t & xyz)
+        {
+#if defined(__aarch64__)
+            const uint16x4x3_t h = {{ vreinterpret_u16_f16(vcvt_f16_f32(xyz.val[0])), vreinterpret_u16_f16(vcvt_f16_f32(xyz.val[1])), vreinterpret_u16_f16(vcvt_f16_f32(xyz.val[2])) }};
+            vst3_u16(reinterpret_cast<uint16_t *>(p), h);
+#else
+            // ARMv7 NEON flushes subnormals, so the conversion is left to the integer path
+            float points[12];
+            vst3q_f32(points, xyz);
+            for(int i = 0; i < 4; ++i) store(p + i * point_size, points[i * 3], points[i * 3 + 1], points[i * 3 + 2]);
+#endif
+        }
+#endif
+    };
+
+    struct xyz16_points
+    {
+        enum { point_size = 6 };
+        static void store(byte * p, float x, float y, float z) { const int16_t xyz[] = { meters_to_millimeters(x), meters_to_millimeters(y), meters_to_millimeters(z) }; memcpy(p, xyz, sizeof(xyz)); }
+#if defined(RS_SIMD_HAVE_SSSE3)
+        static void store(byte * p, __m128 a, __m128 b, __m128 c)
+        {
+            // Coordinates were clamped to the 16 bit range, so the saturating pack only narrows them
+            const __m128i c_mm = meters_to_millimeters(c);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm_packs_epi32(meters_to_millimeters(a), meters_to_millimeters(b)));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(p + 16), _mm_packs_epi32(c_mm, c_mm));
+        }
+#elif defined(RS_SIMD_HAVE_NEON)
+        static void store(byte * p, const float32x4x3_t & xyz)
+        {
+            const int16x4x3_t mm = {{ meters_to_millimeters(xyz.val[0]), meters_to_millimeters(xyz.val[1]), meters_to_millimeters(xyz.val[2]) }};
+            vst3_s16(reinterpret_cast<int16_t *>(p), mm);
+        }
+#endif
+    };
+
+    // Calls run(source, dest, pixel, count) for every row of an image of count pixels, with the offsets of its first pixel in the source image,
+    // the image written and the packed image, or once for the whole image when no stride pads its rows
+    template<class RUN> void for_each_run(int count, int width, const image_strides & strides, RUN run)
+    {
+        if(!width || ((!strides.source || strides.source == width) && (!strides.dest || strides.dest == width))) return run(0, 0, 0, count);
+        const int source_stride = strides.source ? strides.source : width, dest_stride = strides.dest ? strides.dest : width;
+        for(int y = 0; y < count / width; ++y) run(y * source_stride, y * dest_stride, y * width, width);
+    }
 
-    template<class GET_DEPTH, class TRANSFER_PIXEL> void align_images(const rs_intrinsics & depth_intrin, const rs_extrinsics & depth_to_other, const rs_intrinsics & other_intrin, GET_DEPTH get_depth, TRANSFER_PIXEL transfer_pixel)
+    // Scales the unit-depth ray of every pixel by that pixel's depth, which is exactly what rs_deproject_pixel_to_point(...) computes
+    template<class POINTS, class MAP_DEPTH> void deproject_run(byte * points, const float * ray, const uint16_t * depth, int count, MAP_DEPTH map_depth)
     {
-        // Iterate over the pixels of the depth image    
-#pragma omp parallel for schedule(dynamic)
-        for(int depth_y = 0; depth_y < depth_intrin.height; ++depth_y)
+        int i = 0;
+#if defined(RS_SIMD_HAVE_SSSE3)
+        for(; i + 4 <= count; i += 4, depth += 4, ray += 8, points += 4 * POINTS::point_size)
         {
-            int depth_pixel_index = depth_y * depth_intrin.width;
-            for(int depth_x = 0; depth_x < depth_intrin.width; ++depth_x, ++depth_pixel_index)
+            float d[4];
+            for(int j=0; j<4; ++j) d[j] = map_depth(depth[j]);
+            const __m128 z = _mm_loadu_ps(d);
+            const __m128 xy01 = _mm_mul_ps(_mm_loadu_ps(ray), _mm_unpacklo_ps(z, z));       // x0 y0 x1 y1
+            const __m128 xy23 = _mm_mul_ps(_mm_loadu_ps(ray + 4), _mm_unpackhi_ps(z, z));   // x2 y2 x3 y3
+
+            // Interleave into x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+            const __m128 z0_x1 = _mm_shuffle_ps(z, xy01, _MM_SHUFFLE(2, 2, 0, 0));
+            const __m128 y1_z1 = _mm_shuffle_ps(xy01, z, _MM_SHUFFLE(1, 1, 3, 3));
+            const __m128 z2_x3 = _mm_shuffle_ps(z, xy23, _MM_SHUFFLE(2, 2, 2, 2));
+            const __m128 y3_z3 = _mm_shuffle_ps(xy23, z, _MM_SHUFFLE(3, 3, 3, 3));
+            POINTS::store(points, _mm_shuffle_ps(xy01, z0_x1, _MM_SHUFFLE(2, 0, 1, 0)), _mm_shuffle_ps(y1_z1, xy23, _MM_SHUFFLE(1, 0, 2, 0)), _mm_shuffle_ps(z2_x3, y3_z3, _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+#elif defined(RS_SIMD_HAVE_NEON)
+        for(; i + 4 <= count; i += 4, depth += 4, ray += 8, points += 4 * POINTS::point_size)
+        {
+            float d[4];
+            for(int j=0; j<4; ++j) d[j] = map_depth(depth[j]);
+            const float32x4_t z = vld1q_f32(d);
+            const float32x4x2_t xy = vld2q_f32(ray);
+            const float32x4x3_t xyz = {{ vmulq_f32(z, xy.val[0]), vmulq_f32(z, xy.val[1]), z }};
+            POINTS::store(points, xyz);
+        }
+#endif
+        for(; i < count; ++i, ray += 2, points += POINTS::point_size)
+        {
+            const float z = map_depth(*depth++);
+            POINTS::store(points, z * ray[0], z * ray[1], z);
+        }
+    }
+
+    // Calls span(source, dest, pixel, count) as for_each_run(...) does, for the runs of valid pixels of every row alone, and clear(dest, count) for
+    // the pixels in between, whose points would have come out as zero
+    template<class SPAN, class CLEAR> void for_each_depth_run(int width, int height, const image_strides & strides, SPAN span, CLEAR clear)
+    {
+        const int source_stride = strides.source ? strides.source : width, dest_stride = strides.dest ? strides.dest : width;
+        const auto runs = get_depth_runs(strides.source_runs, height);
+        for(int y = 0; y < height; ++y)
+        {
+            int x = 0;
+            for(auto run = runs + strides.source_runs[y], end = runs + strides.source_runs[y+1]; run != end; ++run)
             {
-                // Skip over depth pixels with the value of zero, we have no depth data so we will not write anything into our aligned images
-                if(float depth = get_depth(depth_pixel_index))
-                {
-                    // Map the top-left corner of the depth pixel onto the other image
-                    float depth_pixel[2] = {depth_x-0.5f, depth_y-0.5f}, depth_point[3], other_point[3], other_pixel[2];
-                    rs_deproject_pixel_to_point(depth_point, &depth_intrin, depth_pixel, depth);
-                    rs_transform_point_to_point(other_point, &depth_to_other, depth_point);
-                    rs_project_point_to_pixel(other_pixel, &other_intrin, other_point);
-                    const int other_x0 = static_cast<int>(other_pixel[0] + 0.5f);
-                    const int other_y0 = static_cast<int>(other_pixel[1] + 0.5f);
-
-                    // Map the bottom-right corner of the depth pixel onto the other image
-                    depth_pixel[0] = depth_x+0.5f; depth_pixel[1] = depth_y+0.5f;
-                    rs_deproject_pixel_to_point(depth_point, &depth_intrin, depth_pixel, depth);
-                    rs_transform_point_to_point(other_point, &depth_to_other, depth_point);
-                    rs_project_point_to_pixel(other_pixel, &other_intrin, other_point);
-                    const int other_x1 = static_cast<int>(other_pixel[0] + 0.5f);
-                    const int other_y1 = static_cast<int>(other_pixel[1] + 0.5f);
-
-                    if(other_x0 < 0 || other_y0 < 0 || other_x1 >= other_intrin.width || other_y1 >= other_intrin.height) continue;
-
-                    // Transfer between the depth pixels and the pixels inside the rectangle on the other image
-                    for(int y=other_y0; y<=other_y1; ++y) for(int x=other_x0; x<=other_x1; ++x) transfer_pixel(depth_pixel_index, y * other_intrin.width + x);
-                }
+                clear(y * dest_stride + x, run->x - x);
+                span(y * source_stride + run->x, y * dest_stride + run->x, y * width + run->x, run->count);
+                x = run->x + run->count;
             }
-        }    
+            clear(y * dest_stride + x, width - x);
+        }
     }
 
-    void align_z_to_other(byte * z_aligned_to_other, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin)
+    // Calls span(source, dest, pixel, count) for the rows of the tiles of the depth image that changed alone, leaving the points of the others as
+    // they were. Neighbouring tiles make one span.
+    template<class SPAN> void for_each_changed_span(int width, int height, const image_strides & strides, SPAN span)
     {
-        auto out_z = (uint16_t *)(z_aligned_to_other);
-        align_images(z_intrin, z_to_other, other_intrin, 
-            [z_pixels, z_scale](int z_pixel_index) { return z_scale * z_pixels[z_pixel_index]; },
-            [out_z, z_pixels](int z_pixel_index, int other_pixel_index) { out_z[other_pixel_index] = out_z[other_pixel_index] ? std::min(out_z[other_pixel_index],z_pixels[z_pixel_index]) : z_pixels[z_pixel_index]; });
+        const int source_stride = strides.source ? strides.source : width, dest_stride = strides.dest ? strides.dest : width;
+        const auto & tiles = *strides.source_changes;
+        assert(tiles.columns * changed_tiles::tile_width >= width && tiles.rows * changed_tiles::tile_height >= height);
+        get_shared_parallel_pool().parallel_for(tiles.rows, [&](int tile_row)
+        {
+            const auto changed = tiles.changed.data() + tile_row * tiles.columns;
+            const int y0 = tile_row * changed_tiles::tile_height, y1 = std::min<int>(y0 + changed_tiles::tile_height, height);
+            for(int i = 0; i < tiles.columns;)
+            {
+                if(!changed[i]) { ++i; continue; }
+                int end = i + 1;
+                while(end < tiles.columns && changed[end]) ++end;
+                const int x = i * changed_tiles::tile_width, count = std::min<int>(end * changed_tiles::tile_width, width) - x;
+                for(int y = y0; y < y1; ++y) span(y * source_stride + x, y * dest_stride + x, y * width + x, count);
+                i = end;
+            }
+        });
     }
 
-    void align_disparity_to_other(byte * disparity_aligned_to_other, const uint16_t * disparity_pixels, float disparity_scale, const rs_intrinsics & disparity_intrin, const rs_extrinsics & disparity_to_other, const rs_intrinsics & other_intrin)
+    // Deprojects the spans of the image the strides call for: the tiles that changed, the runs of valid pixels, or every row
+    template<class SPAN, class CLEAR> void for_each_deprojected_span(int count, int width, const image_strides & strides, SPAN span, CLEAR clear)
     {
-        auto out_disparity = (uint16_t *)(disparity_aligned_to_other);
-        align_images(disparity_intrin, disparity_to_other, other_intrin, 
-            [disparity_pixels, disparity_scale](int disparity_pixel_index) { return disparity_scale / disparity_pixels[disparity_pixel_index]; },
-            [out_disparity, disparity_pixels](int disparity_pixel_index, int other_pixel_index) { out_disparity[other_pixel_index] = disparity_pixels[disparity_pixel_index]; });
+        if(width && strides.source_changes) return for_each_changed_span(width, count / width, strides, span);
+        if(width && strides.source_runs) return for_each_depth_run(width, count / width, strides, span, clear);
+        for_each_run(count, width, strides, span);
     }
 
-    template<int N> struct bytes { char b[N]; };
-    template<int N, class GET_DEPTH> void align_other_to_depth_bytes(byte * other_aligned_to_depth, GET_DEPTH get_depth, const rs_intrinsics & depth_intrin, const rs_extrinsics & depth_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels)
+    template<class POINTS, class MAP_DEPTH> void deproject_depth(byte * points, const std::vector<float> & table, const uint16_t * depth, MAP_DEPTH map_depth, int width, const image_strides & strides)
     {
-        auto in_other = (const bytes<N> *)(other_pixels);
-        auto out_other = (bytes<N> *)(other_aligned_to_depth);
-        align_images(depth_intrin, depth_to_other, other_intrin, get_depth,
-            [out_other, in_other](int depth_pixel_index, int other_pixel_index) { out_other[depth_pixel_index] = in_other[other_pixel_index]; });
+        for_each_deprojected_span(static_cast<int>(table.size() / 2), width, strides, [&](int source, int dest, int pixel, int count)
+        {
+            deproject_run<POINTS>(points + dest * POINTS::point_size, table.data() + pixel * 2, depth + source, count, map_depth);
+        }, [points](int dest, int count) { memset(points + dest * POINTS::point_size, 0, count * POINTS::point_size); });
     }
 
-    template<class GET_DEPTH> void align_other_to_depth(byte * other_aligned_to_depth, GET_DEPTH get_depth, const rs_intrinsics & depth_intrin, const rs_extrinsics & depth_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels, rs_format other_format)
+    // As deproject_run(...), into separate planes of X, Y and Z, so the rays are split rather than the points interleaved
+    template<class MAP_DEPTH> void deproject_run_planar(float * x, float * y, float * z, const float * ray, const uint16_t * depth, int count, MAP_DEPTH map_depth)
     {
-        switch(other_format)
+        int i = 0;
+#if defined(RS_SIMD_HAVE_SSSE3)
+        for(; i + 4 <= count; i += 4, depth += 4, ray += 8)
         {
-        case RS_FORMAT_Y8: 
-            align_other_to_depth_bytes<1>(other_aligned_to_depth, get_depth, depth_intrin, depth_to_other, other_intrin, other_pixels); break;
-        case RS_FORMAT_Y16: case RS_FORMAT_Z16: 
-            align_other_to_depth_bytes<2>(other_aligned_to_depth, get_depth, depth_intrin, depth_to_other, other_intrin, other_pixels); break;
-        case RS_FORMAT_RGB8: case RS_FORMAT_BGR8: 
-            align_other_to_depth_bytes<3>(other_aligned_to_depth, get_depth, depth_intrin, depth_to_other, other_intrin, other_pixels); break;
-        case RS_FORMAT_RGBA8: case RS_FORMAT_BGRA8: 
-            align_other_to_depth_bytes<4>(other_aligned_to_depth, get_depth, depth_intrin, depth_to_other, other_intrin, other_pixels); break;
-        default: 
-            assert(false); // NOTE: rs_align_other_to_depth_bytes<2>(...) is not appropriate for RS_FORMAT_YUYV/RS_FORMAT_RAW10 images, no logic prevents U/V channels from being written to one another
+            float d[4];
+            for(int j=0; j<4; ++j) d[j] = map_depth(depth[j]);
+            const __m128 depths = _mm_loadu_ps(d), xy01 = _mm_loadu_ps(ray), xy23 = _mm_loadu_ps(ray + 4);
+            _mm_storeu_ps(x + i, _mm_mul_ps(_mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(2, 0, 2, 0)), depths));
+            _mm_storeu_ps(y + i, _mm_mul_ps(_mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 1, 3, 1)), depths));
+            _mm_storeu_ps(z + i, depths);
+        }
+#elif defined(RS_SIMD_HAVE_NEON)
+        for(; i + 4 <= count; i += 4, depth += 4, ray += 8)
+        {
+            float d[4];
+            for(int j=0; j<4; ++j) d[j] = map_depth(depth[j]);
+            const float32x4_t depths = vld1q_f32(d);
+            const float32x4x2_t xy = vld2q_f32(ray);
+            vst1q_f32(x + i, vmulq_f32(xy.val[0], depths));
+            vst1q_f32(y + i, vmulq_f32(xy.val[1], depths));
+            vst1q_f32(z + i, depths);
+        }
+#endif
+        for(; i < count; ++i, ray += 2)
+        {
+            const float d = map_depth(*depth++);
+            x[i] = d * ray[0];
+            y[i] = d * ray[1];
+            z[i] = d;
         }
     }
 
-    void align_other_to_z(byte * other_aligned_to_z, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels, rs_format other_format)
+    template<class MAP_DEPTH> void deproject_depth_planar(byte * points, const std::vector<float> & table, const uint16_t * depth, MAP_DEPTH map_depth, int width, const image_strides & strides)
     {
-        align_other_to_depth(other_aligned_to_z, [z_pixels, z_scale](int z_pixel_index) { return z_scale * z_pixels[z_pixel_index]; }, z_intrin, z_to_other, other_intrin, other_pixels, other_format);
+        const int count = static_cast<int>(table.size() / 2);
+        const size_t plane = width && strides.dest ? static_cast<size_t>(strides.dest) * (count / width) : count;
+        const auto x = reinterpret_cast<float *>(points), y = x + plane, z = y + plane;
+        for_each_deprojected_span(count, width, strides, [&](int source, int dest, int pixel, int n)
+        {
+            deproject_run_planar(x + dest, y + dest, z + dest, table.data() + pixel * 2, depth + source, n, map_depth);
+        }, [x, y, z](int dest, int n) { for(auto p : { x, y, z }) memset(p + dest, 0, n * sizeof(float)); });
     }
 
-    void align_other_to_disparity(byte * other_aligned_to_disparity, const uint16_t * disparity_pixels, float disparity_scale, const rs_intrinsics & disparity_intrin, const rs_extrinsics & disparity_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels, rs_format other_format)
+    template<class MAP_DEPTH> void deproject_depth(byte * points, rs_format points_format, const std::vector<float> & table, const uint16_t * depth, MAP_DEPTH map_depth, int width, const image_strides & strides)
     {
-        align_other_to_depth(other_aligned_to_disparity, [disparity_pixels, disparity_scale](int disparity_pixel_index) { return disparity_scale / disparity_pixels[disparity_pixel_index]; }, disparity_intrin, disparity_to_other, other_intrin, other_pixels, other_format);
+        switch(points_format)
+        {
+        case RS_FORMAT_XYZ32F: deproject_depth<xyz32f_points>(points, table, depth, map_depth, width, strides); break;
+        case RS_FORMAT_XYZ16F: deproject_depth<xyz16f_points>(points, table, depth, map_depth, width, strides); break;
+        case RS_FORMAT_XYZ16: deproject_depth<xyz16_points>(points, table, depth, map_depth, width, strides); break;
+        case RS_FORMAT_XYZ32F_PLANAR: deproject_depth_planar(points, table, depth, map_depth, width, strides); break;
+        default: throw std::logic_error(to_string() << "cannot deproject into format " << points_format);
+        }
     }
 
-    /////////////////////////
-    // Image rectification //
-    /////////////////////////
+    void deproject_z(byte * points, rs_format points_format, const std::vector<float> & deprojection_table, const uint16_t * z_pixels, float z_scale, int width, const image_strides & strides)
+    {
+        deproject_depth(points, points_format, deprojection_table, z_pixels, [z_scale](uint16_t z) { return z_scale * z; }, width, strides);
+    }
 
-    std::vector<int> compute_rectification_table(const rs_intrinsics & rect_intrin, const rs_extrinsics & rect_to_unrect, const rs_intrinsics & unrect_intrin)
-    {   
-        std::vector<int> rectification_table;
-        rectification_table.resize(rect_intrin.width * rect_intrin.height);
-        align_images(rect_intrin, rect_to_unrect, unrect_intrin, [](int) { return 1.0f; },
-            [&rectification_table](int rect_pixel_index, int unrect_pixel_index) { rectification_table[rect_pixel_index] = unrect_pixel_index; });
-        return rectification_table;
+    void deproject_disparity(byte * points, rs_format points_format, const std::vector<float> & deprojection_table, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth, int width, const image_strides & strides)
+    {
+        auto depth = disparity_to_depth.data();
+        deproject_depth(points, points_format, deprojection_table, disparity_pixels, [depth](uint16_t disparity) { return depth[disparity]; }, width, strides);
+    }
+
+    // Texture coordinates address the centers of the texture pixels, so that a texture sampled at them returns the pixel the point projects to
+    template<class MAP_DEPTH> void deproject_depth_textured(byte * points, const std::vector<float> & table, const uint16_t * depth, MAP_DEPTH map_depth,
+                                                            const rs_extrinsics & depth_to_texture, const rs_intrinsics & texture_intrin, int width, const image_strides & strides)
+    {
+        const float u_scale = 1.0f / texture_intrin.width, v_scale = 1.0f / texture_intrin.height;
+        for_each_run(static_cast<int>(table.size() / 2), width, strides, [&](int source, int dest, int pixel, int count)
+        {
+            const float * ray = table.data() + pixel * 2;
+            byte * out = points + dest * sizeof(float) * 5;
+            for(int i = 0; i < count; ++i, ray += 2, out += sizeof(float) * 5)
+            {
+                const float z = map_depth(depth[source + i]);
+                float xyzuv[5] = { z * ray[0], z * ray[1], z, 0, 0 };
+                if(z > 0)
+                {
+                    float texture_point[3], texture_pixel[2];
+                    rs_transform_point_to_point(texture_point, &depth_to_texture, xyzuv);
+                    rs_project_point_to_pixel(texture_pixel, &texture_intrin, texture_point);
+                    xyzuv[3] = (texture_pixel[0] + 0.5f) * u_scale;
+                    xyzuv[4] = (texture_pixel[1] + 0.5f) * v_scale;
+                }
+                memcpy(out, xyzuv, sizeof(xyzuv));
+            }
+        });
     }
 
-    template<class T> void rectify_image_pixels(T * rect_pixels, const std::vector<int> & rectification_table, const T * unrect_pixels)
+    void deproject_z_textured(byte * points, const std::vector<float> & deprojection_table, const uint16_t * z_pixels, float z_scale, const rs_extrinsics & depth_to_texture, const rs_intrinsics & texture_intrin,
+                              int width, const image_strides & strides)
     {
-        for(auto entry : rectification_table) *rect_pixels++ = unrect_pixels[entry];
+        deproject_depth_textured(points, deprojection_table, z_pixels, [z_scale](uint16_t z) { return z_scale * z; }, depth_to_texture, texture_intrin, width, strides);
     }
 
-    void rectify_image(uint8_t * rect_pixels, const std::vector<int> & rectification_table, const uint8_t * unrect_pixels, rs_format format)
+    void deproject_disparity_textured(byte * points, const std::vector<float> & deprojection_table, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth,
+                                      const rs_extrinsics & depth_to_texture, const rs_intrinsics & texture_intrin, int width, const image_strides & strides)
     {
-        switch(format)
+        auto depth = disparity_to_depth.data();
+        deproject_depth_textured(points, deprojection_table, disparity_pixels, [depth](uint16_t disparity) { return depth[disparity]; }, depth_to_texture, texture_intrin, width, strides);
+    }
+
+    // Normals of the pixels between a row of points and the rows above and below it, each row held as spans of its x, y and z coordinates, so
+    // that four neighbours along the row are a single load. The normal is the cross product of the vertical and horizontal differences of the
+    // neighbouring points, which faces the camera.
+    static void normals_run(float * normals, const float * above, const float * row, const float * below, int width)
+    {
+        const float * x = row, * y = row + width, * z = row + width * 2;
+        const float * above_z = above + width * 2, * below_z = below + width * 2;
+        int i = 1;
+#if defined(RS_SIMD_HAVE_SSSE3) || defined(RS_SIMD_HAVE_NEON)
+        for(; i + 4 < width; i += 4)
         {
-        case RS_FORMAT_Y8: 
-            return rectify_image_pixels((bytes<1> *)rect_pixels, rectification_table, (const bytes<1> *)unrect_pixels);
-        case RS_FORMAT_Y16: case RS_FORMAT_Z16: 
-            return rectify_image_pixels((bytes<2> *)rect_pixels, rectification_table, (const bytes<2> *)unrect_pixels);
-        case RS_FORMAT_RGB8: case RS_FORMAT_BGR8: 
-            return rectify_image_pixels((bytes<3> *)rect_pixels, rectification_table, (const bytes<3> *)unrect_pixels);
-        case RS_FORMAT_RGBA8: case RS_FORMAT_BGRA8: 
-            return rectify_image_pixels((bytes<4> *)rect_pixels, rectification_table, (const bytes<4> *)unrect_pixels);
-        default: 
-            assert(false); // NOTE: rectify_image_pixels(...) is not appropriate for RS_FORMAT_YUYV images, no logic prevents U/V channels from being written to one another
+#if defined(RS_SIMD_HAVE_SSSE3)
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 hx = _mm_sub_ps(_mm_loadu_ps(x + i + 1), _mm_loadu_ps(x + i - 1)), vx = _mm_sub_ps(_mm_loadu_ps(below + i), _mm_loadu_ps(above + i));
+            const __m128 hy = _mm_sub_ps(_mm_loadu_ps(y + i + 1), _mm_loadu_ps(y + i - 1)), vy = _mm_sub_ps(_mm_loadu_ps(below + width + i), _mm_loadu_ps(above + width + i));
+            const __m128 left = _mm_loadu_ps(z + i - 1), right = _mm_loadu_ps(z + i + 1), up = _mm_loadu_ps(above_z + i), down = _mm_loadu_ps(below_z + i);
+            const __m128 hz = _mm_sub_ps(right, left), vz = _mm_sub_ps(down, up);
+            const __m128 nx = _mm_sub_ps(_mm_mul_ps(vy, hz), _mm_mul_ps(vz, hy));
+            const __m128 ny = _mm_sub_ps(_mm_mul_ps(vz, hx), _mm_mul_ps(vx, hz));
+            const __m128 nz = _mm_sub_ps(_mm_mul_ps(vx, hy), _mm_mul_ps(vy, hx));
+            const __m128 length_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+
+            // Masking clears the normals of pixels missing a neighbour, and the NaNs of zero lengths
+            __m128 valid = _mm_and_ps(_mm_cmpgt_ps(_mm_loadu_ps(z + i), zero), _mm_cmpgt_ps(length_squared, zero));
+            valid = _mm_and_ps(valid, _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(left, zero), _mm_cmpgt_ps(right, zero)), _mm_and_ps(_mm_cmpgt_ps(up, zero), _mm_cmpgt_ps(down, zero))));
+            const __m128 length = _mm_sqrt_ps(length_squared);
+            const __m128 ux = _mm_and_ps(valid, _mm_div_ps(nx, length)), uy = _mm_and_ps(valid, _mm_div_ps(ny, length)), uz = _mm_and_ps(valid, _mm_div_ps(nz, length));
+
+            // Interleave into x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3, as deproject_run(...) does
+            const __m128 xy01 = _mm_unpacklo_ps(ux, uy), xy23 = _mm_unpackhi_ps(ux, uy);
+            const __m128 z0_x1 = _mm_shuffle_ps(uz, xy01, _MM_SHUFFLE(2, 2, 0, 0));
+            const __m128 y1_z1 = _mm_shuffle_ps(xy01, uz, _MM_SHUFFLE(1, 1, 3, 3));
+            const __m128 z2_x3 = _mm_shuffle_ps(uz, xy23, _MM_SHUFFLE(2, 2, 2, 2));
+            const __m128 y3_z3 = _mm_shuffle_ps(xy23, uz, _MM_SHUFFLE(3, 3, 3, 3));
+            xyz32f_points::store(reinterpret_cast<byte *>(normals + i * 3), _mm_shuffle_ps(xy01, z0_x1, _MM_SHUFFLE(2, 0, 1, 0)), _mm_shuffle_ps(y1_z1, xy23, _MM_SHUFFLE(1, 0, 2, 0)), _mm_shuffle_ps(z2_x3, y3_z3, _MM_SHUFFLE(2, 0, 2, 0)));
+#else
+            const float32x4_t zero = vdupq_n_f32(0);
+            const float32x4_t hx = vsubq_f32(vld1q_f32(x + i + 1), vld1q_f32(x + i - 1)), vx = vsubq_f32(vld1q_f32(below + i), vld1q_f32(above + i));
+            const float32x4_t hy = vsubq_f32(vld1q_f32(y + i + 1), vld1q_f32(y + i - 1)), vy = vsubq_f32(vld1q_f32(below + width + i), vld1q_f32(above + width + i));
+            const float32x4_t left = vld1q_f32(z + i - 1), right = vld1q_f32(z + i + 1), up = vld1q_f32(above_z + i), down = vld1q_f32(below_z + i);
+            const float32x4_t hz = vsubq_f32(right, left), vz = vsubq_f32(down, up);
+            const float32x4_t nx = vsubq_f32(vmulq_f32(vy, hz), vmulq_f32(vz, hy));
+            const float32x4_t ny = vsubq_f32(vmulq_f32(vz, hx), vmulq_f32(vx, hz));
+            const float32x4_t nz = vsubq_f32(vmulq_f32(vx, hy), vmulq_f32(vy, hx));
+            const float32x4_t length_squared = vaddq_f32(vaddq_f32(vmulq_f32(nx, nx), vmulq_f32(ny, ny)), vmulq_f32(nz, nz));
+
+            uint32x4_t valid = vandq_u32(vcgtq_f32(vld1q_f32(z + i), zero), vcgtq_f32(length_squared, zero));
+            valid = vandq_u32(valid, vandq_u32(vandq_u32(vcgtq_f32(left, zero), vcgtq_f32(right, zero)), vandq_u32(vcgtq_f32(up, zero), vcgtq_f32(down, zero))));
+#if defined(__aarch64__)
+            const float32x4_t length = vsqrtq_f32(length_squared);
+            const float32x4_t quotients[] = { vdivq_f32(nx, length), vdivq_f32(ny, length), vdivq_f32(nz, length) };
+#else
+            // ARMv7 NEON has no division, so the reciprocal square root estimate is refined twice
+            float32x4_t inverse = vrsqrteq_f32(length_squared);
+            inverse = vmulq_f32(inverse, vrsqrtsq_f32(vmulq_f32(length_squared, inverse), inverse));
+            inverse = vmulq_f32(inverse, vrsqrtsq_f32(vmulq_f32(length_squared, inverse), inverse));
+            const float32x4_t quotients[] = { vmulq_f32(nx, inverse), vmulq_f32(ny, inverse), vmulq_f32(nz, inverse) };
+#endif
+            float32x4x3_t xyz;
+            for(int k = 0; k < 3; ++k) xyz.val[k] = vreinterpretq_f32_u32(vandq_u32(valid, vreinterpretq_u32_f32(quotients[k])));
+            xyz32f_points::store(reinterpret_cast<byte *>(normals + i * 3), xyz);
+#endif
+        }
+#endif
+        for(; i < width - 1; ++i)
+        {
+            const float hx = x[i + 1] - x[i - 1], hy = y[i + 1] - y[i - 1], hz = z[i + 1] - z[i - 1];
+            const float vx = below[i] - above[i], vy = below[width + i] - above[width + i], vz = below_z[i] - above_z[i];
+            const float nx = vy * hz - vz * hy, ny = vz * hx - vx * hz, nz = vx * hy - vy * hx;
+            const float length_squared = nx * nx + ny * ny + nz * nz;
+            const bool valid = z[i] > 0 && z[i - 1] > 0 && z[i + 1] > 0 && above_z[i] > 0 && below_z[i] > 0 && length_squared > 0;
+            const float length = std::sqrt(length_squared);
+            xyz32f_points::store(reinterpret_cast<byte *>(normals + i * 3), valid ? nx / length : 0, valid ? ny / length : 0, valid ? nz / length : 0);
+        }
+    }
+
+    template<class MAP_DEPTH> void compute_depth_normals(float * normals, const std::vector<float> & table, const uint16_t * depth, MAP_DEPTH map_depth, int width, int height, const image_strides & strides)
+    {
+        const int depth_stride = strides.source ? strides.source : width, dest_stride = strides.dest ? strides.dest : width;
+        std::vector<float> ring(width * 3 * 3); // The points of three consecutive rows, row y in slot y % 3
+        auto points_of = [&](int y) { return ring.data() + (y % 3) * width * 3; };
+        auto deproject_row = [&](int y)
+        {
+            float * x = points_of(y), * p_y = x + width, * z = x + width * 2;
+            const float * ray = table.data() + y * width * 2;
+            const uint16_t * pixels = depth + y * depth_stride;
+            for(int i = 0; i < width; ++i, ray += 2)
+            {
+                z[i] = map_depth(pixels[i]);
+                x[i] = z[i] * ray[0];
+                p_y[i] = z[i] * ray[1];
+            }
+        };
+
+        // Every row of points is deprojected once, as the row below the row whose normals are computed next
+        if(height > 0) deproject_row(0);
+        for(int y = 0; y < height; ++y)
+        {
+            if(y + 1 < height) deproject_row(y + 1);
+            float * out = normals + y * dest_stride * 3;
+            if(y == 0 || y + 1 == height || width < 3)
+            {
+                std::fill_n(out, width * 3, 0.0f);
+                continue;
+            }
+            std::fill_n(out, 3, 0.0f);
+            normals_run(out, points_of(y - 1), points_of(y), points_of(y + 1), width);
+            std::fill_n(out + (width - 1) * 3, 3, 0.0f);
+        }
+    }
+
+    void compute_z_normals(float * normals, const std::vector<float> & deprojection_table, const uint16_t * z_pixels, float z_scale, int width, int height, const image_strides & strides)
+    {
+        compute_depth_normals(normals, deprojection_table, z_pixels, [z_scale](uint16_t z) { return z_scale * z; }, width, height, strides);
+    }
+
+    void compute_disparity_normals(float * normals, const std::vector<float> & deprojection_table, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth, int width, int height, const image_strides & strides)
+    {
+        auto depth = disparity_to_depth.data();
+        compute_depth_normals(normals, deprojection_table, disparity_pixels, [depth](uint16_t disparity) { return depth[disparity]; }, width, height, strides);
+    }
+
+    // The integer coordinates of a cube, each clamped to 21 bits and offset to be unsigned, packed above a bit that marks the key as used
+    static uint64_t voxel_coordinate(float f) { return static_cast<uint64_t>(static_cast<int64_t>(std::min(std::max(std::floor(f), -1048576.0f), 1048575.0f)) + 1048576); }
+    static uint64_t voxel_key(float x, float y, float z) { return 1 | voxel_coordinate(x) << 1 | voxel_coordinate(y) << 22 | voxel_coordinate(z) << 43; }
+
+    // Cubes are found through an open addressing table of their keys, which grows with the number of cubes reached rather than with the image
+    class voxel_grid
+    {
+        struct voxel { float x, y, z; uint32_t count; };
+        std::vector<uint64_t> keys;     // Of every slot, zero while it is free
+        std::vector<int32_t> indices;   // Into voxels
+        std::vector<voxel> voxels;
+        int bits;
+
+        size_t find(uint64_t key) const
+        {
+            const size_t mask = keys.size() - 1;
+            size_t slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+            while(keys[slot] && keys[slot] != key) slot = (slot + 1) & mask;
+            return slot;
         }
+        void grow()
+        {
+            auto old_keys = std::move(keys);
+            auto old_indices = std::move(indices);
+            ++bits;
+            keys.assign(size_t(1) << bits, 0);
+            indices.assign(size_t(1) << bits, 0);
+            for(size_t i = 0; i < old_keys.size(); ++i)
+            {
+                if(!old_keys[i]) continue;
+                const auto slot = find(old_keys[i]);
+                keys[slot] = old_keys[i];
+                indices[slot] = old_indices[i];
+            }
+        }
+    public:
+        voxel_grid() : keys(1024), indices(1024), bits(10) {}
+
+        void add(uint64_t key, float x, float y, float z)
+        {
+            auto slot = find(key);
+            if(keys[slot])
+            {
+                auto & v = voxels[indices[slot]];
+                v.x += x;
+                v.y += y;
+                v.z += z;
+                ++v.count;
+                return;
+            }
+            if((voxels.size() + 1) * 2 > keys.size())
+            {
+                grow();
+                slot = find(key);
+            }
+            keys[slot] = key;
+            indices[slot] = static_cast<int32_t>(voxels.size());
+            const voxel v = { x, y, z, 1 };
+            voxels.push_back(v);
+        }
+
+        template<class POINTS> int store(byte * points) const
+        {
+            for(auto & v : voxels) POINTS::store(points + (&v - voxels.data()) * POINTS::point_size, v.x / v.count, v.y / v.count, v.z / v.count);
+            return static_cast<int>(voxels.size());
+        }
+    };
+
+    template<class POINTS, class MAP_DEPTH> int deproject_depth_to_voxels(byte * points, const std::vector<float> & table, const uint16_t * depth, MAP_DEPTH map_depth, float leaf_size, int width, int depth_stride)
+    {
+        const int count = static_cast<int>(table.size() / 2);
+        const float cubes_per_meter = 1 / leaf_size;
+        voxel_grid grid;
+        for_each_run(count, width, image_strides(depth_stride), [&](int source, int, int pixel, int run)
+        {
+            const float * ray = table.data() + pixel * 2;
+            for(int i = 0; i < run; ++i, ray += 2)
+            {
+                const float z = map_depth(depth[source + i]);
+                if(!(z > 0)) continue;
+                const float x = z * ray[0], y = z * ray[1];
+                grid.add(voxel_key(x * cubes_per_meter, y * cubes_per_meter, z * cubes_per_meter), x, y, z);
+            }
+        });
+        const int written = grid.store<POINTS>(points);
+        if(written < count) memset(points + written * POINTS::point_size, 0, static_cast<size_t>(count - written) * POINTS::point_size);
+        return written;
+    }
+
+    template<class MAP_DEPTH> int deproject_depth_to_voxels(byte * points, rs_format points_format, const std::vector<float> & table, const uint16_t * depth, MAP_DEPTH map_depth, float leaf_size, int width, int depth_stride)
+    {
+        switch(points_format)
+        {
+        case RS_FORMAT_XYZ32F: return deproject_depth_to_voxels<xyz32f_points>(points, table, depth, map_depth, leaf_size, width, depth_stride);
+        case RS_FORMAT_XYZ16F: return deproject_depth_to_voxels<xyz16f_points>(points, table, depth, map_depth, leaf_size, width, depth_stride);
+        case RS_FORMAT_XYZ16: return deproject_depth_to_voxels<xyz16_points>(points, table, depth, map_depth, leaf_size, width, depth_stride);
+        default: throw std::logic_error(to_string() << "cannot deproject voxels into format " << points_format);
+        }
+    }
+
+    int deproject_z_to_voxels(byte * points, rs_format points_format, const std::vector<float> & deprojection_table, const uint16_t * z_pixels, float z_scale, float leaf_size, int width, int z_stride)
+    {
+        return deproject_depth_to_voxels(points, points_format, deprojection_table, z_pixels, [z_scale](uint16_t z) { return z_scale * z; }, leaf_size, width, z_stride);
+    }
+
+    int deproject_disparity_to_voxels(byte * points, rs_format points_format, const std::vector<float> & deprojection_table, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth, float leaf_size,
+                                      int width, int disparity_stride)
+    {
+        auto depth = disparity_to_depth.data();
+        return deproject_depth_to_voxels(points, points_format, deprojection_table, disparity_pixels, [depth](uint16_t disparity) { return depth[disparity]; }, leaf_size, width, disparity_stride);
+    }
+
+    // Deprojects the pixels of a run which have depth and moves them into another frame of reference in the same pass, calling emit(x, y, z)
+    // for every point in order. Both paths round exactly as rs_transform_point_to_point(...) does.
+    template<class EMIT> void deproject_transform_run(const float * ray, const uint16_t * depth, int count, float z_scale, const rs_extrinsics & transform, EMIT emit)
+    {
+        int i = 0;
+        const float * r = transform.rotation, * t = transform.translation;
+#if defined(RS_SIMD_HAVE_SSSE3)
+        const __m128 scale = _mm_set1_ps(z_scale);
+        const __m128 r0 = _mm_set1_ps(r[0]), r1 = _mm_set1_ps(r[1]), r2 = _mm_set1_ps(r[2]), r3 = _mm_set1_ps(r[3]), r4 = _mm_set1_ps(r[4]);
+        const __m128 r5 = _mm_set1_ps(r[5]), r6 = _mm_set1_ps(r[6]), r7 = _mm_set1_ps(r[7]), r8 = _mm_set1_ps(r[8]);
+        const __m128 t0 = _mm_set1_ps(t[0]), t1 = _mm_set1_ps(t[1]), t2 = _mm_set1_ps(t[2]);
+        for(; i + 4 <= count; i += 4, depth += 4, ray += 8)
+        {
+            const __m128i z16 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(depth));
+            const __m128 z = _mm_mul_ps(scale, _mm_cvtepi32_ps(_mm_unpacklo_epi16(z16, _mm_setzero_si128())));
+            const int valid = _mm_movemask_ps(_mm_cmpgt_ps(z, _mm_setzero_ps()));
+            if(!valid) continue;
+            const __m128 xy01 = _mm_loadu_ps(ray), xy23 = _mm_loadu_ps(ray + 4);
+            const __m128 x = _mm_mul_ps(z, _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(2, 0, 2, 0)));
+            const __m128 y = _mm_mul_ps(z, _mm_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 1, 3, 1)));
+            float px[4], py[4], pz[4];
+            _mm_storeu_ps(px, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, x), _mm_mul_ps(r3, y)), _mm_mul_ps(r6, z)), t0));
+            _mm_storeu_ps(py, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r1, x), _mm_mul_ps(r4, y)), _mm_mul_ps(r7, z)), t1));
+            _mm_storeu_ps(pz, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r2, x), _mm_mul_ps(r5, y)), _mm_mul_ps(r8, z)), t2));
+            for(int j = 0; j < 4; ++j) if(valid & (1 << j)) emit(px[j], py[j], pz[j]);
+        }
+#elif defined(RS_SIMD_HAVE_NEON)
+        const float32x4_t scale = vdupq_n_f32(z_scale);
+        for(; i + 4 <= count; i += 4, depth += 4, ray += 8)
+        {
+            const float32x4_t z = vmulq_f32(scale, vcvtq_f32_u32(vmovl_u16(vld1_u16(depth))));
+            const uint32x4_t valid = vcgtq_f32(z, vdupq_n_f32(0));
+            if(!(vgetq_lane_u32(valid, 0) | vgetq_lane_u32(valid, 1) | vgetq_lane_u32(valid, 2) | vgetq_lane_u32(valid, 3))) continue;
+            const float32x4x2_t xy = vld2q_f32(ray);
+            const float32x4_t x = vmulq_f32(z, xy.val[0]), y = vmulq_f32(z, xy.val[1]);
+            float px[4], py[4], pz[4], pz_in[4];
+            // Separate multiplies and adds rather than fused ones, so that the points match the scalar path
+            vst1q_f32(px, vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(x, r[0]), vmulq_n_f32(y, r[3])), vmulq_n_f32(z, r[6])), vdupq_n_f32(t[0])));
+            vst1q_f32(py, vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(x, r[1]), vmulq_n_f32(y, r[4])), vmulq_n_f32(z, r[7])), vdupq_n_f32(t[1])));
+            vst1q_f32(pz, vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(x, r[2]), vmulq_n_f32(y, r[5])), vmulq_n_f32(z, r[8])), vdupq_n_f32(t[2])));
+            vst1q_f32(pz_in, z);
+            for(int j = 0; j < 4; ++j) if(pz_in[j] > 0) emit(px[j], py[j], pz[j]);
+        }
+#endif
+        for(; i < count; ++i, ray += 2)
+        {
+            const float z = z_scale * *depth++;
+            if(!(z > 0)) continue;
+            const float point[] = { z * ray[0], z * ray[1], z };
+            float moved[3];
+            rs_transform_point_to_point(moved, &transform, point);
+            emit(moved[0], moved[1], moved[2]);
+        }
+    }
+
+    int fuse_depth_to_points(float * points, const std::vector<fused_depth_image> & images, float leaf_size)
+    {
+        int written = 0;
+        if(leaf_size > 0)
+        {
+            const float cubes_per_meter = 1 / leaf_size;
+            voxel_grid grid;
+            auto add = [&](float x, float y, float z) { grid.add(voxel_key(x * cubes_per_meter, y * cubes_per_meter, z * cubes_per_meter), x, y, z); };
+            for(auto & image : images)
+            {
+                for_each_run(image.width * image.height, image.width, image_strides(image.z_stride), [&](int source, int, int pixel, int count)
+                {
+                    deproject_transform_run(image.deprojection_table->data() + pixel * 2, image.z_pixels + source, count, image.z_scale, image.to_common, add);
+                });
+            }
+            return grid.store<xyz32f_points>(reinterpret_cast<byte *>(points));
+        }
+
+        for(auto & image : images)
+        {
+            for_each_run(image.width * image.height, image.width, image_strides(image.z_stride), [&](int source, int, int pixel, int count)
+            {
+                deproject_transform_run(image.deprojection_table->data() + pixel * 2, image.z_pixels + source, count, image.z_scale, image.to_common, [&](float x, float y, float z)
+                {
+                    float * p = points + written++ * 3;
+                    p[0] = x;
+                    p[1] = y;
+                    p[2] = z;
+                });
+            });
+        }
+        return written;
+    }
+
+    ////////////////////////////////////
+    // Batch projection and transform //
+    ////////////////////////////////////
+
+    // The AVX2 kernels when the running CPU has them, then those of the instruction set the whole build targets, then the functions of rsutil.h
+    static const projection_kernels * const wide_projection_kernels = query_cpu_features().avx2 ? get_projection_kernels_avx2() : nullptr;
+
+    void project_points_to_pixels(float * pixels, const rs_intrinsics & intrin, const float * points, int count)
+    {
+        const bool distorted = intrin.model == RS_DISTORTION_MODIFIED_BROWN_CONRADY;
+        int i = 0;
+        if(wide_projection_kernels) i = (distorted ? wide_projection_kernels->project_distorted : wide_projection_kernels->project)(pixels, intrin, points, count);
+#if defined(RS_SIMD_HAVE_SSSE3)
+        i += (distorted ? &project_points_simd<sse_float_ops, true> : &project_points_simd<sse_float_ops, false>)(pixels + i * 2, intrin, points + i * 3, count - i);
+#elif defined(RS_SIMD_HAVE_NEON) && defined(__aarch64__)
+        i += (distorted ? &project_points_simd<neon_float_ops, true> : &project_points_simd<neon_float_ops, false>)(pixels + i * 2, intrin, points + i * 3, count - i);
+#endif
+        for(; i < count; ++i) rs_project_point_to_pixel(pixels + i * 2, &intrin, points + i * 3);
+    }
+
+    void deproject_pixels_to_points(float * points, const rs_intrinsics & intrin, const float * pixels, const float * depths, int count)
+    {
+        const bool distorted = intrin.model == RS_DISTORTION_INVERSE_BROWN_CONRADY;
+        int i = 0;
+        if(wide_projection_kernels) i = (distorted ? wide_projection_kernels->deproject_undistorted : wide_projection_kernels->deproject)(points, intrin, pixels, depths, count);
+#if defined(RS_SIMD_HAVE_SSSE3)
+        i += (distorted ? &deproject_pixels_simd<sse_float_ops, true> : &deproject_pixels_simd<sse_float_ops, false>)(points + i * 3, intrin, pixels + i * 2, depths + i, count - i);
+#elif defined(RS_SIMD_HAVE_NEON) && defined(__aarch64__)
+        i += (distorted ? &deproject_pixels_simd<neon_float_ops, true> : &deproject_pixels_simd<neon_float_ops, false>)(points + i * 3, intrin, pixels + i * 2, depths + i, count - i);
+#endif
+        for(; i < count; ++i) rs_deproject_pixel_to_point(points + i * 3, &intrin, pixels + i * 2, depths[i]);
+    }
+
+    void transform_points_to_points(float * to_points, const rs_extrinsics & extrin, const float * from_points, int count)
+    {
+        int i = 0;
+        if(wide_projection_kernels) i = wide_projection_kernels->transform(to_points, extrin, from_points, count);
+#if defined(RS_SIMD_HAVE_SSSE3)
+        i += transform_points_simd<sse_float_ops>(to_points + i * 3, extrin, from_points + i * 3, count - i);
+#elif defined(RS_SIMD_HAVE_NEON) && defined(__aarch64__)
+        i += transform_points_simd<neon_float_ops>(to_points + i * 3, extrin, from_points + i * 3, count - i);
+#endif
+        for(; i < count; ++i)
+        {
+            const float from[] = { from_points[i * 3], from_points[i * 3 + 1], from_points[i * 3 + 2] }; // Copied, as the arrays may be the same
+            rs_transform_point_to_point(to_points + i * 3, &extrin, from);
+        }
+    }
+
+    ////////////////////////////////
+    // Disparity to depth tables //
+    ////////////////////////////////
+
+    std::vector<float> compute_disparity_to_depth_table(float disparity_scale)
+    {
+        std::vector<float> table(65536);
+        for(size_t d = 1; d < table.size(); ++d) table[d] = disparity_scale / d; // A disparity of zero carries no data, and maps to no depth
+        return table;
+    }
+
+    static std::vector<uint16_t> compute_disparity_to_z16_table(float disparity_scale, float z_scale)
+    {
+        std::vector<uint16_t> table(65536);
+        for(size_t d = 1; d < table.size(); ++d)
+        {
+            // Depths beyond the range of Z16 are reported as no data, like values outside the depth clamp of the camera
+            const double z = std::floor(disparity_scale / (d * static_cast<double>(z_scale)) + 0.5);
+            table[d] = z < 65536 ? static_cast<uint16_t>(z) : 0;
+        }
+        return table;
+    }
+
+    // The scales only change when the disparity multiplier or the depth units do, so the most recent table is kept for every following frame
+    struct disparity_to_z16_table { float disparity_scale, z_scale; std::vector<uint16_t> z; };
+    static std::mutex z16_table_mutex;
+    static std::shared_ptr<const disparity_to_z16_table> z16_table;
+
+    void convert_disparity_to_z16(uint16_t * z_pixels, const uint16_t * disparity_pixels, int count, float disparity_scale, float z_scale)
+    {
+        std::shared_ptr<const disparity_to_z16_table> table;
+        {
+            std::lock_guard<std::mutex> lock(z16_table_mutex);
+            if(!z16_table || z16_table->disparity_scale != disparity_scale || z16_table->z_scale != z_scale)
+            {
+                auto t = std::make_shared<disparity_to_z16_table>();
+                t->disparity_scale = disparity_scale;
+                t->z_scale = z_scale;
+                t->z = compute_disparity_to_z16_table(disparity_scale, z_scale);
+                z16_table = t;
+            }
+            table = z16_table;
+        }
+        auto z = table->z.data();
+        for(int i = 0; i < count; ++i) z_pixels[i] = z[disparity_pixels[i]];
+    }
+
+    //////////////////////
+    // Depth decimation //
+    //////////////////////
+
+    // Both reducers only consider the pixels of a block which carry data, so holes never drag the result towards zero
+    static uint16_t median_of_valid(uint16_t * block, int count)
+    {
+        int valid = 0;
+        for(int i = 0; i < count; ++i) if(block[i]) block[valid++] = block[i];
+        if(!valid) return 0;
+        for(int i = 1; i < valid; ++i) // Insertion sort, there are at most RS_MAX_DEPTH_DECIMATION squared values
+        {
+            const uint16_t v = block[i];
+            int j = i;
+            for(; j > 0 && block[j-1] > v; --j) block[j] = block[j-1];
+            block[j] = v;
+        }
+        return block[(valid - 1) / 2]; // The nearer of the two middle values when their count is even
+    }
+
+    static uint16_t mean_of_valid(const uint16_t * block, int count)
+    {
+        uint32_t sum = 0, valid = 0;
+        for(int i = 0; i < count; ++i) { sum += block[i]; valid += block[i] != 0; }
+        return valid ? static_cast<uint16_t>((sum + valid / 2) / valid) : 0;
+    }
+
+    // Decimated row y only reads source rows from y * factor on, and is written over rows which have already been read, so this works in place
+    void decimate_depth(uint16_t * pixels, int width, int height, int factor, bool mean)
+    {
+        const int out_width = width / factor, out_height = height / factor, block_size = factor * factor;
+        uint16_t block[RS_MAX_DEPTH_DECIMATION * RS_MAX_DEPTH_DECIMATION];
+        uint16_t * out = pixels;
+        for(int y = 0; y < out_height; ++y)
+        {
+            const uint16_t * row = pixels + y * factor * width;
+            for(int x = 0; x < out_width; ++x, ++out)
+            {
+                auto b = block;
+                for(int j = 0; j < factor; ++j) for(int i = 0; i < factor; ++i) *b++ = row[j * width + x * factor + i];
+                *out = mean ? mean_of_valid(block, block_size) : median_of_valid(block, block_size);
+            }
+        }
+    }
+
+    size_t get_depth_pyramid_size(int width, int height, int levels)
+    {
+        size_t size = 0;
+        for(int k = 1; k <= levels; ++k) size += static_cast<size_t>(width >> k) * (height >> k) * sizeof(uint16_t);
+        return size;
+    }
+
+    // Row y of a level from rows 2y and 2y + 1 of the level above, the pixels with no data left out of every mean
+    static void reduce_depth_row(uint16_t * out, const uint16_t * top, const uint16_t * bottom, int out_width)
+    {
+        for(int x = 0; x < out_width; ++x)
+        {
+            const uint16_t a = top[2*x], b = top[2*x+1], c = bottom[2*x], d = bottom[2*x+1];
+            const uint32_t sum = a + b + c + d, valid = (a != 0) + (b != 0) + (c != 0) + (d != 0);
+            out[x] = valid ? static_cast<uint16_t>((sum + valid / 2) / valid) : 0;
+        }
+    }
+
+    // Every row of a level is reduced as soon as its second source row is, so the rows of all levels are read again while still in cache
+    void build_depth_pyramid(uint16_t * pyramid, const uint16_t * pixels, int width, int height, int levels)
+    {
+        if(levels <= 0) return;
+        const uint16_t * level_pixels[RS_MAX_DEPTH_PYRAMID_LEVELS + 1] = { pixels };
+        int widths[RS_MAX_DEPTH_PYRAMID_LEVELS + 1] = { width }, heights[RS_MAX_DEPTH_PYRAMID_LEVELS + 1] = { height };
+        uint16_t * levels_out[RS_MAX_DEPTH_PYRAMID_LEVELS + 1] = {};
+        for(int k = 1; k <= levels; ++k)
+        {
+            widths[k] = width >> k;
+            heights[k] = height >> k;
+            levels_out[k] = pyramid;
+            level_pixels[k] = pyramid;
+            pyramid += widths[k] * heights[k];
+        }
+
+        for(int y = 0; y < heights[1]; ++y)
+        {
+            int row = y;
+            for(int k = 1; k <= levels; ++k)
+            {
+                reduce_depth_row(levels_out[k] + row * widths[k], level_pixels[k-1] + 2 * row * widths[k-1], level_pixels[k-1] + (2 * row + 1) * widths[k-1], widths[k]);
+                if(k == levels || row % 2 == 0 || row / 2 >= heights[k+1]) break; // The next level waits for the second of its source rows
+                row /= 2;
+            }
+        }
+    }
+
+    size_t get_depth_runs_size(int width, int height)
+    {
+        return (height + 1) * sizeof(uint32_t) + static_cast<size_t>(height) * ((width + 1) / 2) * sizeof(depth_run);
+    }
+
+    size_t get_depth_runs_offset(int width, int height, int pyramid_levels)
+    {
+        const size_t end = static_cast<size_t>(width) * height * sizeof(uint16_t) + get_depth_pyramid_size(width, height, pyramid_levels);
+        return (end + alignof(uint32_t) - 1) & ~(alignof(uint32_t) - 1);
+    }
+
+#if defined(RS_SIMD_HAVE_SSSE3)
+    static bool all_depth_x8_zero(const uint16_t * p) { return _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), _mm_setzero_si128())) == 0xFFFF; }
+    static bool all_depth_x8_valid(const uint16_t * p) { return _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), _mm_setzero_si128())) == 0; }
+#elif defined(RS_SIMD_HAVE_NEON)
+    static uint64_t depth_x8_zero_lanes(const uint16_t * p) { return vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(vceqq_u16(vld1q_u16(p), vdupq_n_u16(0)))), 0); } // A byte of ones per pixel with no data
+    static bool all_depth_x8_zero(const uint16_t * p) { return depth_x8_zero_lanes(p) == ~uint64_t(0); }
+    static bool all_depth_x8_valid(const uint16_t * p) { return depth_x8_zero_lanes(p) == 0; }
+#endif
+
+    bool changed_tiles::any_within(const rectification_table::window & pixels) const
+    {
+        const int x0 = std::max(pixels.x0 / tile_width, 0), x1 = std::min(pixels.x1 / tile_width, columns - 1);
+        const int y0 = std::max(pixels.y0 / tile_height, 0), y1 = std::min(pixels.y1 / tile_height, rows - 1);
+        for(int y = y0; y <= y1; ++y) for(int x = x0; x <= x1; ++x) if(changed[y * columns + x]) return true;
+        return false;
+    }
+
+#if defined(RS_SIMD_HAVE_SSSE3)
+    static bool bytes_x16_equal(const byte * a, const byte * b) { return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a)), _mm_loadu_si128(reinterpret_cast<const __m128i *>(b)))) == 0xFFFF; }
+#elif defined(RS_SIMD_HAVE_NEON)
+    static bool bytes_x16_equal(const byte * a, const byte * b) { const uint64x2_t diff = vreinterpretq_u64_u8(veorq_u8(vld1q_u8(a), vld1q_u8(b))); return (vgetq_lane_u64(diff, 0) | vgetq_lane_u64(diff, 1)) == 0; }
+#endif
+
+    static bool bytes_equal(const byte * a, const byte * b, int count)
+    {
+        int i = 0;
+#if defined(RS_SIMD_HAVE_SSSE3) || defined(RS_SIMD_HAVE_NEON)
+        for(; i + 16 <= count; i += 16) if(!bytes_x16_equal(a + i, b + i)) return false;
+#endif
+        return memcmp(a + i, b + i, count - i) == 0;
+    }
+
+    // Comparing a tile stops at its first row that differs
+    void find_changed_tiles(changed_tiles & tiles, const byte * previous, int previous_stride, const byte * current, int current_stride, int width, int height, int pixel_size)
+    {
+        tiles.columns = (width + changed_tiles::tile_width - 1) / changed_tiles::tile_width;
+        tiles.rows = (height + changed_tiles::tile_height - 1) / changed_tiles::tile_height;
+        tiles.changed.assign(tiles.columns * tiles.rows, 0);
+        tiles.count = 0;
+        for(int tile_row = 0; tile_row < tiles.rows; ++tile_row)
+        {
+            const int y0 = tile_row * changed_tiles::tile_height, y1 = std::min<int>(y0 + changed_tiles::tile_height, height);
+            for(int i = 0; i < tiles.columns; ++i)
+            {
+                const int x = i * changed_tiles::tile_width, bytes = (std::min<int>(x + changed_tiles::tile_width, width) - x) * pixel_size;
+                for(int y = y0; y < y1; ++y)
+                {
+                    if(bytes_equal(previous + (y * previous_stride + x) * pixel_size, current + (y * current_stride + x) * pixel_size, bytes)) continue;
+                    tiles.changed[tile_row * tiles.columns + i] = 1;
+                    ++tiles.count;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Blocks of eight pixels all with or all without data are stepped over whole, so only the pixels around the edges of runs are tested one by one
+    int find_depth_runs(uint32_t * row_runs, const uint16_t * pixels, int width, int height)
+    {
+        auto runs = reinterpret_cast<depth_run *>(row_runs + height + 1), run = runs;
+        row_runs[0] = 0;
+        for(int y = 0; y < height; ++y)
+        {
+            const uint16_t * row = pixels + y * width;
+            for(int x = 0;;)
+            {
+#if defined(RS_SIMD_HAVE_SSSE3) || defined(RS_SIMD_HAVE_NEON)
+                while(x + 8 <= width && all_depth_x8_zero(row + x)) x += 8;
+#endif
+                while(x < width && !row[x]) ++x;
+                if(x == width) break;
+                const int begin = x;
+#if defined(RS_SIMD_HAVE_SSSE3) || defined(RS_SIMD_HAVE_NEON)
+                while(x + 8 <= width && all_depth_x8_valid(row + x)) x += 8;
+#endif
+                while(x < width && row[x]) ++x;
+                run->x = static_cast<uint16_t>(begin);
+                run->count = static_cast<uint16_t>(x - begin);
+                ++run;
+            }
+            row_runs[y + 1] = static_cast<uint32_t>(run - runs);
+        }
+        return static_cast<int>(run - runs);
+    }
+
+    /////////////////////
+    // Depth filtering //
+    /////////////////////
+
+    // Blends a pixel with its already filtered neighbour, unless either has no data or they lie delta or more apart. alpha is the weight of the pixel
+    // in 1/256, and the arithmetic is integer, so that the vectorized filters agree with this one bit for bit.
+    static uint16_t blend_depth(uint16_t pixel, uint16_t neighbour, int alpha, int delta)
+    {
+        if(!pixel || !neighbour || std::abs(pixel - neighbour) >= delta) return pixel;
+        return static_cast<uint16_t>(neighbour + (((pixel - neighbour) * alpha + 128) >> 8));
+    }
+
+    static int depth_blend_weight(float alpha) { return static_cast<int>(std::min(std::max(alpha, 0.0f), 1.0f) * 256 + 0.5f); }
+
+#if defined(RS_SIMD_HAVE_SSSE3)
+    typedef __m128i depth_x8;
+    static depth_x8 load_depth_x8(const uint16_t * p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+    static void store_depth_x8(uint16_t * p, depth_x8 v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+
+    // Eight blend_depth(...) at once. The differences which are blended stay below delta, so they fit 16 bits, and pmaddwd forms diff * alpha + 128
+    struct depth_blend_x8
+    {
+        __m128i alpha_and_rounding, delta_minus_one;
+        depth_blend_x8(int alpha, int delta) : alpha_and_rounding(_mm_set1_epi32(128 << 16 | alpha)), delta_minus_one(_mm_set1_epi16(static_cast<short>(delta - 1))) {}
+        __m128i operator()(__m128i pixel, __m128i neighbour) const
+        {
+            const __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi16(1);
+            const __m128i distance = _mm_or_si128(_mm_subs_epu16(pixel, neighbour), _mm_subs_epu16(neighbour, pixel));
+            const __m128i holes = _mm_or_si128(_mm_cmpeq_epi16(pixel, zero), _mm_cmpeq_epi16(neighbour, zero));
+            const __m128i blend = _mm_andnot_si128(holes, _mm_cmpeq_epi16(_mm_subs_epu16(distance, delta_minus_one), zero));
+            const __m128i diff = _mm_sub_epi16(pixel, neighbour);
+            const __m128i lo = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(diff, one), alpha_and_rounding), 8);
+            const __m128i hi = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(diff, one), alpha_and_rounding), 8);
+            const __m128i blended = _mm_add_epi16(neighbour, _mm_packs_epi32(lo, hi));
+            return _mm_or_si128(_mm_and_si128(blend, blended), _mm_andnot_si128(blend, pixel));
+        }
+    };
+
+    static void transpose_depth_x8(depth_x8 (&r)[8])
+    {
+        const __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]), a1 = _mm_unpackhi_epi16(r[0], r[1]), a2 = _mm_unpacklo_epi16(r[2], r[3]), a3 = _mm_unpackhi_epi16(r[2], r[3]);
+        const __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]), a5 = _mm_unpackhi_epi16(r[4], r[5]), a6 = _mm_unpacklo_epi16(r[6], r[7]), a7 = _mm_unpackhi_epi16(r[6], r[7]);
+        const __m128i b0 = _mm_unpacklo_epi32(a0, a2), b1 = _mm_unpackhi_epi32(a0, a2), b2 = _mm_unpacklo_epi32(a1, a3), b3 = _mm_unpackhi_epi32(a1, a3);
+        const __m128i b4 = _mm_unpacklo_epi32(a4, a6), b5 = _mm_unpackhi_epi32(a4, a6), b6 = _mm_unpacklo_epi32(a5, a7), b7 = _mm_unpackhi_epi32(a5, a7);
+        r[0] = _mm_unpacklo_epi64(b0, b4); r[1] = _mm_unpackhi_epi64(b0, b4); r[2] = _mm_unpacklo_epi64(b1, b5); r[3] = _mm_unpackhi_epi64(b1, b5);
+        r[4] = _mm_unpacklo_epi64(b2, b6); r[5] = _mm_unpackhi_epi64(b2, b6); r[6] = _mm_unpacklo_epi64(b3, b7); r[7] = _mm_unpackhi_epi64(b3, b7);
+    }
+
+    // The loop body of filter_depth_temporal(...) for eight pixels, with the ages widened to 16 bits
+    static void filter_depth_temporal_x8(uint16_t * pixels, uint16_t * last, uint8_t * age, const depth_blend_x8 & blend, int persistence)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i z = load_depth_x8(pixels), l = load_depth_x8(last);
+        const __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(age)), zero);
+        const __m128i hole = _mm_cmpeq_epi16(z, zero), smoothed = blend(z, l);
+        const __m128i new_age = _mm_and_si128(hole, _mm_min_epi16(_mm_add_epi16(a, _mm_set1_epi16(1)), _mm_set1_epi16(255)));
+        const __m128i fill = _mm_and_si128(hole, _mm_cmpeq_epi16(_mm_subs_epu16(new_age, _mm_set1_epi16(static_cast<short>(persistence))), zero));
+        store_depth_x8(pixels, _mm_or_si128(_mm_andnot_si128(hole, smoothed), _mm_and_si128(fill, l)));
+        store_depth_x8(last, _mm_or_si128(_mm_andnot_si128(hole, smoothed), _mm_and_si128(hole, l)));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(age), _mm_packus_epi16(new_age, new_age));
+    }
+#elif defined(RS_SIMD_HAVE_NEON)
+    typedef uint16x8_t depth_x8;
+    static depth_x8 load_depth_x8(const uint16_t * p) { return vld1q_u16(p); }
+    static void store_depth_x8(uint16_t * p, depth_x8 v) { vst1q_u16(p, v); }
+
+    // Eight blend_depth(...) at once, the rounding narrowing shift forms (diff * alpha + 128) >> 8
+    struct depth_blend_x8
+    {
+        int16x4_t alpha;
+        uint16x8_t delta;
+        depth_blend_x8(int alpha, int delta) : alpha(vdup_n_s16(static_cast<int16_t>(alpha))), delta(vdupq_n_u16(static_cast<uint16_t>(delta))) {}
+        uint16x8_t operator()(uint16x8_t pixel, uint16x8_t neighbour) const
+        {
+            const uint16x8_t blend = vandq_u16(vcltq_u16(vabdq_u16(pixel, neighbour), delta), vandq_u16(vtstq_u16(pixel, pixel), vtstq_u16(neighbour, neighbour)));
+            const int16x8_t diff = vreinterpretq_s16_u16(vsubq_u16(pixel, neighbour));
+            const int16x8_t step = vcombine_s16(vrshrn_n_s32(vmull_s16(vget_low_s16(diff), alpha), 8), vrshrn_n_s32(vmull_s16(vget_high_s16(diff), alpha), 8));
+            return vbslq_u16(blend, vaddq_u16(neighbour, vreinterpretq_u16_s16(step)), pixel);
+        }
+    };
+
+    static void transpose_depth_x8(depth_x8 (&r)[8])
+    {
+        const uint16x8x2_t t01 = vtrnq_u16(r[0], r[1]), t23 = vtrnq_u16(r[2], r[3]), t45 = vtrnq_u16(r[4], r[5]), t67 = vtrnq_u16(r[6], r[7]);
+        const uint32x4x2_t u0 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[0]), vreinterpretq_u32_u16(t23.val[0])), u1 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[1]), vreinterpretq_u32_u16(t23.val[1]));
+        const uint32x4x2_t u2 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[0]), vreinterpretq_u32_u16(t67.val[0])), u3 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[1]), vreinterpretq_u32_u16(t67.val[1]));
+        r[0] = vreinterpretq_u16_u32(vcombine_u32(vget_low_u32(u0.val[0]), vget_low_u32(u2.val[0])));   r[4] = vreinterpretq_u16_u32(vcombine_u32(vget_high_u32(u0.val[0]), vget_high_u32(u2.val[0])));
+        r[1] = vreinterpretq_u16_u32(vcombine_u32(vget_low_u32(u1.val[0]), vget_low_u32(u3.val[0])));   r[5] = vreinterpretq_u16_u32(vcombine_u32(vget_high_u32(u1.val[0]), vget_high_u32(u3.val[0])));
+        r[2] = vreinterpretq_u16_u32(vcombine_u32(vget_low_u32(u0.val[1]), vget_low_u32(u2.val[1])));   r[6] = vreinterpretq_u16_u32(vcombine_u32(vget_high_u32(u0.val[1]), vget_high_u32(u2.val[1])));
+        r[3] = vreinterpretq_u16_u32(vcombine_u32(vget_low_u32(u1.val[1]), vget_low_u32(u3.val[1])));   r[7] = vreinterpretq_u16_u32(vcombine_u32(vget_high_u32(u1.val[1]), vget_high_u32(u3.val[1])));
+    }
+
+    static void filter_depth_temporal_x8(uint16_t * pixels, uint16_t * last, uint8_t * age, const depth_blend_x8 & blend, int persistence)
+    {
+        const uint16x8_t z = vld1q_u16(pixels), l = vld1q_u16(last), a = vmovl_u8(vld1_u8(age));
+        const uint16x8_t hole = vceqq_u16(z, vdupq_n_u16(0)), smoothed = blend(z, l);
+        const uint16x8_t new_age = vandq_u16(hole, vminq_u16(vaddq_u16(a, vdupq_n_u16(1)), vdupq_n_u16(255)));
+        const uint16x8_t fill = vandq_u16(hole, vcleq_u16(new_age, vdupq_n_u16(static_cast<uint16_t>(persistence))));
+        vst1q_u16(pixels, vbslq_u16(hole, vandq_u16(fill, l), smoothed));
+        vst1q_u16(last, vbslq_u16(hole, l, smoothed));
+        vst1_u8(age, vmovn_u16(new_age));
+    }
+#endif
+
+    // Filters rows [y_begin, y_end) left to right, then right to left. Vectorized, eight rows advance together through transposed blocks of 8x8 pixels.
+    static void filter_depth_rows(uint16_t * pixels, int width, int y_begin, int y_end, int alpha, int delta)
+    {
+        int y = y_begin;
+#if defined(RS_SIMD_HAVE_SSSE3) || defined(RS_SIMD_HAVE_NEON)
+        const depth_blend_x8 blend(alpha, delta);
+        const int blocks = width / 8;
+        for(; blocks && y + 8 <= y_end; y += 8)
+        {
+            uint16_t * rows = pixels + y * width;
+            depth_x8 column[8], previous = load_depth_x8(rows); // Only read once it holds the last column of the previous block
+            for(int b = 0; b < blocks; ++b)
+            {
+                for(int i = 0; i < 8; ++i) column[i] = load_depth_x8(rows + i * width + b * 8);
+                transpose_depth_x8(column);
+                for(int i = b ? 0 : 1; i < 8; ++i) column[i] = blend(column[i], i ? column[i-1] : previous);
+                previous = column[7];
+                transpose_depth_x8(column);
+                for(int i = 0; i < 8; ++i) store_depth_x8(rows + i * width + b * 8, column[i]);
+            }
+            for(int i = 0; i < 8; ++i)
+            {
+                uint16_t * row = rows + i * width;
+                for(int x = blocks * 8; x < width; ++x) row[x] = blend_depth(row[x], row[x-1], alpha, delta);
+            }
+
+            // Right to left, the blocks end at the right edge and the columns left over are on the left
+            const int rest = width - blocks * 8;
+            for(int b = blocks - 1; b >= 0; --b)
+            {
+                for(int i = 0; i < 8; ++i) column[i] = load_depth_x8(rows + i * width + rest + b * 8);
+                transpose_depth_x8(column);
+                for(int i = b == blocks - 1 ? 6 : 7; i >= 0; --i) column[i] = blend(column[i], i < 7 ? column[i+1] : previous);
+                previous = column[0];
+                transpose_depth_x8(column);
+                for(int i = 0; i < 8; ++i) store_depth_x8(rows + i * width + rest + b * 8, column[i]);
+            }
+            for(int i = 0; i < 8; ++i)
+            {
+                uint16_t * row = rows + i * width;
+                for(int x = rest - 1; x >= 0; --x) row[x] = blend_depth(row[x], row[x+1], alpha, delta);
+            }
+        }
+#endif
+        for(; y < y_end; ++y)
+        {
+            uint16_t * row = pixels + y * width;
+            for(int x = 1; x < width; ++x) row[x] = blend_depth(row[x], row[x-1], alpha, delta);
+            for(int x = width - 2; x >= 0; --x) row[x] = blend_depth(row[x], row[x+1], alpha, delta);
+        }
+    }
+
+    // Filters columns [x_begin, x_end) top to bottom, then bottom to top. Whole rows are independent, so they vectorize directly.
+    static void filter_depth_columns(uint16_t * pixels, int width, int height, int x_begin, int x_end, int alpha, int delta)
+    {
+        auto filter_row = [&](uint16_t * row, const uint16_t * neighbour)
+        {
+            int x = x_begin;
+#if defined(RS_SIMD_HAVE_SSSE3) || defined(RS_SIMD_HAVE_NEON)
+            const depth_blend_x8 blend(alpha, delta);
+            for(; x + 8 <= x_end; x += 8) store_depth_x8(row + x, blend(load_depth_x8(row + x), load_depth_x8(neighbour + x)));
+#endif
+            for(; x < x_end; ++x) row[x] = blend_depth(row[x], neighbour[x], alpha, delta);
+        };
+        for(int y = 1; y < height; ++y) filter_row(pixels + y * width, pixels + (y - 1) * width);
+        for(int y = height - 2; y >= 0; --y) filter_row(pixels + y * width, pixels + (y + 1) * width);
+    }
+
+    void filter_depth_spatial(uint16_t * pixels, int width, int height, float alpha, int delta)
+    {
+        // Rows are independent of each other in the first two passes, and columns in the last two, so both split into bands.
+        // Bands start on multiples of eight rows or columns, which keeps every band but the last on whole vectors.
+        const int weight = depth_blend_weight(alpha);
+        auto & pool = get_shared_parallel_pool();
+        const int row_bands = std::max(1, std::min(pool.get_thread_count(), height / 8)), column_bands = std::max(1, std::min(pool.get_thread_count(), width / 8));
+        pool.parallel_for(row_bands, [&](int band)
+        {
+            const int y_begin = band ? height / 8 * band / row_bands * 8 : 0, y_end = band + 1 < row_bands ? height / 8 * (band + 1) / row_bands * 8 : height;
+            filter_depth_rows(pixels, width, y_begin, y_end, weight, delta);
+        });
+        pool.parallel_for(column_bands, [&](int band)
+        {
+            const int x_begin = band ? width / 8 * band / column_bands * 8 : 0, x_end = band + 1 < column_bands ? width / 8 * (band + 1) / column_bands * 8 : width;
+            filter_depth_columns(pixels, width, height, x_begin, x_end, weight, delta);
+        });
+    }
+
+    void filter_depth_temporal(uint16_t * pixels, int count, temporal_depth_history & history, float alpha, int delta, int persistence)
+    {
+        // A new stream, or a new resolution, starts without any past
+        if(history.last.size() != static_cast<size_t>(count))
+        {
+            history.last.assign(count, 0);
+            history.age.assign(count, 255);
+        }
+        const int weight = depth_blend_weight(alpha);
+        auto last = history.last.data();
+        auto age = history.age.data();
+        int i = 0;
+#if defined(RS_SIMD_HAVE_SSSE3) || defined(RS_SIMD_HAVE_NEON)
+        const depth_blend_x8 blend(weight, delta);
+        for(; i + 8 <= count; i += 8) filter_depth_temporal_x8(pixels + i, last + i, age + i, blend, persistence);
+#endif
+        for(; i < count; ++i)
+        {
+            if(pixels[i])
+            {
+                pixels[i] = last[i] = blend_depth(pixels[i], last[i], weight, delta);
+                age[i] = 0;
+            }
+            else
+            {
+                if(age[i] < 255) ++age[i];
+                if(age[i] <= persistence) pixels[i] = last[i];
+            }
+        }
+    }
+
+    //////////////////////
+    // Depth statistics //
+    //////////////////////
+
+    static const uint16_t depth_histogram_floor[depth_statistics::histogram_bins] = {1, 256, 512, 1024, 2048, 4096, 8192, 16384}; // The least depth of every bin
+
+#if defined(RS_SIMD_HAVE_SSSE3)
+    // Per lane minimum, maximum and counts of pixels at or above the floor of every bin. Counts are 16 bit, so only 65535 vectors fit between resets.
+    struct depth_statistics_x8
+    {
+        __m128i min, max, at_least[depth_statistics::histogram_bins];
+        depth_statistics_x8() : min(_mm_set1_epi16(-1)), max(_mm_setzero_si128()) { for(auto & c : at_least) c = _mm_setzero_si128(); }
+        void operator()(__m128i pixel)
+        {
+            // SSE2 has no unsigned 16 bit min and max, but saturating subtraction gets there. Holes are pushed to 0xFFFF to keep them out of the minimum.
+            const __m128i zero = _mm_setzero_si128();
+            min = _mm_sub_epi16(min, _mm_subs_epu16(min, _mm_or_si128(pixel, _mm_cmpeq_epi16(pixel, zero))));
+            max = _mm_add_epi16(pixel, _mm_subs_epu16(max, pixel));
+            for(int k = 0; k < depth_statistics::histogram_bins; ++k)
+            {
+                at_least[k] = _mm_sub_epi16(at_least[k], _mm_cmpeq_epi16(_mm_subs_epu16(_mm_set1_epi16(static_cast<short>(depth_histogram_floor[k])), pixel), zero));
+            }
+        }
+        void reduce(uint16_t & lowest, uint16_t & highest, uint32_t (&counts)[depth_statistics::histogram_bins]) const
+        {
+            uint16_t lanes[8];
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), min);
+            for(auto l : lanes) lowest = std::min(lowest, l);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), max);
+            for(auto l : lanes) highest = std::max(highest, l);
+            for(int k = 0; k < depth_statistics::histogram_bins; ++k)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), at_least[k]);
+                for(auto l : lanes) counts[k] += l;
+            }
+        }
+    };
+#elif defined(RS_SIMD_HAVE_NEON)
+    struct depth_statistics_x8
+    {
+        uint16x8_t min, max, at_least[depth_statistics::histogram_bins];
+        depth_statistics_x8() : min(vdupq_n_u16(0xFFFF)), max(vdupq_n_u16(0)) { for(auto & c : at_least) c = vdupq_n_u16(0); }
+        void operator()(uint16x8_t pixel)
+        {
+            min = vminq_u16(min, vorrq_u16(pixel, vceqq_u16(pixel, vdupq_n_u16(0))));
+            max = vmaxq_u16(max, pixel);
+            for(int k = 0; k < depth_statistics::histogram_bins; ++k) at_least[k] = vsubq_u16(at_least[k], vcgeq_u16(pixel, vdupq_n_u16(depth_histogram_floor[k])));
+        }
+        void reduce(uint16_t & lowest, uint16_t & highest, uint32_t (&counts)[depth_statistics::histogram_bins]) const
+        {
+            uint16_t lanes[8];
+            vst1q_u16(lanes, min);
+            for(auto l : lanes) lowest = std::min(lowest, l);
+            vst1q_u16(lanes, max);
+            for(auto l : lanes) highest = std::max(highest, l);
+            for(int k = 0; k < depth_statistics::histogram_bins; ++k)
+            {
+                vst1q_u16(lanes, at_least[k]);
+                for(auto l : lanes) counts[k] += l;
+            }
+        }
+    };
+#endif
+
+    void accumulate_depth_statistics(const uint16_t * pixels, int count, depth_statistics & statistics, uint16_t * copy)
+    {
+        // Counting the pixels at or above the floor of every bin needs no per pixel bin lookup, and the bins fall out as differences
+        uint32_t at_least[depth_statistics::histogram_bins] = {};
+        uint16_t lowest = statistics.min, highest = statistics.max;
+        int i = 0;
+#if defined(RS_SIMD_HAVE_SSSE3) || defined(RS_SIMD_HAVE_NEON)
+        const int vectorized = count & ~7;
+        while(i < vectorized)
+        {
+            depth_statistics_x8 x8;
+            const int end = std::min(vectorized, i + 8 * 0xFFFF);
+            for(; i < end; i += 8)
+            {
+                const depth_x8 pixel = load_depth_x8(pixels + i);
+                if(copy) store_depth_x8(copy + i, pixel);
+                x8(pixel);
+            }
+            x8.reduce(lowest, highest, at_least);
+        }
+#endif
+        for(; i < count; ++i)
+        {
+            const uint16_t pixel = pixels[i];
+            if(copy) copy[i] = pixel;
+            if(!pixel) continue;
+            lowest = std::min(lowest, pixel);
+            highest = std::max(highest, pixel);
+            for(int k = 0; k < depth_statistics::histogram_bins && pixel >= depth_histogram_floor[k]; ++k) ++at_least[k];
+        }
+
+        statistics.min = lowest;
+        statistics.max = highest;
+        statistics.valid += at_least[0];
+        for(int k = 0; k < depth_statistics::histogram_bins; ++k) statistics.histogram[k] += at_least[k] - (k + 1 < depth_statistics::histogram_bins ? at_least[k+1] : 0);
+    }
+
+    int histogram_of_samples(const uint8_t * pixels, int width, int height, int stride, int sample_rate, int histogram[256])
+    {
+        // Consecutive samples often share a bin, so counting them into four interleaved histograms keeps the increments from waiting on each other
+        uint32_t partial[4][256] = {};
+        const int step = std::max(sample_rate, 1), row_samples = (width + step - 1) / step, unrolled = row_samples & ~3;
+        for(int y = 0; y < height; y += step)
+        {
+            const uint8_t * row = pixels + static_cast<size_t>(y) * stride;
+            int i = 0;
+            if(step == 1)
+            {
+                for(; i < unrolled; i += 4)
+                {
+                    uint32_t quad;
+                    memcpy(&quad, row + i, sizeof(quad));
+                    ++partial[0][quad & 0xFF];
+                    ++partial[1][quad >> 8 & 0xFF];
+                    ++partial[2][quad >> 16 & 0xFF];
+                    ++partial[3][quad >> 24];
+                }
+            }
+            else
+            {
+                for(; i < unrolled; i += 4)
+                {
+                    const uint8_t * sample = row + i * step;
+                    ++partial[0][sample[0]];
+                    ++partial[1][sample[step]];
+                    ++partial[2][sample[2 * step]];
+                    ++partial[3][sample[3 * step]];
+                }
+            }
+            for(; i < row_samples; ++i) ++partial[0][row[i * step]];
+        }
+        for(int k = 0; k < 256; ++k) histogram[k] = static_cast<int>(partial[0][k] + partial[1][k] + partial[2][k] + partial[3][k]);
+        return row_samples * ((height + step - 1) / step);
+    }
+
+    //////////////////////
+    // Depth colorizing //
+    //////////////////////
+
+    static const uint32_t depth_hole_color = 20 | 5 << 8; // The colors of make_depth_histogram(...) in the examples
+    static uint32_t depth_color(int level) { return (255 - level) | level << 16; } // Level 0 is the nearest, 255 the farthest
+
+    void update_depth_colormap(depth_colormap & map, const uint16_t * pixels, int count, float depth_scale, const std::vector<float> * disparity_to_depth, bool equalized, float max_distance)
+    {
+        const bool disparity = disparity_to_depth != nullptr;
+        if(map.lut.empty() || map.equalized != equalized || map.disparity != disparity || map.depth_scale != depth_scale || (!equalized && map.max_distance != max_distance))
+        {
+            map.lut.assign(0x10000, depth_hole_color);
+            map.histogram.assign(0x10000, 0);
+            map.histogram_lowest = 1;
+            map.histogram_highest = 0;
+            map.stale_lowest = 1;
+            map.stale_highest = 0xFFFF;
+            map.equalized = equalized;
+            map.disparity = disparity;
+            map.depth_scale = depth_scale;
+            map.max_distance = max_distance;
+
+            // A linear map only depends on the scales, so it is complete as soon as it is built
+            if(!equalized) for(int v = 1; v < 0x10000; ++v)
+            {
+                const float meters = disparity ? (*disparity_to_depth)[v] : v * depth_scale;
+                if(meters > 0) map.lut[v] = depth_color(static_cast<int>(std::min(meters / max_distance, 1.0f) * 255));
+            }
+        }
+        if(!equalized) return;
+
+        auto & histogram = map.histogram;
+        if(map.histogram_lowest <= map.histogram_highest) std::fill(histogram.begin() + map.histogram_lowest, histogram.begin() + map.histogram_highest + 1, 0);
+        int lowest = 0xFFFF, highest = 1;
+        uint64_t total = 0;
+        for(int i = 0; i < count; ++i)
+        {
+            if(const uint16_t v = pixels[i])
+            {
+                ++histogram[v];
+                lowest = std::min<int>(lowest, v);
+                highest = std::max<int>(highest, v);
+                ++total;
+            }
+        }
+        if(!total)
+        {
+            // Nothing to look up, so the entries are left as they are
+            map.histogram_lowest = 1;
+            map.histogram_highest = 0;
+            return;
+        }
+        map.histogram_lowest = lowest;
+        map.histogram_highest = highest;
+
+        // Outside the values of both frames every entry already holds the color of the extreme on its side, so only the entries in between change
+        const int first = std::min(lowest, map.stale_lowest), last = std::max(highest, map.stale_highest);
+        uint64_t below = 0;
+        for(int v = first; v <= last; ++v)
+        {
+            const uint64_t through = below + histogram[v];
+            map.lut[v] = depth_color(static_cast<int>((disparity ? total - below : through) * 255 / total));
+            below = through;
+        }
+        map.stale_lowest = lowest;
+        map.stale_highest = highest;
+    }
+
+    // Gathers are only worth it with AVX2, everywhere else every pixel is looked up on its own
+    static const depth_colorizer wide_depth_colorizer = query_cpu_features().avx2 ? get_depth_colorizer_avx2() : nullptr;
+
+    void colorize_depth(byte * rgb, const uint16_t * pixels, int count, const uint32_t * lut)
+    {
+        int i = wide_depth_colorizer ? wide_depth_colorizer(rgb, pixels, count, lut) : 0;
+        for(; i < count; ++i)
+        {
+            const uint32_t color = lut[pixels[i]];
+            rgb[i * 3 + 0] = static_cast<byte>(color);
+            rgb[i * 3 + 1] = static_cast<byte>(color >> 8);
+            rgb[i * 3 + 2] = static_cast<byte>(color >> 16);
+        }
+    }
+
+    /////////////////////
+    // Image alignment //
+    /////////////////////
+
+    std::vector<float> compute_alignment_rays(const rs_intrinsics & depth_intrin, const rs_extrinsics & depth_to_other)
+    {
+        // Pixel corners are shared between neighbouring pixels, so a (width+1) x (height+1) grid covers every footprint
+        std::vector<float> rays((depth_intrin.width + 1) * (depth_intrin.height + 1) * 3);
+        auto r = depth_to_other.rotation;
+        float * ray = rays.data();
+        for(int y = 0; y <= depth_intrin.height; ++y)
+        {
+            for(int x = 0; x <= depth_intrin.width; ++x, ray += 3)
+            {
+                const float pixel[] = {x-0.5f, y-0.5f};
+                float point[3];
+                rs_deproject_pixel_to_point(point, &depth_intrin, pixel, 1.0f);
+                ray[0] = r[0] * point[0] + r[3] * point[1] + r[6] * point[2];
+                ray[1] = r[1] * point[0] + r[4] * point[1] + r[7] * point[2];
+                ray[2] = r[2] * point[0] + r[5] * point[1] + r[8] * point[2];
+            }
+        }
+        return rays;
+    }
+
+    // The rectangle of the other image covered by one depth pixel, from its top-left to its bottom-right corner. The depth pixel is indexed
+    // both in the depth image read and in the depth-shaped image written, whose rows may be padded differently.
+    struct pixel_footprint { int depth_pixel_index, dest_pixel_index, x0, y0, x1, y1; };
+
+    // Scales a cached corner ray by depth, moves it into the other camera and returns the nearest pixel of the other image
+    static void map_pixel_corner(int & other_x, int & other_y, const float * ray, float depth, const float translation[3], const rs_intrinsics & other_intrin)
+    {
+        const float other_point[] = {depth * ray[0] + translation[0], depth * ray[1] + translation[1], depth * ray[2] + translation[2]};
+        float other_pixel[2];
+        rs_project_point_to_pixel(other_pixel, &other_intrin, other_point);
+        other_x = static_cast<int>(other_pixel[0] + 0.5f);
+        other_y = static_cast<int>(other_pixel[1] + 0.5f);
+    }
+
+    // Strides of rows of the depth image read, and of the depth-shaped image written, defaulting to the width of the depth image
+    struct depth_rows
+    {
+        int source, dest;
+        const uint32_t * runs; // When set, only the runs of valid pixels of the depth image are visited
+        depth_rows(int width, const image_strides & strides) : source(strides.source ? strides.source : width), dest(strides.dest ? strides.dest : width), runs(strides.source_runs) {}
+    };
+
+    // Calls on_footprint for every depth pixel of rows [y_begin, y_end) which has depth data and whose footprint lies entirely inside the other image.
+    // Given the runs of valid pixels of the depth image, the pixels with no data are never visited.
+    template<class GET_DEPTH, class ON_FOOTPRINT> void for_each_footprint(const rs_intrinsics & depth_intrin, const depth_rows & rows, const std::vector<float> & alignment_rays, const rs_extrinsics & depth_to_other, const rs_intrinsics & other_intrin, GET_DEPTH & get_depth, int y_begin, int y_end, ON_FOOTPRINT on_footprint)
+    {
+        const int ray_stride = (depth_intrin.width + 1) * 3;
+        const depth_run * runs = rows.runs ? get_depth_runs(rows.runs, depth_intrin.height) : nullptr;
+        for(int depth_y = y_begin; depth_y < y_end; ++depth_y)
+        {
+            auto footprints = [&](int x_begin, int x_end)
+            {
+                int depth_pixel_index = depth_y * rows.source + x_begin, dest_pixel_index = depth_y * rows.dest + x_begin;
+                const float * top_left = alignment_rays.data() + depth_y * ray_stride + x_begin * 3;
+                for(int depth_x = x_begin; depth_x < x_end; ++depth_x, ++depth_pixel_index, ++dest_pixel_index, top_left += 3)
+                {
+                    // Skip over depth pixels with the value of zero, we have no depth data so we will not write anything into our aligned images
+                    if(float depth = get_depth(depth_pixel_index))
+                    {
+                        // Map the top-left and bottom-right corners of the depth pixel onto the other image
+                        pixel_footprint f;
+                        f.depth_pixel_index = depth_pixel_index;
+                        f.dest_pixel_index = dest_pixel_index;
+                        map_pixel_corner(f.x0, f.y0, top_left, depth, depth_to_other.translation, other_intrin);
+                        map_pixel_corner(f.x1, f.y1, top_left + ray_stride + 3, depth, depth_to_other.translation, other_intrin);
+                        if(f.x0 < 0 || f.y0 < 0 || f.x1 >= other_intrin.width || f.y1 >= other_intrin.height) continue;
+                        on_footprint(f);
+                    }
+                }
+            };
+            if(!runs) footprints(0, depth_intrin.width);
+            else for(auto run = runs + rows.runs[depth_y], end = runs + rows.runs[depth_y + 1]; run != end; ++run) footprints(run->x, run->x + run->count);
+        }
+    }
+
+    // Aligns images whose transfer only writes to the depth pixel itself (other to depth, rectification), so bands of depth rows never conflict.
+    // Pixels of the other image are indexed in rows of other_stride pixels.
+    template<class GET_DEPTH, class TRANSFER_PIXEL> void align_images(const rs_intrinsics & depth_intrin, const depth_rows & rows, const std::vector<float> & alignment_rays, const rs_extrinsics & depth_to_other, const rs_intrinsics & other_intrin, int other_stride, GET_DEPTH get_depth, TRANSFER_PIXEL transfer_pixel)
+    {
+        auto & pool = get_shared_parallel_pool();
+        const int bands = std::max(1, std::min(pool.get_thread_count(), depth_intrin.height));
+        pool.parallel_for(bands, [&](int band)
+        {
+            for_each_footprint(depth_intrin, rows, alignment_rays, depth_to_other, other_intrin, get_depth, depth_intrin.height * band / bands, depth_intrin.height * (band + 1) / bands, [&](const pixel_footprint & f)
+            {
+                // Transfer between the depth pixels and the pixels inside the rectangle on the other image
+                for(int y=f.y0; y<=f.y1; ++y) for(int x=f.x0; x<=f.x1; ++x) transfer_pixel(f, y * other_stride + x);
+            });
+        });
+    }
+
+    // Aligns images whose transfer writes to the other image (depth to other), where footprints from different depth rows can overlap.
+    // Every band of depth rows first buckets its footprints by band of other rows. Every band of other rows then replays the footprints
+    // touching it, in depth pixel order, so each output pixel sees exactly the sequence of writes of a serial pass without any locking.
+    template<class GET_DEPTH, class TRANSFER_PIXEL> void scatter_images(const rs_intrinsics & depth_intrin, const depth_rows & rows, const std::vector<float> & alignment_rays, const rs_extrinsics & depth_to_other, const rs_intrinsics & other_intrin, int other_stride, GET_DEPTH get_depth, TRANSFER_PIXEL transfer_pixel)
+    {
+        auto & pool = get_shared_parallel_pool();
+        const int bands = std::min(pool.get_thread_count(), std::min(depth_intrin.height, other_intrin.height));
+        if(bands <= 1) return align_images(depth_intrin, rows, alignment_rays, depth_to_other, other_intrin, other_stride, get_depth, transfer_pixel);
+
+        // Rows of band b of the other image are [ceil(b * height / bands), ceil((b + 1) * height / bands)), which is where row * bands / height == b
+        const int other_height = other_intrin.height;
+        std::vector<std::vector<pixel_footprint>> buckets(bands * bands); // Indexed by depth band * bands + other band
+        pool.parallel_for(bands, [&](int band)
+        {
+            const auto bucket = &buckets[band * bands];
+            for_each_footprint(depth_intrin, rows, alignment_rays, depth_to_other, other_intrin, get_depth, depth_intrin.height * band / bands, depth_intrin.height * (band + 1) / bands, [&](const pixel_footprint & f)
+            {
+                for(int b = f.y0 * bands / other_height, last = f.y1 * bands / other_height; b <= last; ++b) bucket[b].push_back(f);
+            });
+        });
+        pool.parallel_for(bands, [&](int band)
+        {
+            const int y_begin = (other_height * band + bands - 1) / bands, y_end = (other_height * (band + 1) + bands - 1) / bands;
+            for(int depth_band = 0; depth_band < bands; ++depth_band)
+            {
+                for(auto & f : buckets[depth_band * bands + band])
+                {
+                    for(int y = std::max(f.y0, y_begin), y1 = std::min(f.y1, y_end - 1); y <= y1; ++y)
+                    {
+                        for(int x=f.x0; x<=f.x1; ++x) transfer_pixel(f, y * other_stride + x);
+                    }
+                }
+            }
+        });
+    }
+
+    void align_z_to_other(byte * z_aligned_to_other, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, const std::vector<float> & z_rays, const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin,
+                          const image_strides & strides)
+    {
+        auto out_z = (uint16_t *)(z_aligned_to_other);
+        depth_rows rows(z_intrin.width, image_strides(strides.source)); // The dest stride is that of the other image
+        rows.runs = strides.source_runs;
+        scatter_images(z_intrin, rows, z_rays, z_to_other, other_intrin, strides.dest ? strides.dest : other_intrin.width,
+            [z_pixels, z_scale](int z_pixel_index) { return z_scale * z_pixels[z_pixel_index]; },
+            [out_z, z_pixels](const pixel_footprint & f, int other_pixel_index) { out_z[other_pixel_index] = out_z[other_pixel_index] ? std::min(out_z[other_pixel_index],z_pixels[f.depth_pixel_index]) : z_pixels[f.depth_pixel_index]; });
+    }
+
+    void align_disparity_to_other(byte * disparity_aligned_to_other, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth, const rs_intrinsics & disparity_intrin, const std::vector<float> & disparity_rays, const rs_extrinsics & disparity_to_other, const rs_intrinsics & other_intrin,
+                                  const image_strides & strides)
+    {
+        auto depth = disparity_to_depth.data();
+        auto out_disparity = (uint16_t *)(disparity_aligned_to_other);
+        depth_rows rows(disparity_intrin.width, image_strides(strides.source));
+        rows.runs = strides.source_runs;
+        scatter_images(disparity_intrin, rows, disparity_rays, disparity_to_other, other_intrin, strides.dest ? strides.dest : other_intrin.width,
+            [disparity_pixels, depth](int disparity_pixel_index) { return depth[disparity_pixels[disparity_pixel_index]]; },
+            [out_disparity, disparity_pixels](const pixel_footprint & f, int other_pixel_index) { auto & out = out_disparity[other_pixel_index]; out = out == 0xFFFF ? disparity_pixels[f.depth_pixel_index] : std::max(out, disparity_pixels[f.depth_pixel_index]); }); // Nearest (largest disparity) wins, 0xFFFF marks pixels not yet written
+    }
+
+    template<int N> struct bytes { char b[N]; };
+    template<int N, class GET_DEPTH> void align_other_to_depth_bytes(byte * other_aligned_to_depth, GET_DEPTH get_depth, const rs_intrinsics & depth_intrin, const std::vector<float> & depth_rays, const rs_extrinsics & depth_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels,
+                                                                      const image_strides & strides)
+    {
+        auto in_other = (const bytes<N> *)(other_pixels);
+        auto out_other = (bytes<N> *)(other_aligned_to_depth);
+        align_images(depth_intrin, depth_rows(depth_intrin.width, strides), depth_rays, depth_to_other, other_intrin, strides.other ? strides.other : other_intrin.width, get_depth,
+            [out_other, in_other](const pixel_footprint & f, int other_pixel_index) { out_other[f.dest_pixel_index] = in_other[other_pixel_index]; });
+    }
+
+    template<class GET_DEPTH> void align_other_to_depth(byte * other_aligned_to_depth, GET_DEPTH get_depth, const rs_intrinsics & depth_intrin, const std::vector<float> & depth_rays, const rs_extrinsics & depth_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels, rs_format other_format,
+                                                        const image_strides & strides)
+    {
+        switch(other_format)
+        {
+        case RS_FORMAT_Y8: 
+            align_other_to_depth_bytes<1>(other_aligned_to_depth, get_depth, depth_intrin, depth_rays, depth_to_other, other_intrin, other_pixels, strides); break;
+        case RS_FORMAT_Y16: case RS_FORMAT_Z16: 
+            align_other_to_depth_bytes<2>(other_aligned_to_depth, get_depth, depth_intrin, depth_rays, depth_to_other, other_intrin, other_pixels, strides); break;
+        case RS_FORMAT_RGB8: case RS_FORMAT_BGR8: 
+            align_other_to_depth_bytes<3>(other_aligned_to_depth, get_depth, depth_intrin, depth_rays, depth_to_other, other_intrin, other_pixels, strides); break;
+        case RS_FORMAT_RGBA8: case RS_FORMAT_BGRA8: 
+            align_other_to_depth_bytes<4>(other_aligned_to_depth, get_depth, depth_intrin, depth_rays, depth_to_other, other_intrin, other_pixels, strides); break;
+        default: 
+            assert(false); // NOTE: rs_align_other_to_depth_bytes<2>(...) is not appropriate for RS_FORMAT_YUYV/RS_FORMAT_RAW10 images, no logic prevents U/V channels from being written to one another
+        }
+    }
+
+    void align_other_to_z(byte * other_aligned_to_z, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, const std::vector<float> & z_rays, const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels, rs_format other_format,
+                          const image_strides & strides)
+    {
+        align_other_to_depth(other_aligned_to_z, [z_pixels, z_scale](int z_pixel_index) { return z_scale * z_pixels[z_pixel_index]; }, z_intrin, z_rays, z_to_other, other_intrin, other_pixels, other_format, strides);
+    }
+
+    void align_other_to_disparity(byte * other_aligned_to_disparity, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth, const rs_intrinsics & disparity_intrin, const std::vector<float> & disparity_rays, const rs_extrinsics & disparity_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels, rs_format other_format,
+                                  const image_strides & strides)
+    {
+        auto depth = disparity_to_depth.data();
+        align_other_to_depth(other_aligned_to_disparity, [disparity_pixels, depth](int disparity_pixel_index) { return depth[disparity_pixels[disparity_pixel_index]]; }, disparity_intrin, disparity_rays, disparity_to_other, other_intrin, other_pixels, other_format, strides);
+    }
+
+    // Fuses YUY2 to RGB8 conversion into alignment. Of every footprint, align_other_to_depth keeps the source pixel written last,
+    // its bottom-right corner, so only that pixel is converted, and the full resolution RGB image is never produced.
+    template<class GET_DEPTH> void align_yuy2_to_depth(byte * rgb_aligned_to_depth, GET_DEPTH get_depth, const rs_intrinsics & depth_intrin, const std::vector<float> & depth_rays, const rs_extrinsics & depth_to_other, const rs_intrinsics & other_intrin, const byte * yuy2_pixels,
+                                                       const image_strides & strides)
+    {
+        auto & pool = get_shared_parallel_pool();
+        const int bands = std::max(1, std::min(pool.get_thread_count(), depth_intrin.height));
+        const depth_rows rows(depth_intrin.width, strides);
+        const int other_stride = strides.other ? strides.other : other_intrin.width; // Even, as macropixels never straddle rows
+        pool.parallel_for(bands, [&](int band)
+        {
+            for_each_footprint(depth_intrin, rows, depth_rays, depth_to_other, other_intrin, get_depth, depth_intrin.height * band / bands, depth_intrin.height * (band + 1) / bands, [&](const pixel_footprint & f)
+            {
+                if(f.x0 > f.x1 || f.y0 > f.y1) return;
+                const int other_pixel_index = f.y1 * other_stride + f.x1;
+                auto macropixel = yuy2_pixels + (other_pixel_index & ~1) * 2; // Y0 U Y1 V
+                auto out = rgb_aligned_to_depth + f.dest_pixel_index * 3;
+                yuy2_to_rgb(yuy2_pixels[other_pixel_index * 2], macropixel[1], macropixel[3], out[0], out[1], out[2]);
+            });
+        });
+    }
+
+    void align_yuy2_to_z(byte * rgb_aligned_to_z, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, const std::vector<float> & z_rays, const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin, const byte * yuy2_pixels,
+                         const image_strides & strides)
+    {
+        align_yuy2_to_depth(rgb_aligned_to_z, [z_pixels, z_scale](int z_pixel_index) { return z_scale * z_pixels[z_pixel_index]; }, z_intrin, z_rays, z_to_other, other_intrin, yuy2_pixels, strides);
+    }
+
+    void align_yuy2_to_disparity(byte * rgb_aligned_to_disparity, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth, const rs_intrinsics & disparity_intrin, const std::vector<float> & disparity_rays, const rs_extrinsics & disparity_to_other, const rs_intrinsics & other_intrin, const byte * yuy2_pixels,
+                                 const image_strides & strides)
+    {
+        auto depth = disparity_to_depth.data();
+        align_yuy2_to_depth(rgb_aligned_to_disparity, [disparity_pixels, depth](int disparity_pixel_index) { return depth[disparity_pixels[disparity_pixel_index]]; }, disparity_intrin, disparity_rays, disparity_to_other, other_intrin, yuy2_pixels, strides);
+    }
+
+    /////////////////////////
+    // Image rectification //
+    /////////////////////////
+
+    rectification_table compute_rectification_table(const rs_intrinsics & rect_intrin, const rs_extrinsics & rect_to_unrect, const rs_intrinsics & unrect_intrin, int unrect_stride)
+    {   
+        std::vector<int> indices(rect_intrin.width * rect_intrin.height);
+        align_images(rect_intrin, depth_rows(rect_intrin.width, image_strides()), compute_alignment_rays(rect_intrin, rect_to_unrect), rect_to_unrect, unrect_intrin, unrect_stride ? unrect_stride : unrect_intrin.width, [](int) { return 1.0f; },
+            [&indices](const pixel_footprint & f, int unrect_pixel_index) { indices[f.depth_pixel_index] = unrect_pixel_index; });
+
+        // Split the indices into tiles, and store each tile as offsets from its first index, narrow whenever they all fit in 16 bits
+        typedef rectification_table table_type;
+        table_type table;
+        table.width = rect_intrin.width;
+        table.height = rect_intrin.height;
+        std::vector<int32_t> offsets(table_type::tile_size);
+        const int source_stride = unrect_stride ? unrect_stride : unrect_intrin.width;
+        for(int tile_y = 0; tile_y < table.height; tile_y += table_type::tile_height)
+        {
+            for(int tile_x = 0; tile_x < table.width; tile_x += table_type::tile_width)
+            {
+                const int base = indices[tile_y * table.width + tile_x];
+                bool wide = false;
+                std::fill(begin(offsets), end(offsets), 0);
+                table_type::window source = {std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::min()};
+                for(int y = tile_y; y < std::min(tile_y + table_type::tile_height, table.height); ++y)
+                {
+                    for(int x = tile_x; x < std::min(tile_x + table_type::tile_width, table.width); ++x)
+                    {
+                        const int index = indices[y * table.width + x];
+                        auto & offset = offsets[(y - tile_y) * table_type::tile_width + x - tile_x];
+                        offset = index - base;
+                        wide |= offset < std::numeric_limits<int16_t>::min() || offset > std::numeric_limits<int16_t>::max();
+                        source.x0 = std::min(source.x0, index % source_stride);
+                        source.x1 = std::max(source.x1, index % source_stride);
+                        source.y0 = std::min(source.y0, index / source_stride);
+                        source.y1 = std::max(source.y1, index / source_stride);
+                    }
+                }
+                table.sources.push_back(source);
+
+                const table_type::tile t = {base, static_cast<int32_t>(wide ? table.wide_offsets.size() : table.narrow_offsets.size()), wide};
+                table.tiles.push_back(t);
+                if(wide) table.wide_offsets.insert(end(table.wide_offsets), begin(offsets), end(offsets));
+                else for(auto offset : offsets) table.narrow_offsets.push_back(static_cast<int16_t>(offset));
+            }
+        }
+        return table;
+    }
+
+    template<class T, class OFFSET> void rectify_tile(T * rect_pixels, int rect_stride, int columns, int rows, const T * unrect_source, const OFFSET * offsets)
+    {
+        for(int y = 0; y < rows; ++y, rect_pixels += rect_stride, offsets += rectification_table::tile_width)
+        {
+            for(int x = 0; x < columns; ++x) rect_pixels[x] = unrect_source[offsets[x]];
+        }
+    }
+
+    template<class T> void rectify_image_pixels(T * rect_pixels, const rectification_table & table, const T * unrect_pixels, int rect_stride, const changed_tiles * unrect_changes)
+    {
+        if(!rect_stride) rect_stride = table.width;
+        // Rows of tiles write disjoint rows of the rectified image, so they are processed in parallel
+        const int tiles_per_row = (table.width + rectification_table::tile_width - 1) / rectification_table::tile_width;
+        const int tile_rows = (table.height + rectification_table::tile_height - 1) / rectification_table::tile_height;
+        get_shared_parallel_pool().parallel_for(tile_rows, [&](int tile_row)
+        {
+            const int tile_y = tile_row * rectification_table::tile_height, rows = std::min<int>(rectification_table::tile_height, table.height - tile_y);
+            for(int i = 0; i < tiles_per_row; ++i)
+            {
+                if(unrect_changes && !unrect_changes->any_within(table.sources[tile_row * tiles_per_row + i])) continue;
+                const auto & tile = table.tiles[tile_row * tiles_per_row + i];
+                const int tile_x = i * rectification_table::tile_width, columns = std::min<int>(rectification_table::tile_width, table.width - tile_x);
+                auto out = rect_pixels + tile_y * rect_stride + tile_x;
+                if(tile.wide) rectify_tile(out, rect_stride, columns, rows, unrect_pixels + tile.base, table.wide_offsets.data() + tile.first);
+                else rectify_tile(out, rect_stride, columns, rows, unrect_pixels + tile.base, table.narrow_offsets.data() + tile.first);
+            }
+        });
+    }
+
+    void rectify_image(uint8_t * rect_pixels, const rectification_table & table, const uint8_t * unrect_pixels, rs_format format, int rect_stride, const changed_tiles * unrect_changes)
+    {
+        switch(format)
+        {
+        case RS_FORMAT_Y8: 
+            return rectify_image_pixels((bytes<1> *)rect_pixels, table, (const bytes<1> *)unrect_pixels, rect_stride, unrect_changes);
+        case RS_FORMAT_Y16: case RS_FORMAT_Z16: 
+            return rectify_image_pixels((bytes<2> *)rect_pixels, table, (const bytes<2> *)unrect_pixels, rect_stride, unrect_changes);
+        case RS_FORMAT_RGB8: case RS_FORMAT_BGR8: 
+            return rectify_image_pixels((bytes<3> *)rect_pixels, table, (const bytes<3> *)unrect_pixels, rect_stride, unrect_changes);
+        case RS_FORMAT_RGBA8: case RS_FORMAT_BGRA8: 
+            return rectify_image_pixels((bytes<4> *)rect_pixels, table, (const bytes<4> *)unrect_pixels, rect_stride, unrect_changes);
+        default: 
+            assert(false); // NOTE: rectify_image_pixels(...) is not appropriate for RS_FORMAT_YUYV images, no logic prevents U/V channels from being written to one another
+        }
+    }
+
+    fisheye_remap_table compute_fisheye_remap_table(const rs_intrinsics & rect_intrin, const rs_extrinsics & rect_to_fisheye, const rs_intrinsics & fisheye_intrin, int fisheye_stride)
+    {
+        typedef fisheye_remap_table table_type;
+        if(!fisheye_stride) fisheye_stride = fisheye_intrin.width;
+        table_type table;
+        table.width = rect_intrin.width;
+        table.height = rect_intrin.height;
+        table.source_stride = fisheye_stride;
+        const int tiles_per_row = (table.width + table_type::tile_width - 1) / table_type::tile_width;
+        const int tile_rows = (table.height + table_type::tile_height - 1) / table_type::tile_height;
+        table.indices.assign(tiles_per_row * tile_rows * table_type::tile_size, -1);
+        table.weights_x.assign(table.indices.size(), 0);
+        table.weights_y.assign(table.indices.size(), 0);
+
+        // Points at infinity only turn, so the translation between the cameras plays no part
+        rs_extrinsics rotation = rect_to_fisheye;
+        rotation.translation[0] = rotation.translation[1] = rotation.translation[2] = 0;
+        const float w = fisheye_intrin.coeffs[0], tan_half_w = std::tan(w / 2);
+        for(int y = 0; y < table.height; ++y)
+        {
+            for(int x = 0; x < table.width; ++x)
+            {
+                const float pixel[] = { (float)x, (float)y }, unit[] = { (pixel[0] - rect_intrin.ppx) / rect_intrin.fx, (pixel[1] - rect_intrin.ppy) / rect_intrin.fy, 1 };
+                float ray[3];
+                rs_transform_point_to_point(ray, &rotation, unit);
+                if(ray[2] <= 0) continue;
+
+                // The f-theta model bends a ray at radius r of the image plane to radius atan(2 r tan(w/2)) / w
+                float u = ray[0] / ray[2], v = ray[1] / ray[2];
+                const float r = std::sqrt(u*u + v*v);
+                if(r > 1e-7f && w > 0)
+                {
+                    const float scale = std::atan(2 * r * tan_half_w) / (w * r);
+                    u *= scale;
+                    v *= scale;
+                }
+                const float fx = u * fisheye_intrin.fx + fisheye_intrin.ppx, fy = v * fisheye_intrin.fy + fisheye_intrin.ppy;
+                if(!(fx >= 0 && fy >= 0 && fx <= fisheye_intrin.width - 1 && fy <= fisheye_intrin.height - 1)) continue;
+
+                const int x0 = std::max(0, std::min((int)fx, fisheye_intrin.width - 2)), y0 = std::max(0, std::min((int)fy, fisheye_intrin.height - 2));
+                const int entry = ((y / table_type::tile_height) * tiles_per_row + x / table_type::tile_width) * table_type::tile_size + (y % table_type::tile_height) * table_type::tile_width + x % table_type::tile_width;
+                table.indices[entry] = y0 * fisheye_stride + x0;
+                table.weights_x[entry] = static_cast<uint8_t>(std::min<int>(table_type::weight_one, (int)std::round((fx - x0) * table_type::weight_one)));
+                table.weights_y[entry] = static_cast<uint8_t>(std::min<int>(table_type::weight_one, (int)std::round((fy - y0) * table_type::weight_one)));
+            }
+        }
+        return table;
+    }
+
+    // Weights out of 64, so the horizontal blends fit 16 bits and the vertical blend is rounded off 12 bits, as the block kernels compute it
+    inline uint8_t blend_bilinear_pixel(int p00, int p01, int p10, int p11, int wx, int wy)
+    {
+        const int one = fisheye_remap_table::weight_one, top = p00 * (one - wx) + p01 * wx, bottom = p10 * (one - wx) + p11 * wx;
+        return static_cast<uint8_t>((top * (one - wy) + bottom * wy + one * one / 2) >> 12);
+    }
+
+    void remap_fisheye_image(uint8_t * rect_pixels, const fisheye_remap_table & table, const uint8_t * fisheye_pixels, int rect_stride)
+    {
+        typedef fisheye_remap_table table_type;
+        static_assert(table_type::weight_one * table_type::weight_one == 1 << 12, "blends are rounded off 12 bits");
+        if(!rect_stride) rect_stride = table.width;
+        const int tiles_per_row = (table.width + table_type::tile_width - 1) / table_type::tile_width;
+        const int tile_rows = (table.height + table_type::tile_height - 1) / table_type::tile_height;
+        void(*block)(uint8_t * out, const uint8_t * p00, const uint8_t * p01, const uint8_t * p10, const uint8_t * p11, const uint8_t * wx, const uint8_t * wy) = SIMD_BLOCK(blend_bilinear);
+        get_shared_parallel_pool().parallel_for(tile_rows, [&](int tile_row)
+        {
+            // The four neighbours of a row of a tile are gathered first, then blended a block at a time
+            uint8_t p[4][table_type::tile_width];
+            const int tile_y = tile_row * table_type::tile_height, rows = std::min<int>(table_type::tile_height, table.height - tile_y);
+            for(int i = 0; i < tiles_per_row; ++i)
+            {
+                const int tile_x = i * table_type::tile_width, columns = std::min<int>(table_type::tile_width, table.width - tile_x);
+                for(int y = 0; y < rows; ++y)
+                {
+                    const int first = (tile_row * tiles_per_row + i) * table_type::tile_size + y * table_type::tile_width;
+                    auto indices = table.indices.data() + first;
+                    auto wx = table.weights_x.data() + first, wy = table.weights_y.data() + first;
+                    for(int x = 0; x < columns; ++x)
+                    {
+                        if(indices[x] < 0) { p[0][x] = p[1][x] = p[2][x] = p[3][x] = 0; continue; }
+                        auto source = fisheye_pixels + indices[x];
+                        p[0][x] = source[0];
+                        p[1][x] = source[1];
+                        p[2][x] = source[table.source_stride];
+                        p[3][x] = source[table.source_stride + 1];
+                    }
+
+                    auto out = rect_pixels + (tile_y + y) * rect_stride + tile_x;
+                    int x = 0;
+                    if(block) for(; x + 16 <= columns; x += 16) block(out + x, p[0] + x, p[1] + x, p[2] + x, p[3] + x, wx + x, wy + x);
+                    for(; x < columns; ++x) out[x] = blend_bilinear_pixel(p[0][x], p[1][x], p[2][x], p[3][x], wx[x], wy[x]);
+                }
+            }
+        });
     }
 }
 
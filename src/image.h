@@ -12,20 +12,254 @@ namespace rsimpl
 
     size_t           get_image_size                 (int width, int height, rs_format format);
     int              get_image_bpp                  (rs_format format);
-    void             deproject_z                    (float * points, const rs_intrinsics & z_intrin, const uint16_t * z_pixels, float z_scale);
-    void             deproject_disparity            (float * points, const rs_intrinsics & disparity_intrin, const uint16_t * disparity_pixels, float disparity_scale);
-
-    void             align_z_to_other               (byte * z_aligned_to_other, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, 
-                                                     const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin);
-    void             align_disparity_to_other       (byte * disparity_aligned_to_other, const uint16_t * disparity_pixels, float disparity_scale, const rs_intrinsics & disparity_intrin, 
-                                                     const rs_extrinsics & disparity_to_other, const rs_intrinsics & other_intrin);
-    void             align_other_to_z               (byte * other_aligned_to_z, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, 
-                                                     const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels, rs_format other_format);
-    void             align_other_to_disparity       (byte * other_aligned_to_disparity, const uint16_t * disparity_pixels, float disparity_scale, const rs_intrinsics & disparity_intrin, 
-                                                     const rs_extrinsics & disparity_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels, rs_format other_format);
-
-    std::vector<int> compute_rectification_table    (const rs_intrinsics & rect_intrin, const rs_extrinsics & rect_to_unrect, const rs_intrinsics & unrect_intrin);
-    void             rectify_image                  (uint8_t * rect_pixels, const std::vector<int> & rectification_table, const uint8_t * unrect_pixels, rs_format format);
+    inline bool      is_yuv420                      (rs_format format) { return format == RS_FORMAT_NV12 || format == RS_FORMAT_I420; } // Planar, with chroma planes after the luminance
+    void             pack_strided_samples           (byte * dest, const byte * source, int count, int pixel_stride); // Gathers count bytes, pixel_stride bytes apart, reading nothing past the last
+
+    struct changed_tiles;
+
+    // Strides in pixels between the first pixels of consecutive rows of the images a kernel reads and writes, such as native frames keeping
+    // the padding of their mode or derived images with aligned rows. A stride of 0 stands for rows exactly as wide as their image.
+    struct image_strides
+    {
+        int source; // The depth image, or the image rectified
+        int other;  // The image aligned to depth
+        int dest;   // The image written
+        const uint32_t * source_runs = nullptr; // The runs of valid pixels of the depth image found by find_depth_runs(...), if any, so kernels only visit pixels with data
+        const changed_tiles * source_changes = nullptr; // The tiles of the depth image that changed since the points were last written, if only those are to be rewritten
+        explicit image_strides(int source = 0, int other = 0, int dest = 0) : source(source), other(other), dest(dest) {}
+    };
+    std::vector<float> compute_deprojection_table   (const rs_intrinsics & intrin); // The x and y of the point at unit depth behind every pixel
+
+    // Deprojection walks the table in rows of width pixels, which only matters when strides are given
+    void             deproject_z                    (byte * points, rs_format points_format, const std::vector<float> & deprojection_table, const uint16_t * z_pixels, float z_scale, // Into XYZ32F, XYZ16F, XYZ16 or XYZ32F_PLANAR
+                                                     int width = 0, const image_strides & strides = image_strides());
+    void             deproject_disparity            (byte * points, rs_format points_format, const std::vector<float> & deprojection_table, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth,
+                                                     int width = 0, const image_strides & strides = image_strides());
+
+    // Into XYZUV32F, projecting every point into the texture image in the same pass. Points without depth get texture coordinates of zero.
+    void             deproject_z_textured           (byte * points, const std::vector<float> & deprojection_table, const uint16_t * z_pixels, float z_scale,
+                                                     const rs_extrinsics & depth_to_texture, const rs_intrinsics & texture_intrin, int width = 0, const image_strides & strides = image_strides());
+    void             deproject_disparity_textured   (byte * points, const std::vector<float> & deprojection_table, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth,
+                                                     const rs_extrinsics & depth_to_texture, const rs_intrinsics & texture_intrin, int width = 0, const image_strides & strides = image_strides());
+
+    // Into XYZ32F, the unit normal of the surface at every pixel, facing the camera: the cross product of the differences between the points of
+    // its vertical and of its horizontal neighbours. Pixels on the border of the image, or missing depth at themselves or a neighbour, get zero.
+    // Each row of points is deprojected once into a ring of three rows, so the depth image is read in a single pass.
+    void             compute_z_normals              (float * normals, const std::vector<float> & deprojection_table, const uint16_t * z_pixels, float z_scale,
+                                                     int width, int height, const image_strides & strides = image_strides());
+    void             compute_disparity_normals      (float * normals, const std::vector<float> & deprojection_table, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth,
+                                                     int width, int height, const image_strides & strides = image_strides());
+
+    // Deprojects straight into a grid of cubes leaf_size meters wide, and writes the mean point of every cube holding any, in the order the cubes
+    // were first reached. Returns the number of points, every point after them is zero. The points are a list, so only the depth rows are strided.
+    int              deproject_z_to_voxels          (byte * points, rs_format points_format, const std::vector<float> & deprojection_table, const uint16_t * z_pixels, float z_scale, float leaf_size,
+                                                     int width = 0, int z_stride = 0);
+    int              deproject_disparity_to_voxels  (byte * points, rs_format points_format, const std::vector<float> & deprojection_table, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth, float leaf_size,
+                                                     int width = 0, int disparity_stride = 0);
+
+    // One depth image of a fused point cloud, with the rays of its pixels and the pose of its camera in the common frame of reference
+    struct fused_depth_image
+    {
+        const uint16_t *            z_pixels;
+        int                         width, height, z_stride;    // A stride of 0 stands for rows exactly as wide as the image
+        const std::vector<float> *  deprojection_table;
+        float                       z_scale;
+        rs_extrinsics               to_common;
+    };
+    // Deprojects the pixels with depth of every image and moves them into the common frame in the same pass, into a list of XYZ32F points
+    // which must have room for every pixel. With a leaf_size above zero, the points of all images are merged into cubes of the common frame
+    // as for deproject_z_to_voxels(...). Returns the number of points.
+    int              fuse_depth_to_points           (float * points, const std::vector<fused_depth_image> & images, float leaf_size);
+
+    // Batches of the functions of rsutil.h, whose results they match, for intrinsics of a distortion model the single point functions accept
+    void             project_points_to_pixels       (float * pixels, const rs_intrinsics & intrin, const float * points, int count);
+    void             deproject_pixels_to_points     (float * points, const rs_intrinsics & intrin, const float * pixels, const float * depths, int count);
+    void             transform_points_to_points     (float * to_points, const rs_extrinsics & extrin, const float * from_points, int count); // Which may be the same array
+
+    // One set of projection kernels built for the same instruction set, each returning the number of leading points it handled
+    struct projection_kernels
+    {
+        int(*project)(float * pixels, const rs_intrinsics & intrin, const float * points, int count);
+        int(*project_distorted)(float * pixels, const rs_intrinsics & intrin, const float * points, int count);                            // RS_DISTORTION_MODIFIED_BROWN_CONRADY
+        int(*deproject)(float * points, const rs_intrinsics & intrin, const float * pixels, const float * depths, int count);
+        int(*deproject_undistorted)(float * points, const rs_intrinsics & intrin, const float * pixels, const float * depths, int count);  // RS_DISTORTION_INVERSE_BROWN_CONRADY
+        int(*transform)(float * to_points, const rs_extrinsics & extrin, const float * from_points, int count);
+    };
+    const projection_kernels * get_projection_kernels_avx2(); // Returns nullptr if the variant was not compiled into this binary
+
+    std::vector<float> compute_disparity_to_depth_table(float disparity_scale); // Depth in meters of every 16 bit disparity value, zero for no data
+    void             convert_disparity_to_z16       (uint16_t * z_pixels, const uint16_t * disparity_pixels, int count, float disparity_scale, float z_scale); // Through a lookup table, zero for no data or out of range
+    void             decimate_depth                 (uint16_t * pixels, int width, int height, int factor, bool mean); // In place, into the top-left (width / factor) x (height / factor) pixels
+
+    // Levels 1 to levels of a depth pyramid, one after the other behind pyramid, level k being (width >> k) x (height >> k) pixels. Every pixel
+    // is the mean of the non-zero pixels of the 2x2 block under it, and all levels are built in one pass over the depth image.
+    size_t           get_depth_pyramid_size         (int width, int height, int levels); // Bytes of levels 1 to levels
+    void             build_depth_pyramid            (uint16_t * pyramid, const uint16_t * pixels, int width, int height, int levels);
+
+    // A sparse view of a depth image: row_runs[y] to row_runs[y + 1] index the runs of row y, x being the first pixel of a run of count
+    // consecutive pixels with data. The height + 1 offsets are followed by the runs themselves, and rows of all-zero pixels are skipped 8 at a time.
+    struct depth_run { uint16_t x, count; };
+    inline const depth_run * get_depth_runs         (const uint32_t * row_runs, int height) { return reinterpret_cast<const depth_run *>(row_runs + height + 1); }
+    size_t           get_depth_runs_size            (int width, int height); // Bytes needed by the worst case of a run behind every other pixel
+    size_t           get_depth_runs_offset          (int width, int height, int pyramid_levels); // Bytes from the depth image to its runs, behind its pyramid
+    int              find_depth_runs                (uint32_t * row_runs, const uint16_t * pixels, int width, int height); // Returns the number of runs
+
+    // Edge-preserving smoothing in place: every pixel is blended with its already smoothed neighbour, along rows in both directions and then
+    // along columns in both directions, unless either has no data or they differ by delta or more. alpha is the weight of the pixel itself.
+    void             filter_depth_spatial           (uint16_t * pixels, int width, int height, float alpha, int delta);
+
+    // Exponential smoothing of every pixel over time. Pixels without data report their last depth for up to persistence frames.
+    struct temporal_depth_history
+    {
+        std::vector<uint16_t> last; // Smoothed depth of every pixel, as of the last frame it had data
+        std::vector<uint8_t>  age;  // Frames since then, saturating
+    };
+    void             filter_depth_temporal          (uint16_t * pixels, int count, temporal_depth_history & history, float alpha, int delta, int persistence); // Frames must be passed in order
+
+    // Summary of the pixels with data in a depth image. Bin 0 of the histogram counts depths from 1 to 255, and every further bin k the depths
+    // from 128 << k up to twice that, except the last, which is open ended.
+    struct depth_statistics
+    {
+        enum { histogram_bins = 8 };
+        uint16_t min, max;                  // min stays 0xFFFF while there are no valid pixels
+        uint32_t valid;
+        uint32_t histogram[histogram_bins];
+        depth_statistics() : min(0xFFFF), max(0), valid(0) { for(auto & bin : histogram) bin = 0; }
+    };
+    void             accumulate_depth_statistics    (const uint16_t * pixels, int count, depth_statistics & statistics, uint16_t * copy = nullptr); // Optionally copies the pixels in the same pass
+    int              histogram_of_samples           (const uint8_t * pixels, int width, int height, int stride, int sample_rate, int histogram[256]); // Of every sample_rate-th pixel of every sample_rate-th row, returns how many were sampled
+
+    // Color of every 16 bit depth or disparity value, packed as R | G << 8 | B << 16, from red when near to blue when far, and dark for no data.
+    // Equalized maps spread the colors evenly over the depths of the latest frame. Every entry outside the range of values that frame holds has
+    // the color of the nearest or farthest depth, so a new frame only rebuilds the entries between the lowest and highest value of both frames.
+    struct depth_colormap
+    {
+        std::vector<uint32_t> lut;                      // 0x10000 entries, empty until the first update
+        std::vector<uint32_t> histogram;                // Of the latest equalized frame, zero outside [histogram_lowest, histogram_highest]
+        int histogram_lowest, histogram_highest;
+        int stale_lowest, stale_highest;                // Entries outside this range hold the color of the extreme on their side
+        bool equalized, disparity;                      // What the entries were computed for
+        float depth_scale, max_distance;
+        depth_colormap() : histogram_lowest(1), histogram_highest(0), stale_lowest(1), stale_highest(0), equalized(), disparity(), depth_scale(), max_distance() {}
+    };
+    void             update_depth_colormap          (depth_colormap & map, const uint16_t * pixels, int count, float depth_scale, const std::vector<float> * disparity_to_depth, // Null for Z16
+                                                     bool equalized, float max_distance); // Meters drawn in the farthest color, unless equalized
+    void             colorize_depth                 (byte * rgb, const uint16_t * pixels, int count, const uint32_t * lut); // Into RGB8
+
+    typedef int (*depth_colorizer)(byte * rgb, const uint16_t * pixels, int count, const uint32_t * lut); // Returns the number of leading pixels it colored
+    depth_colorizer  get_depth_colorizer_avx2       (); // Returns nullptr if the variant was not compiled into this binary
+
+    std::vector<float> compute_alignment_rays       (const rs_intrinsics & depth_intrin, const rs_extrinsics & depth_to_other); // Unit-depth rays through every pixel corner, rotated into the other camera
+    void             align_z_to_other               (byte * z_aligned_to_other, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, const std::vector<float> & z_rays,
+                                                     const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin, const image_strides & strides = image_strides());
+    void             align_disparity_to_other       (byte * disparity_aligned_to_other, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth, const rs_intrinsics & disparity_intrin, const std::vector<float> & disparity_rays,
+                                                     const rs_extrinsics & disparity_to_other, const rs_intrinsics & other_intrin, const image_strides & strides = image_strides());
+    void             align_other_to_z               (byte * other_aligned_to_z, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, const std::vector<float> & z_rays,
+                                                     const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels, rs_format other_format, const image_strides & strides = image_strides());
+    void             align_other_to_disparity       (byte * other_aligned_to_disparity, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth, const rs_intrinsics & disparity_intrin, const std::vector<float> & disparity_rays,
+                                                     const rs_extrinsics & disparity_to_other, const rs_intrinsics & other_intrin, const byte * other_pixels, rs_format other_format, const image_strides & strides = image_strides());
+    void             align_yuy2_to_z                (byte * rgb_aligned_to_z, const uint16_t * z_pixels, float z_scale, const rs_intrinsics & z_intrin, const std::vector<float> & z_rays,
+                                                     const rs_extrinsics & z_to_other, const rs_intrinsics & other_intrin, const byte * yuy2_pixels, const image_strides & strides = image_strides()); // Converts only the YUY2 pixels that land on depth, to RGB8
+    void             align_yuy2_to_disparity        (byte * rgb_aligned_to_disparity, const uint16_t * disparity_pixels, const std::vector<float> & disparity_to_depth, const rs_intrinsics & disparity_intrin, const std::vector<float> & disparity_rays,
+                                                     const rs_extrinsics & disparity_to_other, const rs_intrinsics & other_intrin, const byte * yuy2_pixels, const image_strides & strides = image_strides());
+
+    // Maps every rectified pixel to the unrectified pixel it is copied from. Indices are stored per tile of rectified pixels, as 16 bit offsets
+    // from one 32 bit base, which halves the table of a full resolution image. Tiles whose sources spread too far keep 32 bit offsets instead.
+    struct rectification_table
+    {
+        enum { tile_width = 64, tile_height = 4, tile_size = tile_width * tile_height };
+        struct tile { int32_t base, first; bool wide; };    // first indexes narrow_offsets, or wide_offsets if wide, for tile_size entries in row-major order
+        int                  width, height;                 // Of the rectified image
+        std::vector<tile>    tiles;                         // Row-major, (width + tile_width - 1) / tile_width per row of tiles
+        std::vector<int16_t> narrow_offsets;
+        std::vector<int32_t> wide_offsets;
+        struct window { int32_t x0, y0, x1, y1; };         // Inclusive
+        std::vector<window>  sources;                       // The pixels of the unrectified image each tile reads, so tiles whose source did not change can be skipped
+    };
+
+    // The tiles of an image that differ from those of the previous image of the same shape, so that images derived from it pixel by pixel
+    // are only recomputed where it changed. Rows of tiles are compared 16 bytes at a time, which costs a fraction of recomputing them.
+    struct changed_tiles
+    {
+        enum { tile_width = rectification_table::tile_width, tile_height = rectification_table::tile_height };
+        int                  columns = 0, rows = 0;         // Of tiles
+        std::vector<uint8_t> changed;                       // Row-major, nonzero for every tile with a pixel that changed
+        int                  count = 0;                     // Of tiles that changed
+        bool                 any_within(const rectification_table::window & pixels) const; // Whether a tile overlapping these pixels changed
+    };
+    void             find_changed_tiles             (changed_tiles & tiles, const byte * previous, int previous_stride, const byte * current, int current_stride, int width, int height, int pixel_size); // Strides in pixels
+
+    // The table indexes the unrectified image in rows of unrect_stride pixels, so only the rows of the rectified image are strided when it is applied
+    rectification_table compute_rectification_table (const rs_intrinsics & rect_intrin, const rs_extrinsics & rect_to_unrect, const rs_intrinsics & unrect_intrin, int unrect_stride = 0);
+    void             rectify_image                  (uint8_t * rect_pixels, const rectification_table & table, const uint8_t * unrect_pixels, rs_format format, int rect_stride = 0,
+                                                     const changed_tiles * unrect_changes = nullptr); // If given, only the tiles reading pixels that changed are rewritten
+
+    // Samples an RS_DISTORTION_FTHETA image bilinearly at every pixel of an undistorted image. Entries are laid out per tile of the
+    // undistorted image like those of rectification_table, so each tile reads its part of the table in order and a compact patch of the source.
+    struct fisheye_remap_table
+    {
+        enum { tile_width = 64, tile_height = 4, tile_size = tile_width * tile_height, weight_one = 64 };
+        int                  width, height;                 // Of the undistorted image
+        int                  source_stride;                 // Pixels between the rows of the source image
+        std::vector<int32_t> indices;                       // Per entry, the top-left of the 2x2 source pixels it blends, -1 outside the source image
+        std::vector<uint8_t> weights_x, weights_y;          // Per entry, the weights of the right and bottom source pixels, out of weight_one
+    };
+    fisheye_remap_table compute_fisheye_remap_table (const rs_intrinsics & rect_intrin, const rs_extrinsics & rect_to_fisheye, const rs_intrinsics & fisheye_intrin, int fisheye_stride = 0); // Only the rotation is applied
+    void             remap_fisheye_image            (uint8_t * rect_pixels, const fisheye_remap_table & table, const uint8_t * fisheye_pixels, int rect_stride = 0); // Of one byte per pixel
+
+    // One complete set of YUY2 unpackers, all built for the same instruction set. Pixel counts must be multiples of 16.
+    struct yuy2_unpackers
+    {
+        const char * name;
+        void(*y8)(byte * const dest[], const byte * source, int count);
+        void(*y16)(byte * const dest[], const byte * source, int count);
+        void(*rgb8)(byte * const dest[], const byte * source, int count);
+        void(*rgba8)(byte * const dest[], const byte * source, int count);
+        void(*bgr8)(byte * const dest[], const byte * source, int count);
+        void(*bgra8)(byte * const dest[], const byte * source, int count);
+
+        // Unpacks a pair of rows into their luminance rows and one row of the chroma of both, averaged and rounded up. Chroma is interleaved into u,
+        // as NV12 has it, when v is null. Takes any even count of pixels, and returns how many of the first it unpacked, leaving the rest to the caller.
+        int(*yuv420)(byte * y0, byte * y1, byte * u, byte * v, const byte * s0, const byte * s1, int count);
+    };
+
+    const yuy2_unpackers *              get_yuy2_unpackers_ssse3();     // Returns nullptr if the variant was not compiled into this binary
+    const yuy2_unpackers *              get_yuy2_unpackers_avx2();
+    const yuy2_unpackers *              get_yuy2_unpackers_avx512bw();
+    const yuy2_unpackers *              get_yuy2_unpackers_neon();
+    std::vector<const yuy2_unpackers *> get_available_yuy2_unpackers(); // Scalar first, then every compiled-in variant the running CPU supports, widest last
+
+    // Unpacks rows first_row to first_row + row_count of a YUY2 image into the planes of an NV12 or I420 image of width x height pixels. Each
+    // chroma sample is the average of a pair of rows, or of the last row alone if height is odd. Bands of rows starting on even rows are independent.
+    void unpack_yuy2_to_yuv420(byte * image, rs_format format, int width, int height, const byte * source, size_t source_stride, int first_row, int row_count);
+
+    // One set of Bayer demosaicing kernels, all built for the same instruction set. A kernel demosaics one row of an RGGB image from rows[2], the
+    // rows two above to two below it holding one 10 bit value per pixel in 16 bits, with two pixels of border before and after each. The R or B
+    // pixels of the row lie in its even columns if sites_even, and on a red row if red_row. Colors are interpolated bilinearly, or corrected by
+    // the gradients of the color known at each pixel, which follows edges that bilinear interpolation blurs (Malvar, He and Cutler, 2004).
+    // Kernels return how many of the first pixels they demosaiced, leaving the rest to the caller.
+    struct bayer_demosaicers
+    {
+        const char * name;
+        int(*rgb8)(byte * out, const uint16_t * const rows[5], int count, bool red_row, bool sites_even, bool corrected);
+        int(*y16)(byte * out, const uint16_t * const rows[5], int count, bool red_row, bool sites_even, bool corrected); // BT.601 luma
+    };
+
+    const bayer_demosaicers *              get_bayer_demosaicers_ssse3();     // Returns nullptr if the variant was not compiled into this binary
+    const bayer_demosaicers *              get_bayer_demosaicers_avx2();
+    const bayer_demosaicers *              get_bayer_demosaicers_avx512bw();
+    const bayer_demosaicers *              get_bayer_demosaicers_neon();
+    std::vector<const bayer_demosaicers *> get_available_bayer_demosaicers(); // Scalar first, then every compiled-in variant the running CPU supports, widest last
+
+    // Demosaics rows first_row to first_row + row_count of an RGB8 or Y16 image of width x height pixels from the window at (x, y) of an RGGB RAW10
+    // image of raw_width x raw_height pixels. Pixels near the edges of the window interpolate from the raw pixels around it, and the raw image is
+    // mirrored past its own edges. Bands of rows are independent.
+    void demosaic_raw10(byte * image, rs_format format, int width, int height, const byte * raw, size_t raw_stride, int raw_width, int raw_height,
+                        int x, int y, int first_row, int row_count, bool corrected);
+
+    // An instance of unpack specialized for rows of width pixels, or nullptr if none was built for this combination. The unpacker is inlined into
+    // a loop of fixed trip count, which the compiler unrolls and vectorizes. Unpackers dispatching to SIMD kernels at run time are not specialized.
+    row_unpack_function find_row_unpacker(void(*unpack)(byte * const dest[], const byte * source, int count), int width);
 
     extern const native_pixel_format pf_raw8;       // Four 8 bit luminance
     extern const native_pixel_format pf_rw10;       // Four 10 bit luminance values in one 40 bit macropixel
@@ -99,9 +99,14 @@ namespace rsimpl
         std::vector<rs_option>  base_opt;
         std::vector<double>     base_opt_val;
 
+        // Values the device is known to hold already are not written again
+        std::vector<rs_option> written_opt(options, options + count);
+        std::vector<double>    written_val(values, values + count);
+        option_cache.drop_known_writes(written_opt, written_val);
+        options = written_opt.data(); values = written_val.data(); count = written_opt.size();
+
         for (size_t i = 0; i < count; ++i)
         {
-
             if (uvc::is_pu_control(options[i]))
             {
                 // Disabling auto-setting controls, if needed
@@ -119,10 +124,10 @@ namespace rsimpl
             switch (options[i])
             {
             case RS_OPTION_F200_LASER_POWER:          ivcam::set_laser_power(get_device(), static_cast<uint8_t>(values[i])); break;
-            case RS_OPTION_F200_ACCURACY:             ivcam::set_accuracy(get_device(), static_cast<uint8_t>(values[i])); break;
+            case RS_OPTION_F200_ACCURACY:             ivcam::set_accuracy(get_device(), static_cast<uint8_t>(values[i])); option_cache.store(options[i], static_cast<uint8_t>(values[i])); break;
             case RS_OPTION_F200_MOTION_RANGE:         ivcam::set_motion_range(get_device(), static_cast<uint8_t>(values[i])); break;
-            case RS_OPTION_F200_FILTER_OPTION:        ivcam::set_filter_option(get_device(), static_cast<uint8_t>(values[i])); break;
-            case RS_OPTION_F200_CONFIDENCE_THRESHOLD: ivcam::set_confidence_threshold(get_device(), static_cast<uint8_t>(values[i])); break;
+            case RS_OPTION_F200_FILTER_OPTION:        ivcam::set_filter_option(get_device(), static_cast<uint8_t>(values[i])); option_cache.store(options[i], static_cast<uint8_t>(values[i])); break;
+            case RS_OPTION_F200_CONFIDENCE_THRESHOLD: ivcam::set_confidence_threshold(get_device(), static_cast<uint8_t>(values[i])); option_cache.store(options[i], static_cast<uint8_t>(values[i])); break;
 
             default: 
                 base_opt.push_back(options[i]); base_opt_val.push_back(values[i]); break;
@@ -147,14 +152,17 @@ namespace rsimpl
             if (uvc::is_pu_control(options[i]))
                 throw std::logic_error(to_string() << __FUNCTION__ << " Option " << options[i] << " must be processed by a concrete class");
 
+            if (option_cache.lookup(options[i], values[i]))
+                continue;
+
             uint8_t val = 0;
             switch (options[i])
             {
             case RS_OPTION_F200_LASER_POWER:          ivcam::get_laser_power(get_device(), val); values[i] = val; break;
-            case RS_OPTION_F200_ACCURACY:             ivcam::get_accuracy(get_device(), val); values[i] = val; break;
+            case RS_OPTION_F200_ACCURACY:             ivcam::get_accuracy(get_device(), val); values[i] = val; option_cache.store(options[i], val); break;
             case RS_OPTION_F200_MOTION_RANGE:         ivcam::get_motion_range(get_device(), val); values[i] = val; break;
-            case RS_OPTION_F200_FILTER_OPTION:        ivcam::get_filter_option(get_device(), val); values[i] = val; break;
-            case RS_OPTION_F200_CONFIDENCE_THRESHOLD: ivcam::get_confidence_threshold(get_device(), val); values[i] = val; break;
+            case RS_OPTION_F200_FILTER_OPTION:        ivcam::get_filter_option(get_device(), val); values[i] = val; option_cache.store(options[i], val); break;
+            case RS_OPTION_F200_CONFIDENCE_THRESHOLD: ivcam::get_confidence_threshold(get_device(), val); values[i] = val; option_cache.store(options[i], val); break;
 
             default: 
                 base_opt.push_back(options[i]); base_opt_index.push_back(i);
@@ -7,6 +7,7 @@
 
 #include "ivcam-private.h"
 #include "device.h"
+#include "option-cache.h"
 
 namespace rsimpl
 {
@@ -26,6 +27,7 @@ namespace rsimpl
 
         ivcam::camera_calib_params base_calibration;
         ivcam::cam_auto_range_request arr;
+        option_value_cache option_cache; // Of the depth options the firmware leaves alone; auto-range drives the laser power and motion range of an SR300
 
     public:
         iv_camera(std::shared_ptr<uvc::device> device, const static_device_info & info, const ivcam::camera_calib_params & calib);
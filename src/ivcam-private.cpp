@@ -5,9 +5,11 @@
 #include <algorithm>
 #include <thread>
 #include <cmath>
+#include <iomanip>
 
 #include "hw-monitor.h"
 #include "ivcam-private.h"
+#include "calibration-store.h"
 
 using namespace rsimpl::hw_monitor;
 using namespace rsimpl::ivcam;
@@ -206,6 +208,36 @@ namespace ivcam {
         }
     }
 
+    // The GVD block, returned for a single command, holds the serial number and the firmware version which key the calibration cache, and signs the entry
+    static void get_cached_calibration_raw_data(uvc::device & device, std::timed_mutex & mutex, const char * model, int serial_offset, uint8_t * data, size_t & bytesReturned,
+        void(*read_raw_data)(uvc::device &, std::timed_mutex &, uint8_t *, size_t &))
+    {
+        if (!calibration_store::is_enabled())
+        {
+            read_raw_data(device, mutex, data, bytesReturned);
+            return;
+        }
+
+        std::vector<uint8_t> gvd(1024);
+        get_gvd(device, mutex, gvd.size(), reinterpret_cast<char *>(gvd.data()));
+        std::ostringstream key;
+        key << model << "-" << std::hex;
+        for (int i = 0; i < 6; ++i) key << std::setw(2) << std::setfill('0') << static_cast<int>(gvd[serial_offset + i]);
+        key << "-" << std::dec << static_cast<int>(gvd[3]) << "." << static_cast<int>(gvd[2]) << "." << static_cast<int>(gvd[1]) << "." << static_cast<int>(gvd[0]);
+
+        const size_t capacity = bytesReturned;
+        auto raw = calibration_store::get(key.str(), gvd, [&]()
+        {
+            std::vector<uint8_t> buffer(HW_MONITOR_BUFFER_SIZE);
+            size_t length = buffer.size();
+            read_raw_data(device, mutex, buffer.data(), length);
+            buffer.resize(std::min(length, buffer.size()));
+            return buffer;
+        });
+        bytesReturned = std::min(capacity, raw.size());
+        memcpy(data, raw.data(), bytesReturned);
+    }
+
     void force_hardware_reset(uvc::device & device, std::timed_mutex & mutex)
     {
         hwmon_cmd cmd((uint8_t)fw_cmd::HWReset);
@@ -426,7 +458,7 @@ namespace f200
     {
         uint8_t rawCalibrationBuffer[HW_MONITOR_BUFFER_SIZE];
         size_t bufferLength = HW_MONITOR_BUFFER_SIZE;
-        get_f200_calibration_raw_data(device, mutex, rawCalibrationBuffer, bufferLength);
+        get_cached_calibration_raw_data(device, mutex, "f200", 96, rawCalibrationBuffer, bufferLength, get_f200_calibration_raw_data);
         return get_f200_calibration(rawCalibrationBuffer, bufferLength);
     }
 
@@ -634,7 +666,7 @@ namespace sr300 {
     {
         uint8_t rawCalibrationBuffer[HW_MONITOR_BUFFER_SIZE];
         size_t bufferLength = HW_MONITOR_BUFFER_SIZE;
-        get_sr300_calibration_raw_data(device, mutex, rawCalibrationBuffer, bufferLength);
+        get_cached_calibration_raw_data(device, mutex, "sr300", 132, rawCalibrationBuffer, bufferLength, get_sr300_calibration_raw_data);
 
         SR300RawCalibration rawCalib;
         memcpy(&rawCalib, rawCalibrationBuffer, std::min(sizeof(rawCalib), bufferLength)); // Is this longer or shorter than the rawCalib struct?
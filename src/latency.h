@@ -0,0 +1,91 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_LATENCY_H
+#define LIBREALSENSE_LATENCY_H
+
+#include "types.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+namespace rsimpl
+{
+    // Milliseconds of the monotonic clock the stages of frames are timed against, as RS_FRAME_METADATA_TIME_OF_* values
+    inline double get_monotonic_time() { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+    // Counts durations in bins of powers of two microseconds, bin 0 counting those under a microsecond, bin i those from 2^(i-1) to 2^i
+    // microseconds, and the last bin those longer. Capture threads add to it while the application reads it, neither ever locking.
+    class latency_histogram
+    {
+        std::atomic<unsigned long long> bins[RS_LATENCY_HISTOGRAM_BIN_COUNT];
+    public:
+        latency_histogram() { reset(); }
+
+        void add(double milliseconds)
+        {
+            int bin = 0;
+            for (auto microseconds = milliseconds > 0 ? static_cast<unsigned long long>(milliseconds * 1000) : 0ull; microseconds && bin < RS_LATENCY_HISTOGRAM_BIN_COUNT - 1; microseconds >>= 1) ++bin;
+            bins[bin].fetch_add(1, std::memory_order_relaxed);
+        }
+        void read(unsigned long long counts[RS_LATENCY_HISTOGRAM_BIN_COUNT]) const { for (int i = 0; i < RS_LATENCY_HISTOGRAM_BIN_COUNT; ++i) counts[i] = bins[i].load(std::memory_order_relaxed); }
+        void reset() { for (auto & b : bins) b.store(0, std::memory_order_relaxed); }
+    };
+
+    // Maps the timestamps of a device clock, in milliseconds, to the monotonic clock of the host. Every frame bounds the offset between the
+    // clocks from above by its dequeue time less its timestamp, which exceeds the offset by the time the frame took to reach the host; the
+    // smallest bound of the last window_size frames is taken as the offset, following the drift of the clocks as the window slides. Times
+    // mapped are therefore late by the quickest transfer of the window. Timestamps or frame counters going backwards, and bounds a second
+    // away from the offset, mean the device clock restarted, and the estimate starts over. Used by the capture thread of a subdevice only.
+    class device_clock_estimator
+    {
+        static const int window_size = 128;
+        double bounds[window_size];
+        int count, next;
+        double offset, last_timestamp;
+        unsigned long long last_frame_counter;
+    public:
+        device_clock_estimator() : count(0), next(0), offset(0), last_timestamp(0), last_frame_counter(0) {}
+
+        void add(double timestamp, unsigned long long frame_counter, double host_time)
+        {
+            const double bound = host_time - timestamp;
+            if (count && (timestamp < last_timestamp || frame_counter < last_frame_counter || std::abs(bound - offset) > 1000)) count = next = 0;
+            last_timestamp = timestamp;
+            last_frame_counter = frame_counter;
+
+            bounds[next] = bound;
+            next = (next + 1) % window_size;
+            if (count < window_size) ++count;
+            offset = *std::min_element(bounds, bounds + count);
+        }
+
+        bool is_valid() const { return count > 0; }
+        double to_host_time(double timestamp) const { return timestamp + offset; }
+    };
+
+    // Time the frames of every native stream took from the driver to each of the later stages of their processing, and from their exposure to
+    // their delivery
+    struct stage_latency_histograms
+    {
+        static const int stage_count = RS_FRAME_METADATA_TIME_OF_DELIVERY - RS_FRAME_METADATA_TIME_OF_VALIDATION + 1;
+        latency_histogram stages[RS_STREAM_NATIVE_COUNT][stage_count]; // Indexed by stream, then by metadata - RS_FRAME_METADATA_TIME_OF_VALIDATION
+        latency_histogram exposure_to_delivery[RS_STREAM_NATIVE_COUNT];
+
+        // Adds the stages a frame went through, from the time its native frame was dequeued, which frames not timed lack
+        void add(rs_stream stream, const double (& metadata)[RS_FRAME_METADATA_COUNT], uint32_t supported_metadata_mask)
+        {
+            if (stream < 0 || stream >= RS_STREAM_NATIVE_COUNT || !(supported_metadata_mask & 1u << RS_FRAME_METADATA_TIME_OF_DEQUEUE)) return;
+            for (int i = 0; i < stage_count; ++i)
+            {
+                if (supported_metadata_mask & 1u << (RS_FRAME_METADATA_TIME_OF_VALIDATION + i)) stages[stream][i].add(metadata[RS_FRAME_METADATA_TIME_OF_VALIDATION + i] - metadata[RS_FRAME_METADATA_TIME_OF_DEQUEUE]);
+            }
+            const uint32_t exposed_and_delivered = 1u << RS_FRAME_METADATA_TIME_OF_EXPOSURE | 1u << RS_FRAME_METADATA_TIME_OF_DELIVERY;
+            if ((supported_metadata_mask & exposed_and_delivered) == exposed_and_delivered) exposure_to_delivery[stream].add(metadata[RS_FRAME_METADATA_TIME_OF_DELIVERY] - metadata[RS_FRAME_METADATA_TIME_OF_EXPOSURE]);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,124 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_LIBUSB_INTERRUPTS_H
+#define LIBREALSENSE_LIBUSB_INTERRUPTS_H
+
+#include "types.h"
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include <libusb.h>
+
+namespace rsimpl
+{
+    namespace uvc
+    {
+        // Keeps a ring of interrupt transfers queued on one endpoint, so that the device always has somewhere to put the next packet while
+        // the previous ones are handed to the callback. Shared by the backends which reach the motion module through libusb.
+        class interrupt_transfer_ring
+        {
+            typedef std::function<void(const unsigned char * data, int size)> data_callback;
+
+            const data_callback on_data;
+            std::vector<libusb_transfer *> transfers;
+            std::vector<std::vector<unsigned char>> buffers;
+            std::atomic<int> in_flight;
+            std::atomic<bool> stopping;
+
+            // Runs on whichever thread is handling the events of the USB context, which libusb never lets two threads do at once
+            static void LIBUSB_CALL on_complete(libusb_transfer * transfer)
+            {
+                auto ring = static_cast<interrupt_transfer_ring *>(transfer->user_data);
+                switch(transfer->status)
+                {
+                case LIBUSB_TRANSFER_COMPLETED:
+                    try { ring->on_data(transfer->buffer, transfer->actual_length); }
+                    catch(const std::exception & e) { LOG_ERROR("Motion data callback failed: " << e.what()); }
+                    break;
+                case LIBUSB_TRANSFER_TIMED_OUT:
+                    break;
+                case LIBUSB_TRANSFER_CANCELLED:
+                    --ring->in_flight;
+                    return;
+                case LIBUSB_TRANSFER_NO_DEVICE:
+                    LOG_ERROR("Motion data endpoint disconnected");
+                    --ring->in_flight;
+                    return;
+                default:
+                    LOG_WARNING("Motion data transfer failed with status " << transfer->status);
+                    break;
+                }
+
+                if(!ring->stopping)
+                {
+                    int status = libusb_submit_transfer(transfer);
+                    if(status == 0) return;
+                    LOG_ERROR("libusb_submit_transfer(...) returned " << libusb_error_name(status));
+                }
+                --ring->in_flight;
+            }
+
+            // Waits for completions for up to 100 ms, returns false if events can no longer be handled
+            static bool handle_events(libusb_context * context)
+            {
+                timeval timeout = { 0, 100000 };
+                int status = libusb_handle_events_timeout_completed(context, &timeout, nullptr);
+                if(status == 0 || status == LIBUSB_ERROR_INTERRUPTED) return true;
+                LOG_ERROR("libusb_handle_events_timeout_completed(...) returned " << libusb_error_name(status));
+                return false;
+            }
+
+        public:
+            interrupt_transfer_ring(libusb_device_handle * handle, unsigned char endpoint, int transfer_size, int transfer_count, data_callback on_data)
+                : on_data(on_data), buffers(transfer_count, std::vector<unsigned char>(transfer_size)), in_flight(0), stopping(false)
+            {
+                for(auto & buffer : buffers)
+                {
+                    auto transfer = libusb_alloc_transfer(0);
+                    if(!transfer)
+                    {
+                        for(auto allocated : transfers) libusb_free_transfer(allocated);
+                        throw std::runtime_error("libusb_alloc_transfer(...) failed");
+                    }
+                    libusb_fill_interrupt_transfer(transfer, handle, endpoint, buffer.data(), transfer_size, &on_complete, this, 0);
+                    transfers.push_back(transfer);
+                }
+            }
+
+            ~interrupt_transfer_ring()
+            {
+                // Transfers libusb still owns are leaked rather than freed under it
+                if(in_flight) LOG_ERROR(in_flight.load() << " motion data transfers could not be reclaimed");
+                else for(auto transfer : transfers) libusb_free_transfer(transfer);
+            }
+
+            // Submits every transfer and services their completions until stop is raised, then cancels the queued transfers and waits for them
+            void run(libusb_context * context, const volatile bool & stop)
+            {
+                for(auto transfer : transfers)
+                {
+                    ++in_flight; // Before submitting, as another thread handling events may complete the transfer right away
+                    int status = libusb_submit_transfer(transfer);
+                    if(status < 0)
+                    {
+                        LOG_ERROR("libusb_submit_transfer(...) returned " << libusb_error_name(status));
+                        --in_flight;
+                        break;
+                    }
+                }
+
+                while(!stop && in_flight && handle_events(context)) {}
+
+                stopping = true;
+                for(auto transfer : transfers) libusb_cancel_transfer(transfer); // Fails harmlessly for transfers which are not queued
+                while(in_flight && handle_events(context)) {}
+            }
+        };
+    }
+}
+
+#endif
@@ -395,6 +395,24 @@ typedef struct uvc_frame {
  */
 typedef void(uvc_frame_callback_t)(struct uvc_frame *frame, void *user_ptr);
 
+/** A callback function supplying a buffer of at least size bytes to assemble
+ * the next frame in, or NULL if none is free, in which case a frame is dropped
+ * @ingroup streaming
+ */
+typedef uint8_t *(uvc_frame_buffer_acquire_t)(size_t size, void *user_ptr);
+
+/** A callback function taking back a buffer obtained from a
+ * {uvc_frame_buffer_acquire_t} which no frame is assembled in anymore
+ * @ingroup streaming
+ */
+typedef void(uvc_frame_buffer_release_t)(uint8_t *buffer, void *user_ptr);
+
+/** A callback function taking the rows of a frame as they arrive, ahead of
+ * the frame: rows points to row first_row of the frame being assembled
+ * @ingroup streaming
+ */
+typedef void(uvc_frame_slice_callback_t)(const uint8_t *rows, uint32_t first_row, uint32_t row_count, void *user_ptr);
+
 /** Streaming mode, includes all information needed to select stream
  * @ingroup streaming
  */
@@ -499,6 +517,15 @@ void uvc_stop_streaming(uvc_device_handle_t *devh);
 
 uvc_error_t uvc_stream_open_ctrl(uvc_device_handle_t *devh, uvc_stream_handle_t **strmh, uvc_stream_ctrl_t *ctrl);
 uvc_error_t uvc_stream_ctrl(uvc_stream_handle_t *strmh, uvc_stream_ctrl_t *ctrl);
+uvc_error_t uvc_stream_set_frame_buffers(uvc_stream_handle_t *strmh,
+    uvc_frame_buffer_acquire_t *acquire,
+    uvc_frame_buffer_release_t *release,
+    void *user_ptr);
+uvc_error_t uvc_stream_set_slice_callback(uvc_stream_handle_t *strmh,
+    uint32_t rows_per_slice,
+    size_t row_bytes,
+    uvc_frame_slice_callback_t *cb,
+    void *user_ptr);
 uvc_error_t uvc_stream_start(uvc_stream_handle_t *strmh,
     uvc_frame_callback_t *cb,
     void *user_ptr,
@@ -234,6 +234,20 @@ struct uvc_stream_handle {
   uint32_t last_scr, hold_last_scr;
   size_t got_bytes, hold_bytes;
   uint8_t *outbuf, *holdbuf;
+  /* where frames are assembled when the user supplies the buffers: outbuf
+   * and holdbuf are taken from acquire_buf, and the user callback becomes
+   * responsible for giving each frame's buffer back through release_buf */
+  size_t outbuf_size;
+  uvc_frame_buffer_acquire_t *acquire_buf;
+  uvc_frame_buffer_release_t *release_buf;
+  void *buf_user_ptr;
+  /* when set, slice_cb sees every slice_rows rows of the frame in outbuf as
+   * soon as they arrive, slice_next_row being the first row it has not seen */
+  uvc_frame_slice_callback_t *slice_cb;
+  void *slice_user_ptr;
+  uint32_t slice_rows;
+  size_t slice_row_bytes;
+  uint32_t slice_next_row;
   pthread_mutex_t cb_mutex;
   pthread_cond_t cb_cond;
   pthread_t cb_thread;
@@ -245,6 +259,9 @@ struct uvc_stream_handle {
   struct uvc_frame frame;
   uint32_t fourcc;
   int num_transfer_bufs;
+  /* transfers and packets which failed since the stream was opened,
+   * counted by the event thread and read from the frame callback */
+  uint64_t transfer_errors;
 };
 
 /** Handle on an open UVC device
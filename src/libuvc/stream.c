@@ -372,8 +372,29 @@ void _uvc_swap_buffers(uvc_stream_handle_t *strmh) {
 
   pthread_mutex_lock(&strmh->cb_mutex);
 
+  if (strmh->acquire_buf) {
+    /* assemble the next frame in a fresh user buffer, or else in the one
+     * still held for a callback that has not picked it up yet */
+    tmp_buf = strmh->acquire_buf(strmh->outbuf_size, strmh->buf_user_ptr);
+    if (!tmp_buf) {
+      tmp_buf = strmh->holdbuf;
+      strmh->holdbuf = NULL;
+    }
+
+    if (!tmp_buf) {
+      /* every buffer is out with the user: drop this frame and reuse its buffer */
+      pthread_mutex_unlock(&strmh->cb_mutex);
+      goto reset;
+    }
+
+    if (strmh->holdbuf)
+      strmh->release_buf(strmh->holdbuf, strmh->buf_user_ptr);
+    strmh->holdbuf = NULL;
+  } else {
+    tmp_buf = strmh->holdbuf;
+  }
+
   /* swap the buffers */
-  tmp_buf = strmh->holdbuf;
   strmh->hold_bytes = strmh->got_bytes;
   strmh->holdbuf = strmh->outbuf;
   strmh->outbuf = tmp_buf;
@@ -384,12 +405,42 @@ void _uvc_swap_buffers(uvc_stream_handle_t *strmh) {
   pthread_cond_broadcast(&strmh->cb_cond);
   pthread_mutex_unlock(&strmh->cb_mutex);
 
+reset:
+
   strmh->seq++;
   strmh->got_bytes = 0;
+  strmh->slice_next_row = 0;
   strmh->last_scr = 0;
   strmh->pts = 0;
 }
 
+/** @internal
+ * @brief Hand the rows of the frame being assembled to the slice callback
+ *
+ * Every slice_rows rows completed since the last slice are handed out in
+ * place, from outbuf. At the end of a frame, the rows left over are handed
+ * out as a shorter slice.
+ *
+ * @param end_of_frame Nonzero once the last payload of the frame arrived
+ */
+static void _uvc_process_slices(uvc_stream_handle_t *strmh, int end_of_frame) {
+  uint32_t rows, count;
+
+  if (!strmh->slice_cb)
+    return;
+
+  rows = strmh->got_bytes / strmh->slice_row_bytes;
+  while (rows - strmh->slice_next_row >= strmh->slice_rows ||
+         (end_of_frame && rows > strmh->slice_next_row)) {
+    count = rows - strmh->slice_next_row;
+    if (count > strmh->slice_rows)
+      count = strmh->slice_rows;
+    strmh->slice_cb(strmh->outbuf + strmh->slice_next_row * strmh->slice_row_bytes,
+        strmh->slice_next_row, count, strmh->slice_user_ptr);
+    strmh->slice_next_row += count;
+  }
+}
+
 /** @internal
  * @brief Process a payload transfer
  * 
@@ -478,10 +529,17 @@ void _uvc_process_payload(uvc_stream_handle_t *strmh, uint8_t *payload, size_t p
     }
   }
 
+  if (data_len > strmh->outbuf_size - strmh->got_bytes) {
+    UVC_DEBUG("frame overflows its buffer, truncating",);
+    data_len = strmh->outbuf_size - strmh->got_bytes;
+  }
+
   if (data_len > 0) {
     memcpy(strmh->outbuf + strmh->got_bytes, payload + header_len, data_len);
     strmh->got_bytes += data_len;
 
+    _uvc_process_slices(strmh, header_info & (1 << 1));
+
     if (header_info & (1 << 1)) {
       /* The EOF bit is set, so publish the complete frame */
       _uvc_swap_buffers(strmh);
@@ -519,6 +577,7 @@ void LIBUSB_CALL _uvc_stream_callback(struct libusb_transfer *transfer) {
 
         if (pkt->status != 0) {
           UVC_DEBUG("bad packet (isochronous transfer); status: %d", pkt->status);
+          strmh->transfer_errors++;
           continue;
         }
 
@@ -534,6 +593,8 @@ void LIBUSB_CALL _uvc_stream_callback(struct libusb_transfer *transfer) {
   case LIBUSB_TRANSFER_NO_DEVICE: {
     int i;
     UVC_DEBUG("transfer exception, status = %s", libusb_error_name(transfer->status));
+    if (transfer->status != LIBUSB_TRANSFER_CANCELLED)
+      strmh->transfer_errors++;
     pthread_mutex_lock(&strmh->cb_mutex);
 
     /* Mark transfer as deleted. */
@@ -561,6 +622,7 @@ void LIBUSB_CALL _uvc_stream_callback(struct libusb_transfer *transfer) {
   case LIBUSB_TRANSFER_STALL:
   case LIBUSB_TRANSFER_OVERFLOW:
     UVC_DEBUG("retrying transfer, status = %d", transfer->status);
+    strmh->transfer_errors++;
     break;
   }
   
@@ -675,6 +737,7 @@ uvc_error_t uvc_stream_open_ctrl(uvc_device_handle_t *devh, uvc_stream_handle_t
   /** @todo take only what we need */
   strmh->outbuf = malloc( LIBUVC_XFER_BUF_SIZE );
   strmh->holdbuf = malloc( LIBUVC_XFER_BUF_SIZE );
+  strmh->outbuf_size = LIBUVC_XFER_BUF_SIZE;
    
   pthread_mutex_init(&strmh->cb_mutex, NULL);
   pthread_cond_init(&strmh->cb_cond, NULL);
@@ -693,6 +756,72 @@ fail:
   return ret;
 }
 
+/** Assemble frames in buffers supplied by the user rather than in the stream's own.
+ * @ingroup streaming
+ *
+ * Each frame is handed to the callback in the buffer it was assembled in,
+ * rather than copied out of it, and the callback owns that buffer from then on:
+ * it must give frame->data back through release once done with the frame.
+ * Buffers which are not handed to the callback are released by the stream.
+ * Only streams delivering frames to a callback may supply their buffers.
+ *
+ * @param strmh UVC stream, not yet started
+ * @param acquire Supplies a buffer for every frame, or NULL to return to the stream's own buffers
+ * @param release Takes back buffers obtained from acquire
+ * @param user_ptr Passed to acquire and release
+ */
+uvc_error_t uvc_stream_set_frame_buffers(uvc_stream_handle_t *strmh,
+    uvc_frame_buffer_acquire_t *acquire,
+    uvc_frame_buffer_release_t *release,
+    void *user_ptr) {
+  if (strmh->running)
+    return UVC_ERROR_BUSY;
+
+  if (!acquire != !release)
+    return UVC_ERROR_INVALID_PARAM;
+
+  strmh->acquire_buf = acquire;
+  strmh->release_buf = release;
+  strmh->buf_user_ptr = user_ptr;
+
+  return UVC_SUCCESS;
+}
+
+/** Hand the rows of every frame to a callback as they arrive
+ * @ingroup streaming
+ *
+ * The callback is invoked from the thread receiving the transfers with every
+ * rows_per_slice rows of a frame once they have been assembled, and with the
+ * rows left over at the end of the frame, before the frame is handed to the
+ * frame callback. The rows are only valid for the duration of the call, and
+ * frames which turn out to be incomplete may already have been sliced.
+ *
+ * @param strmh UVC stream, not yet started
+ * @param rows_per_slice Rows of each slice
+ * @param row_bytes Bytes of each row of a frame
+ * @param cb Callback taking the slices, or NULL to stop slicing frames
+ * @param user_ptr Passed to cb
+ */
+uvc_error_t uvc_stream_set_slice_callback(uvc_stream_handle_t *strmh,
+    uint32_t rows_per_slice,
+    size_t row_bytes,
+    uvc_frame_slice_callback_t *cb,
+    void *user_ptr) {
+  if (strmh->running)
+    return UVC_ERROR_BUSY;
+
+  if (cb && (!rows_per_slice || !row_bytes))
+    return UVC_ERROR_INVALID_PARAM;
+
+  strmh->slice_cb = cb;
+  strmh->slice_user_ptr = user_ptr;
+  strmh->slice_rows = rows_per_slice;
+  strmh->slice_row_bytes = row_bytes;
+  strmh->slice_next_row = 0;
+
+  return UVC_SUCCESS;
+}
+
 /** Begin streaming video from the stream into the callback function.
  * @ingroup streaming
  *
@@ -730,8 +859,31 @@ uvc_error_t uvc_stream_start(
     return UVC_ERROR_BUSY;
   }
 
+  if (strmh->acquire_buf) {
+    if (!cb) {
+      UVC_EXIT(UVC_ERROR_INVALID_PARAM);
+      return UVC_ERROR_INVALID_PARAM;
+    }
+
+    /* the stream's own buffers are not needed while the user supplies them */
+    free(strmh->outbuf);
+    free(strmh->holdbuf);
+    strmh->holdbuf = NULL;
+    strmh->outbuf_size = ctrl->dwMaxVideoFrameSize;
+    strmh->outbuf = strmh->acquire_buf(strmh->outbuf_size, strmh->buf_user_ptr);
+    if (!strmh->outbuf) {
+      UVC_EXIT(UVC_ERROR_NO_MEM);
+      return UVC_ERROR_NO_MEM;
+    }
+  } else if (!strmh->outbuf) {
+    strmh->outbuf = malloc( LIBUVC_XFER_BUF_SIZE );
+    strmh->holdbuf = malloc( LIBUVC_XFER_BUF_SIZE );
+    strmh->outbuf_size = LIBUVC_XFER_BUF_SIZE;
+  }
+
   strmh->running = 1;
   strmh->seq = 0;
+  strmh->got_bytes = 0;
   strmh->fid = 0;
   strmh->pts = 0;
   strmh->last_scr = 0;
@@ -883,6 +1035,10 @@ uvc_error_t uvc_stream_start(
   return ret;
 fail:
   strmh->running = 0;
+  if (strmh->acquire_buf) {
+    strmh->release_buf(strmh->outbuf, strmh->buf_user_ptr);
+    strmh->outbuf = NULL;
+  }
   UVC_EXIT(ret);
   return ret;
 }
@@ -910,11 +1066,22 @@ void *_uvc_user_caller(void *arg) {
     }
     
     last_seq = strmh->hold_seq;
+    if (strmh->acquire_buf && !strmh->holdbuf) {
+      /* the frame's buffer went to assembling a newer one before we got to it */
+      pthread_mutex_unlock(&strmh->cb_mutex);
+      continue;
+    }
     _uvc_populate_frame(strmh);
     
     pthread_mutex_unlock(&strmh->cb_mutex);
     
     strmh->user_cb(&strmh->frame, strmh->user_ptr);
+
+    if (strmh->acquire_buf) {
+      /* the buffer belongs to the callback now */
+      strmh->frame.data = NULL;
+      strmh->frame.data_bytes = 0;
+    }
   } while(1);
 
   return NULL; // return value ignored
@@ -957,7 +1124,19 @@ void _uvc_populate_frame(uvc_stream_handle_t *strmh) {
   }
 #pragma GCC diagnostic pop
   
+  if (strmh->acquire_buf) {
+    /* hand the hold buffer itself over to the frame */
+    if (frame->library_owns_data)
+      free(frame->data);
+    frame->data = strmh->holdbuf;
+    frame->data_bytes = strmh->hold_bytes;
+    frame->library_owns_data = 0;
+    strmh->holdbuf = NULL;
+    return;
+  }
+
   /* copy the image data from the hold buffer to the frame (unnecessary extra buf?) */
+  frame->library_owns_data = 1;
   if (frame->data_bytes < strmh->hold_bytes) {
     frame->data = realloc(frame->data, strmh->hold_bytes);
     frame->data_bytes = strmh->hold_bytes;
@@ -988,6 +1167,9 @@ uvc_error_t uvc_stream_get_frame(uvc_stream_handle_t *strmh,
   if (strmh->user_cb)
     return UVC_ERROR_CALLBACK_EXISTS;
 
+  if (strmh->acquire_buf)
+    return UVC_ERROR_NOT_SUPPORTED;
+
   pthread_mutex_lock(&strmh->cb_mutex);
 
   if (strmh->last_polled_seq < strmh->hold_seq) {
@@ -1124,6 +1306,16 @@ uvc_error_t uvc_stream_stop(uvc_stream_handle_t *strmh) {
         pthread_join(strmh->cb_thread, NULL);
     }
     
+    if (strmh->acquire_buf) {
+        /* give back the buffers no callback took over */
+        if (strmh->outbuf)
+            strmh->release_buf(strmh->outbuf, strmh->buf_user_ptr);
+        if (strmh->holdbuf)
+            strmh->release_buf(strmh->holdbuf, strmh->buf_user_ptr);
+        strmh->outbuf = NULL;
+        strmh->holdbuf = NULL;
+    }
+    
     return ret;
 }
 
@@ -4,11 +4,65 @@
 #include <iostream>
 #include <algorithm>
 #include <ctime>
+#include <thread>
 
 namespace rsimpl {
+    std::atomic<int> minimum_log_severity(RS_LOG_SEVERITY_NONE);
+
+    // The messages logged by one thread while logging asynchronously, which only that thread pushes and only the writer thread pops
+    class log_queue
+    {
+        struct entry
+        {
+            rs_log_severity severity;
+            std::time_t time;
+            std::string message;
+        };
+        std::vector<entry> entries;
+        std::atomic<size_t> head, tail; // Entries ever popped and pushed
+    public:
+        const int generation;           // The start of asynchronous logging which the queue was made for
+        std::atomic<bool> pushing;      // Set while the thread pushes, so that stopping asynchronous logging can wait for it
+        std::atomic<bool> abandoned;    // Set once the thread ends, so that the writer forgets the queue once it is empty
+
+        log_queue(size_t capacity, int generation) : entries(capacity), head(0), tail(0), generation(generation), pushing(false), abandoned(false) {}
+
+        bool push(rs_log_severity severity, std::time_t time, std::string message)
+        {
+            auto t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) == entries.size()) return false;
+            auto & e = entries[t % entries.size()];
+            e.severity = severity;
+            e.time = time;
+            e.message = std::move(message);
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        template<class F> void pop_all(F write)
+        {
+            auto h = head.load(std::memory_order_relaxed), t = tail.load(std::memory_order_acquire);
+            for (; h != t; ++h)
+            {
+                auto & e = entries[h % entries.size()];
+                write(e.severity, e.time, e.message);
+                e.message.clear();
+                head.store(h + 1, std::memory_order_release);
+            }
+        }
+
+        bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+    };
+
+    // Hands the queue of a thread back to the writer when the thread ends
+    struct thread_log_queue
+    {
+        std::shared_ptr<log_queue> queue;
+        ~thread_log_queue() { if (queue) queue->abandoned = true; }
+    };
+
     class logger_type {
     private:
-        rs_log_severity minimum_log_severity = RS_LOG_SEVERITY_NONE;
         rs_log_severity minimum_console_severity = RS_LOG_SEVERITY_NONE;
         rs_log_severity minimum_file_severity = RS_LOG_SEVERITY_NONE;
         rs_log_severity minimum_callback_severity = RS_LOG_SEVERITY_NONE;
@@ -17,38 +71,28 @@ namespace rsimpl {
         std::ofstream log_file;
         log_callback_ptr callback;
 
-    public:
-        logger_type() : callback(nullptr, [](rs_log_callback * /*c*/) {}) {}
-
-        rs_log_severity get_minimum_severity() { return minimum_log_severity; }
-
-        void log_to_console(rs_log_severity min_severity)
-        {
-            minimum_console_severity = min_severity;
-            minimum_log_severity = std::min(minimum_console_severity, minimum_log_severity);
-        }
-
-        void log_to_file(rs_log_severity min_severity, const char * file_path)
-        {
-            minimum_file_severity = min_severity;
-            log_file.open(file_path, std::ostream::out | std::ostream::app);
-            minimum_log_severity = std::min(minimum_file_severity, minimum_log_severity);
-        }
+        // While logging asynchronously, threads push their messages to queues of their own, which a writer thread drains every few milliseconds
+        std::mutex control_mutex;                       // Held while asynchronous logging starts or stops
+        std::mutex async_mutex;                         // Guards the members below, except for the atomics
+        std::atomic<bool> async;
+        std::atomic<int> generation;                    // Changes every time asynchronous logging starts, so that threads take new queues
+        std::atomic<unsigned long long> dropped;
+        size_t queue_size = 0;
+        std::vector<std::shared_ptr<log_queue>> queues;
+        std::thread writer;
+        std::condition_variable writer_cv;
+        bool stopping = false;
 
-        void log_to_callback(rs_log_severity min_severity, log_callback_ptr callback)
+        void update_minimum_severity()
         {
-            minimum_callback_severity = min_severity;
-            this->callback = std::move(callback);
-            minimum_log_severity = std::min(minimum_callback_severity, minimum_log_severity);
+            minimum_log_severity.store(std::min(std::min(minimum_console_severity, minimum_file_severity), minimum_callback_severity));
         }
 
-        void log(rs_log_severity severity, const std::string & message)
+        void write(rs_log_severity severity, std::time_t t, const std::string & message)
         {
             std::lock_guard<std::mutex> lock(log_mutex);
 
-            if (static_cast<int>(severity) < minimum_log_severity) return;
-
-            std::time_t t = std::time(nullptr); char buffer[20] = {}; const tm* time = std::localtime(&t);
+            char buffer[20] = {}; const tm* time = std::localtime(&t);
             if (nullptr != time)
                 std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", time);
 
@@ -83,16 +127,135 @@ namespace rsimpl {
                 callback->on_event(severity, message.c_str());
             }
         }
+
+        // Writes the messages queued so far, forgetting the queues of the threads which ended
+        void drain()
+        {
+            std::vector<std::shared_ptr<log_queue>> pending;
+            {
+                std::lock_guard<std::mutex> lock(async_mutex);
+                queues.erase(std::remove_if(begin(queues), end(queues), [](const std::shared_ptr<log_queue> & q) { return q->abandoned && q->empty(); }), end(queues));
+                pending = queues;
+            }
+            for (auto & q : pending) q->pop_all([this](rs_log_severity severity, std::time_t time, const std::string & message) { write(severity, time, message); });
+        }
+
+        void run_writer()
+        {
+            while (true)
+            {
+                bool stop;
+                {
+                    std::unique_lock<std::mutex> lock(async_mutex);
+                    writer_cv.wait_for(lock, std::chrono::milliseconds(10), [this]() { return stopping; });
+                    stop = stopping;
+                }
+                drain();
+                if (stop) return;
+            }
+        }
+
+        std::shared_ptr<log_queue> get_thread_queue()
+        {
+            static thread_local thread_log_queue local;
+            const int current = generation.load();
+            if (!local.queue || local.queue->generation != current)
+            {
+                std::lock_guard<std::mutex> lock(async_mutex);
+                if (local.queue) local.queue->abandoned = true;
+                local.queue = std::make_shared<log_queue>(std::max<size_t>(queue_size, 1), current);
+                queues.push_back(local.queue);
+            }
+            return local.queue;
+        }
+
+    public:
+        logger_type() : callback(nullptr, [](rs_log_callback * /*c*/) {}), async(false), generation(0), dropped(0) {}
+        ~logger_type() { log_asynchronously(0); }
+
+        void log_to_console(rs_log_severity min_severity)
+        {
+            std::lock_guard<std::mutex> lock(log_mutex);
+            minimum_console_severity = min_severity;
+            update_minimum_severity();
+        }
+
+        void log_to_file(rs_log_severity min_severity, const char * file_path)
+        {
+            std::lock_guard<std::mutex> lock(log_mutex);
+            minimum_file_severity = min_severity;
+            log_file.open(file_path, std::ostream::out | std::ostream::app);
+            update_minimum_severity();
+        }
+
+        void log_to_callback(rs_log_severity min_severity, log_callback_ptr callback)
+        {
+            std::lock_guard<std::mutex> lock(log_mutex);
+            minimum_callback_severity = min_severity;
+            this->callback = std::move(callback);
+            update_minimum_severity();
+        }
+
+        void log_asynchronously(int queue_size)
+        {
+            std::lock_guard<std::mutex> control_lock(control_mutex);
+
+            // Stop the writer once no thread is pushing any more, writing what it was handed
+            async = false;
+            std::vector<std::shared_ptr<log_queue>> current;
+            {
+                std::lock_guard<std::mutex> lock(async_mutex);
+                current = queues;
+            }
+            for (auto & q : current) while (q->pushing) std::this_thread::yield();
+            if (writer.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(async_mutex);
+                    stopping = true;
+                }
+                writer_cv.notify_one();
+                writer.join();
+            }
+            drain();
+
+            std::lock_guard<std::mutex> lock(async_mutex);
+            queues.clear();
+            stopping = false;
+            if (queue_size <= 0) return;
+            this->queue_size = queue_size;
+            ++generation;
+            writer = std::thread([this]() { run_writer(); });
+            async = true;
+        }
+
+        unsigned long long get_dropped_messages() const { return dropped; }
+
+        void log(rs_log_severity severity, const std::string & message)
+        {
+            if (!is_logged(severity)) return;
+            const auto time = std::time(nullptr);
+
+            if (async.load(std::memory_order_relaxed))
+            {
+                auto queue = get_thread_queue();
+                queue->pushing = true;
+                // Queues of an earlier start of asynchronous logging are no longer drained
+                if (async && queue->generation == generation)
+                {
+                    if (!queue->push(severity, time, message)) ++dropped;
+                    queue->pushing = false;
+                    return;
+                }
+                queue->pushing = false;
+            }
+            write(severity, time, message);
+        }
     };
 
     static logger_type logger;
 }
 
-rs_log_severity rsimpl::get_minimum_severity(void)
-{
-    return logger.get_minimum_severity();
-}
-
 void rsimpl::log(rs_log_severity severity, const std::string & message)
 {
     logger.log(severity, message);
@@ -118,3 +281,13 @@ void rsimpl::log_to_callback(rs_log_severity min_severity,
 {
     logger.log_to_callback(min_severity, log_callback_ptr(new log_callback(on_log, user), [](rs_log_callback* c) { delete c; }));
 }
+
+void rsimpl::log_asynchronously(int queue_size)
+{
+    logger.log_asynchronously(queue_size);
+}
+
+unsigned long long rsimpl::get_dropped_log_messages()
+{
+    return logger.get_dropped_messages();
+}
@@ -0,0 +1,97 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_METRICS_H
+#define LIBREALSENSE_METRICS_H
+
+#include "types.h"
+
+#include <atomic>
+#include <vector>
+
+namespace rsimpl
+{
+    // The rs_stream_metric counters of every native stream. Capture threads, the application and frame callback threads each update those
+    // of the frames they handle, and anyone reads them, none ever locking.
+    class stream_metrics
+    {
+        std::atomic<unsigned long long> values[RS_STREAM_NATIVE_COUNT][RS_STREAM_METRIC_COUNT];
+    public:
+        stream_metrics() { for (auto & stream : values) for (auto & v : stream) v.store(0, std::memory_order_relaxed); }
+
+        void add(rs_stream stream, rs_stream_metric metric, unsigned long long amount = 1) { if (stream >= 0 && stream < RS_STREAM_NATIVE_COUNT) values[stream][metric].fetch_add(amount, std::memory_order_relaxed); }
+        void subtract(rs_stream stream, rs_stream_metric metric, unsigned long long amount = 1) { if (stream >= 0 && stream < RS_STREAM_NATIVE_COUNT) values[stream][metric].fetch_sub(amount, std::memory_order_relaxed); }
+        void clear(rs_stream stream, rs_stream_metric metric) { values[stream][metric].store(0, std::memory_order_relaxed); }
+        unsigned long long get(rs_stream stream, rs_stream_metric metric) const { return values[stream][metric].load(std::memory_order_relaxed); }
+
+        static unsigned long long to_nanoseconds(double milliseconds) { return milliseconds > 0 ? static_cast<unsigned long long>(milliseconds * 1e6) : 0; }
+    };
+
+    // Bytes of frame memory a device holds, as the allocator of its archives counts them on every allocation and deallocation, and the budget
+    // beyond which the archives keep fewer frames. Counted by the capture, worker and application threads releasing frames, none ever locking.
+    class memory_account
+    {
+        std::atomic<unsigned long long> current, peak, budget;
+    public:
+        memory_account() : current(0), peak(0), budget(0) {}
+
+        void allocated(size_t bytes)
+        {
+            const auto now = current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            raise_peak(now);
+        }
+        void deallocated(size_t bytes) { current.fetch_sub(bytes, std::memory_order_relaxed); }
+        void raise_peak(unsigned long long bytes)
+        {
+            auto p = peak.load(std::memory_order_relaxed);
+            while (p < bytes && !peak.compare_exchange_weak(p, bytes, std::memory_order_relaxed)) {}
+        }
+        unsigned long long get_current() const { return current.load(std::memory_order_relaxed); }
+        unsigned long long get_peak() const { return peak.load(std::memory_order_relaxed); }
+
+        void set_budget(unsigned long long bytes) { budget.store(bytes, std::memory_order_relaxed); } // 0 for no budget
+        unsigned long long get_budget() const { return budget.load(std::memory_order_relaxed); }
+        bool is_over_budget() const { const auto b = get_budget(); return b && get_current() > b; }
+    };
+
+    // Picks the rs_load_shedding_action a device takes from the overload checks it makes while streaming: every check finding an overload takes
+    // the next action of the order on top of those taken, and every calm_checks_to_relax checks in a row finding none drops the last one taken.
+    // A single thread makes the checks, while the capture and precomputing threads ask which actions are taken, none ever locking.
+    class load_shedder
+    {
+        std::vector<rs_load_shedding_action> order;     // Only changed while no check is made
+        std::atomic<int> level, actions;                // actions is the bit mask of the first level actions of the order
+        int calm_checks;
+    public:
+        static const int calm_checks_to_relax = 10;
+
+        load_shedder() : level(0), actions(0), calm_checks(0) {}
+
+        void set_order(const std::vector<rs_load_shedding_action> & actions) { order = actions; reset(); }
+        const std::vector<rs_load_shedding_action> & get_order() const { return order; }
+        void reset() { level = 0; actions = 0; calm_checks = 0; }
+        void update(bool overloaded)
+        {
+            int l = level;
+            if (overloaded)
+            {
+                calm_checks = 0;
+                if (l < (int)order.size()) ++l;
+            }
+            else if (l && ++calm_checks >= calm_checks_to_relax)
+            {
+                calm_checks = 0;
+                --l;
+            }
+            int mask = 0;
+            for (int i = 0; i < l; ++i) mask |= 1 << order[i];
+            actions = mask;
+            level = l;
+        }
+        int get_level() const { return level; }
+        bool is_taking(rs_load_shedding_action action) const { return (actions.load(std::memory_order_relaxed) & (1 << action)) != 0; }
+    };
+}
+
+#endif
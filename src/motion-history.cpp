@@ -0,0 +1,82 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "motion-history.h"
+
+using namespace rsimpl;
+
+// Readers leave the oldest samples of a ring out of their snapshot, so that the writer can keep pushing while they read
+const unsigned long long motion_history_slack = RS_MOTION_HISTORY_SIZE / 8;
+
+template<class F> auto motion_history::read(rs_event_source source, F read) const -> decltype(read(nullptr, 0ull, 0ull))
+{
+    auto & r = rings[source];
+    while (true)
+    {
+        auto end = r.published.load(std::memory_order_acquire);
+        auto begin = end > RS_MOTION_HISTORY_SIZE - motion_history_slack ? end - (RS_MOTION_HISTORY_SIZE - motion_history_slack) : 0;
+        auto result = read(r.samples, begin, end);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (r.begun.load(std::memory_order_relaxed) <= begin + RS_MOTION_HISTORY_SIZE) return result;
+    }
+}
+
+// Index of the first sample in [begin, end) whose timestamp is not below timestamp, or above it if inclusive, end if there is none
+static unsigned long long bisect(const rs_motion_data samples[], unsigned long long begin, unsigned long long end, double timestamp, bool inclusive)
+{
+    while (begin < end)
+    {
+        auto mid = begin + (end - begin) / 2;
+        auto t = samples[mid % RS_MOTION_HISTORY_SIZE].timestamp_data.timestamp;
+        if (t < timestamp || (inclusive && t == timestamp)) begin = mid + 1;
+        else end = mid;
+    }
+    return begin;
+}
+
+void motion_history::push(const rs_motion_data & sample)
+{
+    if (sample.timestamp_data.source_id != RS_EVENT_IMU_ACCEL && sample.timestamp_data.source_id != RS_EVENT_IMU_GYRO) return;
+    auto & r = rings[sample.timestamp_data.source_id];
+
+    auto n = r.published.load(std::memory_order_relaxed);
+    r.begun.store(n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    r.samples[n % RS_MOTION_HISTORY_SIZE] = sample;
+    r.published.store(n + 1, std::memory_order_release);
+}
+
+bool motion_history::get_sample_at(rs_event_source source, double timestamp, rs_motion_data & sample) const
+{
+    return read(source, [timestamp, &sample](const rs_motion_data samples[], unsigned long long begin, unsigned long long end)
+    {
+        auto i = bisect(samples, begin, end, timestamp, false);
+        if (i == end) return false;
+        auto & after = samples[i % RS_MOTION_HISTORY_SIZE];
+        if (after.timestamp_data.timestamp == timestamp)
+        {
+            sample = after;
+            return true;
+        }
+        if (i == begin) return false;
+        auto & before = samples[(i - 1) % RS_MOTION_HISTORY_SIZE];
+
+        auto t = (float)((timestamp - before.timestamp_data.timestamp) / (after.timestamp_data.timestamp - before.timestamp_data.timestamp));
+        sample = t < 0.5f ? before : after;
+        sample.timestamp_data.timestamp = timestamp;
+        sample.is_valid = before.is_valid && after.is_valid;
+        for (int j = 0; j < 3; ++j) sample.axes[j] = before.axes[j] + (after.axes[j] - before.axes[j]) * t;
+        return true;
+    });
+}
+
+size_t motion_history::get_samples(rs_event_source source, double from, double to, rs_motion_data samples[], size_t max_count) const
+{
+    return read(source, [from, to, samples, max_count](const rs_motion_data history[], unsigned long long begin, unsigned long long end)
+    {
+        auto first = bisect(history, begin, end, from, false);
+        auto last = bisect(history, first, end, to, true);
+        for (auto i = first; i < last && i - first < max_count; ++i) samples[i - first] = history[i % RS_MOTION_HISTORY_SIZE];
+        return (size_t)(last - first);
+    });
+}
@@ -0,0 +1,44 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_MOTION_HISTORY_H
+#define LIBREALSENSE_MOTION_HISTORY_H
+
+#include "types.h"
+
+namespace rsimpl
+{
+    // Keeps the latest motion samples of the accelerometer and of the gyroscope, each in a ring of its own ordered by timestamp, for queries at the
+    // timestamps of frames. Samples are pushed by a single thread, the motion data channel, and read by any thread without taking a lock: readers
+    // binary search the published part of a ring, then check that the writer did not overwrite what they read in the meantime, retrying if it did.
+    class motion_history
+    {
+        struct ring
+        {
+            rs_motion_data samples[RS_MOTION_HISTORY_SIZE];
+            std::atomic<unsigned long long> begun;      // Samples pushed so far, counting the one being written
+            std::atomic<unsigned long long> published;  // Samples pushed so far, fully written
+            ring() : begun(0), published(0) {}
+        };
+        ring rings[2]; // Indexed by RS_EVENT_IMU_ACCEL and RS_EVENT_IMU_GYRO
+
+        motion_history(const motion_history &) = delete;
+        motion_history & operator=(const motion_history &) = delete;
+
+        // Calls read(samples, begin, end) over a consistent snapshot of the ring of source, indices counting every sample ever pushed
+        template<class F> auto read(rs_event_source source, F read) const -> decltype(read(nullptr, 0ull, 0ull));
+    public:
+        motion_history() {}
+
+        void push(const rs_motion_data & sample); // Samples of other sources are ignored, those of a source must come in timestamp order
+
+        // Linearly interpolates the sample of source at timestamp, returning false if timestamp is not between two samples of the history
+        bool get_sample_at(rs_event_source source, double timestamp, rs_motion_data & sample) const;
+
+        // Copies up to max_count samples of source with timestamps in [from, to], oldest first, returning how many of them the history holds
+        size_t get_samples(rs_event_source source, double from, double to, rs_motion_data samples[], size_t max_count) const;
+    };
+}
+
+#endif
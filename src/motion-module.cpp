@@ -152,23 +152,6 @@ void motion_module_control::toggle_motion_module_events(bool on)
 }
 
 
-// Write a buffer to the IAP I2C register.
-void motion_module_control::i2c_iap_write(uint16_t slave_address, uint8_t *buffer, uint16_t len)
-{
-    hw_monitor::hwmon_cmd cmd((int)adaptor_board_command::IAP_IWB);
-
-    cmd.Param1 = slave_address;
-    cmd.Param2 = len;
-
-    cmd.sizeOfSendCommandData = len;
-    memcpy(cmd.data, buffer, len);
-
-    perform_and_send_monitor_command(*device_handle, usbMutex, cmd);
-}
-
-// Write a 32 bit value to a specific i2c slave address.
-
-
 // switch the mtion module to IAP mode.
 void motion_module_control::switch_to_iap()
 {
@@ -209,56 +192,47 @@ void motion_module_control::switch_to_operational()
         throw std::runtime_error("Unable to leave IAP state!");
 }
 
-// Write the firmware.
-void motion_module_control::write_firmware(uint8_t *data, int size)
+std::vector<hw_monitor::hwmon_cmd> motion_module::make_firmware_write_commands(uint16_t slave_address, const uint8_t * data, int size)
 {
-    int32_t length = size;
+    std::vector<hw_monitor::hwmon_cmd> commands;
     uint32_t image_address = 0x8002000;
-    fw_image_packet packet;
-    uint8_t *data_buffer = data;
-
-    // we considered to be in a IAP state here. we loop through the data and send it in packets of 128 bytes.
-    while(length > 0)
+    for (int offset = 0; offset < size; offset += FW_IMAGE_PACKET_PAYLOAD_LEN)
     {
-        uint16_t payload_length = (length > FW_IMAGE_PACKET_PAYLOAD_LEN) ? FW_IMAGE_PACKET_PAYLOAD_LEN : length;
-        uint32_t image_address_be;
-        uint16_t payload_be;
-
-        // TODO SERGEY : The firmware needs the image address and payload length as big endian. do we have any 
-        // little to big endian functions in this code ? we should detect that the machine is little endian and only 
-        // then do something.
-        image_address_be =  (image_address >> 24)  & 0xFF;
-        image_address_be |= (image_address >> 8)   & 0xFF00;
-        image_address_be |= (image_address <<  8)  & 0xFF0000;
-        image_address_be |= (image_address <<  24) & 0xFF000000;
-
-        payload_be = (payload_length >> 8) & 0xFF;
-        payload_be |= (payload_length << 8) & 0xFF00;
-
-        // packet require op_code of 0x6. can't find documentation for that.
-        packet.address = image_address_be;
+        const uint16_t payload_length = static_cast<uint16_t>(std::min(size - offset, FW_IMAGE_PACKET_PAYLOAD_LEN));
+
+        // The firmware needs the image address and payload length as big endian. Packets require the op_code of 0x6.
+        fw_image_packet packet;
         packet.op_code = 0x6;
-        packet.length = payload_be;
+        packet.address = pack(image_address & 0xFF, (image_address >> 8) & 0xFF, (image_address >> 16) & 0xFF, image_address >> 24);
+        packet.length = static_cast<uint16_t>((payload_length >> 8) | (payload_length << 8));
         packet.dummy = 0;
-
-        // calcuate packet Length which includes the packet size and payload.
-        uint16_t packetLength = (sizeof(packet) - FW_IMAGE_PACKET_PAYLOAD_LEN + payload_length);
-
-        // copy data to packet.
-        memcpy(packet.data, data_buffer, payload_length);
-
-        // write to IAP.
-        i2c_iap_write(MOTION_MODULE_CONTROL_I2C_SLAVE_ADDRESS, (uint8_t *)&packet, packetLength);
-
-        // go to next packet if needed.
-        data_buffer += payload_length;
-        length -= payload_length;
+        memcpy(packet.data, data + offset, payload_length);
+
+        // Written to the IAP I2C register, the packet only as long as its payload
+        commands.emplace_back((int)adaptor_board_command::IAP_IWB);
+        auto & cmd = commands.back();
+        const uint16_t packet_length = static_cast<uint16_t>(sizeof(packet) - FW_IMAGE_PACKET_PAYLOAD_LEN + payload_length);
+        cmd.Param1 = slave_address;
+        cmd.Param2 = packet_length;
+        cmd.sizeOfSendCommandData = packet_length;
+        memcpy(cmd.data, &packet, packet_length);
         image_address += payload_length;
-    };
+    }
+    return commands;
+}
+
+// Write the firmware. We are considered to be in IAP state here, and the packets are written back to back under a single hold of the monitor.
+void motion_module_control::write_firmware(const uint8_t *data, int size, const blob_progress & on_progress)
+{
+    auto commands = make_firmware_write_commands(MOTION_MODULE_CONTROL_I2C_SLAVE_ADDRESS, data, size);
+    hw_monitor::perform_monitor_commands(*device_handle, usbMutex, commands.data(), commands.size(), [&](size_t performed)
+    {
+        if (on_progress) on_progress(std::min(size, static_cast<int>(performed) * FW_IMAGE_PACKET_PAYLOAD_LEN), size);
+    });
 }
 
 // This function responsible for the whole firmware upgrade process.
-void motion_module_control::firmware_upgrade(void *data, int size)
+void motion_module_control::firmware_upgrade(void *data, int size, const blob_progress & on_progress)
 {
     set_control(mm_events_output, false);
     // power on motion mmodule (if needed).
@@ -268,7 +242,7 @@ void motion_module_control::firmware_upgrade(void *data, int size)
     switch_to_iap();
 
     //write the firmware.
-    write_firmware((uint8_t *)data, size);
+    write_firmware((const uint8_t *)data, size, on_progress);
 
     // write to operational mode.
     switch_to_operational();
@@ -280,7 +254,7 @@ void motion_module::config(uvc::device&, uint8_t, uint8_t, uint8_t, uint8_t, uin
 }
 
 
-std::vector<motion_event> motion_module_parser::operator() (const unsigned char* data, const int& data_size)
+const std::vector<motion_event> & motion_module_parser::operator() (const unsigned char* data, const int& data_size)
 {
     /* All sizes are in bytes*/
     const unsigned short motion_packet_header_size  = 8;
@@ -292,51 +266,73 @@ std::vector<motion_event> motion_module_parser::operator() (const unsigned char*
     const unsigned short motion_packet_size         = non_imu_data_offset + (non_imu_data_entries * non_imu_entry_size);
     unsigned short packets = data_size / motion_packet_size;
 
-    std::vector<motion_event> v;
+    // Reserving every packet up front keeps the entries in place while their pointers wait for the wraparound correction
+    events.clear();
+    events.reserve(packets);
 
-    if (packets)
+    for (unsigned short i = 0; i < packets; i++)
     {
-        unsigned char *cur_packet = nullptr;
+        auto cur_packet = data + (i*motion_packet_size);
 
-        for (uint8_t i = 0; i < packets; i++)
+        // extract packet header
+        unsigned short header[4];
+        memcpy(header, cur_packet, sizeof(header));
+        std::bitset<16> error_state(header[0]);
+
+        if (error_state.any())
         {
-            motion_event event_data = {};
-
-            cur_packet = (unsigned char*)data + (i*motion_packet_size);
-
-            // extract packet header
-            memcpy(&event_data.error_state, &cur_packet[0], sizeof(unsigned short));
-            memcpy(&event_data.status, &cur_packet[2], sizeof(unsigned short));
-            memcpy(&event_data.imu_entries_num, &cur_packet[4], sizeof(unsigned short));
-            memcpy(&event_data.non_imu_entries_num, &cur_packet[6], sizeof(unsigned short));
-
-            if (event_data.error_state.any())
-            {
-                LOG_WARNING("Motion Event: packet-level error detected " << event_data.error_state.to_string() << " packet will be dropped");
-                break;
-            }
-
-            // Validate header input
-            if ((event_data.imu_entries_num <= imu_data_entries) && (event_data.non_imu_entries_num <= non_imu_data_entries))
-            {
-                // Parse IMU entries
-                for (uint8_t j = 0; j < event_data.imu_entries_num; j++)
-                {
-                    event_data.imu_packets[j] = parse_motion(&cur_packet[motion_packet_header_size + j*imu_entry_size]);
-                }
-
-                // Parse non-IMU entries
-                for (uint8_t j = 0; j < event_data.non_imu_entries_num; j++)
-                {
-                    parse_timestamp(&cur_packet[non_imu_data_offset + j*non_imu_entry_size], event_data.non_imu_packets[j]);
-                }
-
-                v.push_back(std::move(event_data));
-            }
+            LOG_WARNING("Motion Event: packet-level error detected " << error_state.to_string() << " packet will be dropped");
+            break;
         }
+
+        // Validate header input
+        if ((header[2] > imu_data_entries) || (header[3] > non_imu_data_entries)) continue;
+
+        events.emplace_back();
+        auto & event_data = events.back();
+        event_data.error_state = error_state;
+        memcpy(&event_data.status, &header[1], sizeof(unsigned short));
+        event_data.imu_entries_num = header[2];
+        event_data.non_imu_entries_num = header[3];
+
+        // Parse IMU entries
+        for (unsigned short j = 0; j < event_data.imu_entries_num; j++)
+            parse_motion(&cur_packet[motion_packet_header_size + j*imu_entry_size], event_data.imu_packets[j]);
+
+        // Parse non-IMU entries
+        for (unsigned short j = 0; j < event_data.non_imu_entries_num; j++)
+            parse_timestamp(&cur_packet[non_imu_data_offset + j*non_imu_entry_size], event_data.non_imu_packets[j]);
     }
 
-    return v;
+    fix_wraparounds();
+    return events;
+}
+
+void motion_module_parser::fix_wraparounds()
+{
+    for (int source = 0; source < RS_EVENT_SOURCE_COUNT; ++source)
+    {
+        auto & entries = pending[source];
+        if (entries.empty()) continue;
+
+        frame_numbers.resize(entries.size());
+        timestamps.resize(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            frame_numbers[i] = entries[i]->frame_number;
+            timestamps[i] = (unsigned long long)entries[i]->timestamp;
+        }
+
+        mm_data_wraparound[source].frame_counter_wraparound.fix(frame_numbers.data(), frame_numbers.size());
+        mm_data_wraparound[source].timestamp_wraparound.fix(timestamps.data(), timestamps.size());
+
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            entries[i]->frame_number = frame_numbers[i];
+            entries[i]->timestamp = timestamps[i] * IMU_UNITS_TO_MSEC; // Convert ticks to ms
+        }
+        entries.clear();
+    }
 }
 
 void motion_module_parser::parse_timestamp(const unsigned char * data, rs_timestamp_data &entry)
@@ -345,13 +341,17 @@ void motion_module_parser::parse_timestamp(const unsigned char * data, rs_timest
     unsigned short  tmp = (data[1] << 8) | (data[0]);
 
     entry.source_id = rs_event_source((tmp & 0x7) - 1);         // bits [0:2] - source_id
-    entry.frame_number = mm_data_wraparound[entry.source_id].frame_counter_wraparound.fix((tmp & 0x7fff) >> 3); // bits [3-14] - frame num
+    entry.frame_number = (tmp & 0x7fff) >> 3;                   // bits [3-14] - frame num
     unsigned int timestamp;
-    memcpy(&timestamp, &data[2], sizeof(unsigned int));   // bits [16:47] - timestamp
-    entry.timestamp = mm_data_wraparound[entry.source_id].timestamp_wraparound.fix(timestamp) * IMU_UNITS_TO_MSEC; // Convert ticks to ms
+    memcpy(&timestamp, &data[2], sizeof(unsigned int));         // bits [16:47] - timestamp, in ticks until the wraparound correction
+    entry.timestamp = timestamp;
+
+    // Entries of no known source have no wraparound state to correct them by, and keep their raw values
+    if ((unsigned)entry.source_id < RS_EVENT_SOURCE_COUNT)
+        pending[entry.source_id].push_back(&entry);
 }
 
-rs_motion_data motion_module_parser::parse_motion(const unsigned char * data)
+void motion_module_parser::parse_motion(const unsigned char * data, rs_motion_data & entry)
 {
     // predefined motion devices parameters
     const static float gravity      = 9.80665f;                 // Standard Gravitation Acceleration
@@ -361,9 +361,11 @@ rs_motion_data motion_module_parser::parse_motion(const unsigned char * data)
     const static float accel_range = 4.f;                       // Accelerometer is preset to [-4...+4]g range
     const static float accelerator_transform_factor = float(gravity * accel_range / 2048.f);
 
-    rs_motion_data entry;
+    // Indexed by the raw source bits, so that converting the axes takes no branch on the source: acceleration data is stored in 12 MSB
+    const static unsigned data_shifts[8] = { 0, 4, 0, 0, 0, 0, 0, 0 };
+    const static float transform_factors[8] = { 1.f, accelerator_transform_factor, gyro_transform_factor, 1.f, 1.f, 1.f, 1.f, 1.f };
 
-    parse_timestamp(data, (rs_timestamp_data&)entry);
+    parse_timestamp(data, entry.timestamp_data);
 
     entry.is_valid = (data[1] >> 7);          // Isolate bit[15]
 
@@ -371,16 +373,7 @@ rs_motion_data motion_module_parser::parse_motion(const unsigned char * data)
     short tmp[3];
     memcpy(&tmp, &data[6], sizeof(short) * 3);
 
-    unsigned data_shift = (RS_EVENT_IMU_ACCEL == entry.timestamp_data.source_id) ? 4 : 0;  // Acceleration data is stored in 12 MSB
-
+    auto raw_source = data[0] & 0x7;
     for (int i = 0; i < 3; i++)                     // convert axis data to physical units, (m/sec^2) or (rad/sec)
-    {
-        entry.axes[i] = float(tmp[i] >> data_shift);
-        if (RS_EVENT_IMU_ACCEL == entry.timestamp_data.source_id) entry.axes[i] *= accelerator_transform_factor;
-        if (RS_EVENT_IMU_GYRO == entry.timestamp_data.source_id) entry.axes[i] *= gyro_transform_factor;
-
-        // TODO check and report invalid conversion requests
-    }
-
-    return entry;
+        entry.axes[i] = float(tmp[i] >> data_shifts[raw_source]) * transform_factors[raw_source];
 }
@@ -9,6 +9,7 @@
 #include <bitset>
 
 #include "device.h"
+#include "hw-monitor.h"
 
 namespace rsimpl
 {
@@ -106,6 +107,9 @@ namespace rsimpl
 
         void config(uvc::device & device, uint8_t gyro_bw, uint8_t gyro_range, uint8_t accel_bw, uint8_t accel_range, uint32_t time_seed);
 
+        // The IAP writes of a firmware image, one packet of at most FW_IMAGE_PACKET_PAYLOAD_LEN bytes each, in the order they are flashed
+        std::vector<hw_monitor::hwmon_cmd> make_firmware_write_commands(uint16_t slave_address, const uint8_t * data, int size);
+
         enum mm_request : uint8_t
         {
             mm_output_undefined = 0,
@@ -155,11 +159,19 @@ namespace rsimpl
                 : mm_data_wraparound(RS_EVENT_SOURCE_COUNT)
             {}
 
-            std::vector<motion_event> operator() (const unsigned char* data, const int& data_size);
+            // Parses the packets of a transfer into a buffer keeping its capacity from one transfer to the next: the events are valid until the next call
+            const std::vector<motion_event> & operator() (const unsigned char* data, const int& data_size);
+            // Decode the raw frame number and timestamp ticks of an entry, queuing it for the wraparound correction of the transfer
             void parse_timestamp(const unsigned char* data, rs_timestamp_data &);
-            rs_motion_data parse_motion(const unsigned char* data);
+            void parse_motion(const unsigned char* data, rs_motion_data &);
 
             std::vector<motion_module_wraparound> mm_data_wraparound;
+        private:
+            void fix_wraparounds();
+
+            std::vector<motion_event> events;
+            std::vector<rs_timestamp_data *> pending[RS_EVENT_SOURCE_COUNT];    // Entries of each source awaiting wraparound correction, in arrival order
+            std::vector<unsigned long long> frame_numbers, timestamps;          // Raw values of one source, corrected as a batch
         };
 
         class motion_module_state
@@ -185,7 +197,7 @@ namespace rsimpl
             void switch_to_iap();
             void switch_to_operational();
 
-            void firmware_upgrade(void *data, int size);
+            void firmware_upgrade(void *data, int size, const blob_progress & on_progress = nullptr);
 
         private:
             motion_module_control(const motion_module_control&);
@@ -195,9 +207,7 @@ namespace rsimpl
             std::timed_mutex& usbMutex;
             bool    power_state;
 
-            void i2c_iap_write(uint16_t slave_address, uint8_t *buffer, uint16_t len);
-
-            void write_firmware(uint8_t *data, int size);
+            void write_firmware(const uint8_t *data, int size, const blob_progress & on_progress);
 
             void impose(mm_request request, bool on);
             void enter_state(mm_state new_state);
@@ -0,0 +1,125 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "multi-sync.h"
+#include "archive.h"
+
+using namespace rsimpl;
+
+const size_t clock_offset_window = 64;  // Framesets over which each device clock offset is estimated
+const size_t max_queued_framesets = 4;  // Per device, before the oldest is a straggler
+
+frameset_matcher::frameset_matcher(int device_count, double tolerance, rs_straggler_policy policy, deliver_function deliver, discard_function discard)
+    : tolerance(tolerance), policy(policy), deliver(deliver), discard(discard), devices(device_count) {}
+
+double frameset_matcher::get_head_time(int device) const
+{
+    return devices[device].framesets.front().timestamp + devices[device].get_clock_offset();
+}
+
+void frameset_matcher::push(int device, void * frameset, double timestamp, long long system_time)
+{
+    auto & d = devices[device];
+    d.clock_offsets.push_back(system_time - timestamp);
+    if (d.clock_offsets.size() > clock_offset_window) d.clock_offsets.pop_front();
+    d.framesets.push_back({ frameset, timestamp });
+    while (match()) {}
+}
+
+// Hands out or discards the oldest queued framesets if they can be decided on, returns false if they have to wait for more framesets
+bool frameset_matcher::match()
+{
+    int oldest = -1;
+    bool complete = true, overflow = false;
+    for (int i = 0; i < (int)devices.size(); ++i)
+    {
+        if (devices[i].framesets.empty()) { complete = false; continue; }
+        if (devices[i].framesets.size() > max_queued_framesets) overflow = true;
+        if (oldest < 0 || get_head_time(i) < get_head_time(oldest)) oldest = i;
+    }
+    if (oldest < 0) return false;
+
+    // Framesets of a device only get newer, so the oldest one has no match left on a device which moved past it
+    const auto latest_match = get_head_time(oldest) + tolerance;
+    bool passed = false;
+    for (int i = 0; i < (int)devices.size(); ++i)
+        if (!devices[i].framesets.empty() && get_head_time(i) > latest_match) passed = true;
+    if (!passed && !complete && !overflow) return false;
+
+    std::vector<void *> set(devices.size(), nullptr);
+    for (int i = 0; i < (int)devices.size(); ++i)
+    {
+        if (devices[i].framesets.empty() || get_head_time(i) > latest_match) continue;
+        set[i] = devices[i].framesets.front().frameset;
+        devices[i].framesets.pop_front();
+    }
+
+    if (complete && !passed) deliver(set.data());
+    else if (policy == RS_STRAGGLER_POLICY_DELIVER_PARTIAL) deliver(set.data());
+    else for (int i = 0; i < (int)set.size(); ++i) if (set[i]) discard(i, set[i]);
+    return true;
+}
+
+void frameset_matcher::flush()
+{
+    for (int i = 0; i < (int)devices.size(); ++i)
+    {
+        for (auto & f : devices[i].framesets) discard(i, f.frameset);
+        devices[i].framesets.clear();
+    }
+}
+
+// Installed on every synchronized device, holds the state alive for as long as the device keeps it
+class multi_device_sync::device_callback : public rs_frameset_callback
+{
+    std::shared_ptr<state> shared;
+    int index;
+public:
+    device_callback(std::shared_ptr<state> shared, int index) : shared(shared), index(index) {}
+
+    void on_frameset(rs_device * device, rs_frameset * frames) override
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        if (!shared->callback)
+        {
+            device->release_frames(frames);
+            return;
+        }
+
+        // Framesets are timed by their first stream, in stream order, with a frame
+        auto & set = ((frame_archive::shared_frameset *)frames)->get_frames();
+        for (int s = 0; s < RS_STREAM_NATIVE_COUNT; ++s)
+        {
+            if (!set.get_frame_data((rs_stream)s)) continue;
+            shared->matcher->push(index, frames, set.get_frame_timestamp((rs_stream)s), set.get_frame_system_time((rs_stream)s));
+            return;
+        }
+        device->release_frames(frames);
+    }
+
+    void release() override { delete this; }
+};
+
+multi_device_sync::multi_device_sync(const std::vector<rs_device *> & devices, double tolerance, rs_straggler_policy policy, rs_multi_frameset_callback * callback)
+    : shared(std::make_shared<state>(devices, callback))
+{
+    for (auto it = devices.begin(); it != devices.end(); ++it)
+    {
+        if (std::find(devices.begin(), it, *it) != it) throw std::runtime_error(to_string() << "device " << (*it)->get_name() << " is passed more than once");
+        if ((*it)->is_capturing()) throw std::runtime_error(to_string() << "device " << (*it)->get_name() << " must be stopped to be synchronized");
+    }
+
+    auto s = shared.get(); // The state owns the matcher
+    s->matcher.reset(new frameset_matcher((int)devices.size(), tolerance, policy,
+        [s](void * const framesets[]) { s->callback->on_framesets(s->devices.data(), (rs_frameset * const *)framesets, (int)s->devices.size()); },
+        [s](int device, void * frameset) { s->devices[device]->release_frames((rs_frameset *)frameset); }));
+
+    for (int i = 0; i < (int)devices.size(); ++i) devices[i]->set_frameset_callback(new device_callback(shared, i));
+}
+
+multi_device_sync::~multi_device_sync()
+{
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    shared->matcher->flush();
+    shared->callback.reset();
+}
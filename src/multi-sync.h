@@ -0,0 +1,78 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_MULTI_SYNC_H
+#define LIBREALSENSE_MULTI_SYNC_H
+
+#include "types.h"
+
+#include <deque>
+
+namespace rsimpl
+{
+    // Matches the framesets of several devices by timestamp. Each device clock is mapped onto the host clock through the smallest gap between
+    // the arrival time of its framesets and their timestamp over a recent window, transport delays only ever lengthening that gap. Framesets
+    // wait in a short queue per device: the oldest queued framesets are handed out together once every device has one within tolerance of the
+    // others, and a frameset is a straggler once another device has moved past it, or once its own queue overflowed waiting for a device.
+    // Not thread safe, the caller serializes access.
+    class frameset_matcher
+    {
+    public:
+        typedef std::function<void(void * const framesets[])> deliver_function; // One frameset per device, null for the devices missing from a partial set
+        typedef std::function<void(int device, void * frameset)> discard_function;
+    private:
+        struct queued_frameset { void * frameset; double timestamp; };
+        struct device_queue
+        {
+            std::deque<queued_frameset> framesets;
+            std::deque<double> clock_offsets;   // Host arrival time minus timestamp of the latest framesets, in ms
+            double get_clock_offset() const { return *std::min_element(clock_offsets.begin(), clock_offsets.end()); }
+        };
+
+        const double tolerance;
+        const rs_straggler_policy policy;
+        const deliver_function deliver;
+        const discard_function discard;
+        std::vector<device_queue> devices;
+
+        double get_head_time(int device) const; // Host time of the oldest queued frameset of a device, which must have one
+        bool match();
+    public:
+        frameset_matcher(int device_count, double tolerance, rs_straggler_policy policy, deliver_function deliver, discard_function discard);
+
+        void push(int device, void * frameset, double timestamp, long long system_time); // Timestamp and system time in ms
+        void flush(); // Discards every queued frameset
+    };
+
+    // Installs a frameset callback on every device and matches their framesets across devices as they arrive, on the threads delivering them
+    class multi_device_sync
+    {
+        struct state
+        {
+            std::mutex mutex;
+            std::vector<rs_device *> devices;
+            std::unique_ptr<rs_multi_frameset_callback, void(*)(rs_multi_frameset_callback *)> callback; // Reset once the synchronizer is released
+            std::unique_ptr<frameset_matcher> matcher;
+
+            state(std::vector<rs_device *> devices, rs_multi_frameset_callback * callback) : devices(devices), callback(callback, [](rs_multi_frameset_callback * c) { c->release(); }) {}
+        };
+        class device_callback;
+
+        std::shared_ptr<state> shared;  // Also held by the frameset callbacks, which devices may keep after the synchronizer is released
+
+        multi_device_sync(const multi_device_sync &) = delete;
+        multi_device_sync & operator=(const multi_device_sync &) = delete;
+    public:
+        multi_device_sync(const std::vector<rs_device *> & devices, double tolerance, rs_straggler_policy policy, rs_multi_frameset_callback * callback); // Takes ownership of callback
+        ~multi_device_sync(); // Releases the queued framesets, the devices then release every frameset they form until their frameset callback is set again
+    };
+}
+
+// Synchronizer handed out through the C API
+struct rs_multi_sync : rsimpl::multi_device_sync
+{
+    rs_multi_sync(const std::vector<rs_device *> & devices, double tolerance, rs_straggler_policy policy, rs_multi_frameset_callback * callback) : multi_device_sync(devices, tolerance, policy, callback) {}
+};
+
+#endif
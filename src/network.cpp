@@ -0,0 +1,429 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "network.h"
+
+#include <cstring>
+#ifdef _WIN32
+#define NOMINMAX // Keeps std::min and std::max usable
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+using namespace rsimpl;
+using namespace rsimpl::network;
+
+#ifdef _WIN32
+typedef SOCKET native_socket;
+static int get_socket_error() { return WSAGetLastError(); }
+static void close_socket(native_socket s) { closesocket(s); }
+#else
+typedef int native_socket;
+static const native_socket INVALID_SOCKET = -1;
+static int get_socket_error() { return errno; }
+static void close_socket(native_socket s) { ::close(s); }
+#endif
+
+// Largest data of a request the server accepts, well above any control or bulk transfer
+static const uint32_t max_request_size = 1 << 20;
+
+static native_socket open_socket(int family)
+{
+#ifdef _WIN32
+    static const bool started = []() { WSADATA data; return WSAStartup(MAKEWORD(2, 2), &data) == 0; }();
+    if (!started) throw std::runtime_error("WSAStartup(...) failed");
+#endif
+    auto s = ::socket(family, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET) throw std::runtime_error(to_string() << "socket(...) failed, error " << get_socket_error());
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    return s;
+}
+
+static void disable_nagle(native_socket s)
+{
+    int on = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&on), sizeof(on));
+}
+
+tcp_socket::tcp_socket(intptr_t handle) : handle(handle) { disable_nagle(static_cast<native_socket>(handle)); }
+tcp_socket::~tcp_socket() { close_socket(static_cast<native_socket>(handle)); }
+
+std::unique_ptr<tcp_socket> tcp_socket::connect(const std::string & host, int port)
+{
+    addrinfo hints = {}, * addresses = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses)) throw std::runtime_error(to_string() << "could not resolve " << host << ", error " << status);
+
+    std::string error = to_string() << "could not connect to " << host << ":" << port;
+    for (auto a = addresses; a; a = a->ai_next)
+    {
+        auto s = open_socket(a->ai_family);
+        if (::connect(s, a->ai_addr, static_cast<int>(a->ai_addrlen)) == 0)
+        {
+            freeaddrinfo(addresses);
+            return std::unique_ptr<tcp_socket>(new tcp_socket(s));
+        }
+        error = to_string() << "could not connect to " << host << ":" << port << ", error " << get_socket_error();
+        close_socket(s);
+    }
+    freeaddrinfo(addresses);
+    throw std::runtime_error(error);
+}
+
+void tcp_socket::send(const buffer buffers[], int count)
+{
+    const int max_buffers = 8;
+    if (count > max_buffers) throw std::logic_error("too many buffers to send at once");
+#ifdef _WIN32
+    WSABUF parts[max_buffers];
+    for (int i = 0; i < count; ++i) parts[i] = { static_cast<ULONG>(buffers[i].size), const_cast<char *>(static_cast<const char *>(buffers[i].data)) };
+#else
+    iovec parts[max_buffers];
+    for (int i = 0; i < count; ++i) parts[i] = { const_cast<void *>(buffers[i].data), buffers[i].size };
+#endif
+
+    // The kernel may take part of the buffers, in which case the rest is sent from where it stopped
+    for (int first = 0; first < count; )
+    {
+#ifdef _WIN32
+        DWORD sent = 0;
+        if (WSASend(static_cast<native_socket>(handle), parts + first, count - first, &sent, 0, nullptr, nullptr) != 0) throw std::runtime_error(to_string() << "sending failed, error " << get_socket_error());
+        size_t remaining = sent;
+        while (first < count && remaining >= parts[first].len) remaining -= parts[first++].len;
+        if (remaining) { parts[first].buf += remaining; parts[first].len -= static_cast<ULONG>(remaining); }
+#else
+        msghdr message = {};
+        message.msg_iov = parts + first;
+        message.msg_iovlen = count - first;
+#ifdef MSG_NOSIGNAL
+        auto sent = sendmsg(static_cast<native_socket>(handle), &message, MSG_NOSIGNAL);
+#else
+        auto sent = sendmsg(static_cast<native_socket>(handle), &message, 0);
+#endif
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0) throw std::runtime_error(to_string() << "sending failed, error " << errno);
+        size_t remaining = static_cast<size_t>(sent);
+        while (first < count && remaining >= parts[first].iov_len) remaining -= parts[first++].iov_len;
+        if (remaining) { parts[first].iov_base = static_cast<char *>(parts[first].iov_base) + remaining; parts[first].iov_len -= remaining; }
+#endif
+    }
+}
+
+bool tcp_socket::receive(void * data, size_t size)
+{
+    auto dest = static_cast<char *>(data);
+    for (size_t received = 0; received < size; )
+    {
+        auto n = recv(static_cast<native_socket>(handle), dest + received, static_cast<int>(std::min<size_t>(size - received, 1 << 30)), 0);
+#ifndef _WIN32
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n < 0) throw std::runtime_error(to_string() << "receiving failed, error " << get_socket_error());
+        if (n == 0)
+        {
+            if (received == 0) return false;
+            throw std::runtime_error("connection closed in the middle of a message");
+        }
+        received += n;
+    }
+    return true;
+}
+
+void tcp_socket::shutdown()
+{
+#ifdef _WIN32
+    ::shutdown(static_cast<native_socket>(handle), SD_BOTH);
+#else
+    ::shutdown(static_cast<native_socket>(handle), SHUT_RDWR);
+#endif
+}
+
+void rsimpl::network::send_message(tcp_socket & s, message_header header, const arguments * args, const void * data, size_t size)
+{
+    header.magic = protocol_magic;
+    header.size = static_cast<uint32_t>((args ? sizeof(*args) : 0) + size);
+    buffer buffers[3] = { { &header, sizeof(header) } };
+    int count = 1;
+    if (args) buffers[count++] = { args, sizeof(*args) };
+    if (size) buffers[count++] = { data, size };
+    s.send(buffers, count);
+}
+
+////////////
+// server //
+////////////
+
+struct server::session
+{
+    std::unique_ptr<tcp_socket> connection;
+    std::vector<std::shared_ptr<uvc::device>> devices;
+    std::vector<bool> streaming, acquiring;     // Of every device, only accessed by the thread of the server
+
+    std::mutex send_mutex;                      // Serializes the replies of the server thread and the frames of the capture threads
+    bool connected;                             // Guarded by send_mutex, cleared once a send failed
+
+    session(std::unique_ptr<tcp_socket> connection, std::vector<std::shared_ptr<uvc::device>> devices) : connection(std::move(connection)), devices(devices),
+        streaming(devices.size()), acquiring(devices.size()), connected(true) {}
+
+    void send(const message_header & header, const arguments * args, const void * data, size_t size)
+    {
+        std::lock_guard<std::mutex> lock(send_mutex);
+        if (!connected) return;
+        try { send_message(*connection, header, args, data, size); }
+        catch (const std::exception & e)
+        {
+            LOG_WARNING("Client of the server was lost: " << e.what());
+            connected = false;
+            connection->shutdown(); // Ends the requests of the session
+        }
+    }
+
+    void execute(const message_header & request, const arguments & in, const std::vector<byte> & data, arguments & out, std::vector<byte> & out_data);
+};
+
+server::server(const std::string & address, int port) : context(uvc::create_context()), listener(INVALID_SOCKET), stopping(false)
+{
+    if (port < 0 || port > 65535) throw std::runtime_error(to_string() << "invalid port " << port);
+    addrinfo hints = {}, * addresses = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (int status = getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &addresses)) throw std::runtime_error(to_string() << "could not resolve " << address << ", error " << status);
+
+    auto s = open_socket(AF_INET);
+    int on = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&on), sizeof(on));
+    const bool bound = bind(s, addresses->ai_addr, static_cast<int>(addresses->ai_addrlen)) == 0;
+    freeaddrinfo(addresses);
+    if (!bound || listen(s, 1) != 0)
+    {
+        auto error = get_socket_error();
+        close_socket(s);
+        throw std::runtime_error(to_string() << "could not listen on " << address << ":" << port << ", error " << error);
+    }
+    listener = s;
+    thread = uvc::start_backend_thread([this]() { run(); });
+}
+
+server::~server()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        if (current) current->connection->shutdown();
+    }
+#ifdef _WIN32
+    ::shutdown(static_cast<native_socket>(listener), SD_BOTH);
+#else
+    ::shutdown(static_cast<native_socket>(listener), SHUT_RDWR); // Wakes the thread up from accept
+#endif
+    thread.join();
+    close_socket(static_cast<native_socket>(listener));
+}
+
+int server::get_port() const
+{
+    sockaddr_in address = {};
+    socklen_t size = sizeof(address);
+    if (getsockname(static_cast<native_socket>(listener), reinterpret_cast<sockaddr *>(&address), &size) != 0) throw std::runtime_error(to_string() << "getsockname(...) failed, error " << get_socket_error());
+    return ntohs(address.sin_port);
+}
+
+void server::run()
+{
+    while (true)
+    {
+        auto s = accept(static_cast<native_socket>(listener), nullptr, nullptr);
+        std::shared_ptr<session> next;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping)
+            {
+                if (s != INVALID_SOCKET) close_socket(s);
+                return;
+            }
+            if (s == INVALID_SOCKET)
+            {
+                LOG_WARNING("accept(...) failed, error " << get_socket_error());
+                std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Out of descriptors, most likely
+                continue;
+            }
+            try { next = current = std::make_shared<session>(std::unique_ptr<tcp_socket>(new tcp_socket(s)), uvc::query_devices(context)); }
+            catch (const std::exception & e)
+            {
+                LOG_ERROR("Client of the server was refused: " << e.what());
+                continue;
+            }
+        }
+        serve(next);
+        std::lock_guard<std::mutex> lock(mutex);
+        current.reset();
+    }
+}
+
+void server::serve(std::shared_ptr<session> s)
+{
+    LOG_INFO("Server is serving " << s->devices.size() << " devices to a client");
+    try
+    {
+        message_header request;
+        while (s->connection->receive(&request, sizeof(request)))
+        {
+            arguments in = {};
+            if (request.magic != protocol_magic || request.size < sizeof(in) || request.size - sizeof(in) > max_request_size) throw std::runtime_error("malformed request");
+            std::vector<byte> data(request.size - sizeof(in));
+            if (!s->connection->receive(&in, sizeof(in)) || (data.size() && !s->connection->receive(data.data(), data.size()))) throw std::runtime_error("request is truncated");
+
+            message_header reply = { protocol_magic, message_type::reply, request.request, request.device, request.subdevice, reply_status::ok, 0 };
+            arguments out = {};
+            std::vector<byte> out_data;
+            try { s->execute(request, in, data, out, out_data); }
+            catch (const std::exception & e)
+            {
+                reply.status = dynamic_cast<const uvc::control_rejected_error *>(&e) ? reply_status::rejected : reply_status::failed;
+                std::string message = e.what();
+                out_data.assign(message.begin(), message.end());
+            }
+            s->send(reply, &out, out_data.data(), out_data.size());
+        }
+    }
+    catch (const std::exception & e)
+    {
+        LOG_WARNING("Client of the server was dropped: " << e.what());
+    }
+
+    // Whatever the client left running stops with it
+    for (size_t i = 0; i < s->devices.size(); ++i)
+    {
+        try
+        {
+            if (s->streaming[i]) uvc::stop_streaming(*s->devices[i]);
+            if (s->acquiring[i]) uvc::stop_data_acquisition(*s->devices[i]);
+        }
+        catch (const std::exception & e) { LOG_WARNING("Device " << i << " of the server could not be stopped: " << e.what()); }
+    }
+    LOG_INFO("Server client disconnected");
+}
+
+void server::session::execute(const message_header & request, const arguments & in, const std::vector<byte> & data, arguments & out, std::vector<byte> & out_data)
+{
+    if (request.type == message_type::hello)
+    {
+        if (in.values[0] != static_cast<int32_t>(protocol_version)) throw std::runtime_error(to_string() << "server speaks version " << protocol_version << " of the protocol, client " << in.values[0]);
+        out.values[0] = protocol_version;
+        return;
+    }
+    if (request.type == message_type::list_devices)
+    {
+        out_data.resize(devices.size() * sizeof(device_description));
+        for (size_t i = 0; i < devices.size(); ++i)
+        {
+            device_description d = {};
+            d.vendor_id = uvc::get_vendor_id(*devices[i]);
+            d.product_id = uvc::get_product_id(*devices[i]);
+            strncpy(d.usb_port_id, uvc::get_usb_port_id(*devices[i]).c_str(), sizeof(d.usb_port_id) - 1);
+            strncpy(d.device_instance_id, uvc::get_device_instance_id(*devices[i]).c_str(), sizeof(d.device_instance_id) - 1);
+            memcpy(out_data.data() + i * sizeof(d), &d, sizeof(d));
+        }
+        return;
+    }
+
+    if (request.device < 0 || request.device >= static_cast<int>(devices.size())) throw std::runtime_error(to_string() << "no device " << request.device);
+    auto & device = *devices[request.device];
+    const int index = request.device, subdevice = request.subdevice;
+    switch (request.type)
+    {
+    case message_type::is_device_connected: out.values[0] = uvc::is_device_connected(device, in.values[0], in.values[1]); break;
+    case message_type::claim_interface: uvc::claim_interface(device, in.xu.id, in.values[0]); break;
+    case message_type::claim_aux_interface: uvc::claim_aux_interface(device, in.xu.id, in.values[0]); break;
+    case message_type::bulk_transfer:
+    {
+        // Data of the request goes to OUT endpoints, data of the reply comes from IN endpoints
+        const auto endpoint = static_cast<unsigned char>(in.values[0]);
+        if (endpoint & 0x80)
+        {
+            if (in.values[1] < 0 || static_cast<uint32_t>(in.values[1]) > max_request_size) throw std::runtime_error("bulk transfer is too large");
+            out_data.resize(in.values[1]);
+        }
+        else out_data = data;
+        int actual_length = 0;
+        uvc::bulk_transfer(device, endpoint, out_data.data(), static_cast<int>(out_data.size()), &actual_length, in.values[2]);
+        out.values[0] = actual_length;
+        out_data.resize(endpoint & 0x80 ? actual_length : 0);
+        break;
+    }
+    case message_type::get_pu_control_range: uvc::get_pu_control_range(device, subdevice, static_cast<rs_option>(in.values[0]), &out.values[0], &out.values[1], &out.values[2], &out.values[3]); break;
+    case message_type::get_extension_control_range: uvc::get_extension_control_range(device, in.xu, static_cast<char>(in.values[0]), &out.values[0], &out.values[1], &out.values[2], &out.values[3]); break;
+    case message_type::set_pu_control: uvc::set_pu_control(device, subdevice, static_cast<rs_option>(in.values[0]), in.values[1]); break;
+    case message_type::get_pu_control: out.values[0] = uvc::get_pu_control(device, subdevice, static_cast<rs_option>(in.values[0])); break;
+    case message_type::set_control:
+    {
+        auto value = data;
+        uvc::set_control(device, in.xu, static_cast<uint8_t>(in.values[0]), value.data(), static_cast<int>(value.size()));
+        break;
+    }
+    case message_type::get_control:
+        if (in.values[1] < 0 || static_cast<uint32_t>(in.values[1]) > max_request_size) throw std::runtime_error("control is too large");
+        out_data.resize(in.values[1]);
+        uvc::get_control(device, in.xu, static_cast<uint8_t>(in.values[0]), out_data.data(), static_cast<int>(out_data.size()));
+        break;
+    case message_type::set_subdevice_mode:
+    {
+        const size_t frame_size = static_cast<uint32_t>(in.values[4]);
+        uvc::set_subdevice_mode(device, subdevice, in.values[0], in.values[1], static_cast<uint32_t>(in.values[2]), in.values[3], frame_size,
+            [this, index, subdevice, frame_size](const void * frame, size_t size, inline_function continuation)
+        {
+            // The capture buffer goes out as is, and is requeued only once the kernel took all of it. The frame size of the client only bounds
+            // what is sent, never reading past what the device delivered.
+            const message_header header = { protocol_magic, message_type::frame, 0, index, subdevice, reply_status::ok, 0 };
+            send(header, nullptr, frame, std::min(size, frame_size));
+            continuation();
+        });
+        break;
+    }
+    case message_type::set_subdevice_buffer_count: uvc::set_subdevice_buffer_count(device, subdevice, in.values[0]); break;
+    case message_type::get_subdevice_buffer_count_range: uvc::get_subdevice_buffer_count_range(device, out.values[0], out.values[1]); break;
+    case message_type::get_subdevice_transfer_statistics:
+    {
+        const auto statistics = uvc::get_subdevice_transfer_statistics(device, subdevice);
+        out_data.resize(sizeof(statistics));
+        memcpy(out_data.data(), &statistics, sizeof(statistics));
+        break;
+    }
+    case message_type::set_capture_thread_scheduling:
+    {
+        uint64_t cpu_mask;
+        memcpy(&cpu_mask, in.values, sizeof(cpu_mask));
+        uvc::set_capture_thread_scheduling(device, cpu_mask, in.values[2]);
+        break;
+    }
+    case message_type::set_data_channel_handler:
+        uvc::set_subdevice_data_channel_handler(device, subdevice, [this, index, subdevice](const unsigned char * transfer, const int size)
+        {
+            const message_header header = { protocol_magic, message_type::data, 0, index, subdevice, reply_status::ok, 0 };
+            send(header, nullptr, transfer, size);
+        });
+        break;
+    case message_type::start_streaming: uvc::start_streaming(device, in.values[0]); streaming[index] = true; break;
+    case message_type::stop_streaming: streaming[index] = false; uvc::stop_streaming(device); break;
+    case message_type::pause_streaming: uvc::pause_streaming(device, subdevice); break;
+    case message_type::resume_streaming: uvc::resume_streaming(device, subdevice); break;
+    case message_type::start_data_acquisition: uvc::start_data_acquisition(device, in.values[0]); acquiring[index] = true; break;
+    case message_type::stop_data_acquisition: acquiring[index] = false; uvc::stop_data_acquisition(device); break;
+    default: throw std::runtime_error(to_string() << "unknown request " << static_cast<uint32_t>(request.type));
+    }
+}
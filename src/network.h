@@ -0,0 +1,137 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_NETWORK_H
+#define LIBREALSENSE_NETWORK_H
+
+#include "uvc.h"
+
+#include <thread>
+
+namespace rsimpl
+{
+    // Relays the UVC devices of one host to the library of another over TCP. The server runs next to the cameras and carries out the requests of
+    // a client, the network backend, on its own UVC devices, sending back the native frames and motion data exactly as they are captured, so
+    // that unpacking and everything after it happens on the client. Every message is a message_header followed by size bytes, all in the byte
+    // order of the hosts, which must match. Requests carry an arguments block, followed by the data of the request if any, and every request gets
+    // a reply echoing its id, with the same layout, status and an error message in place of the data when the request failed.
+    namespace network
+    {
+        const uint32_t protocol_magic = 0x4e545352;     // "RSTN"
+        const uint32_t protocol_version = 1;
+
+        enum class message_type : uint32_t
+        {
+            hello = 1,                  // First request of a client, the protocol version in the first value
+            list_devices,               // Replied with a device_description per device
+            is_device_connected,
+            claim_interface,
+            claim_aux_interface,
+            bulk_transfer,
+            get_pu_control_range,
+            get_extension_control_range,
+            set_pu_control,
+            get_pu_control,
+            set_control,
+            get_control,
+            set_subdevice_mode,
+            set_subdevice_buffer_count,
+            get_subdevice_buffer_count_range,
+            set_capture_thread_scheduling,
+            set_data_channel_handler,
+            start_streaming,
+            stop_streaming,
+            pause_streaming,
+            resume_streaming,
+            start_data_acquisition,
+            stop_data_acquisition,
+            get_subdevice_transfer_statistics, // Replied with the uvc::transfer_statistics of the subdevice on the server
+            reply = 64,
+            frame,                      // Sent by the server for every frame captured by a subdevice set to a mode by the client
+            data                        // Sent by the server for every transfer of a data channel the client acquires
+        };
+
+        enum class reply_status : uint32_t { ok, failed, rejected }; // Rejected requests failed for good, as uvc::control_rejected_error
+
+        struct message_header
+        {
+            uint32_t magic;
+            message_type type;
+            uint32_t request;           // Id of the request, echoed by its reply
+            int32_t device;             // Index among the devices listed by the server
+            int32_t subdevice;
+            reply_status status;
+            uint32_t size;              // Bytes following the header
+        };
+
+        struct arguments
+        {
+            int32_t values[6];          // Meaning depends on the message type
+            uvc::extension_unit xu;     // Of the extension unit controls
+        };
+
+        struct device_description
+        {
+            int32_t vendor_id, product_id;
+            char usb_port_id[64];
+            char device_instance_id[192];
+        };
+
+        struct buffer { const void * data; size_t size; };
+
+        // A connected TCP stream with Nagle's algorithm disabled. Sends gather the buffers they are given in a single call, without copying them.
+        class tcp_socket
+        {
+            intptr_t handle;
+            tcp_socket(const tcp_socket &) = delete;
+            tcp_socket & operator=(const tcp_socket &) = delete;
+        public:
+            explicit tcp_socket(intptr_t handle);
+            ~tcp_socket();
+
+            static std::unique_ptr<tcp_socket> connect(const std::string & host, int port);
+            void send(const buffer buffers[], int count); // Not thread safe, the caller serializes sends
+            bool receive(void * data, size_t size); // Returns false when the peer closed the connection before the first byte
+            void shutdown(); // Makes sends and receives of other threads fail
+        };
+
+        // Sends a message made of a header, an arguments block if not null, and data, throwing if the connection is lost
+        void send_message(tcp_socket & s, message_header header, const arguments * args, const void * data, size_t size);
+
+        // Serves the UVC devices of this host to one client at a time, from a thread of its own, until it is destroyed. Frames are sent from the
+        // capture threads of the backend, straight from the capture buffers, which are only requeued once sent: a client falling behind makes the
+        // driver drop frames rather than the server queue them. Clients are not authenticated, and may send any hw-monitor command, firmware
+        // updates included, so that the server only listens on the address it is given, loopback unless the network is trusted.
+        class server
+        {
+            struct session;
+
+            std::shared_ptr<uvc::context> context;
+            intptr_t listener;
+            std::mutex mutex;                   // Guards the members below
+            std::shared_ptr<session> current;
+            bool stopping;
+            std::thread thread;
+
+            server(const server &) = delete;
+            server & operator=(const server &) = delete;
+
+            void run();
+            void serve(std::shared_ptr<session> s);
+        public:
+            server(const std::string & address, int port); // Address of a local interface, port 0 picks any free port
+            ~server();
+
+            int get_port() const;
+        };
+    }
+}
+
+// Server handed out through the C API
+struct rs_server : rsimpl::network::server
+{
+    rs_server(const std::string & address, int port) : server(address, port) {}
+};
+
+#endif
@@ -0,0 +1,88 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "numa.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#ifdef __linux__
+#include <climits>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace rsimpl;
+
+namespace
+{
+    int read_int(const std::string & path, int fallback)
+    {
+        std::ifstream file(path);
+        int value;
+        return file >> value ? value : fallback;
+    }
+}
+
+uint64_t numa::parse_cpu_list(const std::string & list)
+{
+    uint64_t mask = 0;
+    std::istringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ','))
+    {
+        int first, last;
+        char dash;
+        std::istringstream r(range);
+        if (!(r >> first)) continue;
+        if (!(r >> dash >> last) || dash != '-') last = first;
+        for (int cpu = std::max(first, 0); cpu <= last && cpu < 64; ++cpu) mask |= 1ull << cpu;
+    }
+    return mask;
+}
+
+#ifdef __linux__
+int numa::get_usb_node(const std::string & usb_port_id)
+{
+    // The port id "2-3-1" names the sysfs device "2-3.1", which sits under the PCI device of its host controller
+    const auto dash = usb_port_id.find('-');
+    if (dash == std::string::npos || usb_port_id.find('/') != std::string::npos) return -1;
+    auto name = usb_port_id;
+    for (auto i = dash + 1; i < name.size(); ++i) if (name[i] == '-') name[i] = '.';
+
+    char resolved[PATH_MAX];
+    if (!realpath(("/sys/bus/usb/devices/" + name).c_str(), resolved)) return -1;
+    for (std::string path = resolved; path.size() > 1; path = path.substr(0, path.rfind('/')))
+    {
+        if (access((path + "/numa_node").c_str(), R_OK) == 0) return read_int(path + "/numa_node", -1);
+    }
+    return -1;
+}
+
+uint64_t numa::get_node_cpu_mask(int node)
+{
+    if (node < 0) return 0;
+    std::ifstream file(to_string() << "/sys/devices/system/node/node" << node << "/cpulist");
+    std::string list;
+    return std::getline(file, list) ? parse_cpu_list(list) : 0;
+}
+
+bool numa::prefer_node(void * ptr, size_t length, int node)
+{
+#ifdef SYS_mbind
+    const int mpol_preferred = 1; // MPOL_PREFERRED of <linux/mempolicy.h>
+    const int max_nodes = 1024;
+    if (node < 0 || node >= max_nodes) return false;
+    unsigned long nodes[max_nodes / (8 * sizeof(unsigned long))] = {};
+    nodes[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+    return syscall(SYS_mbind, ptr, length, mpol_preferred, nodes, max_nodes + 1, 0) == 0;
+#else
+    return false;
+#endif
+}
+#else
+int numa::get_usb_node(const std::string &) { return -1; }
+uint64_t numa::get_node_cpu_mask(int) { return 0; }
+bool numa::prefer_node(void *, size_t, int) { return false; }
+#endif
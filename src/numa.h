@@ -0,0 +1,30 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_NUMA_H
+#define LIBREALSENSE_NUMA_H
+
+#include "types.h"
+
+namespace rsimpl
+{
+    // Placement of the memory and threads of a device on the NUMA node of the host controller it is attached to. Only Linux exposes the
+    // topology, through sysfs, everywhere else a device is on no node in particular.
+    namespace numa
+    {
+        // Node of the host controller of a USB device from its USB port id, -1 if unknown or if the system has a single node
+        int get_usb_node(const std::string & usb_port_id);
+
+        // Mask of the CPUs of a node, as RS_OPTION_CAPTURE_THREAD_AFFINITY takes it, only covering the first 64 CPUs. 0 if unknown.
+        uint64_t get_node_cpu_mask(int node);
+
+        // Parses a sysfs CPU list such as "0-7,16-23"
+        uint64_t parse_cpu_list(const std::string & list);
+
+        // Asks for the pages of a mapping not yet touched to come from a node. Returns false if the system does not support it.
+        bool prefer_node(void * ptr, size_t length, int node);
+    }
+}
+
+#endif
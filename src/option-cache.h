@@ -0,0 +1,67 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_OPTION_CACHE_H
+#define LIBREALSENSE_OPTION_CACHE_H
+
+#include "types.h"
+
+namespace rsimpl
+{
+    // Values of device options as last written or read, so that reading them again costs no USB control transfer. Only options the firmware
+    // never changes on its own belong here: those it does, such as the outputs of auto-exposure, must be read from the device every time.
+    class option_value_cache
+    {
+        mutable std::mutex mutex;   // Options are read and written from application threads and executor jobs alike
+        double values[RS_OPTION_COUNT];
+        bool known[RS_OPTION_COUNT];
+    public:
+        option_value_cache() { invalidate_all(); }
+
+        bool lookup(rs_option option, double & value) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!known[option]) return false;
+            value = values[option];
+            return true;
+        }
+
+        void store(rs_option option, double value)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            values[option] = value;
+            known[option] = true;
+        }
+
+        void invalidate(rs_option option) // Before writing an option, so that a write failing halfway leaves no stale value behind
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            known[option] = false;
+        }
+
+        // Drops the writes of values the device is known to hold already, and invalidates the options of the others
+        void drop_known_writes(std::vector<rs_option> & options, std::vector<double> & written_values)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t kept = 0;
+            for (size_t i = 0; i < options.size(); ++i)
+            {
+                if (known[options[i]] && values[options[i]] == written_values[i]) continue;
+                known[options[i]] = false;
+                options[kept] = options[i];
+                written_values[kept++] = written_values[i];
+            }
+            options.resize(kept);
+            written_values.resize(kept);
+        }
+
+        void invalidate_all()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto & k : known) k = false;
+        }
+    };
+}
+
+#endif
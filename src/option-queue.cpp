@@ -0,0 +1,105 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "option-queue.h"
+
+using namespace rsimpl;
+
+// Appends writes to a request, an option written again moving to the end so that the values land in the order they were last written
+static void merge_writes(std::vector<rs_option> & into_options, std::vector<double> & into_values, const rs_option options[], size_t count, const double values[])
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto it = std::find(into_options.begin(), into_options.end(), options[i]);
+        if (it != into_options.end())
+        {
+            into_values.erase(into_values.begin() + (it - into_options.begin()));
+            into_options.erase(it);
+        }
+        into_options.push_back(options[i]);
+        into_values.push_back(values[i]);
+    }
+}
+
+void option_request_queue::set(const rs_option options[], size_t count, const double values[], completion on_complete)
+{
+    request r = { true };
+    merge_writes(r.options, r.values, options, count, values);
+    r.completions.push_back(std::make_pair(std::vector<rs_option>(options, options + count), on_complete));
+    push(std::move(r));
+}
+
+void option_request_queue::get(const rs_option options[], size_t count, completion on_complete)
+{
+    request r = { false, std::vector<rs_option>(options, options + count), std::vector<double>(count) };
+    r.completions.push_back(std::make_pair(r.options, on_complete));
+    push(std::move(r));
+}
+
+void option_request_queue::push(request r)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) throw std::runtime_error("options can no longer be requested from a device being released");
+
+        if (r.is_write && !requests.empty() && requests.back().is_write)
+        {
+            auto & last = requests.back();
+            merge_writes(last.options, last.values, r.options.data(), r.options.size(), r.values.data());
+            for (auto & c : r.completions) last.completions.push_back(std::move(c));
+        }
+        else requests.push_back(std::move(r));
+    }
+    job->trigger();
+}
+
+// Every run carries out the requests until none is left, a request made meanwhile triggering one more run which may find none
+void option_request_queue::run()
+{
+    while (true)
+    {
+        request r;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping || requests.empty()) return;
+            r = std::move(requests.front());
+            requests.pop_front();
+        }
+
+        std::string error_message;
+        try
+        {
+            if (r.is_write) set_options(r.options.data(), r.options.size(), r.values.data());
+            else get_options(r.options.data(), r.options.size(), r.values.data());
+        }
+        catch (const std::exception & e) { error_message = e.what(); }
+        catch (...) { error_message = "unknown error"; }
+        complete(r, error_message.empty() ? nullptr : error_message.c_str());
+    }
+}
+
+void option_request_queue::complete(const request & r, const char * error_message)
+{
+    for (auto & c : r.completions)
+    {
+        if (!c.second) continue;
+
+        // Every request is answered with its own options, at the values finally written or read
+        std::vector<double> values;
+        for (auto option : c.first) values.push_back(r.values[std::find(r.options.begin(), r.options.end(), option) - r.options.begin()]);
+        try { c.second(c.first.data(), c.first.size(), values.data(), error_message); }
+        catch (...) { LOG_ERROR("Received an exception from option request callback!"); }
+    }
+}
+
+void option_request_queue::stop()
+{
+    std::deque<request> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        abandoned.swap(requests);
+    }
+    job->cancel();
+    for (auto & r : abandoned) complete(r, "the device was released before the request was carried out");
+}
@@ -0,0 +1,53 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_OPTION_QUEUE_H
+#define LIBREALSENSE_OPTION_QUEUE_H
+
+#include "executor.h"
+
+namespace rsimpl
+{
+    // Carries out option requests one at a time, in the order they were made, on a job of the executor, so that callers do not wait for the
+    // hardware IO. A write still waiting its turn absorbs the writes queued after it, which then complete together: a stream of updates to
+    // the same options reaches the camera no faster than the camera takes them, with only the latest values written.
+    class option_request_queue
+    {
+    public:
+        typedef std::function<void(const rs_option options[], size_t count, const double values[])> setter;
+        typedef std::function<void(const rs_option options[], size_t count, double values[])> getter;
+        typedef std::function<void(const rs_option options[], size_t count, const double values[], const char * error_message)> completion; // error_message is null on success
+    private:
+        struct request
+        {
+            bool is_write;
+            std::vector<rs_option> options;         // Merged writes carry every option of the writes they absorbed, each once
+            std::vector<double> values;
+            std::vector<std::pair<std::vector<rs_option>, completion>> completions; // Options of every request served, in the order they were made
+        };
+
+        const setter set_options;
+        const getter get_options;
+        std::mutex mutex;
+        std::deque<request> requests;
+        bool stopping = false;
+        std::shared_ptr<executor::job> job;
+
+        option_request_queue(const option_request_queue &) = delete;
+        option_request_queue & operator=(const option_request_queue &) = delete;
+
+        void push(request r);
+        void run();
+        static void complete(const request & r, const char * error_message);
+    public:
+        option_request_queue(executor & pool, setter set_options, getter get_options) : set_options(set_options), get_options(get_options), job(pool.create_job([this]() { run(); })) {}
+        ~option_request_queue() { stop(); }
+
+        void set(const rs_option options[], size_t count, const double values[], completion on_complete); // on_complete may be empty
+        void get(const rs_option options[], size_t count, completion on_complete);
+        void stop(); // Waits for the request being carried out and fails those still queued
+    };
+}
+
+#endif
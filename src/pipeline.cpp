@@ -0,0 +1,156 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "pipeline.h"
+#include "uvc.h" // For set_thread_cpu_mask
+
+using namespace rsimpl;
+
+unpack_pipeline::unpack_pipeline(int thread_count, uint64_t cpu_mask)
+{
+    if (thread_count < 1) throw std::invalid_argument("unpack pipeline requires at least one thread");
+    for (int i = 0; i < thread_count; ++i)
+    {
+        workers.push_back(std::unique_ptr<worker>(new worker()));
+        auto w = workers.back().get();
+        w->thread = std::thread([w]() { w->run(); });
+        uvc::set_thread_cpu_mask(w->thread, cpu_mask);
+    }
+}
+
+void unpack_pipeline::worker::run()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return; // Only reached once stopping, after the queue was drained
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        try { task(); }
+        catch (const std::exception & e) { LOG_ERROR("Frame unpacking failed: " << e.what()); }
+        catch (...) { LOG_ERROR("Frame unpacking failed with an unknown exception"); }
+    }
+}
+
+void unpack_pipeline::submit(int lane, std::function<void()> task)
+{
+    auto & w = *workers[lane % workers.size()];
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (w.stopping) return;
+        w.tasks.push_back(std::move(task));
+    }
+    w.cv.notify_one();
+}
+
+void unpack_pipeline::stop()
+{
+    for (auto & w : workers)
+    {
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            w->stopping = true;
+        }
+        w->cv.notify_one();
+    }
+    for (auto & w : workers)
+    {
+        if (w->thread.joinable()) w->thread.join();
+    }
+}
+
+parallel_pool::parallel_pool(int thread_count)
+{
+    if (thread_count < 1) throw std::invalid_argument("parallel pool requires at least one thread");
+    for (int i = 1; i < thread_count; ++i)
+    {
+        threads.push_back(std::thread([this]()
+        {
+            std::shared_ptr<job> last;
+            while (true)
+            {
+                std::shared_ptr<job> j;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    work_cv.wait(lock, [&]() { return stopping || (current && current != last); });
+                    if (stopping) return;
+                    j = last = current;
+                }
+                run(*j);
+            }
+        }));
+    }
+}
+
+parallel_pool::~parallel_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (auto & t : threads) t.join();
+}
+
+void parallel_pool::run(job & j)
+{
+    for (int i; (i = j.next++) < j.count; )
+    {
+        try { (*j.work)(i); }
+        catch (const std::exception & e) { LOG_ERROR("Parallel work failed: " << e.what()); }
+        catch (...) { LOG_ERROR("Parallel work failed with an unknown exception"); }
+
+        if (++j.finished == j.count)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done_cv.notify_all();
+        }
+    }
+}
+
+void parallel_pool::parallel_for(int count, const std::function<void(int)> & work)
+{
+    if (count <= 0) return;
+    if (threads.empty() || count == 1)
+    {
+        for (int i = 0; i < count; ++i) work(i);
+        return;
+    }
+
+    // Every call gets its own job, so a worker that is late to finish one call can never pick up pieces of the next
+    std::lock_guard<std::mutex> call_lock(call_mutex);
+    auto j = std::make_shared<job>();
+    j->work = &work;
+    j->count = count;
+    j->next = 0;
+    j->finished = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = j;
+    }
+    work_cv.notify_all();
+
+    run(*j);
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [&]() { return j->finished == count; });
+    current.reset();
+}
+
+// Deliberately never destroyed: joining threads during static destruction can deadlock while a DLL is unloaded
+static std::once_flag shared_pool_once;
+static parallel_pool * shared_pool;
+
+parallel_pool & rsimpl::get_shared_parallel_pool()
+{
+    std::call_once(shared_pool_once, []()
+    {
+        const int hardware_threads = static_cast<int>(std::thread::hardware_concurrency());
+        shared_pool = new parallel_pool(std::max(1, std::min(hardware_threads, RS_MAX_UNPACK_THREADS)));
+    });
+    return *shared_pool;
+}
@@ -0,0 +1,73 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_PIPELINE_H
+#define LIBREALSENSE_PIPELINE_H
+
+#include "types.h"
+
+#include <deque>
+#include <thread>
+
+namespace rsimpl
+{
+    // Moves frame unpacking off the backend capture thread
+    // Work submitted on the same lane always runs in submission order on the same worker, so every stream stays in order
+    class unpack_pipeline
+    {
+        struct worker
+        {
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::deque<std::function<void()>> tasks;
+            bool stopping = false;
+            std::thread thread;
+
+            void run();
+        };
+
+        std::vector<std::unique_ptr<worker>> workers;
+
+        unpack_pipeline(const unpack_pipeline &) = delete;
+        unpack_pipeline & operator=(const unpack_pipeline &) = delete;
+    public:
+        explicit unpack_pipeline(int thread_count, uint64_t cpu_mask = 0); // A cpu_mask of 0 lets the threads run on every CPU
+        ~unpack_pipeline() { stop(); }
+
+        void submit(int lane, std::function<void()> task);
+        void stop(); // Completes all submitted work, then joins the workers
+    };
+
+    // Fork-join pool for splitting one computation into independent pieces, such as bands of image rows
+    // The calling thread takes part in the work, and concurrent callers take turns using the pool
+    class parallel_pool
+    {
+        struct job
+        {
+            const std::function<void(int)> * work;
+            int count;
+            std::atomic<int> next, finished;
+        };
+
+        std::mutex call_mutex, mutex;
+        std::condition_variable work_cv, done_cv;
+        std::shared_ptr<job> current;
+        bool stopping = false;
+        std::vector<std::thread> threads;
+
+        void run(job & j);
+        parallel_pool(const parallel_pool &) = delete;
+        parallel_pool & operator=(const parallel_pool &) = delete;
+    public:
+        explicit parallel_pool(int thread_count);
+        ~parallel_pool();
+
+        int get_thread_count() const { return static_cast<int>(threads.size()) + 1; }
+        void parallel_for(int count, const std::function<void(int)> & work); // Calls work(0) ... work(count-1), and returns once all calls have completed
+    };
+
+    parallel_pool & get_shared_parallel_pool(); // Sized to the number of hardware threads, created on first use
+}
+
+#endif
@@ -0,0 +1,205 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#ifdef RS_USE_PLAYBACK_BACKEND
+
+#include "playback.h"
+#include "recording.h"
+#include "shared-ring.h"
+#include "image.h"
+
+using namespace rsimpl;
+
+namespace rsimpl
+{
+    // Frames keep the timestamps and counters they were given when recorded, which the backend hands over along with them
+    class playback_timestamp_reader : public frame_timestamp_reader
+    {
+        const uvc::device & device;
+    public:
+        explicit playback_timestamp_reader(const uvc::device & device) : device(device) {}
+
+        bool validate_frame(const subdevice_mode & mode, const void * frame) override { return true; }
+
+        double get_frame_timestamp(const subdevice_mode & mode, const void * frame, double actual_fps) override
+        {
+            double timestamp = 0; unsigned long long frame_counter = 0;
+            uvc::get_playback_frame_info(device, timestamp, frame_counter);
+            return timestamp;
+        }
+
+        unsigned long long get_frame_counter(const subdevice_mode & mode, const void * frame) override
+        {
+            double timestamp = 0; unsigned long long frame_counter = 0;
+            uvc::get_playback_frame_info(device, timestamp, frame_counter);
+            return frame_counter;
+        }
+    };
+
+    playback_camera::playback_camera(std::shared_ptr<uvc::device> device, const static_device_info & info) : rs_device_base(device, info)
+    {
+    }
+
+    void playback_camera::start_motion_tracking()
+    {
+        rs_device_base::start_motion_tracking();
+        motion_module_ready = true; // The recording only holds data received once the motion module was up
+    }
+
+    void playback_camera::stop_motion_tracking()
+    {
+        motion_module_ready = false;
+        rs_device_base::stop_motion_tracking();
+    }
+
+    void playback_camera::set_playback_pacing(rs_playback_pacing pacing)
+    {
+        uvc::set_playback_pacing(get_device(), pacing);
+    }
+
+    bool playback_camera::step_playback()
+    {
+        return uvc::step_playback(get_device());
+    }
+
+    bool playback_camera::seek_playback_to_frame(rs_stream stream, unsigned long long frame_number)
+    {
+        if (config.info.stream_subdevices[stream] < 0) throw std::runtime_error(to_string() << "recording holds no " << stream << " stream");
+        return uvc::seek_playback_to_frame(get_device(), config.info.stream_subdevices[stream], frame_number);
+    }
+
+    bool playback_camera::seek_playback_to_time(rs_stream stream, double timestamp)
+    {
+        if (config.info.stream_subdevices[stream] < 0) throw std::runtime_error(to_string() << "recording holds no " << stream << " stream");
+        return uvc::seek_playback_to_time(get_device(), config.info.stream_subdevices[stream], timestamp);
+    }
+
+    rs_stream playback_camera::select_key_stream(const std::vector<subdevice_mode_selection> & selected_modes)
+    {
+        // Wait on a stream of the fastest framerate, preferring those which arrive last on cameras delivering several streams at one rate
+        int fps[RS_STREAM_NATIVE_COUNT] = {}, max_fps = 0;
+        for (const auto & m : selected_modes)
+        {
+            for (const auto & output : m.get_outputs())
+            {
+                fps[output.first] = m.mode.fps;
+                max_fps = std::max(max_fps, m.mode.fps);
+            }
+        }
+        for (auto s : { RS_STREAM_COLOR, RS_STREAM_INFRARED2, RS_STREAM_INFRARED, RS_STREAM_FISHEYE })
+        {
+            if (fps[s] == max_fps) return s;
+        }
+        return RS_STREAM_DEPTH;
+    }
+
+    std::vector<std::shared_ptr<frame_timestamp_reader>> playback_camera::create_frame_timestamp_readers() const
+    {
+        auto reader = std::make_shared<playback_timestamp_reader>(get_device());
+        return std::vector<std::shared_ptr<frame_timestamp_reader>>(RS_STREAM_NATIVE_COUNT, reader);
+    }
+
+    // Of the pixel formats of the library, the one a mode was recorded in, able to unpack all the streams recorded from it
+    static const native_pixel_format & find_pixel_format(uint32_t fourcc, const std::vector<recording::stream_record> & streams)
+    {
+        static const native_pixel_format * const formats[] = { &pf_raw8, &pf_rw10, &pf_rw16, &pf_yuy2, &pf_y8, &pf_y8i, &pf_y16, &pf_y12i, &pf_z16, &pf_invz,
+            &pf_f200_invi, &pf_f200_inzi, &pf_sr300_invi, &pf_sr300_inzi };
+        for (auto pf : formats)
+        {
+            if (pf->fourcc != fourcc) continue;
+            for (auto & unpacker : pf->unpackers)
+            {
+                bool unpacks_all = true;
+                for (auto & s : streams) unpacks_all &= unpacker.provides_stream(s.stream);
+                if (unpacks_all) return *pf;
+            }
+        }
+        throw std::runtime_error(to_string() << "recording holds frames of an unknown pixel format " << fourcc);
+    }
+
+    std::shared_ptr<rs_device> make_playback_device(std::shared_ptr<uvc::device> device)
+    {
+        static_device_info info;
+        std::vector<std::pair<recording::mode_record, std::vector<recording::stream_record>>> modes; // With the streams recorded from them
+        bool has_motion_data = false;
+
+        // The records of the recording other than frames are read from its index, the streams recorded after each mode being those unpacked
+        // from it. A ring is described by the modes of the latest start of its device.
+        const auto ring = uvc::get_playback_ring(*device);
+        std::unique_ptr<recording::reader> reader(ring.empty() ? new recording::reader(uvc::get_playback_path(*device)) : new recording::reader(shared_ring::subscriber(ring).get_description()));
+        std::vector<recording::index_entry> index;
+        if (ring.empty()) index = reader->read_index();
+        size_t next_entry = 0;
+        auto next_record = [&](recording::record & r)
+        {
+            if (!ring.empty()) return reader->next(r);
+            while (next_entry < index.size() && index[next_entry].type == recording::record_type::frame) ++next_entry;
+            if (next_entry == index.size()) return false;
+            reader->seek(index[next_entry++]);
+            return reader->next(r);
+        };
+
+        recording::record r;
+        auto string_of = [](const char * s, size_t size) { return std::string(s, std::find(s, s + size, 0)); };
+        size_t current = 0;
+        while (next_record(r))
+        {
+            if (r.type == recording::record_type::device)
+            {
+                auto & d = *reinterpret_cast<const recording::device_record *>(r.payload);
+                info.name = string_of(d.name, sizeof(d.name));
+                info.serial = string_of(d.serial, sizeof(d.serial));
+                info.firmware_version = string_of(d.firmware_version, sizeof(d.firmware_version));
+                if (d.adapter_board_firmware_version[0]) info.camera_info[RS_CAMERA_INFO_ADAPTER_BOARD_FIRMWARE_VERSION] = string_of(d.adapter_board_firmware_version, sizeof(d.adapter_board_firmware_version));
+            }
+            else if (r.type == recording::record_type::mode)
+            {
+                auto & m = *reinterpret_cast<const recording::mode_record *>(r.payload);
+                for (current = 0; current < modes.size() && memcmp(&modes[current].first, &m, sizeof(m)); ++current);
+                if (current == modes.size()) modes.push_back({ m, {} });
+            }
+            else if (r.type == recording::record_type::stream)
+            {
+                auto & s = *reinterpret_cast<const recording::stream_record *>(r.payload);
+                if (current == modes.size() || s.stream < 0 || s.stream >= RS_STREAM_NATIVE_COUNT) throw std::runtime_error("recording is corrupted");
+                auto & streams = modes[current].second;
+                if (std::none_of(streams.begin(), streams.end(), [&s](const recording::stream_record & o) { return o.stream == s.stream; })) streams.push_back(s);
+            }
+            else if (r.type == recording::record_type::motion) has_motion_data = true;
+        }
+        if (modes.empty()) throw std::runtime_error(to_string() << uvc::get_playback_path(*device) << (ring.empty() ? " holds no frames" : " was not published while streaming yet"));
+
+        info.camera_info[RS_CAMERA_INFO_DEVICE_NAME] = info.name;
+        info.camera_info[RS_CAMERA_INFO_DEVICE_SERIAL_NUMBER] = info.serial;
+        info.camera_info[RS_CAMERA_INFO_CAMERA_FIRMWARE_VERSION] = info.firmware_version;
+        info.capabilities_vector.push_back(RS_CAPABILITIES_ENUMERATION);
+        if (has_motion_data)
+        {
+            info.capabilities_vector.push_back(RS_CAPABILITIES_MOTION_EVENTS);
+            info.data_subdevices[RS_STREAM_FISHEYE] = 3;
+        }
+
+        for (auto & mode : modes)
+        {
+            auto & m = mode.first;
+            info.subdevice_modes.push_back({ m.subdevice, { m.width, m.height }, find_pixel_format(m.fourcc, mode.second), m.fps, m.native_intrinsics, {}, { m.pad_crop } });
+            for (auto & s : mode.second)
+            {
+                info.stream_subdevices[s.stream] = m.subdevice;
+                for (auto & p : info.presets[s.stream]) p = { true, s.intrinsics.width, s.intrinsics.height, s.format, s.fps, RS_OUTPUT_BUFFER_FORMAT_CONTINUOUS };
+                info.stream_poses[s.stream] = inverse({ reinterpret_cast<const float3x3 &>(s.extrinsics_to_depth.rotation), reinterpret_cast<const float3 &>(s.extrinsics_to_depth.translation) });
+                info.nominal_depth_scale = s.depth_scale;
+            }
+        }
+
+        for (auto & croppable : info.croppable_subdevices) croppable = true; // Frames carry their timestamps in records of their own, never in their pixels
+        static const rs_capabilities stream_capabilities[RS_STREAM_NATIVE_COUNT] = { RS_CAPABILITIES_DEPTH, RS_CAPABILITIES_COLOR, RS_CAPABILITIES_INFRARED, RS_CAPABILITIES_INFRARED2, RS_CAPABILITIES_FISH_EYE };
+        for (int s = 0; s < RS_STREAM_NATIVE_COUNT; ++s) if (info.stream_subdevices[s] != -1) info.capabilities_vector.push_back(stream_capabilities[s]);
+        info.supported_metadata_vector.push_back(RS_FRAME_METADATA_ACTUAL_FPS);
+
+        rs_device_base::update_device_info(info);
+        return std::make_shared<playback_camera>(device, info);
+    }
+}
+
+#endif
@@ -0,0 +1,35 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_PLAYBACK_H
+#define LIBREALSENSE_PLAYBACK_H
+
+#include "device.h"
+
+namespace rsimpl
+{
+    // Camera replaying a recording through a device of the playback backend. It offers the streams and modes found in the recording, with the
+    // intrinsics, extrinsics and depth scale recorded along with them, and has no options.
+    class playback_camera final : public rs_device_base
+    {
+    protected:
+        void start_motion_tracking() override;
+        void stop_motion_tracking() override;
+    public:
+        playback_camera(std::shared_ptr<uvc::device> device, const static_device_info & info);
+
+        void set_playback_pacing(rs_playback_pacing pacing) override;
+        bool step_playback() override;
+        bool seek_playback_to_frame(rs_stream stream, unsigned long long frame_number) override;
+        bool seek_playback_to_time(rs_stream stream, double timestamp) override;
+
+        void on_before_start(const std::vector<subdevice_mode_selection> & selected_modes) override {}
+        rs_stream select_key_stream(const std::vector<subdevice_mode_selection> & selected_modes) override;
+        std::vector<std::shared_ptr<frame_timestamp_reader>> create_frame_timestamp_readers() const override;
+    };
+
+    std::shared_ptr<rs_device> make_playback_device(std::shared_ptr<uvc::device> device);
+}
+
+#endif
@@ -0,0 +1,530 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "recording.h"
+#include "depth-codec.h"
+
+#include <cstring>
+#include <cstdio>
+#include <sstream>
+#ifdef _WIN32
+#define NOMINMAX // Keeps std::min and std::max usable
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace rsimpl;
+using namespace rsimpl::recording;
+
+static size_t align_up(size_t size, size_t alignment) { return (size + alignment - 1) / alignment * alignment; }
+
+static_assert(sizeof(index_entry) % 8 == 0, "index records need no padding between entries");
+
+// Adds the entry of a record to an index, leaving out the motion records after the first, which only tells readers the recording holds motion data
+static void index_record(std::vector<index_entry> & index, bool & motion_indexed, record_type type, const byte * payload, uint64_t chunk_offset, uint32_t record)
+{
+    if (type == record_type::index || type == record_type::trailer || (type == record_type::motion && motion_indexed)) return;
+    index_entry entry = { chunk_offset, record, type, -1, 0, 0, 0 };
+    if (type == record_type::mode) entry.subdevice = reinterpret_cast<const mode_record *>(payload)->subdevice;
+    else if (type == record_type::motion)
+    {
+        entry.subdevice = reinterpret_cast<const motion_record *>(payload)->subdevice;
+        motion_indexed = true;
+    }
+    else if (type == record_type::frame)
+    {
+        auto & frame = *reinterpret_cast<const frame_record *>(payload);
+        entry.subdevice = frame.subdevice;
+        entry.timestamp = frame.timestamp;
+        entry.frame_counter = frame.frame_counter;
+    }
+    index.push_back(entry);
+}
+
+// Output of the writer thread. On Linux, chunks go straight from their aligned memory to the disk through O_DIRECT, so that hours of recording
+// do not evict everything else from the page cache. File systems refusing O_DIRECT, such as tmpfs, are written through the page cache.
+class writer::file
+{
+#ifdef __linux__
+    int fd;
+public:
+    explicit file(const std::string & path)
+    {
+        fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+        if (fd < 0 && errno == EINVAL) fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw std::runtime_error(to_string() << "could not create recording " << path << ", error " << errno);
+    }
+    ~file() { if (fd >= 0) ::close(fd); }
+
+    void write(const byte * data, size_t size)
+    {
+        while (size)
+        {
+            auto n = ::write(fd, data, size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw std::runtime_error(to_string() << "writing the recording failed, error " << errno);
+            data += n;
+            size -= n;
+        }
+    }
+    void close()
+    {
+        auto result = ::close(fd);
+        fd = -1;
+        if (result < 0) throw std::runtime_error(to_string() << "closing the recording failed, error " << errno);
+    }
+#else
+    FILE * f;
+public:
+    explicit file(const std::string & path)
+    {
+        f = fopen(path.c_str(), "wb");
+        if (!f) throw std::runtime_error(to_string() << "could not create recording " << path);
+        setvbuf(f, nullptr, _IONBF, 0); // Chunks are written whole, there is nothing to gain from another copy
+    }
+    ~file() { if (f) fclose(f); }
+
+    void write(const byte * data, size_t size)
+    {
+        if (fwrite(data, 1, size, f) != size) throw std::runtime_error("writing the recording failed");
+    }
+    void close()
+    {
+        auto result = fclose(f);
+        f = nullptr;
+        if (result) throw std::runtime_error("closing the recording failed");
+    }
+#endif
+};
+
+writer::writer(const std::string & path, size_t chunk_size, int chunk_count, bool lossless)
+    : chunk_size(align_up(chunk_size, chunk_alignment)), lossless(lossless), output(new file(path)), chunks(std::max(chunk_count, 2)), current(nullptr), accepting(true),
+      closing(false), dropped(0), written(0), motion_indexed(false), sealed_size(0)
+{
+    for (auto & c : chunks)
+    {
+        c.memory.resize(this->chunk_size + chunk_alignment);
+        c.data = c.memory.data() + (chunk_alignment - (reinterpret_cast<uintptr_t>(c.memory.data()) % chunk_alignment)) % chunk_alignment;
+        free_chunks.push_back(&c);
+    }
+    thread = std::thread([this]() { run(); });
+}
+
+writer::~writer()
+{
+    try { close(); }
+    catch (const std::exception & e) { LOG_ERROR("Recording was not completed: " << e.what()); }
+}
+
+template<class F> bool writer::append(record_type type, size_t max_size, F write_payload)
+{
+    const size_t max_record_size = sizeof(record_header) + align_up(max_size, 8);
+    if (sizeof(chunk_header) + max_record_size > chunk_size)
+    {
+        ++dropped;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(fill_mutex);
+    if (!accepting) return false;
+    if (current && current->size + max_record_size > chunk_size) seal_current();
+    if (!current)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (free_chunks.empty() && !lossless)
+        {
+            ++dropped;
+            return false;
+        }
+        chunk_freed.wait(lock, [this]() { return !free_chunks.empty(); }); // The writer thread frees every chunk it takes, even after an error
+        current = free_chunks.front();
+        free_chunks.pop_front();
+        current->size = sizeof(chunk_header);
+        current->record_count = 0;
+    }
+
+    auto dest = current->data + current->size;
+    const size_t size = write_payload(dest + sizeof(record_header));
+    const size_t record_size = sizeof(record_header) + align_up(size, 8);
+    record_header h = { type, (uint32_t)size };
+    memcpy(dest, &h, sizeof(h));
+    memset(dest + sizeof(h) + size, 0, record_size - sizeof(h) - size);
+    index_record(index, motion_indexed, type, dest + sizeof(h), sealed_size, current->record_count);
+    current->size += record_size;
+    ++current->record_count;
+    return true;
+}
+
+bool writer::append(record_type type, const void * header, size_t header_size, const void * data, size_t data_size)
+{
+    return append(type, header_size + data_size, [&](byte * dest)
+    {
+        memcpy(dest, header, header_size);
+        if (data_size) memcpy(dest + header_size, data, data_size);
+        return header_size + data_size;
+    });
+}
+
+bool writer::write_frame(const frame_record & frame, const void * data, size_t size)
+{
+    if (frame.encoding != frame_encoding::rvl) return append(record_type::frame, &frame, sizeof(frame), data, size);
+
+    // Depth is encoded straight into the chunk, which leaves room for the largest encoding, while holding fill_mutex. At about a millisecond
+    // per VGA frame, this keeps up with every stream of the device on the capture threads, without a copy of the frame on the way.
+    const int pixel_count = static_cast<int>(size / sizeof(uint16_t));
+    return append(record_type::frame, sizeof(frame) + rvl_max_encoded_size(pixel_count), [&](byte * dest)
+    {
+        memcpy(dest, &frame, sizeof(frame));
+        return sizeof(frame) + rvl_encode(dest + sizeof(frame), reinterpret_cast<const uint16_t *>(data), pixel_count);
+    });
+}
+
+bool writer::write_motion(const motion_record & motion, const void * data, size_t size)
+{
+    return append(record_type::motion, &motion, sizeof(motion), data, size);
+}
+
+void writer::seal_current()
+{
+    chunk_header h = { chunk_magic, format_version, (uint32_t)current->size, current->record_count };
+    memcpy(current->data, &h, sizeof(h));
+    memset(current->data + current->size, 0, align_up(current->size, chunk_alignment) - current->size);
+    sealed_size += align_up(current->size, chunk_alignment);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        full_chunks.push_back(current);
+    }
+    cv.notify_one();
+    current = nullptr;
+}
+
+void writer::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        cv.wait(lock, [this]() { return closing || !full_chunks.empty(); });
+        if (full_chunks.empty()) return;
+        auto c = full_chunks.front();
+        full_chunks.pop_front();
+        auto failed = !error.empty();
+        lock.unlock();
+
+        if (!failed)
+        {
+            try
+            {
+                auto size = align_up(c->size, chunk_alignment);
+                output->write(c->data, size);
+                written += size;
+            }
+            catch (const std::exception & e)
+            {
+                LOG_ERROR("Recording stopped: " << e.what());
+                lock.lock();
+                error = e.what();
+                lock.unlock();
+            }
+        }
+
+        lock.lock();
+        free_chunks.push_back(c);
+        chunk_freed.notify_one();
+    }
+}
+
+void writer::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(fill_mutex);
+        if (!accepting) return;
+        accepting = false;
+        if (current && current->record_count) seal_current();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    cv.notify_one();
+    thread.join();
+
+    if (error.empty()) write_index();
+    output->close();
+    if (!error.empty()) throw std::runtime_error(error);
+}
+
+void writer::write_index()
+{
+    // Index records hold up to a few megabytes of entries each, all in one chunk, which is followed by the trailer
+    const size_t entries_per_record = 1 << 16;
+    const size_t record_count = (index.size() + entries_per_record - 1) / entries_per_record;
+    const size_t index_size = sizeof(chunk_header) + record_count * sizeof(record_header) + index.size() * sizeof(index_entry);
+    if (index_size > UINT32_MAX)
+    {
+        LOG_WARNING("Recording is too long to be indexed, it will be scanned to seek");
+        return;
+    }
+
+    const size_t size = align_up(index_size, chunk_alignment) + chunk_alignment;
+    std::vector<byte> memory(size + chunk_alignment);
+    auto data = memory.data() + (chunk_alignment - (reinterpret_cast<uintptr_t>(memory.data()) % chunk_alignment)) % chunk_alignment;
+    const chunk_header index_header = { chunk_magic, format_version, static_cast<uint32_t>(index_size), static_cast<uint32_t>(record_count) };
+    memcpy(data, &index_header, sizeof(index_header));
+    size_t offset = sizeof(index_header);
+    for (size_t i = 0; i < index.size(); i += entries_per_record)
+    {
+        const size_t count = std::min(entries_per_record, index.size() - i);
+        const record_header h = { record_type::index, static_cast<uint32_t>(count * sizeof(index_entry)) };
+        memcpy(data + offset, &h, sizeof(h));
+        memcpy(data + offset + sizeof(h), index.data() + i, count * sizeof(index_entry));
+        offset += sizeof(h) + count * sizeof(index_entry);
+    }
+
+    auto trailer = data + align_up(index_size, chunk_alignment);
+    const chunk_header trailer_header = { chunk_magic, format_version, sizeof(chunk_header) + sizeof(record_header) + sizeof(trailer_record), 1 };
+    const record_header h = { record_type::trailer, sizeof(trailer_record) };
+    const trailer_record t = { sealed_size, index.size() };
+    memcpy(trailer, &trailer_header, sizeof(trailer_header));
+    memcpy(trailer + sizeof(trailer_header), &h, sizeof(h));
+    memcpy(trailer + sizeof(trailer_header) + sizeof(h), &t, sizeof(t));
+
+    output->write(data, size);
+    written += size;
+}
+
+// How far ahead of a mapped reader pages of the recording are read, about a second of a few cameras
+static const size_t read_ahead = 64 << 20;
+
+#ifdef _WIN32
+mapped_file::mapped_file(const std::string & path) : data(nullptr), size(0), file(INVALID_HANDLE_VALUE), mapping(nullptr)
+{
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error(to_string() << "could not open recording " << path << ", error " << GetLastError());
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || (unsigned long long)file_size.QuadPart > SIZE_MAX)
+    {
+        CloseHandle(file);
+        throw std::runtime_error(to_string() << "recording " << path << " is too large to be mapped");
+    }
+    size = static_cast<size_t>(file_size.QuadPart);
+    if (!size) return;
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) data = static_cast<const byte *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!data)
+    {
+        auto error = GetLastError();
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error(to_string() << "could not map recording " << path << ", error " << error);
+    }
+}
+
+mapped_file::~mapped_file()
+{
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+}
+
+void mapped_file::prefetch(size_t offset, size_t length) const {} // FILE_FLAG_SEQUENTIAL_SCAN already reads ahead
+#else
+mapped_file::mapped_file(const std::string & path) : data(nullptr), size(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error(to_string() << "could not open recording " << path << ", error " << errno);
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (unsigned long long)st.st_size > SIZE_MAX)
+    {
+        ::close(fd);
+        throw std::runtime_error(to_string() << "recording " << path << " is too large to be mapped");
+    }
+    size = static_cast<size_t>(st.st_size);
+    if (size)
+    {
+        auto address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            auto error = errno;
+            ::close(fd);
+            throw std::runtime_error(to_string() << "could not map recording " << path << ", error " << error);
+        }
+        data = static_cast<const byte *>(address);
+        madvise(address, size, MADV_SEQUENTIAL);
+    }
+    ::close(fd); // The mapping keeps the file open
+}
+
+mapped_file::~mapped_file()
+{
+    if (data) munmap(const_cast<byte *>(data), size);
+}
+
+void mapped_file::prefetch(size_t offset, size_t length) const
+{
+    if (offset >= size) return;
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t begin = offset / page * page, end = std::min(offset + length, size);
+    madvise(const_cast<byte *>(data) + begin, end - begin, MADV_WILLNEED);
+}
+#endif
+
+reader::reader(const std::string & path) : current_chunk(0), next_chunk(0), input(new std::ifstream(path, std::ios::binary)), header(), records(nullptr), offset(0), remaining(0)
+{
+    if (!*input) throw std::runtime_error(to_string() << "could not open recording " << path);
+}
+
+reader::reader(const std::vector<byte> & chunks) : current_chunk(0), next_chunk(0), input(new std::istringstream(std::string(chunks.begin(), chunks.end()), std::ios::binary)),
+    header(), records(nullptr), offset(0), remaining(0)
+{
+}
+
+reader::reader(std::shared_ptr<const mapped_file> mapping) : mapping(mapping), current_chunk(0), next_chunk(0), header(), records(nullptr), offset(0), remaining(0)
+{
+    mapping->prefetch(0, read_ahead);
+}
+
+bool reader::next_chunk_header()
+{
+    if (mapping)
+    {
+        if (mapping->get_size() < next_chunk + sizeof(header)) return false;
+        memcpy(&header, mapping->get_data() + next_chunk, sizeof(header));
+    }
+    else if (!input->read(reinterpret_cast<char *>(&header), sizeof(header))) return false;
+    if (header.magic != chunk_magic || header.version != format_version || header.size < sizeof(header)) throw std::runtime_error("not a recording, or a recording of an unsupported version");
+
+    const size_t body_size = align_up(header.size, chunk_alignment) - sizeof(header);
+    current_chunk = next_chunk;
+    next_chunk += sizeof(header) + body_size;
+    if (mapping)
+    {
+        if (mapping->get_size() - current_chunk - sizeof(header) < body_size) throw std::runtime_error("recording is truncated");
+        records = mapping->get_data() + current_chunk + sizeof(header);
+        mapping->prefetch(static_cast<size_t>(current_chunk) + read_ahead, sizeof(header) + body_size); // Keeps read_ahead bytes in flight
+    }
+    else
+    {
+        chunk.resize(body_size);
+        if (!input->read(reinterpret_cast<char *>(chunk.data()), chunk.size())) throw std::runtime_error("recording is truncated");
+        records = chunk.data();
+    }
+    offset = 0;
+    remaining = header.record_count;
+    return true;
+}
+
+bool reader::next(record & r)
+{
+    while (read_record(r)) if (r.type != record_type::index && r.type != record_type::trailer) return true;
+    return false;
+}
+
+bool reader::read_record(record & r)
+{
+    while (!remaining) if (!next_chunk_header()) return false;
+
+    record_header h;
+    if (offset + sizeof(h) > header.size - sizeof(header)) throw std::runtime_error("recording is corrupted");
+    memcpy(&h, records + offset, sizeof(h));
+    if (offset + sizeof(h) + h.size > header.size - sizeof(header)) throw std::runtime_error("recording is corrupted");
+
+    r.type = h.type;
+    r.payload = records + offset + sizeof(h);
+    r.size = h.size;
+    offset += sizeof(h) + align_up(h.size, 8);
+    --remaining;
+    return true;
+}
+
+void reader::rewind()
+{
+    if (mapping) mapping->prefetch(0, read_ahead);
+    else
+    {
+        input->clear();
+        input->seekg(0);
+    }
+    next_chunk = 0;
+    remaining = 0;
+}
+
+bool reader::read_trailer(trailer_record & trailer)
+{
+    uint64_t size;
+    if (mapping) size = mapping->get_size();
+    else
+    {
+        input->clear();
+        input->seekg(0, std::ios::end);
+        size = static_cast<uint64_t>(input->tellg());
+    }
+    if (size < chunk_alignment || size % chunk_alignment) return false;
+
+    byte last[sizeof(chunk_header) + sizeof(record_header) + sizeof(trailer_record)];
+    if (mapping) memcpy(last, mapping->get_data() + mapping->get_size() - chunk_alignment, sizeof(last));
+    else if (!input->seekg(static_cast<std::streamoff>(size - chunk_alignment)) || !input->read(reinterpret_cast<char *>(last), sizeof(last))) return false;
+
+    chunk_header c;
+    record_header h;
+    memcpy(&c, last, sizeof(c));
+    memcpy(&h, last + sizeof(c), sizeof(h));
+    memcpy(&trailer, last + sizeof(c) + sizeof(h), sizeof(trailer));
+    return c.magic == chunk_magic && c.version == format_version && c.record_count == 1 && h.type == record_type::trailer && h.size == sizeof(trailer)
+        && trailer.index_offset < size - chunk_alignment;
+}
+
+std::vector<index_entry> reader::read_index()
+{
+    std::vector<index_entry> index;
+    trailer_record trailer;
+    record r;
+    if (read_trailer(trailer))
+    {
+        next_chunk = trailer.index_offset;
+        if (!mapping)
+        {
+            input->clear();
+            input->seekg(static_cast<std::streamoff>(trailer.index_offset));
+        }
+        remaining = 0;
+        if (!next_chunk_header()) throw std::runtime_error("index of the recording is truncated");
+        while (remaining && read_record(r))
+        {
+            if (r.type != record_type::index || r.size % sizeof(index_entry)) throw std::runtime_error("index of the recording is corrupted");
+            const size_t count = index.size();
+            index.resize(count + r.size / sizeof(index_entry));
+            memcpy(index.data() + count, r.payload, r.size);
+        }
+        if (index.size() != trailer.entry_count) throw std::runtime_error("index of the recording is corrupted");
+    }
+    else
+    {
+        // The recording was not closed, its records are scanned for their entries
+        rewind();
+        bool motion_indexed = false;
+        while (next(r)) index_record(index, motion_indexed, r.type, r.payload, current_chunk, header.record_count - remaining - 1);
+    }
+    rewind();
+    return index;
+}
+
+void reader::seek(const index_entry & entry)
+{
+    if (mapping) mapping->prefetch(static_cast<size_t>(std::min<uint64_t>(entry.chunk_offset, mapping->get_size())), read_ahead);
+    else
+    {
+        input->clear();
+        input->seekg(static_cast<std::streamoff>(entry.chunk_offset));
+    }
+    next_chunk = entry.chunk_offset;
+    remaining = 0;
+    if (!next_chunk_header() || entry.record >= remaining) throw std::runtime_error("index of the recording does not match its records");
+
+    record r;
+    for (uint32_t i = 0; i < entry.record; ++i) read_record(r);
+}
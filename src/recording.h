@@ -0,0 +1,238 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_RECORDING_H
+#define LIBREALSENSE_RECORDING_H
+
+#include "types.h"
+
+#include <deque>
+#include <thread>
+#include <fstream>
+
+namespace rsimpl
+{
+    // A recording is a sequence of chunks, each a chunk_header followed by records and padded to a multiple of chunk_alignment bytes, so that chunks
+    // can be written straight from aligned memory, bypassing the page cache. Every record is a record_header followed by the payload of its type,
+    // padded to a multiple of 8 bytes. Frames keep the native format they were captured in, before unpacking, and motion data keeps the raw transfers
+    // of the data channel, so that replaying a recording goes through the same unpacking and parsing as live capture. A recording which was closed
+    // ends with an index of its records, in a chunk of index records, followed by a last chunk of a single trailer record locating it, so that
+    // readers find any frame without scanning the recording.
+    namespace recording
+    {
+        const uint32_t chunk_magic = 0x4b435352;    // "RSCK"
+        const uint32_t format_version = 1;
+        const size_t chunk_alignment = 4096;
+
+        enum class record_type : uint32_t { device = 1, mode = 2, stream = 3, frame = 4, motion = 5, index = 6, trailer = 7 };
+        enum class frame_encoding : int32_t { raw = 0, rvl = 1 }; // Z16 frames are recorded through the lossless codec of depth-codec.h
+
+        struct chunk_header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t size;                      // Bytes of the chunk up to its padding, header included
+            uint32_t record_count;
+        };
+
+        struct record_header
+        {
+            record_type type;
+            uint32_t size;                      // Bytes of the payload, before its padding
+        };
+
+        struct device_record                    // First record of a recording
+        {
+            char name[64];
+            char serial[32];
+            char firmware_version[32];
+            char adapter_board_firmware_version[32]; // Empty for cameras without an adapter board
+        };
+
+        struct mode_record                      // Written for every subdevice mode before the first of its frames
+        {
+            int32_t subdevice;
+            int32_t width, height;              // Native dimensions advertised over UVC
+            uint32_t fourcc;
+            int32_t fps;
+            int32_t pad_crop;
+            rs_intrinsics native_intrinsics;
+        };
+
+        struct stream_record                    // Written for every enabled native stream along with the modes
+        {
+            rs_stream stream;
+            rs_format format;
+            int32_t fps;
+            rs_intrinsics intrinsics;
+            rs_extrinsics extrinsics_to_depth;
+            float depth_scale;
+        };
+
+        struct frame_record                     // Followed by the native frame, as encoded
+        {
+            int32_t subdevice;
+            frame_encoding encoding;
+            double timestamp;
+            uint64_t frame_counter;
+            int64_t system_time;
+            double exposure_value;
+            double actual_fps;
+        };
+
+        struct motion_record                    // Followed by a transfer of the data channel
+        {
+            int32_t subdevice;
+            int32_t reserved;
+            int64_t system_time;
+        };
+
+        struct index_entry                      // Locates a record, every record being indexed but the motion records after the first
+        {
+            uint64_t chunk_offset;              // Of the chunk holding the record, from the start of the recording
+            uint32_t record;                    // Of the record within its chunk
+            record_type type;
+            int32_t subdevice;                  // Of mode, frame and motion records
+            int32_t reserved;
+            double timestamp;                   // Of frame records
+            uint64_t frame_counter;             // Of frame records
+        };                                      // Index records are arrays of index_entry, in the order of the records
+
+        struct trailer_record                   // Sole record of the last chunk of a recording, which is chunk_alignment bytes long
+        {
+            uint64_t index_offset;              // Of the chunk of index records
+            uint64_t entry_count;
+        };
+
+        struct mode_description                 // A mode along with the streams unpacked from it, as written before its frames
+        {
+            mode_record mode;
+            std::vector<stream_record> streams;
+        };
+
+        struct record
+        {
+            record_type type;
+            const byte * payload;
+            size_t size;
+        };
+
+        // Writes a recording from a thread of its own, so that recording a frame is only a copy into a chunk of a bounded pool. When the writer
+        // falls behind and every chunk is waiting to be written, frames are dropped from the recording rather than waiting for the disk, unless
+        // the writer was made lossless, for recordings written from memory rather than from capture.
+        class writer
+        {
+            struct chunk
+            {
+                std::vector<byte> memory;
+                byte * data;                    // Aligned to chunk_alignment within memory
+                size_t size;
+                uint32_t record_count;
+            };
+            class file;
+
+            const size_t chunk_size;
+            const bool lossless;                // Waits for a free chunk rather than dropping records
+            std::unique_ptr<file> output;
+            std::vector<chunk> chunks;
+
+            std::mutex fill_mutex;              // Serializes the capture threads appending records to the current chunk
+            chunk * current;                    // Guarded by fill_mutex, null while every chunk waits to be written
+            bool accepting;                     // Guarded by fill_mutex, cleared once the writer closes
+
+            std::mutex mutex;                   // Guards the members below
+            std::condition_variable cv;
+            std::condition_variable chunk_freed; // Wakes a lossless writer waiting for a chunk
+            std::deque<chunk *> free_chunks;
+            std::deque<chunk *> full_chunks;
+            bool closing;
+            std::string error;                  // First error of the writer thread, which stops writing from then on
+
+            std::atomic<uint64_t> dropped;
+            std::atomic<uint64_t> written;
+            std::vector<index_entry> index;     // Guarded by fill_mutex, of the records appended so far
+            bool motion_indexed;                // Guarded by fill_mutex
+            uint64_t sealed_size;               // Guarded by fill_mutex, offset of the current chunk in the file once written
+            std::thread thread;
+
+            writer(const writer &) = delete;
+            writer & operator=(const writer &) = delete;
+
+            // Appends a record of at most max_size bytes of payload, write_payload(dest) copying it to dest and returning its actual size
+            template<class F> bool append(record_type type, size_t max_size, F write_payload);
+            bool append(record_type type, const void * header, size_t header_size, const void * data, size_t data_size);
+            void seal_current();                // Requires fill_mutex
+            void run();
+            void write_index();                 // Once the writer thread is done
+        public:
+            writer(const std::string & path, size_t chunk_size, int chunk_count, bool lossless = false); // chunk_size is rounded up to chunk_alignment
+            ~writer();
+
+            // Return false when the record is dropped, because no chunk is free or the record does not fit in one
+            bool write_device(const device_record & device) { return append(record_type::device, &device, sizeof(device), nullptr, 0); }
+            bool write_mode(const mode_record & mode) { return append(record_type::mode, &mode, sizeof(mode), nullptr, 0); }
+            bool write_stream(const stream_record & stream) { return append(record_type::stream, &stream, sizeof(stream), nullptr, 0); }
+            bool write_frame(const frame_record & frame, const void * data, size_t size); // size is that of the raw frame, whatever its encoding
+            bool write_encoded_frame(const frame_record & frame, const void * data, size_t size) { return append(record_type::frame, &frame, sizeof(frame), data, size); } // data already in the encoding of frame
+            bool write_motion(const motion_record & motion, const void * data, size_t size);
+
+            uint64_t get_dropped_count() const { return dropped; }  // Frames and motion transfers left out of the recording
+            uint64_t get_written_bytes() const { return written; }  // Bytes which reached the file so far
+            void close(); // Writes the chunks still pending and the index, and closes the file, throwing the first error of the writer thread if any
+        };
+
+        // A whole recording mapped read only into memory, which stays mapped as long as any copy of the shared_ptr holding it lives. The
+        // kernel is told that the mapping is read sequentially, so that pages are read ahead of the reader and dropped soon after.
+        class mapped_file
+        {
+            const byte * data;
+            size_t size;
+#ifdef _WIN32
+            void * file, * mapping;
+#endif
+            mapped_file(const mapped_file &) = delete;
+            mapped_file & operator=(const mapped_file &) = delete;
+        public:
+            explicit mapped_file(const std::string & path); // Throws when the file cannot be mapped, for instance for lack of address space
+            ~mapped_file();
+
+            const byte * get_data() const { return data; }
+            size_t get_size() const { return size; }
+            void prefetch(size_t offset, size_t length) const; // Starts reading a range of the file in the background, clamped to the file
+        };
+
+        // Reads the records of a recording in order. A reader of a mapped_file hands out payloads pointing into the mapping, which stay valid
+        // as long as the mapping, while a reader of a path or of chunks held in memory copies every chunk into a buffer of its own, payloads
+        // staying valid until the next record is read.
+        class reader
+        {
+            std::shared_ptr<const mapped_file> mapping; // Null when reading through buffered I/O
+            uint64_t current_chunk;             // Offset of the current chunk in the recording
+            uint64_t next_chunk;                // Offset of the next chunk in the recording
+            std::unique_ptr<std::istream> input;
+            std::vector<byte> chunk;
+            chunk_header header;
+            const byte * records;               // Records of the current chunk, in chunk or in mapping
+            size_t offset;                      // Of the next record in records
+            uint32_t remaining;                 // Records left in the current chunk
+
+            bool next_chunk_header();           // Returns false at the end of the recording
+            bool read_trailer(trailer_record & trailer); // Returns false when the recording has none
+            bool read_record(record & r);       // As next, index and trailer records included
+        public:
+            explicit reader(const std::string & path);
+            explicit reader(std::shared_ptr<const mapped_file> mapping);
+            explicit reader(const std::vector<byte> & chunks);
+
+            bool next(record & r);              // Returns false at the end of the recording, leaving out the index
+            void rewind();
+
+            // Returns the index of the recording, from its end, or by scanning the records of recordings which were not closed. Rewinds the reader.
+            std::vector<index_entry> read_index();
+            void seek(const index_entry & entry); // The next record read is that of the entry
+        };
+    }
+}
+
+#endif
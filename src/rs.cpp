@@ -8,6 +8,13 @@
 #include "device.h"
 #include "sync.h"
 #include "archive.h"
+#include "image.h"
+#include "calibration-store.h"
+#include "multi-sync.h"
+#include "bandwidth-planner.h"
+#include "depth-codec.h"
+#include "network.h"
+#include "trace.h"
 
 ////////////////////////
 // API implementation //
@@ -45,6 +52,7 @@ namespace rsimpl
 #define VALIDATE_RANGE(ARG, MIN, MAX) if((ARG) < (MIN) || (ARG) > (MAX)) { std::ostringstream ss; ss << "out of range value for argument \"" #ARG "\""; throw std::runtime_error(ss.str()); }
 #define VALIDATE_LE(ARG, MAX) if((ARG) > (MAX)) { std::ostringstream ss; ss << "out of range value for argument \"" #ARG "\""; throw std::runtime_error(ss.str()); }
 #define VALIDATE_NATIVE_STREAM(ARG) VALIDATE_ENUM(ARG); if(ARG >= RS_STREAM_NATIVE_COUNT) { std::ostringstream ss; ss << "argument \"" #ARG "\" must be a native stream"; throw std::runtime_error(ss.str()); }
+#define VALIDATE_CONFIGURABLE_STREAM(ARG) VALIDATE_ENUM(ARG); if(ARG >= RS_STREAM_NATIVE_COUNT && ARG != RS_STREAM_POINTS) { std::ostringstream ss; ss << "argument \"" #ARG "\" must be a native stream or points"; throw std::runtime_error(ss.str()); }
 
 int major(int version)
 {
@@ -125,6 +133,43 @@ rs_device * rs_get_device(rs_context * context, int index, rs_error ** error) tr
 }
 HANDLE_EXCEPTIONS_AND_RETURN(nullptr, context, index)
 
+void rs_set_devices_changed_callback(rs_context * context, rs_devices_changed_callback_ptr on_change, void * user, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(context);
+    context->set_devices_changed_callback(on_change ? new rsimpl::devices_changed_callback(on_change, user) : nullptr);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, context, on_change, user)
+
+void rs_set_devices_changed_callback_cpp(rs_context * context, rs_devices_changed_callback * callback, rs_error ** error) try
+{
+    std::unique_ptr<rs_devices_changed_callback, void(*)(rs_devices_changed_callback *)> owner(callback, [](rs_devices_changed_callback * c) { if (c) c->release(); });
+    VALIDATE_NOT_NULL(context);
+    context->set_devices_changed_callback(owner.release());
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, context, callback)
+
+void rs_set_executor_threads(rs_context * context, int count, unsigned long long cpu_mask, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(context);
+    VALIDATE_RANGE(count, 1, 64);
+    context->set_executor_threads(count, cpu_mask);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, context, count, cpu_mask)
+
+int rs_get_executor_thread_count(const rs_context * context, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(context);
+    return context->get_executor_thread_count();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, context)
+
+unsigned long long rs_get_executor_cpu_mask(const rs_context * context, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(context);
+    return context->get_executor_cpu_mask();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, context)
+
 const char * rs_get_device_name(const rs_device * device, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device);
@@ -207,7 +252,7 @@ HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, index, width, height, format, fra
 void rs_enable_stream_ex(rs_device * device, rs_stream stream, int width, int height, rs_format format, int framerate, rs_output_buffer_format output, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device);
-    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_CONFIGURABLE_STREAM(stream);
     VALIDATE_RANGE(width, 0, INT_MAX);
     VALIDATE_RANGE(height, 0, INT_MAX);
     VALIDATE_ENUM(format);
@@ -220,7 +265,7 @@ HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, width, height, format, framerate)
 void rs_enable_stream(rs_device * device, rs_stream stream, int width, int height, rs_format format, int framerate, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device);
-    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_CONFIGURABLE_STREAM(stream);
     VALIDATE_RANGE(width, 0, INT_MAX);
     VALIDATE_RANGE(height, 0, INT_MAX);
     VALIDATE_ENUM(format);
@@ -241,11 +286,34 @@ HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, preset)
 void rs_disable_stream(rs_device * device, rs_stream stream, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device);
-    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_CONFIGURABLE_STREAM(stream);
     device->disable_stream(stream);
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, device, stream)
 
+void rs_set_stream_roi(rs_device * device, rs_stream stream, int x, int y, int width, int height, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_ENUM(stream);
+    VALIDATE_RANGE(stream, RS_STREAM_NATIVE_COUNT, RS_STREAM_COUNT - 1);
+    VALIDATE_RANGE(x, 0, INT_MAX);
+    VALIDATE_RANGE(y, 0, INT_MAX);
+    VALIDATE_RANGE(width, 0, INT_MAX);
+    VALIDATE_RANGE(height, 0, INT_MAX);
+    device->set_stream_roi(stream, x, y, width, height);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, x, y, width, height)
+
+void rs_set_stream_decimation(rs_device * device, rs_stream stream, int factor, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_ENUM(stream);
+    VALIDATE_RANGE(stream, RS_STREAM_NATIVE_COUNT, RS_STREAM_COUNT - 1);
+    VALIDATE_RANGE(factor, 1, RS_MAX_DEPTH_DECIMATION);
+    device->set_stream_decimation(stream, factor);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, factor)
+
 int rs_is_stream_enabled(const rs_device * device, rs_stream stream, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device);
@@ -254,6 +322,297 @@ int rs_is_stream_enabled(const rs_device * device, rs_stream stream, rs_error **
 }
 HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream)
 
+void rs_set_stream_queue_policy(rs_device * device, rs_stream stream, int depth, rs_frame_drop_policy policy, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_RANGE(depth, 1, RS_MAX_STREAM_QUEUE_DEPTH);
+    VALIDATE_ENUM(policy);
+    device->set_stream_queue_policy(stream, depth, policy);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, depth, policy)
+
+int rs_get_stream_queue_depth(const rs_device * device, rs_stream stream, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    int depth; rs_frame_drop_policy policy;
+    device->get_stream_queue_policy(stream, depth, policy);
+    return depth;
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream)
+
+rs_frame_drop_policy rs_get_stream_drop_policy(const rs_device * device, rs_stream stream, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    int depth; rs_frame_drop_policy policy;
+    device->get_stream_queue_policy(stream, depth, policy);
+    return policy;
+}
+HANDLE_EXCEPTIONS_AND_RETURN(RS_FRAME_DROP_POLICY_COUNT, device, stream)
+
+void rs_set_stream_capture_dmabufs(rs_device * device, rs_stream stream, const int * fds, int count, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    if(count != 0)
+    {
+        VALIDATE_RANGE(count, 2, RS_MAX_CAPTURE_BUFFERS);
+        VALIDATE_NOT_NULL(fds);
+    }
+    device->set_stream_capture_dmabufs(stream, fds, count);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, fds, count)
+
+void rs_set_stream_capture_buffer_count(rs_device * device, rs_stream stream, int count, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_RANGE(count, 0, RS_MAX_CAPTURE_BUFFERS);
+    device->set_stream_capture_buffer_count(stream, count);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, count)
+
+int rs_get_stream_capture_buffer_count(const rs_device * device, rs_stream stream, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    return device->get_stream_capture_buffer_count(stream);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream)
+
+void rs_set_stream_crop(rs_device * device, rs_stream stream, int x, int y, int width, int height, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    device->set_stream_crop(stream, x, y, width, height);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, x, y, width, height)
+
+int rs_is_stream_cropped_in_driver(const rs_device * device, rs_stream stream, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    return device->is_stream_cropped_in_driver(stream) ? 1 : 0;
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream)
+
+void rs_set_stream_frame_buffers(rs_device * device, rs_stream stream, void * const buffers[], int count, int buffer_size, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_RANGE(count, 0, RS_MAX_FRAME_BUFFERS);
+    if (count)
+    {
+        VALIDATE_NOT_NULL(buffers);
+        for (int i = 0; i < count; ++i) VALIDATE_NOT_NULL(buffers[i]);
+        VALIDATE_RANGE(buffer_size, 1, INT_MAX);
+    }
+    device->set_stream_frame_buffers(stream, buffers, count, buffer_size);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, buffers, count, buffer_size)
+
+void rs_set_stream_callback_queue(rs_device * device, rs_stream stream, int depth, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_RANGE(depth, 0, RS_MAX_STREAM_QUEUE_DEPTH);
+    device->set_stream_callback_queue(stream, depth);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, depth)
+
+int rs_get_stream_callback_queue_depth(const rs_device * device, rs_stream stream, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    return device->get_stream_callback_queue_depth(stream);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream)
+
+unsigned long long rs_get_stream_callback_drops(const rs_device * device, rs_stream stream, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    return device->get_stream_callback_drops(stream);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream)
+
+int rs_add_frame_subscriber(rs_device * device, rs_stream stream, rs_frame_callback_ptr on_frame, void * user, int depth, rs_frame_drop_policy policy, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_NOT_NULL(on_frame);
+    VALIDATE_RANGE(depth, 0, RS_MAX_STREAM_QUEUE_DEPTH);
+    VALIDATE_ENUM(policy);
+    return device->add_frame_subscriber(stream, new rsimpl::frame_callback(device, on_frame, user), depth, policy);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream, on_frame, user, depth, policy)
+
+int rs_add_frame_subscriber_cpp(rs_device * device, rs_stream stream, rs_frame_callback * callback, int depth, rs_frame_drop_policy policy, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_NOT_NULL(callback);
+    VALIDATE_RANGE(depth, 0, RS_MAX_STREAM_QUEUE_DEPTH);
+    VALIDATE_ENUM(policy);
+    return device->add_frame_subscriber(stream, callback, depth, policy);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream, callback, depth, policy)
+
+void rs_remove_frame_subscriber(rs_device * device, rs_stream stream, int subscriber, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    device->remove_frame_subscriber(stream, subscriber);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, subscriber)
+
+unsigned long long rs_get_frame_subscriber_drops(const rs_device * device, rs_stream stream, int subscriber, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    return device->get_frame_subscriber_drops(stream, subscriber);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream, subscriber)
+
+void rs_set_stream_idle_timeout(rs_device * device, rs_stream stream, int milliseconds, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_RANGE(milliseconds, 0, RS_MAX_STREAM_IDLE_TIMEOUT);
+    device->set_stream_idle_timeout(stream, milliseconds);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, milliseconds)
+
+int rs_get_stream_idle_timeout(const rs_device * device, rs_stream stream, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    return device->get_stream_idle_timeout(stream);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream)
+
+void rs_set_stream_sync_tolerance(rs_device * device, rs_stream stream, double milliseconds, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_RANGE(milliseconds, 0, RS_MAX_STREAM_SYNC_TOLERANCE);
+    device->set_stream_sync_tolerance(stream, milliseconds);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, milliseconds)
+
+double rs_get_stream_sync_tolerance(const rs_device * device, rs_stream stream, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    return device->get_stream_sync_tolerance(stream);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream)
+
+int rs_is_stream_idle(const rs_device * device, rs_stream stream, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    return device->is_stream_idle(stream);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream)
+
+void rs_get_stream_latency_histogram(const rs_device * device, rs_stream stream, rs_frame_metadata stage, unsigned long long counts[], rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_RANGE(stage, RS_FRAME_METADATA_TIME_OF_VALIDATION, RS_FRAME_METADATA_TIME_OF_DELIVERY);
+    VALIDATE_NOT_NULL(counts);
+    device->get_stream_latency_histogram(stream, stage, counts);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, stage, counts)
+
+void rs_get_stream_exposure_latency_histogram(const rs_device * device, rs_stream stream, unsigned long long counts[], rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_NOT_NULL(counts);
+    device->get_stream_exposure_latency_histogram(stream, counts);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, counts)
+
+void rs_reset_latency_histograms(rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    device->reset_latency_histograms();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device)
+
+unsigned long long rs_get_stream_metric(const rs_device * device, rs_stream stream, rs_stream_metric metric, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_ENUM(metric);
+    return device->get_stream_metric(stream, metric);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream, metric)
+
+unsigned long long rs_get_transfer_statistic(const rs_device * device, rs_stream stream, rs_transfer_statistic statistic, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_ENUM(statistic);
+    return device->get_transfer_statistic(stream, statistic);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream, statistic)
+
+void rs_set_load_shedding(rs_device * device, const rs_load_shedding_action actions[], int count, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_RANGE(count, 0, RS_LOAD_SHEDDING_ACTION_COUNT);
+    if (count)
+    {
+        VALIDATE_NOT_NULL(actions);
+        for (int i = 0; i < count; ++i) VALIDATE_ENUM(actions[i]);
+    }
+    device->set_load_shedding(actions, count);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, actions, count)
+
+int rs_get_load_shedding_level(const rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    return device->get_load_shedding_level();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device)
+
+void rs_get_memory_usage(const rs_device * device, unsigned long long * current, unsigned long long * peak, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(current);
+    VALIDATE_NOT_NULL(peak);
+    device->get_memory_usage(*current, *peak);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, current, peak)
+
+void rs_set_memory_budget(rs_device * device, unsigned long long bytes, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    device->set_memory_budget(bytes);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, bytes)
+
+unsigned long long rs_get_memory_budget(const rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    return device->get_memory_budget();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device)
+
+void rs_export_fw_log(const rs_device * device, const char * file_path, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(file_path);
+    device->export_fw_log(file_path);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, file_path)
+
 int rs_get_stream_width(const rs_device * device, rs_stream stream, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device);
@@ -291,35 +650,245 @@ void rs_get_stream_intrinsics(const rs_device * device, rs_stream stream, rs_int
     VALIDATE_NOT_NULL(device);
     VALIDATE_ENUM(stream);
     VALIDATE_NOT_NULL(intrin);
-    *intrin = device->get_stream_interface(stream).get_intrinsics();
+    *intrin = device->get_stream_interface(stream).get_intrinsics();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, intrin)
+
+void rs_get_depth_pyramid_intrinsics(const rs_device * device, int level, rs_intrinsics * intrin, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_RANGE(level, 0, RS_MAX_DEPTH_PYRAMID_LEVELS);
+    VALIDATE_NOT_NULL(intrin);
+    *intrin = rsimpl::decimate_intrinsics(device->get_stream_interface(RS_STREAM_DEPTH).get_intrinsics(), 1 << level);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, level, intrin)
+
+void rs_get_motion_intrinsics(const rs_device * device, rs_motion_intrinsics * intrinsic, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(intrinsic);
+    *intrinsic = device->get_motion_intrinsics();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, intrinsic)
+
+void rs_set_frame_callback(rs_device * device, rs_stream stream, rs_frame_callback_ptr on_frame, void * user, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_NOT_NULL(on_frame);
+    device->set_stream_callback(stream, on_frame, user);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, on_frame, user)
+
+void rs_set_frame_callback_cpp(rs_device * device, rs_stream stream, rs_frame_callback * callback, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    VALIDATE_NOT_NULL(callback);
+    device->set_stream_callback(stream, callback);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, callback)
+
+void rs_set_stream_slice_callback(rs_device * device, rs_stream stream, int rows_per_slice, rs_slice_callback_ptr on_slice, void * user, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    if (on_slice) VALIDATE_RANGE(rows_per_slice, 1, RS_MAX_SLICE_ROWS);
+    device->set_stream_slice_callback(stream, rows_per_slice, on_slice, user);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, rows_per_slice, on_slice, user)
+
+void rs_set_stream_slice_callback_cpp(rs_device * device, rs_stream stream, int rows_per_slice, rs_slice_callback * callback, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    if (callback) VALIDATE_RANGE(rows_per_slice, 1, RS_MAX_SLICE_ROWS);
+    device->set_stream_slice_callback(stream, rows_per_slice, callback);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, rows_per_slice, callback)
+
+void rs_set_stream_encoder(rs_device * device, rs_stream stream, int bitrate, rs_encoded_packet_callback_ptr on_packet, void * user, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    if (on_packet) VALIDATE_RANGE(bitrate, RS_MIN_ENCODER_BITRATE, RS_MAX_ENCODER_BITRATE);
+    device->set_stream_encoder(stream, bitrate, on_packet, user);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, bitrate, on_packet, user)
+
+void rs_set_stream_encoder_cpp(rs_device * device, rs_stream stream, int bitrate, rs_encoded_packet_callback * callback, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    if (callback) VALIDATE_RANGE(bitrate, RS_MIN_ENCODER_BITRATE, RS_MAX_ENCODER_BITRATE);
+    device->set_stream_encoder(stream, bitrate, callback);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, bitrate, callback)
+
+void rs_set_frameset_callback(rs_device * device, rs_frameset_callback_ptr on_frameset, void * user, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    device->set_frameset_callback(on_frameset, user);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, on_frameset, user)
+
+void rs_set_frameset_callback_cpp(rs_device * device, rs_frameset_callback * callback, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(callback);
+    device->set_frameset_callback(callback);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, callback)
+
+// Takes ownership of callback, which is released if the arguments are refused
+static rs_multi_sync * create_multi_sync(rs_device * const * devices, int count, double tolerance, rs_straggler_policy policy, rs_multi_frameset_callback * callback)
+{
+    std::unique_ptr<rs_multi_frameset_callback, void(*)(rs_multi_frameset_callback *)> owner(callback, [](rs_multi_frameset_callback * c) { if (c) c->release(); });
+    VALIDATE_NOT_NULL(devices);
+    VALIDATE_RANGE(count, 1, INT_MAX);
+    for (int i = 0; i < count; ++i) VALIDATE_NOT_NULL(devices[i]);
+    VALIDATE_RANGE(tolerance, 0, 1000);
+    VALIDATE_ENUM(policy);
+    return new rs_multi_sync(std::vector<rs_device *>(devices, devices + count), tolerance, policy, owner.release());
+}
+
+rs_multi_sync * rs_create_multi_sync(rs_device * const * devices, int count, double tolerance, rs_straggler_policy policy, rs_multi_frameset_callback_ptr on_framesets, void * user, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(on_framesets);
+    return create_multi_sync(devices, count, tolerance, policy, new rsimpl::multi_frameset_callback(on_framesets, user));
+}
+HANDLE_EXCEPTIONS_AND_RETURN(nullptr, devices, count, tolerance, policy, on_framesets, user)
+
+rs_multi_sync * rs_create_multi_sync_cpp(rs_device * const * devices, int count, double tolerance, rs_straggler_policy policy, rs_multi_frameset_callback * callback, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(callback);
+    return create_multi_sync(devices, count, tolerance, policy, callback);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(nullptr, devices, count, tolerance, policy, callback)
+
+void rs_delete_multi_sync(rs_multi_sync * sync, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(sync);
+    delete sync;
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, sync)
+
+double rs_get_device_bandwidth(const rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    auto lrs_device = dynamic_cast<const rs_device_base *>(device);
+    if (!lrs_device) throw std::runtime_error("bandwidth can only be estimated for physical devices!");
+    return lrs_device->get_stream_bandwidth() / 1e6;
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device)
+
+void rs_plan_device_modes(rs_device * const * devices, int count, double controller_bandwidth, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(devices);
+    VALIDATE_RANGE(count, 1, INT_MAX);
+    for (int i = 0; i < count; ++i) VALIDATE_NOT_NULL(devices[i]);
+    VALIDATE_RANGE(controller_bandwidth, 1, 100000);
+    std::vector<rs_device_base *> lrs_devices;
+    for (int i = 0; i < count; ++i)
+    {
+        lrs_devices.push_back(dynamic_cast<rs_device_base *>(devices[i]));
+        if (!lrs_devices.back()) throw std::runtime_error("modes can only be planned for physical devices!");
+    }
+    rsimpl::plan_device_modes(lrs_devices, controller_bandwidth * 1e6);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, devices, count, controller_bandwidth)
+
+int rs_fuse_point_clouds(rs_device * const * devices, rs_frame_ref * const * depth_frames, const rs_extrinsics * device_to_rig, int count, float voxel_size, float * points, int capacity, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(devices);
+    VALIDATE_NOT_NULL(depth_frames);
+    VALIDATE_NOT_NULL(device_to_rig);
+    VALIDATE_RANGE(count, 1, INT_MAX);
+    VALIDATE_RANGE(voxel_size, 0, 1000);
+    VALIDATE_NOT_NULL(points);
+    for (int i = 0; i < count; ++i)
+    {
+        VALIDATE_NOT_NULL(devices[i]);
+        VALIDATE_NOT_NULL(depth_frames[i]);
+    }
+    std::vector<rsimpl::fused_depth_image> images;
+    std::vector<std::shared_ptr<const std::vector<float>>> rays; // Held until the points are written
+    long long pixels = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        auto lrs_device = dynamic_cast<const rs_device_base *>(devices[i]);
+        if (!lrs_device) throw std::runtime_error("point clouds can only be fused from physical devices!");
+        auto frame = depth_frames[i];
+        if (frame->get_stream_type() != RS_STREAM_DEPTH || frame->get_frame_format() != RS_FORMAT_Z16 || !frame->get_frame_data())
+            throw std::runtime_error(rsimpl::to_string() << "depth frame " << i << " is not a Z16 frame of the depth stream");
+        const auto intrin = devices[i]->get_stream_interface(RS_STREAM_DEPTH).get_intrinsics();
+        const int width = frame->get_frame_width(), height = frame->get_frame_height();
+        if (width != intrin.width || height != intrin.height)
+            throw std::runtime_error(rsimpl::to_string() << "depth frame " << i << " is " << width << "x" << height << " but the depth stream of its device is " << intrin.width << "x" << intrin.height);
+
+        rays.push_back(lrs_device->get_depth_rays(intrin));
+        const rsimpl::fused_depth_image image = { reinterpret_cast<const uint16_t *>(frame->get_frame_data()), width, height, frame->get_frame_stride() / 2, rays.back().get(), devices[i]->get_depth_scale(), device_to_rig[i] };
+        images.push_back(image);
+        pixels += (long long)width * height;
+    }
+    if (capacity < pixels) throw std::runtime_error(rsimpl::to_string() << "a capacity of " << capacity << " points cannot hold the " << pixels << " pixels of the depth frames");
+    return rsimpl::fuse_depth_to_points(points, images, voxel_size);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, devices, depth_frames, device_to_rig, count, voxel_size, points, capacity)
+
+void rs_project_points_to_pixels(float * pixels, const rs_intrinsics * intrin, const float * points, int count, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(pixels);
+    VALIDATE_NOT_NULL(intrin);
+    VALIDATE_NOT_NULL(points);
+    VALIDATE_RANGE(count, 0, INT_MAX / 3);
+    VALIDATE_ENUM(intrin->model);
+    if (intrin->model != RS_DISTORTION_NONE && intrin->model != RS_DISTORTION_MODIFIED_BROWN_CONRADY)
+        throw std::runtime_error(rsimpl::to_string() << "points cannot be projected to an image of " << rsimpl::get_string(intrin->model) << " distortion");
+    rsimpl::project_points_to_pixels(pixels, *intrin, points, count);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, pixels, intrin, points, count)
+
+void rs_deproject_pixels_to_points(float * points, const rs_intrinsics * intrin, const float * pixels, const float * depths, int count, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(points);
+    VALIDATE_NOT_NULL(intrin);
+    VALIDATE_NOT_NULL(pixels);
+    VALIDATE_NOT_NULL(depths);
+    VALIDATE_RANGE(count, 0, INT_MAX / 3);
+    VALIDATE_ENUM(intrin->model);
+    if (intrin->model != RS_DISTORTION_NONE && intrin->model != RS_DISTORTION_INVERSE_BROWN_CONRADY)
+        throw std::runtime_error(rsimpl::to_string() << "pixels cannot be deprojected from an image of " << rsimpl::get_string(intrin->model) << " distortion");
+    rsimpl::deproject_pixels_to_points(points, *intrin, pixels, depths, count);
 }
-HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, intrin)
+HANDLE_EXCEPTIONS_AND_RETURN(, points, intrin, pixels, depths, count)
 
-void rs_get_motion_intrinsics(const rs_device * device, rs_motion_intrinsics * intrinsic, rs_error ** error) try
+void rs_transform_points_to_points(float * to_points, const rs_extrinsics * extrin, const float * from_points, int count, rs_error ** error) try
 {
-    VALIDATE_NOT_NULL(device);
-    VALIDATE_NOT_NULL(intrinsic);
-    *intrinsic = device->get_motion_intrinsics();
+    VALIDATE_NOT_NULL(to_points);
+    VALIDATE_NOT_NULL(extrin);
+    VALIDATE_NOT_NULL(from_points);
+    VALIDATE_RANGE(count, 0, INT_MAX / 3);
+    rsimpl::transform_points_to_points(to_points, *extrin, from_points, count);
 }
-HANDLE_EXCEPTIONS_AND_RETURN(, device, intrinsic)
+HANDLE_EXCEPTIONS_AND_RETURN(, to_points, extrin, from_points, count)
 
-void rs_set_frame_callback(rs_device * device, rs_stream stream, rs_frame_callback_ptr on_frame, void * user, rs_error ** error) try
+void rs_set_frame_allocator(rs_device * device, rs_frame_allocate_ptr allocate, rs_frame_deallocate_ptr deallocate, void * user, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device);
-    VALIDATE_NATIVE_STREAM(stream);
-    VALIDATE_NOT_NULL(on_frame);
-    device->set_stream_callback(stream, on_frame, user);
+    VALIDATE_NOT_NULL(allocate);
+    VALIDATE_NOT_NULL(deallocate);
+    device->set_frame_allocator(allocate, deallocate, user);
 }
-HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, on_frame, user)
+HANDLE_EXCEPTIONS_AND_RETURN(, device, allocate, deallocate, user)
 
-void rs_set_frame_callback_cpp(rs_device * device, rs_stream stream, rs_frame_callback * callback, rs_error ** error) try
+void rs_set_frame_allocator_cpp(rs_device * device, rs_frame_allocator * allocator, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device);
-    VALIDATE_NATIVE_STREAM(stream);
-    VALIDATE_NOT_NULL(callback);
-    device->set_stream_callback(stream, callback);
+    VALIDATE_NOT_NULL(allocator);
+    device->set_frame_allocator(allocator);
 }
-HANDLE_EXCEPTIONS_AND_RETURN(, device, stream, callback)
+HANDLE_EXCEPTIONS_AND_RETURN(, device, allocator)
 
 void rs_log_to_callback(rs_log_severity min_severity, rs_log_callback_ptr on_log, void * user, rs_error ** error) try
 {
@@ -328,6 +897,19 @@ void rs_log_to_callback(rs_log_severity min_severity, rs_log_callback_ptr on_log
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, min_severity, on_log, user)
 
+void rs_set_calibration_cache_directory(const char * directory, rs_error ** error) try
+{
+    rsimpl::calibration_store::set_directory(directory ? directory : "");
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, directory)
+
+void rs_export_trace(const char * file_path, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(file_path);
+    rsimpl::trace::export_chrome_trace(file_path);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, file_path)
+
 void rs_log_to_callback_cpp(rs_log_severity min_severity, rs_log_callback * callback, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(callback);
@@ -346,6 +928,7 @@ void rs_enable_motion_tracking(rs_device * device,
     device->enable_motion_tracking();
     device->set_motion_callback(on_motion_event, motion_handler);
     device->set_timestamp_callback(on_timestamp_event, timestamp_handler);
+    device->set_motion_batch_callback(nullptr, nullptr);
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, device, on_motion_event, motion_handler, on_timestamp_event, timestamp_handler)
 
@@ -360,15 +943,35 @@ void rs_enable_motion_tracking_cpp(rs_device * device,
     device->enable_motion_tracking();
     device->set_motion_callback(motion_callback);
     device->set_timestamp_callback(ts_callback);
+    device->set_motion_batch_callback(nullptr, nullptr);
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, device, motion_callback, ts_callback)
 
+void rs_enable_motion_tracking_batched(rs_device * device, rs_motion_batch_callback_ptr on_events, void * user, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(on_events);
+    device->enable_motion_tracking();
+    device->set_motion_batch_callback(on_events, user);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, on_events, user)
+
+void rs_enable_motion_tracking_batched_cpp(rs_device * device, rs_motion_batch_callback * callback, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(callback);
+    device->enable_motion_tracking();
+    device->set_motion_batch_callback(callback);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, callback)
+
 void rs_disable_motion_tracking(rs_device * device, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device);
     device->disable_motion_tracking();
     device->set_motion_callback(nullptr, nullptr);
     device->set_timestamp_callback(nullptr, nullptr);
+    device->set_motion_batch_callback(nullptr, nullptr);
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, device)
 
@@ -380,6 +983,129 @@ int rs_is_motion_tracking_active(rs_device * device, rs_error ** error) try
 }
 HANDLE_EXCEPTIONS_AND_RETURN(0, device)
 
+int rs_get_motion_sample_at(const rs_device * device, rs_event_source source, double timestamp, rs_motion_data * sample, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_ENUM(source);
+    VALIDATE_RANGE(source, RS_EVENT_IMU_ACCEL, RS_EVENT_IMU_GYRO);
+    VALIDATE_NOT_NULL(sample);
+    return device->get_motion_sample_at(source, timestamp, *sample);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, source, timestamp, sample)
+
+int rs_get_motion_samples(const rs_device * device, rs_event_source source, double from, double to, rs_motion_data * samples, int max_count, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_ENUM(source);
+    VALIDATE_RANGE(source, RS_EVENT_IMU_ACCEL, RS_EVENT_IMU_GYRO);
+    VALIDATE_RANGE(max_count, 0, INT_MAX);
+    if (max_count) VALIDATE_NOT_NULL(samples);
+    return (int)std::min(device->get_motion_samples(source, from, to, samples, max_count), (size_t)INT_MAX);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, source, from, to, samples, max_count)
+
+void rs_start_recording(rs_device * device, const char * path, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(path);
+    device->start_recording(path);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, path)
+
+void rs_stop_recording(rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    device->stop_recording();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device)
+
+unsigned long long rs_get_recording_drops(const rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    return device->get_recording_drops();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device)
+
+void rs_start_publishing(rs_device * device, const char * name, int slot_count, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(name);
+    VALIDATE_RANGE(slot_count, 2, 1024);
+    device->start_publishing(name, slot_count);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, name, slot_count)
+
+void rs_stop_publishing(rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    device->stop_publishing();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device)
+
+void rs_start_frame_history(rs_device * device, double seconds, unsigned long long max_bytes, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    if (!(seconds > 0)) throw std::runtime_error("out of range value for argument \"seconds\"");
+    VALIDATE_RANGE(max_bytes, 1, (unsigned long long)SIZE_MAX);
+    device->start_frame_history(seconds, (size_t)max_bytes);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, seconds, max_bytes)
+
+void rs_stop_frame_history(rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    device->stop_frame_history();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device)
+
+int rs_dump_frame_history(const rs_device * device, const char * path, double timestamp, double before, double after, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(path);
+    if (!(before >= 0)) throw std::runtime_error("out of range value for argument \"before\"");
+    if (!(after >= 0)) throw std::runtime_error("out of range value for argument \"after\"");
+    return (int)std::min(device->dump_frame_history(path, timestamp - before, timestamp + after), (size_t)INT_MAX);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, path, timestamp, before, after)
+
+unsigned long long rs_get_frame_history_size(const rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    return device->get_frame_history_size();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device)
+
+void rs_set_playback_pacing(rs_device * device, rs_playback_pacing pacing, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_ENUM(pacing);
+    device->set_playback_pacing(pacing);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, pacing)
+
+int rs_step_playback(rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    return device->step_playback();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device)
+
+int rs_seek_playback_to_frame(rs_device * device, rs_stream stream, unsigned long long frame_number, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    return device->seek_playback_to_frame(stream, frame_number);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream, frame_number)
+
+int rs_seek_playback_to_time(rs_device * device, rs_stream stream, double timestamp, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    return device->seek_playback_to_time(stream, timestamp);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, stream, timestamp)
+
 void rs_start_device(rs_device * device, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device); 
@@ -410,6 +1136,27 @@ void rs_stop_source(rs_device * device, rs_source source, rs_error ** error) try
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, device, source)
 
+void rs_pause_device(rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    device->pause();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device)
+
+void rs_resume_device(rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    device->resume();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device)
+
+int rs_is_device_paused(const rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    return device->is_paused();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device)
+
 int rs_is_device_streaming(const rs_device * device, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device);
@@ -439,6 +1186,28 @@ int rs_poll_for_frames(rs_device * device, rs_error ** error) try
 }
 HANDLE_EXCEPTIONS_AND_RETURN(0, device)
 
+int rs_wait_for_frames_timeout(rs_device * device, unsigned int timeout_ms, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    return device->wait_all_streams(timeout_ms);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, timeout_ms)
+
+void * rs_get_frames_ready_handle(rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    return device->get_frames_ready_handle();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(nullptr, device)
+
+rs_frame_ref * rs_get_latest_frame(rs_device * device, rs_stream stream, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NATIVE_STREAM(stream);
+    return device->get_latest_frame(stream);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(nullptr, device, stream)
+
 int rs_supports(rs_device * device, rs_capabilities capability, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device);
@@ -516,6 +1285,35 @@ const void * rs_get_detached_frame_data(const rs_frame_ref * frame_ref, rs_error
 }
 HANDLE_EXCEPTIONS_AND_RETURN(nullptr, frame_ref)
 
+const void * rs_get_detached_frame_strided_data(const rs_frame_ref * frame_ref, int * pixel_stride, int * row_stride, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(frame_ref);
+    VALIDATE_NOT_NULL(pixel_stride);
+    VALIDATE_NOT_NULL(row_stride);
+    return frame_ref->get_frame_strided_data(*pixel_stride, *row_stride);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(nullptr, frame_ref, pixel_stride, row_stride)
+
+const void * rs_get_detached_frame_pyramid_level(const rs_frame_ref * frame_ref, int level, int * width, int * height, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(frame_ref);
+    VALIDATE_RANGE(level, 0, RS_MAX_DEPTH_PYRAMID_LEVELS);
+    VALIDATE_NOT_NULL(width);
+    VALIDATE_NOT_NULL(height);
+    return frame_ref->get_frame_pyramid_level(level, *width, *height);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(nullptr, frame_ref, level, width, height)
+
+const unsigned int * rs_get_detached_frame_depth_runs(const rs_frame_ref * frame_ref, const unsigned short ** runs, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(frame_ref);
+    VALIDATE_NOT_NULL(runs);
+    auto row_runs = frame_ref->get_frame_depth_runs();
+    *runs = row_runs ? reinterpret_cast<const unsigned short *>(rsimpl::get_depth_runs(row_runs, frame_ref->get_frame_height())) : nullptr;
+    return row_runs;
+}
+HANDLE_EXCEPTIONS_AND_RETURN(nullptr, frame_ref, runs)
+
 int rs_get_detached_frame_width(const rs_frame_ref * frame_ref, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(frame_ref);
@@ -566,6 +1364,13 @@ rs_stream rs_get_detached_frame_stream_type(const rs_frame_ref * frame_ref, rs_e
 }
 HANDLE_EXCEPTIONS_AND_RETURN(RS_STREAM_COUNT, frame_ref)
 
+int rs_get_detached_frame_buffer_index(const rs_frame_ref * frame_ref, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(frame_ref);
+    return frame_ref->get_frame_buffer_index();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(-1, frame_ref)
+
 
 unsigned long long rs_get_detached_frame_number(const rs_frame_ref * frame, rs_error ** error) try
 {
@@ -582,6 +1387,55 @@ void rs_release_frame(rs_device * device, rs_frame_ref * frame, rs_error ** erro
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, device, frame)
 
+rs_frame_ref * rs_detach_frame(rs_device * device, rs_frameset * frames, rs_stream stream, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(frames);
+    VALIDATE_NATIVE_STREAM(stream);
+    return device->detach_frame(frames, stream);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(nullptr, device, frames, stream)
+
+void rs_release_frames(rs_device * device, rs_frameset * frames, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(frames);
+    device->release_frames(frames);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, frames)
+
+rs_frame_ref * rs_process_frames(rs_device * device, rs_stream stream, rs_frame_ref * const * frames, int count, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_ENUM(stream);
+    VALIDATE_RANGE(stream, RS_STREAM_NATIVE_COUNT, RS_STREAM_COUNT - 1);
+    VALIDATE_NOT_NULL(frames);
+    VALIDATE_RANGE(count, 1, RS_STREAM_NATIVE_COUNT);
+    for (int i = 0; i < count; ++i) VALIDATE_NOT_NULL(frames[i]);
+    return device->process_frames(stream, frames, count);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(nullptr, device, stream, frames, count)
+
+rs_frame_ref * rs_process_frameset(rs_device * device, const rs_frameset * frames, rs_stream stream, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(frames);
+    VALIDATE_ENUM(stream);
+    VALIDATE_RANGE(stream, RS_STREAM_NATIVE_COUNT, RS_STREAM_COUNT - 1);
+    return device->process_frameset(frames, stream);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(nullptr, device, frames, stream)
+
+int rs_get_frameset_frame_info(rs_device * device, const rs_frameset * frames, rs_frame_info * infos, int max_count, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(frames);
+    VALIDATE_RANGE(max_count, 0, INT_MAX);
+    if (max_count) VALIDATE_NOT_NULL(infos);
+    return device->get_frameset_frame_info(frames, infos, max_count);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, device, frames, infos, max_count)
+
 const char * rs_get_stream_name(rs_stream stream, rs_error ** error) try
 {
     VALIDATE_ENUM(stream);
@@ -665,7 +1519,7 @@ void rs_reset_device_options_to_default(rs_device * device, const rs_option* opt
         rs_get_device_option_range_ex(device, options[i], NULL, NULL, NULL, &def, 0);
         values.push_back(def);
     }
-    device->set_options(options, count, values.data());
+    if (!device->hold_options(options, count, values.data())) device->set_options(options, count, values.data());
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, device, options, count)
 
@@ -687,10 +1541,91 @@ void rs_set_device_options(rs_device * device, const rs_option options[], unsign
     VALIDATE_NOT_NULL(options);
     for(size_t i=0; i<count; ++i) VALIDATE_ENUM(options[i]);
     VALIDATE_NOT_NULL(values);
-    device->set_options(options, count, values);
+    if (!device->hold_options(options, count, values)) device->set_options(options, count, values);
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, device, options, count, values)
 
+void rs_begin_device_options(rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    device->begin_options();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device)
+
+void rs_commit_device_options(rs_device * device, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    device->commit_options();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device)
+
+namespace rsimpl
+{
+    // Hands the outcome of an asynchronous option request to a C callback, the failure reason wrapped in an rs_error that lives for the call
+    class options_callback : public rs_options_callback
+    {
+        rs_options_callback_ptr fptr;
+        void * user;
+        const char * function;
+    public:
+        options_callback(rs_options_callback_ptr on_complete, void * user, const char * function) : fptr(on_complete), user(user), function(function) {}
+
+        void on_options(rs_device * device, const rs_option * options, unsigned int count, const double * values, const char * error_message) override
+        {
+            if (!error_message) return fptr(device, options, count, values, nullptr, user);
+            rs_error error = { error_message, function, "" };
+            fptr(device, options, count, values, &error, user);
+        }
+        void release() override { delete this; }
+    };
+}
+
+void rs_set_device_options_async(rs_device * device, const rs_option options[], unsigned int count, const double values[], rs_options_callback_ptr on_complete, void * user, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_LE(count, INT_MAX);
+    VALIDATE_NOT_NULL(options);
+    for(size_t i=0; i<count; ++i) VALIDATE_ENUM(options[i]);
+    VALIDATE_NOT_NULL(values);
+    device->set_options_async(options, count, values, on_complete ? new rsimpl::options_callback(on_complete, user, __FUNCTION__) : nullptr);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, options, count, values, on_complete, user)
+
+void rs_set_device_options_async_cpp(rs_device * device, const rs_option options[], unsigned int count, const double values[], rs_options_callback * callback, rs_error ** error) try
+{
+    std::unique_ptr<rs_options_callback, void(*)(rs_options_callback *)> owner(callback, [](rs_options_callback * c) { if (c) c->release(); });
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_LE(count, INT_MAX);
+    VALIDATE_NOT_NULL(options);
+    for(size_t i=0; i<count; ++i) VALIDATE_ENUM(options[i]);
+    VALIDATE_NOT_NULL(values);
+    device->set_options_async(options, count, values, owner.release());
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, options, count, values, callback)
+
+void rs_get_device_options_async(rs_device * device, const rs_option options[], unsigned int count, rs_options_callback_ptr on_complete, void * user, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_LE(count, INT_MAX);
+    VALIDATE_NOT_NULL(options);
+    for(size_t i=0; i<count; ++i) VALIDATE_ENUM(options[i]);
+    VALIDATE_NOT_NULL(on_complete);
+    device->get_options_async(options, count, new rsimpl::options_callback(on_complete, user, __FUNCTION__));
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, options, count, on_complete, user)
+
+void rs_get_device_options_async_cpp(rs_device * device, const rs_option options[], unsigned int count, rs_options_callback * callback, rs_error ** error) try
+{
+    std::unique_ptr<rs_options_callback, void(*)(rs_options_callback *)> owner(callback, [](rs_options_callback * c) { if (c) c->release(); });
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_LE(count, INT_MAX);
+    VALIDATE_NOT_NULL(options);
+    for(size_t i=0; i<count; ++i) VALIDATE_ENUM(options[i]);
+    VALIDATE_NOT_NULL(callback);
+    device->get_options_async(options, count, owner.release());
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, options, count, callback)
+
 double rs_get_device_option(rs_device * device, rs_option option, rs_error ** error) try
 {
     VALIDATE_NOT_NULL(device);
@@ -713,7 +1648,7 @@ void rs_set_device_option(rs_device * device, rs_option option, double value, rs
 {
     VALIDATE_NOT_NULL(device);
     VALIDATE_ENUM(option);
-    device->set_options(&option, 1, &value);
+    if (!device->hold_options(&option, 1, &value)) device->set_options(&option, 1, &value);
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, device, option, value)
 
@@ -735,7 +1670,7 @@ void rs_send_blob_to_device(rs_device * device, rs_blob_type type, void * data,
     auto lrs_device = dynamic_cast<rs_device_base*>(device);
     if (lrs_device)
     {
-        lrs_device->send_blob_to_device(type, data, size);
+        lrs_device->send_blob_to_device(type, data, size, nullptr);
     }
     else
     {
@@ -744,6 +1679,17 @@ void rs_send_blob_to_device(rs_device * device, rs_blob_type type, void * data,
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, device, type, data, size)
 
+void rs_send_blob_to_device_with_progress(rs_device * device, rs_blob_type type, void * data, int size, rs_blob_progress_callback_ptr on_progress, void * user, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(device);
+    VALIDATE_NOT_NULL(data);
+    VALIDATE_NOT_NULL(on_progress);
+    auto lrs_device = dynamic_cast<rs_device_base*>(device);
+    if (!lrs_device) throw std::runtime_error("sending binary data to the device is only available when using physical device!");
+    lrs_device->send_blob_to_device(type, data, size, [device, on_progress, user](int bytes_sent, int total) { on_progress(device, bytes_sent, total, user); });
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, device, type, data, size, on_progress, user)
+
 
 void rs_free_error(rs_error * error) { if (error) delete error; }
 const char * rs_get_failed_function(const rs_error * error) { return error ? error->function : nullptr; }
@@ -763,6 +1709,12 @@ const char * rs_event_to_string(rs_event_source event)   { return rsimpl::get_st
 const char * rs_blob_type_to_string(rs_blob_type type) { return rsimpl::get_string(type); }
 const char * rs_camera_info_to_string(rs_camera_info info) { return rsimpl::get_string(info); }
 const char * rs_timestamp_domain_to_string(rs_timestamp_domain info){ return rsimpl::get_string(info); }
+const char * rs_frame_drop_policy_to_string(rs_frame_drop_policy policy) { return rsimpl::get_string(policy); }
+const char * rs_straggler_policy_to_string(rs_straggler_policy policy) { return rsimpl::get_string(policy); }
+const char * rs_playback_pacing_to_string(rs_playback_pacing pacing) { return rsimpl::get_string(pacing); }
+const char * rs_stream_metric_to_string(rs_stream_metric metric) { return rsimpl::get_string(metric); }
+const char * rs_transfer_statistic_to_string(rs_transfer_statistic statistic) { return rsimpl::get_string(statistic); }
+const char * rs_load_shedding_action_to_string(rs_load_shedding_action action) { return rsimpl::get_string(action); }
 
 const char * rs_frame_metadata_to_string(rs_frame_metadata md) { return rsimpl::get_string(md); }
 
@@ -772,8 +1724,80 @@ void rs_log_to_console(rs_log_severity min_severity, rs_error ** error) try
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, min_severity)
 
+void rs_convert_disparity_to_z16(const unsigned short * disparity_pixels, unsigned short * z_pixels, int count, float disparity_scale, float z_scale, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(disparity_pixels);
+    VALIDATE_NOT_NULL(z_pixels);
+    VALIDATE_RANGE(count, 0, INT_MAX);
+    if(!(disparity_scale > 0)) throw std::runtime_error("out of range value for argument \"disparity_scale\"");
+    if(!(z_scale > 0)) throw std::runtime_error("out of range value for argument \"z_scale\"");
+    rsimpl::convert_disparity_to_z16(z_pixels, disparity_pixels, count, disparity_scale, z_scale);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, disparity_pixels, z_pixels, count, disparity_scale, z_scale)
+
+int rs_get_encoded_depth_max_size(int pixel_count, rs_error ** error) try
+{
+    VALIDATE_RANGE(pixel_count, 0, INT_MAX / 4 - 2);
+    return static_cast<int>(rsimpl::rvl_max_encoded_size(pixel_count));
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, pixel_count)
+
+int rs_encode_depth(const unsigned short * depth_pixels, int pixel_count, void * buffer, int buffer_size, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(depth_pixels);
+    VALIDATE_RANGE(pixel_count, 0, INT_MAX / 4 - 2);
+    VALIDATE_NOT_NULL(buffer);
+    if (buffer_size < 0 || static_cast<size_t>(buffer_size) < rsimpl::rvl_max_encoded_size(pixel_count)) throw std::runtime_error("buffer is smaller than rs_get_encoded_depth_max_size()");
+    return static_cast<int>(rsimpl::rvl_encode(static_cast<rsimpl::byte *>(buffer), depth_pixels, pixel_count));
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, depth_pixels, pixel_count, buffer, buffer_size)
+
+void rs_decode_depth(const void * data, int size, unsigned short * depth_pixels, int pixel_count, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(data);
+    VALIDATE_RANGE(size, 0, INT_MAX);
+    VALIDATE_NOT_NULL(depth_pixels);
+    VALIDATE_RANGE(pixel_count, 0, INT_MAX);
+    rsimpl::rvl_decode(depth_pixels, pixel_count, static_cast<const rsimpl::byte *>(data), size);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, data, size, depth_pixels, pixel_count)
+
+rs_server * rs_create_server(const char * address, int port, rs_error ** error) try
+{
+    VALIDATE_RANGE(port, 0, 65535);
+    return new rs_server(address ? address : "127.0.0.1", port);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(nullptr, address, port)
+
+int rs_get_server_port(const rs_server * server, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(server);
+    return server->get_port();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, server)
+
+void rs_delete_server(rs_server * server, rs_error ** error) try
+{
+    VALIDATE_NOT_NULL(server);
+    delete server;
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, server)
+
 void rs_log_to_file(rs_log_severity min_severity, const char * file_path, rs_error ** error) try
 {
     rsimpl::log_to_file(min_severity, file_path);
 }
 HANDLE_EXCEPTIONS_AND_RETURN(, min_severity, file_path)
+
+void rs_log_asynchronously(int queue_size, rs_error ** error) try
+{
+    VALIDATE_RANGE(queue_size, 0, 1 << 20);
+    rsimpl::log_asynchronously(queue_size);
+}
+HANDLE_EXCEPTIONS_AND_RETURN(, queue_size)
+
+unsigned long long rs_get_dropped_log_messages(rs_error ** error) try
+{
+    return rsimpl::get_dropped_log_messages();
+}
+HANDLE_EXCEPTIONS_AND_RETURN(0, error)
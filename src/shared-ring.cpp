@@ -0,0 +1,409 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "shared-ring.h"
+
+#include <cstring>
+#include <climits>
+#include <new>
+#ifdef _WIN32
+#define NOMINMAX // Keeps std::min and std::max usable
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+using namespace rsimpl;
+using namespace rsimpl::shared_ring;
+
+static size_t align_up(size_t size, size_t alignment) { return (size + alignment - 1) / alignment * alignment; }
+
+namespace
+{
+    // Atomics of the ring are shared between processes, which holds for lock free atomics on every platform the library supports
+    static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "the ring requires lock free atomics");
+
+    const size_t description_capacity = 64 << 10;   // Bytes of the description, a multiple of recording::chunk_alignment
+    const size_t record_capacity = 256;             // Bytes of the records leading a slot, so that frames start aligned
+
+    struct ring_header
+    {
+        uint32_t magic;                             // Set last by the publisher, once the ring is ready
+        uint32_t version;
+        uint32_t slot_count;
+        uint32_t slot_size;                         // Bytes of a slot, slot_header included
+        std::atomic<uint32_t> description_version;  // Odd while the publisher rewrites the description
+        uint32_t description_size;
+        std::atomic<uint32_t> closed;
+        std::atomic<uint32_t> wakeups;              // Incremented by every record published, subscribers waiting for it to change
+        std::atomic<uint64_t> latest;               // Sequence of the latest record published
+    };
+
+    struct slot_header
+    {
+        std::atomic<uint32_t> holders;              // Subscribers holding the record of the slot
+        uint32_t size;                              // Bytes of the payload
+        std::atomic<uint64_t> sequence;             // Of the record of the slot, 0 while the publisher rewrites it
+        recording::record_type type;
+    };
+
+    const size_t ring_header_size = align_up(sizeof(ring_header), 64);
+    const size_t slot_header_size = align_up(sizeof(slot_header), 64);
+    static_assert(sizeof(recording::mode_record) + sizeof(recording::frame_record) <= record_capacity, "records do not fit a slot");
+    static_assert(sizeof(recording::motion_record) <= record_capacity, "records do not fit a slot");
+
+    void wake_subscribers(std::atomic<uint32_t> & wakeups)
+    {
+        wakeups.fetch_add(1);
+#ifdef __linux__
+        syscall(SYS_futex, &wakeups, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+    }
+
+    void wait_for_wakeup(std::atomic<uint32_t> & wakeups, uint32_t seen, std::chrono::milliseconds timeout)
+    {
+#ifdef __linux__
+        // Not private to the process, so that the futex is keyed by the shared page rather than the address
+        timespec t = { static_cast<time_t>(timeout.count() / 1000), static_cast<long>(timeout.count() % 1000 * 1000000) };
+        syscall(SYS_futex, &wakeups, FUTEX_WAIT, seen, &t, nullptr, 0);
+#else
+        // Without a waitable address shared between processes, subscribers poll
+        const auto until = std::chrono::steady_clock::now() + timeout;
+        while (wakeups.load() == seen && std::chrono::steady_clock::now() < until) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+    }
+}
+
+// A named region of memory shared between processes, created by the publisher and opened by subscribers
+class rsimpl::shared_ring::shared_memory
+{
+    std::string name;
+    byte * data;
+    size_t size;
+    bool owner;
+    uint32_t slot_count;                            // Of the layout the ring was created or checked with, never read back from the shared header,
+    size_t slot_size;                               // which any process mapping the ring may write
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+    shared_memory(const shared_memory &) = delete;
+    shared_memory & operator=(const shared_memory &) = delete;
+public:
+#ifdef _WIN32
+    shared_memory(const std::string & name, size_t size) : name(name), data(nullptr), size(size), owner(true), slot_count(0), slot_size(0)
+    {
+        mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size), name.c_str());
+        if (mapping) data = static_cast<byte *>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+        if (!data)
+        {
+            auto error = GetLastError();
+            if (mapping) CloseHandle(mapping);
+            throw std::runtime_error(to_string() << "could not create ring " << name << ", error " << error);
+        }
+    }
+
+    explicit shared_memory(const std::string & name) : name(name), data(nullptr), size(0), owner(false), slot_count(0), slot_size(0)
+    {
+        mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+        if (mapping) data = static_cast<byte *>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+        MEMORY_BASIC_INFORMATION info;
+        if (!data || !VirtualQuery(data, &info, sizeof(info)))
+        {
+            auto error = GetLastError();
+            if (data) UnmapViewOfFile(data);
+            if (mapping) CloseHandle(mapping);
+            throw std::runtime_error(to_string() << "could not open ring " << name << ", error " << error);
+        }
+        size = info.RegionSize;
+    }
+
+    ~shared_memory()
+    {
+        UnmapViewOfFile(data);
+        CloseHandle(mapping); // The region goes with the last handle to it
+    }
+#else
+    shared_memory(const std::string & name, size_t size) : name(name), data(nullptr), size(size), owner(true), slot_count(0), slot_size(0)
+    {
+        shm_unlink(this->name.c_str()); // Left behind by a publisher which did not stop, most likely
+        int fd = shm_open(this->name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600); // Frames are only for processes of the same user
+        if (fd < 0) throw std::runtime_error(to_string() << "could not create ring " << name << ", error " << errno);
+        auto address = ftruncate(fd, static_cast<off_t>(size)) == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (address == MAP_FAILED)
+        {
+            auto error = errno;
+            ::close(fd);
+            shm_unlink(this->name.c_str());
+            throw std::runtime_error(to_string() << "could not map ring " << name << ", error " << error);
+        }
+        ::close(fd);
+        data = static_cast<byte *>(address);
+    }
+
+    explicit shared_memory(const std::string & name) : name(name), data(nullptr), size(0), owner(false), slot_count(0), slot_size(0)
+    {
+        int fd = shm_open(this->name.c_str(), O_RDWR, 0);
+        if (fd < 0) throw std::runtime_error(to_string() << "could not open ring " << name << ", error " << errno);
+        struct stat st;
+        auto address = fstat(fd, &st) == 0 && st.st_size > 0 ? mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        auto error = errno;
+        ::close(fd);
+        if (address == MAP_FAILED) throw std::runtime_error(to_string() << "could not map ring " << name << ", error " << error);
+        data = static_cast<byte *>(address);
+        size = static_cast<size_t>(st.st_size);
+    }
+
+    ~shared_memory()
+    {
+        munmap(data, size);
+        if (owner) shm_unlink(name.c_str()); // Subscribers keep their mappings
+    }
+#endif
+
+    byte * get_data() const { return data; }
+    size_t get_size() const { return size; }
+
+    // Set once, by the publisher creating the ring or by the subscriber which checked it fits the mapping
+    void set_layout(uint32_t count, size_t size) { slot_count = count; slot_size = size; }
+    uint32_t get_slot_count() const { return slot_count; }
+    size_t get_slot_size() const { return slot_size; }
+
+    ring_header & get_header() const { return *reinterpret_cast<ring_header *>(data); }
+    byte * get_description() const { return data + ring_header_size; }
+    slot_header & get_slot(uint32_t index) const { return *reinterpret_cast<slot_header *>(data + ring_header_size + description_capacity + static_cast<size_t>(index % slot_count) * slot_size); }
+};
+
+///////////////
+// publisher //
+///////////////
+
+publisher::publisher(const std::string & name, int slot_count, size_t max_frame_size, const recording::device_record & device) : next_slot(0), sequence(0), dropped(0)
+{
+    if (slot_count < 2) throw std::runtime_error("a ring needs at least two slots");
+    const size_t slot_size = align_up(slot_header_size + record_capacity + max_frame_size, 4096);
+    if (slot_size > UINT32_MAX) throw std::runtime_error("frames are too large for a ring");
+
+#ifdef _WIN32
+    memory.reset(new shared_memory(name, ring_header_size + description_capacity + slot_size * slot_count));
+#else
+    memory.reset(new shared_memory("/" + name, ring_header_size + description_capacity + slot_size * slot_count));
+#endif
+    memory->set_layout(slot_count, slot_size);
+    auto & header = memory->get_header();
+    new (&header) ring_header();
+    header.version = ring_version;
+    header.slot_count = slot_count;
+    header.slot_size = static_cast<uint32_t>(slot_size);
+    for (int i = 0; i < slot_count; ++i) new (&memory->get_slot(i)) slot_header();
+
+    // The description starts with the device alone, and gets the modes of the device every time it starts
+    auto description = memory->get_description();
+    recording::chunk_header chunk = { recording::chunk_magic, recording::format_version, 0, 1 };
+    recording::record_header record = { recording::record_type::device, sizeof(device) };
+    memcpy(description + sizeof(chunk), &record, sizeof(record));
+    memcpy(description + sizeof(chunk) + sizeof(record), &device, sizeof(device));
+    chunk.size = static_cast<uint32_t>(sizeof(chunk) + sizeof(record) + align_up(sizeof(device), 8));
+    memcpy(description, &chunk, sizeof(chunk));
+    header.description_size = static_cast<uint32_t>(align_up(chunk.size, recording::chunk_alignment));
+
+    std::atomic_thread_fence(std::memory_order_release);
+    header.magic = ring_magic;
+}
+
+publisher::~publisher()
+{
+    auto & header = memory->get_header();
+    header.closed = 1;
+    wake_subscribers(header.wakeups);
+}
+
+void publisher::describe(const std::vector<recording::mode_description> & modes)
+{
+    auto & header = memory->get_header();
+    auto description = memory->get_description();
+    recording::chunk_header device_chunk;
+    memcpy(&device_chunk, description, sizeof(device_chunk));
+
+    // The modes make up a second chunk, after that of the device
+    std::vector<byte> chunk(sizeof(recording::chunk_header));
+    uint32_t record_count = 0;
+    auto append = [&](recording::record_type type, const void * payload, size_t size)
+    {
+        const recording::record_header record = { type, static_cast<uint32_t>(size) };
+        const size_t offset = chunk.size();
+        chunk.resize(offset + sizeof(record) + align_up(size, 8));
+        memcpy(chunk.data() + offset, &record, sizeof(record));
+        memcpy(chunk.data() + offset + sizeof(record), payload, size);
+        ++record_count;
+    };
+    for (auto & m : modes)
+    {
+        append(recording::record_type::mode, &m.mode, sizeof(m.mode));
+        for (auto & s : m.streams) append(recording::record_type::stream, &s, sizeof(s));
+    }
+    const recording::chunk_header modes_chunk = { recording::chunk_magic, recording::format_version, static_cast<uint32_t>(chunk.size()), record_count };
+    memcpy(chunk.data(), &modes_chunk, sizeof(modes_chunk));
+
+    const size_t device_size = align_up(device_chunk.size, recording::chunk_alignment);
+    if (device_size + align_up(chunk.size(), recording::chunk_alignment) > description_capacity) throw std::runtime_error("modes do not fit the description of the ring");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    header.description_version.fetch_add(1);
+    memset(description + device_size, 0, description_capacity - device_size);
+    memcpy(description + device_size, chunk.data(), chunk.size());
+    header.description_size = static_cast<uint32_t>(device_size + align_up(chunk.size(), recording::chunk_alignment));
+    header.description_version.fetch_add(1);
+}
+
+bool publisher::publish(recording::record_type type, const void * records, size_t records_size, const void * data, size_t size)
+{
+    auto & header = memory->get_header();
+    if (memory->get_slot_size() - slot_header_size - record_capacity < size)
+    {
+        ++dropped;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (uint32_t i = 0; i < memory->get_slot_count(); ++i)
+    {
+        const uint32_t index = (next_slot + i) % memory->get_slot_count();
+        auto & slot = memory->get_slot(index);
+        if (slot.holders.load()) continue;
+
+        // Subscribers take a hold before checking the sequence, so once it is cleared, either a hold shows or no subscriber reads the slot
+        const uint64_t previous = slot.sequence.exchange(0);
+        if (slot.holders.load())
+        {
+            slot.sequence.store(previous);
+            continue;
+        }
+
+        auto payload = reinterpret_cast<byte *>(&slot) + slot_header_size;
+        memcpy(payload + record_capacity - records_size, records, records_size); // Records end where the frame starts
+        memcpy(payload + record_capacity, data, size);
+        slot.type = type;
+        slot.size = static_cast<uint32_t>(records_size + size);
+        slot.sequence.store(++sequence);
+        header.latest.store(sequence);
+        wake_subscribers(header.wakeups);
+        next_slot = index + 1;
+        return true;
+    }
+    ++dropped;
+    return false;
+}
+
+bool publisher::publish_frame(const recording::mode_record & mode, const recording::frame_record & frame, const void * data, size_t size)
+{
+    byte records[sizeof(mode) + sizeof(frame)];
+    memcpy(records, &mode, sizeof(mode));
+    memcpy(records + sizeof(mode), &frame, sizeof(frame));
+    return publish(recording::record_type::frame, records, sizeof(records), data, size);
+}
+
+bool publisher::publish_motion(const recording::motion_record & motion, const void * data, size_t size)
+{
+    return publish(recording::record_type::motion, &motion, sizeof(motion), data, size);
+}
+
+////////////////
+// subscriber //
+////////////////
+
+subscriber::subscriber(const std::string & name)
+{
+#ifdef _WIN32
+    memory = std::make_shared<shared_memory>(name);
+#else
+    memory = std::make_shared<shared_memory>("/" + name);
+#endif
+    // The layout is read once, and only what was checked against the mapping is used from then on
+    auto & header = memory->get_header();
+    const uint32_t slot_count = memory->get_size() < ring_header_size + description_capacity ? 0 : header.slot_count;
+    const size_t slot_size = memory->get_size() < ring_header_size + description_capacity ? 0 : header.slot_size;
+    if (slot_count == 0 || header.magic != ring_magic || header.version != ring_version ||
+        memory->get_size() < ring_header_size + description_capacity + slot_size * slot_count || slot_size < slot_header_size + record_capacity)
+    {
+        throw std::runtime_error(to_string() << "ring " << name << " is not ready, or of an unsupported version");
+    }
+    memory->set_layout(slot_count, slot_size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+std::vector<byte> subscriber::get_description() const
+{
+    auto & header = memory->get_header();
+    while (true)
+    {
+        const uint32_t version = header.description_version.load();
+        if (version & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const size_t size = std::min(static_cast<size_t>(header.description_size), description_capacity);
+        std::vector<byte> description(memory->get_description(), memory->get_description() + size);
+        if (header.description_version.load() == version) return description;
+    }
+}
+
+uint64_t subscriber::get_latest() const { return memory->get_header().latest; }
+bool subscriber::is_closed() const { return memory->get_header().closed != 0; }
+
+std::shared_ptr<const held_record> subscriber::hold_next(uint64_t after, std::chrono::milliseconds timeout)
+{
+    auto & header = memory->get_header();
+    const auto until = std::chrono::steady_clock::now() + timeout;
+    while (true)
+    {
+        const uint32_t wakeups = header.wakeups.load();
+
+        // The oldest record after the sequence is held, unless the publisher takes its slot first
+        uint32_t oldest = UINT32_MAX;
+        uint64_t oldest_sequence = UINT64_MAX;
+        for (uint32_t i = 0; i < memory->get_slot_count(); ++i)
+        {
+            const uint64_t s = memory->get_slot(i).sequence.load();
+            if (s > after && s < oldest_sequence)
+            {
+                oldest = i;
+                oldest_sequence = s;
+            }
+        }
+        if (oldest != UINT32_MAX)
+        {
+            auto & slot = memory->get_slot(oldest);
+            slot.holders.fetch_add(1);
+            if (slot.sequence.load() != oldest_sequence)
+            {
+                slot.holders.fetch_sub(1);
+                continue;
+            }
+
+            auto payload = reinterpret_cast<const byte *>(&slot) + slot_header_size;
+            const size_t records_size = slot.type == recording::record_type::frame ? sizeof(recording::mode_record) + sizeof(recording::frame_record) : sizeof(recording::motion_record);
+            const size_t size = std::min<size_t>(slot.size, memory->get_slot_size() - slot_header_size - record_capacity + records_size);
+            auto record = new held_record{ slot.type, payload + record_capacity - records_size, size, oldest_sequence };
+            auto memory = this->memory;
+            return std::shared_ptr<const held_record>(record, [memory, oldest](const held_record * r)
+            {
+                memory->get_slot(oldest).holders.fetch_sub(1);
+                delete r;
+            });
+        }
+
+        if (header.closed) return nullptr;
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= until) return nullptr;
+        wait_for_wakeup(header.wakeups, wakeups, std::chrono::duration_cast<std::chrono::milliseconds>(until - now) + std::chrono::milliseconds(1));
+    }
+}
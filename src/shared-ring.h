@@ -0,0 +1,77 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_SHARED_RING_H
+#define LIBREALSENSE_SHARED_RING_H
+
+#include "recording.h"
+
+namespace rsimpl
+{
+    // Hands the native frames and motion data of a device over to other processes through a named region of shared memory. The process owning
+    // the device publishes every frame into a slot of a ring, once whatever the number of subscribers, and subscribers read the slots in place.
+    // A slot is left alone by the publisher as long as any subscriber holds it, the publisher taking the oldest free slot instead, so that a slow
+    // subscriber only makes the others see fewer distinct slots, and drops frames only once every slot is held. Records keep the layout of
+    // recordings, so that subscribers replay a ring through the same code as a recording.
+    namespace shared_ring
+    {
+        const uint32_t ring_magic = 0x47525352;     // "RSRG"
+        const uint32_t ring_version = 1;
+
+        class shared_memory;
+
+        // A record read from a slot, which the publisher leaves alone until the last reference to it is released
+        struct held_record
+        {
+            recording::record_type type;
+            const byte * payload;               // A mode_record followed by the frame_record and frame, or the motion_record and transfer
+            size_t size;
+            uint64_t sequence;                  // Of the record among all those published
+        };
+
+        class publisher
+        {
+            std::unique_ptr<shared_memory> memory;
+            std::mutex mutex;                   // Serializes the capture threads publishing
+            uint32_t next_slot;                 // Guarded by mutex
+            uint64_t sequence;                  // Guarded by mutex, of the latest record published
+            std::atomic<uint64_t> dropped;
+
+            publisher(const publisher &) = delete;
+            publisher & operator=(const publisher &) = delete;
+
+            bool publish(recording::record_type type, const void * header, size_t header_size, const void * data, size_t size);
+        public:
+            // Creates a ring of slot_count slots fitting frames of max_frame_size bytes, replacing any ring of that name, which only processes of
+            // the same user may open
+            publisher(const std::string & name, int slot_count, size_t max_frame_size, const recording::device_record & device);
+            ~publisher(); // Removes the name of the ring, subscribers still attached seeing it end
+
+            void describe(const std::vector<recording::mode_description> & modes); // Of the latest start of the device, read by subscribers opening it
+
+            // Return false when the record is dropped, because every slot is held or the record does not fit in one
+            bool publish_frame(const recording::mode_record & mode, const recording::frame_record & frame, const void * data, size_t size);
+            bool publish_motion(const recording::motion_record & motion, const void * data, size_t size);
+
+            uint64_t get_dropped_count() const { return dropped; }
+        };
+
+        class subscriber
+        {
+            std::shared_ptr<shared_memory> memory;
+        public:
+            explicit subscriber(const std::string & name); // Throws when no ring of that name is published
+
+            std::vector<byte> get_description() const; // The device and its modes, as chunks of a recording
+            uint64_t get_latest() const;        // Sequence of the latest record published
+            bool is_closed() const;             // Set once the publisher stopped
+
+            // Holds the oldest record published after a sequence, waiting up to a timeout for one. Returns null on timeout, or once the
+            // publisher stopped. Records overwritten before they were held are skipped.
+            std::shared_ptr<const held_record> hold_next(uint64_t after, std::chrono::milliseconds timeout);
+        };
+    }
+}
+
+#endif
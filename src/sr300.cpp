@@ -3,6 +3,7 @@
 
 #include <climits>
 #include <algorithm>
+#include <cstring>
 
 #include "image.h"
 #include "sr300.h"
@@ -114,7 +115,7 @@ namespace rsimpl
     }
 
     sr300_camera::sr300_camera(std::shared_ptr<uvc::device> device, const static_device_info & info, const ivcam::camera_calib_params & calib) :
-        iv_camera(device, info, calib)
+        iv_camera(device, info, calib), auto_range_written(false)
     {
         // These settings come from the "Common" preset. There is no actual way to read the current values off the device.
         arr.enableMvR = 1;
@@ -164,8 +165,10 @@ namespace rsimpl
         std::vector<double>     base_opt_val;
 
         auto arr_writer = make_struct_interface<ivcam::cam_auto_range_request>([this]() { return arr; }, [this](ivcam::cam_auto_range_request r) {
+            if (auto_range_written && !memcmp(&r, &arr, sizeof(r))) return; // The request the device already holds, as a preset applied again
             ivcam::set_auto_range(get_device(), usbMutex, r.enableMvR, r.minMvR, r.maxMvR, r.startMvR, r.enableLaser, r.minLaser, r.maxLaser, r.startLaser, r.ARUpperTh, r.ARLowerTh);
             arr = r;
+            auto_range_written = true;
         });
 
         for(size_t i=0; i<count; ++i)
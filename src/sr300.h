@@ -16,6 +16,7 @@ namespace rsimpl
 
     class sr300_camera final : public iv_camera
     {
+        bool auto_range_written; // Until then, arr holds the values of the Common preset rather than those of the device
         void set_fw_logger_option(double value);
         unsigned get_fw_logger_option();
 
@@ -4,6 +4,7 @@
 #include "stream.h"
 #include "sync.h"       // For frame_archive
 #include "image.h"      // For image alignment, rectification, and deprojection routines
+#include "trace.h"      // For RS_TRACE_SPAN
 #include <algorithm>    // For sort
 #include <tuple>        // For make_tuple
 
@@ -26,7 +27,30 @@ rs_extrinsics stream_interface::get_extrinsics_to(const rs_stream_interface & ot
     return extrin;
 }
 
-native_stream::native_stream(device_config & config, rs_stream stream, calibration_validator in_validator) : stream_interface(in_validator, stream), config(config)
+long long stream_demand::now()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void stream_demand::reset()
+{
+    for(auto & t : last_use) t.store(0, std::memory_order_relaxed);
+    idle_streams = 0;
+}
+
+void stream_demand::consume(rs_stream stream)
+{
+    last_use[stream].store(now(), std::memory_order_relaxed);
+    if(is_idle(stream) && on_wake) on_wake();
+}
+
+void stream_demand::set_idle(rs_stream stream, bool idle)
+{
+    if(idle) idle_streams.fetch_or(1 << stream);
+    else idle_streams.fetch_and(~(1 << stream));
+}
+
+native_stream::native_stream(device_config & config, rs_stream stream, calibration_validator in_validator) : stream_interface(in_validator, stream), config(config), demand(nullptr)
 {
     for(auto & subdevice_mode : config.info.subdevice_modes)
     {
@@ -85,7 +109,8 @@ rs_intrinsics native_stream::get_intrinsics() const
         LOG_ERROR("The intrinsic of " << get_stream_type() << " is not valid");
     }
     const auto m = get_mode();
-    return pad_crop_intrinsics(m.mode.native_intrinsics, m.pad_crop);
+    const auto intrin = m.get_unpacked_intrinsics(m.mode.native_intrinsics);
+    return m.is_decimated(stream) ? decimate_intrinsics(intrin, m.decimation_factor) : intrin;
 }
 
 rs_intrinsics native_stream::get_rectified_intrinsics() const
@@ -96,7 +121,8 @@ rs_intrinsics native_stream::get_rectified_intrinsics() const
     }
     const auto m = get_mode();
     if(m.mode.rect_modes.empty()) return get_intrinsics();
-    return pad_crop_intrinsics(m.mode.rect_modes[0], m.pad_crop);
+    const auto intrin = m.get_unpacked_intrinsics(m.mode.rect_modes[0]);
+    return m.is_decimated(stream) ? decimate_intrinsics(intrin, m.decimation_factor) : intrin;
 }
 
 double native_stream::get_frame_metadata(rs_frame_metadata frame_metadata) const
@@ -138,9 +164,21 @@ const uint8_t * native_stream::get_frame_data() const
 {
     if(!is_enabled()) throw std::runtime_error(to_string() << "stream not enabled: " << stream);
     if (!archive) throw  std::runtime_error(to_string() << "streaming not started!");
+    if (demand) demand->consume(stream);
     return (const uint8_t *) archive->get_frame_data(stream);
 }
 
+const uint32_t * native_stream::get_frame_depth_runs() const
+{
+    return archive ? archive->get_frame_depth_runs(stream) : nullptr;
+}
+
+const byte * native_stream::get_precomputed_frame_data(rs_stream derived) const
+{
+    if (archive && demand) demand->consume(stream);
+    return archive ? archive->get_derived_frame_data(derived) : nullptr;
+}
+
 int native_stream::get_frame_stride() const
 {
     if (!is_enabled()) throw std::runtime_error(to_string() << "stream not enabled: " << stream);
@@ -155,65 +193,395 @@ int native_stream::get_frame_bpp() const
     return archive->get_frame_bpp(stream);
 }
 
-const uint8_t * point_stream::get_frame_data() const
+stream_roi stream_roi::clip(int image_width, int image_height) const
 {
-    if(image.empty() || number != get_frame_number())
+    if(is_full_image()) return {0, 0, image_width, image_height};
+    const int x0 = std::min(x, image_width), y0 = std::min(y, image_height);
+    return {x0, y0, std::min(width, image_width - x0), std::min(height, image_height - y0)};
+}
+
+rs_intrinsics stream_roi::crop(const rs_intrinsics & intrin) const
+{
+    if(is_full_image()) return intrin;
+    const auto window = clip(intrin.width, intrin.height);
+    auto cropped = intrin;
+    cropped.width = window.width;
+    cropped.height = window.height;
+    cropped.ppx -= window.x;
+    cropped.ppy -= window.y;
+    return cropped;
+}
+
+int stream_interface::padded_row_stride(int width, int bpp) const
+{
+    int stride = width;
+    if(row_alignment) while(stride * bpp / 8 % row_alignment) ++stride;
+    return stride;
+}
+
+source_image rsimpl::get_frontbuffer_image(const stream_interface & source)
+{
+    auto data = source.get_frame_data();
+    if (!data) throw std::runtime_error(to_string() << "no frame of stream " << source.get_stream_type() << " in the current frameset"); // Left out for lack of a frame within its sync tolerance
+    return {data, source.get_row_stride(), source.get_frame_depth_runs()};
+}
+
+const changed_tiles * incremental_source::update(const source_image & image, int width, int height, int pixel_size, std::shared_ptr<const void> calibration, float scale)
+{
+    if(!enabled) return nullptr;
+    const bool comparable = !previous.empty() && width == this->width && height == this->height && pixel_size == this->pixel_size && calibration == this->calibration && scale == this->scale;
+    if(!comparable)
     {
-        image.resize(get_image_size(get_intrinsics().width, get_intrinsics().height, get_format()));
+        previous.resize(width * height * pixel_size);
+        for(int y = 0; y < height; ++y) memcpy(previous.data() + y * width * pixel_size, image.data + y * image.stride * pixel_size, width * pixel_size);
+        this->width = width;
+        this->height = height;
+        this->pixel_size = pixel_size;
+        this->calibration = calibration;
+        this->scale = scale;
+        return nullptr;
+    }
 
-        if(source.get_format() == RS_FORMAT_Z16)
+    // Only the tiles that changed are copied over the previous frame
+    find_changed_tiles(tiles, previous.data(), width, image.data, image.stride, width, height, pixel_size);
+    for(int tile_row = 0; tile_row < tiles.rows && tiles.count; ++tile_row)
+    {
+        const int y0 = tile_row * changed_tiles::tile_height, y1 = std::min<int>(y0 + changed_tiles::tile_height, height);
+        for(int i = 0; i < tiles.columns; ++i)
         {
-            deproject_z(reinterpret_cast<float *>(image.data()), get_intrinsics(), reinterpret_cast<const uint16_t *>(source.get_frame_data()), get_depth_scale());
+            if(!tiles.changed[tile_row * tiles.columns + i]) continue;
+            const int x = i * changed_tiles::tile_width, bytes = (std::min<int>(x + changed_tiles::tile_width, width) - x) * pixel_size;
+            for(int y = y0; y < y1; ++y) memcpy(previous.data() + (y * width + x) * pixel_size, image.data + (y * image.stride + x) * pixel_size, bytes);
         }
-        else if(source.get_format() == RS_FORMAT_DISPARITY16)
+    }
+    return &tiles;
+}
+
+// Copies rows of an image to rows dest_stride pixels apart
+static void copy_rows(byte * dest, int dest_stride, const source_image & image, int width, int height, rs_format format)
+{
+    const size_t pixel_size = get_image_bpp(format) / 8;
+    for(int y = 0; y < height; ++y) memcpy(dest + y * dest_stride * pixel_size, image.data + y * image.stride * pixel_size, width * pixel_size);
+}
+
+// The window of an image, read in place through the stride of the image, so that kernels over the whole image only visit the window.
+// The runs of a depth image only describe the whole image.
+static source_image window_image(const source_image & image, const rs_intrinsics & image_intrin, const stream_roi & roi, rs_format format)
+{
+    if(roi.is_full_image()) return image;
+    const auto window = roi.clip(image_intrin.width, image_intrin.height);
+    return {image.data + (window.y * image.stride + window.x) * (get_image_bpp(format) / 8), image.stride, nullptr};
+}
+
+// Returns the image itself if its rows are packed, for code that walks the image as a single span
+static const byte * pack_image(std::vector<byte> & packed, const source_image & image, int width, int height, rs_format format)
+{
+    if(image.stride == width) return image.data;
+    packed.resize(get_image_size(width, height, format));
+    copy_rows(packed.data(), width, image, width, height, format);
+    return packed.data();
+}
+
+// A packed copy of a depth image shrunk by a whole factor, so that aligning to a fraction of the resolution only projects a fraction of the pixels
+static source_image decimate_image(std::vector<byte> & decimated, const source_image & image, const rs_intrinsics & image_intrin, int factor, rs_format format)
+{
+    decimated.resize(get_image_size(image_intrin.width, image_intrin.height, format));
+    copy_rows(decimated.data(), image_intrin.width, image, image_intrin.width, image_intrin.height, format);
+    decimate_depth(reinterpret_cast<uint16_t *>(decimated.data()), image_intrin.width, image_intrin.height, factor, false);
+    return {decimated.data(), image_intrin.width / factor, nullptr};
+}
+
+// Bytes of every pixel of the formats the GPU copies pixels of whole, 0 for those it leaves to the CPU
+static int gpu_pixel_size(rs_format format)
+{
+    switch(format)
+    {
+    case RS_FORMAT_Y8: case RS_FORMAT_Y16: case RS_FORMAT_Z16: case RS_FORMAT_RGB8: case RS_FORMAT_BGR8: case RS_FORMAT_RGBA8: case RS_FORMAT_BGRA8: return get_image_bpp(format) / 8;
+    default: return 0;
+    }
+}
+
+void point_stream::compute_frame(byte * dest, const source_frame_lookup & lookup) const
+{
+    compute_frame(dest, lookup, false);
+}
+
+void point_stream::compute_frame(byte * dest, const source_frame_lookup & lookup, bool incremental) const
+{
+    RS_TRACE_SPAN("points");
+    // The rays only depend on the intrinsics, so they are computed once for every mode the stream is started in
+    const auto intrin = get_intrinsics();
+    const auto rays = table.get(intrin, [&intrin]() { return compute_deprojection_table(intrin); });
+    const auto depth_image = window_image(lookup(source), source.get_intrinsics(), roi, source.get_format());
+    const auto depth = reinterpret_cast<const uint16_t *>(depth_image.data);
+    image_strides strides(depth_image.stride, 0, get_row_stride());
+    strides.source_runs = depth_image.depth_runs;
+
+    if(voxel_size > 0)
+    {
+        // Texture coordinates are only computed per pixel
+        if(format == RS_FORMAT_XYZUV32F) throw std::runtime_error("points with texture coordinates cannot be reduced to voxels");
+        if(format == RS_FORMAT_XYZ32F_PLANAR) throw std::runtime_error("planar points cannot be reduced to voxels");
+        if(source.get_format() == RS_FORMAT_Z16) deproject_z_to_voxels(dest, format, *rays, depth, get_depth_scale(), voxel_size, intrin.width, strides.source);
+        else if(source.get_format() == RS_FORMAT_DISPARITY16) deproject_disparity_to_voxels(dest, format, *rays, depth, *depth_table.get(get_depth_scale()), voxel_size, intrin.width, strides.source);
+        else assert(false && "Cannot deproject image from a non-depth format");
+    }
+    else if(format == RS_FORMAT_XYZUV32F)
+    {
+        // Texture coordinates come from the same calibration the color stream is aligned to depth with
+        const auto depth_to_texture = source.get_extrinsics_to(texture);
+        const auto texture_intrin = texture.get_intrinsics();
+        if(source.get_format() == RS_FORMAT_Z16) deproject_z_textured(dest, *rays, depth, get_depth_scale(), depth_to_texture, texture_intrin, intrin.width, strides);
+        else if(source.get_format() == RS_FORMAT_DISPARITY16) deproject_disparity_textured(dest, *rays, depth, *depth_table.get(get_depth_scale()), depth_to_texture, texture_intrin, intrin.width, strides);
+        else assert(false && "Cannot deproject image from a non-depth format");
+    }
+    else if(source.get_format() == RS_FORMAT_Z16)
+    {
+        // The GPU writes a single span of points, so it reads a packed copy of a strided depth image
+        if(gpu.get() && format == RS_FORMAT_XYZ32F && strides.dest == intrin.width)
         {
-            deproject_disparity(reinterpret_cast<float *>(image.data()), get_intrinsics(), reinterpret_cast<const uint16_t *>(source.get_frame_data()), get_depth_scale());
+            std::vector<byte> packed;
+            gpu.get()->deproject_z(reinterpret_cast<float *>(dest), rays, reinterpret_cast<const uint16_t *>(pack_image(packed, depth_image, intrin.width, intrin.height, source.get_format())), intrin.width * intrin.height, get_depth_scale());
         }
-        else assert(false && "Cannot deproject image from a non-depth format");
+        else
+        {
+            // Points are deprojected pixel by pixel, so only those of the tiles whose depth changed are rewritten
+            if(incremental) strides.source_changes = previous_source.update(depth_image, intrin.width, intrin.height, sizeof(uint16_t), rays, get_depth_scale());
+            deproject_z(dest, format, *rays, depth, get_depth_scale(), intrin.width, strides);
+        }
+    }
+    else if(source.get_format() == RS_FORMAT_DISPARITY16)
+    {
+        if(incremental) strides.source_changes = previous_source.update(depth_image, intrin.width, intrin.height, sizeof(uint16_t), rays, get_depth_scale());
+        deproject_disparity(dest, format, *rays, depth, *depth_table.get(get_depth_scale()), intrin.width, strides);
+    }
+    else assert(false && "Cannot deproject image from a non-depth format");
+}
 
+const uint8_t * point_stream::get_frame_data() const
+{
+    if(auto precomputed = source.get_precomputed_frame_data(stream)) return precomputed;
+
+    std::lock_guard<std::mutex> lock(image_mutex);
+    if(image.empty() || number != get_frame_number())
+    {
+        const auto size = get_image_size(get_row_stride(), get_intrinsics().height, get_format());
+        if(image.size() != size) { previous_source.reset(); } // The frames kept are no longer those the image was computed from
+        image.resize(size);
+        compute_frame(image.data(), get_frontbuffer_image, true);
         number = get_frame_number();
     }
     return image.data();
 }
 
+void normal_stream::compute_frame(byte * dest, const source_frame_lookup & lookup) const
+{
+    RS_TRACE_SPAN("normals");
+    // The window is a depth image of its own, whose border pixels have no normal
+    const auto intrin = get_intrinsics();
+    const auto rays = table.get(intrin, [&intrin]() { return compute_deprojection_table(intrin); });
+    const auto depth_image = window_image(lookup(source), source.get_intrinsics(), roi, source.get_format());
+    const auto depth = reinterpret_cast<const uint16_t *>(depth_image.data);
+    const image_strides strides(depth_image.stride, 0, get_row_stride());
+    if(source.get_format() == RS_FORMAT_Z16) compute_z_normals(reinterpret_cast<float *>(dest), *rays, depth, get_depth_scale(), intrin.width, intrin.height, strides);
+    else if(source.get_format() == RS_FORMAT_DISPARITY16) compute_disparity_normals(reinterpret_cast<float *>(dest), *rays, depth, *depth_table.get(get_depth_scale()), intrin.width, intrin.height, strides);
+    else throw std::runtime_error(to_string() << "cannot compute normals of depth of format " << source.get_format());
+}
+
+const uint8_t * normal_stream::get_frame_data() const
+{
+    if(auto precomputed = source.get_precomputed_frame_data(stream)) return precomputed;
+
+    std::lock_guard<std::mutex> lock(image_mutex);
+    if(image.empty() || number != get_frame_number())
+    {
+        image.resize(get_image_size(get_row_stride(), get_intrinsics().height, get_format()));
+        compute_frame(image.data(), get_frontbuffer_image);
+        number = get_frame_number();
+    }
+    return image.data();
+}
+
+rs_intrinsics rectified_stream::get_intrinsics() const
+{
+    // A fish-eye source is undistorted into a pinhole image of the same focal length and principal point
+    auto intrin = source.get_rectified_intrinsics();
+    if(intrin.model == RS_DISTORTION_FTHETA)
+    {
+        intrin.model = RS_DISTORTION_NONE;
+        for(auto & c : intrin.coeffs) c = 0;
+    }
+    return roi.crop(intrin);
+}
+
+void rectified_stream::compute_frame(byte * dest, const source_frame_lookup & lookup) const
+{
+    compute_frame(dest, lookup, false);
+}
+
+void rectified_stream::compute_frame(byte * dest, const source_frame_lookup & lookup, bool incremental) const
+{
+    RS_TRACE_SPAN("rectify");
+    // If source image is already rectified, it is copied as is, or only its window
+    const auto source_intrin = source.get_intrinsics();
+    const auto unrect = lookup(source);
+    if(get_pose() == source.get_pose() && source.get_rectified_intrinsics() == source_intrin && source_intrin.model != RS_DISTORTION_FTHETA)
+    {
+        const auto window = roi.crop(source_intrin);
+        copy_rows(dest, get_row_stride(), window_image(unrect, source_intrin, roi, get_format()), window.width, window.height, get_format());
+        return;
+    }
+
+    // The table is rebuilt whenever the source is started in a different mode, or its frames change stride
+    const rectification_calibration calib = {get_intrinsics(), source_intrin, unrect.stride};
+    if(source_intrin.model == RS_DISTORTION_FTHETA)
+    {
+        const auto remap = remap_table.get(calib, [this, &calib]() { return compute_fisheye_remap_table(calib.rect_intrin, get_extrinsics_to(source), calib.unrect_intrin, calib.unrect_stride); });
+        remap_fisheye_image(dest, *remap, unrect.data, get_row_stride());
+        return;
+    }
+    const auto rect_table = table.get(calib, [this, &calib]() { return compute_rectification_table(calib.rect_intrin, get_extrinsics_to(source), calib.unrect_intrin, calib.unrect_stride); });
+    if(gpu.get() && gpu_pixel_size(get_format()) && get_row_stride() == calib.rect_intrin.width) gpu.get()->rectify_image(dest, rect_table, unrect.data, unrect.stride * source_intrin.height, gpu_pixel_size(get_format()));
+    else rectify_image(dest, *rect_table, unrect.data, get_format(), get_row_stride(), incremental ? previous_source.update(unrect, source_intrin.width, source_intrin.height, get_frame_bpp() / 8, rect_table, 0) : nullptr);
+}
+
 const uint8_t * rectified_stream::get_frame_data() const
 {
     // If source image is already rectified, just return it without doing any work
-    if(get_pose() == source.get_pose() && get_intrinsics() == source.get_intrinsics()) return source.get_frame_data();
+    if(get_pose() == source.get_pose() && get_intrinsics() == source.get_intrinsics() && get_row_stride() == source.get_row_stride()) return source.get_frame_data();
+    if(auto precomputed = source.get_precomputed_frame_data(stream)) return precomputed;
 
+    std::lock_guard<std::mutex> lock(image_mutex);
     if(image.empty() || number != get_frame_number())
     {
-        if(table.empty()) table = compute_rectification_table(get_intrinsics(), get_extrinsics_to(source), source.get_intrinsics());
-        image.resize(get_image_size(get_intrinsics().width, get_intrinsics().height, get_format()));
-        rectify_image(image.data(), table, source.get_frame_data(), get_format());
+        const auto size = get_image_size(get_row_stride(), get_intrinsics().height, get_format());
+        if(image.size() != size) { previous_source.reset(); } // The frames kept are no longer those the image was computed from
+        image.resize(size);
+        compute_frame(image.data(), get_frontbuffer_image, true);
         number = get_frame_number();
     }
     return image.data();
 }
 
-const uint8_t * aligned_stream::get_frame_data() const
+void aligned_stream::compute_frame(byte * dest, const source_frame_lookup & lookup) const
 {
-    if(image.empty() || number != get_frame_number())
+    compute_frame(dest, lookup, false);
+}
+
+void aligned_stream::compute_frame(byte * dest, const source_frame_lookup & lookup, bool incremental) const
+{
+    RS_TRACE_SPAN("align");
+    // The rays through the depth image only depend on the calibration, so they are computed once for every mode the streams are started in
+    // The window is taken in the image the stream is aligned to: into the other image when depth is being aligned, or out of the depth image, whose pixels then are the only ones visited
+    const bool from_depth = from.get_format() == RS_FORMAT_Z16 || from.get_format() == RS_FORMAT_DISPARITY16;
+    const auto & depth = from_depth ? from : to, & other = from_depth ? to : from;
+    const alignment_calibration calib = {from_depth ? decimate_intrinsics(depth.get_intrinsics(), decimation) : get_intrinsics(), depth.get_extrinsics_to(other)};
+    const auto other_intrin = from_depth ? get_intrinsics() : other.get_intrinsics();
+    std::vector<byte> decimated_depth;
+    const auto whole_depth = decimation > 1 ? decimate_image(decimated_depth, lookup(depth), depth.get_intrinsics(), decimation, depth.get_format()) : lookup(depth);
+    const auto depth_image = from_depth ? whole_depth : window_image(whole_depth, decimate_intrinsics(depth.get_intrinsics(), decimation), roi, depth.get_format());
+    const auto other_image = from_depth ? source_image{nullptr, 0, nullptr} : lookup(from);
+    const auto depth_pixels = reinterpret_cast<const uint16_t *>(depth_image.data);
+    image_strides strides(depth_image.stride, other_image.stride, get_row_stride());
+    strides.source_runs = depth_image.depth_runs; // Dropped by decimation and windows, which leave their own pixels
+    const auto depth_rays = rays.get(calib, [&calib]() { return compute_alignment_rays(calib.depth_intrin, calib.depth_to_other); });
+    const auto & depth_intrin = calib.depth_intrin;
+    const auto & depth_to_other = calib.depth_to_other;
+
+    // A pixel that moves can land anywhere in the aligned image, so it is only kept whole, for as long as neither image changes
+    if(incremental)
     {
-        image.resize(get_image_size(get_intrinsics().width, get_intrinsics().height, get_format()));
-        memset(image.data(), from.get_format() == RS_FORMAT_DISPARITY16 ? 0xFF : 0x00, image.size());
+        const auto depth_changes = previous_depth.update(depth_image, depth_intrin.width, depth_intrin.height, sizeof(uint16_t), depth_rays, depth.get_depth_scale());
+        const auto other_changes = from_depth ? depth_changes : previous_other.update(other_image, other_intrin.width, other_intrin.height, from.get_frame_bpp() / 8, depth_rays, 0);
+        if(depth_changes && other_changes && !depth_changes->count && !other_changes->count) return;
+    }
+
+    // The GPU writes every pixel of the packed images it aligns, reading packed copies of strided sources
+    if(gpu.get() && strides.dest == get_intrinsics().width)
+    {
+        std::vector<byte> packed_depth, packed_other;
         if(from.get_format() == RS_FORMAT_Z16)
         {
-            align_z_to_other(image.data(), (const uint16_t *)from.get_frame_data(), from.get_depth_scale(), from.get_intrinsics(), from.get_extrinsics_to(to), to.get_intrinsics());
+            gpu.get()->align_z_to_other(reinterpret_cast<uint16_t *>(dest), (const uint16_t *)pack_image(packed_depth, depth_image, depth_intrin.width, depth_intrin.height, RS_FORMAT_Z16),
+                                        from.get_depth_scale(), depth_intrin, depth_rays, depth_to_other, other_intrin);
+            return;
         }
-        else if(from.get_format() == RS_FORMAT_DISPARITY16)
+        if(to.get_format() == RS_FORMAT_Z16 && gpu_pixel_size(from.get_format()))
         {
-            align_disparity_to_other(image.data(), (const uint16_t *)from.get_frame_data(), from.get_depth_scale(), from.get_intrinsics(), from.get_extrinsics_to(to), to.get_intrinsics());
+            gpu.get()->align_other_to_z(dest, (const uint16_t *)pack_image(packed_depth, depth_image, depth_intrin.width, depth_intrin.height, RS_FORMAT_Z16), to.get_depth_scale(), depth_intrin, depth_rays, depth_to_other,
+                                        other_intrin, pack_image(packed_other, other_image, other_intrin.width, other_intrin.height, from.get_format()), gpu_pixel_size(from.get_format()));
+            return;
         }
-        else if(to.get_format() == RS_FORMAT_Z16)
-        {
-            align_other_to_z(image.data(), (const uint16_t *)to.get_frame_data(), to.get_depth_scale(), to.get_intrinsics(), to.get_extrinsics_to(from), from.get_intrinsics(), from.get_frame_data(), from.get_format());
-        }
-        else if(to.get_format() == RS_FORMAT_DISPARITY16)
-        {
-            align_other_to_disparity(image.data(), (const uint16_t *)to.get_frame_data(), to.get_depth_scale(), to.get_intrinsics(), to.get_extrinsics_to(from), from.get_intrinsics(), from.get_frame_data(), from.get_format());
-        }
-        else assert(false && "Cannot align two images if neither have depth data");
+    }
+
+    memset(dest, from.get_format() == RS_FORMAT_DISPARITY16 ? 0xFF : 0x00, get_image_size(strides.dest, get_intrinsics().height, get_format()));
+    if(from.get_format() == RS_FORMAT_Z16)
+    {
+        align_z_to_other(dest, depth_pixels, from.get_depth_scale(), depth_intrin, *depth_rays, depth_to_other, other_intrin, strides);
+    }
+    else if(from.get_format() == RS_FORMAT_DISPARITY16)
+    {
+        align_disparity_to_other(dest, depth_pixels, *depth_table.get(from.get_depth_scale()), depth_intrin, *depth_rays, depth_to_other, other_intrin, strides);
+    }
+    else if(from.get_format() == RS_FORMAT_YUYV && to.get_format() == RS_FORMAT_Z16)
+    {
+        align_yuy2_to_z(dest, depth_pixels, to.get_depth_scale(), depth_intrin, *depth_rays, depth_to_other, other_intrin, other_image.data, strides);
+    }
+    else if(from.get_format() == RS_FORMAT_YUYV && to.get_format() == RS_FORMAT_DISPARITY16)
+    {
+        align_yuy2_to_disparity(dest, depth_pixels, *depth_table.get(to.get_depth_scale()), depth_intrin, *depth_rays, depth_to_other, other_intrin, other_image.data, strides);
+    }
+    else if(to.get_format() == RS_FORMAT_Z16)
+    {
+        align_other_to_z(dest, depth_pixels, to.get_depth_scale(), depth_intrin, *depth_rays, depth_to_other, other_intrin, other_image.data, from.get_format(), strides);
+    }
+    else if(to.get_format() == RS_FORMAT_DISPARITY16)
+    {
+        align_other_to_disparity(dest, depth_pixels, *depth_table.get(to.get_depth_scale()), depth_intrin, *depth_rays, depth_to_other, other_intrin, other_image.data, from.get_format(), strides);
+    }
+    else assert(false && "Cannot align two images if neither have depth data");
+}
+
+const uint8_t * aligned_stream::get_frame_data() const
+{
+    if(auto precomputed = from.get_precomputed_frame_data(stream)) return precomputed;
+
+    std::lock_guard<std::mutex> lock(image_mutex);
+    if(image.empty() || number != get_frame_number())
+    {
+        const auto size = get_image_size(get_row_stride(), get_intrinsics().height, get_format());
+        if(image.size() != size) { previous_depth.reset(); previous_other.reset(); } // The frames kept are no longer those the image was computed from
+        image.resize(size);
+        compute_frame(image.data(), get_frontbuffer_image, true);
+        number = get_frame_number();
+    }
+    return image.data();
+}
+
+void colorized_stream::compute_frame(byte * dest, const source_frame_lookup & lookup) const
+{
+    RS_TRACE_SPAN("colorize");
+    if(source.get_format() != RS_FORMAT_Z16 && source.get_format() != RS_FORMAT_DISPARITY16) throw std::runtime_error(to_string() << "cannot colorize depth of format " << source.get_format());
+    const auto intrin = get_intrinsics();
+    // The colormap is computed over a single span of depth
+    std::vector<byte> packed;
+    const auto depth = reinterpret_cast<const uint16_t *>(pack_image(packed, window_image(lookup(source), source.get_intrinsics(), roi, source.get_format()), intrin.width, intrin.height, source.get_format()));
+    const auto disparity_to_depth = source.get_format() == RS_FORMAT_DISPARITY16 ? depth_table.get(get_depth_scale()) : nullptr;
+
+    std::lock_guard<std::mutex> lock(map_mutex);
+    update_depth_colormap(map, depth, intrin.width * intrin.height, get_depth_scale(), disparity_to_depth.get(), equalized, max_distance);
+    colorize_depth(dest, depth, intrin.width * intrin.height, map.lut.data());
+}
+
+const uint8_t * colorized_stream::get_frame_data() const
+{
+    if(auto precomputed = source.get_precomputed_frame_data(stream)) return precomputed;
+
+    std::lock_guard<std::mutex> lock(image_mutex);
+    if(image.empty() || number != get_frame_number())
+    {
+        image.resize(get_image_size(get_intrinsics().width, get_intrinsics().height, get_format()));
+        compute_frame(image.data(), get_frontbuffer_image);
         number = get_frame_number();
     }
     return image.data();
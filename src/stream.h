@@ -6,14 +6,43 @@
 #define LIBREALSENSE_STREAM_H
 
 #include "types.h"
+#include "image.h" // For rectification_table
+#include "gpu.h"
 
 #include <memory> // For shared_ptr
+#include <mutex>
+#include <functional>
 
 namespace rsimpl
 {
+    struct stream_interface;
+
+    // Frame data of a stream a derived image is computed from, whose rows start stride pixels apart
+    struct source_image
+    {
+        const byte * data;
+        int stride;
+        const uint32_t * depth_runs; // The runs of valid pixels found behind a depth frame, if any, see find_depth_runs
+    };
+    typedef std::function<source_image(const stream_interface & source)> source_frame_lookup;
+    source_image get_frontbuffer_image(const stream_interface & source); // The frame a stream currently presents, which the legacy API computes derived images from
+
+    // A window of the image of a derived stream, which is then the only part computed and handed out. All zero selects the whole image.
+    struct stream_roi
+    {
+        int x, y, width, height;
+
+        stream_roi() : x(), y(), width(), height() {}
+        stream_roi(int x, int y, int width, int height) : x(x), y(y), width(width), height(height) {}
+
+        bool                                    is_full_image() const { return !width || !height; }
+        stream_roi                              clip(int image_width, int image_height) const;  // The part of the window inside an image
+        rs_intrinsics                           crop(const rs_intrinsics & intrin) const;       // Intrinsics of the clipped window, whose principal point moves with its origin
+    };
+
     struct stream_interface : rs_stream_interface
     {
-        stream_interface(calibration_validator in_validator, rs_stream in_stream) : stream(in_stream), validator(in_validator){};
+        stream_interface(calibration_validator in_validator, rs_stream in_stream) : stream(in_stream), validator(in_validator), row_alignment(){};
                                                                  
         virtual rs_extrinsics                   get_extrinsics_to(const rs_stream_interface & other) const override;
         virtual rsimpl::pose                    get_pose() const = 0;
@@ -21,21 +50,56 @@ namespace rsimpl
         virtual void                            get_mode(int /*mode*/, int * /*w*/, int * /*h*/, rs_format * /*f*/, int * /*fps*/) const override { throw std::logic_error("no modes"); }
         virtual rs_stream                       get_stream_type()const override { return stream; }
 
+        // Derived streams compute their image from the frames of the streams they are built on. Safe to call from any thread.
+        virtual rs_stream                       get_frame_source() const { return stream; } // Stream whose frames provide the timestamp and metadata
+        virtual void                            compute_frame(byte * /*dest*/, const source_frame_lookup & /*lookup*/) const { throw std::logic_error("not a derived stream"); }
+        virtual const byte *                    get_precomputed_frame_data(rs_stream /*derived*/) const { return nullptr; } // Image of a derived stream computed ahead of the current frameset, if any
+        virtual const uint32_t *                get_frame_depth_runs() const { return nullptr; } // Runs of valid pixels of the current depth frame, if they were found
+        virtual size_t                          get_image_memory() const { return 0; } // Bytes of the image a derived stream keeps for get_frame_data
+        void                                    set_roi(const stream_roi & new_roi) { roi = new_roi; } // Derived streams only, while not streaming
+        void                                    set_row_alignment(int bytes) { row_alignment = bytes; } // Derived streams only, while not streaming. 0 packs the rows.
+        int                                     get_row_alignment() const { return row_alignment; }
+        virtual int                             get_row_stride() const { return get_frame_stride() * 8 / get_frame_bpp(); } // Pixels from the start of a row of frames to the next
+
         const rs_stream   stream;
 
     protected:
         calibration_validator validator;
+        stream_roi        roi;
+        int               row_alignment;
+
+        int                                     padded_row_stride(int width, int bpp) const; // Smallest stride of at least width pixels whose rows start on a multiple of the row alignment
     };
     
     class frame_archive;
     class syncronizing_archive;
 
+    // When the application last consumed the frames of every native stream, so that streams started on demand can be turned off while nobody
+    // reads them. Consuming a stream which was turned off invokes the wake handler, which is expected to turn it on again without blocking.
+    class stream_demand
+    {
+        std::atomic<long long>                  last_use[RS_STREAM_NATIVE_COUNT];   // Milliseconds of the steady clock, 0 if never consumed
+        std::atomic<int>                        idle_streams;                       // Bit mask of the streams turned off
+        std::function<void()>                   on_wake;
+    public:
+        stream_demand() : idle_streams(0) { reset(); }
+
+        static long long                        now();
+        void                                    set_wake_handler(std::function<void()> handler) { on_wake = handler; } // Before any stream is consumed
+        void                                    reset(); // Before streaming starts, forgetting every use
+        void                                    consume(rs_stream stream); // From any thread, whenever the frames of a native stream are read
+        long long                               get_last_use(rs_stream stream) const { return last_use[stream].load(std::memory_order_relaxed); }
+        void                                    set_idle(rs_stream stream, bool idle);
+        bool                                    is_idle(rs_stream stream) const { return (idle_streams.load(std::memory_order_relaxed) & (1 << stream)) != 0; }
+    };
+
     struct native_stream final : public stream_interface
     {
         const device_config &                   config;
         
         std::vector<subdevice_mode_selection>   modes;
         std::shared_ptr<syncronizing_archive>   archive;
+        stream_demand *                         demand;     // Told of every read of the frame data, if set
 
                                                 native_stream(device_config & config, rs_stream stream, calibration_validator in_validator);
 
@@ -57,54 +121,201 @@ namespace rsimpl
         double                                  get_frame_timestamp() const override;
         long long                               get_frame_system_time() const override;
         const uint8_t *                         get_frame_data() const override;
+        const byte *                            get_precomputed_frame_data(rs_stream derived) const override;
+        const uint32_t *                        get_frame_depth_runs() const override;
 
         int                                     get_frame_stride() const override;
         int                                     get_frame_bpp() const override;
     };
 
+    // A table computed from the calibration, rebuilt only when its key changes. Callers keep the table they were handed,
+    // so a rebuild on one thread never pulls the table out from under another.
+    template<class KEY, class TABLE> class calibration_cache
+    {
+        mutable std::mutex                      mutex;
+        mutable std::shared_ptr<const TABLE>    table;
+        mutable KEY                             key;
+    public:
+        calibration_cache() : key() {}
+
+        template<class BUILD> std::shared_ptr<const TABLE> get(const KEY & new_key, BUILD build) const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!table || !(key == new_key))
+            {
+                table = std::make_shared<TABLE>(build());
+                key = new_key;
+            }
+            return table;
+        }
+    };
+
+    // The disparity to depth table of a disparity stream, rebuilt only when the disparity scale changes
+    class disparity_table
+    {
+        calibration_cache<float, std::vector<float>> cache;
+    public:
+        std::shared_ptr<const std::vector<float>> get(float disparity_scale) const { return cache.get(disparity_scale, [disparity_scale]() { return compute_disparity_to_depth_table(disparity_scale); }); }
+    };
+
+    // The CUDA processor of a derived stream, present while RS_OPTION_GPU_PROCESSING_ENABLED is 1. Images it cannot compute stay on the CPU.
+    class gpu_offload
+    {
+        std::unique_ptr<gpu::processor>         processor;
+    public:
+        void                                    set_enabled(bool enabled) { processor.reset(enabled ? new gpu::processor() : nullptr); } // Only while not streaming
+        bool                                    is_enabled() const { return processor != nullptr; }
+        gpu::processor *                        get() const { return processor.get(); }
+    };
+
+    // The source frame a derived image was last computed from, kept while RS_OPTION_INCREMENTAL_PROCESSING_ENABLED is 1, so that the next
+    // frame is only recomputed in the tiles that differ from it. The calibration is held too, so that a rebuilt table never passes for the old one.
+    class incremental_source
+    {
+        bool                                    enabled;
+        std::vector<byte>                       previous;       // Packed
+        int                                     width, height, pixel_size;
+        std::shared_ptr<const void>             calibration;
+        float                                   scale;
+        changed_tiles                           tiles;
+    public:
+        incremental_source() : enabled(), width(), height(), pixel_size(), scale() {}
+
+        void                                    set_enabled(bool enable) { enabled = enable; reset(); } // Only while not streaming
+        bool                                    is_enabled() const { return enabled; }
+        void                                    reset() { previous.clear(); calibration.reset(); }
+
+        // Compares a frame to the previous one and keeps it in its place. Returns the tiles that changed, or nullptr if the whole derived
+        // image is to be computed: while disabled, for the first frame, and whenever the shape of the frames or the calibration changes.
+        const changed_tiles *                   update(const source_image & image, int width, int height, int pixel_size, std::shared_ptr<const void> calibration, float scale);
+    };
+
+    struct alignment_calibration
+    {
+        rs_intrinsics                           depth_intrin;
+        rs_extrinsics                           depth_to_other;
+    };
+    inline bool operator == (const alignment_calibration & a, const alignment_calibration & b) { return a.depth_intrin == b.depth_intrin && a.depth_to_other == b.depth_to_other; }
+
+    struct rectification_calibration
+    {
+        rs_intrinsics                           rect_intrin;
+        rs_intrinsics                           unrect_intrin;
+        int                                     unrect_stride;
+    };
+    inline bool operator == (const rectification_calibration & a, const rectification_calibration & b) { return a.rect_intrin == b.rect_intrin && a.unrect_intrin == b.unrect_intrin && a.unrect_stride == b.unrect_stride; }
+
     class point_stream final : public stream_interface
+    {
+        const stream_interface &                source, & texture;
+        calibration_cache<rs_intrinsics, std::vector<float>> table;
+        disparity_table                         depth_table;
+        mutable std::mutex                      image_mutex;
+        mutable std::vector<uint8_t>            image;
+        mutable unsigned long long              number;
+        rs_format                               format;
+        float                                   voxel_size;
+        gpu_offload                             gpu;
+        mutable incremental_source              previous_source;
+
+        void                                    compute_frame(byte * dest, const source_frame_lookup & lookup, bool incremental) const; // Incrementally only into the image kept for get_frame_data
+    public:
+        point_stream(const stream_interface & source, const stream_interface & texture) :stream_interface(calibration_validator(), RS_STREAM_POINTS), source(source), texture(texture), number(), format(RS_FORMAT_XYZ32F), voxel_size() {}
+
+        void                                    set_format(rs_format points_format) { format = points_format; } // XYZ32F, XYZ16F, XYZ16, XYZUV32F or XYZ32F_PLANAR, only while not streaming
+        void                                    set_voxel_size(float size) { voxel_size = size; } // Meters, 0 keeps one point per pixel, only while not streaming
+        float                                   get_voxel_size() const { return voxel_size; }
+        void                                    set_gpu_processing(bool enabled) { gpu.set_enabled(enabled); } // Only while not streaming
+        bool                                    is_gpu_processing() const { return gpu.is_enabled(); }
+        void                                    set_incremental_processing(bool enabled) { previous_source.set_enabled(enabled); } // Only while not streaming
+        bool                                    is_incremental_processing() const { return previous_source.is_enabled(); }
+
+        pose                                    get_pose() const override { return {{{1,0,0},{0,1,0},{0,0,1}}, source.get_pose().position}; }
+        float                                   get_depth_scale() const override { return source.get_depth_scale(); }
+
+        bool                                    is_enabled() const override { return source.is_enabled() && (format != RS_FORMAT_XYZUV32F || texture.is_enabled()); }
+        rs_intrinsics                           get_intrinsics() const override { return roi.crop(source.get_intrinsics()); }
+        rs_intrinsics                           get_rectified_intrinsics() const override { return roi.crop(source.get_rectified_intrinsics()); }
+        rs_format                               get_format() const override { return format; }
+        int                                     get_framerate() const override { return source.get_framerate(); }
+
+        double                                  get_frame_metadata(rs_frame_metadata frame_metadata) const override { return source.get_frame_metadata(frame_metadata); }
+        bool                                    supports_frame_metadata(rs_frame_metadata frame_metadata) const override { return source.supports_frame_metadata(frame_metadata); }
+        unsigned long long                      get_frame_number() const override { return source.get_frame_number(); }
+        double                                  get_frame_timestamp() const override{ return source.get_frame_timestamp(); }
+        long long                               get_frame_system_time() const override { return source.get_frame_system_time(); }
+        const uint8_t *                         get_frame_data() const override;
+        rs_stream                               get_frame_source() const override { return source.get_frame_source(); }
+        const byte *                            get_precomputed_frame_data(rs_stream derived) const override { return source.get_precomputed_frame_data(derived); }
+        void                                    compute_frame(byte * dest, const source_frame_lookup & lookup) const override;
+        size_t                                  get_image_memory() const override { std::lock_guard<std::mutex> lock(image_mutex); return image.capacity(); }
+
+        int                                     get_frame_stride() const override { return get_row_stride() * get_frame_bpp() / 8; }
+        int                                     get_frame_bpp() const override { return get_image_bpp(format); }
+        int                                     get_row_stride() const override { return voxel_size > 0 ? get_intrinsics().width : padded_row_stride(get_intrinsics().width, get_frame_bpp()); } // Voxels are a list
+    };
+
+    // The surface normals of the depth image, computed from the depth itself rather than from the points stream, so they never wait on it
+    class normal_stream final : public stream_interface
     {
         const stream_interface &                source;
+        calibration_cache<rs_intrinsics, std::vector<float>> table;
+        disparity_table                         depth_table;
+        mutable std::mutex                      image_mutex;
         mutable std::vector<uint8_t>            image;
         mutable unsigned long long              number;
     public:
-        point_stream(const stream_interface & source) :stream_interface(calibration_validator(), RS_STREAM_POINTS), source(source), number() {}
+        normal_stream(const stream_interface & source) : stream_interface(calibration_validator(), RS_STREAM_NORMALS), source(source), number() {}
 
         pose                                    get_pose() const override { return {{{1,0,0},{0,1,0},{0,0,1}}, source.get_pose().position}; }
         float                                   get_depth_scale() const override { return source.get_depth_scale(); }
 
         bool                                    is_enabled() const override { return source.is_enabled(); }
-        rs_intrinsics                           get_intrinsics() const override { return source.get_intrinsics(); }
-        rs_intrinsics                           get_rectified_intrinsics() const override { return source.get_rectified_intrinsics(); }
+        rs_intrinsics                           get_intrinsics() const override { return roi.crop(source.get_intrinsics()); }
+        rs_intrinsics                           get_rectified_intrinsics() const override { return roi.crop(source.get_rectified_intrinsics()); }
         rs_format                               get_format() const override { return RS_FORMAT_XYZ32F; }
         int                                     get_framerate() const override { return source.get_framerate(); }
 
         double                                  get_frame_metadata(rs_frame_metadata frame_metadata) const override { return source.get_frame_metadata(frame_metadata); }
         bool                                    supports_frame_metadata(rs_frame_metadata frame_metadata) const override { return source.supports_frame_metadata(frame_metadata); }
         unsigned long long                      get_frame_number() const override { return source.get_frame_number(); }
-        double                                  get_frame_timestamp() const override{ return source.get_frame_timestamp(); }
+        double                                  get_frame_timestamp() const override { return source.get_frame_timestamp(); }
         long long                               get_frame_system_time() const override { return source.get_frame_system_time(); }
         const uint8_t *                         get_frame_data() const override;
+        rs_stream                               get_frame_source() const override { return source.get_frame_source(); }
+        const byte *                            get_precomputed_frame_data(rs_stream derived) const override { return source.get_precomputed_frame_data(derived); }
+        void                                    compute_frame(byte * dest, const source_frame_lookup & lookup) const override;
+        size_t                                  get_image_memory() const override { std::lock_guard<std::mutex> lock(image_mutex); return image.capacity(); }
 
-        int                                     get_frame_stride() const override { return source.get_frame_stride(); }
-        int                                     get_frame_bpp() const override { return source.get_frame_bpp(); }
+        int                                     get_frame_stride() const override { return get_row_stride() * get_frame_bpp() / 8; }
+        int                                     get_frame_bpp() const override { return get_image_bpp(RS_FORMAT_XYZ32F); }
+        int                                     get_row_stride() const override { return padded_row_stride(get_intrinsics().width, get_frame_bpp()); }
     };
 
     class rectified_stream final : public stream_interface
     {
         const stream_interface &                source;
-        mutable std::vector<int>                table;
+        calibration_cache<rectification_calibration, rectification_table> table;
+        calibration_cache<rectification_calibration, fisheye_remap_table> remap_table; // For f-theta sources, which are sampled bilinearly
+        mutable std::mutex                      image_mutex;
         mutable std::vector<uint8_t>            image;
         mutable unsigned long long              number;
+        gpu_offload                             gpu;
+        mutable incremental_source              previous_source;
+
+        void                                    compute_frame(byte * dest, const source_frame_lookup & lookup, bool incremental) const; // Incrementally only into the image kept for get_frame_data
     public:
-        rectified_stream(const stream_interface & source) : stream_interface(calibration_validator(), RS_STREAM_RECTIFIED_COLOR), source(source), number() {}
+        rectified_stream(const stream_interface & source, rs_stream stream = RS_STREAM_RECTIFIED_COLOR) : stream_interface(calibration_validator(), stream), source(source), number() {}
+
+        void                                    set_gpu_processing(bool enabled) { gpu.set_enabled(enabled); } // Only while not streaming
+        void                                    set_incremental_processing(bool enabled) { previous_source.set_enabled(enabled); } // Only while not streaming
 
         pose                                    get_pose() const override { return {{{1,0,0},{0,1,0},{0,0,1}}, source.get_pose().position}; }
         float                                   get_depth_scale() const override { return source.get_depth_scale(); }
 
         bool                                    is_enabled() const override { return source.is_enabled(); }
-        rs_intrinsics                           get_intrinsics() const override { return source.get_rectified_intrinsics(); }
-        rs_intrinsics                           get_rectified_intrinsics() const override { return source.get_rectified_intrinsics(); }
+        rs_intrinsics                           get_intrinsics() const override;
+        rs_intrinsics                           get_rectified_intrinsics() const override { return get_intrinsics(); }
         rs_format                               get_format() const override { return source.get_format(); }
         int                                     get_framerate() const override { return source.get_framerate(); }
 
@@ -114,26 +325,44 @@ namespace rsimpl
         double                                  get_frame_timestamp() const override { return source.get_frame_timestamp(); }
         long long                               get_frame_system_time() const override { return source.get_frame_system_time(); }
         const uint8_t *                         get_frame_data() const override;
+        rs_stream                               get_frame_source() const override { return source.get_frame_source(); }
+        const byte *                            get_precomputed_frame_data(rs_stream derived) const override { return source.get_precomputed_frame_data(derived); }
+        void                                    compute_frame(byte * dest, const source_frame_lookup & lookup) const override;
+        size_t                                  get_image_memory() const override { std::lock_guard<std::mutex> lock(image_mutex); return image.capacity(); }
 
-        int                                     get_frame_stride() const override { return source.get_frame_stride(); }
+        int                                     get_frame_stride() const override { return get_row_stride() * get_frame_bpp() / 8; }
         int                                     get_frame_bpp() const override { return source.get_frame_bpp(); }
+        int                                     get_row_stride() const override { return padded_row_stride(get_intrinsics().width, get_frame_bpp()); }
     };
 
     class aligned_stream final : public stream_interface
     {
         const stream_interface &                from, & to;
+        calibration_cache<alignment_calibration, std::vector<float>> rays;
+        disparity_table                         depth_table;
+        mutable std::mutex                      image_mutex;
         mutable std::vector<uint8_t>            image;
         mutable unsigned long long              number;
+        gpu_offload                             gpu;
+        int                                     decimation;     // Both dimensions of the image aligned to are shrunk by this factor
+        mutable incremental_source              previous_depth, previous_other;
+
+        void                                    compute_frame(byte * dest, const source_frame_lookup & lookup, bool incremental) const; // Incrementally only into the image kept for get_frame_data
     public:
-        aligned_stream(const stream_interface & from, const stream_interface & to) :stream_interface(calibration_validator(), RS_STREAM_COLOR_ALIGNED_TO_DEPTH), from(from), to(to), number() {}
+        aligned_stream(const stream_interface & from, const stream_interface & to, rs_stream stream) :stream_interface(calibration_validator(), stream), from(from), to(to), number(), decimation(1) {}
+
+        void                                    set_gpu_processing(bool enabled) { gpu.set_enabled(enabled); } // Only while not streaming
+        void                                    set_incremental_processing(bool enabled) { previous_depth.set_enabled(enabled); previous_other.set_enabled(enabled); } // Only while not streaming
+        void                                    set_decimation(int factor) { decimation = factor; } // Only while not streaming
+        int                                     get_decimation() const { return decimation; }
 
         pose                                    get_pose() const override { return to.get_pose(); }
         float                                   get_depth_scale() const override { return to.get_depth_scale(); }
 
         bool                                    is_enabled() const override { return from.is_enabled() && to.is_enabled(); }
-        rs_intrinsics                           get_intrinsics() const override { return to.get_intrinsics(); }
-        rs_intrinsics                           get_rectified_intrinsics() const override { return to.get_rectified_intrinsics(); }
-        rs_format                               get_format() const override { return from.get_format(); }
+        rs_intrinsics                           get_intrinsics() const override { return roi.crop(decimate_intrinsics(to.get_intrinsics(), decimation)); }
+        rs_intrinsics                           get_rectified_intrinsics() const override { return roi.crop(decimate_intrinsics(to.get_rectified_intrinsics(), decimation)); }
+        rs_format                               get_format() const override { return from.get_format() == RS_FORMAT_YUYV ? RS_FORMAT_RGB8 : from.get_format(); } // YUYV is converted while it is aligned
         int                                     get_framerate() const override { return from.get_framerate(); }
 
         double                                  get_frame_metadata(rs_frame_metadata frame_metadata) const override { return from.get_frame_metadata(frame_metadata); }
@@ -142,9 +371,57 @@ namespace rsimpl
         double                                  get_frame_timestamp() const override { return from.get_frame_timestamp(); }
         long long                               get_frame_system_time() const override { return from.get_frame_system_time(); }
         const unsigned char *                   get_frame_data() const override;
+        rs_stream                               get_frame_source() const override { return from.get_frame_source(); }
+        const byte *                            get_precomputed_frame_data(rs_stream derived) const override { return from.get_precomputed_frame_data(derived); }
+        void                                    compute_frame(byte * dest, const source_frame_lookup & lookup) const override;
+        size_t                                  get_image_memory() const override { std::lock_guard<std::mutex> lock(image_mutex); return image.capacity(); }
+
+        int                                     get_frame_stride() const override { return get_row_stride() * get_frame_bpp() / 8; }
+        int                                     get_frame_bpp() const override { return from.get_format() == RS_FORMAT_YUYV ? get_image_bpp(RS_FORMAT_RGB8) : from.get_frame_bpp(); }
+        int                                     get_row_stride() const override { return padded_row_stride(get_intrinsics().width, get_frame_bpp()); }
+    };
+
+    // The depth image colored for display. The colormap carries over from frame to frame, so frames are colorized one at a time.
+    class colorized_stream final : public stream_interface
+    {
+        const stream_interface &                source;
+        disparity_table                         depth_table;
+        mutable std::mutex                      image_mutex;
+        mutable std::vector<uint8_t>            image;
+        mutable unsigned long long              number;
+        mutable std::mutex                      map_mutex;
+        mutable depth_colormap                  map;
+        bool                                    equalized;
+        float                                   max_distance;
+    public:
+        colorized_stream(const stream_interface & source) : stream_interface(calibration_validator(), RS_STREAM_DEPTH_COLORIZED), source(source), number(), equalized(true), max_distance(6) {}
+
+        void                                    set_colormap(bool equalize, float max_meters) { std::lock_guard<std::mutex> lock(map_mutex); equalized = equalize; max_distance = max_meters; } // Also while streaming
+        bool                                    is_equalized() const { std::lock_guard<std::mutex> lock(map_mutex); return equalized; }
+        float                                   get_max_distance() const { std::lock_guard<std::mutex> lock(map_mutex); return max_distance; }
+
+        pose                                    get_pose() const override { return source.get_pose(); }
+        float                                   get_depth_scale() const override { return source.get_depth_scale(); }
+
+        bool                                    is_enabled() const override { return source.is_enabled(); }
+        rs_intrinsics                           get_intrinsics() const override { return roi.crop(source.get_intrinsics()); }
+        rs_intrinsics                           get_rectified_intrinsics() const override { return roi.crop(source.get_rectified_intrinsics()); }
+        rs_format                               get_format() const override { return RS_FORMAT_RGB8; }
+        int                                     get_framerate() const override { return source.get_framerate(); }
+
+        double                                  get_frame_metadata(rs_frame_metadata frame_metadata) const override { return source.get_frame_metadata(frame_metadata); }
+        bool                                    supports_frame_metadata(rs_frame_metadata frame_metadata) const override { return source.supports_frame_metadata(frame_metadata); }
+        unsigned long long                      get_frame_number() const override { return source.get_frame_number(); }
+        double                                  get_frame_timestamp() const override { return source.get_frame_timestamp(); }
+        long long                               get_frame_system_time() const override { return source.get_frame_system_time(); }
+        const uint8_t *                         get_frame_data() const override;
+        rs_stream                               get_frame_source() const override { return source.get_frame_source(); }
+        const byte *                            get_precomputed_frame_data(rs_stream derived) const override { return source.get_precomputed_frame_data(derived); }
+        void                                    compute_frame(byte * dest, const source_frame_lookup & lookup) const override;
+        size_t                                  get_image_memory() const override { std::lock_guard<std::mutex> lock(image_mutex); return image.capacity(); }
 
-        int                                     get_frame_stride() const override { return from.get_frame_stride(); }
-        int                                     get_frame_bpp() const override { return from.get_frame_bpp(); }
+        int                                     get_frame_stride() const override { return get_intrinsics().width * get_frame_bpp() / 8; }
+        int                                     get_frame_bpp() const override { return get_image_bpp(RS_FORMAT_RGB8); }
     };
 }
 
@@ -1,17 +1,109 @@
 #include <cmath>
 #include "sync.h"
+#include "trace.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#endif
 
 using namespace rsimpl;
 
+frames_ready_signal::frames_ready_signal() : armed(false), signaled(false)
+{
+#ifdef _WIN32
+    event = nullptr;
+#else
+    fds[0] = fds[1] = -1;
+#endif
+}
+
+frames_ready_signal::~frames_ready_signal()
+{
+#ifdef _WIN32
+    if (event) CloseHandle(event);
+#else
+    if (fds[1] != fds[0] && fds[1] >= 0) close(fds[1]);
+    if (fds[0] >= 0) close(fds[0]);
+#endif
+}
+
+void * frames_ready_signal::get_handle()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+#ifdef _WIN32
+    if (!event)
+    {
+        event = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+        if (!event) throw std::runtime_error(to_string() << "CreateEvent(...) failed with error " << GetLastError());
+    }
+    armed = true;
+    return event;
+#else
+    if (fds[0] < 0)
+    {
+#ifdef __linux__
+        fds[0] = fds[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fds[0] < 0) throw std::runtime_error(to_string() << "eventfd(...) failed with errno " << errno);
+#else
+        if (pipe(fds) < 0) throw std::runtime_error(to_string() << "pipe(...) failed with errno " << errno);
+        for (auto fd : fds)
+        {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+#endif
+    }
+    armed = true;
+    return reinterpret_cast<void *>(static_cast<intptr_t>(fds[0]));
+#endif
+}
+
+void frames_ready_signal::set()
+{
+    if (!armed || signaled.exchange(true)) return;
+#ifdef _WIN32
+    SetEvent(event);
+#elif defined(__linux__)
+    uint64_t one = 1;
+    if (write(fds[1], &one, sizeof(one)) < 0) LOG_WARNING("Could not signal frames ready event, errno " << errno);
+#else
+    char one = 1;
+    if (write(fds[1], &one, sizeof(one)) < 0) LOG_WARNING("Could not signal frames ready pipe, errno " << errno);
+#endif
+}
+
+void frames_ready_signal::reset()
+{
+    if (!armed || !signaled.exchange(false)) return;
+#ifdef _WIN32
+    ResetEvent(event);
+#else
+    char drain[64];
+    while (read(fds[0], drain, sizeof(drain)) > 0) {} // The descriptor is non-blocking, so this stops once it is empty
+#endif
+}
+
 syncronizing_archive::syncronizing_archive(const std::vector<subdevice_mode_selection> & selection,
     rs_stream key_stream,
     std::atomic<uint32_t>* max_size,
     std::atomic<uint32_t>* event_queue_size,
     std::atomic<uint32_t>* events_timeout,
+    const stream_queue_policy (&queue_policies)[RS_STREAM_NATIVE_COUNT],
+    std::shared_ptr<rs_frame_allocator> allocator,
     std::chrono::high_resolution_clock::time_point capture_started)
-    : frame_archive(selection, max_size, capture_started), key_stream(key_stream),
+    : frame_archive(selection, max_size, allocator, capture_started), key_stream(key_stream), idle_streams(0),
     ts_corrector(event_queue_size, events_timeout)
 {
+    std::copy(std::begin(queue_policies), std::end(queue_policies), std::begin(this->queue_policies));
+    std::fill(std::begin(leaders), std::end(leaders), RS_STREAM_COUNT);
+
     // Enumerate all streams we need to keep synchronized with the key stream
     for(auto s : {RS_STREAM_DEPTH, RS_STREAM_INFRARED, RS_STREAM_INFRARED2, RS_STREAM_COLOR, RS_STREAM_FISHEYE})
     {
@@ -31,85 +123,254 @@ syncronizing_archive::syncronizing_archive(const std::vector<subdevice_mode_sele
 
 const byte * syncronizing_archive::get_frame_data(rs_stream stream) const
 {
-    return frontbuffer.get_frame_data(stream);
+    return presented().get_frame_data(stream);
 }
 
 double syncronizing_archive::get_frame_timestamp(rs_stream stream) const
 {
-    return frontbuffer.get_frame_timestamp(stream);
+    return presented().get_frame_timestamp(stream);
 }
 
 int syncronizing_archive::get_frame_bpp(rs_stream stream) const
 {
-    return frontbuffer.get_frame_bpp(stream);
+    return presented().get_frame_bpp(stream);
+}
+
+const byte * syncronizing_archive::get_derived_frame_data(rs_stream stream) const
+{
+    return preparing && stream >= RS_STREAM_NATIVE_COUNT && stream < RS_STREAM_COUNT ? current.derived[stream - RS_STREAM_NATIVE_COUNT].get_frame_data() : nullptr;
 }
 
-frame_archive::frameset* syncronizing_archive::clone_frontbuffer()
+// A handle to the presented frameset, which is copied out of its buffer only the first time it is handed out, must be called with consumer_mutex held
+frame_archive::shared_frameset* syncronizing_archive::clone_presented()
 {
-    return clone_frameset(&frontbuffer);
+    if(!presented_set) presented_set = share_frameset(presented());
+    return presented_set ? clone_frameset(presented_set) : nullptr;
+}
+
+// Drop the handle of the archive to the presented frameset before another one is presented, must be called with consumer_mutex held
+void syncronizing_archive::unshare_presented()
+{
+    if(presented_set) release_frameset(presented_set);
+    presented_set = nullptr;
 }
 
 double syncronizing_archive::get_frame_metadata(rs_stream stream, rs_frame_metadata frame_metadata) const
 {
-    return frontbuffer.get_frame_metadata(stream, frame_metadata);
+    return presented().get_frame_metadata(stream, frame_metadata);
 }
 
 bool syncronizing_archive::supports_frame_metadata(rs_stream stream, rs_frame_metadata frame_metadata) const
 {
-    return frontbuffer.supports_frame_metadata(stream, frame_metadata);
+    return presented().supports_frame_metadata(stream, frame_metadata);
 }
 
 unsigned long long rsimpl::syncronizing_archive::get_frame_number(rs_stream stream) const
 {
-    return frontbuffer.get_frame_number(stream);
+    return presented().get_frame_number(stream);
 }
 
 long long syncronizing_archive::get_frame_system_time(rs_stream stream) const
 {
-    return frontbuffer.get_frame_system_time(stream);
+    return presented().get_frame_system_time(stream);
+}
+
+size_t syncronizing_archive::get_queue_depth(rs_stream stream) const
+{
+    const auto depth = static_cast<size_t>(queue_policies[stream].get_max_queued_frames());
+    return is_over_budget() ? std::min(depth, static_cast<size_t>(RS_OVER_BUDGET_QUEUE_SIZE)) : depth;
+}
+
+// Move everything the frame callback threads have handed over into the application side queues
+void syncronizing_archive::drain_inboxes()
+{
+    frame f;
+    for(auto s : drain_order) // A companion is committed before its leader, and drained after it, so the leader never finds its frame missing
+    {
+        const auto keep_queued = queue_policies[s].policy == RS_FRAME_DROP_POLICY_DROP_NEWEST;
+        while(inbox[s].try_dequeue(f))
+        {
+            if(keep_queued && frames[s].size() >= get_queue_depth(s)) cull_frame(std::move(f));
+            else
+            {
+                if(frames[s].full()) discard_frame(s); // Only while the depth shrinks, the oldest frame would be culled right after anyway
+                frames[s].push_back(std::move(f));
+
+                // Frames matched within a tolerance are kept in timestamp order, a frame arriving late is moved back past the few that overtook it
+                for(size_t i = frames[s].size() - 1; sync_tolerances[s] > 0 && i > 0 && frames[s][i - 1].additional_data.timestamp > frames[s][i].additional_data.timestamp; --i)
+                {
+                    std::swap(frames[s][i - 1], frames[s][i]);
+                }
+            }
+        }
+        correct_pending_timestamps(s);
+    }
+    cull_frames();
+}
+
+// Returns false if no frame arrived on the key stream within the timeout, must be called with consumer_mutex held
+// Streams matched within a tolerance are waited for as well, for as long as the timeout allows
+bool syncronizing_archive::wait_for_key_frame(std::chrono::milliseconds timeout)
+{
+    drain_inboxes();
+    if(is_key_frame_ready()) return true;
+
+    const auto ready = [this]()
+    {
+        if(!matching_within_tolerance) return !inbox[key_stream].empty();
+        drain_inboxes(); // Only ever done by the thread holding consumer_mutex
+        return is_key_frame_ready();
+    };
+
+    // A key frame in the inbox may still be culled once drained, which goes back to waiting, until the deadline rather than for another timeout
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while(true)
+    {
+        bool woken;
+        {
+            std::unique_lock<std::mutex> lock(cv_mutex);
+            woken = cv.wait_until(lock, deadline, ready);
+        }
+        drain_inboxes();
+        if(!frames[key_stream].empty()) return true;
+        if(!woken) return false;
+    }
+}
+
+// Clear the frames ready signal once the application has taken everything, must be called with consumer_mutex held
+void syncronizing_archive::update_frames_ready()
+{
+    if(!frames_ready) return;
+
+    // Reset before checking, a key frame committed in between then sets the signal again instead of being missed
+    frames_ready->reset();
+    if(preparing)
+    {
+        std::lock_guard<std::mutex> lock(prepared_mutex);
+        if(!prepared.empty()) frames_ready->set();
+        return;
+    }
+    if(matching_within_tolerance ? is_key_frame_ready() : !frames[key_stream].empty() || !inbox[key_stream].empty()) frames_ready->set();
+}
+
+// Waits for a frameset to be published without holding consumer_mutex, which the frame callback threads take to form the framesets they prepare
+bool syncronizing_archive::wait_for_prepared_frameset(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(prepared_mutex);
+    return prepared_cv.wait_for(lock, timeout, [this]() { return !prepared.empty(); });
+}
+
+// Make the oldest prepared frameset current, returns false if none was published within the timeout, must be called with consumer_mutex held
+bool syncronizing_archive::next_prepared_frameset(std::chrono::milliseconds timeout)
+{
+    prepared_frameset next;
+    {
+        std::unique_lock<std::mutex> lock(prepared_mutex);
+        if(!prepared_cv.wait_for(lock, timeout, [this]() { return !prepared.empty(); })) return false;
+        next = std::move(prepared.front());
+        prepared.pop_front();
+    }
+    unshare_presented();
+    current = std::move(next); // Releases the frames of the previous frameset
+    current.frames.log_delivery(latency_histograms);
+    for(auto & d : current.derived) d.log_delivery(latency_histograms);
+    return true;
 }
 
 // Block until the next coherent frameset is available
 void syncronizing_archive::wait_for_frames()
 {
-    std::unique_lock<std::recursive_mutex> lock(mutex);
-    const auto ready = [this]() { return !frames[key_stream].empty(); };
-    if(!ready() && !cv.wait_for(lock, std::chrono::seconds(5), ready)) throw std::runtime_error("Timeout waiting for frames.");
-    get_next_frames();
+    if(!try_wait_for_frames(std::chrono::seconds(5))) throw std::runtime_error("Timeout waiting for frames.");
+}
+
+// Block until the next coherent frameset is available or the timeout expires, returns false on timeout
+bool syncronizing_archive::try_wait_for_frames(std::chrono::milliseconds timeout)
+{
+    RS_TRACE_SPAN("sync");
+    if(preparing && !wait_for_prepared_frameset(timeout)) return false;
+    std::lock_guard<std::mutex> lock(consumer_mutex);
+    if(preparing)
+    {
+        if(!next_prepared_frameset(std::chrono::milliseconds(0))) return false;
+    }
+    else
+    {
+        if(!wait_for_key_frame(timeout)) return false;
+        wait_for_key_timestamp();
+        get_next_frames();
+        frontbuffer.log_delivery(latency_histograms);
+    }
+    update_frames_ready();
+    return true;
 }
 
 // If a coherent frameset is available, obtain it and return true, otherwise return false immediately
 bool syncronizing_archive::poll_for_frames()
 {
-    // TODO: Implement a user-specifiable timeout for how long to wait before returning false?
-    std::unique_lock<std::recursive_mutex> lock(mutex);
-    if(frames[key_stream].empty()) return false;
+    RS_TRACE_SPAN("sync");
+    std::lock_guard<std::mutex> lock(consumer_mutex);
+    if(preparing)
+    {
+        const bool ready = next_prepared_frameset(std::chrono::milliseconds(0));
+        update_frames_ready();
+        return ready;
+    }
+    drain_inboxes();
+    if(!is_key_frame_ready())
+    {
+        update_frames_ready();
+        return false;
+    }
     get_next_frames();
+    frontbuffer.log_delivery(latency_histograms);
+    update_frames_ready();
     return true;
 }
 
-frame_archive::frameset* syncronizing_archive::wait_for_frames_safe()
+frame_archive::shared_frameset* syncronizing_archive::wait_for_frames_safe()
 {
-    frameset * result = nullptr;
+    RS_TRACE_SPAN("sync");
+    shared_frameset * result = nullptr;
     do
     {
-        std::unique_lock<std::recursive_mutex> lock(mutex);
-        const auto ready = [this]() { return !frames[key_stream].empty(); };
-        if (!ready() && !cv.wait_for(lock, std::chrono::seconds(5), ready)) throw std::runtime_error("Timeout waiting for frames.");
-        get_next_frames();
-        result = clone_frontbuffer();
+        if (preparing && !wait_for_prepared_frameset(std::chrono::seconds(5))) throw std::runtime_error("Timeout waiting for frames.");
+        std::lock_guard<std::mutex> lock(consumer_mutex);
+        if (preparing)
+        {
+            if (!next_prepared_frameset(std::chrono::milliseconds(0))) continue; // Taken by another thread meanwhile
+        }
+        else
+        {
+            if (!wait_for_key_frame(std::chrono::seconds(5))) throw std::runtime_error("Timeout waiting for frames.");
+            wait_for_key_timestamp();
+            get_next_frames();
+            frontbuffer.log_delivery(latency_histograms);
+        }
+        update_frames_ready();
+        result = clone_presented();
     } 
     while (!result);
     return result;
 }
 
-bool syncronizing_archive::poll_for_frames_safe(frameset** frameset)
+bool syncronizing_archive::poll_for_frames_safe(shared_frameset** frameset)
 {
     // TODO: Implement a user-specifiable timeout for how long to wait before returning false?
-    std::unique_lock<std::recursive_mutex> lock(mutex);
-    if (frames[key_stream].empty()) return false;
-    get_next_frames();
-    auto result = clone_frontbuffer();
+    RS_TRACE_SPAN("sync");
+    std::lock_guard<std::mutex> lock(consumer_mutex);
+    if (preparing)
+    {
+        if (!next_prepared_frameset(std::chrono::milliseconds(0))) return false;
+    }
+    else
+    {
+        drain_inboxes();
+        if (!is_key_frame_ready()) return false;
+        get_next_frames();
+        frontbuffer.log_delivery(latency_histograms);
+    }
+    update_frames_ready();
+    auto result = clone_presented();
     if (result)
     {
         *frameset = result;
@@ -121,12 +382,19 @@ bool syncronizing_archive::poll_for_frames_safe(frameset** frameset)
 // Move frames from the queues to the frontbuffers to form the next coherent frameset
 void syncronizing_archive::get_next_frames()
 {
+    if(!preparing) unshare_presented();
+
     // Always dequeue a frame from the key stream
     dequeue_frame(key_stream);
 
     // Dequeue from other streams if the new frame is closer to the timestamp of the key stream than the old frame
     for(auto s : other_streams)
     {
+        if (sync_tolerances[s] > 0)
+        {
+            match_frame(s);
+            continue;
+        }
         if (frames[s].empty())
             continue;
 
@@ -139,21 +407,208 @@ void syncronizing_archive::get_next_frames()
             dequeue_frame(s);
         }
     }
+
+    // Companions take the frame unpacked along with that of their leader, without comparing timestamps
+    for(auto s : companions) match_companion(s);
+}
+
+// Move the frame of a stream with a tolerance closest to the key frame into the frontbuffer, or leave the stream out if none is within tolerance
+void syncronizing_archive::match_frame(rs_stream stream)
+{
+    const double key = frontbuffer.get_frame_timestamp(key_stream);
+    auto & queue = frames[stream];
+    size_t passed;
+    const int match = match_within_tolerance(queue.size(), [&queue](size_t i) { return queue[i].additional_data.timestamp; }, key, sync_tolerances[stream], passed);
+    while(passed--) discard_frame(stream);
+    if(match >= 0) dequeue_frame(stream);
+    else if(!(idle_streams.load(std::memory_order_relaxed) & (1 << stream))) frontbuffer.clear_frame(stream);
+}
+
+// Move the frame of a companion unpacked along with the frame of its leader in the frontbuffer there, or leave it out with the frame of its leader
+void syncronizing_archive::match_companion(rs_stream stream)
+{
+    const auto leader = frontbuffer.get_additional_data(leaders[stream]);
+    if(!leader)
+    {
+        if(!(idle_streams.load(std::memory_order_relaxed) & (1 << stream))) frontbuffer.clear_frame(stream);
+        return;
+    }
+
+    auto & queue = frames[stream];
+    for(size_t i = 0; i < queue.size(); ++i)
+    {
+        if(queue[i].additional_data.frame_number != leader->frame_number || queue[i].additional_data.system_time != leader->system_time) continue;
+        while(i--) discard_frame(stream);
+        dequeue_frame(stream);
+        return;
+    }
 }
 
-// Move a frame from the backbuffer to the back of the queue
+// Move a frame from the backbuffer to the back of the stream's inbox, dropping frames according to the stream's policy if the application is falling behind
 void syncronizing_archive::commit_frame(rs_stream stream)
 {
-    std::unique_lock<std::recursive_mutex> lock(mutex);
-    frames[stream].push_back(std::move(backbuffer[stream]));
-    cull_frames();
-    lock.unlock();
-    if(!frames[key_stream].empty()) cv.notify_one();
+    commit_frames(&stream, 1);
+}
+
+// Companions are enqueued ahead of their leaders, and the application is woken up once for the whole native frame
+void syncronizing_archive::commit_frames(const rs_stream streams[], size_t count)
+{
+    bool wake = false;
+    for(size_t i = 0; i < count; ++i) if(leaders[streams[i]] != RS_STREAM_COUNT) enqueue_frame(streams[i]);
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(leaders[streams[i]] != RS_STREAM_COUNT) continue;
+        enqueue_frame(streams[i]);
+        wake |= streams[i] == key_stream || sync_tolerances[streams[i]] > 0;
+    }
+
+    if(on_frameset)
+    {
+        dispatch_framesets();
+    }
+    else if(wake)
+    {
+        { std::lock_guard<std::mutex> lock(cv_mutex); } // Pairs with the predicate check in wait_for_key_frame, so the wakeup cannot be lost
+        cv.notify_one();
+        if(frames_ready) frames_ready->set();
+    }
+}
+
+void syncronizing_archive::enqueue_frame(rs_stream stream)
+{
+    // Each stream has a single producer, so the inbox size seen here can only be an overestimate
+    const auto max_queued = get_queue_depth(stream);
+    if(queue_policies[stream].policy == RS_FRAME_DROP_POLICY_DROP_NEWEST && inbox[stream].size() >= max_queued)
+    {
+        if(metrics) metrics->add(stream, RS_STREAM_METRIC_FRAMES_CULLED);
+        recycle_frame(std::move(backbuffer[stream]));
+        return;
+    }
+
+    if(metrics) metrics->add(stream, RS_STREAM_METRIC_QUEUED_FRAMES);
+    frame oldest;
+    while(inbox[stream].size() >= max_queued && inbox[stream].try_dequeue(oldest)) cull_frame(std::move(oldest));
+    while(!inbox[stream].try_enqueue(std::move(backbuffer[stream])))
+    {
+        if(inbox[stream].try_dequeue(oldest)) cull_frame(std::move(oldest));
+    }
+}
+
+// A key frame is queued, and every stream with a tolerance has a frame at or after it, unless holding on would start dropping key frames
+// No closer frame of those streams can then arrive, must be called with consumer_mutex held
+bool syncronizing_archive::is_key_frame_ready() const
+{
+    if(frames[key_stream].empty()) return false;
+    if(!matching_within_tolerance || frames[key_stream].size() >= get_queue_depth(key_stream)) return true;
+    const double key = frames[key_stream].front().additional_data.timestamp;
+    const int idle = idle_streams.load(std::memory_order_relaxed);
+    for(auto s : other_streams)
+    {
+        if(sync_tolerances[s] > 0 && !(idle & (1 << s)) && (frames[s].empty() || frames[s].back().additional_data.timestamp < key)) return false;
+    }
+    return true;
+}
+
+// A pushed frameset waits for a candidate frame of every stream, unless holding on would start dropping key frames, must be called with consumer_mutex held
+bool syncronizing_archive::is_frameset_ready() const
+{
+    if(!is_key_frame_ready()) return false;
+    if(frames[key_stream].size() >= get_queue_depth(key_stream)) return true;
+    const int idle = idle_streams.load(std::memory_order_relaxed);
+    for(auto s : other_streams) if(frames[s].empty() && !(idle & (1 << s))) return false;
+    return true;
+}
+
+void syncronizing_archive::set_sync_tolerance(rs_stream stream, double tolerance)
+{
+    sync_tolerances[stream] = tolerance;
+    matching_within_tolerance = std::any_of(other_streams.begin(), other_streams.end(), [this](rs_stream s) { return sync_tolerances[s] > 0; });
+}
+
+void syncronizing_archive::set_companion(rs_stream stream, rs_stream leader)
+{
+    if(stream == key_stream || leaders[stream] != RS_STREAM_COUNT || !is_stream_enabled(stream) || !is_stream_enabled(leader)) return;
+    leaders[stream] = leader;
+    other_streams.erase(std::remove(other_streams.begin(), other_streams.end(), stream), other_streams.end());
+    companions.push_back(stream);
+    std::stable_partition(std::begin(drain_order), std::end(drain_order), [this](rs_stream s) { return leaders[s] == RS_STREAM_COUNT; });
+    set_sync_tolerance(stream, 0);
+}
+
+void syncronizing_archive::set_stream_idle(rs_stream stream, bool idle)
+{
+    if(idle) idle_streams.fetch_or(1 << stream);
+    else idle_streams.fetch_and(~(1 << stream));
+}
+
+// Hand every frameset that can be formed to the frameset callback, without holding consumer_mutex while the application runs
+void syncronizing_archive::dispatch_framesets()
+{
+    std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex);
+    while(true)
+    {
+        shared_frameset * result = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(consumer_mutex);
+            drain_inboxes();
+            if(!is_frameset_ready()) return;
+            get_next_frames();
+            result = share_frameset(frontbuffer);
+            if(result && !preparing) frontbuffer.log_delivery(latency_histograms); // Prepared framesets are delivered once the application takes them
+        }
+
+        if(result) on_frameset(result);
+        else LOG_WARNING("Frameset dropped, the application holds on to too many framesets");
+    }
+}
+
+void syncronizing_archive::set_frameset_preparation(std::function<void(shared_frameset *)> prepare)
+{
+    on_frameset = prepare;
+    preparing = true;
+    current.frames = frontbuffer; // The empty images, until the first frameset is prepared
+}
+
+void syncronizing_archive::publish_prepared_frameset(shared_frameset * frames, frame_ref * const (&derived)[RS_STREAM_COUNT - RS_STREAM_NATIVE_COUNT])
+{
+    prepared_frameset result, dropped;
+    result.frames = frames->get_frames();
+    release_frameset(frames);
+    for(int i = 0; i < RS_STREAM_COUNT - RS_STREAM_NATIVE_COUNT; ++i)
+    {
+        if(!derived[i]) continue;
+        result.derived[i] = *derived[i];
+        release_frame_ref(derived[i]);
+    }
+
+    {
+        // Framesets waiting for the application are bound and dropped like the frames of the key stream
+        std::lock_guard<std::mutex> lock(prepared_mutex);
+        if(prepared.size() >= get_queue_depth(key_stream))
+        {
+            if(queue_policies[key_stream].policy == RS_FRAME_DROP_POLICY_DROP_NEWEST) return;
+            dropped = std::move(prepared.front()); // Released once the lock is
+            prepared.pop_front();
+        }
+        prepared.push_back(std::move(result));
+    }
+    prepared_cv.notify_one();
+    if(frames_ready) frames_ready->set();
 }
 
 void syncronizing_archive::flush()
 {
+    std::unique_lock<std::mutex> lock(consumer_mutex);
     frontbuffer.cleanup(); // frontbuffer also holds frame references, since its content is publicly available through get_frame_data
+    current.frames.cleanup();
+    for(auto & d : current.derived) d = frame_ref();
+    unshare_presented(); // After the continuations of its frames are disabled
+    {
+        std::lock_guard<std::mutex> prepared_lock(prepared_mutex);
+        for(auto & p : prepared) p.frames.cleanup();
+        prepared.clear();
+    }
+    lock.unlock();
     frame_archive::flush();
 }
 
@@ -161,10 +616,32 @@ void syncronizing_archive::correct_timestamp(rs_stream stream)
 {
     if (is_stream_enabled(stream))
         {
-            ts_corrector.correct_timestamp(backbuffer[stream], stream);
+            backbuffer[stream].additional_data.timestamp_pending = !ts_corrector.correct_timestamp(backbuffer[stream], stream);
         }
 }
 
+// Correct the queued frames of stream whose events arrived since they were published, giving up on those whose events are overdue
+void syncronizing_archive::correct_pending_timestamps(rs_stream stream)
+{
+    const auto overdue = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() - (long long)ts_corrector.get_events_timeout();
+    for(size_t i = 0; i < frames[stream].size(); ++i)
+    {
+        auto & f = frames[stream][i];
+        if(!f.additional_data.timestamp_pending) continue;
+        f.additional_data.timestamp_pending = !ts_corrector.correct_timestamp(f, stream) && f.additional_data.system_time > overdue;
+    }
+}
+
+// Before the application takes the next key frame, wait for its event unless it is overdue, which blocks the application thread instead of the capture thread
+void syncronizing_archive::wait_for_key_timestamp()
+{
+    if(frames[key_stream].empty() || !frames[key_stream].front().additional_data.timestamp_pending) return;
+    auto & f = frames[key_stream].front();
+    ts_corrector.wait_and_correct_timestamp(f, key_stream, std::chrono::system_clock::time_point(std::chrono::milliseconds(f.additional_data.system_time)));
+    f.additional_data.timestamp_pending = false;
+    drain_inboxes(); // Frames and events which arrived meanwhile
+}
+
 void syncronizing_archive::on_timestamp(rs_timestamp_data data)
 {
     ts_corrector.on_timestamp(data);
@@ -172,24 +649,46 @@ void syncronizing_archive::on_timestamp(rs_timestamp_data data)
 
 int syncronizing_archive::get_frame_stride(rs_stream stream) const
 {
-    return frontbuffer.get_frame_stride(stream);
+    return presented().get_frame_stride(stream);
+}
+
+const uint32_t * syncronizing_archive::get_frame_depth_runs(rs_stream stream) const
+{
+    return presented().get_frame_depth_runs(stream);
 }
 
 // Discard all frames which are older than the most recent coherent frameset
 void syncronizing_archive::cull_frames()
 {
-    // Never keep more than four frames around in any given stream, regardless of timestamps
+    // Never keep more frames around than the stream's queue policy allows, regardless of timestamps
     for(auto s : {RS_STREAM_DEPTH, RS_STREAM_COLOR, RS_STREAM_INFRARED, RS_STREAM_INFRARED2, RS_STREAM_FISHEYE})
     {
-        while(frames[s].size() > 4)
+        while(frames[s].size() > get_queue_depth(s))
         {
             discard_frame(s);
         }
     }
 
-    // Cannot do any culling unless at least one frame is enqueued for each enabled stream    
+    // Frames of a companion older than every frame of its leader still to be presented can never be matched
+    for(auto s : companions)
+    {
+        const auto leader = leaders[s];
+        const auto oldest = frames[leader].empty() ? frontbuffer.get_frame_system_time(leader) : frames[leader].front().additional_data.system_time;
+        while(!frames[s].empty() && frames[s].front().additional_data.system_time < oldest) discard_frame(s);
+    }
+
+    // Cannot do any culling unless at least one frame is enqueued for each enabled stream, other than those turned off
     if(frames[key_stream].empty()) return;
-    for(auto s : other_streams) if(frames[s].empty()) return;
+    const int idle = idle_streams.load(std::memory_order_relaxed);
+    for(auto s : other_streams) if(frames[s].empty() && !(idle & (1 << s))) return;
+
+    // Frames of the streams with a tolerance older than the window of the next key frame can never be matched, key frames are never discarded for them
+    const double key = frames[key_stream].front().additional_data.timestamp;
+    for(auto s : other_streams)
+    {
+        if(sync_tolerances[s] > 0) while(!frames[s].empty() && frames[s].front().additional_data.timestamp < key - sync_tolerances[s]) discard_frame(s);
+    }
+    if(matching_within_tolerance && std::all_of(other_streams.begin(), other_streams.end(), [this](rs_stream s) { return sync_tolerances[s] > 0; })) return;
 
     // We can discard frames from the key stream if we have at least two and the latter is closer to the most recent frame of all other streams than the former
     while(true)
@@ -200,6 +699,7 @@ void syncronizing_archive::cull_frames()
         bool valid_to_skip = true;
         for(auto s : other_streams)
         {
+            if (frames[s].empty() || sync_tolerances[s] > 0) continue;
             if (std::fabs(t0 - frames[s].back().additional_data.timestamp) < std::fabs(t1 - frames[s].back().additional_data.timestamp))
             {
                 valid_to_skip = false;
@@ -214,7 +714,7 @@ void syncronizing_archive::cull_frames()
     // We can discard frames for other streams if we have at least two and the latter is closer to the next key stream frame than the former
     for(auto s : other_streams)
     {
-        while(true)
+        while(sync_tolerances[s] == 0)
         {
             if(frames[s].size() < 2) break;
             const double t0 = frames[s][0].additional_data.timestamp, t1 = frames[s][1].additional_data.timestamp;
@@ -225,10 +725,12 @@ void syncronizing_archive::cull_frames()
     }
 }
 
-// Move a single frame from the head of the queue to the front buffer, while recycling the front buffer into the freelist
+// Move a single frame from the head of the queue to the front buffer, while recycling the front buffer into the pool
 void syncronizing_archive::dequeue_frame(rs_stream stream)
 {
     auto & frame = frames[stream].front();
+    frame.additional_data.set_metadata(RS_FRAME_METADATA_TIME_OF_SYNC, get_monotonic_time());
+    if(metrics) metrics->subtract(stream, RS_STREAM_METRIC_QUEUED_FRAMES);
     
     // Log callback started
     auto callback_start_time = std::chrono::high_resolution_clock::now();
@@ -237,13 +739,24 @@ void syncronizing_archive::dequeue_frame(rs_stream stream)
     LOG_DEBUG("CallbackStarted," << rsimpl::get_string(frame.get_stream_type()) << "," << frame.get_frame_number() << ",DispatchedAt," << ts);
 
     frontbuffer.place_frame(stream, std::move(frames[stream].front())); // the frame will move to free list once there are no external references to it
-    frames[stream].erase(begin(frames[stream]));
+    frames[stream].pop_front();
 }
 
-// Move a single frame from the head of the queue directly to the freelist
+// Move a single frame from the head of the queue directly to the pool
 void syncronizing_archive::discard_frame(rs_stream stream)
 {
-    std::lock_guard<std::recursive_mutex> guard(mutex);
-    freelist.push_back(std::move(frames[stream].front()));
-    frames[stream].erase(begin(frames[stream]));
+    cull_frame(std::move(frames[stream].front()));
+    frames[stream].pop_front();
 }
+
+// Recycle a frame which was queued, but will never be handed out
+void syncronizing_archive::cull_frame(frame && f)
+{
+    if(metrics)
+    {
+        metrics->add(f.get_stream_type(), RS_STREAM_METRIC_FRAMES_CULLED);
+        metrics->subtract(f.get_stream_type(), RS_STREAM_METRIC_QUEUED_FRAMES);
+    }
+    recycle_frame(std::move(f));
+}
+
@@ -9,9 +9,35 @@
 #include <atomic>
 #include "timestamps.h"
 #include <chrono>
+#include <deque>
+#include <cmath>
 
 namespace rsimpl
 {
+    // Of count frames queued for a stream in timestamp order, whose timestamps are given by timestamp(i), the index of the closest to the timestamp
+    // of a key frame within tolerance, or -1 if none is. The frames before the match, or all those scanned if none is within tolerance, cannot
+    // match a later key frame any better and their count is returned in passed, to be discarded. Scanning stops at the first frame past the
+    // window, so that each frame is looked at a bounded number of times however many key frames are matched against the queue.
+    template<class Timestamp> int match_within_tolerance(size_t count, Timestamp timestamp, double key, double tolerance, size_t & passed)
+    {
+        int match = -1;
+        double closest = tolerance;
+        size_t i = 0;
+        for(; i < count; ++i)
+        {
+            const double t = timestamp(i);
+            if(t > key + tolerance) break;
+            const double distance = std::fabs(t - key);
+            if(distance <= closest)
+            {
+                match = static_cast<int>(i);
+                closest = distance;
+            }
+        }
+        passed = match < 0 ? i : static_cast<size_t>(match);
+        return match;
+    }
+
     class fps_calc
     {
     public:
@@ -48,25 +74,97 @@ namespace rsimpl
         std::vector<std::chrono::time_point<std::chrono::system_clock>> _time_samples;
     };
 
+    // Level-triggered OS object that is signaled while a frameset is ready, so applications can wait on several devices with epoll / WaitForMultipleObjects
+    // The OS object is only created once the application asks for it, until then set() and reset() are free
+    class frames_ready_signal
+    {
+        std::mutex mutex;
+        std::atomic<bool> armed;
+        std::atomic<bool> signaled;
+#ifdef _WIN32
+        void * event;
+#else
+        int fds[2];     // eventfd on Linux, a non-blocking pipe elsewhere
+#endif
+
+        frames_ready_signal(const frames_ready_signal &) = delete;
+        frames_ready_signal & operator=(const frames_ready_signal &) = delete;
+    public:
+        frames_ready_signal();
+        ~frames_ready_signal();
+
+        void * get_handle(); // HANDLE on Windows, a readable file descriptor elsewhere
+        void set();
+        void reset();
+    };
+
     class syncronizing_archive : public frame_archive
     {
     private:
         // This data will be left constant after creation, and accessed from all threads
         subdevice_mode_selection modes[RS_STREAM_NATIVE_COUNT];
+        stream_queue_policy queue_policies[RS_STREAM_NATIVE_COUNT];
         rs_stream key_stream;
         std::vector<rs_stream> other_streams;
-
-        // This data will be read and written exclusively from the application thread
+        std::atomic<int> idle_streams;  // Bit mask of the other streams turned off for lack of demand, which framesets no longer wait for
+        double sync_tolerances[RS_STREAM_NATIVE_COUNT] = {}; // Set before streaming starts, 0 for the streams matched to the nearest frame
+        bool matching_within_tolerance = false;             // Some other stream has a tolerance
+        rs_stream leaders[RS_STREAM_NATIVE_COUNT];          // Set before streaming starts, the stream a companion is unpacked along with, RS_STREAM_COUNT for the others
+        std::vector<rs_stream> companions;                  // Taken out of other_streams, and matched by frame rather than by timestamp
+        rs_stream drain_order[RS_STREAM_NATIVE_COUNT] = { RS_STREAM_DEPTH, RS_STREAM_COLOR, RS_STREAM_INFRARED, RS_STREAM_INFRARED2, RS_STREAM_FISHEYE }; // Companions last
+
+        // This data will be read and written exclusively from the application thread, and synchronized with consumer_mutex
         frameset frontbuffer;
-
-        // This data will be read and written by all threads, and synchronized with a mutex
-        std::vector<frame> frames[RS_STREAM_NATIVE_COUNT];
-        std::condition_variable_any cv;
-        
+        ring_queue<frame, 2 * RS_MAX_STREAM_QUEUE_DEPTH> frames[RS_STREAM_NATIVE_COUNT]; // Room for a full queue and a full inbox between two culls
+        std::mutex consumer_mutex;
+
+        // Frames handed over from the frame callback threads, without ever blocking the producer on the application
+        lock_free_queue<frame, RS_MAX_STREAM_QUEUE_DEPTH> inbox[RS_STREAM_NATIVE_COUNT];
+        std::mutex cv_mutex;            // Only guards the wait / notify handshake, never held while touching frames
+        std::condition_variable cv;
+
+        // Set before streaming starts, the frame callback threads then push framesets instead of the application waiting for them
+        std::function<void(shared_frameset *)> on_frameset;
+        std::mutex dispatch_mutex;      // Keeps framesets in order when several frame callback threads could form one
+        frames_ready_signal * frames_ready = nullptr;
+
+        // While framesets are prepared ahead of the application, the frame callback threads form them in frontbuffer, and the application takes them
+        // from prepared instead, together with the frames of derived streams computed from them. current is only touched by the application thread.
+        struct prepared_frameset
+        {
+            frameset frames;
+            frame_ref derived[RS_STREAM_COUNT - RS_STREAM_NATIVE_COUNT]; // Indexed by stream - RS_STREAM_NATIVE_COUNT, empty unless it was computed
+        };
+        bool preparing = false;
+        std::deque<prepared_frameset> prepared;
+        prepared_frameset current;
+        std::mutex prepared_mutex;
+        std::condition_variable prepared_cv;
+
+        frameset & presented() { return preparing ? current.frames : frontbuffer; } // The frameset the application sees
+        const frameset & presented() const { return preparing ? current.frames : frontbuffer; }
+        shared_frameset * presented_set = nullptr; // presented() once handed out, shared by every later handle until the next frameset is presented
+        shared_frameset * clone_presented();
+        void unshare_presented();
+        bool wait_for_prepared_frameset(std::chrono::milliseconds timeout);
+        bool next_prepared_frameset(std::chrono::milliseconds timeout);
+        void drain_inboxes();
+        void correct_pending_timestamps(rs_stream stream);
+        void wait_for_key_timestamp();
+        bool wait_for_key_frame(std::chrono::milliseconds timeout);
+        void update_frames_ready();
+        bool is_key_frame_ready() const;
+        bool is_frameset_ready() const;
+        void dispatch_framesets();
         void get_next_frames();
+        void match_frame(rs_stream stream);
+        void match_companion(rs_stream stream);
+        void enqueue_frame(rs_stream stream);
         void dequeue_frame(rs_stream stream);
         void discard_frame(rs_stream stream);
         void cull_frames();
+        void cull_frame(frame && f);
+        size_t get_queue_depth(rs_stream stream) const; // Frames of the stream kept queued, as its policy allows unless over the memory budget
 
         timestamp_corrector            ts_corrector;
     public:
@@ -75,32 +173,56 @@ namespace rsimpl
             std::atomic<uint32_t>* max_size,
             std::atomic<uint32_t>* event_queue_size,
             std::atomic<uint32_t>* events_timeout,
+            const stream_queue_policy (&queue_policies)[RS_STREAM_NATIVE_COUNT],
+            std::shared_ptr<rs_frame_allocator> allocator = nullptr,
             std::chrono::high_resolution_clock::time_point capture_started = std::chrono::high_resolution_clock::now());
         
         // Application thread API
         void wait_for_frames();
+        bool try_wait_for_frames(std::chrono::milliseconds timeout);
         bool poll_for_frames();
 
-        frameset * wait_for_frames_safe();
-        bool poll_for_frames_safe(frameset ** frames);
+        shared_frameset * wait_for_frames_safe();
+        bool poll_for_frames_safe(shared_frameset ** frames);
 
         double get_frame_metadata(rs_stream stream, rs_frame_metadata frame_metadata) const;
         bool supports_frame_metadata(rs_stream stream, rs_frame_metadata frame_metadata) const;
         const byte * get_frame_data(rs_stream stream) const;
+        const byte * get_derived_frame_data(rs_stream stream) const; // Frame of a derived stream prepared along with the current frameset, or nullptr
         double get_frame_timestamp(rs_stream stream) const;
         unsigned long long get_frame_number(rs_stream stream) const;
         long long get_frame_system_time(rs_stream stream) const;
         int get_frame_stride(rs_stream stream) const;
+        const uint32_t * get_frame_depth_runs(rs_stream stream) const; // Of the depth frame presented, nullptr unless its runs were found
         int get_frame_bpp(rs_stream stream) const;
 
-        frameset * clone_frontbuffer();
+        void set_frameset_callback(std::function<void(shared_frameset *)> callback) { on_frameset = callback; }
+        void set_frames_ready_signal(frames_ready_signal * signal) { frames_ready = signal; }
+
+        // Set before streaming starts instead of a frameset callback. Framesets are then formed as soon as their frames arrive and handed to prepare, which
+        // takes ownership and hands them back through publish_prepared_frameset, from any thread but in order, to be waited for or polled by the application.
+        void set_frameset_preparation(std::function<void(shared_frameset *)> prepare);
+        void publish_prepared_frameset(shared_frameset * frames, frame_ref * const (&derived)[RS_STREAM_COUNT - RS_STREAM_NATIVE_COUNT]); // Releases frames and every non-null derived ref
+
+        // Set before streaming starts. A stream with a tolerance is matched to the closest of its frames within that many milliseconds of the key
+        // frame, and left out of the frameset if it has none, instead of to its nearest frame however far. Framesets wait until such a stream
+        // has a frame at or after the key frame, or is turned off, or the key stream queue is full.
+        void set_sync_tolerance(rs_stream stream, double tolerance);
+
+        // Set before streaming starts, for a stream whose every frame is unpacked from the same native frame as one of leader, and committed along
+        // with it. Its frames are then matched to those of leader by frame number instead of by timestamp, and framesets never wait for them.
+        void set_companion(rs_stream stream, rs_stream leader);
+
+        // A stream turned off keeps its last frame in the framesets, which are formed without waiting for it until it is turned on again
+        void set_stream_idle(rs_stream stream, bool idle);
 
         // Frame callback thread API
         void commit_frame(rs_stream stream);
+        void commit_frames(const rs_stream streams[], size_t count); // The frames of streams unpacked from one native frame, companions included
 
         void flush() override;
 
-        void correct_timestamp(rs_stream stream);
+        void correct_timestamp(rs_stream stream); // Never waits, a frame whose event has not arrived yet is corrected once the application takes it
         void on_timestamp(rs_timestamp_data data);
 
     };
@@ -0,0 +1,100 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "task-graph.h"
+
+using namespace rsimpl;
+
+task_graph::task_graph(int thread_count, uint64_t cpu_mask, std::function<void(void * input)> on_complete) : pool(thread_count, cpu_mask), on_complete(on_complete), stopped(false) {}
+
+int task_graph::add_task(task work, const std::vector<int> & dependencies)
+{
+    const int index = (int)nodes.size();
+    std::unique_ptr<node> n(new node());
+    n->index = index;
+    n->work = work;
+    n->dependency_count = (int)dependencies.size();
+    for (auto d : dependencies)
+    {
+        if (d < 0 || d >= index) throw std::logic_error("tasks can only depend on tasks added before them");
+        nodes[d]->dependents.push_back(index);
+    }
+    auto self = n.get();
+    n->job = pool.create_job([this, self]() { run_ready(*self); });
+    nodes.push_back(std::move(n));
+    return index;
+}
+
+void task_graph::submit(void * input)
+{
+    auto r = std::make_shared<run>();
+    r->input = input;
+    r->waiting.reset(new std::atomic<int>[nodes.size()]);
+    for (size_t i = 0; i < nodes.size(); ++i) r->waiting[i] = nodes[i]->dependency_count;
+    r->remaining = (int)nodes.size() + 1; // Held until every root has the input, so that it cannot complete before it is queued
+    r->complete = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        in_flight.push_back(r);
+    }
+
+    for (auto & n : nodes) if (!n->dependency_count) make_ready(*n, r);
+    finish(*r);
+}
+
+void task_graph::make_ready(node & n, std::shared_ptr<run> r)
+{
+    {
+        std::lock_guard<std::mutex> lock(n.mutex);
+        n.ready.push_back(std::move(r));
+    }
+    n.job->trigger();
+}
+
+void task_graph::run_ready(node & n)
+{
+    while (true)
+    {
+        std::shared_ptr<run> r;
+        {
+            std::lock_guard<std::mutex> lock(n.mutex);
+            if (n.ready.empty()) return;
+            r = std::move(n.ready.front());
+            n.ready.pop_front();
+        }
+
+        // A failing task still lets its dependents and the completion of the input go ahead
+        try { n.work(r->input); }
+        catch (const std::exception & e) { LOG_ERROR("Received an exception from task " << n.index << " of a task graph: " << e.what()); }
+        catch (...) { LOG_ERROR("Received an exception from task " << n.index << " of a task graph!"); }
+
+        for (auto d : n.dependents) if (--r->waiting[d] == 0) make_ready(*nodes[d], r);
+        finish(*r);
+    }
+}
+
+void task_graph::finish(run & r)
+{
+    if (--r.remaining) return;
+
+    // Inputs are completed in the order they were submitted, under the mutex, so that completions on different threads cannot overtake each other
+    std::lock_guard<std::mutex> lock(mutex);
+    r.complete = true;
+    while (!in_flight.empty() && in_flight.front()->complete)
+    {
+        on_complete(in_flight.front()->input);
+        in_flight.pop_front();
+    }
+    if (in_flight.empty()) cv.notify_all();
+}
+
+void task_graph::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (stopped) return;
+        cv.wait(lock, [this]() { return in_flight.empty(); });
+        stopped = true;
+    }
+    for (auto & n : nodes) n->job->cancel();
+}
@@ -0,0 +1,63 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_TASK_GRAPH_H
+#define LIBREALSENSE_TASK_GRAPH_H
+
+#include "executor.h"
+
+namespace rsimpl
+{
+    // A fixed graph of tasks, run once for every input submitted to it. A task runs on an input as soon as the tasks it depends on have run on
+    // that input, so tasks independent of one another run in parallel. Every task is a job of a work-stealing executor of its own: the runs of
+    // one task never overlap and take the inputs in the order they became ready. Once all tasks have run on an input, the input is handed to
+    // the completion callback, in the order the inputs were submitted.
+    class task_graph
+    {
+    public:
+        typedef std::function<void(void * input)> task;
+    private:
+        struct run
+        {
+            void *                                  input;
+            std::unique_ptr<std::atomic<int>[]>     waiting;        // Dependencies of every task yet to run on the input
+            std::atomic<int>                        remaining;      // Tasks yet to run on the input
+            bool                                    complete;       // Guarded by mutex
+        };
+        struct node
+        {
+            int                                     index;
+            task                                    work;
+            std::vector<int>                        dependents;
+            int                                     dependency_count;
+            std::mutex                              mutex;
+            std::deque<std::shared_ptr<run>>        ready;          // Guarded by mutex, inputs whose dependencies have all run
+            std::shared_ptr<executor::job>          job;
+        };
+
+        executor                                    pool;           // Declared first, so that it outlives the jobs of the nodes
+        std::function<void(void *)>                 on_complete;
+        std::vector<std::unique_ptr<node>>          nodes;
+        std::mutex                                  mutex;          // Guards the members below
+        std::condition_variable                     cv;
+        std::deque<std::shared_ptr<run>>            in_flight;      // In submission order
+        bool                                        stopped;
+
+        task_graph(const task_graph &) = delete;
+        task_graph & operator=(const task_graph &) = delete;
+
+        void make_ready(node & n, std::shared_ptr<run> r);
+        void run_ready(node & n);
+        void finish(run & r);
+    public:
+        task_graph(int thread_count, uint64_t cpu_mask, std::function<void(void * input)> on_complete); // A cpu_mask of 0 lets the threads run on every CPU
+        ~task_graph() { stop(); }
+
+        int add_task(task work, const std::vector<int> & dependencies = {}); // Only before the first input is submitted, depending on tasks added before
+        void submit(void * input);
+        void stop(); // Waits for every input submitted to complete, after which no task runs again
+    };
+}
+
+#endif
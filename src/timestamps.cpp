@@ -7,69 +7,42 @@ using namespace std;
 
 
 
-void concurrent_queue::push_back_data(rs_timestamp_data data)
-{
-    lock_guard<mutex> lock(mtx);
-
-    data_queue.push_back(data);
-}
+const unsigned long long no_frame_number = ~0ull;
 
-bool concurrent_queue::pop_front_data()
+event_ring::event_ring() : latest(0)
 {
-    lock_guard<mutex> lock(mtx);
-
-    if (!data_queue.size())
-        return false;
-
-    data_queue.pop_front();
-
-    return true;
-}
-
-bool concurrent_queue::erase(rs_timestamp_data data)
-{
-    lock_guard<mutex> lock(mtx);
-
-    auto it = find_if(data_queue.begin(), data_queue.end(),
-                      [&](const rs_timestamp_data& element) {
-        return (data.frame_number == element.frame_number);
-    });
-
-    if (it != data_queue.end())
+    for (auto & s : slots)
     {
-        data_queue.erase(it);
-        return true;
+        s.frame_number.store(no_frame_number, memory_order_relaxed);
+        s.timestamp.store(0, memory_order_relaxed);
     }
-
-    return false;
 }
 
-size_t concurrent_queue::size()
+void event_ring::push(const rs_timestamp_data & data)
 {
-    lock_guard<mutex> lock(mtx);
-
-    return data_queue.size();
+    auto & s = slots[data.frame_number % RS_MAX_EVENT_QUEUE_SIZE];
+    s.frame_number.store(no_frame_number, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    s.timestamp.store(data.timestamp, memory_order_relaxed);
+    s.frame_number.store(data.frame_number, memory_order_release);
+    if (data.frame_number > latest.load(memory_order_relaxed)) latest.store(data.frame_number, memory_order_relaxed);
 }
 
-bool concurrent_queue::correct( frame_interface& frame)
+bool event_ring::find(unsigned long long frame_number, uint32_t depth, double & timestamp) const
 {
-    lock_guard<mutex> lock(mtx);
-    
-    auto it = find_if(data_queue.begin(), data_queue.end(),
-                      [&](const rs_timestamp_data& element) {
-        return ((frame.get_frame_number() == element.frame_number));
-    });
-
-    if (it != data_queue.end())
-    {
-        frame.set_timestamp(it->timestamp);
-        return true;
-    }
-    return false;
+    if (frame_number == no_frame_number || latest.load(memory_order_relaxed) - frame_number >= std::min<uint32_t>(depth, RS_MAX_EVENT_QUEUE_SIZE)) return false;
+
+    auto & s = slots[frame_number % RS_MAX_EVENT_QUEUE_SIZE];
+    if (s.frame_number.load(memory_order_acquire) != frame_number) return false;
+    auto t = s.timestamp.load(memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if (s.frame_number.load(memory_order_relaxed) != frame_number) return false;
+    timestamp = t;
+    return true;
 }
 
 timestamp_corrector::timestamp_corrector(std::atomic<uint32_t>* queue_size, std::atomic<uint32_t>* timeout)
-    :event_queue_size(queue_size), events_timeout(timeout)
+    :waiters(0), event_queue_size(queue_size), events_timeout(timeout)
 {
 }
 
@@ -79,17 +52,19 @@ timestamp_corrector::~timestamp_corrector()
 
 void timestamp_corrector::on_timestamp(rs_timestamp_data data)
 {
-    lock_guard<mutex> lock(mtx);
+    if (data.source_id < 0 || data.source_id >= RS_EVENT_SOURCE_COUNT) return;
+    events[data.source_id].push(data);
 
-    if (data_queue[data.source_id].size() <= *event_queue_size)
-        data_queue[data.source_id].push_back_data(data);
-    if (data_queue[data.source_id].size() > *event_queue_size)
-        data_queue[data.source_id].pop_front_data();
-
-    cv.notify_one();
+    // Pairs with the increment in wait_and_correct_timestamp, so that a waiter either finds the event or is notified of it
+    atomic_thread_fence(memory_order_seq_cst);
+    if (waiters.load(memory_order_relaxed))
+    {
+        { lock_guard<mutex> lock(mtx); }
+        cv.notify_all();
+    }
 }
 
-void timestamp_corrector::update_source_id(rs_event_source& source_id, const rs_stream stream)
+rs_event_source timestamp_corrector::get_source_id(const rs_stream stream)
 {
     switch(stream)
     {
@@ -97,32 +72,32 @@ void timestamp_corrector::update_source_id(rs_event_source& source_id, const rs_
     case RS_STREAM_COLOR:
     case RS_STREAM_INFRARED:
     case RS_STREAM_INFRARED2:
-        source_id = RS_EVENT_IMU_DEPTH_CAM;
-        break;
+        return RS_EVENT_IMU_DEPTH_CAM;
     case RS_STREAM_FISHEYE:
-        source_id = RS_EVENT_IMU_MOTION_CAM;
-        break;
+        return RS_EVENT_IMU_MOTION_CAM;
     default:
         throw std::runtime_error(to_string() << "Unsupported source stream requested " << rs_stream_to_string(stream));
     }
 }
 
-void timestamp_corrector::correct_timestamp(frame_interface& frame, rs_stream stream)
+bool timestamp_corrector::correct_timestamp(frame_interface& frame, rs_stream stream)
 {
-    unique_lock<mutex> lock(mtx);
+    double timestamp;
+    if (!events[get_source_id(stream)].find(frame.get_frame_number(), *event_queue_size, timestamp)) return false;
 
-    bool res;
-    rs_event_source source_id;
-    update_source_id(source_id, stream);
-    if (!(res = data_queue[source_id].correct(frame)))
-    {
-        const auto ready = [&]() { return data_queue[source_id].correct(frame); };
-        res = cv.wait_for(lock, std::chrono::milliseconds(*events_timeout), ready);
-    }
+    frame.set_timestamp(timestamp);
+    frame.set_timestamp_domain(RS_TIMESTAMP_DOMAIN_MICROCONTROLLER);
+    return true;
+}
 
-    if (res)
-    {
-        frame.set_timestamp_domain(RS_TIMESTAMP_DOMAIN_MICROCONTROLLER);
-    }
-    lock.unlock();
+bool timestamp_corrector::wait_and_correct_timestamp(frame_interface& frame, rs_stream stream, std::chrono::system_clock::time_point captured)
+{
+    if (correct_timestamp(frame, stream)) return true;
+
+    unique_lock<mutex> lock(mtx);
+    waiters.fetch_add(1);
+    atomic_thread_fence(memory_order_seq_cst);
+    auto res = cv.wait_until(lock, captured + std::chrono::milliseconds(*events_timeout), [&]() { return correct_timestamp(frame, stream); });
+    waiters.fetch_sub(1);
+    return res;
 }
@@ -2,11 +2,11 @@
 #ifndef LIBREALSENSE_TIMESTAMPS_H
 #define LIBREALSENSE_TIMESTAMPS_H
 
-#include "../include/librealsense/rs.h"     // Inherit all type definitions in the public API
-#include <deque>
+#include "types.h"
 #include <condition_variable>
 #include <mutex>
 #include <atomic>
+#include <chrono>
 
 
 namespace rsimpl
@@ -23,43 +23,57 @@ namespace rsimpl
     };
 
 
-    class concurrent_queue{
+    // Events of one source, each kept in the slot of its frame number modulo the capacity, so that finding the event of a frame is a single lookup.
+    // Events are pushed by the motion data channel and looked up from any thread without a lock: a slot is marked empty while it is rewritten,
+    // and a reader only takes its timestamp if the slot held the same frame number before and after reading it.
+    class event_ring
+    {
+        struct slot
+        {
+            std::atomic<unsigned long long> frame_number;
+            std::atomic<double> timestamp;
+        };
+        slot slots[RS_MAX_EVENT_QUEUE_SIZE];
+        std::atomic<unsigned long long> latest; // Highest frame number pushed so far
+
+        event_ring(const event_ring &) = delete;
+        event_ring & operator=(const event_ring &) = delete;
     public:
-        void    push_back_data(rs_timestamp_data data);
-        bool    pop_front_data();
-        bool    erase(rs_timestamp_data data);
-        bool    correct(frame_interface& frame);
-        size_t  size();
-
-        private:
-        std::deque<rs_timestamp_data> data_queue;
-        std::mutex mtx;
+        event_ring();
 
+        void push(const rs_timestamp_data & data);
+        bool find(unsigned long long frame_number, uint32_t depth, double & timestamp) const; // Only the latest depth frame numbers are considered
     };
 
     class timestamp_corrector_interface{
     public:
         virtual ~timestamp_corrector_interface() {}
         virtual void on_timestamp(rs_timestamp_data data) = 0;
-        virtual void correct_timestamp(frame_interface& frame, rs_stream stream) = 0;
+        virtual bool correct_timestamp(frame_interface& frame, rs_stream stream) = 0;
+        virtual bool wait_and_correct_timestamp(frame_interface& frame, rs_stream stream, std::chrono::system_clock::time_point captured) = 0;
         virtual void release() = 0;
     };
 
 
+    // Frames take the timestamp of the motion module event carrying their frame number. Correction never waits on the capture threads: a frame
+    // whose event has not arrived yet is published as it is, to be corrected later by the application side, which may wait for the event.
     class timestamp_corrector : public timestamp_corrector_interface{
     public:
         timestamp_corrector(std::atomic<uint32_t>* event_queue_size, std::atomic<uint32_t>* events_timeout);
         ~timestamp_corrector() override;
         void on_timestamp(rs_timestamp_data data) override;
-        void correct_timestamp(frame_interface& frame, rs_stream stream) override;
+        bool correct_timestamp(frame_interface& frame, rs_stream stream) override; // Returns false at once if the event has not arrived
+        bool wait_and_correct_timestamp(frame_interface& frame, rs_stream stream, std::chrono::system_clock::time_point captured) override; // Waits until events_timeout after captured
         void release() override  {delete this;}
+        uint32_t get_events_timeout() const { return *events_timeout; } // Milliseconds
 
     private:
-        void update_source_id(rs_event_source& source_id, const rs_stream stream);
+        static rs_event_source get_source_id(const rs_stream stream);
 
-        std::mutex mtx;
-        concurrent_queue data_queue[RS_EVENT_SOURCE_COUNT];
+        event_ring events[RS_EVENT_SOURCE_COUNT];
+        std::mutex mtx;                 // Only guards the wait / notify handshake with wait_and_correct_timestamp
         std::condition_variable cv;
+        std::atomic<int> waiters;
         std::atomic<uint32_t>* event_queue_size;
         std::atomic<uint32_t>* events_timeout;
 
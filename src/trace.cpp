@@ -0,0 +1,140 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#include "trace.h"
+#include "types.h"
+
+#include <fstream>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+using namespace rsimpl;
+
+uint64_t trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef RS_ENABLE_TRACING
+
+namespace
+{
+    const size_t ring_capacity = 1 << 14; // Spans kept per thread
+
+    struct span_record
+    {
+        const char * name;
+        uint64_t begin, end;
+    };
+
+    // Written by one thread at a time, read by exporters, which skip the records that may have been overwritten while they read them
+    struct span_ring
+    {
+        int id;                             // Thread id of the trace
+        span_record records[ring_capacity];
+        std::atomic<uint64_t> written;      // Records ever written, the latest at (written - 1) % ring_capacity
+
+        explicit span_ring(int id) : id(id), written(0) {}
+    };
+
+    struct ring_registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<span_ring>> rings, free_rings; // All rings, and those whose thread ended
+    };
+
+    ring_registry & get_registry()
+    {
+        static ring_registry registry;
+        return registry;
+    }
+
+    // Takes a ring when the thread records its first span, and hands it back when the thread ends
+    class thread_ring
+    {
+        std::shared_ptr<span_ring> ring;
+    public:
+        thread_ring()
+        {
+            auto & registry = get_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            if (registry.free_rings.empty())
+            {
+                registry.rings.push_back(std::make_shared<span_ring>(static_cast<int>(registry.rings.size()) + 1));
+                ring = registry.rings.back();
+            }
+            else
+            {
+                ring = registry.free_rings.back();
+                registry.free_rings.pop_back();
+            }
+        }
+        ~thread_ring()
+        {
+            auto & registry = get_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.free_rings.push_back(ring);
+        }
+        span_ring & get() { return *ring; }
+    };
+}
+
+void trace::record(const char * name, uint64_t begin, uint64_t end)
+{
+    static thread_local thread_ring ring;
+    auto & r = ring.get();
+    const auto written = r.written.load(std::memory_order_relaxed);
+    r.records[written % ring_capacity] = { name, begin, end };
+    r.written.store(written + 1, std::memory_order_release);
+}
+
+void trace::export_chrome_trace(const std::string & path)
+{
+    std::vector<std::shared_ptr<span_ring>> rings;
+    {
+        auto & registry = get_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        rings = registry.rings;
+    }
+
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error(to_string() << "could not create trace " << path);
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    std::vector<span_record> records;
+    for (auto & ring : rings)
+    {
+        // Copy the records, then drop those the thread may have overwritten meanwhile
+        const auto written = ring->written.load(std::memory_order_acquire);
+        const auto begin = written > ring_capacity ? written - ring_capacity : 0;
+        records.clear();
+        for (auto i = begin; i < written; ++i) records.push_back(ring->records[i % ring_capacity]);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const auto rewritten = ring->written.load(std::memory_order_relaxed);
+        const size_t overwritten = rewritten - written > records.size() ? records.size() : static_cast<size_t>(rewritten - written);
+
+        for (size_t i = overwritten; i < records.size(); ++i)
+        {
+            auto & r = records[i];
+            out << (first ? "" : ",") << "\n{\"name\":\"" << r.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->id
+                << ",\"ts\":" << r.begin / 1000.0 << ",\"dur\":" << (r.end - r.begin) / 1000.0 << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    if (!out) throw std::runtime_error(to_string() << "could not write trace " << path);
+}
+
+#else
+
+void trace::record(const char *, uint64_t, uint64_t) {}
+
+void trace::export_chrome_trace(const std::string &)
+{
+    throw std::runtime_error("librealsense was built without RS_ENABLE_TRACING");
+}
+
+#endif
@@ -0,0 +1,46 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_TRACE_H
+#define LIBREALSENSE_TRACE_H
+
+#include <string>
+#include <cstdint>
+
+// RS_TRACE_SPAN(name) times the rest of the enclosing scope as a span of the calling thread, name being a string literal. Spans are only
+// recorded by libraries built with RS_ENABLE_TRACING, and compile to nothing otherwise.
+#ifdef RS_ENABLE_TRACING
+#define RS_TRACE_CONCAT_(a, b) a##b
+#define RS_TRACE_CONCAT(a, b) RS_TRACE_CONCAT_(a, b)
+#define RS_TRACE_SPAN(name) rsimpl::trace::span RS_TRACE_CONCAT(trace_span_, __LINE__)(name)
+#else
+#define RS_TRACE_SPAN(name) do {} while (false)
+#endif
+
+namespace rsimpl
+{
+    namespace trace
+    {
+        uint64_t now(); // Nanoseconds of the monotonic clock
+
+        // Records a span into the ring of the calling thread, a thread only ever writing to its own ring, so that recording never locks.
+        // Rings keep the latest spans of their thread, overwriting the oldest, and are handed to the next thread started once theirs ends.
+        void record(const char * name, uint64_t begin, uint64_t end);
+
+        class span
+        {
+            const char * name;
+            uint64_t begin;
+        public:
+            explicit span(const char * name) : name(name), begin(now()) {}
+            ~span() { record(name, begin, now()); }
+        };
+
+        // Writes the spans the rings hold in the Chrome trace event format, which Perfetto and chrome://tracing open. Throws if the library
+        // was built without RS_ENABLE_TRACING.
+        void export_chrome_trace(const std::string & path);
+    }
+}
+
+#endif
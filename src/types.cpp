@@ -4,6 +4,7 @@
 #include "types.h"
 #include "image.h"
 #include "device.h"
+#include "pipeline.h"
 
 #include <cstring>
 #include <algorithm>
@@ -32,7 +33,10 @@ namespace rsimpl
         CASE(DEPTH_ALIGNED_TO_RECTIFIED_COLOR)
         CASE(INFRARED2_ALIGNED_TO_DEPTH)
         CASE(DEPTH_ALIGNED_TO_INFRARED2)
+        CASE(DEPTH_COLORIZED)
         CASE(FISHEYE)
+        CASE(RECTIFIED_FISHEYE)
+        CASE(NORMALS)
         default: assert(!is_valid(value)); return unknown;
         }
         #undef CASE
@@ -57,6 +61,12 @@ namespace rsimpl
         CASE(RAW10)
         CASE(RAW16)
         CASE(RAW8)
+        CASE(XYZ16F)
+        CASE(XYZ16)
+        CASE(XYZUV32F)
+        CASE(NV12)
+        CASE(I420)
+        CASE(XYZ32F_PLANAR)
         default: assert(!is_valid(value)); return unknown;
         }
         #undef CASE
@@ -156,6 +166,36 @@ namespace rsimpl
         CASE(FISHEYE_EXTERNAL_TRIGGER)
         CASE(FRAMES_QUEUE_SIZE)
         CASE(TOTAL_FRAME_DROPS)
+        CASE(FRAME_UNPACK_THREADS)
+        CASE(DEPTH_DECIMATION_FACTOR)
+        CASE(DEPTH_DECIMATION_MODE)
+        CASE(DEPTH_SPATIAL_FILTER_ALPHA)
+        CASE(DEPTH_SPATIAL_FILTER_DELTA)
+        CASE(DEPTH_TEMPORAL_FILTER_ALPHA)
+        CASE(DEPTH_TEMPORAL_FILTER_DELTA)
+        CASE(DEPTH_TEMPORAL_FILTER_PERSISTENCE)
+        CASE(DEPTH_STATISTICS_ENABLED)
+        CASE(PRECOMPUTED_STREAMS)
+        CASE(DEPTH_COLORIZER_EQUALIZATION_ENABLED)
+        CASE(DEPTH_COLORIZER_MAX_DISTANCE)
+        CASE(POINTS_VOXEL_SIZE)
+        CASE(CAPTURE_THREAD_AFFINITY)
+        CASE(CAPTURE_THREAD_PRIORITY)
+        CASE(CAPTURE_MEMORY)
+        CASE(MOTION_DATA_TRANSFER_COUNT)
+        CASE(CONTROL_RETRY_BUDGET)
+        CASE(GPU_PROCESSING_ENABLED)
+        CASE(DERIVED_ROW_ALIGNMENT)
+        CASE(FRAME_MEMORY_PAGES)
+        CASE(NUMA_LOCALITY_ENABLED)
+        CASE(FRAME_MAILBOX_ENABLED)
+        CASE(INTERLEAVED_VIEWS_ENABLED)
+        CASE(DEPTH_PYRAMID_LEVELS)
+        CASE(FRAME_UNPACK_BANDS)
+        CASE(COLOR_DEMOSAIC_MODE)
+        CASE(DEPTH_RUNS_ENABLED)
+        CASE(INCREMENTAL_PROCESSING_ENABLED)
+        CASE(ZERO_COPY_ENABLED)
         CASE(FISHEYE_ENABLE_AUTO_EXPOSURE)
         CASE(FISHEYE_AUTO_EXPOSURE_MODE)
         CASE(FISHEYE_AUTO_EXPOSURE_ANTIFLICKER_RATE)
@@ -267,6 +307,25 @@ namespace rsimpl
         {
         CASE(ACTUAL_EXPOSURE)
         CASE(ACTUAL_FPS)
+        CASE(DEPTH_MIN)
+        CASE(DEPTH_MAX)
+        CASE(DEPTH_VALID_PIXELS)
+        CASE(DEPTH_HISTOGRAM_0)
+        CASE(DEPTH_HISTOGRAM_1)
+        CASE(DEPTH_HISTOGRAM_2)
+        CASE(DEPTH_HISTOGRAM_3)
+        CASE(DEPTH_HISTOGRAM_4)
+        CASE(DEPTH_HISTOGRAM_5)
+        CASE(DEPTH_HISTOGRAM_6)
+        CASE(DEPTH_HISTOGRAM_7)
+        CASE(TIME_OF_DEQUEUE)
+        CASE(TIME_OF_VALIDATION)
+        CASE(TIME_OF_UNPACK_START)
+        CASE(TIME_OF_UNPACK_END)
+        CASE(TIME_OF_COMMIT)
+        CASE(TIME_OF_SYNC)
+        CASE(TIME_OF_DELIVERY)
+        CASE(TIME_OF_EXPOSURE)
         default: assert(!is_valid(value)); return unknown;
         }
         #undef CASE
@@ -284,9 +343,98 @@ namespace rsimpl
         #undef CASE
     }
 
+    const char * get_string(rs_frame_drop_policy value)
+    {
+        #define CASE(X) case RS_FRAME_DROP_POLICY_##X: return #X;
+        switch (value)
+        {
+        CASE(DROP_OLDEST)
+        CASE(DROP_NEWEST)
+        CASE(LATEST_ONLY)
+        default: assert(!is_valid(value)); return unknown;
+        }
+        #undef CASE
+    }
+
+    const char * get_string(rs_straggler_policy value)
+    {
+        #define CASE(X) case RS_STRAGGLER_POLICY_##X: return #X;
+        switch (value)
+        {
+        CASE(DROP_SET)
+        CASE(DELIVER_PARTIAL)
+        default: assert(!is_valid(value)); return unknown;
+        }
+        #undef CASE
+    }
+
+    const char * get_string(rs_playback_pacing value)
+    {
+        #define CASE(X) case RS_PLAYBACK_PACING_##X: return #X;
+        switch (value)
+        {
+        CASE(REAL_TIME)
+        CASE(AS_FAST_AS_POSSIBLE)
+        CASE(STEP)
+        default: assert(!is_valid(value)); return unknown;
+        }
+        #undef CASE
+    }
+
+    const char * get_string(rs_stream_metric value)
+    {
+        #define CASE(X) case RS_STREAM_METRIC_##X: return #X;
+        switch (value)
+        {
+        CASE(FRAMES_RECEIVED)
+        CASE(FRAMES_INVALID)
+        CASE(FRAMES_CULLED)
+        CASE(FRAMES_UNPUBLISHED)
+        CASE(QUEUED_FRAMES)
+        CASE(UNPACK_NANOSECONDS)
+        CASE(CALLBACK_NANOSECONDS)
+        CASE(DERIVED_FRAMES_SHED)
+        CASE(UNPACKS_SHED)
+        CASE(FRAMES_DECIMATED)
+        default: assert(!is_valid(value)); return unknown;
+        }
+        #undef CASE
+    }
+
+    const char * get_string(rs_transfer_statistic value)
+    {
+        #define CASE(X) case RS_TRANSFER_STATISTIC_##X: return #X;
+        switch (value)
+        {
+        CASE(BYTES)
+        CASE(BYTES_PER_SECOND)
+        CASE(FRAMES)
+        CASE(SHORT_FRAMES)
+        CASE(ERRORS)
+        default: assert(!is_valid(value)); return unknown;
+        }
+        #undef CASE
+    }
+
+    const char * get_string(rs_load_shedding_action value)
+    {
+        #define CASE(X) case RS_LOAD_SHEDDING_ACTION_##X: return #X;
+        switch (value)
+        {
+        CASE(SKIP_DERIVED_STREAMS)
+        CASE(SKIP_CULLED_UNPACKING)
+        CASE(DECIMATE_FRAMERATE)
+        default: assert(!is_valid(value)); return unknown;
+        }
+        #undef CASE
+    }
+
     size_t subdevice_mode_selection::get_image_size(rs_stream stream) const
     {
-        return rsimpl::get_image_size(get_width(), get_height(), get_format(stream));
+        auto size = rsimpl::get_image_size(get_width(), get_height(), get_format(stream));
+        if(builds_pyramid(stream)) size += get_depth_pyramid_size(get_output_width(stream), get_output_height(stream), depth_pyramid_levels);
+        if(finds_depth_runs(stream)) size = std::max(size, get_depth_runs_offset(get_output_width(stream), get_output_height(stream), builds_pyramid(stream) ? depth_pyramid_levels : 0) + get_depth_runs_size(get_output_width(stream), get_output_height(stream)));
+        return size;
     }
 
     void subdevice_mode_selection::set_output_buffer_format(const rs_output_buffer_format in_output_format)
@@ -294,7 +442,49 @@ namespace rsimpl
         output_format = in_output_format;
     }
 
-    void subdevice_mode_selection::unpack(byte * const dest[], const byte * source) const
+    rs_intrinsics subdevice_mode_selection::get_unpacked_intrinsics(const rs_intrinsics & native) const
+    {
+        const auto intrin = pad_crop_intrinsics(native, pad_crop);
+        return software_crop.width ? crop_intrinsics(intrin, software_crop.x, software_crop.y, software_crop.width, software_crop.height) : intrin;
+    }
+
+    void subdevice_mode_selection::crop(const stream_crop & window)
+    {
+        // Windows start on whole pixels of every packed format, such as the pixel pairs of YUY2, and planar formats are never cropped
+        const int x = window.x - pad_crop, y = window.y - pad_crop;
+        const int valid_width = std::min(mode.native_intrinsics.width, mode.native_dims.x), valid_height = std::min(mode.native_intrinsics.height, mode.native_dims.y);
+        if(mode.pf.plane_count != 1) throw std::runtime_error(to_string() << "streams of format " << get_string(get_format(get_outputs().front().first)) << " cannot be cropped");
+        if(window.width <= 0 || window.height <= 0 || x < 0 || y < 0 || x + window.width > valid_width || y + window.height > valid_height)
+            throw std::runtime_error(to_string() << "crop " << window.width << 'x' << window.height << " at " << window.x << ',' << window.y << " does not lie within the " << get_width() << 'x' << get_height() << " image of " << get_string(get_outputs().front().first));
+        if(window.x % 2 || window.width % 2) throw std::runtime_error("crops must start on and span an even number of columns");
+        software_crop = window;
+        row_unpacker = nullptr;
+    }
+
+    void subdevice_mode_selection::move_crop_to_driver()
+    {
+        const int x = software_crop.x - pad_crop, y = software_crop.y - pad_crop;
+        uncropped_dims = mode.native_dims;
+        mode.native_dims = { software_crop.width, software_crop.height };
+        mode.native_intrinsics = crop_intrinsics(mode.native_intrinsics, x, y, software_crop.width, software_crop.height);
+        for(auto & rect : mode.rect_modes) rect = crop_intrinsics(rect, x, y, software_crop.width, software_crop.height);
+        pad_crop = 0;
+        software_crop = {};
+        cropped_in_driver = true;
+        row_unpacker = find_row_unpacker(get_unpacker().unpack, get_unpacked_width());
+        unpack_bands = choose_unpack_bands(unpack_bands); // The window is all the driver delivers
+    }
+
+    int subdevice_mode_selection::choose_unpack_bands(int max_bands) const
+    {
+        // Planar formats unpack every plane in one pass, and so does a copy of depth gathering its statistics
+        const int height = get_unpacked_height();
+        if(max_bands <= 1 || mode.pf.plane_count != 1 || height <= 1) return 1;
+        const size_t bytes = mode.pf.get_image_size(mode.native_dims.x, height);
+        return static_cast<int>(std::max<size_t>(1, std::min<size_t>({ bytes / RS_MIN_UNPACK_BAND_BYTES, static_cast<size_t>(max_bands), static_cast<size_t>(height) })));
+    }
+
+    void subdevice_mode_selection::unpack(byte * const dest[], const byte * source, temporal_depth_history * depth_history, depth_statistics * statistics, parallel_pool * bands_pool) const
     {
         const int MAX_OUTPUTS = 2;
         const auto & outputs = get_outputs();        
@@ -303,7 +493,40 @@ namespace rsimpl
         // Determine input stride (and apply cropping)
         const byte * in = source;
         size_t in_stride = mode.pf.get_image_size(mode.native_dims.x, 1);
-        if(pad_crop < 0) in += in_stride * -pad_crop + mode.pf.get_image_size(-pad_crop, 1);
+        if(software_crop.width) in += in_stride * (software_crop.y - pad_crop) + mode.pf.get_image_size(software_crop.x - pad_crop, 1);
+        else if(pad_crop < 0) in += in_stride * -pad_crop + mode.pf.get_image_size(-pad_crop, 1);
+
+        // 4:2:0 images are not made of rows of pixels, their chroma planes are filled from pairs of rows, in bands starting on even rows
+        if(outputs.size() == 1 && is_yuv420(outputs[0].second))
+        {
+            assert(pad_crop <= 0 || software_crop.width); // The padding of depth does not apply to color
+            const int width = get_width(), height = get_height(), pairs = (height + 1) / 2;
+            auto unpack_pairs = [&](int first_pair, int pair_count)
+            {
+                unpack_yuy2_to_yuv420(dest[0], outputs[0].second, width, height, in, in_stride, first_pair * 2, std::min(pair_count * 2, height - first_pair * 2));
+            };
+            const int bands = bands_pool ? std::min(unpack_bands, pairs) : 1;
+            if(bands > 1) bands_pool->parallel_for(bands, [&](int band) { unpack_pairs(pairs * band / bands, pairs * (band + 1) / bands - pairs * band / bands); });
+            else unpack_pairs(0, pairs);
+            return;
+        }
+
+        // Demosaicing interpolates every pixel from the rows around it, which bands read past their own rows
+        if(outputs.size() == 1 && mode.pf.fourcc == pf_rw10.fourcc && outputs[0].second != RS_FORMAT_RAW10)
+        {
+            assert(pad_crop <= 0 || software_crop.width); // The padding of depth does not apply to color
+            const int width = get_width(), height = get_height();
+            const int x = software_crop.width ? software_crop.x - pad_crop : -pad_crop, y = software_crop.width ? software_crop.y - pad_crop : -pad_crop;
+            const int raw_width = std::min(mode.native_intrinsics.width, mode.native_dims.x), raw_height = std::min(mode.native_intrinsics.height, mode.native_dims.y);
+            auto unpack_rows = [&](int first_row, int row_count)
+            {
+                demosaic_raw10(dest[0], outputs[0].second, width, height, source, in_stride, raw_width, raw_height, x, y, first_row, row_count, demosaic_corrected);
+            };
+            const int bands = bands_pool ? std::min(unpack_bands, height) : 1;
+            if(bands > 1) bands_pool->parallel_for(bands, [&](int band) { unpack_rows(height * band / bands, height * (band + 1) / bands - height * band / bands); });
+            else unpack_rows(0, height);
+            return;
+        }
 
         // Determine output stride (and apply padding)
         byte * out[MAX_OUTPUTS];
@@ -312,38 +535,116 @@ namespace rsimpl
         {
             out[i] = dest[i];
             out_stride[i] = rsimpl::get_image_size(get_width(), 1, outputs[i].second);
-            if(pad_crop > 0) out[i] += out_stride[i] * pad_crop + rsimpl::get_image_size(pad_crop, 1, outputs[i].second);
+            if(pad_crop > 0 && !software_crop.width) out[i] += out_stride[i] * pad_crop + rsimpl::get_image_size(pad_crop, 1, outputs[i].second);
         }
 
+        // A plain copy of depth gathers its statistics on the way, unless the image is changed afterwards
+        const bool statistics_pass = statistics && computes_statistics(RS_STREAM_DEPTH);
+        const bool copy_statistics = statistics_pass && outputs.size() == 1 && !get_unpacker().requires_processing && !is_decimated(RS_STREAM_DEPTH) && !is_filtered(RS_STREAM_DEPTH);
+        auto unpack_pixels = [&](byte * const dest[], const byte * source, int count)
+        {
+            if(copy_statistics) accumulate_depth_statistics(reinterpret_cast<const uint16_t *>(source), count, *statistics, reinterpret_cast<uint16_t *>(dest[0]));
+            else mode.pf.unpackers[unpacker_index].unpack(dest, source, count);
+        };
+
         // Unpack (potentially a subrect of) the source image into (potentially a subrect of) the destination buffers
         const int unpack_width = get_unpacked_width(), unpack_height = get_unpacked_height();
-        if(mode.native_dims.x == get_width())
-        {
-            // If not strided, unpack as though it were a single long row
-            mode.pf.unpackers[unpacker_index].unpack(out, in, unpack_width * unpack_height);
-        }
-        else
+        const bool rows_unpacked = row_unpacker && !copy_statistics && (mode.native_dims.x != get_width() || unpack_width == get_width());
+        const bool long_row = !rows_unpacked && mode.native_dims.x == get_width();
+        auto unpack_rows = [&](int first_row, int row_count)
         {
-            
-            // Otherwise unpack one row at a time
-            assert(mode.pf.plane_count == 1); // Can't unpack planar formats row-by-row (at least not with the current architecture, would need to pass multiple source ptrs to unpack)
-            for(int i=0; i<unpack_height; ++i)
+            const byte * band_in = in + in_stride * first_row;
+            byte * band_out[MAX_OUTPUTS];
+            for(size_t i=0; i<outputs.size(); ++i) band_out[i] = out[i] + out_stride[i] * first_row;
+            if(rows_unpacked)
             {
-                mode.pf.unpackers[unpacker_index].unpack(out, in, unpack_width);
-                for(size_t i=0; i<outputs.size(); ++i) out[i] += out_stride[i];
-                in += in_stride;
+                // An instance with the width built in, whose rows the compiler unrolled and vectorized
+                row_unpacker(band_out, out_stride, band_in, in_stride, row_count);
             }
+            else if(long_row)
+            {
+                // If not strided, unpack as though it were a single long row
+                unpack_pixels(band_out, band_in, unpack_width * row_count);
+            }
+            else
+            {
+                // Otherwise unpack one row at a time
+                assert(mode.pf.plane_count == 1); // Can't unpack planar formats row-by-row (at least not with the current architecture, would need to pass multiple source ptrs to unpack)
+                for(int y=0; y<row_count; ++y)
+                {
+                    unpack_pixels(band_out, band_in, unpack_width);
+                    for(size_t i=0; i<outputs.size(); ++i) band_out[i] += out_stride[i];
+                    band_in += in_stride;
+                }
+            }
+        };
+
+        // Rows are independent of one another, so bands of them unpack in parallel. A long row only splits on rows when it is made of whole
+        // rows of the native image, and the statistics gathered by a copy of depth are not shared between bands.
+        const int bands = bands_pool && !copy_statistics && (!long_row || unpack_width == get_width()) ? std::min(unpack_bands, unpack_height) : 1;
+        if(bands > 1) bands_pool->parallel_for(bands, [&](int band) { unpack_rows(unpack_height * band / bands, unpack_height * (band + 1) / bands - unpack_height * band / bands); });
+        else unpack_rows(0, unpack_height);
+
+        // Shrink and filter depth in place, while the image is still hot in cache
+        for(size_t i=0; i<outputs.size(); ++i)
+        {
+            if(outputs[i].first != RS_STREAM_DEPTH) continue;
+            auto depth = reinterpret_cast<uint16_t *>(dest[i]);
+            if(is_decimated(RS_STREAM_DEPTH)) decimate_depth(depth, get_width(), get_height(), decimation_factor, decimation_mean);
+            const int width = get_output_width(RS_STREAM_DEPTH), height = get_output_height(RS_STREAM_DEPTH);
+            if(depth_filter.spatial_enabled()) filter_depth_spatial(depth, width, height, depth_filter.spatial_alpha, depth_filter.spatial_delta);
+            if(depth_filter.temporal_enabled() && depth_history) filter_depth_temporal(depth, width * height, *depth_history, depth_filter.temporal_alpha, depth_filter.temporal_delta, depth_filter.temporal_persistence);
+            if(statistics_pass && !copy_statistics) accumulate_depth_statistics(depth, width * height, *statistics); // The image is still in cache
+            if(builds_pyramid(RS_STREAM_DEPTH)) build_depth_pyramid(depth + width * height, depth, width, height, depth_pyramid_levels);
+            if(finds_depth_runs(RS_STREAM_DEPTH)) find_depth_runs(reinterpret_cast<uint32_t *>(dest[i] + get_depth_runs_offset(width, height, builds_pyramid(RS_STREAM_DEPTH) ? depth_pyramid_levels : 0)), depth, width, height);
         }
     }
 
+    bool subdevice_mode_selection::requires_processing() const
+    {
+        if(mode.pf.unpackers[unpacker_index].requires_processing) return true;
+        if(is_decimated(RS_STREAM_DEPTH) || is_filtered(RS_STREAM_DEPTH) || computes_statistics(RS_STREAM_DEPTH) || builds_pyramid(RS_STREAM_DEPTH) || finds_depth_runs(RS_STREAM_DEPTH)) return true;
+        if(output_format == RS_OUTPUT_BUFFER_FORMAT_NATIVE) return false;
+
+        // A continuous buffer can be handed out as is when the native image carries no padding and the driver lets us hold on to it
+        if(!zero_copy || pad_crop != 0 || software_crop.width || mode.pf.plane_count != 1) return true;
+        if(mode.native_dims.x != get_width() || mode.native_dims.y < get_height()) return true;
+        for(auto & output : get_outputs())
+        {
+            if(rsimpl::get_image_size(get_width(), 1, output.second) != mode.pf.get_image_size(mode.native_dims.x, 1)) return true;
+        }
+        return false;
+    }
+
+    int subdevice_mode_selection::get_plane_view(size_t output) const
+    {
+        auto & views = get_unpacker().plane_views;
+        if(output >= views.size() || views[output] < 0 || is_decimated(get_outputs()[output].first) || is_filtered(get_outputs()[output].first) || computes_statistics(get_outputs()[output].first) || builds_pyramid(get_outputs()[output].first) || finds_depth_runs(get_outputs()[output].first)) return -1;
+
+        // The plane must stay valid while the application holds the frame, and must be laid out exactly like the output image
+        if(!zero_copy || pad_crop != 0 || software_crop.width || mode.native_dims.x != get_width() || mode.native_dims.y != get_height()) return -1;
+        if(rsimpl::get_image_size(get_width(), get_height(), get_outputs()[output].second) * mode.pf.plane_count != mode.pf.get_image_size(mode.native_dims.x, mode.native_dims.y)) return -1;
+        return views[output];
+    }
+
+    int subdevice_mode_selection::get_interleaved_view(size_t output) const
+    {
+        auto & offsets = get_unpacker().interleaved_offsets;
+        if(!interleaved_views || output >= offsets.size() || offsets[output] < 0) return -1;
+
+        // As for plane views, the native frame must stay valid while the application holds the view, and its rows must be those of the output
+        if(!zero_copy || pad_crop != 0 || software_crop.width || mode.native_dims.x != get_width() || mode.native_dims.y != get_height()) return -1;
+        return offsets[output];
+    }
+
     int subdevice_mode_selection::get_unpacked_width() const
     {
-        return std::min(mode.native_intrinsics.width, get_width());
+        return software_crop.width ? software_crop.width : std::min(mode.native_intrinsics.width, get_width());
     }
 
     int subdevice_mode_selection::get_unpacked_height() const
     {
-        return std::min(mode.native_intrinsics.height, get_height());
+        return software_crop.width ? software_crop.height : std::min(mode.native_intrinsics.height, get_height());
     }
 
     ////////////////////////
@@ -370,6 +671,7 @@ namespace rsimpl
     {
         for(auto & s : stream_subdevices) s = -1;
         for(auto & s : data_subdevices) s = -1;
+        for(auto & s : croppable_subdevices) s = false;
         for(auto & s : presets) for(auto & p : s) p = stream_request();
         for(auto & p : stream_poses)
         {
@@ -417,7 +719,7 @@ namespace rsimpl
     // once there is a item that all its stream requsts are filled 
     // and validated to satisfies all interstream constraints
     // copy it to requests parameter and return true.
-    bool device_config::find_good_requests_combination( stream_request(&requests)[RS_STREAM_NATIVE_COUNT], std::vector<stream_request> stream_requests[RS_STREAM_NATIVE_COUNT]) const
+    bool device_config::find_good_requests_combination( stream_request(&requests)[RS_STREAM_NATIVE_COUNT], const std::vector<stream_request> stream_requests[RS_STREAM_NATIVE_COUNT]) const
     {
         std::deque<search_request_params> calls;
   
@@ -486,13 +788,10 @@ namespace rsimpl
         }
 
         //If the user did not fill all requests, we need to fill the missing requests
-
-        std::vector<stream_request> stream_requests[RS_STREAM_NATIVE_COUNT];
-        //Get all requests posibilities in order to find the requests that satisfies interstream constraints
-        get_all_possible_requestes(stream_requests);
+        //from all requests posibilities, gathered once when the config was made
 
         //find stream requests combination that satisfies all interstream constraints
-        return find_good_requests_combination(requests, stream_requests);
+        return find_good_requests_combination(requests, possible_requests);
     }
 
     void device_config::get_all_possible_requestes(std::vector<stream_request>(&stream_requests)[RS_STREAM_NATIVE_COUNT]) const
@@ -596,7 +895,34 @@ namespace rsimpl
         throw std::runtime_error(ss.str());
     }
 
-    std::vector<subdevice_mode_selection> device_config::select_modes(const stream_request (&reqs)[RS_STREAM_NATIVE_COUNT]) const
+    static bool same_request(const stream_request & a, const stream_request & b)
+    {
+        return a.enabled == b.enabled && a.width == b.width && a.height == b.height && a.format == b.format && a.fps == b.fps && a.output_format == b.output_format;
+    }
+
+    bool mode_selection_cache::find(const stream_request(&requests)[RS_STREAM_NATIVE_COUNT], std::vector<subdevice_mode_selection> & modes) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto & e : entries)
+        {
+            if (!std::equal(std::begin(requests), std::end(requests), std::begin(e.requests), same_request)) continue;
+            modes = e.modes;
+            ++hits;
+            return true;
+        }
+        return false;
+    }
+
+    void mode_selection_cache::insert(const stream_request(&requests)[RS_STREAM_NATIVE_COUNT], const std::vector<subdevice_mode_selection> & modes) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entries.size() == max_entries) entries.clear();
+        entries.push_back({});
+        std::copy(std::begin(requests), std::end(requests), std::begin(entries.back().requests));
+        entries.back().modes = modes;
+    }
+
+    std::vector<subdevice_mode_selection> device_config::resolve_modes(const stream_request (&reqs)[RS_STREAM_NATIVE_COUNT]) const
     {
         // Make a mutable copy of our array
         stream_request requests[RS_STREAM_NATIVE_COUNT];
@@ -615,11 +941,117 @@ namespace rsimpl
         for(int i = 0; i < num_subdevices; ++i)
         {
             auto selection = select_mode(requests, i);
-            if(selection.mode.pf.fourcc) selected_modes.push_back(selection);
+            if(!selection.mode.pf.fourcc) continue;
+            selected_modes.push_back(selection);
+        }
+        return selected_modes;
+    }
+
+    std::vector<subdevice_mode_selection> device_config::select_modes(const stream_request (&requests)[RS_STREAM_NATIVE_COUNT]) const
+    {
+        // Only the sets of requests resolving to modes are kept, so that failing sets keep reporting their error
+        std::vector<subdevice_mode_selection> selected_modes;
+        if(!selections.find(requests, selected_modes))
+        {
+            selected_modes = resolve_modes(requests);
+            selections.insert(requests, selected_modes);
+        }
+
+        for(auto & selection : selected_modes)
+        {
+            selection.decimation_factor = depth_decimation_factor;
+            selection.decimation_mean = depth_decimation_mean;
+            selection.demosaic_corrected = color_demosaic_corrected;
+            selection.depth_filter = depth_filter;
+            selection.gather_depth_statistics = gather_depth_statistics;
+            selection.interleaved_views = interleaved_views;
+            selection.depth_pyramid_levels = depth_pyramid_levels;
+            selection.depth_runs = depth_runs;
+            if(selection.mode.pf.plane_count == 1) selection.row_unpacker = find_row_unpacker(selection.get_unpacker().unpack, selection.get_unpacked_width());
+            selection.unpack_bands = selection.choose_unpack_bands(unpack_bands);
+        }
+        return selected_modes;
+    }
+
+    std::vector<subdevice_mode_selection> device_config::select_modes() const
+    {
+        auto selected_modes = select_modes(requests);
+        for(auto & selection : selected_modes)
+        {
+            // The streams of one subdevice are cut from the same native frame
+            const stream_crop * window = nullptr;
+            for(auto & output : selection.get_outputs())
+            {
+                auto & crop = crops[output.first];
+                if(!requests[output.first].enabled || !crop.width) continue;
+                if(window && memcmp(window, &crop, sizeof(crop))) throw std::runtime_error(to_string() << get_string(output.first) << " and the streams it is captured with must be given the same crop");
+                window = &crop;
+            }
+            if(!window) continue;
+            selection.crop(*window);
+            if(selection.mode.pf.plane_count == 1) selection.row_unpacker = find_row_unpacker(selection.get_unpacker().unpack, selection.get_unpacked_width());
+            selection.unpack_bands = selection.choose_unpack_bands(unpack_bands);
         }
         return selected_modes;
     }
 
+    std::vector<request_candidate> device_config::get_bandwidth_candidates() const
+    {
+        const size_t max_combinations = 4096; // Bounds the search on devices with many streams enabled and left open
+
+        std::vector<request_candidate> candidates(1);
+        for (int i = 0; i < RS_STREAM_NATIVE_COUNT; ++i) candidates[0].requests[i] = requests[i];
+        validate_requests(candidates[0].requests, true);
+        fill_requests(candidates[0].requests);
+        const auto selected_bandwidth = candidates[0].bandwidth = get_bandwidth(resolve_modes(candidates[0].requests));
+
+        // The options left open by the request of each enabled stream, once per resolution, format and framerate
+        std::vector<stream_request> options[RS_STREAM_NATIVE_COUNT];
+        for (int i = 0; i < RS_STREAM_NATIVE_COUNT; ++i)
+        {
+            std::vector<stream_request> open;
+            if (requests[i].enabled) for (auto & o : possible_requests[i])
+            {
+                if (requests[i].contradict(o)) continue;
+                if (std::any_of(open.begin(), open.end(), [&o](const stream_request & r) { return r.width == o.width && r.height == o.height && r.format == o.format && r.fps == o.fps; })) continue;
+                open.push_back(o);
+            }
+            options[i] = open;
+        }
+
+        // Depth first over the streams, the combinations breaking interstream constraints being cut as soon as they do
+        stream_request combination[RS_STREAM_NATIVE_COUNT];
+        for (int i = 0; i < RS_STREAM_NATIVE_COUNT; ++i) combination[i] = requests[i];
+        size_t combinations = 0;
+        std::function<void(int)> search = [&](int stream)
+        {
+            if (combinations == max_combinations) return;
+            if (stream == RS_STREAM_NATIVE_COUNT)
+            {
+                ++combinations;
+                request_candidate c;
+                for (int i = 0; i < RS_STREAM_NATIVE_COUNT; ++i) c.requests[i] = combination[i];
+                try { c.bandwidth = get_bandwidth(resolve_modes(c.requests)); } // Not cached, the combinations would push out the sets of requests in use
+                catch (const std::exception &) { return; } // No set of modes provides this combination
+                if (c.bandwidth >= selected_bandwidth) return;
+                if (std::any_of(candidates.begin(), candidates.end(), [&c](const request_candidate & k) { return k.bandwidth == c.bandwidth; })) return;
+                candidates.push_back(c);
+                return;
+            }
+            if (!requests[stream].enabled) { search(stream + 1); return; }
+            for (auto & o : options[stream])
+            {
+                combination[stream] = o;
+                if (validate_requests(combination)) search(stream + 1);
+            }
+            combination[stream] = requests[stream];
+        };
+        search(0);
+
+        std::stable_sort(candidates.begin() + 1, candidates.end(), [](const request_candidate & a, const request_candidate & b) { return a.bandwidth > b.bandwidth; });
+        return candidates;
+    }
+
     bool device_config::validate_requests(stream_request(&requests)[RS_STREAM_NATIVE_COUNT], bool throw_exception) const
     {
         // Check and modify requests to enforce all interstream constraints
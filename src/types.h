@@ -23,9 +23,41 @@
 #include <map>          
 #include <algorithm>
 #include <functional>
+#include <new>                              // For placement new
+#include <type_traits>
 
 const uint8_t RS_STREAM_NATIVE_COUNT    = 5;
 const int RS_USER_QUEUE_SIZE = 20;
+const int RS_MAX_USER_QUEUE_SIZE = 1000;   // Frames of a stream the application may hold at once, the frame pools growing to it by RS_USER_QUEUE_SIZE frames per stream
+const int RS_MAX_UNPACK_THREADS = 8;
+const int RS_MAX_UNPACK_BANDS = 8;
+const size_t RS_MIN_UNPACK_BAND_BYTES = 256 * 1024; // Of native data, below which handing a band to a worker costs more than it saves
+const int RS_MAX_DEPTH_DECIMATION = 4;
+const int RS_MAX_DEPTH_PYRAMID_LEVELS = 4;
+const int RS_MAX_DEPTH_FILTER_DELTA = 4096;      // Blended differences must fit 16 bit signed arithmetic
+const int RS_MAX_DEPTH_FILTER_PERSISTENCE = 100; // Frames, must stay below the saturation of the 8 bit pixel ages
+const int RS_MAX_PRECOMPUTED_STREAMS = (1 << (RS_STREAM_COUNT - RS_STREAM_NATIVE_COUNT)) - 1; // Every derived stream
+const double RS_MAX_CAPTURE_THREAD_AFFINITY = 9007199254740991.0; // CPUs 0 to 52, the largest mask an option value holds exactly
+const int RS_MAX_CAPTURE_THREAD_PRIORITY = 99;                    // Highest SCHED_FIFO priority
+const int RS_MAX_CAPTURE_BUFFERS = 32;                            // VIDEO_MAX_FRAME, the most buffers a V4L2 driver accepts
+const int RS_DEFAULT_CONTROL_RETRY_BUDGET = 1000; // Milliseconds
+const int RS_MAX_CONTROL_RETRY_BUDGET = 10000;
+const int RS_DEFAULT_MOTION_DATA_TRANSFERS = 8;
+const int RS_MAX_MOTION_DATA_TRANSFERS = 32;
+const int RS_DEFAULT_STREAM_QUEUE_DEPTH = 4;
+const int RS_MAX_STREAM_QUEUE_DEPTH = 16; // Must be a power of two, bounds the lock-free inbox of every stream
+const int RS_MAX_STREAM_IDLE_TIMEOUT = 3600000; // Milliseconds a stream started on demand may stay on without being consumed
+const double RS_MAX_STREAM_SYNC_TOLERANCE = 1000; // Milliseconds of skew a frameset may tolerate between a stream and the stream it is formed on
+const int RS_MAX_SLICE_ROWS = 4096; // Rows of the slices a frame may be handed out in ahead of the frame
+const int RS_MIN_ENCODER_BITRATE = 100000; // Bits per second of the H.264 encoding of a stream
+const int RS_MAX_ENCODER_BITRATE = 200000000;
+const int RS_OVER_BUDGET_QUEUE_SIZE = 2; // Frames of a stream queued, or published, at once while a device holds more frame memory than its budget
+const int RS_LOAD_CHECK_PERIOD = 100; // Milliseconds between the overload checks of a device shedding load
+const double RS_MAX_CALLBACK_BUSY_RATIO = 0.9; // Share of the time a frame callback may run before its stream counts as overloaded
+const int RS_MOTION_HISTORY_SIZE = 4096;   // Samples kept per motion sensor, a few seconds of gyroscope and accelerometer data
+const int RS_RECORDING_CHUNK_SIZE = 8 << 20; // Bytes of a chunk of a recording, which must hold the largest native frame, or encoding of a depth frame
+const int RS_RECORDING_CHUNK_COUNT = 8;    // Chunks of a recording filled or written at once, beyond which frames are dropped from it
+const int RS_FRAME_HISTORY_SPARE_BUFFERS = 4; // Buffers of frames leaving a frame history kept for the next frames, so that capture rarely allocates
 
 // Timestamp syncronization settings:
 const int RS_MAX_EVENT_QUEUE_SIZE = 500;  // Max number of timestamp events to keep for all streams
@@ -71,9 +103,15 @@ namespace rsimpl
     void log_to_file(rs_log_severity min_severity, const char * file_path);
     void log_to_callback(rs_log_severity min_severity, rs_log_callback * callback);
     void log_to_callback(rs_log_severity min_severity, void(*on_log)(rs_log_severity min_severity, const char * message, void * user), void * user);
-    rs_log_severity get_minimum_severity();
+    void log_asynchronously(int queue_size);
+    unsigned long long get_dropped_log_messages();
 
-#define LOG(SEVERITY, ...) do { if(static_cast<int>(SEVERITY) >= rsimpl::get_minimum_severity()) { std::ostringstream ss; ss << __VA_ARGS__; rsimpl::log(SEVERITY, ss.str()); } } while(false)
+    // The lowest severity any sink writes, so that messages no sink wants are never formatted
+    extern std::atomic<int> minimum_log_severity;
+    inline rs_log_severity get_minimum_severity() { return static_cast<rs_log_severity>(minimum_log_severity.load(std::memory_order_relaxed)); }
+    inline bool is_logged(rs_log_severity severity) { return severity >= minimum_log_severity.load(std::memory_order_relaxed); }
+
+#define LOG(SEVERITY, ...) do { if(rsimpl::is_logged(SEVERITY)) { std::ostringstream ss; ss << __VA_ARGS__; rsimpl::log(SEVERITY, ss.str()); } } while(false)
 #define LOG_DEBUG(...)   LOG(RS_LOG_SEVERITY_DEBUG, __VA_ARGS__)
 #define LOG_INFO(...)    LOG(RS_LOG_SEVERITY_INFO,  __VA_ARGS__)
 #define LOG_WARNING(...) LOG(RS_LOG_SEVERITY_WARN,  __VA_ARGS__)
@@ -100,6 +138,12 @@ namespace rsimpl
     RS_ENUM_HELPERS(rs_camera_info, CAMERA_INFO)
     RS_ENUM_HELPERS(rs_timestamp_domain, TIMESTAMP_DOMAIN)
     RS_ENUM_HELPERS(rs_frame_metadata, FRAME_METADATA)
+    RS_ENUM_HELPERS(rs_frame_drop_policy, FRAME_DROP_POLICY)
+    RS_ENUM_HELPERS(rs_straggler_policy, STRAGGLER_POLICY)
+    RS_ENUM_HELPERS(rs_playback_pacing, PLAYBACK_PACING)
+    RS_ENUM_HELPERS(rs_stream_metric, STREAM_METRIC)
+    RS_ENUM_HELPERS(rs_transfer_statistic, TRANSFER_STATISTIC)
+    RS_ENUM_HELPERS(rs_load_shedding_action, LOAD_SHEDDING_ACTION)
     #undef RS_ENUM_HELPERS
 
     ////////////////////////////////////////////
@@ -126,11 +170,16 @@ namespace rsimpl
     // Pixel formats //
     ///////////////////
 
+    // Unpacks height rows of a width built into the function, see find_row_unpacker()
+    typedef void(*row_unpack_function)(byte * const dest[], const size_t dest_stride[], const byte * source, size_t source_stride, int height);
+
     struct pixel_format_unpacker
     {
         bool requires_processing;
         void(*unpack)(byte * const dest[], const byte * source, int count);
         std::vector<std::pair<rs_stream, rs_format>> outputs;
+        std::vector<int> plane_views; // Per output, the native plane it is identical to, or -1. Outputs handed out as views get a null destination and must be skipped by unpack.
+        std::vector<int> interleaved_offsets; // Per output, the byte offset of its sample within every native pixel, if its pixels can be handed out in place as a strided view, or -1
 
         bool provides_stream(rs_stream stream) const { for (auto & o : outputs) if (o.first == stream) return true; return false; }
         rs_format get_format(rs_stream stream) const { for (auto & o : outputs) if (o.first == stream) return o.second; throw std::logic_error("missing output"); }
@@ -174,6 +223,14 @@ namespace rsimpl
         bool is_filled() const;
     };
 
+    struct stream_queue_policy
+    {
+        int depth;
+        rs_frame_drop_policy policy;
+
+        int get_max_queued_frames() const { return policy == RS_FRAME_DROP_POLICY_LATEST_ONLY ? 1 : depth; }
+    };
+
     struct interstream_rule // Requires a.*field + delta == b.*field OR a.*field + delta2 == b.*field
     {
         rs_stream a, b;
@@ -282,6 +339,7 @@ namespace rsimpl
         std::vector<supported_capability> capabilities_vector;
         std::vector<rs_frame_metadata> supported_metadata_vector;
         std::map<rs_camera_info, std::string> camera_info;
+        bool croppable_subdevices[RS_STREAM_NATIVE_COUNT];                  // Subdevices whose frames carry nothing but pixels, so that the driver may crop them
 
         static_device_info();
     };
@@ -290,12 +348,47 @@ namespace rsimpl
     // Runtime device configuration //
     //////////////////////////////////
 
+    struct temporal_depth_history; // Defined in image.h
+    class user_frame_buffers;       // Defined in archive.h
+    struct depth_statistics;
+    class parallel_pool;            // Defined in pipeline.h
+
+    struct depth_filter_settings
+    {
+        float spatial_alpha, temporal_alpha;    // Weight of every pixel against its filtered neighbours, or its filtered past, 1 disables the filter
+        int spatial_delta, temporal_delta;      // Values this many depth units apart lie across an edge, or moved, and are not blended
+        int temporal_persistence;               // Number of frames a pixel without data keeps reporting its last depth
+
+        depth_filter_settings() : spatial_alpha(1), temporal_alpha(1), spatial_delta(20), temporal_delta(20), temporal_persistence(0) {}
+        bool spatial_enabled() const { return spatial_alpha < 1; }
+        bool temporal_enabled() const { return temporal_alpha < 1 || temporal_persistence > 0; }
+    };
+
+    struct stream_crop
+    {
+        int x, y, width, height;                // In pixels of the uncropped output, a width of 0 keeps all of it
+    };
+
     struct subdevice_mode_selection
     {
         subdevice_mode mode;                    // The streaming mode in which to place the hardware
         int pad_crop;                           // The number of pixels of padding (positive values) or cropping (negative values) to apply to all four edges of the image
         size_t unpacker_index;                  // The specific unpacker used to unpack the encoded format into the desired output formats
         rs_output_buffer_format output_format = RS_OUTPUT_BUFFER_FORMAT_CONTINUOUS; // The output buffer format. 
+        bool zero_copy = false;                 // Set when RS_OPTION_ZERO_COPY_ENABLED is and the backend keeps frame memory valid until it is released, so pass-through streams can skip the copy
+        int decimation_factor = 1;              // The depth output is shrunk by this factor in both dimensions after unpacking
+        bool decimation_mean = false;           // Decimated depth pixels are the mean of the non-zero pixels they cover, rather than their median
+        bool demosaic_corrected = false;        // Colors demosaiced from raw images are corrected by the gradients of the known color, rather than bilinear
+        depth_filter_settings depth_filter;     // Applied to the depth output after decimation
+        bool gather_depth_statistics = false;   // Statistics of the depth output are gathered while it is unpacked
+        int depth_pyramid_levels = 0;           // Levels of 2x2 reductions of the depth output appended behind it after filtering
+        bool depth_runs = false;                // The runs of valid pixels of the depth output are found after filtering and appended behind its pyramid
+        bool interleaved_views = false;         // Outputs interleaved in the native pixels are handed out as strided views of the native frame when possible
+        stream_crop software_crop = {};         // Window of the output unpacked, the rest of the native frame is skipped
+        bool cropped_in_driver = false;         // The driver delivers a window of its frames, which mode describes
+        int2 uncropped_dims = {};               // Resolution the driver is set to when it crops
+        row_unpack_function row_unpacker = nullptr; // Specialized for the unpacker and the unpacked width, found by select_modes, or nullptr for the generic loop
+        int unpack_bands = 1;                   // Bands of rows a frame is split into to be unpacked in parallel, see choose_unpack_bands
 
         subdevice_mode_selection() : mode({}), pad_crop(), unpacker_index(), output_format(RS_OUTPUT_BUFFER_FORMAT_CONTINUOUS){}
         subdevice_mode_selection(const subdevice_mode & mode, int pad_crop, int unpacker_index) : mode(mode), pad_crop(pad_crop), unpacker_index(unpacker_index){}
@@ -306,28 +399,53 @@ namespace rsimpl
             throw std::runtime_error("failed to fetch an unpakcer, most likely because enable_stream was not called!");
         }
         const std::vector<std::pair<rs_stream, rs_format>> & get_outputs() const { return get_unpacker().outputs; }
-        int get_width() const { return mode.native_intrinsics.width + pad_crop * 2; }
-        int get_height() const { return mode.native_intrinsics.height + pad_crop * 2; }
+        int get_width() const { return software_crop.width ? software_crop.width : mode.native_intrinsics.width + pad_crop * 2; }
+        int get_height() const { return software_crop.width ? software_crop.height : mode.native_intrinsics.height + pad_crop * 2; }
         int get_framerate() const { return mode.fps; }
+        double get_bandwidth() const { return (double)mode.pf.get_image_size(mode.native_dims.x, mode.native_dims.y) * mode.fps; } // Bytes per second of the native frames on the bus
         int get_stride_x() const { return requires_processing() ? get_width() : mode.native_dims.x; }
         int get_stride_y() const { return requires_processing() ? get_height() : mode.native_dims.y; }
-        size_t get_image_size(rs_stream stream) const;
+        size_t get_image_size(rs_stream stream) const; // Of the buffer the stream is unpacked into, decimated streams are shrunk in place, depth pyramids and runs follow the depth image
+        bool is_decimated(rs_stream stream) const { return decimation_factor > 1 && stream == RS_STREAM_DEPTH && provides_stream(stream); }
+        bool computes_statistics(rs_stream stream) const { return gather_depth_statistics && stream == RS_STREAM_DEPTH && provides_stream(stream); }
+        bool builds_pyramid(rs_stream stream) const { return depth_pyramid_levels > 0 && stream == RS_STREAM_DEPTH && provides_stream(stream); }
+        bool finds_depth_runs(rs_stream stream) const { return depth_runs && stream == RS_STREAM_DEPTH && provides_stream(stream); }
+        bool is_filtered(rs_stream stream) const { return (depth_filter.spatial_enabled() || depth_filter.temporal_enabled()) && stream == RS_STREAM_DEPTH && provides_stream(stream); }
+        int get_output_width(rs_stream stream) const { return is_decimated(stream) ? get_width() / decimation_factor : get_width(); }
+        int get_output_height(rs_stream stream) const { return is_decimated(stream) ? get_height() / decimation_factor : get_height(); }
         bool provides_stream(rs_stream stream) const { return get_unpacker().provides_stream(stream); }
         rs_format get_format(rs_stream stream) const { return get_unpacker().get_format(stream); }
         void set_output_buffer_format(const rs_output_buffer_format in_output_format);
+        rs_intrinsics get_unpacked_intrinsics(const rs_intrinsics & native) const; // Of the unpacked image, before decimation, given those of the native image
 
-        void unpack(byte * const dest[], const byte * source) const;
+        // A window of the output must lie within the valid pixels of the native image. The driver cropping it leaves the selection describing the
+        // window as though it were the native mode.
+        void crop(const stream_crop & window);
+        void move_crop_to_driver();
+
+        // Depth is only filtered in time given the history of its previous frames, and its statistics are only gathered given somewhere to put them.
+        // Given a pool, the rows are unpacked in unpack_bands bands on its threads.
+        void unpack(byte * const dest[], const byte * source, temporal_depth_history * depth_history = nullptr, depth_statistics * statistics = nullptr, parallel_pool * bands_pool = nullptr) const;
+        int choose_unpack_bands(int max_bands) const; // As many as keep every band at RS_MIN_UNPACK_BAND_BYTES of native data, 1 if the frame cannot be split
         int get_unpacked_width() const;
         int get_unpacked_height() const;
 
-        bool requires_processing() const { return (output_format == RS_OUTPUT_BUFFER_FORMAT_CONTINUOUS) || (mode.pf.unpackers[unpacker_index].requires_processing); }
+        bool requires_processing() const;
+        int get_plane_view(size_t output) const; // The native plane which can be handed out in place of unpacking this output, or -1
+        int get_interleaved_view(size_t output) const; // The byte offset of this output within the native pixels if they can be handed out as a strided view of it, or -1
 
     };
 
     typedef void(*frame_callback_function_ptr)(rs_device * dev, rs_frame_ref * frame, void * user);
+    typedef void(*frameset_callback_function_ptr)(rs_device * dev, rs_frameset * frames, void * user);
+    typedef void(*slice_callback_function_ptr)(rs_device * dev, const void * rows, int width, int first_row, int row_count, void * user);
+    typedef void(*encoded_packet_callback_function_ptr)(rs_device * dev, rs_stream stream, rs_encoded_packet packet, void * user);
+    typedef void(*multi_frameset_callback_function_ptr)(rs_device * const * devices, rs_frameset * const * framesets, int count, void * user);
     typedef void(*motion_callback_function_ptr)(rs_device * dev, rs_motion_data data, void * user);
     typedef void(*timestamp_callback_function_ptr)(rs_device * dev, rs_timestamp_data data, void * user);
+    typedef void(*motion_batch_callback_function_ptr)(rs_device * dev, const rs_motion_data * motion, int motion_count, const rs_timestamp_data * timestamps, int timestamp_count, void * user);
     typedef void(*log_callback_function_ptr)(rs_log_severity severity, const char * message, void * user);
+    typedef void(*devices_changed_callback_function_ptr)(rs_context * context, rs_device * device, int connected, void * user);
 
     class frame_callback : public rs_frame_callback
     {
@@ -351,6 +469,74 @@ namespace rsimpl
         void release() override { delete this; }
     };
 
+    class frameset_callback : public rs_frameset_callback
+    {
+        frameset_callback_function_ptr fptr;
+        void * user;
+        rs_device * device;
+    public:
+        frameset_callback(rs_device * dev, frameset_callback_function_ptr on_frameset, void * user) : fptr(on_frameset), user(user), device(dev) {}
+
+        void on_frameset(rs_device * dev, rs_frameset * frames) override {
+            if (fptr)
+            {
+                try { fptr(dev, frames, user); } catch (...)
+                {
+                    LOG_ERROR("Received an execption from frameset callback!");
+                }
+            }
+        }
+        void release() override { delete this; }
+    };
+
+    class multi_frameset_callback : public rs_multi_frameset_callback
+    {
+        multi_frameset_callback_function_ptr fptr;
+        void * user;
+    public:
+        multi_frameset_callback(multi_frameset_callback_function_ptr on_framesets, void * user) : fptr(on_framesets), user(user) {}
+
+        void on_framesets(rs_device * const * devices, rs_frameset * const * framesets, int count) override {
+            try { fptr(devices, framesets, count, user); } catch (...)
+            {
+                LOG_ERROR("Received an execption from multi-device frameset callback!");
+            }
+        }
+        void release() override { delete this; }
+    };
+
+    class devices_changed_callback : public rs_devices_changed_callback
+    {
+        devices_changed_callback_function_ptr fptr;
+        void * user;
+    public:
+        devices_changed_callback(devices_changed_callback_function_ptr on_change, void * user) : fptr(on_change), user(user) {}
+
+        void on_devices_changed(rs_context * context, rs_device * device, int connected) override {
+            try { fptr(context, device, connected, user); } catch (...)
+            {
+                LOG_ERROR("Received an execption from devices changed callback!");
+            }
+        }
+        void release() override { delete this; }
+    };
+
+    typedef void *(*frame_allocate_function_ptr)(int size, void * user);
+    typedef void(*frame_deallocate_function_ptr)(void * ptr, int size, void * user);
+
+    class frame_allocator : public rs_frame_allocator
+    {
+        frame_allocate_function_ptr allocate_fptr;
+        frame_deallocate_function_ptr deallocate_fptr;
+        void * user;
+    public:
+        frame_allocator(frame_allocate_function_ptr on_allocate, frame_deallocate_function_ptr on_deallocate, void * user) : allocate_fptr(on_allocate), deallocate_fptr(on_deallocate), user(user) {}
+
+        void * allocate(size_t size) override { return allocate_fptr(static_cast<int>(size), user); }
+        void deallocate(void * ptr, size_t size) override { deallocate_fptr(ptr, static_cast<int>(size), user); }
+        void release() override { delete this; }
+    };
+
     class motion_events_callback : public rs_motion_callback
     {
         motion_callback_function_ptr fptr;
@@ -398,6 +584,61 @@ namespace rsimpl
         void release() override { }
     };
 
+    class motion_batch_events_callback : public rs_motion_batch_callback
+    {
+        motion_batch_callback_function_ptr fptr;
+        void        * user;
+        rs_device   * device;
+    public:
+        motion_batch_events_callback(rs_device * dev, motion_batch_callback_function_ptr fptr, void * user) : fptr(fptr), user(user), device(dev) {}
+
+        void on_events(const rs_motion_data * motion, int motion_count, const rs_timestamp_data * timestamps, int timestamp_count) override
+        {
+            try { fptr(device, motion, motion_count, timestamps, timestamp_count, user); } catch (...)
+            {
+                LOG_ERROR("Received an execption from motion batch callback!");
+            }
+        }
+
+        void release() override { delete this; }
+    };
+
+    class slice_callback : public rs_slice_callback
+    {
+        slice_callback_function_ptr fptr;
+        void * user;
+    public:
+        slice_callback(slice_callback_function_ptr on_slice, void * user) : fptr(on_slice), user(user) {}
+
+        void on_slice(rs_device * dev, const void * rows, int width, int first_row, int row_count) override
+        {
+            try { fptr(dev, rows, width, first_row, row_count, user); } catch (...)
+            {
+                LOG_ERROR("Received an execption from slice callback!");
+            }
+        }
+
+        void release() override { delete this; }
+    };
+
+    class encoded_packet_callback : public rs_encoded_packet_callback
+    {
+        encoded_packet_callback_function_ptr fptr;
+        void * user;
+    public:
+        encoded_packet_callback(encoded_packet_callback_function_ptr on_packet, void * user) : fptr(on_packet), user(user) {}
+
+        void on_packet(rs_device * dev, rs_stream stream, rs_encoded_packet packet) override
+        {
+            try { fptr(dev, stream, packet, user); } catch (...)
+            {
+                LOG_ERROR("Received an execption from encoded packet callback!");
+            }
+        }
+
+        void release() override { delete this; }
+    };
+
     class log_callback : public rs_log_callback
     {
         log_callback_function_ptr fptr;
@@ -426,6 +667,12 @@ namespace rsimpl
     typedef std::unique_ptr<rs_log_callback, void(*)(rs_log_callback*)> log_callback_ptr;
     typedef std::unique_ptr<rs_motion_callback, void(*)(rs_motion_callback*)> motion_callback_ptr;
     typedef std::unique_ptr<rs_timestamp_callback, void(*)(rs_timestamp_callback*)> timestamp_callback_ptr;
+    typedef std::unique_ptr<rs_motion_batch_callback, void(*)(rs_motion_batch_callback*)> motion_batch_callback_ptr;
+    typedef std::shared_ptr<rs_frameset_callback> frameset_callback_ptr;
+    typedef std::shared_ptr<rs_slice_callback> slice_callback_ptr;
+    typedef std::shared_ptr<rs_encoded_packet_callback> encoded_packet_callback_ptr;
+    typedef std::shared_ptr<rs_options_callback> options_callback_ptr;
+    typedef std::shared_ptr<rs_devices_changed_callback> devices_changed_callback_ptr;
     class frame_callback_ptr
     {
         rs_frame_callback * callback;
@@ -445,31 +692,109 @@ namespace rsimpl
         rs_frame_callback * operator*() { return callback; }
     };
 
+    // A consumer of the frames of a stream alongside its frame callback, handed a reference of its own to every frame, see add_frame_subscriber
+    struct frame_subscriber
+    {
+        int                                 id;
+        std::shared_ptr<rs_frame_callback>  callback;
+        stream_queue_policy                 queue;      // A depth of 0 invokes the callback on the capture threads
+    };
+
+    // Native stream requests filled in full, along with the bandwidth of the modes selected for them
+    struct request_candidate
+    {
+        stream_request                      requests[RS_STREAM_NATIVE_COUNT];
+        double                              bandwidth;  // Bytes per second, see get_bandwidth
+    };
+
+    // The modes selected for sets of native stream requests, so that reconfiguring with requests seen before skips the search through the
+    // combinations of modes. Holds the modes as resolved from the requests, before the settings of the device are applied to them, and
+    // forgets every set once full.
+    class mode_selection_cache
+    {
+        struct entry
+        {
+            stream_request                          requests[RS_STREAM_NATIVE_COUNT];
+            std::vector<subdevice_mode_selection>   modes;
+        };
+        enum { max_entries = 64 };
+
+        mutable std::mutex                          mutex;
+        mutable std::vector<entry>                  entries;
+        mutable int                                 hits = 0;
+    public:
+        bool find(const stream_request(&requests)[RS_STREAM_NATIVE_COUNT], std::vector<subdevice_mode_selection> & modes) const;
+        void insert(const stream_request(&requests)[RS_STREAM_NATIVE_COUNT], const std::vector<subdevice_mode_selection> & modes) const;
+        int get_hit_count() const { std::lock_guard<std::mutex> lock(mutex); return hits; }
+    };
+
     struct device_config
     {
         const static_device_info            info;
+        std::vector<stream_request>         possible_requests[RS_STREAM_NATIVE_COUNT];              // Every request the modes of the device can satisfy, per stream
+        mode_selection_cache                selections;                                             // Modes resolved by select_modes, per set of requests
         stream_request                      requests[RS_STREAM_NATIVE_COUNT];                       // Modified by enable/disable_stream calls
         frame_callback_ptr                  callbacks[RS_STREAM_NATIVE_COUNT];                      // Modified by set_frame_callback calls
+        std::vector<frame_subscriber>       subscribers[RS_STREAM_NATIVE_COUNT];                    // Modified by add/remove_frame_subscriber calls
+        int                                 last_subscriber_id = 0;
         data_polling_request                data_request;                                           // Modified by enable/disable_events calls
         motion_callback_ptr                 motion_callback{ nullptr, [](rs_motion_callback*){} };  // Modified by set_events_callback calls
         timestamp_callback_ptr              timestamp_callback{ nullptr, [](rs_timestamp_callback*){} };
+        motion_batch_callback_ptr           motion_batch_callback{ nullptr, [](rs_motion_batch_callback*){} };  // Modified by set_motion_batch_callback calls, takes over from the per-event callbacks
+        std::shared_ptr<rs_frame_allocator> frame_allocator;                                        // Modified by set_frame_allocator calls, null selects the heap
+        frameset_callback_ptr               frameset_callback;                                      // Modified by set_frameset_callback calls
+        slice_callback_ptr                  slice_callbacks[RS_STREAM_NATIVE_COUNT];                // Modified by set_stream_slice_callback calls
+        int                                 slice_rows[RS_STREAM_NATIVE_COUNT];                     // Rows of the slices of each stream with a slice callback
+        encoded_packet_callback_ptr         encoded_packet_callbacks[RS_STREAM_NATIVE_COUNT];       // Modified by set_stream_encoder calls
+        int                                 encoder_bitrates[RS_STREAM_NATIVE_COUNT];               // Bits per second of each stream with an encoder
+        stream_queue_policy                 queue_policies[RS_STREAM_NATIVE_COUNT];                 // Modified by set_stream_queue_policy calls
+        std::vector<int>                    capture_dmabufs[RS_STREAM_NATIVE_COUNT];                // Modified by set_stream_capture_dmabufs calls
+        int                                 capture_buffer_counts[RS_STREAM_NATIVE_COUNT];          // Modified by set_stream_capture_buffer_count calls, 0 lets the library choose
+        int                                 callback_queue_depths[RS_STREAM_NATIVE_COUNT];          // Modified by set_stream_callback_queue calls, 0 invokes the callbacks on the capture threads
+        int                                 idle_timeouts[RS_STREAM_NATIVE_COUNT];                  // Modified by set_stream_idle_timeout calls, 0 streams for as long as the device does
+        double                              sync_tolerances[RS_STREAM_NATIVE_COUNT];                // Modified by set_stream_sync_tolerance calls, 0 matches the nearest frame
+        std::shared_ptr<user_frame_buffers> frame_buffers[RS_STREAM_NATIVE_COUNT];                  // Modified by set_stream_frame_buffers calls, null unpacks into library memory
+        stream_crop                         crops[RS_STREAM_NATIVE_COUNT];                          // Modified by set_stream_crop calls
         float depth_scale;                                              // Scale of depth values
-
-        explicit device_config(const rsimpl::static_device_info & info) : info(info), depth_scale(info.nominal_depth_scale)
+        int depth_decimation_factor;                                    // Modified by set_option calls, applied to every selected mode providing depth
+        bool depth_decimation_mean;
+        bool color_demosaic_corrected;                                  // Modified by set_option calls, applied to every selected mode demosaicing raw color
+        depth_filter_settings depth_filter;
+        bool gather_depth_statistics;
+        bool interleaved_views;                                         // Modified by set_option calls, applied to every selected mode with interleaved outputs
+        int depth_pyramid_levels;                                       // Modified by set_option calls, applied to every selected mode providing depth
+        bool depth_runs;
+        int unpack_bands;                                               // Modified by set_option calls, the most bands select_modes splits the unpacking of a frame into
+
+        explicit device_config(const rsimpl::static_device_info & info) : info(info), depth_scale(info.nominal_depth_scale), depth_decimation_factor(1), depth_decimation_mean(false), color_demosaic_corrected(false), gather_depth_statistics(false), interleaved_views(false), depth_pyramid_levels(0), depth_runs(false), unpack_bands(1)
         {
             for (auto & req : requests) req = rsimpl::stream_request();
+            for (auto & q : queue_policies) q = { RS_DEFAULT_STREAM_QUEUE_DEPTH, RS_FRAME_DROP_POLICY_DROP_OLDEST };
+            for (auto & count : capture_buffer_counts) count = 0;
+            for (auto & depth : callback_queue_depths) depth = 0;
+            for (auto & timeout : idle_timeouts) timeout = 0;
+            for (auto & tolerance : sync_tolerances) tolerance = 0;
+            for (auto & rows : slice_rows) rows = 0;
+            for (auto & bitrate : encoder_bitrates) bitrate = 0;
+            for (auto & crop : crops) crop = {};
+            get_all_possible_requestes(possible_requests);
         }
 
+        bool has_frame_callbacks(rs_stream stream) { return callbacks[stream] || !subscribers[stream].empty(); } // Its frames then never go to the sync archive
         subdevice_mode_selection select_mode(const stream_request(&requests)[RS_STREAM_NATIVE_COUNT], int subdevice_index) const;
         bool all_requests_filled(const stream_request(&original_requests)[RS_STREAM_NATIVE_COUNT]) const;
-        bool find_good_requests_combination(stream_request(&output_requests)[RS_STREAM_NATIVE_COUNT], std::vector<stream_request> stream_requests[RS_STREAM_NATIVE_COUNT]) const;
+        bool find_good_requests_combination(stream_request(&output_requests)[RS_STREAM_NATIVE_COUNT], const std::vector<stream_request> stream_requests[RS_STREAM_NATIVE_COUNT]) const;
         bool fill_requests(stream_request(&requests)[RS_STREAM_NATIVE_COUNT]) const;
         void get_all_possible_requestes(std::vector<stream_request> (&stream_requests)[RS_STREAM_NATIVE_COUNT]) const;
+        std::vector<subdevice_mode_selection> resolve_modes(const stream_request(&requests)[RS_STREAM_NATIVE_COUNT]) const; // Without the settings of the device, bypassing the cache
         std::vector<subdevice_mode_selection> select_modes(const stream_request(&requests)[RS_STREAM_NATIVE_COUNT]) const;
-        std::vector<subdevice_mode_selection> select_modes() const { return select_modes(requests); }
+        std::vector<subdevice_mode_selection> select_modes() const; // Of the requests, with the stream crops applied
         bool validate_requests(stream_request(&requests)[RS_STREAM_NATIVE_COUNT], bool throw_exception = false) const;
+        std::vector<request_candidate> get_bandwidth_candidates() const; // The requests as select_modes fills them, then the fillings of lower bandwidth from the highest
     };
 
+    inline double get_bandwidth(const std::vector<subdevice_mode_selection> & selected_modes) { double b = 0; for (auto & m : selected_modes) b += m.get_bandwidth(); return b; }
+
     ////////////////////////////////////////
     // Helper functions for library types //
     ////////////////////////////////////////
@@ -479,6 +804,18 @@ namespace rsimpl
         return{ i.width + pad_crop * 2, i.height + pad_crop * 2, i.ppx + pad_crop, i.ppy + pad_crop, i.fx, i.fy, i.model, {i.coeffs[0], i.coeffs[1], i.coeffs[2], i.coeffs[3], i.coeffs[4]} };
     }
 
+    inline rs_intrinsics crop_intrinsics(const rs_intrinsics & i, int x, int y, int width, int height)
+    {
+        return{ width, height, i.ppx - x, i.ppy - y, i.fx, i.fy, i.model, {i.coeffs[0], i.coeffs[1], i.coeffs[2], i.coeffs[3], i.coeffs[4]} };
+    }
+
+    inline rs_intrinsics decimate_intrinsics(const rs_intrinsics & i, int factor)
+    {
+        // Every decimated pixel covers a factor x factor block, centered (factor - 1) / 2 pixels past its first source pixel
+        const float f = (float)factor, offset = (factor - 1) * 0.5f;
+        return{ i.width / factor, i.height / factor, (i.ppx - offset) / f, (i.ppy - offset) / f, i.fx / f, i.fy / f, i.model, {i.coeffs[0], i.coeffs[1], i.coeffs[2], i.coeffs[3], i.coeffs[4]} };
+    }
+
     inline rs_intrinsics scale_intrinsics(const rs_intrinsics & i, int width, int height)
     {
         const float sx = (float)width / i.width, sy = (float)height / i.height;
@@ -486,75 +823,135 @@ namespace rsimpl
     }
 
     inline bool operator == (const rs_intrinsics & a, const rs_intrinsics & b) { return std::memcmp(&a, &b, sizeof(a)) == 0; }
+    inline bool operator == (const rs_extrinsics & a, const rs_extrinsics & b) { return std::memcmp(&a, &b, sizeof(a)) == 0; }
 
     inline uint32_t pack(uint8_t c0, uint8_t c1, uint8_t c2, uint8_t c3)
     {
         return (c0 << 24) | (c1 << 16) | (c2 << 8) | c3;
     }
 
-    template<class T, int C>
+    // Pool of objects handed out from any thread without a lock. It starts with one chunk of objects and grows by whole chunks, up to its
+    // capacity, once every object is taken. Chunks never move, so the objects handed out stay where they are for as long as the pool lives.
+    template<class T>
     class small_heap
     {
-        T buffer[C];
-        bool is_free[C];
+        // Free slots form a Treiber stack threaded through next[]. The head packs a use tag above the slot index,
+        // so a slot that is popped and pushed back between a load and a CAS cannot be mistaken for the old head.
+        // Slot i lives at index i % chunk_size of chunk i / chunk_size, and every chunk is complete before its slots are pushed.
+        static const uint32_t empty_index = 0xffffffff;
+
+        struct chunk
+        {
+            std::unique_ptr<T[]> buffer;
+            std::unique_ptr<std::atomic<uint32_t>[]> next;
+            uint32_t size;
+        };
+
+        const uint32_t chunk_size, capacity;
+        std::unique_ptr<chunk[]> chunks;
+        std::atomic<uint32_t> chunk_count;
+        std::mutex grow_mutex;
+        std::atomic<uint64_t> head;
+        std::atomic<bool> keep_allocating;
+        std::atomic<int> size;
         std::mutex mutex;
-        bool keep_allocating = true;
         std::condition_variable cv;
-        int size = 0;
 
-    public:
-        small_heap()
+        static uint64_t pack(uint64_t tag, uint32_t index) { return (tag << 32) | index; }
+        static uint32_t index_of(uint64_t h) { return static_cast<uint32_t>(h & 0xffffffff); }
+        static uint64_t tag_of(uint64_t h) { return h >> 32; }
+
+        std::atomic<uint32_t> & next_of(uint32_t i) { return chunks[i / chunk_size].next[i % chunk_size]; }
+
+        void release_one()
         {
-            for (auto i = 0; i < C; i++)
+            if (size.fetch_sub(1) == 1)
             {
-                is_free[i] = true;
-                buffer[i] = std::move(T());
+                // Taking the lock means a waiter is either already blocked or has yet to check the size
+                { std::lock_guard<std::mutex> lock(mutex); }
+                cv.notify_all();
             }
         }
 
+        // Pushes the slots of a new chunk onto the free stack, unless a slot came free meanwhile. False once the pool is at its capacity.
+        bool grow()
+        {
+            std::lock_guard<std::mutex> lock(grow_mutex);
+            if (index_of(head.load()) != empty_index) return true;
+            const uint32_t c = chunk_count;
+            if (c * chunk_size >= capacity) return false;
+
+            auto & new_chunk = chunks[c];
+            new_chunk.size = std::min(chunk_size, capacity - c * chunk_size);
+            new_chunk.buffer.reset(new T[new_chunk.size]);
+            new_chunk.next.reset(new std::atomic<uint32_t>[new_chunk.size]);
+            const uint32_t first = c * chunk_size, last = first + new_chunk.size - 1;
+            for (uint32_t i = first; i < last; ++i) new_chunk.next[i - first].store(i + 1, std::memory_order_relaxed);
+            chunk_count = c + 1;
+
+            auto h = head.load();
+            do { new_chunk.next[last - first].store(index_of(h), std::memory_order_relaxed); }
+            while (!head.compare_exchange_weak(h, pack(tag_of(h) + 1, first)));
+            return true;
+        }
+
+    public:
+        small_heap(int chunk_size, int capacity) : chunk_size(static_cast<uint32_t>(chunk_size)), capacity(static_cast<uint32_t>(capacity)),
+            chunks(new chunk[(capacity + chunk_size - 1) / chunk_size]), chunk_count(0), head(pack(0, empty_index)), keep_allocating(true), size(0)
+        {
+            grow();
+        }
+
+        int get_capacity() const { return static_cast<int>(capacity); }
+        int get_allocated_capacity() const { return static_cast<int>(std::min(chunk_count.load() * chunk_size, capacity)); } // Of the chunks allocated so far
+
         T * allocate()
         {
-            std::unique_lock<std::mutex> lock(mutex);
-            if (!keep_allocating) return nullptr;
+            // Count the allocation before checking the flag, so wait_until_empty never misses one that raced with stop_allocation
+            size.fetch_add(1);
+            if (!keep_allocating)
+            {
+                release_one();
+                return nullptr;
+            }
 
-            for (auto i = 0; i < C; i++)
+            do
             {
-                if (is_free[i])
+                auto h = head.load();
+                while (index_of(h) != empty_index)
                 {
-                    is_free[i] = false;
-                    size++;
-                    return &buffer[i];
+                    auto i = index_of(h);
+                    if (head.compare_exchange_weak(h, pack(tag_of(h) + 1, next_of(i).load(std::memory_order_relaxed))))
+                        return &chunks[i / chunk_size].buffer[i % chunk_size];
                 }
-            }
+            } while (grow());
+            release_one();
             return nullptr;
         }
 
         void deallocate(T * item)
         {
-             if (item < buffer || item >= buffer + C)
+            uint32_t i = empty_index;
+            for (uint32_t c = 0, count = chunk_count; c < count; ++c)
             {
-                throw std::runtime_error("Trying to return item to a heap that didn't allocate it!");
+                auto & k = chunks[c];
+                if (item >= k.buffer.get() && item < k.buffer.get() + k.size) i = c * chunk_size + static_cast<uint32_t>(item - k.buffer.get());
             }
-            auto i = item - buffer;
-            buffer[i] = std::move(T());
-            
+            if (i == empty_index)
             {
-                std::unique_lock<std::mutex> lock(mutex);
+                throw std::runtime_error("Trying to return item to a heap that didn't allocate it!");
+            }
+            *item = std::move(T());
 
-                is_free[i] = true;
-                size--;
+            auto h = head.load();
+            do { next_of(i).store(index_of(h), std::memory_order_relaxed); }
+            while (!head.compare_exchange_weak(h, pack(tag_of(h) + 1, i)));
 
-                if (size == 0)
-                {
-                    lock.unlock();
-                    cv.notify_one();
-                }
-            }
+            release_one();
         }
 
         void stop_allocation()
         {
-            std::unique_lock<std::mutex> lock(mutex);
             keep_allocating = false;
         }
 
@@ -573,55 +970,251 @@ namespace rsimpl
         }
     };
 
+    // Bounded multi-producer / multi-consumer queue that never takes a lock
+    // Every cell carries a sequence number that tells producers and consumers whose turn it is, C must be a power of two
+    template<class T, int C>
+    class lock_free_queue
+    {
+        static_assert(C >= 2 && (C & (C - 1)) == 0, "lock_free_queue capacity must be a power of two");
+
+        struct cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        cell buffer[C];
+        std::atomic<size_t> enqueue_pos;
+        std::atomic<size_t> dequeue_pos;
+
+        lock_free_queue(const lock_free_queue &) = delete;
+        lock_free_queue & operator=(const lock_free_queue &) = delete;
+    public:
+        lock_free_queue() : enqueue_pos(0), dequeue_pos(0)
+        {
+            for (size_t i = 0; i < C; i++) buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        // Returns false without touching item if the queue is full
+        bool try_enqueue(T && item)
+        {
+            auto pos = enqueue_pos.load(std::memory_order_relaxed);
+            while (true)
+            {
+                auto & c = buffer[pos & (C - 1)];
+                auto seq = c.sequence.load(std::memory_order_acquire);
+                auto diff = (intptr_t)seq - (intptr_t)pos;
+                if (diff == 0)
+                {
+                    if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        c.value = std::move(item);
+                        c.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) return false;
+                else pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Returns false if the queue is empty
+        bool try_dequeue(T & item)
+        {
+            auto pos = dequeue_pos.load(std::memory_order_relaxed);
+            while (true)
+            {
+                auto & c = buffer[pos & (C - 1)];
+                auto seq = c.sequence.load(std::memory_order_acquire);
+                auto diff = (intptr_t)seq - (intptr_t)(pos + 1);
+                if (diff == 0)
+                {
+                    if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        item = std::move(c.value);
+                        c.sequence.store(pos + C, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) return false;
+                else pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        // Only a hint when other threads are active
+        bool empty() const
+        {
+            auto pos = dequeue_pos.load(std::memory_order_acquire);
+            return (intptr_t)buffer[pos & (C - 1)].sequence.load(std::memory_order_acquire) - (intptr_t)(pos + 1) < 0;
+        }
+
+        // Only a hint when other threads are active, exact for a sole producer since consumers can only make it shrink
+        size_t size() const
+        {
+            auto head = dequeue_pos.load(std::memory_order_acquire);
+            auto tail = enqueue_pos.load(std::memory_order_acquire);
+            return tail > head ? tail - head : 0;
+        }
+    };
+
+    // Bounded queue of a single thread whose items stay in place, so that pushing and popping never allocates nor moves the other items
+    // C must be a power of two, pushing to a full queue is a logic error
+    template<class T, int C>
+    class ring_queue
+    {
+        static_assert(C >= 2 && (C & (C - 1)) == 0, "ring_queue capacity must be a power of two");
+
+        T buffer[C];
+        size_t head = 0, count = 0;
+
+        ring_queue(const ring_queue &) = delete;
+        ring_queue & operator=(const ring_queue &) = delete;
+    public:
+        ring_queue() {}
+
+        bool empty() const { return count == 0; }
+        bool full() const { return count == C; }
+        size_t size() const { return count; }
+
+        T & operator[](size_t i) { return buffer[(head + i) & (C - 1)]; }
+        const T & operator[](size_t i) const { return buffer[(head + i) & (C - 1)]; }
+        T & front() { return (*this)[0]; }
+        const T & front() const { return (*this)[0]; }
+        T & back() { return (*this)[count - 1]; }
+        const T & back() const { return (*this)[count - 1]; }
+
+        void push_back(T && item)
+        {
+            assert(count < C);
+            buffer[(head + count++) & (C - 1)] = std::move(item);
+        }
+
+        void pop_front() // Leaves a default item in place of the front one, so that nothing it held outlives it
+        {
+            assert(count > 0);
+            buffer[head] = T();
+            head = (head + 1) & (C - 1);
+            --count;
+        }
+    };
+
+    // A move-only callable of no arguments whose target is stored inline, so that making, moving and running one never allocates. The
+    // continuations of driver buffers capture a shared handle and an index or pointer, more than the small buffer of std::function holds,
+    // and are made for every frame. Targets larger than the storage are refused at compile time rather than moved to the heap.
+    class inline_function
+    {
+        union storage_type { void * pointers[6]; double d; long long ll; };
+        struct operations
+        {
+            void (*invoke)(void * target);
+            void (*relocate)(void * dest, void * src); // Move constructs dest from src, then destroys src
+            void (*destroy)(void * target);
+        };
+        template<class F> struct operations_of
+        {
+            static void invoke(void * target) { (*static_cast<F *>(target))(); }
+            static void relocate(void * dest, void * src) { new (dest) F(std::move(*static_cast<F *>(src))); static_cast<F *>(src)->~F(); }
+            static void destroy(void * target) { static_cast<F *>(target)->~F(); }
+            static const operations table;
+        };
+
+        storage_type storage;
+        const operations * ops;
+
+        void take(inline_function & other)
+        {
+            ops = other.ops;
+            if (ops) ops->relocate(&storage, &other.storage);
+            other.ops = nullptr;
+        }
+
+        inline_function(const inline_function &) = delete;
+        inline_function & operator=(const inline_function &) = delete;
+    public:
+        static const size_t capacity = sizeof(storage_type);
+
+        inline_function() : ops(nullptr) {}
+        template<class F, class = typename std::enable_if<!std::is_same<typename std::decay<F>::type, inline_function>::value>::type>
+        inline_function(F && f) : ops(&operations_of<typename std::decay<F>::type>::table)
+        {
+            typedef typename std::decay<F>::type target_type;
+            static_assert(sizeof(target_type) <= capacity, "the target does not fit an inline_function, capture less");
+            static_assert(std::alignment_of<target_type>::value <= std::alignment_of<storage_type>::value, "the target is overaligned for an inline_function");
+            new (&storage) target_type(std::forward<F>(f));
+        }
+        inline_function(inline_function && other) { take(other); }
+        inline_function & operator=(inline_function && other)
+        {
+            if (this != &other)
+            {
+                reset();
+                take(other);
+            }
+            return *this;
+        }
+        ~inline_function() { reset(); }
+
+        explicit operator bool() const { return ops != nullptr; }
+        void operator()() { if (ops) ops->invoke(&storage); }
+
+        // Destroys the target without running it
+        void reset()
+        {
+            if (ops) ops->destroy(&storage);
+            ops = nullptr;
+        }
+    };
+    template<class F> const inline_function::operations inline_function::operations_of<F>::table = { &invoke, &relocate, &destroy };
+
+    // Runs the release of a frame exactly once: when invoked, when another continuation is moved over it, or when destroyed
     class frame_continuation
     {
-        std::function<void()> continuation;
+        inline_function continuation;
         const void* protected_data = nullptr;
 
         frame_continuation(const frame_continuation &) = delete;
         frame_continuation & operator=(const frame_continuation &) = delete;
     public:
-        frame_continuation() : continuation([]() {}) {}
+        frame_continuation() {}
 
-        explicit frame_continuation(std::function<void()> continuation, const void* protected_data) : continuation(continuation), protected_data(protected_data) {}
-        
+        explicit frame_continuation(inline_function continuation, const void* protected_data) : continuation(std::move(continuation)), protected_data(protected_data) {}
 
         frame_continuation(frame_continuation && other) : continuation(std::move(other.continuation)), protected_data(other.protected_data)
         {
-            other.continuation = []() {};
             other.protected_data = nullptr;
         }
 
         void operator()()
         {
-            continuation();
-            continuation = []() {};
+            auto release = std::move(continuation);
             protected_data = nullptr;
+            release();
         }
 
         void reset()
         {
             protected_data = nullptr;
-            continuation = [](){};
+            continuation.reset();
         }
 
         const void* get_data() const { return protected_data; }
 
         frame_continuation & operator=(frame_continuation && other)
         {
-            continuation();
-            protected_data = other.protected_data;
-            continuation = other.continuation;
-            other.continuation = []() {};
-            other.protected_data = nullptr;
+            if (this != &other)
+            {
+                (*this)();
+                protected_data = other.protected_data;
+                continuation = std::move(other.continuation);
+                other.protected_data = nullptr;
+            }
             return *this;
         }
 
         ~frame_continuation()
         {
-            continuation();
+            (*this)();
         }
-
     };
 
     // this class is a convenience wrapper for intrinsics / extrinsics validation methods
@@ -8,7 +8,13 @@
 #include "uvc.h"
 #include "libuvc/libuvc.h"
 #include "libuvc/libuvc_internal.h" // For LibUSB punchthrough
+#include "libusb-interrupts.h"
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
 
 namespace rsimpl
 {
@@ -20,10 +26,87 @@ namespace rsimpl
         }
         #define CALL_UVC(name, ...) check(#name, name(__VA_ARGS__))
 
+        // Requests libusb or the device refuse for good are reported as such, so they are not retried. A stall is not among them,
+        // as the cameras also stall control requests while they are busy.
+        static void throw_control_error(const char * call, int status)
+        {
+            std::string message = to_string() << call << "(...) returned " << libusb_error_name(status);
+            switch(status)
+            {
+            case LIBUSB_ERROR_INVALID_PARAM: case LIBUSB_ERROR_ACCESS: case LIBUSB_ERROR_NO_DEVICE: case LIBUSB_ERROR_NOT_FOUND: case LIBUSB_ERROR_NOT_SUPPORTED:
+                throw control_rejected_error(message);
+            default:
+                throw std::runtime_error(message);
+            }
+        }
+
+        // Failing to raise the scheduling of a thread only costs latency, so it is reported and streaming goes on
+        static void set_thread_scheduling(pthread_t thread, uint64_t cpu_mask, int priority)
+        {
+#ifdef __linux__
+            if(cpu_mask)
+            {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                for(int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) if(cpu_mask >> cpu & 1) CPU_SET(cpu, &cpus);
+                if(int status = pthread_setaffinity_np(thread, sizeof(cpus), &cpus)) LOG_WARNING("pthread_setaffinity_np(...) returned " << strerror(status));
+            }
+#else
+            if(cpu_mask) LOG_WARNING("CPU affinity of the capture threads is only supported on Linux");
+#endif
+            if(priority)
+            {
+                sched_param param = {};
+                param.sched_priority = priority;
+                if(int status = pthread_setschedparam(thread, SCHED_FIFO, &param)) LOG_WARNING("pthread_setschedparam(SCHED_FIFO, " << priority << ") returned " << strerror(status));
+            }
+        }
+
+        // Reports cameras attached and detached through the hotplug callbacks of libusb, which are dispatched by a thread of its own
+        class hotplug_monitor
+        {
+            libusb_context * usb_context;
+            devices_changed_callback callback;
+            libusb_hotplug_callback_handle handle;
+            std::atomic<bool> stopping;
+            std::thread thread;
+
+            static int LIBUSB_CALL on_hotplug(libusb_context *, libusb_device *, libusb_hotplug_event, void * user)
+            {
+                static_cast<hotplug_monitor *>(user)->callback();
+                return 0; // Stay registered
+            }
+        public:
+            hotplug_monitor(libusb_context * usb_context, devices_changed_callback callback) : usb_context(usb_context), callback(callback), stopping(false)
+            {
+                if(!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) throw std::runtime_error("libusb cannot report devices being attached or detached on this platform");
+                int status = libusb_hotplug_register_callback(usb_context, static_cast<libusb_hotplug_event>(LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT),
+                    static_cast<libusb_hotplug_flag>(0), VID_INTEL_CAMERA, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, &hotplug_monitor::on_hotplug, this, &handle);
+                if(status < 0) throw std::runtime_error(to_string() << "libusb_hotplug_register_callback(...) returned " << libusb_error_name(status));
+
+                thread = std::thread([this]()
+                {
+                    while(!stopping)
+                    {
+                        timeval timeout = { 0, 100000 };
+                        libusb_handle_events_timeout_completed(this->usb_context, &timeout, nullptr);
+                    }
+                });
+            }
+            ~hotplug_monitor()
+            {
+                stopping = true;
+                thread.join();
+                libusb_hotplug_deregister_callback(usb_context, handle);
+            }
+        };
+
         struct context
         {
             uvc_context_t * ctx;
             libusb_context * usb_context;
+            std::unique_ptr<hotplug_monitor> monitor;
+            std::mutex open_mutex; // libuvc keeps the handles open in a list of its context, which it updates without locking
 
             context() : ctx()
             {
@@ -34,11 +117,54 @@ namespace rsimpl
             }
             ~context()
             {
+                monitor.reset();
                 libusb_exit(usb_context);
                 if (ctx) uvc_exit(ctx);
             }
         };
 
+        const unsigned char motion_data_endpoint = 0x84;
+        const int motion_data_transfer_size = 0x400;
+        const int default_frame_buffer_count = 4;
+
+        // Buffers libuvc assembles the frames of one stream in. Each frame reaches the video_channel_callback in the buffer it was assembled
+        // in, which its continuation puts back in the ring. Continuations hold on to the ring, so frames can outlive the stream.
+        class frame_buffer_ring
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<uint8_t[]>> buffers;
+            std::vector<uint8_t *> free_buffers;
+            const size_t max_buffers;
+            size_t buffer_size = 0;
+        public:
+            frame_buffer_ring(int max_buffers) : max_buffers(max_buffers) {}
+
+            // Buffers are allocated on demand, so a stream only ever holds as many as the application keeps frames around
+            static uint8_t * acquire(size_t size, void * user)
+            {
+                auto ring = static_cast<frame_buffer_ring *>(user);
+                std::lock_guard<std::mutex> lock(ring->mutex);
+                if(!ring->free_buffers.empty())
+                {
+                    auto buffer = ring->free_buffers.back();
+                    ring->free_buffers.pop_back();
+                    return buffer;
+                }
+                if(ring->buffers.size() == ring->max_buffers || (ring->buffer_size && ring->buffer_size != size)) return nullptr;
+                ring->buffers.emplace_back(new (std::nothrow) uint8_t[size]);
+                if(!ring->buffers.back()) { ring->buffers.pop_back(); return nullptr; }
+                ring->buffer_size = size;
+                return ring->buffers.back().get();
+            }
+
+            static void release(uint8_t * buffer, void * user)
+            {
+                auto ring = static_cast<frame_buffer_ring *>(user);
+                std::lock_guard<std::mutex> lock(ring->mutex);
+                ring->free_buffers.push_back(buffer);
+            }
+        };
+
         struct subdevice
         {
             uvc_device_handle_t * handle = nullptr;
@@ -46,36 +172,19 @@ namespace rsimpl
             uint8_t unit;
             video_channel_callback callback = nullptr;
             data_channel_callback  channel_data_callback = nullptr;
+            int frame_buffer_count = 0; // Frames assembled or held by the application at once, 0 for the default
+            std::shared_ptr<frame_buffer_ring> frame_buffers;
+            size_t frame_size = 0;      // Bytes of a frame of the mode, those which arrive with fewer are counted as short
+            uvc_stream_handle_t * stream = nullptr; // Open while streaming, for the frame callback to read its transfer errors
+            video_slice_callback slice_callback;   // Handed the rows of frames from the assembly buffer, on the event thread
+            int slice_rows = 0;
+            size_t slice_row_bytes = 0;
+            std::shared_ptr<transfer_monitor> monitor = std::make_shared<transfer_monitor>();
 
             void set_data_channel_cfg(data_channel_callback callback)
             {
                 this->channel_data_callback = callback;
             }
-
-            static void poll_interrupts(libusb_device_handle *handle, const std::vector<subdevice *> & subdevices, uint16_t timeout)
-            {
-                static const unsigned short interrupt_buf_size = 0x400;
-                uint8_t buffer[interrupt_buf_size];           /* 64 byte transfer buffer - dedicated channel */
-                int num_bytes = 0;                            /* Actual bytes transferred */
-
-                // TODO - replace hard-coded values : 0x82 and 1000
-                int res = libusb_interrupt_transfer(handle, 0x84, buffer, interrupt_buf_size, &num_bytes, timeout);
-                if (0 == res)
-                {
-                    // Propagate the data to device layer
-                    for (auto & sub : subdevices)
-                        if (sub->channel_data_callback)
-                            sub->channel_data_callback(buffer, num_bytes);
-                }
-                else
-                {
-                    if (res == LIBUSB_ERROR_TIMEOUT) 
-                        LOG_WARNING("interrupt e.p. timeout");
-                    else 
-                        throw std::runtime_error(to_string() << "USB Interrupt end-point error " << libusb_strerror((libusb_error)res));
-                }
-            }
-
         };
 
         struct device
@@ -88,13 +197,16 @@ namespace rsimpl
 
             std::thread data_channel_thread;
             volatile bool data_stop;
-
+            uint64_t capture_cpu_mask;
+            int capture_priority;
+            int control_retry_budget;
+            int num_transfer_bufs;      // Of the streams started last, for resuming them
 
             std::shared_ptr<device> aux_device;
 
             libusb_device_handle * usb_handle;
 
-            device(std::shared_ptr<context> parent, uvc_device_t * uvcdevice) : parent(parent), uvcdevice(uvcdevice), usb_handle()
+            device(std::shared_ptr<context> parent, uvc_device_t * uvcdevice) : parent(parent), uvcdevice(uvcdevice), capture_cpu_mask(), capture_priority(), control_retry_budget(RS_DEFAULT_CONTROL_RETRY_BUDGET), num_transfer_bufs(), usb_handle()
             {
                 get_subdevice(0);
                 
@@ -112,7 +224,10 @@ namespace rsimpl
                     if(status < 0) LOG_ERROR("libusb_release_interface(...) returned " << libusb_error_name(status));
                 }
 
-                for(auto & sub : subdevices) if(sub.handle) uvc_close(sub.handle);
+                {
+                    std::lock_guard<std::mutex> lock(parent->open_mutex);
+                    for(auto & sub : subdevices) if(sub.handle) uvc_close(sub.handle);
+                }
                 if(claimed_interfaces.size()) if(uvcdevice) uvc_unref_device(uvcdevice);
             }
 
@@ -127,11 +242,15 @@ namespace rsimpl
                     return sub;
                 }
 
-                if (!subdevices[subdevice_index].handle) check("uvc_open2", uvc_open2(uvcdevice, &subdevices[subdevice_index].handle, subdevice_index));
+                if (!subdevices[subdevice_index].handle)
+                {
+                    std::lock_guard<std::mutex> lock(parent->open_mutex);
+                    check("uvc_open2", uvc_open2(uvcdevice, &subdevices[subdevice_index].handle, subdevice_index));
+                }
                 return subdevices[subdevice_index];
             }
 
-            void start_data_acquisition()
+            void start_data_acquisition(int transfer_count)
             {
                 data_stop = false;
                 std::vector<subdevice *> data_channel_subs;
@@ -143,17 +262,17 @@ namespace rsimpl
                     }
                 }
 
-                // Motion events polling pipe
+                // Motion events arrive on a ring of interrupt transfers, serviced by a thread of their own
                 if (claimed_interfaces.size())
                 {
-                    data_channel_thread = std::thread([this, data_channel_subs]()
+                    auto ring = std::make_shared<interrupt_transfer_ring>(usb_handle, motion_data_endpoint, motion_data_transfer_size, transfer_count, [data_channel_subs](const unsigned char * data, int size)
                     {
-                        // Polling 100ms timeout
-                        while (!data_stop)
-                        {
-                            subdevice::poll_interrupts(this->usb_handle, data_channel_subs, 100);
-                        }
+                        // Propagate the data to device layer
+                        for (auto & sub : data_channel_subs)
+                            if (sub->channel_data_callback)
+                                sub->channel_data_callback(data, size);
                     });
+                    data_channel_thread = std::thread([this, ring]() { ring->run(parent->usb_context, data_stop); });
                 }
             }
 
@@ -185,13 +304,13 @@ namespace rsimpl
         void get_control(const device & dev, const extension_unit & xu, uint8_t ctrl, void * data, int len)
         {
             int status = uvc_get_ctrl(const_cast<device &>(dev).get_subdevice(xu.subdevice).handle, xu.unit, ctrl, data, len, UVC_GET_CUR);
-            if(status < 0) throw std::runtime_error(to_string() << "uvc_get_ctrl(...) returned " << libusb_error_name(status));
+            if(status < 0) throw_control_error("uvc_get_ctrl", status);
         }
 
         void set_control(device & device, const extension_unit & xu, uint8_t ctrl, void * data, int len)
         {
             int status = uvc_set_ctrl(device.get_subdevice(xu.subdevice).handle, xu.unit, ctrl, data, len);
-            if(status < 0) throw std::runtime_error(to_string() << "uvc_set_ctrl(...) returned " << libusb_error_name(status));
+            if(status < 0) throw_control_error("uvc_set_ctrl", status);
         }
 
         void claim_interface(device & device, const guid & interface_guid, int interface_number)
@@ -236,20 +355,98 @@ namespace rsimpl
 
         }
 
-        void set_subdevice_mode(device & device, int subdevice_index, int width, int height, uint32_t fourcc, int fps, video_channel_callback callback)
+        void set_subdevice_mode(device & device, int subdevice_index, int width, int height, uint32_t fourcc, int fps, size_t frame_size, video_channel_callback callback)
         {
             auto & sub = device.get_subdevice(subdevice_index);
             check("get_stream_ctrl_format_size", uvc_get_stream_ctrl_format_size(sub.handle, &sub.ctrl, reinterpret_cast<const big_endian<uint32_t> &>(fourcc), width, height, fps));
+            sub.frame_size = frame_size;
             sub.callback = callback;
         }
 
+        bool set_subdevice_crop(device & device, int subdevice_index, int x, int y, int width, int height)
+        {
+            return width == 0; // libuvc negotiates whole frames of a mode
+        }
+
+        bool set_subdevice_slice_callback(device & device, int subdevice_index, int rows_per_slice, size_t row_bytes, video_slice_callback callback)
+        {
+            auto & sub = device.get_subdevice(subdevice_index);
+            sub.slice_callback = callback;
+            sub.slice_rows = rows_per_slice;
+            sub.slice_row_bytes = row_bytes;
+            return true;
+        }
+
+        transfer_statistics get_subdevice_transfer_statistics(const device & device, int subdevice_index)
+        {
+            if(subdevice_index < 0 || subdevice_index >= static_cast<int>(device.subdevices.size())) throw std::runtime_error(to_string() << "no subdevice " << subdevice_index);
+            return device.subdevices[subdevice_index].monitor->get();
+        }
+
         void set_subdevice_data_channel_handler(device & device, int subdevice_index, data_channel_callback callback)
         {
             device.subdevices[subdevice_index].set_data_channel_cfg(callback);
         }
 
+        bool supports_zero_copy(const device & /*device*/)
+        {
+            return true; // Frames stay in their frame_buffer_ring until the continuation runs
+        }
+
+        void set_subdevice_buffer_count(device & device, int subdevice_index, int buffer_count)
+        {
+            // One buffer is always being assembled, so a stream needs a second one for the frame it delivers
+            if(buffer_count == 1 || buffer_count < 0 || buffer_count > RS_MAX_CAPTURE_BUFFERS) throw std::runtime_error(to_string() << "libuvc assembles frames in 2 to " << RS_MAX_CAPTURE_BUFFERS << " buffers");
+            device.get_subdevice(subdevice_index).frame_buffer_count = buffer_count;
+        }
+
+        void get_subdevice_buffer_count_range(const device & /*device*/, int & min, int & max)
+        {
+            min = 2;
+            max = RS_MAX_CAPTURE_BUFFERS;
+        }
+
+        void set_subdevice_capture_memory(device & /*device*/, int /*subdevice_index*/, capture_memory memory, std::shared_ptr<rs_frame_allocator> /*allocator*/, const std::vector<int> & /*dmabuf_fds*/)
+        {
+            if(memory != capture_memory::mapped) throw std::runtime_error("libuvc captures only into its own transfer buffers, user pointer and dma-buf capture require the V4L2 backend");
+        }
+
+        void set_capture_thread_scheduling(device & device, uint64_t cpu_mask, int priority)
+        {
+            device.capture_cpu_mask = cpu_mask;
+            device.capture_priority = priority;
+        }
+
+        void set_control_retry_budget(device & device, int milliseconds) { device.control_retry_budget = milliseconds; }
+        int get_control_retry_budget(const device & device) { return device.control_retry_budget; }
+
+        // Starts the transfers of an open stream, along with the thread libuvc delivers its frames from
+        static uvc_error_t start_stream(device & device, subdevice & sub, uvc_stream_handle_t * strmh)
+        {
+            sub.stream = strmh;
+            auto status = uvc_stream_start(strmh, [](uvc_frame * frame, void * user)
+            {
+                auto sub = reinterpret_cast<subdevice *>(user);
+                sub->monitor->set_errors(sub->stream->transfer_errors);
+                sub->monitor->on_frame(frame->data_bytes, sub->frame_size);
+                auto ring = sub->frame_buffers;
+                auto data = static_cast<uint8_t *>(frame->data);
+                sub->callback(data, frame->data_bytes, [ring, data]() { frame_buffer_ring::release(data, ring.get()); });
+            }, &sub, 0, device.num_transfer_bufs);
+            if(status == UVC_SUCCESS && (device.capture_cpu_mask || device.capture_priority) && strmh->user_cb) set_thread_scheduling(strmh->cb_thread, device.capture_cpu_mask, device.capture_priority);
+            return status;
+        }
+
+        // Transfers complete on the event thread of the libuvc context, which owns the USB context of every device it opened
+        static void set_event_thread_scheduling(device & device)
+        {
+            auto ctx = device.parent->ctx;
+            if((device.capture_cpu_mask || device.capture_priority) && ctx->own_usb_ctx && ctx->open_devices) set_thread_scheduling(ctx->handler_thread, device.capture_cpu_mask, device.capture_priority);
+        }
+
         void start_streaming(device & device, int num_transfer_bufs)
         {
+            device.num_transfer_bufs = num_transfer_bufs;
             for(auto i = 0; i < device.subdevices.size(); i++)
             {
                 auto& sub = device.get_subdevice(i);
@@ -259,12 +456,59 @@ namespace rsimpl
                     uvc_print_stream_ctrl(&sub.ctrl, stdout);
                     #endif
 
-                    check("uvc_start_streaming", uvc_start_streaming(sub.handle, &sub.ctrl, [](uvc_frame * frame, void * user)
+                    sub.frame_buffers = std::make_shared<frame_buffer_ring>(sub.frame_buffer_count ? sub.frame_buffer_count : default_frame_buffer_count);
+                    sub.monitor->reset();
+                    uvc_stream_handle_t * strmh;
+                    check("uvc_stream_open_ctrl", uvc_stream_open_ctrl(sub.handle, &strmh, &sub.ctrl));
+                    uvc_stream_set_frame_buffers(strmh, &frame_buffer_ring::acquire, &frame_buffer_ring::release, sub.frame_buffers.get());
+                    if(sub.slice_callback) uvc_stream_set_slice_callback(strmh, sub.slice_rows, sub.slice_row_bytes, [](const uint8_t * rows, uint32_t first_row, uint32_t row_count, void * user)
                     {
-                        reinterpret_cast<subdevice *>(user)->callback(frame->data, []{});
-                    }, &sub, 0, num_transfer_bufs));
+                        reinterpret_cast<subdevice *>(user)->slice_callback(rows, first_row, row_count);
+                    }, &sub);
+                    auto status = start_stream(device, sub, strmh);
+                    if(status < 0) uvc_stream_close(strmh);
+                    check("uvc_stream_start", status);
+                    sub.ctrl.handle = strmh;
+                }
+            }
+            set_event_thread_scheduling(device);
+        }
+
+        // The stream handles stay open with their frame buffer rings, and only the transfers are stopped. Selecting the zero bandwidth
+        // alternate setting gives up the isochronous bandwidth, which uvc_stream_start reserves again.
+        void pause_streaming(device & device, int subdevice_index)
+        {
+            for(int i = 0; i < (int)device.subdevices.size(); ++i)
+            {
+                auto & sub = device.subdevices[i];
+                if(!sub.handle || (subdevice_index >= 0 && i != subdevice_index)) continue;
+                for(auto strmh = sub.handle->streams; strmh; strmh = strmh->next)
+                {
+                    if(!strmh->running) continue;
+                    uvc_stream_stop(strmh);
+                    int status = libusb_set_interface_alt_setting(strmh->devh->usb_devh, strmh->stream_if->bInterfaceNumber, 0);
+                    if(status < 0) LOG_WARNING("libusb_set_interface_alt_setting(...) returned " << libusb_error_name(status));
+                }
+            }
+        }
+
+        void resume_streaming(device & device, int subdevice_index)
+        {
+            for(int i = 0; i < (int)device.subdevices.size(); ++i)
+            {
+                auto & sub = device.subdevices[i];
+                if(!sub.handle || (subdevice_index >= 0 && i != subdevice_index)) continue;
+                for(auto strmh = sub.handle->streams; strmh; strmh = strmh->next)
+                {
+                    if(strmh->running) continue;
+
+                    // The format is committed again, as after the stream was opened
+                    auto ctrl = strmh->cur_ctrl;
+                    check("uvc_stream_ctrl", uvc_stream_ctrl(strmh, &ctrl));
+                    check("uvc_stream_start", start_stream(device, *reinterpret_cast<subdevice *>(strmh->user_ptr), strmh));
                 }
             }
+            set_event_thread_scheduling(device);
         }
 
         void stop_streaming(device & device)
@@ -273,14 +517,17 @@ namespace rsimpl
             for(auto & sub : device.subdevices)
             {
                 if(sub.handle) uvc_stop_streaming(sub.handle);
+                sub.frame_buffers.reset();
+                sub.stream = nullptr;
                 sub.ctrl = {};
                 sub.callback = {};
+                sub.slice_callback = {};
             }
         }
 
-        void start_data_acquisition(device & device)
+        void start_data_acquisition(device & device, int num_transfers)
         {
-            device.start_data_acquisition();
+            device.start_data_acquisition(num_transfers);
         }
 
         void stop_data_acquisition(device & device)
@@ -296,7 +543,7 @@ namespace rsimpl
             if(sizeof(T)==2) SHORT_TO_SW(value, buffer);
             if(sizeof(T)==4) INT_TO_DW(value, buffer);
             int status = libusb_control_transfer(devh->usb_devh, REQ_TYPE_SET, UVC_SET_CUR, control << 8, unit << 8 | (subdevice * 2), buffer, sizeof(T), 0);
-            if(status < 0) throw std::runtime_error(to_string() << "libusb_control_transfer(...) returned " << libusb_error_name(status));
+            if(status < 0) throw_control_error("libusb_control_transfer", status);
             if(status != sizeof(T)) throw std::runtime_error("insufficient data written to usb");
         }
 
@@ -305,7 +552,7 @@ namespace rsimpl
             const int REQ_TYPE_GET = 0xa1;
             unsigned char buffer[4];
             int status = libusb_control_transfer(devh->usb_devh, REQ_TYPE_GET, uvc_get_thing, control << 8, unit << 8 | (subdevice * 2), buffer, sizeof(T), 0);
-            if(status < 0) throw std::runtime_error(to_string() << "libusb_control_transfer(...) returned " << libusb_error_name(status));
+            if(status < 0) throw_control_error("libusb_control_transfer", status);
             if(status != sizeof(T)) throw std::runtime_error("insufficient data read from usb");
             if(sizeof(T)==1) return buffer[0];
             if(sizeof(T)==2) return SW_TO_SHORT(buffer);
@@ -413,6 +660,27 @@ namespace rsimpl
             return std::make_shared<context>();
         }
 
+        std::thread start_backend_thread(std::function<void()> function)
+        {
+            return std::thread(function);
+        }
+
+        void set_thread_cpu_mask(std::thread & thread, uint64_t cpu_mask)
+        {
+            set_thread_scheduling(thread.native_handle(), cpu_mask, 0);
+        }
+
+        void set_devices_changed_callback(context & context, devices_changed_callback callback)
+        {
+            context.monitor.reset();
+            if(callback) context.monitor.reset(new hotplug_monitor(context.usb_context, callback));
+        }
+
+        std::string get_device_instance_id(const device & device)
+        {
+            return to_string() << static_cast<int>(uvc_get_bus_number(device.uvcdevice)) << '-' << static_cast<int>(uvc_get_device_address(device.uvcdevice));
+        }
+
         bool is_device_connected(device & device, int vid, int pid)
         {
             return true;
@@ -0,0 +1,527 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#ifdef RS_USE_NETWORK_BACKEND
+
+#include "uvc.h"
+#include "network.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <map>
+#ifdef __linux__
+#include <pthread.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace rsimpl
+{
+    namespace uvc
+    {
+        struct device;
+
+        // Connection to one server, shared by all of its devices. Requests of any thread wait for their reply, while a thread of the connection
+        // receives the replies, the frames and the motion data, invoking the callbacks of the devices as they arrive.
+        struct connection
+        {
+            const std::string address;
+            std::unique_ptr<network::tcp_socket> socket;
+            std::mutex send_mutex;
+
+            struct pending_reply
+            {
+                bool done;
+                network::reply_status status;
+                network::arguments args;
+                std::vector<byte> data;
+            };
+
+            std::mutex mutex;                   // Guards the members below
+            std::condition_variable cv;
+            uint32_t next_request;
+            std::map<uint32_t, pending_reply *> pending;
+            std::map<int, std::weak_ptr<device>> devices; // Latest devices listed, by index on the server
+            bool lost;
+            std::thread thread;
+            bool * destroyed;                   // Set by the destructor when it runs on the thread of the connection
+
+            connection(const std::string & host, int port) : address(to_string() << host << ":" << port), socket(network::tcp_socket::connect(host, port)),
+                next_request(1), lost(false), destroyed(nullptr)
+            {
+                thread = std::thread([this]() { run(); });
+                network::arguments args = {};
+                args.values[0] = network::protocol_version;
+                request(network::message_type::hello, -1, -1, args);
+            }
+
+            ~connection()
+            {
+                socket->shutdown();
+                // The last device may be released by a callback, on the thread of the connection
+                if (thread.get_id() == std::this_thread::get_id())
+                {
+                    *destroyed = true;
+                    thread.detach();
+                }
+                else thread.join();
+            }
+
+            struct reply { network::arguments args; std::vector<byte> data; };
+
+            reply request(network::message_type type, int device, int subdevice, const network::arguments & args, const void * data = nullptr, size_t size = 0)
+            {
+                pending_reply r = { false };
+                network::message_header header = { network::protocol_magic, type, 0, device, subdevice, network::reply_status::ok, 0 };
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (lost) throw std::runtime_error(to_string() << "connection to " << address << " was lost");
+                    header.request = next_request++;
+                    pending[header.request] = &r;
+                }
+                try
+                {
+                    std::lock_guard<std::mutex> lock(send_mutex);
+                    network::send_message(*socket, header, &args, data, size);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    pending.erase(header.request);
+                    throw;
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]() { return r.done || lost; });
+                pending.erase(header.request);
+                if (!r.done) throw std::runtime_error(to_string() << "connection to " << address << " was lost");
+                if (r.status != network::reply_status::ok)
+                {
+                    std::string message(r.data.begin(), r.data.end());
+                    if (r.status == network::reply_status::rejected) throw control_rejected_error(message);
+                    throw std::runtime_error(message);
+                }
+                return { r.args, std::move(r.data) };
+            }
+
+            void run();
+        };
+
+        struct context
+        {
+            std::vector<std::pair<std::string, int>> servers;
+            std::map<std::string, std::shared_ptr<connection>> connections; // Reopened once lost
+            devices_changed_callback callback; // Servers are only listed again by query_devices, it is never invoked
+        };
+
+        struct subdevice
+        {
+            video_channel_callback callback;
+            size_t frame_size = 0;  // Of the mode, frames the server sends short are padded to it
+            data_channel_callback data_callback;
+        };
+
+        struct device
+        {
+            const std::shared_ptr<connection> server;
+            const int index;
+            const network::device_description description;
+            int control_retry_budget;
+
+            std::mutex mutex;                   // Guards the callbacks, which the thread of the connection invokes
+            subdevice subdevices[RS_STREAM_NATIVE_COUNT];
+
+            device(std::shared_ptr<connection> server, int index, const network::device_description & description) : server(server), index(index),
+                description(description), control_retry_budget(RS_DEFAULT_CONTROL_RETRY_BUDGET) {}
+
+            connection::reply request(network::message_type type, int subdevice, const network::arguments & args, const void * data = nullptr, size_t size = 0) const
+            {
+                return server->request(type, index, subdevice, args, data, size);
+            }
+
+            subdevice & get_subdevice(int subdevice_index)
+            {
+                if (subdevice_index < 0 || subdevice_index >= RS_STREAM_NATIVE_COUNT) throw std::runtime_error(to_string() << "no subdevice " << subdevice_index);
+                return subdevices[subdevice_index];
+            }
+        };
+
+        void connection::run()
+        {
+            std::vector<byte> buffer; // Frames are copied out of it before their callback returns
+            bool destroyed_here = false;
+            destroyed = &destroyed_here;
+            try
+            {
+                network::message_header header;
+                while (socket->receive(&header, sizeof(header)))
+                {
+                    if (header.magic != network::protocol_magic) throw std::runtime_error("malformed message");
+                    if (header.type == network::message_type::reply)
+                    {
+                        network::arguments args;
+                        if (header.size < sizeof(args) || !socket->receive(&args, sizeof(args))) throw std::runtime_error("malformed reply");
+                        std::vector<byte> data(header.size - sizeof(args));
+                        if (data.size() && !socket->receive(data.data(), data.size())) throw std::runtime_error("reply is truncated");
+
+                        std::lock_guard<std::mutex> lock(mutex);
+                        auto it = pending.find(header.request);
+                        if (it == pending.end()) continue;
+                        it->second->status = header.status;
+                        it->second->args = args;
+                        it->second->data = std::move(data);
+                        it->second->done = true;
+                        cv.notify_all();
+                        continue;
+                    }
+
+                    buffer.resize(header.size);
+                    if (header.size && !socket->receive(buffer.data(), buffer.size())) throw std::runtime_error("message is truncated");
+                    if (header.subdevice < 0 || header.subdevice >= RS_STREAM_NATIVE_COUNT) continue;
+
+                    // A callback may release the last reference to the device, and through it to the connection
+                    {
+                        std::shared_ptr<device> dev;
+                        {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            auto it = devices.find(header.device);
+                            if (it != devices.end()) dev = it->second.lock();
+                        }
+                        if (!dev) continue;
+
+                        std::unique_lock<std::mutex> lock(dev->mutex);
+                        auto & sub = dev->subdevices[header.subdevice];
+                        if (header.type == network::message_type::frame && sub.callback)
+                        {
+                            auto callback = sub.callback;
+                            const size_t received = buffer.size();
+                            if (received < sub.frame_size) buffer.resize(sub.frame_size);
+                            lock.unlock();
+                            callback(buffer.data(), received, []() {});
+                        }
+                        else if (header.type == network::message_type::data && sub.data_callback)
+                        {
+                            auto callback = sub.data_callback;
+                            lock.unlock();
+                            callback(buffer.data(), static_cast<int>(buffer.size()));
+                        }
+                    }
+                    if (destroyed_here) return;
+                }
+            }
+            catch (const std::exception & e)
+            {
+                LOG_ERROR("Connection to " << address << " failed: " << e.what());
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            lost = true;
+            cv.notify_all();
+        }
+
+        ////////////
+        // device //
+        ////////////
+
+        int get_vendor_id(const device & device) { return device.description.vendor_id; }
+        int get_product_id(const device & device) { return device.description.product_id; }
+        std::string get_usb_port_id(const device & device) { return to_string() << device.server->address << "/" << device.description.usb_port_id; }
+        std::string get_device_instance_id(const device & device) { return to_string() << device.server->address << "/" << device.description.device_instance_id; }
+
+        bool is_device_connected(device & device, int vid, int pid)
+        {
+            network::arguments args = {};
+            args.values[0] = vid;
+            args.values[1] = pid;
+            return device.request(network::message_type::is_device_connected, -1, args).args.values[0] != 0;
+        }
+
+        void claim_interface(device & device, const guid & interface_guid, int interface_number)
+        {
+            network::arguments args = {};
+            args.xu.id = interface_guid;
+            args.values[0] = interface_number;
+            device.request(network::message_type::claim_interface, -1, args);
+        }
+
+        void claim_aux_interface(device & device, const guid & interface_guid, int interface_number)
+        {
+            network::arguments args = {};
+            args.xu.id = interface_guid;
+            args.values[0] = interface_number;
+            device.request(network::message_type::claim_aux_interface, -1, args);
+        }
+
+        void bulk_transfer(device & device, unsigned char endpoint, void * data, int length, int * actual_length, unsigned int timeout)
+        {
+            network::arguments args = {};
+            args.values[0] = endpoint;
+            args.values[1] = length;
+            args.values[2] = static_cast<int32_t>(timeout);
+            const bool in = (endpoint & 0x80) != 0;
+            auto reply = device.request(network::message_type::bulk_transfer, -1, args, in ? nullptr : data, in ? 0 : length);
+            if (in) memcpy(data, reply.data.data(), std::min(reply.data.size(), static_cast<size_t>(length)));
+            *actual_length = reply.args.values[0];
+        }
+
+        void get_pu_control_range(const device & device, int subdevice, rs_option option, int * min, int * max, int * step, int * def)
+        {
+            network::arguments args = {};
+            args.values[0] = option;
+            auto reply = device.request(network::message_type::get_pu_control_range, subdevice, args);
+            if (min) *min = reply.args.values[0];
+            if (max) *max = reply.args.values[1];
+            if (step) *step = reply.args.values[2];
+            if (def) *def = reply.args.values[3];
+        }
+
+        void get_extension_control_range(const device & device, const extension_unit & xu, char control, int * min, int * max, int * step, int * def)
+        {
+            network::arguments args = {};
+            args.xu = xu;
+            args.values[0] = control;
+            auto reply = device.request(network::message_type::get_extension_control_range, xu.subdevice, args);
+            if (min) *min = reply.args.values[0];
+            if (max) *max = reply.args.values[1];
+            if (step) *step = reply.args.values[2];
+            if (def) *def = reply.args.values[3];
+        }
+
+        void set_pu_control(device & device, int subdevice, rs_option option, int value)
+        {
+            network::arguments args = {};
+            args.values[0] = option;
+            args.values[1] = value;
+            device.request(network::message_type::set_pu_control, subdevice, args);
+        }
+
+        int get_pu_control(const device & device, int subdevice, rs_option option)
+        {
+            network::arguments args = {};
+            args.values[0] = option;
+            return device.request(network::message_type::get_pu_control, subdevice, args).args.values[0];
+        }
+
+        void set_control(device & device, const extension_unit & xu, uint8_t ctrl, void * data, int len)
+        {
+            network::arguments args = {};
+            args.xu = xu;
+            args.values[0] = ctrl;
+            device.request(network::message_type::set_control, xu.subdevice, args, data, len);
+        }
+
+        void get_control(const device & device, const extension_unit & xu, uint8_t ctrl, void * data, int len)
+        {
+            network::arguments args = {};
+            args.xu = xu;
+            args.values[0] = ctrl;
+            args.values[1] = len;
+            auto reply = device.request(network::message_type::get_control, xu.subdevice, args);
+            if (reply.data.size() != static_cast<size_t>(len)) throw std::runtime_error("server replied with a control of another size");
+            memcpy(data, reply.data.data(), len);
+        }
+
+        void set_control_retry_budget(device & device, int milliseconds) { device.control_retry_budget = milliseconds; }
+        int get_control_retry_budget(const device & device) { return device.control_retry_budget; }
+
+        void set_subdevice_data_channel_handler(device & device, int subdevice_index, data_channel_callback callback)
+        {
+            {
+                std::lock_guard<std::mutex> lock(device.mutex);
+                device.get_subdevice(subdevice_index).data_callback = callback;
+            }
+            device.request(network::message_type::set_data_channel_handler, subdevice_index, {});
+        }
+
+        void start_data_acquisition(device & device, int num_transfers)
+        {
+            network::arguments args = {};
+            args.values[0] = num_transfers;
+            device.request(network::message_type::start_data_acquisition, -1, args);
+        }
+
+        void stop_data_acquisition(device & device)
+        {
+            // Transfers sent before the reply have all been delivered once it arrives
+            device.request(network::message_type::stop_data_acquisition, -1, {});
+        }
+
+        void set_subdevice_mode(device & device, int subdevice_index, int width, int height, uint32_t fourcc, int fps, size_t frame_size, video_channel_callback callback)
+        {
+            network::arguments args = {};
+            args.values[0] = width;
+            args.values[1] = height;
+            args.values[2] = static_cast<int32_t>(fourcc);
+            args.values[3] = fps;
+            args.values[4] = static_cast<int32_t>(frame_size);
+            device.request(network::message_type::set_subdevice_mode, subdevice_index, args);
+
+            std::lock_guard<std::mutex> lock(device.mutex);
+            device.get_subdevice(subdevice_index).callback = callback;
+            device.get_subdevice(subdevice_index).frame_size = frame_size;
+        }
+
+        bool set_subdevice_crop(device & device, int subdevice_index, int x, int y, int width, int height)
+        {
+            return width == 0; // Frames are relayed as the server captured them
+        }
+
+        bool set_subdevice_slice_callback(device & device, int subdevice_index, int rows_per_slice, size_t row_bytes, video_slice_callback callback)
+        {
+            return !callback; // Frames are relayed whole
+        }
+
+        void set_subdevice_buffer_count(device & device, int subdevice_index, int buffer_count)
+        {
+            network::arguments args = {};
+            args.values[0] = buffer_count;
+            device.request(network::message_type::set_subdevice_buffer_count, subdevice_index, args);
+        }
+
+        void get_subdevice_buffer_count_range(const device & device, int & min, int & max)
+        {
+            auto reply = device.request(network::message_type::get_subdevice_buffer_count_range, -1, {});
+            min = reply.args.values[0];
+            max = reply.args.values[1];
+        }
+
+        transfer_statistics get_subdevice_transfer_statistics(const device & device, int subdevice_index)
+        {
+            auto reply = device.request(network::message_type::get_subdevice_transfer_statistics, subdevice_index, {});
+            transfer_statistics statistics;
+            if (reply.data.size() != sizeof(statistics)) throw std::runtime_error("server replied with malformed transfer statistics");
+            memcpy(&statistics, reply.data.data(), sizeof(statistics));
+            return statistics;
+        }
+
+        void set_subdevice_capture_memory(device & device, int subdevice_index, capture_memory memory, std::shared_ptr<rs_frame_allocator> allocator, const std::vector<int> & dmabuf_fds)
+        {
+            if (memory != capture_memory::mapped) throw std::runtime_error("frames of a remote device are received into a buffer of the connection");
+        }
+
+        bool supports_zero_copy(const device & device) { return false; }
+
+        // Applies to the capture threads of the server, which send the frames
+        void set_capture_thread_scheduling(device & device, uint64_t cpu_mask, int priority)
+        {
+            network::arguments args = {};
+            memcpy(args.values, &cpu_mask, sizeof(cpu_mask));
+            args.values[2] = priority;
+            device.request(network::message_type::set_capture_thread_scheduling, -1, args);
+        }
+
+        void start_streaming(device & device, int num_transfer_bufs)
+        {
+            network::arguments args = {};
+            args.values[0] = num_transfer_bufs;
+            device.request(network::message_type::start_streaming, -1, args);
+        }
+
+        void stop_streaming(device & device)
+        {
+            // Frames sent before the reply have all been delivered once it arrives
+            device.request(network::message_type::stop_streaming, -1, {});
+            std::lock_guard<std::mutex> lock(device.mutex);
+            for (auto & sub : device.subdevices) sub.callback = nullptr;
+        }
+
+        void pause_streaming(device & device, int subdevice_index) { device.request(network::message_type::pause_streaming, subdevice_index, {}); }
+        void resume_streaming(device & device, int subdevice_index) { device.request(network::message_type::resume_streaming, subdevice_index, {}); }
+
+        ////////////
+        // thread //
+        ////////////
+
+        std::thread start_backend_thread(std::function<void()> function)
+        {
+            return std::thread(function);
+        }
+
+        void set_thread_cpu_mask(std::thread & thread, uint64_t cpu_mask)
+        {
+            if (!cpu_mask) return;
+#ifdef __linux__
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) if (cpu_mask >> cpu & 1) CPU_SET(cpu, &cpus);
+            if (int status = pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus)) LOG_WARNING("pthread_setaffinity_np(...) returned " << strerror(status));
+#elif defined(_WIN32)
+            if (!SetThreadAffinityMask(thread.native_handle(), (DWORD_PTR)cpu_mask)) LOG_WARNING("SetThreadAffinityMask(...) returned " << GetLastError());
+#endif
+        }
+
+        /////////////
+        // context //
+        /////////////
+
+        std::shared_ptr<context> create_context()
+        {
+            auto ctx = std::make_shared<context>();
+            auto servers = getenv("RS_NETWORK_SERVERS");
+            std::string list = servers ? servers : "";
+            for (size_t begin = 0, end; begin < list.size(); begin = end + 1)
+            {
+                end = list.find(',', begin);
+                if (end == std::string::npos) end = list.size();
+                auto server = list.substr(begin, end - begin);
+                if (server.empty()) continue;
+
+                auto colon = server.rfind(':');
+                int port = colon == std::string::npos ? 0 : atoi(server.c_str() + colon + 1);
+                if (port <= 0 || port > 65535) throw std::runtime_error(to_string() << "RS_NETWORK_SERVERS names " << server << ", which is not a host:port pair");
+                ctx->servers.push_back({ server.substr(0, colon), port });
+            }
+            if (ctx->servers.empty()) LOG_WARNING("No servers to connect to, RS_NETWORK_SERVERS is not set");
+            return ctx;
+        }
+
+        std::vector<std::shared_ptr<device>> query_devices(std::shared_ptr<context> context)
+        {
+            std::vector<std::shared_ptr<device>> devices;
+            for (auto & server : context->servers)
+            {
+                // Servers which cannot be reached contribute no devices, until they can
+                std::string key = to_string() << server.first << ":" << server.second;
+                auto & conn = context->connections[key];
+                try
+                {
+                    if (conn)
+                    {
+                        std::lock_guard<std::mutex> lock(conn->mutex);
+                        if (conn->lost) conn.reset();
+                    }
+                    if (!conn) conn = std::make_shared<connection>(server.first, server.second);
+                    auto reply = conn->request(network::message_type::list_devices, -1, -1, {});
+
+                    std::lock_guard<std::mutex> lock(conn->mutex);
+                    conn->devices.clear();
+                    for (size_t i = 0; i + sizeof(network::device_description) <= reply.data.size(); i += sizeof(network::device_description))
+                    {
+                        network::device_description description;
+                        memcpy(&description, reply.data.data() + i, sizeof(description));
+                        description.usb_port_id[sizeof(description.usb_port_id) - 1] = 0;
+                        description.device_instance_id[sizeof(description.device_instance_id) - 1] = 0;
+                        const int index = static_cast<int>(i / sizeof(description));
+                        auto dev = std::make_shared<device>(conn, index, description);
+                        conn->devices[index] = dev;
+                        devices.push_back(dev);
+                    }
+                }
+                catch (const std::exception & e)
+                {
+                    LOG_WARNING("Server " << key << " cannot be reached: " << e.what());
+                    conn.reset();
+                }
+            }
+            return devices;
+        }
+
+        void set_devices_changed_callback(context & context, devices_changed_callback callback)
+        {
+            context.callback = callback;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,674 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#ifdef RS_USE_PLAYBACK_BACKEND
+
+#include "uvc.h"
+#include "recording.h"
+#include "depth-codec.h"
+#include "shared-ring.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <algorithm>
+#ifdef __linux__
+#include <pthread.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace rsimpl
+{
+    namespace uvc
+    {
+        struct context
+        {
+            std::vector<std::string> paths;
+            std::vector<std::string> rings;
+            devices_changed_callback callback; // Recordings come and go with the context, it is never invoked
+        };
+
+        struct subdevice
+        {
+            int width, height, fps;
+            uint32_t fourcc;
+            size_t frame_size;          // Raw frames recorded with fewer bytes are counted as short, encoded frames by the bytes they were stored in
+            video_channel_callback callback;
+            data_channel_callback data_callback;
+            transfer_monitor monitor;   // Of the bytes read from the recording or ring, of the window alone when cropping
+            int crop_x = 0, crop_y = 0, crop_width = 0, crop_height = 0; // Window the frames are cut down to, emulating a driver which crops, a width of 0 for whole frames
+            std::shared_ptr<std::vector<uint8_t>> cropped; // Latest window cut from a frame
+            bool paused = false;        // Guarded by the mutex of the device, the frames of the subdevice are skipped while set
+        };
+
+        // Replays a recording from a thread of its own, which runs while the device streams or acquires motion data. Frames are delivered to the
+        // subdevices streaming in the mode they were recorded in, motion data to those with a data channel handler, in the order of the recording.
+        // Recordings are mapped into memory whenever possible, and their frames handed out in place, each continuation holding the mapping, so
+        // that replaying costs no more than the page faults of the mapping. Encoded frames are decoded into buffers which continuations hold.
+        // Rings are replayed as they are published, from their slots, each continuation holding its slot. Seeking goes through the index of the
+        // recording, read on the first seek, and only moves the reader of the thread, restoring the modes in effect at the frame sought.
+        struct device
+        {
+            const std::shared_ptr<context> parent;
+            const std::string path;
+            std::shared_ptr<const recording::mapped_file> mapping; // Null when the recording is read through buffered I/O
+            std::shared_ptr<shared_ring::subscriber> ring; // Set instead of the recording for devices of a ring
+            subdevice subdevices[RS_STREAM_NATIVE_COUNT];
+            int control_retry_budget;
+            uint64_t capture_cpu_mask;
+
+            std::mutex mutex;                   // Guards the members below
+            std::condition_variable cv;
+            bool streaming, acquiring, paused, stopping;
+            rs_playback_pacing pacing;
+            bool rebase;                        // Set when real time pacing must restart its clock from the next record
+            bool finished;                      // Set once the thread reached the end of the recording
+            unsigned long long steps_requested, steps_delivered;
+            bool seek_pending;                  // Set until the thread moves to seek_target, from its next record
+            recording::index_entry seek_target;
+            std::vector<recording::index_entry> seek_modes; // Latest mode record of every subdevice before seek_target
+            std::thread thread;
+
+            std::mutex index_mutex;             // Guards the members below
+            bool index_loaded;
+            std::vector<recording::index_entry> index;
+            std::vector<size_t> mode_entries;   // Of index
+            std::vector<size_t> frame_entries[RS_STREAM_NATIVE_COUNT]; // Of index, for every subdevice
+
+            const recording::frame_record * current_frame; // Only accessed by the thread, set while it invokes a video_channel_callback
+
+            device(std::shared_ptr<context> parent, const std::string & path) : parent(parent), path(path), subdevices(), control_retry_budget(RS_DEFAULT_CONTROL_RETRY_BUDGET),
+                capture_cpu_mask(0), streaming(false), acquiring(false), paused(false), stopping(false), pacing(RS_PLAYBACK_PACING_REAL_TIME), rebase(true),
+                finished(false), steps_requested(0), steps_delivered(0), seek_pending(false), seek_target(), index_loaded(false), current_frame(nullptr)
+            {
+                try { mapping = std::make_shared<recording::mapped_file>(path); }
+                catch (const std::exception & e) { LOG_WARNING("Replaying " << path << " through buffered reads: " << e.what()); }
+            }
+            device(std::shared_ptr<context> parent, std::shared_ptr<shared_ring::subscriber> ring, const std::string & name) : parent(parent), path(name), ring(ring),
+                subdevices(), control_retry_budget(RS_DEFAULT_CONTROL_RETRY_BUDGET), capture_cpu_mask(0), streaming(false), acquiring(false), paused(false),
+                stopping(false), pacing(RS_PLAYBACK_PACING_REAL_TIME), rebase(true), finished(false), steps_requested(0), steps_delivered(0), seek_pending(false),
+                seek_target(), index_loaded(false), current_frame(nullptr) {}
+            ~device() { stop_thread(); }
+
+            void start_thread()
+            {
+                if (thread.joinable()) return;
+                stopping = finished = false;
+                rebase = true;
+                steps_requested = steps_delivered = 0;
+                thread = std::thread([this]() { if (ring) run_ring(); else run(); });
+                set_thread_cpu_mask(thread, capture_cpu_mask);
+            }
+
+            void stop_thread()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                }
+                cv.notify_all();
+                if (thread.joinable()) thread.join();
+            }
+
+            // Waits for the time a record is due at, returning false if the thread must stop first
+            bool wait_for(int64_t system_time, bool is_frame, std::chrono::steady_clock::time_point & origin, int64_t & origin_time)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true)
+                {
+                    if (stopping) return false;
+                    if (seek_pending) return true; // The record is dropped by the caller
+                    if (paused) { cv.wait(lock); rebase = true; continue; }
+
+                    if (pacing == RS_PLAYBACK_PACING_STEP)
+                    {
+                        if (!is_frame || steps_requested > steps_delivered) return true;
+                        cv.wait(lock);
+                        rebase = true;
+                        continue;
+                    }
+                    if (pacing == RS_PLAYBACK_PACING_AS_FAST_AS_POSSIBLE)
+                    {
+                        rebase = true;
+                        return true;
+                    }
+
+                    if (rebase)
+                    {
+                        origin = std::chrono::steady_clock::now();
+                        origin_time = system_time;
+                        rebase = false;
+                    }
+                    auto due = origin + std::chrono::milliseconds(system_time - origin_time);
+                    if (cv.wait_until(lock, due) == std::cv_status::timeout) return true;
+                }
+            }
+
+            // Cuts the window out of a whole frame into a buffer the continuation holds, frames of packed formats having rows of whole pixels
+            const void * crop_frame(subdevice & sub, const void * frame, size_t frame_bytes, std::shared_ptr<const void> & holder)
+            {
+                if (!sub.crop_width) return frame;
+                const size_t row_bytes = frame_bytes / sub.height, pixel_bytes = row_bytes / sub.width, window_row_bytes = pixel_bytes * sub.crop_width;
+                if (!sub.cropped || sub.cropped.use_count() > 1) sub.cropped = std::make_shared<std::vector<uint8_t>>(); // The last one is still held
+                sub.cropped->resize(window_row_bytes * sub.crop_height);
+                for (int y = 0; y < sub.crop_height; ++y) memcpy(sub.cropped->data() + window_row_bytes * y, static_cast<const uint8_t *>(frame) + row_bytes * (sub.crop_y + y) + pixel_bytes * sub.crop_x, window_row_bytes);
+                holder = sub.cropped;
+                return sub.cropped->data();
+            }
+
+            void run()
+            {
+                try
+                {
+                    std::unique_ptr<recording::reader> reader(mapping ? new recording::reader(mapping) : new recording::reader(path));
+                    recording::mode_record modes[RS_STREAM_NATIVE_COUNT] = {};
+                    std::chrono::steady_clock::time_point origin;
+                    int64_t origin_time = 0;
+
+                    std::shared_ptr<std::vector<uint16_t>> decoded; // Latest frame which was encoded in the recording
+                    recording::record r;
+                    while (true)
+                    {
+                        if (apply_seek(*reader, modes)) rebase_pacing();
+                        if (!reader->next(r)) break;
+                        if (r.type == recording::record_type::mode)
+                        {
+                            auto & mode = *reinterpret_cast<const recording::mode_record *>(r.payload);
+                            if (mode.subdevice >= 0 && mode.subdevice < RS_STREAM_NATIVE_COUNT) modes[mode.subdevice] = mode;
+                        }
+                        else if (r.type == recording::record_type::frame)
+                        {
+                            auto & frame = *reinterpret_cast<const recording::frame_record *>(r.payload);
+                            if (frame.subdevice < 0 || frame.subdevice >= RS_STREAM_NATIVE_COUNT) continue;
+                            auto & sub = subdevices[frame.subdevice];
+                            auto & mode = modes[frame.subdevice];
+                            if (!sub.callback || sub.width != mode.width || sub.height != mode.height || sub.fourcc != mode.fourcc || sub.fps != mode.fps) continue;
+                            {
+                                std::lock_guard<std::mutex> lock(mutex);
+                                if (!streaming || sub.paused) continue;
+                            }
+                            if (!wait_for(frame.system_time, true, origin, origin_time)) return;
+                            if (is_seek_pending()) continue;
+
+                            const void * data = r.payload + sizeof(frame);
+                            std::shared_ptr<const void> holder = mapping;
+                            if (frame.encoding == recording::frame_encoding::rvl)
+                            {
+                                if (!decoded || decoded.use_count() > 1) decoded = std::make_shared<std::vector<uint16_t>>(); // The last one is still held
+                                decoded->resize(static_cast<size_t>(mode.width) * mode.height);
+                                rvl_decode(decoded->data(), static_cast<int>(decoded->size()), r.payload + sizeof(frame), r.size - sizeof(frame));
+                                data = decoded->data();
+                                holder = decoded;
+                            }
+                            else if (frame.encoding != recording::frame_encoding::raw) throw std::runtime_error("recording holds frames of an unknown encoding");
+
+                            const size_t frame_bytes = frame.encoding == recording::frame_encoding::rvl ? decoded->size() * sizeof(uint16_t) : r.size - sizeof(frame);
+                            data = crop_frame(sub, data, frame_bytes, holder);
+                            if (sub.crop_width) sub.monitor.on_frame(sub.cropped->size(), sub.frame_size);
+                            else sub.monitor.on_frame(r.size - sizeof(frame), frame.encoding == recording::frame_encoding::raw ? sub.frame_size : 0);
+                            current_frame = &frame;
+                            sub.callback(data, sub.crop_width ? sub.cropped->size() : frame_bytes, [holder]() {}); // Without a mapping, the frame is copied before the callback returns
+                            current_frame = nullptr;
+                            {
+                                std::lock_guard<std::mutex> lock(mutex);
+                                ++steps_delivered;
+                            }
+                            cv.notify_all();
+                        }
+                        else if (r.type == recording::record_type::motion)
+                        {
+                            auto & motion = *reinterpret_cast<const recording::motion_record *>(r.payload);
+                            if (motion.subdevice < 0 || motion.subdevice >= RS_STREAM_NATIVE_COUNT || !subdevices[motion.subdevice].data_callback) continue;
+                            {
+                                std::lock_guard<std::mutex> lock(mutex);
+                                if (!acquiring) continue;
+                            }
+                            if (!wait_for(motion.system_time, false, origin, origin_time)) return;
+                            if (is_seek_pending()) continue;
+                            subdevices[motion.subdevice].data_callback(r.payload + sizeof(motion), static_cast<int>(r.size - sizeof(motion)));
+                        }
+                    }
+                }
+                catch (const std::exception & e)
+                {
+                    LOG_ERROR("Replaying " << path << " failed: " << e.what());
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished = true;
+                }
+                cv.notify_all();
+            }
+
+            bool is_seek_pending()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                return seek_pending;
+            }
+
+            void rebase_pacing()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                rebase = true;
+            }
+
+            // Moves the reader of the thread to the record sought if any, restoring the modes in effect there
+            bool apply_seek(recording::reader & reader, recording::mode_record (& modes)[RS_STREAM_NATIVE_COUNT])
+            {
+                recording::index_entry target;
+                std::vector<recording::index_entry> mode_records;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!seek_pending) return false;
+                    seek_pending = false;
+                    target = seek_target;
+                    mode_records.swap(seek_modes);
+                }
+
+                recording::record r;
+                for (auto & entry : mode_records)
+                {
+                    reader.seek(entry);
+                    if (!reader.next(r) || r.type != recording::record_type::mode) throw std::runtime_error("index of the recording does not match its records");
+                    modes[entry.subdevice] = *reinterpret_cast<const recording::mode_record *>(r.payload);
+                }
+                reader.seek(target);
+                return true;
+            }
+
+            // Seeks the first frame of a subdevice for which a predicate holds, the predicate being false up to some frame of the subdevice and
+            // true from it on, so that the frame is found by bisection
+            template<class F> bool seek(int subdevice, F is_at_or_after)
+            {
+                if (ring) throw std::logic_error("a ring is replayed as it is published, playback cannot move within it");
+                if (subdevice < 0 || subdevice >= RS_STREAM_NATIVE_COUNT) throw std::runtime_error(to_string() << "no subdevice " << subdevice);
+
+                recording::index_entry target;
+                std::vector<recording::index_entry> modes;
+                {
+                    std::lock_guard<std::mutex> lock(index_mutex);
+                    if (!index_loaded)
+                    {
+                        std::unique_ptr<recording::reader> reader(mapping ? new recording::reader(mapping) : new recording::reader(path));
+                        index = reader->read_index();
+                        for (size_t i = 0; i < index.size(); ++i)
+                        {
+                            if (index[i].subdevice < 0 || index[i].subdevice >= RS_STREAM_NATIVE_COUNT) continue;
+                            if (index[i].type == recording::record_type::mode) mode_entries.push_back(i);
+                            else if (index[i].type == recording::record_type::frame) frame_entries[index[i].subdevice].push_back(i);
+                        }
+                        index_loaded = true;
+                    }
+
+                    auto & frames = frame_entries[subdevice];
+                    auto it = std::partition_point(frames.begin(), frames.end(), [&](size_t i) { return !is_at_or_after(index[i]); });
+                    if (it == frames.end()) return false;
+                    target = index[*it];
+
+                    size_t latest[RS_STREAM_NATIVE_COUNT];
+                    std::fill(std::begin(latest), std::end(latest), SIZE_MAX);
+                    for (auto i : mode_entries)
+                    {
+                        if (i > *it) break;
+                        latest[index[i].subdevice] = i;
+                    }
+                    for (auto i : latest) if (i != SIZE_MAX) modes.push_back(index[i]);
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+                seek_pending = true;
+                seek_target = target;
+                seek_modes = modes;
+                if (finished && thread.joinable())
+                {
+                    // The thread reached the end of the recording, it starts again from the frame sought
+                    lock.unlock();
+                    thread.join();
+                    lock.lock();
+                    if (streaming || acquiring) start_thread();
+                }
+                lock.unlock();
+                cv.notify_all();
+                return true;
+            }
+
+            // Delivers the records published from the start of the device on, in order, leaving out those published while paused
+            void run_ring()
+            {
+                try
+                {
+                    uint64_t last = ring->get_latest();
+                    while (true)
+                    {
+                        {
+                            std::unique_lock<std::mutex> lock(mutex);
+                            if (paused)
+                            {
+                                cv.wait(lock, [this]() { return stopping || !paused; });
+                                last = ring->get_latest();
+                            }
+                            if (stopping) break;
+                        }
+
+                        auto held = ring->hold_next(last, std::chrono::milliseconds(100));
+                        if (!held)
+                        {
+                            if (!ring->is_closed()) continue;
+                            LOG_WARNING("Ring " << path << " is no longer published");
+                            break;
+                        }
+                        last = held->sequence;
+
+                        if (held->type == recording::record_type::frame)
+                        {
+                            recording::mode_record mode;
+                            recording::frame_record frame;
+                            memcpy(&mode, held->payload, sizeof(mode));
+                            memcpy(&frame, held->payload + sizeof(mode), sizeof(frame));
+                            if (frame.subdevice < 0 || frame.subdevice >= RS_STREAM_NATIVE_COUNT) continue;
+                            auto & sub = subdevices[frame.subdevice];
+                            if (!sub.callback || sub.width != mode.width || sub.height != mode.height || sub.fourcc != mode.fourcc || sub.fps != mode.fps) continue;
+                            {
+                                std::lock_guard<std::mutex> lock(mutex);
+                                if (!streaming || sub.paused) continue;
+                            }
+
+                            std::shared_ptr<const void> holder = held;
+                            const void * data = crop_frame(sub, held->payload + sizeof(mode) + sizeof(frame), held->size - sizeof(mode) - sizeof(frame), holder);
+                            const size_t frame_bytes = sub.crop_width ? sub.cropped->size() : held->size - sizeof(mode) - sizeof(frame);
+                            sub.monitor.on_frame(frame_bytes, sub.frame_size);
+                            current_frame = &frame;
+                            sub.callback(data, frame_bytes, [holder]() {});
+                            current_frame = nullptr;
+                        }
+                        else if (held->type == recording::record_type::motion)
+                        {
+                            recording::motion_record motion;
+                            memcpy(&motion, held->payload, sizeof(motion));
+                            if (motion.subdevice < 0 || motion.subdevice >= RS_STREAM_NATIVE_COUNT || !subdevices[motion.subdevice].data_callback) continue;
+                            {
+                                std::lock_guard<std::mutex> lock(mutex);
+                                if (!acquiring) continue;
+                            }
+                            subdevices[motion.subdevice].data_callback(held->payload + sizeof(motion), static_cast<int>(held->size - sizeof(motion)));
+                        }
+                    }
+                }
+                catch (const std::exception & e)
+                {
+                    LOG_ERROR("Replaying ring " << path << " failed: " << e.what());
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished = true;
+                }
+                cv.notify_all();
+            }
+        };
+
+        ////////////
+        // device //
+        ////////////
+
+        int get_vendor_id(const device & device) { return VID_INTEL_CAMERA; }
+        int get_product_id(const device & device) { return 0; }
+        std::string get_usb_port_id(const device & device) { return device.path; }
+        std::string get_device_instance_id(const device & device) { return device.path; }
+        bool is_device_connected(device & device, int vid, int pid) { return true; }
+
+        void claim_interface(device & device, const guid & interface_guid, int interface_number) {}
+        void claim_aux_interface(device & device, const guid & interface_guid, int interface_number) {}
+        void bulk_transfer(device & device, unsigned char endpoint, void * data, int length, int * actual_length, unsigned int timeout)
+        {
+            throw control_rejected_error("a recording cannot take commands");
+        }
+
+        void get_pu_control_range(const device & device, int subdevice, rs_option option, int * min, int * max, int * step, int * def)
+        {
+            throw control_rejected_error("a recording has no controls");
+        }
+        void get_extension_control_range(const device & device, const extension_unit & xu, char control, int * min, int * max, int * step, int * def)
+        {
+            throw control_rejected_error("a recording has no controls");
+        }
+        void set_pu_control(device & device, int subdevice, rs_option option, int value) { throw control_rejected_error("a recording has no controls"); }
+        int get_pu_control(const device & device, int subdevice, rs_option option) { throw control_rejected_error("a recording has no controls"); }
+        void set_control(device & device, const extension_unit & xu, uint8_t ctrl, void * data, int len) { throw control_rejected_error("a recording has no controls"); }
+        void get_control(const device & device, const extension_unit & xu, uint8_t ctrl, void * data, int len) { throw control_rejected_error("a recording has no controls"); }
+
+        void set_control_retry_budget(device & device, int milliseconds) { device.control_retry_budget = milliseconds; }
+        int get_control_retry_budget(const device & device) { return device.control_retry_budget; }
+
+        void set_subdevice_data_channel_handler(device & device, int subdevice_index, data_channel_callback callback)
+        {
+            if (subdevice_index < 0 || subdevice_index >= RS_STREAM_NATIVE_COUNT) throw std::runtime_error(to_string() << "no subdevice " << subdevice_index);
+            device.subdevices[subdevice_index].data_callback = callback;
+        }
+
+        void start_data_acquisition(device & device, int num_transfers)
+        {
+            std::lock_guard<std::mutex> lock(device.mutex);
+            device.acquiring = true;
+            device.start_thread();
+        }
+
+        void stop_data_acquisition(device & device)
+        {
+            bool idle;
+            {
+                std::lock_guard<std::mutex> lock(device.mutex);
+                device.acquiring = false;
+                idle = !device.streaming;
+            }
+            if (idle) device.stop_thread();
+        }
+
+        void set_subdevice_mode(device & device, int subdevice_index, int width, int height, uint32_t fourcc, int fps, size_t frame_size, video_channel_callback callback)
+        {
+            if (subdevice_index < 0 || subdevice_index >= RS_STREAM_NATIVE_COUNT) throw std::runtime_error(to_string() << "no subdevice " << subdevice_index);
+            auto & sub = device.subdevices[subdevice_index];
+            sub.width = width;
+            sub.height = height;
+            sub.fourcc = fourcc;
+            sub.fps = fps;
+            sub.frame_size = frame_size;
+            sub.callback = callback;
+        }
+
+        bool set_subdevice_crop(device & device, int subdevice_index, int x, int y, int width, int height)
+        {
+            if (subdevice_index < 0 || subdevice_index >= RS_STREAM_NATIVE_COUNT) throw std::runtime_error(to_string() << "no subdevice " << subdevice_index);
+            auto & sub = device.subdevices[subdevice_index];
+            sub.crop_x = x;
+            sub.crop_y = y;
+            sub.crop_width = width;
+            sub.crop_height = height;
+            return true;
+        }
+
+        bool set_subdevice_slice_callback(device & device, int subdevice_index, int rows_per_slice, size_t row_bytes, video_slice_callback callback)
+        {
+            return !callback; // Frames are replayed whole
+        }
+
+        transfer_statistics get_subdevice_transfer_statistics(const device & device, int subdevice_index)
+        {
+            if (subdevice_index < 0 || subdevice_index >= RS_STREAM_NATIVE_COUNT) throw std::runtime_error(to_string() << "no subdevice " << subdevice_index);
+            return device.subdevices[subdevice_index].monitor.get();
+        }
+
+        void set_subdevice_buffer_count(device & device, int subdevice_index, int buffer_count)
+        {
+            if (buffer_count) throw std::runtime_error("recordings are replayed from a buffer of their own, the buffer count cannot be set");
+        }
+
+        void get_subdevice_buffer_count_range(const device & device, int & min, int & max) { min = max = 0; }
+
+        void set_subdevice_capture_memory(device & device, int subdevice_index, capture_memory memory, std::shared_ptr<rs_frame_allocator> allocator, const std::vector<int> & dmabuf_fds)
+        {
+            if (memory != capture_memory::mapped) throw std::runtime_error("recordings are replayed from a buffer of their own");
+        }
+
+        bool supports_zero_copy(const device & device) { return device.mapping || device.ring; }
+
+        void set_capture_thread_scheduling(device & device, uint64_t cpu_mask, int priority) { device.capture_cpu_mask = cpu_mask; }
+
+        void start_streaming(device & device, int num_transfer_bufs)
+        {
+            std::lock_guard<std::mutex> lock(device.mutex);
+            for (auto & sub : device.subdevices) sub.monitor.reset();
+            device.streaming = true;
+            device.paused = false;
+            for (auto & sub : device.subdevices) sub.paused = false;
+            device.start_thread();
+        }
+
+        void stop_streaming(device & device)
+        {
+            bool idle;
+            {
+                std::lock_guard<std::mutex> lock(device.mutex);
+                device.streaming = false;
+                device.paused = false;
+                idle = !device.acquiring;
+            }
+            if (idle) device.stop_thread();
+            for (auto & sub : device.subdevices) sub.callback = nullptr;
+        }
+
+        // Pausing a single subdevice skips its frames as they come up, replaying the others at their pace
+        void pause_streaming(device & device, int subdevice_index)
+        {
+            std::lock_guard<std::mutex> lock(device.mutex);
+            if (subdevice_index < 0) device.paused = true;
+            else if (subdevice_index < RS_STREAM_NATIVE_COUNT) device.subdevices[subdevice_index].paused = true;
+        }
+
+        void resume_streaming(device & device, int subdevice_index)
+        {
+            {
+                std::lock_guard<std::mutex> lock(device.mutex);
+                if (subdevice_index < 0) device.paused = false;
+                for (int i = 0; i < RS_STREAM_NATIVE_COUNT; ++i) if (subdevice_index < 0 || i == subdevice_index) device.subdevices[i].paused = false;
+            }
+            device.cv.notify_all();
+        }
+
+        std::string get_playback_path(const device & device) { return device.path; }
+        std::string get_playback_ring(const device & device) { return device.ring ? device.path : std::string(); }
+
+        void set_playback_pacing(device & device, rs_playback_pacing pacing)
+        {
+            if (device.ring) throw std::logic_error("a ring is replayed as it is published, its pacing cannot be set");
+            {
+                std::lock_guard<std::mutex> lock(device.mutex);
+                device.pacing = pacing;
+                device.rebase = true;
+            }
+            device.cv.notify_all();
+        }
+
+        bool step_playback(device & device)
+        {
+            std::unique_lock<std::mutex> lock(device.mutex);
+            if (device.pacing != RS_PLAYBACK_PACING_STEP) throw std::logic_error("playback is not paced by steps");
+            if (!device.streaming) throw std::logic_error("device is not streaming");
+            auto target = ++device.steps_requested;
+            device.cv.notify_all();
+            device.cv.wait(lock, [&]() { return device.steps_delivered >= target || device.finished || device.stopping; });
+            return device.steps_delivered >= target;
+        }
+
+        bool seek_playback_to_frame(device & device, int subdevice, unsigned long long frame_counter)
+        {
+            return device.seek(subdevice, [frame_counter](const recording::index_entry & e) { return e.frame_counter >= frame_counter; });
+        }
+
+        bool seek_playback_to_time(device & device, int subdevice, double timestamp)
+        {
+            return device.seek(subdevice, [timestamp](const recording::index_entry & e) { return e.timestamp >= timestamp; });
+        }
+
+        bool get_playback_frame_info(const device & device, double & timestamp, unsigned long long & frame_counter)
+        {
+            if (!device.current_frame) return false;
+            timestamp = device.current_frame->timestamp;
+            frame_counter = device.current_frame->frame_counter;
+            return true;
+        }
+
+        ////////////
+        // thread //
+        ////////////
+
+        std::thread start_backend_thread(std::function<void()> function)
+        {
+            return std::thread(function);
+        }
+
+        void set_thread_cpu_mask(std::thread & thread, uint64_t cpu_mask)
+        {
+            if (!cpu_mask) return;
+#ifdef __linux__
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) if (cpu_mask >> cpu & 1) CPU_SET(cpu, &cpus);
+            if (int status = pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus)) LOG_WARNING("pthread_setaffinity_np(...) returned " << strerror(status));
+#elif defined(_WIN32)
+            if (!SetThreadAffinityMask(thread.native_handle(), (DWORD_PTR)cpu_mask)) LOG_WARNING("SetThreadAffinityMask(...) returned " << GetLastError());
+#endif
+        }
+
+        /////////////
+        // context //
+        /////////////
+
+        std::shared_ptr<context> create_context()
+        {
+            auto ctx = std::make_shared<context>();
+#ifdef _WIN32
+            const char separator = ';';
+#else
+            const char separator = ':';
+#endif
+            auto split = [separator](const char * variable, std::vector<std::string> & entries)
+            {
+                auto value = getenv(variable);
+                std::string list = value ? value : "";
+                for (size_t begin = 0, end; begin < list.size(); begin = end + 1)
+                {
+                    end = list.find(separator, begin);
+                    if (end == std::string::npos) end = list.size();
+                    if (end > begin) entries.push_back(list.substr(begin, end - begin));
+                }
+            };
+            split("RS_PLAYBACK_FILES", ctx->paths);
+            split("RS_PLAYBACK_RINGS", ctx->rings);
+            if (ctx->paths.empty() && ctx->rings.empty()) LOG_WARNING("No recordings to replay, neither RS_PLAYBACK_FILES nor RS_PLAYBACK_RINGS is set");
+            return ctx;
+        }
+
+        std::vector<std::shared_ptr<device>> query_devices(std::shared_ptr<context> context)
+        {
+            std::vector<std::shared_ptr<device>> devices;
+            for (auto & path : context->paths) devices.push_back(std::make_shared<device>(context, path));
+            for (auto & name : context->rings)
+            {
+                // Rings which are not published yet contribute no devices, until they are
+                try { devices.push_back(std::make_shared<device>(context, std::make_shared<shared_ring::subscriber>(name), name)); }
+                catch (const std::exception & e) { LOG_WARNING("Ring " << name << " cannot be replayed: " << e.what()); }
+            }
+            return devices;
+        }
+
+        void set_devices_changed_callback(context & context, devices_changed_callback callback)
+        {
+            context.callback = callback;
+        }
+    }
+}
+
+#endif
@@ -21,22 +21,34 @@
 #include <utility> // for pair
 #include <chrono>
 #include <thread>
+#include <atomic>
 
 #include <dirent.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <limits.h>
 #include <errno.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
 #include <linux/usb/video.h>
 #include <linux/uvcvideo.h>
 #include <linux/videodev2.h>
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,11,0)
+#include <linux/dma-buf.h>
+#endif
 
 #pragma GCC diagnostic ignored "-Wpedantic"
 #include <libusb.h>
 #pragma GCC diagnostic pop
+#include "libusb-interrupts.h"
 
 #pragma GCC diagnostic ignored "-Woverflow"
 
@@ -51,6 +63,20 @@ namespace rsimpl
             throw std::runtime_error(ss.str());
         }
 
+        // Requests the driver or device refuse for good are reported as such, so they are not retried
+        static void throw_control_error(const char * s)
+        {
+            std::ostringstream ss;
+            ss << s << " error " << errno << ", " << strerror(errno);
+            switch(errno)
+            {
+            case EINVAL: case ERANGE: case ENOTTY: case ENOENT: case EACCES: case EPERM: case ENODEV:
+                throw control_rejected_error(ss.str());
+            default:
+                throw std::runtime_error(ss.str());
+            }
+        }
+
         static void warn_error(const char * s)
         {
             LOG_ERROR(s << " error " << errno << ", " << strerror(errno));
@@ -65,11 +91,232 @@ namespace rsimpl
             return r;
         }
 
-        struct buffer { void * start; size_t length; };
+        // Failing to raise the scheduling of a thread only costs latency, so it is reported and streaming goes on
+        static void set_thread_scheduling(pthread_t thread, uint64_t cpu_mask, int priority)
+        {
+            if(cpu_mask)
+            {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                for(int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) if(cpu_mask >> cpu & 1) CPU_SET(cpu, &cpus);
+                if(int status = pthread_setaffinity_np(thread, sizeof(cpus), &cpus)) LOG_WARNING("pthread_setaffinity_np(...) returned " << strerror(status));
+            }
+            if(priority)
+            {
+                sched_param param = {};
+                param.sched_priority = priority;
+                if(int status = pthread_setschedparam(thread, SCHED_FIFO, &param)) LOG_WARNING("pthread_setschedparam(SCHED_FIFO, " << priority << ") returned " << strerror(status) << ", SCHED_FIFO requires CAP_SYS_NICE");
+            }
+        }
+
+        const unsigned char motion_data_endpoint = 0x84;
+        const int motion_data_transfer_size = 0x400;
+
+        struct buffer { void * start; size_t length; int dmabuf_fd; }; // dmabuf_fd is -1 unless the driver captures into a dma-buf
+
+        struct buffer_set;
+
+        // The capture queue of a subdevice, whose buffers belong to the session which last requested them. Sessions outlive their subdevice
+        // and the sessions after them while frames hold them, so that one only releases the buffers of the driver while it still owns them.
+        struct driver_queue
+        {
+            std::mutex mutex;
+            int fd;                             // -1 once the subdevice is closed, guarded by mutex
+            const buffer_set * owner;           // Session the buffers of the driver were last requested for, guarded by mutex
+
+            explicit driver_queue(int fd) : fd(fd), owner(nullptr) {}
+        };
+
+        // The capture buffers of one session. Frames are handed out straight from them, so the session stays alive until the last frame
+        // is released, and only then are the buffers unmapped or given back to their allocator, and released by the driver
+        struct buffer_set
+        {
+            const std::shared_ptr<driver_queue> driver; // Only queued to while streaming, which the subdevice stops before closing it
+            const int fd;
+            const std::string dev_name;
+            const v4l2_memory memory;
+            const std::shared_ptr<rs_frame_allocator> allocator; // Owner of the buffers when capturing into user pointers
+            std::vector<buffer> buffers;
+            std::mutex mutex;
+            bool streaming;                 // Buffers released while not streaming wait for restart, guarded by mutex
+            std::vector<bool> held;         // Buffers handed out in frames not released yet, guarded by mutex
+
+            buffer_set(std::shared_ptr<driver_queue> driver, const std::string & dev_name, v4l2_memory memory, std::shared_ptr<rs_frame_allocator> allocator) : driver(driver), fd(driver->fd), dev_name(dev_name), memory(memory), allocator(allocator), streaming(false) {}
+            ~buffer_set()
+            {
+                for(auto & b : buffers)
+                {
+                    if(memory == V4L2_MEMORY_USERPTR) allocator->deallocate(b.start, b.length);
+                    else if(munmap(b.start, b.length) < 0) warn_error("munmap");
+                    if(b.dmabuf_fd >= 0 && close(b.dmabuf_fd) < 0) warn_error("close");
+                }
+
+                // Release the buffers of the driver, unless the subdevice was closed, its descriptor possibly reused, or another session started
+                std::lock_guard<std::mutex> lock(driver->mutex);
+                if(driver->owner != this || driver->fd < 0) return;
+                struct v4l2_requestbuffers req = {};
+                req.count = 0;
+                req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                req.memory = memory;
+                if(xioctl(driver->fd, VIDIOC_REQBUFS, &req) < 0) warn_error("VIDIOC_REQBUFS");
+                driver->owner = nullptr;
+            }
+
+            // Hands a buffer to the driver to be filled, returns false and leaves errno set on failure
+            bool queue(uint32_t index)
+            {
+                v4l2_buffer buf = {};
+                buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                buf.memory = memory;
+                buf.index = index;
+                if(memory == V4L2_MEMORY_USERPTR) buf.m.userptr = reinterpret_cast<unsigned long>(buffers[index].start);
+                if(memory == V4L2_MEMORY_DMABUF) buf.m.fd = buffers[index].dmabuf_fd;
+                if(memory != V4L2_MEMORY_MMAP) buf.length = buffers[index].length;
+                return xioctl(fd, VIDIOC_QBUF, &buf) == 0;
+            }
+
+            // Brackets the reads of a dma-buf through its mapping, so that they see what the device wrote even on platforms without coherent caches
+            void sync_cpu_access(uint32_t index, bool start)
+            {
+#ifdef DMA_BUF_IOCTL_SYNC
+                if(memory != V4L2_MEMORY_DMABUF) return;
+                dma_buf_sync sync = {};
+                sync.flags = (start ? DMA_BUF_SYNC_START : DMA_BUF_SYNC_END) | DMA_BUF_SYNC_READ;
+                if(xioctl(buffers[index].dmabuf_fd, DMA_BUF_IOCTL_SYNC, &sync) < 0) warn_error("DMA_BUF_IOCTL_SYNC");
+#endif
+            }
+
+            // Called when a filled buffer is handed to the callback
+            void hand_out(uint32_t index)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                held[index] = true;
+            }
+
+            // Called when the last reference to a frame is released, possibly from an application thread
+            void requeue(uint32_t index)
+            {
+                sync_cpu_access(index, false);
+                std::lock_guard<std::mutex> lock(mutex);
+                held[index] = false;
+                if(!streaming) return;
+                if(!queue(index)) warn_error("VIDIOC_QBUF");
+            }
+
+            // Queues every buffer no frame holds, the others being queued as their frames are released
+            void restart()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                held.resize(buffers.size());
+                for(size_t i = 0; i < buffers.size(); ++i)
+                {
+                    if(!held[i] && !queue(i)) throw_error("VIDIOC_QBUF");
+                }
+                streaming = true;
+            }
+
+            void stop()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                streaming = false;
+            }
+        };
+
+        // Listens to the uevents the kernel broadcasts, the ones udev itself is driven by, and reports every video4linux node added or removed
+        class hotplug_monitor
+        {
+            int uevent_fd, stop_fd;
+            std::thread thread;
+
+            void run(devices_changed_callback callback)
+            {
+                int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+                if(epoll_fd < 0) { warn_error("epoll_create1"); return; }
+                epoll_event uevent = {}, stop = {};
+                uevent.events = stop.events = EPOLLIN;
+                uevent.data.fd = uevent_fd;
+                stop.data.fd = stop_fd;
+                if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, uevent_fd, &uevent) < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &stop) < 0)
+                {
+                    warn_error("epoll_ctl");
+                    close(epoll_fd);
+                    return;
+                }
+
+                bool stopping = false;
+                while(!stopping)
+                {
+                    epoll_event events[2];
+                    const int count = epoll_wait(epoll_fd, events, 2, -1);
+                    if(count < 0)
+                    {
+                        if(errno == EINTR) continue;
+                        warn_error("epoll_wait");
+                        break;
+                    }
+                    for(int i = 0; i < count; ++i)
+                    {
+                        if(events[i].data.fd == stop_fd) stopping = true;
+                        else if(is_video_device_change()) callback();
+                    }
+                }
+                close(epoll_fd);
+            }
+
+            // A uevent is "ACTION@DEVPATH" followed by KEY=VALUE strings, each terminated by a null character
+            bool is_video_device_change()
+            {
+                char buffer[8192];
+                sockaddr_nl sender = {};
+                socklen_t sender_length = sizeof(sender);
+                const ssize_t length = recvfrom(uevent_fd, buffer, sizeof(buffer) - 1, 0, reinterpret_cast<sockaddr *>(&sender), &sender_length);
+                if(length <= 0 || sender.nl_pid != 0) return false; // Only messages from the kernel are trusted
+                buffer[length] = 0;
+
+                bool is_video = false, is_change = false;
+                for(const char * field = buffer; field < buffer + length; field += strlen(field) + 1)
+                {
+                    if(!strcmp(field, "SUBSYSTEM=video4linux")) is_video = true;
+                    if(!strcmp(field, "ACTION=add") || !strcmp(field, "ACTION=remove")) is_change = true;
+                }
+                return is_video && is_change;
+            }
+        public:
+            hotplug_monitor(devices_changed_callback callback) : uevent_fd(-1), stop_fd(-1)
+            {
+                uevent_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+                if(uevent_fd < 0) throw_error("socket(NETLINK_KOBJECT_UEVENT)");
+                sockaddr_nl address = {};
+                address.nl_family = AF_NETLINK;
+                address.nl_groups = 1; // The kernel's uevent multicast group
+                if(bind(uevent_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+                {
+                    close(uevent_fd);
+                    throw_error("bind(NETLINK_KOBJECT_UEVENT)");
+                }
+
+                stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+                if(stop_fd < 0)
+                {
+                    close(uevent_fd);
+                    throw_error("eventfd");
+                }
+                thread = std::thread([this, callback]() { run(callback); });
+            }
+            ~hotplug_monitor()
+            {
+                uint64_t one = 1;
+                if(write(stop_fd, &one, sizeof(one)) < 0) warn_error("write(stop_fd)");
+                thread.join();
+                close(stop_fd);
+                close(uevent_fd);
+            }
+        };
 
         struct context
         {
             libusb_context * usb_context;
+            std::unique_ptr<hotplug_monitor> monitor;
 
             context()
             {
@@ -78,6 +325,7 @@ namespace rsimpl
             }
             ~context()
             {
+                monitor.reset();
                 libusb_exit(usb_context);
             }
         };
@@ -88,14 +336,24 @@ namespace rsimpl
             int busnum, devnum, parent_devnum;     // USB device bus number and device number (needed for F200/SR300 direct USB controls)
             int vid, pid, mi;       // Vendor ID, product ID, and multiple interface index
             int fd;                 // File descriptor for this device
-            std::vector<buffer> buffers;
+            int buffer_count;       // Number of kernel buffers to request, frames held by the application keep theirs until released
+            capture_memory memory;  // Where the driver writes frames, see set_subdevice_capture_memory
+            std::shared_ptr<rs_frame_allocator> allocator;
+            std::vector<int> dmabuf_fds;
+            std::shared_ptr<driver_queue> driver; // Shared with the sessions, created once fd is open
+            std::shared_ptr<buffer_set> session;
 
             int width, height, format, fps;
+            v4l2_rect crop = {};    // Window of the default rectangle the driver delivers, a width of 0 for whole frames
+            bool cropped = false;   // The driver was left cropping by the last capture
+            size_t frame_size = 0;  // Bytes of a frame of the mode, those which arrive with fewer are counted as short
+            transfer_monitor monitor;
             video_channel_callback callback = nullptr;
             data_channel_callback  channel_data_callback = nullptr;    // handle non-uvc data produced by device
             bool is_capturing;
+            bool is_paused;         // Capturing, with the buffers kept but the stream off
 
-            subdevice(const std::string & name) : dev_name("/dev/" + name), vid(), pid(), fd(), width(), height(), format(), callback(nullptr), channel_data_callback(nullptr), is_capturing()
+            subdevice(const std::string & name) : dev_name("/dev/" + name), vid(), pid(), fd(), buffer_count(4), memory(capture_memory::mapped), width(), height(), format(), callback(nullptr), channel_data_callback(nullptr), is_capturing(), is_paused()
             {
                 struct stat st;
                 if(stat(dev_name.c_str(), &st) < 0)
@@ -144,6 +402,7 @@ namespace rsimpl
                     std::ostringstream ss; ss << "Cannot open '" << dev_name << "': " << errno << ", " << strerror(errno);
                     throw std::runtime_error(ss.str());
                 }
+                driver = std::make_shared<driver_queue>(fd);
 
                 v4l2_capability cap = {};
                 if(xioctl(fd, VIDIOC_QUERYCAP, &cap) < 0)
@@ -176,6 +435,10 @@ namespace rsimpl
             ~subdevice()
             {
                 stop_capture();
+                {
+                    std::lock_guard<std::mutex> lock(driver->mutex);
+                    driver->fd = -1;
+                }
                 if(close(fd) < 0) warn_error("close");
             }
 
@@ -186,24 +449,43 @@ namespace rsimpl
             void get_control(const extension_unit & xu, uint8_t control, void * data, size_t size)
             {
             uvc_xu_control_query q = {static_cast<uint8_t>(xu.unit), control, UVC_GET_CUR, static_cast<uint16_t>(size), reinterpret_cast<uint8_t *>(data)};
-                if(xioctl(fd, UVCIOC_CTRL_QUERY, &q) < 0) throw_error("UVCIOC_CTRL_QUERY:UVC_GET_CUR");
+                if(xioctl(fd, UVCIOC_CTRL_QUERY, &q) < 0) throw_control_error("UVCIOC_CTRL_QUERY:UVC_GET_CUR");
             }
 
             void set_control(const extension_unit & xu, uint8_t control, void * data, size_t size)
             {
             uvc_xu_control_query q = {static_cast<uint8_t>(xu.unit), control, UVC_SET_CUR, static_cast<uint16_t>(size), reinterpret_cast<uint8_t *>(data)};
-                if(xioctl(fd, UVCIOC_CTRL_QUERY, &q) < 0) throw_error("UVCIOC_CTRL_QUERY:UVC_SET_CUR");
+                if(xioctl(fd, UVCIOC_CTRL_QUERY, &q) < 0) throw_control_error("UVCIOC_CTRL_QUERY:UVC_SET_CUR");
             }
 
-            void set_format(int width, int height, int fourcc, int fps, video_channel_callback callback)
+            void set_format(int width, int height, int fourcc, int fps, size_t frame_size, video_channel_callback callback)
             {
                 this->width = width;
                 this->height = height;
                 this->format = fourcc;
                 this->fps = fps;
+                this->frame_size = frame_size;
                 this->callback = callback;
             }
 
+            bool set_crop(int x, int y, int width, int height)
+            {
+                crop = {};
+                if(!width) return true;
+
+                // The window is taken from the default rectangle, which is the whole frame, and must have square pixels to be delivered unscaled
+                v4l2_cropcap cropcap = {};
+                cropcap.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                if(xioctl(fd, VIDIOC_CROPCAP, &cropcap) < 0) return false;
+                if(static_cast<__u32>(x + width) > cropcap.defrect.width || static_cast<__u32>(y + height) > cropcap.defrect.height) return false;
+                if(cropcap.pixelaspect.numerator != cropcap.pixelaspect.denominator) return false;
+                crop.left = cropcap.defrect.left + x;
+                crop.top = cropcap.defrect.top + y;
+                crop.width = width;
+                crop.height = height;
+                return true;
+            }
+
             void set_data_channel_cfg(data_channel_callback callback)
             {                
                 this->channel_data_callback = callback;
@@ -213,14 +495,36 @@ namespace rsimpl
             {
                 if(!is_capturing)
                 {
+                    monitor.reset();
+
+                    // The window is set before the format, which takes its size, and read back, since drivers adjust windows they cannot crop to
+                    v4l2_crop window = {};
+                    window.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                    if(crop.width || cropped)
+                    {
+                        v4l2_cropcap cropcap = {};
+                        cropcap.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                        if(xioctl(fd, VIDIOC_CROPCAP, &cropcap) < 0) throw_error("VIDIOC_CROPCAP");
+                        window.c = crop.width ? crop : cropcap.defrect;
+                        if(xioctl(fd, VIDIOC_S_CROP, &window) < 0) throw_error("VIDIOC_S_CROP");
+                        cropped = crop.width != 0;
+                    }
+
                     v4l2_format fmt = {};
                     fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-                    fmt.fmt.pix.width       = width;
-                    fmt.fmt.pix.height      = height;
+                    fmt.fmt.pix.width       = crop.width ? crop.width : width;
+                    fmt.fmt.pix.height      = crop.width ? crop.height : height;
                     fmt.fmt.pix.pixelformat = format;
                     fmt.fmt.pix.field       = V4L2_FIELD_NONE;
                     if(xioctl(fd, VIDIOC_S_FMT, &fmt) < 0) throw_error("VIDIOC_S_FMT");
 
+                    if(crop.width)
+                    {
+                        if(xioctl(fd, VIDIOC_G_CROP, &window) < 0) throw_error("VIDIOC_G_CROP");
+                        if(window.c.left != crop.left || window.c.top != crop.top || window.c.width != crop.width || window.c.height != crop.height || fmt.fmt.pix.width != crop.width || fmt.fmt.pix.height != crop.height)
+                            throw std::runtime_error(to_string() << dev_name << " cropped to " << window.c.width << 'x' << window.c.height << " at " << window.c.left << ',' << window.c.top << " scaled to " << fmt.fmt.pix.width << 'x' << fmt.fmt.pix.height << " instead of the window requested");
+                    }
+
                     v4l2_streamparm parm = {};
                     parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
                     if(xioctl(fd, VIDIOC_G_PARM, &parm) < 0) throw_error("VIDIOC_G_PARM");
@@ -228,14 +532,20 @@ namespace rsimpl
                     parm.parm.capture.timeperframe.denominator = fps;
                     if(xioctl(fd, VIDIOC_S_PARM, &parm) < 0) throw_error("VIDIOC_S_PARM");
 
-                    // Init memory mapped IO
+                    const v4l2_memory v4l2_memory_type = memory == capture_memory::user_pointer ? V4L2_MEMORY_USERPTR : memory == capture_memory::dma_buffer ? V4L2_MEMORY_DMABUF : V4L2_MEMORY_MMAP;
+                    const char * memory_name = v4l2_memory_type == V4L2_MEMORY_USERPTR ? "user pointer" : v4l2_memory_type == V4L2_MEMORY_DMABUF ? "dma-buf" : "memory mapped";
+                    if(v4l2_memory_type == V4L2_MEMORY_DMABUF && dmabuf_fds.size() < 2) throw std::runtime_error("at least two dma-bufs are required for streaming from " + dev_name);
+
+                    // Init streaming IO. The buffers are requested for the new session under the lock of the queue, so that no session released
+                    // late by its frames gives them back.
+                    std::unique_lock<std::mutex> lock(driver->mutex);
                     v4l2_requestbuffers req = {};
-                    req.count = 4;
+                    req.count = v4l2_memory_type == V4L2_MEMORY_DMABUF ? dmabuf_fds.size() : buffer_count;
                     req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-                    req.memory = V4L2_MEMORY_MMAP;
+                    req.memory = v4l2_memory_type;
                     if(xioctl(fd, VIDIOC_REQBUFS, &req) < 0)
                     {
-                        if(errno == EINVAL) throw std::runtime_error(dev_name + " does not support memory mapping");
+                        if(errno == EINVAL) throw std::runtime_error(to_string() << dev_name << " does not support " << memory_name << " streaming");
                         else throw_error("VIDIOC_REQBUFS");
                     }
                     if(req.count < 2)
@@ -243,30 +553,60 @@ namespace rsimpl
                         throw std::runtime_error("Insufficient buffer memory on " + dev_name);
                     }
 
-                    buffers.resize(req.count);
-                    for(size_t i = 0; i < buffers.size(); ++i)
+                    auto new_session = std::make_shared<buffer_set>(driver, dev_name, v4l2_memory_type, allocator);
+                    driver->owner = new_session.get();
+                    lock.unlock();
+                    if(v4l2_memory_type == V4L2_MEMORY_MMAP)
                     {
-                        v4l2_buffer buf = {};
-                        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-                        buf.memory = V4L2_MEMORY_MMAP;
-                        buf.index = i;
-                        if(xioctl(fd, VIDIOC_QUERYBUF, &buf) < 0) throw_error("VIDIOC_QUERYBUF");
-
-                        buffers[i].length = buf.length;
-                        buffers[i].start = mmap(NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buf.m.offset);
-                        if(buffers[i].start == MAP_FAILED) throw_error("mmap");
+                        for(size_t i = 0; i < req.count; ++i)
+                        {
+                            v4l2_buffer buf = {};
+                            buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                            buf.memory = V4L2_MEMORY_MMAP;
+                            buf.index = i;
+                            if(xioctl(fd, VIDIOC_QUERYBUF, &buf) < 0) throw_error("VIDIOC_QUERYBUF");
+
+                            buffer b = { mmap(NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buf.m.offset), buf.length, -1 };
+                            if(b.start == MAP_FAILED) throw_error("mmap");
+                            new_session->buffers.push_back(b);
+                        }
                     }
-
-                    // Start capturing
-                    for(size_t i = 0; i < buffers.size(); ++i)
+                    else if(v4l2_memory_type == V4L2_MEMORY_USERPTR)
                     {
-                        v4l2_buffer buf = {};
-                        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-                        buf.memory = V4L2_MEMORY_MMAP;
-                        buf.index = i;
-                        if(xioctl(fd, VIDIOC_QBUF, &buf) < 0) throw_error("VIDIOC_QBUF");
+                        // The driver writes straight into the blocks of the allocator, which frames passed through unchanged are delivered in
+                        for(size_t i = 0; i < req.count; ++i)
+                        {
+                            buffer b = { allocator->allocate(fmt.fmt.pix.sizeimage), fmt.fmt.pix.sizeimage, -1 };
+                            if(!b.start) throw std::runtime_error(to_string() << "frame allocator failed to provide " << b.length << " bytes for " << dev_name);
+                            new_session->buffers.push_back(b);
+                        }
+                    }
+                    else
+                    {
+                        // The session keeps descriptors of its own, and maps every dma-buf for reading the frame headers and unpacking
+                        for(size_t i = 0; i < req.count && i < dmabuf_fds.size(); ++i)
+                        {
+                            const int dmabuf_fd = fcntl(dmabuf_fds[i], F_DUPFD_CLOEXEC, 0);
+                            if(dmabuf_fd < 0) throw_error("fcntl(F_DUPFD_CLOEXEC)");
+                            const off_t size = lseek(dmabuf_fd, 0, SEEK_END);
+                            if(size < static_cast<off_t>(fmt.fmt.pix.sizeimage))
+                            {
+                                close(dmabuf_fd);
+                                throw std::runtime_error(to_string() << "dma-buf " << i << " is smaller than the " << fmt.fmt.pix.sizeimage << " bytes of a frame from " << dev_name);
+                            }
+                            buffer b = { mmap(NULL, size, PROT_READ, MAP_SHARED, dmabuf_fd, 0), static_cast<size_t>(size), dmabuf_fd };
+                            if(b.start == MAP_FAILED)
+                            {
+                                close(dmabuf_fd);
+                                throw_error("mmap");
+                            }
+                            new_session->buffers.push_back(b);
+                        }
                     }
 
+                    // Start capturing
+                    new_session->restart();
+
                     v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
                     for(int i=0; i<10; ++i)
                     {
@@ -277,6 +617,7 @@ namespace rsimpl
                     }
                     if(xioctl(fd, VIDIOC_STREAMON, &type) < 0) throw_error("VIDIOC_STREAMON");
 
+                    session = new_session;
                     is_capturing = true;
                 }
             }
@@ -289,93 +630,109 @@ namespace rsimpl
                     v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
                     if(xioctl(fd, VIDIOC_STREAMOFF, &type) < 0) warn_error("VIDIOC_STREAMOFF");
 
-                    for(size_t i = 0; i < buffers.size(); i++)
-                    {
-                        if(munmap(buffers[i].start, buffers[i].length) < 0) warn_error("munmap");
-                    }
-
-                    // Close memory mapped IO
-                    struct v4l2_requestbuffers req = {};
-                    req.count = 0;
-                    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-                    req.memory = V4L2_MEMORY_MMAP;
-                    if(xioctl(fd, VIDIOC_REQBUFS, &req) < 0)
-                    {
-                        if(errno == EINVAL) LOG_ERROR(dev_name + " does not support memory mapping");
-                        else warn_error("VIDIOC_REQBUFS");
-                    }
+                    // Frames still held by the application keep the mappings alive, the buffers are unmapped with the last of them
+                    session->stop();
+                    session.reset();
 
                     callback = nullptr;
                     is_capturing = false;
+                    is_paused = false;
                 }
             }
 
-            static void poll(const std::vector<subdevice *> & subdevices)
+            // VIDIOC_STREAMOFF takes every buffer back from the driver, which keeps them allocated, and gives up the USB bandwidth of the stream
+            void pause_capture()
             {
-                int max_fd = 0;
-                fd_set fds;
-                FD_ZERO(&fds);
-                for(auto * sub : subdevices)
+                if(is_capturing && !is_paused)
                 {
-                    FD_SET(sub->fd, &fds);
-                    max_fd = std::max(max_fd, sub->fd);
+                    session->stop();
+                    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                    if(xioctl(fd, VIDIOC_STREAMOFF, &type) < 0) throw_error("VIDIOC_STREAMOFF");
+                    is_paused = true;
                 }
+            }
 
-                struct timeval tv = {0,10000};
-                if(select(max_fd + 1, &fds, NULL, NULL, &tv) < 0)
+            void resume_capture()
+            {
+                if(is_paused)
                 {
-                    if (errno == EINTR) return;
-                    throw_error("select");
+                    session->restart();
+                    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                    if(xioctl(fd, VIDIOC_STREAMON, &type) < 0) throw_error("VIDIOC_STREAMON");
+                    is_paused = false;
                 }
+            }
 
-                for(auto * sub : subdevices)
+            // Hands every filled buffer to the callback, until the driver has none left
+            void dequeue_frames()
+            {
+                while(true)
                 {
-                    if(FD_ISSET(sub->fd, &fds))
+                    v4l2_buffer buf = {};
+                    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+                    buf.memory = session->memory;
+                    if(xioctl(fd, VIDIOC_DQBUF, &buf) < 0)
                     {
-                        v4l2_buffer buf = {};
-                        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-                        buf.memory = V4L2_MEMORY_MMAP;
-                        if(xioctl(sub->fd, VIDIOC_DQBUF, &buf) < 0)
-                        {
-                            if(errno == EAGAIN) return;
-                            throw_error("VIDIOC_DQBUF");
-                        }
-
-                        sub->callback(sub->buffers[buf.index].start,
-                                [sub, buf]() mutable {
-                                    if(xioctl(sub->fd, VIDIOC_QBUF, &buf) < 0) throw_error("VIDIOC_QBUF");
-                                });
+                        if(errno == EAGAIN) return;
+                        monitor.on_error();
+                        throw_error("VIDIOC_DQBUF");
                     }
+
+                    // The driver flags the buffers whose transfer went wrong, which may still be delivered with the payload they got
+                    if(buf.flags & V4L2_BUF_FLAG_ERROR) monitor.on_error();
+                    monitor.on_frame(buf.bytesused, frame_size);
+
+                    auto session = this->session;
+                    const uint32_t index = buf.index;
+                    session->hand_out(index);
+                    session->sync_cpu_access(index, true);
+                    callback(session->buffers[index].start, std::min<size_t>(buf.bytesused, session->buffers[index].length),
+                            [session, index]() {
+                                session->requeue(index);
+                            });
                 }
-            }            
+            }
 
-            static void poll_interrupts(libusb_device_handle *handle, const std::vector<subdevice *> & subdevices, uint16_t timeout)
+            // Sleeps until the driver fills a buffer or stop_fd is signaled, without waking up in between
+            void capture(int stop_fd)
             {
-                static const unsigned short interrupt_buf_size = 0x400;
-                uint8_t buffer[interrupt_buf_size];                       /* 64 byte transfer buffer  - dedicated channel*/
-                int num_bytes             = 0;                           /* Actual bytes transferred. */
-
-                // TODO - replace hard-coded values : 0x82 and 1000
-                int res = libusb_interrupt_transfer(handle, 0x84, buffer, interrupt_buf_size, &num_bytes, timeout);
-                if (0 == res)
+                int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+                if(epoll_fd < 0) { warn_error("epoll_create1"); return; }
+                epoll_event video = {}, stop = {};
+                video.events = stop.events = EPOLLIN;
+                video.data.fd = fd;
+                stop.data.fd = stop_fd;
+                if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &video) < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &stop) < 0)
                 {
-                    // Propagate the data to device layer
-                    for(auto & sub : subdevices)
-                        if (sub->channel_data_callback)
-                            sub->channel_data_callback(buffer, num_bytes);
+                    warn_error("epoll_ctl");
+                    close(epoll_fd);
+                    return;
                 }
-                else
+
+                try
                 {
-                    switch (res)
+                    bool stopping = false;
+                    while(!stopping)
                     {
-                    case LIBUSB_ERROR_TIMEOUT :
-                        LOG_WARNING("interrupt e.p. timeout");
-                        break;
-                    default:
-                        throw std::runtime_error(to_string() << "USB Interrupt end-point error " << libusb_strerror((libusb_error)res));
-                        break;
+                        epoll_event events[2];
+                        const int count = epoll_wait(epoll_fd, events, 2, -1);
+                        if(count < 0)
+                        {
+                            if(errno == EINTR) continue;
+                            throw_error("epoll_wait");
+                        }
+                        for(int i = 0; i < count; ++i)
+                        {
+                            if(events[i].data.fd == stop_fd) stopping = true;
+                            else dequeue_frames();
+                        }
                     }
                 }
+                catch(const std::exception & e)
+                {
+                    LOG_ERROR("Capture from " << dev_name << " stopped: " << e.what());
+                }
+                close(epoll_fd);
             }
         };
 
@@ -383,16 +740,19 @@ namespace rsimpl
         {
             const std::shared_ptr<context> parent;
             std::vector<std::unique_ptr<subdevice>> subdevices;
-            std::thread thread;
+            std::vector<std::thread> capture_threads;   // One for every streaming subdevice
+            int stop_fd;                                // Event the capture threads wait on next to their frames
+            uint64_t capture_cpu_mask;
+            int capture_priority;
+            int control_retry_budget;
             std::thread data_channel_thread;
-            volatile bool stop;
             volatile bool data_stop;
 
             libusb_device * usb_device;
             libusb_device_handle * usb_handle;
             std::vector<int> claimed_interfaces;
 
-            device(std::shared_ptr<context> parent) : parent(parent), stop(), data_stop(), usb_device(), usb_handle() {}
+            device(std::shared_ptr<context> parent) : parent(parent), stop_fd(-1), capture_cpu_mask(), capture_priority(), control_retry_budget(RS_DEFAULT_CONTROL_RETRY_BUDGET), data_stop(), usb_device(), usb_handle() {}
             ~device()
             {
                 stop_streaming();
@@ -416,38 +776,84 @@ namespace rsimpl
                 return false;
             }
 
-            void start_streaming()
+            // Every subdevice is serviced by a thread of its own, so that a slow callback on one stream never delays another
+            void start_capture_threads()
             {
-                std::vector<subdevice *> subs;
+                stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+                if(stop_fd < 0) throw_error("eventfd");
 
                 for(auto & sub : subdevices)
                 {
-                    if(sub->callback)
+                    if(sub->is_capturing && !sub->is_paused)
                     {
-                        sub->start_capture();
-                        subs.push_back(sub.get());
-                    }                
+                        auto capturing = sub.get();
+                        auto stop_event = stop_fd;
+                        capture_threads.push_back(std::thread([capturing, stop_event]() { capturing->capture(stop_event); }));
+                        set_thread_scheduling(capture_threads.back().native_handle(), capture_cpu_mask, capture_priority);
+                    }
                 }
+            }
 
-                thread = std::thread([this, subs]()
+            void stop_capture_threads()
+            {
+                if(stop_fd < 0) return;
+
+                const uint64_t signal = 1;
+                if(write(stop_fd, &signal, sizeof(signal)) < 0) warn_error("write");
+                for(auto & thread : capture_threads) thread.join();
+                capture_threads.clear();
+                if(close(stop_fd) < 0) warn_error("close");
+                stop_fd = -1;
+            }
+
+            void start_streaming()
+            {
+                try
                 {
-                    while(!stop) subdevice::poll(subs);
-                });
+                    for(auto & sub : subdevices)
+                    {
+                        if(sub->callback) sub->start_capture();
+                    }
+                    start_capture_threads();
+                }
+                catch(...)
+                {
+                    stop_streaming();
+                    throw;
+                }
             }
 
             void stop_streaming()
             {
-                if(thread.joinable())
-                {
-                    stop = true;
-                    thread.join();
-                    stop = false;
+                stop_capture_threads();
+                for(auto & sub : subdevices) sub->stop_capture();
+            }
+
+            // A stream which is off no longer wakes its capture thread, which is stopped along with it. The threads of the other subdevices
+            // are restarted right away, their frames waiting in the driver meanwhile.
+            void pause_streaming(int subdevice_index)
+            {
+                stop_capture_threads();
+                for(int i = 0; i < (int)subdevices.size(); ++i) if(subdevice_index < 0 || i == subdevice_index) subdevices[i]->pause_capture();
+                if(subdevice_index >= 0) start_capture_threads();
+            }
 
-                    for(auto & sub : subdevices) sub->stop_capture();
-                }                
+            void resume_streaming(int subdevice_index)
+            {
+                try
+                {
+                    stop_capture_threads();
+                    for(int i = 0; i < (int)subdevices.size(); ++i) if(subdevice_index < 0 || i == subdevice_index) subdevices[i]->resume_capture();
+                    start_capture_threads();
+                }
+                catch(...)
+                {
+                    stop_streaming();
+                    throw;
+                }
             }
 
-            void start_data_acquisition()
+            void start_data_acquisition(int transfer_count)
             {
                 std::vector<subdevice *> data_channel_subs;
                 for (auto & sub : subdevices)
@@ -458,17 +864,17 @@ namespace rsimpl
                     }
                 }
                 
-                // Motion events polling pipe
+                // Motion events arrive on a ring of interrupt transfers, serviced by a thread of their own
                 if (claimed_interfaces.size())
                 {
-                    data_channel_thread = std::thread([this, data_channel_subs]()
+                    auto ring = std::make_shared<interrupt_transfer_ring>(usb_handle, motion_data_endpoint, motion_data_transfer_size, transfer_count, [data_channel_subs](const unsigned char * data, int size)
                     {
-                        // Polling 100ms timeout
-                        while (!data_stop)
-                        {
-                            subdevice::poll_interrupts(this->usb_handle, data_channel_subs, 100);
-                        }
+                        // Propagate the data to device layer
+                        for(auto & sub : data_channel_subs)
+                            if (sub->channel_data_callback)
+                                sub->channel_data_callback(data, size);
                     });
+                    data_channel_thread = std::thread([this, ring]() { ring->run(parent->usb_context, data_stop); });
                 }
             }
 
@@ -548,9 +954,25 @@ namespace rsimpl
             if(status < 0) throw std::runtime_error(to_string() << "libusb_interrupt_transfer(...) returned " << libusb_error_name(status));
         }
 
-        void set_subdevice_mode(device & device, int subdevice_index, int width, int height, uint32_t fourcc, int fps, video_channel_callback callback)
+        void set_subdevice_mode(device & device, int subdevice_index, int width, int height, uint32_t fourcc, int fps, size_t frame_size, video_channel_callback callback)
+        {
+            device.subdevices[subdevice_index]->set_format(width, height, (const big_endian<int> &)fourcc, fps, frame_size, callback);
+        }
+
+        bool set_subdevice_crop(device & device, int subdevice_index, int x, int y, int width, int height)
+        {
+            return device.subdevices[subdevice_index]->set_crop(x, y, width, height);
+        }
+
+        bool set_subdevice_slice_callback(device & device, int subdevice_index, int rows_per_slice, size_t row_bytes, video_slice_callback callback)
+        {
+            return !callback; // Frames are dequeued whole from the kernel
+        }
+
+        transfer_statistics get_subdevice_transfer_statistics(const device & device, int subdevice_index)
         {
-            device.subdevices[subdevice_index]->set_format(width, height, (const big_endian<int> &)fourcc, fps, callback);
+            if(subdevice_index < 0 || subdevice_index >= static_cast<int>(device.subdevices.size())) throw std::runtime_error(to_string() << "no subdevice " << subdevice_index);
+            return device.subdevices[subdevice_index]->monitor.get();
         }
 
         void set_subdevice_data_channel_handler(device & device, int subdevice_index, data_channel_callback callback)
@@ -558,6 +980,40 @@ namespace rsimpl
             device.subdevices[subdevice_index]->set_data_channel_cfg(callback);
         }
 
+        bool supports_zero_copy(const device & /*device*/)
+        {
+            return true;
+        }
+
+        void set_subdevice_buffer_count(device & device, int subdevice_index, int buffer_count)
+        {
+            if(buffer_count != 0 && (buffer_count < 2 || buffer_count > RS_MAX_CAPTURE_BUFFERS)) throw std::runtime_error(to_string() << "V4L2 streams with 2 to " << RS_MAX_CAPTURE_BUFFERS << " buffers");
+            device.subdevices[subdevice_index]->buffer_count = buffer_count ? buffer_count : 4;
+        }
+
+        void get_subdevice_buffer_count_range(const device & /*device*/, int & min, int & max)
+        {
+            min = 2;
+            max = RS_MAX_CAPTURE_BUFFERS; // VIDIOC_REQBUFS never grants more
+        }
+
+        void set_subdevice_capture_memory(device & device, int subdevice_index, capture_memory memory, std::shared_ptr<rs_frame_allocator> allocator, const std::vector<int> & dmabuf_fds)
+        {
+            auto & sub = *device.subdevices[subdevice_index];
+            sub.memory = memory;
+            sub.allocator = allocator;
+            sub.dmabuf_fds = dmabuf_fds;
+        }
+
+        void set_capture_thread_scheduling(device & device, uint64_t cpu_mask, int priority)
+        {
+            device.capture_cpu_mask = cpu_mask;
+            device.capture_priority = priority;
+        }
+
+        void set_control_retry_budget(device & device, int milliseconds) { device.control_retry_budget = milliseconds; }
+        int get_control_retry_budget(const device & device) { return device.control_retry_budget; }
+
         void start_streaming(device & device, int /*num_transfer_bufs*/)
         {
             device.start_streaming();
@@ -568,9 +1024,19 @@ namespace rsimpl
             device.stop_streaming();
         }       
 
-        void start_data_acquisition(device & device)
+        void pause_streaming(device & device, int subdevice_index)
         {
-            device.start_data_acquisition();
+            device.pause_streaming(subdevice_index);
+        }
+
+        void resume_streaming(device & device, int subdevice_index)
+        {
+            device.resume_streaming(subdevice_index);
+        }
+
+        void start_data_acquisition(device & device, int num_transfers)
+        {
+            device.start_data_acquisition(num_transfers);
         }
 
         void stop_data_acquisition(device & device)
@@ -595,7 +1061,7 @@ namespace rsimpl
             case RS_OPTION_COLOR_ENABLE_AUTO_EXPOSURE: return V4L2_CID_EXPOSURE_AUTO; // Automatic gain/exposure control
             case RS_OPTION_COLOR_ENABLE_AUTO_WHITE_BALANCE: return V4L2_CID_AUTO_WHITE_BALANCE;
             case RS_OPTION_FISHEYE_GAIN: return V4L2_CID_GAIN;
-            default: throw std::runtime_error(to_string() << "no v4l2 cid for option " << option);
+            default: throw control_rejected_error(to_string() << "no v4l2 cid for option " << option);
             }
         }
 
@@ -603,13 +1069,13 @@ namespace rsimpl
         {
             struct v4l2_control control = {get_cid(option), value};
             if (RS_OPTION_COLOR_ENABLE_AUTO_EXPOSURE==option) { control.value = value ? V4L2_EXPOSURE_APERTURE_PRIORITY : V4L2_EXPOSURE_MANUAL; }
-            if (xioctl(device.subdevices[subdevice]->fd, VIDIOC_S_CTRL, &control) < 0) throw_error("VIDIOC_S_CTRL");
+            if (xioctl(device.subdevices[subdevice]->fd, VIDIOC_S_CTRL, &control) < 0) throw_control_error("VIDIOC_S_CTRL");
         }
 
         int get_pu_control(const device & device, int subdevice, rs_option option)
         {
             struct v4l2_control control = {get_cid(option), 0};
-            if (xioctl(device.subdevices[subdevice]->fd, VIDIOC_G_CTRL, &control) < 0) throw_error("VIDIOC_G_CTRL");
+            if (xioctl(device.subdevices[subdevice]->fd, VIDIOC_G_CTRL, &control) < 0) throw_control_error("VIDIOC_G_CTRL");
             if (RS_OPTION_COLOR_ENABLE_AUTO_EXPOSURE==option)  { control.value = (V4L2_EXPOSURE_MANUAL==control.value) ? 0 : 1; }
             return control.value;
         }
@@ -712,6 +1178,28 @@ namespace rsimpl
             return std::make_shared<context>();
         }
 
+        std::thread start_backend_thread(std::function<void()> function)
+        {
+            return std::thread(function);
+        }
+
+        void set_thread_cpu_mask(std::thread & thread, uint64_t cpu_mask)
+        {
+            set_thread_scheduling(thread.native_handle(), cpu_mask, 0);
+        }
+
+        void set_devices_changed_callback(context & context, devices_changed_callback callback)
+        {
+            context.monitor.reset();
+            if(callback) context.monitor.reset(new hotplug_monitor(callback));
+        }
+
+        std::string get_device_instance_id(const device & device)
+        {
+            // The kernel numbers a device anew each time it is attached
+            return to_string() << device.subdevices[0]->busnum << '-' << device.subdevices[0]->devnum;
+        }
+
         bool is_device_connected(device & device, int vid, int pid)
         {
             for (auto& sub : device.subdevices)
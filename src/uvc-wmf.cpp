@@ -11,6 +11,7 @@
 #endif
 
 #include <windows.h>
+#include <dbt.h>
 #include <usbioctl.h>
 #include <sstream>
 
@@ -46,6 +47,9 @@
 
 #include <functional>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
 #include <chrono>
 #include <algorithm>
 #include <regex>
@@ -57,6 +61,8 @@ DEFINE_GUID(GUID_DEVINTERFACE_USB_DEVICE, 0xA5DCBF10L, 0x6530, 0x11D2, 0x90, 0x1
     0xC0, 0x4F, 0xB9, 0x51, 0xED);
 DEFINE_GUID(GUID_DEVINTERFACE_IMAGE, 0x6bdd1fc6L, 0x810f, 0x11d0, 0xbe, 0xc7, 0x08, 0x00, \
     0x2b, 0xe2, 0x09, 0x2f);
+DEFINE_GUID(GUID_DEVINTERFACE_VIDEO_CAMERA, 0xe5323777L, 0xf976, 0x4f5b, 0x9b, 0x55, 0xb9, 0x46, \
+    0x99, 0xc4, 0x6e, 0x44); // KSCATEGORY_VIDEO_CAMERA, registered by camera drivers from Windows 10 on
 
 namespace rsimpl
 {
@@ -85,6 +91,18 @@ namespace rsimpl
             if(FAILED(hr)) throw std::runtime_error(to_string() << call << "(...) returned 0x" << std::hex << (uint32_t)hr);
         }
 
+        // Requests the driver or device refuse for good are reported as such, so they are not retried
+        static void check_control(const char * call, HRESULT hr)
+        {
+            if(SUCCEEDED(hr)) return;
+            std::string message = to_string() << call << "(...) returned 0x" << std::hex << (uint32_t)hr;
+            const HRESULT rejections[] = {E_INVALIDARG, E_NOTIMPL, E_ACCESSDENIED, MF_E_VIDEO_RECORDING_DEVICE_INVALIDATED,
+                HRESULT_FROM_WIN32(ERROR_NOT_FOUND), HRESULT_FROM_WIN32(ERROR_SET_NOT_FOUND), HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED),
+                HRESULT_FROM_WIN32(ERROR_INVALID_PARAMETER), HRESULT_FROM_WIN32(ERROR_DEVICE_NOT_CONNECTED)};
+            if(std::find(std::begin(rejections), std::end(rejections), hr) != std::end(rejections)) throw control_rejected_error(message);
+            throw std::runtime_error(message);
+        }
+
         template<class T> class com_ptr
         {
             T * p;
@@ -214,16 +232,94 @@ namespace rsimpl
         }
 
 
+        // Receives the notifications Windows sends as capture devices arrive and leave, in a message-only window pumped by a thread of its own
+        class hotplug_monitor
+        {
+            devices_changed_callback callback;
+            HWND window;
+            std::thread thread;
+
+            static LRESULT CALLBACK window_proc(HWND window, UINT message, WPARAM wparam, LPARAM lparam)
+            {
+                switch(message)
+                {
+                case WM_DEVICECHANGE:
+                    if(wparam == DBT_DEVICEARRIVAL || wparam == DBT_DEVICEREMOVECOMPLETE)
+                    {
+                        if(auto monitor = reinterpret_cast<hotplug_monitor *>(GetWindowLongPtr(window, GWLP_USERDATA))) monitor->callback();
+                    }
+                    return TRUE;
+                case WM_CLOSE: DestroyWindow(window); return 0;
+                case WM_DESTROY: PostQuitMessage(0); return 0;
+                default: return DefWindowProc(window, message, wparam, lparam);
+                }
+            }
+
+            void run(std::promise<HWND> & created)
+            {
+                WNDCLASS window_class = {};
+                window_class.lpfnWndProc = &hotplug_monitor::window_proc;
+                window_class.hInstance = GetModuleHandle(nullptr);
+                window_class.lpszClassName = TEXT("librealsense_hotplug_monitor");
+                RegisterClass(&window_class); // Fails harmlessly when a previous monitor registered it
+
+                HWND hwnd = CreateWindow(window_class.lpszClassName, nullptr, 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, window_class.hInstance, nullptr);
+                if(!hwnd)
+                {
+                    created.set_exception(std::make_exception_ptr(std::runtime_error(to_string() << "CreateWindow(HWND_MESSAGE) returned error " << GetLastError())));
+                    return;
+                }
+                SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+
+                DEV_BROADCAST_DEVICEINTERFACE filter = {};
+                filter.dbcc_size = sizeof(filter);
+                filter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
+                filter.dbcc_classguid = KSCATEGORY_CAPTURE;
+                HDEVNOTIFY notification = RegisterDeviceNotification(hwnd, &filter, DEVICE_NOTIFY_WINDOW_HANDLE);
+                if(!notification)
+                {
+                    auto error = GetLastError();
+                    DestroyWindow(hwnd);
+                    created.set_exception(std::make_exception_ptr(std::runtime_error(to_string() << "RegisterDeviceNotification(...) returned error " << error)));
+                    return;
+                }
+                created.set_value(hwnd);
+
+                MSG message;
+                while(GetMessage(&message, nullptr, 0, 0) > 0) DispatchMessage(&message);
+                UnregisterDeviceNotification(notification);
+            }
+        public:
+            hotplug_monitor(devices_changed_callback callback) : callback(callback), window()
+            {
+                std::promise<HWND> created;
+                thread = std::thread([this, &created]() { run(created); });
+                try { window = created.get_future().get(); }
+                catch(...)
+                {
+                    thread.join();
+                    throw;
+                }
+            }
+            ~hotplug_monitor()
+            {
+                PostMessage(window, WM_CLOSE, 0, 0);
+                thread.join();
+            }
+        };
+
         struct context
         {
+            std::unique_ptr<hotplug_monitor> monitor;
+
             context()
             {
                 CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
                 MFStartup(MF_VERSION, MFSTARTUP_NOSOCKET);
             }
             ~context()
             {   
+                monitor.reset();
                 MFShutdown();
                 CoUninitialize();
             }
@@ -234,12 +330,27 @@ namespace rsimpl
             std::weak_ptr<device> owner; // The device holds a reference to us, so use weak_ptr to prevent a cycle
             int subdevice_index;
             ULONG ref_count;
-            volatile bool streaming = false;
+            std::mutex mutex;
+            std::condition_variable stopped;
+            bool streaming = false;
+
+            void set_streaming(bool value)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                streaming = value;
+                if(!streaming) stopped.notify_all();
+            }
         public:
             reader_callback(std::weak_ptr<device> owner, int subdevice_index) : owner(owner), subdevice_index(subdevice_index), ref_count() {}
 
-            bool is_streaming() const { return streaming; }
-            void on_start() { streaming = true; }
+            void on_start() { set_streaming(true); }
+
+            // Sleeps until the flush completes, or until a failed ReadSample ends the stream
+            void wait_until_stopped()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                stopped.wait(lock, [this]() { return !streaming; });
+            }
 
 #pragma warning( push )
 #pragma warning( disable: 4838 )
@@ -261,14 +372,15 @@ namespace rsimpl
 
             // Implement IMFSourceReaderCallback
             HRESULT STDMETHODCALLTYPE OnReadSample(HRESULT hrStatus, DWORD dwStreamIndex, DWORD dwStreamFlags, LONGLONG llTimestamp, IMFSample * sample) override;
-            HRESULT STDMETHODCALLTYPE OnFlush(DWORD dwStreamIndex) override { streaming = false; return S_OK; }
+            HRESULT STDMETHODCALLTYPE OnFlush(DWORD dwStreamIndex) override { set_streaming(false); return S_OK; }
             HRESULT STDMETHODCALLTYPE OnEvent(DWORD dwStreamIndex, IMFMediaEvent *pEvent) override { return S_OK; }
         };
 
         struct subdevice
         {
             com_ptr<reader_callback> reader_callback;
-            com_ptr<IMFActivate> mf_activate;
+            com_ptr<IMFActivate> mf_activate;     // Set when enumerated through Media Foundation, otherwise the source is made from the symbolic link
+            std::wstring symbolic_link;
             com_ptr<IMFMediaSource> mf_media_source;
             com_ptr<IAMCameraControl> am_camera_control;
             com_ptr<IAMVideoProcAmp> am_video_proc_amp;
@@ -277,6 +389,8 @@ namespace rsimpl
             video_channel_callback callback = nullptr;
             data_channel_callback  channel_data_callback = nullptr;
             int vid, pid;
+            size_t frame_size = 0;  // Bytes of a frame of the mode, those which arrive with fewer are counted as short
+            std::shared_ptr<transfer_monitor> monitor = std::make_shared<transfer_monitor>();
 
             void set_data_channel_cfg(data_channel_callback callback)
             {
@@ -287,7 +401,15 @@ namespace rsimpl
             {
                 if(!mf_media_source)
                 {
-                    check("IMFActivate::ActivateObject", mf_activate->ActivateObject(__uuidof(IMFMediaSource), (void **)&mf_media_source));
+                    if(mf_activate) check("IMFActivate::ActivateObject", mf_activate->ActivateObject(__uuidof(IMFMediaSource), (void **)&mf_media_source));
+                    else
+                    {
+                        com_ptr<IMFAttributes> attributes;
+                        check("MFCreateAttributes", MFCreateAttributes(&attributes, 2));
+                        check("IMFAttributes::SetGUID", attributes->SetGUID(MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE, MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE_VIDCAP_GUID));
+                        check("IMFAttributes::SetString", attributes->SetString(MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE_VIDCAP_SYMBOLIC_LINK, symbolic_link.c_str()));
+                        check("MFCreateDeviceSource", MFCreateDeviceSource(attributes, &mf_media_source));
+                    }
                     if (mf_media_source)
                     {
                         check("IMFMediaSource::QueryInterface", mf_media_source->QueryInterface(__uuidof(IAMCameraControl), (void **)&am_camera_control));
@@ -459,8 +581,9 @@ namespace rsimpl
             std::string aux_unique_id;
             std::thread data_channel_thread;
             volatile bool data_stop;
+            int control_retry_budget;
 
-            device(std::shared_ptr<context> parent, int vid, int pid, std::string unique_id) : parent(move(parent)), vid(vid), pid(pid), unique_id(move(unique_id)), aux_pid(0), aux_vid(0), data_stop(false)
+            device(std::shared_ptr<context> parent, int vid, int pid, std::string unique_id) : parent(move(parent)), vid(vid), pid(pid), unique_id(move(unique_id)), aux_pid(0), aux_vid(0), data_stop(false), control_retry_budget(RS_DEFAULT_CONTROL_RETRY_BUDGET)
             {
             }
 
@@ -505,11 +628,12 @@ namespace rsimpl
                 }
             }
 
-            void start_streaming()
+            void start_streaming(int subdevice_index = -1)
             {
-                for(auto & sub : subdevices)
+                for(int i = 0; i < (int)subdevices.size(); ++i)
                 {
-                    if(sub.mf_source_reader)
+                    auto & sub = subdevices[i];
+                    if(sub.mf_source_reader && (subdevice_index < 0 || i == subdevice_index))
                     {
                         sub.reader_callback->on_start();
                         check("IMFSourceReader::ReadSample", sub.mf_source_reader->ReadSample(MF_SOURCE_READER_FIRST_VIDEO_STREAM, 0, NULL, NULL, NULL, NULL));                    
@@ -517,21 +641,21 @@ namespace rsimpl
                 }
             }
 
-            void stop_streaming()
+            // The source readers keep their media types, and no further sample is read until start_streaming
+            void pause_streaming(int subdevice_index = -1)
             {
-                for(auto & sub : subdevices)
+                for(int i = 0; i < (int)subdevices.size(); ++i)
                 {
-                    if(sub.mf_source_reader) sub.mf_source_reader->Flush(MF_SOURCE_READER_FIRST_VIDEO_STREAM);
-                }
-                while(true)
-                {
-                    bool is_streaming = false;
-                    for(auto & sub : subdevices) is_streaming |= sub.reader_callback->is_streaming();                   
-                    if(is_streaming) std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                    else break;
+                    if(subdevices[i].mf_source_reader && (subdevice_index < 0 || i == subdevice_index)) subdevices[i].mf_source_reader->Flush(MF_SOURCE_READER_FIRST_VIDEO_STREAM);
                 }
+                for(int i = 0; i < (int)subdevices.size(); ++i) if(subdevice_index < 0 || i == subdevice_index) subdevices[i].reader_callback->wait_until_stopped();
+            }
+
+            void stop_streaming()
+            {
+                pause_streaming();
 
-                // Free up our source readers, our KS control nodes, and our media sources, but retain our original IMFActivate objects for later reuse
+                // Free up our source readers, our KS control nodes, and our media sources, but retain our original IMFActivate objects or symbolic links for later reuse
                 for(auto & sub : subdevices)
                 {
                     sub.mf_source_reader = nullptr;
@@ -540,8 +664,17 @@ namespace rsimpl
                     sub.ks_controls.clear();
                     if(sub.mf_media_source)
                     {
-                        sub.mf_media_source = nullptr;
-                        check("IMFActivate::ShutdownObject", sub.mf_activate->ShutdownObject());
+                        if(sub.mf_activate)
+                        {
+                            sub.mf_media_source = nullptr;
+                            check("IMFActivate::ShutdownObject", sub.mf_activate->ShutdownObject());
+                        }
+                        else
+                        {
+                            auto source = sub.mf_media_source;
+                            sub.mf_media_source = nullptr;
+                            check("IMFMediaSource::Shutdown", source->Shutdown());
+                        }
                     }
                     sub.callback = {};
                 }
@@ -686,6 +819,8 @@ namespace rsimpl
         {
             if(auto owner_ptr = owner.lock())
             {
+                auto & monitor = *owner_ptr->subdevices[subdevice_index].monitor;
+                if(FAILED(hrStatus) || (dwStreamFlags & MF_SOURCE_READERF_ERROR)) monitor.on_error();
                 if(sample)
                 {
                     com_ptr<IMFMediaBuffer> buffer = NULL;
@@ -694,12 +829,15 @@ namespace rsimpl
                         BYTE * byte_buffer; DWORD max_length, current_length;
                         if(SUCCEEDED(buffer->Lock(&byte_buffer, &max_length, &current_length)))
                         {
-                            auto continuation = [buffer, this]()
+                            monitor.on_frame(current_length, owner_ptr->subdevices[subdevice_index].frame_size);
+
+                            // The sample stays in our hands, without a copy, until the frame is released
+                            auto continuation = [buffer]()
                             {
                                 buffer->Unlock();
                             };
 
-                            owner_ptr->subdevices[subdevice_index].callback(byte_buffer, continuation);
+                            owner_ptr->subdevices[subdevice_index].callback(byte_buffer, current_length, continuation);
                         }
                     }
                 }
@@ -717,7 +855,11 @@ namespace rsimpl
                     case MF_E_VIDEO_RECORDING_DEVICE_INVALIDATED: LOG_ERROR("ReadSample returned MF_E_VIDEO_RECORDING_DEVICE_INVALIDATED"); break;
                     default: LOG_ERROR("ReadSample returned HRESULT " << std::hex << (uint32_t)hr); break;
                     }
-                    if (hr != S_OK) streaming = false;
+                    if (hr != S_OK)
+                    {
+                        owner_ptr_new->subdevices[subdevice_index].monitor->on_error();
+                        set_streaming(false);
+                    }
                 }
             }
             return S_OK; 
@@ -742,7 +884,7 @@ namespace rsimpl
             node.NodeId = xu.node;
 
             ULONG bytes_received = 0;
-            check("IKsControl::KsProperty", ks_control->KsProperty((PKSPROPERTY)&node, sizeof(node), data, len, &bytes_received));
+            check_control("IKsControl::KsProperty", ks_control->KsProperty((PKSPROPERTY)&node, sizeof(node), data, len, &bytes_received));
             if(bytes_received != len) throw std::runtime_error("XU read did not return enough data");
         }
 
@@ -758,7 +900,7 @@ namespace rsimpl
             node.NodeId = xu.node;
                 
             ULONG bytes_received = 0;
-            check("IKsControl::KsProperty", ks_control->KsProperty((PKSPROPERTY)&node, sizeof(KSP_NODE), data, len, &bytes_received));
+            check_control("IKsControl::KsProperty", ks_control->KsProperty((PKSPROPERTY)&node, sizeof(KSP_NODE), data, len, &bytes_received));
         }
 
         void claim_interface(device & device, const guid & interface_guid, int interface_number)
@@ -786,7 +928,7 @@ namespace rsimpl
             }
         }
 
-        void set_subdevice_mode(device & device, int subdevice_index, int width, int height, uint32_t fourcc, int fps, video_channel_callback callback)
+        void set_subdevice_mode(device & device, int subdevice_index, int width, int height, uint32_t fourcc, int fps, size_t frame_size, video_channel_callback callback)
         {
             auto & sub = device.subdevices[subdevice_index];
             
@@ -819,22 +961,78 @@ namespace rsimpl
                 if(std::abs(fps - uvc_fps) > 1) continue;
 
                 check("IMFSourceReader::SetCurrentMediaType", sub.mf_source_reader->SetCurrentMediaType((DWORD)MF_SOURCE_READER_FIRST_VIDEO_STREAM, NULL, media_type));
+                sub.frame_size = frame_size;
                 sub.callback = callback;
                 return;
             }
             throw std::runtime_error(to_string() << "no matching media type for  pixel format " << std::hex << fourcc);
         }
 
+        bool set_subdevice_crop(device & device, int subdevice_index, int x, int y, int width, int height)
+        {
+            return width == 0; // Media Foundation delivers whole frames of a media type
+        }
+
+        bool set_subdevice_slice_callback(device & device, int subdevice_index, int rows_per_slice, size_t row_bytes, video_slice_callback callback)
+        {
+            return !callback; // Media Foundation delivers whole samples
+        }
+
         void set_subdevice_data_channel_handler(device & device, int subdevice_index, data_channel_callback callback)
         {           
             device.subdevices[subdevice_index].set_data_channel_cfg(callback);
         }
 
-        void start_streaming(device & device, int num_transfer_bufs) { device.start_streaming(); }
+        bool supports_zero_copy(const device & /*device*/)
+        {
+            return true; // Each sample keeps its media buffer locked until the continuation unlocks it
+        }
+
+        void set_subdevice_buffer_count(device & /*device*/, int /*subdevice_index*/, int buffer_count)
+        {
+            // Media Foundation manages its own sample pool
+            if(buffer_count != 0) throw std::runtime_error("Media Foundation does not allow changing the number of capture buffers");
+        }
+
+        void get_subdevice_buffer_count_range(const device & /*device*/, int & min, int & max)
+        {
+            min = max = 0;
+        }
+
+        void set_subdevice_capture_memory(device & /*device*/, int /*subdevice_index*/, capture_memory memory, std::shared_ptr<rs_frame_allocator> /*allocator*/, const std::vector<int> & /*dmabuf_fds*/)
+        {
+            if(memory != capture_memory::mapped) throw std::runtime_error("Media Foundation captures only into its own sample pool, user pointer and dma-buf capture require the V4L2 backend");
+        }
+
+        void set_capture_thread_scheduling(device & /*device*/, uint64_t cpu_mask, int priority)
+        {
+            // Samples arrive on the work queues of Media Foundation, which are shared with the rest of the process
+            if(cpu_mask || priority) LOG_WARNING("Capture thread scheduling is not supported by the Media Foundation backend");
+        }
+
+        void set_control_retry_budget(device & device, int milliseconds) { device.control_retry_budget = milliseconds; }
+        int get_control_retry_budget(const device & device) { return device.control_retry_budget; }
+
+        void start_streaming(device & device, int num_transfer_bufs)
+        {
+            for(auto & sub : device.subdevices) sub.monitor->reset();
+            device.start_streaming();
+        }
         void stop_streaming(device & device) { device.stop_streaming(); }
 
-        void start_data_acquisition(device & device)
+        // The media sources keep running, so the USB bandwidth of the streams stays reserved while paused
+        void pause_streaming(device & device, int subdevice_index) { device.pause_streaming(subdevice_index); }
+        void resume_streaming(device & device, int subdevice_index) { device.start_streaming(subdevice_index); }
+
+        transfer_statistics get_subdevice_transfer_statistics(const device & device, int subdevice_index)
+        {
+            if(subdevice_index < 0 || subdevice_index >= static_cast<int>(device.subdevices.size())) throw std::runtime_error(to_string() << "no subdevice " << subdevice_index);
+            return device.subdevices[subdevice_index].monitor->get();
+        }
+
+        void start_data_acquisition(device & device, int /*num_transfers*/)
         {
+            // WinUSB reads of the motion data endpoint are issued one at a time
             device.start_data_acquisition();
         }
 
@@ -864,17 +1062,17 @@ namespace rsimpl
             sub.get_media_source();
             if (option == RS_OPTION_COLOR_EXPOSURE)
             {
-                check("IAMCameraControl::Set", sub.am_camera_control->Set(CameraControl_Exposure, static_cast<int>(value), CameraControl_Flags_Manual));
+                check_control("IAMCameraControl::Set", sub.am_camera_control->Set(CameraControl_Exposure, static_cast<int>(value), CameraControl_Flags_Manual));
                 return;
             }
             if(option == RS_OPTION_COLOR_ENABLE_AUTO_EXPOSURE)
             {
-                if(value) check("IAMCameraControl::Set", sub.am_camera_control->Set(CameraControl_Exposure, 0, CameraControl_Flags_Auto));
+                if(value) check_control("IAMCameraControl::Set", sub.am_camera_control->Set(CameraControl_Exposure, 0, CameraControl_Flags_Auto));
                 else
                 {
                     long min, max, step, def, caps;
-                    check("IAMCameraControl::GetRange", sub.am_camera_control->GetRange(CameraControl_Exposure, &min, &max, &step, &def, &caps));
-                    check("IAMCameraControl::Set", sub.am_camera_control->Set(CameraControl_Exposure, def, CameraControl_Flags_Manual));
+                    check_control("IAMCameraControl::GetRange", sub.am_camera_control->GetRange(CameraControl_Exposure, &min, &max, &step, &def, &caps));
+                    check_control("IAMCameraControl::Set", sub.am_camera_control->Set(CameraControl_Exposure, def, CameraControl_Flags_Manual));
                 }
                 return;
             }
@@ -884,19 +1082,19 @@ namespace rsimpl
                 {
                     if(pu.enable_auto)
                     {
-                        if(value) check("IAMVideoProcAmp::Set", sub.am_video_proc_amp->Set(pu.property, 0, VideoProcAmp_Flags_Auto));
+                        if(value) check_control("IAMVideoProcAmp::Set", sub.am_video_proc_amp->Set(pu.property, 0, VideoProcAmp_Flags_Auto));
                         else
                         {
                             long min, max, step, def, caps;
-                            check("IAMVideoProcAmp::GetRange", sub.am_video_proc_amp->GetRange(pu.property, &min, &max, &step, &def, &caps));
-                            check("IAMVideoProcAmp::Set", sub.am_video_proc_amp->Set(pu.property, def, VideoProcAmp_Flags_Manual));    
+                            check_control("IAMVideoProcAmp::GetRange", sub.am_video_proc_amp->GetRange(pu.property, &min, &max, &step, &def, &caps));
+                            check_control("IAMVideoProcAmp::Set", sub.am_video_proc_amp->Set(pu.property, def, VideoProcAmp_Flags_Manual));    
                         }
                     }
-                    else check("IAMVideoProcAmp::Set", sub.am_video_proc_amp->Set(pu.property, value, VideoProcAmp_Flags_Manual));
+                    else check_control("IAMVideoProcAmp::Set", sub.am_video_proc_amp->Set(pu.property, value, VideoProcAmp_Flags_Manual));
                     return;
                 }
             }
-            throw std::runtime_error("unsupported control");
+            throw control_rejected_error("unsupported control");
         }
 
         void get_pu_control_range(const device & device, int subdevice, rs_option option, int * min, int * max, int * step, int * def)
@@ -1021,24 +1219,24 @@ namespace rsimpl
             if (option == RS_OPTION_COLOR_EXPOSURE)
             {
                 // am_camera_control != null, because get_media_source was called at least once
-                check("IAMCameraControl::Get", sub.am_camera_control->Get(CameraControl_Exposure, &value, &flags));
+                check_control("IAMCameraControl::Get", sub.am_camera_control->Get(CameraControl_Exposure, &value, &flags));
                 return value;
             }
             if(option == RS_OPTION_COLOR_ENABLE_AUTO_EXPOSURE)
             {
-                check("IAMCameraControl::Get", sub.am_camera_control->Get(CameraControl_Exposure, &value, &flags));
+                check_control("IAMCameraControl::Get", sub.am_camera_control->Get(CameraControl_Exposure, &value, &flags));
                 return flags == CameraControl_Flags_Auto;          
             }
             for(auto & pu : pu_controls)
             {
                 if(option == pu.option)
                 {
-                    check("IAMVideoProcAmp::Get", sub.am_video_proc_amp->Get(pu.property, &value, &flags));
+                    check_control("IAMVideoProcAmp::Get", sub.am_video_proc_amp->Get(pu.property, &value, &flags));
                     if(pu.enable_auto) return flags == VideoProcAmp_Flags_Auto;
                     else return value;
                 }
             }
-            throw std::runtime_error("unsupported control");
+            throw control_rejected_error("unsupported control");
         }
 
         /////////////
@@ -1050,6 +1248,37 @@ namespace rsimpl
             return std::make_shared<context>();
         }
 
+        std::thread start_backend_thread(std::function<void()> function)
+        {
+            return std::thread([function]()
+            {
+                CoInitializeEx(NULL, COINIT_MULTITHREADED);
+                try { function(); }
+                catch(...)
+                {
+                    CoUninitialize();
+                    throw;
+                }
+                CoUninitialize();
+            });
+        }
+
+        void set_thread_cpu_mask(std::thread & thread, uint64_t cpu_mask)
+        {
+            if(cpu_mask && !SetThreadAffinityMask(thread.native_handle(), (DWORD_PTR)cpu_mask)) LOG_WARNING("SetThreadAffinityMask(...) returned " << GetLastError());
+        }
+
+        void set_devices_changed_callback(context & context, devices_changed_callback callback)
+        {
+            context.monitor.reset();
+            if(callback) context.monitor.reset(new hotplug_monitor(callback));
+        }
+
+        std::string get_device_instance_id(const device & device)
+        {
+            return device.unique_id;
+        }
+
         bool is_device_connected(device & device, int vid, int pid)
         {
             for(auto& dev : device.subdevices)
@@ -1061,17 +1290,74 @@ namespace rsimpl
             return false;
         }
 
+        // The symbolic links of the camera interfaces present, read from the configuration manager without creating any media source. Empty
+        // before Windows 10, whose camera drivers do not register KSCATEGORY_VIDEO_CAMERA.
+        static std::vector<std::wstring> query_camera_interfaces()
+        {
+            std::vector<std::wstring> links;
+            std::vector<WCHAR> list;
+            CONFIGRET result;
+            do
+            {
+                // The list can grow between the two calls, as devices arrive
+                ULONG size = 0;
+                if(CM_Get_Device_Interface_List_Size(&size, (LPGUID)&GUID_DEVINTERFACE_VIDEO_CAMERA, nullptr, CM_GET_DEVICE_INTERFACE_LIST_PRESENT) != CR_SUCCESS || size <= 1) return links;
+                list.resize(size);
+                result = CM_Get_Device_Interface_List((LPGUID)&GUID_DEVINTERFACE_VIDEO_CAMERA, nullptr, list.data(), size, CM_GET_DEVICE_INTERFACE_LIST_PRESENT);
+            } while(result == CR_BUFFER_SMALL);
+            if(result != CR_SUCCESS) return links;
+
+            for(auto link = list.data(); *link; link += wcslen(link) + 1) links.push_back(link);
+            return links;
+        }
+
+        static void add_subdevice(std::vector<std::shared_ptr<device>> & devices, std::shared_ptr<context> context, const std::string & name, com_ptr<IMFActivate> activate, const std::wstring & symbolic_link)
+        {
+            int vid, pid, mi; std::string unique_id;
+            if(!parse_usb_path(vid, pid, mi, unique_id, name)) return;
+
+            std::shared_ptr<device> dev;
+            for(auto & d : devices)
+            {
+                if(d->vid == vid && d->pid == pid && d->unique_id == unique_id)
+                {
+                    dev = d;
+                }
+            }
+            if(!dev)
+            {
+                dev = std::make_shared<device>(context, vid, pid, unique_id);
+                devices.push_back(dev);
+            }
+
+            size_t subdevice_index = mi/2;
+            if(subdevice_index >= dev->subdevices.size()) dev->subdevices.resize(subdevice_index+1);
+            if(dev->subdevices[subdevice_index].mf_activate || !dev->subdevices[subdevice_index].symbolic_link.empty()) return; // Listed by both enumerations
+
+            dev->subdevices[subdevice_index].reader_callback = new reader_callback(dev, static_cast<int>(subdevice_index));
+            dev->subdevices[subdevice_index].mf_activate = activate;
+            dev->subdevices[subdevice_index].symbolic_link = symbolic_link;
+            dev->subdevices[subdevice_index].vid = vid;
+            dev->subdevices[subdevice_index].pid = pid;
+        }
+
         std::vector<std::shared_ptr<device>> query_devices(std::shared_ptr<context> context)
         {
+            std::vector<std::shared_ptr<device>> devices;
+
+            // Subdevices listed as camera interfaces have their media source made from the symbolic link, only once they are used. Drivers do not
+            // all register that interface class though, even next to other cameras which do, so that MFEnumDeviceSources fills in the subdevices
+            // the interfaces missed, those found twice keeping their symbolic link.
+            for(auto & link : query_camera_interfaces()) add_subdevice(devices, context, win_to_utf(link.c_str()), nullptr, link);
+
             IMFAttributes * pAttributes = NULL;
             check("MFCreateAttributes", MFCreateAttributes(&pAttributes, 1));
             check("IMFAttributes::SetGUID", pAttributes->SetGUID(MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE, MF_DEVSOURCE_ATTRIBUTE_SOURCE_TYPE_VIDCAP_GUID));
- 
+
             IMFActivate ** ppDevices;
             UINT32 numDevices;
             check("MFEnumDeviceSources", MFEnumDeviceSources(pAttributes, &ppDevices, &numDevices));
 
-            std::vector<std::shared_ptr<device>> devices;
             for(UINT32 i=0; i<numDevices; ++i)
             {
                 com_ptr<IMFActivate> pDevice;
@@ -1082,31 +1368,9 @@ namespace rsimpl
                 auto name = win_to_utf(wchar_name);
                 CoTaskMemFree(wchar_name);
 
-                int vid, pid, mi; std::string unique_id;
-                if(!parse_usb_path(vid, pid, mi, unique_id, name)) continue;
-
-                std::shared_ptr<device> dev;
-                for(auto & d : devices)
-                {
-                    if(d->vid == vid && d->pid == pid && d->unique_id == unique_id)
-                    {
-                        dev = d;
-                    }
-                }
-                if(!dev)
-                {
-                    dev = std::make_shared<device>(context, vid, pid, unique_id);
-                    devices.push_back(dev);
-                }
-
-                size_t subdevice_index = mi/2;
-                if(subdevice_index >= dev->subdevices.size()) dev->subdevices.resize(subdevice_index+1);
-
-                dev->subdevices[subdevice_index].reader_callback = new reader_callback(dev, static_cast<int>(subdevice_index));
-                dev->subdevices[subdevice_index].mf_activate = pDevice;                
-                dev->subdevices[subdevice_index].vid = vid;
-                dev->subdevices[subdevice_index].pid = pid;
+                add_subdevice(devices, context, name, pDevice, {});
             }
+            CoTaskMemFree(ppDevices);
 
             for(auto& devA : devices) // Look for CX3 Fisheye camera
             {
@@ -1119,6 +1383,7 @@ namespace rsimpl
                             devB->subdevices.resize(4);
                             devB->subdevices[3].reader_callback = new reader_callback(devB, static_cast<int>(3));
                             devB->subdevices[3].mf_activate = devA->subdevices[0].mf_activate;
+                            devB->subdevices[3].symbolic_link = devA->subdevices[0].symbolic_link;
                             devB->subdevices[3].vid = devB->aux_vid = VID_INTEL_CAMERA;
                             devB->subdevices[3].pid = devB->aux_pid = ZR300_FISHEYE_PID;
                             devB->aux_unique_id = devA->unique_id;
@@ -1130,7 +1395,6 @@ namespace rsimpl
                 }
             }
 
-            CoTaskMemFree(ppDevices);
             return devices;
         }
 
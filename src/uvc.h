@@ -10,6 +10,8 @@
 #include <memory>       // For shared_ptr
 #include <functional>   // For function
 #include <thread>       // For this_thread::sleep_for
+#include <random>       // For minstd_rand
+#include <chrono>       // For steady_clock
 
 const uint16_t VID_INTEL_CAMERA     = 0x8086;
 const uint16_t ZR300_CX3_PID        = 0x0acb;
@@ -29,6 +31,17 @@ namespace rsimpl
         std::shared_ptr<context> create_context();
         std::vector<std::shared_ptr<device>> query_devices(std::shared_ptr<context> context);
 
+        // Hotplug notification: the callback is invoked, on a thread of the backend, whenever a video device may have been attached or
+        // detached, possibly several times for one change. It is expected to query_devices again. An empty callback stops the notifications.
+        typedef std::function<void()> devices_changed_callback;
+        void set_devices_changed_callback(context & context, devices_changed_callback callback);
+
+        // Starts a thread prepared to call into the backend, which for WMF means a COM apartment of its own
+        std::thread start_backend_thread(std::function<void()> function);
+
+        // Restricts a thread started by start_backend_thread to the CPUs of cpu_mask, 0 leaving it on every CPU. Failures are only reported.
+        void set_thread_cpu_mask(std::thread & thread, uint64_t cpu_mask);
+
         // Check for connected device
         bool is_device_connected(device & device, int vid, int pid);
 
@@ -36,6 +49,7 @@ namespace rsimpl
         int get_vendor_id(const device & device);
         int get_product_id(const device & device);
         std::string get_usb_port_id(const device & device);
+        std::string get_device_instance_id(const device & device); // Differs between two devices, and between two attachments of one device where the backend can tell
 
         // Direct USB controls
         void claim_interface(device & device, const guid & interface_guid, int interface_number);
@@ -53,64 +67,182 @@ namespace rsimpl
         void set_control(device & device, const extension_unit & xu, uint8_t ctrl, void * data, int len);
         void get_control(const device & device, const extension_unit & xu, uint8_t ctrl, void * data, int len);
 
+        // Thrown by the control functions when the device or driver refuses a request for good, such as a control the device lacks,
+        // a value out of range, or a device which is gone. Any other failure is taken to be transient.
+        class control_rejected_error : public std::runtime_error
+        {
+        public:
+            control_rejected_error(const std::string & message) : std::runtime_error(message) {}
+        };
+
+        // Milliseconds a device may spend sleeping between attempts at one failing control request, 0 for a single attempt
+        void set_control_retry_budget(device & device, int milliseconds);
+        int get_control_retry_budget(const device & device);
+
         // Control data channels
         typedef std::function<void(const unsigned char * data, const int size)> data_channel_callback;
 
         void set_subdevice_data_channel_handler(device & device, int subdevice_index, data_channel_callback callback);
-        void start_data_acquisition(device & device);
+        void start_data_acquisition(device & device, int num_transfers); // Interrupt transfers kept queued, where the backend can queue several
         void stop_data_acquisition(device & device);
 
         // Control streaming
-        typedef std::function<void(const void * frame, std::function<void()> continuation)> video_channel_callback;
-
-        void set_subdevice_mode(device & device, int subdevice_index, int width, int height, uint32_t fourcc, int fps, video_channel_callback callback);
+        // size is the number of bytes the device delivered in the frame, fewer than a whole frame when it came short. Continuations release the buffer, without allocating.
+        typedef std::function<void(const void * frame, size_t size, inline_function continuation)> video_channel_callback;
+
+        // frame_size is the number of bytes of a native frame of the mode, which backends relaying frames rather than capturing them need to know
+        void set_subdevice_mode(device & device, int subdevice_index, int width, int height, uint32_t fourcc, int fps, size_t frame_size, video_channel_callback callback);
+
+        // Crops the frames of a subdevice to a window of its mode, applied by the next start_streaming, so that only the window crosses the bus.
+        // Frames are then delivered with width x height pixels. A width of 0 restores whole frames. Returns false, delivering whole frames, where
+        // the driver cannot crop without scaling.
+        bool set_subdevice_crop(device & device, int subdevice_index, int x, int y, int width, int height);
+
+        // Invoked with every rows_per_slice rows of a frame as the driver assembles it, ahead of the frame, and with the rows left over at its end.
+        // The rows are only valid for the duration of the call, which holds up the transfers of the device.
+        typedef std::function<void(const void * rows, int first_row, int row_count)> video_slice_callback;
+
+        // Slices the frames of a subdevice, applied by the next start_streaming. A null callback turns slicing off. Returns false, slicing nothing,
+        // where frames only reach the host whole.
+        bool set_subdevice_slice_callback(device & device, int subdevice_index, int rows_per_slice, size_t row_bytes, video_slice_callback callback);
+
+        // Buffers a subdevice captures with: kernel buffers for V4L2, frame assembly buffers for libuvc. A count of 0 restores the
+        // default of the backend. Backends with a pool of their own accept only 0, and report a range of 0 to 0.
+        void set_subdevice_buffer_count(device & device, int subdevice_index, int buffer_count);
+        void get_subdevice_buffer_count_range(const device & device, int & min, int & max);
+
+        // Memory the driver captures frames into: its own buffers mapped into the process, blocks obtained from a frame allocator,
+        // or dma-bufs exported by another driver, one capture buffer per descriptor. Backends which cannot capture into foreign memory
+        // throw for anything but mapped buffers.
+        enum class capture_memory { mapped, user_pointer, dma_buffer };
+        void set_subdevice_capture_memory(device & device, int subdevice_index, capture_memory memory, std::shared_ptr<rs_frame_allocator> allocator, const std::vector<int> & dmabuf_fds);
+
+        // True if frame memory passed to a video_channel_callback stays valid until its continuation is invoked, allowing frames to be delivered without copying
+        bool supports_zero_copy(const device & device);
+
+        // Scheduling of the threads that invoke video_channel_callbacks, applied by the next start_streaming. A cpu_mask of 0 lets them run on every CPU,
+        // a priority of 0 keeps the default policy, and priorities from 1 to 99 run them SCHED_FIFO. Backends without control over their threads ignore it.
+        void set_capture_thread_scheduling(device & device, uint64_t cpu_mask, int priority);
         void start_streaming(device & device, int num_transfer_bufs);
         void stop_streaming(device & device);
+
+        // Stops and restarts the flow of frames of a streaming device, keeping its capture buffers and negotiated modes, so that resuming costs
+        // no more than the driver takes to start the pipes again. Frames held by the application stay valid across a pause. The device can be
+        // stopped while paused. Given a subdevice index, only the frames of that subdevice stop or restart, the others streaming on.
+        void pause_streaming(device & device, int subdevice_index = -1);
+        void resume_streaming(device & device, int subdevice_index = -1);
+
+        // What a subdevice captured since it last started streaming. Errors count the transfers, packets and dequeues the driver or USB stack
+        // failed, and short frames those which arrived with fewer bytes than their mode has.
+        struct transfer_statistics { unsigned long long bytes, bytes_per_second, frames, short_frames, errors; };
+        transfer_statistics get_subdevice_transfer_statistics(const device & device, int subdevice_index);
+
+        // Keeps the transfer_statistics of a subdevice, updated by its capture thread without locking and read by any thread
+        class transfer_monitor
+        {
+            std::atomic<unsigned long long> bytes, frames, short_frames, errors, bytes_per_second;
+            std::atomic<long long> rate_time;   // Nanoseconds of the steady clock at which bytes_per_second was last measured
+            long long window_start;             // Of the bytes counted towards the next measure, touched by the capture thread only
+            unsigned long long window_bytes;
+
+            static long long now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+        public:
+            static const long long rate_window = 1000000000; // Bytes per second are measured over a second, and read as 0 once two have passed without frames
+
+            transfer_monitor() { reset(); }
+
+            // Called before the capture thread starts
+            void reset()
+            {
+                for (auto counter : { &bytes, &frames, &short_frames, &errors, &bytes_per_second }) counter->store(0, std::memory_order_relaxed);
+                window_start = now();
+                rate_time.store(window_start, std::memory_order_relaxed);
+                window_bytes = 0;
+            }
+
+            void on_frame(size_t size, size_t expected_size)
+            {
+                bytes.fetch_add(size, std::memory_order_relaxed);
+                frames.fetch_add(1, std::memory_order_relaxed);
+                if (size < expected_size) short_frames.fetch_add(1, std::memory_order_relaxed);
+
+                window_bytes += size;
+                const auto t = now();
+                if (t - window_start >= rate_window)
+                {
+                    bytes_per_second.store(static_cast<unsigned long long>(window_bytes * 1e9 / (t - window_start)), std::memory_order_relaxed);
+                    rate_time.store(t, std::memory_order_relaxed);
+                    window_start = t;
+                    window_bytes = 0;
+                }
+            }
+
+            void on_error() { errors.fetch_add(1, std::memory_order_relaxed); }
+            void set_errors(unsigned long long count) { errors.store(count, std::memory_order_relaxed); } // For backends which count them elsewhere
+
+            transfer_statistics get() const
+            {
+                const bool stalled = now() - rate_time.load(std::memory_order_relaxed) > 2 * rate_window;
+                return { bytes.load(std::memory_order_relaxed), stalled ? 0 : bytes_per_second.load(std::memory_order_relaxed),
+                    frames.load(std::memory_order_relaxed), short_frames.load(std::memory_order_relaxed), errors.load(std::memory_order_relaxed) };
+            }
+        };
         
-        // Access CT, PU, and XU controls, and retry if failure occurs
-        inline void set_pu_control_with_retry(device & device, int subdevice, rs_option option, int value)
+        // Devices of the playback backend replay recordings instead of capturing, their frames and motion data delivered through the same callbacks
+        // as those of a camera. Their controls are rejected. The recordings are named by the RS_PLAYBACK_FILES environment variable, and the rings
+        // published by other processes, which are replayed as they are published, by the RS_PLAYBACK_RINGS environment variable.
+        std::string get_playback_path(const device & device);
+        std::string get_playback_ring(const device & device); // Name of the ring the device replays, empty for recordings
+        void set_playback_pacing(device & device, rs_playback_pacing pacing);
+        bool step_playback(device & device); // Returns once the next frame was delivered, false if the recording ended before it
+        // Move playback to the first frame of a subdevice whose frame counter, or timestamp, is at least that given, through the index of the
+        // recording. Return false, leaving playback where it is, if no such frame was recorded.
+        bool seek_playback_to_frame(device & device, int subdevice, unsigned long long frame_counter);
+        bool seek_playback_to_time(device & device, int subdevice, double timestamp);
+        bool get_playback_frame_info(const device & device, double & timestamp, unsigned long long & frame_counter); // Of the frame being delivered, from its video_channel_callback
+
+        // Reattempts a control request until it succeeds, fails for good, or the next sleep would overrun a budget in milliseconds.
+        // Sleeps start at 5 ms and double up to 200 ms, each drawn from the upper half of its interval so that retries of threads sharing
+        // a device spread out.
+        template<class REQUEST> void retry_control(int budget, REQUEST request)
         {
-            // Try writing a control, if it fails, retry several times
-            // TODO: We may wish to tune the retry counts and sleep times based on camera, platform, firmware, etc.
-            for(int i=0; i<20; ++i)
+            std::minstd_rand jitter(static_cast<unsigned>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+            int delay = 5, slept = 0;
+            while(true)
             {
-                try { set_pu_control(device, subdevice, option, value); return; }
-                catch(...) { std::this_thread::sleep_for(std::chrono::milliseconds(50)); }
+                try { request(); return; }
+                catch(const control_rejected_error &) { throw; }
+                catch(const std::logic_error &) { throw; }
+                catch(const std::exception &) { if(slept + delay > budget) throw; }
+
+                const int sleep = delay / 2 + static_cast<int>(jitter() % (delay - delay / 2 + 1));
+                std::this_thread::sleep_for(std::chrono::milliseconds(sleep));
+                slept += sleep;
+                delay = std::min(delay * 2, 200);
             }
-            set_pu_control(device, subdevice, option, value);
+        }
+
+        // Access CT, PU, and XU controls, and retry if failure occurs
+        inline void set_pu_control_with_retry(device & device, int subdevice, rs_option option, int value)
+        {
+            retry_control(get_control_retry_budget(device), [&]() { set_pu_control(device, subdevice, option, value); });
         }
         
         inline int get_pu_control_with_retry(const device & device, int subdevice, rs_option option)
         {
-            // Try reading a control, if it fails, retry several times
-            for(int i=0; i<20; ++i)
-            {
-                try { return get_pu_control(device, subdevice, option); }
-                catch(...) { std::this_thread::sleep_for(std::chrono::milliseconds(50)); }
-            }
-            return get_pu_control(device, subdevice, option);
+            int value = 0;
+            retry_control(get_control_retry_budget(device), [&]() { value = get_pu_control(device, subdevice, option); });
+            return value;
         }
         
         inline void set_control_with_retry(device & device, const extension_unit & xu, uint8_t ctrl, void * data, int len)
         {
-            // Try writing a control, if it fails, retry several times
-            for(int i=0; i<20; ++i)
-            {
-                try { set_control(device, xu, ctrl, data, len); return; }
-                catch(...) { std::this_thread::sleep_for(std::chrono::milliseconds(50)); }
-            }
-            set_control(device, xu, ctrl, data, len);
+            retry_control(get_control_retry_budget(device), [&]() { set_control(device, xu, ctrl, data, len); });
         }
         
         inline void get_control_with_retry(const device & device, const extension_unit & xu, uint8_t ctrl, void * data, int len)
         {
-            // Try reading a control, if it fails, retry several times
-            for(int i=0; i<20; ++i)
-            {
-                try { get_control(device, xu, ctrl, data, len); return; }
-                catch(...) { std::this_thread::sleep_for(std::chrono::milliseconds(50)); }
-            }
-            get_control(device, xu, ctrl, data, len);
+            retry_control(get_control_retry_budget(device), [&]() { get_control(device, xu, ctrl, data, len); });
         }
     }
 }
@@ -0,0 +1,210 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+// H.264 encoding on the hardware encoders of FFmpeg, built with BUILD_WITH_FFMPEG. Encoders taking images in host memory copy them into
+// input buffers of their own while a frame is sent, while those of VA-API and Quick Sync are handed surfaces the images are uploaded to.
+#ifdef RS_USE_FFMPEG
+
+#include "video-encoder.h"
+#include "image.h" // For get_image_size
+
+#include <deque>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/opt.h>
+}
+
+namespace rsimpl
+{
+    namespace video
+    {
+        static int check(int result, const char * call)
+        {
+            if(result < 0)
+            {
+                char message[AV_ERROR_MAX_STRING_SIZE] = {};
+                av_strerror(result, message, sizeof(message));
+                throw std::runtime_error(to_string() << call << " failed: " << message);
+            }
+            return result;
+        }
+        #define AV_CHECK(call) check(call, #call)
+
+        bool is_available() { return true; }
+
+        // In order of preference, encoders needing a device context only take frames on its surfaces
+        struct candidate { const char * name; AVHWDeviceType device_type; AVPixelFormat surface_format; };
+        static const candidate candidates[] = {
+            { "h264_vaapi",     AV_HWDEVICE_TYPE_VAAPI, AV_PIX_FMT_VAAPI },
+            { "h264_nvenc",     AV_HWDEVICE_TYPE_NONE,  AV_PIX_FMT_NONE },
+            { "h264_qsv",       AV_HWDEVICE_TYPE_QSV,   AV_PIX_FMT_QSV },
+            { "h264_mf",        AV_HWDEVICE_TYPE_NONE,  AV_PIX_FMT_NONE },
+            { "h264_v4l2m2m",   AV_HWDEVICE_TYPE_NONE,  AV_PIX_FMT_NONE },
+        };
+
+        struct h264_encoder::impl
+        {
+            const int width, height;
+            const rs_format format;
+            const char * name = "";
+            AVBufferRef * device = nullptr;
+            AVCodecContext * context = nullptr;
+            AVFrame * frame = nullptr;      // The image being encoded, in place
+            AVFrame * surface = nullptr;    // The surface it is uploaded to, for encoders which only take those
+            AVPacket * packet = nullptr;
+            int64_t next_pts = 0;
+            std::deque<std::pair<int64_t, rs_encoded_packet>> pending; // Metadata of the frames sent, until their packet is received
+
+            impl(int width, int height, rs_format format) : width(width), height(height), format(format) {}
+            impl(const impl &) = delete;
+            impl & operator = (const impl &) = delete;
+            ~impl()
+            {
+                av_packet_free(&packet);
+                av_frame_free(&surface);
+                av_frame_free(&frame);
+                avcodec_free_context(&context);
+                av_buffer_unref(&device);
+            }
+
+            bool open(const candidate & c, int fps, int bitrate)
+            {
+                auto codec = avcodec_find_encoder_by_name(c.name);
+                if(!codec) return false;
+                if(c.device_type != AV_HWDEVICE_TYPE_NONE && av_hwdevice_ctx_create(&device, c.device_type, nullptr, nullptr, 0) < 0) return false;
+
+                const AVPixelFormat image_format = format == RS_FORMAT_I420 ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_NV12;
+                context = avcodec_alloc_context3(codec);
+                if(!context) return false;
+                context->width = width;
+                context->height = height;
+                context->time_base = { 1, fps };
+                context->framerate = { fps, 1 };
+                context->gop_size = fps;
+                context->max_b_frames = 0;
+                context->bit_rate = context->rc_max_rate = bitrate;
+                context->pix_fmt = image_format;
+                av_opt_set_int(context->priv_data, "zerolatency", 1, 0); // Only known to some encoders, such as NVENC
+                if(device)
+                {
+                    AVBufferRef * frames = av_hwframe_ctx_alloc(device);
+                    if(!frames) return false;
+                    auto surfaces = reinterpret_cast<AVHWFramesContext *>(frames->data);
+                    surfaces->format = c.surface_format;
+                    surfaces->sw_format = image_format;
+                    surfaces->width = width;
+                    surfaces->height = height;
+                    surfaces->initial_pool_size = 4;
+                    if(av_hwframe_ctx_init(frames) < 0)
+                    {
+                        av_buffer_unref(&frames);
+                        return false;
+                    }
+                    context->hw_frames_ctx = frames;
+                    context->pix_fmt = c.surface_format;
+                }
+                if(avcodec_open2(context, codec, nullptr) < 0) return false;
+
+                frame = av_frame_alloc();
+                surface = device ? av_frame_alloc() : nullptr;
+                packet = av_packet_alloc();
+                if(!frame || (device && !surface) || !packet) return false;
+                frame->format = image_format;
+                frame->width = width;
+                frame->height = height;
+                name = c.name;
+                return true;
+            }
+
+            void receive_packets(const packet_handler & on_packet)
+            {
+                while(true)
+                {
+                    const int result = avcodec_receive_packet(context, packet);
+                    if(result == AVERROR(EAGAIN) || result == AVERROR_EOF) return;
+                    check(result, "avcodec_receive_packet(context, packet)");
+
+                    // Without B-frames packets come in the order of their frames, whose metadata was queued as they were sent
+                    while(pending.size() > 1 && pending.front().first < packet->pts) pending.pop_front();
+                    rs_encoded_packet out = pending.empty() ? rs_encoded_packet() : pending.front().second;
+                    if(!pending.empty() && pending.front().first == packet->pts) pending.pop_front();
+                    out.data = packet->data;
+                    out.size = packet->size;
+                    out.keyframe = packet->flags & AV_PKT_FLAG_KEY ? 1 : 0;
+                    on_packet(out);
+                    av_packet_unref(packet);
+                }
+            }
+        };
+
+        h264_encoder::h264_encoder(int width, int height, rs_format format, int fps, int bitrate)
+        {
+            if(format != RS_FORMAT_NV12 && format != RS_FORMAT_I420) throw std::logic_error("only NV12 and I420 images can be encoded");
+            for(auto & c : candidates)
+            {
+                std::unique_ptr<impl> attempt(new impl(width, height, format));
+                if(!attempt->open(c, fps, bitrate)) continue;
+                p = std::move(attempt);
+                LOG_INFO("Encoding " << width << "x" << height << " " << get_string(format) << " images into H.264 with " << c.name);
+                return;
+            }
+            throw std::runtime_error(to_string() << "no hardware H.264 encoder opened for " << width << "x" << height << " " << get_string(format) << " images at " << fps << " fps");
+        }
+
+        h264_encoder::~h264_encoder() {}
+
+        const char * h264_encoder::get_name() const { return p->name; }
+
+        void h264_encoder::encode(const byte * image, double timestamp, unsigned long long frame_number, long long system_time, const packet_handler & on_packet)
+        {
+            // Point the frame at the planes of the image, read-only, so that the encoder reads it rather than a copy
+            const int chroma_stride = p->format == RS_FORMAT_I420 ? p->width / 2 : p->width;
+            const size_t size = get_image_size(p->width, p->height, p->format);
+            AVFrame * frame = p->frame;
+            av_frame_unref(frame);
+            frame->format = p->format == RS_FORMAT_I420 ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_NV12;
+            frame->width = p->width;
+            frame->height = p->height;
+            frame->buf[0] = av_buffer_create(const_cast<byte *>(image), static_cast<int>(size), [](void *, uint8_t *) {}, nullptr, AV_BUFFER_FLAG_READONLY);
+            if(!frame->buf[0]) throw std::bad_alloc();
+            frame->data[0] = const_cast<byte *>(image);
+            frame->linesize[0] = p->width;
+            frame->data[1] = frame->data[0] + p->width * p->height;
+            frame->linesize[1] = chroma_stride;
+            if(p->format == RS_FORMAT_I420)
+            {
+                frame->data[2] = frame->data[1] + chroma_stride * ((p->height + 1) / 2);
+                frame->linesize[2] = chroma_stride;
+            }
+            frame->pts = p->next_pts++;
+
+            AVFrame * input = frame;
+            if(p->surface)
+            {
+                av_frame_unref(p->surface);
+                AV_CHECK(av_hwframe_get_buffer(p->context->hw_frames_ctx, p->surface, 0));
+                AV_CHECK(av_hwframe_transfer_data(p->surface, frame, 0));
+                p->surface->pts = frame->pts;
+                input = p->surface;
+            }
+
+            rs_encoded_packet metadata = {};
+            metadata.timestamp = timestamp;
+            metadata.frame_number = frame_number;
+            metadata.system_time = system_time;
+            p->pending.push_back({ frame->pts, metadata });
+
+            // An encoder whose output is full takes the frame once its packets have been received
+            int result;
+            while((result = avcodec_send_frame(p->context, input)) == AVERROR(EAGAIN)) p->receive_packets(on_packet);
+            check(result, "avcodec_send_frame(context, input)");
+            p->receive_packets(on_packet);
+            av_frame_unref(frame);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,27 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+// Without BUILD_WITH_FFMPEG, streams cannot be encoded. The FFmpeg implementation lives in video-encoder-ffmpeg.cpp.
+#ifndef RS_USE_FFMPEG
+
+#include "video-encoder.h"
+
+namespace rsimpl
+{
+    namespace video
+    {
+        struct h264_encoder::impl {};
+
+        bool is_available() { return false; }
+
+        static void throw_unavailable() { throw std::runtime_error("librealsense was built without BUILD_WITH_FFMPEG"); }
+
+        h264_encoder::h264_encoder(int, int, rs_format, int, int) { throw_unavailable(); }
+        h264_encoder::~h264_encoder() {}
+
+        const char * h264_encoder::get_name() const { return ""; }
+        void h264_encoder::encode(const byte *, double, unsigned long long, long long, const packet_handler &) { throw_unavailable(); }
+    }
+}
+
+#endif
@@ -0,0 +1,41 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+#pragma once
+#ifndef LIBREALSENSE_VIDEO_ENCODER_H
+#define LIBREALSENSE_VIDEO_ENCODER_H
+
+#include "types.h"
+
+#include <memory>
+
+namespace rsimpl
+{
+    namespace video
+    {
+        // True if the library was built with BUILD_WITH_FFMPEG, whether or not any hardware encoder is present
+        bool is_available();
+
+        // Encodes NV12 or I420 images into H.264 on the first hardware encoder of FFmpeg which opens for their size: VA-API, NVENC, Quick Sync,
+        // Media Foundation or V4L2 memory-to-memory. The encoding runs at a constant bitrate, without B-frames and with a keyframe every second,
+        // so that packets follow their frames closely. Images are read where they are, the encoder copying them into its own input buffers or
+        // uploading them to its surfaces, and are not referenced once encode returns.
+        class h264_encoder
+        {
+            struct impl;
+            std::unique_ptr<impl> p;
+        public:
+            typedef std::function<void(const rs_encoded_packet & packet)> packet_handler; // Must not throw
+
+            h264_encoder(int width, int height, rs_format format, int fps, int bitrate); // Throws if no hardware encoder opens
+            ~h264_encoder();
+
+            const char * get_name() const; // Of the FFmpeg encoder, such as h264_vaapi
+
+            // Sends an image to the encoder, then hands every packet it has produced so far to on_packet, with the metadata of its frame
+            void encode(const byte * image, double timestamp, unsigned long long frame_number, long long system_time, const packet_handler & on_packet);
+        };
+    }
+}
+
+#endif
@@ -3,12 +3,14 @@
 
 #include <climits>
 #include <algorithm>
+#include <iomanip>
 
 #include "image.h"
 #include "ds-private.h"
 #include "zr300.h"
 #include "ivcam-private.h"
 #include "hw-monitor.h"
+#include "calibration-store.h"
 
 using namespace rsimpl;
 using namespace rsimpl::ds;
@@ -22,6 +24,8 @@ namespace rsimpl
       motion_module_ctrl(device.get(), usbMutex),
       auto_exposure(nullptr),
       to_add_frames((auto_exposure_state.get_auto_exposure_state(RS_OPTION_FISHEYE_ENABLE_AUTO_EXPOSURE) == 1)),
+      fisheye_exposure(-1),
+      fisheye_gain(-1),
       fe_intrinsic(in_fe_intrinsic)
     {}
     
@@ -55,6 +59,7 @@ namespace rsimpl
             if (is_fisheye_uvc_control(options[i]))
             {
                 uvc::set_pu_control_with_retry(dev, 3, options[i], static_cast<int>(values[i]));
+                if (options[i] == RS_OPTION_FISHEYE_GAIN) fisheye_gain = static_cast<int>(values[i]);
                 continue;
             }
 
@@ -62,7 +67,7 @@ namespace rsimpl
             {
             case RS_OPTION_FISHEYE_STROBE:                            zr300::set_fisheye_strobe(dev, static_cast<uint8_t>(values[i])); break;
             case RS_OPTION_FISHEYE_EXTERNAL_TRIGGER:                  zr300::set_fisheye_external_trigger(dev, static_cast<uint8_t>(values[i])); break;
-            case RS_OPTION_FISHEYE_EXPOSURE:                          zr300::set_fisheye_exposure(dev, static_cast<uint16_t>(values[i])); break;
+            case RS_OPTION_FISHEYE_EXPOSURE:                          zr300::set_fisheye_exposure(dev, static_cast<uint16_t>(values[i])); fisheye_exposure = static_cast<uint16_t>(values[i]); break;
             case RS_OPTION_FISHEYE_ENABLE_AUTO_EXPOSURE:              set_auto_exposure_state(RS_OPTION_FISHEYE_ENABLE_AUTO_EXPOSURE, values[i]); break;
             case RS_OPTION_FISHEYE_AUTO_EXPOSURE_MODE:                set_auto_exposure_state(RS_OPTION_FISHEYE_AUTO_EXPOSURE_MODE, values[i]); break;
             case RS_OPTION_FISHEYE_AUTO_EXPOSURE_ANTIFLICKER_RATE:    set_auto_exposure_state(RS_OPTION_FISHEYE_AUTO_EXPOSURE_ANTIFLICKER_RATE, values[i]); break;
@@ -94,6 +99,7 @@ namespace rsimpl
             if (is_fisheye_uvc_control(options[i]))
             {
                 values[i] = uvc::get_pu_control(dev, 3, options[i]);
+                if (options[i] == RS_OPTION_FISHEYE_GAIN) fisheye_gain = static_cast<int>(values[i]);
                 continue;
             }
 
@@ -102,7 +108,7 @@ namespace rsimpl
 
             case RS_OPTION_FISHEYE_STROBE:                          values[i] = zr300::get_fisheye_strobe        (dev); break;
             case RS_OPTION_FISHEYE_EXTERNAL_TRIGGER:                values[i] = zr300::get_fisheye_external_trigger      (dev); break;
-            case RS_OPTION_FISHEYE_EXPOSURE:                        values[i] = zr300::get_fisheye_exposure      (dev); break;
+            case RS_OPTION_FISHEYE_EXPOSURE:                        values[i] = fisheye_exposure = zr300::get_fisheye_exposure(dev); break;
             case RS_OPTION_FISHEYE_ENABLE_AUTO_EXPOSURE:            values[i] = get_auto_exposure_state(RS_OPTION_FISHEYE_ENABLE_AUTO_EXPOSURE); break;
             case RS_OPTION_FISHEYE_AUTO_EXPOSURE_MODE:              values[i] = get_auto_exposure_state(RS_OPTION_FISHEYE_AUTO_EXPOSURE_MODE); break;
             case RS_OPTION_FISHEYE_AUTO_EXPOSURE_ANTIFLICKER_RATE:  values[i] = get_auto_exposure_state(RS_OPTION_FISHEYE_AUTO_EXPOSURE_ANTIFLICKER_RATE); break;
@@ -127,14 +133,23 @@ namespace rsimpl
             values[i] = base_opt_val[i];
     }
 
-    void zr300_camera::send_blob_to_device(rs_blob_type type, void * data, int size)
+    double zr300_camera::get_cached_fisheye_option(rs_option option)
+    {
+        const int known = option == RS_OPTION_FISHEYE_EXPOSURE ? fisheye_exposure : fisheye_gain;
+        if (known >= 0) return known;
+        double value;
+        get_options(&option, 1, &value);
+        return value;
+    }
+
+    void zr300_camera::send_blob_to_device(rs_blob_type type, void * data, int size, const blob_progress & on_progress)
     {
         switch(type)
         {
         case RS_BLOB_TYPE_MOTION_MODULE_FIRMWARE_UPDATE:
-            motion_module_ctrl.firmware_upgrade(data, size);
+            motion_module_ctrl.firmware_upgrade(data, size, on_progress);
             break;
-        default: rs_device_base::send_blob_to_device(type, data, size);
+        default: rs_device_base::send_blob_to_device(type, data, size, on_progress);
         }
     }
 
@@ -214,7 +229,7 @@ namespace rsimpl
             toggle_motion_module_power(true);
 
         if (supports(RS_CAPABILITIES_FISH_EYE))
-            auto_exposure = std::make_shared<auto_exposure_mechanism>(this, auto_exposure_state);
+            auto_exposure = std::make_shared<auto_exposure_mechanism>(this, *shared_executor, auto_exposure_state);
 
         ds_device::start(source);
     }
@@ -398,7 +413,7 @@ namespace rsimpl
         size_t bufferLength = HW_MONITOR_BUFFER_SIZE;
         get_raw_data(static_cast<uint8_t>(adaptor_board_command::MM_SNB), device, mutex, serial_number_raw, bufferLength);
 
-        serial_number sn;
+        serial_number sn = {};
         memcpy(&sn, serial_number_raw, std::min(sizeof(serial_number), bufferLength)); // Is this longer or shorter than the rawCalib struct?
         return sn;
     }
@@ -412,12 +427,31 @@ namespace rsimpl
         memcpy(&calibration, scalibration_raw, std::min(sizeof(calibration), bufferLength)); // Is this longer or shorter than the rawCalib struct?
         return calibration;
     }
-    motion_module_calibration read_fisheye_intrinsic(uvc::device & device, std::timed_mutex & mutex)
+    // The serial number block, which the motion module returns for a short command, keys and signs the calibration along with the firmware version
+    motion_module_calibration read_fisheye_intrinsic(uvc::device & device, std::timed_mutex & mutex, const std::string & firmware_version)
     {
         motion_module_calibration intrinsic;
-        intrinsic.calib = read_calibration(device, mutex);
         intrinsic.sn = read_serial_number(device, mutex);
+        if (firmware_version.empty())
+        {
+            intrinsic.calib = read_calibration(device, mutex);
+            return intrinsic;
+        }
 
+        std::ostringstream key;
+        key << "zr300-mm-" << std::hex;
+        for (auto b : intrinsic.sn.MM_s_n) key << std::setw(2) << std::setfill('0') << static_cast<int>(b);
+        key << "-" << firmware_version;
+
+        auto sn_bytes = reinterpret_cast<const uint8_t *>(&intrinsic.sn);
+        auto data = calibration_store::get(key.str(), std::vector<uint8_t>(sn_bytes, sn_bytes + sizeof(intrinsic.sn)), [&]()
+        {
+            auto calib = read_calibration(device, mutex);
+            auto calib_bytes = reinterpret_cast<const uint8_t *>(&calib);
+            return std::vector<uint8_t>(calib_bytes, calib_bytes + sizeof(calib));
+        });
+        if (data.size() != sizeof(intrinsic.calib)) throw std::runtime_error("Cached motion module calibration has the wrong size");
+        memcpy(&intrinsic.calib, data.data(), data.size());
         return intrinsic;
     }
 
@@ -428,41 +462,61 @@ namespace rsimpl
 
         static_device_info info;
         info.name =  "Intel RealSense ZR300" ;
-        auto cam_info = ds::read_camera_info(*device);
 
         motion_module_calibration fisheye_intrinsic;
         auto succeeded_to_read_fisheye_intrinsic = false;
 
-
         // TODO - is Motion Module optional
-        if (uvc::is_device_connected(*device, VID_INTEL_CAMERA, FISHEYE_PRODUCT_ID))
+        const bool motion_module_connected = uvc::is_device_connected(*device, VID_INTEL_CAMERA, FISHEYE_PRODUCT_ID);
+        std::thread motion_module_reader;
+        if (motion_module_connected)
         {
             // Acquire Device handle for Motion Module API
             zr300::claim_motion_module_interface(*device);
-            std::timed_mutex mtx;
-            try
-            {
-                std::string version_string;
-                ivcam::get_firmware_version_string(*device, mtx, version_string, (int)adaptor_board_command::GVD);
-                info.camera_info[RS_CAMERA_INFO_ADAPTER_BOARD_FIRMWARE_VERSION] = version_string;
-                ivcam::get_firmware_version_string(*device, mtx, version_string, (int)adaptor_board_command::GVD, 4);
-                info.camera_info[RS_CAMERA_INFO_MOTION_MODULE_FIRMWARE_VERSION] = version_string;
-            }
-            catch (...)
-            {
-                LOG_ERROR("Failed to get firmware version");
-            }
 
-            try
-            {
-                std::timed_mutex  mutex;
-                fisheye_intrinsic = read_fisheye_intrinsic(*device, mutex);
-                succeeded_to_read_fisheye_intrinsic = true;
-            }
-            catch (...)
+            // The motion module answers through the adapter board, so its versions and calibration are read on a thread of their own while
+            // the depth camera reads its calibration sector, and the device waits for the slower of the two rather than for both in turn
+            motion_module_reader = uvc::start_backend_thread([&]()
             {
-                LOG_ERROR("Couldn't query adapter board / motion module FW version!");
-            }
+                std::timed_mutex mtx;
+                try
+                {
+                    std::string version_string;
+                    ivcam::get_firmware_version_string(*device, mtx, version_string, (int)adaptor_board_command::GVD);
+                    info.camera_info[RS_CAMERA_INFO_ADAPTER_BOARD_FIRMWARE_VERSION] = version_string;
+                    ivcam::get_firmware_version_string(*device, mtx, version_string, (int)adaptor_board_command::GVD, 4);
+                    info.camera_info[RS_CAMERA_INFO_MOTION_MODULE_FIRMWARE_VERSION] = version_string;
+                }
+                catch (...)
+                {
+                    LOG_ERROR("Failed to get firmware version");
+                }
+
+                try
+                {
+                    std::timed_mutex  mutex;
+                    auto mm_version = info.camera_info.find(RS_CAMERA_INFO_MOTION_MODULE_FIRMWARE_VERSION);
+                    fisheye_intrinsic = read_fisheye_intrinsic(*device, mutex, mm_version != info.camera_info.end() ? mm_version->second : std::string());
+                    succeeded_to_read_fisheye_intrinsic = true;
+                }
+                catch (...)
+                {
+                    LOG_ERROR("Couldn't query adapter board / motion module FW version!");
+                }
+            });
+        }
+
+        ds::ds_info cam_info;
+        try { cam_info = ds::read_camera_info(*device); }
+        catch (...)
+        {
+            if (motion_module_reader.joinable()) motion_module_reader.join();
+            throw;
+        }
+        if (motion_module_reader.joinable()) motion_module_reader.join();
+
+        if (motion_module_connected)
+        {
             rs_intrinsics rs_intrinsics = fisheye_intrinsic.calib.fe_intrinsic;
 
             info.capabilities_vector.push_back(RS_CAPABILITIES_MOTION_MODULE_FW_UPDATE);
@@ -499,6 +553,7 @@ namespace rsimpl
             info.options.push_back({ RS_OPTION_FISHEYE_AUTO_EXPOSURE_PIXEL_SAMPLE_RATE, 1,  3,   1,  1  });
             info.options.push_back({ RS_OPTION_FISHEYE_AUTO_EXPOSURE_SKIP_FRAMES,       2,  3,   1,  2  });
             info.options.push_back({ RS_OPTION_HARDWARE_LOGGER_ENABLED,                 0,  1,   1,  0  });
+            info.options.push_back({ RS_OPTION_MOTION_DATA_TRANSFER_COUNT,              1,  RS_MAX_MOTION_DATA_TRANSFERS, 1, RS_DEFAULT_MOTION_DATA_TRANSFERS });
         }
 
         ds_device::set_common_ds_config(device, info, cam_info);
@@ -621,91 +676,88 @@ namespace rsimpl
         }
     }
 
-    auto_exposure_mechanism::auto_exposure_mechanism(zr300_camera* dev, fisheye_auto_exposure_state auto_exposure_state) : device(dev), auto_exposure_algo(auto_exposure_state), sync_archive(nullptr), keep_alive(true), frames_counter(0), skip_frames(get_skip_frames(auto_exposure_state))
+    auto_exposure_mechanism::auto_exposure_mechanism(zr300_camera* dev, executor & pool, fisheye_auto_exposure_state auto_exposure_state) : device(dev), auto_exposure_algo(auto_exposure_state), sync_archive(nullptr), keep_alive(true), frames_counter(0), skip_frames(get_skip_frames(auto_exposure_state)), frames_since_counter_sample(0)
     {
-        exposure_thread = std::make_shared<std::thread>([this]() {
-            while (keep_alive)
-            {
-                std::unique_lock<std::mutex> lk(queue_mtx);
-                cv.wait(lk, [&] {return (get_queue_size() || !keep_alive); });
-                if (!keep_alive)
-                    return;
+        exposure_job = pool.create_job([this]() { process_frames(); });
+    }
 
+    auto_exposure_mechanism::~auto_exposure_mechanism()
+    {
+        keep_alive = false;
+        exposure_job->cancel();
 
-                rs_frame_ref* frame_ref = nullptr;
-                auto frame_sts = try_pop_front_data(&frame_ref);
-                lk.unlock();
-
-                double values[2] = {};
-                unsigned long long frame_counter;
-                try {
-                    if (frame_ref->supports_frame_metadata(RS_FRAME_METADATA_ACTUAL_EXPOSURE))
-                    {
-                        double gain[1] = {};
-                        rs_option options[] = { RS_OPTION_FISHEYE_GAIN };
-                        device->get_options(options, 1, gain);
-                        values[0] = frame_ref->get_frame_metadata(RS_FRAME_METADATA_ACTUAL_EXPOSURE);
-                        values[1] = gain[0];
-                    }
-                    else
-                    {
-                        rs_option options[] = { RS_OPTION_FISHEYE_EXPOSURE, RS_OPTION_FISHEYE_GAIN };
-                        device->get_options(options, 2, values);
-                    }
-
-                    values[0] /= 10.; // Fisheye exposure value by extension control is in units of 10 mSec
-                    frame_counter = device->get_frame_counter_by_usb_cmd();
-                    push_back_exp_and_cnt(exposure_and_frame_counter(values[0], frame_counter));
-                }
-                catch (...) {};
+        std::lock_guard<std::mutex> lk(queue_mtx);
+        clear_queue();
+    }
 
-                if (frame_sts)
-                {
-                    unsigned long long frame_counter = frame_ref->get_frame_number();
-                    double exp_by_frame_cnt;
-                    auto exp_and_cnt_sts = try_get_exp_by_frame_cnt(exp_by_frame_cnt, frame_counter);
-
-                    auto exposure_value = static_cast<float>((exp_and_cnt_sts)? exp_by_frame_cnt : values[0]);
-                    auto gain_value = static_cast<float>(2 + (values[1]-15) / 8.);
-
-                    bool sts = auto_exposure_algo.analyze_image(frame_ref);
-                    if (sts)
-                    {
-                        bool modify_exposure, modify_gain;
-                        auto_exposure_algo.modify_exposure(exposure_value, modify_exposure, gain_value, modify_gain);
-
-                        if (modify_exposure)
-                        {
-                            rs_option option[] = { RS_OPTION_FISHEYE_EXPOSURE };
-                            double value[] = { exposure_value * 10. };
-                            if (value[0] < 1)
-                                value[0] = 1;
-
-                            device->set_options(option, 1, value);
-                        }
-
-                        if (modify_gain)
-                        {
-                            rs_option option[] = { RS_OPTION_FISHEYE_GAIN };
-                            double value[] = { (gain_value-2) * 8 +15. };
-                            device->set_options(option, 1, value);
-                        }
-                    }
-                }
-                sync_archive->release_frame_ref((rsimpl::frame_archive::frame_ref *)frame_ref);
+    // Every run analyzes the frames queued until none is left
+    void auto_exposure_mechanism::process_frames()
+    {
+        while (keep_alive)
+        {
+            rs_frame_ref* frame_ref = nullptr;
+            {
+                std::lock_guard<std::mutex> lk(queue_mtx);
+                if (!try_pop_front_data(&frame_ref))
+                    return;
             }
-        });
+            process_frame(frame_ref);
+        }
     }
 
-    auto_exposure_mechanism::~auto_exposure_mechanism()
+    void auto_exposure_mechanism::process_frame(rs_frame_ref* frame_ref)
     {
+        double values[2] = {};
+        bool exposure_of_frame = false;
+        try {
+            // The device only changes exposure and gain when told to, so the values last written stand in for reading them back
+            values[1] = device->get_cached_fisheye_option(RS_OPTION_FISHEYE_GAIN);
+            if (frame_ref->supports_frame_metadata(RS_FRAME_METADATA_ACTUAL_EXPOSURE))
+            {
+                // The frame carries its own exposure, so the control endpoint and the queue are left alone
+                values[0] = frame_ref->get_frame_metadata(RS_FRAME_METADATA_ACTUAL_EXPOSURE) / 10.; // Fisheye exposure value by extension control is in units of 10 mSec
+                exposure_of_frame = true;
+            }
+            else
+            {
+                values[0] = device->get_cached_fisheye_option(RS_OPTION_FISHEYE_EXPOSURE) / 10.;
+                if (frames_since_counter_sample++ % frame_counter_sample_interval == 0)
+                    push_back_exp_and_cnt(exposure_and_frame_counter(values[0], device->get_frame_counter_by_usb_cmd()));
+            }
+        }
+        catch (...) {};
+
+        // Otherwise, the exposure sampled along with the frame counter of the device is that of the frame, when the frame numbers match
+        double exp_by_frame_cnt;
+        if (!exposure_of_frame && try_get_exp_by_frame_cnt(exp_by_frame_cnt, frame_ref->get_frame_number())) values[0] = exp_by_frame_cnt;
+
+        auto exposure_value = static_cast<float>(values[0]);
+        auto gain_value = static_cast<float>(2 + (values[1]-15) / 8.);
+
+        bool sts = auto_exposure_algo.analyze_image(frame_ref);
+        if (sts)
         {
-            std::lock_guard<std::mutex> lk(queue_mtx);
-            keep_alive = false;
-            clear_queue();
+            bool modify_exposure, modify_gain;
+            auto_exposure_algo.modify_exposure(exposure_value, modify_exposure, gain_value, modify_gain);
+
+            if (modify_exposure)
+            {
+                rs_option option[] = { RS_OPTION_FISHEYE_EXPOSURE };
+                double value[] = { exposure_value * 10. };
+                if (value[0] < 1)
+                    value[0] = 1;
+
+                device->set_options(option, 1, value);
+            }
+
+            if (modify_gain)
+            {
+                rs_option option[] = { RS_OPTION_FISHEYE_GAIN };
+                double value[] = { (gain_value-2) * 8 +15. };
+                device->set_options(option, 1, value);
+            }
         }
-        cv.notify_one();
-        exposure_thread->join();
+        sync_archive->release_frame_ref((rsimpl::frame_archive::frame_ref *)frame_ref);
     }
 
     void auto_exposure_mechanism::update_auto_exposure_state(fisheye_auto_exposure_state& auto_exposure_state)
@@ -738,7 +790,7 @@ namespace rsimpl
 
             push_back_data(frame);
         }
-        cv.notify_one();
+        exposure_job->trigger();
     }
 
     void auto_exposure_mechanism::push_back_exp_and_cnt(exposure_and_frame_counter exp_and_cnt)
@@ -873,9 +925,12 @@ namespace rsimpl
         if (number_of_pixels == 0)  return false;   // empty image
 
         std::vector<int> H(256);
-        int total_weight = number_of_pixels;
-
-        im_hist((uint8_t*)image->get_frame_data(), cols, rows, image->get_frame_bpp() / 8 * cols, &H[0]);
+        int total_weight;
+        {
+            std::lock_guard<std::recursive_mutex> lock(state_mutex);
+            total_weight = histogram_of_samples((const uint8_t*)image->get_frame_data(), cols, rows, image->get_frame_bpp() / 8 * cols,
+                                                state.get_auto_exposure_state(RS_OPTION_FISHEYE_AUTO_EXPOSURE_PIXEL_SAMPLE_RATE), &H[0]);
+        }
 
         histogram_metric score = {};
         histogram_score(H, total_weight, score);
@@ -920,15 +975,6 @@ namespace rsimpl
         flicker_cycle = 1000.0f / (state.get_auto_exposure_state(RS_OPTION_FISHEYE_AUTO_EXPOSURE_ANTIFLICKER_RATE) * 2.0f);
     }
 
-    void auto_exposure_algorithm::im_hist(const uint8_t* data, const int width, const int height, const int rowStep, int h[])
-    {
-        std::lock_guard<std::recursive_mutex> lock(state_mutex);
-
-        for (int i = 0; i < 256; ++i) h[i] = 0;
-        const uint8_t* rowData = data;
-        for (int i = 0; i < height; ++i, rowData += rowStep) for (int j = 0; j < width; j+=state.get_auto_exposure_state(RS_OPTION_FISHEYE_AUTO_EXPOSURE_PIXEL_SAMPLE_RATE)) ++h[rowData[j]];
-    }
-
     void auto_exposure_algorithm::increase_exposure_target(float mult, float& target_exposure)
     {
         target_exposure = std::min((exposure * gain) * (1.0f + mult), maximal_exposure * gain_limit);
@@ -214,7 +214,6 @@ namespace rsimpl
         struct histogram_metric { int under_exposure_count; int over_exposure_count; int shadow_limit; int highlight_limit; int lower_q; int upper_q; float main_mean; float main_std; };
         enum class rounding_mode_type { round, ceil, floor };
 
-        inline void im_hist(const uint8_t* data, const int width, const int height, const int rowStep, int h[]);
         void increase_exposure_target(float mult, float& target_exposure);
         void decrease_exposure_target(float mult, float& target_exposure);
         void increase_exposure_gain(const float& target_exposure, const float& target_exposure0, float& exposure, float& gain);
@@ -249,7 +248,7 @@ namespace rsimpl
 
     class auto_exposure_mechanism {
     public:
-        auto_exposure_mechanism(zr300_camera* dev, fisheye_auto_exposure_state auto_exposure_state);
+        auto_exposure_mechanism(zr300_camera* dev, executor & pool, fisheye_auto_exposure_state auto_exposure_state); // Frames are analyzed on a job of pool
         ~auto_exposure_mechanism();
         void add_frame(rs_frame_ref* frame, std::shared_ptr<rsimpl::frame_archive> archive);
         void update_auto_exposure_state(fisheye_auto_exposure_state& auto_exposure_state);
@@ -261,6 +260,8 @@ namespace rsimpl
         };
 
     private:
+        void process_frames();
+        void process_frame(rs_frame_ref* frame_ref);
         void push_back_data(rs_frame_ref* data);
         bool try_pop_front_data(rs_frame_ref** data);
         size_t get_queue_size();
@@ -270,11 +271,11 @@ namespace rsimpl
         bool try_get_exp_by_frame_cnt(double& exposure, const unsigned long long frame_counter);
 
         const std::size_t                      max_size_of_exp_and_cnt_queue = 10;
+        const unsigned                         frame_counter_sample_interval = 8; // Frames analyzed per USB read of the frame counter, when frames carry no exposure
         zr300_camera*                          device;
         auto_exposure_algorithm                auto_exposure_algo;
         std::shared_ptr<rsimpl::frame_archive> sync_archive;
-        std::shared_ptr<std::thread>           exposure_thread;
-        std::condition_variable                cv;
+        std::shared_ptr<executor::job>         exposure_job;
         std::atomic<bool>                      keep_alive;
         std::deque<rs_frame_ref*>              data_queue;
         std::mutex                             queue_mtx;
@@ -282,6 +283,7 @@ namespace rsimpl
         std::atomic<unsigned>                  skip_frames;
         std::deque<exposure_and_frame_counter> exposure_and_frame_counter_queue;
         std::mutex                             exp_and_cnt_queue_mtx;
+        unsigned                               frames_since_counter_sample; // Only touched by the exposure job
     };
 
     class zr300_camera final : public ds::ds_device
@@ -291,6 +293,7 @@ namespace rsimpl
         fisheye_auto_exposure_state              auto_exposure_state;
         std::shared_ptr<auto_exposure_mechanism> auto_exposure;
         std::atomic<bool>                        to_add_frames;
+        std::atomic<int>                         fisheye_exposure, fisheye_gain; // As last written or read, -1 before, so auto-exposure needs no USB read per frame
 
     protected:
         void toggle_motion_module_power(bool bOn);
@@ -306,7 +309,7 @@ namespace rsimpl
         void get_option_range(rs_option option, double & min, double & max, double & step, double & def) override;
         void set_options(const rs_option options[], size_t count, const double values[]) override;
         void get_options(const rs_option options[], size_t count, double values[]) override;
-        void send_blob_to_device(rs_blob_type type, void * data, int size) override;
+        void send_blob_to_device(rs_blob_type type, void * data, int size, const blob_progress & on_progress) override;
         bool supports_option(rs_option option) const override;
 
         void start_motion_tracking() override;
@@ -320,6 +323,7 @@ namespace rsimpl
         rs_motion_intrinsics get_motion_intrinsics() const override;
         rs_extrinsics get_motion_extrinsics_from(rs_stream from) const override;
         unsigned long long get_frame_counter_by_usb_cmd();
+        double get_cached_fisheye_option(rs_option option); // RS_OPTION_FISHEYE_EXPOSURE or RS_OPTION_FISHEYE_GAIN, only read over USB while no value is known
 
        
     private:
@@ -333,7 +337,7 @@ namespace rsimpl
 
         motion_module_calibration fe_intrinsic;
     };
-    motion_module_calibration read_fisheye_intrinsic(uvc::device & device);
+    motion_module_calibration read_fisheye_intrinsic(uvc::device & device, std::timed_mutex & mutex, const std::string & firmware_version); // An empty firmware version bypasses the calibration cache
     std::shared_ptr<rs_device> make_zr300_device(std::shared_ptr<uvc::device> device);
 }
 
@@ -0,0 +1,325 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2015 Intel Corporation. All Rights Reserved.
+
+/////////////////////
+// realsense-bench //
+/////////////////////
+
+// Times the image kernels and frame handoff of the library on synthetic frames, without any camera attached. Every result is printed
+// as one JSON object per line, so that runs before and after a change can be compared by scripts. Pass a substring to only run the
+// benchmarks whose name contains it, and --min-time=<seconds> to time each of them for longer than the default quarter second.
+
+#include "../src/image.h"
+#include "../src/sync.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <algorithm>
+
+namespace
+{
+    struct resolution { int width, height; };
+
+    // Every native resolution of the color, depth, infrared and fisheye streams of the supported cameras
+    const resolution resolutions[] = { { 320, 240 }, { 480, 360 }, { 628, 468 }, { 640, 480 }, { 960, 540 }, { 1280, 720 }, { 1920, 1080 } };
+
+    struct named_format { const char * name; const rsimpl::native_pixel_format * format; };
+    const named_format native_formats[] = {
+        { "raw8", &rsimpl::pf_raw8 }, { "rw10", &rsimpl::pf_rw10 }, { "rw16", &rsimpl::pf_rw16 }, { "yuy2", &rsimpl::pf_yuy2 },
+        { "y8", &rsimpl::pf_y8 }, { "y8i", &rsimpl::pf_y8i }, { "y16", &rsimpl::pf_y16 }, { "y12i", &rsimpl::pf_y12i },
+        { "z16", &rsimpl::pf_z16 }, { "invz", &rsimpl::pf_invz }, { "f200_invi", &rsimpl::pf_f200_invi }, { "f200_inzi", &rsimpl::pf_f200_inzi },
+        { "sr300_invi", &rsimpl::pf_sr300_invi }, { "sr300_inzi", &rsimpl::pf_sr300_inzi }
+    };
+
+    std::string filter;
+    double min_time = 0.25;
+
+    // Runs a kernel until min_time has passed, and reports the mean time of one run, per pixel of the images it handles, and the bytes it read and wrote per second
+    void run(const std::string & name, const std::string & variant, const resolution & res, size_t bytes, const std::function<void()> & kernel, int images_per_run = 1)
+    {
+        if (name.find(filter) == std::string::npos) return;
+
+        kernel(); // Warms up caches and lazily built tables
+        long long runs = 0;
+        const auto start = std::chrono::steady_clock::now();
+        double elapsed;
+        do
+        {
+            kernel();
+            ++runs;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < min_time);
+
+        const double seconds_per_run = elapsed / runs;
+        printf("{\"benchmark\":\"%s\",\"variant\":\"%s\",\"width\":%d,\"height\":%d,\"runs\":%lld,\"ns_per_run\":%.1f,\"ns_per_pixel\":%.4f,\"gb_per_s\":%.3f}\n",
+            name.c_str(), variant.c_str(), res.width, res.height, runs, seconds_per_run * 1e9, seconds_per_run * 1e9 / (static_cast<double>(res.width) * res.height * images_per_run), bytes / seconds_per_run / 1e9);
+        fflush(stdout);
+    }
+
+    std::vector<rsimpl::byte> random_bytes(size_t size)
+    {
+        std::mt19937 engine(size);
+        std::vector<rsimpl::byte> bytes(size);
+        for (auto & b : bytes) b = static_cast<rsimpl::byte>(engine());
+        return bytes;
+    }
+
+    // Depth of a slanted plane between one and three meters, with a hole of no data in one corner
+    std::vector<uint16_t> synthetic_depth(const resolution & res, float units_per_meter)
+    {
+        std::vector<uint16_t> depth(res.width * res.height);
+        for (int y = 0; y < res.height; ++y) for (int x = 0; x < res.width; ++x)
+        {
+            depth[y * res.width + x] = x < res.width / 8 && y < res.height / 8 ? 0 : static_cast<uint16_t>((1.0f + 2.0f * (x + y) / (res.width + res.height)) * units_per_meter);
+        }
+        return depth;
+    }
+
+    rs_intrinsics make_intrinsics(const resolution & res, rs_distortion model)
+    {
+        return { res.width, res.height, res.width / 2.0f, res.height / 2.0f, res.width * 0.9f, res.width * 0.9f, model, { 0.1f, -0.05f, 0.001f, 0.001f, 0.01f } };
+    }
+
+    const rs_extrinsics depth_to_color = { { 0.9999f, 0.0100f, -0.0050f, -0.0100f, 0.9999f, 0.0020f, 0.0050f, -0.0020f, 0.9999f }, { 0.025f, 0.0f, 0.004f } };
+
+    void bench_unpackers(const resolution & res)
+    {
+        const int count = res.width * res.height;
+        const auto source = random_bytes(count * 8); // Enough for the widest native format, and for RW10 which reads past its nominal size
+        for (auto & f : native_formats)
+        {
+            for (auto & unpacker : f.format->unpackers)
+            {
+                std::string outputs;
+                std::vector<std::vector<rsimpl::byte>> buffers;
+                size_t bytes = f.format->get_image_size(res.width, res.height);
+                for (auto & o : unpacker.outputs)
+                {
+                    outputs += std::string(outputs.empty() ? "" : "+") + rs_format_to_string(o.second);
+                    buffers.emplace_back(rsimpl::get_image_size(res.width, res.height, o.second));
+                    bytes += buffers.back().size();
+                }
+                std::vector<rsimpl::byte *> dest;
+                for (auto & b : buffers) dest.push_back(b.data());
+                run(std::string("unpack_") + f.name, outputs, res, bytes, [&]() { unpacker.unpack(dest.data(), source.data(), count); });
+            }
+        }
+
+        // Every instruction set the YUY2 unpackers were built for, which the dispatch above only runs the widest of
+        for (auto * set : rsimpl::get_available_yuy2_unpackers())
+        {
+            std::vector<rsimpl::byte> rgba(count * 4);
+            rsimpl::byte * dest[] = { rgba.data() };
+            run("unpack_yuy2_rgb8", set->name, res, count * 5, [&]() { set->rgb8(dest, source.data(), count); });
+            run("unpack_yuy2_rgba8", set->name, res, count * 6, [&]() { set->rgba8(dest, source.data(), count); });
+        }
+    }
+
+    void bench_deprojection(const resolution & res)
+    {
+        const int count = res.width * res.height;
+        const auto table = rsimpl::compute_deprojection_table(make_intrinsics(res, RS_DISTORTION_NONE));
+        const auto z = synthetic_depth(res, 1000);
+        const auto disparity = synthetic_depth(res, 32);
+        const auto disparity_to_depth = rsimpl::compute_disparity_to_depth_table(32 * 1.0f);
+        std::vector<rsimpl::byte> points(count * 12);
+        for (auto format : { RS_FORMAT_XYZ32F, RS_FORMAT_XYZ16 })
+        {
+            const size_t bytes = count * 2 + rsimpl::get_image_size(res.width, res.height, format);
+            run("deproject_z", rs_format_to_string(format), res, bytes, [&]() { rsimpl::deproject_z(points.data(), format, table, z.data(), 0.001f); });
+            run("deproject_disparity", rs_format_to_string(format), res, bytes, [&]() { rsimpl::deproject_disparity(points.data(), format, table, disparity.data(), disparity_to_depth); });
+        }
+    }
+
+    void bench_alignment(const resolution & res)
+    {
+        const int count = res.width * res.height;
+        const auto depth_intrin = make_intrinsics(res, RS_DISTORTION_NONE), color_intrin = make_intrinsics(res, RS_DISTORTION_MODIFIED_BROWN_CONRADY);
+        const auto rays = rsimpl::compute_alignment_rays(depth_intrin, depth_to_color);
+        const auto z = synthetic_depth(res, 1000);
+        const auto disparity = synthetic_depth(res, 32);
+        const auto disparity_to_depth = rsimpl::compute_disparity_to_depth_table(32 * 1.0f);
+        const auto color = random_bytes(count * 3);
+        std::vector<rsimpl::byte> aligned(count * 3);
+
+        run("align_z_to_other", "z16", res, count * 4, [&]() { rsimpl::align_z_to_other(aligned.data(), z.data(), 0.001f, depth_intrin, rays, depth_to_color, color_intrin); });
+        run("align_disparity_to_other", "disparity16", res, count * 4, [&]() { rsimpl::align_disparity_to_other(aligned.data(), disparity.data(), disparity_to_depth, depth_intrin, rays, depth_to_color, color_intrin); });
+        run("align_other_to_z", "rgb8", res, count * 8, [&]() { rsimpl::align_other_to_z(aligned.data(), z.data(), 0.001f, depth_intrin, rays, depth_to_color, color_intrin, color.data(), RS_FORMAT_RGB8); });
+        run("align_other_to_disparity", "rgb8", res, count * 8, [&]() { rsimpl::align_other_to_disparity(aligned.data(), disparity.data(), disparity_to_depth, depth_intrin, rays, depth_to_color, color_intrin, color.data(), RS_FORMAT_RGB8); });
+    }
+
+    void bench_rectification(const resolution & res)
+    {
+        const int count = res.width * res.height;
+        const rs_extrinsics identity = { { 1, 0, 0, 0, 1, 0, 0, 0, 1 }, { 0, 0, 0 } };
+        const auto table = rsimpl::compute_rectification_table(make_intrinsics(res, RS_DISTORTION_NONE), identity, make_intrinsics(res, RS_DISTORTION_MODIFIED_BROWN_CONRADY));
+        const auto unrect = random_bytes(count * 4);
+        std::vector<uint8_t> rect(count * 4);
+        for (auto format : { RS_FORMAT_Y8, RS_FORMAT_RGB8, RS_FORMAT_RGBA8 })
+        {
+            const size_t bytes = rsimpl::get_image_size(res.width, res.height, format) * 2;
+            run("rectify_image", rs_format_to_string(format), res, bytes, [&]() { rsimpl::rectify_image(rect.data(), table, unrect.data(), format); });
+        }
+    }
+
+    // A capture thread commits depth frames while the application thread waits for framesets, as in wait_for_frames(). Frames the
+    // application falls behind on are dropped by the queue, as they would be while streaming, and the run ends with the last one.
+    void bench_archive(const resolution & res)
+    {
+        const rs_intrinsics intrin = make_intrinsics(res, RS_DISTORTION_NONE);
+        const rsimpl::subdevice_mode mode = { 0, { res.width, res.height }, rsimpl::pf_z16, 30, intrin, {}, { 0 } };
+        std::atomic<uint32_t> max_size(RS_USER_QUEUE_SIZE), event_queue_size(RS_MAX_EVENT_QUEUE_SIZE), events_timeout(RS_MAX_EVENT_TIME_OUT);
+        rsimpl::stream_queue_policy policies[RS_STREAM_NATIVE_COUNT];
+        for (auto & p : policies) p = { 2, RS_FRAME_DROP_POLICY_DROP_OLDEST };
+        rsimpl::syncronizing_archive archive({ rsimpl::subdevice_mode_selection(mode, 0, 0) }, RS_STREAM_DEPTH, &max_size, &event_queue_size, &events_timeout, policies);
+
+        const auto z = synthetic_depth(res, 1000);
+        const int frames_per_run = 64;
+        unsigned long long last = 0;
+        run("archive_commit_wait", "depth", res, z.size() * 2 * frames_per_run, [&]()
+        {
+            const auto first = last + 1;
+            last += frames_per_run;
+            std::thread producer([&]()
+            {
+                for (auto number = first; number <= last; ++number)
+                {
+                    rsimpl::frame_archive::frame_additional_data data;
+                    data.frame_number = number;
+                    data.width = data.stride_x = res.width;
+                    data.height = data.stride_y = res.height;
+                    data.bpp = 16;
+                    data.format = RS_FORMAT_Z16;
+                    data.stream_type = RS_STREAM_DEPTH;
+                    rsimpl::byte * dest;
+                    while (!(dest = archive.alloc_frame(RS_STREAM_DEPTH, data, true))) std::this_thread::yield(); // Until the application releases a frame
+                    memcpy(dest, z.data(), z.size() * 2);
+                    archive.commit_frame(RS_STREAM_DEPTH);
+                }
+            });
+            while (archive.try_wait_for_frames(std::chrono::milliseconds(1000)) && archive.get_frame_number(RS_STREAM_DEPTH) < last) {}
+            producer.join();
+        }, frames_per_run);
+        archive.flush();
+    }
+
+    // Framesets of 60 fps depth and 30 fps color, whose timestamps jitter, with frames dropped and color frames now and then arriving after the
+    // next one, matched to their nearest frame or within a tolerance. Reported as an image one pixel per depth frame wide, so that ns_per_pixel
+    // is the cost of forming one frameset, and followed by the largest skew between the frames of a frameset and the framesets left without color.
+    void bench_sync()
+    {
+        struct arrival { rs_stream stream; double timestamp, arrival_time; };
+        std::mt19937 engine(42);
+        std::normal_distribution<double> jitter(0, 1.5);
+        std::uniform_real_distribution<double> chance(0, 1);
+        const int depth_frames = 240;
+        const double duration = depth_frames * 1000.0 / 60;
+        std::vector<arrival> schedule;
+        for (int i = 0; i < depth_frames; ++i)
+        {
+            const double t = i * 1000.0 / 60 + jitter(engine);
+            if (chance(engine) > 0.05) schedule.push_back({ RS_STREAM_DEPTH, t, t + 1 });
+            if (i % 2) continue;
+            const double c = t + 2 + jitter(engine);
+            if (chance(engine) > 0.05) schedule.push_back({ RS_STREAM_COLOR, c, c + (chance(engine) < 0.1 ? 40 : 1) });
+        }
+        std::stable_sort(schedule.begin(), schedule.end(), [](const arrival & a, const arrival & b) { return a.arrival_time < b.arrival_time; });
+        const resolution per_frame = { static_cast<int>(std::count_if(schedule.begin(), schedule.end(), [](const arrival & a) { return a.stream == RS_STREAM_DEPTH; })), 1 };
+
+        const resolution image = { 8, 2 };
+        const rs_intrinsics intrin = make_intrinsics(image, RS_DISTORTION_NONE);
+        const rsimpl::subdevice_mode depth_mode = { 0, { image.width, image.height }, rsimpl::pf_z16, 60, intrin, {}, { 0 } };
+        const rsimpl::subdevice_mode color_mode = { 1, { image.width, image.height }, rsimpl::pf_yuy2, 30, intrin, {}, { 0 } };
+        for (double tolerance : { 0.0, 8.0 })
+        {
+            std::atomic<uint32_t> max_size(RS_USER_QUEUE_SIZE), event_queue_size(RS_MAX_EVENT_QUEUE_SIZE), events_timeout(RS_MAX_EVENT_TIME_OUT);
+            rsimpl::stream_queue_policy policies[RS_STREAM_NATIVE_COUNT];
+            for (auto & p : policies) p = { 4, RS_FRAME_DROP_POLICY_DROP_OLDEST };
+            rsimpl::syncronizing_archive archive({ rsimpl::subdevice_mode_selection(depth_mode, 0, 0), rsimpl::subdevice_mode_selection(color_mode, 0, 0) }, RS_STREAM_DEPTH, &max_size, &event_queue_size, &events_timeout, policies);
+            archive.set_sync_tolerance(RS_STREAM_COLOR, tolerance);
+
+            const std::string variant = tolerance > 0 ? "tolerance " + std::to_string(static_cast<int>(tolerance)) + " ms" : "nearest";
+            double offset = 0, max_skew = 0;
+            unsigned long long number = 0, framesets = 0, without_color = 0;
+            run("sync_frameset", variant, per_frame, 0, [&]()
+            {
+                for (auto & a : schedule)
+                {
+                    rsimpl::frame_archive::frame_additional_data data;
+                    data.frame_number = ++number;
+                    data.timestamp = a.timestamp + offset;
+                    data.width = data.stride_x = image.width;
+                    data.height = data.stride_y = image.height;
+                    data.bpp = 16;
+                    data.format = a.stream == RS_STREAM_DEPTH ? RS_FORMAT_Z16 : RS_FORMAT_YUYV;
+                    data.stream_type = a.stream;
+                    if (!archive.alloc_frame(a.stream, data, true)) continue;
+                    archive.commit_frame(a.stream);
+                    while (archive.poll_for_frames())
+                    {
+                        ++framesets;
+                        if (!archive.get_frame_data(RS_STREAM_COLOR)) ++without_color;
+                        else max_skew = (std::max)(max_skew, std::fabs(archive.get_frame_timestamp(RS_STREAM_COLOR) - archive.get_frame_timestamp(RS_STREAM_DEPTH)));
+                    }
+                }
+                offset += duration;
+            });
+            archive.flush();
+            if (framesets && std::string("sync_frameset").find(filter) != std::string::npos)
+            {
+                printf("{\"benchmark\":\"sync_skew\",\"variant\":\"%s\",\"framesets\":%llu,\"max_skew_ms\":%.2f,\"without_color\":%.4f}\n", variant.c_str(), framesets, max_skew, static_cast<double>(without_color) / framesets);
+                fflush(stdout);
+            }
+        }
+    }
+
+    // Threads allocate and release objects of one small_heap at once, the pattern of frame callback threads sharing the frame pool.
+    // Reported as an image one pixel per allocation wide, so that ns_per_pixel is the time of one allocation and release.
+    void bench_small_heap()
+    {
+        const int operations = 1 << 16;
+        const resolution per_operation = { operations, 1 };
+        for (int threads = 1; threads <= static_cast<int>((std::max)(2u, std::thread::hardware_concurrency())); threads *= 2)
+        {
+            rsimpl::small_heap<int> heap(128, 128);
+            run("small_heap", std::to_string(threads) + " threads", per_operation, 0, [&]()
+            {
+                std::vector<std::thread> workers;
+                for (int t = 0; t < threads; ++t) workers.emplace_back([&]()
+                {
+                    for (int i = 0; i < operations / threads; ++i) if (auto item = heap.allocate()) heap.deallocate(item);
+                });
+                for (auto & w : workers) w.join();
+            });
+        }
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], "--min-time=", 11) == 0) min_time = atof(argv[i] + 11);
+        else filter = argv[i];
+    }
+
+    for (auto & res : resolutions)
+    {
+        bench_unpackers(res);
+        bench_deprojection(res);
+        bench_alignment(res);
+        bench_rectification(res);
+        bench_archive(res);
+    }
+    bench_sync();
+    bench_small_heap();
+    return EXIT_SUCCESS;
+}
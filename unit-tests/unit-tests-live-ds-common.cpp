@@ -112,7 +112,36 @@ TEST_CASE("DS-device devices support all required options", "[live] [DS-device]"
                 RS_OPTION_R200_DEPTH_CONTROL_SECOND_PEAK_THRESHOLD,
                 RS_OPTION_R200_DEPTH_CONTROL_NEIGHBOR_THRESHOLD,
                 RS_OPTION_R200_DEPTH_CONTROL_LR_THRESHOLD,
-                RS_OPTION_FRAMES_QUEUE_SIZE
+                RS_OPTION_FRAMES_QUEUE_SIZE,
+                RS_OPTION_FRAME_UNPACK_THREADS,
+                RS_OPTION_DEPTH_DECIMATION_FACTOR,
+                RS_OPTION_DEPTH_DECIMATION_MODE,
+                RS_OPTION_DEPTH_SPATIAL_FILTER_ALPHA,
+                RS_OPTION_DEPTH_SPATIAL_FILTER_DELTA,
+                RS_OPTION_DEPTH_TEMPORAL_FILTER_ALPHA,
+                RS_OPTION_DEPTH_TEMPORAL_FILTER_DELTA,
+                RS_OPTION_DEPTH_TEMPORAL_FILTER_PERSISTENCE,
+                RS_OPTION_DEPTH_STATISTICS_ENABLED,
+                RS_OPTION_PRECOMPUTED_STREAMS,
+                RS_OPTION_DEPTH_COLORIZER_EQUALIZATION_ENABLED,
+                RS_OPTION_DEPTH_COLORIZER_MAX_DISTANCE,
+                RS_OPTION_POINTS_VOXEL_SIZE,
+                RS_OPTION_CAPTURE_THREAD_AFFINITY,
+                RS_OPTION_CAPTURE_THREAD_PRIORITY,
+                RS_OPTION_CAPTURE_MEMORY,
+                RS_OPTION_CONTROL_RETRY_BUDGET,
+                RS_OPTION_GPU_PROCESSING_ENABLED,
+                RS_OPTION_DERIVED_ROW_ALIGNMENT,
+                RS_OPTION_FRAME_MEMORY_PAGES,
+                RS_OPTION_NUMA_LOCALITY_ENABLED,
+                RS_OPTION_FRAME_MAILBOX_ENABLED,
+                RS_OPTION_INTERLEAVED_VIEWS_ENABLED,
+                RS_OPTION_DEPTH_PYRAMID_LEVELS,
+                RS_OPTION_FRAME_UNPACK_BANDS,
+                RS_OPTION_COLOR_DEMOSAIC_MODE,
+                RS_OPTION_DEPTH_RUNS_ENABLED,
+                RS_OPTION_INCREMENTAL_PROCESSING_ENABLED,
+                RS_OPTION_ZERO_COPY_ENABLED
             };
 
             std::stringstream ss;
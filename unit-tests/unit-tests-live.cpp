@@ -77,6 +77,45 @@ TEST_CASE("Start-Stop stream sequence", "[live]")
     }
 }
 
+TEST_CASE("Pause-Resume stream sequence", "[live]")
+{
+    // Require at least one device to be plugged in
+    safe_context ctx;
+    const int device_count = rs_get_device_count(ctx, require_no_error());
+    REQUIRE(device_count > 0);
+
+    rs_device * dev = rs_get_device(ctx, 0, require_no_error());
+    REQUIRE(dev != nullptr);
+    rs_enable_stream_preset(dev, RS_STREAM_DEPTH, RS_PRESET_BEST_QUALITY, require_no_error());
+
+    rs_pause_device(dev, require_error("cannot pause device without first starting device"));
+    rs_start_device(dev, require_no_error());
+    rs_resume_device(dev, require_error("cannot resume device without first pausing device"));
+    rs_wait_for_frames(dev, require_no_error());
+
+    for (int i = 0; i < 5; i++)
+    {
+        rs_pause_device(dev, require_no_error());
+        REQUIRE(rs_is_device_paused(dev, require_no_error()) == 1);
+        REQUIRE(rs_is_device_streaming(dev, require_no_error()) == 1);
+        rs_resume_device(dev, require_no_error());
+        REQUIRE(rs_is_device_paused(dev, require_no_error()) == 0);
+
+        // Frames keep coming after every resume
+        auto frame_number = rs_get_frame_number(dev, RS_STREAM_DEPTH, require_no_error());
+        rs_wait_for_frames(dev, require_no_error());
+        rs_wait_for_frames(dev, require_no_error());
+        REQUIRE(rs_get_frame_number(dev, RS_STREAM_DEPTH, require_no_error()) != frame_number);
+    }
+
+    // A paused device can be stopped like a streaming one
+    rs_pause_device(dev, require_no_error());
+    rs_stop_device(dev, require_no_error());
+    REQUIRE(rs_is_device_paused(dev, require_no_error()) == 0);
+    REQUIRE(rs_is_device_streaming(dev, require_no_error()) == 0);
+    rs_disable_stream(dev, RS_STREAM_DEPTH, require_no_error());
+}
+
 ///////////////////////////////////
 // Calibration information tests //
 ///////////////////////////////////
@@ -7,9 +7,48 @@
 #include "catch/catch.hpp"
 
 #include "unit-tests-common.h"
+#include <librealsense/rs.hpp>
 #include "../src/device.h"
+#include "../src/archive.h"
+#include "../src/sync.h"
+#include "../src/image.h"
+#include "../src/pipeline.h"
+#include "../src/option-queue.h"
+#include "../src/option-cache.h"
+#include "../src/hw-command-queue.h"
+#include "../src/callback-queue.h"
+#include "../src/motion-history.h"
+#include "../src/recording.h"
+#include "../src/shared-ring.h"
+#include "../src/frame-history.h"
+#include "../src/depth-codec.h"
+#include "../src/network.h"
+#include "../src/executor.h"
+#include "../src/task-graph.h"
+#include "../src/calibration-store.h"
+#include "../src/multi-sync.h"
+#include "../src/bandwidth-planner.h"
+#include "../src/trace.h"
+#include "../src/fw-log.h"
+#include "../src/numa.h"
+#include "../src/video-encoder.h"
+#include "../src/motion-module.h"
+#include "../include/librealsense/rsutil.h"
 
 #include <sstream>
+#include <fstream>
+#include <numeric>
+#include <array>
+#include <map>
+#include <tuple>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/stat.h>
+#endif
 
 static std::string unknown = "UNKNOWN"; 
 
@@ -35,196 +74,5593 @@ TEST_CASE("wraparound_mechanism produces correct output", "[offline] [validation
     }
 }
 
+TEST_CASE("wraparound_mechanism fixes a batch as it fixes numbers one by one", "[offline] [validation]")
+{
+    rsimpl::wraparound_mechanism<unsigned long long> single(0, 0xfff), batch(0, 0xfff);
+
+    std::vector<unsigned long long> numbers;
+    for (unsigned i = 0; i < 20000; i += 7) numbers.push_back(i & 0xfff);
+    numbers.push_back(0); // A repeated drop counts as a further wraparound, as it does for single numbers
+
+    std::vector<unsigned long long> expected;
+    for (auto n : numbers) expected.push_back(single.fix(n));
+
+    batch.fix(numbers.data(), 100);
+    batch.fix(numbers.data() + 100, numbers.size() - 100);
+    REQUIRE(numbers == expected);
+    REQUIRE(single.fix(5) == batch.fix(5));
+}
+
+TEST_CASE("motion_module_parser decodes a transfer and fixes its wraparounds in batch", "[offline] [validation]")
+{
+    const int packet_size = 8 + 4 * 12 + 8 * 6;
+    std::vector<unsigned char> transfer(packet_size * 3);
+
+    auto write_entry = [](unsigned char * p, int raw_source, unsigned frame_number, uint32_t ticks, bool valid)
+    {
+        unsigned short id = (unsigned short)(raw_source | (frame_number << 3) | (valid ? 0x8000 : 0));
+        memcpy(p, &id, sizeof(id));
+        memcpy(p + 2, &ticks, sizeof(ticks));
+    };
+    auto write_header = [&](int packet, unsigned short error, unsigned short imu, unsigned short non_imu)
+    {
+        unsigned short header[4] = { error, 0, imu, non_imu };
+        memcpy(&transfer[packet * packet_size], header, sizeof(header));
+    };
+
+    // First packet: an accelerometer and a gyroscope sample, and a depth frame timestamp about to wrap around
+    write_header(0, 0, 2, 1);
+    short accel[3] = { 256, -512, 0 }, gyro[3] = { 100, -200, 32767 }; // Accelerations of 16 and -32 in the upper 12 bits
+    write_entry(&transfer[8], 1, 0xffe, 0xfffffff0, true);
+    memcpy(&transfer[8 + 6], accel, sizeof(accel));
+    write_entry(&transfer[8 + 12], 2, 0xfff, 0xfffffff8, false);
+    memcpy(&transfer[8 + 12 + 6], gyro, sizeof(gyro));
+    write_entry(&transfer[56], 3, 0xfff, 0xffffff00, false);
+
+    // Second packet: the counters of the same sources wrap around
+    write_header(1, 0, 1, 1);
+    write_entry(&transfer[packet_size + 8], 1, 0x001, 0x10, true);
+    memcpy(&transfer[packet_size + 8 + 6], accel, sizeof(accel));
+    write_entry(&transfer[packet_size + 56], 3, 0x000, 0x20, false);
+
+    // Third packet reports an error, and is dropped
+    write_header(2, 1, 1, 0);
+
+    rsimpl::motion_module::motion_module_parser parser;
+    auto & events = parser(transfer.data(), (int)transfer.size());
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].imu_entries_num == 2);
+    REQUIRE(events[0].non_imu_entries_num == 1);
+
+    auto & a0 = events[0].imu_packets[0];
+    REQUIRE(a0.timestamp_data.source_id == RS_EVENT_IMU_ACCEL);
+    REQUIRE(a0.timestamp_data.frame_number == 0xffe);
+    REQUIRE(a0.timestamp_data.timestamp == Approx(0xfffffff0 * 0.00003125));
+    REQUIRE(a0.is_valid == 1);
+    REQUIRE(a0.axes[0] == Approx(16 * 9.80665f * 4.f / 2048.f));
+    REQUIRE(a0.axes[1] == Approx(-32 * 9.80665f * 4.f / 2048.f));
+    REQUIRE(a0.axes[2] == 0);
+
+    auto & g0 = events[0].imu_packets[1];
+    REQUIRE(g0.timestamp_data.source_id == RS_EVENT_IMU_GYRO);
+    REQUIRE(g0.is_valid == 0);
+    REQUIRE(g0.axes[0] == Approx(100 * 1000.f * 3.14159265358979 / (180.f * 32767.f)));
+    REQUIRE(g0.axes[2] == Approx(1000.f * 3.14159265358979 / 180.f));
+
+    auto & a1 = events[1].imu_packets[0];
+    REQUIRE(a1.timestamp_data.frame_number == 0x1001);
+    REQUIRE(a1.timestamp_data.timestamp == Approx((0x10 + 0xffffffffull) * 0.00003125));
+
+    REQUIRE(events[0].non_imu_packets[0].source_id == RS_EVENT_IMU_DEPTH_CAM);
+    REQUIRE(events[1].non_imu_packets[0].frame_number == 0x1000);
+    REQUIRE(events[1].non_imu_packets[0].timestamp == Approx((0x20 + 0xffffffffull) * 0.00003125));
+
+    // The correction carries over to the next transfer, into the same buffer
+    write_header(0, 0, 0, 1);
+    write_entry(&transfer[56], 3, 0x001, 0x30, false);
+    auto & next = parser(transfer.data(), packet_size);
+    REQUIRE(&next == &events);
+    REQUIRE(next.size() == 1);
+    REQUIRE(next[0].non_imu_packets[0].frame_number == 0x1001);
+}
+
+TEST_CASE("lock_free_queue preserves order and capacity", "[offline] [validation]")
+{
+    rsimpl::lock_free_queue<int, 4> queue;
+    int value = 0;
+    REQUIRE(queue.empty());
+    REQUIRE(!queue.try_dequeue(value));
+
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 4; ++i) REQUIRE(queue.try_enqueue(round * 10 + i));
+        REQUIRE(!queue.try_enqueue(99));
+        for (int i = 0; i < 4; ++i)
+        {
+            REQUIRE(queue.try_dequeue(value));
+            REQUIRE(value == round * 10 + i);
+        }
+        REQUIRE(queue.empty());
+    }
+}
+
+TEST_CASE("ring_queue preserves order and capacity", "[offline] [validation]")
+{
+    rsimpl::ring_queue<int, 4> queue;
+    REQUIRE(queue.empty());
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 4; ++i) queue.push_back(round * 10 + i);
+        REQUIRE(queue.full());
+        REQUIRE(queue.back() == round * 10 + 3);
+        for (int i = 0; i < 4; ++i) REQUIRE(queue[i] == round * 10 + i);
+        for (int i = 0; i < 3; ++i)
+        {
+            REQUIRE(queue.front() == round * 10 + i);
+            queue.pop_front();
+        }
+        REQUIRE(queue.size() == 1);
+        queue.pop_front();
+        REQUIRE(queue.empty());
+    }
+}
+
+TEST_CASE("frames are matched to the closest within tolerance", "[offline] [validation]")
+{
+    const std::vector<double> timestamps = { 10, 20, 29, 32, 45, 60 };
+    auto timestamp = [&timestamps](size_t i) { return timestamps[i]; };
+    size_t passed = 0;
+
+    REQUIRE(rsimpl::match_within_tolerance(timestamps.size(), timestamp, 31, 5, passed) == 3);
+    REQUIRE(passed == 3); // 10 and 20 are too old, 29 was beaten by a closer frame
+    REQUIRE(rsimpl::match_within_tolerance(timestamps.size(), timestamp, 20, 0.5, passed) == 1);
+    REQUIRE(passed == 1);
+
+    // Without a frame in the window, only the frames before it are passed over, scanning stops at the first frame after it
+    REQUIRE(rsimpl::match_within_tolerance(timestamps.size(), timestamp, 52, 4, passed) == -1);
+    REQUIRE(passed == 5);
+    REQUIRE(rsimpl::match_within_tolerance(timestamps.size(), timestamp, 0, 4, passed) == -1);
+    REQUIRE(passed == 0);
+    REQUIRE(rsimpl::match_within_tolerance(0, timestamp, 30, 5, passed) == -1);
+    REQUIRE(passed == 0);
+}
+
+TEST_CASE("small_heap hands out every slot exactly once", "[offline] [validation]")
+{
+    rsimpl::small_heap<int> heap(8, 8);
+    std::vector<int *> items;
+    for (int i = 0; i < 8; ++i)
+    {
+        auto item = heap.allocate();
+        REQUIRE(item != nullptr);
+        REQUIRE(std::find(items.begin(), items.end(), item) == items.end());
+        items.push_back(item);
+    }
+    REQUIRE(heap.allocate() == nullptr);
+
+    int outside = 0;
+    REQUIRE_THROWS(heap.deallocate(&outside));
+
+    heap.deallocate(items.back());
+    items.pop_back();
+    auto item = heap.allocate();
+    REQUIRE(item != nullptr);
+    items.push_back(item);
+
+    std::thread releaser([&]() { for (auto i : items) heap.deallocate(i); });
+    heap.stop_allocation();
+    heap.wait_until_empty();
+    releaser.join();
+    REQUIRE(heap.allocate() == nullptr);
+}
+
+TEST_CASE("small_heap grows by chunks up to its capacity and keeps its objects in place", "[offline] [validation]")
+{
+    rsimpl::small_heap<int> heap(4, 10);
+    REQUIRE(heap.get_capacity() == 10);
+    REQUIRE(heap.get_allocated_capacity() == 4);
+
+    std::vector<int *> items;
+    for (int i = 0; i < 10; ++i)
+    {
+        auto item = heap.allocate();
+        REQUIRE(item != nullptr);
+        REQUIRE(std::find(items.begin(), items.end(), item) == items.end());
+        *item = i;
+        items.push_back(item);
+    }
+    REQUIRE(heap.get_allocated_capacity() == 10);
+    REQUIRE(heap.allocate() == nullptr);
+    for (int i = 0; i < 10; ++i) REQUIRE(*items[i] == i);
+
+    // Objects of every chunk go back to the pool, and are handed out again before any new chunk would be
+    heap.deallocate(items[1]);
+    heap.deallocate(items[9]);
+    auto again = heap.allocate();
+    REQUIRE((again == items[1] || again == items[9]));
+    REQUIRE(*again == 0);
+    heap.deallocate(again);
+    for (int i = 0; i < 10; ++i) if (items[i] != items[1] && items[i] != items[9]) heap.deallocate(items[i]);
+    heap.stop_allocation();
+    heap.wait_until_empty();
+}
+
+TEST_CASE("frame metadata is stored inline and looked up by mask", "[offline] [validation]")
+{
+    typedef rsimpl::frame_archive::frame_additional_data additional_data;
+    auto mask = additional_data::get_metadata_mask({ RS_FRAME_METADATA_ACTUAL_FPS });
+    REQUIRE(mask == 1u << RS_FRAME_METADATA_ACTUAL_FPS);
+
+    rsimpl::frame_archive::frame f;
+    f.additional_data = additional_data(1.0, 2, 3, 640, 480, 30, 640, 480, 2, RS_FORMAT_Z16, RS_STREAM_DEPTH, 0, mask, 10.0, 29.5);
+    REQUIRE(f.supports_frame_metadata(RS_FRAME_METADATA_ACTUAL_FPS));
+    REQUIRE(!f.supports_frame_metadata(RS_FRAME_METADATA_ACTUAL_EXPOSURE));
+    REQUIRE(!f.supports_frame_metadata(RS_FRAME_METADATA_COUNT));
+    REQUIRE(f.get_frame_metadata(RS_FRAME_METADATA_ACTUAL_FPS) == 29.5);
+    REQUIRE_THROWS(f.get_frame_metadata(RS_FRAME_METADATA_ACTUAL_EXPOSURE));
+}
+
+TEST_CASE("frame continuations hold the release of a driver buffer inline and run it once", "[offline] [validation]")
+{
+    auto ring = std::make_shared<int>(0);
+    int index = 3;
+    int released = 0;
+    auto release = [ring, index, &released]() { released += index; };
+    static_assert(sizeof(release) <= rsimpl::inline_function::capacity, "a shared handle and an index fit inline");
+
+    rsimpl::frame_continuation a(release, &index), b;
+    REQUIRE(a.get_data() == &index);
+    b = std::move(a);
+    REQUIRE(a.get_data() == nullptr);
+    REQUIRE(b.get_data() == &index);
+    REQUIRE(ring.use_count() == 3);
+    REQUIRE(released == 0);
+
+    b();
+    REQUIRE(released == 3);
+    REQUIRE(ring.use_count() == 2);
+    b();
+    REQUIRE(released == 3);
+
+    {
+        rsimpl::frame_continuation c(release, &index);
+        rsimpl::frame_continuation d(std::move(c));
+        c = rsimpl::frame_continuation(release, &index); // Moving over a released continuation runs nothing
+        REQUIRE(released == 3);
+        d = std::move(c);                                 // Moving over a held one runs it first
+        REQUIRE(released == 6);
+        rsimpl::frame_continuation e(release, &index);
+        e.reset();                                        // Discards without running
+    }
+    REQUIRE(released == 9);
+    REQUIRE(ring.use_count() == 2);
+}
+
+TEST_CASE("frame_buffer_pool recycles buffers by size class", "[offline] [validation]")
+{
+    REQUIRE(rsimpl::frame_buffer_pool::get_size_class(1) == 4096);
+    REQUIRE(rsimpl::frame_buffer_pool::get_size_class(640 * 480 * 2) == 655360);
+    REQUIRE(rsimpl::frame_buffer_pool::get_size_class(1920 * 1080 * 3) == 6291456);
+    for (size_t size = 4000; size < 10000000; size = size * 3 / 2)
+    {
+        auto size_class = rsimpl::frame_buffer_pool::get_size_class(size);
+        REQUIRE(size_class >= size);
+        REQUIRE(size_class <= size + size / 4 + 4096);
+    }
+
+    rsimpl::frame_buffer_pool pool(rsimpl::get_default_frame_allocator());
+    pool.reserve(640 * 480 * 2, 1);
+    auto buffer = pool.acquire(640 * 480 * 2);
+    REQUIRE(buffer.size() == 640 * 480 * 2);
+    REQUIRE(reinterpret_cast<uintptr_t>(buffer.data()) % 64 == 0);
+    auto first_block = buffer.data();
+    pool.recycle(std::move(buffer));
+    REQUIRE(buffer.empty());
+
+    // A slightly smaller frame falls in the same size class, and should reuse the same block
+    auto smaller = pool.acquire(640 * 480 * 2 - 100);
+    REQUIRE(smaller.data() == first_block);
+    REQUIRE(smaller.size() == 640 * 480 * 2 - 100);
+}
+
+TEST_CASE("frame memory is accounted, and the pool gives it back while over budget", "[offline] [validation]")
+{
+    auto account = std::make_shared<rsimpl::memory_account>();
+    rsimpl::frame_buffer_pool pool(std::make_shared<rsimpl::accounted_frame_allocator>(rsimpl::get_default_frame_allocator(), account));
+    pool.set_memory_account(account);
+    const size_t size_class = rsimpl::frame_buffer_pool::get_size_class(640 * 480 * 2);
+    pool.reserve(640 * 480 * 2, 2);
+    REQUIRE(account->get_current() == 2 * size_class);
+    REQUIRE(pool.get_pooled_bytes() == 2 * size_class);
+
+    auto a = pool.acquire(640 * 480 * 2), b = pool.acquire(640 * 480 * 2), c = pool.acquire(640 * 480 * 2);
+    REQUIRE(account->get_current() == 3 * size_class);
+    REQUIRE(account->get_peak() == 3 * size_class);
+    pool.recycle(std::move(c));
+    REQUIRE(pool.get_pooled_bytes() == size_class); // Kept while there is no budget
+
+    // Over budget, released buffers go back to the allocator along with those pooled
+    account->set_budget(2 * size_class);
+    REQUIRE(account->is_over_budget());
+    pool.recycle(std::move(b));
+    REQUIRE(pool.get_pooled_bytes() == 0);
+    REQUIRE(account->get_current() == size_class);
+    REQUIRE(!account->is_over_budget());
+    pool.recycle(std::move(a));
+    REQUIRE(pool.get_pooled_bytes() == size_class);
+    REQUIRE(account->get_peak() == 3 * size_class);
+}
+
+TEST_CASE("mapped_frame_allocator reports the pages it could provide", "[offline] [validation]")
+{
+    for (auto pages : { rsimpl::frame_memory_pages::transparent_huge, rsimpl::frame_memory_pages::explicit_huge })
+    {
+        auto allocator = std::make_shared<rsimpl::mapped_frame_allocator>(pages);
+        rsimpl::frame_buffer_pool pool(allocator);
+        auto buffer = pool.acquire(1920 * 1080 * 3);
+        REQUIRE(buffer.size() == 1920 * 1080 * 3);
+#ifdef __linux__
+        REQUIRE(reinterpret_cast<uintptr_t>(buffer.data()) % (2 << 20) == 0);
+#endif
+        memset(buffer.data(), 0x5A, buffer.size());
+        REQUIRE(buffer.data()[buffer.size() - 1] == 0x5A);
+        REQUIRE(allocator->get_provided_pages() <= pages);
+        pool.recycle(std::move(buffer));
+    }
+}
+
+TEST_CASE("NUMA placement parses the topology sysfs reports", "[offline] [validation]")
+{
+    REQUIRE(rsimpl::numa::parse_cpu_list("0-3,8,10-11\n") == 0xD0Full);
+    REQUIRE(rsimpl::numa::parse_cpu_list("60-70") == 0xF000000000000000ull);
+    REQUIRE(rsimpl::numa::parse_cpu_list("") == 0);
+    REQUIRE(rsimpl::numa::get_usb_node("not-a-port") == -1);
+    REQUIRE(rsimpl::numa::get_usb_node("/recordings/device.bin") == -1);
+    REQUIRE(rsimpl::numa::get_node_cpu_mask(-1) == 0);
+
+    // Memory of a node is mapped in whole pages, whether or not the system can place it there
+    auto allocator = std::make_shared<rsimpl::mapped_frame_allocator>(rsimpl::frame_memory_pages::heap, 0);
+    rsimpl::frame_buffer buffer(allocator, 640 * 480 * 2);
+    REQUIRE(reinterpret_cast<uintptr_t>(buffer.data()) % 4096 == 0);
+    memset(buffer.data(), 0x5A, 640 * 480 * 2);
+    REQUIRE(allocator->get_provided_pages() == rsimpl::frame_memory_pages::heap);
+}
+
+TEST_CASE("user_frame_buffers hand out the buffers of the application, and the heap once they run out", "[offline] [validation]")
+{
+    std::vector<uint8_t> a(1000), b(1000);
+    void * buffers[] = { a.data(), b.data() };
+    auto user = std::make_shared<rsimpl::user_frame_buffers>(buffers, 2, 1000);
+
+    rsimpl::frame_buffer first(user, 1000), second(user, 800), third(user, 800), large;
+    REQUIRE(user->get_index(first.data()) == 0);
+    REQUIRE(user->get_index(second.data()) == 1);
+    REQUIRE(user->get_index(third.data()) == -1);
+    large = rsimpl::frame_buffer(user, 1001);
+    REQUIRE(user->get_index(large.data()) == -1);
+
+    // A buffer released is handed out again, and a pool of library buffers gives it back rather than keeping it
+    rsimpl::frame_buffer_pool pool(rsimpl::get_default_frame_allocator());
+    pool.recycle(std::move(second));
+    rsimpl::frame_buffer again(user, 1000);
+    REQUIRE(user->get_index(again.data()) == 1);
+}
+
+TEST_CASE("yuy2 unpackers agree across instruction sets", "[offline] [validation]")
+{
+    auto variants = rsimpl::get_available_yuy2_unpackers();
+    REQUIRE(!variants.empty());
+    REQUIRE(std::string(variants.front()->name) == "scalar");
+
+    // 7 blocks of 16 pixels exercise the 64, 32 and 16 pixel steps of every variant
+    const int n = 16 * 7;
+    std::vector<rsimpl::byte> yuy2(n * 2);
+    for (size_t i = 0; i < yuy2.size(); ++i) yuy2[i] = static_cast<rsimpl::byte>(i * 37 + (i >> 3) * 11);
+
+    auto unpack = [&](void(*fn)(rsimpl::byte * const[], const rsimpl::byte *, int), int bpp)
+    {
+        std::vector<rsimpl::byte> out(n * bpp + 16, 0xcd);
+        rsimpl::byte * dest[] = { out.data() };
+        fn(dest, yuy2.data(), n);
+        for (int i = n * bpp; i < n * bpp + 16; ++i) REQUIRE(out[i] == 0xcd); // No writes past the end of the image
+        out.resize(n * bpp);
+        return out;
+    };
+
+    // A pair of rows into both luminance rows and their chroma, interleaved or planar, with the pixels a variant leaves over done by the portable code
+    std::vector<rsimpl::byte> yuy2_below(yuy2.rbegin(), yuy2.rend());
+    auto unpack420 = [&](int(*fn)(rsimpl::byte *, rsimpl::byte *, rsimpl::byte *, rsimpl::byte *, const rsimpl::byte *, const rsimpl::byte *, int), bool planar)
+    {
+        std::vector<rsimpl::byte> out(n * 3 + 16, 0xcd);
+        rsimpl::byte * y0 = out.data(), * y1 = y0 + n, * u = y1 + n, * v = planar ? u + n / 2 : nullptr;
+        const int done = fn(y0, y1, u, v, yuy2.data(), yuy2_below.data(), n);
+        REQUIRE(done % 2 == 0);
+        variants.front()->yuv420(y0 + done, y1 + done, u + (v ? done / 2 : done), v ? v + done / 2 : nullptr, yuy2.data() + done * 2, yuy2_below.data() + done * 2, n - done);
+        for (int i = n * 3; i < n * 3 + 16; ++i) REQUIRE(out[i] == 0xcd);
+        out.resize(n * 3);
+        return out;
+    };
+
+    // Every variant must match the portable code bit for bit
+    const rsimpl::yuy2_unpackers & scalar = *variants.front();
+    for (auto v : variants)
+    {
+        INFO(v->name);
+        REQUIRE(unpack(v->y8, 1) == unpack(scalar.y8, 1));
+        REQUIRE(unpack(v->y16, 2) == unpack(scalar.y16, 2));
+        REQUIRE(unpack(v->rgb8, 3) == unpack(scalar.rgb8, 3));
+        REQUIRE(unpack(v->rgba8, 4) == unpack(scalar.rgba8, 4));
+        REQUIRE(unpack(v->bgr8, 3) == unpack(scalar.bgr8, 3));
+        REQUIRE(unpack(v->bgra8, 4) == unpack(scalar.bgra8, 4));
+        REQUIRE(unpack420(v->yuv420, false) == unpack420(scalar.yuv420, false));
+        REQUIRE(unpack420(v->yuv420, true) == unpack420(scalar.yuv420, true));
+    }
+
+    // Spot check the conversion itself: black, white and saturated red
+    const rsimpl::byte pixels[32] = { 16, 128, 16, 128,  235, 128, 235, 128,  81, 90, 81, 240 };
+    std::vector<rsimpl::byte> rgb(16 * 3);
+    rsimpl::byte * dest[] = { rgb.data() };
+    scalar.rgb8(dest, pixels, 16);
+    REQUIRE(rgb[0] == 0); REQUIRE(rgb[1] == 0); REQUIRE(rgb[2] == 0);
+    REQUIRE(rgb[6] == 254); REQUIRE(rgb[7] == 254); REQUIRE(rgb[8] == 254);
+    REQUIRE(rgb[12] > 250); REQUIRE(rgb[13] < 5); REQUIRE(rgb[14] < 5);
+}
+
+TEST_CASE("yuy2 images unpack into the planes of NV12 and I420 images", "[offline] [validation]")
+{
+    REQUIRE(rsimpl::get_image_size(640, 480, RS_FORMAT_NV12) == 640 * 480 * 3 / 2);
+    REQUIRE(rsimpl::get_image_size(640, 480, RS_FORMAT_I420) == 640 * 480 * 3 / 2);
+    REQUIRE(rsimpl::get_image_size(4, 3, RS_FORMAT_I420) == 4 * 3 + 2 * 2 * 2);
+
+    // 4 x 3 pixels, whose last row has no pair and supplies the chroma of its own
+    const int width = 4, height = 3;
+    const rsimpl::byte yuy2[] = { 10, 100, 11, 200,  12, 101, 13, 201,
+                                  20, 103, 21, 204,  22, 102, 23, 202,
+                                  30, 50,  31, 60,   32, 70,  33, 80 };
+    std::vector<rsimpl::byte> nv12(rsimpl::get_image_size(width, height, RS_FORMAT_NV12)), i420(nv12.size());
+    rsimpl::unpack_yuy2_to_yuv420(nv12.data(), RS_FORMAT_NV12, width, height, yuy2, width * 2, 0, height);
+
+    // Bands starting on even rows make up the same image
+    rsimpl::unpack_yuy2_to_yuv420(i420.data(), RS_FORMAT_I420, width, height, yuy2, width * 2, 0, 2);
+    rsimpl::unpack_yuy2_to_yuv420(i420.data(), RS_FORMAT_I420, width, height, yuy2, width * 2, 2, 1);
+
+    const std::vector<rsimpl::byte> luma = { 10, 11, 12, 13,  20, 21, 22, 23,  30, 31, 32, 33 };
+    REQUIRE(std::vector<rsimpl::byte>(nv12.begin(), nv12.begin() + 12) == luma);
+    REQUIRE(std::vector<rsimpl::byte>(i420.begin(), i420.begin() + 12) == luma);
+    REQUIRE(std::vector<rsimpl::byte>(nv12.begin() + 12, nv12.end()) == std::vector<rsimpl::byte>({ 102, 202, 102, 202,  50, 60, 70, 80 }));
+    REQUIRE(std::vector<rsimpl::byte>(i420.begin() + 12, i420.end()) == std::vector<rsimpl::byte>({ 102, 102, 50, 70,  202, 202, 60, 80 }));
+}
+
+TEST_CASE("bayer demosaicers agree across instruction sets", "[offline] [validation]")
+{
+    auto variants = rsimpl::get_available_bayer_demosaicers();
+    REQUIRE(!variants.empty());
+    REQUIRE(std::string(variants.front()->name) == "scalar");
+
+    // 7 blocks of 16 pixels and a remainder exercise every step of every variant, on rows with two pixels of border either side
+    const int n = 16 * 7 + 6, padded = n + 4;
+    std::vector<uint16_t> raw(padded * 5);
+    for (size_t i = 0; i < raw.size(); ++i) raw[i] = static_cast<uint16_t>((i * 389 + (i >> 3) * 71) % 1024);
+    const uint16_t * rows[5];
+    for (int k = 0; k < 5; ++k) rows[k] = raw.data() + padded * k + 2;
+
+    const rsimpl::bayer_demosaicers & scalar = *variants.front();
+    auto demosaic = [&](const rsimpl::bayer_demosaicers & d, bool y16, bool red_row, bool sites_even, bool corrected)
+    {
+        const int bpp = y16 ? 2 : 3;
+        std::vector<rsimpl::byte> out(n * bpp + 16, 0xcd);
+        const int done = (y16 ? d.y16 : d.rgb8)(out.data(), rows, n, red_row, sites_even, corrected);
+        REQUIRE(done % 2 == 0);
+        const uint16_t * rest[5];
+        for (int k = 0; k < 5; ++k) rest[k] = rows[k] + done;
+        (y16 ? scalar.y16 : scalar.rgb8)(out.data() + done * bpp, rest, n - done, red_row, sites_even, corrected);
+        for (int i = n * bpp; i < n * bpp + 16; ++i) REQUIRE(out[i] == 0xcd); // No writes past the end of the row
+        out.resize(n * bpp);
+        return out;
+    };
+
+    // Every variant must match the portable code bit for bit, on both kinds of rows and with either interpolation
+    for (auto v : variants)
+    {
+        INFO(v->name);
+        for (int mode = 0; mode < 16; ++mode)
+        {
+            const bool y16 = (mode & 1) != 0, red_row = (mode & 2) != 0, sites_even = (mode & 4) != 0, corrected = (mode & 8) != 0;
+            INFO("mode " << mode);
+            REQUIRE(demosaic(*v, y16, red_row, sites_even, corrected) == demosaic(scalar, y16, red_row, sites_even, corrected));
+        }
+    }
+}
+
+namespace
+{
+    // Packs 10 bit values four at a time, their upper 8 bits in four bytes and their lower 2 bits in a fifth
+    std::vector<rsimpl::byte> pack_raw10(const std::vector<uint16_t> & values)
+    {
+        std::vector<rsimpl::byte> raw(values.size() / 4 * 5);
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            raw[i / 4 * 5 + i % 4] = static_cast<rsimpl::byte>(values[i] >> 2);
+            raw[i / 4 * 5 + 4] |= static_cast<rsimpl::byte>((values[i] & 3) << (i % 4 * 2));
+        }
+        return raw;
+    }
+}
+
+TEST_CASE("raw10 images demosaic into RGB8 and Y16 images", "[offline] [validation]")
+{
+    // A uniform color seen through the RGGB pattern of a 40 x 12 sensor, whose lower 2 bits are kept by the packing
+    const int raw_width = 40, raw_height = 12;
+    std::vector<uint16_t> bayer(raw_width * raw_height);
+    for (int y = 0; y < raw_height; ++y) for (int x = 0; x < raw_width; ++x) bayer[y * raw_width + x] = y % 2 == 0 ? (x % 2 == 0 ? 803 : 401) : (x % 2 == 0 ? 401 : 102);
+    const auto raw = pack_raw10(bayer);
+    const size_t raw_stride = raw_width * 5 / 4;
+
+    // Both interpolations reproduce a uniform color exactly, over the whole image and over windows starting on any row and column of the pattern
+    for (bool corrected : { false, true })
+    {
+        for (auto window : { std::make_pair(0, 0), std::make_pair(4, 1), std::make_pair(3, 2) })
+        {
+            INFO("corrected " << corrected << ", window at " << window.first << "," << window.second);
+            const int width = 32, height = 8;
+            std::vector<rsimpl::byte> rgb(width * height * 3);
+            std::vector<uint16_t> y16(width * height);
+            rsimpl::demosaic_raw10(rgb.data(), RS_FORMAT_RGB8, width, height, raw.data(), raw_stride, raw_width, raw_height, window.first, window.second, 0, height, corrected);
+            rsimpl::demosaic_raw10(reinterpret_cast<rsimpl::byte *>(y16.data()), RS_FORMAT_Y16, width, height, raw.data(), raw_stride, raw_width, raw_height, window.first, window.second, 0, 3, corrected);
+            rsimpl::demosaic_raw10(reinterpret_cast<rsimpl::byte *>(y16.data()), RS_FORMAT_Y16, width, height, raw.data(), raw_stride, raw_width, raw_height, window.first, window.second, 3, 5, corrected);
+            for (int i = 0; i < width * height; ++i)
+            {
+                REQUIRE(rgb[i * 3] == 803 >> 2);
+                REQUIRE(rgb[i * 3 + 1] == 401 >> 2);
+                REQUIRE(rgb[i * 3 + 2] == 102 >> 2);
+                REQUIRE(y16[i] == (242 + 235 + 12) << 6); // 803, 401 and 102 weighted by 77, 150 and 29 out of 256, each rounded
+            }
+        }
+    }
+
+    // Color modes of RAW10 are demosaiced by the unpacking of their frames, in bands of rows
+    rs_intrinsics intrin = {};
+    intrin.width = raw_width;
+    intrin.height = raw_height;
+    const rsimpl::subdevice_mode mode = { 2, { (int)raw_stride, raw_height }, rsimpl::pf_rw10, 30, intrin, {}, { 0 } };
+    std::vector<uint16_t> varied(bayer.size());
+    for (size_t i = 0; i < varied.size(); ++i) varied[i] = static_cast<uint16_t>((i * 389) % 1024);
+    const auto native = pack_raw10(varied);
+    rsimpl::parallel_pool pool(2);
+    for (size_t unpacker = 1; unpacker < rsimpl::pf_rw10.unpackers.size(); ++unpacker)
+    {
+        rsimpl::subdevice_mode_selection selection(mode, 0, unpacker);
+        selection.demosaic_corrected = true;
+        selection.unpack_bands = 2;
+        const rs_format format = selection.get_format(RS_STREAM_COLOR);
+        REQUIRE((format == RS_FORMAT_RGB8 || format == RS_FORMAT_Y16));
+        REQUIRE(selection.requires_processing());
+
+        const size_t size = selection.get_image_size(RS_STREAM_COLOR);
+        REQUIRE(size == rsimpl::get_image_size(raw_width, raw_height, format));
+        std::vector<rsimpl::byte> expected(size), serial(size), banded(size);
+        rsimpl::demosaic_raw10(expected.data(), format, raw_width, raw_height, native.data(), raw_stride, raw_width, raw_height, 0, 0, 0, raw_height, true);
+        rsimpl::byte * const serial_dest[] = { serial.data() }, * const banded_dest[] = { banded.data() };
+        selection.unpack(serial_dest, native.data());
+        selection.unpack(banded_dest, native.data(), nullptr, nullptr, &pool);
+        REQUIRE(serial == expected);
+        REQUIRE(banded == expected);
+    }
+}
+
+TEST_CASE("y12i unpackers split both planes", "[offline] [validation]")
+{
+    // 37 pixels cover two whole blocks of 16 and a remainder. Values above 10 bits check that the kernels truncate like the portable code.
+    const int count = 37;
+    std::vector<uint8_t> source(count * 3);
+    for (size_t i = 0; i < source.size(); ++i) source[i] = static_cast<uint8_t>(i * 89 + 17);
+
+    std::vector<uint16_t> left16(count), right16(count);
+    std::vector<uint8_t> left8(count), right8(count);
+    rsimpl::byte * const planes16[] = { reinterpret_cast<rsimpl::byte *>(left16.data()), reinterpret_cast<rsimpl::byte *>(right16.data()) };
+    rsimpl::byte * const planes8[] = { left8.data(), right8.data() };
+    REQUIRE(rsimpl::pf_y12i.unpackers.size() == 2);
+    REQUIRE(rsimpl::pf_y12i.unpackers[1].get_format(RS_STREAM_INFRARED2) == RS_FORMAT_Y8);
+    rsimpl::pf_y12i.unpackers[0].unpack(planes16, source.data(), count);
+    rsimpl::pf_y12i.unpackers[1].unpack(planes8, source.data(), count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const int l = source[i * 3 + 2] << 4 | source[i * 3 + 1] >> 4, r = (source[i * 3 + 1] & 0xf) << 8 | source[i * 3];
+        REQUIRE(left16[i] == static_cast<uint16_t>(l << 6 | l >> 4));
+        REQUIRE(right16[i] == static_cast<uint16_t>(r << 6 | r >> 4));
+        REQUIRE(left8[i] == static_cast<uint8_t>(l >> 2));
+        REQUIRE(right8[i] == static_cast<uint8_t>(r >> 2));
+    }
+}
+
+TEST_CASE("width-specialized unpackers match the generic unpackers row by row", "[offline] [validation]")
+{
+    // Rows of 628 pixels padded to 640, as the cropped depth of an R200
+    const int width = 628, height = 3, source_width = 640;
+    REQUIRE(rsimpl::find_row_unpacker(rsimpl::pf_y8i.unpackers[0].unpack, 627) == nullptr);
+    REQUIRE(rsimpl::find_row_unpacker(rsimpl::pf_yuy2.unpackers[0].unpack, 640) == nullptr); // Dispatched to SIMD kernels at run time
+    for (auto pf : { &rsimpl::pf_z16, &rsimpl::pf_y8i, &rsimpl::pf_y12i, &rsimpl::pf_f200_inzi })
+    {
+        for (auto & unpacker : pf->unpackers)
+        {
+            auto rows = rsimpl::find_row_unpacker(unpacker.unpack, width);
+            REQUIRE(rows != nullptr);
+
+            const size_t source_stride = pf->get_image_size(source_width, 1);
+            std::vector<uint8_t> source(source_stride * height);
+            for (size_t i = 0; i < source.size(); ++i) source[i] = static_cast<uint8_t>(i * 89 + 17);
+
+            std::vector<uint8_t> expected[2], actual[2];
+            size_t dest_stride[2] = {};
+            rsimpl::byte * expected_rows[2] = {}, * actual_rows[2] = {};
+            for (size_t o = 0; o < unpacker.outputs.size(); ++o)
+            {
+                dest_stride[o] = rsimpl::get_image_size(width, 1, unpacker.outputs[o].second);
+                expected[o].resize(dest_stride[o] * height);
+                actual[o].assign(dest_stride[o] * height, 0);
+                expected_rows[o] = expected[o].data();
+                actual_rows[o] = actual[o].data();
+            }
+            for (int y = 0; y < height; ++y)
+            {
+                rsimpl::byte * const out[2] = { expected_rows[0] + dest_stride[0] * y, expected_rows[1] ? expected_rows[1] + dest_stride[1] * y : nullptr };
+                unpacker.unpack(out, source.data() + source_stride * y, width);
+            }
+            rows(actual_rows, dest_stride, source.data(), source_stride, height);
+            for (size_t o = 0; o < unpacker.outputs.size(); ++o) REQUIRE(actual[o] == expected[o]);
+        }
+    }
+}
+
+TEST_CASE("sr300 inzi depth is handed out as a view of its native plane", "[offline] [validation]")
+{
+    rs_intrinsics intrin = {};
+    intrin.width = 64; intrin.height = 4;
+    rsimpl::subdevice_mode mode = { 1, { 64, 4 }, rsimpl::pf_sr300_inzi, 30, intrin, {}, { 0 } };
+    for (int unpacker = 0; unpacker < 2; ++unpacker)
+    {
+        rsimpl::subdevice_mode_selection selection(mode, 0, unpacker);
+        REQUIRE(selection.get_plane_view(0) == -1); // The driver buffer may not be held by the application
+        selection.zero_copy = true;
+        REQUIRE(selection.get_plane_view(0) == 1);
+        REQUIRE(selection.get_plane_view(1) == -1);
+        REQUIRE(rsimpl::subdevice_mode_selection(mode, 1, unpacker).get_plane_view(0) == -1);
+    }
+
+    // Only the IR plane is written when the depth destination is left out
+    const int count = 64 * 4 + 5;
+    std::vector<uint16_t> native(count * 2), ir16(count);
+    std::vector<uint8_t> ir8(count);
+    for (int i = 0; i < count * 2; ++i) native[i] = static_cast<uint16_t>(i * 7919);
+    rsimpl::byte * const dest16[] = { nullptr, reinterpret_cast<rsimpl::byte *>(ir16.data()) }, * const dest8[] = { nullptr, ir8.data() };
+    rsimpl::pf_sr300_inzi.unpackers[1].unpack(dest16, reinterpret_cast<const rsimpl::byte *>(native.data()), count);
+    rsimpl::pf_sr300_inzi.unpackers[0].unpack(dest8, reinterpret_cast<const rsimpl::byte *>(native.data()), count);
+    for (int i = 0; i < count; ++i)
+    {
+        REQUIRE(ir16[i] == static_cast<uint16_t>(native[i] << 6));
+        REQUIRE(ir8[i] == static_cast<uint8_t>(native[i] >> 2));
+    }
+}
+
+TEST_CASE("y8i infrared pairs are handed out as strided views of the native frame", "[offline] [validation]")
+{
+    rs_intrinsics intrin = {};
+    intrin.width = 64; intrin.height = 4;
+    rsimpl::subdevice_mode mode = { 1, { 64, 4 }, rsimpl::pf_y8i, 30, intrin, {}, { 0 } };
+    rsimpl::subdevice_mode_selection selection(mode, 0, 0);
+    selection.zero_copy = true;
+    REQUIRE(selection.get_interleaved_view(0) == -1); // Only when the application asked for views
+    selection.interleaved_views = true;
+    REQUIRE(selection.get_interleaved_view(0) == 0);
+    REQUIRE(selection.get_interleaved_view(1) == 1);
+    selection.zero_copy = false;
+    REQUIRE(selection.get_interleaved_view(1) == -1);
+    rsimpl::subdevice_mode_selection padded(mode, 1, 0);
+    padded.zero_copy = padded.interleaved_views = true;
+    REQUIRE(padded.get_interleaved_view(0) == -1);
+
+    // Views are packed into exactly the pixels the unpacker splits out of the native frame
+    const int count = 64 * 4 + 5;
+    std::vector<uint8_t> native(count * 2), left(count), right(count), packed_left(count), packed_right(count);
+    for (int i = 0; i < count * 2; ++i) native[i] = static_cast<uint8_t>(i * 89 + 17);
+    rsimpl::byte * const dest[] = { left.data(), right.data() };
+    rsimpl::pf_y8i.unpackers[0].unpack(dest, native.data(), count);
+    rsimpl::pack_strided_samples(packed_left.data(), native.data(), count, 2);
+    rsimpl::pack_strided_samples(packed_right.data(), native.data() + 1, count, 2);
+    for (int i = 0; i < count; ++i)
+    {
+        REQUIRE(left[i] == native[i * 2]);
+        REQUIRE(right[i] == native[i * 2 + 1]);
+    }
+    REQUIRE(packed_left == left);
+    REQUIRE(packed_right == right);
+}
+
+TEST_CASE("deprojection table matches per-pixel deprojection", "[offline] [validation]")
+{
+    // An odd pixel count exercises both the vectorized loop and the remainder
+    rs_intrinsics intrin = { 37, 5, 18.3f, 2.1f, 30.5f, 31.2f, RS_DISTORTION_INVERSE_BROWN_CONRADY, { 0.12f, -0.05f, 0.001f, -0.002f, 0.01f } };
+    const auto table = rsimpl::compute_deprojection_table(intrin);
+    REQUIRE(table.size() == 37 * 5 * 2);
+
+    // The disparity image starts one value later, so that its zeros land on other pixels
+    std::vector<uint16_t> depth(37 * 5 + 1);
+    for (size_t i = 0; i < depth.size(); ++i) depth[i] = static_cast<uint16_t>(i % 7 ? i * 131 : 0);
+    std::vector<float> z_points(37 * 5 * 3), disparity_points(37 * 5 * 3);
+    rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(z_points.data()), RS_FORMAT_XYZ32F, table, depth.data(), 0.001f);
+    rsimpl::deproject_disparity(reinterpret_cast<rsimpl::byte *>(disparity_points.data()), RS_FORMAT_XYZ32F, table, depth.data() + 1, rsimpl::compute_disparity_to_depth_table(0.5f));
+
+    for (int y = 0, i = 0; y < intrin.height; ++y)
+    {
+        for (int x = 0; x < intrin.width; ++x, ++i)
+        {
+            const float pixel[] = { (float)x, (float)y };
+            float expected[3];
+            rs_deproject_pixel_to_point(expected, &intrin, pixel, 0.001f * depth[i]);
+            for (int j = 0; j < 3; ++j) REQUIRE(z_points[i * 3 + j] == Approx(expected[j]));
+
+            rs_deproject_pixel_to_point(expected, &intrin, pixel, depth[i + 1] ? 0.5f / depth[i + 1] : 0.0f); // No data deprojects to the origin, like a Z of zero
+            for (int j = 0; j < 3; ++j) REQUIRE(disparity_points[i * 3 + j] == Approx(expected[j]));
+        }
+    }
+}
+
+static double half_to_float(uint16_t h)
+{
+    const int e = (h >> 10) & 31, m = h & 1023;
+    const double v = e == 0 ? std::ldexp(m, -24) : e == 31 ? std::numeric_limits<double>::infinity() : std::ldexp(m | 1024, e - 25);
+    return h & 0x8000 ? -v : v;
+}
+
+TEST_CASE("compact point formats encode every coordinate", "[offline] [validation]")
+{
+    // With a unit depth, the x and y of every point are the rays themselves. The odd count exercises both the vectorized loop and the remainder.
+    const float exact[] = { 1.0f, -2.0f, 65504.0f, 65520.0f, 1e6f, std::ldexp(1.0f, -24), std::ldexp(1.0f, -25), std::ldexp(3.0f, -25), 0.1f, 1 + std::ldexp(1.0f, -11), 1 + std::ldexp(3.0f, -11) };
+    const uint16_t exact_halves[] = { 0x3C00, 0xC000, 0x7BFF, 0x7C00, 0x7C00, 0x0001, 0x0000, 0x0002, 0x2E66, 0x3C00, 0x3C02 };
+    const int count = 37;
+    std::vector<float> table(count * 2);
+    for (int i = 0; i < count; ++i)
+    {
+        table[i * 2] = i < 11 ? exact[i] : (i * 7919 % 2000 - 1000) * 0.0437f;
+        table[i * 2 + 1] = i < 11 ? -exact[i] : (i * 104729 % 2000 - 1000) * 0.00131f;
+    }
+    const std::vector<uint16_t> depth(count, 1);
+
+    std::vector<uint16_t> halves(count * 3);
+    std::vector<int16_t> millimeters(count * 3);
+    rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(halves.data()), RS_FORMAT_XYZ16F, table, depth.data(), 1.0f);
+    rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(millimeters.data()), RS_FORMAT_XYZ16, table, depth.data(), 1.0f);
+    REQUIRE_THROWS(rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(halves.data()), RS_FORMAT_Z16, table, depth.data(), 1.0f));
+
+    for (int i = 0; i < count; ++i)
+    {
+        REQUIRE(halves[i * 3 + 2] == 0x3C00);
+        REQUIRE(millimeters[i * 3 + 2] == 1000);
+        for (int j = 0; j < 2; ++j)
+        {
+            const float v = table[i * 2 + j];
+            const uint16_t h = halves[i * 3 + j];
+            if (i < 11) REQUIRE(h == (j ? exact_halves[i] ^ 0x8000 : exact_halves[i]));
+            else
+            {
+                // Not a tie, so the encoding must be strictly closer than both neighbours
+                const uint16_t magnitude = h & 0x7FFF;
+                REQUIRE(std::abs(half_to_float(h) - v) < std::abs(half_to_float(static_cast<uint16_t>((h & 0x8000) | (magnitude + 1))) - v));
+                if (magnitude) REQUIRE(std::abs(half_to_float(h) - v) < std::abs(half_to_float(static_cast<uint16_t>((h & 0x8000) | (magnitude - 1))) - v));
+            }
+            REQUIRE(millimeters[i * 3 + j] == static_cast<int16_t>(std::nearbyint(std::min(std::max(v * 1000.0f, -32768.0f), 32767.0f))));
+        }
+    }
+    REQUIRE(millimeters[0] == 1000);
+    REQUIRE(millimeters[3 * 2] == 32767);     // 65504 m
+    REQUIRE(millimeters[3 * 2 + 1] == -32768);
+    REQUIRE(millimeters[3 * 8] == 100);       // 0.1 m
+    REQUIRE(rsimpl::get_image_size(640, 480, RS_FORMAT_XYZ16F) == 640 * 480 * 6);
+}
+
+TEST_CASE("parallel_pool runs every index exactly once", "[offline] [validation]")
+{
+    for (int threads : { 1, 3 })
+    {
+        rsimpl::parallel_pool pool(threads);
+        REQUIRE(pool.get_thread_count() == threads);
+        for (int count : { 0, 1, 2, 7, 100 })
+        {
+            std::vector<std::atomic<int>> hits(count);
+            for (auto & h : hits) h = 0;
+            pool.parallel_for(count, [&](int i) { ++hits[i]; });
+            for (auto & h : hits) REQUIRE(h == 1);
+        }
+    }
+}
+
+TEST_CASE("banded align_z_to_other matches a serial pass", "[offline] [validation]")
+{
+    // The other camera is offset and has a longer focal length, so depth pixel footprints overlap and span several rows
+    const rs_intrinsics z_intrin = { 64, 48, 32.0f, 24.0f, 60.0f, 60.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rs_intrinsics other_intrin = { 80, 60, 40.0f, 30.0f, 110.0f, 110.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rs_extrinsics z_to_other = { { 1, 0, 0, 0, 1, 0, 0, 0, 1 }, { 0.025f, 0.01f, 0 } };
+    std::vector<uint16_t> z(z_intrin.width * z_intrin.height);
+    for (size_t i = 0; i < z.size(); ++i) z[i] = static_cast<uint16_t>(i % 11 ? 300 + (i * 37) % 700 : 0);
+
+    std::vector<uint16_t> expected(other_intrin.width * other_intrin.height), aligned(expected.size());
+    for (int y = 0, i = 0; y < z_intrin.height; ++y)
+    {
+        for (int x = 0; x < z_intrin.width; ++x, ++i)
+        {
+            if (!z[i]) continue;
+            int corners[2][2];
+            for (int c = 0; c < 2; ++c)
+            {
+                float pixel[] = { x + c - 0.5f, y + c - 0.5f }, point[3], other_point[3], other_pixel[2];
+                rs_deproject_pixel_to_point(point, &z_intrin, pixel, 0.001f * z[i]);
+                rs_transform_point_to_point(other_point, &z_to_other, point);
+                rs_project_point_to_pixel(other_pixel, &other_intrin, other_point);
+                corners[c][0] = static_cast<int>(other_pixel[0] + 0.5f);
+                corners[c][1] = static_cast<int>(other_pixel[1] + 0.5f);
+            }
+            if (corners[0][0] < 0 || corners[0][1] < 0 || corners[1][0] >= other_intrin.width || corners[1][1] >= other_intrin.height) continue;
+            for (int oy = corners[0][1]; oy <= corners[1][1]; ++oy) for (int ox = corners[0][0]; ox <= corners[1][0]; ++ox)
+            {
+                auto & out = expected[oy * other_intrin.width + ox];
+                out = out ? std::min(out, z[i]) : z[i];
+            }
+        }
+    }
+
+    rsimpl::align_z_to_other(reinterpret_cast<rsimpl::byte *>(aligned.data()), z.data(), 0.001f, z_intrin, rsimpl::compute_alignment_rays(z_intrin, z_to_other), z_to_other, other_intrin);
+    REQUIRE(std::count(expected.begin(), expected.end(), 0) < static_cast<long>(expected.size() / 2));
+    REQUIRE(aligned == expected);
+}
+
+TEST_CASE("fused yuy2 alignment matches unpacking then aligning", "[offline] [validation]")
+{
+    const rs_intrinsics z_intrin = { 48, 36, 24.0f, 18.0f, 50.0f, 50.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rs_intrinsics color_intrin = { 128, 96, 64.0f, 48.0f, 90.0f, 90.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const float c = std::cos(0.05f), s = std::sin(0.05f);
+    const rs_extrinsics z_to_color = { { c, s, 0, -s, c, 0, 0, 0, 1 }, { 0.025f, 0.004f, 0.001f } };
+    const auto rays = rsimpl::compute_alignment_rays(z_intrin, z_to_color);
+    std::vector<uint16_t> z(z_intrin.width * z_intrin.height);
+    for (size_t i = 0; i < z.size(); ++i) z[i] = static_cast<uint16_t>(i % 13 ? 400 + (i * 53) % 900 : 0);
+    std::vector<uint8_t> yuy2(color_intrin.width * color_intrin.height * 2), rgb(color_intrin.width * color_intrin.height * 3);
+    for (size_t i = 0; i < yuy2.size(); ++i) yuy2[i] = static_cast<uint8_t>(i * 31 + (i >> 7));
+
+    rsimpl::byte * const rgb_dest[] = { rgb.data() };
+    rsimpl::pf_yuy2.unpackers[0].unpack(rgb_dest, yuy2.data(), color_intrin.width * color_intrin.height);
+    std::vector<uint8_t> expected(z.size() * 3), fused(z.size() * 3);
+    rsimpl::align_other_to_z(expected.data(), z.data(), 0.001f, z_intrin, rays, z_to_color, color_intrin, rgb.data(), RS_FORMAT_RGB8);
+    rsimpl::align_yuy2_to_z(fused.data(), z.data(), 0.001f, z_intrin, rays, z_to_color, color_intrin, yuy2.data());
+    REQUIRE(std::count(expected.begin(), expected.end(), 0) < static_cast<long>(expected.size() / 2));
+    REQUIRE(fused == expected);
+}
+
+TEST_CASE("alignment rays match the deproject and transform chain", "[offline] [validation]")
+{
+    const rs_intrinsics intrin = { 9, 7, 4.2f, 3.1f, 10.5f, 11.0f, RS_DISTORTION_INVERSE_BROWN_CONRADY, { 0.1f, -0.03f, 0.002f, 0.001f, 0.005f } };
+    const float c = std::cos(0.1f), s = std::sin(0.1f);
+    const rs_extrinsics extrin = { { c, 0, -s, 0, 1, 0, s, 0, c }, { 0.05f, -0.01f, 0.002f } };
+    const auto rays = rsimpl::compute_alignment_rays(intrin, extrin);
+    REQUIRE(rays.size() == 10 * 8 * 3);
+
+    for (int y = 0, i = 0; y <= intrin.height; ++y)
+    {
+        for (int x = 0; x <= intrin.width; ++x, ++i)
+        {
+            const float pixel[] = { x - 0.5f, y - 0.5f }, depth = 1.7f;
+            float point[3], expected[3];
+            rs_deproject_pixel_to_point(point, &intrin, pixel, depth);
+            rs_transform_point_to_point(expected, &extrin, point);
+            for (int j = 0; j < 3; ++j) REQUIRE(depth * rays[i * 3 + j] + extrin.translation[j] == Approx(expected[j]));
+        }
+    }
+}
+
+TEST_CASE("rectify_image matches the rectification footprint rule", "[offline] [validation]")
+{
+    // Identical cameras map every pixel's footprint onto itself and its bottom-right neighbour, which is written last. The wide
+    // image spreads every tile over more rows than 16 bit offsets can reach, the narrow one does not.
+    for (int width : { 150, 9000 })
+    {
+        const int height = 11;
+        const rs_intrinsics intrin = { width, height, 0.0f, 0.0f, 1.0f, 1.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } }; // Exact projection, no rounding
+        const rs_extrinsics identity = { { 1, 0, 0, 0, 1, 0, 0, 0, 1 }, { 0, 0, 0 } };
+        const auto table = rsimpl::compute_rectification_table(intrin, identity, intrin);
+        REQUIRE(table.wide_offsets.empty() == (width < 1000));
+
+        std::vector<uint32_t> unrect(width * height), rect(width * height);
+        for (size_t i = 0; i < unrect.size(); ++i) unrect[i] = static_cast<uint32_t>(i);
+        rsimpl::rectify_image(reinterpret_cast<uint8_t *>(rect.data()), table, reinterpret_cast<const uint8_t *>(unrect.data()), RS_FORMAT_RGBA8);
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                const uint32_t expected = x + 1 < width && y + 1 < height ? (y + 1) * width + x + 1 : 0;
+                REQUIRE(rect[y * width + x] == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("decimated depth reduces the valid pixels of every block", "[offline] [validation]")
+{
+    const rs_intrinsics intrin = { 12, 8, 5.5f, 3.25f, 6.0f, 7.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rsimpl::subdevice_mode mode = { 1, { 12, 8 }, rsimpl::pf_z16, 30, intrin, {}, { 0 } };
+    std::vector<uint16_t> native(12 * 8);
+    for (size_t i = 0; i < native.size(); ++i) native[i] = i % 5 == 2 ? 0 : static_cast<uint16_t>(1000 + (i * 7919) % 613);
+
+    for (int factor : { 2, 3, 4 })
+    {
+        for (bool mean : { false, true })
+        {
+            rsimpl::subdevice_mode_selection selection(mode, 0, 0);
+            selection.zero_copy = true;
+            selection.decimation_factor = factor;
+            selection.decimation_mean = mean;
+            REQUIRE(selection.requires_processing());
+            REQUIRE(selection.get_output_width(RS_STREAM_DEPTH) == 12 / factor);
+            REQUIRE(selection.get_output_height(RS_STREAM_DEPTH) == 8 / factor);
+
+            std::vector<uint16_t> depth(selection.get_image_size(RS_STREAM_DEPTH) / sizeof(uint16_t));
+            rsimpl::byte * const dest[] = { reinterpret_cast<rsimpl::byte *>(depth.data()) };
+            selection.unpack(dest, reinterpret_cast<const rsimpl::byte *>(native.data()));
+
+            for (int y = 0; y < 8 / factor; ++y)
+            {
+                for (int x = 0; x < 12 / factor; ++x)
+                {
+                    std::vector<uint16_t> valid;
+                    for (int j = 0; j < factor; ++j) for (int i = 0; i < factor; ++i)
+                    {
+                        const auto z = native[(y * factor + j) * 12 + x * factor + i];
+                        if (z) valid.push_back(z);
+                    }
+                    std::sort(valid.begin(), valid.end());
+                    uint32_t sum = 0;
+                    for (auto z : valid) sum += z;
+                    const auto expected = mean ? (sum + valid.size() / 2) / valid.size() : valid[(valid.size() - 1) / 2];
+                    REQUIRE(depth[y * (12 / factor) + x] == expected);
+                }
+            }
+
+            // The center of every block projects onto the decimated pixel
+            const auto decimated = rsimpl::decimate_intrinsics(intrin, factor);
+            const float center = (factor - 1) * 0.5f;
+            REQUIRE((center - intrin.ppx) / intrin.fx == Approx((0 - decimated.ppx) / decimated.fx));
+            REQUIRE((factor + center - intrin.ppy) / intrin.fy == Approx((1 - decimated.ppy) / decimated.fy));
+        }
+    }
+}
+
+// Reference for depth pyramids, reduces one level to the next, leaving the pixels with no data out of every 2x2 block
+static std::vector<uint16_t> reduce_depth(const std::vector<uint16_t> & depth, int width, int height)
+{
+    std::vector<uint16_t> reduced((width / 2) * (height / 2));
+    for (int y = 0; y < height / 2; ++y) for (int x = 0; x < width / 2; ++x)
+    {
+        uint32_t sum = 0, valid = 0;
+        for (int j = 0; j < 2; ++j) for (int i = 0; i < 2; ++i)
+        {
+            const auto z = depth[(2 * y + j) * width + 2 * x + i];
+            sum += z;
+            valid += z != 0;
+        }
+        reduced[y * (width / 2) + x] = valid ? static_cast<uint16_t>((sum + valid / 2) / valid) : 0;
+    }
+    return reduced;
+}
+
+TEST_CASE("depth pyramids reduce the delivered depth level after level", "[offline] [validation]")
+{
+    const rs_intrinsics intrin = { 46, 27, 22.5f, 13.0f, 40.0f, 40.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rsimpl::subdevice_mode mode = { 1, { 46, 27 }, rsimpl::pf_z16, 30, intrin, {}, { 0 } };
+    std::vector<uint16_t> native(46 * 27);
+    for (size_t i = 0; i < native.size(); ++i) native[i] = i % 3 == 1 || (i / 46 > 20 && i % 46 > 30) ? 0 : static_cast<uint16_t>(500 + (i * 7919) % 4000);
+
+    for (int factor : { 1, 2 })
+    {
+        for (int levels : { 1, 3, RS_MAX_DEPTH_PYRAMID_LEVELS })
+        {
+            rsimpl::subdevice_mode_selection selection(mode, 0, 0);
+            selection.zero_copy = true;
+            selection.decimation_factor = factor;
+            selection.depth_pyramid_levels = levels;
+            REQUIRE(selection.requires_processing());
+            REQUIRE(selection.get_plane_view(0) < 0);
+
+            int width = selection.get_output_width(RS_STREAM_DEPTH), height = selection.get_output_height(RS_STREAM_DEPTH);
+            REQUIRE(selection.get_image_size(RS_STREAM_DEPTH) == 46 * 27 * sizeof(uint16_t) + rsimpl::get_depth_pyramid_size(width, height, levels));
+            std::vector<uint16_t> depth(selection.get_image_size(RS_STREAM_DEPTH) / sizeof(uint16_t));
+            rsimpl::byte * const dest[] = { reinterpret_cast<rsimpl::byte *>(depth.data()) };
+            selection.unpack(dest, reinterpret_cast<const rsimpl::byte *>(native.data()));
+
+            // Every level follows the one before it, and is the reduction of the one before it
+            std::vector<uint16_t> level(depth.begin(), depth.begin() + width * height);
+            auto pixels = depth.begin() + width * height;
+            for (int k = 1; k <= levels; ++k)
+            {
+                level = reduce_depth(level, width, height);
+                width /= 2;
+                height /= 2;
+                REQUIRE(std::vector<uint16_t>(pixels, pixels + width * height) == level);
+                pixels += width * height;
+            }
+        }
+    }
+}
+
+TEST_CASE("depth runs let point clouds and alignment skip the pixels with no data", "[offline] [validation]")
+{
+    // Sparse depth, with rows of no data, long runs crossing blocks of eight pixels and single pixels on their own
+    const rs_intrinsics intrin = { 46, 27, 22.5f, 13.0f, 40.0f, 40.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rsimpl::subdevice_mode mode = { 1, { 46, 27 }, rsimpl::pf_z16, 30, intrin, {}, { 0 } };
+    std::vector<uint16_t> native(46 * 27);
+    for (size_t i = 0; i < native.size(); ++i)
+    {
+        const size_t x = i % 46, y = i / 46;
+        native[i] = y % 5 == 3 || (x > 20 && x < 29 && y % 2) || (x < 12 && x % 7 == 2) || x == 45 ? static_cast<uint16_t>(400 + (i * 53) % 900) : 0;
+        if (y == 10) native[i] = static_cast<uint16_t>(600 + x); // A row with no holes at all
+    }
+
+    rsimpl::subdevice_mode_selection selection(mode, 0, 0);
+    selection.zero_copy = true;
+    selection.depth_pyramid_levels = 1;
+    selection.depth_runs = true;
+    REQUIRE(selection.requires_processing());
+    REQUIRE(selection.get_plane_view(0) < 0);
+    const size_t runs_offset = rsimpl::get_depth_runs_offset(46, 27, 1);
+    REQUIRE(runs_offset % sizeof(uint32_t) == 0);
+    REQUIRE(selection.get_image_size(RS_STREAM_DEPTH) == runs_offset + rsimpl::get_depth_runs_size(46, 27));
+    std::vector<uint32_t> frame((selection.get_image_size(RS_STREAM_DEPTH) + 3) / sizeof(uint32_t));
+    auto depth = reinterpret_cast<uint16_t *>(frame.data());
+    rsimpl::byte * const dest[] = { reinterpret_cast<rsimpl::byte *>(frame.data()) };
+    selection.unpack(dest, reinterpret_cast<const rsimpl::byte *>(native.data()));
+    REQUIRE(std::equal(native.begin(), native.end(), depth));
+
+    // The runs cover exactly the pixels with data, each run as long as it can be
+    const auto row_runs = reinterpret_cast<const uint32_t *>(reinterpret_cast<const rsimpl::byte *>(frame.data()) + runs_offset);
+    const auto runs = rsimpl::get_depth_runs(row_runs, 27);
+    REQUIRE(row_runs[0] == 0);
+    for (int y = 0; y < 27; ++y)
+    {
+        std::vector<std::pair<int, int>> expected, found;
+        for (int x = 0; x < 46; ++x)
+        {
+            if (!native[y * 46 + x]) continue;
+            if (x && native[y * 46 + x - 1]) ++expected.back().second;
+            else expected.push_back({ x, 1 });
+        }
+        for (auto run = runs + row_runs[y]; run != runs + row_runs[y + 1]; ++run) found.push_back({ run->x, run->count });
+        REQUIRE(found == expected);
+    }
+    REQUIRE(rsimpl::find_depth_runs(std::vector<uint32_t>(rsimpl::get_depth_runs_size(46, 27) / sizeof(uint32_t)).data(), native.data(), 46, 27) == static_cast<int>(row_runs[27]));
+
+    // Following the runs gives the same points and aligned images as visiting every pixel, into rows padded or not
+    const auto table = rsimpl::compute_deprojection_table(intrin);
+    for (int dest_stride : { 0, 48 })
+    {
+        rsimpl::image_strides strides(0, 0, dest_stride), sparse_strides(0, 0, dest_stride);
+        sparse_strides.source_runs = row_runs;
+        std::vector<float> dense_points(48 * 27 * 3, -1.0f), sparse_points(48 * 27 * 3, -1.0f);
+        rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(dense_points.data()), RS_FORMAT_XYZ32F, table, depth, 0.001f, 46, strides);
+        rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(sparse_points.data()), RS_FORMAT_XYZ32F, table, depth, 0.001f, 46, sparse_strides);
+        REQUIRE(sparse_points == dense_points);
+    }
+
+    const rs_intrinsics color_intrin = { 64, 48, 32.0f, 24.0f, 60.0f, 60.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rs_extrinsics z_to_color = { { 1, 0, 0, 0, 1, 0, 0, 0, 1 }, { 0.025f, 0.004f, 0.001f } };
+    const auto rays = rsimpl::compute_alignment_rays(intrin, z_to_color);
+    rsimpl::image_strides sparse;
+    sparse.source_runs = row_runs;
+    std::vector<uint16_t> dense_z(64 * 48), sparse_z(64 * 48);
+    rsimpl::align_z_to_other(reinterpret_cast<rsimpl::byte *>(dense_z.data()), depth, 0.001f, intrin, rays, z_to_color, color_intrin);
+    rsimpl::align_z_to_other(reinterpret_cast<rsimpl::byte *>(sparse_z.data()), depth, 0.001f, intrin, rays, z_to_color, color_intrin, sparse);
+    REQUIRE(std::count(dense_z.begin(), dense_z.end(), 0) < static_cast<long>(dense_z.size()));
+    REQUIRE(sparse_z == dense_z);
+
+    std::vector<uint8_t> rgb(64 * 48 * 3), dense_rgb(46 * 27 * 3), sparse_rgb(46 * 27 * 3);
+    for (size_t i = 0; i < rgb.size(); ++i) rgb[i] = static_cast<uint8_t>(i * 31 + (i >> 7));
+    rsimpl::align_other_to_z(dense_rgb.data(), depth, 0.001f, intrin, rays, z_to_color, color_intrin, rgb.data(), RS_FORMAT_RGB8);
+    rsimpl::align_other_to_z(sparse_rgb.data(), depth, 0.001f, intrin, rays, z_to_color, color_intrin, rgb.data(), RS_FORMAT_RGB8, sparse);
+    REQUIRE(sparse_rgb == dense_rgb);
+}
+
+// Reference for the depth filters, blends a pixel with its neighbour unless either is a hole or they lie across an edge
+static uint16_t blend_depth(uint16_t pixel, uint16_t neighbour, int alpha, int delta)
+{
+    if (!pixel || !neighbour || std::abs(pixel - neighbour) >= delta) return pixel;
+    return static_cast<uint16_t>(neighbour + static_cast<int>(std::floor(((pixel - neighbour) * alpha + 128) / 256.0)));
+}
+
+TEST_CASE("planar points split the coordinates of interleaved points into planes", "[offline] [validation]")
+{
+    REQUIRE(rsimpl::get_image_size(640, 480, RS_FORMAT_XYZ32F_PLANAR) == rsimpl::get_image_size(640, 480, RS_FORMAT_XYZ32F));
+    REQUIRE(rsimpl::get_image_bpp(RS_FORMAT_XYZ32F_PLANAR) == 32);
+
+    const rs_intrinsics intrin = { 37, 9, 18.0f, 4.5f, 30.0f, 30.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    std::vector<uint16_t> depth(40 * 9);
+    for (size_t i = 0; i < depth.size(); ++i) depth[i] = i % 7 == 3 ? 0 : static_cast<uint16_t>(500 + (i * 29) % 700);
+    std::vector<uint32_t> row_runs(rsimpl::get_depth_runs_size(37, 9) / sizeof(uint32_t));
+    std::vector<uint16_t> packed(37 * 9);
+    for (int y = 0; y < 9; ++y) std::copy(depth.begin() + y * 40, depth.begin() + y * 40 + 37, packed.begin() + y * 37);
+    rsimpl::find_depth_runs(row_runs.data(), packed.data(), 37, 9);
+
+    // Every coordinate lands in its plane, in rows of the stride of the points, whether every pixel or only the runs are visited
+    const auto table = rsimpl::compute_deprojection_table(intrin);
+    for (bool runs : { false, true })
+    {
+        rsimpl::image_strides strides(40, 0, 44);
+        if (runs) strides.source_runs = row_runs.data();
+        std::vector<float> interleaved(44 * 9 * 3), planar(44 * 9 * 3, -1.0f);
+        rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(interleaved.data()), RS_FORMAT_XYZ32F, table, depth.data(), 0.001f, 37, strides);
+        rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(planar.data()), RS_FORMAT_XYZ32F_PLANAR, table, depth.data(), 0.001f, 37, strides);
+        for (int y = 0; y < 9; ++y)
+        {
+            for (int x = 0; x < 37; ++x)
+            {
+                for (int c = 0; c < 3; ++c) REQUIRE(planar[c * 44 * 9 + y * 44 + x] == interleaved[(y * 44 + x) * 3 + c]);
+            }
+        }
+    }
+}
+
+TEST_CASE("only the tiles of a depth or color image that changed are deprojected or rectified again", "[offline] [validation]")
+{
+    const rs_intrinsics intrin = { 150, 22, 75.0f, 11.0f, 80.0f, 80.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    std::vector<uint16_t> previous(152 * 22), current;
+    for (size_t i = 0; i < previous.size(); ++i) previous[i] = static_cast<uint16_t>(300 + (i * 37) % 1200);
+    current = previous;
+    current[5 * 152 + 70] = 0;      // Tile (1, 1)
+    current[21 * 152 + 149] += 1;   // Tile (2, 5), which is cut short on both sides
+    current[3 * 152 + 151] = 7;     // Padding, which no tile reads
+
+    // Tiles are compared within the width of the image, whatever the strides
+    rsimpl::changed_tiles tiles;
+    rsimpl::find_changed_tiles(tiles, reinterpret_cast<const rsimpl::byte *>(previous.data()), 152, reinterpret_cast<const rsimpl::byte *>(current.data()), 152, 150, 22, sizeof(uint16_t));
+    REQUIRE(tiles.columns == 3);
+    REQUIRE(tiles.rows == 6);
+    REQUIRE(tiles.count == 2);
+    for (int i = 0; i < 18; ++i) REQUIRE((tiles.changed[i] != 0) == (i == 1 * 3 + 1 || i == 5 * 3 + 2));
+    REQUIRE(tiles.any_within({ 60, 0, 70, 4 }));
+    REQUIRE(!tiles.any_within({ 0, 0, 63, 21 }));
+    rsimpl::find_changed_tiles(tiles, reinterpret_cast<const rsimpl::byte *>(previous.data()), 152, reinterpret_cast<const rsimpl::byte *>(previous.data()), 152, 150, 22, sizeof(uint16_t));
+    REQUIRE(tiles.count == 0);
+    rsimpl::find_changed_tiles(tiles, reinterpret_cast<const rsimpl::byte *>(previous.data()), 152, reinterpret_cast<const rsimpl::byte *>(current.data()), 152, 150, 22, sizeof(uint16_t));
+
+    // Points deprojected again in the changed tiles alone are those of the whole current image
+    const auto table = rsimpl::compute_deprojection_table(intrin);
+    for (auto format : { RS_FORMAT_XYZ32F, RS_FORMAT_XYZ16 })
+    {
+        rsimpl::image_strides strides(152, 0, 0), incremental(152, 0, 0);
+        incremental.source_changes = &tiles;
+        std::vector<rsimpl::byte> expected(rsimpl::get_image_size(150, 22, format)), points(expected.size());
+        rsimpl::deproject_z(points.data(), format, table, previous.data(), 0.001f, 150, strides);
+        rsimpl::deproject_z(points.data(), format, table, current.data(), 0.001f, 150, incremental);
+        rsimpl::deproject_z(expected.data(), format, table, current.data(), 0.001f, 150, strides);
+        REQUIRE(points == expected);
+    }
+
+    // Rectified tiles are rewritten when any pixel they read changed, and the others are left alone
+    const rs_extrinsics rotation = { { 0.9998f, 0.0175f, 0, -0.0175f, 0.9998f, 0, 0, 0, 1 }, { 0, 0, 0 } };
+    const auto rect_table = rsimpl::compute_rectification_table(intrin, rotation, intrin, 152);
+    REQUIRE(rect_table.sources.size() == rect_table.tiles.size());
+    std::vector<uint16_t> rect(150 * 22), expected(150 * 22);
+    rsimpl::rectify_image(reinterpret_cast<uint8_t *>(rect.data()), rect_table, reinterpret_cast<const uint8_t *>(previous.data()), RS_FORMAT_Z16);
+    const auto before = rect;
+    rsimpl::rectify_image(reinterpret_cast<uint8_t *>(rect.data()), rect_table, reinterpret_cast<const uint8_t *>(current.data()), RS_FORMAT_Z16, 0, &tiles);
+    rsimpl::rectify_image(reinterpret_cast<uint8_t *>(expected.data()), rect_table, reinterpret_cast<const uint8_t *>(current.data()), RS_FORMAT_Z16);
+    REQUIRE(rect == expected);
+    REQUIRE(rect != before);
+
+    rsimpl::changed_tiles none;
+    rsimpl::find_changed_tiles(none, reinterpret_cast<const rsimpl::byte *>(current.data()), 152, reinterpret_cast<const rsimpl::byte *>(current.data()), 152, 150, 22, sizeof(uint16_t));
+    std::fill(rect.begin(), rect.end(), uint16_t(0xABCD));
+    rsimpl::rectify_image(reinterpret_cast<uint8_t *>(rect.data()), rect_table, reinterpret_cast<const uint8_t *>(current.data()), RS_FORMAT_Z16, 0, &none);
+    REQUIRE(std::all_of(rect.begin(), rect.end(), [](uint16_t pixel) { return pixel == 0xABCD; }));
+}
+
+TEST_CASE("cropped streams unpack a window of the native image with shifted intrinsics", "[offline] [validation]")
+{
+    const rs_intrinsics intrin = { 46, 27, 22.5f, 13.0f, 40.0f, 40.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rsimpl::subdevice_mode mode = { 1, { 48, 27 }, rsimpl::pf_z16, 30, intrin, {}, { 0 } };
+    std::vector<uint16_t> native(48 * 27);
+    for (size_t i = 0; i < native.size(); ++i) native[i] = static_cast<uint16_t>(i);
+
+    for (int pad_crop : { 0, -2 })
+    {
+        rsimpl::subdevice_mode_selection selection(mode, pad_crop, 0);
+        selection.zero_copy = true;
+        REQUIRE_THROWS(selection.crop({ 4, 3, 44, 10 }));   // Past the valid pixels
+        REQUIRE_THROWS(selection.crop({ 3, 3, 20, 10 }));   // Odd columns
+        selection.crop({ 4, 3, 20, 10 });
+        REQUIRE(selection.get_width() == 20);
+        REQUIRE(selection.get_height() == 10);
+        REQUIRE(selection.requires_processing());
+        REQUIRE(selection.get_image_size(RS_STREAM_DEPTH) == 20 * 10 * sizeof(uint16_t));
+
+        std::vector<uint16_t> depth(20 * 10);
+        rsimpl::byte * const dest[] = { reinterpret_cast<rsimpl::byte *>(depth.data()) };
+        selection.unpack(dest, reinterpret_cast<const rsimpl::byte *>(native.data()));
+        for (int y = 0; y < 10; ++y) for (int x = 0; x < 20; ++x) REQUIRE(depth[y * 20 + x] == native[(y + 3 - pad_crop) * 48 + x + 4 - pad_crop]);
+
+        // Points keep projecting onto the pixels they did before the crop
+        const auto uncropped = rsimpl::pad_crop_intrinsics(intrin, pad_crop), cropped = selection.get_unpacked_intrinsics(intrin);
+        REQUIRE(cropped.width == 20);
+        REQUIRE(cropped.height == 10);
+        REQUIRE(cropped.ppx == uncropped.ppx - 4);
+        REQUIRE(cropped.ppy == uncropped.ppy - 3);
+
+        // Cropped by the driver, the window is the native image
+        selection.move_crop_to_driver();
+        REQUIRE(selection.cropped_in_driver);
+        REQUIRE(selection.uncropped_dims.x == 48);
+        REQUIRE(selection.mode.native_dims.x == 20);
+        REQUIRE(selection.mode.native_dims.y == 10);
+        REQUIRE(selection.get_width() == 20);
+        const auto driver = selection.get_unpacked_intrinsics(selection.mode.native_intrinsics);
+        REQUIRE(driver.ppx == cropped.ppx);
+        REQUIRE(driver.ppy == cropped.ppy);
+        REQUIRE(!selection.requires_processing());
+    }
+}
+
+TEST_CASE("frames unpacked in bands of rows match those unpacked in one pass", "[offline] [validation]")
+{
+    // Bands keep RS_MIN_UNPACK_BAND_BYTES of native data, planar formats and small frames stay whole
+    rs_intrinsics hd = {}, vga = {}, qvga = {};
+    hd.width = 1920; hd.height = 1080;
+    vga.width = 640; vga.height = 480;
+    qvga.width = 320; qvga.height = 240;
+    REQUIRE(rsimpl::subdevice_mode_selection({ 1, { 1920, 1080 }, rsimpl::pf_yuy2, 30, hd, {}, { 0 } }, 0, 0).choose_unpack_bands(RS_MAX_UNPACK_BANDS) == RS_MAX_UNPACK_BANDS);
+    REQUIRE(rsimpl::subdevice_mode_selection({ 1, { 1920, 1080 }, rsimpl::pf_yuy2, 30, hd, {}, { 0 } }, 0, 0).choose_unpack_bands(1) == 1);
+    REQUIRE(rsimpl::subdevice_mode_selection({ 0, { 640, 480 }, rsimpl::pf_z16, 30, vga, {}, { 0 } }, 0, 0).choose_unpack_bands(RS_MAX_UNPACK_BANDS) == 2);
+    REQUIRE(rsimpl::subdevice_mode_selection({ 0, { 320, 240 }, rsimpl::pf_z16, 30, qvga, {}, { 0 } }, 0, 0).choose_unpack_bands(RS_MAX_UNPACK_BANDS) == 1);
+    REQUIRE(rsimpl::subdevice_mode_selection({ 0, { 640, 480 }, rsimpl::pf_sr300_inzi, 30, vga, {}, { 0 } }, 0, 0).choose_unpack_bands(RS_MAX_UNPACK_BANDS) == 1);
+
+    const rsimpl::subdevice_mode mode = { 1, { 640, 480 }, rsimpl::pf_yuy2, 30, vga, {}, { 0, 8 } };
+    std::vector<uint8_t> native(rsimpl::pf_yuy2.get_image_size(640, 480));
+    for (size_t i = 0; i < native.size(); ++i) native[i] = static_cast<uint8_t>(i * 89 + 17);
+    rsimpl::parallel_pool pool(2);
+    for (size_t unpacker = 0; unpacker < rsimpl::pf_yuy2.unpackers.size(); ++unpacker)
+    {
+        // Long rows, rows specialized for their width, padded rows and cropped rows each split on rows
+        for (int variant = 0; variant < 4; ++variant)
+        {
+            if (variant == 2 && rsimpl::is_yuv420(rsimpl::pf_yuy2.unpackers[unpacker].outputs[0].second)) continue; // Only depth is padded
+            rsimpl::subdevice_mode_selection selection(mode, variant == 2 ? 8 : 0, unpacker);
+            if (variant == 1) selection.row_unpacker = rsimpl::find_row_unpacker(selection.get_unpacker().unpack, selection.get_unpacked_width());
+            if (variant == 3) selection.crop({ 64, 16, 512, 448 });
+            selection.unpack_bands = selection.choose_unpack_bands(RS_MAX_UNPACK_BANDS);
+            REQUIRE(selection.unpack_bands == 2);
+
+            const size_t size = selection.get_image_size(RS_STREAM_COLOR);
+            std::vector<uint8_t> serial(size, 0), banded(size, 0);
+            rsimpl::byte * const serial_dest[] = { serial.data() }, * const banded_dest[] = { banded.data() };
+            selection.unpack(serial_dest, native.data());
+            selection.unpack(banded_dest, native.data(), nullptr, nullptr, &pool);
+            INFO("unpacker " << unpacker << ", variant " << variant);
+            REQUIRE(std::mismatch(banded.begin(), banded.end(), serial.begin()).first - banded.begin() == (ptrdiff_t)size);
+        }
+    }
+}
+
+TEST_CASE("spatial depth filter smooths along rows then columns", "[offline] [validation]")
+{
+    for (auto size : { std::make_pair(37, 21), std::make_pair(64, 16), std::make_pair(5, 3) })
+    {
+        const int width = size.first, height = size.second, delta = 50;
+        std::vector<uint16_t> depth(width * height);
+        for (int i = 0; i < width * height; ++i) depth[i] = i % 7 == 3 ? 0 : static_cast<uint16_t>((i % width < width / 2 ? 1000 : 3000) + (i * 7919) % 61);
+
+        auto expected = depth;
+        for (int y = 0; y < height; ++y)
+        {
+            auto row = &expected[y * width];
+            for (int x = 1; x < width; ++x) row[x] = blend_depth(row[x], row[x - 1], 160, delta);
+            for (int x = width - 2; x >= 0; --x) row[x] = blend_depth(row[x], row[x + 1], 160, delta);
+        }
+        for (int y = 1; y < height; ++y) for (int x = 0; x < width; ++x) expected[y * width + x] = blend_depth(expected[y * width + x], expected[(y - 1) * width + x], 160, delta);
+        for (int y = height - 2; y >= 0; --y) for (int x = 0; x < width; ++x) expected[y * width + x] = blend_depth(expected[y * width + x], expected[(y + 1) * width + x], 160, delta);
+
+        rsimpl::filter_depth_spatial(depth.data(), width, height, 0.625f, delta);
+        REQUIRE(depth == expected);
+    }
+}
+
+TEST_CASE("temporal depth filter smooths over time and fills holes for a while", "[offline] [validation]")
+{
+    const int count = 29, persistence = 2, delta = 40;
+    rsimpl::temporal_depth_history history;
+    std::vector<uint16_t> last(count, 0);
+    std::vector<int> age(count, 255);
+    for (int frame = 0; frame < 8; ++frame)
+    {
+        std::vector<uint16_t> depth(count);
+        for (int i = 0; i < count; ++i) depth[i] = (i + frame) % 5 == 0 || (i % 3 == 0 && frame > 2) ? 0 : static_cast<uint16_t>(2000 + (i * 31 + frame * 17) % 70);
+
+        std::vector<uint16_t> expected(count);
+        for (int i = 0; i < count; ++i)
+        {
+            if (depth[i])
+            {
+                expected[i] = last[i] = blend_depth(depth[i], last[i], 64, delta);
+                age[i] = 0;
+            }
+            else
+            {
+                age[i] = std::min(age[i] + 1, 255);
+                expected[i] = age[i] <= persistence ? last[i] : 0;
+            }
+        }
+
+        rsimpl::filter_depth_temporal(depth.data(), count, history, 0.25f, delta, persistence);
+        REQUIRE(depth == expected);
+    }
+}
+
+TEST_CASE("depth statistics are gathered while depth is unpacked", "[offline] [validation]")
+{
+    const rs_intrinsics intrin = { 37, 9, 18.0f, 4.0f, 30.0f, 30.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rsimpl::subdevice_mode mode = { 1, { 37, 9 }, rsimpl::pf_z16, 30, intrin, {}, { 0 } };
+    std::vector<uint16_t> native(37 * 9);
+    for (size_t i = 0; i < native.size(); ++i) native[i] = i % 7 == 3 ? 0 : static_cast<uint16_t>((i * 7919) % 40000);
+
+    for (int factor : { 1, 2 })
+    {
+        rsimpl::subdevice_mode_selection selection(mode, 0, 0);
+        selection.zero_copy = true;
+        selection.decimation_factor = factor;
+        selection.gather_depth_statistics = true;
+        REQUIRE(selection.requires_processing());
+        REQUIRE(selection.get_plane_view(0) < 0);
+
+        std::vector<uint16_t> depth(selection.get_image_size(RS_STREAM_DEPTH) / sizeof(uint16_t));
+        rsimpl::byte * const dest[] = { reinterpret_cast<rsimpl::byte *>(depth.data()) };
+        rsimpl::depth_statistics statistics;
+        selection.unpack(dest, reinterpret_cast<const rsimpl::byte *>(native.data()), nullptr, &statistics);
+        if (factor == 1) REQUIRE(depth == native);
+
+        // Statistics describe the delivered image, after decimation
+        const int count = selection.get_output_width(RS_STREAM_DEPTH) * selection.get_output_height(RS_STREAM_DEPTH);
+        uint16_t min = 0xFFFF, max = 0;
+        uint32_t valid = 0, histogram[rsimpl::depth_statistics::histogram_bins] = {};
+        for (int i = 0; i < count; ++i)
+        {
+            const auto z = depth[i];
+            if (!z) continue;
+            min = std::min(min, z);
+            max = std::max(max, z);
+            ++valid;
+            int bin = 0;
+            while (bin + 1 < rsimpl::depth_statistics::histogram_bins && z >= 256 << bin) ++bin;
+            ++histogram[bin];
+        }
+        REQUIRE(valid > 0);
+        REQUIRE(statistics.min == min);
+        REQUIRE(statistics.max == max);
+        REQUIRE(statistics.valid == valid);
+        for (int k = 0; k < rsimpl::depth_statistics::histogram_bins; ++k) REQUIRE(statistics.histogram[k] == histogram[k]);
+    }
+}
+
+TEST_CASE("sampled histograms count every sample_rate-th pixel of every sample_rate-th row", "[offline] [validation]")
+{
+    // Rows of 37 pixels padded to 40, so neither the width nor the height is a multiple of the sample rates
+    const int width = 37, height = 11, stride = 40;
+    std::vector<uint8_t> pixels(stride * height);
+    for (size_t i = 0; i < pixels.size(); ++i) pixels[i] = static_cast<uint8_t>(i * 61 + 7);
+    for (int rate = 1; rate <= 3; ++rate)
+    {
+        int expected[256] = {}, expected_count = 0;
+        for (int y = 0; y < height; y += rate) for (int x = 0; x < width; x += rate, ++expected_count) ++expected[pixels[y * stride + x]];
+
+        int actual[256];
+        for (auto & bin : actual) bin = -1;
+        REQUIRE(rsimpl::histogram_of_samples(pixels.data(), width, height, stride, rate, actual) == expected_count);
+        for (int k = 0; k < 256; ++k) REQUIRE(actual[k] == expected[k]);
+    }
+}
+
+TEST_CASE("depth is colorized through a colormap carried over from frame to frame", "[offline] [validation]")
+{
+    const int count = 37 * 9;
+    const auto disparity_to_depth = rsimpl::compute_disparity_to_depth_table(32.0f);
+    auto make_frame = [count](int lowest, int highest)
+    {
+        std::vector<uint16_t> frame(count);
+        for (int i = 0; i < count; ++i) frame[i] = i % 7 == 3 ? 0 : static_cast<uint16_t>(lowest + (i * 7919) % (highest - lowest + 1));
+        return frame;
+    };
+
+    // The equalization of make_depth_histogram(...) in the examples, with disparities ordered far to near
+    auto equalized_color = [count](const std::vector<uint16_t> & frame, uint16_t d, bool disparity) -> std::array<uint8_t, 3>
+    {
+        if (!d) return {{ 20, 5, 0 }};
+        int64_t total = 0, through = 0;
+        for (auto v : frame) if (v)
+        {
+            ++total;
+            if (disparity ? v >= d : v <= d) ++through;
+        }
+        const int f = static_cast<int>(through * 255 / total);
+        return {{ static_cast<uint8_t>(255 - f), 0, static_cast<uint8_t>(f) }};
+    };
+
+    for (bool disparity : { false, true })
+    {
+        rsimpl::depth_colormap map;
+        std::vector<rsimpl::byte> rgb(count * 3);
+        // Overlapping, then disjoint and lower, then holes only, then again after the map was left untouched
+        for (auto range : { std::make_pair(1000, 5000), std::make_pair(3000, 9000), std::make_pair(100, 400), std::make_pair(0, 0), std::make_pair(2000, 2100) })
+        {
+            const auto frame = make_frame(range.first, range.second);
+            rsimpl::update_depth_colormap(map, frame.data(), count, disparity ? 32.0f : 0.001f, disparity ? &disparity_to_depth : nullptr, true, 6);
+            rsimpl::colorize_depth(rgb.data(), frame.data(), count, map.lut.data());
+            for (int i = 0; i < count; ++i)
+            {
+                const auto expected = equalized_color(frame, frame[i], disparity);
+                REQUIRE(rgb[i * 3 + 0] == expected[0]);
+                REQUIRE(rgb[i * 3 + 1] == expected[1]);
+                REQUIRE(rgb[i * 3 + 2] == expected[2]);
+            }
+        }
+
+        // Without equalization the colors span from zero to the maximum distance, and every farther depth is drawn in the farthest color
+        const auto frame = make_frame(1, 9000);
+        rsimpl::update_depth_colormap(map, frame.data(), count, disparity ? 32.0f : 0.001f, disparity ? &disparity_to_depth : nullptr, false, 4);
+        rsimpl::colorize_depth(rgb.data(), frame.data(), count, map.lut.data());
+        for (int i = 0; i < count; ++i)
+        {
+            const float meters = disparity ? disparity_to_depth[frame[i]] : frame[i] * 0.001f;
+            const int f = static_cast<int>(std::min(meters / 4, 1.0f) * 255);
+            REQUIRE(rgb[i * 3 + 0] == (frame[i] ? 255 - f : 20));
+            REQUIRE(rgb[i * 3 + 1] == (frame[i] ? 0 : 5));
+            REQUIRE(rgb[i * 3 + 2] == (frame[i] ? f : 0));
+        }
+    }
+}
+
+TEST_CASE("rs_convert_disparity_to_z16() converts through the disparity scale", "[offline] [validation]")
+{
+    const float disparity_scale = 100.0f, z_scale = 0.001f;
+    const std::vector<uint16_t> disparity = { 0, 1, 2, 7, 500, 35000, 65535 };
+    std::vector<uint16_t> z(disparity.size(), 1);
+    rs_convert_disparity_to_z16(disparity.data(), z.data(), static_cast<int>(z.size()), disparity_scale, z_scale, require_no_error());
+    REQUIRE(z[0] == 0);     // No data
+    REQUIRE(z[1] == 0);     // 100 meters is beyond 65535 millimeters
+    REQUIRE(z[2] == 50000);
+    REQUIRE(z[3] == 14286);
+    REQUIRE(z[4] == 200);
+    REQUIRE(z[5] == 3);
+    REQUIRE(z[6] == 2);     // 1.53 millimeters rounds to 2
+
+    rs_convert_disparity_to_z16(nullptr, z.data(), 1, disparity_scale, z_scale, require_error("null pointer passed for argument \"disparity_pixels\""));
+    rs_convert_disparity_to_z16(disparity.data(), nullptr, 1, disparity_scale, z_scale, require_error("null pointer passed for argument \"z_pixels\""));
+    rs_convert_disparity_to_z16(disparity.data(), z.data(), -1, disparity_scale, z_scale, require_error("out of range value for argument \"count\""));
+    rs_convert_disparity_to_z16(disparity.data(), z.data(), 1, 0.0f, z_scale, require_error("out of range value for argument \"disparity_scale\""));
+    rs_convert_disparity_to_z16(disparity.data(), z.data(), 1, disparity_scale, -1.0f, require_error("out of range value for argument \"z_scale\""));
+}
+
+TEST_CASE("rs_encode_depth() and rs_decode_depth() restore depth images exactly", "[offline] [validation]")
+{
+    // Holes, smooth surfaces, steps of every size and both ends of the range, over a length which is not a multiple of the vector width
+    std::vector<uint16_t> depth(1237);
+    for (size_t i = 0; i < depth.size(); ++i) depth[i] = i % 100 < 10 ? 0 : i % 100 < 50 ? static_cast<uint16_t>(1000 + i / 3) : static_cast<uint16_t>(i * 7919);
+    depth[depth.size() - 1] = 65535;
+    depth[depth.size() - 2] = 1;
+
+    const int max_size = rs_get_encoded_depth_max_size(static_cast<int>(depth.size()), require_no_error());
+    std::vector<unsigned char> encoded(max_size);
+    const int size = rs_encode_depth(depth.data(), static_cast<int>(depth.size()), encoded.data(), max_size, require_no_error());
+    REQUIRE(size > 0);
+    REQUIRE(size < static_cast<int>(depth.size() * sizeof(uint16_t)));
+
+    std::vector<uint16_t> decoded(depth.size(), 42);
+    rs_decode_depth(encoded.data(), size, decoded.data(), static_cast<int>(decoded.size()), require_no_error());
+    REQUIRE(decoded == depth);
+
+    rs_decode_depth(encoded.data(), size, decoded.data(), static_cast<int>(decoded.size()) - 1, require_error("encoded depth image does not have the expected number of pixels"));
+    rs_decode_depth(encoded.data(), size / 2, decoded.data(), static_cast<int>(decoded.size()), require_error("encoded depth image is truncated"));
+    REQUIRE(rs_encode_depth(depth.data(), 0, encoded.data(), max_size, require_no_error()) > 0);
+
+    REQUIRE(rs_get_encoded_depth_max_size(-1, require_error("out of range value for argument \"pixel_count\"")) == 0);
+    REQUIRE(rs_encode_depth(nullptr, 1, encoded.data(), max_size, require_error("null pointer passed for argument \"depth_pixels\"")) == 0);
+    REQUIRE(rs_encode_depth(depth.data(), 1, nullptr, max_size, require_error("null pointer passed for argument \"buffer\"")) == 0);
+    REQUIRE(rs_encode_depth(depth.data(), static_cast<int>(depth.size()), encoded.data(), size, require_error("buffer is smaller than rs_get_encoded_depth_max_size()")) == 0);
+    rs_decode_depth(nullptr, size, decoded.data(), 1, require_error("null pointer passed for argument \"data\""));
+    rs_decode_depth(encoded.data(), size, nullptr, 1, require_error("null pointer passed for argument \"depth_pixels\""));
+    rs_decode_depth(encoded.data(), -1, decoded.data(), 1, require_error("out of range value for argument \"size\""));
+}
+
+TEST_CASE("rs_create_server() validates input", "[offline] [validation]")
+{
+    REQUIRE(rs_create_server(nullptr, -1, require_error("out of range value for argument \"port\"")) == nullptr);
+    REQUIRE(rs_create_server(nullptr, 65536, require_error("out of range value for argument \"port\"")) == nullptr);
+    REQUIRE(rs_create_server("192.0.2.1", 0, require_error("", false)) == nullptr);
+    REQUIRE(rs_get_server_port(nullptr, require_error("null pointer passed for argument \"server\"")) == 0);
+    rs_delete_server(nullptr, require_error("null pointer passed for argument \"server\""));
+}
+
+TEST_CASE("servers reply to every request, with the reason of those which failed", "[offline] [validation]")
+{
+    using namespace rsimpl::network;
+    server s("127.0.0.1", 0);
+    REQUIRE(s.get_port() > 0);
+    auto client = tcp_socket::connect("127.0.0.1", s.get_port());
+
+    auto request = [&](message_type type, int device, int32_t value, std::string & message)
+    {
+        static uint32_t next_request = 1;
+        const message_header header = { protocol_magic, type, next_request++, device, 0, reply_status::ok, 0 };
+        arguments args = {};
+        args.values[0] = value;
+        send_message(*client, header, &args, nullptr, 0);
+
+        message_header reply;
+        REQUIRE(client->receive(&reply, sizeof(reply)));
+        REQUIRE(reply.magic == protocol_magic);
+        REQUIRE(reply.type == message_type::reply);
+        REQUIRE(reply.request == header.request);
+        REQUIRE(reply.size >= sizeof(args));
+        REQUIRE(client->receive(&args, sizeof(args)));
+        message.resize(reply.size - sizeof(args));
+        if (message.size()) REQUIRE(client->receive(&message[0], message.size()));
+        return reply.status;
+    };
+
+    std::string message;
+    REQUIRE(request(message_type::hello, -1, protocol_version, message) == reply_status::ok);
+    REQUIRE(message.empty());
+    REQUIRE(request(message_type::hello, -1, protocol_version + 1, message) == reply_status::failed);
+    REQUIRE(message == "server speaks version 1 of the protocol, client 2");
+    REQUIRE(request(message_type::get_pu_control, 1000, RS_OPTION_COLOR_GAIN, message) == reply_status::failed);
+    REQUIRE(message == "no device 1000");
+
+    // The session outlives a request it does not know
+    REQUIRE(request(static_cast<message_type>(63), -1, 0, message) == reply_status::failed);
+    REQUIRE(request(message_type::hello, -1, protocol_version, message) == reply_status::ok);
+}
+
+namespace
+{
+    // A native stream whose frame lives in a plain vector
+    struct fake_stream : rsimpl::stream_interface
+    {
+        rs_intrinsics intrin;
+        rs_format format;
+        std::vector<uint8_t> image;
+
+        template<class T> fake_stream(rs_stream stream, const rs_intrinsics & intrin, rs_format format, const std::vector<T> & pixels) : stream_interface(rsimpl::calibration_validator(), stream),
+            intrin(intrin), format(format), image(reinterpret_cast<const uint8_t *>(pixels.data()), reinterpret_cast<const uint8_t *>(pixels.data() + pixels.size())) {}
+
+        rsimpl::pose get_pose() const override { return { { { 1,0,0 },{ 0,1,0 },{ 0,0,1 } },{ 0,0,0 } }; }
+        float get_depth_scale() const override { return 0.001f; }
+        bool is_enabled() const override { return true; }
+        rs_intrinsics get_intrinsics() const override { return intrin; }
+        rs_intrinsics get_rectified_intrinsics() const override { return intrin; }
+        rs_format get_format() const override { return format; }
+        int get_framerate() const override { return 30; }
+        double get_frame_metadata(rs_frame_metadata) const override { return 0; }
+        bool supports_frame_metadata(rs_frame_metadata) const override { return false; }
+        unsigned long long get_frame_number() const override { return 1; }
+        double get_frame_timestamp() const override { return 0; }
+        long long get_frame_system_time() const override { return 0; }
+        const uint8_t * get_frame_data() const override { return image.data(); }
+        int get_frame_stride() const override { return intrin.width * get_frame_bpp() / 8; }
+        int get_frame_bpp() const override { return rsimpl::get_image_bpp(format); }
+    };
+}
+
+TEST_CASE("derived frames are computed concurrently into archive frames", "[offline] [validation]")
+{
+    rs_intrinsics intrin = { 32, 8, 15.5f, 3.5f, 20.0f, 20.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    std::vector<uint16_t> depth(32 * 8);
+    for (size_t i = 0; i < depth.size(); ++i) depth[i] = static_cast<uint16_t>(i * 37);
+    fake_stream source(RS_STREAM_DEPTH, intrin, RS_FORMAT_Z16, depth);
+    rsimpl::point_stream points(source, source);
+    REQUIRE(points.get_frame_source() == RS_STREAM_DEPTH);
+
+    std::vector<float> expected(32 * 8 * 3);
+    rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(expected.data()), RS_FORMAT_XYZ32F, rsimpl::compute_deprojection_table(intrin), depth.data(), 0.001f);
+
+    std::atomic<uint32_t> queue_size(RS_USER_QUEUE_SIZE);
+    rsimpl::frame_archive archive({}, &queue_size);
+    rsimpl::frame_archive::frame_additional_data data(1.0, 7, 3, 32, 8, 30, 32, 8, 96, RS_FORMAT_XYZ32F, RS_STREAM_POINTS, 0, 0, 0, 0);
+    const rsimpl::source_frame_lookup lookup = rsimpl::get_frontbuffer_image;
+
+    // Every thread computes its own frames, while the calibration tables are shared between them
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&]()
+        {
+            for (int i = 0; i < 20; ++i)
+            {
+                auto ref = archive.create_derived_frame(data, [&](rsimpl::byte * dest) { points.compute_frame(dest, lookup); });
+                if (!ref) { ++mismatches; continue; }
+                if (ref->get_frame_number() != 7 || ref->get_stream_type() != RS_STREAM_POINTS || ref->get_frame_stride() != 32 * 12 ||
+                    memcmp(ref->get_frame_data(), expected.data(), expected.size() * sizeof(float))) ++mismatches;
+                archive.release_frame_ref(ref);
+            }
+        });
+    }
+    for (auto & t : threads) t.join();
+    REQUIRE(mismatches == 0);
+
+    // A source that cannot be read hands the frame back to the pool
+    REQUIRE_THROWS(archive.create_derived_frame(data, [&](rsimpl::byte * dest) { points.compute_frame(dest, [](const rsimpl::stream_interface &) -> rsimpl::source_image { throw std::runtime_error("no frame"); }); }));
+    REQUIRE_THROWS(source.compute_frame(nullptr, lookup));
+    archive.flush();
+}
+
+TEST_CASE("derived streams only compute their roi", "[offline] [validation]")
+{
+    // Power of two focal lengths keep the pixel corners exact, so that the window of an alignment lands on the same pixels as the whole image
+    rs_intrinsics intrin = { 32, 8, 16.0f, 4.0f, 16.0f, 16.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    std::vector<uint16_t> depth(32 * 8);
+    std::vector<uint8_t> rgb(32 * 8 * 3);
+    for (size_t i = 0; i < depth.size(); ++i) depth[i] = static_cast<uint16_t>(i % 5 ? 500 + i * 3 : 0);
+    for (size_t i = 0; i < rgb.size(); ++i) rgb[i] = static_cast<uint8_t>(i * 7);
+    fake_stream depth_stream(RS_STREAM_DEPTH, intrin, RS_FORMAT_Z16, depth), color_stream(RS_STREAM_COLOR, intrin, RS_FORMAT_RGB8, rgb);
+    rsimpl::point_stream points(depth_stream, color_stream);
+    rsimpl::rectified_stream rect_color(color_stream);
+    rsimpl::aligned_stream color_to_depth(color_stream, depth_stream, RS_STREAM_COLOR_ALIGNED_TO_DEPTH);
+    const rsimpl::source_frame_lookup lookup = rsimpl::get_frontbuffer_image;
+
+    std::vector<float> full_points(32 * 8 * 3);
+    std::vector<uint8_t> full_aligned(32 * 8 * 3);
+    points.compute_frame(reinterpret_cast<rsimpl::byte *>(full_points.data()), lookup);
+    color_to_depth.compute_frame(full_aligned.data(), lookup);
+
+    const rsimpl::stream_roi roi(5, 2, 12, 4);
+    for (rsimpl::stream_interface * s : { (rsimpl::stream_interface *)&points, (rsimpl::stream_interface *)&rect_color, (rsimpl::stream_interface *)&color_to_depth })
+    {
+        s->set_roi(roi);
+        const auto window = s->get_intrinsics();
+        REQUIRE(window.width == 12);
+        REQUIRE(window.height == 4);
+        REQUIRE(window.ppx == 11.0f);
+        REQUIRE(window.ppy == 2.0f);
+    }
+    REQUIRE(points.get_frame_stride() == 12 * 12);
+
+    std::vector<float> roi_points(12 * 4 * 3);
+    std::vector<uint8_t> roi_rect(12 * 4 * 3), roi_aligned(12 * 4 * 3);
+    points.compute_frame(reinterpret_cast<rsimpl::byte *>(roi_points.data()), lookup);
+    rect_color.compute_frame(roi_rect.data(), lookup);
+    color_to_depth.compute_frame(roi_aligned.data(), lookup);
+    for (int y = 0; y < 4; ++y)
+    {
+        for (int x = 0; x < 12; ++x)
+        {
+            const int full = (y + 2) * 32 + x + 5, window = y * 12 + x;
+            for (int c = 0; c < 3; ++c)
+            {
+                REQUIRE(roi_points[window * 3 + c] == Approx(full_points[full * 3 + c]));
+                REQUIRE(roi_rect[window * 3 + c] == rgb[full * 3 + c]);
+                REQUIRE(roi_aligned[window * 3 + c] == full_aligned[full * 3 + c]);
+            }
+        }
+    }
+
+    // Windows are clipped to the image, and an empty window selects the whole image again
+    points.set_roi(rsimpl::stream_roi(28, 6, 10, 10));
+    REQUIRE(points.get_intrinsics().width == 4);
+    REQUIRE(points.get_intrinsics().height == 2);
+    points.set_roi(rsimpl::stream_roi());
+    REQUIRE(rsimpl::operator==(points.get_intrinsics(), intrin));
+}
+
+TEST_CASE("decimated aligned streams align the decimated depth image", "[offline] [validation]")
+{
+    rs_intrinsics intrin = { 32, 8, 16.0f, 4.0f, 16.0f, 16.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    std::vector<uint16_t> depth(32 * 8);
+    std::vector<uint8_t> rgb(32 * 8 * 3);
+    for (size_t i = 0; i < depth.size(); ++i) depth[i] = static_cast<uint16_t>(i % 5 ? 500 + i * 3 : 0);
+    for (size_t i = 0; i < rgb.size(); ++i) rgb[i] = static_cast<uint8_t>(i * 7);
+    fake_stream depth_stream(RS_STREAM_DEPTH, intrin, RS_FORMAT_Z16, depth), color_stream(RS_STREAM_COLOR, intrin, RS_FORMAT_RGB8, rgb);
+    rsimpl::aligned_stream color_to_depth(color_stream, depth_stream, RS_STREAM_COLOR_ALIGNED_TO_DEPTH), depth_to_color(depth_stream, color_stream, RS_STREAM_DEPTH_ALIGNED_TO_COLOR);
+    const rsimpl::source_frame_lookup lookup = rsimpl::get_frontbuffer_image;
+
+    // Aligning at half the resolution matches aligning at full resolution to a depth image decimated ahead of time
+    const auto half = rsimpl::decimate_intrinsics(intrin, 2);
+    auto decimated = depth;
+    rsimpl::decimate_depth(decimated.data(), 32, 8, 2, false);
+    decimated.resize(16 * 4);
+    fake_stream half_depth(RS_STREAM_DEPTH, half, RS_FORMAT_Z16, decimated), half_color(RS_STREAM_COLOR, half, RS_FORMAT_RGB8, rgb);
+    rsimpl::aligned_stream color_to_half_depth(color_stream, half_depth, RS_STREAM_COLOR_ALIGNED_TO_DEPTH), half_depth_to_color(half_depth, half_color, RS_STREAM_DEPTH_ALIGNED_TO_COLOR);
+
+    for (auto s : { &color_to_depth, &depth_to_color }) s->set_decimation(2);
+    REQUIRE(rsimpl::operator==(color_to_depth.get_intrinsics(), half));
+    REQUIRE(rsimpl::operator==(depth_to_color.get_intrinsics(), half));
+    REQUIRE(color_to_depth.get_frame_stride() == 16 * 3);
+
+    std::vector<uint8_t> aligned_color(16 * 4 * 3), expected_color(16 * 4 * 3);
+    color_to_depth.compute_frame(aligned_color.data(), lookup);
+    color_to_half_depth.compute_frame(expected_color.data(), lookup);
+    REQUIRE(aligned_color == expected_color);
+
+    std::vector<uint16_t> aligned_depth(16 * 4), expected_depth(16 * 4);
+    depth_to_color.compute_frame(reinterpret_cast<rsimpl::byte *>(aligned_depth.data()), lookup);
+    half_depth_to_color.compute_frame(reinterpret_cast<rsimpl::byte *>(expected_depth.data()), lookup);
+    REQUIRE(aligned_depth == expected_depth);
+    REQUIRE(std::count(aligned_depth.begin(), aligned_depth.end(), 0) < 16 * 4);
+
+    // Windows are taken in the decimated image
+    color_to_depth.set_roi(rsimpl::stream_roi(2, 1, 8, 2));
+    color_to_half_depth.set_roi(rsimpl::stream_roi(2, 1, 8, 2));
+    REQUIRE(rsimpl::operator==(color_to_depth.get_intrinsics(), color_to_half_depth.get_intrinsics()));
+    std::vector<uint8_t> window(8 * 2 * 3), expected_window(8 * 2 * 3);
+    color_to_depth.compute_frame(window.data(), lookup);
+    color_to_half_depth.compute_frame(expected_window.data(), lookup);
+    REQUIRE(window == expected_window);
+}
+
+TEST_CASE("rectified fisheye images sample the f-theta image bilinearly", "[offline] [validation]")
+{
+    // Not a multiple of the tile width, so partial tiles and the portable tail of every row are covered
+    const int width = 100, height = 70;
+    const rs_intrinsics intrin = { width, height, 49.5f, 34.5f, 40.0f, 40.0f, RS_DISTORTION_FTHETA, { 0.9f, 0, 0, 0, 0 } };
+    std::vector<uint8_t> ramp(width * height), noise(width * height);
+    for (int i = 0; i < width * height; ++i)
+    {
+        ramp[i] = static_cast<uint8_t>(i % width + 2 * (i / width));
+        noise[i] = static_cast<uint8_t>(i * 89 + 17);
+    }
+    fake_stream fisheye(RS_STREAM_FISHEYE, intrin, RS_FORMAT_RAW8, ramp);
+    rsimpl::rectified_stream rect(fisheye, RS_STREAM_RECTIFIED_FISHEYE);
+    const auto rect_intrin = rect.get_intrinsics();
+    REQUIRE(rect.get_stream_type() == RS_STREAM_RECTIFIED_FISHEYE);
+    REQUIRE(rect_intrin.model == RS_DISTORTION_NONE);
+    REQUIRE(rect_intrin.coeffs[0] == 0);
+    REQUIRE(rect_intrin.fx == intrin.fx);
+    REQUIRE(rect_intrin.ppx == intrin.ppx);
+
+    // A ramp is sampled where the f-theta model bends each pinhole ray to, up to the rounding of the weights
+    std::vector<uint8_t> image(width * height);
+    rect.compute_frame(image.data(), rsimpl::get_frontbuffer_image);
+    int sampled = 0;
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            float u = (x - intrin.ppx) / intrin.fx, v = (y - intrin.ppy) / intrin.fy;
+            const float r = std::sqrt(u*u + v*v);
+            if (r > 0)
+            {
+                const float scale = std::atan(2 * r * std::tan(intrin.coeffs[0] / 2)) / (intrin.coeffs[0] * r);
+                u *= scale;
+                v *= scale;
+            }
+            const float px = u * intrin.fx + intrin.ppx, py = v * intrin.fy + intrin.ppy;
+            if (px < 0.01f || py < 0.01f || px > width - 1.01f || py > height - 1.01f) continue;
+            REQUIRE(std::abs(image[y * width + x] - (px + 2 * py)) <= 1.5f);
+            ++sampled;
+        }
+    }
+    REQUIRE(sampled > width * height / 2);
+
+    // The block kernels blend exactly as the portable code does
+    const auto table = rsimpl::compute_fisheye_remap_table(rect_intrin, rs_extrinsics{ { 1,0,0, 0,1,0, 0,0,1 }, { 0,0,0 } }, intrin);
+    rsimpl::remap_fisheye_image(image.data(), table, noise.data());
+    const int tiles_per_row = (width + rsimpl::fisheye_remap_table::tile_width - 1) / rsimpl::fisheye_remap_table::tile_width;
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const int entry = ((y / 4) * tiles_per_row + x / 64) * rsimpl::fisheye_remap_table::tile_size + (y % 4) * 64 + x % 64;
+            const int index = table.indices[entry], wx = table.weights_x[entry], wy = table.weights_y[entry];
+            if (index < 0) { REQUIRE(image[y * width + x] == 0); continue; }
+            const int top = noise[index] * (64 - wx) + noise[index + 1] * wx, bottom = noise[index + width] * (64 - wx) + noise[index + width + 1] * wx;
+            REQUIRE(image[y * width + x] == (top * (64 - wy) + bottom * wy + 2048) >> 12);
+        }
+    }
+}
+
+TEST_CASE("derived streams read padded frames and can pad their rows", "[offline] [validation]")
+{
+    rs_intrinsics intrin = { 32, 8, 16.0f, 4.0f, 16.0f, 16.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    std::vector<uint16_t> depth(32 * 8);
+    std::vector<uint8_t> rgb(32 * 8 * 3);
+    for (size_t i = 0; i < depth.size(); ++i) depth[i] = static_cast<uint16_t>(i % 5 ? 500 + i * 3 : 0);
+    for (size_t i = 0; i < rgb.size(); ++i) rgb[i] = static_cast<uint8_t>(i * 7);
+    fake_stream depth_stream(RS_STREAM_DEPTH, intrin, RS_FORMAT_Z16, depth), color_stream(RS_STREAM_COLOR, intrin, RS_FORMAT_RGB8, rgb);
+    rsimpl::point_stream points(depth_stream, color_stream);
+    rsimpl::rectified_stream rect_color(color_stream);
+    rsimpl::aligned_stream color_to_depth(color_stream, depth_stream, RS_STREAM_COLOR_ALIGNED_TO_DEPTH), depth_to_color(depth_stream, color_stream, RS_STREAM_DEPTH_ALIGNED_TO_COLOR);
+    const std::vector<rsimpl::stream_interface *> derived = { &points, &rect_color, &color_to_depth, &depth_to_color };
+
+    // Packed images of a window computed from packed frames
+    std::vector<std::vector<uint8_t>> packed;
+    for (auto s : derived)
+    {
+        s->set_roi(rsimpl::stream_roi(5, 2, 13, 4));
+        REQUIRE(s->get_row_stride() == 13);
+        packed.emplace_back(s->get_frame_stride() * 4);
+        s->compute_frame(packed.back().data(), rsimpl::get_frontbuffer_image);
+    }
+
+    // The same frames with rows of 40 pixels, as RS_OUTPUT_BUFFER_FORMAT_NATIVE hands them out, into rows starting on multiples of 64 bytes
+    std::vector<uint8_t> padded_depth(40 * 8 * 2, 0xAB), padded_rgb(40 * 8 * 3, 0xCD);
+    for (int y = 0; y < 8; ++y)
+    {
+        memcpy(&padded_depth[y * 40 * 2], &depth[y * 32], 32 * 2);
+        memcpy(&padded_rgb[y * 40 * 3], &rgb[y * 32 * 3], 32 * 3);
+    }
+    const rsimpl::source_frame_lookup padded_lookup = [&](const rsimpl::stream_interface & s) { return rsimpl::source_image{ s.get_format() == RS_FORMAT_Z16 ? padded_depth.data() : padded_rgb.data(), 40 }; };
+    for (size_t i = 0; i < derived.size(); ++i)
+    {
+        auto s = derived[i];
+        s->set_row_alignment(64);
+        REQUIRE(s->get_row_stride() > 13);
+        REQUIRE(s->get_frame_stride() % 64 == 0);
+        std::vector<uint8_t> padded(s->get_frame_stride() * 4);
+        s->compute_frame(padded.data(), padded_lookup);
+        const size_t row_size = 13 * s->get_frame_bpp() / 8;
+        for (int y = 0; y < 4; ++y) REQUIRE(!memcmp(&padded[y * s->get_frame_stride()], &packed[i][y * row_size], row_size));
+    }
+    REQUIRE(points.get_row_stride() == 16);
+    points.set_voxel_size(0.05f);
+    REQUIRE(points.get_row_stride() == 13);
+
+    // Rectification reads the unrectified image through the stride its table was built for
+    const rs_extrinsics rotation = { { 0.9998f, 0.0175f, 0, -0.0175f, 0.9998f, 0, 0, 0, 1 }, { 0, 0, 0 } };
+    std::vector<uint8_t> rect(32 * 8 * 3), padded_rect(48 * 8 * 3);
+    rsimpl::rectify_image(rect.data(), rsimpl::compute_rectification_table(intrin, rotation, intrin), rgb.data(), RS_FORMAT_RGB8);
+    rsimpl::rectify_image(padded_rect.data(), rsimpl::compute_rectification_table(intrin, rotation, intrin, 40), padded_rgb.data(), RS_FORMAT_RGB8, 48);
+    for (int y = 0; y < 8; ++y) REQUIRE(!memcmp(&padded_rect[y * 48 * 3], &rect[y * 32 * 3], 32 * 3));
+}
+
+TEST_CASE("points carry the texture coordinates of the color pixel they project to", "[offline] [validation]")
+{
+    const rs_intrinsics depth_intrin = { 32, 8, 15.5f, 3.5f, 20.0f, 20.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rs_intrinsics color_intrin = { 64, 16, 31.0f, 8.5f, 45.0f, 44.0f, RS_DISTORTION_MODIFIED_BROWN_CONRADY, { 0.1f, -0.05f, 0.001f, 0.002f, 0 } };
+    const rs_extrinsics depth_to_color = { { 0.9998f, 0.0175f, 0, -0.0175f, 0.9998f, 0, 0, 0, 1 }, { 0.025f, 0.001f, -0.002f } };
+    std::vector<uint16_t> depth(32 * 8);
+    for (size_t i = 0; i < depth.size(); ++i) depth[i] = static_cast<uint16_t>(i % 5 ? 400 + i * 11 : 0);
+    const auto table = rsimpl::compute_deprojection_table(depth_intrin);
+
+    std::vector<float> points(depth.size() * 5);
+    rsimpl::deproject_z_textured(reinterpret_cast<rsimpl::byte *>(points.data()), table, depth.data(), 0.001f, depth_to_color, color_intrin);
+    for (int i = 0; i < 32 * 8; ++i)
+    {
+        const float pixel[] = { static_cast<float>(i % 32), static_cast<float>(i / 32) };
+        float point[3], color_point[3], color_pixel[2];
+        rs_deproject_pixel_to_point(point, &depth_intrin, pixel, depth[i] * 0.001f);
+        rs_transform_point_to_point(color_point, &depth_to_color, point);
+        rs_project_point_to_pixel(color_pixel, &color_intrin, color_point);
+        for (int c = 0; c < 3; ++c) REQUIRE(points[i * 5 + c] == Approx(point[c]));
+        REQUIRE(points[i * 5 + 3] == (depth[i] ? Approx((color_pixel[0] + 0.5f) / 64) : Approx(0)));
+        REQUIRE(points[i * 5 + 4] == (depth[i] ? Approx((color_pixel[1] + 0.5f) / 16) : Approx(0)));
+    }
+
+    // The point stream projects into the stream it was given as its texture
+    std::vector<uint8_t> rgb(64 * 16 * 3);
+    fake_stream depth_stream(RS_STREAM_DEPTH, depth_intrin, RS_FORMAT_Z16, depth), color_stream(RS_STREAM_COLOR, color_intrin, RS_FORMAT_RGB8, rgb);
+    rsimpl::point_stream textured(depth_stream, color_stream);
+    textured.set_format(RS_FORMAT_XYZUV32F);
+    REQUIRE(textured.get_frame_stride() == 32 * 20);
+    std::vector<float> stream_points(depth.size() * 5), expected(depth.size() * 5);
+    textured.compute_frame(reinterpret_cast<rsimpl::byte *>(stream_points.data()), rsimpl::get_frontbuffer_image);
+    rsimpl::deproject_z_textured(reinterpret_cast<rsimpl::byte *>(expected.data()), table, depth.data(), 0.001f, depth_stream.get_extrinsics_to(color_stream), color_intrin);
+    REQUIRE(stream_points == expected);
+}
+
+TEST_CASE("points are reduced to the mean point of every voxel", "[offline] [validation]")
+{
+    const rs_intrinsics intrin = { 64, 48, 31.5f, 23.5f, 40.0f, 40.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    std::vector<uint16_t> depth(64 * 48);
+    for (size_t i = 0; i < depth.size(); ++i) depth[i] = static_cast<uint16_t>(i % 9 == 4 ? 0 : 500 + (i * 7919) % 3000);
+    const auto table = rsimpl::compute_deprojection_table(intrin);
+
+    for (float leaf : { 0.005f, 0.05f, 0.5f })
+    {
+        // Cubes in the order they are first reached, with their points summed in pixel order
+        std::vector<std::tuple<int, int, int>> order;
+        std::map<std::tuple<int, int, int>, std::array<float, 4>> sums;
+        for (size_t i = 0; i < depth.size(); ++i)
+        {
+            if (!depth[i]) continue;
+            const float z = 0.001f * depth[i], x = z * table[i * 2], y = z * table[i * 2 + 1];
+            const auto cube = std::make_tuple((int)std::floor(x * (1 / leaf)), (int)std::floor(y * (1 / leaf)), (int)std::floor(z * (1 / leaf)));
+            if (!sums.count(cube)) { order.push_back(cube); sums[cube] = {{ 0, 0, 0, 0 }}; }
+            auto & sum = sums[cube];
+            sum[0] += x;
+            sum[1] += y;
+            sum[2] += z;
+            ++sum[3];
+        }
+
+        std::vector<float> points(depth.size() * 3, 1.0f);
+        const int count = rsimpl::deproject_z_to_voxels(reinterpret_cast<rsimpl::byte *>(points.data()), RS_FORMAT_XYZ32F, table, depth.data(), 0.001f, leaf);
+        REQUIRE(count == (int)order.size());
+        REQUIRE(count < (int)depth.size());
+        for (int k = 0; k < count; ++k)
+        {
+            const auto & sum = sums[order[k]];
+            for (int c = 0; c < 3; ++c) REQUIRE(points[k * 3 + c] == Approx(sum[c] / sum[3]));
+        }
+        for (size_t k = count * 3; k < points.size(); ++k) REQUIRE(points[k] == 0);
+    }
+
+    // The point stream lists its voxels in front of the frame
+    fake_stream depth_stream(RS_STREAM_DEPTH, intrin, RS_FORMAT_Z16, depth);
+    rsimpl::point_stream points(depth_stream, depth_stream);
+    points.set_voxel_size(0.05f);
+    std::vector<float> stream_points(depth.size() * 3), expected(depth.size() * 3);
+    points.compute_frame(reinterpret_cast<rsimpl::byte *>(stream_points.data()), rsimpl::get_frontbuffer_image);
+    rsimpl::deproject_z_to_voxels(reinterpret_cast<rsimpl::byte *>(expected.data()), RS_FORMAT_XYZ32F, table, depth.data(), 0.001f, 0.05f);
+    REQUIRE(stream_points == expected);
+    points.set_format(RS_FORMAT_XYZUV32F);
+    REQUIRE_THROWS(points.compute_frame(reinterpret_cast<rsimpl::byte *>(stream_points.data()), rsimpl::get_frontbuffer_image));
+}
+
+TEST_CASE("normals are the unit normals of the surface behind the depth image", "[offline] [validation]")
+{
+    // A wall facing the camera, and a plane tilted about both axes, are seen with the normals of the planes everywhere but on the border
+    const rs_intrinsics intrin = { 13, 9, 6.0f, 4.0f, 10.0f, 10.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const auto table = rsimpl::compute_deprojection_table(intrin);
+    const float plane[] = { 0.3f, -0.2f, -0.9327379f }; // Unit normal facing the camera, of the plane n.p = -1 meter
+    std::vector<uint16_t> wall(13 * 9, 1500), tilted(13 * 9);
+    for (int i = 0; i < 13 * 9; ++i) tilted[i] = static_cast<uint16_t>(std::lround(-10000 / (plane[0] * table[i * 2] + plane[1] * table[i * 2 + 1] + plane[2])));
+
+    std::vector<float> normals(13 * 9 * 3, 1.0f);
+    rsimpl::compute_z_normals(normals.data(), table, wall.data(), 0.001f, 13, 9);
+    for (int y = 0; y < 9; ++y) for (int x = 0; x < 13; ++x)
+    {
+        const bool border = x == 0 || y == 0 || x == 12 || y == 8;
+        REQUIRE(normals[(y * 13 + x) * 3] == 0);
+        REQUIRE(normals[(y * 13 + x) * 3 + 1] == 0);
+        REQUIRE(normals[(y * 13 + x) * 3 + 2] == (border ? 0 : -1));
+    }
+    rsimpl::compute_z_normals(normals.data(), table, tilted.data(), 0.0001f, 13, 9);
+    for (int y = 1; y < 8; ++y) for (int x = 1; x < 12; ++x) for (int c = 0; c < 3; ++c) REQUIRE(normals[(y * 13 + x) * 3 + c] == Approx(plane[c]).epsilon(0.01));
+
+    // Every pixel matches the cross product of the points of its neighbours, and those next to a hole have none
+    std::vector<uint16_t> depth(13 * 9);
+    for (size_t i = 0; i < depth.size(); ++i) depth[i] = static_cast<uint16_t>(i % 11 == 5 ? 0 : 800 + (i * 7919) % 400);
+    std::vector<float> points(depth.size() * 3);
+    rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(points.data()), RS_FORMAT_XYZ32F, table, depth.data(), 0.001f);
+    rsimpl::compute_z_normals(normals.data(), table, depth.data(), 0.001f, 13, 9);
+    for (int y = 1; y < 8; ++y) for (int x = 1; x < 12; ++x)
+    {
+        auto p = [&](int dx, int dy, int c) { return points[((y + dy) * 13 + x + dx) * 3 + c]; };
+        const float h[] = { p(1, 0, 0) - p(-1, 0, 0), p(1, 0, 1) - p(-1, 0, 1), p(1, 0, 2) - p(-1, 0, 2) };
+        const float v[] = { p(0, 1, 0) - p(0, -1, 0), p(0, 1, 1) - p(0, -1, 1), p(0, 1, 2) - p(0, -1, 2) };
+        const float n[] = { v[1] * h[2] - v[2] * h[1], v[2] * h[0] - v[0] * h[2], v[0] * h[1] - v[1] * h[0] };
+        const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        const bool hole = !p(0, 0, 2) || !p(-1, 0, 2) || !p(1, 0, 2) || !p(0, -1, 2) || !p(0, 1, 2);
+        INFO(x << "," << y);
+        for (int c = 0; c < 3; ++c) REQUIRE(normals[(y * 13 + x) * 3 + c] == (hole ? Approx(0) : Approx(n[c] / length)));
+    }
+
+    // The stream computes the normals of its window of depth, into rows padded to its alignment, from disparity as from Z16
+    fake_stream depth_stream(RS_STREAM_DEPTH, intrin, RS_FORMAT_Z16, depth);
+    rsimpl::normal_stream stream(depth_stream);
+    REQUIRE(stream.get_format() == RS_FORMAT_XYZ32F);
+    REQUIRE(stream.get_frame_source() == RS_STREAM_DEPTH);
+    std::vector<float> stream_normals(13 * 9 * 3);
+    stream.compute_frame(reinterpret_cast<rsimpl::byte *>(stream_normals.data()), rsimpl::get_frontbuffer_image);
+    REQUIRE(stream_normals == normals);
+
+    stream.set_roi({ 2, 1, 8, 6 });
+    stream.set_row_alignment(64);
+    REQUIRE(stream.get_row_stride() == 16);
+    std::vector<float> window_normals(16 * 6 * 3), expected(8 * 6 * 3);
+    std::vector<uint16_t> window(8 * 6);
+    for (int y = 0; y < 6; ++y) for (int x = 0; x < 8; ++x) window[y * 8 + x] = depth[(y + 1) * 13 + x + 2];
+    stream.compute_frame(reinterpret_cast<rsimpl::byte *>(window_normals.data()), rsimpl::get_frontbuffer_image);
+    rsimpl::compute_z_normals(expected.data(), rsimpl::compute_deprojection_table(stream.get_intrinsics()), window.data(), 0.001f, 8, 6);
+    for (int y = 0; y < 6; ++y) REQUIRE(std::vector<float>(window_normals.begin() + y * 16 * 3, window_normals.begin() + (y * 16 + 8) * 3) == std::vector<float>(expected.begin() + y * 8 * 3, expected.begin() + (y + 1) * 8 * 3));
+
+    std::vector<uint16_t> disparity(13 * 9, 0);
+    for (size_t i = 0; i < disparity.size(); ++i) disparity[i] = static_cast<uint16_t>(i % 11 == 5 ? 0 : 2000 + i * 3);
+    fake_stream disparity_stream(RS_STREAM_DEPTH, intrin, RS_FORMAT_DISPARITY16, disparity);
+    rsimpl::normal_stream from_disparity(disparity_stream);
+    from_disparity.compute_frame(reinterpret_cast<rsimpl::byte *>(stream_normals.data()), rsimpl::get_frontbuffer_image);
+    rsimpl::compute_disparity_normals(normals.data(), table, disparity.data(), rsimpl::compute_disparity_to_depth_table(0.001f), 13, 9);
+    REQUIRE(stream_normals == normals);
+}
+
+TEST_CASE("depth images of several cameras are fused into one point cloud in a common frame", "[offline] [validation]")
+{
+    // Two cameras, the second with padded rows and turned a quarter around y and moved, as a rig would hold them
+    const rs_intrinsics intrin_a = { 64, 48, 31.5f, 23.5f, 40.0f, 40.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rs_intrinsics intrin_b = { 30, 20, 14.5f, 9.5f, 25.0f, 25.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    std::vector<uint16_t> depth_a(64 * 48), depth_b(32 * 20);
+    for (size_t i = 0; i < depth_a.size(); ++i) depth_a[i] = static_cast<uint16_t>(i % 7 == 3 ? 0 : 400 + (i * 7919) % 3000);
+    for (size_t i = 0; i < depth_b.size(); ++i) depth_b[i] = static_cast<uint16_t>(i % 32 >= 30 || i % 5 == 1 ? 0 : 800 + (i * 104729) % 2000);
+    const auto table_a = rsimpl::compute_deprojection_table(intrin_a), table_b = rsimpl::compute_deprojection_table(intrin_b);
+    const rs_extrinsics a_to_rig = { { 1, 0, 0, 0, 1, 0, 0, 0, 1 }, { 0, 0, 0 } };
+    const rs_extrinsics b_to_rig = { { 0, 0, -1, 0, 1, 0, 1, 0, 0 }, { 0.25f, -0.05f, 0.1f } };
+    const std::vector<rsimpl::fused_depth_image> images = {
+        { depth_a.data(), 64, 48, 0, &table_a, 0.001f, a_to_rig },
+        { depth_b.data(), 30, 20, 32, &table_b, 0.0005f, b_to_rig } };
+
+    // Every pixel with depth, deprojected and transformed on its own
+    std::vector<float> expected;
+    auto add_points = [&](const rsimpl::fused_depth_image & image, const std::vector<float> & table)
+    {
+        for (int y = 0; y < image.height; ++y) for (int x = 0; x < image.width; ++x)
+        {
+            const float z = image.z_scale * image.z_pixels[y * (image.z_stride ? image.z_stride : image.width) + x];
+            if (!z) continue;
+            const int i = y * image.width + x;
+            const float point[] = { z * table[i * 2], z * table[i * 2 + 1], z };
+            float moved[3];
+            rs_transform_point_to_point(moved, &image.to_common, point);
+            expected.insert(expected.end(), moved, moved + 3);
+        }
+    };
+    add_points(images[0], table_a);
+    add_points(images[1], table_b);
+
+    std::vector<float> points((64 * 48 + 30 * 20) * 3);
+    const int count = rsimpl::fuse_depth_to_points(points.data(), images, 0);
+    REQUIRE(count * 3 == (int)expected.size());
+    for (size_t k = 0; k < expected.size(); ++k) REQUIRE(points[k] == Approx(expected[k]));
+
+    // Merged into cubes of the rig frame, across the cameras
+    const float leaf = 0.05f;
+    std::vector<std::tuple<int, int, int>> order;
+    std::map<std::tuple<int, int, int>, std::array<float, 4>> sums;
+    for (size_t k = 0; k < expected.size(); k += 3)
+    {
+        const float x = expected[k], y = expected[k + 1], z = expected[k + 2];
+        const auto cube = std::make_tuple((int)std::floor(x * (1 / leaf)), (int)std::floor(y * (1 / leaf)), (int)std::floor(z * (1 / leaf)));
+        if (!sums.count(cube)) { order.push_back(cube); sums[cube] = {{ 0, 0, 0, 0 }}; }
+        auto & sum = sums[cube];
+        sum[0] += x;
+        sum[1] += y;
+        sum[2] += z;
+        ++sum[3];
+    }
+    const int merged = rsimpl::fuse_depth_to_points(points.data(), images, leaf);
+    REQUIRE(merged == (int)order.size());
+    for (int k = 0; k < merged; ++k)
+    {
+        const auto & sum = sums[order[k]];
+        for (int c = 0; c < 3; ++c) REQUIRE(points[k * 3 + c] == Approx(sum[c] / sum[3]));
+    }
+}
+
 TEST_CASE( "rs_create_context() validates input", "[offline] [validation]" )
 {
-    REQUIRE(rs_create_context(RS_API_VERSION - 100, require_error("", false)) == nullptr);
-    REQUIRE(rs_create_context(RS_API_VERSION + 100, require_error("", false)) == nullptr);
-    auto ctx = rs_create_context(RS_API_VERSION + 1, require_no_error()); // make sure changes in patch do not fail context creation
-    REQUIRE(ctx != nullptr);
-    rs_delete_context(ctx, require_no_error());
+    REQUIRE(rs_create_context(RS_API_VERSION - 100, require_error("", false)) == nullptr);
+    REQUIRE(rs_create_context(RS_API_VERSION + 100, require_error("", false)) == nullptr);
+    auto ctx = rs_create_context(RS_API_VERSION + 1, require_no_error()); // make sure changes in patch do not fail context creation
+    REQUIRE(ctx != nullptr);
+    rs_delete_context(ctx, require_no_error());
+}
+
+TEST_CASE( "rs_delete_context() validates input", "[offline] [validation]" )
+{
+    rs_delete_context(nullptr, require_error("null pointer passed for argument \"context\""));
+}
+
+TEST_CASE( "rs_get_device_count() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_get_device_count(nullptr, require_error("null pointer passed for argument \"context\"")) == 0);
+}
+
+TEST_CASE( "rs_get_device() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_get_device(nullptr, 0, require_error("null pointer passed for argument \"context\"")) == nullptr);
+
+    REQUIRE(rs_get_device(fake_object_pointer(), -1, require_error("out of range value for argument \"index\"")) == nullptr);
+    // NOTE: Index upper bound determined by rs_get_device_count(), can't validate without a live object
+}
+
+TEST_CASE( "rs_set_devices_changed_callback() validates input", "[offline] [validation]" )
+{
+    auto on_change = [](rs_context *, rs_device *, int, void *) {};
+    rs_set_devices_changed_callback(nullptr, on_change, nullptr, require_error("null pointer passed for argument \"context\""));
+
+    // The callback is released even when it is refused
+    struct counted_callback : rs_devices_changed_callback
+    {
+        int & releases;
+        counted_callback(int & releases) : releases(releases) {}
+        void on_devices_changed(rs_context *, rs_device *, int) override {}
+        void release() override { ++releases; delete this; }
+    };
+    int releases = 0;
+    rs_set_devices_changed_callback_cpp(nullptr, new counted_callback(releases), require_error("null pointer passed for argument \"context\""));
+    REQUIRE(releases == 1);
+}
+
+TEST_CASE( "rs_get_device_name() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_get_device_name(nullptr, require_error("null pointer passed for argument \"device\"")) == nullptr);
+}
+
+TEST_CASE( "rs_get_device_serial() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_get_device_serial(nullptr, require_error("null pointer passed for argument \"device\"")) == nullptr);
+}
+
+TEST_CASE( "rs_get_device_firmware_version() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_get_device_firmware_version(nullptr, require_error("null pointer passed for argument \"device\"")) == nullptr);
+}
+
+TEST_CASE( "rs_get_device_extrinsics() validates input", "[offline] [validation]" )
+{
+    rs_extrinsics extrin;
+    rs_get_device_extrinsics(nullptr,               RS_STREAM_DEPTH,    RS_STREAM_COLOR,    &extrin, require_error("null pointer passed for argument \"device\""));
+                                                                                            
+    rs_get_device_extrinsics(fake_object_pointer(), (rs_stream)-1,      RS_STREAM_COLOR,    &extrin, require_error("bad enum value for argument \"from\""));
+    rs_get_device_extrinsics(fake_object_pointer(), RS_STREAM_COUNT,    RS_STREAM_COLOR,    &extrin, require_error("bad enum value for argument \"from\""));
+
+    rs_get_device_extrinsics(fake_object_pointer(), RS_STREAM_DEPTH,    (rs_stream)-1,      &extrin, require_error("bad enum value for argument \"to\""));
+    rs_get_device_extrinsics(fake_object_pointer(), RS_STREAM_DEPTH,    RS_STREAM_COUNT,    &extrin, require_error("bad enum value for argument \"to\""));
+                                                                        
+    rs_get_device_extrinsics(fake_object_pointer(), RS_STREAM_DEPTH,    RS_STREAM_COLOR,    nullptr, require_error("null pointer passed for argument \"extrin\""));
+}
+
+TEST_CASE( "rs_get_device_depth_scale() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_get_device_depth_scale(nullptr, require_error("null pointer passed for argument \"device\"")) == 0.0f);
+}
+
+TEST_CASE( "rs_device_supports_option() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_device_supports_option(nullptr,               RS_OPTION_COLOR_GAIN, require_error("null pointer passed for argument \"device\"")) == 0);
+
+    REQUIRE(rs_device_supports_option(fake_object_pointer(), (rs_option)-1,        require_error("bad enum value for argument \"option\"")) == 0);
+    REQUIRE(rs_device_supports_option(fake_object_pointer(), RS_OPTION_COUNT,      require_error("bad enum value for argument \"option\"")) == 0);
+}
+
+TEST_CASE( "rs_get_stream_mode_count() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_get_stream_mode_count(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == 0);
+                                                                                
+    REQUIRE(rs_get_stream_mode_count(fake_object_pointer(), (rs_stream)-1,      require_error("bad enum value for argument \"stream\"")) == 0);
+    REQUIRE(rs_get_stream_mode_count(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == 0);
+}
+
+TEST_CASE( "rs_get_stream_mode() validates input", "[offline] [validation]" )
+{
+    int width, height, framerate; rs_format format;
+    rs_get_stream_mode(nullptr,               RS_STREAM_DEPTH,     0, &width, &height, &format, &framerate, require_error("null pointer passed for argument \"device\""));
+                                                                   
+    rs_get_stream_mode(fake_object_pointer(), (rs_stream)-1,       0, &width, &height, &format, &framerate, require_error("bad enum value for argument \"stream\""));
+    rs_get_stream_mode(fake_object_pointer(), RS_STREAM_COUNT,     0, &width, &height, &format, &framerate, require_error("bad enum value for argument \"stream\""));
+
+    rs_get_stream_mode(fake_object_pointer(), RS_STREAM_DEPTH,    -1, &width, &height, &format, &framerate, require_error("out of range value for argument \"index\""));
+    // NOTE: Index upper bound determined by rs_get_stream_mode_count(), can't validate without a live object
+
+    // NOTE: width, height, format, framerate are all permitted to be null, nothing to validate
+}
+
+TEST_CASE( "rs_enable_stream() validates input", "[offline] [validation]" )
+{
+    rs_enable_stream(nullptr, RS_STREAM_DEPTH, 640, 480, RS_FORMAT_Z16, 60, require_error("null pointer passed for argument \"device\""));
+                                                                                              
+    const auto RS_STREAM_MAX_ENUM = (rs_stream)0xFFFF;
+    const auto RS_FORMAT_MAX_ENUM = (rs_format)0xFFFF;
+    rs_enable_stream(fake_object_pointer(), (rs_stream)-1, 640, 480, RS_FORMAT_Z16, 60, require_error("bad enum value for argument \"stream\""));
+    rs_enable_stream(fake_object_pointer(), RS_STREAM_COUNT, 640, 480, RS_FORMAT_Z16, 60, require_error("bad enum value for argument \"stream\""));
+    rs_enable_stream(fake_object_pointer(), RS_STREAM_MAX_ENUM, 640, 480, RS_FORMAT_Z16, 60, require_error("bad enum value for argument \"stream\""));
+    rs_enable_stream(fake_object_pointer(), RS_STREAM_RECTIFIED_COLOR, 0, 0, RS_FORMAT_RGB8, 0, require_error("argument \"stream\" must be a native stream or points"));
+                                                                                              
+    rs_enable_stream(fake_object_pointer(), RS_STREAM_DEPTH, -1, 480, RS_FORMAT_Z16, 60, require_error("out of range value for argument \"width\""));
+                                                                                              
+    rs_enable_stream(fake_object_pointer(), RS_STREAM_DEPTH, 640, -1, RS_FORMAT_Z16, 60, require_error("out of range value for argument \"height\""));
+                                                                                              
+    rs_enable_stream(fake_object_pointer(), RS_STREAM_DEPTH, 640, 480, (rs_format)-1, 60, require_error("bad enum value for argument \"format\""));
+    rs_enable_stream(fake_object_pointer(), RS_STREAM_DEPTH, 640, 480, RS_FORMAT_COUNT, 60, require_error("bad enum value for argument \"format\""));
+    rs_enable_stream(fake_object_pointer(), RS_STREAM_DEPTH, 640, 480, RS_FORMAT_MAX_ENUM, 60, require_error("bad enum value for argument \"format\""));
+                                                                
+    rs_enable_stream(fake_object_pointer(), RS_STREAM_DEPTH, 640, 480, RS_FORMAT_Z16, -1, require_error("out of range value for argument \"framerate\""));
+}
+
+TEST_CASE( "rs_enable_stream_preset() validates input", "[offline] [validation]" )
+{
+    rs_enable_stream_preset(nullptr,               RS_STREAM_DEPTH,    RS_PRESET_BEST_QUALITY, require_error("null pointer passed for argument \"device\""));
+                                                                       
+    rs_enable_stream_preset(fake_object_pointer(), (rs_stream)-1,      RS_PRESET_BEST_QUALITY, require_error("bad enum value for argument \"stream\""));
+    rs_enable_stream_preset(fake_object_pointer(), RS_STREAM_COUNT,    RS_PRESET_BEST_QUALITY, require_error("bad enum value for argument \"stream\""));
+
+    rs_enable_stream_preset(fake_object_pointer(), RS_STREAM_DEPTH,    (rs_preset)-1,          require_error("bad enum value for argument \"preset\""));
+    rs_enable_stream_preset(fake_object_pointer(), RS_STREAM_DEPTH,    RS_PRESET_COUNT,        require_error("bad enum value for argument \"preset\""));
+}
+
+TEST_CASE( "rs_disable_stream() validates input", "[offline] [validation]" )
+{
+    rs_disable_stream(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\""));
+                                                                 
+    rs_disable_stream(fake_object_pointer(), (rs_stream)-1,      require_error("bad enum value for argument \"stream\""));
+    rs_disable_stream(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\""));
+}
+
+TEST_CASE( "rs_is_stream_enabled() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_is_stream_enabled(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == 0);
+                                                                            
+    REQUIRE(rs_is_stream_enabled(fake_object_pointer(), (rs_stream)-1,      require_error("bad enum value for argument \"stream\"")) == 0);
+    REQUIRE(rs_is_stream_enabled(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == 0);
+}
+
+TEST_CASE( "rs_set_stream_queue_policy() validates input", "[offline] [validation]" )
+{
+    rs_set_stream_queue_policy(nullptr,               RS_STREAM_DEPTH,    4,  RS_FRAME_DROP_POLICY_DROP_OLDEST,   require_error("null pointer passed for argument \"device\""));
+
+    rs_set_stream_queue_policy(fake_object_pointer(), (rs_stream)-1,      4,  RS_FRAME_DROP_POLICY_DROP_OLDEST,   require_error("bad enum value for argument \"stream\""));
+    rs_set_stream_queue_policy(fake_object_pointer(), RS_STREAM_COUNT,    4,  RS_FRAME_DROP_POLICY_DROP_OLDEST,   require_error("bad enum value for argument \"stream\""));
+    rs_set_stream_queue_policy(fake_object_pointer(), RS_STREAM_POINTS,   4,  RS_FRAME_DROP_POLICY_DROP_OLDEST,   require_error("argument \"stream\" must be a native stream"));
+
+    rs_set_stream_queue_policy(fake_object_pointer(), RS_STREAM_DEPTH,    0,  RS_FRAME_DROP_POLICY_DROP_OLDEST,   require_error("out of range value for argument \"depth\""));
+    rs_set_stream_queue_policy(fake_object_pointer(), RS_STREAM_DEPTH,    17, RS_FRAME_DROP_POLICY_DROP_OLDEST,   require_error("out of range value for argument \"depth\""));
+
+    rs_set_stream_queue_policy(fake_object_pointer(), RS_STREAM_DEPTH,    4,  (rs_frame_drop_policy)-1,           require_error("bad enum value for argument \"policy\""));
+    rs_set_stream_queue_policy(fake_object_pointer(), RS_STREAM_DEPTH,    4,  RS_FRAME_DROP_POLICY_COUNT,         require_error("bad enum value for argument \"policy\""));
+
+    REQUIRE(rs_get_stream_queue_depth(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_get_stream_queue_depth(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == 0);
+    REQUIRE(rs_get_stream_drop_policy(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == RS_FRAME_DROP_POLICY_COUNT);
+    REQUIRE(rs_get_stream_drop_policy(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == RS_FRAME_DROP_POLICY_COUNT);
+}
+
+TEST_CASE( "rs_set_stream_capture_dmabufs() validates input", "[offline] [validation]" )
+{
+    const int fds[33] = {};
+    rs_set_stream_capture_dmabufs(nullptr,               RS_STREAM_DEPTH,    fds,     4,  require_error("null pointer passed for argument \"device\""));
+
+    rs_set_stream_capture_dmabufs(fake_object_pointer(), (rs_stream)-1,      fds,     4,  require_error("bad enum value for argument \"stream\""));
+    rs_set_stream_capture_dmabufs(fake_object_pointer(), RS_STREAM_POINTS,   fds,     4,  require_error("argument \"stream\" must be a native stream"));
+
+    rs_set_stream_capture_dmabufs(fake_object_pointer(), RS_STREAM_DEPTH,    fds,     1,  require_error("out of range value for argument \"count\""));
+    rs_set_stream_capture_dmabufs(fake_object_pointer(), RS_STREAM_DEPTH,    fds,     33, require_error("out of range value for argument \"count\""));
+    rs_set_stream_capture_dmabufs(fake_object_pointer(), RS_STREAM_DEPTH,    fds,     -1, require_error("out of range value for argument \"count\""));
+    rs_set_stream_capture_dmabufs(fake_object_pointer(), RS_STREAM_DEPTH,    nullptr, 4,  require_error("null pointer passed for argument \"fds\""));
+}
+
+TEST_CASE( "rs_set_stream_capture_buffer_count() validates input", "[offline] [validation]" )
+{
+    rs_set_stream_capture_buffer_count(nullptr,               RS_STREAM_DEPTH,    4,  require_error("null pointer passed for argument \"device\""));
+
+    rs_set_stream_capture_buffer_count(fake_object_pointer(), (rs_stream)-1,      4,  require_error("bad enum value for argument \"stream\""));
+    rs_set_stream_capture_buffer_count(fake_object_pointer(), RS_STREAM_POINTS,   4,  require_error("argument \"stream\" must be a native stream"));
+
+    rs_set_stream_capture_buffer_count(fake_object_pointer(), RS_STREAM_DEPTH,    -1, require_error("out of range value for argument \"count\""));
+    rs_set_stream_capture_buffer_count(fake_object_pointer(), RS_STREAM_DEPTH,    33, require_error("out of range value for argument \"count\""));
+
+    REQUIRE(rs_get_stream_capture_buffer_count(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_get_stream_capture_buffer_count(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == 0);
+}
+
+TEST_CASE( "rs_set_stream_frame_buffers() and rs_get_detached_frame_buffer_index() validate input", "[offline] [validation]" )
+{
+    void * buffers[] = { fake_object_pointer(), nullptr };
+    rs_set_stream_frame_buffers(nullptr,               RS_STREAM_DEPTH,    buffers, 1,  4096, require_error("null pointer passed for argument \"device\""));
+
+    rs_set_stream_frame_buffers(fake_object_pointer(), (rs_stream)-1,      buffers, 1,  4096, require_error("bad enum value for argument \"stream\""));
+    rs_set_stream_frame_buffers(fake_object_pointer(), RS_STREAM_POINTS,   buffers, 1,  4096, require_error("argument \"stream\" must be a native stream"));
+
+    rs_set_stream_frame_buffers(fake_object_pointer(), RS_STREAM_DEPTH,    buffers, -1, 4096, require_error("out of range value for argument \"count\""));
+    rs_set_stream_frame_buffers(fake_object_pointer(), RS_STREAM_DEPTH,    buffers, RS_MAX_FRAME_BUFFERS + 1, 4096, require_error("out of range value for argument \"count\""));
+    rs_set_stream_frame_buffers(fake_object_pointer(), RS_STREAM_DEPTH,    nullptr, 1,  4096, require_error("null pointer passed for argument \"buffers\""));
+    rs_set_stream_frame_buffers(fake_object_pointer(), RS_STREAM_DEPTH,    buffers, 2,  4096, require_error("null pointer passed for argument \"buffers[i]\""));
+    rs_set_stream_frame_buffers(fake_object_pointer(), RS_STREAM_DEPTH,    buffers, 1,  0,    require_error("out of range value for argument \"buffer_size\""));
+
+    REQUIRE(rs_get_detached_frame_buffer_index(nullptr, require_error("null pointer passed for argument \"frame_ref\"")) == -1);
+}
+
+TEST_CASE( "rs_get_detached_frame_strided_data() validates input", "[offline] [validation]" )
+{
+    int pixel_stride = 0, row_stride = 0;
+    REQUIRE(rs_get_detached_frame_strided_data(nullptr,               &pixel_stride, &row_stride, require_error("null pointer passed for argument \"frame_ref\"")) == nullptr);
+    REQUIRE(rs_get_detached_frame_strided_data(fake_object_pointer(), nullptr,       &row_stride, require_error("null pointer passed for argument \"pixel_stride\"")) == nullptr);
+    REQUIRE(rs_get_detached_frame_strided_data(fake_object_pointer(), &pixel_stride, nullptr,     require_error("null pointer passed for argument \"row_stride\"")) == nullptr);
+}
+
+TEST_CASE( "rs_get_detached_frame_pyramid_level() validates input", "[offline] [validation]" )
+{
+    int width = 0, height = 0;
+    REQUIRE(rs_get_detached_frame_pyramid_level(nullptr,               1,                                  &width,  &height, require_error("null pointer passed for argument \"frame_ref\"")) == nullptr);
+    REQUIRE(rs_get_detached_frame_pyramid_level(fake_object_pointer(), -1,                                 &width,  &height, require_error("out of range value for argument \"level\"")) == nullptr);
+    REQUIRE(rs_get_detached_frame_pyramid_level(fake_object_pointer(), RS_MAX_DEPTH_PYRAMID_LEVELS + 1,    &width,  &height, require_error("out of range value for argument \"level\"")) == nullptr);
+    REQUIRE(rs_get_detached_frame_pyramid_level(fake_object_pointer(), 1,                                  nullptr, &height, require_error("null pointer passed for argument \"width\"")) == nullptr);
+    REQUIRE(rs_get_detached_frame_pyramid_level(fake_object_pointer(), 1,                                  &width,  nullptr, require_error("null pointer passed for argument \"height\"")) == nullptr);
+}
+
+TEST_CASE( "rs_get_detached_frame_depth_runs() validates input", "[offline] [validation]" )
+{
+    const unsigned short * runs = nullptr;
+    REQUIRE(rs_get_detached_frame_depth_runs(nullptr,               &runs,   require_error("null pointer passed for argument \"frame_ref\"")) == nullptr);
+    REQUIRE(rs_get_detached_frame_depth_runs(fake_object_pointer(), nullptr, require_error("null pointer passed for argument \"runs\"")) == nullptr);
+}
+
+TEST_CASE( "rs_get_depth_pyramid_intrinsics() validates input", "[offline] [validation]" )
+{
+    rs_intrinsics intrin;
+    rs_get_depth_pyramid_intrinsics(nullptr,               1,                               &intrin, require_error("null pointer passed for argument \"device\""));
+    rs_get_depth_pyramid_intrinsics(fake_object_pointer(), -1,                              &intrin, require_error("out of range value for argument \"level\""));
+    rs_get_depth_pyramid_intrinsics(fake_object_pointer(), RS_MAX_DEPTH_PYRAMID_LEVELS + 1, &intrin, require_error("out of range value for argument \"level\""));
+    rs_get_depth_pyramid_intrinsics(fake_object_pointer(), 1,                               nullptr, require_error("null pointer passed for argument \"intrin\""));
+}
+
+TEST_CASE( "rs_set_stream_crop() validates input", "[offline] [validation]" )
+{
+    rs_set_stream_crop(nullptr,               RS_STREAM_DEPTH, 0, 0, 16, 16, require_error("null pointer passed for argument \"device\""));
+    rs_set_stream_crop(fake_object_pointer(), (rs_stream)-1,   0, 0, 16, 16, require_error("bad enum value for argument \"stream\""));
+    rs_set_stream_crop(fake_object_pointer(), RS_STREAM_POINTS, 0, 0, 16, 16, require_error("argument \"stream\" must be a native stream"));
+    REQUIRE(rs_is_stream_cropped_in_driver(nullptr,               RS_STREAM_DEPTH, require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_is_stream_cropped_in_driver(fake_object_pointer(), (rs_stream)-1,   require_error("bad enum value for argument \"stream\"")) == 0);
+}
+
+TEST_CASE( "rs_set_stream_callback_queue() validates input", "[offline] [validation]" )
+{
+    rs_set_stream_callback_queue(nullptr,               RS_STREAM_DEPTH,    4,  require_error("null pointer passed for argument \"device\""));
+
+    rs_set_stream_callback_queue(fake_object_pointer(), (rs_stream)-1,      4,  require_error("bad enum value for argument \"stream\""));
+    rs_set_stream_callback_queue(fake_object_pointer(), RS_STREAM_POINTS,   4,  require_error("argument \"stream\" must be a native stream"));
+
+    rs_set_stream_callback_queue(fake_object_pointer(), RS_STREAM_DEPTH,    -1, require_error("out of range value for argument \"depth\""));
+    rs_set_stream_callback_queue(fake_object_pointer(), RS_STREAM_DEPTH,    RS_MAX_STREAM_QUEUE_DEPTH + 1, require_error("out of range value for argument \"depth\""));
+
+    REQUIRE(rs_get_stream_callback_queue_depth(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_get_stream_callback_queue_depth(fake_object_pointer(), RS_STREAM_POINTS,   require_error("argument \"stream\" must be a native stream")) == 0);
+    REQUIRE(rs_get_stream_callback_drops(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_get_stream_callback_drops(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == 0);
+}
+
+TEST_CASE( "rs_add_frame_subscriber() validates input", "[offline] [validation]" )
+{
+    auto on_frame = [](rs_device *, rs_frame_ref *, void *) {};
+    REQUIRE(rs_add_frame_subscriber(nullptr,               RS_STREAM_DEPTH,    on_frame, nullptr, 2,  RS_FRAME_DROP_POLICY_DROP_OLDEST,          require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_add_frame_subscriber(fake_object_pointer(), RS_STREAM_POINTS,   on_frame, nullptr, 2,  RS_FRAME_DROP_POLICY_DROP_OLDEST,          require_error("argument \"stream\" must be a native stream")) == 0);
+    REQUIRE(rs_add_frame_subscriber(fake_object_pointer(), RS_STREAM_DEPTH,    nullptr,  nullptr, 2,  RS_FRAME_DROP_POLICY_DROP_OLDEST,          require_error("null pointer passed for argument \"on_frame\"")) == 0);
+    REQUIRE(rs_add_frame_subscriber(fake_object_pointer(), RS_STREAM_DEPTH,    on_frame, nullptr, -1, RS_FRAME_DROP_POLICY_DROP_OLDEST,          require_error("out of range value for argument \"depth\"")) == 0);
+    REQUIRE(rs_add_frame_subscriber(fake_object_pointer(), RS_STREAM_DEPTH,    on_frame, nullptr, RS_MAX_STREAM_QUEUE_DEPTH + 1, RS_FRAME_DROP_POLICY_DROP_OLDEST, require_error("out of range value for argument \"depth\"")) == 0);
+    REQUIRE(rs_add_frame_subscriber(fake_object_pointer(), RS_STREAM_DEPTH,    on_frame, nullptr, 2,  RS_FRAME_DROP_POLICY_COUNT,                require_error("bad enum value for argument \"policy\"")) == 0);
+    REQUIRE(rs_add_frame_subscriber_cpp(nullptr,           RS_STREAM_DEPTH,    nullptr,           2,  RS_FRAME_DROP_POLICY_DROP_OLDEST,          require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_add_frame_subscriber_cpp(fake_object_pointer(), RS_STREAM_DEPTH, nullptr,          2,  RS_FRAME_DROP_POLICY_DROP_OLDEST,          require_error("null pointer passed for argument \"callback\"")) == 0);
+
+    rs_remove_frame_subscriber(nullptr,               RS_STREAM_DEPTH,    1,  require_error("null pointer passed for argument \"device\""));
+    rs_remove_frame_subscriber(fake_object_pointer(), (rs_stream)-1,      1,  require_error("bad enum value for argument \"stream\""));
+    REQUIRE(rs_get_frame_subscriber_drops(nullptr,               RS_STREAM_DEPTH,    1,  require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_get_frame_subscriber_drops(fake_object_pointer(), RS_STREAM_POINTS,   1,  require_error("argument \"stream\" must be a native stream")) == 0);
+}
+
+TEST_CASE( "rs_set_stream_idle_timeout() validates input", "[offline] [validation]" )
+{
+    rs_set_stream_idle_timeout(nullptr,               RS_STREAM_COLOR,    1000,   require_error("null pointer passed for argument \"device\""));
+    rs_set_stream_idle_timeout(fake_object_pointer(), RS_STREAM_POINTS,   1000,   require_error("argument \"stream\" must be a native stream"));
+    rs_set_stream_idle_timeout(fake_object_pointer(), RS_STREAM_COLOR,    -1,     require_error("out of range value for argument \"milliseconds\""));
+    rs_set_stream_idle_timeout(fake_object_pointer(), RS_STREAM_COLOR,    RS_MAX_STREAM_IDLE_TIMEOUT + 1, require_error("out of range value for argument \"milliseconds\""));
+
+    REQUIRE(rs_get_stream_idle_timeout(nullptr,               RS_STREAM_COLOR,    require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_get_stream_idle_timeout(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == 0);
+    REQUIRE(rs_is_stream_idle(nullptr,               RS_STREAM_COLOR,    require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_is_stream_idle(fake_object_pointer(), RS_STREAM_POINTS,   require_error("argument \"stream\" must be a native stream")) == 0);
+}
+
+TEST_CASE( "rs_set_stream_sync_tolerance() validates input", "[offline] [validation]" )
+{
+    rs_set_stream_sync_tolerance(nullptr,               RS_STREAM_COLOR,    5,      require_error("null pointer passed for argument \"device\""));
+    rs_set_stream_sync_tolerance(fake_object_pointer(), RS_STREAM_POINTS,   5,      require_error("argument \"stream\" must be a native stream"));
+    rs_set_stream_sync_tolerance(fake_object_pointer(), RS_STREAM_COLOR,    -0.5,   require_error("out of range value for argument \"milliseconds\""));
+    rs_set_stream_sync_tolerance(fake_object_pointer(), RS_STREAM_COLOR,    RS_MAX_STREAM_SYNC_TOLERANCE + 1, require_error("out of range value for argument \"milliseconds\""));
+
+    REQUIRE(rs_get_stream_sync_tolerance(nullptr,               RS_STREAM_COLOR,    require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_get_stream_sync_tolerance(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == 0);
+}
+
+TEST_CASE( "rs_set_stream_slice_callback() validates input", "[offline] [validation]" )
+{
+    auto on_slice = [](rs_device *, const void *, int, int, int, void *) {};
+    rs_set_stream_slice_callback(nullptr,               RS_STREAM_DEPTH,    16, on_slice, nullptr, require_error("null pointer passed for argument \"device\""));
+    rs_set_stream_slice_callback(fake_object_pointer(), RS_STREAM_POINTS,   16, on_slice, nullptr, require_error("argument \"stream\" must be a native stream"));
+    rs_set_stream_slice_callback(fake_object_pointer(), RS_STREAM_DEPTH,    0,  on_slice, nullptr, require_error("out of range value for argument \"rows_per_slice\""));
+    rs_set_stream_slice_callback(fake_object_pointer(), RS_STREAM_DEPTH,    RS_MAX_SLICE_ROWS + 1, on_slice, nullptr, require_error("out of range value for argument \"rows_per_slice\""));
+    rs_set_stream_slice_callback_cpp(nullptr,           RS_STREAM_DEPTH,    16, nullptr, require_error("null pointer passed for argument \"device\""));
+}
+
+TEST_CASE( "rs_set_stream_encoder() validates input", "[offline] [validation]" )
+{
+    auto on_packet = [](rs_device *, rs_stream, rs_encoded_packet, void *) {};
+    rs_set_stream_encoder(nullptr,               RS_STREAM_COLOR,    4000000, on_packet, nullptr, require_error("null pointer passed for argument \"device\""));
+    rs_set_stream_encoder(fake_object_pointer(), RS_STREAM_POINTS,   4000000, on_packet, nullptr, require_error("argument \"stream\" must be a native stream"));
+    rs_set_stream_encoder(fake_object_pointer(), RS_STREAM_COLOR,    0,       on_packet, nullptr, require_error("out of range value for argument \"bitrate\""));
+    rs_set_stream_encoder(fake_object_pointer(), RS_STREAM_COLOR,    RS_MAX_ENCODER_BITRATE + 1, on_packet, nullptr, require_error("out of range value for argument \"bitrate\""));
+    rs_set_stream_encoder_cpp(nullptr,           RS_STREAM_COLOR,    4000000, nullptr, require_error("null pointer passed for argument \"device\""));
+}
+
+TEST_CASE( "rs_set_load_shedding() validates input", "[offline] [validation]" )
+{
+    const rs_load_shedding_action actions[] = { RS_LOAD_SHEDDING_ACTION_SKIP_CULLED_UNPACKING, RS_LOAD_SHEDDING_ACTION_DECIMATE_FRAMERATE };
+    const rs_load_shedding_action invalid[] = { RS_LOAD_SHEDDING_ACTION_SKIP_CULLED_UNPACKING, RS_LOAD_SHEDDING_ACTION_COUNT };
+    rs_set_load_shedding(nullptr,               actions,    2,  require_error("null pointer passed for argument \"device\""));
+    rs_set_load_shedding(fake_object_pointer(), nullptr,    2,  require_error("null pointer passed for argument \"actions\""));
+    rs_set_load_shedding(fake_object_pointer(), actions,    -1, require_error("out of range value for argument \"count\""));
+    rs_set_load_shedding(fake_object_pointer(), actions,    RS_LOAD_SHEDDING_ACTION_COUNT + 1, require_error("out of range value for argument \"count\""));
+    rs_set_load_shedding(fake_object_pointer(), invalid,    2,  require_error("bad enum value for argument \"actions[i]\""));
+
+    REQUIRE(rs_get_load_shedding_level(nullptr, require_error("null pointer passed for argument \"device\"")) == 0);
+}
+
+TEST_CASE( "rs_get_memory_usage() validates input", "[offline] [validation]" )
+{
+    unsigned long long current = 0, peak = 0;
+    rs_get_memory_usage(nullptr,               &current,   &peak,      require_error("null pointer passed for argument \"device\""));
+    rs_get_memory_usage(fake_object_pointer(), nullptr,    &peak,      require_error("null pointer passed for argument \"current\""));
+    rs_get_memory_usage(fake_object_pointer(), &current,   nullptr,    require_error("null pointer passed for argument \"peak\""));
+    rs_set_memory_budget(nullptr, 1 << 20, require_error("null pointer passed for argument \"device\""));
+    REQUIRE(rs_get_memory_budget(nullptr, require_error("null pointer passed for argument \"device\"")) == 0);
+}
+
+TEST_CASE( "load_shedder takes its actions in order and drops them once calm", "[offline] [validation]" )
+{
+    rsimpl::load_shedder shedder;
+    shedder.update(true);
+    REQUIRE(shedder.get_level() == 0); // Nothing to take without an order
+
+    shedder.set_order({ RS_LOAD_SHEDDING_ACTION_DECIMATE_FRAMERATE, RS_LOAD_SHEDDING_ACTION_SKIP_DERIVED_STREAMS });
+    shedder.update(true);
+    REQUIRE(shedder.get_level() == 1);
+    REQUIRE(shedder.is_taking(RS_LOAD_SHEDDING_ACTION_DECIMATE_FRAMERATE));
+    REQUIRE(!shedder.is_taking(RS_LOAD_SHEDDING_ACTION_SKIP_DERIVED_STREAMS));
+    shedder.update(true);
+    shedder.update(true);
+    REQUIRE(shedder.get_level() == 2);
+    REQUIRE(shedder.is_taking(RS_LOAD_SHEDDING_ACTION_SKIP_DERIVED_STREAMS));
+    REQUIRE(!shedder.is_taking(RS_LOAD_SHEDDING_ACTION_SKIP_CULLED_UNPACKING));
+
+    // An overload among calm checks starts the count over, the last action taken is dropped first
+    for (int i = 1; i < rsimpl::load_shedder::calm_checks_to_relax; ++i) shedder.update(false);
+    shedder.update(true);
+    for (int i = 1; i < rsimpl::load_shedder::calm_checks_to_relax; ++i) shedder.update(false);
+    REQUIRE(shedder.get_level() == 2);
+    shedder.update(false);
+    REQUIRE(shedder.get_level() == 1);
+    REQUIRE(shedder.is_taking(RS_LOAD_SHEDDING_ACTION_DECIMATE_FRAMERATE));
+    REQUIRE(!shedder.is_taking(RS_LOAD_SHEDDING_ACTION_SKIP_DERIVED_STREAMS));
+    for (int i = 0; i < rsimpl::load_shedder::calm_checks_to_relax; ++i) shedder.update(false);
+    REQUIRE(shedder.get_level() == 0);
+    REQUIRE(!shedder.is_taking(RS_LOAD_SHEDDING_ACTION_DECIMATE_FRAMERATE));
+}
+
+TEST_CASE( "rs_get_stream_latency_histogram() and rs_reset_latency_histograms() validate input", "[offline] [validation]" )
+{
+    unsigned long long counts[RS_LATENCY_HISTOGRAM_BIN_COUNT];
+    rs_get_stream_latency_histogram(nullptr,               RS_STREAM_DEPTH,    RS_FRAME_METADATA_TIME_OF_COMMIT,   counts,  require_error("null pointer passed for argument \"device\""));
+
+    rs_get_stream_latency_histogram(fake_object_pointer(), (rs_stream)-1,      RS_FRAME_METADATA_TIME_OF_COMMIT,   counts,  require_error("bad enum value for argument \"stream\""));
+    rs_get_stream_latency_histogram(fake_object_pointer(), RS_STREAM_POINTS,   RS_FRAME_METADATA_TIME_OF_COMMIT,   counts,  require_error("argument \"stream\" must be a native stream"));
+
+    rs_get_stream_latency_histogram(fake_object_pointer(), RS_STREAM_DEPTH,    RS_FRAME_METADATA_TIME_OF_DEQUEUE,  counts,  require_error("out of range value for argument \"stage\""));
+    rs_get_stream_latency_histogram(fake_object_pointer(), RS_STREAM_DEPTH,    RS_FRAME_METADATA_ACTUAL_EXPOSURE,  counts,  require_error("out of range value for argument \"stage\""));
+
+    rs_get_stream_latency_histogram(fake_object_pointer(), RS_STREAM_DEPTH,    RS_FRAME_METADATA_TIME_OF_COMMIT,   nullptr, require_error("null pointer passed for argument \"counts\""));
+
+    rs_get_stream_exposure_latency_histogram(nullptr,               RS_STREAM_DEPTH,    counts,  require_error("null pointer passed for argument \"device\""));
+    rs_get_stream_exposure_latency_histogram(fake_object_pointer(), RS_STREAM_POINTS,   counts,  require_error("argument \"stream\" must be a native stream"));
+    rs_get_stream_exposure_latency_histogram(fake_object_pointer(), RS_STREAM_DEPTH,    nullptr, require_error("null pointer passed for argument \"counts\""));
+
+    rs_reset_latency_histograms(nullptr, require_error("null pointer passed for argument \"device\""));
+}
+
+TEST_CASE( "rs_get_stream_metric() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_get_stream_metric(nullptr,               RS_STREAM_DEPTH,    RS_STREAM_METRIC_FRAMES_RECEIVED,   require_error("null pointer passed for argument \"device\"")) == 0);
+
+    REQUIRE(rs_get_stream_metric(fake_object_pointer(), (rs_stream)-1,      RS_STREAM_METRIC_FRAMES_RECEIVED,   require_error("bad enum value for argument \"stream\"")) == 0);
+    REQUIRE(rs_get_stream_metric(fake_object_pointer(), RS_STREAM_POINTS,   RS_STREAM_METRIC_FRAMES_RECEIVED,   require_error("argument \"stream\" must be a native stream")) == 0);
+
+    REQUIRE(rs_get_stream_metric(fake_object_pointer(), RS_STREAM_DEPTH,    (rs_stream_metric)-1,               require_error("bad enum value for argument \"metric\"")) == 0);
+    REQUIRE(rs_get_stream_metric(fake_object_pointer(), RS_STREAM_DEPTH,    RS_STREAM_METRIC_COUNT,             require_error("bad enum value for argument \"metric\"")) == 0);
+}
+
+TEST_CASE( "rs_get_transfer_statistic() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_get_transfer_statistic(nullptr,               RS_STREAM_DEPTH,    RS_TRANSFER_STATISTIC_BYTES,   require_error("null pointer passed for argument \"device\"")) == 0);
+
+    REQUIRE(rs_get_transfer_statistic(fake_object_pointer(), (rs_stream)-1,      RS_TRANSFER_STATISTIC_BYTES,   require_error("bad enum value for argument \"stream\"")) == 0);
+    REQUIRE(rs_get_transfer_statistic(fake_object_pointer(), RS_STREAM_POINTS,   RS_TRANSFER_STATISTIC_BYTES,   require_error("argument \"stream\" must be a native stream")) == 0);
+
+    REQUIRE(rs_get_transfer_statistic(fake_object_pointer(), RS_STREAM_DEPTH,    (rs_transfer_statistic)-1,     require_error("bad enum value for argument \"statistic\"")) == 0);
+    REQUIRE(rs_get_transfer_statistic(fake_object_pointer(), RS_STREAM_DEPTH,    RS_TRANSFER_STATISTIC_COUNT,   require_error("bad enum value for argument \"statistic\"")) == 0);
+}
+
+TEST_CASE( "transfer monitors count short frames and errors until reset", "[offline] [validation]" )
+{
+    rsimpl::uvc::transfer_monitor monitor;
+    monitor.on_frame(200, 200);
+    monitor.on_frame(150, 200);
+    monitor.on_frame(300, 0);
+    monitor.on_error();
+    auto statistics = monitor.get();
+    REQUIRE(statistics.bytes == 650);
+    REQUIRE(statistics.frames == 3);
+    REQUIRE(statistics.short_frames == 1);
+    REQUIRE(statistics.errors == 1);
+    REQUIRE(statistics.bytes_per_second == 0); // Not a second of frames yet
+
+    monitor.set_errors(7);
+    REQUIRE(monitor.get().errors == 7);
+    monitor.reset();
+    statistics = monitor.get();
+    REQUIRE(statistics.bytes + statistics.frames + statistics.short_frames + statistics.errors == 0);
+}
+
+TEST_CASE( "rs_export_fw_log() validates input", "[offline] [validation]" )
+{
+    rs_export_fw_log(nullptr,               "fw.log", require_error("null pointer passed for argument \"device\""));
+    rs_export_fw_log(fake_object_pointer(), nullptr,  require_error("null pointer passed for argument \"file_path\""));
+}
+
+TEST_CASE( "firmware log rings keep the latest whole records, each preceded by its size", "[offline] [validation]" )
+{
+    rsimpl::fw_log_ring ring(32);
+    std::vector<uint8_t> data(10);
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        std::fill(begin(data), end(data), i);
+        ring.push(data.data(), data.size());
+    }
+    ring.push(data.data(), 29); // Larger than the ring, dropped
+
+    // Two records of 14 bytes fit, the older ones made room for them whole
+    auto records = ring.get_records();
+    REQUIRE(records.size() == 28);
+    for (int r = 0; r < 2; ++r)
+    {
+        REQUIRE(records[r * 14] == 10);
+        REQUIRE(records[r * 14 + 1] + records[r * 14 + 2] + records[r * 14 + 3] == 0);
+        for (int i = 0; i < 10; ++i) REQUIRE(records[r * 14 + 4 + i] == 2 + r);
+    }
+
+    const std::string path = "fw-log-ring-test.bin";
+    ring.export_records(path.c_str());
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> exported((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(path.c_str());
+    REQUIRE(exported == records);
+
+    ring.clear();
+    REQUIRE(ring.get_records().empty());
+}
+
+TEST_CASE( "rs_get_stream_intrinsics() validates input", "[offline] [validation]" )
+{
+    rs_intrinsics intrin;
+    rs_get_stream_intrinsics(nullptr,               RS_STREAM_DEPTH,    &intrin, require_error("null pointer passed for argument \"device\""));
+                                                                        
+    rs_get_stream_intrinsics(fake_object_pointer(), (rs_stream)-1,      &intrin, require_error("bad enum value for argument \"stream\""));
+    rs_get_stream_intrinsics(fake_object_pointer(), RS_STREAM_COUNT,    &intrin, require_error("bad enum value for argument \"stream\""));
+
+    rs_get_stream_intrinsics(fake_object_pointer(), RS_STREAM_DEPTH,    nullptr, require_error("null pointer passed for argument \"intrin\""));
+}
+
+TEST_CASE( "rs_get_stream_format() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_get_stream_format(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == RS_FORMAT_ANY);
+                                                                            
+    REQUIRE(rs_get_stream_format(fake_object_pointer(), (rs_stream)-1,      require_error("bad enum value for argument \"stream\"")) == RS_FORMAT_ANY);
+    REQUIRE(rs_get_stream_format(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == RS_FORMAT_ANY);
+}
+
+TEST_CASE( "rs_get_stream_framerate() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_get_stream_framerate(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == 0);
+                                                                               
+    REQUIRE(rs_get_stream_framerate(fake_object_pointer(), (rs_stream)-1,      require_error("bad enum value for argument \"stream\"")) == 0);
+    REQUIRE(rs_get_stream_framerate(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == 0);
+}
+
+TEST_CASE( "rs_set_frame_allocator() validates input", "[offline] [validation]" )
+{
+    auto allocate = [](int, void *) -> void * { return nullptr; };
+    auto deallocate = [](void *, int, void *) {};
+    rs_set_frame_allocator(nullptr,               allocate, deallocate, nullptr, require_error("null pointer passed for argument \"device\""));
+    rs_set_frame_allocator(fake_object_pointer(), nullptr,  deallocate, nullptr, require_error("null pointer passed for argument \"allocate\""));
+    rs_set_frame_allocator(fake_object_pointer(), allocate, nullptr,    nullptr, require_error("null pointer passed for argument \"deallocate\""));
+    rs_set_frame_allocator_cpp(nullptr,               fake_object_pointer(), require_error("null pointer passed for argument \"device\""));
+    rs_set_frame_allocator_cpp(fake_object_pointer(), nullptr,               require_error("null pointer passed for argument \"allocator\""));
+}
+
+TEST_CASE( "rs_set_frameset_callback() validates input", "[offline] [validation]" )
+{
+    auto on_frameset = [](rs_device *, rs_frameset *, void *) {};
+    rs_set_frameset_callback(nullptr,                   on_frameset, nullptr, require_error("null pointer passed for argument \"device\""));
+    rs_set_frameset_callback_cpp(nullptr,               fake_object_pointer(), require_error("null pointer passed for argument \"device\""));
+    rs_set_frameset_callback_cpp(fake_object_pointer(), nullptr,               require_error("null pointer passed for argument \"callback\""));
+}
+
+TEST_CASE( "rs_enable_motion_tracking_batched() validates input", "[offline] [validation]" )
+{
+    auto on_events = [](rs_device *, const rs_motion_data *, int, const rs_timestamp_data *, int, void *) {};
+    rs_enable_motion_tracking_batched(nullptr,                   on_events, nullptr, require_error("null pointer passed for argument \"device\""));
+    rs_enable_motion_tracking_batched(fake_object_pointer(),     nullptr,   nullptr, require_error("null pointer passed for argument \"on_events\""));
+    rs_enable_motion_tracking_batched_cpp(nullptr,               fake_object_pointer(), require_error("null pointer passed for argument \"device\""));
+    rs_enable_motion_tracking_batched_cpp(fake_object_pointer(), nullptr,               require_error("null pointer passed for argument \"callback\""));
+}
+
+TEST_CASE( "rs_detach_frame() and rs_release_frames() validate input", "[offline] [validation]" )
+{
+    REQUIRE(rs_detach_frame(nullptr,               (rs_frameset *)fake_object_pointer(), RS_STREAM_DEPTH,  require_error("null pointer passed for argument \"device\"")) == nullptr);
+    REQUIRE(rs_detach_frame(fake_object_pointer(), nullptr,                              RS_STREAM_DEPTH,  require_error("null pointer passed for argument \"frames\"")) == nullptr);
+    REQUIRE(rs_detach_frame(fake_object_pointer(), (rs_frameset *)fake_object_pointer(), RS_STREAM_COUNT,  require_error("bad enum value for argument \"stream\"")) == nullptr);
+    REQUIRE(rs_detach_frame(fake_object_pointer(), (rs_frameset *)fake_object_pointer(), RS_STREAM_POINTS, require_error("argument \"stream\" must be a native stream")) == nullptr);
+
+    rs_release_frames(nullptr,               (rs_frameset *)fake_object_pointer(), require_error("null pointer passed for argument \"device\""));
+    rs_release_frames(fake_object_pointer(), nullptr,                              require_error("null pointer passed for argument \"frames\""));
+}
+
+TEST_CASE( "rs_process_frames() and rs_process_frameset() validate input", "[offline] [validation]" )
+{
+    rs_frame_ref * frames[] = { (rs_frame_ref *)fake_object_pointer(), nullptr };
+    REQUIRE(rs_process_frames(nullptr,               RS_STREAM_POINTS, frames,  1, require_error("null pointer passed for argument \"device\"")) == nullptr);
+    REQUIRE(rs_process_frames(fake_object_pointer(), RS_STREAM_COUNT,  frames,  1, require_error("bad enum value for argument \"stream\"")) == nullptr);
+    REQUIRE(rs_process_frames(fake_object_pointer(), RS_STREAM_DEPTH,  frames,  1, require_error("out of range value for argument \"stream\"")) == nullptr);
+    REQUIRE(rs_process_frames(fake_object_pointer(), RS_STREAM_POINTS, nullptr, 1, require_error("null pointer passed for argument \"frames\"")) == nullptr);
+    REQUIRE(rs_process_frames(fake_object_pointer(), RS_STREAM_POINTS, frames,  0, require_error("out of range value for argument \"count\"")) == nullptr);
+    REQUIRE(rs_process_frames(fake_object_pointer(), RS_STREAM_POINTS, frames,  RS_STREAM_NATIVE_COUNT + 1, require_error("out of range value for argument \"count\"")) == nullptr);
+    REQUIRE(rs_process_frames(fake_object_pointer(), RS_STREAM_POINTS, frames,  2, require_error("null pointer passed for argument \"frames[i]\"")) == nullptr);
+
+    REQUIRE(rs_process_frameset(nullptr,               (rs_frameset *)fake_object_pointer(), RS_STREAM_POINTS, require_error("null pointer passed for argument \"device\"")) == nullptr);
+    REQUIRE(rs_process_frameset(fake_object_pointer(), nullptr,                              RS_STREAM_POINTS, require_error("null pointer passed for argument \"frames\"")) == nullptr);
+    REQUIRE(rs_process_frameset(fake_object_pointer(), (rs_frameset *)fake_object_pointer(), RS_STREAM_COLOR,  require_error("out of range value for argument \"stream\"")) == nullptr);
+}
+
+TEST_CASE( "rs_get_frameset_frame_info() validates input", "[offline] [validation]" )
+{
+    rs_frame_info infos[RS_STREAM_NATIVE_COUNT];
+    REQUIRE(rs_get_frameset_frame_info(nullptr,               (rs_frameset *)fake_object_pointer(), infos,   RS_STREAM_NATIVE_COUNT, require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_get_frameset_frame_info(fake_object_pointer(), nullptr,                              infos,   RS_STREAM_NATIVE_COUNT, require_error("null pointer passed for argument \"frames\"")) == 0);
+    REQUIRE(rs_get_frameset_frame_info(fake_object_pointer(), (rs_frameset *)fake_object_pointer(), infos,   -1,                     require_error("out of range value for argument \"max_count\"")) == 0);
+    REQUIRE(rs_get_frameset_frame_info(fake_object_pointer(), (rs_frameset *)fake_object_pointer(), nullptr, 1,                      require_error("null pointer passed for argument \"infos\"")) == 0);
+}
+
+TEST_CASE( "rs_set_stream_roi() validates input", "[offline] [validation]" )
+{
+    rs_set_stream_roi(nullptr,               RS_STREAM_POINTS, 0, 0, 64, 64, require_error("null pointer passed for argument \"device\""));
+    rs_set_stream_roi(fake_object_pointer(), RS_STREAM_COUNT,  0, 0, 64, 64, require_error("bad enum value for argument \"stream\""));
+    rs_set_stream_roi(fake_object_pointer(), RS_STREAM_DEPTH,  0, 0, 64, 64, require_error("out of range value for argument \"stream\""));
+    rs_set_stream_roi(fake_object_pointer(), RS_STREAM_POINTS, -1, 0, 64, 64, require_error("out of range value for argument \"x\""));
+    rs_set_stream_roi(fake_object_pointer(), RS_STREAM_POINTS, 0, -1, 64, 64, require_error("out of range value for argument \"y\""));
+    rs_set_stream_roi(fake_object_pointer(), RS_STREAM_POINTS, 0, 0, -1, 64,  require_error("out of range value for argument \"width\""));
+    rs_set_stream_roi(fake_object_pointer(), RS_STREAM_POINTS, 0, 0, 64, -1,  require_error("out of range value for argument \"height\""));
+}
+
+TEST_CASE( "rs_wait_for_frames_timeout() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_wait_for_frames_timeout(nullptr, 100, require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_get_frames_ready_handle(nullptr,      require_error("null pointer passed for argument \"device\"")) == nullptr);
+}
+
+TEST_CASE( "rs_get_latest_frame() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_get_latest_frame(nullptr,               RS_STREAM_DEPTH,  require_error("null pointer passed for argument \"device\"")) == nullptr);
+    REQUIRE(rs_get_latest_frame(fake_object_pointer(), RS_STREAM_COUNT,  require_error("bad enum value for argument \"stream\"")) == nullptr);
+    REQUIRE(rs_get_latest_frame(fake_object_pointer(), RS_STREAM_POINTS, require_error("argument \"stream\" must be a native stream")) == nullptr);
+}
+
+TEST_CASE( "frames_ready_signal follows set and reset", "[offline] [validation]" )
+{
+    rsimpl::frames_ready_signal signal;
+    signal.set(); // No OS object yet, nothing to signal
+    signal.reset();
+
+    auto handle = signal.get_handle();
+    REQUIRE(signal.get_handle() == handle);
+#ifndef _WIN32
+    auto fd = static_cast<int>(reinterpret_cast<intptr_t>(handle));
+    REQUIRE(fd >= 0);
+    auto readable = [fd]()
+    {
+        pollfd p = { fd, POLLIN, 0 };
+        return poll(&p, 1, 0) == 1;
+    };
+    REQUIRE(!readable());
+    signal.set();
+    signal.set();
+    REQUIRE(readable());
+    signal.reset();
+    REQUIRE(!readable());
+#endif
+}
+
+TEST_CASE( "prepared framesets are handed out with their derived frames", "[offline] [validation]" )
+{
+    const rs_intrinsics intrin = { 8, 2, 4.0f, 1.0f, 10.0f, 10.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rsimpl::subdevice_mode mode = { 0, { 8, 2 }, rsimpl::pf_z16, 30, intrin, {}, { 0 } };
+    std::atomic<uint32_t> max_size(RS_USER_QUEUE_SIZE), event_queue_size(RS_MAX_EVENT_QUEUE_SIZE), events_timeout(RS_MAX_EVENT_TIME_OUT);
+    rsimpl::stream_queue_policy policies[RS_STREAM_NATIVE_COUNT];
+    for (auto & p : policies) p = { 2, RS_FRAME_DROP_POLICY_DROP_OLDEST };
+    rsimpl::syncronizing_archive archive({ rsimpl::subdevice_mode_selection(mode, 0, 0) }, RS_STREAM_DEPTH, &max_size, &event_queue_size, &events_timeout, policies);
+
+    std::vector<rsimpl::frame_archive::shared_frameset *> formed;
+    archive.set_frameset_preparation([&formed](rsimpl::frame_archive::shared_frameset * frames) { formed.push_back(frames); });
+    REQUIRE(!archive.poll_for_frames());
+    REQUIRE(archive.get_frame_data(RS_STREAM_DEPTH) != nullptr); // The empty image, until a frameset is prepared
+
+    auto publish = [&](unsigned long long number, bool with_points)
+    {
+        rsimpl::frame_archive::frame_additional_data data;
+        data.frame_number = number;
+        data.width = data.stride_x = 8;
+        data.height = data.stride_y = 2;
+        data.bpp = 16;
+        data.format = RS_FORMAT_Z16;
+        data.stream_type = RS_STREAM_DEPTH;
+        archive.alloc_frame(RS_STREAM_DEPTH, data, true);
+        archive.commit_frame(RS_STREAM_DEPTH);
+        REQUIRE(formed.size() == 1); // Formed as soon as its frames arrive
+        if (number == 1) REQUIRE(!archive.poll_for_frames()); // but only handed out once published
+
+        rsimpl::frame_archive::frame_ref * derived[RS_STREAM_COUNT - RS_STREAM_NATIVE_COUNT] = {};
+        if (with_points)
+        {
+            data.format = RS_FORMAT_XYZ32F;
+            data.bpp = 96;
+            data.stream_type = RS_STREAM_POINTS;
+            derived[RS_STREAM_POINTS - RS_STREAM_NATIVE_COUNT] = archive.create_derived_frame(data, [number](rsimpl::byte * dest) { dest[0] = static_cast<rsimpl::byte>(number); });
+            REQUIRE(derived[RS_STREAM_POINTS - RS_STREAM_NATIVE_COUNT] != nullptr);
+        }
+        archive.publish_prepared_frameset(formed.front(), derived);
+        formed.clear();
+    };
+
+    publish(1, true);
+    REQUIRE(archive.poll_for_frames());
+    REQUIRE(archive.get_frame_number(RS_STREAM_DEPTH) == 1);
+    REQUIRE(archive.get_derived_frame_data(RS_STREAM_POINTS)[0] == 1);
+    REQUIRE(archive.get_derived_frame_data(RS_STREAM_DEPTH_ALIGNED_TO_COLOR) == nullptr);
+    REQUIRE(!archive.poll_for_frames());
+
+    // Waiting framesets are bound by the queue of the key stream
+    publish(2, false);
+    publish(3, true);
+    publish(4, true);
+    REQUIRE(archive.try_wait_for_frames(std::chrono::milliseconds(0)));
+    REQUIRE(archive.get_frame_number(RS_STREAM_DEPTH) == 3);
+    REQUIRE(archive.get_derived_frame_data(RS_STREAM_POINTS)[0] == 3);
+    REQUIRE(archive.poll_for_frames());
+    REQUIRE(archive.get_frame_number(RS_STREAM_DEPTH) == 4);
+    REQUIRE(!archive.try_wait_for_frames(std::chrono::milliseconds(1)));
+    archive.flush();
+}
+
+TEST_CASE( "streams with a sync tolerance are matched within it or left out", "[offline] [validation]" )
+{
+    const rs_intrinsics intrin = { 8, 2, 4.0f, 1.0f, 10.0f, 10.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rsimpl::subdevice_mode depth_mode = { 0, { 8, 2 }, rsimpl::pf_z16, 60, intrin, {}, { 0 } };
+    const rsimpl::subdevice_mode color_mode = { 1, { 8, 2 }, rsimpl::pf_yuy2, 30, intrin, {}, { 0 } };
+    std::atomic<uint32_t> max_size(RS_USER_QUEUE_SIZE), event_queue_size(RS_MAX_EVENT_QUEUE_SIZE), events_timeout(RS_MAX_EVENT_TIME_OUT);
+    rsimpl::stream_queue_policy policies[RS_STREAM_NATIVE_COUNT];
+    for (auto & p : policies) p = { 4, RS_FRAME_DROP_POLICY_DROP_OLDEST };
+    rsimpl::syncronizing_archive archive({ rsimpl::subdevice_mode_selection(depth_mode, 0, 0), rsimpl::subdevice_mode_selection(color_mode, 0, 0) }, RS_STREAM_DEPTH, &max_size, &event_queue_size, &events_timeout, policies);
+    REQUIRE(archive.is_stream_enabled(RS_STREAM_COLOR));
+    archive.set_sync_tolerance(RS_STREAM_COLOR, 5);
+
+    auto commit = [&](rs_stream stream, unsigned long long number, double timestamp)
+    {
+        rsimpl::frame_archive::frame_additional_data data;
+        data.frame_number = number;
+        data.timestamp = timestamp;
+        data.width = data.stride_x = 8;
+        data.height = data.stride_y = 2;
+        data.bpp = 16;
+        data.format = stream == RS_STREAM_DEPTH ? RS_FORMAT_Z16 : RS_FORMAT_YUYV;
+        data.stream_type = stream;
+        archive.alloc_frame(stream, data, true);
+        archive.commit_frame(stream);
+    };
+
+    commit(RS_STREAM_DEPTH, 1, 0);
+    REQUIRE(!archive.poll_for_frames()); // Waits for a color frame at or after the depth frame
+    commit(RS_STREAM_COLOR, 1, 1.5);
+    REQUIRE(archive.poll_for_frames());
+    REQUIRE(archive.get_frame_number(RS_STREAM_COLOR) == 1);
+
+    // Color frame 2 was dropped, frame 3 is too far from depth frame 2, which goes out alone
+    commit(RS_STREAM_DEPTH, 2, 16.7);
+    REQUIRE(!archive.poll_for_frames());
+    commit(RS_STREAM_COLOR, 3, 68.2);
+    REQUIRE(archive.poll_for_frames());
+    REQUIRE(archive.get_frame_number(RS_STREAM_DEPTH) == 2);
+    REQUIRE(archive.get_frame_data(RS_STREAM_COLOR) == nullptr);
+
+    // A late color frame arriving out of order is put back in timestamp order and still matched
+    commit(RS_STREAM_DEPTH, 3, 33.3);
+    commit(RS_STREAM_DEPTH, 4, 50.0);
+    commit(RS_STREAM_COLOR, 2, 35.0);
+    REQUIRE(archive.poll_for_frames());
+    REQUIRE(archive.get_frame_number(RS_STREAM_DEPTH) == 3);
+    REQUIRE(archive.get_frame_number(RS_STREAM_COLOR) == 2);
+    REQUIRE(archive.poll_for_frames());
+    REQUIRE(archive.get_frame_number(RS_STREAM_DEPTH) == 4);
+    REQUIRE(archive.get_frame_data(RS_STREAM_COLOR) == nullptr);
+    commit(RS_STREAM_DEPTH, 5, 66.7);
+    REQUIRE(archive.try_wait_for_frames(std::chrono::milliseconds(0)));
+    REQUIRE(archive.get_frame_number(RS_STREAM_COLOR) == 3);
+    REQUIRE(std::fabs(archive.get_frame_timestamp(RS_STREAM_COLOR) - archive.get_frame_timestamp(RS_STREAM_DEPTH)) <= 5);
+    archive.flush();
+}
+
+TEST_CASE( "streams unpacked from one native frame are matched by frame instead of by timestamp", "[offline] [validation]" )
+{
+    const rs_intrinsics intrin = { 8, 2, 4.0f, 1.0f, 10.0f, 10.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rsimpl::subdevice_mode inzi_mode = { 0, { 8, 2 }, rsimpl::pf_f200_inzi, 60, intrin, {}, { 0 } };
+    const rsimpl::subdevice_mode color_mode = { 1, { 8, 2 }, rsimpl::pf_yuy2, 30, intrin, {}, { 0 } };
+    std::atomic<uint32_t> max_size(RS_USER_QUEUE_SIZE), event_queue_size(RS_MAX_EVENT_QUEUE_SIZE), events_timeout(RS_MAX_EVENT_TIME_OUT);
+    rsimpl::stream_queue_policy policies[RS_STREAM_NATIVE_COUNT];
+    for (auto & p : policies) p = { 4, RS_FRAME_DROP_POLICY_DROP_OLDEST };
+    rsimpl::syncronizing_archive archive({ rsimpl::subdevice_mode_selection(inzi_mode, 0, 0), rsimpl::subdevice_mode_selection(color_mode, 0, 0) }, RS_STREAM_DEPTH, &max_size, &event_queue_size, &events_timeout, policies);
+    REQUIRE(archive.is_stream_enabled(RS_STREAM_INFRARED));
+    archive.set_companion(RS_STREAM_INFRARED, RS_STREAM_DEPTH);
+
+    auto alloc = [&](rs_stream stream, unsigned long long number, double timestamp, long long system_time)
+    {
+        rsimpl::frame_archive::frame_additional_data data;
+        data.frame_number = number;
+        data.timestamp = timestamp;
+        data.system_time = system_time;
+        data.width = data.stride_x = 8;
+        data.height = data.stride_y = 2;
+        data.bpp = stream == RS_STREAM_INFRARED ? 8 : 16;
+        data.format = stream == RS_STREAM_DEPTH ? RS_FORMAT_Z16 : stream == RS_STREAM_INFRARED ? RS_FORMAT_Y8 : RS_FORMAT_YUYV;
+        data.stream_type = stream;
+        archive.alloc_frame(stream, data, true);
+    };
+    auto commit_inzi = [&](unsigned long long number, double timestamp, double infrared_timestamp)
+    {
+        alloc(RS_STREAM_DEPTH, number, timestamp, 1000 + number);
+        alloc(RS_STREAM_INFRARED, number, infrared_timestamp, 1000 + number);
+        const rs_stream unit[] = { RS_STREAM_DEPTH, RS_STREAM_INFRARED };
+        archive.commit_frames(unit, 2);
+    };
+
+    // Infrared frames are committed and drained along with their depth frame
+    commit_inzi(1, 0, 0);
+    REQUIRE(archive.poll_for_frames());
+    REQUIRE(archive.get_frame_number(RS_STREAM_DEPTH) == 1);
+    REQUIRE(archive.get_frame_number(RS_STREAM_INFRARED) == 1);
+
+    // Infrared frames go out with their depth frame however far their timestamps are, and are culled along with the depth frames
+    commit_inzi(2, 16.7, 100);
+    commit_inzi(3, 33.3, -100);
+    commit_inzi(4, 50.0, 50.0);
+    alloc(RS_STREAM_COLOR, 2, 33.8, 1003);
+    archive.commit_frame(RS_STREAM_COLOR);
+    REQUIRE(archive.poll_for_frames());
+    REQUIRE(archive.get_frame_number(RS_STREAM_DEPTH) == 3);
+    REQUIRE(archive.get_frame_number(RS_STREAM_INFRARED) == 3);
+    REQUIRE(archive.get_frame_timestamp(RS_STREAM_INFRARED) == -100);
+    REQUIRE(archive.poll_for_frames());
+    REQUIRE(archive.get_frame_number(RS_STREAM_DEPTH) == 4);
+    REQUIRE(archive.get_frame_number(RS_STREAM_INFRARED) == 4);
+    REQUIRE(!archive.poll_for_frames());
+    archive.flush();
+}
+
+TEST_CASE( "framesets are shared by every handle and release their frames together", "[offline] [validation]" )
+{
+    const rs_intrinsics intrin = { 8, 2, 4.0f, 1.0f, 10.0f, 10.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rsimpl::subdevice_mode mode = { 0, { 8, 2 }, rsimpl::pf_z16, 30, intrin, {}, { 0 } };
+    std::atomic<uint32_t> max_size(RS_USER_QUEUE_SIZE), event_queue_size(RS_MAX_EVENT_QUEUE_SIZE), events_timeout(RS_MAX_EVENT_TIME_OUT);
+    rsimpl::stream_queue_policy policies[RS_STREAM_NATIVE_COUNT];
+    for (auto & p : policies) p = { 2, RS_FRAME_DROP_POLICY_DROP_OLDEST };
+    rsimpl::syncronizing_archive archive({ rsimpl::subdevice_mode_selection(mode, 0, 0) }, RS_STREAM_DEPTH, &max_size, &event_queue_size, &events_timeout, policies);
+
+    rsimpl::frame_archive::frame_additional_data data;
+    data.frame_number = 1;
+    data.width = data.stride_x = 8;
+    data.height = data.stride_y = 2;
+    data.bpp = 16;
+    data.format = RS_FORMAT_Z16;
+    data.stream_type = RS_STREAM_DEPTH;
+    archive.alloc_frame(RS_STREAM_DEPTH, data, true);
+    archive.commit_frame(RS_STREAM_DEPTH);
+
+    rsimpl::frame_archive::shared_frameset * frames = nullptr;
+    REQUIRE(archive.poll_for_frames_safe(&frames));
+    auto clone = archive.clone_frameset(frames);
+    REQUIRE(clone == frames);
+
+    // Frames are obtained from a frameset without changing it
+    auto depth = archive.detach_frame_ref(frames, RS_STREAM_DEPTH);
+    REQUIRE(depth->get_frame_number() == 1);
+    REQUIRE(clone->get_frames().get_frame_number(RS_STREAM_DEPTH) == 1);
+    archive.release_frameset(frames);
+    REQUIRE(clone->get_frames().get_frame_data(RS_STREAM_DEPTH) == depth->get_frame_data());
+    archive.release_frameset(clone);
+    REQUIRE(depth->get_frame_number() == 1);
+    archive.release_frame_ref(depth);
+    archive.flush(); // Waits for every handle, the one of the archive to the presented frameset included
+}
+
+TEST_CASE( "control requests are retried within their budget", "[offline] [validation]" )
+{
+    // Transient failures are retried until the request succeeds
+    int attempts = 0;
+    rsimpl::uvc::retry_control(1000, [&]() { if(++attempts < 3) throw std::runtime_error("busy"); });
+    REQUIRE(attempts == 3);
+
+    // Requests refused for good fail on the first attempt
+    attempts = 0;
+    REQUIRE_THROWS_AS(rsimpl::uvc::retry_control(1000, [&]() { ++attempts; throw rsimpl::uvc::control_rejected_error("unsupported"); }), rsimpl::uvc::control_rejected_error);
+    REQUIRE(attempts == 1);
+
+    // A budget of 0 makes a single attempt, and a small one gives up after a few
+    attempts = 0;
+    REQUIRE_THROWS_AS(rsimpl::uvc::retry_control(0, [&]() { ++attempts; throw std::runtime_error("busy"); }), std::runtime_error);
+    REQUIRE(attempts == 1);
+    attempts = 0;
+    REQUIRE_THROWS_AS(rsimpl::uvc::retry_control(20, [&]() { ++attempts; throw std::runtime_error("busy"); }), std::runtime_error);
+    REQUIRE(attempts >= 2);
+    REQUIRE(attempts <= 4);
+}
+
+TEST_CASE( "rs_start_device() validates input", "[offline] [validation]" )
+{
+    rs_start_device(nullptr, require_error("null pointer passed for argument \"device\""));
+}
+
+TEST_CASE( "rs_stop_device() validates input", "[offline] [validation]" )
+{
+    rs_stop_device(nullptr, require_error("null pointer passed for argument \"device\""));
+}
+
+TEST_CASE( "rs_is_device_streaming() validates input", "[offline] [validation]" )
+{
+    REQUIRE(rs_is_device_streaming(nullptr, require_error("null pointer passed for argument \"device\"")) == 0);
+}
+
+TEST_CASE( "rs_pause_device(), rs_resume_device() and rs_is_device_paused() validate input", "[offline] [validation]" )
+{
+    rs_pause_device(nullptr, require_error("null pointer passed for argument \"device\""));
+    rs_resume_device(nullptr, require_error("null pointer passed for argument \"device\""));
+    REQUIRE(rs_is_device_paused(nullptr, require_error("null pointer passed for argument \"device\"")) == 0);
+}
+
+TEST_CASE( "rs_set_device_option() validates input", "[offline] [validation]" )
+{
+    rs_set_device_option(nullptr,               RS_OPTION_COLOR_GAIN, 100, require_error("null pointer passed for argument \"device\""));
+
+    rs_set_device_option(fake_object_pointer(), (rs_option)-1,        100, require_error("bad enum value for argument \"option\""));
+    rs_set_device_option(fake_object_pointer(), RS_OPTION_COUNT,      100, require_error("bad enum value for argument \"option\""));
+
+    // NOTE: Currently no validation is done for valid option ranges at the API level, though specifying an invalid option may fail at the UVC level
+    // todo - Add some basic validation for parameter sanity (gain/exposure cannot be negative, depth clamping must be in uint16_t range, etc...)
+}
+
+TEST_CASE( "rs_begin_device_options() and rs_commit_device_options() validate input", "[offline] [validation]" )
+{
+    rs_begin_device_options(nullptr, require_error("null pointer passed for argument \"device\""));
+    rs_commit_device_options(nullptr, require_error("null pointer passed for argument \"device\""));
+}
+
+TEST_CASE( "rs_set_device_options_async() and rs_get_device_options_async() validate input", "[offline] [validation]" )
+{
+    const rs_option options[] = { RS_OPTION_COLOR_GAIN };
+    const double values[] = { 100 };
+    auto on_complete = [](rs_device *, const rs_option *, unsigned int, const double *, rs_error *, void *) {};
+    rs_set_device_options_async(nullptr,               options, 1, values, on_complete, nullptr, require_error("null pointer passed for argument \"device\""));
+    rs_set_device_options_async(fake_object_pointer(), nullptr, 1, values, on_complete, nullptr, require_error("null pointer passed for argument \"options\""));
+    rs_set_device_options_async(fake_object_pointer(), options, 1, nullptr, on_complete, nullptr, require_error("null pointer passed for argument \"values\""));
+
+    const rs_option bad_options[] = { RS_OPTION_COUNT };
+    rs_set_device_options_async(fake_object_pointer(), bad_options, 1, values, on_complete, nullptr, require_error("bad enum value for argument \"options[i]\""));
+
+    rs_get_device_options_async(nullptr,               options, 1, on_complete, nullptr, require_error("null pointer passed for argument \"device\""));
+    rs_get_device_options_async(fake_object_pointer(), bad_options, 1, on_complete, nullptr, require_error("bad enum value for argument \"options[i]\""));
+    rs_get_device_options_async(fake_object_pointer(), options, 1, nullptr, nullptr, require_error("null pointer passed for argument \"on_complete\""));
+}
+
+TEST_CASE( "option requests run in order, queued writes merging", "[offline] [validation]" )
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool blocked = true;
+    std::vector<std::vector<rs_option>> writes;
+    rsimpl::executor pool(2, 0);
+    rsimpl::option_request_queue queue(pool, [&](const rs_option options[], size_t count, const double values[])
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return !blocked; });
+        if (values[0] < 0) throw std::runtime_error("negative value");
+        writes.push_back(std::vector<rs_option>(options, options + count));
+    }, [&](const rs_option options[], size_t count, double values[])
+    {
+        for (size_t i = 0; i < count; ++i) values[i] = 42;
+    });
+
+    std::vector<std::string> completions;
+    auto record = [&](std::string name) { return [&, name](const rs_option *, size_t count, const double * values, const char * error_message)
+    {
+        std::ostringstream ss;
+        ss << name;
+        for (size_t i = 0; i < count; ++i) ss << ' ' << values[i];
+        if (error_message) ss << ' ' << error_message;
+        std::lock_guard<std::mutex> lock(mutex);
+        completions.push_back(ss.str());
+        cv.notify_all();
+    }; };
+
+    // The first write holds the queue up, so that the next three merge behind it, the read is queued after them and the failing write after the read
+    const rs_option gain = RS_OPTION_COLOR_GAIN, exposure = RS_OPTION_COLOR_EXPOSURE, both[] = { RS_OPTION_COLOR_GAIN, RS_OPTION_COLOR_EXPOSURE };
+    double first = 1, second[] = { 2, 3 }, third = 4, failing = -1;
+    queue.set(&gain, 1, &first, record("a"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    queue.set(both, 2, second, record("b"));
+    queue.set(&gain, 1, &first, nullptr);
+    queue.set(&gain, 1, &third, record("c"));
+    queue.get(&exposure, 1, record("d"));
+    queue.set(&exposure, 1, &failing, record("e"));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        blocked = false;
+        cv.notify_all();
+        cv.wait(lock, [&]() { return completions.size() == 5; });
+    }
+    queue.stop();
+
+    REQUIRE(writes.size() == 2);
+    REQUIRE(writes[1] == std::vector<rs_option>({ RS_OPTION_COLOR_EXPOSURE, RS_OPTION_COLOR_GAIN }));
+    REQUIRE(completions == std::vector<std::string>({ "a 1", "b 4 3", "c 4", "d 42", "e -1 negative value" }));
+}
+
+TEST_CASE( "option values are cached as written or read until invalidated", "[offline] [validation]" )
+{
+    rsimpl::option_value_cache cache;
+    double value = -1;
+    REQUIRE(!cache.lookup(RS_OPTION_R200_DEPTH_UNITS, value));
+    REQUIRE(value == -1);
+
+    cache.store(RS_OPTION_R200_DEPTH_UNITS, 1000);
+    cache.store(RS_OPTION_F200_ACCURACY, 2);
+    REQUIRE(cache.lookup(RS_OPTION_R200_DEPTH_UNITS, value));
+    REQUIRE(value == 1000);
+    REQUIRE(!cache.lookup(RS_OPTION_R200_DEPTH_CLAMP_MIN, value));
+
+    cache.invalidate(RS_OPTION_R200_DEPTH_UNITS);
+    REQUIRE(!cache.lookup(RS_OPTION_R200_DEPTH_UNITS, value));
+    REQUIRE(cache.lookup(RS_OPTION_F200_ACCURACY, value));
+    REQUIRE(value == 2);
+
+    cache.invalidate_all();
+    REQUIRE(!cache.lookup(RS_OPTION_F200_ACCURACY, value));
+}
+
+TEST_CASE( "hw commands of the application go before background reads, identical reads merging", "[offline] [validation]" )
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool blocked = true, busy_once = true;
+    std::vector<int> performed;
+    rsimpl::executor pool(2, 0);
+    rsimpl::hw_command_queue queue(pool, [&](rsimpl::hw_monitor::hwmon_cmd & cmd, std::chrono::milliseconds)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return !blocked; });
+        if (cmd.cmd == 3 && busy_once)
+        {
+            busy_once = false;
+            throw rsimpl::hw_monitor::monitor_busy_error();
+        }
+        if (cmd.cmd == 4) throw std::runtime_error("bad opcode");
+        performed.push_back(cmd.cmd);
+        cmd.receivedCommandDataLength = cmd.cmd;
+    });
+
+    std::vector<std::string> completions;
+    auto record = [&](std::string name) { return [&, name](const rsimpl::hw_monitor::hwmon_cmd & cmd, const char * error_message)
+    {
+        std::ostringstream ss;
+        ss << name << ' ' << cmd.receivedCommandDataLength;
+        if (error_message) ss << ' ' << error_message;
+        std::lock_guard<std::mutex> lock(mutex);
+        completions.push_back(ss.str());
+        cv.notify_all();
+    }; };
+
+    // The first command holds the queue up, so that the background reads merge behind it and the control commands overtake them.
+    // The background read finding the monitor busy once is put back and carried out after the next control command.
+    rsimpl::hw_monitor::hwmon_cmd write(2);
+    write.sizeOfSendCommandData = 1;
+    queue.submit(rsimpl::hw_monitor::hwmon_cmd(1), rsimpl::hw_command_priority::control, record("a"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    queue.submit(rsimpl::hw_monitor::hwmon_cmd(3), rsimpl::hw_command_priority::background, record("b"));
+    queue.submit(write, rsimpl::hw_command_priority::background, record("c"));
+    queue.submit(write, rsimpl::hw_command_priority::background, record("d"));
+    queue.submit(rsimpl::hw_monitor::hwmon_cmd(3), rsimpl::hw_command_priority::background, record("e"));
+    queue.submit(rsimpl::hw_monitor::hwmon_cmd(4), rsimpl::hw_command_priority::control, record("f"));
+    queue.submit(rsimpl::hw_monitor::hwmon_cmd(5), rsimpl::hw_command_priority::control, nullptr);
+    REQUIRE(queue.get_queued_count(rsimpl::hw_command_priority::background) == 3);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        blocked = false;
+        cv.notify_all();
+        cv.wait(lock, [&]() { return completions.size() == 6; });
+    }
+    queue.stop();
+
+    REQUIRE(performed == std::vector<int>({ 1, 5, 3, 2, 2 }));
+    REQUIRE(completions == std::vector<std::string>({ "a 1", "f 0 bad opcode", "b 3", "e 3", "c 2", "d 2" }));
+    REQUIRE_THROWS(queue.submit(rsimpl::hw_monitor::hwmon_cmd(1), rsimpl::hw_command_priority::control, nullptr));
+}
+
+TEST_CASE( "motion module firmware is cut into IAP writes of at most 128 bytes of payload", "[offline] [motion-module]" )
+{
+    std::vector<uint8_t> image(300);
+    for (size_t i = 0; i < image.size(); ++i) image[i] = static_cast<uint8_t>(i);
+
+    auto commands = rsimpl::motion_module::make_firmware_write_commands(0x42, image.data(), (int)image.size());
+    REQUIRE(commands.size() == 3);
+
+    const int payloads[] = { 128, 128, 44 };
+    const uint8_t addresses[][4] = { { 0x08, 0x00, 0x20, 0x00 }, { 0x08, 0x00, 0x20, 0x80 }, { 0x08, 0x00, 0x21, 0x00 } };
+    for (int i = 0; i < 3; ++i)
+    {
+        auto & cmd = commands[i];
+        REQUIRE(cmd.cmd == 0x05);
+        REQUIRE(cmd.Param1 == 0x42);
+        REQUIRE(cmd.Param2 == 8 + payloads[i]);
+        REQUIRE(cmd.sizeOfSendCommandData == 8 + payloads[i]);
+
+        // Op code, then the image address and payload length as big endian
+        REQUIRE(cmd.data[0] == 0x6);
+        for (int j = 0; j < 4; ++j) REQUIRE(cmd.data[1 + j] == addresses[i][j]);
+        REQUIRE(cmd.data[5] == 0);
+        REQUIRE(cmd.data[6] == payloads[i]);
+        REQUIRE(cmd.data[7] == 0);
+        REQUIRE(memcmp(cmd.data + 8, image.data() + i * 128, payloads[i]) == 0);
+    }
+
+    REQUIRE(rsimpl::motion_module::make_firmware_write_commands(0x42, image.data(), 0).empty());
+}
+
+TEST_CASE( "rs_send_blob_to_device_with_progress() validates input", "[offline] [validation]" )
+{
+    uint8_t blob[4] = {};
+    auto on_progress = [](rs_device *, int, int, void *) {};
+    rs_send_blob_to_device_with_progress(nullptr, RS_BLOB_TYPE_MOTION_MODULE_FIRMWARE_UPDATE, blob, sizeof(blob), on_progress, nullptr, require_error("null pointer passed for argument \"device\""));
+    rs_send_blob_to_device_with_progress((rs_device *)1, RS_BLOB_TYPE_MOTION_MODULE_FIRMWARE_UPDATE, nullptr, sizeof(blob), on_progress, nullptr, require_error("null pointer passed for argument \"data\""));
+    rs_send_blob_to_device_with_progress((rs_device *)1, RS_BLOB_TYPE_MOTION_MODULE_FIRMWARE_UPDATE, blob, sizeof(blob), nullptr, nullptr, require_error("null pointer passed for argument \"on_progress\""));
+}
+
+TEST_CASE( "callback queues drop their oldest frames once full", "[offline] [validation]" )
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool blocked = true;
+    std::vector<intptr_t> delivered, released;
+    auto frame = [](intptr_t i) { return (rs_frame_ref *)i; };
+    rsimpl::frame_callback_queue queue(2, [&](rs_frame_ref * f)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        delivered.push_back((intptr_t)f);
+        cv.notify_all();
+        cv.wait(lock, [&]() { return !blocked; });
+    }, [&](rs_frame_ref * f)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released.push_back((intptr_t)f);
+    });
+
+    // The first frame holds the callback up, so that frames 2 and 3 are dropped to make room for 4 and 5 behind it
+    queue.push(frame(1));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return delivered.size() == 1; });
+    }
+    for (intptr_t i = 2; i <= 5; ++i) queue.push(frame(i));
+    REQUIRE(queue.get_dropped_count() == 2);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(released == std::vector<intptr_t>({ 2, 3 }));
+        blocked = false;
+        cv.notify_all();
+        cv.wait(lock, [&]() { return delivered.size() == 3; });
+    }
+
+    // Once stopped, frames are released instead of being queued
+    queue.stop();
+    queue.push(frame(6));
+    REQUIRE(delivered == std::vector<intptr_t>({ 1, 4, 5 }));
+    REQUIRE(released == std::vector<intptr_t>({ 2, 3, 6 }));
+    REQUIRE(queue.get_dropped_count() == 2);
+}
+
+TEST_CASE( "callback queues dropping their newest frames keep the frames queued", "[offline] [validation]" )
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool blocked = true;
+    std::vector<intptr_t> delivered, released;
+    auto frame = [](intptr_t i) { return (rs_frame_ref *)i; };
+    rsimpl::frame_callback_queue queue(2, [&](rs_frame_ref * f)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        delivered.push_back((intptr_t)f);
+        cv.notify_all();
+        cv.wait(lock, [&]() { return !blocked; });
+    }, [&](rs_frame_ref * f)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released.push_back((intptr_t)f);
+    }, RS_FRAME_DROP_POLICY_DROP_NEWEST);
+
+    queue.push(frame(1));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return delivered.size() == 1; });
+    }
+    for (intptr_t i = 2; i <= 5; ++i) queue.push(frame(i));
+    REQUIRE(queue.get_dropped_count() == 2);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(released == std::vector<intptr_t>({ 4, 5 }));
+        blocked = false;
+        cv.notify_all();
+        cv.wait(lock, [&]() { return delivered.size() == 3; });
+    }
+    queue.stop();
+    REQUIRE(delivered == std::vector<intptr_t>({ 1, 2, 3 }));
+}
+
+TEST_CASE( "timestamp corrector finds events by frame number without waiting", "[offline] [validation]" )
+{
+    struct fake_frame : rsimpl::frame_interface
+    {
+        unsigned long long number;
+        double timestamp = 0;
+        rs_timestamp_domain domain = RS_TIMESTAMP_DOMAIN_CAMERA;
+        explicit fake_frame(unsigned long long number) : number(number) {}
+        double get_frame_metadata(rs_frame_metadata) const override { return 0; }
+        bool supports_frame_metadata(rs_frame_metadata) const override { return false; }
+        unsigned long long get_frame_number() const override { return number; }
+        void set_timestamp(double new_ts) override { timestamp = new_ts; }
+        void set_timestamp_domain(rs_timestamp_domain timestamp_domain) override { domain = timestamp_domain; }
+        rs_stream get_stream_type() const override { return RS_STREAM_DEPTH; }
+    };
+    std::atomic<uint32_t> queue_size(4), timeout(20);
+    std::unique_ptr<rsimpl::timestamp_corrector> corrector(new rsimpl::timestamp_corrector(&queue_size, &timeout));
+
+    for (unsigned long long n = 1; n <= 6; ++n) corrector->on_timestamp({ 100.0 + n, RS_EVENT_IMU_DEPTH_CAM, n });
+    corrector->on_timestamp({ 500, RS_EVENT_IMU_MOTION_CAM, 7 });
+
+    fake_frame f5(5), f2(2), f7(7);
+    REQUIRE(corrector->correct_timestamp(f5, RS_STREAM_DEPTH));
+    REQUIRE(f5.timestamp == 105);
+    REQUIRE(f5.domain == RS_TIMESTAMP_DOMAIN_MICROCONTROLLER);
+    REQUIRE(!corrector->correct_timestamp(f2, RS_STREAM_DEPTH)); // Older than the latest queue_size events
+    REQUIRE(!corrector->correct_timestamp(f7, RS_STREAM_COLOR));  // Not arrived yet on this source
+    REQUIRE(f7.domain == RS_TIMESTAMP_DOMAIN_CAMERA);
+    REQUIRE(corrector->correct_timestamp(f7, RS_STREAM_FISHEYE));
+
+    // Waiting returns as soon as the event arrives, or once it is overdue
+    fake_frame f8(8), f9(9);
+    std::thread producer([&]() { std::this_thread::sleep_for(std::chrono::milliseconds(5)); corrector->on_timestamp({ 108, RS_EVENT_IMU_DEPTH_CAM, 8 }); });
+    REQUIRE(corrector->wait_and_correct_timestamp(f8, RS_STREAM_INFRARED, std::chrono::system_clock::now() + std::chrono::seconds(10)));
+    producer.join();
+    REQUIRE(f8.timestamp == 108);
+    REQUIRE(!corrector->wait_and_correct_timestamp(f9, RS_STREAM_INFRARED, std::chrono::system_clock::now()));
+}
+
+TEST_CASE( "latency histograms bin durations by powers of two microseconds", "[offline] [validation]" )
+{
+    rsimpl::latency_histogram histogram;
+    histogram.add(-1);
+    histogram.add(0.0005);
+    histogram.add(0.001);
+    histogram.add(0.003);
+    histogram.add(0.004);
+    histogram.add(16.5);
+    histogram.add(10000);
+
+    unsigned long long counts[RS_LATENCY_HISTOGRAM_BIN_COUNT];
+    histogram.read(counts);
+    REQUIRE(counts[0] == 2);
+    REQUIRE(counts[1] == 1);
+    REQUIRE(counts[2] == 1);
+    REQUIRE(counts[3] == 1);
+    REQUIRE(counts[15] == 1);
+    REQUIRE(counts[RS_LATENCY_HISTOGRAM_BIN_COUNT - 1] == 1);
+    REQUIRE(std::accumulate(counts, counts + RS_LATENCY_HISTOGRAM_BIN_COUNT, 0ull) == 7);
+
+    // Stages are timed from the dequeue of the frame, and frames not timed are left out
+    rsimpl::stage_latency_histograms stages;
+    double metadata[RS_FRAME_METADATA_COUNT] = {};
+    metadata[RS_FRAME_METADATA_TIME_OF_DEQUEUE] = 100;
+    metadata[RS_FRAME_METADATA_TIME_OF_COMMIT] = 100.003;
+    stages.add(RS_STREAM_DEPTH, metadata, 1u << RS_FRAME_METADATA_TIME_OF_COMMIT);
+    stages.add(RS_STREAM_DEPTH, metadata, 1u << RS_FRAME_METADATA_TIME_OF_DEQUEUE | 1u << RS_FRAME_METADATA_TIME_OF_COMMIT);
+    stages.stages[RS_STREAM_DEPTH][RS_FRAME_METADATA_TIME_OF_COMMIT - RS_FRAME_METADATA_TIME_OF_VALIDATION].read(counts);
+    REQUIRE(counts[2] == 1);
+    REQUIRE(std::accumulate(counts, counts + RS_LATENCY_HISTOGRAM_BIN_COUNT, 0ull) == 1);
+
+    // Exposure is timed to delivery, for frames with both
+    metadata[RS_FRAME_METADATA_TIME_OF_EXPOSURE] = 70;
+    metadata[RS_FRAME_METADATA_TIME_OF_DELIVERY] = 100.0005;
+    stages.add(RS_STREAM_COLOR, metadata, 1u << RS_FRAME_METADATA_TIME_OF_DEQUEUE | 1u << RS_FRAME_METADATA_TIME_OF_EXPOSURE);
+    stages.add(RS_STREAM_COLOR, metadata, 1u << RS_FRAME_METADATA_TIME_OF_DEQUEUE | 1u << RS_FRAME_METADATA_TIME_OF_EXPOSURE | 1u << RS_FRAME_METADATA_TIME_OF_DELIVERY);
+    stages.exposure_to_delivery[RS_STREAM_COLOR].read(counts);
+    REQUIRE(counts[15] == 1);
+    REQUIRE(std::accumulate(counts, counts + RS_LATENCY_HISTOGRAM_BIN_COUNT, 0ull) == 1);
+
+    histogram.reset();
+    histogram.read(counts);
+    REQUIRE(std::accumulate(counts, counts + RS_LATENCY_HISTOGRAM_BIN_COUNT, 0ull) == 0);
+}
+
+TEST_CASE( "device clock estimators map timestamps by the quickest recent transfer, and start over when the device clock restarts", "[offline] [validation]" )
+{
+    rsimpl::device_clock_estimator clock;
+    REQUIRE(!clock.is_valid());
+
+    // Frames exposed every 33 ms of a device clock 5000 ms behind the host, reaching the host 2 to 9 ms later
+    for (unsigned long long i = 0; i < 60; ++i)
+    {
+        const double timestamp = 1000 + 33.0 * i;
+        clock.add(timestamp, i, timestamp + 5000 + 2 + (i * 7) % 8);
+    }
+    REQUIRE(clock.is_valid());
+    REQUIRE(clock.to_host_time(3000) == Approx(8002));
+
+    // The offset follows the drift of the clocks once the quicker transfers leave the window
+    for (unsigned long long i = 60; i < 300; ++i)
+    {
+        const double timestamp = 1000 + 33.0 * i;
+        clock.add(timestamp, i, timestamp + 5010 + 2 + (i * 7) % 8);
+    }
+    REQUIRE(clock.to_host_time(3000) == Approx(8012));
+
+    // A timestamp going backwards restarts the estimate
+    clock.add(10, 0, 20000);
+    REQUIRE(clock.to_host_time(10) == Approx(20000));
+    clock.add(43, 1, 20040);
+    REQUIRE(clock.to_host_time(43) == Approx(20033));
+}
+
+TEST_CASE( "motion history interpolates samples and finds them by timestamp", "[offline] [validation]" )
+{
+    std::unique_ptr<rsimpl::motion_history> history(new rsimpl::motion_history());
+    auto sample = [](rs_event_source source, double timestamp, float x)
+    {
+        rs_motion_data s = {};
+        s.timestamp_data.timestamp = timestamp;
+        s.timestamp_data.source_id = source;
+        s.is_valid = 1;
+        s.axes[0] = x;
+        return s;
+    };
+    for (int i = 0; i < 10; ++i) history->push(sample(RS_EVENT_IMU_GYRO, 10.0 * i, (float)i));
+    history->push(sample(RS_EVENT_IMU_ACCEL, 5, 100));
+    history->push(sample(RS_EVENT_IMU_DEPTH_CAM, 5, 200));
+
+    rs_motion_data s;
+    REQUIRE(history->get_sample_at(RS_EVENT_IMU_GYRO, 25, s));
+    REQUIRE(s.timestamp_data.timestamp == 25);
+    REQUIRE(s.axes[0] == Approx(2.5f));
+    REQUIRE(history->get_sample_at(RS_EVENT_IMU_GYRO, 90, s));
+    REQUIRE(s.axes[0] == 9);
+    REQUIRE(!history->get_sample_at(RS_EVENT_IMU_GYRO, -1, s));
+    REQUIRE(!history->get_sample_at(RS_EVENT_IMU_GYRO, 91, s));
+    REQUIRE(history->get_sample_at(RS_EVENT_IMU_ACCEL, 5, s));
+    REQUIRE(s.axes[0] == 100);
+
+    rs_motion_data samples[2];
+    REQUIRE(history->get_samples(RS_EVENT_IMU_GYRO, 20, 50, samples, 2) == 4);
+    REQUIRE(samples[0].axes[0] == 2);
+    REQUIRE(samples[1].axes[0] == 3);
+    REQUIRE(history->get_samples(RS_EVENT_IMU_GYRO, 91, 100, samples, 2) == 0);
+
+    // Once the ring wraps around, only the latest samples remain
+    for (int i = 10; i < 2 * RS_MOTION_HISTORY_SIZE; ++i) history->push(sample(RS_EVENT_IMU_GYRO, 10.0 * i, (float)i));
+    REQUIRE(!history->get_sample_at(RS_EVENT_IMU_GYRO, 25, s));
+    REQUIRE(history->get_sample_at(RS_EVENT_IMU_GYRO, 10.0 * (2 * RS_MOTION_HISTORY_SIZE - 1) - 5, s));
+    REQUIRE(s.axes[0] == Approx(2 * RS_MOTION_HISTORY_SIZE - 1.5f));
+}
+
+TEST_CASE( "rs_get_motion_sample_at() and rs_get_motion_samples() validate input", "[offline] [validation]" )
+{
+    rs_motion_data sample;
+    REQUIRE(rs_get_motion_sample_at(nullptr,               RS_EVENT_IMU_GYRO,       0, &sample, require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_get_motion_sample_at(fake_object_pointer(), RS_EVENT_SOURCE_COUNT,   0, &sample, require_error("bad enum value for argument \"source\"")) == 0);
+    REQUIRE(rs_get_motion_sample_at(fake_object_pointer(), RS_EVENT_IMU_DEPTH_CAM,  0, &sample, require_error("out of range value for argument \"source\"")) == 0);
+    REQUIRE(rs_get_motion_sample_at(fake_object_pointer(), RS_EVENT_IMU_GYRO,       0, nullptr, require_error("null pointer passed for argument \"sample\"")) == 0);
+
+    REQUIRE(rs_get_motion_samples(nullptr,               RS_EVENT_IMU_ACCEL,    0, 1, &sample, 1,  require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_get_motion_samples(fake_object_pointer(), (rs_event_source)-1,   0, 1, &sample, 1,  require_error("bad enum value for argument \"source\"")) == 0);
+    REQUIRE(rs_get_motion_samples(fake_object_pointer(), RS_EVENT_G0_SYNC,      0, 1, &sample, 1,  require_error("out of range value for argument \"source\"")) == 0);
+    REQUIRE(rs_get_motion_samples(fake_object_pointer(), RS_EVENT_IMU_ACCEL,    0, 1, &sample, -1, require_error("out of range value for argument \"max_count\"")) == 0);
+    REQUIRE(rs_get_motion_samples(fake_object_pointer(), RS_EVENT_IMU_ACCEL,    0, 1, nullptr, 1,  require_error("null pointer passed for argument \"samples\"")) == 0);
+}
+
+TEST_CASE( "recordings read back the records written, in order", "[offline] [validation]" )
+{
+    const std::string path = "recording-test.bin";
+    std::vector<uint16_t> frame(640 * 480);
+    for (size_t i = 0; i < frame.size(); ++i) frame[i] = (uint16_t)i;
+    const unsigned char transfer[] = { 1, 2, 3, 4, 5 };
+    {
+        // Chunks hold two frames each, so that the records span several chunks and the last one is partly filled
+        rsimpl::recording::writer writer(path, 2 * frame.size() * sizeof(uint16_t) + 4096, 2);
+        rsimpl::recording::device_record device = { "Test Camera", "1234", "1.0" };
+        REQUIRE(writer.write_device(device));
+        for (int i = 0; i < 5; ++i)
+        {
+            rsimpl::recording::frame_record record = { 1, rsimpl::recording::frame_encoding::raw, 10.0 * i, (uint64_t)i, 0, 0, 30 };
+            frame[0] = (uint16_t)i;
+            while (!writer.write_frame(record, frame.data(), frame.size() * sizeof(uint16_t))) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        rsimpl::recording::motion_record motion = { 3, 0, 0 };
+        REQUIRE(writer.write_motion(motion, transfer, sizeof(transfer)));
+        REQUIRE(!writer.write_frame({}, frame.data(), 4 * frame.size() * sizeof(uint16_t))); // Larger than a chunk
+        writer.close();
+        REQUIRE(writer.get_written_bytes() % rsimpl::recording::chunk_alignment == 0);
+    }
+
+    rsimpl::recording::reader reader(path);
+    rsimpl::recording::record r;
+    REQUIRE(reader.next(r));
+    REQUIRE(r.type == rsimpl::recording::record_type::device);
+    REQUIRE(std::string(reinterpret_cast<const rsimpl::recording::device_record *>(r.payload)->name) == "Test Camera");
+    for (int i = 0; i < 5; ++i)
+    {
+        REQUIRE(reader.next(r));
+        REQUIRE(r.type == rsimpl::recording::record_type::frame);
+        REQUIRE(r.size == sizeof(rsimpl::recording::frame_record) + frame.size() * sizeof(uint16_t));
+        REQUIRE(reinterpret_cast<const rsimpl::recording::frame_record *>(r.payload)->frame_counter == (uint64_t)i);
+        auto pixels = reinterpret_cast<const uint16_t *>(r.payload + sizeof(rsimpl::recording::frame_record));
+        REQUIRE(pixels[0] == i);
+        REQUIRE(pixels[frame.size() - 1] == frame.back());
+    }
+    REQUIRE(reader.next(r));
+    REQUIRE(r.type == rsimpl::recording::record_type::motion);
+    REQUIRE(r.size == sizeof(rsimpl::recording::motion_record) + sizeof(transfer));
+    REQUIRE(r.payload[sizeof(rsimpl::recording::motion_record) + 4] == 5);
+    REQUIRE(!reader.next(r));
+
+    reader.rewind();
+    REQUIRE(reader.next(r));
+    REQUIRE(r.type == rsimpl::recording::record_type::device);
+
+    // A reader of a mapped file hands out payloads which point into the mapping, and stay valid along with it
+    auto mapping = std::make_shared<rsimpl::recording::mapped_file>(path);
+    std::vector<const unsigned char *> frames;
+    {
+        rsimpl::recording::reader mapped_reader(mapping);
+        while (mapped_reader.next(r)) if (r.type == rsimpl::recording::record_type::frame) frames.push_back(r.payload + sizeof(rsimpl::recording::frame_record));
+    }
+    REQUIRE(frames.size() == 5);
+    for (int i = 0; i < 5; ++i)
+    {
+        REQUIRE(frames[i] >= mapping->get_data());
+        REQUIRE(frames[i] < mapping->get_data() + mapping->get_size());
+        REQUIRE(reinterpret_cast<const uint16_t *>(frames[i])[0] == i);
+    }
+    mapping.reset();
+    std::remove(path.c_str());
+}
+
+TEST_CASE( "recordings end with an index locating every frame", "[offline] [validation]" )
+{
+    using namespace rsimpl::recording;
+    const std::string path = "recording-index-test.bin", truncated_path = "recording-index-test-truncated.bin";
+    std::vector<uint16_t> frame(320 * 240);
+    const unsigned char transfer[] = { 1, 2, 3, 4, 5 };
+    {
+        writer writer(path, 2 * frame.size() * sizeof(uint16_t) + 4096, 4);
+        device_record device = { "Test Camera", "1234", "1.0" };
+        REQUIRE(writer.write_device(device));
+        REQUIRE(writer.write_mode({ 0, 320, 240, 0x20363159, 30, 0, {} }));
+        REQUIRE(writer.write_mode({ 1, 320, 240, 0x56595559, 30, 0, {} }));
+        for (int i = 0; i < 10; ++i)
+        {
+            for (int subdevice = 0; subdevice < 2; ++subdevice)
+            {
+                frame_record record = { subdevice, frame_encoding::raw, 100.0 + 33.3 * i, (uint64_t)(1000 * subdevice + i), 0, 0, 30 };
+                frame[0] = (uint16_t)(1000 * subdevice + i);
+                while (!writer.write_frame(record, frame.data(), frame.size() * sizeof(uint16_t))) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            motion_record motion = { 3, 0, 0 };
+            while (!writer.write_motion(motion, transfer, sizeof(transfer))) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Every record but the motion records after the first is indexed, and readers leave the index out
+    reader reader(path);
+    auto index = reader.read_index();
+    REQUIRE(index.size() == 1 + 2 + 20 + 1);
+    REQUIRE(index[0].type == record_type::device);
+    REQUIRE(index[2].type == record_type::mode);
+    REQUIRE(index[2].subdevice == 1);
+    REQUIRE(std::count_if(index.begin(), index.end(), [](const index_entry & e) { return e.type == record_type::motion; }) == 1);
+    record r;
+    int frames = 0;
+    while (reader.next(r)) frames += r.type == record_type::frame;
+    REQUIRE(frames == 20);
+
+    for (auto & entry : index)
+    {
+        if (entry.type != record_type::frame) continue;
+        reader.seek(entry);
+        REQUIRE(reader.next(r));
+        REQUIRE(r.type == record_type::frame);
+        auto & record = *reinterpret_cast<const frame_record *>(r.payload);
+        REQUIRE(record.subdevice == entry.subdevice);
+        REQUIRE(record.frame_counter == entry.frame_counter);
+        REQUIRE(record.timestamp == entry.timestamp);
+        REQUIRE(reinterpret_cast<const uint16_t *>(r.payload + sizeof(record))[0] == entry.frame_counter);
+    }
+
+    // Without the trailer, as when recording did not stop properly, the index is rebuilt by scanning the recording
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream(truncated_path, std::ios::binary).write(contents.data(), contents.size() - chunk_alignment);
+    }
+    auto mapping = std::make_shared<mapped_file>(truncated_path);
+    auto scanned = rsimpl::recording::reader(mapping).read_index();
+    REQUIRE(scanned.size() == index.size());
+    for (size_t i = 0; i < index.size(); ++i) REQUIRE(memcmp(&scanned[i], &index[i], sizeof(index_entry)) == 0);
+    mapping.reset();
+
+    std::remove(path.c_str());
+    std::remove(truncated_path.c_str());
+}
+
+TEST_CASE( "recordings encode depth frames losslessly", "[offline] [validation]" )
+{
+    const std::string path = "recording-depth-test.bin";
+    std::vector<uint16_t> frame(640 * 480);
+    for (size_t i = 0; i < frame.size(); ++i) frame[i] = i % 640 < 40 ? 0 : static_cast<uint16_t>(800 + i % 640 + i / 640);
+    {
+        rsimpl::recording::writer writer(path, RS_RECORDING_CHUNK_SIZE, 2);
+        rsimpl::recording::frame_record record = { 0, rsimpl::recording::frame_encoding::rvl, 0, 0, 0, 0, 30 };
+        REQUIRE(writer.write_frame(record, frame.data(), frame.size() * sizeof(uint16_t)));
+        writer.close();
+    }
+
+    rsimpl::recording::reader reader(path);
+    rsimpl::recording::record r;
+    REQUIRE(reader.next(r));
+    REQUIRE(r.type == rsimpl::recording::record_type::frame);
+    REQUIRE(reinterpret_cast<const rsimpl::recording::frame_record *>(r.payload)->encoding == rsimpl::recording::frame_encoding::rvl);
+    REQUIRE(r.size < sizeof(rsimpl::recording::frame_record) + frame.size() * sizeof(uint16_t) / 2);
+
+    std::vector<uint16_t> decoded(frame.size());
+    rsimpl::rvl_decode(decoded.data(), static_cast<int>(decoded.size()), r.payload + sizeof(rsimpl::recording::frame_record), r.size - sizeof(rsimpl::recording::frame_record));
+    REQUIRE(decoded == frame);
+    REQUIRE(!reader.next(r));
+    std::remove(path.c_str());
+}
+
+TEST_CASE( "frame histories keep the latest frames, compress depth and dump a window as a recording", "[offline] [validation]" )
+{
+    using namespace rsimpl::recording;
+    const int width = 64, height = 48;
+    const rs_intrinsics intrin = { width, height, 32.0f, 24.0f, 60.0f, 60.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rs_extrinsics identity = { { 1, 0, 0, 0, 1, 0, 0, 0, 1 }, { 0, 0, 0 } };
+    std::vector<mode_description> modes(2);
+    modes[0].mode = { 0, width, height, rsimpl::pf_z16.fourcc, 30, 0, intrin };
+    modes[0].streams.push_back({ RS_STREAM_DEPTH, RS_FORMAT_Z16, 30, intrin, identity, 0.001f });
+    modes[1].mode = { 1, width, height, rsimpl::pf_yuy2.fourcc, 30, 0, intrin };
+    modes[1].streams.push_back({ RS_STREAM_COLOR, RS_FORMAT_RGB8, 30, intrin, identity, 0.001f });
+
+    auto depth_frame = [&](int i) { std::vector<uint16_t> depth(width * height); for (int p = 0; p < width * height; ++p) depth[p] = p % width < 8 ? 0 : static_cast<uint16_t>(1000 + i + p / width); return depth; };
+    auto color_frame = [&](int i) { std::vector<uint16_t> color(width * height); for (int p = 0; p < width * height; ++p) color[p] = static_cast<uint16_t>(p * 31 + i); return color; };
+    const size_t frame_size = width * height * sizeof(uint16_t);
+    auto timestamp_of = [](int i) { return 1000.0 * i / 30; };
+
+    // Frames within the duration of the latest stay in the history, depth shrinking once compressed
+    {
+        rsimpl::frame_history history({ "Synthetic Camera", "0001", "1.0" }, 0.99, 1 << 30);
+        history.describe(modes);
+        for (int i = 0; i < 60; ++i)
+        {
+            const frame_record record = { 0, frame_encoding::raw, timestamp_of(i), (uint64_t)i, (int64_t)timestamp_of(i), 0, 30 };
+            history.push(record, true, depth_frame(i).data(), frame_size);
+            const frame_record color_record = { 1, frame_encoding::raw, timestamp_of(i), (uint64_t)i, (int64_t)timestamp_of(i), 0, 30 };
+            history.push(color_record, false, color_frame(i).data(), frame_size);
+        }
+        REQUIRE(history.get_frame_count() == 60); // Frames 30 to 59, within 990 ms of the latest
+        history.wait_for_compression();
+        REQUIRE(history.get_size() < 30 * frame_size + 30 * frame_size / 2);
+        REQUIRE(history.get_size() > 30 * frame_size);
+
+        const std::string path = "frame-history-test.bin";
+        REQUIRE(history.dump(path, timestamp_of(40), timestamp_of(44)) == 10);
+        reader r(path);
+        record rec;
+        REQUIRE(r.next(rec));
+        REQUIRE(rec.type == record_type::device);
+        int mode_count = 0, stream_count = 0, frame_count = 0;
+        while (r.next(rec))
+        {
+            if (rec.type == record_type::mode) ++mode_count;
+            if (rec.type == record_type::stream) ++stream_count;
+            if (rec.type != record_type::frame) continue;
+            REQUIRE(mode_count == 2); // Modes come before the frames
+            auto & frame = *reinterpret_cast<const frame_record *>(rec.payload);
+            const int i = 40 + frame_count / 2;
+            REQUIRE(frame.frame_counter == (uint64_t)i);
+            std::vector<uint16_t> pixels(width * height);
+            if (frame.subdevice == 0)
+            {
+                REQUIRE(frame.encoding == frame_encoding::rvl);
+                rsimpl::rvl_decode(pixels.data(), width * height, rec.payload + sizeof(frame), rec.size - sizeof(frame));
+                REQUIRE(pixels == depth_frame(i));
+            }
+            else
+            {
+                REQUIRE(frame.encoding == frame_encoding::raw); // Color stays in its native format
+                REQUIRE(rec.size == sizeof(frame) + frame_size);
+                memcpy(pixels.data(), rec.payload + sizeof(frame), frame_size);
+                REQUIRE(pixels == color_frame(i));
+            }
+            ++frame_count;
+        }
+        REQUIRE(stream_count == 2);
+        REQUIRE(frame_count == 10);
+        std::remove(path.c_str());
+    }
+
+    // The budget of bytes holds at every push, however far behind compression is
+    {
+        rsimpl::frame_history history({ "Synthetic Camera", "0001", "1.0" }, 60.0, 5 * frame_size);
+        history.describe(modes);
+        for (int i = 0; i < 40; ++i)
+        {
+            const frame_record record = { 0, frame_encoding::raw, timestamp_of(i), (uint64_t)i, (int64_t)timestamp_of(i), 0, 30 };
+            history.push(record, true, depth_frame(i).data(), frame_size);
+            REQUIRE(history.get_size() <= 5 * frame_size);
+            REQUIRE(history.get_frame_count() >= std::min<size_t>(i + 1, 5));
+        }
+        history.wait_for_compression();
+        REQUIRE(history.get_size() <= 5 * frame_size);
+    }
+}
+
+TEST_CASE( "rs_start_recording() and rs_stop_recording() validate input", "[offline] [validation]" )
+{
+    rs_start_recording(nullptr, "recording.bin", require_error("null pointer passed for argument \"device\""));
+    rs_start_recording(fake_object_pointer(), nullptr, require_error("null pointer passed for argument \"path\""));
+    rs_stop_recording(nullptr, require_error("null pointer passed for argument \"device\""));
+    REQUIRE(rs_get_recording_drops(nullptr, require_error("null pointer passed for argument \"device\"")) == 0);
+}
+
+TEST_CASE( "rs_start_frame_history() and rs_dump_frame_history() validate input", "[offline] [validation]" )
+{
+    rs_start_frame_history(nullptr, 10, 1 << 20, require_error("null pointer passed for argument \"device\""));
+    rs_start_frame_history(fake_object_pointer(), 0, 1 << 20, require_error("out of range value for argument \"seconds\""));
+    rs_start_frame_history(fake_object_pointer(), 10, 0, require_error("out of range value for argument \"max_bytes\""));
+    rs_stop_frame_history(nullptr, require_error("null pointer passed for argument \"device\""));
+    REQUIRE(rs_dump_frame_history(nullptr, "history.bin", 0, 100, 100, require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_dump_frame_history(fake_object_pointer(), nullptr, 0, 100, 100, require_error("null pointer passed for argument \"path\"")) == 0);
+    REQUIRE(rs_dump_frame_history(fake_object_pointer(), "history.bin", 0, -1, 100, require_error("out of range value for argument \"before\"")) == 0);
+    REQUIRE(rs_dump_frame_history(fake_object_pointer(), "history.bin", 0, 100, -1, require_error("out of range value for argument \"after\"")) == 0);
+    REQUIRE(rs_get_frame_history_size(nullptr, require_error("null pointer passed for argument \"device\"")) == 0);
+}
+
+#ifdef RS_USE_PLAYBACK_BACKEND
+// The devices of the playback backend replay recordings through the same capture, unpacking and synchronization as cameras, which lets
+// these tests hold the pipeline to its throughput without hardware. Synthetic recordings of depth and color frames stand in for real ones.
+namespace
+{
+    const int synthetic_width = 320, synthetic_height = 240, synthetic_fps = 30, synthetic_frame_count = 90;
+
+    void write_synthetic_recording(const std::string & path)
+    {
+        using namespace rsimpl::recording;
+        const rs_intrinsics intrin = { synthetic_width, synthetic_height, 160.0f, 120.0f, 300.0f, 300.0f, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+        const rs_extrinsics identity = { { 1, 0, 0, 0, 1, 0, 0, 0, 1 }, { 0, 0, 0 } };
+        std::vector<uint16_t> depth(synthetic_width * synthetic_height), color(synthetic_width * synthetic_height);
+        for (size_t i = 0; i < depth.size(); ++i) depth[i] = (uint16_t)(1000 + i % 1000);
+        for (size_t i = 0; i < color.size(); ++i) color[i] = (uint16_t)(0x8000 | i % 256);
+
+        writer writer(path, 4 * depth.size() * sizeof(uint16_t) + 4096, 8);
+        REQUIRE(writer.write_device({ "Synthetic Camera", "0001", "1.0" }));
+        REQUIRE(writer.write_mode({ 0, synthetic_width, synthetic_height, rsimpl::pf_z16.fourcc, synthetic_fps, 0, intrin }));
+        REQUIRE(writer.write_stream({ RS_STREAM_DEPTH, RS_FORMAT_Z16, synthetic_fps, intrin, identity, 0.001f }));
+        REQUIRE(writer.write_mode({ 1, synthetic_width, synthetic_height, rsimpl::pf_yuy2.fourcc, synthetic_fps, 0, intrin }));
+        REQUIRE(writer.write_stream({ RS_STREAM_COLOR, RS_FORMAT_RGB8, synthetic_fps, intrin, identity, 0.001f }));
+        for (int i = 0; i < synthetic_frame_count; ++i)
+        {
+            const double timestamp = 1000.0 * i / synthetic_fps;
+            const frame_record depth_record = { 0, frame_encoding::raw, timestamp, (uint64_t)i, (int64_t)timestamp, 0, synthetic_fps };
+            const frame_record color_record = { 1, frame_encoding::raw, timestamp, (uint64_t)i, (int64_t)timestamp, 0, synthetic_fps };
+            while (!writer.write_frame(depth_record, depth.data(), depth.size() * sizeof(uint16_t))) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            while (!writer.write_frame(color_record, color.data(), color.size() * sizeof(uint16_t))) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        writer.close();
+    }
+
+    // Names the recordings the devices of contexts created meanwhile replay, and removes them once done
+    class synthetic_playback
+    {
+        std::string path;
+    public:
+        explicit synthetic_playback(const std::string & path) : path(path)
+        {
+            write_synthetic_recording(path);
+#ifdef _WIN32
+            _putenv_s("RS_PLAYBACK_FILES", path.c_str());
+#else
+            setenv("RS_PLAYBACK_FILES", path.c_str(), 1);
+#endif
+        }
+        ~synthetic_playback()
+        {
+#ifdef _WIN32
+            _putenv_s("RS_PLAYBACK_FILES", "");
+#else
+            unsetenv("RS_PLAYBACK_FILES");
+#endif
+            std::remove(path.c_str());
+        }
+    };
+
+    // Frames whose time from dequeue to a stage, as of the latency histograms, is over a budget. Bin i counts those under 2^i microseconds.
+    unsigned long long count_frames_over_budget(rs_device * device, rs_stream stream, rs_frame_metadata stage, double budget_ms, unsigned long long & total)
+    {
+        unsigned long long counts[RS_LATENCY_HISTOGRAM_BIN_COUNT], over = 0;
+        rs_get_stream_latency_histogram(device, stream, stage, counts, require_no_error());
+        total = 0;
+        for (int i = 0; i < RS_LATENCY_HISTOGRAM_BIN_COUNT; ++i)
+        {
+            total += counts[i];
+            if ((1ull << i) / 1000.0 > budget_ms) over += counts[i];
+        }
+        return over;
+    }
+}
+
+TEST_CASE( "recorded frames reach frame callbacks in order, without drops and within budget", "[offline] [performance]" )
+{
+    synthetic_playback playback("pipeline-callback-test.bin");
+    {
+        safe_context ctx;
+        REQUIRE(rs_get_device_count(ctx, require_no_error()) == 1);
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_set_playback_pacing(device, RS_PLAYBACK_PACING_AS_FAST_AS_POSSIBLE, require_no_error());
+
+        struct delivery
+        {
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::vector<unsigned long long> numbers[RS_STREAM_NATIVE_COUNT];
+        } delivered;
+        auto on_frame = [](rs_device * device, rs_frame_ref * frame, void * user)
+        {
+            auto & delivered = *reinterpret_cast<delivery *>(user);
+            {
+                std::lock_guard<std::mutex> lock(delivered.mutex);
+                delivered.numbers[rs_get_detached_frame_stream_type(frame, nullptr)].push_back(rs_get_detached_frame_number(frame, nullptr));
+            }
+            delivered.cv.notify_all();
+            rs_release_frame(device, frame, nullptr);
+        };
+        for (auto stream : { RS_STREAM_DEPTH, RS_STREAM_COLOR })
+        {
+            rs_enable_stream(device, stream, synthetic_width, synthetic_height, stream == RS_STREAM_DEPTH ? RS_FORMAT_Z16 : RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+            rs_set_frame_callback(device, stream, on_frame, &delivered, require_no_error());
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        rs_start_device(device, require_no_error());
+        {
+            std::unique_lock<std::mutex> lock(delivered.mutex);
+            delivered.cv.wait_for(lock, std::chrono::seconds(30), [&]()
+            {
+                return delivered.numbers[RS_STREAM_DEPTH].size() == synthetic_frame_count && delivered.numbers[RS_STREAM_COLOR].size() == synthetic_frame_count;
+            });
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        rs_stop_device(device, require_no_error());
+
+        // Every frame is delivered once and in order, at least twice as fast as it was captured
+        for (auto stream : { RS_STREAM_DEPTH, RS_STREAM_COLOR })
+        {
+            auto & numbers = delivered.numbers[stream];
+            REQUIRE(numbers.size() == synthetic_frame_count);
+            for (int i = 0; i < synthetic_frame_count; ++i) REQUIRE(numbers[i] == (unsigned long long)i);
+        }
+        REQUIRE(synthetic_frame_count / seconds >= 2 * synthetic_fps);
+
+        // Nearly every frame is unpacked and handed to its callback within one frame interval of leaving the driver
+        for (auto stream : { RS_STREAM_DEPTH, RS_STREAM_COLOR })
+        {
+            for (auto stage : { RS_FRAME_METADATA_TIME_OF_COMMIT, RS_FRAME_METADATA_TIME_OF_DELIVERY })
+            {
+                unsigned long long total;
+                const auto over = count_frames_over_budget(device, stream, stage, 1000.0 / synthetic_fps, total);
+                REQUIRE(total == synthetic_frame_count);
+                REQUIRE(over * 20 <= total);
+            }
+
+            // Every frame delivered was timed from its exposure
+            unsigned long long counts[RS_LATENCY_HISTOGRAM_BIN_COUNT];
+            rs_get_stream_exposure_latency_histogram(device, stream, counts, require_no_error());
+            REQUIRE(std::accumulate(counts, counts + RS_LATENCY_HISTOGRAM_BIN_COUNT, 0ull) == synthetic_frame_count);
+        }
+
+        // The metrics account for every frame, and for the time spent unpacking color and running callbacks
+        for (auto stream : { RS_STREAM_DEPTH, RS_STREAM_COLOR })
+        {
+            REQUIRE(rs_get_stream_metric(device, stream, RS_STREAM_METRIC_FRAMES_RECEIVED, require_no_error()) == synthetic_frame_count);
+            REQUIRE(rs_get_stream_metric(device, stream, RS_STREAM_METRIC_FRAMES_INVALID, require_no_error()) == 0);
+            REQUIRE(rs_get_stream_metric(device, stream, RS_STREAM_METRIC_FRAMES_UNPUBLISHED, require_no_error()) == 0);
+            REQUIRE(rs_get_stream_metric(device, stream, RS_STREAM_METRIC_CALLBACK_NANOSECONDS, require_no_error()) > 0);
+        }
+        REQUIRE(rs_get_stream_metric(device, RS_STREAM_COLOR, RS_STREAM_METRIC_UNPACK_NANOSECONDS, require_no_error()) > 0);
+
+        // Replayed frames are counted as transferred, the raw color frames whole, and the encoded depth frames by their encoded size
+        for (auto stream : { RS_STREAM_DEPTH, RS_STREAM_COLOR })
+        {
+            REQUIRE(rs_get_transfer_statistic(device, stream, RS_TRANSFER_STATISTIC_FRAMES, require_no_error()) == synthetic_frame_count);
+            REQUIRE(rs_get_transfer_statistic(device, stream, RS_TRANSFER_STATISTIC_SHORT_FRAMES, require_no_error()) == 0);
+            REQUIRE(rs_get_transfer_statistic(device, stream, RS_TRANSFER_STATISTIC_ERRORS, require_no_error()) == 0);
+        }
+        REQUIRE(rs_get_transfer_statistic(device, RS_STREAM_COLOR, RS_TRANSFER_STATISTIC_BYTES, require_no_error()) == synthetic_frame_count * synthetic_width * synthetic_height * 2ull);
+        REQUIRE(rs_get_transfer_statistic(device, RS_STREAM_DEPTH, RS_TRANSFER_STATISTIC_BYTES, require_no_error()) > 0);
+    }
+}
+
+TEST_CASE( "recorded frames are unpacked into the buffers of the application given them", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-buffers-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_set_playback_pacing(device, RS_PLAYBACK_PACING_AS_FAST_AS_POSSIBLE, require_no_error());
+
+        // Depth needs no processing, and would otherwise be handed out in the memory the recording is mapped into
+        const int buffer_size = synthetic_width * synthetic_height * 2, buffer_count = 3;
+        std::vector<uint8_t> storage(buffer_count * buffer_size + 64);
+        auto first = storage.data() + (64 - reinterpret_cast<uintptr_t>(storage.data()) % 64) % 64;
+        void * buffers[buffer_count];
+        for (int i = 0; i < buffer_count; ++i) buffers[i] = first + i * buffer_size;
+        rs_set_stream_frame_buffers(device, RS_STREAM_DEPTH, buffers, buffer_count, buffer_size, require_no_error());
+
+        struct delivery
+        {
+            void ** buffers;
+            std::atomic<int> frames, in_buffers, misplaced;
+        } delivered = { buffers };
+        delivered.frames = delivered.in_buffers = delivered.misplaced = 0;
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_set_frame_callback(device, RS_STREAM_DEPTH, [](rs_device * device, rs_frame_ref * frame, void * user)
+        {
+            auto & delivered = *reinterpret_cast<delivery *>(user);
+            const int index = rs_get_detached_frame_buffer_index(frame, nullptr);
+            auto data = static_cast<const uint16_t *>(rs_get_detached_frame_data(frame, nullptr));
+            if (index >= 0)
+            {
+                ++delivered.in_buffers;
+                if (data != delivered.buffers[index] || data[0] != 1000 || data[999] != 1999) ++delivered.misplaced;
+            }
+            ++delivered.frames;
+            rs_release_frame(device, frame, nullptr);
+        }, &delivered, require_no_error());
+
+        rs_start_device(device, require_no_error());
+        for (int i = 0; i < 3000 && delivered.frames < synthetic_frame_count; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        rs_stop_device(device, require_no_error());
+
+        // Callbacks release their frame before the next one is unpacked, so a buffer is always free
+        REQUIRE(delivered.frames == synthetic_frame_count);
+        REQUIRE(delivered.in_buffers == synthetic_frame_count);
+        REQUIRE(delivered.misplaced == 0);
+    }
+}
+
+TEST_CASE( "depth frames of devices are fused into one point cloud of the rig", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-fusion-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        std::atomic<rs_frame_ref *> kept(nullptr);
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_set_frame_callback(device, RS_STREAM_DEPTH, [](rs_device * device, rs_frame_ref * frame, void * user)
+        {
+            rs_frame_ref * none = nullptr;
+            if (!reinterpret_cast<std::atomic<rs_frame_ref *> *>(user)->compare_exchange_strong(none, frame)) rs_release_frame(device, frame, nullptr);
+        }, &kept, require_no_error());
+        rs_start_device(device, require_no_error());
+        for (int i = 0; i < 3000 && !kept; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        REQUIRE(kept != nullptr);
+
+        // The one device stands in for two cameras of a rig, the second a meter to the right of the first
+        rs_device * devices[] = { device, device };
+        rs_frame_ref * frames[] = { kept, kept };
+        const rs_extrinsics poses[] = { { { 1, 0, 0, 0, 1, 0, 0, 0, 1 }, { 0, 0, 0 } }, { { 1, 0, 0, 0, 1, 0, 0, 0, 1 }, { 1, 0, 0 } } };
+        const int pixels = synthetic_width * synthetic_height;
+        std::vector<float> points(pixels * 2 * 3);
+        rs_fuse_point_clouds(devices, frames, poses, 2, 0, points.data(), pixels * 2 - 1, require_error("a capacity of 153599 points cannot hold the 153600 pixels of the depth frames"));
+        REQUIRE(rs_fuse_point_clouds(devices, frames, poses, 2, 0, points.data(), pixels * 2, require_no_error()) == pixels * 2);
+        REQUIRE(points[0] == Approx(-160.0f / 300));
+        REQUIRE(points[1] == Approx(-120.0f / 300));
+        REQUIRE(points[2] == Approx(1.0f));
+        REQUIRE(points[pixels * 3] == Approx(1 - 160.0f / 300));
+        REQUIRE(points[pixels * 3 + 2] == Approx(1.0f));
+
+        const int merged = rs_fuse_point_clouds(devices, frames, poses, 2, 0.1f, points.data(), pixels * 2, require_no_error());
+        REQUIRE(merged > 0);
+        REQUIRE(merged < pixels);
+
+        rs_release_frame(device, kept, require_no_error());
+        rs_stop_device(device, require_no_error());
+    }
+}
+
+TEST_CASE( "the frame pools grow to let the application hold more frames than before", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-frame-pool-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_set_device_option(device, RS_OPTION_FRAMES_QUEUE_SIZE, 1001, require_error("frames queue size must be between 1 and 1000"));
+        rs_set_device_option(device, RS_OPTION_FRAMES_QUEUE_SIZE, 64, require_no_error());
+
+        struct holder
+        {
+            std::mutex mutex;
+            std::vector<rs_frame_ref *> frames;
+            bool full = false;
+        } held;
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_set_frame_callback(device, RS_STREAM_DEPTH, [](rs_device * device, rs_frame_ref * frame, void * user)
+        {
+            auto & held = *reinterpret_cast<holder *>(user);
+            std::lock_guard<std::mutex> lock(held.mutex);
+            if (held.full) rs_release_frame(device, frame, nullptr);
+            else held.frames.push_back(frame);
+        }, &held, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_set_device_option(device, RS_OPTION_FRAMES_QUEUE_SIZE, 65, require_error("frames queue size cannot be raised above 64, the size of the frame pools, after having called rs_start_device()"));
+        rs_set_device_option(device, RS_OPTION_FRAMES_QUEUE_SIZE, 63, require_no_error());
+        rs_set_device_option(device, RS_OPTION_FRAMES_QUEUE_SIZE, 64, require_no_error());
+        for (int i = 0; i < 3000; ++i)
+        {
+            {
+                std::lock_guard<std::mutex> lock(held.mutex);
+                if (held.frames.size() >= 60) break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        // Three times the frames the fixed pools held, every one still intact
+        std::vector<rs_frame_ref *> frames;
+        {
+            std::lock_guard<std::mutex> lock(held.mutex);
+            held.full = true;
+            frames.swap(held.frames);
+        }
+        REQUIRE(frames.size() >= 60);
+        for (auto frame : frames)
+        {
+            auto data = static_cast<const uint16_t *>(rs_get_detached_frame_data(frame, require_no_error()));
+            REQUIRE(data[0] == 1000);
+            REQUIRE(data[999] == 1999);
+        }
+        for (auto frame : frames) rs_release_frame(device, frame, require_no_error());
+        rs_stop_device(device, require_no_error());
+    }
+}
+
+TEST_CASE( "derived streams are only computed on the GPU by libraries built with CUDA", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-gpu-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_set_device_option(device, RS_OPTION_GPU_PROCESSING_ENABLED, 2, require_error("GPU processing must be 0 (disabled) or 1 (enabled)"));
+#ifndef RS_USE_CUDA
+        rs_set_device_option(device, RS_OPTION_GPU_PROCESSING_ENABLED, 1, require_error("GPU processing requires a library built with BUILD_WITH_CUDA and a CUDA device"));
+#endif
+        rs_set_device_option(device, RS_OPTION_GPU_PROCESSING_ENABLED, 0, require_no_error());
+        REQUIRE(rs_get_device_option(device, RS_OPTION_GPU_PROCESSING_ENABLED, require_no_error()) == 0);
+    }
+}
+
+TEST_CASE( "the rows of derived streams are aligned to a power of two", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-row-alignment-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        REQUIRE(rs_get_device_option(device, RS_OPTION_DERIVED_ROW_ALIGNMENT, require_no_error()) == 0);
+        rs_set_device_option(device, RS_OPTION_DERIVED_ROW_ALIGNMENT, 24, require_error("the row alignment of derived streams must be 0 or a power of two up to 64"));
+        rs_set_device_option(device, RS_OPTION_DERIVED_ROW_ALIGNMENT, 128, require_error("the row alignment of derived streams must be 0 or a power of two up to 64"));
+        rs_set_device_option(device, RS_OPTION_DERIVED_ROW_ALIGNMENT, 32, require_no_error());
+        REQUIRE(rs_get_device_option(device, RS_OPTION_DERIVED_ROW_ALIGNMENT, require_no_error()) == 32);
+    }
+}
+
+TEST_CASE( "frame memory reports the huge pages it got while streaming", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-huge-pages-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_set_device_option(device, RS_OPTION_FRAME_MEMORY_PAGES, 3, require_error("frame memory pages must be 0 for the heap, 1 for transparent huge pages or 2 for explicit huge pages"));
+        rs_set_device_option(device, RS_OPTION_FRAME_MEMORY_PAGES, 2, require_no_error());
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_wait_for_frames(device, require_no_error());
+        REQUIRE(rs_get_frame_data(device, RS_STREAM_POINTS, require_no_error()) != nullptr);
+
+        // The system may have no huge page reserved, and then the frames fall back to smaller pages
+        const double provided = rs_get_device_option(device, RS_OPTION_FRAME_MEMORY_PAGES, require_no_error());
+        REQUIRE(provided >= 0);
+        REQUIRE(provided <= 2);
+        rs_set_device_option(device, RS_OPTION_FRAME_MEMORY_PAGES, 0, require_error("frame memory pages cannot be changed after having called rs_start_device()"));
+        rs_stop_device(device, require_no_error());
+        REQUIRE(rs_get_device_option(device, RS_OPTION_FRAME_MEMORY_PAGES, require_no_error()) == 2);
+    }
+}
+
+TEST_CASE( "devices on an unknown NUMA node stream as usual", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-numa-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_set_device_option(device, RS_OPTION_NUMA_LOCALITY_ENABLED, 2, require_error("NUMA locality must be 0 (disabled) or 1 (enabled)"));
+        rs_set_device_option(device, RS_OPTION_NUMA_LOCALITY_ENABLED, 1, require_no_error());
+        rs_set_device_option(device, RS_OPTION_FRAME_UNPACK_THREADS, 2, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_wait_for_frames(device, require_no_error());
+        REQUIRE(rs_get_frame_data(device, RS_STREAM_COLOR, require_no_error()) != nullptr);
+        rs_set_device_option(device, RS_OPTION_NUMA_LOCALITY_ENABLED, 0, require_error("NUMA locality cannot be changed after having called rs_start_device()"));
+        rs_stop_device(device, require_no_error());
+        REQUIRE(rs_get_device_option(device, RS_OPTION_NUMA_LOCALITY_ENABLED, require_no_error()) == 1);
+    }
+}
+
+TEST_CASE( "color streams can be unpacked into NV12 and I420 images", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-yuv420-test.bin");
+    for (auto format : { RS_FORMAT_NV12, RS_FORMAT_I420 })
+    {
+        INFO(rs_format_to_string(format));
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_set_device_option(device, RS_OPTION_FRAME_UNPACK_THREADS, 2, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, format, synthetic_fps, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_wait_for_frames(device, require_no_error());
+        REQUIRE(rs_get_stream_format(device, RS_STREAM_COLOR, require_no_error()) == format);
+
+        // Synthetic color has the luminance of its pixel index and neutral chroma
+        auto image = reinterpret_cast<const uint8_t *>(rs_get_frame_data(device, RS_STREAM_COLOR, require_no_error()));
+        REQUIRE(image != nullptr);
+        const int pixels = synthetic_width * synthetic_height;
+        for (int i = 0; i < pixels; ++i) REQUIRE(image[i] == i % 256);
+        for (int i = pixels; i < pixels * 3 / 2; ++i) REQUIRE(image[i] == 128);
+        rs_stop_device(device, require_no_error());
+    }
+}
+
+TEST_CASE( "color streams are only encoded by libraries built with FFmpeg", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-encoder-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        auto on_packet = [](rs_device *, rs_stream, rs_encoded_packet, void *) {};
+        if (rsimpl::video::is_available())
+        {
+            // Encoders take the 4:2:0 frames unpacked for the stream, checked as the device starts
+            rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+            rs_set_stream_encoder(device, RS_STREAM_COLOR, 4000000, on_packet, nullptr, require_no_error());
+            rs_start_device(device, require_error("only streams in NV12 or I420 can be encoded, COLOR is RGB8"));
+        }
+        else
+        {
+            rs_set_stream_encoder(device, RS_STREAM_COLOR, 4000000, on_packet, nullptr, require_error("encoding requires a library built with BUILD_WITH_FFMPEG"));
+        }
+
+        // Without an encoder, the stream is delivered as usual
+        rs_set_stream_encoder(device, RS_STREAM_COLOR, 0, nullptr, nullptr, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_NV12, synthetic_fps, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_wait_for_frames(device, require_no_error());
+        rs_set_stream_encoder(device, RS_STREAM_COLOR, 4000000, nullptr, nullptr, require_error("encoders cannot be changed after having called rs_start_device()"));
+        rs_stop_device(device, require_no_error());
+    }
+}
+
+TEST_CASE( "precomputed streams are computed in parallel along with every frameset", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-precompute-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        const rs_stream derived[] = { RS_STREAM_POINTS, RS_STREAM_COLOR_ALIGNED_TO_DEPTH, RS_STREAM_DEPTH_ALIGNED_TO_COLOR, RS_STREAM_DEPTH_COLORIZED };
+        int mask = 0;
+        for (auto stream : derived) mask |= 1 << (stream - RS_STREAM_NATIVE_COUNT);
+        rs_set_device_option(device, RS_OPTION_PRECOMPUTED_STREAMS, mask, require_no_error());
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        rs_start_device(device, require_no_error());
+
+        // Framesets are handed out in order, each with the derived frames computed from its own frames
+        unsigned long long last_number = 0;
+        for (int i = 0; i < 20; ++i)
+        {
+            rs_wait_for_frames(device, require_no_error());
+            const auto number = rs_get_frame_number(device, RS_STREAM_DEPTH, require_no_error());
+            if (i) REQUIRE(number > last_number);
+            last_number = number;
+            for (auto stream : derived)
+            {
+                REQUIRE(rs_get_frame_data(device, stream, require_no_error()) != nullptr);
+                REQUIRE(rs_get_frame_number(device, stream, require_no_error()) == number);
+            }
+        }
+        rs_stop_device(device, require_no_error());
+    }
+}
+
+TEST_CASE( "option transactions write the latest value of every option on commit", "[offline] [validation]" )
+{
+    synthetic_playback playback("option-transaction-test.bin");
+    safe_context ctx;
+    rs_device * device = rs_get_device(ctx, 0, require_no_error());
+    rs_commit_device_options(device, require_error("no option transaction is open"));
+
+    rs_begin_device_options(device, require_no_error());
+    rs_begin_device_options(device, require_error("an option transaction is already open"));
+    const rs_option options[] = { RS_OPTION_FRAME_MAILBOX_ENABLED, RS_OPTION_FRAMES_QUEUE_SIZE };
+    const double values[] = { 1, 5 };
+    rs_set_device_options(device, options, 2, values, require_no_error());
+    rs_set_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, 2, require_no_error()); // Invalid, but only checked on commit
+    rs_set_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, 0, require_no_error());
+    rs_set_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, 1, require_no_error());
+    REQUIRE(rs_get_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, require_no_error()) == 0);
+    rs_commit_device_options(device, require_no_error());
+    REQUIRE(rs_get_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, require_no_error()) == 1);
+    REQUIRE(rs_get_device_option(device, RS_OPTION_FRAMES_QUEUE_SIZE, require_no_error()) == 5);
+
+    // A failing commit still closes the transaction
+    rs_begin_device_options(device, require_no_error());
+    rs_set_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, 2, require_no_error());
+    rs_commit_device_options(device, require_error("frame mailboxes must be 0 (disabled) or 1 (enabled)"));
+    rs_commit_device_options(device, require_error("no option transaction is open"));
+    rs_set_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, 0, require_no_error());
+    REQUIRE(rs_get_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, require_no_error()) == 0);
+}
+
+TEST_CASE( "mailboxes hand out the latest frame of every stream without blocking", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-mailbox-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        REQUIRE(rs_get_latest_frame(device, RS_STREAM_DEPTH, require_error("latest frames are only kept with RS_OPTION_FRAME_MAILBOX_ENABLED")) == nullptr);
+        rs_set_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, 2, require_error("frame mailboxes must be 0 (disabled) or 1 (enabled)"));
+        rs_set_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, 1, require_no_error());
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_set_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, 0, require_error("frame mailboxes cannot be enabled or disabled after having called rs_start_device()"));
+
+        // Frames only ever move forward, and every frame is taken at most once
+        long long last[RS_STREAM_NATIVE_COUNT] = { -1, -1, -1, -1, -1 };
+        int taken[RS_STREAM_NATIVE_COUNT] = {};
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while ((taken[RS_STREAM_DEPTH] < 5 || taken[RS_STREAM_COLOR] < 5) && std::chrono::steady_clock::now() < deadline)
+        {
+            for (auto stream : { RS_STREAM_DEPTH, RS_STREAM_COLOR })
+            {
+                auto frame = rs_get_latest_frame(device, stream, require_no_error());
+                if (!frame) continue;
+                REQUIRE(rs_get_detached_frame_stream_type(frame, require_no_error()) == stream);
+                REQUIRE(rs_get_detached_frame_data(frame, require_no_error()) != nullptr);
+                int pixel_stride = 0, row_stride = 0; // Frames unpacked by the library are packed
+                REQUIRE(rs_get_detached_frame_strided_data(frame, &pixel_stride, &row_stride, require_no_error()) == rs_get_detached_frame_data(frame, require_no_error()));
+                REQUIRE(pixel_stride == rs_get_detached_frame_bpp(frame, require_no_error()) / 8);
+                REQUIRE(row_stride == rs_get_detached_frame_stride(frame, require_no_error()));
+                const auto number = (long long)rs_get_detached_frame_number(frame, require_no_error());
+                REQUIRE(number > last[stream]);
+                last[stream] = number;
+                ++taken[stream];
+                rs_release_frame(device, frame, require_no_error());
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(taken[RS_STREAM_DEPTH] >= 5);
+        REQUIRE(taken[RS_STREAM_COLOR] >= 5);
+        REQUIRE(!rs_poll_for_frames(device, require_no_error())); // Nothing is queued for framesets
+        rs_stop_device(device, require_no_error());
+        REQUIRE(rs_get_latest_frame(device, RS_STREAM_DEPTH, require_no_error()) == nullptr);
+        REQUIRE(rs_get_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, require_no_error()) == 1);
+    }
+}
+
+TEST_CASE( "streams on demand only run while their frames are consumed", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-demand-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        rs_set_stream_idle_timeout(device, RS_STREAM_COLOR, 200, require_no_error());
+        REQUIRE(rs_get_stream_idle_timeout(device, RS_STREAM_COLOR, require_no_error()) == 200);
+        REQUIRE(rs_get_stream_idle_timeout(device, RS_STREAM_DEPTH, require_no_error()) == 0);
+        rs_start_device(device, require_no_error());
+        rs_set_stream_idle_timeout(device, RS_STREAM_COLOR, 100, require_error("idle timeouts cannot be changed after having called rs_start_device()"));
+
+        // Color stays off until it is read, framesets are formed on depth meanwhile
+        REQUIRE(rs_is_stream_idle(device, RS_STREAM_COLOR, require_no_error()) == 1);
+        REQUIRE(rs_is_stream_idle(device, RS_STREAM_DEPTH, require_no_error()) == 0);
+        for (int i = 0; i < 5; ++i)
+        {
+            rs_wait_for_frames(device, require_no_error());
+            REQUIRE(rs_get_frame_data(device, RS_STREAM_DEPTH, require_no_error()) != nullptr);
+        }
+        REQUIRE(rs_get_stream_metric(device, RS_STREAM_COLOR, RS_STREAM_METRIC_FRAMES_RECEIVED, require_no_error()) == 0);
+        REQUIRE(rs_get_stream_metric(device, RS_STREAM_DEPTH, RS_STREAM_METRIC_FRAMES_RECEIVED, require_no_error()) >= 5);
+
+        // Reading color turns it on, its frames joining the framesets once they arrive
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (rs_get_stream_metric(device, RS_STREAM_COLOR, RS_STREAM_METRIC_FRAMES_RECEIVED, require_no_error()) < 3 && std::chrono::steady_clock::now() < deadline)
+        {
+            rs_wait_for_frames(device, require_no_error());
+            REQUIRE(rs_get_frame_data(device, RS_STREAM_COLOR, require_no_error()) != nullptr);
+        }
+        REQUIRE(rs_is_stream_idle(device, RS_STREAM_COLOR, require_no_error()) == 0);
+        REQUIRE(rs_get_stream_metric(device, RS_STREAM_COLOR, RS_STREAM_METRIC_FRAMES_RECEIVED, require_no_error()) >= 3);
+
+        // Left unread for its timeout, color is turned off again while depth streams on
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!rs_is_stream_idle(device, RS_STREAM_COLOR, require_no_error()) && std::chrono::steady_clock::now() < deadline) rs_wait_for_frames(device, require_no_error());
+        REQUIRE(rs_is_stream_idle(device, RS_STREAM_COLOR, require_no_error()) == 1);
+        const auto received = rs_get_stream_metric(device, RS_STREAM_COLOR, RS_STREAM_METRIC_FRAMES_RECEIVED, require_no_error());
+        for (int i = 0; i < 5; ++i) rs_wait_for_frames(device, require_no_error());
+        REQUIRE(rs_get_stream_metric(device, RS_STREAM_COLOR, RS_STREAM_METRIC_FRAMES_RECEIVED, require_no_error()) <= received + 1); // A frame already on its way
+        rs_stop_device(device, require_no_error());
+        REQUIRE(rs_is_stream_idle(device, RS_STREAM_COLOR, require_no_error()) == 0);
+    }
+}
+
+TEST_CASE( "devices shed load while their frames are not consumed", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-shedding-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        const rs_load_shedding_action duplicated[] = { RS_LOAD_SHEDDING_ACTION_DECIMATE_FRAMERATE, RS_LOAD_SHEDDING_ACTION_DECIMATE_FRAMERATE };
+        rs_set_load_shedding(device, duplicated, 2, require_error("load shedding action DECIMATE_FRAMERATE is listed more than once"));
+        const rs_load_shedding_action actions[] = { RS_LOAD_SHEDDING_ACTION_SKIP_CULLED_UNPACKING, RS_LOAD_SHEDDING_ACTION_DECIMATE_FRAMERATE };
+        rs_set_load_shedding(device, actions, 2, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_set_load_shedding(device, actions, 1, require_error("load shedding cannot be changed after having called rs_start_device()"));
+
+        // Left unread, the queues fill up, after which new frames are released without being unpacked, then every other frame
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (rs_get_stream_metric(device, RS_STREAM_DEPTH, RS_STREAM_METRIC_FRAMES_DECIMATED, require_no_error()) == 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        REQUIRE(rs_get_load_shedding_level(device, require_no_error()) == 2);
+        for (auto stream : { RS_STREAM_DEPTH, RS_STREAM_COLOR })
+        {
+            REQUIRE(rs_get_stream_metric(device, stream, RS_STREAM_METRIC_UNPACKS_SHED, require_no_error()) > 0);
+            REQUIRE(rs_get_stream_metric(device, stream, RS_STREAM_METRIC_FRAMES_DECIMATED, require_no_error()) > 0);
+            REQUIRE(rs_get_stream_metric(device, stream, RS_STREAM_METRIC_QUEUED_FRAMES, require_no_error()) <= (unsigned long long)RS_DEFAULT_STREAM_QUEUE_DEPTH * 2);
+            REQUIRE(rs_get_stream_metric(device, stream, RS_STREAM_METRIC_DERIVED_FRAMES_SHED, require_no_error()) == 0);
+        }
+
+        // Once the application keeps up, the actions are dropped one at a time
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (rs_get_load_shedding_level(device, require_no_error()) && std::chrono::steady_clock::now() < deadline)
+        {
+            rs_poll_for_frames(device, require_no_error());
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(rs_get_load_shedding_level(device, require_no_error()) == 0);
+        rs_stop_device(device, require_no_error());
+    }
+}
+
+TEST_CASE( "captures whose every stream has a frame callback keep no synchronization state", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-callbacks-only-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        std::atomic<int> delivered[RS_STREAM_NATIVE_COUNT] = {};
+        auto on_frame = [](rs_device * device, rs_frame_ref * frame, void * user)
+        {
+            ++reinterpret_cast<std::atomic<int> *>(user)[rs_get_detached_frame_stream_type(frame, nullptr)];
+            rs_release_frame(device, frame, nullptr);
+        };
+        for (auto stream : { RS_STREAM_DEPTH, RS_STREAM_COLOR })
+        {
+            rs_enable_stream(device, stream, synthetic_width, synthetic_height, stream == RS_STREAM_DEPTH ? RS_FORMAT_Z16 : RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+            rs_set_frame_callback(device, stream, on_frame, delivered, require_no_error());
+        }
+        rs_start_device(device, require_no_error());
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while ((delivered[RS_STREAM_DEPTH] < 5 || delivered[RS_STREAM_COLOR] < 5) && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(delivered[RS_STREAM_DEPTH] >= 5);
+        REQUIRE(delivered[RS_STREAM_COLOR] >= 5);
+
+        // No frameset is ever formed, waiting for one returns at once
+        REQUIRE(!rs_poll_for_frames(device, require_no_error()));
+        rs_wait_for_frames(device, require_no_error());
+        REQUIRE(rs_get_frame_data(device, RS_STREAM_DEPTH, require_error("streaming not started!")) == nullptr);
+        for (auto stream : { RS_STREAM_DEPTH, RS_STREAM_COLOR })
+        {
+            REQUIRE(rs_get_stream_metric(device, stream, RS_STREAM_METRIC_QUEUED_FRAMES, require_no_error()) == 0);
+        }
+        rs_stop_device(device, require_no_error());
+    }
+}
+
+TEST_CASE( "devices account their frame memory and keep fewer frames over budget", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-memory-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        REQUIRE(rs_get_memory_budget(device, require_no_error()) == 0);
+        rs_start_device(device, require_no_error());
+
+        for (int i = 0; i < 5; ++i) rs_wait_for_frames(device, require_no_error());
+        REQUIRE(rs_get_frame_data(device, RS_STREAM_DEPTH_ALIGNED_TO_COLOR, require_no_error()) != nullptr);
+        unsigned long long current = 0, peak = 0;
+        rs_get_memory_usage(device, &current, &peak, require_no_error());
+        REQUIRE(current >= (unsigned long long)synthetic_width * synthetic_height * 2); // The aligned image at least
+        REQUIRE(peak >= current);
+
+        // A budget nothing fits in, set while streaming, bounds the frames queued for the application not reading them
+        rs_set_memory_budget(device, 1, require_no_error());
+        REQUIRE(rs_get_memory_budget(device, require_no_error()) == 1);
+        const auto received = rs_get_stream_metric(device, RS_STREAM_DEPTH, RS_STREAM_METRIC_FRAMES_RECEIVED, require_no_error());
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (rs_get_stream_metric(device, RS_STREAM_DEPTH, RS_STREAM_METRIC_FRAMES_RECEIVED, require_no_error()) < received + 2 * RS_DEFAULT_STREAM_QUEUE_DEPTH && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        rs_wait_for_frames(device, require_no_error());
+        for (auto stream : { RS_STREAM_DEPTH, RS_STREAM_COLOR })
+        {
+            REQUIRE(rs_get_stream_metric(device, stream, RS_STREAM_METRIC_QUEUED_FRAMES, require_no_error()) <= (unsigned long long)RS_OVER_BUDGET_QUEUE_SIZE);
+        }
+        unsigned long long over_budget = 0, later_peak = 0;
+        rs_get_memory_usage(device, &over_budget, &later_peak, require_no_error());
+        REQUIRE(later_peak >= peak);
+        rs_stop_device(device, require_no_error());
+        rs_set_memory_budget(device, 0, require_no_error());
+    }
+}
+
+TEST_CASE( "frames are only handed out in driver memory once zero-copy delivery is enabled", "[offline] [validation]" )
+{
+    // YUYV color is passed through. Copied out of the driver buffers, its frames reuse the few buffers of the frame pool, while left in place,
+    // they point into the mapping of the recording.
+    size_t distinct[2] = {};
+    for (int zero_copy = 0; zero_copy < 2; ++zero_copy)
+    {
+        synthetic_playback playback("pipeline-zero-copy-test.bin");
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        REQUIRE(rs_get_device_option(device, RS_OPTION_ZERO_COPY_ENABLED, require_no_error()) == 0);
+        rs_set_device_option(device, RS_OPTION_ZERO_COPY_ENABLED, 2, require_error("zero-copy delivery must be 0 (disabled) or 1 (enabled)"));
+        rs_set_device_option(device, RS_OPTION_ZERO_COPY_ENABLED, zero_copy, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_YUYV, synthetic_fps, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_set_device_option(device, RS_OPTION_ZERO_COPY_ENABLED, 1 - zero_copy, require_error("zero-copy delivery cannot be enabled or disabled after having called rs_start_device()"));
+        std::set<const void *> pointers;
+        for (int i = 0; i < 30; ++i)
+        {
+            rs_wait_for_frames(device, require_no_error());
+            pointers.insert(rs_get_frame_data(device, RS_STREAM_COLOR, require_no_error()));
+        }
+        distinct[zero_copy] = pointers.size();
+        rs_stop_device(device, require_no_error());
+    }
+    REQUIRE(distinct[0] < 30);
+    REQUIRE(distinct[1] == 30);
+}
+
+TEST_CASE( "depth frames carry the levels of their pyramid", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-pyramid-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_set_device_option(device, RS_OPTION_DEPTH_PYRAMID_LEVELS, RS_MAX_DEPTH_PYRAMID_LEVELS + 1, require_error("depth pyramid levels must be between 0 and 4"));
+        rs_set_device_option(device, RS_OPTION_DEPTH_PYRAMID_LEVELS, 2, require_no_error());
+        rs_set_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, 1, require_no_error());
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_set_device_option(device, RS_OPTION_DEPTH_PYRAMID_LEVELS, 1, require_error("depth pyramid levels cannot be changed after having called rs_start_device()"));
+
+        rs_frame_ref * frame = nullptr;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!frame && std::chrono::steady_clock::now() < deadline)
+        {
+            frame = rs_get_latest_frame(device, RS_STREAM_DEPTH, require_no_error());
+            if (!frame) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(frame != nullptr);
+
+        // Level 0 is the frame itself, every level after it reduces the one before, with the intrinsics of the pixels it holds
+        int width = 0, height = 0;
+        REQUIRE(rs_get_detached_frame_pyramid_level(frame, 0, &width, &height, require_no_error()) == rs_get_detached_frame_data(frame, require_no_error()));
+        REQUIRE(width == synthetic_width);
+        REQUIRE(height == synthetic_height);
+        auto pixels = static_cast<const uint16_t *>(rs_get_detached_frame_data(frame, require_no_error()));
+        std::vector<uint16_t> level(pixels, pixels + width * height);
+        rs_intrinsics depth_intrin;
+        rs_get_stream_intrinsics(device, RS_STREAM_DEPTH, &depth_intrin, require_no_error());
+        for (int k = 1; k <= 2; ++k)
+        {
+            level = reduce_depth(level, width, height);
+            pixels = static_cast<const uint16_t *>(rs_get_detached_frame_pyramid_level(frame, k, &width, &height, require_no_error()));
+            REQUIRE(pixels != nullptr);
+            REQUIRE(width == synthetic_width >> k);
+            REQUIRE(height == synthetic_height >> k);
+            REQUIRE(std::vector<uint16_t>(pixels, pixels + width * height) == level);
+
+            rs_intrinsics intrin;
+            rs_get_depth_pyramid_intrinsics(device, k, &intrin, require_no_error());
+            const auto expected = rsimpl::decimate_intrinsics(depth_intrin, 1 << k);
+            REQUIRE(intrin.ppx == expected.ppx);
+            REQUIRE(intrin.fy == expected.fy);
+            REQUIRE(intrin.width == width);
+            REQUIRE(intrin.height == height);
+        }
+        REQUIRE(rs_get_detached_frame_pyramid_level(frame, 3, &width, &height, require_no_error()) == nullptr);
+        REQUIRE(width == 0);
+        rs_release_frame(device, frame, require_no_error());
+
+        // Other streams carry no pyramid
+        frame = nullptr;
+        while (!frame && std::chrono::steady_clock::now() < deadline)
+        {
+            frame = rs_get_latest_frame(device, RS_STREAM_COLOR, require_no_error());
+            if (!frame) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(frame != nullptr);
+        REQUIRE(rs_get_detached_frame_pyramid_level(frame, 1, &width, &height, require_no_error()) == nullptr);
+        rs_release_frame(device, frame, require_no_error());
+        rs_stop_device(device, require_no_error());
+    }
+}
+
+TEST_CASE( "depth frames carry the runs of their valid pixels, which point clouds follow", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-depth-runs-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_set_device_option(device, RS_OPTION_DEPTH_RUNS_ENABLED, 2, require_error("depth runs must be 0 (disabled) or 1 (enabled)"));
+        rs_set_device_option(device, RS_OPTION_DEPTH_RUNS_ENABLED, 1, require_no_error());
+        rs_set_device_option(device, RS_OPTION_DEPTH_PYRAMID_LEVELS, 1, require_no_error());
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_set_device_option(device, RS_OPTION_DEPTH_RUNS_ENABLED, 0, require_error("depth runs cannot be enabled or disabled after having called rs_start_device()"));
+        REQUIRE(rs_get_device_option(device, RS_OPTION_DEPTH_RUNS_ENABLED, require_no_error()) == 1);
+
+        // The points computed by following the runs are those of every pixel
+        rs_wait_for_frames(device, require_no_error());
+        auto pixels = static_cast<const uint16_t *>(rs_get_frame_data(device, RS_STREAM_DEPTH, require_no_error()));
+        rs_intrinsics depth_intrin;
+        rs_get_stream_intrinsics(device, RS_STREAM_DEPTH, &depth_intrin, require_no_error());
+        std::vector<float> expected(synthetic_width * synthetic_height * 3);
+        rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(expected.data()), RS_FORMAT_XYZ32F, rsimpl::compute_deprojection_table(depth_intrin), pixels, rs_get_device_depth_scale(device, require_no_error()));
+        auto points = static_cast<const float *>(rs_get_frame_data(device, RS_STREAM_POINTS, require_no_error()));
+        REQUIRE(std::equal(expected.begin(), expected.end(), points));
+        rs_stop_device(device, require_no_error());
+
+        rs_set_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, 1, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_frame_ref * frame = nullptr;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!frame && std::chrono::steady_clock::now() < deadline)
+        {
+            frame = rs_get_latest_frame(device, RS_STREAM_DEPTH, require_no_error());
+            if (!frame) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(frame != nullptr);
+        const unsigned short * runs = nullptr;
+        const unsigned int * row_runs = rs_get_detached_frame_depth_runs(frame, &runs, require_no_error());
+        REQUIRE(row_runs != nullptr);
+        REQUIRE(runs != nullptr);
+
+        // Every pixel with data is in exactly one run, and none without is
+        pixels = static_cast<const uint16_t *>(rs_get_detached_frame_data(frame, require_no_error()));
+        std::vector<uint16_t> covered(synthetic_width * synthetic_height, 0);
+        for (int y = 0; y < synthetic_height; ++y)
+        {
+            for (unsigned int r = row_runs[y]; r < row_runs[y + 1]; ++r)
+            {
+                for (int x = runs[r * 2]; x < runs[r * 2] + runs[r * 2 + 1]; ++x) covered[y * synthetic_width + x] += pixels[y * synthetic_width + x];
+            }
+        }
+        REQUIRE(std::equal(covered.begin(), covered.end(), pixels));
+        for (unsigned int r = 0; r < row_runs[synthetic_height]; ++r) REQUIRE(runs[r * 2 + 1] > 0);
+        rs_release_frame(device, frame, require_no_error());
+
+        // Other streams carry no runs
+        frame = nullptr;
+        while (!frame && std::chrono::steady_clock::now() < deadline)
+        {
+            frame = rs_get_latest_frame(device, RS_STREAM_COLOR, require_no_error());
+            if (!frame) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(frame != nullptr);
+        REQUIRE(rs_get_detached_frame_depth_runs(frame, &runs, require_no_error()) == nullptr);
+        REQUIRE(runs == nullptr);
+        rs_release_frame(device, frame, require_no_error());
+        rs_stop_device(device, require_no_error());
+    }
+}
+
+TEST_CASE( "cropped streams deliver a window of their frames, cropped before they cross the bus where the driver can", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-crop-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_set_stream_crop(device, RS_STREAM_DEPTH, -2, 0, 100, 60, require_error("crops must have a positive size at non-negative coordinates"));
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        rs_set_stream_crop(device, RS_STREAM_DEPTH, 300, 30, 100, 60, require_no_error());
+        rs_start_device(device, require_error("crop 100x60 at 300,30 does not lie within the 320x240 image of DEPTH"));
+        rs_set_stream_crop(device, RS_STREAM_DEPTH, 41, 30, 100, 60, require_no_error());
+        rs_start_device(device, require_error("crops must start on and span an even number of columns"));
+
+        // The size and intrinsics of the window are known before streaming
+        rs_set_stream_crop(device, RS_STREAM_DEPTH, 40, 30, 100, 60, require_no_error());
+        REQUIRE(rs_get_stream_width(device, RS_STREAM_DEPTH, require_no_error()) == 100);
+        REQUIRE(rs_get_stream_height(device, RS_STREAM_DEPTH, require_no_error()) == 60);
+        rs_intrinsics intrin;
+        rs_get_stream_intrinsics(device, RS_STREAM_DEPTH, &intrin, require_no_error());
+        REQUIRE(intrin.ppx == 120.0f);
+        REQUIRE(intrin.ppy == 90.0f);
+        REQUIRE(rs_get_stream_width(device, RS_STREAM_COLOR, require_no_error()) == synthetic_width);
+
+        rs_set_device_option(device, RS_OPTION_FRAME_MAILBOX_ENABLED, 1, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_set_stream_crop(device, RS_STREAM_DEPTH, 0, 0, 0, 0, require_error("stream crops cannot be changed after having called rs_start_device()"));
+        REQUIRE(rs_is_stream_cropped_in_driver(device, RS_STREAM_DEPTH, require_no_error()) == 1);
+        REQUIRE(rs_is_stream_cropped_in_driver(device, RS_STREAM_COLOR, require_no_error()) == 0);
+
+        rs_frame_ref * frame = nullptr;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!frame && std::chrono::steady_clock::now() < deadline)
+        {
+            frame = rs_get_latest_frame(device, RS_STREAM_DEPTH, require_no_error());
+            if (!frame) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(frame != nullptr);
+        REQUIRE(rs_get_detached_frame_width(frame, require_no_error()) == 100);
+        REQUIRE(rs_get_detached_frame_height(frame, require_no_error()) == 60);
+        auto pixels = static_cast<const uint16_t *>(rs_get_detached_frame_data(frame, require_no_error()));
+        for (int y = 0; y < 60; ++y) for (int x = 0; x < 100; ++x) REQUIRE(pixels[y * 100 + x] == 1000 + ((y + 30) * synthetic_width + x + 40) % 1000);
+        rs_release_frame(device, frame, require_no_error());
+
+        // Only the window crossed the bus
+        const auto bytes = rs_get_transfer_statistic(device, RS_STREAM_DEPTH, RS_TRANSFER_STATISTIC_BYTES, require_no_error());
+        const auto frames = rs_get_transfer_statistic(device, RS_STREAM_DEPTH, RS_TRANSFER_STATISTIC_FRAMES, require_no_error());
+        REQUIRE(frames > 0);
+        REQUIRE(bytes <= frames * 100 * 60 * sizeof(uint16_t));
+        REQUIRE(rs_get_transfer_statistic(device, RS_STREAM_DEPTH, RS_TRANSFER_STATISTIC_SHORT_FRAMES, require_no_error()) == 0);
+        rs_stop_device(device, require_no_error());
+        REQUIRE(rs_is_stream_cropped_in_driver(device, RS_STREAM_DEPTH, require_no_error()) == 0);
+    }
+}
+
+TEST_CASE( "sliced streams hand out the rows of every frame in order, ahead of the frame", "[offline] [validation]" )
+{
+    struct slice { int width, first_row, row_count; bool pixels_match; };
+    struct slices { std::mutex mutex; std::vector<slice> received; } log;
+    auto on_slice = [](rs_device *, const void * rows, int width, int first_row, int row_count, void * user)
+    {
+        auto pixels = static_cast<const uint16_t *>(rows);
+        bool match = true;
+        for (int y = 0; y < row_count; ++y) for (int x = 0; x < width; ++x) match &= pixels[y * width + x] == 1000 + ((first_row + y) * width + x) % 1000;
+        auto & log = *static_cast<slices *>(user);
+        std::lock_guard<std::mutex> lock(log.mutex);
+        log.received.push_back({ width, first_row, row_count, match });
+    };
+
+    synthetic_playback playback("pipeline-slice-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        rs_set_stream_slice_callback(device, RS_STREAM_COLOR, 64, on_slice, &log, require_no_error());
+        rs_start_device(device, require_error("only streams sent as Z16 can be sliced, COLOR is not"));
+        rs_set_stream_slice_callback(device, RS_STREAM_COLOR, 0, nullptr, nullptr, require_no_error());
+
+        rs_set_stream_slice_callback(device, RS_STREAM_DEPTH, 64, on_slice, &log, require_no_error());
+        rs_start_device(device, require_no_error());
+        rs_set_stream_slice_callback(device, RS_STREAM_DEPTH, 0, nullptr, nullptr, require_error("slice callbacks cannot be changed after having called rs_start_device()"));
+
+        // Once a frame has arrived, every row of it has been handed out before
+        rs_wait_for_frames(device, require_no_error());
+        rs_stop_device(device, require_no_error());
+
+        std::lock_guard<std::mutex> lock(log.mutex);
+        REQUIRE(log.received.size() >= 4);
+        REQUIRE(log.received.size() % 4 == 0);
+        for (size_t i = 0; i < log.received.size(); ++i)
+        {
+            const int index = static_cast<int>(i % 4);
+            REQUIRE(log.received[i].width == synthetic_width);
+            REQUIRE(log.received[i].first_row == index * 64);
+            REQUIRE(log.received[i].row_count == (index < 3 ? 64 : synthetic_height - 192));
+            REQUIRE(log.received[i].pixels_match);
+        }
+    }
+}
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+// Starts running at once and destroys itself at its end, the simplest coroutine type there is to await frames with
+struct detached_task
+{
+    struct promise_type
+    {
+        detached_task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+static detached_task take_framesets(rs::frame_scheduler & scheduler, rs::device & dev, int count, std::vector<unsigned long long> & numbers)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        co_await scheduler.next_frameset(dev);
+        numbers.push_back(dev.get_frame_number(rs::stream::depth));
+    }
+}
+
+TEST_CASE( "coroutines await the framesets of devices from the thread of a frame scheduler", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-coroutine-test.bin");
+    {
+        safe_context ctx;
+        auto & dev = *(rs::device *)rs_get_device(ctx, 0, require_no_error());
+        dev.enable_stream(rs::stream::depth, synthetic_width, synthetic_height, rs::format::z16, synthetic_fps);
+        dev.start();
+
+        // Two coroutines take turns at the framesets of one device, neither blocking the thread nor getting a frameset the other took
+        rs::frame_scheduler scheduler;
+        std::vector<unsigned long long> first, second;
+        take_framesets(scheduler, dev, 10, first);
+        take_framesets(scheduler, dev, 5, second);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (scheduler.pending() && std::chrono::steady_clock::now() < deadline) scheduler.run_once(100);
+        REQUIRE(scheduler.pending() == 0);
+        REQUIRE(scheduler.run_once(0) == 0);
+        REQUIRE(first.size() == 10);
+        REQUIRE(second.size() == 5);
+        REQUIRE(std::is_sorted(first.begin(), first.end()));
+        REQUIRE(std::is_sorted(second.begin(), second.end()));
+        for (auto n : second) REQUIRE(std::count(first.begin(), first.end(), n) == 0);
+        dev.stop();
+    }
+}
+#endif
+
+TEST_CASE( "frame histories dump the frames around an event as a recording", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-history-test.bin");
+    const std::string path = "pipeline-history-dump.bin";
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        REQUIRE(rs_dump_frame_history(device, path.c_str(), 0, 100, 100, require_error("device keeps no frame history")) == 0);
+        rs_start_frame_history(device, 10, 64 << 20, require_no_error());
+        rs_start_frame_history(device, 10, 64 << 20, require_error("device already keeps a frame history"));
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        rs_start_device(device, require_no_error());
+        double timestamp = 0;
+        for (int i = 0; i < 10; ++i)
+        {
+            rs_wait_for_frames(device, require_no_error());
+            timestamp = rs_get_frame_timestamp(device, RS_STREAM_DEPTH, require_no_error());
+        }
+        REQUIRE(rs_get_frame_history_size(device, require_no_error()) > 0);
+        REQUIRE(rs_get_frame_history_size(device, require_no_error()) <= 64u << 20);
+
+        // The window ends with the event, the frames after it not being captured yet
+        const int written = rs_dump_frame_history(device, path.c_str(), timestamp, 200, 0, require_no_error());
+        REQUIRE(written >= 2);
+        rs_stop_device(device, require_no_error());
+        rs_stop_frame_history(device, require_no_error());
+        rs_stop_frame_history(device, require_error("device keeps no frame history"));
+        REQUIRE(rs_get_frame_history_size(device, require_no_error()) == 0);
+
+        using namespace rsimpl::recording;
+        reader r(path);
+        record rec;
+        int frames[2] = {}, streams = 0;
+        while (r.next(rec))
+        {
+            if (rec.type == record_type::stream) ++streams;
+            if (rec.type != record_type::frame) continue;
+            auto & frame = *reinterpret_cast<const frame_record *>(rec.payload);
+            REQUIRE(frame.timestamp >= timestamp - 200);
+            REQUIRE(frame.timestamp <= timestamp);
+            REQUIRE(frame.encoding == (frame.subdevice == 0 ? frame_encoding::rvl : frame_encoding::raw));
+            ++frames[frame.subdevice];
+        }
+        REQUIRE(streams == 2);
+        REQUIRE(frames[0] + frames[1] == written);
+        REQUIRE(frames[0] > 0);
+        REQUIRE(frames[1] > 0);
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE( "recorded framesets are synchronized and derived streams computed in real time", "[offline] [performance]" )
+{
+    synthetic_playback playback("pipeline-sync-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+        rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        rs_start_device(device, require_no_error());
+
+        // Replayed in real time, the application sees nearly every frameset, and computing its derived streams fits in a frame interval
+        int framesets = 0, over_budget = 0;
+        unsigned long long last = 0;
+        while (last + 1 < synthetic_frame_count)
+        {
+            rs_wait_for_frames(device, require_no_error());
+            const auto number = rs_get_frame_number(device, RS_STREAM_DEPTH, require_no_error());
+            REQUIRE((framesets == 0 || number > last));
+            REQUIRE(rs_get_frame_number(device, RS_STREAM_COLOR, require_no_error()) == number);
+            last = number;
+            ++framesets;
+
+            const auto start = std::chrono::steady_clock::now();
+            REQUIRE(rs_get_frame_data(device, RS_STREAM_POINTS, require_no_error()) != nullptr);
+            REQUIRE(rs_get_frame_data(device, RS_STREAM_COLOR_ALIGNED_TO_DEPTH, require_no_error()) != nullptr);
+            REQUIRE(rs_get_frame_data(device, RS_STREAM_DEPTH_ALIGNED_TO_COLOR, require_no_error()) != nullptr);
+            if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(1000 / synthetic_fps)) ++over_budget;
+        }
+        rs_stop_device(device, require_no_error());
+
+        REQUIRE(framesets * 10 >= synthetic_frame_count * 9);
+        REQUIRE(over_budget * 20 <= framesets);
+
+        // Frames received were either handed out, culled, or are still queued
+        REQUIRE(rs_get_stream_metric(device, RS_STREAM_DEPTH, RS_STREAM_METRIC_FRAMES_RECEIVED, require_no_error()) == synthetic_frame_count);
+        REQUIRE(framesets + rs_get_stream_metric(device, RS_STREAM_DEPTH, RS_STREAM_METRIC_FRAMES_CULLED, require_no_error())
+            + rs_get_stream_metric(device, RS_STREAM_DEPTH, RS_STREAM_METRIC_QUEUED_FRAMES, require_no_error()) == synthetic_frame_count);
+
+        unsigned long long total;
+        count_frames_over_budget(device, RS_STREAM_DEPTH, RS_FRAME_METADATA_TIME_OF_DELIVERY, 1000.0 / synthetic_fps, total);
+        REQUIRE(total == (unsigned long long)framesets);
+    }
+}
+
+TEST_CASE( "aligned streams can be decimated until the device starts", "[offline] [validation]" )
+{
+    synthetic_playback playback("pipeline-aligned-decimation-test.bin");
+    {
+        safe_context ctx;
+        rs_device * device = rs_get_device(ctx, 0, require_no_error());
+        rs_set_stream_decimation(device, RS_STREAM_DEPTH, 2, require_error("out of range value for argument \"stream\""));
+        rs_set_stream_decimation(device, RS_STREAM_POINTS, 2, require_error("only aligned streams can be decimated, not POINTS"));
+        rs_set_stream_decimation(device, RS_STREAM_DEPTH_ALIGNED_TO_COLOR, 5, require_error("out of range value for argument \"factor\""));
+        rs_set_stream_decimation(device, RS_STREAM_DEPTH_ALIGNED_TO_COLOR, 2, require_no_error());
+        rs_set_stream_decimation(device, RS_STREAM_COLOR_ALIGNED_TO_DEPTH, 4, require_no_error());
+        for (auto stream : { RS_STREAM_DEPTH, RS_STREAM_COLOR })
+        {
+            rs_enable_stream(device, stream, synthetic_width, synthetic_height, stream == RS_STREAM_DEPTH ? RS_FORMAT_Z16 : RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+        }
+        rs_start_device(device, require_no_error());
+        rs_set_stream_decimation(device, RS_STREAM_DEPTH_ALIGNED_TO_COLOR, 1, require_error("streams cannot be reconfigured after having called rs_start_device()"));
+        rs_wait_for_frames(device, require_no_error());
+
+        rs_intrinsics depth_to_color, color_to_depth;
+        rs_get_stream_intrinsics(device, RS_STREAM_DEPTH_ALIGNED_TO_COLOR, &depth_to_color, require_no_error());
+        rs_get_stream_intrinsics(device, RS_STREAM_COLOR_ALIGNED_TO_DEPTH, &color_to_depth, require_no_error());
+        REQUIRE(depth_to_color.width == synthetic_width / 2);
+        REQUIRE(depth_to_color.height == synthetic_height / 2);
+        REQUIRE(color_to_depth.width == synthetic_width / 4);
+        REQUIRE(color_to_depth.height == synthetic_height / 4);
+
+        // Synthetic depth has no holes, so every decimated pixel lands somewhere in the color image
+        auto depth = reinterpret_cast<const uint16_t *>(rs_get_frame_data(device, RS_STREAM_DEPTH_ALIGNED_TO_COLOR, require_no_error()));
+        REQUIRE(depth != nullptr);
+        REQUIRE(std::count(depth, depth + depth_to_color.width * depth_to_color.height, 0) < depth_to_color.width * depth_to_color.height);
+        REQUIRE(rs_get_frame_data(device, RS_STREAM_COLOR_ALIGNED_TO_DEPTH, require_no_error()) != nullptr);
+        rs_stop_device(device, require_no_error());
+    }
 }
 
-TEST_CASE( "rs_delete_context() validates input", "[offline] [validation]" )
+TEST_CASE( "points computed incrementally match those of every whole depth frame", "[offline] [validation]" )
 {
-    rs_delete_context(nullptr, require_error("null pointer passed for argument \"context\""));
+    synthetic_playback playback("pipeline-incremental-test.bin");
+    safe_context ctx;
+    rs_device * device = rs_get_device(ctx, 0, require_no_error());
+    rs_set_device_option(device, RS_OPTION_INCREMENTAL_PROCESSING_ENABLED, 2, require_error("incremental processing must be 0 (disabled) or 1 (enabled)"));
+    rs_set_device_option(device, RS_OPTION_INCREMENTAL_PROCESSING_ENABLED, 1, require_no_error());
+    rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+    rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+    rs_start_device(device, require_no_error());
+    rs_set_device_option(device, RS_OPTION_INCREMENTAL_PROCESSING_ENABLED, 0, require_error("incremental processing cannot be changed after having called rs_start_device()"));
+    REQUIRE(rs_get_device_option(device, RS_OPTION_INCREMENTAL_PROCESSING_ENABLED, require_no_error()) == 1);
+
+    rs_intrinsics depth_intrin;
+    rs_get_stream_intrinsics(device, RS_STREAM_DEPTH, &depth_intrin, require_no_error());
+    const auto table = rsimpl::compute_deprojection_table(depth_intrin);
+    std::vector<float> expected(synthetic_width * synthetic_height * 3);
+    for (int i = 0; i < 5; ++i)
+    {
+        rs_wait_for_frames(device, require_no_error());
+        auto pixels = static_cast<const uint16_t *>(rs_get_frame_data(device, RS_STREAM_DEPTH, require_no_error()));
+        rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(expected.data()), RS_FORMAT_XYZ32F, table, pixels, rs_get_device_depth_scale(device, require_no_error()));
+        auto points = static_cast<const float *>(rs_get_frame_data(device, RS_STREAM_POINTS, require_no_error()));
+        REQUIRE(std::equal(expected.begin(), expected.end(), points));
+        REQUIRE(rs_get_frame_data(device, RS_STREAM_COLOR_ALIGNED_TO_DEPTH, require_no_error()) != nullptr);
+    }
+    rs_stop_device(device, require_no_error());
 }
 
-TEST_CASE( "rs_get_device_count() validates input", "[offline] [validation]" )
+TEST_CASE( "points can be enabled in planes of X, Y and Z", "[offline] [validation]" )
 {
-    REQUIRE(rs_get_device_count(nullptr, require_error("null pointer passed for argument \"context\"")) == 0);
+    synthetic_playback playback("pipeline-planar-points-test.bin");
+    safe_context ctx;
+    rs_device * device = rs_get_device(ctx, 0, require_no_error());
+    rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+    rs_enable_stream(device, RS_STREAM_POINTS, 0, 0, RS_FORMAT_XYZ32F_PLANAR, 0, require_no_error());
+    rs_start_device(device, require_no_error());
+    REQUIRE(rs_get_stream_format(device, RS_STREAM_POINTS, require_no_error()) == RS_FORMAT_XYZ32F_PLANAR);
+    rs_wait_for_frames(device, require_no_error());
+    auto pixels = static_cast<const uint16_t *>(rs_get_frame_data(device, RS_STREAM_DEPTH, require_no_error()));
+    rs_intrinsics depth_intrin;
+    rs_get_stream_intrinsics(device, RS_STREAM_DEPTH, &depth_intrin, require_no_error());
+    std::vector<float> expected(synthetic_width * synthetic_height * 3);
+    rsimpl::deproject_z(reinterpret_cast<rsimpl::byte *>(expected.data()), RS_FORMAT_XYZ32F, rsimpl::compute_deprojection_table(depth_intrin), pixels, rs_get_device_depth_scale(device, require_no_error()));
+    auto points = static_cast<const float *>(rs_get_frame_data(device, RS_STREAM_POINTS, require_no_error()));
+    const int plane = synthetic_width * synthetic_height;
+    std::vector<float> expected_planes(expected.size());
+    for (int i = 0; i < plane; ++i) for (int c = 0; c < 3; ++c) expected_planes[c * plane + i] = expected[i * 3 + c];
+    REQUIRE(std::equal(expected_planes.begin(), expected_planes.end(), points));
+    rs_stop_device(device, require_no_error());
 }
 
-TEST_CASE( "rs_get_device() validates input", "[offline] [validation]" )
+TEST_CASE( "every frame of a frameset is read in one call as it would be detached", "[offline] [validation]" )
 {
-    REQUIRE(rs_get_device(nullptr, 0, require_error("null pointer passed for argument \"context\"")) == nullptr);
+    synthetic_playback playback("pipeline-frameset-info-test.bin");
+    safe_context ctx;
+    rs_device * device = rs_get_device(ctx, 0, require_no_error());
+    std::atomic<rs_frameset *> kept(nullptr);
+    rs_enable_stream(device, RS_STREAM_DEPTH, synthetic_width, synthetic_height, RS_FORMAT_Z16, synthetic_fps, require_no_error());
+    rs_enable_stream(device, RS_STREAM_COLOR, synthetic_width, synthetic_height, RS_FORMAT_RGB8, synthetic_fps, require_no_error());
+    rs_set_frameset_callback(device, [](rs_device * device, rs_frameset * frames, void * user)
+    {
+        rs_frameset * none = nullptr;
+        if (!reinterpret_cast<std::atomic<rs_frameset *> *>(user)->compare_exchange_strong(none, frames)) rs_release_frames(device, frames, nullptr);
+    }, &kept, require_no_error());
+    rs_start_device(device, require_no_error());
+    for (int i = 0; i < 3000 && !kept; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(kept != nullptr);
 
-    REQUIRE(rs_get_device(fake_object_pointer(), -1, require_error("out of range value for argument \"index\"")) == nullptr);
-    // NOTE: Index upper bound determined by rs_get_device_count(), can't validate without a live object
+    // The count of frames is returned whatever the capacity, and only that many are written
+    rs_frame_info infos[RS_STREAM_NATIVE_COUNT] = {};
+    REQUIRE(rs_get_frameset_frame_info(device, kept, nullptr, 0, require_no_error()) == 2);
+    REQUIRE(rs_get_frameset_frame_info(device, kept, infos, 1, require_no_error()) == 2);
+    REQUIRE(infos[0].stream == RS_STREAM_DEPTH);
+    REQUIRE(infos[1].data == nullptr);
+    REQUIRE(rs_get_frameset_frame_info(device, kept, infos, RS_STREAM_NATIVE_COUNT, require_no_error()) == 2);
+    REQUIRE(infos[1].stream == RS_STREAM_COLOR);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        const auto & info = infos[i];
+        rs_frame_ref * frame = rs_detach_frame(device, kept, info.stream, require_no_error());
+        REQUIRE(info.data == rs_get_detached_frame_data(frame, require_no_error()));
+        REQUIRE(info.width == rs_get_detached_frame_width(frame, require_no_error()));
+        REQUIRE(info.height == rs_get_detached_frame_height(frame, require_no_error()));
+        REQUIRE(info.stride == rs_get_detached_frame_stride(frame, require_no_error()));
+        REQUIRE(info.bpp == rs_get_detached_frame_bpp(frame, require_no_error()));
+        REQUIRE(info.format == rs_get_detached_frame_format(frame, require_no_error()));
+        REQUIRE(info.framerate == rs_get_detached_framerate(frame, require_no_error()));
+        REQUIRE(info.timestamp == rs_get_detached_frame_timestamp(frame, require_no_error()));
+        REQUIRE(info.timestamp_domain == rs_get_detached_frame_timestamp_domain(frame, require_no_error()));
+        REQUIRE(info.frame_number == rs_get_detached_frame_number(frame, require_no_error()));
+        for (int m = 0; m < RS_FRAME_METADATA_COUNT; ++m)
+        {
+            const bool supported = rs_supports_frame_metadata(frame, (rs_frame_metadata)m, require_no_error()) != 0;
+            REQUIRE(((info.supported_metadata >> m) & 1) == (supported ? 1u : 0u));
+            if (supported) REQUIRE(info.metadata[m] == rs_get_detached_frame_metadata(frame, (rs_frame_metadata)m, require_no_error()));
+        }
+        rs_release_frame(device, frame, require_no_error());
+    }
+    REQUIRE(infos[0].width == synthetic_width);
+    REQUIRE(infos[1].format == RS_FORMAT_RGB8);
+
+    rs_release_frames(device, kept, require_no_error());
+    rs_stop_device(device, require_no_error());
 }
+#endif
 
-TEST_CASE( "rs_get_device_name() validates input", "[offline] [validation]" )
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+TEST_CASE( "frame schedulers return at once while no coroutine awaits frames", "[offline] [validation]" )
 {
-    REQUIRE(rs_get_device_name(nullptr, require_error("null pointer passed for argument \"device\"")) == nullptr);
+    rs::frame_scheduler scheduler;
+    REQUIRE(scheduler.pending() == 0);
+    REQUIRE(scheduler.run_once(0) == 0);
+    REQUIRE(scheduler.run_once(-1) == 0);
+    scheduler.run();
+    REQUIRE(scheduler.pending() == 0);
 }
+#endif
 
-TEST_CASE( "rs_get_device_serial() validates input", "[offline] [validation]" )
+TEST_CASE( "shared rings hand out records in order, and leave held slots alone", "[offline] [validation]" )
 {
-    REQUIRE(rs_get_device_serial(nullptr, require_error("null pointer passed for argument \"device\"")) == nullptr);
+    using namespace rsimpl;
+    recording::device_record device = { "Fake Camera", "1234", "5.6" };
+    shared_ring::publisher publisher("rs-unit-test-ring", 3, 16, device);
+    shared_ring::subscriber subscriber("rs-unit-test-ring");
+
+    // The description is that of a recording, the device first, then the modes of the latest start
+    recording::mode_description mode = { { 1, 4, 2, 0x32595559, 30, 0, {} }, { { RS_STREAM_COLOR, RS_FORMAT_YUYV, 30, {}, {}, 0.001f } } };
+    publisher.describe({ mode });
+    recording::reader reader(subscriber.get_description());
+    recording::record r;
+    REQUIRE(reader.next(r));
+    REQUIRE(r.type == recording::record_type::device);
+    REQUIRE(std::string(reinterpret_cast<const recording::device_record *>(r.payload)->serial) == "1234");
+    REQUIRE(reader.next(r));
+    REQUIRE(r.type == recording::record_type::mode);
+    REQUIRE(reader.next(r));
+    REQUIRE(r.type == recording::record_type::stream);
+    REQUIRE(!reader.next(r));
+
+    auto publish = [&](uint8_t value)
+    {
+        const uint8_t frame[16] = { value };
+        recording::frame_record record = { 1, recording::frame_encoding::raw, 100.0 + value, value, 0, 0, 30 };
+        return publisher.publish_frame(mode.mode, record, frame, sizeof(frame));
+    };
+    REQUIRE(subscriber.hold_next(subscriber.get_latest(), std::chrono::milliseconds(1)) == nullptr);
+    for (uint8_t i = 1; i <= 2; ++i) REQUIRE(publish(i));
+
+    auto first = subscriber.hold_next(0, std::chrono::milliseconds(0));
+    REQUIRE(first != nullptr);
+    REQUIRE(first->type == recording::record_type::frame);
+    REQUIRE(first->size == sizeof(recording::mode_record) + sizeof(recording::frame_record) + 16);
+    const size_t frame_offset = sizeof(recording::mode_record) + sizeof(recording::frame_record);
+    REQUIRE(first->payload[frame_offset] == 1);
+    REQUIRE(reinterpret_cast<uintptr_t>(first->payload + frame_offset) % 64 == 0);
+
+    // With the first slot held, the publisher goes around it
+    for (uint8_t i = 3; i <= 6; ++i) REQUIRE(publish(i));
+    REQUIRE(first->payload[frame_offset] == 1);
+    auto next = subscriber.hold_next(first->sequence, std::chrono::milliseconds(0));
+    REQUIRE(next != nullptr);
+    REQUIRE(next->payload[frame_offset] == 5); // 2, 3 and 4 were overwritten
+    auto last = subscriber.hold_next(next->sequence, std::chrono::milliseconds(0));
+    REQUIRE(last != nullptr);
+    REQUIRE(last->payload[frame_offset] == 6);
+
+    // Once every slot is held, frames are dropped
+    REQUIRE(!publish(7));
+    REQUIRE(publisher.get_dropped_count() == 1);
+    next.reset();
+    REQUIRE(publish(8));
+    auto eighth = subscriber.hold_next(last->sequence, std::chrono::milliseconds(0));
+    REQUIRE(eighth != nullptr);
+    REQUIRE(eighth->payload[frame_offset] == 8);
+
+    const std::vector<uint8_t> transfer(4096);
+    recording::motion_record motion = { 3, 0, 0 };
+    REQUIRE(!publisher.publish_motion(motion, transfer.data(), 4)); // No slot is free
+    REQUIRE(!publisher.publish_frame(mode.mode, recording::frame_record(), transfer.data(), transfer.size())); // Larger than a slot
+    REQUIRE(publisher.get_dropped_count() == 3);
+
+    REQUIRE(!subscriber.is_closed());
 }
 
-TEST_CASE( "rs_get_device_firmware_version() validates input", "[offline] [validation]" )
+#ifdef __linux__
+TEST_CASE( "shared rings are private to their user, and keep their layout whatever is written to them", "[offline] [validation]" )
 {
-    REQUIRE(rs_get_device_firmware_version(nullptr, require_error("null pointer passed for argument \"device\"")) == nullptr);
+    using namespace rsimpl;
+    recording::device_record device = { "Fake Camera", "1234", "5.6" };
+    shared_ring::publisher publisher("rs-unit-test-ring", 2, 16, device);
+    shared_ring::subscriber subscriber("rs-unit-test-ring");
+    struct stat st;
+    REQUIRE(stat("/dev/shm/rs-unit-test-ring", &st) == 0);
+    REQUIRE((st.st_mode & 0777) == 0600);
+
+    // Another process of the user overwrites the slot count and size of the header, which the publisher and subscriber no longer read
+    {
+        std::fstream ring("/dev/shm/rs-unit-test-ring", std::ios::in | std::ios::out | std::ios::binary);
+        const uint32_t layout[2] = { 1000000, 0xfffff000 };
+        ring.seekp(8);
+        ring.write(reinterpret_cast<const char *>(layout), sizeof(layout));
+    }
+    const uint8_t frame[16] = { 42 };
+    recording::mode_description mode = { { 1, 4, 2, 0x32595559, 30, 0, {} }, {} };
+    recording::frame_record record = { 1, recording::frame_encoding::raw, 100.0, 1, 0, 0, 30 };
+    for (int i = 0; i < 4; ++i) REQUIRE(publisher.publish_frame(mode.mode, record, frame, sizeof(frame)));
+    REQUIRE(!publisher.publish_frame(mode.mode, record, std::vector<uint8_t>(8192).data(), 8192)); // Still larger than a slot
+    auto held = subscriber.hold_next(2, std::chrono::milliseconds(0));
+    REQUIRE(held != nullptr);
+    REQUIRE(held->sequence == 3);
+    REQUIRE(held->payload[sizeof(recording::mode_record) + sizeof(recording::frame_record)] == 42);
 }
+#endif
 
-TEST_CASE( "rs_get_device_extrinsics() validates input", "[offline] [validation]" )
+TEST_CASE( "rs_start_publishing() and rs_stop_publishing() validate input", "[offline] [validation]" )
 {
-    rs_extrinsics extrin;
-    rs_get_device_extrinsics(nullptr,               RS_STREAM_DEPTH,    RS_STREAM_COLOR,    &extrin, require_error("null pointer passed for argument \"device\""));
-                                                                                            
-    rs_get_device_extrinsics(fake_object_pointer(), (rs_stream)-1,      RS_STREAM_COLOR,    &extrin, require_error("bad enum value for argument \"from\""));
-    rs_get_device_extrinsics(fake_object_pointer(), RS_STREAM_COUNT,    RS_STREAM_COLOR,    &extrin, require_error("bad enum value for argument \"from\""));
+    rs_start_publishing(nullptr, "ring", 16, require_error("null pointer passed for argument \"device\""));
+    rs_start_publishing(fake_object_pointer(), nullptr, 16, require_error("null pointer passed for argument \"name\""));
+    rs_start_publishing(fake_object_pointer(), "ring", 1, require_error("out of range value for argument \"slot_count\""));
+    rs_stop_publishing(nullptr, require_error("null pointer passed for argument \"device\""));
+}
 
-    rs_get_device_extrinsics(fake_object_pointer(), RS_STREAM_DEPTH,    (rs_stream)-1,      &extrin, require_error("bad enum value for argument \"to\""));
-    rs_get_device_extrinsics(fake_object_pointer(), RS_STREAM_DEPTH,    RS_STREAM_COUNT,    &extrin, require_error("bad enum value for argument \"to\""));
-                                                                        
-    rs_get_device_extrinsics(fake_object_pointer(), RS_STREAM_DEPTH,    RS_STREAM_COLOR,    nullptr, require_error("null pointer passed for argument \"extrin\""));
+TEST_CASE( "rs_set_playback_pacing() and rs_step_playback() validate input", "[offline] [validation]" )
+{
+    rs_set_playback_pacing(nullptr, RS_PLAYBACK_PACING_STEP, require_error("null pointer passed for argument \"device\""));
+    rs_set_playback_pacing(fake_object_pointer(), RS_PLAYBACK_PACING_COUNT, require_error("bad enum value for argument \"pacing\""));
+    REQUIRE(rs_step_playback(nullptr, require_error("null pointer passed for argument \"device\"")) == 0);
 }
 
-TEST_CASE( "rs_get_device_depth_scale() validates input", "[offline] [validation]" )
+TEST_CASE( "rs_seek_playback_to_frame() and rs_seek_playback_to_time() validate input", "[offline] [validation]" )
 {
-    REQUIRE(rs_get_device_depth_scale(nullptr, require_error("null pointer passed for argument \"device\"")) == 0.0f);
+    REQUIRE(rs_seek_playback_to_frame(nullptr, RS_STREAM_DEPTH, 10, require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_seek_playback_to_frame(fake_object_pointer(), RS_STREAM_POINTS, 10, require_error("argument \"stream\" must be a native stream")) == 0);
+    REQUIRE(rs_seek_playback_to_time(nullptr, RS_STREAM_DEPTH, 100.0, require_error("null pointer passed for argument \"device\"")) == 0);
+    REQUIRE(rs_seek_playback_to_time(fake_object_pointer(), RS_STREAM_COUNT, 100.0, require_error("bad enum value for argument \"stream\"")) == 0);
 }
 
-TEST_CASE( "rs_device_supports_option() validates input", "[offline] [validation]" )
+TEST_CASE( "rs_set_executor_threads() validates input", "[offline] [validation]" )
 {
-    REQUIRE(rs_device_supports_option(nullptr,               RS_OPTION_COLOR_GAIN, require_error("null pointer passed for argument \"device\"")) == 0);
+    rs_set_executor_threads(nullptr, 2, 0, require_error("null pointer passed for argument \"context\""));
+    rs_set_executor_threads((rs_context *)fake_object_pointer(), 0, 0, require_error("out of range value for argument \"count\""));
+    rs_set_executor_threads((rs_context *)fake_object_pointer(), 65, 0, require_error("out of range value for argument \"count\""));
+    REQUIRE(rs_get_executor_thread_count(nullptr, require_error("null pointer passed for argument \"context\"")) == 0);
+    REQUIRE(rs_get_executor_cpu_mask(nullptr, require_error("null pointer passed for argument \"context\"")) == 0);
+}
 
-    REQUIRE(rs_device_supports_option(fake_object_pointer(), (rs_option)-1,        require_error("bad enum value for argument \"option\"")) == 0);
-    REQUIRE(rs_device_supports_option(fake_object_pointer(), RS_OPTION_COUNT,      require_error("bad enum value for argument \"option\"")) == 0);
+TEST_CASE( "executor jobs run once for the triggers made before they start", "[offline] [validation]" )
+{
+    rsimpl::executor pool(2, 0);
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool blocked = true;
+    int runs = 0;
+    auto job = pool.create_job([&]()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ++runs;
+        cv.notify_all();
+        cv.wait(lock, [&]() { return !blocked; });
+    });
+
+    job->trigger();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return runs == 1; });
+    }
+    for (int i = 0; i < 3; ++i) job->trigger();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        blocked = false;
+        cv.notify_all();
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return runs == 2; });
+    }
+
+    // Reconfiguring the pool keeps the jobs, and a cancelled job never runs again
+    pool.set_threads(3, 0);
+    REQUIRE(pool.get_thread_count() == 3);
+    job->trigger();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return runs == 3; });
+    }
+    job->cancel();
+    job->trigger();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(runs == 3);
 }
 
-TEST_CASE( "rs_get_stream_mode_count() validates input", "[offline] [validation]" )
+TEST_CASE( "periodic executor jobs run on every period until cancelled", "[offline] [validation]" )
 {
-    REQUIRE(rs_get_stream_mode_count(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == 0);
-                                                                                
-    REQUIRE(rs_get_stream_mode_count(fake_object_pointer(), (rs_stream)-1,      require_error("bad enum value for argument \"stream\"")) == 0);
-    REQUIRE(rs_get_stream_mode_count(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == 0);
+    rsimpl::executor pool(1, 0);
+    std::atomic<int> runs(0);
+    auto job = pool.create_job([&]() { ++runs; }, std::chrono::milliseconds(10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    job->cancel();
+    const int cancelled_runs = runs;
+    REQUIRE(cancelled_runs >= 5);
+    REQUIRE(cancelled_runs <= 21);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(runs == cancelled_runs);
 }
 
-TEST_CASE( "rs_get_stream_mode() validates input", "[offline] [validation]" )
+TEST_CASE( "periodic executor jobs falling due close together start together", "[offline] [validation]" )
 {
-    int width, height, framerate; rs_format format;
-    rs_get_stream_mode(nullptr,               RS_STREAM_DEPTH,     0, &width, &height, &format, &framerate, require_error("null pointer passed for argument \"device\""));
-                                                                   
-    rs_get_stream_mode(fake_object_pointer(), (rs_stream)-1,       0, &width, &height, &format, &framerate, require_error("bad enum value for argument \"stream\""));
-    rs_get_stream_mode(fake_object_pointer(), RS_STREAM_COUNT,     0, &width, &height, &format, &framerate, require_error("bad enum value for argument \"stream\""));
+    // The first is allowed to start 50 ms late, by which time the second is due 40 ms after it
+    rsimpl::executor pool(2, 0);
+    std::mutex mutex;
+    std::vector<std::chrono::steady_clock::time_point> starts;
+    auto record = [&]() { std::lock_guard<std::mutex> lock(mutex); starts.push_back(std::chrono::steady_clock::now()); };
+    auto first = pool.create_job(record, std::chrono::milliseconds(400));
+    auto second = pool.create_job(record, std::chrono::milliseconds(440));
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    first->cancel();
+    second->cancel();
 
-    rs_get_stream_mode(fake_object_pointer(), RS_STREAM_DEPTH,    -1, &width, &height, &format, &framerate, require_error("out of range value for argument \"index\""));
-    // NOTE: Index upper bound determined by rs_get_stream_mode_count(), can't validate without a live object
+    std::lock_guard<std::mutex> lock(mutex);
+    REQUIRE(starts.size() == 2);
+    REQUIRE(std::abs(std::chrono::duration<double, std::milli>(starts[1] - starts[0]).count()) < 20);
+}
 
-    // NOTE: width, height, format, framerate are all permitted to be null, nothing to validate
+TEST_CASE( "task graphs run independent tasks in parallel and complete inputs in order", "[offline] [validation]" )
+{
+    struct input { int number; std::atomic<int> steps[4]; };
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<int> completed;
+    int parallel_runs = 0;
+    std::atomic<int> out_of_order(0); // Counted rather than checked on the pool threads
+    rsimpl::task_graph graph(4, 0, [&](void * i) { std::lock_guard<std::mutex> lock(mutex); completed.push_back(((input *)i)->number); });
+
+    // A diamond: b and c follow a, and d follows both. Every run of b waits until c has started on the same input, which only ends if they run in parallel.
+    std::atomic<int> started_c(-1);
+    auto a = graph.add_task([](void * i) { ((input *)i)->steps[0] = 1; });
+    auto b = graph.add_task([&](void * i)
+    {
+        auto in = (input *)i;
+        if (in->steps[0] != 1) ++out_of_order;
+        for (int wait = 0; wait < 2000 && started_c < in->number; ++wait) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::lock_guard<std::mutex> lock(mutex);
+        if (started_c >= in->number) ++parallel_runs;
+        in->steps[1] = 1;
+    }, {a});
+    auto c = graph.add_task([&](void * i)
+    {
+        auto in = (input *)i;
+        if (in->steps[0] != 1) ++out_of_order;
+        started_c = in->number;
+        in->steps[2] = 1;
+        if (in->number == 3) throw std::runtime_error("failing task"); // Does not hold up d, nor the completion of the input
+    }, {a});
+    graph.add_task([&](void * i)
+    {
+        auto in = (input *)i;
+        if (in->steps[1] != 1 || in->steps[2] != 1) ++out_of_order;
+        in->steps[3] = 1;
+    }, {b, c});
+    REQUIRE_THROWS(graph.add_task([](void *) {}, {7}));
+
+    std::vector<std::unique_ptr<input>> inputs;
+    for (int i = 0; i < 20; ++i)
+    {
+        inputs.emplace_back(new input());
+        inputs.back()->number = i;
+        for (auto & step : inputs.back()->steps) step = 0;
+        graph.submit(inputs.back().get());
+    }
+    graph.stop(); // Waits for every input
+
+    std::vector<int> expected(20);
+    std::iota(expected.begin(), expected.end(), 0);
+    REQUIRE(completed == expected);
+    REQUIRE(parallel_runs == 20);
+    REQUIRE(out_of_order == 0);
+    for (auto & in : inputs) REQUIRE(in->steps[3] == 1);
 }
 
-TEST_CASE( "rs_enable_stream() validates input", "[offline] [validation]" )
+TEST_CASE( "rs_create_multi_sync() validates input", "[offline] [validation]" )
 {
-    rs_enable_stream(nullptr, RS_STREAM_DEPTH, 640, 480, RS_FORMAT_Z16, 60, require_error("null pointer passed for argument \"device\""));
-                                                                                              
-    const auto RS_STREAM_MAX_ENUM = (rs_stream)0xFFFF;
-    const auto RS_FORMAT_MAX_ENUM = (rs_format)0xFFFF;
-    rs_enable_stream(fake_object_pointer(), (rs_stream)-1, 640, 480, RS_FORMAT_Z16, 60, require_error("bad enum value for argument \"stream\""));
-    rs_enable_stream(fake_object_pointer(), RS_STREAM_COUNT, 640, 480, RS_FORMAT_Z16, 60, require_error("bad enum value for argument \"stream\""));
-    rs_enable_stream(fake_object_pointer(), RS_STREAM_MAX_ENUM, 640, 480, RS_FORMAT_Z16, 60, require_error("bad enum value for argument \"stream\""));
-                                                                                              
-    rs_enable_stream(fake_object_pointer(), RS_STREAM_DEPTH, -1, 480, RS_FORMAT_Z16, 60, require_error("out of range value for argument \"width\""));
-                                                                                              
-    rs_enable_stream(fake_object_pointer(), RS_STREAM_DEPTH, 640, -1, RS_FORMAT_Z16, 60, require_error("out of range value for argument \"height\""));
-                                                                                              
-    rs_enable_stream(fake_object_pointer(), RS_STREAM_DEPTH, 640, 480, (rs_format)-1, 60, require_error("bad enum value for argument \"format\""));
-    rs_enable_stream(fake_object_pointer(), RS_STREAM_DEPTH, 640, 480, RS_FORMAT_COUNT, 60, require_error("bad enum value for argument \"format\""));
-    rs_enable_stream(fake_object_pointer(), RS_STREAM_DEPTH, 640, 480, RS_FORMAT_MAX_ENUM, 60, require_error("bad enum value for argument \"format\""));
-                                                                
-    rs_enable_stream(fake_object_pointer(), RS_STREAM_DEPTH, 640, 480, RS_FORMAT_Z16, -1, require_error("out of range value for argument \"framerate\""));
+    auto on_framesets = [](rs_device * const *, rs_frameset * const *, int, void *) {};
+    rs_device * devices[] = { (rs_device *)fake_object_pointer(), nullptr };
+    REQUIRE(rs_create_multi_sync(nullptr, 1, 5, RS_STRAGGLER_POLICY_DROP_SET,          on_framesets, nullptr, require_error("null pointer passed for argument \"devices\"")) == nullptr);
+    REQUIRE(rs_create_multi_sync(devices, 0, 5, RS_STRAGGLER_POLICY_DROP_SET,          on_framesets, nullptr, require_error("out of range value for argument \"count\"")) == nullptr);
+    REQUIRE(rs_create_multi_sync(devices, 2, 5, RS_STRAGGLER_POLICY_DROP_SET,          on_framesets, nullptr, require_error("null pointer passed for argument \"devices[i]\"")) == nullptr);
+    REQUIRE(rs_create_multi_sync(devices, 1, -1, RS_STRAGGLER_POLICY_DROP_SET,         on_framesets, nullptr, require_error("out of range value for argument \"tolerance\"")) == nullptr);
+    REQUIRE(rs_create_multi_sync(devices, 1, 5, RS_STRAGGLER_POLICY_COUNT,             on_framesets, nullptr, require_error("bad enum value for argument \"policy\"")) == nullptr);
+    REQUIRE(rs_create_multi_sync(devices, 1, 5, RS_STRAGGLER_POLICY_DELIVER_PARTIAL,   nullptr,      nullptr, require_error("null pointer passed for argument \"on_framesets\"")) == nullptr);
+    REQUIRE(rs_create_multi_sync_cpp(devices, 1, 5, RS_STRAGGLER_POLICY_DROP_SET,      nullptr,               require_error("null pointer passed for argument \"callback\"")) == nullptr);
+
+    rs_delete_multi_sync(nullptr, require_error("null pointer passed for argument \"sync\""));
 }
 
-TEST_CASE( "rs_enable_stream_preset() validates input", "[offline] [validation]" )
+TEST_CASE( "framesets of several devices are matched across their clocks", "[offline] [validation]" )
 {
-    rs_enable_stream_preset(nullptr,               RS_STREAM_DEPTH,    RS_PRESET_BEST_QUALITY, require_error("null pointer passed for argument \"device\""));
-                                                                       
-    rs_enable_stream_preset(fake_object_pointer(), (rs_stream)-1,      RS_PRESET_BEST_QUALITY, require_error("bad enum value for argument \"stream\""));
-    rs_enable_stream_preset(fake_object_pointer(), RS_STREAM_COUNT,    RS_PRESET_BEST_QUALITY, require_error("bad enum value for argument \"stream\""));
+    for (auto policy : { RS_STRAGGLER_POLICY_DELIVER_PARTIAL, RS_STRAGGLER_POLICY_DROP_SET })
+    {
+        std::vector<std::string> delivered, discarded;
+        std::string names[] = { "A0", "A1", "A2", "A3", "A4", "A5", "A6", "A7", "A8", "B0", "B1", "B3" };
+        rsimpl::frameset_matcher matcher(2, 5, policy, [&](void * const framesets[])
+        {
+            delivered.push_back((framesets[0] ? *(std::string *)framesets[0] : "-") + " " + (framesets[1] ? *(std::string *)framesets[1] : "-"));
+        }, [&](int, void * frameset) { discarded.push_back(*(std::string *)frameset); });
 
-    rs_enable_stream_preset(fake_object_pointer(), RS_STREAM_DEPTH,    (rs_preset)-1,          require_error("bad enum value for argument \"preset\""));
-    rs_enable_stream_preset(fake_object_pointer(), RS_STREAM_DEPTH,    RS_PRESET_COUNT,        require_error("bad enum value for argument \"preset\""));
+        // The clock of device A runs 1000 ms behind the host and that of device B 500 ms, A1 arrives late and B misses its third frame, then stops
+        matcher.push(0, &names[0], 0, 1000);
+        matcher.push(1, &names[9], 502, 1002);
+        matcher.push(0, &names[1], 33, 1043);
+        matcher.push(1, &names[10], 535, 1035);
+        matcher.push(0, &names[2], 66, 1066);
+        matcher.push(0, &names[3], 99, 1099);
+        matcher.push(1, &names[11], 601, 1101);
+        for (int i = 4; i < 9; ++i) matcher.push(0, &names[i], 33 * i, 1000 + 33 * i);
+
+        if (policy == RS_STRAGGLER_POLICY_DELIVER_PARTIAL)
+        {
+            REQUIRE(delivered == std::vector<std::string>({ "A0 B0", "A1 B1", "A2 -", "A3 B3", "A4 -" }));
+            REQUIRE(discarded.empty());
+        }
+        else
+        {
+            REQUIRE(delivered == std::vector<std::string>({ "A0 B0", "A1 B1", "A3 B3" }));
+            REQUIRE(discarded == std::vector<std::string>({ "A2", "A4" }));
+        }
+
+        discarded.clear();
+        matcher.flush();
+        REQUIRE(discarded == std::vector<std::string>({ "A5", "A6", "A7", "A8" }));
+    }
 }
 
-TEST_CASE( "rs_disable_stream() validates input", "[offline] [validation]" )
+TEST_CASE( "rs_get_device_bandwidth() and rs_plan_device_modes() validate input", "[offline] [validation]" )
 {
-    rs_disable_stream(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\""));
-                                                                 
-    rs_disable_stream(fake_object_pointer(), (rs_stream)-1,      require_error("bad enum value for argument \"stream\""));
-    rs_disable_stream(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\""));
+    REQUIRE(rs_get_device_bandwidth(nullptr, require_error("null pointer passed for argument \"device\"")) == 0);
+
+    rs_device * devices[] = { (rs_device *)fake_object_pointer(), nullptr };
+    rs_plan_device_modes(nullptr, 1, 400, require_error("null pointer passed for argument \"devices\""));
+    rs_plan_device_modes(devices, 0, 400, require_error("out of range value for argument \"count\""));
+    rs_plan_device_modes(devices, 2, 400, require_error("null pointer passed for argument \"devices[i]\""));
+    rs_plan_device_modes(devices, 1, 0, require_error("out of range value for argument \"controller_bandwidth\""));
 }
 
-TEST_CASE( "rs_is_stream_enabled() validates input", "[offline] [validation]" )
+TEST_CASE( "points are projected, deprojected and transformed in batches as one at a time", "[offline] [validation]" )
 {
-    REQUIRE(rs_is_stream_enabled(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == 0);
-                                                                            
-    REQUIRE(rs_is_stream_enabled(fake_object_pointer(), (rs_stream)-1,      require_error("bad enum value for argument \"stream\"")) == 0);
-    REQUIRE(rs_is_stream_enabled(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == 0);
+    // A count which leaves points past the widest vector step
+    const int count = 37;
+    std::vector<rs::float3> points(count);
+    std::vector<rs::float2> pixels(count);
+    std::vector<float> depths(count);
+    for (int i = 0; i < count; ++i)
+    {
+        points[i] = { ((i * 37) % 101 - 50) * 0.01f, ((i * 53) % 89 - 44) * 0.01f, 0.3f + (i % 13) * 0.2f };
+        pixels[i] = { (i * 97) % 640 + 0.25f, (i * 61) % 480 + 0.75f };
+        depths[i] = 0.5f + (i % 7) * 0.5f;
+    }
+
+    rs::intrinsics intrin;
+    static_cast<rs_intrinsics &>(intrin) = { 640, 480, 320.5f, 240.25f, 610.0f, 605.0f, RS_DISTORTION_NONE, { 0.12f, -0.25f, 0.001f, -0.002f, 0.05f } };
+    for (auto model : { RS_DISTORTION_NONE, RS_DISTORTION_MODIFIED_BROWN_CONRADY, RS_DISTORTION_INVERSE_BROWN_CONRADY })
+    {
+        intrin.rs_intrinsics::model = model;
+        if (model != RS_DISTORTION_INVERSE_BROWN_CONRADY)
+        {
+            auto projected = intrin.project(points);
+            REQUIRE(projected.size() == points.size());
+            for (int i = 0; i < count; ++i)
+            {
+                auto expected = intrin.project(points[i]);
+                REQUIRE(projected[i].x == Approx(expected.x));
+                REQUIRE(projected[i].y == Approx(expected.y));
+            }
+        }
+        if (model != RS_DISTORTION_MODIFIED_BROWN_CONRADY)
+        {
+            auto deprojected = intrin.deproject(pixels, depths);
+            REQUIRE(deprojected.size() == pixels.size());
+            for (int i = 0; i < count; ++i)
+            {
+                auto expected = intrin.deproject(pixels[i], depths[i]);
+                REQUIRE(deprojected[i].x == Approx(expected.x));
+                REQUIRE(deprojected[i].y == Approx(expected.y));
+                REQUIRE(deprojected[i].z == Approx(expected.z));
+            }
+        }
+    }
+
+    rs::extrinsics extrin;
+    static_cast<rs_extrinsics &>(extrin) = { { 0.36f, 0.48f, -0.8f, -0.8f, 0.6f, 0, 0.48f, 0.64f, 0.6f }, { 0.025f, -0.01f, 0.004f } };
+    auto moved = extrin.transform(points);
+    for (int i = 0; i < count; ++i)
+    {
+        auto expected = extrin.transform(points[i]);
+        REQUIRE(moved[i].x == Approx(expected.x));
+        REQUIRE(moved[i].y == Approx(expected.y));
+        REQUIRE(moved[i].z == Approx(expected.z));
+    }
+
+    // In place, the points are only overwritten once read
+    rs_transform_points_to_points(&points.data()->x, &extrin, &points.data()->x, count, require_no_error());
+    for (int i = 0; i < count; ++i)
+    {
+        REQUIRE(points[i].x == moved[i].x);
+        REQUIRE(points[i].y == moved[i].y);
+        REQUIRE(points[i].z == moved[i].z);
+    }
+    REQUIRE(extrin.transform(std::vector<rs::float3>()).empty());
 }
 
-TEST_CASE( "rs_get_stream_intrinsics() validates input", "[offline] [validation]" )
+TEST_CASE( "batch projection validates input", "[offline] [validation]" )
 {
-    rs_intrinsics intrin;
-    rs_get_stream_intrinsics(nullptr,               RS_STREAM_DEPTH,    &intrin, require_error("null pointer passed for argument \"device\""));
-                                                                        
-    rs_get_stream_intrinsics(fake_object_pointer(), (rs_stream)-1,      &intrin, require_error("bad enum value for argument \"stream\""));
-    rs_get_stream_intrinsics(fake_object_pointer(), RS_STREAM_COUNT,    &intrin, require_error("bad enum value for argument \"stream\""));
+    rs_intrinsics intrin = { 640, 480, 320, 240, 600, 600, RS_DISTORTION_NONE, { 0, 0, 0, 0, 0 } };
+    const rs_extrinsics extrin = { { 1, 0, 0, 0, 1, 0, 0, 0, 1 }, { 0, 0, 0 } };
+    float points[3] = { 0, 0, 1 }, pixels[2] = {}, depths[1] = { 1 };
+    rs_project_points_to_pixels(nullptr, &intrin, points, 1, require_error("null pointer passed for argument \"pixels\""));
+    rs_project_points_to_pixels(pixels, nullptr, points, 1, require_error("null pointer passed for argument \"intrin\""));
+    rs_project_points_to_pixels(pixels, &intrin, nullptr, 1, require_error("null pointer passed for argument \"points\""));
+    rs_project_points_to_pixels(pixels, &intrin, points, -1, require_error("out of range value for argument \"count\""));
+    rs_deproject_pixels_to_points(points, &intrin, pixels, nullptr, 1, require_error("null pointer passed for argument \"depths\""));
+    rs_transform_points_to_points(points, nullptr, points, 1, require_error("null pointer passed for argument \"extrin\""));
+    rs_transform_points_to_points(points, &extrin, points, 0, require_no_error());
 
-    rs_get_stream_intrinsics(fake_object_pointer(), RS_STREAM_DEPTH,    nullptr, require_error("null pointer passed for argument \"intrin\""));
+    intrin.model = RS_DISTORTION_INVERSE_BROWN_CONRADY;
+    rs_project_points_to_pixels(pixels, &intrin, points, 1, require_error("points cannot be projected to an image of INVERSE_BROWN_CONRADY distortion"));
+    rs_deproject_pixels_to_points(points, &intrin, pixels, depths, 1, require_no_error());
+    intrin.model = RS_DISTORTION_FTHETA;
+    rs_deproject_pixels_to_points(points, &intrin, pixels, depths, 1, require_error("pixels cannot be deprojected from an image of FTHETA distortion"));
+    intrin.model = RS_DISTORTION_COUNT;
+    rs_project_points_to_pixels(pixels, &intrin, points, 1, require_error("bad enum value for argument \"intrin->model\""));
 }
 
-TEST_CASE( "rs_get_stream_format() validates input", "[offline] [validation]" )
+TEST_CASE( "rs_fuse_point_clouds() validates input", "[offline] [validation]" )
 {
-    REQUIRE(rs_get_stream_format(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == RS_FORMAT_ANY);
-                                                                            
-    REQUIRE(rs_get_stream_format(fake_object_pointer(), (rs_stream)-1,      require_error("bad enum value for argument \"stream\"")) == RS_FORMAT_ANY);
-    REQUIRE(rs_get_stream_format(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == RS_FORMAT_ANY);
+    rs_device * devices[] = { (rs_device *)fake_object_pointer(), nullptr };
+    rs_frame_ref * frames[] = { (rs_frame_ref *)fake_object_pointer(), nullptr };
+    const rs_extrinsics poses[2] = {};
+    float points[3];
+    REQUIRE(rs_fuse_point_clouds(nullptr, frames, poses, 1, 0, points, 1, require_error("null pointer passed for argument \"devices\"")) == 0);
+    REQUIRE(rs_fuse_point_clouds(devices, nullptr, poses, 1, 0, points, 1, require_error("null pointer passed for argument \"depth_frames\"")) == 0);
+    REQUIRE(rs_fuse_point_clouds(devices, frames, nullptr, 1, 0, points, 1, require_error("null pointer passed for argument \"device_to_rig\"")) == 0);
+    REQUIRE(rs_fuse_point_clouds(devices, frames, poses, 0, 0, points, 1, require_error("out of range value for argument \"count\"")) == 0);
+    REQUIRE(rs_fuse_point_clouds(devices, frames, poses, 1, -1, points, 1, require_error("out of range value for argument \"voxel_size\"")) == 0);
+    REQUIRE(rs_fuse_point_clouds(devices, frames, poses, 1, 0, nullptr, 1, require_error("null pointer passed for argument \"points\"")) == 0);
+    REQUIRE(rs_fuse_point_clouds(devices, frames, poses, 2, 0, points, 1, require_error("null pointer passed for argument \"devices[i]\"")) == 0);
 }
 
-TEST_CASE( "rs_get_stream_framerate() validates input", "[offline] [validation]" )
+TEST_CASE( "stream bandwidth is planned per USB controller", "[offline] [validation]" )
 {
-    REQUIRE(rs_get_stream_framerate(nullptr,               RS_STREAM_DEPTH,    require_error("null pointer passed for argument \"device\"")) == 0);
-                                                                               
-    REQUIRE(rs_get_stream_framerate(fake_object_pointer(), (rs_stream)-1,      require_error("bad enum value for argument \"stream\"")) == 0);
-    REQUIRE(rs_get_stream_framerate(fake_object_pointer(), RS_STREAM_COUNT,    require_error("bad enum value for argument \"stream\"")) == 0);
+    REQUIRE(rsimpl::get_usb_controller("2-1-3") == "2");
+    REQUIRE(rsimpl::get_usb_controller("4") == "4");
+    REQUIRE(rsimpl::get_usb_controller("") == "");
+
+    // A and B share bus 1 and start at 300 MB/s together, C on bus 2 and D of unknown port fit on their own
+    std::vector<rsimpl::bandwidth_demand> demands = {
+        { "A", "1", { 200e6, 120e6, 60e6 } },
+        { "B", "1", { 100e6, 50e6 } },
+        { "C", "2", { 150e6 } },
+        { "D", "", { 180e6, 90e6 } },
+    };
+    REQUIRE(rsimpl::plan_bandwidth(demands, 300e6) == std::vector<size_t>({ 0, 0, 0, 0 }));
+    REQUIRE(rsimpl::plan_bandwidth(demands, 200e6) == std::vector<size_t>({ 2, 0, 0, 0 })); // A keeps taking the most until it is at its lowest
+    REQUIRE(rsimpl::plan_bandwidth(demands, 150e6) == std::vector<size_t>({ 2, 1, 0, 1 }));
+
+    try
+    {
+        rsimpl::plan_bandwidth(demands, 100e6);
+        FAIL("the streams of bus 1 fit within 100 MB/s");
+    }
+    catch (const std::runtime_error & e)
+    {
+        REQUIRE(std::string(e.what()) == "the streams of A, B on USB bus 1 take 110 MB/s at their lowest, more than the 100 MB/s available");
+    }
 }
 
-TEST_CASE( "rs_start_device() validates input", "[offline] [validation]" )
+TEST_CASE( "bandwidth candidates only move the streams left open", "[offline] [validation]" )
 {
-    rs_start_device(nullptr, require_error("null pointer passed for argument \"device\""));
+    rsimpl::static_device_info info;
+    info.stream_subdevices[RS_STREAM_DEPTH] = 0;
+    info.stream_subdevices[RS_STREAM_COLOR] = 1;
+    rs_intrinsics vga = { 640, 480 };
+    info.subdevice_modes.push_back({ 0, { 640, 480 }, rsimpl::pf_z16, 60, vga, {}, { 0 } });
+    info.subdevice_modes.push_back({ 0, { 640, 480 }, rsimpl::pf_z16, 30, vga, {}, { 0 } });
+    info.subdevice_modes.push_back({ 1, { 640, 480 }, rsimpl::pf_yuy2, 30, vga, {}, { 0 } });
+
+    rsimpl::device_config config(info);
+    config.requests[RS_STREAM_DEPTH] = { true, 0, 0, RS_FORMAT_ANY, 0, RS_OUTPUT_BUFFER_FORMAT_CONTINUOUS };
+    config.requests[RS_STREAM_COLOR] = { true, 640, 480, RS_FORMAT_YUYV, 30, RS_OUTPUT_BUFFER_FORMAT_CONTINUOUS };
+    auto candidates = config.get_bandwidth_candidates();
+    REQUIRE(candidates.size() == 2);
+    REQUIRE(candidates[0].requests[RS_STREAM_DEPTH].fps == 60);
+    REQUIRE(candidates[0].bandwidth == 640 * 480 * 2 * (60 + 30));
+    REQUIRE(candidates[1].requests[RS_STREAM_DEPTH].fps == 30);
+    REQUIRE(candidates[1].requests[RS_STREAM_COLOR].fps == 30);
+    REQUIRE(candidates[1].bandwidth == 640 * 480 * 2 * (30 + 30));
+
+    config.requests[RS_STREAM_DEPTH].fps = 60;
+    REQUIRE(config.get_bandwidth_candidates().size() == 1);
 }
 
-TEST_CASE( "rs_stop_device() validates input", "[offline] [validation]" )
+TEST_CASE( "modes are selected once per set of requests", "[offline] [validation]" )
 {
-    rs_stop_device(nullptr, require_error("null pointer passed for argument \"device\""));
+    rsimpl::static_device_info info;
+    info.stream_subdevices[RS_STREAM_DEPTH] = 0;
+    info.stream_subdevices[RS_STREAM_COLOR] = 1;
+    rs_intrinsics vga = { 640, 480 };
+    info.subdevice_modes.push_back({ 0, { 640, 480 }, rsimpl::pf_z16, 60, vga, {}, { 0 } });
+    info.subdevice_modes.push_back({ 0, { 640, 480 }, rsimpl::pf_z16, 30, vga, {}, { 0 } });
+    info.subdevice_modes.push_back({ 1, { 640, 480 }, rsimpl::pf_yuy2, 30, vga, {}, { 0 } });
+
+    rsimpl::device_config config(info);
+    config.requests[RS_STREAM_DEPTH] = { true, 0, 0, RS_FORMAT_ANY, 30, RS_OUTPUT_BUFFER_FORMAT_CONTINUOUS };
+    auto first = config.select_modes();
+    REQUIRE(config.selections.get_hit_count() == 0);
+    auto second = config.select_modes();
+    REQUIRE(config.selections.get_hit_count() == 1);
+    REQUIRE(first.size() == 1);
+    REQUIRE(second.size() == 1);
+    REQUIRE(second[0].mode.fps == 30);
+    REQUIRE(second[0].mode.fps == first[0].mode.fps);
+
+    // The settings of the device still apply to the modes found in the cache
+    config.depth_decimation_factor = 2;
+    auto decimated = config.select_modes();
+    REQUIRE(config.selections.get_hit_count() == 2);
+    REQUIRE(decimated[0].decimation_factor == 2);
+    REQUIRE(decimated[0].get_output_width(RS_STREAM_DEPTH) == 320);
+
+    // Other requests are resolved anew, and requests no mode provides are never kept
+    config.requests[RS_STREAM_COLOR] = { true, 640, 480, RS_FORMAT_YUYV, 30, RS_OUTPUT_BUFFER_FORMAT_CONTINUOUS };
+    REQUIRE(config.select_modes().size() == 2);
+    REQUIRE(config.selections.get_hit_count() == 2);
+    config.requests[RS_STREAM_COLOR].fps = 60;
+    for (int i = 0; i < 2; ++i) REQUIRE_THROWS(config.select_modes());
+    REQUIRE(config.selections.get_hit_count() == 2);
 }
 
-TEST_CASE( "rs_is_device_streaming() validates input", "[offline] [validation]" )
+TEST_CASE( "calibration is read again only when its signature changes", "[offline] [validation]" )
 {
-    REQUIRE(rs_is_device_streaming(nullptr, require_error("null pointer passed for argument \"device\"")) == 0);
+    rs_set_calibration_cache_directory("./no-such-directory", require_error("calibration cache directory ./no-such-directory does not exist"));
+    rs_set_calibration_cache_directory(".", require_no_error());
+
+    int reads = 0;
+    const std::vector<uint8_t> calibration = { 1, 2, 3, 4, 5 };
+    auto read_calibration = [&]() { ++reads; return calibration; };
+    const std::string key = "offline-test serial/firmware";
+    std::remove("./offline-test_serial_firmware.calibration");
+
+    REQUIRE(rsimpl::calibration_store::get(key, { 7, 7 }, read_calibration) == calibration);
+    REQUIRE(reads == 1);
+    REQUIRE(rsimpl::calibration_store::get(key, { 7, 7 }, read_calibration) == calibration);
+    REQUIRE(reads == 1);
+    REQUIRE(rsimpl::calibration_store::get(key, { 7, 8 }, read_calibration) == calibration);
+    REQUIRE(reads == 2);
+
+    // An entry damaged on disk is read again
+    {
+        std::ofstream file("./offline-test_serial_firmware.calibration", std::ios::binary | std::ios::in);
+        file.seekp(-1, std::ios::end);
+        file.put(9);
+    }
+    REQUIRE(rsimpl::calibration_store::get(key, { 7, 8 }, read_calibration) == calibration);
+    REQUIRE(reads == 3);
+
+    rs_set_calibration_cache_directory(nullptr, require_no_error());
+    REQUIRE(!rsimpl::calibration_store::is_enabled());
+    REQUIRE(rsimpl::calibration_store::get(key, { 7, 8 }, read_calibration) == calibration);
+    REQUIRE(reads == 4);
+    std::remove("./offline-test_serial_firmware.calibration");
 }
 
-TEST_CASE( "rs_set_device_option() validates input", "[offline] [validation]" )
+TEST_CASE( "rs_export_trace() writes the spans of every thread", "[offline] [validation]" )
 {
-    rs_set_device_option(nullptr,               RS_OPTION_COLOR_GAIN, 100, require_error("null pointer passed for argument \"device\""));
+    rs_export_trace(nullptr, require_error("null pointer passed for argument \"file_path\""));
 
-    rs_set_device_option(fake_object_pointer(), (rs_option)-1,        100, require_error("bad enum value for argument \"option\""));
-    rs_set_device_option(fake_object_pointer(), RS_OPTION_COUNT,      100, require_error("bad enum value for argument \"option\""));
+#ifdef RS_ENABLE_TRACING
+    { RS_TRACE_SPAN("offline-test-main"); }
+    std::thread([]() { for (int i = 0; i < 3; ++i) { RS_TRACE_SPAN("offline-test-worker"); } }).join();
+    rs_export_trace("./offline-test.trace.json", require_no_error());
 
-    // NOTE: Currently no validation is done for valid option ranges at the API level, though specifying an invalid option may fail at the UVC level
-    // todo - Add some basic validation for parameter sanity (gain/exposure cannot be negative, depth clamping must be in uint16_t range, etc...)
+    std::ifstream file("./offline-test.trace.json");
+    const std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    REQUIRE(trace.find("{\"traceEvents\":[") == 0);
+    REQUIRE(trace.find("\"name\":\"offline-test-main\",\"ph\":\"X\"") != std::string::npos);
+    size_t workers = 0;
+    for (auto pos = trace.find("offline-test-worker"); pos != std::string::npos; pos = trace.find("offline-test-worker", pos + 1)) ++workers;
+    REQUIRE(workers >= 3);
+    file.close();
+    std::remove("./offline-test.trace.json");
+#else
+    rs_export_trace("./offline-test.trace.json", require_error("librealsense was built without RS_ENABLE_TRACING"));
+#endif
+}
+
+TEST_CASE( "asynchronous logging writes the messages of every thread in order, or counts them as dropped", "[offline] [validation]" )
+{
+    rs_log_asynchronously(-1, require_error("out of range value for argument \"queue_size\""));
+
+    struct received_messages { std::mutex mutex; std::map<std::string, std::vector<int>> by_thread; int count = 0; } received;
+    rs_log_to_callback(RS_LOG_SEVERITY_DEBUG, [](rs_log_severity, const char * message, void * user)
+    {
+        auto & r = *(received_messages *)user;
+        std::string text(message);
+        if (text.compare(0, 13, "offline-test ") != 0) return;
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto space = text.find(' ', 13);
+        r.by_thread[text.substr(13, space - 13)].push_back(std::stoi(text.substr(space + 1)));
+        ++r.count;
+    }, &received, require_no_error());
+
+    rs_log_asynchronously(1000, require_no_error());
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) threads.emplace_back([t]() { for (int i = 0; i < 200; ++i) LOG_DEBUG("offline-test " << t << " " << i); });
+    for (auto & t : threads) t.join();
+    rs_log_asynchronously(0, require_no_error());
+    REQUIRE(received.count == 800);
+    for (auto & thread : received.by_thread)
+    {
+        REQUIRE(thread.second.size() == 200);
+        for (int i = 0; i < 200; ++i) REQUIRE(thread.second[i] == i);
+    }
+
+    // Queues of a single message overflow, and each message lost is counted
+    received.by_thread.clear();
+    received.count = 0;
+    const auto dropped = rs_get_dropped_log_messages(require_no_error());
+    rs_log_asynchronously(1, require_no_error());
+    for (int i = 0; i < 2000; ++i) LOG_DEBUG("offline-test main " << i);
+    rs_log_asynchronously(0, require_no_error());
+    const auto newly_dropped = rs_get_dropped_log_messages(require_no_error()) - dropped;
+    REQUIRE(newly_dropped > 0);
+    REQUIRE(received.count + newly_dropped == 2000);
+    REQUIRE(std::is_sorted(begin(received.by_thread["main"]), end(received.by_thread["main"])));
+
+    // Synchronous logging writes every message before returning
+    LOG_DEBUG("offline-test main 2000");
+    REQUIRE(received.by_thread["main"].back() == 2000);
+    rs_log_to_callback(RS_LOG_SEVERITY_NONE, [](rs_log_severity, const char *, void *) {}, nullptr, require_no_error());
+    REQUIRE(rsimpl::get_minimum_severity() == RS_LOG_SEVERITY_NONE);
+}
+
+struct counted_log_argument { int * formatted; };
+std::ostream & operator << (std::ostream & out, const counted_log_argument & arg) { ++*arg.formatted; return out << "counted"; }
+
+TEST_CASE( "log messages are only formatted for severities some sink writes", "[offline] [validation]" )
+{
+    int formatted = 0;
+    REQUIRE(!rsimpl::is_logged(RS_LOG_SEVERITY_FATAL));
+    LOG_FATAL("offline-test " << counted_log_argument{ &formatted });
+    REQUIRE(formatted == 0);
+
+    rs_log_to_callback(RS_LOG_SEVERITY_WARN, [](rs_log_severity, const char *, void *) {}, nullptr, require_no_error());
+    LOG_INFO("offline-test " << counted_log_argument{ &formatted });
+    REQUIRE(formatted == 0);
+    LOG_WARNING("offline-test " << counted_log_argument{ &formatted });
+    REQUIRE(formatted == 1);
+
+    rs_log_to_callback(RS_LOG_SEVERITY_NONE, [](rs_log_severity, const char *, void *) {}, nullptr, require_no_error());
+    LOG_ERROR("offline-test " << counted_log_argument{ &formatted });
+    REQUIRE(formatted == 1);
 }
 
 TEST_CASE( "rs_get_device_option() validates input", "[offline] [validation]" )
@@ -288,6 +5724,8 @@ TEST_CASE( "rs_stream_to_string() produces correct output", "[offline] [validati
     REQUIRE(rs_stream_to_string(RS_STREAM_COLOR_ALIGNED_TO_DEPTH) == std::string("COLOR_ALIGNED_TO_DEPTH"));
     REQUIRE(rs_stream_to_string(RS_STREAM_DEPTH_ALIGNED_TO_COLOR) == std::string("DEPTH_ALIGNED_TO_COLOR"));
     REQUIRE(rs_stream_to_string(RS_STREAM_DEPTH_ALIGNED_TO_RECTIFIED_COLOR) == std::string("DEPTH_ALIGNED_TO_RECTIFIED_COLOR"));
+    REQUIRE(rs_stream_to_string(RS_STREAM_RECTIFIED_FISHEYE) == std::string("RECTIFIED_FISHEYE"));
+    REQUIRE(rs_stream_to_string(RS_STREAM_NORMALS) == std::string("NORMALS"));
 
     // Invalid enum values should return nullptr
     REQUIRE(rs_stream_to_string((rs_stream)-1) == unknown);
@@ -308,6 +5746,11 @@ TEST_CASE( "rs_format_to_string() produces correct output", "[offline] [validati
     REQUIRE(rs_format_to_string(RS_FORMAT_Y8) == std::string("Y8"));
     REQUIRE(rs_format_to_string(RS_FORMAT_Y16) == std::string("Y16"));
     REQUIRE(rs_format_to_string(RS_FORMAT_RAW10) == std::string("RAW10"));
+    REQUIRE(rs_format_to_string(RS_FORMAT_XYZ16F) == std::string("XYZ16F"));
+    REQUIRE(rs_format_to_string(RS_FORMAT_XYZ16) == std::string("XYZ16"));
+    REQUIRE(rs_format_to_string(RS_FORMAT_NV12) == std::string("NV12"));
+    REQUIRE(rs_format_to_string(RS_FORMAT_I420) == std::string("I420"));
+    REQUIRE(rs_format_to_string(RS_FORMAT_XYZ32F_PLANAR) == std::string("XYZ32F_PLANAR"));
 
     // Invalid enum values should return nullptr
     REQUIRE(rs_format_to_string((rs_format)-1) == unknown);
@@ -338,6 +5781,86 @@ TEST_CASE( "rs_distortion_to_string() produces correct output", "[offline] [vali
     REQUIRE(rs_distortion_to_string(RS_DISTORTION_COUNT) == unknown);
 }
 
+TEST_CASE( "rs_frame_drop_policy_to_string() produces correct output", "[offline] [validation]" )
+{
+    // Valid enum values should return the text that follows the type prefix
+    REQUIRE(rs_frame_drop_policy_to_string(RS_FRAME_DROP_POLICY_DROP_OLDEST) == std::string("DROP_OLDEST"));
+    REQUIRE(rs_frame_drop_policy_to_string(RS_FRAME_DROP_POLICY_DROP_NEWEST) == std::string("DROP_NEWEST"));
+    REQUIRE(rs_frame_drop_policy_to_string(RS_FRAME_DROP_POLICY_LATEST_ONLY) == std::string("LATEST_ONLY"));
+
+    // Invalid enum values should return nullptr
+    REQUIRE(rs_frame_drop_policy_to_string((rs_frame_drop_policy)-1) == unknown);
+    REQUIRE(rs_frame_drop_policy_to_string(RS_FRAME_DROP_POLICY_COUNT) == unknown);
+}
+
+TEST_CASE( "rs_straggler_policy_to_string() produces correct output", "[offline] [validation]" )
+{
+    // Valid enum values should return the text that follows the type prefix
+    REQUIRE(rs_straggler_policy_to_string(RS_STRAGGLER_POLICY_DROP_SET) == std::string("DROP_SET"));
+    REQUIRE(rs_straggler_policy_to_string(RS_STRAGGLER_POLICY_DELIVER_PARTIAL) == std::string("DELIVER_PARTIAL"));
+
+    // Invalid enum values should return nullptr
+    REQUIRE(rs_straggler_policy_to_string((rs_straggler_policy)-1) == unknown);
+    REQUIRE(rs_straggler_policy_to_string(RS_STRAGGLER_POLICY_COUNT) == unknown);
+}
+
+TEST_CASE( "rs_playback_pacing_to_string() produces correct output", "[offline] [validation]" )
+{
+    // Valid enum values should return the text that follows the type prefix
+    REQUIRE(rs_playback_pacing_to_string(RS_PLAYBACK_PACING_REAL_TIME) == std::string("REAL_TIME"));
+    REQUIRE(rs_playback_pacing_to_string(RS_PLAYBACK_PACING_AS_FAST_AS_POSSIBLE) == std::string("AS_FAST_AS_POSSIBLE"));
+    REQUIRE(rs_playback_pacing_to_string(RS_PLAYBACK_PACING_STEP) == std::string("STEP"));
+
+    // Invalid enum values should return nullptr
+    REQUIRE(rs_playback_pacing_to_string((rs_playback_pacing)-1) == unknown);
+    REQUIRE(rs_playback_pacing_to_string(RS_PLAYBACK_PACING_COUNT) == unknown);
+}
+
+TEST_CASE( "rs_stream_metric_to_string() produces correct output", "[offline] [validation]" )
+{
+    // Valid enum values should return the text that follows the type prefix
+    REQUIRE(rs_stream_metric_to_string(RS_STREAM_METRIC_FRAMES_RECEIVED) == std::string("FRAMES_RECEIVED"));
+    REQUIRE(rs_stream_metric_to_string(RS_STREAM_METRIC_FRAMES_INVALID) == std::string("FRAMES_INVALID"));
+    REQUIRE(rs_stream_metric_to_string(RS_STREAM_METRIC_FRAMES_CULLED) == std::string("FRAMES_CULLED"));
+    REQUIRE(rs_stream_metric_to_string(RS_STREAM_METRIC_FRAMES_UNPUBLISHED) == std::string("FRAMES_UNPUBLISHED"));
+    REQUIRE(rs_stream_metric_to_string(RS_STREAM_METRIC_QUEUED_FRAMES) == std::string("QUEUED_FRAMES"));
+    REQUIRE(rs_stream_metric_to_string(RS_STREAM_METRIC_UNPACK_NANOSECONDS) == std::string("UNPACK_NANOSECONDS"));
+    REQUIRE(rs_stream_metric_to_string(RS_STREAM_METRIC_CALLBACK_NANOSECONDS) == std::string("CALLBACK_NANOSECONDS"));
+    REQUIRE(rs_stream_metric_to_string(RS_STREAM_METRIC_DERIVED_FRAMES_SHED) == std::string("DERIVED_FRAMES_SHED"));
+    REQUIRE(rs_stream_metric_to_string(RS_STREAM_METRIC_UNPACKS_SHED) == std::string("UNPACKS_SHED"));
+    REQUIRE(rs_stream_metric_to_string(RS_STREAM_METRIC_FRAMES_DECIMATED) == std::string("FRAMES_DECIMATED"));
+
+    // Invalid enum values should return nullptr
+    REQUIRE(rs_stream_metric_to_string((rs_stream_metric)-1) == unknown);
+    REQUIRE(rs_stream_metric_to_string(RS_STREAM_METRIC_COUNT) == unknown);
+}
+
+TEST_CASE( "rs_transfer_statistic_to_string() produces correct output", "[offline] [validation]" )
+{
+    // Valid enum values should return the text that follows the type prefix
+    REQUIRE(rs_transfer_statistic_to_string(RS_TRANSFER_STATISTIC_BYTES) == std::string("BYTES"));
+    REQUIRE(rs_transfer_statistic_to_string(RS_TRANSFER_STATISTIC_BYTES_PER_SECOND) == std::string("BYTES_PER_SECOND"));
+    REQUIRE(rs_transfer_statistic_to_string(RS_TRANSFER_STATISTIC_FRAMES) == std::string("FRAMES"));
+    REQUIRE(rs_transfer_statistic_to_string(RS_TRANSFER_STATISTIC_SHORT_FRAMES) == std::string("SHORT_FRAMES"));
+    REQUIRE(rs_transfer_statistic_to_string(RS_TRANSFER_STATISTIC_ERRORS) == std::string("ERRORS"));
+
+    // Invalid enum values should return nullptr
+    REQUIRE(rs_transfer_statistic_to_string((rs_transfer_statistic)-1) == unknown);
+    REQUIRE(rs_transfer_statistic_to_string(RS_TRANSFER_STATISTIC_COUNT) == unknown);
+}
+
+TEST_CASE( "rs_load_shedding_action_to_string() produces correct output", "[offline] [validation]" )
+{
+    // Valid enum values should return the text that follows the type prefix
+    REQUIRE(rs_load_shedding_action_to_string(RS_LOAD_SHEDDING_ACTION_SKIP_DERIVED_STREAMS) == std::string("SKIP_DERIVED_STREAMS"));
+    REQUIRE(rs_load_shedding_action_to_string(RS_LOAD_SHEDDING_ACTION_SKIP_CULLED_UNPACKING) == std::string("SKIP_CULLED_UNPACKING"));
+    REQUIRE(rs_load_shedding_action_to_string(RS_LOAD_SHEDDING_ACTION_DECIMATE_FRAMERATE) == std::string("DECIMATE_FRAMERATE"));
+
+    // Invalid enum values should return nullptr
+    REQUIRE(rs_load_shedding_action_to_string((rs_load_shedding_action)-1) == unknown);
+    REQUIRE(rs_load_shedding_action_to_string(RS_LOAD_SHEDDING_ACTION_COUNT) == unknown);
+}
+
 TEST_CASE( "rs_option_to_string() produces correct output", "[offline] [validation]" )
 {
     // Valid enum values should return the text that follows the type prefix